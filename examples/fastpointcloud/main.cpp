@@ -8,41 +8,6 @@
 #include <fstream>
 #include <sstream>
 
-static void create_xy_table(const k4a_calibration_t *calibration, k4a_image_t xy_table)
-{
-    k4a_float2_t *table_data = (k4a_float2_t *)(void *)k4a_image_get_buffer(xy_table);
-
-    int width = calibration->depth_camera_calibration.resolution_width;
-    int height = calibration->depth_camera_calibration.resolution_height;
-
-    k4a_float2_t p;
-    k4a_float3_t ray;
-    int valid;
-
-    for (int y = 0, idx = 0; y < height; y++)
-    {
-        p.xy.y = (float)y;
-        for (int x = 0; x < width; x++, idx++)
-        {
-            p.xy.x = (float)x;
-
-            k4a_calibration_2d_to_3d(
-                calibration, &p, 1.f, K4A_CALIBRATION_TYPE_DEPTH, K4A_CALIBRATION_TYPE_DEPTH, &ray, &valid);
-
-            if (valid)
-            {
-                table_data[idx].xy.x = ray.xyz.x;
-                table_data[idx].xy.y = ray.xyz.y;
-            }
-            else
-            {
-                table_data[idx].xy.x = nanf("");
-                table_data[idx].xy.y = nanf("");
-            }
-        }
-    }
-}
-
 static void generate_point_cloud(const k4a_image_t depth_image,
                                  const k4a_image_t xy_table,
                                  k4a_image_t point_cloud,
@@ -119,6 +84,7 @@ int main(int argc, char **argv)
     uint32_t device_count = 0;
     k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
     k4a_image_t depth_image = NULL;
+    k4a_transformation_t transformation = NULL;
     k4a_image_t xy_table = NULL;
     k4a_image_t point_cloud = NULL;
     int point_count = 0;
@@ -163,7 +129,14 @@ int main(int argc, char **argv)
                      calibration.depth_camera_calibration.resolution_width * (int)sizeof(k4a_float2_t),
                      &xy_table);
 
-    create_xy_table(&calibration, xy_table);
+    // The transformation handle computes the table of its depth camera when it is created
+    transformation = k4a_transformation_create(&calibration);
+    if (transformation == NULL ||
+        K4A_RESULT_SUCCEEDED != k4a_transformation_get_xy_table(transformation, K4A_CALIBRATION_TYPE_DEPTH, xy_table))
+    {
+        printf("Failed to get xy table\n");
+        goto Exit;
+    }
 
     k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
                      calibration.depth_camera_calibration.resolution_width,
@@ -209,6 +182,11 @@ int main(int argc, char **argv)
 
     returnCode = 0;
 Exit:
+    if (transformation != NULL)
+    {
+        k4a_transformation_destroy(transformation);
+    }
+
     if (device != NULL)
     {
         k4a_device_close(device);
@@ -34,6 +34,15 @@ typedef struct
     uint32_t biClrImportant;
 } BITMAPINFOHEADER;
 
+// Called by the recording once it no longer needs the buffer of an image passed to
+// k4a_record_write_custom_track_data_owned().
+void release_image(void *buffer, void *context);
+void release_image(void *buffer, void *context)
+{
+    (void)buffer;
+    k4a_image_release((k4a_image_t)context);
+}
+
 void fill_bitmap_header(uint32_t width, uint32_t height, BITMAPINFOHEADER *out);
 void fill_bitmap_header(uint32_t width, uint32_t height, BITMAPINFOHEADER *out)
 {
@@ -148,13 +157,15 @@ int main(int argc, char **argv)
                     depth_buffer[i + 1] = 128;
                 }
 
-                VERIFY(k4a_record_write_custom_track_data(recording,
-                                                          "PROCESSED_DEPTH",
-                                                          k4a_image_get_device_timestamp_usec(depth_image),
-                                                          depth_buffer,
-                                                          (uint32_t)depth_buffer_size));
-
-                k4a_image_release(depth_image);
+                // Write the processed image without copying it. The recording takes over our reference to the
+                // image and releases it once it has been written to disk.
+                VERIFY(k4a_record_write_custom_track_data_owned(recording,
+                                                                "PROCESSED_DEPTH",
+                                                                k4a_image_get_device_timestamp_usec(depth_image),
+                                                                depth_buffer,
+                                                                depth_buffer_size,
+                                                                release_image,
+                                                                depth_image));
             }
 
             k4a_capture_release(capture);
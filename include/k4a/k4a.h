@@ -38,6 +38,11 @@ extern "C" {
  * \remarks
  * This API counts the number of Azure Kinect devices connected to the host PC.
  *
+ * \remarks
+ * Each call enumerates the USB devices of the host, unless a callback is registered with
+ * k4a_set_device_hotplug_callback(). The count is then kept up to date as devices are attached and detached, and is
+ * returned without enumerating.
+ *
  * \xmlonly
  * <requirements>
  *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
@@ -48,6 +53,41 @@ extern "C" {
  */
 K4A_EXPORT uint32_t k4a_device_get_installed_count(void);
 
+/** Sets and clears the callback function notified when devices are attached or detached.
+ *
+ * \param hotplug_cb
+ * The callback function notified of device changes. Set to NULL to unregister the callback function.
+ *
+ * \param hotplug_cb_context
+ * The callback functions context.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the callback was set or cleared, ::K4A_RESULT_FAILED if the devices can not be monitored.
+ *
+ * \remarks
+ * While a callback is registered, a thread of the SDK monitors the devices of the host and
+ * k4a_device_get_installed_count() returns the count it keeps instead of enumerating the USB devices on each call. The
+ * count is updated when libusb reports a device change. Where libusb has no hotplug support, as on Windows, the devices
+ * are enumerated every 500 milliseconds instead.
+ *
+ * \remarks
+ * A device unplugged and plugged back in quickly can be reported as removed and then arrived with the same device
+ * count. Setting a new callback replaces the previous one, which is not called again once this function returns.
+ * Only one callback can be registered for the process.
+ *
+ * \remarks
+ * This function must not be called from \p hotplug_cb.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_set_device_hotplug_callback(k4a_device_hotplug_cb_t *hotplug_cb, void *hotplug_cb_context);
+
 /** Sets and clears the callback function to receive debug messages from the Azure Kinect device.
  *
  * \param message_cb
@@ -96,6 +136,40 @@ K4A_EXPORT k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *
                                                       void *message_cb_context,
                                                       k4a_log_level_t min_level);
 
+/** Writes the recent events of the SDK trace ring to a file.
+ *
+ * \param path
+ * Path of the file to create.
+ *
+ * \param duration_usec
+ * Only events from the last \p duration_usec microseconds are written. 0 writes every event still in the ring.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the file was written. ::K4A_RESULT_FAILED if \p path is NULL or the file could not
+ * be written.
+ *
+ * \remarks
+ * The SDK always records USB transfer completions, capture queue pushes, pops and drops, depth engine frame start and
+ * end, and capture synchronization decisions into a fixed size ring in memory, as binary events without formatting.
+ * Unlike K4A_LOG_LEVEL=trace this does not change the timing of the streaming threads, so it can be dumped after a
+ * frame drop or other field issue is observed to see what led to it.
+ *
+ * \remarks
+ * The ring holds the most recent events, typically tens of seconds of streaming. The file is a binary format meant
+ * for offline decoding: a header with the magic "K4ATRACE", a format version, the number of event names and of
+ * events, and the dump time, followed by the event names as null terminated strings, followed by one 40 byte record
+ * per event holding its timestamp in nanoseconds, its event index, 32 bits of padding, and three 64 bit arguments.
+ * Timestamps use the clock of the system timestamps of images.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_trace_dump(const char *path, uint64_t duration_usec);
+
 /** Sets the callback functions for the SDK allocator
  *
  * \param allocate
@@ -132,24 +206,35 @@ K4A_EXPORT k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *
  */
 K4A_EXPORT k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memory_destroy_cb_t free);
 
-/** Open an Azure Kinect device.
+/** Sets the callback functions for the SDK allocator, with the source, image format and alignment of each buffer
  *
- * \param index
- * The index of the device to open, starting with 0. Optionally pass in #K4A_DEVICE_DEFAULT.
+ * \param allocate
+ * The callback function to allocate memory. It is told what the buffer is for, so it can place frames in memory such
+ * as CUDA pinned host memory or buffers registered for RDMA.
  *
- * \param device_handle
- * Output parameter which on success will return a handle to the device.
+ * \param free
+ * The callback function to free memory. The SDK will call this function when memory allocated by \p allocate
+ * is no longer needed.
  *
- * \relates k4a_device_t
+ * \param user_context
+ * Context passed to every call of \p allocate.
  *
- * \return ::K4A_RESULT_SUCCEEDED if the device was opened successfully.
+ * \return ::K4A_RESULT_SUCCEEDED if the callback functions were set or cleared successfully. ::K4A_RESULT_FAILED if
+ * only one of \p allocate and \p free is NULL.
  *
  * \remarks
- * If successful, k4a_device_open() will return a device handle in the device_handle parameter.
- * This handle grants exclusive access to the device and may be used in the other Azure Kinect API calls.
+ * Calling with both \p allocate and \p free as NULL resets to the default allocator. This replaces any allocator set
+ * with k4a_set_allocator() or k4a_set_allocator_huge_pages(), and those functions replace this one. Pooled buffers are
+ * released as with k4a_set_allocator().
  *
  * \remarks
- * When done with the device, close the handle with k4a_device_close()
+ * The image data of a buffer starts inside the memory \p allocate returns, after a header of up to 64 bytes, so a
+ * region registered for DMA covers the whole image. A buffer that is not aligned to the requested alignment is freed
+ * and the allocation fails.
+ *
+ * \remarks
+ * As with k4a_set_allocator(), the SDK calls the \p free function that was set when the memory was allocated, and not
+ * all memory allocated by the SDK comes from \p allocate.
  *
  * \xmlonly
  * <requirements>
@@ -159,19 +244,29 @@ K4A_EXPORT k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t allocate, k4a
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle);
+K4A_EXPORT k4a_result_t k4a_set_allocator_ex(k4a_memory_allocate_ex_cb_t allocate,
+                                             k4a_memory_destroy_cb_t free,
+                                             void *user_context);
 
-/** Closes an Azure Kinect device.
+/** Sets how many freed buffers the SDK allocator keeps for reuse
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param max_pooled_buffers
+ * The maximum number of freed buffers kept for each internal buffer source (depth, color, IMU, USB transfers and
+ * application created images). Pass 0 to disable pooling, which is the default.
  *
- * \relates k4a_device_t
+ * \return ::K4A_RESULT_SUCCEEDED if the limit was set. ::K4A_RESULT_FAILED if \p max_pooled_buffers exceeds the
+ * supported limit of 1024.
  *
- * \remarks Once closed, the handle is no longer valid.
+ * \remarks
+ * Image sizes of each source are fixed while streaming. With pooling enabled, a freed buffer is kept and handed out
+ * for the next allocation of the same size from the same source instead of being returned to the heap. This avoids
+ * heap fragmentation in long running sessions at the cost of holding up to \p max_pooled_buffers idle buffers per
+ * source.
  *
- * \remarks Before closing the handle to the device, ensure that all \ref k4a_capture_t captures have been released with
- * k4a_capture_release().
+ * \remarks
+ * Pooled buffers are released when this function is called again, when k4a_set_allocator() is called, and when the
+ * last open device is closed. Pooled buffers are freed with the \p free function that was set when they were
+ * allocated.
  *
  * \xmlonly
  * <requirements>
@@ -181,57 +276,28 @@ K4A_EXPORT k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_han
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_device_close(k4a_device_t device_handle);
+K4A_EXPORT k4a_result_t k4a_set_allocator_pooling(uint32_t max_pooled_buffers);
 
-/** Reads a sensor capture.
- *
- * \param device_handle
- * Handle obtained by k4a_device_open().
- *
- * \param capture_handle
- * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
- * this capture.
- *
- * \param timeout_in_ms
- * Specifies the time in milliseconds the function should block waiting for the capture. If set to 0, the function will
- * return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available, the
- * device is disconnected, or another error occurs.
+/** Serves the SDK image buffers from huge pages
  *
- * \returns
- * ::K4A_WAIT_RESULT_SUCCEEDED if a capture is returned. If a capture is not available before the timeout elapses, the
- * function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
- *
- * \relates k4a_device_t
- *
- * \remarks
- * Gets the next capture in the streamed sequence of captures from the camera. If a new capture is not currently
- * available, this function will block until the timeout is reached. The SDK will buffer at least two captures worth
- * of data before dropping the oldest capture. Callers needing to capture all data need to ensure they read the data as
- * fast as the data is being produced on average.
- *
- * \remarks
- * Upon successfully reading a capture this function will return success and populate \p capture.
- * If a capture is not available in the configured \p timeout_in_ms, then the API will return ::K4A_WAIT_RESULT_TIMEOUT.
+ * \param enable
+ * true to allocate frame sized buffers from 2 MB huge pages, false to return to the default allocator.
  *
- * \remarks
- * If the call is successful and a capture is returned, callers must call k4a_capture_release() to return the allocated
- * memory.
+ * \return ::K4A_RESULT_SUCCEEDED if the allocator was set.
  *
  * \remarks
- * This function needs to be called while the device is in a running state;
- * after k4a_device_start_cameras() is called and before k4a_device_stop_cameras() is called.
+ * Depth, IR and color frames are several megabytes each. Mapping them from huge pages reduces the TLB misses of the
+ * kernels processing them. Buffers smaller than 1 MB keep coming from the heap. When no huge pages are available, for
+ * example when none are reserved on Linux or the process lacks SeLockMemoryPrivilege on Windows, regular pages are
+ * used instead.
  *
  * \remarks
- * This function returns an error when an internal problem is encountered; such as loss of the USB connection, inability
- * to allocate enough memory, and other unexpected issues. Any error returned by this function signals the end of
- * streaming data, and caller should stop the stream using k4a_device_stop_cameras().
+ * On systems with several NUMA nodes the buffers of each device are placed on the node local to the USB controller it
+ * is connected to, where it can be determined.
  *
  * \remarks
- * If this function is waiting for data (non-zero timeout) when k4a_device_stop_cameras() or k4a_device_close() is
- * called on another thread, this function will return an error.
- *
- * \returns ::K4A_WAIT_RESULT_SUCCEEDED if a capture is returned. If a capture is not available before the timeout
- * elapses, the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
+ * This replaces any allocator set with k4a_set_allocator(), and k4a_set_allocator() replaces this one. Pooled buffers
+ * are released as with k4a_set_allocator().
  *
  * \xmlonly
  * <requirements>
@@ -240,57 +306,19 @@ K4A_EXPORT void k4a_device_close(k4a_device_t device_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
- *
  */
-K4A_EXPORT k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
-                                                    k4a_capture_t *capture_handle,
-                                                    int32_t timeout_in_ms);
+K4A_EXPORT k4a_result_t k4a_set_allocator_huge_pages(bool enable);
 
-/** Reads an IMU sample.
- *
- * \param device_handle
- * Handle obtained by k4a_device_open().
- *
- * \param imu_sample
- * Pointer to the location for the API to write the IMU sample.
- *
- * \param timeout_in_ms
- * Specifies the time in milliseconds the function should block waiting for the sample. If set to 0, the function will
- * return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available, the
- * device is disconnected, or another error occurs.
- *
- * \returns
- * ::K4A_WAIT_RESULT_SUCCEEDED if a sample is returned. If a sample is not available before the timeout elapses, the
- * function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
+/** Sets whether images created with a default stride get their rows padded to 64 bytes
  *
- * \relates k4a_device_t
- *
- * \remarks
- * Gets the next sample in the streamed sequence of IMU samples from the device. If a new sample is not currently
- * available, this function will block until the timeout is reached. The API will buffer at least two camera capture
- * intervals worth of samples before dropping the oldest sample. Callers needing to capture all data need to ensure they
- * read the data as fast as the data is being produced on average.
- *
- * \remarks
- * Upon successfully reading a sample this function will return success and populate \p imu_sample.
- * If a sample is not available in the configured \p timeout_in_ms, then the API will return ::K4A_WAIT_RESULT_TIMEOUT.
- *
- * \remarks
- * This function needs to be called while the device is in a running state;
- * after k4a_device_start_imu() is called and before k4a_device_stop_imu() is called.
- *
- * \remarks
- * This function returns an error when an internal problem is encountered; such as loss of the USB connection, inability
- * to allocate enough memory, and other unexpected issues. Any error returned by this function signals the end of
- * streaming data, and caller should stop the stream using k4a_device_stop_imu().
- *
- * \remarks
- * If this function is waiting for data (non-zero timeout) when k4a_device_stop_imu() or k4a_device_close() is
- * called on another thread, this function will return an error.
+ * \param enable
+ * true to round the default stride of k4a_image_create() up to a multiple of 64 bytes, false to use the minimum stride,
+ * which is the default.
  *
  * \remarks
- * The memory the IMU sample is written to is allocated and owned by the caller, so there is no need to call an Azure
- * Kinect API to free or release the sample.
+ * Only images created with a \p stride_bytes of 0 are affected. Padded rows all start on a 64 byte boundary, which lets
+ * SIMD code process every row with aligned loads and stores and without handling a partial vector at the end of a row.
+ * Code that assumes the stride is the width times the bytes per pixel must use k4a_image_get_stride_bytes() instead.
  *
  * \xmlonly
  * <requirements>
@@ -300,25 +328,21 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
-                                                       k4a_imu_sample_t *imu_sample,
-                                                       int32_t timeout_in_ms);
+K4A_EXPORT void k4a_set_image_row_padding(bool enable);
 
-/** Create an empty capture object.
+/** Gets statistics of the buffers allocated by the SDK allocator
  *
- * \param capture_handle
- * Pointer to a location to store the handle.
+ * \param stats
+ * Location to write the statistics of each buffer source.
  *
- * \relates k4a_capture_t
+ * \return ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED if \p stats is NULL.
  *
  * \remarks
- * Call this function to create a \ref k4a_capture_t handle for a new capture. Release it with k4a_capture_release().
- *
- * The new capture is created with a reference count of 1.
+ * Statistics are process wide and cover every buffer allocated by the SDK allocator, see k4a_set_allocator(). A
+ * growing live_bytes count usually means captures or images are not being released as fast as they are produced.
  *
- * \returns
- * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED and error specific data can be
- * found in the log.
+ * \remarks
+ * Buffers held by the allocator pools, see k4a_set_allocator_pooling(), are not counted as live.
  *
  * \xmlonly
  * <requirements>
@@ -328,17 +352,30 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handl
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle);
+K4A_EXPORT k4a_result_t k4a_get_allocator_stats(k4a_allocator_stats_t *stats);
 
-/** Release a capture.
+/** Sizes the buffers and queues of the SDK to a memory budget
  *
- * \param capture_handle
- * Capture to release.
+ * \param budget_bytes
+ * The memory each device, recording and playback should hold for its buffers, or 0 for the default sizes.
  *
- * \relates k4a_capture_t
+ * \remarks
+ * The default sizes favor throughput, and hold a few hundred megabytes per streaming device. A budget trades them for a
+ * bounded footprint, for example on embedded boards with a few gigabytes of memory shared with the GPU:
+ * - A quarter of the budget goes to the USB transfer buffers of the depth stream.
+ * - Half of it goes to the captures the device queues: k4a_device_get_capture() holds as many captures as fit in it,
+ *   unless a depth is set with k4a_device_set_queue_policy(), and the depth engine output buffers are limited to it.
+ *   BGRA32, YUY2 and NV12 color buffers for those captures are allocated when the cameras start, so streaming does no
+ *   further dynamic allocation of them.
+ * - Recordings created with k4a_record_create() hold at most half of it before writing, as with
+ *   k4a_record_set_write_queue_limit() and ::K4A_RECORD_WRITE_QUEUE_BLOCK, unless another limit is set.
+ * - Playbacks read ahead a single cluster, and keep at most a quarter of it in cached image buffers, and another
+ *   quarter in the blocks read by k4a_playback_open_custom_io().
  *
  * \remarks
- * Call this function when finished using the capture.
+ * The remaining quarter is left to the depth engine and the application. Every part keeps at least the minimum it needs
+ * to stream, so a budget that is too small is exceeded. The budget applies to the cameras started, and the recordings
+ * and playbacks opened, after the call. Environment variables such as K4A_MAX_LIBUSB_POOL still take precedence.
  *
  * \xmlonly
  * <requirements>
@@ -348,18 +385,11 @@ K4A_EXPORT k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_release(k4a_capture_t capture_handle);
+K4A_EXPORT void k4a_set_memory_budget(size_t budget_bytes);
 
-/** Add a reference to a capture.
- *
- * \param capture_handle
- * Capture to add a reference to.
+/** Gets the memory budget set with k4a_set_memory_budget()
  *
- * \relates k4a_capture_t
- *
- * \remarks
- * Call this function to add an additional reference to a capture. This reference must be removed with
- * k4a_capture_release().
+ * \return The budget in bytes, 0 if the default sizes are used.
  *
  * \xmlonly
  * <requirements>
@@ -369,18 +399,28 @@ K4A_EXPORT void k4a_capture_release(k4a_capture_t capture_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_reference(k4a_capture_t capture_handle);
+K4A_EXPORT size_t k4a_get_memory_budget(void);
 
-/** Get the color image associated with the given capture.
+/** Gets the latency statistics of a stage of the depth capture pipeline
  *
- * \param capture_handle
- * Capture handle containing the image.
+ * \param stage
+ * The stage to read.
  *
- * \relates k4a_capture_t
+ * \param stats
+ * Location to write the statistics of the stage.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED if \p stage is not valid or \p stats
+ * is NULL.
  *
  * \remarks
- * Call this function to access the color image part of this capture. Release the \ref k4a_image_t with
- * k4a_image_release();
+ * Every depth capture is timed as it moves from the USB transfer of its raw frame, through the depth engine and capture
+ * synchronization, to k4a_device_get_capture(). The per stage statistics show where the time goes when the end to end
+ * latency, ::K4A_LATENCY_STAGE_TOTAL, is higher than expected. Statistics are process wide and cover every open
+ * device.
+ *
+ * \remarks
+ * Captures delivered through a capture callback instead of k4a_device_get_capture() are not counted in
+ * ::K4A_LATENCY_STAGE_USER and ::K4A_LATENCY_STAGE_TOTAL. Captures without depth are not timed.
  *
  * \xmlonly
  * <requirements>
@@ -390,18 +430,12 @@ K4A_EXPORT void k4a_capture_reference(k4a_capture_t capture_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle);
+K4A_EXPORT k4a_result_t k4a_get_latency_stats(k4a_latency_stage_t stage, k4a_latency_stats_t *stats);
 
-/** Get the depth image associated with the given capture.
- *
- * \param capture_handle
- * Capture handle containing the image.
- *
- * \relates k4a_capture_t
+/** Clears the latency statistics of every stage
  *
  * \remarks
- * Call this function to access the depth image part of this capture. Release the \ref k4a_image_t with
- * k4a_image_release();
+ * Call after the cameras have started to leave the slower first captures out of the statistics.
  *
  * \xmlonly
  * <requirements>
@@ -411,18 +445,23 @@ K4A_EXPORT k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle);
+K4A_EXPORT void k4a_reset_latency_stats(void);
 
-/** Get the IR image associated with the given capture.
+/** Pins the threads of an SDK role to a set of CPUs
  *
- * \param capture_handle
- * Capture handle containing the image.
+ * \param role
+ * The role of the threads to pin.
  *
- * \relates k4a_capture_t
+ * \param cpu_mask
+ * Bit N set allows the threads to run on CPU N. Pass 0 to let the operating system schedule the threads anywhere,
+ * which is the default.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the mask was stored. ::K4A_RESULT_FAILED if \p role is not valid.
  *
  * \remarks
- * Call this function to access the IR image part of this capture. Release the \ref k4a_image_t with
- * k4a_image_release();
+ * The mask applies to threads of \p role started after this call; set it before opening devices and starting the
+ * cameras. Dedicating isolated cores to ::K4A_THREAD_ROLE_USB keeps the USB event threads from being delayed by the
+ * application when many devices are streaming. A thread that can not be pinned logs a warning and keeps running.
  *
  * \xmlonly
  * <requirements>
@@ -432,33 +471,29 @@ K4A_EXPORT k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle)
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle);
+K4A_EXPORT k4a_result_t k4a_set_thread_affinity(k4a_thread_role_t role, uint64_t cpu_mask);
 
-/** Set or add a color image to the associated capture.
- *
- * \param capture_handle
- * Capture handle to hold the image.
- *
- * \param image_handle
- * Image handle containing the image.
+/** Sets the scheduling priority of SDK threads of a role
  *
- * \relates k4a_capture_t
+ * \param role
+ * The role of the threads.
  *
- * \remarks
- * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
- * to the \ref k4a_image_t.
+ * \param priority
+ * The priority of the threads. ::K4A_THREAD_PRIORITY_DEFAULT is the default.
  *
- * \remarks
- * If there is already a color image contained in the capture, the existing image will be dereferenced and replaced with
- * the new image.
+ * \return ::K4A_RESULT_SUCCEEDED if the priority was stored. ::K4A_RESULT_FAILED if \p role or \p priority is not
+ * valid.
  *
  * \remarks
- * To remove a color image to the capture without adding a new image, this function can be called with a NULL
- * image_handle.
+ * Like the CPU mask, the priority applies to threads of \p role started after this call. On Linux
+ * ::K4A_THREAD_PRIORITY_HIGH lowers the nice value of the threads and ::K4A_THREAD_PRIORITY_REALTIME moves them to the
+ * SCHED_FIFO class; both need CAP_SYS_NICE or a matching RLIMIT_RTPRIO. On Windows ::K4A_THREAD_PRIORITY_HIGH raises
+ * the thread priority and ::K4A_THREAD_PRIORITY_REALTIME registers the threads with the Multimedia Class Scheduler
+ * Service as "Capture" tasks. A thread whose priority can not be changed logs a warning and keeps running.
  *
  * \remarks
- * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
- * the \ref k4a_capture_t are released with k4a_capture_release().
+ * Real-time threads preempt the application, use ::K4A_THREAD_PRIORITY_REALTIME together with
+ * k4a_set_thread_affinity() to keep them off the cores the application needs.
  *
  * \xmlonly
  * <requirements>
@@ -468,33 +503,23 @@ K4A_EXPORT k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_set_thread_priority(k4a_thread_role_t role, k4a_thread_priority_t priority);
 
-/** Set or add a depth image to the associated capture.
- *
- * \param capture_handle
- * Capture handle to hold the image.
- *
- * \param image_handle
- * Image handle containing the image.
- *
- * \relates k4a_capture_t
+/** Sets the number of threads of the shared SDK worker pool
  *
- * \remarks
- * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
- * to the \ref k4a_image_t.
+ * \param worker_count
+ * Number of worker threads. Pass 0 to use one thread per CPU less one, which is the default.
  *
- * \remarks
- * If there is already an image depth image contained in the capture, the existing image will be dereferenced and
- * replaced with the new image.
+ * \return ::K4A_RESULT_SUCCEEDED if the count was stored. ::K4A_RESULT_FAILED if \p worker_count exceeds the supported
+ * limit of 64.
  *
  * \remarks
- * To remove a depth image to the capture without adding a new image, this function can be called with a NULL
- * image_handle.
+ * Transformation handles split their CPU work across the pool threads instead of each call creating its own
+ * threads. The pool starts when the first transformation handle configured for more than one thread runs and stops
+ * when the last of them is destroyed; a new count applies the next time the pool starts.
  *
  * \remarks
- * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
- * the \ref k4a_capture_t are released with k4a_capture_release().
+ * Pool threads are pinned with the mask of ::K4A_THREAD_ROLE_WORKER, see k4a_set_thread_affinity().
  *
  * \xmlonly
  * <requirements>
@@ -504,32 +529,49 @@ K4A_EXPORT void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_im
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_set_worker_thread_count(uint32_t worker_count);
 
-/** Set or add an IR image to the associated capture.
+/** Starts loading the depth engine plugin in the background
  *
- * \param capture_handle
- * Capture handle to hold the image.
+ * \remarks
+ * The depth engine plugin is otherwise loaded by the first k4a_device_start_cameras() or
+ * k4a_transformation_create() that needs it. Loading it and initializing the GPU driver can take hundreds of
+ * milliseconds. This function starts that work on a background thread and returns immediately, so it overlaps with
+ * k4a_device_open() and other application startup. A call that needs the plugin while it is still loading waits for
+ * the load to finish instead of starting another one.
  *
- * \param image_handle
- * Image handle containing the image.
+ * \remarks
+ * Calls after the first do nothing. Setting the environment variable K4A_DEPTH_ENGINE_PRELOAD to 1 has
+ * k4a_device_open() call this function. Whether the load succeeded is logged.
  *
- * \relates k4a_capture_t
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_preload_depth_engine(void);
+
+/** Sets a callback reading the shared timebase of a multi-host capture rig
  *
- * \remarks
- * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
- * to the \ref k4a_image_t.
+ * \param timebase_cb
+ * Callback returning the current time of the shared timebase in nanoseconds, or NULL to use the clock of
+ * k4a_image_get_system_timestamp_nsec() as the shared timebase again.
  *
- * \remarks
- * If there is already an IR image contained in the capture, the existing image will be dereferenced and replaced with
- * the new image.
+ * \param timebase_cb_context
+ * Context passed to \p timebase_cb.
  *
  * \remarks
- * To remove a IR image to the capture without adding a new image, this function can be called with a NULL image_handle.
+ * Hosts of a rig that agree on a time, through PTP or another time source, can use it to merge captures across hosts.
+ * k4a_device_get_shared_timestamp_nsec() and k4a_device_get_capture_shared_timestamps() map device timestamps through
+ * the device clock model to the system clock, then to the shared timebase.
  *
  * \remarks
- * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
- * the \ref k4a_capture_t are released with k4a_capture_release().
+ * The offset from the system clock to the shared timebase is measured on first use and again once it is more than a
+ * second old, from the tightest of several readings bracketed by the system clock. The setting applies to every
+ * device of the process.
  *
  * \xmlonly
  * <requirements>
@@ -539,17 +581,21 @@ K4A_EXPORT void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_im
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_set_shared_timebase_callback(k4a_shared_timebase_cb_t *timebase_cb,
+                                                         void *timebase_cb_context);
 
-/** Set the temperature associated with the capture.
+/** Uses a clock of the host as the shared timebase of a multi-host capture rig
  *
- * \param capture_handle
- * Capture handle to set the temperature on.
+ * \param phc_device_path
+ * Path of a PTP hardware clock, such as /dev/ptp0, synchronized by ptp4l. NULL selects the realtime clock of the
+ * host, for hosts whose system time is disciplined by phc2sys or NTP.
  *
- * \param temperature_c
- * Temperature in Celsius to store.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the clock can be read. ::K4A_RESULT_FAILED if the clock can not be opened or read, and on
+ * Windows, where k4a_set_shared_timebase_callback() is used instead.
  *
- * \relates k4a_capture_t
+ * \remarks
+ * See k4a_set_shared_timebase_callback(), which this replaces.
  *
  * \xmlonly
  * <requirements>
@@ -559,18 +605,26 @@ K4A_EXPORT void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_capture_set_temperature_c(k4a_capture_t capture_handle, float temperature_c);
+K4A_EXPORT k4a_result_t k4a_set_shared_timebase_clock(const char *phc_device_path);
 
-/** Get the temperature associated with the capture.
+/** Open an Azure Kinect device.
  *
- * \param capture_handle
- * Capture handle to retrieve the temperature from.
+ * \param index
+ * The index of the device to open, starting with 0. Optionally pass in #K4A_DEVICE_DEFAULT.
  *
- * \return
- * This function returns the temperature of the device at the time of the capture in Celsius. If
- * the temperature is unavailable, the function will return NAN.
+ * \param device_handle
+ * Output parameter which on success will return a handle to the device.
  *
- * \relates k4a_capture_t
+ * \relates k4a_device_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the device was opened successfully.
+ *
+ * \remarks
+ * If successful, k4a_device_open() will return a device handle in the device_handle parameter.
+ * This handle grants exclusive access to the device and may be used in the other Azure Kinect API calls.
+ *
+ * \remarks
+ * When done with the device, close the handle with k4a_device_close()
  *
  * \xmlonly
  * <requirements>
@@ -580,49 +634,53 @@ K4A_EXPORT void k4a_capture_set_temperature_c(k4a_capture_t capture_handle, floa
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT float k4a_capture_get_temperature_c(k4a_capture_t capture_handle);
+K4A_EXPORT k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle);
 
-/** Create an image.
- *
- * \param format
- * The format of the image that will be stored in this image container.
+/** Open several Azure Kinect devices at once.
  *
- * \param width_pixels
- * Width in pixels.
+ * \param device_count
+ * The number of devices to open. The devices at index 0 through device_count - 1 are opened.
  *
- * \param height_pixels
- * Height in pixels.
+ * \param device_handles
+ * Array of device_count handles which on success will hold a handle to each device, in index order.
  *
- * \param stride_bytes
- * The number of bytes per horizontal line of the image.
- * If set to 0, the stride will be set to the minimum size given the \p format and \p width_pixels.
+ * \relates k4a_device_t
  *
- * \param image_handle
- * Pointer to store image handle in.
+ * \return ::K4A_RESULT_SUCCEEDED if all the devices were opened successfully.
  *
  * \remarks
- * This function is used to create images of formats that have consistent stride. The function is not suitable for
- * compressed formats that may not be represented by the same number of bytes per line.
+ * Each device is opened on its own thread, so bringing up many devices takes about as long as opening the slowest of
+ * them rather than the sum of all of them. Each handle is the same as one returned by k4a_device_open() for that
+ * index.
  *
  * \remarks
- * For most image formats, the function will allocate an image buffer of size \p height_pixels * \p stride_bytes.
- * Buffers #K4A_IMAGE_FORMAT_COLOR_NV12 format will allocate an additional \p height_pixels / 2 set of lines (each of \p
- * stride_bytes). This function cannot be used to allocate #K4A_IMAGE_FORMAT_COLOR_MJPG buffers.
+ * If any device fails to open, the devices that were opened are closed again and every entry of device_handles is set
+ * to NULL.
  *
  * \remarks
- * To create an image object without the API allocating memory, or to represent an image that has a non-deterministic
- * stride, use k4a_image_create_from_buffer().
+ * When done with the devices, close each handle with k4a_device_close()
  *
- * \remarks
- * The \ref k4a_image_t is created with a reference count of 1.
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_open_all(uint32_t device_count, k4a_device_t *device_handles);
+
+/** Closes an Azure Kinect device.
  *
- * \remarks
- * When finished using the created image, release it with k4a_image_release.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \returns
- * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED.
+ * \relates k4a_device_t
  *
- * \relates k4a_image_t
+ * \remarks Once closed, the handle is no longer valid.
+ *
+ * \remarks Before closing the handle to the device, ensure that all \ref k4a_capture_t captures have been released with
+ * k4a_capture_release().
  *
  * \xmlonly
  * <requirements>
@@ -632,59 +690,57 @@ K4A_EXPORT float k4a_capture_get_temperature_c(k4a_capture_t capture_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_image_create(k4a_image_format_t format,
-                                         int width_pixels,
-                                         int height_pixels,
-                                         int stride_bytes,
-                                         k4a_image_t *image_handle);
+K4A_EXPORT void k4a_device_close(k4a_device_t device_handle);
 
-/** Create an image from a pre-allocated buffer.
- *
- * \param format
- * The format of the image that will be stored in this image container.
- *
- * \param width_pixels
- * Width in pixels.
+/** Reads a sensor capture.
  *
- * \param height_pixels
- * Height in pixels.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param stride_bytes
- * The number of bytes per horizontal line of the image.
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
+ * this capture.
  *
- * \param buffer
- * Pointer to a pre-allocated image buffer.
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the capture. If set to 0, the function will
+ * return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available, the
+ * device is disconnected, or another error occurs.
  *
- * \param buffer_size
- * Size in bytes of the pre-allocated image buffer.
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if a capture is returned. If a capture is not available before the timeout elapses, the
+ * function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
  *
- * \param buffer_release_cb
- * Callback to the buffer free function, called when all references to the buffer have been released. This parameter is
- * optional.
+ * \relates k4a_device_t
  *
- * \param buffer_release_cb_context
- * Context for the buffer free function. This value will be called as a parameter to \p buffer_release_cb when
- * the callback is invoked.
+ * \remarks
+ * Gets the next capture in the streamed sequence of captures from the camera. If a new capture is not currently
+ * available, this function will block until the timeout is reached. The SDK will buffer at least two captures worth
+ * of data before dropping the oldest capture. Callers needing to capture all data need to ensure they read the data as
+ * fast as the data is being produced on average.
  *
- * \param image_handle
- * Pointer to store image handle in.
+ * \remarks
+ * Upon successfully reading a capture this function will return success and populate \p capture.
+ * If a capture is not available in the configured \p timeout_in_ms, then the API will return ::K4A_WAIT_RESULT_TIMEOUT.
  *
  * \remarks
- * This function creates a \ref k4a_image_t from a pre-allocated buffer. When all references to this object reach zero
- * the provided \p buffer_release_cb callback function is called so that the memory can be released. If this function
- * fails, the API will not use the memory provided in \p buffer, and the API will not call \p buffer_release_cb.
+ * If the call is successful and a capture is returned, callers must call k4a_capture_release() to return the allocated
+ * memory.
  *
  * \remarks
- * The \ref k4a_image_t is created with a reference count of 1.
+ * This function needs to be called while the device is in a running state;
+ * after k4a_device_start_cameras() is called and before k4a_device_stop_cameras() is called.
  *
  * \remarks
- * Release the reference on this function with k4a_image_release().
+ * This function returns an error when an internal problem is encountered; such as loss of the USB connection, inability
+ * to allocate enough memory, and other unexpected issues. Any error returned by this function signals the end of
+ * streaming data, and caller should stop the stream using k4a_device_stop_cameras().
  *
- * \returns
- * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED and error specific data can be
- * found in the log.
+ * \remarks
+ * If this function is waiting for data (non-zero timeout) when k4a_device_stop_cameras() or k4a_device_close() is
+ * called on another thread, this function will return an error.
  *
- * \relates k4a_image_t
+ * \returns ::K4A_WAIT_RESULT_SUCCEEDED if a capture is returned. If a capture is not available before the timeout
+ * elapses, the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
  *
  * \xmlonly
  * <requirements>
@@ -693,31 +749,39 @@ K4A_EXPORT k4a_result_t k4a_image_create(k4a_image_format_t format,
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT k4a_result_t k4a_image_create_from_buffer(k4a_image_format_t format,
-                                                     int width_pixels,
-                                                     int height_pixels,
-                                                     int stride_bytes,
-                                                     uint8_t *buffer,
-                                                     size_t buffer_size,
-                                                     k4a_memory_destroy_cb_t *buffer_release_cb,
-                                                     void *buffer_release_cb_context,
-                                                     k4a_image_t *image_handle);
+K4A_EXPORT k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
+                                                    k4a_capture_t *capture_handle,
+                                                    int32_t timeout_in_ms);
 
-/** Get the image buffer.
+/** Registers a callback that receives captures as soon as they are produced.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Use this buffer to access the raw image data.
+ * \param capture_cb
+ * Callback to receive captures, or NULL to go back to reading captures with k4a_device_get_capture().
+ *
+ * \param capture_cb_context
+ * Context passed to \p capture_cb.
  *
  * \returns
- * The function will return NULL if there is an error, and will normally return a pointer to the image buffer.
- * Since all \ref k4a_image_t instances are created with an image buffer, this function should only return NULL if the
- * \p image_handle is invalid.
+ * ::K4A_RESULT_SUCCEEDED if the callback was set or cleared. ::K4A_RESULT_FAILED if \p device_handle is invalid.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Captures are delivered directly from the thread that produces them, avoiding a queue and a thread wake up per
+ * capture. While a callback is registered captures are not buffered for k4a_device_get_capture().
+ *
+ * \remarks
+ * The callback is invoked while an internal lock is held. It must not call k4a_device_set_capture_callback(),
+ * k4a_device_stop_cameras() or k4a_device_close(), and should return quickly to avoid delaying the next capture.
+ *
+ * \remarks
+ * The callback may be set or cleared at any time, including while the cameras are running. Once this function returns,
+ * the previous callback will not be called again.
  *
  * \xmlonly
  * <requirements>
@@ -726,23 +790,42 @@ K4A_EXPORT k4a_result_t k4a_image_create_from_buffer(k4a_image_format_t format,
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT uint8_t *k4a_image_get_buffer(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_capture_callback(k4a_device_t device_handle,
+                                                        k4a_capture_cb_t *capture_cb,
+                                                        void *capture_cb_context);
 
-/** Get the image buffer size.
+/** Registers a callback that receives depth captures before they are synchronized with color.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Use this function to know what the size of the image buffer is returned by k4a_image_get_buffer().
+ * \param depth_capture_cb
+ * Callback to receive depth captures, or NULL to stop receiving them.
+ *
+ * \param depth_capture_cb_context
+ * Context passed to \p depth_capture_cb.
  *
  * \returns
- * The function will return 0 if there is an error, and will normally return the image size.
- * Since all \ref k4a_image_t instances are created with an image buffer, this function should only return 0 if the
- * \p image_handle is invalid.
+ * ::K4A_RESULT_SUCCEEDED if the callback was set or cleared. ::K4A_RESULT_FAILED if \p device_handle is invalid.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Each capture passed to \p depth_capture_cb holds only the depth and IR images, and is delivered as soon as the depth
+ * engine produces it. It doesn't wait for a matching color image. Applications that only need depth get it
+ * without the latency of the color pipeline.
+ *
+ * \remarks
+ * The depth and IR images are still synchronized with color as usual. The synchronized capture that follows through
+ * k4a_device_get_capture() or k4a_device_set_capture_callback() contains the same images, with the same device
+ * timestamp, plus the matching color image.
+ *
+ * \remarks
+ * The callback runs on the depth streaming thread and delays the next depth capture until it returns. It must not call
+ * k4a_device_set_depth_capture_callback(), k4a_device_stop_cameras() or k4a_device_close(). Once this function returns,
+ * the previous callback will not be called again.
  *
  * \xmlonly
  * <requirements>
@@ -751,22 +834,41 @@ K4A_EXPORT uint8_t *k4a_image_get_buffer(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT size_t k4a_image_get_size(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_capture_callback(k4a_device_t device_handle,
+                                                              k4a_capture_cb_t *depth_capture_cb,
+                                                              void *depth_capture_cb_context);
 
-/** Get the format of the image.
+/** Attaches the IMU samples taken during each capture's exposure to the capture.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Use this function to determine the format of the image buffer.
+ * \param enabled
+ * True to attach the IMU samples to the captures, false to stop.
  *
  * \returns
- * This function is not expected to fail, all \ref k4a_image_t's are created with a known format. If the
- * \p image_handle is invalid, the function will return ::K4A_IMAGE_FORMAT_CUSTOM.
+ * ::K4A_RESULT_SUCCEEDED if the option was set. ::K4A_RESULT_FAILED if \p device_handle is invalid or the samples could
+ * not be buffered.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The SDK keeps the last second of IMU samples and copies the ones taken during the exposure of a capture to the
+ * capture when it is synchronized, where they are read with k4a_capture_get_imu_samples(). Applications no longer need
+ * to buffer the IMU stream and search it for the samples of each frame. Reading the IMU with
+ * k4a_device_get_imu_sample() is not affected, the samples are attached to the captures in addition to being queued.
+ *
+ * \remarks
+ * Image timestamps are the middle of the exposure. The samples of a color image are the ones within its exposure time.
+ * Depth and IR images don't report an exposure time, they get the samples within half a frame period of their
+ * timestamp, so consecutive depth captures together hold every sample.
+ *
+ * \remarks
+ * Samples are only attached while the IMU is running, see k4a_device_start_imu(). Only the samples that arrived before
+ * the capture was synchronized are attached; the IMU stream usually runs ahead of the cameras, but the last samples of
+ * an exposure can be missing when it lags.
  *
  * \xmlonly
  * <requirements>
@@ -775,19 +877,32 @@ K4A_EXPORT size_t k4a_image_get_size(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT k4a_image_format_t k4a_image_get_format(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_capture_imu_samples(k4a_device_t device_handle, bool enabled);
 
-/** Get the image width in pixels.
+/** Gets statistics of the captures synchronized for an Azure Kinect device.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param stats
+ * Location to write the statistics.
  *
  * \returns
- * This function is not expected to fail, all \ref k4a_image_t's are created with a known width. If the \p
- * image_handle is invalid, the function will return 0.
+ * ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED if \p device_handle is invalid or \p stats is
+ * NULL.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The counters break down where captures are lost: depth captures dropped while the device timestamps reset, captures
+ * that found no match within the sync window, internal sync queues that overflowed, and captures the application
+ * didn't read in time. Reading them is cheap and doesn't require K4A_ENABLE_TS_LOGGING.
+ *
+ * \remarks
+ * Counters are reset when k4a_device_start_cameras() is called. Unmatched captures are still returned to the
+ * application unless synchronized_images_only is set.
  *
  * \xmlonly
  * <requirements>
@@ -796,19 +911,44 @@ K4A_EXPORT k4a_image_format_t k4a_image_get_format(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT int k4a_image_get_width_pixels(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_get_capture_stats(k4a_device_t device_handle, k4a_capture_stats_t *stats);
 
-/** Get the image height in pixels.
+/** Gets statistics of a USB streaming endpoint of an Azure Kinect device.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param stream
+ * The streaming endpoint to read the statistics of.
+ *
+ * \param stats
+ * Location to write the statistics.
  *
  * \returns
- * This function is not expected to fail, all \ref k4a_image_t's are created with a known height. If the \p
- * image_handle is invalid, the function will return 0.
+ * ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED if \p device_handle is invalid, \p stream is
+ * not valid or \p stats is NULL.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Timeouts and resubmit failures point to a USB controller that is shared with other devices or short on memory for
+ * in-flight transfers; the latency histogram shows how long transfers wait for the device.
+ *
+ * \remarks
+ * The number of in-flight transfers is fixed by default. Setting the environment variable K4A_LIBUSB_ADAPTIVE=1
+ * before starting the cameras lets each stream tune it at run time: it grows when the USB event thread falls behind
+ * the device and shrinks when transfers time out, fail to be submitted, or sit idle. K4A_MAX_LIBUSB_POOL still caps
+ * the memory used for transfers.
+ *
+ * \remarks
+ * When a transfer fails with a USB error, the stream cancels its other transfers, clears the halt on the endpoint and
+ * submits the transfers again, each time counted in stream_recoveries. The depth engine, the color stream and the
+ * capture queues keep running and only miss the frames lost during the reset. The error is reported and the stream
+ * ends as before when the device is gone or after several recoveries without a completed transfer in between.
+ * Setting the environment variable K4A_LIBUSB_RECOVERY=0 before starting the cameras ends the stream on the first
+ * error instead.
  *
  * \xmlonly
  * <requirements>
@@ -817,19 +957,44 @@ K4A_EXPORT int k4a_image_get_width_pixels(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT int k4a_image_get_height_pixels(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_get_usb_stream_stats(k4a_device_t device_handle,
+                                                        k4a_usb_stream_t stream,
+                                                        k4a_usb_stream_stats_t *stats);
 
-/** Get the image stride in bytes.
+/** Gets the metrics of an Azure Kinect device as counters, gauges and histograms.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param metrics
+ * Location to write the metrics to. If this input is NULL \p metric_count will still be updated to return the number
+ * of metrics.
+ *
+ * \param metric_count
+ * On input, the number of elements of \p metrics if that pointer is not NULL. On output, the number of metrics of the
+ * device.
  *
  * \returns
- * This function is not expected to fail, all \ref k4a_image_t's are created with a known stride. If the
- * \p image_handle is invalid, or the image's format does not have a stride, the function will return 0.
+ * A return of ::K4A_BUFFER_RESULT_SUCCEEDED means that \p metrics has been filled in. If the buffer is too small the
+ * function returns ::K4A_BUFFER_RESULT_TOO_SMALL, the metrics that fit are filled in and the number of metrics is
+ * returned in \p metric_count. All other failures return ::K4A_BUFFER_RESULT_FAILED.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The metrics bring the statistics of the SDK together in one list, named and typed so that an agent can export them
+ * to Prometheus or OpenTelemetry without knowing each statistics structure: the USB streams of
+ * k4a_device_get_usb_stream_stats() labeled by stream, the capture synchronization counters of
+ * k4a_device_get_capture_stats(), the frames processed, failed and slower than the frame period by the depth engine,
+ * the allocator statistics of k4a_get_allocator_stats() labeled by source, and the pipeline latency histograms of
+ * k4a_get_latency_stats() labeled by stage. The allocator and latency metrics are process wide, they are the same for
+ * every device.
+ *
+ * \remarks
+ * Metrics are read from the statistics kept by the SDK, collecting them doesn't slow down the streams. The number of
+ * metrics doesn't change while a device is open.
  *
  * \xmlonly
  * <requirements>
@@ -838,27 +1003,41 @@ K4A_EXPORT int k4a_image_get_height_pixels(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT int k4a_image_get_stride_bytes(k4a_image_t image_handle);
+K4A_EXPORT k4a_buffer_result_t k4a_device_get_metrics(k4a_device_t device_handle,
+                                                      k4a_metric_t *metrics,
+                                                      size_t *metric_count);
 
-/** Get the image's device timestamp in microseconds.
+/** Delivers the metrics of an Azure Kinect device to a callback periodically.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Returns the device timestamp of the image. Timestamps are recorded by the device and represent the mid-point of
- * exposure. They may be used for relative comparison, but their absolute value has no defined meaning.
+ * \param metrics_cb
+ * Callback to receive the metrics, or NULL to stop delivering them.
+ *
+ * \param metrics_cb_context
+ * Context passed to \p metrics_cb.
+ *
+ * \param period_ms
+ * Time between two deliveries in milliseconds. Ignored when \p metrics_cb is NULL.
  *
  * \returns
- * If the \p image_handle is invalid or if no timestamp was set for the image,
- * this function will return 0. It is also possible for 0 to be a valid timestamp originating from the beginning
- * of a recording or the start of streaming.
+ * ::K4A_RESULT_SUCCEEDED if the callback was set or cleared. ::K4A_RESULT_FAILED if \p device_handle is invalid, \p
+ * period_ms is 0 or the thread delivering the metrics could not be started.
  *
- * \deprecated
- * Deprecated starting in 1.2.0. Please use k4a_image_get_device_timestamp_usec().
+ * \relates k4a_device_t
  *
- * \relates k4a_image_t
+ * \remarks
+ * The callback receives the same metrics as k4a_device_get_metrics(), from a thread of the device that only
+ * delivers metrics, for example to push them to an OpenTelemetry collector or to refresh what a Prometheus endpoint
+ * serves. The first delivery is one period after the callback is set, and deliveries continue whether the cameras are
+ * running or not until the callback is cleared or the device is closed.
+ *
+ * \remarks
+ * Setting a callback replaces the previous one. This function waits for a delivery in progress to complete, so it
+ * must not be called from the callback, and it must not be called for the same device from several threads at once.
  *
  * \xmlonly
  * <requirements>
@@ -867,59 +1046,47 @@ K4A_EXPORT int k4a_image_get_stride_bytes(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_DEPRECATED_EXPORT uint64_t k4a_image_get_timestamp_usec(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_metrics_callback(k4a_device_t device_handle,
+                                                       k4a_metrics_cb_t *metrics_cb,
+                                                       void *metrics_cb_context,
+                                                       uint32_t period_ms);
 
-/** Get the image's device timestamp in microseconds.
+/** Sets the depth of a stream's queue and what happens when it is full.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Returns the device timestamp of the image, as captured by the hardware. Timestamps are recorded by the device and
- * represent the mid-point of exposure. They may be used for relative comparison, but their absolute value has no
- * defined meaning.
+ * \param stream
+ * The stream whose queue is configured.
  *
- * \returns
- * If the \p image_handle is invalid or if no timestamp was set for the image, this function will return 0. It is also
- * possible for 0 to be a valid timestamp originating from the beginning of a recording or the start of streaming.
+ * \param queue_depth
+ * Number of entries the queue holds, or 0 for the default of half a second of data.
  *
- * \relates k4a_image_t
+ * \param policy
+ * What happens when data arrives while the queue is full.
  *
- * \xmlonly
- * <requirements>
- *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
- *   <requirement name="Library">k4a.lib</requirement>
- *   <requirement name="DLL">k4a.dll</requirement>
- * </requirements>
- * \endxmlonly
- */
-K4A_EXPORT uint64_t k4a_image_get_device_timestamp_usec(k4a_image_t image_handle);
-
-/** Get the image's system timestamp in nanoseconds.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the queue was configured. ::K4A_RESULT_FAILED if an argument is invalid, the stream is
+ * running, or the policy isn't supported by the stream.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \relates k4a_device_t
  *
  * \remarks
- * Returns the system timestamp of the image. Timestamps are recorded by the host. They may be used for relative
- * comparision, as they are relative to the corresponding system clock. The absolute value is a monotonic count from
- * an arbitrary point in the past.
+ * The configuration applies the next time the stream is started, it must be set while the stream is stopped: before
+ * k4a_device_start_cameras() for ::K4A_QUEUE_STREAM_CAPTURE, before k4a_device_start_imu() for
+ * ::K4A_QUEUE_STREAM_IMU. It is kept until it is set again or the device is closed.
  *
  * \remarks
- * The system timestamp is captured at the moment host PC finishes receiving the image.
+ * A depth of 1 with ::K4A_QUEUE_POLICY_DROP_OLDEST always returns the most recent data, which gives latency critical
+ * applications the lowest age for each frame. A deeper queue absorbs jitter in the application, for example when
+ * recording.
  *
  * \remarks
- * On Linux the system timestamp is read from clock_gettime(CLOCK_MONOTONIC), which measures realtime and is not
- * impacted by adjustments to the system clock. It starts from an arbitrary point in the past. On Windows the system
- * timestamp is read from QueryPerformanceCounter(), it also measures realtime and is not impacted by adjustments to the
- * system clock. It also starts from an arbitrary point in the past.
- *
- * \returns
- * If the \p image_handle is invalid or if no timestamp was set for the image, this function will return 0. It is also
- * possible for 0 to be a valid timestamp originating from the beginning of a recording or the start of streaming.
- *
- * \relates k4a_image_t
+ * ::K4A_QUEUE_POLICY_BLOCK is only supported by ::K4A_QUEUE_STREAM_CAPTURE. While blocked the SDK doesn't process
+ * further depth or color data, so the application must keep reading captures or the device will drop data over USB.
+ * The queue isn't used while a callback is set with k4a_device_set_capture_callback().
  *
  * \xmlonly
  * <requirements>
@@ -928,22 +1095,36 @@ K4A_EXPORT uint64_t k4a_image_get_device_timestamp_usec(k4a_image_t image_handle
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT uint64_t k4a_image_get_system_timestamp_nsec(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_queue_policy(k4a_device_t device_handle,
+                                                    k4a_queue_stream_t stream,
+                                                    uint32_t queue_depth,
+                                                    k4a_queue_policy_t policy);
 
-/** Get the image exposure in microseconds.
+/** Selects the GPU the depth engine of a device runs on.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Returns an exposure time in microseconds. This is only supported on color image formats.
+ * \param gpu_index
+ * Index of the GPU, ::K4A_DEPTH_ENGINE_GPU_AUTO for the least loaded GPU, or ::K4A_DEPTH_ENGINE_GPU_DEFAULT for the
+ * GPU the depth engine plugin picks.
  *
  * \returns
- * If the \p image_handle is invalid, or no exposure was set on the image, the function will return 0. Otherwise,
- * it will return the image exposure time in microseconds.
+ * ::K4A_RESULT_SUCCEEDED if the GPU was set. ::K4A_RESULT_FAILED if an argument is invalid or the cameras are running.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The GPU applies the next time k4a_device_start_cameras() is called, it must be set while the cameras are stopped. It
+ * is kept until it is set again or the device is closed.
+ *
+ * \remarks
+ * Placing depth engines on GPUs needs support from the depth engine plugin. With ::K4A_DEPTH_ENGINE_GPU_AUTO, the load
+ * of a GPU is the sum of the depth pixels per second of the depth engines this process runs on it, and the GPU with
+ * the lowest load is used; without plugin support the default GPU is used. If a GPU index is given and it can't be
+ * used, k4a_device_start_cameras() fails.
  *
  * \xmlonly
  * <requirements>
@@ -952,22 +1133,38 @@ K4A_EXPORT uint64_t k4a_image_get_system_timestamp_nsec(k4a_image_t image_handle
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT uint64_t k4a_image_get_exposure_usec(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_engine_gpu(k4a_device_t device_handle, int32_t gpu_index);
 
-/** Get the image white balance.
+/** Shares one depth engine between the devices of this process that use the same depth mode.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * Returns the image's white balance. This function is only valid for color captures, and not for depth or IR captures.
+ * \param shared
+ * true to share the depth engine with other devices that have sharing enabled, false for a depth engine of its own.
  *
  * \returns
- * Returns the image white balance in Kelvin. If \p image_handle is invalid, or the white balance was not set or
- * not applicable to the image, the function will return 0.
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid or the cameras are
+ * running.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The setting applies the next time k4a_device_start_cameras() is called, it must be set while the cameras are stopped.
+ * It is kept until it is set again or the device is closed.
+ *
+ * \remarks
+ * Devices sharing a depth engine use the same GPU context, shaders and intermediate buffers, which saves GPU memory and
+ * context switches when many devices run on one GPU. Devices are grouped by depth mode and by the GPU selected with
+ * k4a_device_set_depth_engine_gpu(). Raw frames from the devices of a group that arrive within about 2ms are processed
+ * in one batch, so devices synchronized with the sync cables benefit the most; a frame waits at most that long for
+ * the other devices.
+ *
+ * \remarks
+ * Sharing needs support from the depth engine plugin. Without it each device gets a depth engine of its own, as if
+ * sharing was disabled.
  *
  * \xmlonly
  * <requirements>
@@ -976,21 +1173,34 @@ K4A_EXPORT uint64_t k4a_image_get_exposure_usec(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT uint32_t k4a_image_get_white_balance(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_engine_shared(k4a_device_t device_handle, bool shared);
 
-/** Get the image ISO speed.
+/** Keeps the depth engine of a device initialized while the cameras are stopped.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \remarks
- * This function is only valid for color captures, and not for depth  or IR captures.
+ * \param keep_alive
+ * true to keep the depth engine initialized after k4a_device_stop_cameras(), false to release it.
  *
  * \returns
- * Returns the ISO speed of the image. 0 indicates the ISO speed was not available or an error occurred.
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid or the cameras are
+ * running.
  *
- * \relates k4a_image_t
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Initializing the depth engine compiles its GPU programs and uploads the calibration, which makes up most of the time
+ * k4a_device_start_cameras() takes. With keep_alive, the next k4a_device_start_cameras() with the same depth mode
+ * reuses the depth engine and resumes in milliseconds. A start with a different depth mode initializes a new depth
+ * engine.
+ *
+ * \remarks
+ * A kept depth engine holds its GPU memory until the cameras are started with another depth mode, keep_alive is
+ * disabled and the cameras are stopped, or the device is closed. Depth engines shared with
+ * k4a_device_set_depth_engine_shared() aren't kept.
  *
  * \xmlonly
  * <requirements>
@@ -999,25 +1209,33 @@ K4A_EXPORT uint32_t k4a_image_get_white_balance(k4a_image_t image_handle);
  *   <requirement name="DLL">k4a.dll</requirement>
  * </requirements>
  * \endxmlonly
+ *
  */
-K4A_EXPORT uint32_t k4a_image_get_iso_speed(k4a_image_t image_handle);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_engine_keep_alive(k4a_device_t device_handle, bool keep_alive);
 
-/** Set the device time stamp, in microseconds, of the image.
+/** Filters the depth images of a device.
  *
- * \param image_handle
- * Handle of the image to set the timestamp on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param timestamp_usec
- * Device timestamp of the image in microseconds.
+ * \param config
+ * The filters to run, see ::k4a_depth_filter_configuration_t. NULL disables filtering, which is the default.
  *
- * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the filters were set. ::K4A_RESULT_FAILED if the handle is invalid, the cameras are
+ * running or a setting of \p config is out of range.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * The device timestamp represents the mid-point of exposure of the image, as captured by the hardware.
+ * Applies the next time the cameras are started with k4a_device_start_cameras(). The filters run on the depth engine
+ * thread right after the depth engine produced the depth image, or on the shared SDK worker threads when \p config
+ * has a thread_count above 1. They write to the buffer of the depth image, so the depth images of the captures are
+ * filtered without a copy and can be passed to the transformation functions directly.
  *
- * \relates k4a_image_t
+ * \remarks
+ * Filtering adds to the time the depth engine thread spends on each capture. Raise the thread_count of \p config when
+ * one thread can't keep up with the frame rate.
  *
  * \xmlonly
  * <requirements>
@@ -1027,27 +1245,38 @@ K4A_EXPORT uint32_t k4a_image_get_iso_speed(k4a_image_t image_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_set_device_timestamp_usec(k4a_image_t image_handle, uint64_t timestamp_usec);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_filter(k4a_device_t device_handle,
+                                                    const k4a_depth_filter_configuration_t *config);
 
-/** Set the device time stamp, in microseconds, of the image.
+/** Keeps the depth engine output of a device on the GPU as an exported resource.
  *
- * \param image_handle
- * Handle of the image to set the timestamp on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param timestamp_usec
- * Device timestamp of the image in microseconds.
+ * \param config
+ * How the resources are shared, see ::k4a_depth_gpu_export_configuration_t. NULL disables the export, which is the
+ * default.
  *
- * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the export was set. ::K4A_RESULT_FAILED if the handle is invalid, the cameras are running
+ * or the interop type of \p config is unknown.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * The device timestamp represents the mid-point of exposure of the image, as captured by the hardware.
+ * Applies the next time the cameras are started with k4a_device_start_cameras(). The depth engine then writes the depth
+ * and IR images of every capture to a GPU resource, which k4a_image_get_gpu_resource() returns for both images.
+ * GPU-only pipelines can set skip_depth_readback so the depth image is not copied to host memory, and pass the resource
+ * to k4a_transformation_depth_resource_to_color_camera_gpu() so it is not uploaded again either.
  *
- * \relates k4a_image_t
+ * \remarks
+ * The depth engine writes ::K4A_DEPTH_GPU_EXPORT_SLOT_COUNT resources in turn, so an application has that many
+ * captures of time to use a resource. All of them become invalid when the cameras are stopped.
  *
- * \deprecated
- * Deprecated starting in 1.2.0. Please use k4a_image_set_device_timestamp_usec().
+ * \remarks
+ * When the depth engine plugin does not support the export, or the depth engine is shared with
+ * k4a_device_set_depth_engine_shared(), the cameras start without it and a warning is logged. The depth filter of
+ * k4a_device_set_depth_filter() runs on the host copy only.
  *
  * \xmlonly
  * <requirements>
@@ -1057,25 +1286,32 @@ K4A_EXPORT void k4a_image_set_device_timestamp_usec(k4a_image_t image_handle, ui
  * </requirements>
  * \endxmlonly
  */
-K4A_DEPRECATED_EXPORT void k4a_image_set_timestamp_usec(k4a_image_t image_handle, uint64_t timestamp_usec);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_gpu_export(k4a_device_t device_handle,
+                                                        const k4a_depth_gpu_export_configuration_t *config);
 
-/** Set the system time stamp, in nanoseconds, of the image.
+/** Leaves the IR images out of the depth captures of a device.
  *
- * \param image_handle
- * Handle of the image to set the timestamp on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param timestamp_nsec
- * Timestamp of the image in nanoseconds.
+ * \param depth_only
+ * true to have the depth engine output depth images only, false to output depth and IR images, which is the default.
  *
- * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid or the cameras are
+ * running.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * The system timestamp is a high performance and increasing clock (from boot). The timestamp represents the time
- * immediately after the image buffer was read by the host PC.
+ * Applies the next time the cameras are started with k4a_device_start_cameras(). The depth engine then doesn't write
+ * the IR image, which halves its output buffer and the readback from the GPU, and k4a_capture_get_ir_image() returns
+ * NULL for the captures of the device.
  *
- * \relates k4a_image_t
+ * \remarks
+ * The setting is ignored, and a warning logged, in ::K4A_DEPTH_MODE_PASSIVE_IR, when the depth engine plugin doesn't
+ * support it, when the depth engine is shared with k4a_device_set_depth_engine_shared() and when
+ * k4a_device_set_depth_gpu_export() skips the depth readback, as the IR image is the only image of a capture then.
  *
  * \xmlonly
  * <requirements>
@@ -1085,22 +1321,33 @@ K4A_DEPRECATED_EXPORT void k4a_image_set_timestamp_usec(k4a_image_t image_handle
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_set_system_timestamp_nsec(k4a_image_t image_handle, uint64_t timestamp_nsec);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_only(k4a_device_t device_handle, bool depth_only);
 
-/** Set the exposure time, in microseconds, of the image.
+/** Replaces the IR16 images of the depth captures of a device with tone mapped 8 bit IR images.
  *
- * \param image_handle
- * Handle of the image to set the exposure time on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param exposure_usec
- * Exposure time of the image in microseconds.
+ * \param config
+ * How the IR values are mapped to 8 bits, see ::k4a_ir8_configuration_t. NULL outputs IR16 images, which is the
+ * default.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid, the cameras are
+ * running or a setting of \p config is out of range.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t. An exposure time of 0 is considered invalid. Only color image formats are expected to have a valid
- * exposure time.
+ * Applies the next time the cameras are started with k4a_device_start_cameras(). The depth engine thread then maps
+ * each IR image to a ::K4A_IMAGE_FORMAT_CUSTOM8 image of the same size, which k4a_capture_get_ir_image() returns in
+ * place of the IR16 image. The IR images of the captures take half the memory, and applications that only display or
+ * track features in the IR image don't each convert it.
  *
- * \relates k4a_image_t
+ * \remarks
+ * The 8 bit IR images carry no GPU resource of k4a_device_set_depth_gpu_export(). The setting has no effect when
+ * k4a_device_set_depth_only() leaves the IR images out. k4a_record_write_capture() only records IR16 images, so
+ * captures with an 8 bit IR image must be recorded without it.
  *
  * \xmlonly
  * <requirements>
@@ -1110,25 +1357,34 @@ K4A_EXPORT void k4a_image_set_system_timestamp_nsec(k4a_image_t image_handle, ui
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_set_exposure_usec(k4a_image_t image_handle, uint64_t exposure_usec);
+K4A_EXPORT k4a_result_t k4a_device_set_ir8_output(k4a_device_t device_handle, const k4a_ir8_configuration_t *config);
 
-/** Set the exposure time, in microseconds, of the image.
+/** Processes only one of every few raw depth frames of a device.
  *
- * \param image_handle
- * Handle of the image to set the exposure time on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param exposure_usec
- * Exposure time of the image in microseconds.
+ * \param decimation
+ * Number of raw frames per processed frame. 0 or 1 processes every frame, which is the default.
  *
- * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t. An exposure time of 0 is considered invalid. Only color image formats are expected to have a valid
- * exposure time.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid or the cameras are
+ * running.
  *
- * \deprecated
- * Deprecated starting in 1.2.0. Please use k4a_image_set_exposure_usec().
+ * \relates k4a_device_t
  *
- * \relates k4a_image_t
+ * \remarks
+ * The depth sensor keeps running at the camera_fps of k4a_device_start_cameras(), and only the first of every
+ * \p decimation raw frames is processed by the depth engine. For example ::K4A_FRAMES_PER_SECOND_30 with a decimation
+ * of 3 gives depth at 10 frames per second. The other raw frames are dropped as they arrive from USB, before a capture
+ * is allocated for them, so the GPU time of the depth engine scales with the depth frames actually used. The load of
+ * the device for ::K4A_DEPTH_ENGINE_GPU_AUTO is reduced accordingly.
+ *
+ * \remarks
+ * Applies the next time the cameras are started with k4a_device_start_cameras(). Color images are not decimated, with
+ * synchronized_images_only the captures are limited to the depth rate, otherwise the color images between depth
+ * frames are delivered in captures of their own. The raw frames kept are counted from the start of the cameras, so
+ * devices synchronized with the sync cables can keep different raw frames.
  *
  * \xmlonly
  * <requirements>
@@ -1138,22 +1394,34 @@ K4A_EXPORT void k4a_image_set_exposure_usec(k4a_image_t image_handle, uint64_t e
  * </requirements>
  * \endxmlonly
  */
-K4A_DEPRECATED_EXPORT void k4a_image_set_exposure_time_usec(k4a_image_t image_handle, uint64_t exposure_usec);
+K4A_EXPORT k4a_result_t k4a_device_set_depth_frame_decimation(k4a_device_t device_handle, uint32_t decimation);
 
-/** Set the white balance of the image.
+/** Sets what the depth engine of a device does when it can't keep up with the frame rate.
  *
- * \param image_handle
- * Handle of the image to set the white balance on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param white_balance
- * White balance of the image in degrees Kelvin.
+ * \param config
+ * The overload policy, NULL to never drop raw frames, which is the default.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the setting was changed. ::K4A_RESULT_FAILED if the handle is invalid or the cameras are
+ * running.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t. A white balance of 0 is considered invalid. White balance is only meaningful for color images,
- * and not expected on depth or IR images.
+ * A depth engine that is slower than the frame rate, because the GPU is shared with the application or another device,
+ * otherwise processes every raw frame late and the latency of the captures grows up to the depth of its queue. With
+ * an overload policy the raw frames it can't keep up with are dropped instead, and the callback of \p config lets the
+ * application reduce its own load. See k4a_depth_engine_overload_configuration_t.
  *
- * \relates k4a_image_t
+ * \remarks
+ * The time the depth engine took for each image is available with k4a_image_get_compute_time_usec(), and as a
+ * histogram in the metrics of k4a_device_get_metrics() whether a policy is set or not.
+ *
+ * \remarks
+ * Applies the next time the cameras are started with k4a_device_start_cameras().
  *
  * \xmlonly
  * <requirements>
@@ -1163,21 +1431,55 @@ K4A_DEPRECATED_EXPORT void k4a_image_set_exposure_time_usec(k4a_image_t image_ha
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_set_white_balance(k4a_image_t image_handle, uint32_t white_balance);
+K4A_EXPORT k4a_result_t
+k4a_device_set_depth_engine_overload_policy(k4a_device_t device_handle,
+                                            const k4a_depth_engine_overload_configuration_t *config);
 
-/** Set the ISO speed of the image.
+/** Reads an IMU sample.
  *
- * \param image_handle
- * Handle of the image to set the ISO speed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
  *
- * \param iso_speed
- * ISO speed of the image.
+ * \param imu_sample
+ * Pointer to the location for the API to write the IMU sample.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the sample. If set to 0, the function will
+ * return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available, the
+ * device is disconnected, or another error occurs.
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if a sample is returned. If a sample is not available before the timeout elapses, the
+ * function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
- * \ref k4a_image_t. An ISO speed of 0 is considered invalid. Only color images are expected to have a valid ISO speed.
+ * Gets the next sample in the streamed sequence of IMU samples from the device. If a new sample is not currently
+ * available, this function will block until the timeout is reached. The API will buffer at least two camera capture
+ * intervals worth of samples before dropping the oldest sample. Callers needing to capture all data need to ensure they
+ * read the data as fast as the data is being produced on average.
  *
- * \relates k4a_image_t
+ * \remarks
+ * Upon successfully reading a sample this function will return success and populate \p imu_sample.
+ * If a sample is not available in the configured \p timeout_in_ms, then the API will return ::K4A_WAIT_RESULT_TIMEOUT.
+ *
+ * \remarks
+ * This function needs to be called while the device is in a running state;
+ * after k4a_device_start_imu() is called and before k4a_device_stop_imu() is called.
+ *
+ * \remarks
+ * This function returns an error when an internal problem is encountered; such as loss of the USB connection, inability
+ * to allocate enough memory, and other unexpected issues. Any error returned by this function signals the end of
+ * streaming data, and caller should stop the stream using k4a_device_stop_imu().
+ *
+ * \remarks
+ * If this function is waiting for data (non-zero timeout) when k4a_device_stop_imu() or k4a_device_close() is
+ * called on another thread, this function will return an error.
+ *
+ * \remarks
+ * The memory the IMU sample is written to is allocated and owned by the caller, so there is no need to call an Azure
+ * Kinect API to free or release the sample.
  *
  * \xmlonly
  * <requirements>
@@ -1187,18 +1489,43 @@ K4A_EXPORT void k4a_image_set_white_balance(k4a_image_t image_handle, uint32_t w
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_set_iso_speed(k4a_image_t image_handle, uint32_t iso_speed);
+K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
+                                                       k4a_imu_sample_t *imu_sample,
+                                                       int32_t timeout_in_ms);
 
-/** Add a reference to the k4a_image_t.
+/** Reads all buffered IMU samples, up to a maximum count, in one call.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param imu_samples
+ * Pointer to an array of \p max_sample_count samples for the API to write the IMU samples to.
+ *
+ * \param max_sample_count
+ * Number of samples \p imu_samples can hold, at least 1.
+ *
+ * \param sample_count
+ * Pointer to the location for the API to write the number of samples written to \p imu_samples.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for a sample when none is buffered. If set to
+ * 0, the function will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until
+ * data is available, the device is disconnected, or another error occurs.
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if at least one sample is returned. If no sample is available before the timeout
+ * elapses, the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return
+ * ::K4A_WAIT_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * References manage the lifetime of the object. When the references reach zero the object is destroyed. A caller must
- * not access the object after its reference is released.
+ * Writes the buffered samples in the streamed sequence, oldest first, without waiting for more samples than are
+ * buffered when one is available. Reading the backlog this way avoids a call per sample at the IMU sample rate.
  *
- * \relates k4a_image_t
+ * \remarks
+ * Samples and errors are the same as for k4a_device_get_imu_sample(). Both functions read from the same stream, each
+ * sample is returned by only one call.
  *
  * \xmlonly
  * <requirements>
@@ -1208,18 +1535,52 @@ K4A_EXPORT void k4a_image_set_iso_speed(k4a_image_t image_handle, uint32_t iso_s
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_reference(k4a_image_t image_handle);
+K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                                        k4a_imu_sample_t *imu_samples,
+                                                        size_t max_sample_count,
+                                                        size_t *sample_count,
+                                                        int32_t timeout_in_ms);
 
-/** Remove a reference from the k4a_image_t.
+/** Waits until any of several device streams can be read without blocking.
  *
- * \param image_handle
- * Handle of the image for which the get operation is performed on.
+ * \param sources
+ * Array of \p source_count streams to wait for. The device and stream of each entry are set by the caller, the ready
+ * flag of each entry is written by the API.
+ *
+ * \param source_count
+ * Number of entries in \p sources, at least 1.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for a stream to become ready. If set to 0, the
+ * function will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until a stream
+ * is ready.
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if at least one stream is ready. If no stream becomes ready before the timeout elapses,
+ * the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return ::K4A_WAIT_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * References manage the lifetime of the object. When the references reach zero the object is destroyed. A caller must
- * not access the object after its reference is released.
+ * A single thread can service the captures and IMU samples of many devices, instead of blocking one thread in
+ * k4a_device_get_capture() and another in k4a_device_get_imu_sample() for each device. After this function returns,
+ * read each stream flagged as ready with a timeout of 0, using k4a_device_get_capture() for
+ * ::K4A_QUEUE_STREAM_CAPTURE and k4a_device_get_imu_sample() or k4a_device_get_imu_samples() for
+ * ::K4A_QUEUE_STREAM_IMU. Reading every ready stream before waiting again keeps a busy stream from delaying the others.
  *
- * \relates k4a_image_t
+ * \remarks
+ * A stream is ready when it holds data, or when it is not running, in which case the read fails immediately as it
+ * would for a stream that was stopped or disconnected while waiting in its read function. Only streams that are
+ * running should be passed in.
+ *
+ * \remarks
+ * Each stream can be waited on by up to 8 calls at a time. The same stream should only be read by one thread, as with
+ * the other read functions. Captures sent to a callback registered with k4a_device_set_capture_callback() are not
+ * queued, so the capture stream of such a device never becomes ready.
+ *
+ * \remarks
+ * The wait is portable and does not expose operating system objects, such as an eventfd or a HANDLE, that could be
+ * added to an application's own epoll or WaitForMultipleObjects set.
  *
  * \xmlonly
  * <requirements>
@@ -1229,27 +1590,37 @@ K4A_EXPORT void k4a_image_reference(k4a_image_t image_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_image_release(k4a_image_t image_handle);
+K4A_EXPORT k4a_wait_result_t k4a_device_wait_any(k4a_wait_source_t *sources,
+                                                 size_t source_count,
+                                                 int32_t timeout_in_ms);
 
-/** Starts color and depth camera capture.
+/** Maps a device timestamp to the clock of the system timestamps.
  *
  * \param device_handle
  * Handle obtained by k4a_device_open().
  *
- * \param config
- * The configuration we want to run the device in. This can be initialized with ::K4A_DEVICE_CONFIG_INIT_DISABLE_ALL.
+ * \param device_timestamp_usec
+ * A device timestamp, from k4a_image_get_device_timestamp_usec() or the timestamps of a ::k4a_imu_sample_t.
+ *
+ * \param system_timestamp_nsec
+ * Pointer to the location for the API to write the system time, on the clock of
+ * k4a_image_get_system_timestamp_nsec().
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED is returned on success.
+ * ::K4A_RESULT_SUCCEEDED if the timestamp was mapped. ::K4A_RESULT_FAILED if the cameras have not delivered enough
+ * captures since they started to model the device clock, or if an argument is invalid.
  *
  * \relates k4a_device_t
  *
  * \remarks
- * Individual sensors configured to run will now start to stream captured data.
+ * The system timestamp of an image is read when the image arrives at the host, so it varies with the USB transfer and
+ * processing latency of each image. The SDK fits a linear model of the device clock to the system clock from the
+ * arrival of every depth and color capture. The model follows the earliest arrivals, so the mapped time does not
+ * carry that jitter and device timestamps of images and IMU samples from the same device map consistently.
  *
  * \remarks
- * It is not valid to call k4a_device_start_cameras() a second time on the same \ref k4a_device_t until
- * k4a_device_stop_cameras() has been called.
+ * The model is reset when the cameras are started, as the device clock restarts. It covers device timestamps from the
+ * last 16 seconds, and extrapolates for timestamps outside of them.
  *
  * \xmlonly
  * <requirements>
@@ -1259,22 +1630,30 @@ K4A_EXPORT void k4a_image_release(k4a_image_t image_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_device_configuration_t *config);
+K4A_EXPORT k4a_result_t k4a_device_get_system_timestamp_nsec(k4a_device_t device_handle,
+                                                             uint64_t device_timestamp_usec,
+                                                             uint64_t *system_timestamp_nsec);
 
-/** Stops the color and depth camera capture.
+/** Maps a device timestamp to the shared timebase.
  *
  * \param device_handle
  * Handle obtained by k4a_device_open().
  *
- * \relates k4a_device_t
+ * \param device_timestamp_usec
+ * A device timestamp, from k4a_image_get_device_timestamp_usec() or the timestamps of a ::k4a_imu_sample_t.
  *
- * \remarks
- * The streaming of individual sensors stops as a result of this call. Once called, k4a_device_start_cameras() may
- * be called again to resume sensor streaming.
+ * \param shared_timestamp_nsec
+ * Pointer to the location for the API to write the time in the shared timebase.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the timestamp was mapped. ::K4A_RESULT_FAILED if k4a_device_get_system_timestamp_nsec()
+ * fails, or if the shared timebase can not be read.
+ *
+ * \relates k4a_device_t
  *
  * \remarks
- * This function may be called while another thread is blocking in k4a_device_get_capture().
- * Calling this function while another thread is in that function will result in that function returning a failure.
+ * The shared timebase is set with k4a_set_shared_timebase_callback() or k4a_set_shared_timebase_clock(). Until one is
+ * set, this returns the same time as k4a_device_get_system_timestamp_nsec().
  *
  * \xmlonly
  * <requirements>
@@ -1284,26 +1663,29 @@ K4A_EXPORT k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, con
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_device_stop_cameras(k4a_device_t device_handle);
+K4A_EXPORT k4a_result_t k4a_device_get_shared_timestamp_nsec(k4a_device_t device_handle,
+                                                             uint64_t device_timestamp_usec,
+                                                             uint64_t *shared_timestamp_nsec);
 
-/** Starts the IMU sample stream.
+/** Maps the device timestamps of the images of a capture to the shared timebase.
  *
  * \param device_handle
- * Handle obtained by k4a_device_open().
+ * Handle of the device that produced the capture.
+ *
+ * \param capture_handle
+ * The capture.
+ *
+ * \param timestamps
+ * Pointer to the location for the API to write the timestamps. Images the capture does not have get a timestamp of 0.
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED is returned on success. ::K4A_RESULT_FAILED if the sensor is already running or a failure is
- * encountered
+ * ::K4A_RESULT_SUCCEEDED if every image of the capture was mapped, ::K4A_RESULT_FAILED otherwise.
  *
  * \relates k4a_device_t
  *
  * \remarks
- * Call this API to start streaming IMU data. It is not valid to call this function a second time on the same
- * \ref k4a_device_t until k4a_device_stop_imu() has been called.
- *
- * \remarks
- * This function is dependent on the state of the cameras. The color or depth camera must be started before the IMU.
- * ::K4A_RESULT_FAILED will be returned if one of the cameras is not running.
+ * Each host of a rig can export these timestamps with its captures, so captures from all hosts can be merged by time
+ * without buffering a window of captures to match them. See k4a_device_get_shared_timestamp_nsec().
  *
  * \xmlonly
  * <requirements>
@@ -1313,22 +1695,29 @@ K4A_EXPORT void k4a_device_stop_cameras(k4a_device_t device_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_start_imu(k4a_device_t device_handle);
+K4A_EXPORT k4a_result_t k4a_device_get_capture_shared_timestamps(k4a_device_t device_handle,
+                                                                 k4a_capture_t capture_handle,
+                                                                 k4a_capture_shared_timestamps_t *timestamps);
 
-/** Stops the IMU capture.
+/** Create an empty capture object.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param capture_handle
+ * Pointer to a location to store the handle.
  *
- * \relates k4a_device_t
+ * \relates k4a_capture_t
  *
  * \remarks
- * The streaming of the IMU stops as a result of this call. Once called, k4a_device_start_imu() may
- * be called again to resume sensor streaming, so long as the cameras are running.
+ * Call this function to create a \ref k4a_capture_t handle for a new capture. Release it with k4a_capture_release().
+ *
+ * The new capture is created with a reference count of 1.
  *
  * \remarks
- * This function may be called while another thread is blocking in k4a_device_get_imu_sample().
- * Calling this function while another thread is in that function will result in that function returning a failure.
+ * Add the images to the capture before sharing it with other threads. Reading a capture does not lock it, so its
+ * images must not be replaced while another thread may be reading them.
+ *
+ * \returns
+ * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED and error specific data can be
+ * found in the log.
  *
  * \xmlonly
  * <requirements>
@@ -1338,37 +1727,17 @@ K4A_EXPORT k4a_result_t k4a_device_start_imu(k4a_device_t device_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_device_stop_imu(k4a_device_t device_handle);
+K4A_EXPORT k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle);
 
-/** Get the Azure Kinect device serial number.
- *
- * \param device_handle
- * Handle obtained by k4a_device_open().
- *
- * \param serial_number
- * Location to write the serial number to. If the function returns ::K4A_BUFFER_RESULT_SUCCEEDED, this will be a NULL
- * terminated string of ASCII characters. If this input is NULL \p serial_number_size will still be updated to return
- * the size of the buffer needed to store the string.
- *
- * \param serial_number_size
- * On input, the size of the \p serial_number buffer if that pointer is not NULL. On output, this value is set to the
- * actual number of bytes in the serial number (including the null terminator).
- *
- * \returns
- * A return of ::K4A_BUFFER_RESULT_SUCCEEDED means that the \p serial_number has been filled in. If the buffer is too
- * small the function returns ::K4A_BUFFER_RESULT_TOO_SMALL and the size of the serial number is
- * returned in the \p serial_number_size parameter. All other failures return ::K4A_BUFFER_RESULT_FAILED.
+/** Release a capture.
  *
- * \relates k4a_device_t
+ * \param capture_handle
+ * Capture to release.
  *
- * \remarks
- * Queries the device for its serial number. If the caller needs to know the size of the serial number to allocate
- * memory, the function should be called once with a NULL \p serial_number to get the needed size in the \p
- * serial_number_size output, and then again with the allocated buffer.
+ * \relates k4a_capture_t
  *
  * \remarks
- * Only a complete serial number will be returned. If the caller's buffer is too small, the function will return
- * ::K4A_BUFFER_RESULT_TOO_SMALL without returning any data in \p serial_number.
+ * Call this function when finished using the capture.
  *
  * \xmlonly
  * <requirements>
@@ -1378,22 +1747,25 @@ K4A_EXPORT void k4a_device_stop_imu(k4a_device_t device_handle);
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_buffer_result_t k4a_device_get_serialnum(k4a_device_t device_handle,
-                                                        char *serial_number,
-                                                        size_t *serial_number_size);
+K4A_EXPORT void k4a_capture_release(k4a_capture_t capture_handle);
 
-/** Get the version numbers of the device's subsystems.
+/** Release a capture and recycle its memory for the next captures.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param capture_handle
+ * Capture to release.
  *
- * \param version
- * Location to write the version info to.
+ * \relates k4a_capture_t
  *
- * \returns A return of ::K4A_RESULT_SUCCEEDED means that the version structure has been filled in.
- * All other failures return ::K4A_RESULT_FAILED.
+ * \remarks
+ * Call this function instead of k4a_capture_release() when finished with a capture while streaming. It removes the
+ * same reference, and when that was the last one the capture handle, its image handles and their buffers are kept
+ * for the next captures of the same configuration, even when k4a_set_allocator_pooling() is not enabled. Once the
+ * first few captures have been recycled, streaming makes no new heap allocations for the captures of a device.
  *
- * \relates k4a_device_t
+ * \remarks
+ * Images the application still holds a reference to are released when it releases them, as with
+ * k4a_capture_release(). When pooling is enabled, k4a_capture_release() already keeps the memory up to the pooling
+ * limit. IMU samples attached with k4a_device_set_capture_imu_samples() are still freed with each capture.
  *
  * \xmlonly
  * <requirements>
@@ -1403,39 +1775,18 @@ K4A_EXPORT k4a_buffer_result_t k4a_device_get_serialnum(k4a_device_t device_hand
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_version_t *version);
+K4A_EXPORT void k4a_capture_recycle(k4a_capture_t capture_handle);
 
-/** Get the Azure Kinect color sensor control capabilities.
- *
- * \param device_handle
- * Handle obtained by k4a_device_open().
- *
- * \param command
- * Color sensor control command.
- *
- * \param supports_auto
- * Location to store whether the color sensor's control support auto mode or not.
- * true if it supports auto mode, otherwise false.
- *
- * \param min_value
- * Location to store the color sensor's control minimum value of /p command.
- *
- * \param max_value
- * Location to store the color sensor's control maximum value of /p command.
- *
- * \param step_value
- * Location to store the color sensor's control step value of /p command.
- *
- * \param default_value
- * Location to store the color sensor's control default value of /p command.
+/** Add a reference to a capture.
  *
- * \param default_mode
- * Location to store the color sensor's control default mode of /p command.
+ * \param capture_handle
+ * Capture to add a reference to.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if the value was successfully returned, ::K4A_RESULT_FAILED if an error occurred
+ * \relates k4a_capture_t
  *
- * \relates k4a_device_t
+ * \remarks
+ * Call this function to add an additional reference to a capture. This reference must be removed with
+ * k4a_capture_release().
  *
  * \xmlonly
  * <requirements>
@@ -1445,48 +1796,2852 @@ K4A_EXPORT k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_h
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_get_color_control_capabilities(k4a_device_t device_handle,
-                                                                  k4a_color_control_command_t command,
-                                                                  bool *supports_auto,
-                                                                  int32_t *min_value,
-                                                                  int32_t *max_value,
-                                                                  int32_t *step_value,
+K4A_EXPORT void k4a_capture_reference(k4a_capture_t capture_handle);
+
+/** Get the color image associated with the given capture.
+ *
+ * \param capture_handle
+ * Capture handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * Call this function to access the color image part of this capture. Release the \ref k4a_image_t with
+ * k4a_image_release();
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle);
+
+/** Get the depth image associated with the given capture.
+ *
+ * \param capture_handle
+ * Capture handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * Call this function to access the depth image part of this capture. Release the \ref k4a_image_t with
+ * k4a_image_release();
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle);
+
+/** Get the IR image associated with the given capture.
+ *
+ * \param capture_handle
+ * Capture handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * Call this function to access the IR image part of this capture. Release the \ref k4a_image_t with
+ * k4a_image_release();
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle);
+
+/** Set or add a color image to the associated capture.
+ *
+ * \param capture_handle
+ * Capture handle to hold the image.
+ *
+ * \param image_handle
+ * Image handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
+ * to the \ref k4a_image_t.
+ *
+ * \remarks
+ * If there is already a color image contained in the capture, the existing image will be dereferenced and replaced with
+ * the new image.
+ *
+ * \remarks
+ * To remove a color image to the capture without adding a new image, this function can be called with a NULL
+ * image_handle.
+ *
+ * \remarks
+ * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
+ * the \ref k4a_capture_t are released with k4a_capture_release().
+ *
+ * \remarks
+ * Captures are not locked while they are read. Set the images before the capture is shared with other threads;
+ * captures returned by the SDK must not be changed while another thread may be reading them.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+
+/** Set or add a depth image to the associated capture.
+ *
+ * \param capture_handle
+ * Capture handle to hold the image.
+ *
+ * \param image_handle
+ * Image handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
+ * to the \ref k4a_image_t.
+ *
+ * \remarks
+ * If there is already an image depth image contained in the capture, the existing image will be dereferenced and
+ * replaced with the new image.
+ *
+ * \remarks
+ * To remove a depth image to the capture without adding a new image, this function can be called with a NULL
+ * image_handle.
+ *
+ * \remarks
+ * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
+ * the \ref k4a_capture_t are released with k4a_capture_release().
+ *
+ * \remarks
+ * Captures are not locked while they are read. Set the images before the capture is shared with other threads;
+ * captures returned by the SDK must not be changed while another thread may be reading them.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+
+/** Set or add an IR image to the associated capture.
+ *
+ * \param capture_handle
+ * Capture handle to hold the image.
+ *
+ * \param image_handle
+ * Image handle containing the image.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * When a \ref k4a_image_t is added to a \ref k4a_capture_t, the \ref k4a_capture_t will automatically add a reference
+ * to the \ref k4a_image_t.
+ *
+ * \remarks
+ * If there is already an IR image contained in the capture, the existing image will be dereferenced and replaced with
+ * the new image.
+ *
+ * \remarks
+ * To remove a IR image to the capture without adding a new image, this function can be called with a NULL image_handle.
+ *
+ * \remarks
+ * Any \ref k4a_image_t contained in this \ref k4a_capture_t will automatically be dereferenced when all references to
+ * the \ref k4a_capture_t are released with k4a_capture_release().
+ *
+ * \remarks
+ * Captures are not locked while they are read. Set the images before the capture is shared with other threads;
+ * captures returned by the SDK must not be changed while another thread may be reading them.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle);
+
+/** Set the temperature associated with the capture.
+ *
+ * \param capture_handle
+ * Capture handle to set the temperature on.
+ *
+ * \param temperature_c
+ * Temperature in Celsius to store.
+ *
+ * \relates k4a_capture_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_capture_set_temperature_c(k4a_capture_t capture_handle, float temperature_c);
+
+/** Get the temperature associated with the capture.
+ *
+ * \param capture_handle
+ * Capture handle to retrieve the temperature from.
+ *
+ * \return
+ * This function returns the temperature of the device at the time of the capture in Celsius. If
+ * the temperature is unavailable, the function will return NAN.
+ *
+ * \relates k4a_capture_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT float k4a_capture_get_temperature_c(k4a_capture_t capture_handle);
+
+/** Get the time a capture finished a stage of the depth capture pipeline.
+ *
+ * \param capture_handle
+ * Capture handle to retrieve the timestamp from.
+ *
+ * \param stage
+ * The stage to read.
+ *
+ * \return
+ * The system time in nanoseconds the capture left \p stage, on the clock of k4a_image_get_system_timestamp_nsec(). 0
+ * if the capture did not go through the stage or \p stage is not valid.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * Each stage starts when the previous one ends. ::K4A_LATENCY_STAGE_DEPTH_QUEUE and ::K4A_LATENCY_STAGE_TOTAL start at
+ * the system timestamp of the IR image, taken when the USB transfer of the raw depth frame completed. This gives the
+ * time spent in every stage by each capture, where k4a_get_latency_stats() only keeps statistics of all captures.
+ *
+ * \remarks
+ * ::K4A_LATENCY_STAGE_USER and ::K4A_LATENCY_STAGE_TOTAL are only set on captures read with
+ * k4a_device_get_capture(). Captures without depth are not timed.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_capture_get_latency_timestamp_nsec(k4a_capture_t capture_handle, k4a_latency_stage_t stage);
+
+/** Get the IMU samples taken during the exposure of a capture.
+ *
+ * \param capture_handle
+ * Capture handle to retrieve the samples from.
+ *
+ * \param imu_samples
+ * Location to write the samples to. If the function returns ::K4A_BUFFER_RESULT_SUCCEEDED, then the samples, in
+ * order of their timestamps, will be written to this location. This parameter may be NULL to query the number of
+ * samples.
+ *
+ * \param imu_sample_count
+ * On input, the number of samples \p imu_samples can hold. On output, the number of samples of the capture.
+ *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if the samples were written. ::K4A_BUFFER_RESULT_TOO_SMALL if the capture has
+ * samples and \p imu_samples is NULL or too small, \p imu_sample_count then holds the number of samples.
+ * ::K4A_BUFFER_RESULT_FAILED if an argument is invalid.
+ *
+ * \relates k4a_capture_t
+ *
+ * \remarks
+ * Captures only hold IMU samples when k4a_device_set_capture_imu_samples() is enabled, otherwise the capture has no
+ * samples and ::K4A_BUFFER_RESULT_SUCCEEDED is returned with \p imu_sample_count set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_buffer_result_t k4a_capture_get_imu_samples(k4a_capture_t capture_handle,
+                                                           k4a_imu_sample_t *imu_samples,
+                                                           size_t *imu_sample_count);
+
+/** Create an image.
+ *
+ * \param format
+ * The format of the image that will be stored in this image container.
+ *
+ * \param width_pixels
+ * Width in pixels.
+ *
+ * \param height_pixels
+ * Height in pixels.
+ *
+ * \param stride_bytes
+ * The number of bytes per horizontal line of the image.
+ * If set to 0, the stride will be set to the minimum size given the \p format and \p width_pixels.
+ *
+ * \param image_handle
+ * Pointer to store image handle in.
+ *
+ * \remarks
+ * This function is used to create images of formats that have consistent stride. The function is not suitable for
+ * compressed formats that may not be represented by the same number of bytes per line.
+ *
+ * \remarks
+ * For most image formats, the function will allocate an image buffer of size \p height_pixels * \p stride_bytes.
+ * Buffers #K4A_IMAGE_FORMAT_COLOR_NV12 format will allocate an additional \p height_pixels / 2 set of lines (each of \p
+ * stride_bytes). This function cannot be used to allocate #K4A_IMAGE_FORMAT_COLOR_MJPG buffers.
+ *
+ * \remarks
+ * The image buffer is aligned to 64 bytes and its size is rounded up to a multiple of 64 bytes, so it can be processed
+ * with aligned full width vector loads and stores up to its end. When row padding is enabled with
+ * k4a_set_image_row_padding() and \p stride_bytes is 0, the minimum stride is rounded up to a multiple of 64 bytes so
+ * every row starts aligned as well.
+ *
+ * \remarks
+ * To create an image object without the API allocating memory, or to represent an image that has a non-deterministic
+ * stride, use k4a_image_create_from_buffer().
+ *
+ * \remarks
+ * The \ref k4a_image_t is created with a reference count of 1.
+ *
+ * \remarks
+ * When finished using the created image, release it with k4a_image_release.
+ *
+ * \returns
+ * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_image_create(k4a_image_format_t format,
+                                         int width_pixels,
+                                         int height_pixels,
+                                         int stride_bytes,
+                                         k4a_image_t *image_handle);
+
+/** Create an image from a pre-allocated buffer.
+ *
+ * \param format
+ * The format of the image that will be stored in this image container.
+ *
+ * \param width_pixels
+ * Width in pixels.
+ *
+ * \param height_pixels
+ * Height in pixels.
+ *
+ * \param stride_bytes
+ * The number of bytes per horizontal line of the image.
+ *
+ * \param buffer
+ * Pointer to a pre-allocated image buffer.
+ *
+ * \param buffer_size
+ * Size in bytes of the pre-allocated image buffer.
+ *
+ * \param buffer_release_cb
+ * Callback to the buffer free function, called when all references to the buffer have been released. This parameter is
+ * optional.
+ *
+ * \param buffer_release_cb_context
+ * Context for the buffer free function. This value will be called as a parameter to \p buffer_release_cb when
+ * the callback is invoked.
+ *
+ * \param image_handle
+ * Pointer to store image handle in.
+ *
+ * \remarks
+ * This function creates a \ref k4a_image_t from a pre-allocated buffer. When all references to this object reach zero
+ * the provided \p buffer_release_cb callback function is called so that the memory can be released. If this function
+ * fails, the API will not use the memory provided in \p buffer, and the API will not call \p buffer_release_cb.
+ *
+ * \remarks
+ * The \ref k4a_image_t is created with a reference count of 1.
+ *
+ * \remarks
+ * Release the reference on this function with k4a_image_release().
+ *
+ * \returns
+ * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED and error specific data can be
+ * found in the log.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_image_create_from_buffer(k4a_image_format_t format,
+                                                     int width_pixels,
+                                                     int height_pixels,
+                                                     int stride_bytes,
+                                                     uint8_t *buffer,
+                                                     size_t buffer_size,
+                                                     k4a_memory_destroy_cb_t *buffer_release_cb,
+                                                     void *buffer_release_cb_context,
+                                                     k4a_image_t *image_handle);
+
+/** Create an image of a rectangle of another image without copying.
+ *
+ * \param parent_handle
+ * Image to view. Its format must have a fixed number of bytes per pixel: ::K4A_IMAGE_FORMAT_COLOR_YUY2,
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32, ::K4A_IMAGE_FORMAT_DEPTH16, ::K4A_IMAGE_FORMAT_IR16, ::K4A_IMAGE_FORMAT_CUSTOM8 or
+ * ::K4A_IMAGE_FORMAT_CUSTOM16.
+ *
+ * \param x
+ * Column of the top left pixel of the view in the parent.
+ *
+ * \param y
+ * Row of the top left pixel of the view in the parent.
+ *
+ * \param width_pixels
+ * Width of the view. The view must lie inside the parent.
+ *
+ * \param height_pixels
+ * Height of the view.
+ *
+ * \param image_handle
+ * Pointer to store the view in.
+ *
+ * \remarks
+ * The view points into the buffer of the parent and has the stride of the parent, so k4a_image_get_buffer() returns
+ * the first pixel of the view and rows are k4a_image_get_stride_bytes() apart. k4a_image_get_size() covers the bytes
+ * from the first to the last pixel of the view. Writes to either image are seen by the other.
+ *
+ * \remarks
+ * The view holds a reference to the parent, which stays valid until both have been released. Timestamps, exposure,
+ * white balance and ISO speed are copied from the parent when the view is created. For
+ * ::K4A_IMAGE_FORMAT_COLOR_YUY2, \p x and \p width_pixels must be even.
+ *
+ * \remarks
+ * The transformation functions taking images accept views and other images with padded rows, as inputs and outputs,
+ * at the cost of a copy of their rows. The GPU variants and k4a_transformation_submit() need packed rows.
+ *
+ * \returns
+ * Returns #K4A_RESULT_SUCCEEDED on success. Errors are indicated with #K4A_RESULT_FAILED and error specific data can be
+ * found in the log.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_image_create_view(k4a_image_t parent_handle,
+                                              int x,
+                                              int y,
+                                              int width_pixels,
+                                              int height_pixels,
+                                              k4a_image_t *image_handle);
+
+/** Get the image buffer.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Use this buffer to access the raw image data.
+ *
+ * \returns
+ * The function will return NULL if there is an error, and will normally return a pointer to the image buffer.
+ * Since all \ref k4a_image_t instances are created with an image buffer, this function should only return NULL if the
+ * \p image_handle is invalid.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint8_t *k4a_image_get_buffer(k4a_image_t image_handle);
+
+/** Get the image buffer size.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Use this function to know what the size of the image buffer is returned by k4a_image_get_buffer().
+ *
+ * \returns
+ * The function will return 0 if there is an error, and will normally return the image size.
+ * Since all \ref k4a_image_t instances are created with an image buffer, this function should only return 0 if the
+ * \p image_handle is invalid.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT size_t k4a_image_get_size(k4a_image_t image_handle);
+
+/** Get the format of the image.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Use this function to determine the format of the image buffer.
+ *
+ * \returns
+ * This function is not expected to fail, all \ref k4a_image_t's are created with a known format. If the
+ * \p image_handle is invalid, the function will return ::K4A_IMAGE_FORMAT_CUSTOM.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_image_format_t k4a_image_get_format(k4a_image_t image_handle);
+
+/** Get the image width in pixels.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \returns
+ * This function is not expected to fail, all \ref k4a_image_t's are created with a known width. If the \p
+ * image_handle is invalid, the function will return 0.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT int k4a_image_get_width_pixels(k4a_image_t image_handle);
+
+/** Get the image height in pixels.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \returns
+ * This function is not expected to fail, all \ref k4a_image_t's are created with a known height. If the \p
+ * image_handle is invalid, the function will return 0.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT int k4a_image_get_height_pixels(k4a_image_t image_handle);
+
+/** Get the image stride in bytes.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \returns
+ * This function is not expected to fail, all \ref k4a_image_t's are created with a known stride. If the
+ * \p image_handle is invalid, or the image's format does not have a stride, the function will return 0.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT int k4a_image_get_stride_bytes(k4a_image_t image_handle);
+
+/** Get the image's device timestamp in microseconds.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Returns the device timestamp of the image. Timestamps are recorded by the device and represent the mid-point of
+ * exposure. They may be used for relative comparison, but their absolute value has no defined meaning.
+ *
+ * \returns
+ * If the \p image_handle is invalid or if no timestamp was set for the image,
+ * this function will return 0. It is also possible for 0 to be a valid timestamp originating from the beginning
+ * of a recording or the start of streaming.
+ *
+ * \deprecated
+ * Deprecated starting in 1.2.0. Please use k4a_image_get_device_timestamp_usec().
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DEPRECATED_EXPORT uint64_t k4a_image_get_timestamp_usec(k4a_image_t image_handle);
+
+/** Get the image's device timestamp in microseconds.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Returns the device timestamp of the image, as captured by the hardware. Timestamps are recorded by the device and
+ * represent the mid-point of exposure. They may be used for relative comparison, but their absolute value has no
+ * defined meaning.
+ *
+ * \returns
+ * If the \p image_handle is invalid or if no timestamp was set for the image, this function will return 0. It is also
+ * possible for 0 to be a valid timestamp originating from the beginning of a recording or the start of streaming.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_image_get_device_timestamp_usec(k4a_image_t image_handle);
+
+/** Get the image's system timestamp in nanoseconds.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Returns the system timestamp of the image. Timestamps are recorded by the host. They may be used for relative
+ * comparision, as they are relative to the corresponding system clock. The absolute value is a monotonic count from
+ * an arbitrary point in the past.
+ *
+ * \remarks
+ * The system timestamp is captured at the moment host PC finishes receiving the image.
+ *
+ * \remarks
+ * On Linux the system timestamp is read from clock_gettime(CLOCK_MONOTONIC), which measures realtime and is not
+ * impacted by adjustments to the system clock. It starts from an arbitrary point in the past. On Windows the system
+ * timestamp is read from QueryPerformanceCounter(), it also measures realtime and is not impacted by adjustments to the
+ * system clock. It also starts from an arbitrary point in the past.
+ *
+ * \returns
+ * If the \p image_handle is invalid or if no timestamp was set for the image, this function will return 0. It is also
+ * possible for 0 to be a valid timestamp originating from the beginning of a recording or the start of streaming.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_image_get_system_timestamp_nsec(k4a_image_t image_handle);
+
+/** Get the GPU resource the depth engine exported a depth or IR image to.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \param resource
+ * Receives the resource. The depth and IR images of a capture carry the same resource, see
+ * ::k4a_depth_gpu_export_configuration_t.
+ *
+ * \remarks
+ * Only the depth and IR images of a device with GPU export enabled by k4a_device_set_depth_gpu_export() have a
+ * resource. The resource belongs to the depth engine: it is written again ::K4A_DEPTH_GPU_EXPORT_SLOT_COUNT captures
+ * later and becomes invalid when the cameras are stopped. It is not released with the image.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p resource was filled in and ::K4A_RESULT_FAILED if the image has no GPU resource.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_image_get_gpu_resource(k4a_image_t image_handle, k4a_gpu_resource_t *resource);
+
+/** Get the statistics of the valid pixels of a depth image.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \param statistics
+ * Receives the minimum, maximum and mean depth, the number of valid pixels and a coarse histogram of the depth.
+ *
+ * \remarks
+ * The statistics of the depth images of a device are computed once per capture, after the depth filter, while the
+ * image is still in the processor cache. Reading them costs no pass over the pixels. They describe the pixels as the
+ * image was delivered and are not updated if the buffer is modified.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p statistics was filled in and ::K4A_RESULT_FAILED if the image has no statistics, which
+ * is the case for images created with k4a_image_create() and for images read from a recording.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_image_get_depth_statistics(k4a_image_t image_handle, k4a_depth_statistics_t *statistics);
+
+/** Get the time the depth engine took to produce an image, in microseconds.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * The time from the submission of the raw frame to the depth engine until its depth and IR images were ready. It is
+ * the same for the depth and IR images of a capture. Times longer than the frame period mean the depth engine doesn't
+ * keep up, see k4a_device_set_depth_engine_overload_policy().
+ *
+ * \returns
+ * The compute time of the image, 0 for images not produced by the depth engine of a device.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_image_get_compute_time_usec(k4a_image_t image_handle);
+
+/** Get the image exposure in microseconds.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Returns an exposure time in microseconds. This is only supported on color image formats.
+ *
+ * \returns
+ * If the \p image_handle is invalid, or no exposure was set on the image, the function will return 0. Otherwise,
+ * it will return the image exposure time in microseconds.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint64_t k4a_image_get_exposure_usec(k4a_image_t image_handle);
+
+/** Get the image white balance.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * Returns the image's white balance. This function is only valid for color captures, and not for depth or IR captures.
+ *
+ * \returns
+ * Returns the image white balance in Kelvin. If \p image_handle is invalid, or the white balance was not set or
+ * not applicable to the image, the function will return 0.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint32_t k4a_image_get_white_balance(k4a_image_t image_handle);
+
+/** Get the image ISO speed.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * This function is only valid for color captures, and not for depth  or IR captures.
+ *
+ * \returns
+ * Returns the ISO speed of the image. 0 indicates the ISO speed was not available or an error occurred.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT uint32_t k4a_image_get_iso_speed(k4a_image_t image_handle);
+
+/** Set the device time stamp, in microseconds, of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the timestamp on.
+ *
+ * \param timestamp_usec
+ * Device timestamp of the image in microseconds.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t.
+ *
+ * \remarks
+ * The device timestamp represents the mid-point of exposure of the image, as captured by the hardware.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_set_device_timestamp_usec(k4a_image_t image_handle, uint64_t timestamp_usec);
+
+/** Set the device time stamp, in microseconds, of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the timestamp on.
+ *
+ * \param timestamp_usec
+ * Device timestamp of the image in microseconds.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t.
+ *
+ * \remarks
+ * The device timestamp represents the mid-point of exposure of the image, as captured by the hardware.
+ *
+ * \relates k4a_image_t
+ *
+ * \deprecated
+ * Deprecated starting in 1.2.0. Please use k4a_image_set_device_timestamp_usec().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DEPRECATED_EXPORT void k4a_image_set_timestamp_usec(k4a_image_t image_handle, uint64_t timestamp_usec);
+
+/** Set the system time stamp, in nanoseconds, of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the timestamp on.
+ *
+ * \param timestamp_nsec
+ * Timestamp of the image in nanoseconds.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t.
+ *
+ * \remarks
+ * The system timestamp is a high performance and increasing clock (from boot). The timestamp represents the time
+ * immediately after the image buffer was read by the host PC.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_set_system_timestamp_nsec(k4a_image_t image_handle, uint64_t timestamp_nsec);
+
+/** Set the exposure time, in microseconds, of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the exposure time on.
+ *
+ * \param exposure_usec
+ * Exposure time of the image in microseconds.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t. An exposure time of 0 is considered invalid. Only color image formats are expected to have a valid
+ * exposure time.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_set_exposure_usec(k4a_image_t image_handle, uint64_t exposure_usec);
+
+/** Set the exposure time, in microseconds, of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the exposure time on.
+ *
+ * \param exposure_usec
+ * Exposure time of the image in microseconds.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t. An exposure time of 0 is considered invalid. Only color image formats are expected to have a valid
+ * exposure time.
+ *
+ * \deprecated
+ * Deprecated starting in 1.2.0. Please use k4a_image_set_exposure_usec().
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DEPRECATED_EXPORT void k4a_image_set_exposure_time_usec(k4a_image_t image_handle, uint64_t exposure_usec);
+
+/** Set the white balance of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the white balance on.
+ *
+ * \param white_balance
+ * White balance of the image in degrees Kelvin.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t. A white balance of 0 is considered invalid. White balance is only meaningful for color images,
+ * and not expected on depth or IR images.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_set_white_balance(k4a_image_t image_handle, uint32_t white_balance);
+
+/** Set the ISO speed of the image.
+ *
+ * \param image_handle
+ * Handle of the image to set the ISO speed on.
+ *
+ * \param iso_speed
+ * ISO speed of the image.
+ *
+ * \remarks
+ * Use this function in conjunction with k4a_image_create() or k4a_image_create_from_buffer() to construct a
+ * \ref k4a_image_t. An ISO speed of 0 is considered invalid. Only color images are expected to have a valid ISO speed.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_set_iso_speed(k4a_image_t image_handle, uint32_t iso_speed);
+
+/** Add a reference to the k4a_image_t.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * References manage the lifetime of the object. When the references reach zero the object is destroyed. A caller must
+ * not access the object after its reference is released.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_reference(k4a_image_t image_handle);
+
+/** Remove a reference from the k4a_image_t.
+ *
+ * \param image_handle
+ * Handle of the image for which the get operation is performed on.
+ *
+ * \remarks
+ * References manage the lifetime of the object. When the references reach zero the object is destroyed. A caller must
+ * not access the object after its reference is released.
+ *
+ * \relates k4a_image_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_image_release(k4a_image_t image_handle);
+
+/** Sets the scale color images are decoded to.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param scale
+ * Scale of the color images produced by the next call to k4a_device_start_cameras().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the scale was set. ::K4A_RESULT_FAILED if \p device_handle is invalid, \p scale is not a
+ * valid value or the color camera is running.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The color camera still streams MJPG at the configured color resolution. The frames are then decoded directly to the
+ * reduced resolution, which is much cheaper than a full resolution decode.
+ *
+ * \remarks
+ * Scaling needs the color format ::K4A_IMAGE_FORMAT_COLOR_BGRA32. If \p scale is not ::K4A_COLOR_SCALE_FULL,
+ * k4a_device_start_cameras() fails for any other color format. Scaling is not supported on Windows.
+ *
+ * \remarks
+ * The calibration returned by k4a_device_get_calibration() describes the full color resolution. Scaled color images
+ * can not be used with the k4a_transformation_t functions.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_set_color_scale(k4a_device_t device_handle, k4a_color_scale_t scale);
+
+/** Starts color and depth camera capture.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param config
+ * The configuration we want to run the device in. This can be initialized with ::K4A_DEVICE_CONFIG_INIT_DISABLE_ALL.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED is returned on success.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Individual sensors configured to run will now start to stream captured data.
+ *
+ * \remarks
+ * It is not valid to call k4a_device_start_cameras() a second time on the same \ref k4a_device_t until
+ * k4a_device_stop_cameras() has been called.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_device_configuration_t *config);
+
+/** Stops the color and depth camera capture.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The streaming of individual sensors stops as a result of this call. Once called, k4a_device_start_cameras() may
+ * be called again to resume sensor streaming.
+ *
+ * \remarks
+ * This function may be called while another thread is blocking in k4a_device_get_capture().
+ * Calling this function while another thread is in that function will result in that function returning a failure.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_device_stop_cameras(k4a_device_t device_handle);
+
+/** Changes the depth mode and frame rate of running cameras without restarting them.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param depth_mode
+ * The new depth mode, which can't be ::K4A_DEPTH_MODE_OFF.
+ *
+ * \param camera_fps
+ * The new frame rate. It must be the frame rate the cameras were started with while the color camera is running.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the depth camera streams in the new mode. ::K4A_RESULT_FAILED if the handle is invalid, the
+ * depth camera isn't running, the configuration isn't supported or the reconfiguration failed, in which case the
+ * cameras are stopped.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Only the depth stream is restarted. The color camera keeps streaming and the device clock isn't reset, so timestamps
+ * continue from before the call. The depth sensor stays powered and the depth engine thread is reused, as is the depth
+ * engine when \p depth_mode is unchanged, so this is much faster than k4a_device_stop_cameras() followed by
+ * k4a_device_start_cameras().
+ *
+ * \remarks
+ * Captures of the previous mode that haven't been read are dropped, and the first captures of the new mode may have no
+ * color image while the synchronization of the cameras restarts. The other fields of the configuration passed to
+ * k4a_device_start_cameras() are kept, and the combination must be valid, for example ::K4A_DEPTH_MODE_WFOV_UNBINNED
+ * doesn't support ::K4A_FRAMES_PER_SECOND_30.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_reconfigure_depth(k4a_device_t device_handle,
+                                                     k4a_depth_mode_t depth_mode,
+                                                     k4a_fps_t camera_fps);
+
+/** Starts the IMU sample stream.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED is returned on success. ::K4A_RESULT_FAILED if the sensor is already running or a failure is
+ * encountered
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Call this API to start streaming IMU data. It is not valid to call this function a second time on the same
+ * \ref k4a_device_t until k4a_device_stop_imu() has been called.
+ *
+ * \remarks
+ * This function is dependent on the state of the cameras. The color or depth camera must be started before the IMU.
+ * ::K4A_RESULT_FAILED will be returned if one of the cameras is not running.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_start_imu(k4a_device_t device_handle);
+
+/** Stops the IMU capture.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * The streaming of the IMU stops as a result of this call. Once called, k4a_device_start_imu() may
+ * be called again to resume sensor streaming, so long as the cameras are running.
+ *
+ * \remarks
+ * This function may be called while another thread is blocking in k4a_device_get_imu_sample().
+ * Calling this function while another thread is in that function will result in that function returning a failure.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_device_stop_imu(k4a_device_t device_handle);
+
+/** Get the Azure Kinect device serial number.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param serial_number
+ * Location to write the serial number to. If the function returns ::K4A_BUFFER_RESULT_SUCCEEDED, this will be a NULL
+ * terminated string of ASCII characters. If this input is NULL \p serial_number_size will still be updated to return
+ * the size of the buffer needed to store the string.
+ *
+ * \param serial_number_size
+ * On input, the size of the \p serial_number buffer if that pointer is not NULL. On output, this value is set to the
+ * actual number of bytes in the serial number (including the null terminator).
+ *
+ * \returns
+ * A return of ::K4A_BUFFER_RESULT_SUCCEEDED means that the \p serial_number has been filled in. If the buffer is too
+ * small the function returns ::K4A_BUFFER_RESULT_TOO_SMALL and the size of the serial number is
+ * returned in the \p serial_number_size parameter. All other failures return ::K4A_BUFFER_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Queries the device for its serial number. If the caller needs to know the size of the serial number to allocate
+ * memory, the function should be called once with a NULL \p serial_number to get the needed size in the \p
+ * serial_number_size output, and then again with the allocated buffer.
+ *
+ * \remarks
+ * Only a complete serial number will be returned. If the caller's buffer is too small, the function will return
+ * ::K4A_BUFFER_RESULT_TOO_SMALL without returning any data in \p serial_number.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_buffer_result_t k4a_device_get_serialnum(k4a_device_t device_handle,
+                                                        char *serial_number,
+                                                        size_t *serial_number_size);
+
+/** Get the version numbers of the device's subsystems.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param version
+ * Location to write the version info to.
+ *
+ * \returns A return of ::K4A_RESULT_SUCCEEDED means that the version structure has been filled in.
+ * All other failures return ::K4A_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_version_t *version);
+
+/** Get the Azure Kinect color sensor control capabilities.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param command
+ * Color sensor control command.
+ *
+ * \param supports_auto
+ * Location to store whether the color sensor's control support auto mode or not.
+ * true if it supports auto mode, otherwise false.
+ *
+ * \param min_value
+ * Location to store the color sensor's control minimum value of /p command.
+ *
+ * \param max_value
+ * Location to store the color sensor's control maximum value of /p command.
+ *
+ * \param step_value
+ * Location to store the color sensor's control step value of /p command.
+ *
+ * \param default_value
+ * Location to store the color sensor's control default value of /p command.
+ *
+ * \param default_mode
+ * Location to store the color sensor's control default mode of /p command.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the value was successfully returned, ::K4A_RESULT_FAILED if an error occurred
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_color_control_capabilities(k4a_device_t device_handle,
+                                                                  k4a_color_control_command_t command,
+                                                                  bool *supports_auto,
+                                                                  int32_t *min_value,
+                                                                  int32_t *max_value,
+                                                                  int32_t *step_value,
                                                                   int32_t *default_value,
                                                                   k4a_color_control_mode_t *default_mode);
 
-/** Get the Azure Kinect color sensor control
- * value.
+/** Get the Azure Kinect color sensor control
+ * value.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param command
+ * Color sensor control command.
+ *
+ * \param mode
+ * Location to store the color sensor's control mode. This mode represents whether the command is in automatic or
+ * manual mode.
+ *
+ * \param value
+ * Location to store the color sensor's control value. This value is always written, but is only valid when the \p
+ * mode returned is ::K4A_COLOR_CONTROL_MODE_MANUAL for the current \p command.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the value was successfully returned, ::K4A_RESULT_FAILED if an error occurred
+ *
+ * \remarks
+ * Each control command may be set to manual or automatic. See the definition of \ref k4a_color_control_command_t on
+ * how to interpret the \p value for each command.
+ *
+ * \remarks
+ * Some control commands are only supported in manual mode. When a command is in automatic mode, the \p value for
+ * that command is not valid.
+ *
+ * \remarks
+ * Control values set on a device are reset only when the device is power cycled. The device will retain the
+ * settings even if the \ref k4a_device_t is closed or the application is restarted.
+ *
+ * \remarks
+ * Values are cached, so polling a control every frame doesn't send a USB request each time. A manual value is read from
+ * the device once and again after k4a_device_set_color_control() changes any control. While the color camera streams,
+ * the automatic exposure time and white balance come from the metadata of the latest color image, see
+ * k4a_image_get_exposure_usec() and k4a_image_get_white_balance(). Changes made to the device by another process
+ * are not seen until this device handle sets a control.
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_color_control(k4a_device_t device_handle,
+                                                     k4a_color_control_command_t command,
+                                                     k4a_color_control_mode_t *mode,
+                                                     int32_t *value);
+
+/** Set the Azure Kinect color sensor control value.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param command
+ * Color sensor control command.
+ *
+ * \param mode
+ * Color sensor control mode to set. This mode represents whether the command is in automatic or manual mode.
+ *
+ * \param value
+ * Value to set the color sensor's control to. The value is only valid if \p mode
+ * is set to ::K4A_COLOR_CONTROL_MODE_MANUAL, and is otherwise ignored.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the value was successfully set, ::K4A_RESULT_FAILED if an error occurred
+ *
+ * \remarks
+ * Each control command may be set to manual or automatic. See the definition of \ref k4a_color_control_command_t on how
+ * to interpret the \p value for each command.
+ *
+ * \remarks
+ * Some control commands are only supported in manual mode. When a command is in automatic mode, the \p value for that
+ * command is not valid.
+ *
+ * \remarks
+ * Control values set on a device are reset only when the device is power cycled. The device will retain the settings
+ * even if the \ref k4a_device_t is closed or the application is restarted.
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_set_color_control(k4a_device_t device_handle,
+                                                     k4a_color_control_command_t command,
+                                                     k4a_color_control_mode_t mode,
+                                                     int32_t value);
+
+/** Get the raw calibration blob for the entire Azure Kinect device.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param data
+ * Location to write the calibration data to. This field may optionally be set to NULL for the caller to query for
+ * the needed data size.
+ *
+ * \param data_size
+ * On passing \p data_size into the function this variable represents the available size of the \p data
+ * buffer. On return this variable is updated with the amount of data actually written to the buffer, or the size
+ * required to store the calibration buffer if \p data is NULL.
+ *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if \p data was successfully written. If \p data_size points to a buffer size that is
+ * too small to hold the output or \p data is NULL, ::K4A_BUFFER_RESULT_TOO_SMALL is returned and \p data_size is
+ * updated to contain the minimum buffer size needed to capture the calibration data.
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_buffer_result_t k4a_device_get_raw_calibration(k4a_device_t device_handle,
+                                                              uint8_t *data,
+                                                              size_t *data_size);
+
+/** Get the camera calibration for the entire Azure Kinect device.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param depth_mode
+ * Mode in which depth camera is operated.
+ *
+ * \param color_resolution
+ * Resolution in which color camera is operated.
+ *
+ * \param calibration
+ * Location to write the calibration
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p calibration was successfully written. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * The \p calibration represents the data needed to transform between the camera views and may be
+ * different for each operating \p depth_mode and \p color_resolution the device is configured to operate in.
+ *
+ * \remarks
+ * The \p calibration output is used as input to all calibration and transformation functions.
+ *
+ * \see k4a_calibration_2d_to_2d()
+ * \see k4a_calibration_2d_to_3d()
+ * \see k4a_calibration_3d_to_2d()
+ * \see k4a_calibration_3d_to_3d()
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_calibration(k4a_device_t device_handle,
+                                                   const k4a_depth_mode_t depth_mode,
+                                                   const k4a_color_resolution_t color_resolution,
+                                                   k4a_calibration_t *calibration);
+
+/** Get the device jack status for the synchronization in and synchronization out connectors.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param sync_in_jack_connected
+ * Upon successful return this value will be set to true if a cable is connected to this sync in jack.
+ *
+ * \param sync_out_jack_connected
+ * Upon successful return this value will be set to true if a cable is connected to this sync out jack.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the connector status was successfully read.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * If \p sync_out_jack_connected is true then \ref k4a_device_configuration_t wired_sync_mode mode can be set to \ref
+ * K4A_WIRED_SYNC_MODE_STANDALONE or \ref K4A_WIRED_SYNC_MODE_MASTER. If \p sync_in_jack_connected is true then \ref
+ * k4a_device_configuration_t wired_sync_mode mode can be set to \ref K4A_WIRED_SYNC_MODE_STANDALONE or \ref
+ * K4A_WIRED_SYNC_MODE_SUBORDINATE.
+ *
+ * \see k4a_device_start_cameras()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_sync_jack(k4a_device_t device_handle,
+                                                 bool *sync_in_jack_connected,
+                                                 bool *sync_out_jack_connected);
+
+/** Create a group of devices whose captures are matched by timestamp.
+ *
+ * \param device_handles
+ * Array of \p device_count handles obtained by k4a_device_open() or k4a_device_open_all().
+ *
+ * \param device_count
+ * Number of devices in the group, from 1 to 9.
+ *
+ * \param group_handle
+ * Output parameter which on success will return a handle to the group.
+ *
+ * \relates k4a_device_group_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the group was created.
+ *
+ * \remarks
+ * On success the group owns the devices, k4a_device_group_destroy() closes them. The application may still call
+ * device functions that don't stream, such as k4a_device_get_calibration() or k4a_device_set_color_control(), but must
+ * not start or stop the cameras, read captures, or set a capture callback on them. On failure the devices are left
+ * open and owned by the caller.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_group_create(const k4a_device_t *device_handles,
+                                                uint32_t device_count,
+                                                k4a_device_group_t *group_handle);
+
+/** Starts the color and depth cameras of every device in a group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_device_group_create().
+ *
+ * \param configs
+ * Array of one configuration per device, in the order the devices were passed to k4a_device_group_create().
+ *
+ * \relates k4a_device_group_t
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if every device was started. On failure the devices that were started are stopped again.
+ *
+ * \remarks
+ * All devices must use the same camera_fps. Subordinates are started before the master, so the master's first sync
+ * pulse reaches every subordinate.
+ *
+ * \remarks
+ * Timestamps are aligned to the color camera of the master using each device's subordinate_delay_off_master_usec and
+ * depth_delay_off_color_usec, so devices with the color camera turned off can be grouped as well.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_group_start_cameras(k4a_device_group_t group_handle,
+                                                       const k4a_device_configuration_t *configs);
+
+/** Reads one capture from every device of a group, matched by timestamp.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_device_group_create().
+ *
+ * \param capture_handles
+ * Array with room for one capture per device. On success it holds the capture of each device, in the order the devices
+ * were passed to k4a_device_group_create(). Release each of them with k4a_capture_release().
+ *
+ * \param skew_usec
+ * Optional location to write the difference between the latest and earliest aligned timestamp of the captures.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the captures. If set to 0, the function
+ * will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely.
+ *
+ * \relates k4a_device_group_t
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if a set of captures was read. ::K4A_WAIT_RESULT_TIMEOUT if no set was matched before the
+ * timeout elapsed. ::K4A_WAIT_RESULT_FAILED if the group isn't streaming or a device reported an error.
+ *
+ * \remarks
+ * Captures are matched as they arrive, on the SDK threads that produce them; the group doesn't add threads of its own.
+ * A set is complete once every device has a capture within a quarter of the frame period of the others. Captures that
+ * can no longer be part of a set are dropped. If the application doesn't read sets fast enough, the oldest set is
+ * dropped.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_wait_result_t k4a_device_group_get_capture(k4a_device_group_t group_handle,
+                                                          k4a_capture_t *capture_handles,
+                                                          uint64_t *skew_usec,
+                                                          int32_t timeout_in_ms);
+
+/** Stops the color and depth cameras of every device in a group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_device_group_create().
+ *
+ * \relates k4a_device_group_t
+ *
+ * \remarks
+ * Captures that were not read yet are released, and blocked calls to k4a_device_group_get_capture() return.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_device_group_stop_cameras(k4a_device_group_t group_handle);
+
+/** Destroys a group of devices and closes the devices.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_device_group_create().
+ *
+ * \relates k4a_device_group_t
+ *
+ * \remarks
+ * Stops the cameras if they are running, then closes each device with k4a_device_close().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_device_group_destroy(k4a_device_group_t group_handle);
+
+/** Creates a broker sharing the captures of a device owned by this process with other processes.
+ *
+ * \param name
+ * Name other processes pass to k4a_broker_attach(), up to 48 letters, digits, '-' and '_'.
+ *
+ * \param buffer_count
+ * Number of shared image buffers, from 1 to 1024.
+ *
+ * \param buffer_size
+ * Size of each shared buffer in bytes, at least 65536. Images larger than this are not shared.
+ *
+ * \param broker_handle
+ * Output parameter which on success will return a handle to the broker.
+ *
+ * \relates k4a_broker_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the broker was created.
+ *
+ * \remarks
+ * Only one process can open a device. The broker lets that process share its captures with others, such as a recorder
+ * and a viewer, without copying the images. While the broker exists, image buffers of 65536 to \p buffer_size bytes
+ * allocated by the SDK come from shared memory, and the images other processes receive point at those same buffers.
+ * A buffer is reused once every process has released its image.
+ *
+ * \remarks
+ * Replaces any allocator set with k4a_set_allocator() and turns off buffer reuse within this process. Choose
+ * \p buffer_count to cover the images the device, this process and the attached processes hold at once; when every
+ * buffer is in use images are allocated from the heap and copied when published. Don't call k4a_set_allocator() or
+ * enable buffer pooling while the broker exists. Only one broker can exist in a process. Not supported on Windows.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_broker_create(const char *name,
+                                          uint32_t buffer_count,
+                                          size_t buffer_size,
+                                          k4a_broker_t *broker_handle);
+
+/** Shares the calibration of a device with the processes attached to a broker.
+ *
+ * \param broker_handle
+ * Handle obtained by k4a_broker_create().
+ *
+ * \param device_handle
+ * Handle of the device whose captures are published.
+ *
+ * \param depth_mode
+ * Depth mode the device cameras were started with.
+ *
+ * \param color_resolution
+ * Color resolution the device cameras were started with.
+ *
+ * \relates k4a_broker_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the calibration was shared.
+ *
+ * \remarks
+ * Attached processes read it with k4a_broker_client_get_calibration().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_broker_set_device(k4a_broker_t broker_handle,
+                                              k4a_device_t device_handle,
+                                              k4a_depth_mode_t depth_mode,
+                                              k4a_color_resolution_t color_resolution);
+
+/** Sends a capture to every process attached to a broker.
+ *
+ * \param broker_handle
+ * Handle obtained by k4a_broker_create().
+ *
+ * \param capture_handle
+ * Capture to publish, typically read with k4a_device_get_capture(). The caller keeps its reference.
+ *
+ * \relates k4a_broker_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the capture was published.
+ *
+ * \remarks
+ * Images in shared buffers are sent without a copy, other images are copied to a free shared buffer. Each attached
+ * process queues up to four captures; when it doesn't read them fast enough its oldest capture is dropped. Processes
+ * that exited without calling k4a_broker_detach() are found here and their buffers are returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_broker_publish_capture(k4a_broker_t broker_handle, k4a_capture_t capture_handle);
+
+/** Destroys a broker.
+ *
+ * \param broker_handle
+ * Handle obtained by k4a_broker_create().
+ *
+ * \relates k4a_broker_t
+ *
+ * \remarks
+ * Attached processes receive the captures already queued for them, then k4a_broker_client_get_capture() fails. Images
+ * remain valid in every process until released. The default allocator is restored.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_broker_destroy(k4a_broker_t broker_handle);
+
+/** Attaches to a broker created by another process.
+ *
+ * \param name
+ * Name the broker was created with.
+ *
+ * \param client_handle
+ * Output parameter which on success will return a handle to the attached broker.
+ *
+ * \relates k4a_broker_client_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if attached. Fails if there is no broker of this name, or eight processes are
+ * attached to it already.
+ *
+ * \remarks
+ * Captures published after this call are queued for this process. Not supported on Windows.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_broker_attach(const char *name, k4a_broker_client_t *client_handle);
+
+/** Gets the calibration of the device shared by a broker.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_broker_attach().
+ *
+ * \param calibration
+ * Location to write the calibration for the depth mode and color resolution set with k4a_broker_set_device().
+ *
+ * \relates k4a_broker_client_t
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the calibration was read, ::K4A_RESULT_FAILED if the broker has not shared one.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_broker_client_get_calibration(k4a_broker_client_t client_handle,
+                                                          k4a_calibration_t *calibration);
+
+/** Reads the next capture published by a broker.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_broker_attach().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture. Release it with k4a_capture_release().
+ *
+ * \param timeout_in_ms
+ * Time to wait for a capture, 0 to not block, or ::K4A_WAIT_INFINITE.
+ *
+ * \relates k4a_broker_client_t
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if a capture was read. ::K4A_WAIT_RESULT_TIMEOUT if none was published in time.
+ * ::K4A_WAIT_RESULT_FAILED once the broker was destroyed or its process exited and no capture is queued.
+ *
+ * \remarks
+ * The images of the capture point into the shared buffers of the broker. Their buffer is returned to the broker when
+ * the last process holding it releases the image, or exits.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_wait_result_t k4a_broker_client_get_capture(k4a_broker_client_t client_handle,
+                                                           k4a_capture_t *capture_handle,
+                                                           int32_t timeout_in_ms);
+
+/** Detaches from a broker.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_broker_attach().
+ *
+ * \relates k4a_broker_client_t
+ *
+ * \remarks
+ * Captures queued and not read are dropped. Images already read remain valid until released.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_broker_detach(k4a_broker_client_t client_handle);
+
+/** Get the camera calibration for a device from a raw calibration blob.
+ *
+ * \param raw_calibration
+ * Raw calibration blob obtained from a device or recording. The raw calibration must be NULL terminated.
+ *
+ * \param raw_calibration_size
+ * The size, in bytes, of raw_calibration including the NULL termination.
+ *
+ * \param depth_mode
+ * Mode in which depth camera is operated.
+ *
+ * \param color_resolution
+ * Resolution in which color camera is operated.
+ *
+ * \param calibration
+ * Location to write the calibration.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p calibration was successfully written. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * The \p calibration represents the data needed to transform between the camera views and is
+ * different for each operating \p depth_mode and \p color_resolution the device is configured to operate in.
+ *
+ * \remarks
+ * The \p calibration output is used as input to all transformation functions.
+ *
+ * \see k4a_calibration_2d_to_2d()
+ * \see k4a_calibration_2d_to_3d()
+ * \see k4a_calibration_3d_to_2d()
+ * \see k4a_calibration_3d_to_3d()
+ *
+ * \relates k4a_device_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_get_from_raw(char *raw_calibration,
+                                                     size_t raw_calibration_size,
+                                                     const k4a_depth_mode_t depth_mode,
+                                                     const k4a_color_resolution_t color_resolution,
+                                                     k4a_calibration_t *calibration);
+
+/** Transform a 3D point of a source coordinate system into a 3D point of the target coordinate system
+ *
+ * \param calibration
+ * Location to read the camera calibration data.
+ *
+ * \param source_point3d_mm
+ * The 3D coordinates in millimeters representing a point in \p source_camera.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_point3d_mm
+ * Pointer to the output where the new 3D coordinates of the input point in the coordinate space of \p target_camera is
+ * stored in millimeters.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_point3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters.
+ *
+ * \remarks
+ * This function is used to transform 3D points between depth and color camera coordinate systems. The function uses the
+ * extrinsic camera calibration. It computes the output via multiplication with a precomputed matrix encoding a 3D
+ * rotation and a 3D translation. If \p source_camera and \p target_camera are the same, then \p target_point3d_mm will
+ * be identical to \p source_point3d_mm.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_3d_to_3d(const k4a_calibration_t *calibration,
+                                                 const k4a_float3_t *source_point3d_mm,
+                                                 const k4a_calibration_type_t source_camera,
+                                                 const k4a_calibration_type_t target_camera,
+                                                 k4a_float3_t *target_point3d_mm);
+
+/** Transform a 2D pixel coordinate with an associated depth value of the source camera into a 3D point of the target
+ * coordinate system.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_point2d
+ * The 2D pixel in \p source_camera coordinates.
+ *
+ * \param source_depth_mm
+ * The depth of \p source_point2d in millimeters. One way to derive the depth value in the color camera geometry is to
+ * use the function k4a_transformation_depth_image_to_color_camera().
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_point3d_mm
+ * Pointer to the output where the 3D coordinates of the input pixel in the coordinate system of \p target_camera is
+ * stored in millimeters.
+ *
+ * \param valid
+ * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate, and will return 0 if
+ * the coordinate is not valid in the calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_point3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
+ * the transformation was computed, but the results in \p target_point3d_mm are outside of the range of valid
+ * calibration and should be ignored.
+ *
+ * \remarks
+ * This function applies the intrinsic calibration of \p source_camera to compute the 3D ray from the focal point of the
+ * camera through pixel \p source_point2d. The 3D point on this ray is then found using \p source_depth_mm. If \p
+ * target_camera is different from \p source_camera, the 3D point is transformed to \p target_camera using
+ * k4a_calibration_3d_to_3d(). In practice, \p source_camera and \p target_camera will often be identical. In this
+ * case, no 3D to 3D transformation is applied.
+ *
+ * \remarks
+ * If \p source_point2d is not considered as valid pixel coordinate
+ * according to the intrinsic camera model, \p valid is set to 0. If it is valid, \p valid will be set to 1. The user
+ * should not use the value of \p target_point3d_mm if \p valid was set to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_2d_to_3d(const k4a_calibration_t *calibration,
+                                                 const k4a_float2_t *source_point2d,
+                                                 const float source_depth_mm,
+                                                 const k4a_calibration_type_t source_camera,
+                                                 const k4a_calibration_type_t target_camera,
+                                                 k4a_float3_t *target_point3d_mm,
+                                                 int *valid);
+
+/** Transform an array of 2D pixel coordinates with associated depth values of the source camera into 3D points of the
+ * target coordinate system.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points2d
+ * Array of \p point_count 2D pixels in \p source_camera coordinates.
+ *
+ * \param source_depths_mm
+ * Array of \p point_count depth values in millimeters, one for each pixel in \p source_points2d.
+ *
+ * \param point_count
+ * The number of points to transform.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points3d_mm
+ * Array of \p point_count elements where the 3D coordinates of the input pixels in the coordinate system of \p
+ * target_camera are stored in millimeters.
+ *
+ * \param valid
+ * Array of \p point_count elements. Each element is set to 1 if the corresponding pixel in \p source_points2d is a
+ * valid coordinate, and to 0 if the coordinate is not valid in the calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters.
+ *
+ * \remarks
+ * This function produces the same results as calling k4a_calibration_2d_to_3d() once for each point, but validates the
+ * calibration once for the whole array. Prefer it when transforming many points, such as a list of feature points.
+ *
+ * \remarks
+ * The user should not use the elements of \p target_points3d_mm for which the corresponding element of \p valid was
+ * set to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float2_t *source_points2d,
+                                                       const float *source_depths_mm,
+                                                       size_t point_count,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float3_t *target_points3d_mm,
+                                                       int *valid);
+
+/** Transform a 3D point of a source coordinate system into a 2D pixel coordinate of the target camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_point3d_mm
+ * The 3D coordinates in millimeters representing a point in \p source_camera
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_point2d
+ * Pointer to the output where the 2D pixel in \p target_camera coordinates is stored.
+ *
+ * \param valid
+ * The output parameter returns a value of 1 if the \p source_point3d_mm is a valid coordinate in the \p target_camera
+ * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
+ * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
+ * and should be ignored.
+ *
+ * \remarks
+ * If \p target_camera is different from \p source_camera, \p source_point3d_mm is transformed to \p target_camera using
+ * k4a_calibration_3d_to_3d(). In practice, \p source_camera and \p target_camera will often be identical. In this
+ * case, no 3D to 3D transformation is applied. The 3D point in the coordinate system of \p target_camera is then
+ * projected onto the image plane using the intrinsic calibration of \p target_camera.
+ *
+ * \remarks
+ * If \p source_point3d_mm does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is
+ * set to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p
+ * valid was set to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_3d_to_2d(const k4a_calibration_t *calibration,
+                                                 const k4a_float3_t *source_point3d_mm,
+                                                 const k4a_calibration_type_t source_camera,
+                                                 const k4a_calibration_type_t target_camera,
+                                                 k4a_float2_t *target_point2d,
+                                                 int *valid);
+
+/** Transform an array of 3D points of a source coordinate system into 2D pixel coordinates of the target camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_points3d_mm
+ * Array of \p point_count 3D coordinates in millimeters representing points in \p source_camera.
+ *
+ * \param point_count
+ * The number of points to transform.
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_points2d
+ * Array of \p point_count elements where the 2D pixels in \p target_camera coordinates are stored.
+ *
+ * \param valid
+ * Array of \p point_count elements. Each element is set to 1 if the corresponding point in \p source_points3d_mm is a
+ * valid coordinate in the \p target_camera coordinate system, and to 0 if the coordinate is not valid in the
+ * calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_points2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters.
+ *
+ * \remarks
+ * This function produces the same results as calling k4a_calibration_3d_to_2d() once for each point, but validates the
+ * calibration once for the whole array and projects several points at a time using SIMD instructions where available.
+ * Prefer it when transforming many points, such as the vertices of a point cloud.
+ *
+ * \remarks
+ * The user should not use the elements of \p target_points2d for which the corresponding element of \p valid was set
+ * to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                                       const k4a_float3_t *source_points3d_mm,
+                                                       size_t point_count,
+                                                       const k4a_calibration_type_t source_camera,
+                                                       const k4a_calibration_type_t target_camera,
+                                                       k4a_float2_t *target_points2d,
+                                                       int *valid);
+
+/** Transform a 2D pixel coordinate with an associated depth value of the source camera into a 2D pixel coordinate of
+ * the target camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_point2d
+ * The 2D pixel in \p source_camera coordinates.
+ *
+ * \param source_depth_mm
+ * The depth of \p source_point2d in millimeters. One way to derive the depth value in the color camera geometry is to
+ * use the function k4a_transformation_depth_image_to_color_camera().
+ *
+ * \param source_camera
+ * The current camera.
+ *
+ * \param target_camera
+ * The target camera.
+ *
+ * \param target_point2d
+ * The 2D pixel in \p target_camera coordinates.
+ *
+ * \param valid
+ * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate in the \p target_camera
+ * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
+ * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
+ * and should be ignored.
+ *
+ * \remarks
+ * This function maps a pixel between the coordinate systems of the depth and color cameras. It is equivalent to calling
+ * k4a_calibration_2d_to_3d() to compute the 3D point corresponding to \p source_point2d and then using
+ * k4a_calibration_3d_to_2d() to map the 3D point into the coordinate system of the \p target_camera.
+ *
+ * \remarks
+ * If \p source_camera and \p target_camera are identical, the function immediately sets \p target_point2d to \p
+ * source_point2d and returns without computing any transformations.
+ *
+ * \remarks
+ * If \p source_point2d does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is set
+ * to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p valid
+ * was set to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibration,
+                                                 const k4a_float2_t *source_point2d,
+                                                 const float source_depth_mm,
+                                                 const k4a_calibration_type_t source_camera,
+                                                 const k4a_calibration_type_t target_camera,
+                                                 k4a_float2_t *target_point2d,
+                                                 int *valid);
+
+/** Transform a 2D pixel coordinate from color camera into a 2D pixel coordinate of
+ * the depth camera.
+ *
+ * \param calibration
+ * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ *
+ * \param source_point2d
+ * The 2D pixel in \p color camera coordinates.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param target_point2d
+ * The 2D pixel in \p depth camera coordinates.
+ *
+ * \param valid
+ * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate in the \p target_camera
+ * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
+ * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
+ * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
+ * and should be ignored.
+ *
+ * \remarks
+ * This function represents an alternative to k4a_calibration_2d_to_2d() if the number of pixels that need to be
+ * transformed is small. This function searches along an epipolar line in the depth image to find the corresponding
+ * depth pixel. If a larger number of pixels need to be transformed, it might be computationally cheaper to call
+ * k4a_transformation_depth_image_to_color_camera() to get correspondence depth values for these color pixels, then call
+ * the function k4a_calibration_2d_to_2d(). k4a_transformation_color_2d_to_depth_2d_batch() transforms many color pixels
+ * against the same depth image without an epipolar search per pixel.
+ *
+ * \remarks
+ * If \p source_point2d does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is set
+ * to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p valid
+ * was set to 0.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_calibration_color_2d_to_depth_2d(const k4a_calibration_t *calibration,
+                                                             const k4a_float2_t *source_point2d,
+                                                             const k4a_image_t depth_image,
+                                                             k4a_float2_t *target_point2d,
+                                                             int *valid);
+
+/** Get handle to transformation handle.
+ *
+ * \param calibration
+ * A calibration structure obtained by k4a_device_get_calibration().
+ *
+ * \returns
+ * A transformation handle. A NULL is returned if creation fails.
+ *
+ * \remarks
+ * The transformation handle is used to transform images from the coordinate system of one camera into the other. Each
+ * transformation handle requires some pre-computed resources to be allocated, which are retained until the handle is
+ * destroyed.
+ *
+ * \remarks
+ * If the environment variable \p K4A_TRANSFORMATION_CACHE_DIR names an existing directory, the pre-computed
+ * unprojection tables are stored there and loaded by later calls with the same calibration and mode, instead of being
+ * computed again. Cache files that do not match the calibration are ignored and rewritten.
+ *
+ * \remarks
+ * A transformation handle may be used from several threads at once, so one handle can serve a pool of worker threads
+ * instead of each thread creating its own copy of the tables. CPU transformations of different threads run in
+ * parallel; calls that use the GPU share one transform engine and run one after the other.
+ *
+ * \remarks
+ * The transformation handle must be destroyed with k4a_transformation_destroy() when it is no longer to be used.
+ *
+ * \relates k4a_calibration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_transformation_t k4a_transformation_create(const k4a_calibration_t *calibration);
+
+/** Destroy transformation handle.
+ *
+ * \param transformation_handle
+ * Transformation handle to destroy.
+ *
+ * \remarks
+ * Jobs submitted with k4a_transformation_submit() complete before the handle is destroyed.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_transformation_destroy(k4a_transformation_t transformation_handle);
+
+/** Limits the transformation functions to a region of interest of the depth camera.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param roi
+ * Region of interest in pixels of the depth camera, or NULL to process full images again.
+ *
+ * \remarks
+ * With a region of interest the transformation functions only process the pixels of the depth image that the region
+ * selects, so their cost scales with the number of selected pixels. A decimation of n selects every n-th pixel of
+ * every n-th row of the region. The selected pixels form an image of ceil(width / decimation) by ceil(height /
+ * decimation) pixels, called the region image below.
+ *
+ * \remarks
+ * Input images in the depth camera geometry keep the full resolution of the depth mode. Output images in the depth
+ * camera geometry, which are the outputs of k4a_transformation_color_image_to_depth_camera(),
+ * k4a_transformation_depth_image_to_colored_point_cloud() and the point cloud functions with
+ * ::K4A_CALIBRATION_TYPE_DEPTH, must have the width and height of the region image. Output images in the color camera
+ * geometry keep the full or downscaled resolution of the color camera; k4a_transformation_depth_image_to_color_camera()
+ * and k4a_transformation_depth_image_to_color_camera_custom() render a mesh of the selected depth pixels into them.
+ *
+ * \remarks
+ * The point cloud functions with ::K4A_CALIBRATION_TYPE_COLOR are not affected by the region of interest.
+ *
+ * \remarks
+ * The transformation functions run on the CPU while a region of interest is set, also for handles created with GPU
+ * acceleration.
+ *
+ * \remarks
+ * The region of interest may be changed while other threads use the handle. The function waits for the running
+ * transformation functions to complete; transformations called after it returns use the new region.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the region of interest was set and ::K4A_RESULT_FAILED if it does not fit into the depth
+ * image.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_set_region_of_interest(k4a_transformation_t transformation_handle,
+                                                                  const k4a_transformation_roi_t *roi);
+
+/** Sets the number of threads the transformation functions running on the CPU are split across.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param thread_count
+ * Number of threads, from 1 to 16. 1, the default, runs the transformation functions on the calling thread only.
+ *
+ * \remarks
+ * The threads split k4a_transformation_depth_image_to_color_camera(),
+ * k4a_transformation_depth_image_to_color_camera_custom() and
+ * k4a_transformation_depth_image_to_color_camera_custom_images() while they run on the CPU, and
+ * k4a_transformation_color_2d_to_depth_2d_batch(). The depth to color functions run on the CPU with a region of
+ * interest, a downscaled output or more than one custom image, see k4a_transformation_set_region_of_interest(), and
+ * otherwise on the GPU the handle was created with.
+ *
+ * \remarks
+ * The threads are shared by every transformation handle of the process that uses more than one, they are created by
+ * the first such call and exit once no handle uses them.
+ *
+ * \remarks
+ * The thread count may be changed while other threads use the handle. The function waits for the running
+ * transformation functions to complete; transformations called after it returns use the new thread count.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the thread count was set and ::K4A_RESULT_FAILED if it is out of range or the threads could
+ * not be created.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_set_thread_count(k4a_transformation_t transformation_handle,
+                                                            uint32_t thread_count);
+
+/** Gets the table that maps each pixel of a camera to a point on the Z=1 plane.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param camera
+ * The camera to get the table for, ::K4A_CALIBRATION_TYPE_DEPTH or ::K4A_CALIBRATION_TYPE_COLOR.
+ *
+ * \param xy_table_image
+ * Handle to the output image. It must be of format ::K4A_IMAGE_FORMAT_CUSTOM, have the full resolution of \p camera
+ * and a stride of at least width * sizeof(k4a_float2_t) bytes.
+ *
+ * \remarks
+ * Each pixel of \p xy_table_image is set to a ::k4a_float2_t with the X and Y coordinates of the unprojected pixel at
+ * a depth of 1, so a point in millimeters is (x * depth, y * depth, depth). Pixels that can not be unprojected are set
+ * to NAN in both coordinates.
+ *
+ * \remarks
+ * These are the tables that the transformation handle computed when it was created, so applications that compute point
+ * clouds themselves, e.g. on the GPU, can use them instead of unprojecting every pixel with k4a_calibration_2d_to_3d().
+ * The table always covers the full image and is not affected by k4a_transformation_set_region_of_interest().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xy_table_image was filled in and ::K4A_RESULT_FAILED if \p camera is not in use or
+ * \p xy_table_image does not have the expected format or size.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_get_xy_table(k4a_transformation_t transformation_handle,
+                                                        const k4a_calibration_type_t camera,
+                                                        k4a_image_t xy_table_image);
+
+/** Transforms an array of 2D pixel coordinates of the color camera into 2D pixel coordinates of the depth camera.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image at the resolution of the depth camera.
+ *
+ * \param source_points2d
+ * Array of \p point_count 2D pixels in color camera coordinates.
+ *
+ * \param point_count
+ * Number of points to transform.
+ *
+ * \param target_points2d
+ * Array of \p point_count 2D pixels in depth camera coordinates.
+ *
+ * \param valid
+ * Array of \p point_count values, each set to 1 if the corresponding point of \p source_points2d was found in the
+ * depth image and to 0 otherwise.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the points were transformed. ::K4A_RESULT_FAILED if the transformation handle has no
+ * color camera, or if \p depth_image does not have the format and resolution of the depth camera.
+ *
+ * \remarks
+ * This is the batched form of k4a_calibration_color_2d_to_depth_2d(). Instead of searching along the epipolar line of
+ * every color pixel, the correspondence of every depth pixel in the color camera is computed once, as for
+ * k4a_transformation_depth_image_to_color_camera(), and inverted into a map of the color camera. Each color pixel is
+ * then looked up in the map, moved to the depth pixel whose correspondence is nearest to it and refined to a sub pixel
+ * position. Where several depth pixels map to the same color pixels, the one nearest to the color camera is used. The
+ * cost of building the map is shared by all points of a call, so many points should be passed in one call.
+ *
+ * \remarks
+ * The full depth image is used, k4a_transformation_set_region_of_interest() does not apply.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_color_2d_to_depth_2d_batch(k4a_transformation_t transformation_handle,
+                                                                      const k4a_image_t depth_image,
+                                                                      const k4a_float2_t *source_points2d,
+                                                                      size_t point_count,
+                                                                      k4a_float2_t *target_points2d,
+                                                                      int *valid);
+
+/** Transforms the depth map into the geometry of the color camera.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param transformed_depth_image
+ * Handle to output transformed depth image.
+ *
+ * \remarks
+ * This produces a depth image for which each pixel matches the corresponding pixel coordinates of the color camera.
+ *
+ * \remarks
+ * \p depth_image and \p transformed_depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
+ *
+ * \remarks
+ * \p transformed_depth_image must have a width and height matching the width and height of the color camera in the mode
+ * specified by the \ref k4a_calibration_t used to create the \p transformation_handle with k4a_transformation_create().
+ *
+ * \remarks
+ * \p transformed_depth_image may instead have 1/2, 1/4 or 1/8 of the width and height of the color camera, rounded up,
+ * with packed rows. The depth image is then rendered with the color camera intrinsics scaled to that resolution, so
+ * pixel (x, y) covers the color camera pixels (x * n, y * n) to (x * n + n - 1, y * n + n - 1) for a scale of 1/n.
+ * This is the same geometry as a color image decoded at that scale, and it divides the rasterization work and the size
+ * of the output by n * n. A downscaled output is always rendered on the CPU.
+ *
+ * \remarks
+ * The contents \p transformed_depth_image will be filled with the depth values derived from \p depth_image in the color
+ * camera's coordinate space.
+ *
+ * \remarks
+ * \p transformed_depth_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_color_camera(k4a_transformation_t transformation_handle,
+                                                                       const k4a_image_t depth_image,
+                                                                       k4a_image_t transformed_depth_image);
+
+/** Transforms depth map and a custom image into the geometry of the color camera.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param custom_image
+ * Handle to input custom image.
+ *
+ * \param transformed_depth_image
+ * Handle to output transformed depth image.
+ *
+ * \param transformed_custom_image
+ * Handle to output transformed custom image.
+ *
+ * \param interpolation_type
+ * Parameter that controls how pixels in \p custom_image should be interpolated when transformed to color camera space.
+ * K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR if linear interpolation should be used.
+ * K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST if nearest neighbor interpolation should be used.
+ *
+ * \param invalid_custom_value
+ * Defines the custom image pixel value that should be written to \p transformed_custom_image in case the corresponding
+ * depth pixel can not be transformed into the color camera space.
+ *
+ * \remarks
+ * This produces a depth image and a corresponding custom image for which each pixel matches the corresponding
+ * pixel coordinates of the color camera.
+ *
+ * \remarks
+ * \p depth_image and \p transformed_depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
+ *
+ * \remarks
+ * \p custom_image and \p transformed_custom_image must be of format ::K4A_IMAGE_FORMAT_CUSTOM8 or
+ * ::K4A_IMAGE_FORMAT_CUSTOM16.
+ *
+ * \remarks
+ * \p transformed_depth_image and \p transformed_custom_image must have a width and height matching the width and
+ * height of the color camera in the mode specified by the \ref k4a_calibration_t used to create the
+ * \p transformation_handle with k4a_transformation_create(), or both the same downscaled width and height that
+ * k4a_transformation_depth_image_to_color_camera() accepts.
+ *
+ * \remarks
+ * \p custom_image must have a width and height matching the width and height of \p depth_image.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \remarks
+ * The contents \p transformed_depth_image will be filled with the depth values derived from \p depth_image in the color
+ * camera's coordinate space.
  *
- * \param command
- * Color sensor control command.
+ * \remarks
+ * The contents \p transformed_custom_image will be filled with the values derived from \p custom_image in the color
+ * camera's coordinate space.
  *
- * \param mode
- * Location to store the color sensor's control mode. This mode represents whether the command is in automatic or
- * manual mode.
+ * \remarks
+ * \p transformed_depth_image and \p transformed_custom_image should be created by the caller using k4a_image_create()
+ * or k4a_image_create_from_buffer().
  *
- * \param value
- * Location to store the color sensor's control value. This value is always written, but is only valid when the \p
- * mode returned is ::K4A_COLOR_CONTROL_MODE_MANUAL for the current \p command.
+ * \remarks
+ * Using ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR for \p interpolation_type could create new values to \p
+ * transformed_custom_image which do no exist in \p custom_image. Using ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST
+ * will prevent this from happenning but will result in a less smooth image.
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED if the value was successfully returned, ::K4A_RESULT_FAILED if an error occurred
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_image and \p transformed_custom_image were successfully written and
+ * ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_color_camera_custom(k4a_transformation_t transformation_handle,
+                                                      const k4a_image_t depth_image,
+                                                      const k4a_image_t custom_image,
+                                                      k4a_image_t transformed_depth_image,
+                                                      k4a_image_t transformed_custom_image,
+                                                      k4a_transformation_interpolation_type_t interpolation_type,
+                                                      uint32_t invalid_custom_value);
+
+/** Transforms depth map and several custom images into the geometry of the color camera in one pass.
+ *
+ * \param transformation_handle
+ * Transformation handle.
+ *
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param custom_images
+ * Array of \p custom_image_count handles to input custom images.
+ *
+ * \param custom_image_count
+ * Number of custom images, at most ::K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES. May be 0.
+ *
+ * \param transformed_depth_image
+ * Handle to output transformed depth image.
+ *
+ * \param transformed_custom_images
+ * Array of \p custom_image_count handles to output transformed custom images.
+ *
+ * \param interpolation_type
+ * Parameter that controls how pixels in \p custom_images should be interpolated when transformed to color camera
+ * space, see k4a_transformation_depth_image_to_color_camera_custom().
+ *
+ * \param invalid_custom_values
+ * Array of \p custom_image_count values. Entry i is written to \p transformed_custom_images[i] in case the
+ * corresponding depth pixel can not be transformed into the color camera space.
  *
  * \remarks
- * Each control command may be set to manual or automatic. See the definition of \ref k4a_color_control_command_t on
- * how to interpret the \p value for each command.
+ * This produces the same images as calling k4a_transformation_depth_image_to_color_camera_custom() once for every
+ * custom image, but rasterizes the depth mesh only once and interpolates all custom images from the same triangles.
  *
  * \remarks
- * Some control commands are only supported in manual mode. When a command is in automatic mode, the \p value for
- * that command is not valid.
+ * Each pair of \p custom_images[i] and \p transformed_custom_images[i] must follow the requirements of
+ * k4a_transformation_depth_image_to_color_camera_custom(). Pairs of format ::K4A_IMAGE_FORMAT_CUSTOM8 and
+ * ::K4A_IMAGE_FORMAT_CUSTOM16 may be mixed.
  *
  * \remarks
- * Control values set on a device are reset only when the device is power cycled. The device will retain the
- * settings even if the \ref k4a_device_t is closed or the application is restarted.
+ * The GPU transform engine maps one custom image per pass, so a transformation created with GPU optimization
+ * transforms more than one custom image on the CPU.
  *
- * \relates k4a_device_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_image and \p transformed_custom_images were successfully written and
+ * ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1496,42 +4651,61 @@ K4A_EXPORT k4a_result_t k4a_device_get_color_control_capabilities(k4a_device_t d
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_get_color_control(k4a_device_t device_handle,
-                                                     k4a_color_control_command_t command,
-                                                     k4a_color_control_mode_t *mode,
-                                                     int32_t *value);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_color_camera_custom_images(k4a_transformation_t transformation_handle,
+                                                             const k4a_image_t depth_image,
+                                                             const k4a_image_t *custom_images,
+                                                             size_t custom_image_count,
+                                                             k4a_image_t transformed_depth_image,
+                                                             k4a_image_t *transformed_custom_images,
+                                                             k4a_transformation_interpolation_type_t interpolation_type,
+                                                             const uint32_t *invalid_custom_values);
 
-/** Set the Azure Kinect color sensor control value.
+/** Transforms a color image into the geometry of the depth camera.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param command
- * Color sensor control command.
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param mode
- * Color sensor control mode to set. This mode represents whether the command is in automatic or manual mode.
+ * \param color_image
+ * Handle to input color image.
  *
- * \param value
- * Value to set the color sensor's control to. The value is only valid if \p mode
- * is set to ::K4A_COLOR_CONTROL_MODE_MANUAL, and is otherwise ignored.
+ * \param transformed_color_image
+ * Handle to output transformed color image.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if the value was successfully set, ::K4A_RESULT_FAILED if an error occurred
+ * \remarks
+ * This produces a color image for which each pixel matches the corresponding pixel coordinates of the depth camera.
  *
  * \remarks
- * Each control command may be set to manual or automatic. See the definition of \ref k4a_color_control_command_t on how
- * to interpret the \p value for each command.
+ * \p depth_image and \p color_image need to represent the same moment in time. The depth data will be applied to the
+ * color image to properly warp the color data to the perspective of the depth camera.
  *
  * \remarks
- * Some control commands are only supported in manual mode. When a command is in automatic mode, the \p value for that
- * command is not valid.
+ * \p depth_image must be of type ::K4A_IMAGE_FORMAT_DEPTH16. \p color_image must be of format
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32, ::K4A_IMAGE_FORMAT_COLOR_NV12, ::K4A_IMAGE_FORMAT_COLOR_YUY2 or
+ * ::K4A_IMAGE_FORMAT_COLOR_MJPG.
  *
  * \remarks
- * Control values set on a device are reset only when the device is power cycled. The device will retain the settings
- * even if the \ref k4a_device_t is closed or the application is restarted.
+ * A color image in another format than BGRA32 does not need to be converted first. NV12 and YUY2 images are sampled
+ * directly and only the sampled pixels are converted to BGRA. MJPEG images are decoded at the smallest scale that still
+ * has the resolution of the depth camera. Both are faster than converting the whole color image to BGRA32. Only
+ * BGRA32 images are transformed on the GPU, other formats are transformed on the CPU.
  *
- * \relates k4a_device_t
+ * \remarks
+ * \p transformed_color_image image must be of format ::K4A_IMAGE_FORMAT_COLOR_BGRA32. \p transformed_color_image must
+ * have the width and height of the depth camera in the mode specified by the \ref k4a_calibration_t used to create
+ * the \p transformation_handle with k4a_transformation_create().
+ *
+ * \remarks
+ * \p transformed_color_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_color_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1541,31 +4715,41 @@ K4A_EXPORT k4a_result_t k4a_device_get_color_control(k4a_device_t device_handle,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_set_color_control(k4a_device_t device_handle,
-                                                     k4a_color_control_command_t command,
-                                                     k4a_color_control_mode_t mode,
-                                                     int32_t value);
+K4A_EXPORT k4a_result_t k4a_transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
+                                                                       const k4a_image_t depth_image,
+                                                                       const k4a_image_t color_image,
+                                                                       k4a_image_t transformed_color_image);
 
-/** Get the raw calibration blob for the entire Azure Kinect device.
+/** Transforms a color image into the geometry of the depth camera with a choice of color interpolation.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param data
- * Location to write the calibration data to. This field may optionally be set to NULL for the caller to query for
- * the needed data size.
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param data_size
- * On passing \p data_size into the function this variable represents the available size of the \p data
- * buffer. On return this variable is updated with the amount of data actually written to the buffer, or the size
- * required to store the calibration buffer if \p data is NULL.
+ * \param color_image
+ * Handle to input color image.
+ *
+ * \param transformed_color_image
+ * Handle to output transformed color image.
+ *
+ * \param interpolation_type
+ * K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR samples \p color_image bilinearly, which is what
+ * k4a_transformation_color_image_to_depth_camera() does. K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST copies the
+ * closest color pixel, which is faster and never mixes colors across edges, but gives a less smooth image.
+ *
+ * \remarks
+ * The images follow the requirements of k4a_transformation_color_image_to_depth_camera().
+ *
+ * \remarks
+ * The GPU transform engine always samples color bilinearly, so a transformation created with GPU optimization runs
+ * ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST on the CPU.
  *
  * \returns
- * ::K4A_BUFFER_RESULT_SUCCEEDED if \p data was successfully written. If \p data_size points to a buffer size that is
- * too small to hold the output or \p data is NULL, ::K4A_BUFFER_RESULT_TOO_SMALL is returned and \p data_size is
- * updated to contain the minimum buffer size needed to capture the calibration data.
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_color_image was successfully written and ::K4A_RESULT_FAILED otherwise.
  *
- * \relates k4a_device_t
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1575,40 +4759,45 @@ K4A_EXPORT k4a_result_t k4a_device_set_color_control(k4a_device_t device_handle,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_buffer_result_t k4a_device_get_raw_calibration(k4a_device_t device_handle,
-                                                              uint8_t *data,
-                                                              size_t *data_size);
+K4A_EXPORT k4a_result_t k4a_transformation_color_image_to_depth_camera_with_interpolation(
+    k4a_transformation_t transformation_handle,
+    const k4a_image_t depth_image,
+    const k4a_image_t color_image,
+    k4a_image_t transformed_color_image,
+    k4a_transformation_interpolation_type_t interpolation_type);
 
-/** Get the camera calibration for the entire Azure Kinect device.
+/** Transforms the depth map into the geometry of the color camera and exports the result as a GPU resource.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param depth_mode
- * Mode in which depth camera is operated.
+ * \param depth_image
+ * Handle to input depth image, as for k4a_transformation_depth_image_to_color_camera(). Its rows must be packed.
  *
- * \param color_resolution
- * Resolution in which color camera is operated.
+ * \param type
+ * How the transformed depth image is shared with the application.
  *
- * \param calibration
- * Location to write the calibration
+ * \param transformed_depth_resource
+ * Receives the transformed depth image, a ::K4A_IMAGE_FORMAT_DEPTH16 image of the color camera resolution.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p calibration was successfully written. ::K4A_RESULT_FAILED otherwise.
+ * \remarks
+ * Renderers and GPU inference that upload the transformed image again can use this instead of
+ * k4a_transformation_depth_image_to_color_camera(), the transform engine leaves the image on the GPU and skips the copy
+ * to host memory. Wait for \p transformed_depth_resource's fence before reading it.
  *
  * \remarks
- * The \p calibration represents the data needed to transform between the camera views and may be
- * different for each operating \p depth_mode and \p color_resolution the device is configured to operate in.
+ * The resource belongs to the transformation handle, release it with k4a_transformation_release_gpu_resource() before
+ * the handle is destroyed. Until it is released the transform engine does not write it again.
  *
  * \remarks
- * The \p calibration output is used as input to all calibration and transformation functions.
+ * Point clouds are computed on the CPU and have no GPU variant. Applications can compute them on the GPU from the
+ * depth image and the table of k4a_transformation_get_xy_table().
  *
- * \see k4a_calibration_2d_to_2d()
- * \see k4a_calibration_2d_to_3d()
- * \see k4a_calibration_3d_to_2d()
- * \see k4a_calibration_3d_to_3d()
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_resource was filled in. ::K4A_RESULT_FAILED if the depth engine
+ * plugin or the GPU does not support \p type, a region of interest is set or the transformation failed.
  *
- * \relates k4a_device_t
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1618,34 +4807,37 @@ K4A_EXPORT k4a_buffer_result_t k4a_device_get_raw_calibration(k4a_device_t devic
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_get_calibration(k4a_device_t device_handle,
-                                                   const k4a_depth_mode_t depth_mode,
-                                                   const k4a_color_resolution_t color_resolution,
-                                                   k4a_calibration_t *calibration);
+K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_color_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const k4a_image_t depth_image,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_depth_resource);
 
-/** Get the device jack status for the synchronization in and synchronization out connectors.
+/** Transforms a color image into the geometry of the depth camera and exports the result as a GPU resource.
  *
- * \param device_handle
- * Handle obtained by k4a_device_open().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param sync_in_jack_connected
- * Upon successful return this value will be set to true if a cable is connected to this sync in jack.
+ * \param depth_image
+ * Handle to input depth image. Its rows must be packed.
  *
- * \param sync_out_jack_connected
- * Upon successful return this value will be set to true if a cable is connected to this sync out jack.
+ * \param color_image
+ * Handle to input color image of format ::K4A_IMAGE_FORMAT_COLOR_BGRA32. Its rows must be packed.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if the connector status was successfully read.
+ * \param type
+ * How the transformed color image is shared with the application.
  *
- * \relates k4a_device_t
+ * \param transformed_color_resource
+ * Receives the transformed color image, a ::K4A_IMAGE_FORMAT_COLOR_BGRA32 image of the depth camera resolution.
  *
  * \remarks
- * If \p sync_out_jack_connected is true then \ref k4a_device_configuration_t wired_sync_mode mode can be set to \ref
- * K4A_WIRED_SYNC_MODE_STANDALONE or \ref K4A_WIRED_SYNC_MODE_MASTER. If \p sync_in_jack_connected is true then \ref
- * k4a_device_configuration_t wired_sync_mode mode can be set to \ref K4A_WIRED_SYNC_MODE_STANDALONE or \ref
- * K4A_WIRED_SYNC_MODE_SUBORDINATE.
+ * The GPU variant of k4a_transformation_color_image_to_depth_camera(), see
+ * k4a_transformation_depth_image_to_color_camera_gpu().
  *
- * \see k4a_device_start_cameras()
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_color_resource was filled in and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1655,43 +4847,63 @@ K4A_EXPORT k4a_result_t k4a_device_get_calibration(k4a_device_t device_handle,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_device_get_sync_jack(k4a_device_t device_handle,
-                                                 bool *sync_in_jack_connected,
-                                                 bool *sync_out_jack_connected);
+K4A_EXPORT k4a_result_t k4a_transformation_color_image_to_depth_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const k4a_image_t depth_image,
+    const k4a_image_t color_image,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_color_resource);
 
-/** Get the camera calibration for a device from a raw calibration blob.
+/** Transforms a depth image that the depth engine left on the GPU into the geometry of the color camera.
  *
- * \param raw_calibration
- * Raw calibration blob obtained from a device or recording. The raw calibration must be NULL terminated.
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param raw_calibration_size
- * The size, in bytes, of raw_calibration including the NULL termination.
+ * \param depth_resource
+ * Resource of a depth image, returned by k4a_image_get_gpu_resource() for a device with GPU export enabled by
+ * k4a_device_set_depth_gpu_export().
  *
- * \param depth_mode
- * Mode in which depth camera is operated.
+ * \param type
+ * How the transformed depth image is shared with the application.
  *
- * \param color_resolution
- * Resolution in which color camera is operated.
+ * \param transformed_depth_resource
+ * Receives the transformed depth image, see k4a_transformation_depth_image_to_color_camera_gpu().
  *
- * \param calibration
- * Location to write the calibration.
+ * \remarks
+ * The transform engine reads the depth image on the GPU after waiting for the fence of \p depth_resource, so a
+ * GPU-only pipeline copies neither the depth image nor the transformed image through host memory. Release
+ * \p transformed_depth_resource with k4a_transformation_release_gpu_resource().
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED if \p calibration was successfully written. ::K4A_RESULT_FAILED otherwise.
- *
- * \remarks
- * The \p calibration represents the data needed to transform between the camera views and is
- * different for each operating \p depth_mode and \p color_resolution the device is configured to operate in.
+ * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_resource was filled in. ::K4A_RESULT_FAILED if the depth engine plugin
+ * can't read \p depth_resource, \p depth_resource is not a depth image of the calibration's depth mode, a region of
+ * interest is set or the transformation failed.
  *
- * \remarks
- * The \p calibration output is used as input to all transformation functions.
+ * \relates k4a_transformation_t
  *
- * \see k4a_calibration_2d_to_2d()
- * \see k4a_calibration_2d_to_3d()
- * \see k4a_calibration_3d_to_2d()
- * \see k4a_calibration_3d_to_3d()
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_resource_to_color_camera_gpu(k4a_transformation_t transformation_handle,
+                                                      const k4a_gpu_resource_t *depth_resource,
+                                                      k4a_gpu_interop_type_t type,
+                                                      k4a_gpu_resource_t *transformed_depth_resource);
+
+/** Releases a GPU resource exported by a transformation.
  *
- * \relates k4a_device_t
+ * \param transformation_handle
+ * Transformation handle the resource was exported from.
+ *
+ * \param resource
+ * The resource to release. The application must be done with it on the GPU and have closed the handles it imported.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1701,41 +4913,48 @@ K4A_EXPORT k4a_result_t k4a_device_get_sync_jack(k4a_device_t device_handle,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_get_from_raw(char *raw_calibration,
-                                                     size_t raw_calibration_size,
-                                                     const k4a_depth_mode_t depth_mode,
-                                                     const k4a_color_resolution_t color_resolution,
-                                                     k4a_calibration_t *calibration);
+K4A_EXPORT void k4a_transformation_release_gpu_resource(k4a_transformation_t transformation_handle,
+                                                        const k4a_gpu_resource_t *resource);
 
-/** Transform a 3D point of a source coordinate system into a 3D point of the target coordinate system
+/** Transforms the depth image into a single image with voxels representing
+ * X, Y and Z-coordinates in millimeters of corresponding 3D points.
  *
- * \param calibration
- * Location to read the camera calibration data.
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param source_point3d_mm
- * The 3D coordinates in millimeters representing a point in \p source_camera.
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param source_camera
- * The current camera.
+ * \param camera
+ * Geometry in which depth map was computed.
  *
- * \param target_camera
- * The target camera.
+ * \param xyz_image
+ * Handle to output xyz image.
  *
- * \param target_point3d_mm
- * Pointer to the output where the new 3D coordinates of the input point in the coordinate space of \p target_camera is
- * stored in millimeters.
+ * \remarks
+ * \p depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p target_point3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
- * contained invalid transformation parameters.
+ * \remarks
+ * The \p camera parameter tells the function what the perspective of the \p depth_image is. If the \p depth_image was
+ * captured directly from the depth camera, the value should be ::K4A_CALIBRATION_TYPE_DEPTH. If the \p depth_image is
+ * the result of a transformation into the color camera's coordinate space using
+ * k4a_transformation_depth_image_to_color_camera(), the value should be ::K4A_CALIBRATION_TYPE_COLOR.
  *
  * \remarks
- * This function is used to transform 3D points between depth and color camera coordinate systems. The function uses the
- * extrinsic camera calibration. It computes the output via multiplication with a precomputed matrix encoding a 3D
- * rotation and a 3D translation. If \p source_camera and \p target_camera are the same, then \p target_point3d_mm will
- * be identical to \p source_point3d_mm.
+ * The format of \p xyz_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p xyz_image must match the
+ * width and height of \p depth_image. \p xyz_image must have a stride in bytes of at least 6 times its width in pixels.
  *
- * \relates k4a_calibration_t
+ * \remarks
+ * Each pixel of the \p xyz_image consists of three int16_t values, totaling 6 bytes. The three int16_t values are the
+ * X, Y, and Z values of the point.
+ *
+ * \remarks
+ * \p xyz_image should be created by the caller using k4a_image_create() or k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1745,58 +4964,53 @@ K4A_EXPORT k4a_result_t k4a_calibration_get_from_raw(char *raw_calibration,
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_3d_to_3d(const k4a_calibration_t *calibration,
-                                                 const k4a_float3_t *source_point3d_mm,
-                                                 const k4a_calibration_type_t source_camera,
-                                                 const k4a_calibration_type_t target_camera,
-                                                 k4a_float3_t *target_point3d_mm);
+K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
+                                                                      const k4a_image_t depth_image,
+                                                                      const k4a_calibration_type_t camera,
+                                                                      k4a_image_t xyz_image);
 
-/** Transform a 2D pixel coordinate with an associated depth value of the source camera into a 3D point of the target
- * coordinate system.
- *
- * \param calibration
- * Location to read the camera calibration obtained by k4a_device_get_calibration().
+/** Transforms a depth image into a point cloud in which every point carries the color of the matching color pixel.
  *
- * \param source_point2d
- * The 2D pixel in \p source_camera coordinates.
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param source_depth_mm
- * The depth of \p source_point2d in millimeters. One way to derive the depth value in the color camera geometry is to
- * use the function k4a_transformation_depth_image_to_color_camera().
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param source_camera
- * The current camera.
+ * \param color_image
+ * Handle to input color image.
  *
- * \param target_camera
- * The target camera.
+ * \param colored_xyz_image
+ * Handle to output colored xyz image.
  *
- * \param target_point3d_mm
- * Pointer to the output where the 3D coordinates of the input pixel in the coordinate system of \p target_camera is
- * stored in millimeters.
+ * \remarks
+ * This function produces the same points as k4a_transformation_depth_image_to_point_cloud() with
+ * ::K4A_CALIBRATION_TYPE_DEPTH and the same colors as k4a_transformation_color_image_to_depth_camera(), in a single
+ * pass over \p depth_image and without writing either intermediate image. It always runs on the CPU.
  *
- * \param valid
- * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate, and will return 0 if
- * the coordinate is not valid in the calibration model.
+ * \remarks
+ * \p depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16 and \p color_image must be of format
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32. The width and height of \p depth_image must match the depth mode and the width and
+ * height of \p color_image must match the color resolution that were used to create \p transformation_handle.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p target_point3d_mm was successfully written. ::K4A_RESULT_FAILED if \p calibration
- * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
- * the transformation was computed, but the results in \p target_point3d_mm are outside of the range of valid
- * calibration and should be ignored.
+ * \remarks
+ * The format of \p colored_xyz_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p colored_xyz_image
+ * must match the width and height of \p depth_image. \p colored_xyz_image must have a stride in bytes of 10 times its
+ * width in pixels.
  *
  * \remarks
- * This function applies the intrinsic calibration of \p source_camera to compute the 3D ray from the focal point of the
- * camera through pixel \p source_point2d. The 3D point on this ray is then found using \p source_depth_mm. If \p
- * target_camera is different from \p source_camera, the 3D point is transformed to \p target_camera using
- * k4a_calibration_3d_to_3d(). In practice, \p source_camera and \p target_camera will often be identical. In this
- * case, no 3D to 3D transformation is applied.
+ * Each pixel of the \p colored_xyz_image consists of three int16_t values followed by four uint8_t values, totaling 10
+ * bytes. The three int16_t values are the X, Y, and Z values of the point in the depth camera coordinate system. The
+ * four uint8_t values are the B, G, R, and A values of the color of the point. A color of (0,0,0,0) marks a point
+ * that is not visible in \p color_image.
  *
  * \remarks
- * If \p source_point2d is not considered as valid pixel coordinate
- * according to the intrinsic camera model, \p valid is set to 0. If it is valid, \p valid will be set to 1. The user
- * should not use the value of \p target_point3d_mm if \p valid was set to 0.
+ * \p colored_xyz_image should be created by the caller using k4a_image_create() or k4a_image_create_from_buffer().
  *
- * \relates k4a_calibration_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p colored_xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1806,53 +5020,51 @@ K4A_EXPORT k4a_result_t k4a_calibration_3d_to_3d(const k4a_calibration_t *calibr
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_2d_to_3d(const k4a_calibration_t *calibration,
-                                                 const k4a_float2_t *source_point2d,
-                                                 const float source_depth_mm,
-                                                 const k4a_calibration_type_t source_camera,
-                                                 const k4a_calibration_type_t target_camera,
-                                                 k4a_float3_t *target_point3d_mm,
-                                                 int *valid);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                      const k4a_image_t depth_image,
+                                                      const k4a_image_t color_image,
+                                                      k4a_image_t colored_xyz_image);
 
-/** Transform a 3D point of a source coordinate system into a 2D pixel coordinate of the target camera.
+/** Transforms a depth image into a point cloud of the given point format.
  *
- * \param calibration
- * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param source_point3d_mm
- * The 3D coordinates in millimeters representing a point in \p source_camera
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param source_camera
- * The current camera.
+ * \param camera
+ * Geometry in which depth map was computed.
  *
- * \param target_camera
- * The target camera.
+ * \param point_cloud_format
+ * Format of the points written to \p xyz_image.
  *
- * \param target_point2d
- * Pointer to the output where the 2D pixel in \p target_camera coordinates is stored.
+ * \param xyz_image
+ * Handle to output xyz image.
  *
- * \param valid
- * The output parameter returns a value of 1 if the \p source_point3d_mm is a valid coordinate in the \p target_camera
- * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ * \remarks
+ * This function behaves like k4a_transformation_depth_image_to_point_cloud(), which is the same as calling it with
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
- * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
- * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
- * and should be ignored.
+ * \remarks
+ * The format of \p xyz_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p xyz_image must match the
+ * width and height of \p depth_image. \p xyz_image must have a stride in bytes of 6 times its width in pixels for
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS and of 12 times its width in pixels for
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS.
  *
  * \remarks
- * If \p target_camera is different from \p source_camera, \p source_point3d_mm is transformed to \p target_camera using
- * k4a_calibration_3d_to_3d(). In practice, \p source_camera and \p target_camera will often be identical. In this
- * case, no 3D to 3D transformation is applied. The 3D point in the coordinate system of \p target_camera is then
- * projected onto the image plane using the intrinsic calibration of \p target_camera.
+ * With ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS each pixel of the \p xyz_image consists of three float
+ * values, totaling 12 bytes. The three float values are the X, Y, and Z values of the point in meters. Pixels without
+ * a valid point are (0,0,0).
  *
  * \remarks
- * If \p source_point3d_mm does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is
- * set to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p
- * valid was set to 0.
+ * \p xyz_image should be created by the caller using k4a_image_create() or k4a_image_create_from_buffer().
  *
- * \relates k4a_calibration_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1862,60 +5074,60 @@ K4A_EXPORT k4a_result_t k4a_calibration_2d_to_3d(const k4a_calibration_t *calibr
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_3d_to_2d(const k4a_calibration_t *calibration,
-                                                 const k4a_float3_t *source_point3d_mm,
-                                                 const k4a_calibration_type_t source_camera,
-                                                 const k4a_calibration_type_t target_camera,
-                                                 k4a_float2_t *target_point2d,
-                                                 int *valid);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_point_cloud_with_format(k4a_transformation_t transformation_handle,
+                                                          const k4a_image_t depth_image,
+                                                          const k4a_calibration_type_t camera,
+                                                          k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                          k4a_image_t xyz_image);
 
-/** Transform a 2D pixel coordinate with an associated depth value of the source camera into a 2D pixel coordinate of
- * the target camera.
+/** Transforms a depth image into a compact point cloud that only holds the valid points.
  *
- * \param calibration
- * Location to read the camera calibration obtained by k4a_device_get_calibration().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \param source_point2d
- * The 2D pixel in \p source_camera coordinates.
+ * \param depth_image
+ * Handle to input depth image.
  *
- * \param source_depth_mm
- * The depth of \p source_point2d in millimeters. One way to derive the depth value in the color camera geometry is to
- * use the function k4a_transformation_depth_image_to_color_camera().
+ * \param camera
+ * Geometry in which depth map was computed.
  *
- * \param source_camera
- * The current camera.
+ * \param point_cloud_format
+ * Format of the points written to \p xyz_image.
  *
- * \param target_camera
- * The target camera.
+ * \param xyz_image
+ * Handle to output xyz image.
  *
- * \param target_point2d
- * The 2D pixel in \p target_camera coordinates.
+ * \param index_image
+ * Handle to output index image. May be NULL.
  *
- * \param valid
- * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate in the \p target_camera
- * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ * \param point_count
+ * Location to write the number of points written to \p xyz_image.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
- * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
- * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
- * and should be ignored.
+ * \remarks
+ * A point is valid if its pixel in \p depth_image has a non zero depth and a valid unprojection in \p camera. The
+ * valid points are written one after the other from the start of \p xyz_image in row major pixel order, with the
+ * same values k4a_transformation_depth_image_to_point_cloud_with_format() writes for them. The content of
+ * \p xyz_image after the last point is undefined.
  *
  * \remarks
- * This function maps a pixel between the coordinate systems of the depth and color cameras. It is equivalent to calling
- * k4a_calibration_2d_to_3d() to compute the 3D point corresponding to \p source_point2d and then using
- * k4a_calibration_3d_to_2d() to map the 3D point into the coordinate system of the \p target_camera.
+ * \p xyz_image must be able to hold one point for every pixel of \p depth_image, so its format, width, height and
+ * stride are the same as for k4a_transformation_depth_image_to_point_cloud_with_format().
  *
  * \remarks
- * If \p source_camera and \p target_camera are identical, the function immediately sets \p target_point2d to \p
- * source_point2d and returns without computing any transformations.
+ * If \p index_image is not NULL, the index of the depth pixel of every point, computed as y times the width plus x, is
+ * written to it as one uint32_t per point. The format of \p index_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width
+ * and height of \p index_image must match the width and height of \p depth_image, and \p index_image must have a
+ * stride in bytes of 4 times its width in pixels.
  *
  * \remarks
- * If \p source_point2d does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is set
- * to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p valid
- * was set to 0.
+ * \p xyz_image and \p index_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
  *
- * \relates k4a_calibration_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1925,52 +5137,57 @@ K4A_EXPORT k4a_result_t k4a_calibration_3d_to_2d(const k4a_calibration_t *calibr
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibration,
-                                                 const k4a_float2_t *source_point2d,
-                                                 const float source_depth_mm,
-                                                 const k4a_calibration_type_t source_camera,
-                                                 const k4a_calibration_type_t target_camera,
-                                                 k4a_float2_t *target_point2d,
-                                                 int *valid);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_compact_point_cloud(k4a_transformation_t transformation_handle,
+                                                      const k4a_image_t depth_image,
+                                                      const k4a_calibration_type_t camera,
+                                                      k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                      k4a_image_t xyz_image,
+                                                      k4a_image_t index_image,
+                                                      size_t *point_count);
 
-/** Transform a 2D pixel coordinate from color camera into a 2D pixel coordinate of
- * the depth camera.
- *
- * \param calibration
- * Location to read the camera calibration obtained by k4a_device_get_calibration().
+/** Transforms a depth image into a point cloud and the normals of its points.
  *
- * \param source_point2d
- * The 2D pixel in \p color camera coordinates.
+ * \param transformation_handle
+ * Transformation handle.
  *
  * \param depth_image
  * Handle to input depth image.
  *
- * \param target_point2d
- * The 2D pixel in \p depth camera coordinates.
+ * \param camera
+ * Geometry in which depth map was computed.
  *
- * \param valid
- * The output parameter returns a value of 1 if the \p source_point2d is a valid coordinate in the \p target_camera
- * coordinate system, and will return 0 if the coordinate is not valid in the calibration model.
+ * \param xyz_image
+ * Handle to output xyz image.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p target_point2d was successfully written. ::K4A_RESULT_FAILED if \p calibration
- * contained invalid transformation parameters. If the function returns ::K4A_RESULT_SUCCEEDED, but \p valid is 0,
- * the transformation was computed, but the results in \p target_point2d are outside of the range of valid calibration
- * and should be ignored.
+ * \param normal_image
+ * Handle to output normal image.
+ *
+ * \remarks
+ * \p xyz_image receives the same points as k4a_transformation_depth_image_to_point_cloud_with_format() writes with
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS, and its format, width, height and stride are the same. The
+ * points and the normals are computed in a single pass over \p depth_image. It always runs on the CPU.
+ *
+ * \remarks
+ * The normal of a pixel is the cross product of the differences of the points of the pixels below and above it, and
+ * to the right and left of it. Each pixel of \p normal_image consists of three float values, the X, Y and Z values of
+ * a normal of unit length that points towards the camera. Pixels on the border of the image, pixels without a point
+ * and pixels with one of those four neighbors without a point have a normal of (0,0,0).
  *
  * \remarks
- * This function represents an alternative to k4a_calibration_2d_to_2d() if the number of pixels that need to be
- * transformed is small. This function searches along an epipolar line in the depth image to find the corresponding
- * depth pixel. If a larger number of pixels need to be transformed, it might be computationally cheaper to call
- * k4a_transformation_depth_image_to_color_camera() to get correspondence depth values for these color pixels, then call
- * the function k4a_calibration_2d_to_2d().
+ * The format of \p normal_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p normal_image must match
+ * the width and height of \p depth_image, and \p normal_image must have a stride in bytes of 12 times its width in
+ * pixels.
  *
  * \remarks
- * If \p source_point2d does not map to a valid 2D coordinate in the \p target_camera coordinate system, \p valid is set
- * to 0. If it is valid, \p valid will be set to 1. The user should not use the value of \p target_point2d if \p valid
- * was set to 0.
+ * \p xyz_image and \p normal_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
  *
- * \relates k4a_calibration_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xyz_image and \p normal_image were successfully written and ::K4A_RESULT_FAILED
+ * otherwise.
+ *
+ * \relates k4a_transformation_t
  *
  * \xmlonly
  * <requirements>
@@ -1980,44 +5197,64 @@ K4A_EXPORT k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibr
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_calibration_color_2d_to_depth_2d(const k4a_calibration_t *calibration,
-                                                             const k4a_float2_t *source_point2d,
-                                                             const k4a_image_t depth_image,
-                                                             k4a_float2_t *target_point2d,
-                                                             int *valid);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_point_cloud_with_normals(k4a_transformation_t transformation_handle,
+                                                           const k4a_image_t depth_image,
+                                                           const k4a_calibration_type_t camera,
+                                                           k4a_image_t xyz_image,
+                                                           k4a_image_t normal_image);
 
-/** Get handle to transformation handle.
+/** Transforms a depth image into a point cloud downsampled to one point per voxel.
  *
- * \param calibration
- * A calibration structure obtained by k4a_device_get_calibration().
+ * \param transformation_handle
+ * Transformation handle.
  *
- * \returns
- * A transformation handle. A NULL is returned if creation fails.
+ * \param depth_image
+ * Handle to input depth image.
+ *
+ * \param camera
+ * Geometry in which depth map was computed.
+ *
+ * \param voxel_size
+ * Edge length of the voxels in meters, larger than 0.
+ *
+ * \param xyz_image
+ * Handle to output xyz image.
+ *
+ * \param normal_image
+ * Handle to output normal image. May be NULL.
+ *
+ * \param point_count
+ * Location to write the number of points written to \p xyz_image.
  *
  * \remarks
- * The transformation handle is used to transform images from the coordinate system of one camera into the other. Each
- * transformation handle requires some pre-computed resources to be allocated, which are retained until the handle is
- * destroyed.
+ * Space is divided into cubic voxels of \p voxel_size meters, aligned with the origin of \p camera. Every voxel that
+ * holds one of the points k4a_transformation_depth_image_to_point_cloud_with_format() computes with
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS is written to \p xyz_image as the centroid of its points, in
+ * meters. The voxels are written one after the other from the start of \p xyz_image, in the row major order of the
+ * first depth pixel of each voxel. The content of \p xyz_image after the last point is undefined.
  *
  * \remarks
- * The transformation handle must be destroyed with k4a_transformation_destroy() when it is no longer to be used.
+ * The points are added to a hash grid as the rows of \p depth_image are transformed, so the organized point cloud is
+ * never written out. It always runs on the CPU.
  *
- * \relates k4a_calibration_t
+ * \remarks
+ * \p xyz_image must be able to hold one point for every pixel of \p depth_image, so its format, width, height and
+ * stride are the same as for k4a_transformation_depth_image_to_point_cloud_with_format() with
+ * ::K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS.
  *
- * \xmlonly
- * <requirements>
- *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
- *   <requirement name="Library">k4a.lib</requirement>
- *   <requirement name="DLL">k4a.dll</requirement>
- * </requirements>
- * \endxmlonly
- */
-K4A_EXPORT k4a_transformation_t k4a_transformation_create(const k4a_calibration_t *calibration);
-
-/** Destroy transformation handle.
+ * \remarks
+ * If \p normal_image is not NULL, the normal of every voxel is written to it as three float values at the index of its
+ * point. It is the normalized sum of the normals k4a_transformation_depth_image_to_point_cloud_with_normals() computes
+ * for the points of the voxel, or (0,0,0) if none of them has a normal. The format, width, height and stride of
+ * \p normal_image are the same as for k4a_transformation_depth_image_to_point_cloud_with_normals().
  *
- * \param transformation_handle
- * Transformation handle to destroy.
+ * \remarks
+ * \p xyz_image and \p normal_image should be created by the caller using k4a_image_create() or
+ * k4a_image_create_from_buffer().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
  *
  * \relates k4a_transformation_t
  *
@@ -2029,39 +5266,51 @@ K4A_EXPORT k4a_transformation_t k4a_transformation_create(const k4a_calibration_
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT void k4a_transformation_destroy(k4a_transformation_t transformation_handle);
+K4A_EXPORT k4a_result_t
+k4a_transformation_depth_image_to_voxel_point_cloud(k4a_transformation_t transformation_handle,
+                                                    const k4a_image_t depth_image,
+                                                    const k4a_calibration_type_t camera,
+                                                    float voxel_size,
+                                                    k4a_image_t xyz_image,
+                                                    k4a_image_t normal_image,
+                                                    size_t *point_count);
 
-/** Transforms the depth map into the geometry of the color camera.
+/** Submits transformation jobs that run asynchronously of the caller.
  *
  * \param transformation_handle
  * Transformation handle.
  *
- * \param depth_image
- * Handle to input depth image.
+ * \param jobs
+ * Array of \p job_count jobs. Each job names the transformation it runs and holds the images and parameters of the
+ * synchronous function of that transformation, see ::k4a_transformation_job_t.
  *
- * \param transformed_depth_image
- * Handle to output transformed depth image.
+ * \param job_count
+ * Number of jobs in \p jobs, at least 1.
  *
- * \remarks
- * This produces a depth image for which each pixel matches the corresponding pixel coordinates of the color camera.
+ * \param callback
+ * Callback that is called once all jobs of this submission completed, or NULL.
  *
- * \remarks
- * \p depth_image and \p transformed_depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
+ * \param callback_context
+ * Context passed to \p callback.
  *
  * \remarks
- * \p transformed_depth_image must have a width and height matching the width and height of the color camera in the mode
- * specified by the \ref k4a_calibration_t used to create the \p transformation_handle with k4a_transformation_create().
+ * The function returns once the jobs are queued. A worker thread of the transformation handle runs the submissions in
+ * the order they were submitted, and the jobs of a submission one after the other, so submitting the jobs of several
+ * captures at once keeps a GPU accelerated handle busy without waking the worker thread for every frame.
  *
  * \remarks
- * The contents \p transformed_depth_image will be filled with the depth values derived from \p depth_image in the color
- * camera's coordinate space.
+ * The jobs are copied and the SDK holds a reference to each of their images until \p callback returned, so the
+ * caller may release its references right after submitting. The content of the output images is undefined until the
+ * submission completed.
  *
  * \remarks
- * \p transformed_depth_image should be created by the caller using k4a_image_create() or
- * k4a_image_create_from_buffer().
+ * The jobs run with the settings of the handle at the time they run. Do not change the region of interest or other
+ * settings of the handle while submissions are pending, call k4a_transformation_wait_idle() first.
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ * ::K4A_RESULT_SUCCEEDED if the jobs were queued. ::K4A_RESULT_FAILED if a job lacks an image its type requires or the
+ * jobs could not be queued, in which case \p callback is not called. Failures of the transformations themselves are
+ * reported to \p callback.
  *
  * \relates k4a_transformation_t
  *
@@ -2073,77 +5322,116 @@ K4A_EXPORT void k4a_transformation_destroy(k4a_transformation_t transformation_h
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_color_camera(k4a_transformation_t transformation_handle,
-                                                                       const k4a_image_t depth_image,
-                                                                       k4a_image_t transformed_depth_image);
+K4A_EXPORT k4a_result_t k4a_transformation_submit(k4a_transformation_t transformation_handle,
+                                                  const k4a_transformation_job_t *jobs,
+                                                  size_t job_count,
+                                                  k4a_transformation_completion_cb_t *callback,
+                                                  void *callback_context);
 
-/** Transforms depth map and a custom image into the geometry of the color camera.
+/** Waits for all jobs submitted with k4a_transformation_submit() to complete.
  *
  * \param transformation_handle
  * Transformation handle.
  *
- * \param depth_image
- * Handle to input depth image.
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the jobs. If set to 0, the function will
+ * return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until the jobs completed.
  *
- * \param custom_image
- * Handle to input custom image.
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if no submission is pending, which includes the callbacks of all submissions having
+ * returned. ::K4A_WAIT_RESULT_TIMEOUT if submissions are still pending after \p timeout_in_ms.
+ * ::K4A_WAIT_RESULT_FAILED if the wait failed.
  *
- * \param transformed_depth_image
- * Handle to output transformed depth image.
+ * \remarks
+ * Must not be called from a k4a_transformation_completion_cb_t callback.
  *
- * \param transformed_custom_image
- * Handle to output transformed custom image.
+ * \relates k4a_transformation_t
  *
- * \param interpolation_type
- * Parameter that controls how pixels in \p custom_image should be interpolated when transformed to color camera space.
- * K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR if linear interpolation should be used.
- * K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST if nearest neighbor interpolation should be used.
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_wait_result_t k4a_transformation_wait_idle(k4a_transformation_t transformation_handle,
+                                                          int32_t timeout_in_ms);
+
+/** Creates a map that undistorts or rectifies the images of a camera.
  *
- * \param invalid_custom_value
- * Defines the custom image pixel value that should be written to \p transformed_custom_image in case the corresponding
- * depth pixel can not be transformed into the color camera space.
+ * \param calibration
+ * Camera calibration, as for k4a_transformation_create().
  *
- * \remarks
- * This produces a depth image and a corresponding custom image for which each pixel matches the corresponding
- * pixel coordinates of the color camera.
+ * \param camera
+ * ::K4A_CALIBRATION_TYPE_DEPTH or ::K4A_CALIBRATION_TYPE_COLOR, the camera whose images are remapped.
  *
- * \remarks
- * \p depth_image and \p transformed_depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
+ * \param target
+ * Pinhole camera without distortion of the remapped images. NULL keeps the resolution, focal length and principal point
+ * of \p camera and only removes its distortion.
  *
- * \remarks
- * \p custom_image and \p transformed_custom_image must be of format ::K4A_IMAGE_FORMAT_CUSTOM8 or
- * ::K4A_IMAGE_FORMAT_CUSTOM16.
+ * \param rotation
+ * Row major 3x3 rotation from the target camera to \p camera, for example the rectifying rotation of a stereo pair.
+ * NULL for none.
  *
- * \remarks
- * \p transformed_depth_image and \p transformed_custom_image must have a width and height matching the width and
- * height of the color camera in the mode specified by the \ref k4a_calibration_t used to create the
- * \p transformation_handle with k4a_transformation_create().
+ * \param thread_count
+ * Number of threads each k4a_undistortion_map_remap() is split across, at most 16. 0 or 1 remaps on the calling
+ * thread only.
  *
- * \remarks
- * \p custom_image must have a width and height matching the width and height of \p depth_image.
+ * \param map_handle
+ * Location to write the handle.
  *
- * \remarks
- * The contents \p transformed_depth_image will be filled with the depth values derived from \p depth_image in the color
- * camera's coordinate space.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the map was created, ::K4A_RESULT_FAILED otherwise.
  *
  * \remarks
- * The contents \p transformed_custom_image will be filled with the values derived from \p custom_image in the color
- * camera's coordinate space.
+ * The map stores for every target pixel the pixel of \p camera its ray projects to, computed once with the vectorized
+ * projection of k4a_calibration_3d_to_2d_batch(). Remapping an image then only reads the source pixels, instead of
+ * calling k4a_calibration_3d_to_2d() for every pixel of every image.
  *
- * \remarks
- * \p transformed_depth_image and \p transformed_custom_image should be created by the caller using k4a_image_create()
- * or k4a_image_create_from_buffer().
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_undistortion_map_create(const k4a_calibration_t *calibration,
+                                                    k4a_calibration_type_t camera,
+                                                    const k4a_pinhole_t *target,
+                                                    const float *rotation,
+                                                    uint32_t thread_count,
+                                                    k4a_undistortion_map_t *map_handle);
+
+/** Remaps an image with an undistortion map.
  *
- * \remarks
- * Using ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR for \p interpolation_type could create new values to \p
- * transformed_custom_image which do no exist in \p custom_image. Using ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST
- * will prevent this from happenning but will result in a less smooth image.
+ * \param map_handle
+ * Handle obtained by k4a_undistortion_map_create().
+ *
+ * \param source_image
+ * Image of the camera of the map, of format ::K4A_IMAGE_FORMAT_DEPTH16, ::K4A_IMAGE_FORMAT_IR16 or
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32 and the resolution of the camera.
+ *
+ * \param destination_image
+ * Image of the format of \p source_image and the resolution of the target of the map.
+ *
+ * \param interpolation_type
+ * ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST copies the closest source pixel.
+ * ::K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR interpolates the four closest source pixels.
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED if \p transformed_depth_image and \p transformed_custom_image were successfully written and
- * ::K4A_RESULT_FAILED otherwise.
+ * ::K4A_RESULT_SUCCEEDED if \p destination_image was written, ::K4A_RESULT_FAILED otherwise.
  *
- * \relates k4a_transformation_t
+ * \remarks
+ * Pixels of \p destination_image without a source pixel are set to 0. Bilinear interpolation of a depth image writes
+ * 0 where one of the weighted source pixels is 0, so depth is never blended with pixels without depth. The rows of
+ * both images may be padded.
+ *
+ * \remarks
+ * Calls with the same map must not overlap. Use one map per thread to remap images concurrently.
+ *
+ * \relates k4a_undistortion_map_t
  *
  * \xmlonly
  * <requirements>
@@ -2153,53 +5441,75 @@ K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_color_camera(k4a_trans
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t
-k4a_transformation_depth_image_to_color_camera_custom(k4a_transformation_t transformation_handle,
-                                                      const k4a_image_t depth_image,
-                                                      const k4a_image_t custom_image,
-                                                      k4a_image_t transformed_depth_image,
-                                                      k4a_image_t transformed_custom_image,
-                                                      k4a_transformation_interpolation_type_t interpolation_type,
-                                                      uint32_t invalid_custom_value);
+K4A_EXPORT k4a_result_t k4a_undistortion_map_remap(k4a_undistortion_map_t map_handle,
+                                                   const k4a_image_t source_image,
+                                                   k4a_image_t destination_image,
+                                                   k4a_transformation_interpolation_type_t interpolation_type);
 
-/** Transforms a color image into the geometry of the depth camera.
+/** Destroys an undistortion map.
  *
- * \param transformation_handle
- * Transformation handle.
+ * \param map_handle
+ * Handle obtained by k4a_undistortion_map_create().
  *
- * \param depth_image
- * Handle to input depth image.
+ * \relates k4a_undistortion_map_t
  *
- * \param color_image
- * Handle to input color image.
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT void k4a_undistortion_map_destroy(k4a_undistortion_map_t map_handle);
+
+/** Creates a converter of images to the input tensors of neural networks.
  *
- * \param transformed_color_image
- * Handle to output transformed color image.
+ * \param config
+ * Format and resolution of the images, resolution and element type of the tensors and the normalization of the values.
  *
- * \remarks
- * This produces a color image for which each pixel matches the corresponding pixel coordinates of the depth camera.
+ * \param thread_count
+ * Number of threads each k4a_tensor_converter_convert() is split across, at most 16. 0 or 1 converts on the calling
+ * thread only.
  *
- * \remarks
- * \p depth_image and \p color_image need to represent the same moment in time. The depth data will be applied to the
- * color image to properly warp the color data to the perspective of the depth camera.
+ * \param converter_handle
+ * Location to write the handle.
  *
- * \remarks
- * \p depth_image must be of type ::K4A_IMAGE_FORMAT_DEPTH16. \p color_image must be of format
- * ::K4A_IMAGE_FORMAT_COLOR_BGRA32.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the converter was created, ::K4A_RESULT_FAILED otherwise.
  *
  * \remarks
- * \p transformed_color_image image must be of format ::K4A_IMAGE_FORMAT_COLOR_BGRA32. \p transformed_color_image must
- * have the width and height of the depth camera in the mode specified by the \ref k4a_calibration_t used to create
- * the \p transformation_handle with k4a_transformation_create().
+ * The converter writes the 1 x C x H x W tensor of an image in one pass: it drops alpha, reorders the color channels,
+ * resizes the image to the tensor, normalizes each value and converts it to the element type of the tensor. C is 3 for
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32 images and 1 for ::K4A_IMAGE_FORMAT_DEPTH16 and ::K4A_IMAGE_FORMAT_IR16 images.
  *
  * \remarks
- * \p transformed_color_image should be created by the caller using k4a_image_create() or
- * k4a_image_create_from_buffer().
+ * Tensor pixels are mapped to the image by their centers. Color and IR images are resized bilinearly and depth images
+ * with the nearest pixel, so depth is never blended with pixels without depth. The depth image written by
+ * k4a_transformation_depth_image_to_color_camera() is converted like any DEPTH16 image of the color resolution, so the
+ * color and depth tensors of a capture are aligned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_tensor_converter_create(const k4a_tensor_configuration_t *config,
+                                                    uint32_t thread_count,
+                                                    k4a_tensor_converter_t *converter_handle);
+
+/** Gets the size of the tensors written by a converter.
+ *
+ * \param converter_handle
+ * Handle obtained by k4a_tensor_converter_create().
  *
  * \returns
- * ::K4A_RESULT_SUCCEEDED if \p transformed_color_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ * The size of a tensor in bytes, 0 if \p converter_handle is invalid.
  *
- * \relates k4a_transformation_t
+ * \relates k4a_tensor_converter_t
  *
  * \xmlonly
  * <requirements>
@@ -2209,50 +5519,53 @@ k4a_transformation_depth_image_to_color_camera_custom(k4a_transformation_t trans
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
-                                                                       const k4a_image_t depth_image,
-                                                                       const k4a_image_t color_image,
-                                                                       k4a_image_t transformed_color_image);
+K4A_EXPORT size_t k4a_tensor_converter_get_size(k4a_tensor_converter_t converter_handle);
 
-/** Transforms the depth image into a single image with voxels representing
- * X, Y and Z-coordinates in millimeters of corresponding 3D points.
+/** Converts an image to a tensor.
  *
- * \param transformation_handle
- * Transformation handle.
+ * \param converter_handle
+ * Handle obtained by k4a_tensor_converter_create().
  *
- * \param depth_image
- * Handle to input depth image.
+ * \param image
+ * Image of the format and resolution of the configuration of the converter. Its rows may be padded.
  *
- * \param camera
- * Geometry in which depth map was computed.
+ * \param tensor
+ * Buffer receiving the tensor, planes of H rows of W elements, one plane per channel.
  *
- * \param xyz_image
- * Handle to output xyz image.
+ * \param tensor_size
+ * Size of \p tensor in bytes, at least k4a_tensor_converter_get_size().
  *
- * \remarks
- * \p depth_image must be of format ::K4A_IMAGE_FORMAT_DEPTH16.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p tensor was written, ::K4A_RESULT_FAILED otherwise.
  *
  * \remarks
- * The \p camera parameter tells the function what the perspective of the \p depth_image is. If the \p depth_image was
- * captured directly from the depth camera, the value should be ::K4A_CALIBRATION_TYPE_DEPTH. If the \p depth_image is
- * the result of a transformation into the color camera's coordinate space using
- * k4a_transformation_depth_image_to_color_camera(), the value should be ::K4A_CALIBRATION_TYPE_COLOR.
+ * The tensor is written to memory of the caller, so it can be written directly to a buffer the inference runtime
+ * reads from, such as page-locked memory for a copy to a GPU.
  *
  * \remarks
- * The format of \p xyz_image must be ::K4A_IMAGE_FORMAT_CUSTOM. The width and height of \p xyz_image must match the
- * width and height of \p depth_image. \p xyz_image must have a stride in bytes of at least 6 times its width in pixels.
+ * Calls with the same converter must not overlap. Use one converter per thread to convert images concurrently.
  *
- * \remarks
- * Each pixel of the \p xyz_image consists of three int16_t values, totaling 6 bytes. The three int16_t values are the
- * X, Y, and Z values of the point.
+ * \relates k4a_tensor_converter_t
  *
- * \remarks
- * \p xyz_image should be created by the caller using k4a_image_create() or k4a_image_create_from_buffer().
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_tensor_converter_convert(k4a_tensor_converter_t converter_handle,
+                                                     const k4a_image_t image,
+                                                     void *tensor,
+                                                     size_t tensor_size);
+
+/** Destroys a tensor converter.
  *
- * \returns
- * ::K4A_RESULT_SUCCEEDED if \p xyz_image was successfully written and ::K4A_RESULT_FAILED otherwise.
+ * \param converter_handle
+ * Handle obtained by k4a_tensor_converter_create().
  *
- * \relates k4a_transformation_t
+ * \relates k4a_tensor_converter_t
  *
  * \xmlonly
  * <requirements>
@@ -2262,10 +5575,7 @@ K4A_EXPORT k4a_result_t k4a_transformation_color_image_to_depth_camera(k4a_trans
  * </requirements>
  * \endxmlonly
  */
-K4A_EXPORT k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
-                                                                      const k4a_image_t depth_image,
-                                                                      const k4a_calibration_type_t camera,
-                                                                      k4a_image_t xyz_image);
+K4A_EXPORT void k4a_tensor_converter_destroy(k4a_tensor_converter_t converter_handle);
 
 /**
  * @}
@@ -10,9 +10,12 @@
 #include "k4a.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -258,6 +261,22 @@ public:
         return image(handle);
     }
 
+    /** Create an image of a rectangle of this image, sharing its buffer
+     * Throws error on failure
+     *
+     * \sa k4a_image_create_view
+     */
+    image create_view(int x, int y, int width_pixels, int height_pixels) const
+    {
+        k4a_image_t handle = nullptr;
+        k4a_result_t result = k4a_image_create_view(m_handle, x, y, width_pixels, height_pixels, &handle);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to create image view!");
+        }
+        return image(handle);
+    }
+
     /** Get the image buffer
      *
      * \sa k4a_image_get_buffer
@@ -339,6 +358,33 @@ public:
         return std::chrono::nanoseconds(k4a_image_get_system_timestamp_nsec(m_handle));
     }
 
+    /** Get the GPU resource the depth engine exported the image to, returns false if the image has none
+     *
+     * \sa k4a_image_get_gpu_resource
+     */
+    bool get_gpu_resource(k4a_gpu_resource_t *resource) const noexcept
+    {
+        return K4A_RESULT_SUCCEEDED == k4a_image_get_gpu_resource(m_handle, resource);
+    }
+
+    /** Get the statistics of the valid pixels of a depth image, returns false if the image has none
+     *
+     * \sa k4a_image_get_depth_statistics
+     */
+    bool get_depth_statistics(k4a_depth_statistics_t *statistics) const noexcept
+    {
+        return K4A_RESULT_SUCCEEDED == k4a_image_get_depth_statistics(m_handle, statistics);
+    }
+
+    /** Get the time the depth engine took to produce the image, 0 for images it didn't produce
+     *
+     * \sa k4a_image_get_compute_time_usec
+     */
+    std::chrono::microseconds get_compute_time() const noexcept
+    {
+        return std::chrono::microseconds(k4a_image_get_compute_time_usec(m_handle));
+    }
+
     /** Get the image exposure time in microseconds
      *
      * \sa k4a_image_get_exposure_usec
@@ -545,6 +591,19 @@ public:
         }
     }
 
+    /** Releases the underlying k4a_capture_t and recycles its memory; the capture is set to invalid.
+     *
+     * \sa k4a_capture_recycle
+     */
+    void recycle() noexcept
+    {
+        if (m_handle != nullptr)
+        {
+            k4a_capture_recycle(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
     /** Get the color image associated with the capture
      *
      * \sa k4a_capture_get_color_image
@@ -617,6 +676,41 @@ public:
         return k4a_capture_get_temperature_c(m_handle);
     }
 
+    /** Get the system time (in nanoseconds) the capture finished a stage of the depth capture pipeline.
+     *
+     * \sa k4a_capture_get_latency_timestamp_nsec
+     */
+    std::chrono::nanoseconds get_latency_timestamp(k4a_latency_stage_t stage) const noexcept
+    {
+        return std::chrono::nanoseconds(k4a_capture_get_latency_timestamp_nsec(m_handle, stage));
+    }
+
+    /** Get the IMU samples taken during the exposure of the capture.
+     * Throws error on failure.
+     *
+     * \sa k4a_capture_get_imu_samples
+     */
+    std::vector<k4a_imu_sample_t> get_imu_samples() const
+    {
+        std::vector<k4a_imu_sample_t> samples;
+        size_t count = 0;
+        k4a_buffer_result_t result = k4a_capture_get_imu_samples(m_handle, nullptr, &count);
+
+        if (result == K4A_BUFFER_RESULT_TOO_SMALL)
+        {
+            samples.resize(count);
+            result = k4a_capture_get_imu_samples(m_handle, samples.data(), &count);
+        }
+
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            throw error("Failed to read IMU samples from capture!");
+        }
+
+        samples.resize(count);
+        return samples;
+    }
+
     /** Create an empty capture object.
      * Throws error on failure.
      *
@@ -712,6 +806,53 @@ struct calibration : public k4a_calibration_t
         return static_cast<bool>(valid);
     }
 
+    /** Transform an array of 2d pixel coordinates with associated depth values of the source camera into 3d points of
+     * the target coordinate system. Each element of valid is set to 0 if the corresponding point is invalid in the
+     * target coordinate system (and therefore the corresponding element of target_points3d should not be used)
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_2d_to_3d_batch
+     */
+    void convert_2d_to_3d(const k4a_float2_t *source_points2d,
+                          const float *source_depths,
+                          size_t point_count,
+                          k4a_calibration_type_t source_camera,
+                          k4a_calibration_type_t target_camera,
+                          k4a_float3_t *target_points3d,
+                          int *valid) const
+    {
+        k4a_result_t result = k4a_calibration_2d_to_3d_batch(
+            this, source_points2d, source_depths, point_count, source_camera, target_camera, target_points3d, valid);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
+    /** Transform an array of 3d points of a source coordinate system into 2d pixel coordinates of the target camera.
+     * Each element of valid is set to 0 if the corresponding point is invalid in the target coordinate system (and
+     * therefore the corresponding element of target_points2d should not be used)
+     * Throws error if calibration contains invalid data.
+     *
+     * \sa k4a_calibration_3d_to_2d_batch
+     */
+    void convert_3d_to_2d(const k4a_float3_t *source_points3d,
+                          size_t point_count,
+                          k4a_calibration_type_t source_camera,
+                          k4a_calibration_type_t target_camera,
+                          k4a_float2_t *target_points2d,
+                          int *valid) const
+    {
+        k4a_result_t result = k4a_calibration_3d_to_2d_batch(
+            this, source_points3d, point_count, source_camera, target_camera, target_points2d, valid);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Calibration contained invalid transformation parameters!");
+        }
+    }
+
     /** Transform a 2d pixel coordinate with an associated depth value of the source camera into a 2d pixel coordinate
      * of the target camera
      * Returns false if the point is invalid in the target coordinate system (and therefore target_point2d should not be
@@ -815,10 +956,159 @@ struct calibration : public k4a_calibration_t
     }
 };
 
+namespace internal
+{
+/// @cond FALSE
+/** Recycles the buffers of images that are created over and over with the same size
+ *
+ * \remarks
+ * Each image created by the pool holds a reference on the pool. Its buffer goes back to the pool when the last
+ * reference to the image is released, or is freed if the pool already holds enough free buffers. The free buffers are
+ * freed with the pool, once the owner and all images are gone.
+ */
+class image_pool
+{
+public:
+    image_pool() noexcept : m_state(new (std::nothrow) state()) {}
+
+    image_pool(image_pool &&other) noexcept : m_state(other.m_state)
+    {
+        other.m_state = nullptr;
+    }
+
+    image_pool(const image_pool &) = delete;
+
+    ~image_pool()
+    {
+        state::release(m_state);
+    }
+
+    image_pool &operator=(image_pool &&other) noexcept
+    {
+        std::swap(m_state, other.m_state);
+        return *this;
+    }
+
+    image_pool &operator=(const image_pool &) = delete;
+
+    image create(k4a_image_format_t format, int width_pixels, int height_pixels, int stride_bytes) const
+    {
+        if (m_state == nullptr)
+        {
+            // Allocating the pool failed, or it was moved away
+            return image::create(format, width_pixels, height_pixels, stride_bytes);
+        }
+
+        size_t size = static_cast<size_t>(stride_bytes) * static_cast<size_t>(height_pixels);
+        std::unique_ptr<release_context> context(new release_context{ m_state, size });
+        uint8_t *buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_state->lock);
+            for (size_t i = 0; i < m_state->free_buffers.size(); i++)
+            {
+                if (m_state->free_buffers[i].size == size)
+                {
+                    buffer = m_state->free_buffers[i].buffer;
+                    m_state->free_buffers.erase(m_state->free_buffers.begin() + static_cast<std::ptrdiff_t>(i));
+                    break;
+                }
+            }
+        }
+        if (buffer == nullptr)
+        {
+            buffer = new uint8_t[size];
+        }
+
+        // The image holds a reference on the pool until its buffer is released
+        m_state->references++;
+        k4a_image_t handle = nullptr;
+        k4a_result_t result = k4a_image_create_from_buffer(format,
+                                                           width_pixels,
+                                                           height_pixels,
+                                                           stride_bytes,
+                                                           buffer,
+                                                           size,
+                                                           release_buffer,
+                                                           context.get(),
+                                                           &handle);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            release_buffer(buffer, context.release());
+            throw error("Failed to create image!");
+        }
+        context.release();
+        return image(handle);
+    }
+
+private:
+    // Free buffers kept for reuse, enough for a few outputs of each kind to be in flight
+    static const size_t max_free_buffers = 8;
+
+    struct free_buffer
+    {
+        uint8_t *buffer;
+        size_t size;
+    };
+
+    struct state
+    {
+        ~state()
+        {
+            for (const free_buffer &free : free_buffers)
+            {
+                delete[] free.buffer;
+            }
+        }
+
+        static void release(state *pool)
+        {
+            if (pool != nullptr && --pool->references == 0)
+            {
+                delete pool;
+            }
+        }
+
+        std::atomic<long> references{ 1 };
+        std::mutex lock;
+        std::vector<free_buffer> free_buffers;
+    };
+
+    struct release_context
+    {
+        state *pool;
+        size_t size;
+    };
+
+    static void release_buffer(void *buffer, void *context)
+    {
+        release_context *release = static_cast<release_context *>(context);
+        uint8_t *bytes = static_cast<uint8_t *>(buffer);
+        {
+            std::lock_guard<std::mutex> lock(release->pool->lock);
+            if (release->pool->free_buffers.size() < max_free_buffers)
+            {
+                release->pool->free_buffers.push_back({ bytes, release->size });
+                bytes = nullptr;
+            }
+        }
+        delete[] bytes;
+        state::release(release->pool);
+        delete release;
+    }
+
+    state *m_state;
+};
+/// @endcond
+} // namespace internal
+
 /** \class transformation k4a.hpp <k4a/k4a.hpp>
  * Wrapper for \ref k4a_transformation_t
  *
  * Wraps a handle for a transformation.
+ *
+ * The overloads that return new images take their buffers from a pool owned by the transformation, a buffer is reused
+ * for a later output once the image it was returned in is released. The overloads that take an output image pointer
+ * write to caller provided images instead.
  */
 class transformation
 {
@@ -848,7 +1138,9 @@ public:
     transformation(transformation &&other) noexcept :
         m_handle(other.m_handle),
         m_color_resolution(other.m_color_resolution),
-        m_depth_resolution(other.m_depth_resolution)
+        m_depth_resolution(other.m_depth_resolution),
+        m_roi_resolution(other.m_roi_resolution),
+        m_output_pool(std::move(other.m_output_pool))
     {
         other.m_handle = nullptr;
     }
@@ -870,6 +1162,8 @@ public:
             m_handle = other.m_handle;
             m_color_resolution = other.m_color_resolution;
             m_depth_resolution = other.m_depth_resolution;
+            m_roi_resolution = other.m_roi_resolution;
+            m_output_pool = std::move(other.m_output_pool);
             other.m_handle = nullptr;
         }
 
@@ -897,6 +1191,93 @@ public:
         }
     }
 
+    /** Limits the transformation functions to a region of interest of the depth camera.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_set_region_of_interest
+     */
+    void set_region_of_interest(const k4a_transformation_roi_t &roi)
+    {
+        k4a_result_t result = k4a_transformation_set_region_of_interest(m_handle, &roi);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set transformation region of interest!");
+        }
+        m_roi_resolution = { (roi.width + roi.decimation - 1) / roi.decimation,
+                             (roi.height + roi.decimation - 1) / roi.decimation };
+    }
+
+    /** Lets the transformation functions process full images again.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_set_region_of_interest
+     */
+    void clear_region_of_interest()
+    {
+        k4a_result_t result = k4a_transformation_set_region_of_interest(m_handle, nullptr);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to clear transformation region of interest!");
+        }
+        m_roi_resolution = { 0, 0 };
+    }
+
+    /** Sets the number of threads the transformation functions running on the CPU are split across.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_set_thread_count
+     */
+    void set_thread_count(uint32_t thread_count)
+    {
+        k4a_result_t result = k4a_transformation_set_thread_count(m_handle, thread_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set transformation thread count!");
+        }
+    }
+
+    /** Gets the table that maps each pixel of a camera to a point on the Z=1 plane.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_get_xy_table
+     */
+    image get_xy_table(k4a_calibration_type_t camera) const
+    {
+        const resolution &table_resolution = camera == K4A_CALIBRATION_TYPE_COLOR ? m_color_resolution :
+                                                                                     m_depth_resolution;
+        image xy_table = image::create(K4A_IMAGE_FORMAT_CUSTOM,
+                                       table_resolution.width,
+                                       table_resolution.height,
+                                       table_resolution.width * static_cast<int32_t>(sizeof(k4a_float2_t)));
+        k4a_result_t result = k4a_transformation_get_xy_table(m_handle, camera, xy_table.handle());
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to get transformation xy table!");
+        }
+        return xy_table;
+    }
+
+    /** Transforms an array of 2D pixel coordinates of the color camera into 2D pixel coordinates of the depth camera.
+     * Each element of valid is set to 0 if the corresponding point was not found in the depth image (and therefore the
+     * corresponding element of target_points2d should not be used)
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_color_2d_to_depth_2d_batch
+     */
+    void color_2d_to_depth_2d(const image &depth_image,
+                              const k4a_float2_t *source_points2d,
+                              size_t point_count,
+                              k4a_float2_t *target_points2d,
+                              int *valid) const
+    {
+        k4a_result_t result = k4a_transformation_color_2d_to_depth_2d_batch(
+            m_handle, depth_image.handle(), source_points2d, point_count, target_points2d, valid);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform color pixels to the depth camera!");
+        }
+    }
+
     /** Transforms the depth map into the geometry of the color camera.
      * Throws error on failure
      *
@@ -922,11 +1303,30 @@ public:
      */
     image depth_image_to_color_camera(const image &depth_image) const
     {
-        image transformed_depth_image = image::create(K4A_IMAGE_FORMAT_DEPTH16,
-                                                      m_color_resolution.width,
-                                                      m_color_resolution.height,
-                                                      m_color_resolution.width *
-                                                          static_cast<int32_t>(sizeof(uint16_t)));
+        image transformed_depth_image = m_output_pool.create(K4A_IMAGE_FORMAT_DEPTH16,
+                                                             m_color_resolution.width,
+                                                             m_color_resolution.height,
+                                                             m_color_resolution.width *
+                                                                 static_cast<int32_t>(sizeof(uint16_t)));
+        depth_image_to_color_camera(depth_image, &transformed_depth_image);
+        return transformed_depth_image;
+    }
+
+    /** Transforms the depth map into the geometry of the color camera at a reduced resolution.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_depth_image_to_color_camera
+     * Creates a new image of the color resolution divided by \p scale, rounded up.
+     */
+    image depth_image_to_color_camera(const image &depth_image, k4a_color_scale_t scale) const
+    {
+        int32_t divisor = 1 << static_cast<int32_t>(scale);
+        int32_t width = (m_color_resolution.width + divisor - 1) / divisor;
+        int32_t height = (m_color_resolution.height + divisor - 1) / divisor;
+        image transformed_depth_image = m_output_pool.create(K4A_IMAGE_FORMAT_DEPTH16,
+                                                             width,
+                                                             height,
+                                                             width * static_cast<int32_t>(sizeof(uint16_t)));
         depth_image_to_color_camera(depth_image, &transformed_depth_image);
         return transformed_depth_image;
     }
@@ -969,27 +1369,12 @@ public:
                                        k4a_transformation_interpolation_type_t interpolation_type,
                                        uint32_t invalid_custom_value) const
     {
-        image transformed_depth_image = image::create(K4A_IMAGE_FORMAT_DEPTH16,
-                                                      m_color_resolution.width,
-                                                      m_color_resolution.height,
-                                                      m_color_resolution.width *
-                                                          static_cast<int32_t>(sizeof(uint16_t)));
-        int32_t bytes_per_pixel;
-        switch (custom_image.get_format())
-        {
-        case K4A_IMAGE_FORMAT_CUSTOM8:
-            bytes_per_pixel = static_cast<int32_t>(sizeof(int8_t));
-            break;
-        case K4A_IMAGE_FORMAT_CUSTOM16:
-            bytes_per_pixel = static_cast<int32_t>(sizeof(int16_t));
-            break;
-        default:
-            throw error("Failed to support this format of custom image!");
-        }
-        image transformed_custom_image = image::create(custom_image.get_format(),
-                                                       m_color_resolution.width,
-                                                       m_color_resolution.height,
-                                                       m_color_resolution.width * bytes_per_pixel);
+        image transformed_depth_image = m_output_pool.create(K4A_IMAGE_FORMAT_DEPTH16,
+                                                             m_color_resolution.width,
+                                                             m_color_resolution.height,
+                                                             m_color_resolution.width *
+                                                                 static_cast<int32_t>(sizeof(uint16_t)));
+        image transformed_custom_image = create_transformed_custom_image(custom_image);
         depth_image_to_color_camera_custom(depth_image,
                                            custom_image,
                                            &transformed_depth_image,
@@ -999,6 +1384,79 @@ public:
         return { std::move(transformed_depth_image), std::move(transformed_custom_image) };
     }
 
+    /** Transforms depth map and several custom images into the geometry of the color camera in one pass.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_depth_image_to_color_camera_custom_images
+     * Transforms the output in to the existing caller provided \p transformed_depth_image \p transformed_custom_images.
+     */
+    void depth_image_to_color_camera_custom_images(const image &depth_image,
+                                                   const std::vector<image> &custom_images,
+                                                   image *transformed_depth_image,
+                                                   std::vector<image> *transformed_custom_images,
+                                                   k4a_transformation_interpolation_type_t interpolation_type,
+                                                   const std::vector<uint32_t> &invalid_custom_values) const
+    {
+        if (transformed_custom_images->size() != custom_images.size() ||
+            invalid_custom_values.size() != custom_images.size())
+        {
+            throw error("Expect one transformed image and invalid value per custom image!");
+        }
+
+        std::vector<k4a_image_t> custom_image_handles;
+        std::vector<k4a_image_t> transformed_custom_image_handles;
+        for (size_t i = 0; i < custom_images.size(); i++)
+        {
+            custom_image_handles.push_back(custom_images[i].handle());
+            transformed_custom_image_handles.push_back((*transformed_custom_images)[i].handle());
+        }
+
+        k4a_result_t result = k4a_transformation_depth_image_to_color_camera_custom_images(
+            m_handle,
+            depth_image.handle(),
+            custom_image_handles.data(),
+            custom_image_handles.size(),
+            transformed_depth_image->handle(),
+            transformed_custom_image_handles.data(),
+            interpolation_type,
+            invalid_custom_values.data());
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to convert depth map and custom images to color camera geometry!");
+        }
+    }
+
+    /** Transforms depth map and several custom images into the geometry of the color camera in one pass.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_depth_image_to_color_camera_custom_images
+     * Creates new images with the output.
+     */
+    std::pair<image, std::vector<image>>
+    depth_image_to_color_camera_custom_images(const image &depth_image,
+                                              const std::vector<image> &custom_images,
+                                              k4a_transformation_interpolation_type_t interpolation_type,
+                                              const std::vector<uint32_t> &invalid_custom_values) const
+    {
+        image transformed_depth_image = m_output_pool.create(K4A_IMAGE_FORMAT_DEPTH16,
+                                                             m_color_resolution.width,
+                                                             m_color_resolution.height,
+                                                             m_color_resolution.width *
+                                                                 static_cast<int32_t>(sizeof(uint16_t)));
+        std::vector<image> transformed_custom_images;
+        for (const image &custom_image : custom_images)
+        {
+            transformed_custom_images.push_back(create_transformed_custom_image(custom_image));
+        }
+        depth_image_to_color_camera_custom_images(depth_image,
+                                                  custom_images,
+                                                  &transformed_depth_image,
+                                                  &transformed_custom_images,
+                                                  interpolation_type,
+                                                  invalid_custom_values);
+        return { std::move(transformed_depth_image), std::move(transformed_custom_images) };
+    }
+
     /** Transforms the color image into the geometry of the depth camera.
      * Throws error on failure
      *
@@ -1027,22 +1485,135 @@ public:
      */
     image color_image_to_depth_camera(const image &depth_image, const image &color_image) const
     {
-        image transformed_color_image = image::create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
-                                                      m_depth_resolution.width,
-                                                      m_depth_resolution.height,
-                                                      m_depth_resolution.width * 4 *
-                                                          static_cast<int32_t>(sizeof(uint8_t)));
+        resolution output_resolution = m_roi_resolution.width > 0 ? m_roi_resolution : m_depth_resolution;
+        image transformed_color_image = m_output_pool.create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                                             output_resolution.width,
+                                                             output_resolution.height,
+                                                             output_resolution.width * 4 *
+                                                                 static_cast<int32_t>(sizeof(uint8_t)));
         color_image_to_depth_camera(depth_image, color_image, &transformed_color_image);
         return transformed_color_image;
     }
 
-    /** Transforms the depth image into 3 planar images representing X, Y and Z-coordinates of corresponding 3d points.
-     * Throws error on failure.
+    /** Transforms the color image into the geometry of the depth camera with the given sampling of the color image.
+     * Throws error on failure
      *
-     * \sa k4a_transformation_depth_image_to_point_cloud
-     * Transforms the output in to the existing caller provided \p xyz_image.
+     * \sa k4a_transformation_color_image_to_depth_camera_with_interpolation
+     * Transforms the output in to the existing caller provided \p transformed_color_image.
      */
-    void depth_image_to_point_cloud(const image &depth_image, k4a_calibration_type_t camera, image *xyz_image) const
+    void color_image_to_depth_camera(const image &depth_image,
+                                     const image &color_image,
+                                     k4a_transformation_interpolation_type_t interpolation_type,
+                                     image *transformed_color_image) const
+    {
+        k4a_result_t result =
+            k4a_transformation_color_image_to_depth_camera_with_interpolation(m_handle,
+                                                                              depth_image.handle(),
+                                                                              color_image.handle(),
+                                                                              transformed_color_image->handle(),
+                                                                              interpolation_type);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to convert color image to depth camera geometry!");
+        }
+    }
+
+    /** Transforms the color image into the geometry of the depth camera with the given sampling of the color image.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_color_image_to_depth_camera_with_interpolation
+     * Creates a new image with the output.
+     */
+    image color_image_to_depth_camera(const image &depth_image,
+                                      const image &color_image,
+                                      k4a_transformation_interpolation_type_t interpolation_type) const
+    {
+        resolution output_resolution = m_roi_resolution.width > 0 ? m_roi_resolution : m_depth_resolution;
+        image transformed_color_image = m_output_pool.create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                                             output_resolution.width,
+                                                             output_resolution.height,
+                                                             output_resolution.width * 4 *
+                                                                 static_cast<int32_t>(sizeof(uint8_t)));
+        color_image_to_depth_camera(depth_image, color_image, interpolation_type, &transformed_color_image);
+        return transformed_color_image;
+    }
+
+    /** Transforms the depth map into the geometry of the color camera and exports the result as a GPU resource.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_depth_image_to_color_camera_gpu
+     * Release the resource with release_gpu_resource().
+     */
+    k4a_gpu_resource_t depth_image_to_color_camera_gpu(const image &depth_image, k4a_gpu_interop_type_t type) const
+    {
+        k4a_gpu_resource_t resource = {};
+        k4a_result_t result =
+            k4a_transformation_depth_image_to_color_camera_gpu(m_handle, depth_image.handle(), type, &resource);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to export depth image in color camera geometry to the GPU!");
+        }
+        return resource;
+    }
+
+    /** Transforms the color image into the geometry of the depth camera and exports the result as a GPU resource.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_color_image_to_depth_camera_gpu
+     * Release the resource with release_gpu_resource().
+     */
+    k4a_gpu_resource_t color_image_to_depth_camera_gpu(const image &depth_image,
+                                                       const image &color_image,
+                                                       k4a_gpu_interop_type_t type) const
+    {
+        k4a_gpu_resource_t resource = {};
+        k4a_result_t result = k4a_transformation_color_image_to_depth_camera_gpu(m_handle,
+                                                                                 depth_image.handle(),
+                                                                                 color_image.handle(),
+                                                                                 type,
+                                                                                 &resource);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to export color image in depth camera geometry to the GPU!");
+        }
+        return resource;
+    }
+
+    /** Transforms a depth image the depth engine left on the GPU into the geometry of the color camera and exports
+     * the result as a GPU resource. Throws error on failure
+     *
+     * \sa k4a_transformation_depth_resource_to_color_camera_gpu
+     * Release the resource with release_gpu_resource().
+     */
+    k4a_gpu_resource_t depth_resource_to_color_camera_gpu(const k4a_gpu_resource_t &depth_resource,
+                                                          k4a_gpu_interop_type_t type) const
+    {
+        k4a_gpu_resource_t resource = {};
+        k4a_result_t result =
+            k4a_transformation_depth_resource_to_color_camera_gpu(m_handle, &depth_resource, type, &resource);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to export depth resource in color camera geometry to the GPU!");
+        }
+        return resource;
+    }
+
+    /** Releases a GPU resource exported by this transformation
+     *
+     * \sa k4a_transformation_release_gpu_resource
+     */
+    void release_gpu_resource(const k4a_gpu_resource_t &resource) const
+    {
+        k4a_transformation_release_gpu_resource(m_handle, &resource);
+    }
+
+    /** Transforms the depth image into 3 planar images representing X, Y and Z-coordinates of corresponding 3d points.
+     * Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_point_cloud
+     * Transforms the output in to the existing caller provided \p xyz_image.
+     */
+    void depth_image_to_point_cloud(const image &depth_image, k4a_calibration_type_t camera, image *xyz_image) const
     {
         k4a_result_t result =
             k4a_transformation_depth_image_to_point_cloud(m_handle, depth_image.handle(), camera, xyz_image->handle());
@@ -1060,23 +1631,514 @@ public:
      */
     image depth_image_to_point_cloud(const image &depth_image, k4a_calibration_type_t camera) const
     {
-        image xyz_image = image::create(K4A_IMAGE_FORMAT_CUSTOM,
-                                        depth_image.get_width_pixels(),
-                                        depth_image.get_height_pixels(),
-                                        depth_image.get_width_pixels() * 3 * static_cast<int32_t>(sizeof(int16_t)));
+        image xyz_image =
+            create_point_cloud_image(depth_image, camera, K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS);
         depth_image_to_point_cloud(depth_image, camera, &xyz_image);
         return xyz_image;
     }
 
+    /** Transforms the depth image into a point cloud of the given point format. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_point_cloud_with_format
+     * Transforms the output in to the existing caller provided \p xyz_image.
+     */
+    void depth_image_to_point_cloud(const image &depth_image,
+                                    k4a_calibration_type_t camera,
+                                    k4a_transformation_point_cloud_format_t point_cloud_format,
+                                    image *xyz_image) const
+    {
+        k4a_result_t result = k4a_transformation_depth_image_to_point_cloud_with_format(m_handle,
+                                                                                        depth_image.handle(),
+                                                                                        camera,
+                                                                                        point_cloud_format,
+                                                                                        xyz_image->handle());
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to point cloud!");
+        }
+    }
+
+    /** Transforms the depth image into a point cloud of the given point format. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_point_cloud_with_format
+     * Creates a new image with the output.
+     */
+    image depth_image_to_point_cloud(const image &depth_image,
+                                     k4a_calibration_type_t camera,
+                                     k4a_transformation_point_cloud_format_t point_cloud_format) const
+    {
+        image xyz_image = create_point_cloud_image(depth_image, camera, point_cloud_format);
+        depth_image_to_point_cloud(depth_image, camera, point_cloud_format, &xyz_image);
+        return xyz_image;
+    }
+
+    /** Transforms the depth image into a compact point cloud that only holds the valid points and returns the number
+     * of points. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_compact_point_cloud
+     * Transforms the output in to the existing caller provided \p xyz_image and, if not nullptr, \p index_image.
+     */
+    size_t depth_image_to_compact_point_cloud(const image &depth_image,
+                                              k4a_calibration_type_t camera,
+                                              k4a_transformation_point_cloud_format_t point_cloud_format,
+                                              image *xyz_image,
+                                              image *index_image = nullptr) const
+    {
+        size_t point_count = 0;
+        k4a_result_t result = k4a_transformation_depth_image_to_compact_point_cloud(m_handle,
+                                                                                    depth_image.handle(),
+                                                                                    camera,
+                                                                                    point_cloud_format,
+                                                                                    xyz_image->handle(),
+                                                                                    index_image == nullptr ?
+                                                                                        nullptr :
+                                                                                        index_image->handle(),
+                                                                                    &point_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to compact point cloud!");
+        }
+        return point_count;
+    }
+
+    /** Transforms the depth image into a float point cloud in meters and the normals of its points.
+     * Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_point_cloud_with_normals
+     * Transforms the output in to the existing caller provided \p xyz_image and \p normal_image.
+     */
+    void depth_image_to_point_cloud_with_normals(const image &depth_image,
+                                                 k4a_calibration_type_t camera,
+                                                 image *xyz_image,
+                                                 image *normal_image) const
+    {
+        k4a_result_t result = k4a_transformation_depth_image_to_point_cloud_with_normals(m_handle,
+                                                                                         depth_image.handle(),
+                                                                                         camera,
+                                                                                         xyz_image->handle(),
+                                                                                         normal_image->handle());
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to point cloud with normals!");
+        }
+    }
+
+    /** Transforms the depth image into a point cloud with one point per voxel of voxel_size meters and returns the
+     * number of points. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_voxel_point_cloud
+     * Transforms the output in to the existing caller provided \p xyz_image and, if not nullptr, \p normal_image.
+     */
+    size_t depth_image_to_voxel_point_cloud(const image &depth_image,
+                                            k4a_calibration_type_t camera,
+                                            float voxel_size,
+                                            image *xyz_image,
+                                            image *normal_image = nullptr) const
+    {
+        size_t point_count = 0;
+        k4a_result_t result = k4a_transformation_depth_image_to_voxel_point_cloud(m_handle,
+                                                                                  depth_image.handle(),
+                                                                                  camera,
+                                                                                  voxel_size,
+                                                                                  xyz_image->handle(),
+                                                                                  normal_image == nullptr ?
+                                                                                      nullptr :
+                                                                                      normal_image->handle(),
+                                                                                  &point_count);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to voxel point cloud!");
+        }
+        return point_count;
+    }
+
+    /** Transforms the depth image into a point cloud in which every point carries the color of the matching color
+     * pixel. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_colored_point_cloud
+     * Transforms the output in to the existing caller provided \p colored_xyz_image.
+     */
+    void depth_image_to_colored_point_cloud(const image &depth_image,
+                                            const image &color_image,
+                                            image *colored_xyz_image) const
+    {
+        k4a_result_t result = k4a_transformation_depth_image_to_colored_point_cloud(m_handle,
+                                                                                    depth_image.handle(),
+                                                                                    color_image.handle(),
+                                                                                    colored_xyz_image->handle());
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to transform depth image to colored point cloud!");
+        }
+    }
+
+    /** Transforms the depth image into a point cloud in which every point carries the color of the matching color
+     * pixel. Throws error on failure.
+     *
+     * \sa k4a_transformation_depth_image_to_colored_point_cloud
+     * Creates a new image with the output.
+     */
+    image depth_image_to_colored_point_cloud(const image &depth_image, const image &color_image) const
+    {
+        resolution output_resolution = depth_output_resolution(depth_image, K4A_CALIBRATION_TYPE_DEPTH);
+        image colored_xyz_image = m_output_pool.create(K4A_IMAGE_FORMAT_CUSTOM,
+                                                       output_resolution.width,
+                                                       output_resolution.height,
+                                                       output_resolution.width *
+                                                           (3 * static_cast<int32_t>(sizeof(int16_t)) +
+                                                            4 * static_cast<int32_t>(sizeof(uint8_t))));
+        depth_image_to_colored_point_cloud(depth_image, color_image, &colored_xyz_image);
+        return colored_xyz_image;
+    }
+
+    /** Submits transformation jobs that run asynchronously of the caller.
+     * Throws error on failure
+     *
+     * \sa k4a_transformation_submit
+     */
+    void submit(const k4a_transformation_job_t *jobs,
+                size_t job_count,
+                k4a_transformation_completion_cb_t *callback,
+                void *callback_context) const
+    {
+        k4a_result_t result = k4a_transformation_submit(m_handle, jobs, job_count, callback, callback_context);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to submit transformation jobs!");
+        }
+    }
+
+    /** Waits for all submitted transformation jobs to complete. Returns true if they completed, false if the wait
+     * timed out. Throws error on failure.
+     *
+     * \sa k4a_transformation_wait_idle
+     */
+    bool wait_idle(std::chrono::milliseconds timeout) const
+    {
+        int32_t timeout_ms = internal::clamp_cast<int32_t>(timeout.count());
+        k4a_wait_result_t result = k4a_transformation_wait_idle(m_handle, timeout_ms);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            throw error("Failed to wait for transformation jobs!");
+        }
+        return result == K4A_WAIT_RESULT_SUCCEEDED;
+    }
+
+    /** Waits for all submitted transformation jobs to complete.
+     * Throws error on failure. This API assumes an infinite timeout.
+     *
+     * \sa k4a_transformation_wait_idle
+     */
+    void wait_idle() const
+    {
+        (void)wait_idle(std::chrono::milliseconds(K4A_WAIT_INFINITE));
+    }
+
 private:
-    k4a_transformation_t m_handle;
     struct resolution
     {
         int32_t width;
         int32_t height;
     };
+
+    // Size of an output image in the geometry of the depth image, which is the region image with a region of interest
+    resolution depth_output_resolution(const image &depth_image, k4a_calibration_type_t camera) const
+    {
+        if (m_roi_resolution.width > 0 && camera == K4A_CALIBRATION_TYPE_DEPTH)
+        {
+            return m_roi_resolution;
+        }
+        return { depth_image.get_width_pixels(), depth_image.get_height_pixels() };
+    }
+
+    image create_transformed_custom_image(const image &custom_image) const
+    {
+        int32_t bytes_per_pixel;
+        switch (custom_image.get_format())
+        {
+        case K4A_IMAGE_FORMAT_CUSTOM8:
+            bytes_per_pixel = static_cast<int32_t>(sizeof(int8_t));
+            break;
+        case K4A_IMAGE_FORMAT_CUSTOM16:
+            bytes_per_pixel = static_cast<int32_t>(sizeof(int16_t));
+            break;
+        default:
+            throw error("Failed to support this format of custom image!");
+        }
+        return m_output_pool.create(custom_image.get_format(),
+                                    m_color_resolution.width,
+                                    m_color_resolution.height,
+                                    m_color_resolution.width * bytes_per_pixel);
+    }
+
+    image create_point_cloud_image(const image &depth_image,
+                                   k4a_calibration_type_t camera,
+                                   k4a_transformation_point_cloud_format_t point_cloud_format) const
+    {
+        int32_t point_size = point_cloud_format == K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS ?
+                                 3 * static_cast<int32_t>(sizeof(float)) :
+                                 3 * static_cast<int32_t>(sizeof(int16_t));
+        resolution output_resolution = depth_output_resolution(depth_image, camera);
+        return m_output_pool.create(K4A_IMAGE_FORMAT_CUSTOM,
+                                    output_resolution.width,
+                                    output_resolution.height,
+                                    output_resolution.width * point_size);
+    }
+
+    k4a_transformation_t m_handle;
     resolution m_color_resolution;
     resolution m_depth_resolution;
+    resolution m_roi_resolution = { 0, 0 };
+    internal::image_pool m_output_pool;
+};
+
+/** \class undistortion_map k4a.hpp <k4a/k4a.hpp>
+ * Wrapper for \ref k4a_undistortion_map_t
+ *
+ * Wraps a handle for an undistortion map.
+ */
+class undistortion_map
+{
+public:
+    /** Creates an undistortion_map from a k4a_undistortion_map_t
+     * Takes ownership of the handle, i.e. you should not call
+     * k4a_undistortion_map_destroy on the handle after giving
+     * it to the undistortion_map; the undistortion_map will take care of that.
+     */
+    undistortion_map(k4a_undistortion_map_t handle = nullptr, int width_pixels = 0, int height_pixels = 0) noexcept :
+        m_handle(handle),
+        m_width_pixels(width_pixels),
+        m_height_pixels(height_pixels)
+    {
+    }
+
+    /** Moves another undistortion_map into a new undistortion_map
+     */
+    undistortion_map(undistortion_map &&other) noexcept :
+        m_handle(other.m_handle),
+        m_width_pixels(other.m_width_pixels),
+        m_height_pixels(other.m_height_pixels)
+    {
+        other.m_handle = nullptr;
+    }
+
+    undistortion_map(const undistortion_map &) = delete;
+
+    ~undistortion_map()
+    {
+        destroy();
+    }
+
+    /** Moves another undistortion_map into this undistortion_map; other is set to invalid
+     */
+    undistortion_map &operator=(undistortion_map &&other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = other.m_handle;
+            m_width_pixels = other.m_width_pixels;
+            m_height_pixels = other.m_height_pixels;
+            other.m_handle = nullptr;
+        }
+
+        return *this;
+    }
+
+    undistortion_map &operator=(const undistortion_map &) = delete;
+
+    /** Invalidates this undistortion_map
+     */
+    void destroy() noexcept
+    {
+        if (m_handle != nullptr)
+        {
+            k4a_undistortion_map_destroy(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /** Returns true if the undistortion_map is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Creates a map from the pixels of a pinhole camera to the pixels of one camera of a calibration
+     * Throws error on failure
+     *
+     * \sa k4a_undistortion_map_create
+     */
+    static undistortion_map create(const k4a_calibration_t &calibration,
+                                   k4a_calibration_type_t camera,
+                                   const k4a_pinhole_t *target = nullptr,
+                                   const float *rotation = nullptr,
+                                   uint32_t thread_count = 0)
+    {
+        k4a_undistortion_map_t handle = nullptr;
+        k4a_result_t result =
+            k4a_undistortion_map_create(&calibration, camera, target, rotation, thread_count, &handle);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to create undistortion map!");
+        }
+
+        const k4a_calibration_camera_t &camera_calibration = camera == K4A_CALIBRATION_TYPE_DEPTH ?
+                                                                 calibration.depth_camera_calibration :
+                                                                 calibration.color_camera_calibration;
+        return undistortion_map(handle,
+                                target != nullptr ? target->width : camera_calibration.resolution_width,
+                                target != nullptr ? target->height : camera_calibration.resolution_height);
+    }
+
+    /** Remaps an image of the calibrated camera into a caller provided image of the target camera
+     * Throws error on failure
+     *
+     * \sa k4a_undistortion_map_remap
+     */
+    void remap(const image &source_image,
+               image *destination_image,
+               k4a_transformation_interpolation_type_t interpolation_type) const
+    {
+        k4a_result_t result = k4a_undistortion_map_remap(m_handle,
+                                                         source_image.handle(),
+                                                         destination_image->handle(),
+                                                         interpolation_type);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to remap image!");
+        }
+    }
+
+    /** Remaps an image of the calibrated camera into a new image of the target camera
+     * Throws error on failure
+     *
+     * \sa k4a_undistortion_map_remap
+     */
+    image remap(const image &source_image, k4a_transformation_interpolation_type_t interpolation_type) const
+    {
+        int32_t bytes_per_pixel = source_image.get_format() == K4A_IMAGE_FORMAT_COLOR_BGRA32 ?
+                                      4 * static_cast<int32_t>(sizeof(uint8_t)) :
+                                      static_cast<int32_t>(sizeof(uint16_t));
+        image destination_image = image::create(source_image.get_format(),
+                                                m_width_pixels,
+                                                m_height_pixels,
+                                                m_width_pixels * bytes_per_pixel);
+        remap(source_image, &destination_image, interpolation_type);
+        return destination_image;
+    }
+
+private:
+    k4a_undistortion_map_t m_handle;
+    int m_width_pixels;
+    int m_height_pixels;
+};
+
+/** \class tensor_converter k4a.hpp <k4a/k4a.hpp>
+ * Wrapper for \ref k4a_tensor_converter_t
+ *
+ * Wraps a handle for a tensor converter.
+ */
+class tensor_converter
+{
+public:
+    /** Creates a tensor_converter from a k4a_tensor_converter_t
+     * Takes ownership of the handle, i.e. you should not call
+     * k4a_tensor_converter_destroy on the handle after giving
+     * it to the tensor_converter; the tensor_converter will take care of that.
+     */
+    tensor_converter(k4a_tensor_converter_t handle = nullptr) noexcept : m_handle(handle) {}
+
+    /** Moves another tensor_converter into a new tensor_converter
+     */
+    tensor_converter(tensor_converter &&other) noexcept : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+
+    tensor_converter(const tensor_converter &) = delete;
+
+    ~tensor_converter()
+    {
+        destroy();
+    }
+
+    /** Moves another tensor_converter into this tensor_converter; other is set to invalid
+     */
+    tensor_converter &operator=(tensor_converter &&other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+
+        return *this;
+    }
+
+    tensor_converter &operator=(const tensor_converter &) = delete;
+
+    /** Invalidates this tensor_converter
+     */
+    void destroy() noexcept
+    {
+        if (m_handle != nullptr)
+        {
+            k4a_tensor_converter_destroy(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /** Returns true if the tensor_converter is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Creates a converter of images to tensors
+     * Throws error on failure
+     *
+     * \sa k4a_tensor_converter_create
+     */
+    static tensor_converter create(const k4a_tensor_configuration_t &config, uint32_t thread_count = 0)
+    {
+        k4a_tensor_converter_t handle = nullptr;
+        k4a_result_t result = k4a_tensor_converter_create(&config, thread_count, &handle);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to create tensor converter!");
+        }
+        return tensor_converter(handle);
+    }
+
+    /** Returns the size of the tensors in bytes
+     *
+     * \sa k4a_tensor_converter_get_size
+     */
+    size_t get_size() const noexcept
+    {
+        return k4a_tensor_converter_get_size(m_handle);
+    }
+
+    /** Converts an image into a caller provided tensor
+     * Throws error on failure
+     *
+     * \sa k4a_tensor_converter_convert
+     */
+    void convert(const image &source_image, void *tensor, size_t tensor_size) const
+    {
+        k4a_result_t result = k4a_tensor_converter_convert(m_handle, source_image.handle(), tensor, tensor_size);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to convert image to tensor!");
+        }
+    }
+
+private:
+    k4a_tensor_converter_t m_handle;
 };
 
 /** \class device k4a.hpp <k4a/k4a.hpp>
@@ -1224,6 +2286,130 @@ public:
         return get_imu_sample(imu_sample, std::chrono::milliseconds(K4A_WAIT_INFINITE));
     }
 
+    /** Reads up to max_sample_count buffered IMU samples.  Returns the number of samples read, 0 if the read timed out.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_get_imu_samples
+     */
+    size_t get_imu_samples(k4a_imu_sample_t *imu_samples,
+                           size_t max_sample_count,
+                           std::chrono::milliseconds timeout) const
+    {
+        int32_t timeout_ms = internal::clamp_cast<int32_t>(timeout.count());
+        size_t sample_count = 0;
+        k4a_wait_result_t result =
+            k4a_device_get_imu_samples(m_handle, imu_samples, max_sample_count, &sample_count, timeout_ms);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            throw error("Failed to get IMU samples from device!");
+        }
+
+        return sample_count;
+    }
+
+    /** Reads up to max_sample_count buffered IMU samples.  Returns the number of samples read.
+     * Throws error on failure. This API assumes an infinite timeout.
+     *
+     * \sa k4a_device_get_imu_samples
+     */
+    size_t get_imu_samples(k4a_imu_sample_t *imu_samples, size_t max_sample_count) const
+    {
+        return get_imu_samples(imu_samples, max_sample_count, std::chrono::milliseconds(K4A_WAIT_INFINITE));
+    }
+
+    /** Waits until any of several device streams can be read without blocking, and flags the ready ones.  Returns true
+     * if a stream is ready, false if the wait timed out.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_wait_any
+     */
+    static bool wait_any(k4a_wait_source_t *sources, size_t source_count, std::chrono::milliseconds timeout)
+    {
+        int32_t timeout_ms = internal::clamp_cast<int32_t>(timeout.count());
+        k4a_wait_result_t result = k4a_device_wait_any(sources, source_count, timeout_ms);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            throw error("Failed to wait for device streams!");
+        }
+
+        return result == K4A_WAIT_RESULT_SUCCEEDED;
+    }
+
+    /** Maps a device timestamp to the clock of the system timestamps.  Returns false if the device clock is not
+     * modeled yet.
+     *
+     * \sa k4a_device_get_system_timestamp_nsec
+     */
+    bool get_system_timestamp(std::chrono::microseconds device_timestamp,
+                              std::chrono::nanoseconds *system_timestamp) const noexcept
+    {
+        uint64_t device_timestamp_usec = internal::clamp_cast<uint64_t>(device_timestamp.count());
+        uint64_t system_timestamp_nsec = 0;
+        k4a_result_t result = k4a_device_get_system_timestamp_nsec(m_handle,
+                                                                   device_timestamp_usec,
+                                                                   &system_timestamp_nsec);
+        if (K4A_FAILED(result))
+        {
+            return false;
+        }
+
+        *system_timestamp = std::chrono::nanoseconds(system_timestamp_nsec);
+        return true;
+    }
+
+    /** Maps a device timestamp to the shared timebase.  Returns false if the device clock is not modeled yet, or if
+     * the shared timebase can not be read.
+     *
+     * \sa k4a_device_get_shared_timestamp_nsec
+     */
+    bool get_shared_timestamp(std::chrono::microseconds device_timestamp,
+                              std::chrono::nanoseconds *shared_timestamp) const noexcept
+    {
+        uint64_t device_timestamp_usec = internal::clamp_cast<uint64_t>(device_timestamp.count());
+        uint64_t shared_timestamp_nsec = 0;
+        k4a_result_t result = k4a_device_get_shared_timestamp_nsec(m_handle,
+                                                                   device_timestamp_usec,
+                                                                   &shared_timestamp_nsec);
+        if (K4A_FAILED(result))
+        {
+            return false;
+        }
+
+        *shared_timestamp = std::chrono::nanoseconds(shared_timestamp_nsec);
+        return true;
+    }
+
+    /** Maps the device timestamps of the images of a capture to the shared timebase.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_get_capture_shared_timestamps
+     */
+    k4a_capture_shared_timestamps_t get_capture_shared_timestamps(const capture &cap) const
+    {
+        k4a_capture_shared_timestamps_t timestamps;
+        k4a_result_t result = k4a_device_get_capture_shared_timestamps(m_handle, cap.handle(), &timestamps);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to map capture timestamps to the shared timebase!");
+        }
+
+        return timestamps;
+    }
+
+    /** Sets the scale the color images are decoded to by the next start_cameras()
+     * Throws error on failure.
+     *
+     * \sa k4a_device_set_color_scale
+     */
+    void set_color_scale(k4a_color_scale_t scale) const
+    {
+        k4a_result_t result = k4a_device_set_color_scale(m_handle, scale);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set color scale!");
+        }
+    }
+
     /** Starts the K4A device's cameras
      * Throws error on failure.
      *
@@ -1247,6 +2433,20 @@ public:
         k4a_device_stop_cameras(m_handle);
     }
 
+    /** Changes the depth mode and frame rate of the running cameras without restarting them
+     * Throws error on failure, the cameras are stopped then.
+     *
+     * \sa k4a_device_reconfigure_depth
+     */
+    void reconfigure_depth(k4a_depth_mode_t depth_mode, k4a_fps_t camera_fps) const
+    {
+        k4a_result_t result = k4a_device_reconfigure_depth(m_handle, depth_mode, camera_fps);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to reconfigure depth!");
+        }
+    }
+
     /** Starts the K4A IMU
      * Throws error on failure
      *
@@ -1440,6 +2640,30 @@ public:
         return device(handle);
     }
 
+    /** Open the first count k4a devices in parallel.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_open_all
+     */
+    static std::vector<device> open_all(uint32_t count)
+    {
+        std::vector<k4a_device_t> handles(count, nullptr);
+        std::vector<device> devices;
+        devices.reserve(count);
+        k4a_result_t result = k4a_device_open_all(count, handles.data());
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open devices!");
+        }
+
+        for (k4a_device_t handle : handles)
+        {
+            devices.emplace_back(handle);
+        }
+        return devices;
+    }
+
     /** Gets the number of connected devices
      *
      * \sa k4a_device_get_installed_count
@@ -0,0 +1,174 @@
+/** \file k4aeigen.hpp
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK - Eigen adapters for the C++ wrapper.
+ *
+ * Header-only, include it after Eigen to access the pixels of a k4a::image as an Eigen matrix without copying them.
+ */
+
+#ifndef K4AEIGEN_HPP
+#define K4AEIGEN_HPP
+
+#include "k4a.hpp"
+
+#include <Eigen/Core>
+
+namespace k4a
+{
+
+/**
+ * \addtogroup cppsdk
+ *
+ * @{
+ */
+
+/** Row major matrix of the pixels of an image
+ */
+template<typename Scalar> using image_matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Helper functions not intended for use by client code
+//
+namespace internal
+{
+/// @cond FALSE
+/** Returns the size of a pixel of an image format in bytes, 0 for CUSTOM and compressed or subsampled formats
+ */
+inline int eigen_bytes_per_pixel(k4a_image_format_t format)
+{
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+    case K4A_IMAGE_FORMAT_CUSTOM16:
+        return 2;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        return 4;
+    case K4A_IMAGE_FORMAT_CUSTOM8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+template<typename Scalar> int eigen_map_cols(const image &source_image)
+{
+    int bytes_per_pixel = source_image ? eigen_bytes_per_pixel(source_image.get_format()) : 0;
+    int stride_bytes = source_image ? source_image.get_stride_bytes() : 0;
+    if (source_image && source_image.get_format() == K4A_IMAGE_FORMAT_CUSTOM)
+    {
+        // The rows of CUSTOM images, such as point clouds, are mapped whole
+        if (stride_bytes > 0 && stride_bytes % static_cast<int>(sizeof(Scalar)) == 0)
+        {
+            return stride_bytes / static_cast<int>(sizeof(Scalar));
+        }
+    }
+    else if (bytes_per_pixel != 0 && bytes_per_pixel % static_cast<int>(sizeof(Scalar)) == 0 &&
+             stride_bytes % static_cast<int>(sizeof(Scalar)) == 0)
+    {
+        return source_image.get_width_pixels() * (bytes_per_pixel / static_cast<int>(sizeof(Scalar)));
+    }
+    throw error("Failed to map an image whose format does not divide into the matrix elements!");
+}
+/// @endcond
+} // namespace internal
+
+/** \class image_map k4aeigen.hpp <k4a/k4aeigen.hpp>
+ * An Eigen::Map of the pixels of an image, holding a reference to the image
+ *
+ * The matrix has a row per image row. DEPTH16, IR16, CUSTOM16 and CUSTOM8 images have a column per pixel when
+ * Scalar is the size of a pixel, BGRA32 images a column per pixel with a 32 bit Scalar or per channel with an 8 bit
+ * Scalar. CUSTOM images map their whole rows, for example the int16_t x, y and z of each point of a point cloud.
+ * Padded rows are skipped with the outer stride.
+ */
+template<typename Scalar>
+class image_map : public Eigen::Map<image_matrix<Scalar>, Eigen::Unaligned, Eigen::OuterStride<>>
+{
+public:
+    using map_type = Eigen::Map<image_matrix<Scalar>, Eigen::Unaligned, Eigen::OuterStride<>>;
+
+    /** Maps the pixels of an image without copying them
+     * Throws error if the image format does not divide into elements of Scalar
+     */
+    explicit image_map(image source_image) :
+        map_type(reinterpret_cast<Scalar *>(source_image.get_buffer()),
+                 source_image.get_height_pixels(),
+                 internal::eigen_map_cols<Scalar>(source_image),
+                 Eigen::OuterStride<>(source_image.get_stride_bytes() / static_cast<int>(sizeof(Scalar)))),
+        m_image(std::move(source_image))
+    {
+    }
+
+    image_map(const image_map &) = default;
+
+    // Assigning a map writes to the pixels, use the inherited operators to assign matrix expressions
+    image_map &operator=(const image_map &) = delete;
+    using map_type::operator=;
+
+    /** Returns the mapped image
+     */
+    const image &get_image() const noexcept
+    {
+        return m_image;
+    }
+
+private:
+    image m_image;
+};
+
+/** Maps the pixels of an image as a matrix of Scalar without copying them
+ * Throws error if the image format does not divide into elements of Scalar
+ *
+ * \sa image_map
+ */
+template<typename Scalar> image_map<Scalar> to_eigen_map(image source_image)
+{
+    return image_map<Scalar>(std::move(source_image));
+}
+
+/** Moves a matrix into an image without copying its elements
+ * Throws error if Scalar is not the size of a pixel of \p format
+ *
+ * \remarks
+ * The matrix is owned by the image and freed when the image is released. DEPTH16, IR16 and CUSTOM16 images need a 16
+ * bit Scalar, BGRA32 images a 32 bit Scalar and CUSTOM8 images an 8 bit Scalar, with a column per pixel. CUSTOM images
+ * have a pixel per element.
+ */
+template<typename Scalar> image from_eigen_matrix(image_matrix<Scalar> &&matrix, k4a_image_format_t format)
+{
+    int bytes_per_pixel = internal::eigen_bytes_per_pixel(format);
+    if (format != K4A_IMAGE_FORMAT_CUSTOM && bytes_per_pixel != static_cast<int>(sizeof(Scalar)))
+    {
+        throw error("Failed to create an image from a matrix whose elements are not pixels of the image format!");
+    }
+    if (matrix.size() == 0)
+    {
+        throw error("Failed to create an image from an empty matrix!");
+    }
+
+    image_matrix<Scalar> *owner = new image_matrix<Scalar>(std::move(matrix));
+    try
+    {
+        return image::create_from_buffer(
+            format,
+            static_cast<int>(owner->cols()),
+            static_cast<int>(owner->rows()),
+            static_cast<int>(owner->cols() * static_cast<Eigen::Index>(sizeof(Scalar))),
+            reinterpret_cast<uint8_t *>(owner->data()),
+            static_cast<size_t>(owner->size()) * sizeof(Scalar),
+            [](void *, void *context) { delete static_cast<image_matrix<Scalar> *>(context); },
+            owner);
+    }
+    catch (...)
+    {
+        delete owner;
+        throw;
+    }
+}
+
+/**
+ * @}
+ */
+
+} // namespace k4a
+
+#endif
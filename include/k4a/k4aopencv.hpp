@@ -0,0 +1,206 @@
+/** \file k4aopencv.hpp
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK - OpenCV adapters for the C++ wrapper.
+ *
+ * Header-only, include it after OpenCV to convert between k4a::image and cv::Mat without copying the pixels.
+ */
+
+#ifndef K4AOPENCV_HPP
+#define K4AOPENCV_HPP
+
+#include "k4a.hpp"
+
+#include <opencv2/core.hpp>
+
+namespace k4a
+{
+
+/**
+ * \addtogroup cppsdk
+ *
+ * @{
+ */
+
+// Helper functions not intended for use by client code
+//
+namespace internal
+{
+/// @cond FALSE
+/** Allocator of the cv::Mat wrapping a k4a_image_t
+ *
+ * The UMatData of a wrapped image holds a reference to the image, which is released with the last cv::Mat sharing it.
+ * It never allocates, a cv::Mat that is reallocated gets memory from the default allocator.
+ */
+class opencv_image_allocator : public cv::MatAllocator
+{
+public:
+#if CV_VERSION_MAJOR >= 4
+    using access_flag_t = cv::AccessFlag;
+#else
+    using access_flag_t = int;
+#endif
+
+    cv::UMatData *allocate(int, const int *, int, void *, size_t *, access_flag_t, cv::UMatUsageFlags) const override
+    {
+        return nullptr;
+    }
+
+    bool allocate(cv::UMatData *, access_flag_t, cv::UMatUsageFlags) const override
+    {
+        return false;
+    }
+
+    void deallocate(cv::UMatData *data) const override
+    {
+        if (data != nullptr)
+        {
+            k4a_image_release(static_cast<k4a_image_t>(data->userdata));
+            delete data;
+        }
+    }
+
+    /** Wraps the buffer of an image, the caller's reference to the image is moved to the returned UMatData
+     */
+    cv::UMatData *wrap(k4a_image_t handle) const
+    {
+        cv::UMatData *data = new cv::UMatData(this);
+        data->data = data->origdata = k4a_image_get_buffer(handle);
+        data->size = k4a_image_get_size(handle);
+        data->userdata = handle;
+        data->refcount = 1;
+        return data;
+    }
+
+    static const opencv_image_allocator &get()
+    {
+        static const opencv_image_allocator allocator;
+        return allocator;
+    }
+};
+
+inline void opencv_release_mat(void *buffer, void *context)
+{
+    (void)buffer;
+    delete static_cast<cv::Mat *>(context);
+}
+/// @endcond
+} // namespace internal
+
+/** Wraps an image as a cv::Mat without copying its pixels
+ * Throws error if the format has no matching cv::Mat type
+ *
+ * \remarks
+ * The cv::Mat and its copies hold a reference to the image, so the pixels stay valid after \p source_image is
+ * released. DEPTH16, IR16 and CUSTOM16 images are CV_16UC1, BGRA32 images CV_8UC4, CUSTOM8 images CV_8UC1 and YUY2
+ * images CV_8UC2. NV12 images are CV_8UC1 with the chroma rows under the luma rows, as cv::cvtColor() expects them.
+ * MJPG images are a single row of CV_8UC1 bytes for cv::imdecode().
+ */
+inline cv::Mat to_cv_mat(const image &source_image)
+{
+    if (!source_image)
+    {
+        throw error("Failed to wrap an invalid image!");
+    }
+
+    int rows = source_image.get_height_pixels();
+    int cols = source_image.get_width_pixels();
+    size_t step = static_cast<size_t>(source_image.get_stride_bytes());
+    int type = 0;
+    switch (source_image.get_format())
+    {
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+    case K4A_IMAGE_FORMAT_CUSTOM16:
+        type = CV_16UC1;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        type = CV_8UC4;
+        break;
+    case K4A_IMAGE_FORMAT_CUSTOM8:
+        type = CV_8UC1;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        type = CV_8UC2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        type = CV_8UC1;
+        rows = rows * 3 / 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        type = CV_8UC1;
+        rows = 1;
+        cols = static_cast<int>(source_image.get_size());
+        step = source_image.get_size();
+        break;
+    default:
+        throw error("Failed to wrap an image of a format without a cv::Mat type!");
+    }
+
+    cv::Mat mat(rows, cols, type, const_cast<uint8_t *>(source_image.get_buffer()), step);
+    k4a_image_t handle = source_image.handle();
+    k4a_image_reference(handle);
+    mat.u = internal::opencv_image_allocator::get().wrap(handle);
+    return mat;
+}
+
+/** Wraps a cv::Mat as an image without copying its pixels
+ * Throws error if the type of \p mat does not match \p format
+ *
+ * \remarks
+ * The image holds a reference to the pixels of \p mat, which stay valid while the image or a copy of it exists.
+ * DEPTH16, IR16 and CUSTOM16 images need a CV_16UC1 cv::Mat, BGRA32 images a CV_8UC4 and CUSTOM8 images a CV_8UC1.
+ * The rows of \p mat may be padded, for example when it is a region of a larger cv::Mat.
+ */
+inline image from_cv_mat(const cv::Mat &mat, k4a_image_format_t format)
+{
+    int type = -1;
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+    case K4A_IMAGE_FORMAT_CUSTOM16:
+        type = CV_16UC1;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        type = CV_8UC4;
+        break;
+    case K4A_IMAGE_FORMAT_CUSTOM8:
+        type = CV_8UC1;
+        break;
+    default:
+        break;
+    }
+    if (mat.dims != 2 || mat.empty() || mat.type() != type)
+    {
+        throw error("Failed to wrap a cv::Mat whose type does not match the image format!");
+    }
+
+    // The copy keeps the pixels of mat alive until the image is released
+    cv::Mat *owner = new cv::Mat(mat);
+    size_t size = owner->step[0] * static_cast<size_t>(owner->rows - 1) + owner->elemSize() * owner->cols;
+    try
+    {
+        return image::create_from_buffer(format,
+                                         owner->cols,
+                                         owner->rows,
+                                         static_cast<int>(owner->step[0]),
+                                         owner->data,
+                                         size,
+                                         internal::opencv_release_mat,
+                                         owner);
+    }
+    catch (...)
+    {
+        delete owner;
+        throw;
+    }
+}
+
+/**
+ * @}
+ */
+
+} // namespace k4a
+
+#endif
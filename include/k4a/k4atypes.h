@@ -194,6 +194,91 @@ K4A_DECLARE_HANDLE(k4a_image_t);
  */
 K4A_DECLARE_HANDLE(k4a_transformation_t);
 
+/** \class k4a_device_group_t k4a.h <k4a/k4a.h>
+ * Handle to a group of Azure Kinect devices in wired sync whose captures are matched by timestamp.
+ *
+ * \remarks
+ * Handles are created with k4a_device_group_create() and closed with k4a_device_group_destroy().
+ *
+ * \remarks
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_device_group_t);
+
+/** \class k4a_broker_t k4a.h <k4a/k4a.h>
+ * Handle to a broker sharing the captures of a device owned by this process with other processes.
+ *
+ * \remarks
+ * Handles are created with k4a_broker_create() and closed with k4a_broker_destroy().
+ *
+ * \remarks
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_broker_t);
+
+/** \class k4a_broker_client_t k4a.h <k4a/k4a.h>
+ * Handle to a broker created by another process, receiving the captures it shares.
+ *
+ * \remarks
+ * Handles are created with k4a_broker_attach() and closed with k4a_broker_detach().
+ *
+ * \remarks
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_broker_client_t);
+
+/** \class k4a_undistortion_map_t k4a.h <k4a/k4a.h>
+ * Handle to a precomputed map from the pixels of a pinhole camera to the pixels of a calibrated camera.
+ *
+ * \remarks
+ * Handles are created with k4a_undistortion_map_create() and closed with k4a_undistortion_map_destroy().
+ *
+ * \remarks
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_undistortion_map_t);
+
+/** \class k4a_tensor_converter_t k4a.h <k4a/k4a.h>
+ * Handle to a converter of images to the input tensors of neural networks.
+ *
+ * \remarks
+ * Handles are created with k4a_tensor_converter_create() and closed with k4a_tensor_converter_destroy().
+ *
+ * \remarks
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_tensor_converter_t);
+
 /**
  *
  * @}
@@ -317,6 +402,26 @@ typedef enum
     K4A_COLOR_RESOLUTION_3072P,   /**< 4096 * 3072 4:3  */
 } k4a_color_resolution_t;
 
+/** Scale of decoded color images.
+ *
+ * \remarks
+ * Used with k4a_device_set_color_scale() and k4a_playback_set_color_scale() to have MJPG frames decoded directly to a
+ * reduced resolution. Scaled dimensions are rounded up, so 1080P at ::K4A_COLOR_SCALE_EIGHTH is 240 * 135.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_COLOR_SCALE_FULL = 0, /**< Color images at the full color resolution */
+    K4A_COLOR_SCALE_HALF,     /**< 1/2 of the width and height of the color resolution */
+    K4A_COLOR_SCALE_QUARTER,  /**< 1/4 of the width and height of the color resolution */
+    K4A_COLOR_SCALE_EIGHTH,   /**< 1/8 of the width and height of the color resolution */
+} k4a_color_scale_t;
+
 /** Image format type.
  *
  * \remarks
@@ -462,6 +567,81 @@ typedef enum
     K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,      /**< Linear interpolation */
 } k4a_transformation_interpolation_type_t;
 
+/** Transformation point cloud format.
+ *
+ * \remarks
+ * Format of the points written by k4a_transformation_depth_image_to_point_cloud_with_format and
+ * k4a_transformation_depth_image_to_compact_point_cloud.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS = 0, /**< int16_t X, Y and Z in millimeters */
+    K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,        /**< float X, Y and Z in meters */
+} k4a_transformation_point_cloud_format_t;
+
+/** Tensor element type.
+ *
+ * \remarks
+ * Type of the elements written by k4a_tensor_converter_convert().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_TENSOR_DATA_TYPE_FLOAT32 = 0, /**< 32 bit IEEE float */
+    K4A_TENSOR_DATA_TYPE_FLOAT16,     /**< 16 bit IEEE half float, rounded to nearest even */
+} k4a_tensor_data_type_t;
+
+/** Transformation job type.
+ *
+ * \remarks
+ * Selects the transformation that a job submitted with k4a_transformation_submit() runs.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR = 0,    /**< k4a_transformation_depth_image_to_color_camera() */
+    K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR, /**< k4a_transformation_depth_image_to_color_camera_custom() */
+    K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH,        /**< k4a_transformation_color_image_to_depth_camera() */
+    K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD,  /**< k4a_transformation_depth_image_to_point_cloud() */
+} k4a_transformation_job_type_t;
+
+/** GPU resource types that transformation outputs can be exported as.
+ *
+ * \remarks
+ * Selects how k4a_transformation_depth_image_to_color_camera_gpu() and
+ * k4a_transformation_color_image_to_depth_camera_gpu() share their output with the application. Which types are
+ * available depends on the depth engine plugin and the platform.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_GPU_INTEROP_TYPE_OPENGL_TEXTURE = 0,   /**< OpenGL texture name in a context shared with the depth engine */
+    K4A_GPU_INTEROP_TYPE_OPENGL_BUFFER,        /**< OpenGL buffer name in a context shared with the depth engine */
+    K4A_GPU_INTEROP_TYPE_CUDA_EXTERNAL_MEMORY, /**< Memory handle to import with cudaImportExternalMemory() */
+    K4A_GPU_INTEROP_TYPE_D3D11_SHARED_HANDLE,  /**< Shared handle to open with ID3D11Device::OpenSharedResource() */
+} k4a_gpu_interop_type_t;
+
 /** Color and depth sensor frame rate.
  *
  * \remarks
@@ -720,6 +900,162 @@ typedef enum
     K4A_FIRMWARE_SIGNATURE_UNSIGNED /**< Unsigned firmware. */
 } k4a_firmware_signature_t;
 
+/** Streams with an application facing queue that can be configured.
+ *
+ * \see k4a_device_set_queue_policy()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_QUEUE_STREAM_CAPTURE = 0, /**< Captures read with k4a_device_get_capture(). */
+    K4A_QUEUE_STREAM_IMU,         /**< Samples read with k4a_device_get_imu_sample(). */
+} k4a_queue_stream_t;
+
+/** What happens when a stream produces data while its queue is full.
+ *
+ * \see k4a_device_set_queue_policy()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_QUEUE_POLICY_DROP_OLDEST = 0, /**< Drop the oldest entry to make room, readers always get the latest data. */
+    K4A_QUEUE_POLICY_DROP_NEWEST,     /**< Drop the new entry, the queued entries are kept. */
+    K4A_QUEUE_POLICY_BLOCK,           /**< Block the producing SDK thread until the application makes room. */
+} k4a_queue_policy_t;
+
+/** Roles of the threads created by the SDK.
+ *
+ * \see k4a_set_thread_affinity()
+ * \see k4a_set_thread_priority()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_THREAD_ROLE_USB = 0,          /**< USB event threads reading the depth and IMU streams, one per device. */
+    K4A_THREAD_ROLE_DEPTH_ENGINE,     /**< Depth engine threads, two per device streaming depth. */
+    K4A_THREAD_ROLE_TRANSFORM_ENGINE, /**< Transform engine threads of GPU accelerated transformations. */
+    K4A_THREAD_ROLE_COLOR,            /**< Color frame decoding threads. */
+    K4A_THREAD_ROLE_WORKER,           /**< Threads of the shared worker pool and transformation submission threads. */
+    K4A_THREAD_ROLE_NUM,              /**< Number of thread roles. */
+} k4a_thread_role_t;
+
+/** Scheduling priority of the threads of a role.
+ *
+ * \see k4a_set_thread_priority()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_THREAD_PRIORITY_DEFAULT = 0, /**< Scheduled like any other thread of the process. */
+    K4A_THREAD_PRIORITY_HIGH,        /**< Preferred over threads at default priority. */
+    K4A_THREAD_PRIORITY_REALTIME,    /**< Real-time scheduling, SCHED_FIFO on Linux and MMCSS on Windows. */
+} k4a_thread_priority_t;
+
+/** Stages of the depth capture pipeline, from the USB transfer of a frame to the capture returned to the user.
+ *
+ * \see k4a_get_latency_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_LATENCY_STAGE_DEPTH_QUEUE = 0, /**< From USB transfer completion until the depth engine starts on the frame. */
+    K4A_LATENCY_STAGE_DEPTH_ENGINE,    /**< Depth engine processing of the frame. */
+    K4A_LATENCY_STAGE_CAPTURE_SYNC,    /**< From depth engine completion until the capture is matched and published. */
+    K4A_LATENCY_STAGE_USER,            /**< From publishing until the capture is read by k4a_device_get_capture(). */
+    K4A_LATENCY_STAGE_TOTAL,           /**< From USB transfer completion until read by k4a_device_get_capture(). */
+    K4A_LATENCY_STAGE_NUM,             /**< Number of latency stages. */
+} k4a_latency_stage_t;
+
+/** Kinds of metrics returned by k4a_device_get_metrics().
+ *
+ * \see k4a_metric_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_METRIC_TYPE_COUNTER = 0, /**< Cumulative value that only grows, until the statistic behind it is reset. */
+    K4A_METRIC_TYPE_GAUGE,       /**< Value that can go up and down. */
+    K4A_METRIC_TYPE_HISTOGRAM,   /**< Distribution of observations in buckets. */
+} k4a_metric_type_t;
+
+/** USB streaming endpoints of a device.
+ *
+ * \see k4a_device_get_usb_stream_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_USB_STREAM_DEPTH = 0, /**< Raw depth frames from the depth processor. */
+    K4A_USB_STREAM_IMU,       /**< IMU samples from the color processor. */
+} k4a_usb_stream_t;
+
+/** Device changes reported to a hotplug callback.
+ *
+ * \see k4a_set_device_hotplug_callback()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_DEVICE_HOTPLUG_ARRIVED = 0, /**< A device was attached. */
+    K4A_DEVICE_HOTPLUG_REMOVED,     /**< A device was detached. */
+} k4a_device_hotplug_event_t;
+
+/** How 16 bit IR values are mapped to the 8 bit IR images of a device.
+ *
+ * \see k4a_ir8_configuration_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_IR_TONE_MAPPING_SHIFT = 0,  /**< Values are shifted right by a fixed number of bits and clamped to 255. */
+    K4A_IR_TONE_MAPPING_PERCENTILE, /**< The range between two percentiles of each image is stretched to 0 to 255. */
+} k4a_ir_tone_mapping_t;
+
 /**
  *
  * @}
@@ -786,6 +1122,17 @@ typedef enum
  *    't'  - log all messages of level 'trace' or higher criticality
  *    DEFAULT - log all message of level 'error' or higher criticality
  *
+ * K4A_LOG_ASYNC =
+ *    0    - write messages to the file or stdout from the thread logging them
+ *    all else  - queue messages to a background thread that writes them, messages are dropped while the queue is full
+ *    DEFAULT - write messages from the thread logging them
+ *
+ * K4A_LOG_RATE_LIMIT =
+ *    0    - disable rate limiting
+ *    N    - log at most N warnings and errors per second from each place in the SDK that logs them, this applies to
+ *           the callback set with \p k4a_set_debug_message_handler as well
+ *    DEFAULT - rate limiting is disabled
+ *
  * See remarks section of \p k4a_set_debug_message_handler
  *
  * @{
@@ -891,22 +1238,25 @@ typedef void(k4a_memory_destroy_cb_t)(void *buffer, void *context);
  */
 typedef uint8_t *(k4a_memory_allocate_cb_t)(int size, void **context);
 
-/**
- *
- * @}
- *
- * \defgroup Structures Structures
- * \ingroup csdk
+/** Part of the SDK a buffer is allocated for.
  *
- * Structures used in the API.
- *
- * @{
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
  */
+typedef enum
+{
+    K4A_ALLOCATION_SOURCE_USER = 0,  /**< Images created by the application. */
+    K4A_ALLOCATION_SOURCE_DEPTH,     /**< Depth and IR images and the buffers they are computed in. */
+    K4A_ALLOCATION_SOURCE_COLOR,     /**< Color images. */
+    K4A_ALLOCATION_SOURCE_IMU,       /**< IMU samples. */
+    K4A_ALLOCATION_SOURCE_USB_DEPTH, /**< USB transfers of the depth camera. */
+    K4A_ALLOCATION_SOURCE_USB_IMU,   /**< USB transfers of the IMU. */
+} k4a_allocation_source_t;
 
-/** Configuration parameters for an Azure Kinect device.
- *
- * \remarks
- * Used by k4a_device_start_cameras() to specify the configuration of the data capture.
+/** Description of a buffer requested from an allocator set with k4a_set_allocator_ex().
  *
  * \xmlonly
  * <requirements>
@@ -914,19 +1264,183 @@ typedef uint8_t *(k4a_memory_allocate_cb_t)(int size, void **context);
  * </requirements>
  * \endxmlonly
  */
-typedef struct _k4a_device_configuration_t
+typedef struct _k4a_allocation_info_t
 {
-    /** Image format to capture with the color camera.
-     *
-     * The color camera does not natively produce BGRA32 images.
-     * Setting ::K4A_IMAGE_FORMAT_COLOR_BGRA32 for color_format will result in higher CPU utilization. */
-    k4a_image_format_t color_format;
+    /** Minimum size of the buffer in bytes. It includes a header of up to 64 bytes the SDK stores in front of the
+     * data. */
+    size_t size;
 
-    /** Image resolution to capture with the color camera. */
-    k4a_color_resolution_t color_resolution;
+    /** Alignment in bytes the buffer must start at, a power of two. */
+    size_t alignment;
 
-    /** Capture mode for the depth camera. */
-    k4a_depth_mode_t depth_mode;
+    /** Part of the SDK the buffer is for. */
+    k4a_allocation_source_t source;
+
+    /** Format of the image the buffer holds. ::K4A_IMAGE_FORMAT_CUSTOM for buffers that do not hold an image of a
+     * known format, such as USB transfers and IMU samples. */
+    k4a_image_format_t format;
+} k4a_allocation_info_t;
+
+/** Callback function for a memory allocation described by its source, image format and alignment.
+ *
+ * \param info
+ * Size, alignment, source and image format of the buffer.
+ *
+ * \param user_context
+ * Context passed to k4a_set_allocator_ex().
+ *
+ * \param context
+ * Output parameter for a context that will be provided in the subsequent call to the \ref k4a_memory_destroy_cb_t
+ * callback.
+ *
+ * \return
+ * A pointer to the newly allocated memory, aligned to info->alignment, or NULL if it could not be allocated.
+ *
+ * \remarks
+ * A callback of this type lets an application place the buffers of each source in memory it chose, for example depth
+ * frames in page locked memory that a GPU reads with DMA.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef uint8_t *(k4a_memory_allocate_ex_cb_t)(const k4a_allocation_info_t *info, void *user_context, void **context);
+
+/** Callback function for a capture being produced by the device.
+ *
+ * \param result
+ * ::K4A_RESULT_SUCCEEDED if \p capture_handle holds a new capture. ::K4A_RESULT_FAILED if an internal error ended the
+ * stream, in which case \p capture_handle is NULL.
+ *
+ * \param capture_handle
+ * The capture that was produced. The capture is only valid for the duration of the callback, call
+ * k4a_capture_reference() to keep it longer.
+ *
+ * \param context
+ * The context that was supplied by the caller to \p k4a_device_set_capture_callback.
+ *
+ * \remarks
+ * The callback is called from an internal SDK thread as soon as a capture is produced and blocks the delivery of
+ * further captures until it returns. All care should be made to return quickly.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef void(k4a_capture_cb_t)(k4a_result_t result, k4a_capture_t capture_handle, void *context);
+
+/** Callback function for the completion of transformation jobs.
+ *
+ * \param result
+ * ::K4A_RESULT_SUCCEEDED if all jobs of the submission succeeded. ::K4A_RESULT_FAILED if any of them failed.
+ *
+ * \param context
+ * The context that was supplied by the caller to \p k4a_transformation_submit.
+ *
+ * \remarks
+ * The callback is called from an internal SDK thread once all jobs of a submission completed, before the SDK releases
+ * its references to the images of the jobs. It blocks the processing of further submissions until it returns.
+ *
+ * \remarks
+ * The callback must not call k4a_transformation_wait_idle() or k4a_transformation_destroy().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef void(k4a_transformation_completion_cb_t)(k4a_result_t result, void *context);
+
+/** Callback function reading the current time of a shared timebase.
+ *
+ * \param context
+ * The context that was supplied by the caller to \p k4a_set_shared_timebase_callback.
+ *
+ * \returns
+ * The current time of the shared timebase in nanoseconds, or 0 if the time can not be read.
+ *
+ * \remarks
+ * The callback is called from the threads that convert timestamps to the shared timebase, and must be fast and
+ * thread safe. The SDK reads it several times in a row to bracket each reading with its own clock.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef uint64_t(k4a_shared_timebase_cb_t)(void *context);
+
+/** Callback function notified when devices are attached or detached.
+ *
+ * \param context
+ * The context that was supplied by the caller to \p k4a_set_device_hotplug_callback.
+ *
+ * \param event
+ * Whether a device was attached or detached.
+ *
+ * \param device_count
+ * The number of connected devices after the change, as returned by k4a_device_get_installed_count().
+ *
+ * \remarks
+ * The callback is called from the thread monitoring the devices. It must not call
+ * k4a_set_device_hotplug_callback(), and should return quickly; opening a device that arrived is best done from
+ * another thread.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef void(k4a_device_hotplug_cb_t)(void *context, k4a_device_hotplug_event_t event, uint32_t device_count);
+
+/**
+ *
+ * @}
+ *
+ * \defgroup Structures Structures
+ * \ingroup csdk
+ *
+ * Structures used in the API.
+ *
+ * @{
+ */
+
+/** Configuration parameters for an Azure Kinect device.
+ *
+ * \remarks
+ * Used by k4a_device_start_cameras() to specify the configuration of the data capture.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_device_configuration_t
+{
+    /** Image format to capture with the color camera.
+     *
+     * The color camera does not natively produce BGRA32 images.
+     * Setting ::K4A_IMAGE_FORMAT_COLOR_BGRA32 for color_format will result in higher CPU utilization. */
+    k4a_image_format_t color_format;
+
+    /** Image resolution to capture with the color camera. */
+    k4a_color_resolution_t color_resolution;
+
+    /** Capture mode for the depth camera. */
+    k4a_depth_mode_t depth_mode;
 
     /** Desired frame rate for the color and depth camera. */
     k4a_fps_t camera_fps;
@@ -1114,6 +1628,212 @@ typedef struct _k4a_calibration_t
     k4a_color_resolution_t color_resolution; /**< Color camera resolution for which calibration was obtained. */
 } k4a_calibration_t;
 
+/** Region of interest of the transformation functions.
+ *
+ * \remarks
+ * The region is given in pixels of the depth camera. The transformation functions process the pixels (x + i *
+ * decimation, y + j * decimation) of the region, where i and j start at 0. See
+ * k4a_transformation_set_region_of_interest().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_transformation_roi_t
+{
+    int x;          /**< Column of the top left pixel of the region. */
+    int y;          /**< Row of the top left pixel of the region. */
+    int width;      /**< Width of the region in pixels. */
+    int height;     /**< Height of the region in pixels. */
+    int decimation; /**< Distance in pixels between two processed pixels of a row or a column, 1 for every pixel. */
+} k4a_transformation_roi_t;
+
+/** Pinhole camera without distortion that images are undistorted to.
+ *
+ * \remarks
+ * See k4a_undistortion_map_create().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_pinhole_t
+{
+    float cx;   /**< Principal point in image, x, in pixels. */
+    float cy;   /**< Principal point in image, y, in pixels. */
+    float fx;   /**< Focal length x, in pixels. */
+    float fy;   /**< Focal length y, in pixels. */
+    int width;  /**< Width of the images in pixels. */
+    int height; /**< Height of the images in pixels. */
+} k4a_pinhole_t;
+
+/** Configuration of a tensor converter.
+ *
+ * \remarks
+ * See k4a_tensor_converter_create(). Each element of the tensor is (value * scale - mean) / std, where value is the
+ * image value of the pixel and channel, resized when the tensor and the image are of different sizes. BGRA32 images
+ * give three channels without alpha, DEPTH16 and IR16 images give one channel normalized with mean[0] and std[0].
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_tensor_configuration_t
+{
+    k4a_image_format_t format;        /**< Format of the images, BGRA32, DEPTH16 or IR16. */
+    int image_width;                  /**< Width of the images in pixels. */
+    int image_height;                 /**< Height of the images in pixels. */
+    int tensor_width;                 /**< Width of the tensor, W, the image is resized if it differs. */
+    int tensor_height;                /**< Height of the tensor, H, the image is resized if it differs. */
+    k4a_tensor_data_type_t data_type; /**< Type of the tensor elements. */
+    bool rgb;                         /**< R, G, B channel order instead of the B, G, R order of the image. */
+    float scale;                      /**< Factor applied to each value first, for example 1/255. */
+    float mean[3];                    /**< Mean subtracted from each channel, in tensor order. */
+    float std[3];                     /**< Standard deviation dividing each channel, in tensor order. */
+} k4a_tensor_configuration_t;
+
+/** Transformation job.
+ *
+ * \remarks
+ * Describes one transformation submitted with k4a_transformation_submit(). The images and parameters are those of the
+ * synchronous function that \p type names, images the job type does not use are NULL.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_transformation_job_t
+{
+    k4a_transformation_job_type_t type; /**< Transformation the job runs. */
+    k4a_image_t depth_image;            /**< Depth image to transform. */
+
+    /** Custom image of a depth and custom to color job, or color image of a color to depth job. */
+    k4a_image_t source_image;
+
+    /** Transformed depth image, transformed color image or point cloud image. */
+    k4a_image_t transformed_image;
+
+    /** Transformed custom image of a depth and custom to color job. */
+    k4a_image_t transformed_source_image;
+
+    /** Interpolation of the custom image, or sampling of the color image of a color to depth job. */
+    k4a_transformation_interpolation_type_t interpolation_type;
+
+    uint32_t invalid_custom_value; /**< Invalid custom value of a depth and custom to color job. */
+    k4a_calibration_type_t camera; /**< Camera the depth image of a point cloud job was captured with. */
+
+    /** Format of the points of a point cloud job. */
+    k4a_transformation_point_cloud_format_t point_cloud_format;
+} k4a_transformation_job_t;
+
+/** Transformation output exported as a GPU resource.
+ *
+ * \remarks
+ * Filled in by k4a_transformation_depth_image_to_color_camera_gpu() and
+ * k4a_transformation_color_image_to_depth_camera_gpu(), and released with k4a_transformation_release_gpu_resource().
+ * The pixels are laid out as in the ::k4a_image_t the host memory functions write.
+ *
+ * \remarks
+ * \p handle and \p fence are 64 bit values whose meaning depends on \p type. For OpenGL they are the texture or buffer
+ * name and a GLsync object. For CUDA they are the memory and semaphore handles to import, a file descriptor on Linux
+ * and a Win32 handle on Windows. For D3D11 they are the shared handles of the texture and of an ID3D11Fence.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_gpu_resource_t
+{
+    k4a_gpu_interop_type_t type; /**< How the resource is shared. */
+    k4a_image_format_t format;   /**< Format of the pixels. */
+    int width_pixels;            /**< Width of the image in pixels. */
+    int height_pixels;           /**< Height of the image in pixels. */
+    int stride_bytes;            /**< Distance in bytes between the starts of two rows. */
+    size_t size;                 /**< Size of the resource in bytes. */
+    uint64_t handle;             /**< Handle of the resource. */
+
+    /** Fence that is signaled once the GPU finished writing the resource, 0 if it was written when the call returned.
+     */
+    uint64_t fence;
+} k4a_gpu_resource_t;
+
+/** Configuration of the export of depth engine output as GPU resources.
+ *
+ * \remarks
+ * Passed to k4a_device_set_depth_gpu_export(). The depth and IR images of a capture then carry the GPU resource the
+ * depth engine wrote them to, see k4a_image_get_gpu_resource().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_depth_gpu_export_configuration_t
+{
+    k4a_gpu_interop_type_t type; /**< How the resources are shared. */
+
+    /** Don't copy the depth image to host memory, captures then have no depth image. The IR image is always copied, it
+     * is needed to synchronize captures. */
+    bool skip_depth_readback;
+} k4a_depth_gpu_export_configuration_t;
+
+/** Number of bins in the histogram of \ref k4a_depth_statistics_t.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_DEPTH_STATISTICS_HISTOGRAM_BINS (16)
+
+/** Width in millimeters of each bin in the histogram of \ref k4a_depth_statistics_t.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_DEPTH_STATISTICS_BIN_WIDTH_MM (512)
+
+/** Statistics of the valid pixels of a depth image.
+ *
+ * \remarks
+ * A pixel is valid when its depth is not 0. The statistics are computed once per capture while the depth image is
+ * produced, see k4a_image_get_depth_statistics().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_depth_statistics_t
+{
+    uint32_t valid_pixel_count; /**< Pixels with a depth. */
+    uint16_t min_mm;            /**< Smallest depth, 0 if no pixel is valid. */
+    uint16_t max_mm;            /**< Largest depth, 0 if no pixel is valid. */
+    float mean_mm;              /**< Mean depth, 0 if no pixel is valid. */
+
+    /**
+     * Valid pixels by depth. Bin N counts depths from N * K4A_DEPTH_STATISTICS_BIN_WIDTH_MM up to
+     * (N + 1) * K4A_DEPTH_STATISTICS_BIN_WIDTH_MM and the last bin counts every larger depth.
+     */
+    uint32_t histogram[K4A_DEPTH_STATISTICS_HISTOGRAM_BINS];
+} k4a_depth_statistics_t;
+
 /** Version information.
  *
  * \xmlonly
@@ -1205,6 +1925,413 @@ typedef struct _k4a_imu_sample_t
     uint64_t gyro_timestamp_usec; /**< Timestamp of the gyroscope in microseconds */
 } k4a_imu_sample_t;
 
+/** Allocator statistics for a single source of SDK buffers.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_allocator_source_stats_t
+{
+    uint64_t live_count;        /**< Number of buffers currently allocated. */
+    uint64_t live_bytes;        /**< Bytes currently allocated. */
+    uint64_t peak_bytes;        /**< Largest value reached by live_bytes. */
+    uint64_t total_allocations; /**< Cumulative number of allocations, sample over time to derive a rate. */
+} k4a_allocator_source_stats_t;
+
+/** Allocator statistics for all sources of SDK buffers.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_allocator_stats_t
+{
+    k4a_allocator_source_stats_t user;      /**< Buffers allocated for images created by the application. */
+    k4a_allocator_source_stats_t depth;     /**< Buffers allocated by the depth reader. */
+    k4a_allocator_source_stats_t color;     /**< Buffers allocated by the color reader. */
+    k4a_allocator_source_stats_t imu;       /**< Buffers allocated by the IMU reader. */
+    k4a_allocator_source_stats_t usb_depth; /**< Buffers allocated by the USB reader for depth. */
+    k4a_allocator_source_stats_t usb_imu;   /**< Buffers allocated by the USB reader for IMU. */
+} k4a_allocator_stats_t;
+
+/** Statistics of the captures synchronized for a device.
+ *
+ * \remarks
+ * Counters are cumulative since the cameras were last started with k4a_device_start_cameras(). Queue counts are a
+ * snapshot taken when the statistics are read.
+ *
+ * \see k4a_device_get_capture_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_capture_stats_t
+{
+    uint64_t synchronized_captures; /**< Captures published with matching color and depth images. */
+
+    /** Depth captures dropped at start while waiting for the device timestamps to reset. */
+    uint64_t depth_dropped_timestamp_reset;
+
+    uint64_t depth_unmatched;       /**< Depth captures that had no color image within the sync window. */
+    uint64_t color_unmatched;       /**< Color captures that had no depth image within the sync window. */
+    uint64_t depth_queue_overflow;  /**< Depth captures released early because the depth sync queue was full. */
+    uint64_t color_queue_overflow;  /**< Color captures released early because the color sync queue was full. */
+    uint64_t output_queue_overflow; /**< Captures dropped because the application didn't read them fast enough. */
+
+    /**
+     * Average of the depth image timestamp minus the color image timestamp of synchronized captures, in microseconds.
+     * This includes the configured depth_delay_off_color_usec.
+     */
+    int64_t average_skew_usec;
+
+    uint32_t depth_queue_count;  /**< Depth captures waiting for a matching color capture. */
+    uint32_t color_queue_count;  /**< Color captures waiting for a matching depth capture. */
+    uint32_t output_queue_count; /**< Captures waiting to be read with k4a_device_get_capture(). */
+} k4a_capture_stats_t;
+
+/** Number of buckets in the transfer latency histogram of \ref k4a_usb_stream_stats_t.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_USB_LATENCY_HISTOGRAM_BUCKETS (12)
+
+/** Statistics of a USB streaming endpoint of a device.
+ *
+ * \remarks
+ * Counters are cumulative since the stream was last started. Transfer counts and the receive rate are a snapshot taken
+ * when the statistics are read.
+ *
+ * \see k4a_device_get_usb_stream_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_usb_stream_stats_t
+{
+    uint64_t completed_transfers; /**< Transfers that completed with data. */
+    uint64_t bytes_transferred;   /**< Bytes received by completed transfers. */
+    uint64_t bytes_per_second;    /**< Receive rate over the last full second of streaming. */
+    uint64_t timed_out_transfers; /**< Transfers that timed out waiting for the device. */
+    uint64_t overflow_transfers;  /**< Transfers that ended because the device sent more than the transfer size. */
+    uint64_t failed_transfers;    /**< Transfers that ended with any other error. */
+    uint64_t resubmit_failures;   /**< Completed transfers that could not be submitted again. */
+    uint64_t stream_recoveries;   /**< Times the endpoint was restarted in place after a transfer error. */
+
+    uint32_t transfers_in_flight; /**< Transfers submitted and waiting for data. */
+    uint32_t transfer_target;     /**< Transfers the stream keeps submitted, tuned at run time in adaptive mode. */
+    uint32_t transfer_size;       /**< Size of each transfer in bytes. */
+
+    /**
+     * Time from submitting a transfer to its completion. Bucket 0 counts transfers under 1 ms, bucket N counts
+     * transfers from 2^(N-1) ms up to 2^N ms and the last bucket counts every slower transfer.
+     */
+    uint64_t latency_histogram[K4A_USB_LATENCY_HISTOGRAM_BUCKETS];
+} k4a_usb_stream_stats_t;
+
+/** A stream of a device to wait for with k4a_device_wait_any().
+ *
+ * \see k4a_device_wait_any()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_wait_source_t
+{
+    k4a_device_t device;       /**< Handle obtained by k4a_device_open(). */
+    k4a_queue_stream_t stream; /**< The stream of the device to wait for. */
+
+    /** Set by k4a_device_wait_any() when the stream can be read without blocking. */
+    bool ready;
+} k4a_wait_source_t;
+
+/** Number of buckets in the histogram of \ref k4a_latency_stats_t.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_LATENCY_HISTOGRAM_BUCKETS (16)
+
+/** Latency statistics of a stage of the depth capture pipeline.
+ *
+ * \remarks
+ * Statistics are cumulative since the process started or since k4a_reset_latency_stats() was last called.
+ *
+ * \see k4a_get_latency_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_latency_stats_t
+{
+    uint64_t count;      /**< Captures that went through the stage. */
+    uint64_t min_usec;   /**< Shortest time spent in the stage, in microseconds. */
+    uint64_t max_usec;   /**< Longest time spent in the stage, in microseconds. */
+    uint64_t total_usec; /**< Sum of the time spent in the stage, divide by count for the mean. */
+
+    /**
+     * Time spent in the stage. Bucket 0 counts captures under 64 us, bucket N counts captures from 2^(N+5) us up to
+     * 2^(N+6) us and the last bucket counts every slower capture.
+     */
+    uint64_t histogram[K4A_LATENCY_HISTOGRAM_BUCKETS];
+} k4a_latency_stats_t;
+
+/** Maximum number of buckets of a histogram in \ref k4a_metric_t.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_METRIC_HISTOGRAM_BUCKETS (16)
+
+/** A metric of the SDK, in a form that maps directly to Prometheus and OpenTelemetry.
+ *
+ * \remarks
+ * Names follow the Prometheus conventions: they start with "k4a_", values are in base units such as seconds and bytes
+ * and the unit ends the name, and counters end in "_total". A metric that exists once per stream, queue or stage
+ * carries a label naming which one it is. The strings are static and stay valid for the life of the process.
+ *
+ * \see k4a_device_get_metrics()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_metric_t
+{
+    const char *name;        /**< Name of the metric. */
+    const char *help;        /**< One line description of the metric. */
+    const char *label_name;  /**< Name of the label, NULL if the metric has none. */
+    const char *label_value; /**< Value of the label, NULL if the metric has none. */
+    k4a_metric_type_t type;  /**< Kind of the metric. */
+
+    /** Value of a counter or gauge. For a histogram, the sum of all observations. */
+    double value;
+
+    uint64_t count;        /**< Number of observations of a histogram, 0 for other kinds. */
+    uint32_t bucket_count; /**< Number of buckets of a histogram, 0 for other kinds. */
+
+    /** Inclusive upper bound of each bucket of a histogram. The last bound is infinity. */
+    double bucket_upper_bounds[K4A_METRIC_HISTOGRAM_BUCKETS];
+
+    /**
+     * Observations in each bucket of a histogram, not cumulative: bucket N counts the observations above the bound of
+     * bucket N-1. Add the counts up for the "le" buckets of Prometheus.
+     */
+    uint64_t bucket_counts[K4A_METRIC_HISTOGRAM_BUCKETS];
+} k4a_metric_t;
+
+/** Callback function receiving the metrics of a device periodically.
+ *
+ * \param device_handle
+ * The device the metrics belong to.
+ *
+ * \param metrics
+ * The metrics of the device, only valid for the duration of the callback.
+ *
+ * \param metric_count
+ * Number of elements of \p metrics.
+ *
+ * \param context
+ * The context that was supplied by the caller to \p k4a_device_set_metrics_callback.
+ *
+ * \remarks
+ * The callback is called from a thread of the device that only collects metrics, it doesn't delay any stream.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef void(k4a_metrics_cb_t)(k4a_device_t device_handle,
+                               const k4a_metric_t *metrics,
+                               size_t metric_count,
+                               void *context);
+
+/** Filters the depth engine runs on the depth images of a device.
+ *
+ * \remarks
+ * A zero initialized configuration disables every filter. The filters run in the order edge removal, temporal
+ * smoothing, hole filling, on the depth image buffer itself. The IR image is not filtered.
+ *
+ * \see k4a_device_set_depth_filter()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_depth_filter_configuration_t
+{
+    /**
+     * Invalidates pixels whose depth differs by more than this many millimeters from a valid pixel to their left,
+     * right, top or bottom, which removes the flying pixels along object edges. 0 disables edge removal.
+     */
+    uint16_t edge_threshold_mm;
+
+    /**
+     * Weight of the new depth image in the temporal smoothing, between 0 and 1. Each pixel becomes the weighted average
+     * of its new depth and its smoothed depth of the previous image. 0 disables temporal smoothing.
+     */
+    float temporal_alpha;
+
+    /**
+     * Pixels whose depth changed by more than this many millimeters since the previous image, or that were invalid in
+     * either image, are not smoothed so moving objects don't leave a trail. 0 smooths every pixel that is valid in both
+     * images.
+     */
+    uint16_t temporal_threshold_mm;
+
+    /**
+     * Number of hole filling passes. Each pass gives invalid pixels next to a valid pixel the depth of their farthest
+     * valid neighbor, so holes up to twice this many pixels wide are closed. 0 disables hole filling.
+     */
+    uint32_t hole_fill_passes;
+
+    /**
+     * Number of threads the filters run on. 0 or 1 runs them on the depth engine thread, more splits each image across
+     * the shared SDK worker threads, see k4a_set_worker_thread_count().
+     */
+    uint32_t thread_count;
+} k4a_depth_filter_configuration_t;
+
+/** Tone mapping of the 8 bit IR images the depth engine outputs instead of IR16 images.
+ *
+ * \remarks
+ * Each pixel of the ::K4A_IMAGE_FORMAT_CUSTOM8 image is the IR value mapped to 0 to 255, with the values below the
+ * low end of the range mapped to 0 and the values above the high end mapped to 255.
+ *
+ * \see k4a_device_set_ir8_output()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_ir8_configuration_t
+{
+    k4a_ir_tone_mapping_t tone_mapping; /**< How the range of IR values is chosen. */
+
+    /**
+     * With ::K4A_IR_TONE_MAPPING_SHIFT, the number of bits the IR values are shifted right, up to 8. The range is then
+     * 0 to 255 shifted left by this many bits, the same for every image.
+     */
+    uint32_t shift;
+
+    /**
+     * With ::K4A_IR_TONE_MAPPING_PERCENTILE, the percentage of the pixels of each image mapped to 0, from 0 up to
+     * high_percentile.
+     */
+    float low_percentile;
+
+    /**
+     * With ::K4A_IR_TONE_MAPPING_PERCENTILE, the percentage of the pixels of each image mapped below 255, up to 100.
+     */
+    float high_percentile;
+} k4a_ir8_configuration_t;
+
+/** Callback function notified when the depth engine of a device becomes overloaded and when it recovers.
+ *
+ * \param context
+ * The callback_context of the k4a_depth_engine_overload_configuration_t.
+ *
+ * \param overloaded
+ * true when the depth engine has become overloaded and drops raw frames, false when it has recovered.
+ *
+ * \param compute_time_usec
+ * Time the depth engine took to process the frame that changed the state.
+ *
+ * \remarks
+ * The callback is called from the depth engine thread of the device. It should only record the state change and
+ * return, for example to lower the load the application puts on the GPU. It must not call into the SDK for the same
+ * device.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef void(k4a_depth_engine_overload_cb_t)(void *context, bool overloaded, uint32_t compute_time_usec);
+
+/** What the depth engine of a device does when it can't keep up with the frame rate.
+ *
+ * \remarks
+ * The depth engine is overloaded once it took longer than the period of the raw frames it is posted for \p
+ * frame_count frames in a row. It then processes only the newest raw frame of its queue and drops every other raw
+ * frame, so the latency of the captures doesn't build up, until \p frame_count frames in a row are processed in time.
+ *
+ * \see k4a_device_set_depth_engine_overload_policy()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_depth_engine_overload_configuration_t
+{
+    /** Consecutive frames over or within the frame period that change the state, 0 to never drop raw frames. */
+    uint32_t frame_count;
+
+    /** Called when the state changes, NULL for none. */
+    k4a_depth_engine_overload_cb_t *callback;
+
+    /** Context passed to \p callback. */
+    void *callback_context;
+} k4a_depth_engine_overload_configuration_t;
+
+/** Timestamps of the images of a capture in the shared timebase.
+ *
+ * \remarks
+ * Each timestamp is 0 if the capture has no image of that type.
+ *
+ * \see k4a_device_get_capture_shared_timestamps()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_capture_shared_timestamps_t
+{
+    uint64_t color_timestamp_nsec; /**< Device timestamp of the color image, in the shared timebase. */
+    uint64_t depth_timestamp_nsec; /**< Device timestamp of the depth image, in the shared timebase. */
+    uint64_t ir_timestamp_nsec;    /**< Device timestamp of the IR image, in the shared timebase. */
+} k4a_capture_shared_timestamps_t;
+
 /**
  *
  * @}
@@ -1239,6 +2366,55 @@ typedef struct _k4a_imu_sample_t
  */
 #define K4A_WAIT_INFINITE (-1)
 
+/** Runs the depth engine on the GPU the depth engine plugin picks.
+ *
+ * Passed as an argument to \ref k4a_device_set_depth_engine_gpu(). This is the default.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_DEPTH_ENGINE_GPU_DEFAULT (-1)
+
+/** Runs the depth engine on the GPU with the least depth processing load from the devices opened by this process.
+ *
+ * Passed as an argument to \ref k4a_device_set_depth_engine_gpu().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_DEPTH_ENGINE_GPU_AUTO (-2)
+
+/** Number of GPU resources the depth engine exports into in turn.
+ *
+ * \remarks
+ * A resource exported with a capture is written again K4A_DEPTH_GPU_EXPORT_SLOT_COUNT captures later, see
+ * k4a_device_set_depth_gpu_export().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_DEPTH_GPU_EXPORT_SLOT_COUNT (4)
+
+/** Largest number of custom images that one call to \ref k4a_transformation_depth_image_to_color_camera_custom_images()
+ * transforms.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES (8)
+
 /** Initial configuration setting for disabling all sensors.
  *
  * \remarks
@@ -16,6 +16,10 @@ extern "C" {
 #endif
 
 /** Allocation Source.
+ *
+ * \remarks
+ * The values match ::k4a_allocation_source_t, which is how the source is passed to an allocator set with
+ * allocator_set_allocator_ex().
  *
  * \xmlonly
  * <requirements>
@@ -25,14 +29,27 @@ extern "C" {
  */
 typedef enum
 {
-    ALLOCATION_SOURCE_USER = 0,  /**< Memory was allocated by the user */
-    ALLOCATION_SOURCE_DEPTH,     /**< Memory was allocated by the depth reader */
-    ALLOCATION_SOURCE_COLOR,     /**< Memory was allocated by the Color reader */
-    ALLOCATION_SOURCE_IMU,       /**< Memory was allocated by the IMU reader */
-    ALLOCATION_SOURCE_USB_DEPTH, /**< Memory was allocated by the USB reader */
-    ALLOCATION_SOURCE_USB_IMU,   /**< Memory was allocated by the USB reader */
+    ALLOCATION_SOURCE_USER = K4A_ALLOCATION_SOURCE_USER,           /**< Memory was allocated by the user */
+    ALLOCATION_SOURCE_DEPTH = K4A_ALLOCATION_SOURCE_DEPTH,         /**< Memory was allocated by the depth reader */
+    ALLOCATION_SOURCE_COLOR = K4A_ALLOCATION_SOURCE_COLOR,         /**< Memory was allocated by the Color reader */
+    ALLOCATION_SOURCE_IMU = K4A_ALLOCATION_SOURCE_IMU,             /**< Memory was allocated by the IMU reader */
+    ALLOCATION_SOURCE_USB_DEPTH = K4A_ALLOCATION_SOURCE_USB_DEPTH, /**< Memory was allocated by the USB reader */
+    ALLOCATION_SOURCE_USB_IMU = K4A_ALLOCATION_SOURCE_USB_IMU,     /**< Memory was allocated by the USB reader */
 } allocation_source_t;
 
+/** Pools of freed handles kept for reuse, see allocator_handle_alloc().
+ */
+typedef enum
+{
+    HANDLE_POOL_CAPTURE = 0,   /**< Handles of k4a_capture_t */
+    HANDLE_POOL_IMAGE,         /**< Handles of k4a_image_t */
+    HANDLE_POOL_SHARED_BUFFER, /**< Contexts of the depth engine output buffers the depth and IR images share */
+    HANDLE_POOL_COUNT,         /**< Number of handle pools */
+} handle_pool_t;
+
+/** Number of freed handles each handle pool keeps */
+#define ALLOCATOR_MAX_POOLED_HANDLES (256)
+
 /** Initializes the globals used by the allocator
  *
  */
@@ -79,6 +96,156 @@ void allocator_deinitialize(void);
  */
 k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memory_destroy_cb_t free);
 
+/** Sets callback functions for the SDK allocator that are told the source, image format and alignment of each buffer
+ *
+ * \param allocate
+ * The callback function to allocate memory
+ *
+ * \param free
+ * The callback function to free memory allocated by \p allocate
+ *
+ * \param user_context
+ * Context passed to every call of \p allocate
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the callback functions were set or cleared. ::K4A_RESULT_FAILED if only one of
+ * \p allocate and \p free is NULL.
+ *
+ * \remarks
+ * Replaces any allocator set with allocator_set_allocator() or allocator_set_huge_pages(), both NULL resets to the
+ * default allocator. Buffers are requested with an alignment of ALLOCATOR_ALIGNMENT and without the slack
+ * allocator_alloc() otherwise adds to align them, a buffer returned unaligned fails the allocation.
+ */
+k4a_result_t allocator_set_allocator_ex(k4a_memory_allocate_ex_cb_t allocate,
+                                        k4a_memory_destroy_cb_t free,
+                                        void *user_context);
+
+/** Serves frame sized buffers from huge pages
+ *
+ * \param enable
+ * true to map buffers of 1 MB and more from 2 MB huge pages, false to return to the default allocator
+ *
+ * \remarks
+ * Replaces any allocator set with allocator_set_allocator(). Buffers are placed on the NUMA node set for the allocating
+ * thread with allocator_set_thread_numa_node(). When no huge pages are available regular pages are used.
+ */
+k4a_result_t allocator_set_huge_pages(bool enable);
+
+/** Sets the NUMA node the huge page allocator places the buffers allocated by the calling thread on
+ *
+ * \param numa_node
+ * The node, -1 for no preference
+ *
+ * \remarks
+ * Called by the streaming threads of a device with the node local to its USB controller.
+ */
+void allocator_set_thread_numa_node(int numa_node);
+
+/** Upper limit accepted by allocator_set_pooling() */
+#define ALLOCATOR_MAX_POOLED_BUFFERS (1024)
+
+/** Sets the number of freed buffers the allocator keeps for reuse
+ *
+ * \param max_pooled_buffers
+ * Maximum number of freed buffers to keep for each ::allocation_source_t. 0 disables pooling.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the limit was set. ::K4A_RESULT_FAILED if \p max_pooled_buffers is larger than
+ * ALLOCATOR_MAX_POOLED_BUFFERS.
+ *
+ * \remarks
+ * Buffers already held by the pools are released when the limit is changed, when a new allocator is set with
+ * allocator_set_allocator(), and when the last session ends.
+ */
+k4a_result_t allocator_set_pooling(uint32_t max_pooled_buffers);
+
+/** Keeps a number of buffers of one size pooled for a source, whatever the pooling limit
+ *
+ * \param source
+ * The source the buffers are allocated for
+ *
+ * \param alloc_size
+ * Size of the buffers
+ *
+ * \param count
+ * Number of buffers added to the reservation of the source
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the buffers were allocated into the pool. ::K4A_RESULT_FAILED if they couldn't be
+ * allocated or the pool of \p source is reserved for another size.
+ *
+ * \remarks
+ * Lets a stream allocate its buffers before it starts, so it does no dynamic allocation while streaming. Reservations
+ * of the same size add up, each must be released with allocator_pool_unreserve(). A reserved pool keeps its size
+ * class, buffers of other sizes freed by the source go back to the heap.
+ */
+k4a_result_t allocator_pool_reserve(allocation_source_t source, size_t alloc_size, uint32_t count);
+
+/** Releases buffers reserved with allocator_pool_reserve()
+ *
+ * \param source
+ * The source the buffers were reserved for
+ *
+ * \param count
+ * Number of buffers the reservation was made for
+ */
+void allocator_pool_unreserve(allocation_source_t source, uint32_t count);
+
+/** Parts of the memory budget set with allocator_set_memory_budget()
+ */
+typedef enum
+{
+    MEMORY_BUDGET_USB_TRANSFERS = 0, /**< Depth USB transfer buffers of a device, a quarter of the budget */
+    MEMORY_BUDGET_CAPTURES,          /**< Captures queued by a device and the buffers backing them, half the budget */
+    MEMORY_BUDGET_RECORDING,         /**< Data a recording holds before writing it, half of the budget */
+    MEMORY_BUDGET_PLAYBACK_CACHE,    /**< Blocks and image buffers cached by a playback, a quarter of the budget */
+} memory_budget_share_t;
+
+/** Sets the memory budget buffer counts are sized to
+ *
+ * \param budget_bytes
+ * Budget of each device, recording and playback, 0 for the default buffer counts
+ *
+ * \remarks
+ * Applies to the streams started, and the recordings and playbacks opened, after the call.
+ */
+void allocator_set_memory_budget(size_t budget_bytes);
+
+/** Gets the memory budget set with allocator_set_memory_budget(), 0 if none is set
+ */
+size_t allocator_get_memory_budget(void);
+
+/** Gets the number of items of a size that fit in a share of the memory budget
+ *
+ * \param share
+ * The part of the budget the items come from
+ *
+ * \param item_size
+ * Size of an item in bytes
+ *
+ * \param min_count
+ * Count returned when the budget is too small
+ *
+ * \param default_count
+ * Count returned without a budget, and the largest count returned with one
+ */
+uint32_t allocator_budget_count(memory_budget_share_t share,
+                                size_t item_size,
+                                uint32_t min_count,
+                                uint32_t default_count);
+
+/** Gets statistics of the allocations made by each ::allocation_source_t
+ *
+ * \param stats
+ * Location to write the statistics
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED if \p stats is NULL.
+ */
+k4a_result_t allocator_get_stats(k4a_allocator_stats_t *stats);
+
+/** Alignment in bytes of every buffer returned by allocator_alloc(), one cache line and one AVX-512 vector */
+#define ALLOCATOR_ALIGNMENT (64)
+
+/** Rounds a size or address up to a multiple of ALLOCATOR_ALIGNMENT */
+#define ALLOCATOR_ALIGN_UP(x) (((x) + (ALLOCATOR_ALIGNMENT - 1)) & ~((size_t)ALLOCATOR_ALIGNMENT - 1))
+
 /** Allocates memory from the allocator
  *
  * \param source
@@ -87,10 +254,30 @@ k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memo
  * \param alloc_size
  * size of the memory to allocate
  *
+ * \remarks
+ * The buffer is aligned to ALLOCATOR_ALIGNMENT and readable and writable up to \p alloc_size rounded up to
+ * ALLOCATOR_ALIGNMENT, whatever the alignment of the memory returned by the allocate callback.
+ *
  * This call only cleans up the allocator handle.
  */
 uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size);
 
+/** Allocates memory for an image of a known format from the allocator
+ *
+ * \param source
+ * the source of code allocating the memory
+ *
+ * \param format
+ * Format of the image the buffer holds, passed to an allocator set with allocator_set_allocator_ex()
+ *
+ * \param alloc_size
+ * size of the memory to allocate
+ *
+ * \remarks
+ * Same as allocator_alloc(), which allocates buffers of format ::K4A_IMAGE_FORMAT_CUSTOM.
+ */
+uint8_t *allocator_alloc_image(allocation_source_t source, k4a_image_format_t format, size_t alloc_size);
+
 /** Returns a buffer to the allocator
  *
  * \param buffer
@@ -101,6 +288,44 @@ uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size);
  */
 void allocator_free(void *buffer);
 
+/** Number of recycled buffers each allocation source keeps whatever the pooling limit, see allocator_recycle() */
+#define ALLOCATOR_RECYCLED_BUFFERS (16)
+
+/** Returns a buffer to the allocator for the next allocation of the same source and size
+ *
+ * \param buffer
+ * Buffer to recycle, allocated by allocator_alloc()
+ *
+ * \remarks
+ * Same as allocator_free(), except that the pool of the source keeps up to ALLOCATOR_RECYCLED_BUFFERS buffers even
+ * when allocator_set_pooling() disabled pooling. Used when an application recycles a capture with
+ * k4a_capture_recycle(), so steady state streaming allocates no new buffers.
+ */
+void allocator_recycle(void *buffer);
+
+/** Allocates zeroed memory for a handle, reusing a freed handle of the same pool when one is available
+ *
+ * \param pool
+ * The pool of the handle type
+ *
+ * \param size
+ * Size of the handle, the same for every handle of \p pool
+ *
+ * \remarks
+ * Used through K4A_DECLARE_POOLED_CONTEXT(), see handle.h. Pooled handles are freed when the last session ends.
+ */
+void *allocator_handle_alloc(handle_pool_t pool, size_t size);
+
+/** Returns memory from allocator_handle_alloc() to its pool
+ *
+ * \param pool
+ * The pool the handle was allocated from
+ *
+ * \param handle
+ * The handle, whose type tag in its first pointer was already cleared by the destroy function of the handle
+ */
+void allocator_handle_free(handle_pool_t pool, void *handle);
+
 /** Verifies there are no outstanding allocations
  *
  * \remarks
@@ -0,0 +1,188 @@
+/** \file broker.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Share the captures of a device with other processes through shared memory
+ */
+
+#ifndef BROKER_H
+#define BROKER_H
+
+#include <k4a/k4atypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of processes attached to a broker at once
+ */
+#define BROKER_MAX_CLIENTS (8)
+
+/** Captures queued for each attached process before the oldest is dropped
+ */
+#define BROKER_CLIENT_QUEUE_LENGTH (4)
+
+/** Largest raw calibration a broker shares
+ */
+#define BROKER_MAX_CALIBRATION_BYTES (32 * 1024)
+
+/** Allocations smaller than this are served from the heap instead of a shared buffer
+ */
+#define BROKER_MIN_SHARED_ALLOCATION (64 * 1024)
+
+/** Handle to a broker sharing captures from the process owning a device
+ *
+ * Handles are created with broker_create() and closed
+ * with broker_destroy().
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(broker_t);
+
+/** Handle to a broker attached to from another process
+ *
+ * Handles are created with broker_attach() and closed
+ * with broker_detach().
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(broker_client_t);
+
+/** Creates a named broker and serves the buffers of the SDK allocator from its shared memory
+ *
+ * \param name
+ * Name other processes attach with, letters, digits, '-' and '_' only
+ *
+ * \param buffer_count
+ * Number of shared buffers
+ *
+ * \param buffer_size
+ * Size of each shared buffer, the largest allocation served from shared memory
+ *
+ * \param broker_handle
+ * Location to write the handle
+ *
+ * \remarks
+ * Replaces the allocator set with allocator_set_allocator() or allocator_set_huge_pages() and turns allocator pooling
+ * off, since a pooled buffer would be reused while other processes still read it. Allocations of
+ * BROKER_MIN_SHARED_ALLOCATION to \p buffer_size bytes take a shared buffer while one is free, others come from the
+ * heap. Only one broker can exist in a process. Not supported on Windows.
+ */
+k4a_result_t broker_create(const char *name, uint32_t buffer_count, size_t buffer_size, broker_t *broker_handle);
+
+/** Destroys a broker
+ *
+ * \remarks
+ * The default allocator is restored. The shared memory stays mapped until every buffer allocated from it has been
+ * freed, and attached processes keep the images they hold.
+ */
+void broker_destroy(broker_t broker_handle);
+
+/** Shares the calibration of the device with attached processes
+ *
+ * \param broker_handle
+ * The broker
+ *
+ * \param raw_calibration
+ * Raw calibration of the device
+ *
+ * \param raw_calibration_size
+ * Size of \p raw_calibration, at most BROKER_MAX_CALIBRATION_BYTES
+ *
+ * \param depth_mode
+ * Depth mode the device was started with
+ *
+ * \param color_resolution
+ * Color resolution the device was started with
+ */
+k4a_result_t broker_set_calibration(broker_t broker_handle,
+                                    const uint8_t *raw_calibration,
+                                    size_t raw_calibration_size,
+                                    k4a_depth_mode_t depth_mode,
+                                    k4a_color_resolution_t color_resolution);
+
+/** Queues a capture for every attached process
+ *
+ * \param broker_handle
+ * The broker
+ *
+ * \param capture_handle
+ * The capture
+ *
+ * \remarks
+ * Images in shared buffers are shared in place, with a reference held for each process until it releases the image.
+ * Other images are copied to a free shared buffer, and skipped when there is none. When the queue of a process is full
+ * its oldest capture is dropped.
+ */
+k4a_result_t broker_publish_capture(broker_t broker_handle, k4a_capture_t capture_handle);
+
+/** Gets the number of shared buffers not in use by any process
+ */
+uint32_t broker_get_free_buffer_count(broker_t broker_handle);
+
+/** Attaches to a broker created by another process
+ *
+ * \param name
+ * Name of the broker
+ *
+ * \param client_handle
+ * Location to write the handle
+ *
+ * \return K4A_RESULT_FAILED if there is no broker of this name or it has BROKER_MAX_CLIENTS processes attached.
+ */
+k4a_result_t broker_attach(const char *name, broker_client_t *client_handle);
+
+/** Detaches from a broker
+ *
+ * \remarks
+ * Images received from the broker stay valid, the shared memory is unmapped once the last one is released.
+ */
+void broker_detach(broker_client_t client_handle);
+
+/** Gets the calibration shared by the broker
+ *
+ * \param client_handle
+ * The attached broker
+ *
+ * \param raw_calibration
+ * Buffer of BROKER_MAX_CALIBRATION_BYTES + 1 bytes to write the null terminated raw calibration to
+ *
+ * \param raw_calibration_size
+ * Location to write the size of the raw calibration, including the null terminator
+ *
+ * \param depth_mode
+ * Location to write the depth mode of the device
+ *
+ * \param color_resolution
+ * Location to write the color resolution of the device
+ *
+ * \return K4A_RESULT_FAILED if the broker has not shared a calibration.
+ */
+k4a_result_t broker_client_get_calibration(broker_client_t client_handle,
+                                           char *raw_calibration,
+                                           size_t *raw_calibration_size,
+                                           k4a_depth_mode_t *depth_mode,
+                                           k4a_color_resolution_t *color_resolution);
+
+/** Waits for the next capture published by the broker
+ *
+ * \param client_handle
+ * The attached broker
+ *
+ * \param capture_handle
+ * Location to write the capture
+ *
+ * \param timeout_in_ms
+ * Time to wait, K4A_WAIT_INFINITE to wait until a capture arrives or the broker goes away
+ *
+ * \return K4A_WAIT_RESULT_FAILED once the broker has been destroyed or its process has exited and no capture is
+ * queued.
+ */
+k4a_wait_result_t broker_client_get_capture(broker_client_t client_handle,
+                                            k4a_capture_t *capture_handle,
+                                            int32_t timeout_in_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BROKER_H */
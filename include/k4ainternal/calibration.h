@@ -90,6 +90,35 @@ typedef struct _k4a_calibration_imu_t
  */
 k4a_result_t calibration_create(depthmcu_t depthmcu, calibration_t *calibration_handle);
 
+/** Creates an calibration instance, using a calibration cached on disk when there is one
+ *
+ * \param depthmcu
+ *  Handle to the depthmcu that the calibration is read from
+ *
+ * \param serial_number
+ * Serial number of the device, the calibration is cached per device
+ *
+ * \param version
+ * Firmware versions of the device, a firmware update invalidates the cached calibration. May be NULL, in which case
+ * the cache is not used.
+ *
+ * \param calibration_handle
+ * pointer to a handle location to store the handle. This is only written on K4A_RESULT_SUCCEEDED;
+ *
+ * The cache is enabled by pointing K4A_CALIBRATION_CACHE_DIR at an existing directory, otherwise this is the same as
+ * \ref calibration_create. On a cache hit the calibration is available without reading it from the device. The device
+ * is then read on a background thread, and the cache and the calibration returned by this instance are refreshed if
+ * they no longer match it. On a cache miss the calibration is read from the device and stored in the cache.
+ *
+ * To cleanup this resource call \ref calibration_destroy, which must be called before depthmcu is destroyed.
+ *
+ * \return K4A_RESULT_SUCCEEDED is returned on success, otherwise K4A_RESULT_FAILED is returned
+ */
+k4a_result_t calibration_create_cached(depthmcu_t depthmcu,
+                                       const char *serial_number,
+                                       const depthmcu_firmware_versions_t *version,
+                                       calibration_t *calibration_handle);
+
 /** Creates an calibration instance
  *
  * \param raw_calibration
@@ -24,6 +24,10 @@ extern "C" {
  * /ref k4a_capture_t object this API creates is with a base ref count of 1. It will automatically be deleted when
  * its ref count reaches zero. Any k4a_image_t's associated with this capture will also have a reference removed when
  * this object is destroyed.
+
+ *
+ * Captures are immutable once published: the setters are only called by the thread filling in a new capture, so the
+ * getters read the image slots without a lock.
  */
 k4a_result_t capture_create(k4a_capture_t *capture_handle);
 
@@ -45,6 +49,17 @@ void capture_inc_ref(k4a_capture_t capture_handle);
  */
 void capture_dec_ref(k4a_capture_t capture_handle);
 
+/** Decrease the ref count on \ref k4a_capture_t blob, keeping the buffers of its images for reuse
+ *
+ * \param capture_handle
+ * The k4a_capture_t blob
+ *
+ * \remarks
+ * Same as \ref capture_dec_ref, except that when the last reference is removed the images are released with
+ * \ref image_recycle.
+ */
+void capture_recycle(k4a_capture_t capture_handle);
+
 k4a_image_t capture_get_color_image(k4a_capture_t capture_handle);
 k4a_image_t capture_get_depth_image(k4a_capture_t capture_handle);
 k4a_image_t capture_get_imu_image(k4a_capture_t capture_handle);
@@ -56,6 +71,21 @@ void capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle
 void capture_set_temperature_c(k4a_capture_t capture_handle, float temperature_c);
 float capture_get_temperature_c(k4a_capture_t capture_handle);
 
+/** Time the capture finished a latency stage, see latency_record(). 0 when the capture did not go through the stage. */
+void capture_set_latency_timestamp_nsec(k4a_capture_t capture_handle,
+                                        k4a_latency_stage_t stage,
+                                        uint64_t timestamp_nsec);
+uint64_t capture_get_latency_timestamp_nsec(k4a_capture_t capture_handle, k4a_latency_stage_t stage);
+
+/** Sets the IMU samples of the capture's exposure, see imu_get_history_samples(). The capture takes ownership of
+ * \p imu_samples, which must be allocated with malloc(), and frees it with the capture. */
+void capture_set_imu_samples(k4a_capture_t capture_handle, k4a_imu_sample_t *imu_samples, size_t imu_sample_count);
+
+/** Copies the IMU samples of the capture, see k4a_capture_get_imu_samples(). */
+k4a_buffer_result_t capture_get_imu_samples(k4a_capture_t capture_handle,
+                                            k4a_imu_sample_t *imu_samples,
+                                            size_t *imu_sample_count);
+
 #ifdef __cplusplus
 }
 #endif
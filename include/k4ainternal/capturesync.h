@@ -10,6 +10,7 @@
 #define CAPTURESYNC_H
 
 #include <k4a/k4atypes.h>
+#include <k4ainternal/queue.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +24,25 @@ extern "C" {
  */
 K4A_DECLARE_HANDLE(capturesync_t);
 
+/** Callback filling in the IMU samples of a capture before it is published
+ *
+ * \param capture
+ * The capture to attach the samples to with capture_set_imu_samples()
+ *
+ * \param start_usec
+ * Device timestamp of the start of the capture's exposure
+ *
+ * \param end_usec
+ * Device timestamp of the end of the capture's exposure
+ *
+ * \param context
+ * Context passed to capturesync_set_imu_samples_callback()
+ */
+typedef void(capturesync_imu_samples_cb_t)(k4a_capture_t capture,
+                                           uint64_t start_usec,
+                                           uint64_t end_usec,
+                                           void *context);
+
 /** Creates an capturesync instance
  *
  * \param capturesync_handle
@@ -85,6 +105,130 @@ k4a_wait_result_t capturesync_get_capture(capturesync_t capturesync_handle,
                                           k4a_capture_t *capture_handle,
                                           int32_t timeout_in_ms);
 
+/** Attaches a waiter to the synchronized capture queue
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param waiter_handle
+ * A waiter from queue_waiter_create()
+ *
+ * \remarks
+ * The waiter is notified each time a capture is queued for capturesync_get_capture() and when capturesync stops. No
+ * capture is queued while a capture callback is registered.
+ */
+k4a_result_t capturesync_add_waiter(capturesync_t capturesync_handle, queue_waiter_t waiter_handle);
+
+/** Detaches a waiter attached with capturesync_add_waiter()
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param waiter_handle
+ * The waiter to detach
+ */
+void capturesync_remove_waiter(capturesync_t capturesync_handle, queue_waiter_t waiter_handle);
+
+/** Checks whether capturesync_get_capture() would return without waiting
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \remarks
+ * Returns true if a capture is queued, or if capturesync is stopped and capturesync_get_capture() fails immediately.
+ */
+bool capturesync_is_ready(capturesync_t capturesync_handle);
+
+/** Registers a callback to receive synchronized captures instead of the synchronized capture queue
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param capture_cb
+ * The callback to invoke with each capture, NULL to go back to queueing captures for capturesync_get_capture()
+ *
+ * \param capture_cb_context
+ * Context passed to \p capture_cb
+ *
+ * \remarks
+ * The callback is invoked from the thread calling capturesync_add_capture() while holding the capturesync lock
+ */
+k4a_result_t capturesync_set_capture_callback(capturesync_t capturesync_handle,
+                                              k4a_capture_cb_t *capture_cb,
+                                              void *capture_cb_context);
+
+/** Registers a callback to receive each depth capture as soon as it arrives, before it is synchronized with color
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param depth_capture_cb
+ * The callback to invoke with each depth capture, NULL to stop publishing depth captures early
+ *
+ * \param depth_capture_cb_context
+ * Context passed to \p depth_capture_cb
+ *
+ * \remarks
+ * The callback receives a capture holding only the depth and IR images. The same images are still synchronized with
+ * color and published through capturesync_get_capture() or the capture callback. The callback is invoked from the
+ * thread calling capturesync_add_capture() without holding the capturesync lock.
+ */
+k4a_result_t capturesync_set_depth_capture_callback(capturesync_t capturesync_handle,
+                                                    k4a_capture_cb_t *depth_capture_cb,
+                                                    void *depth_capture_cb_context);
+
+/** Registers a callback to attach the IMU samples of each synchronized capture's exposure
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param imu_samples_cb
+ * The callback to invoke with each synchronized capture, NULL to stop attaching IMU samples
+ *
+ * \param imu_samples_cb_context
+ * Context passed to \p imu_samples_cb
+ *
+ * \remarks
+ * The exposure spans the exposures of the capture's images, which are centered on their timestamps. Images without an
+ * exposure time, like depth and IR, are given half a frame period on each side, so consecutive captures together hold
+ * every sample. The callback is invoked from the thread calling capturesync_add_capture() while holding the
+ * capturesync lock, before the capture is published through capturesync_get_capture() or the capture callback.
+ */
+k4a_result_t capturesync_set_imu_samples_callback(capturesync_t capturesync_handle,
+                                                  capturesync_imu_samples_cb_t *imu_samples_cb,
+                                                  void *imu_samples_cb_context);
+
+/** Sets the depth and full policy of the synchronized capture queue
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param queue_depth
+ * Number of captures the queue holds, 0 for the default
+ *
+ * \param policy
+ * What happens to a capture published while the queue is full, see queue_configure()
+ *
+ * \remarks
+ * Fails while capturesync is running, the configuration applies on the next capturesync_start()
+ */
+k4a_result_t capturesync_set_queue_policy(capturesync_t capturesync_handle,
+                                         uint32_t queue_depth,
+                                         k4a_queue_policy_t policy);
+
+/** Reads the synchronization counters and queue depths
+ *
+ * \param capturesync_handle
+ * The capturesync handle from capturesync_create()
+ *
+ * \param stats
+ * Location to write the statistics to
+ *
+ * \remarks
+ * Counters are reset by capturesync_start()
+ */
+k4a_result_t capturesync_get_stats(capturesync_t capturesync_handle, k4a_capture_stats_t *stats);
+
 /** Capturesync module asynchronously accepts new captures from color and depth modules through this API.
  *
  * \param capturesync_handle
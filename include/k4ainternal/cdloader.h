@@ -0,0 +1,37 @@
+/** \file cdloader.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Color Decoder Loader
+ * Stub layer to abstract away the dynamic loading of the hardware color decoder plugin from our developers usage
+ */
+
+#pragma once
+
+#include <k4ainternal/k4adecoderplugin.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returns true if the color decoder plugin was requested with K4A_COLOR_HARDWARE_DECODE and loaded.
+ *
+ * The plugin is loaded on the first call. Callers decode in software when this returns false.
+ */
+bool cdloader_is_loaded(void);
+
+k4a_decoder_result_code_t cdloader_decoder_create(k4a_decoder_context_t **context,
+                                                  uint32_t width_pixels,
+                                                  uint32_t height_pixels);
+
+k4a_decoder_result_code_t cdloader_decode_mjpeg(k4a_decoder_context_t *context,
+                                                const uint8_t *input_frame,
+                                                size_t input_frame_size,
+                                                uint8_t *output_frame,
+                                                uint32_t output_stride_bytes,
+                                                size_t output_frame_size);
+
+void cdloader_decoder_destroy(k4a_decoder_context_t **context);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+/** \file clockmodel.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Mapping of device timestamps to the system clock
+ */
+
+#ifndef CLOCKMODEL_H
+#define CLOCKMODEL_H
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/handle.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Observations needed before \ref clockmodel_get_system_timestamp_nsec maps timestamps
+ */
+#define CLOCKMODEL_MIN_OBSERVATIONS (8)
+
+/** Handle to a clock model.
+ *
+ * Handles are created with \ref clockmodel_create and closed
+ * with \ref clockmodel_destroy.
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(clockmodel_t);
+
+/** Creates a clock model for one device
+ *
+ * \param clockmodel_handle
+ * Location to write the handle
+ *
+ * \remarks
+ * The model fits a line from device timestamps to the system clock of image_apply_system_timestamp(). Arrival times
+ * are late by a varying transfer and processing latency, so the line follows the lower envelope of the observations:
+ * the drift is fit to the earliest arrival of every window of device time, and the line is then offset to lie under
+ * every observation kept.
+ */
+k4a_result_t clockmodel_create(clockmodel_t *clockmodel_handle);
+
+/** Destroys a clock model
+ */
+void clockmodel_destroy(clockmodel_t clockmodel_handle);
+
+/** Discards every observation, for when the device clock restarts
+ */
+void clockmodel_reset(clockmodel_t clockmodel_handle);
+
+/** Adds the arrival time of data with a device timestamp
+ *
+ * \param clockmodel_handle
+ * The clock model
+ *
+ * \param device_timestamp_usec
+ * Device timestamp of the data
+ *
+ * \param system_timestamp_nsec
+ * System time the data arrived at the host
+ *
+ * \remarks
+ * An observation far off the current model, or going back in device time, means the device clock restarted and
+ * resets the model. Observations with a timestamp of 0 are ignored.
+ */
+void clockmodel_add_observation(clockmodel_t clockmodel_handle,
+                                uint64_t device_timestamp_usec,
+                                uint64_t system_timestamp_nsec);
+
+/** Maps a device timestamp to the system clock
+ *
+ * \param clockmodel_handle
+ * The clock model
+ *
+ * \param device_timestamp_usec
+ * Device timestamp to map
+ *
+ * \param system_timestamp_nsec
+ * Location to write the system time
+ *
+ * \return K4A_RESULT_FAILED if fewer than \ref CLOCKMODEL_MIN_OBSERVATIONS were added since the model was created or
+ * reset.
+ */
+k4a_result_t clockmodel_get_system_timestamp_nsec(clockmodel_t clockmodel_handle,
+                                                  uint64_t device_timestamp_usec,
+                                                  uint64_t *system_timestamp_nsec);
+
+/** Reads the shared timebase through a callback
+ *
+ * \param timebase_cb
+ * Callback returning the current time of the shared timebase, NULL to use the system clock again
+ *
+ * \param timebase_cb_context
+ * Context passed to the callback
+ */
+k4a_result_t clockmodel_set_shared_timebase_callback(k4a_shared_timebase_cb_t *timebase_cb, void *timebase_cb_context);
+
+/** Reads the shared timebase from a clock of the host
+ *
+ * \param phc_device_path
+ * Path of a PTP hardware clock such as /dev/ptp0, or NULL for the realtime clock of the host
+ *
+ * \remarks
+ * Not supported on Windows.
+ */
+k4a_result_t clockmodel_set_shared_timebase_clock(const char *phc_device_path);
+
+/** Converts a time on the clock of image system timestamps to the shared timebase
+ *
+ * \param system_timestamp_nsec
+ * Time on the clock of image_apply_system_timestamp()
+ *
+ * \param shared_timestamp_nsec
+ * Location to write the time in the shared timebase
+ *
+ * \remarks
+ * The offset between the clocks is measured again when the last measurement is more than a second old. Without a
+ * shared timebase the system timestamp is returned unchanged.
+ */
+k4a_result_t clockmodel_system_to_shared_nsec(uint64_t system_timestamp_nsec, uint64_t *shared_timestamp_nsec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCKMODEL_H */
@@ -86,6 +86,18 @@ k4a_result_t color_create(TICK_COUNTER_HANDLE tick_handle,
  */
 void color_destroy(color_t color_handle);
 
+/** Sets the scale MJPG frames are decoded to when the color camera outputs BGRA32
+ *
+ * \param color_handle
+ * Handle to the color camera
+ *
+ * \param scale
+ * Scale applied by the next call to \ref color_start
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if successful. ::K4A_RESULT_FAILED if the scale is invalid.
+ */
+k4a_result_t color_set_scale(color_t color_handle, k4a_color_scale_t scale);
+
 /** Starts the color camera streaming
  *
  * \param color_handle
@@ -177,6 +177,7 @@ k4a_result_t colormcu_imu_register_stream_cb(colormcu_t colormcu_handle,
                                              void *context);
 k4a_result_t colormcu_imu_get_calibration(colormcu_t colormcu_handle,
                                           void *memory); // RGB_CAMERA_USB_COMMAND_READ_IMU_CALIDATA
+k4a_result_t colormcu_imu_get_usb_stream_stats(colormcu_t colormcu_handle, k4a_usb_stream_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -144,6 +144,41 @@ inline static bool k4a_convert_depth_mode_to_width_height(k4a_depth_mode_t mode,
     return true;
 }
 
+// Approximate bytes held by a capture of config: the depth and IR images and the color image, MJPG frames counted at a
+// byte per pixel. Used to size buffer counts to the memory budget.
+inline static size_t k4a_estimate_capture_size(const k4a_device_configuration_t *config)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t size = 0;
+
+    if (k4a_convert_depth_mode_to_width_height(config->depth_mode, &width, &height))
+    {
+        size += (size_t)width * height * (config->depth_mode == K4A_DEPTH_MODE_PASSIVE_IR ? 2 : 4);
+    }
+
+    if (k4a_convert_resolution_to_width_height(config->color_resolution, &width, &height))
+    {
+        switch (config->color_format)
+        {
+        case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+            size += (size_t)width * height * 4;
+            break;
+        case K4A_IMAGE_FORMAT_COLOR_YUY2:
+            size += (size_t)width * height * 2;
+            break;
+        case K4A_IMAGE_FORMAT_COLOR_NV12:
+            size += (size_t)width * height * 3 / 2;
+            break;
+        default:
+            size += (size_t)width * height;
+            break;
+        }
+    }
+
+    return size;
+}
+
 inline static bool k4a_is_version_greater_or_equal(k4a_version_t *fw_version_l, k4a_version_t *fw_version_r)
 {
     typedef enum
@@ -8,12 +8,20 @@
 
 #pragma once
 
+#include <k4a/k4atypes.h>
 #include <k4ainternal/k4aplugin.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Starts loading the depth engine plugin on a background thread, so the first depth engine doesn't wait for the dynamic
+// library and the GPU driver to load. Returns immediately, calls after the first do nothing.
+void deloader_preload(void);
+
+// Calls deloader_preload() if the K4A_DEPTH_ENGINE_PRELOAD environment variable is 1
+void deloader_preload_if_requested(void);
+
 k4a_depth_engine_result_code_t deloader_depth_engine_create_and_initialize(k4a_depth_engine_context_t **context,
                                                                            size_t cal_block_size_in_bytes,
                                                                            void *cal_block,
@@ -35,8 +43,116 @@ deloader_depth_engine_process_frame(k4a_depth_engine_context_t *context,
 
 size_t deloader_depth_engine_get_output_frame_size(k4a_depth_engine_context_t *context);
 
+// Output frame size of an output type, 0 if the plugin doesn't support it
+size_t deloader_depth_engine_get_output_type_frame_size(k4a_depth_engine_context_t *context,
+                                                        k4a_depth_engine_output_type_t output_type);
+
 void deloader_depth_engine_destroy(k4a_depth_engine_context_t **context);
 
+// Picks the GPU for a depth engine and adds load to the load of that GPU. gpu_index is a GPU index or
+// K4A_DEPTH_ENGINE_GPU_AUTO for the GPU with the least load. Returns the GPU, or -1 if the plugin can't place depth
+// engines on GPUs or gpu_index is out of range. Release the load with deloader_depth_engine_release_gpu().
+int32_t deloader_depth_engine_reserve_gpu(int32_t gpu_index, uint64_t load);
+void deloader_depth_engine_release_gpu(int32_t gpu_index, uint64_t load);
+
+// deloader_depth_engine_create_and_initialize() on a GPU returned by deloader_depth_engine_reserve_gpu()
+k4a_depth_engine_result_code_t
+deloader_depth_engine_create_and_initialize_on_gpu(k4a_depth_engine_context_t **context,
+                                                   size_t cal_block_size_in_bytes,
+                                                   void *cal_block,
+                                                   k4a_depth_engine_mode_t mode,
+                                                   k4a_depth_engine_input_type_t input_format,
+                                                   void *camera_calibration,
+                                                   k4a_processing_complete_cb_t *callback,
+                                                   void *callback_context,
+                                                   uint32_t gpu_index);
+
+// Creates a depth engine that shares the GPU resources of the other shared depth engines with the same mode on the same
+// GPU. gpu_index is a GPU returned by deloader_depth_engine_reserve_gpu(), or -1 for the GPU picked by the plugin.
+// shared is set to false if the plugin doesn't support sharing and a separate depth engine was created.
+k4a_depth_engine_result_code_t deloader_depth_engine_create_shared(k4a_depth_engine_context_t **context,
+                                                                   size_t cal_block_size_in_bytes,
+                                                                   void *cal_block,
+                                                                   k4a_depth_engine_mode_t mode,
+                                                                   k4a_depth_engine_input_type_t input_format,
+                                                                   void *camera_calibration,
+                                                                   int32_t gpu_index,
+                                                                   bool *shared);
+
+// deloader_depth_engine_process_frame() for a depth engine created by deloader_depth_engine_create_shared(). The frame
+// is processed in one batch with the frames that the other depth engines of its group submit at the same time.
+k4a_depth_engine_result_code_t
+deloader_depth_engine_process_frame_shared(k4a_depth_engine_context_t *context,
+                                           void *input_frame,
+                                           size_t input_frame_size,
+                                           k4a_depth_engine_output_type_t output_type,
+                                           void *output_frame,
+                                           size_t output_frame_size,
+                                           k4a_depth_engine_output_frame_info_t *output_frame_info,
+                                           k4a_depth_engine_input_frame_info_t *input_frame_info);
+
+// True if the plugin can export depth engine outputs as GPU resources
+bool deloader_depth_engine_supports_gpu_export(void);
+
+// deloader_depth_engine_process_frame() that also exports the output into GPU resource slot of slot_count. The host
+// readback of the depth image is skipped if skip_depth_readback is set.
+k4a_depth_engine_result_code_t
+deloader_depth_engine_process_frame_gpu(k4a_depth_engine_context_t *context,
+                                        void *input_frame,
+                                        size_t input_frame_size,
+                                        k4a_depth_engine_output_type_t output_type,
+                                        void *output_frame,
+                                        size_t output_frame_size,
+                                        bool skip_depth_readback,
+                                        k4a_depth_engine_output_frame_info_t *output_frame_info,
+                                        k4a_depth_engine_input_frame_info_t *input_frame_info,
+                                        k4a_transform_engine_gpu_export_t export_type,
+                                        uint32_t slot,
+                                        uint32_t slot_count,
+                                        k4a_transform_engine_gpu_output_t *gpu_output);
+
+// A frame submitted with deloader_depth_engine_submit_frame(). The caller fills in the input and output and keeps the
+// frame until deloader_depth_engine_complete_frame() returns for it.
+typedef struct _deloader_depth_engine_frame_t
+{
+    void *input_frame;
+    size_t input_frame_size;
+    k4a_depth_engine_output_type_t output_type;
+    void *output_frame;
+    size_t output_frame_size;
+
+    k4a_depth_engine_output_frame_info_t output_frame_info; // Written when the frame completes
+
+    // Result of a frame processed at submit. Frames processed by another deloader call complete with the result stored
+    // here as well, with submitted left false.
+    k4a_depth_engine_result_code_t result;
+    bool submitted; // Submitted to the asynchronous entry points
+} deloader_depth_engine_frame_t;
+
+// True if the plugin processes frames asynchronously. Plugins that don't are driven through the same submit and
+// complete calls, which then process each frame synchronously at submit, so only one frame is in flight.
+bool deloader_depth_engine_supports_async(void);
+
+// Registers the output buffers of asynchronous frames. Succeeds without doing anything for synchronous plugins.
+k4a_depth_engine_result_code_t deloader_depth_engine_register_output_frames(k4a_depth_engine_context_t *context,
+                                                                            void *const *output_frames,
+                                                                            uint32_t output_frame_count,
+                                                                            size_t output_frame_size);
+
+// Submits a frame to the depth engine. Up to K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT frames can be submitted before the
+// oldest one is completed, or one for synchronous plugins.
+k4a_depth_engine_result_code_t deloader_depth_engine_submit_frame(k4a_depth_engine_context_t *context,
+                                                                  deloader_depth_engine_frame_t *frame);
+
+// Sets completed if deloader_depth_engine_complete_frame() would not wait for frame, the oldest frame in flight
+k4a_depth_engine_result_code_t deloader_depth_engine_poll_frame(k4a_depth_engine_context_t *context,
+                                                                deloader_depth_engine_frame_t *frame,
+                                                                bool *completed);
+
+// Waits for frame, the oldest frame in flight, and returns the result of processing it
+k4a_depth_engine_result_code_t deloader_depth_engine_complete_frame(k4a_depth_engine_context_t *context,
+                                                                    deloader_depth_engine_frame_t *frame);
+
 k4a_depth_engine_result_code_t deloader_transform_engine_create_and_initialize(k4a_transform_engine_context_t **context,
                                                                                void *camera_calibration,
                                                                                k4a_processing_complete_cb_t *callback,
@@ -61,6 +177,47 @@ size_t deloader_transform_engine_get_output_frame_size(k4a_transform_engine_cont
 
 void deloader_transform_engine_destroy(k4a_transform_engine_context_t **context);
 
+// Converts a public GPU interop type to the export type of the plugin, false for unknown types
+bool deloader_get_gpu_export_type(k4a_gpu_interop_type_t type, k4a_transform_engine_gpu_export_t *export_type);
+
+// True if the plugin can export transform engine outputs as GPU resources
+bool deloader_transform_engine_supports_gpu_export(void);
+
+// deloader_transform_engine_process_frame() into a GPU resource, released with
+// deloader_transform_engine_release_gpu_output()
+k4a_depth_engine_result_code_t
+deloader_transform_engine_process_frame_gpu(k4a_transform_engine_context_t *context,
+                                            k4a_transform_engine_type_t type,
+                                            const void *depth_frame,
+                                            size_t depth_frame_size,
+                                            const void *frame2,
+                                            size_t frame2_size,
+                                            k4a_transform_engine_interpolation_t interpolation,
+                                            uint32_t invalid_value,
+                                            k4a_transform_engine_gpu_export_t export_type,
+                                            k4a_transform_engine_gpu_output_t *output);
+
+void deloader_transform_engine_release_gpu_output(k4a_transform_engine_context_t *context,
+                                                  k4a_transform_engine_gpu_export_t export_type,
+                                                  k4a_transform_engine_gpu_output_t *output);
+
+// True if the plugin can read the depth image of a transform engine frame from a depth engine GPU resource
+bool deloader_transform_engine_supports_gpu_input(void);
+
+// deloader_transform_engine_process_frame_gpu() with the depth image read from depth_input, a resource exported by
+// deloader_depth_engine_process_frame_gpu()
+k4a_depth_engine_result_code_t
+deloader_transform_engine_process_frame_gpu_input(k4a_transform_engine_context_t *context,
+                                                  k4a_transform_engine_type_t type,
+                                                  k4a_transform_engine_gpu_export_t depth_export_type,
+                                                  const k4a_transform_engine_gpu_output_t *depth_input,
+                                                  const void *frame2,
+                                                  size_t frame2_size,
+                                                  k4a_transform_engine_interpolation_t interpolation,
+                                                  uint32_t invalid_value,
+                                                  k4a_transform_engine_gpu_export_t export_type,
+                                                  k4a_transform_engine_gpu_output_t *output);
+
 #ifdef __cplusplus
 }
 #endif
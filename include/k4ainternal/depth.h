@@ -11,6 +11,7 @@
 #include <k4ainternal/handle.h>
 #include <k4ainternal/depth_mcu.h>
 #include <k4ainternal/calibration.h>
+#include <k4ainternal/dewrapper.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -143,6 +144,144 @@ k4a_result_t depth_start(depth_t depth_handle, const k4a_device_configuration_t
  */
 void depth_stop(depth_t depth_handle);
 
+/** Changes the depth mode and frame rate of a streaming depth sensor
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param config [IN]
+ * The configuration with the new depth_mode and camera_fps.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the sensor streams in the new mode. ::K4A_RESULT_FAILED if the sensor isn't
+ * running or an error was encountered, the sensor is stopped then.
+ *
+ * The sensor stays on and the depth engine thread is reused, the depth engine itself is reused when the depth mode is
+ * unchanged.
+ */
+k4a_result_t depth_reconfigure(depth_t depth_handle, const k4a_device_configuration_t *config);
+
+/** Selects the GPU the depth engine runs on.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param gpu_index [IN]
+ * GPU index, ::K4A_DEPTH_ENGINE_GPU_AUTO or ::K4A_DEPTH_ENGINE_GPU_DEFAULT
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running. Applies the next time \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_engine_gpu(depth_t depth_handle, int32_t gpu_index);
+
+/** Shares the depth engine with the other devices that have sharing enabled and use the same depth mode.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param shared [IN]
+ * true to share the depth engine
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running. Applies the next time \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_engine_shared(depth_t depth_handle, bool shared);
+
+/** Keeps the depth engine initialized while the depth sensor is stopped.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param keep_alive [IN]
+ * true to keep the depth engine for the next \ref depth_start with the same depth mode
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running.
+ */
+k4a_result_t depth_set_depth_engine_keep_alive(depth_t depth_handle, bool keep_alive);
+
+/** Sets the filters run on the depth images.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param config [IN]
+ * The filters to run, NULL to disable filtering
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running or a setting is out of range. Applies the next time
+ * \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_filter(depth_t depth_handle, const k4a_depth_filter_configuration_t *config);
+
+/** Exports the depth engine output as GPU resources.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param config [IN]
+ * How the resources are shared, NULL to disable the export
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running or the interop type is unknown. Applies the next time
+ * \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_gpu_export(depth_t depth_handle, const k4a_depth_gpu_export_configuration_t *config);
+
+/** Has the depth engine output depth images without IR images.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param depth_only [IN]
+ * true to leave the IR images out of the captures
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running. Applies the next time \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_only(depth_t depth_handle, bool depth_only);
+
+/** Replaces the IR16 images with tone mapped 8 bit IR images.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param config [IN]
+ * The tone mapping of the IR images, NULL to output IR16 images
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running or a setting is out of range. Applies the next time
+ * \ref depth_start is called.
+ */
+k4a_result_t depth_set_ir8_output(depth_t depth_handle, const k4a_ir8_configuration_t *config);
+
+/** Processes one of every N raw depth frames.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param decimation [IN]
+ * N, 0 or 1 to process every raw frame
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running. Applies the next time \ref depth_start is called.
+ */
+k4a_result_t depth_set_frame_decimation(depth_t depth_handle, uint32_t decimation);
+
+/** Sets what the depth engine does when it can't keep up with the frame rate.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param config [IN]
+ * The overload policy, NULL to never drop raw frames
+ *
+ * \return K4A_RESULT_FAILED if the depth sensor is running. Applies the next time \ref depth_start is called.
+ */
+k4a_result_t depth_set_depth_engine_overload_policy(depth_t depth_handle,
+                                                    const k4a_depth_engine_overload_configuration_t *config);
+
+/** Gets the statistics of the depth engine.
+ *
+ * \param depth_handle [IN]
+ * The depth device handle.
+ *
+ * \param stats [OUT]
+ * Location to write the statistics
+ */
+k4a_result_t depth_get_depth_engine_stats(depth_t depth_handle, dewrapper_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
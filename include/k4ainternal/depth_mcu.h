@@ -103,6 +103,11 @@ k4a_result_t depthmcu_depth_start_streaming(depthmcu_t depthmcu_handle,
 
 void depthmcu_depth_stop_streaming(depthmcu_t depthmcu_handle, bool quiet);
 
+k4a_result_t depthmcu_depth_get_usb_stream_stats(depthmcu_t depthmcu_handle, k4a_usb_stream_stats_t *stats);
+
+// NUMA node of the USB controller the depth sensor is connected to, -1 when unknown
+int depthmcu_get_numa_node(depthmcu_t depthmcu_handle);
+
 k4a_result_t depthmcu_depth_set_capture_mode(depthmcu_t depthmcu_handle, k4a_depth_mode_t depth_mode);
 k4a_result_t depthmcu_depth_get_capture_mode(depthmcu_t depthmcu_handle, k4a_depth_mode_t *depth_mode);
 
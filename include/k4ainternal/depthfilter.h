@@ -0,0 +1,156 @@
+/** \file depthfilter.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Filtering of the depth images produced by the depth engine
+ */
+
+#ifndef DEPTHFILTER_H
+#define DEPTHFILTER_H
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/handle.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Largest thread_count of a depth filter configuration
+ */
+#define DEPTHFILTER_MAX_THREAD_COUNT (16)
+
+/** Step between the rows and between the pixels of a row sampled for the percentiles of an IR tone mapping
+ */
+#define DEPTHFILTER_IR8_SAMPLE_STEP (4)
+
+/** Largest shift of an IR tone mapping configuration
+ */
+#define DEPTHFILTER_IR8_MAX_SHIFT (8)
+
+/** Handle to a depth filter.
+ *
+ * Handles are created with \ref depthfilter_create and closed
+ * with \ref depthfilter_destroy.
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(depthfilter_t);
+
+/** Checks that a depth filter configuration is valid
+ *
+ * \param config
+ * The configuration to check
+ *
+ * \return K4A_RESULT_FAILED and logs the reason if a setting is out of range.
+ */
+k4a_result_t depthfilter_validate_configuration(const k4a_depth_filter_configuration_t *config);
+
+/** Returns true if the configuration enables at least one filter
+ */
+bool depthfilter_is_enabled(const k4a_depth_filter_configuration_t *config);
+
+/** Creates a depth filter for images of one size
+ *
+ * \param config
+ * A valid configuration, it is copied
+ *
+ * \param width
+ * Width of the depth images in pixels
+ *
+ * \param height
+ * Height of the depth images in pixels
+ *
+ * \param depthfilter_handle
+ * Location to write the handle
+ *
+ * \remarks
+ * The filter keeps the previous depth image for the temporal filter, so one filter is used for one stream.
+ */
+k4a_result_t depthfilter_create(const k4a_depth_filter_configuration_t *config,
+                                int width,
+                                int height,
+                                depthfilter_t *depthfilter_handle);
+
+/** Destroys a depth filter
+ */
+void depthfilter_destroy(depthfilter_t depthfilter_handle);
+
+/** Filters a depth image in place
+ *
+ * \param depthfilter_handle
+ * The depth filter
+ *
+ * \param depth_image
+ * DEPTH16 pixels of the size the filter was created for, rows packed without padding
+ *
+ * \remarks
+ * Runs on the calling thread, split across the shared worker threads when the configuration has a thread_count
+ * above 1. Calls for one filter must not overlap.
+ */
+void depthfilter_process(depthfilter_t depthfilter_handle, uint16_t *depth_image);
+
+/** Computes the statistics of the valid pixels of a depth image
+ *
+ * \param depth_image
+ * DEPTH16 pixels, rows packed without padding
+ *
+ * \param width
+ * Width of the image in pixels
+ *
+ * \param height
+ * Height of the image in pixels
+ *
+ * \param statistics
+ * Location to write the statistics
+ *
+ * \remarks
+ * Makes one pass over the pixels with the kernels of simd_get_level() and needs no depth filter. The depth engine
+ * thread calls it right after depthfilter_process(), while the filtered image is still in the processor cache.
+ */
+void depthfilter_compute_statistics(const uint16_t *depth_image,
+                                    int width,
+                                    int height,
+                                    k4a_depth_statistics_t *statistics);
+
+/** Checks that an IR tone mapping configuration is valid
+ *
+ * \param config
+ * The configuration to check
+ *
+ * \return K4A_RESULT_FAILED and logs the reason if a setting is out of range.
+ */
+k4a_result_t depthfilter_validate_ir8_configuration(const k4a_ir8_configuration_t *config);
+
+/** Tone maps an IR16 image to 8 bits
+ *
+ * \param config
+ * A valid configuration
+ *
+ * \param ir_image
+ * IR16 pixels, rows packed without padding
+ *
+ * \param width
+ * Width of the image in pixels
+ *
+ * \param height
+ * Height of the image in pixels
+ *
+ * \param ir8_image
+ * Location to write the 8 bit pixels, rows packed without padding
+ *
+ * \remarks
+ * The percentiles of ::K4A_IR_TONE_MAPPING_PERCENTILE are taken from a histogram of one pixel in
+ * DEPTHFILTER_IR8_SAMPLE_STEP of every DEPTHFILTER_IR8_SAMPLE_STEP rows, so the image is read in full once. The
+ * mapping runs with the kernels of simd_get_level().
+ */
+void depthfilter_tone_map_ir(const k4a_ir8_configuration_t *config,
+                             const uint16_t *ir_image,
+                             int width,
+                             int height,
+                             uint8_t *ir8_image);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEPTHFILTER_H */
@@ -0,0 +1,135 @@
+/** \file devicegroup.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Match the captures of several devices in wired sync by timestamp
+ */
+
+#ifndef DEVICEGROUP_H
+#define DEVICEGROUP_H
+
+#include <k4a/k4atypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of devices in a group, a master and up to 8 subordinates in a daisy chain
+ */
+#define DEVICEGROUP_MAX_DEVICES (9)
+
+/** Handle to the devicegroup module
+ *
+ * Handles are created with devicegroup_create() and closed
+ * with devicegroup_destroy().
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(devicegroup_t);
+
+/** Creates a devicegroup instance
+ *
+ * \param device_count
+ * Number of devices whose captures are matched, up to DEVICEGROUP_MAX_DEVICES
+ *
+ * \param devicegroup_handle
+ * pointer to a handle location to store the handle. This is only written on K4A_RESULT_SUCCEEDED;
+ *
+ * To cleanup this resource call devicegroup_destroy().
+ *
+ * \ref K4A_RESULT_SUCCEEDED is returned on success
+ */
+k4a_result_t devicegroup_create(uint32_t device_count, devicegroup_t *devicegroup_handle);
+
+/** Destroys a devicegroup instance
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle to destroy
+ *
+ * Captures held by the group are released.
+ */
+void devicegroup_destroy(devicegroup_t devicegroup_handle);
+
+/** Prepares the devicegroup to match captures
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle from devicegroup_create()
+ *
+ * \param configs
+ * The configuration each device was started with, one per device
+ *
+ * \remarks
+ * All devices must use the same camera_fps. Timestamps are aligned to the color camera of the master with
+ * subordinate_delay_off_master_usec and depth_delay_off_color_usec.
+ */
+k4a_result_t devicegroup_start(devicegroup_t devicegroup_handle, const k4a_device_configuration_t *configs);
+
+/** Stops matching captures
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle from devicegroup_create()
+ *
+ * \remarks
+ * Releases the pending captures and unblocks any waiters in devicegroup_get_capture()
+ */
+void devicegroup_stop(devicegroup_t devicegroup_handle);
+
+/** Adds a capture of one of the devices in the group
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle from devicegroup_create()
+ *
+ * \param device_index
+ * Index of the device that produced the capture
+ *
+ * \param result
+ * ::K4A_RESULT_FAILED if the stream of the device ended, in which case \p capture_handle may be NULL
+ *
+ * \param capture_handle
+ * The capture, the group takes its own reference
+ *
+ * \remarks
+ * Matching is done on the calling thread, the group has no threads of its own. A set of captures within a quarter
+ * frame period of each other is queued for devicegroup_get_capture(). Captures that can no longer be matched are
+ * dropped.
+ */
+void devicegroup_add_capture(devicegroup_t devicegroup_handle,
+                             uint32_t device_index,
+                             k4a_result_t result,
+                             k4a_capture_t capture_handle);
+
+/** Reads a set of matched captures
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle from devicegroup_create()
+ *
+ * \param capture_handles
+ * Location to write one capture per device, the caller releases each of them
+ *
+ * \param skew_usec
+ * Optional location to write the difference between the latest and earliest aligned timestamp of the set
+ *
+ * \param timeout_in_ms
+ * Time to wait for a set, 0 to not wait, or K4A_WAIT_INFINITE
+ */
+k4a_wait_result_t devicegroup_get_capture(devicegroup_t devicegroup_handle,
+                                          k4a_capture_t *capture_handles,
+                                          uint64_t *skew_usec,
+                                          int32_t timeout_in_ms);
+
+/** Gets the number of captures dropped because no match was found for them
+ *
+ * \param devicegroup_handle
+ * The devicegroup handle from devicegroup_create()
+ *
+ * \remarks
+ * Includes sets of matched captures dropped because devicegroup_get_capture() wasn't called fast enough, each counted
+ * once per capture. The count is reset by devicegroup_start().
+ */
+uint64_t devicegroup_get_dropped_count(devicegroup_t devicegroup_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEVICEGROUP_H */
@@ -37,6 +37,25 @@ typedef void(dewrapper_streaming_capture_cb_t)(k4a_result_t result,
                                                k4a_capture_t capture_handle,
                                                void *callback_context);
 
+/** Statistics of the depth engine of a dewrapper, cumulative since the dewrapper was created.
+ */
+typedef struct
+{
+    uint64_t processed_frames;     // Frames the depth engine completed
+    uint64_t failed_frames;        // Frames that failed or were dropped after processing
+    uint64_t slow_frames;          // Frames that took longer than max_compute_time_ms
+    uint32_t max_compute_time_ms;  // Time budget of a frame at the frame rate, 0 before the first frame
+    uint32_t last_compute_time_ms; // Processing time of the last completed frame
+
+    // Processing time of the completed frames, with the buckets of k4a_latency_stats_t::histogram
+    uint64_t compute_time_histogram[K4A_LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t compute_time_total_usec;
+
+    bool overloaded;                  // The overload policy is dropping raw frames
+    uint64_t overloads;               // Times the depth engine became overloaded
+    uint64_t overload_dropped_frames; // Raw frames dropped by the overload policy
+} dewrapper_stats_t;
+
 /** Handle to the dewrapper device.
  *
  * Handles are created with \ref dewrapper_create and closed
@@ -49,11 +68,61 @@ dewrapper_t dewrapper_create(k4a_calibration_camera_t *calibration,
                              dewrapper_streaming_capture_cb_t *capture_ready,
                              void *capture_ready_context);
 void dewrapper_destroy(dewrapper_t dewrapper_handle);
+
+// Sets the NUMA node the depth engine thread allocates its output buffers on, -1 for no preference. Applies the next
+// time the dewrapper is started.
+void dewrapper_set_numa_node(dewrapper_t dewrapper_handle, int numa_node);
+
+// Sets the GPU the depth engine runs on: a GPU index, K4A_DEPTH_ENGINE_GPU_AUTO or K4A_DEPTH_ENGINE_GPU_DEFAULT.
+// Applies the next time the dewrapper is started.
+void dewrapper_set_depth_engine_gpu(dewrapper_t dewrapper_handle, int32_t gpu_index);
+
+// Shares the depth engine with the other dewrappers of the process that have sharing enabled and the same depth mode
+// and GPU. Applies the next time the dewrapper is started.
+void dewrapper_set_depth_engine_shared(dewrapper_t dewrapper_handle, bool shared);
+
+// Keeps the depth engine initialized when the dewrapper is stopped, so the next start with the same depth mode doesn't
+// initialize it again. The depth engine is released when the dewrapper is destroyed.
+void dewrapper_set_keep_depth_engine(dewrapper_t dewrapper_handle, bool keep);
+
+// Sets the filters run on the depth images, NULL to disable them. The configuration must have been checked with
+// depthfilter_validate_configuration(). Applies the next time the dewrapper is started.
+void dewrapper_set_depth_filter(dewrapper_t dewrapper_handle, const k4a_depth_filter_configuration_t *config);
+
+// Exports the depth engine output as GPU resources attached to the depth and IR images, NULL to disable it. Applies
+// the next time the dewrapper is started, if the depth engine plugin supports it.
+void dewrapper_set_depth_gpu_export(dewrapper_t dewrapper_handle, const k4a_depth_gpu_export_configuration_t *config);
+
+// Has the depth engine output depth images without IR images, which halves its output buffer and readback. Applies the
+// next time the dewrapper is started, if the depth engine plugin supports it and the depth mode has depth images.
+void dewrapper_set_depth_only(dewrapper_t dewrapper_handle, bool depth_only);
+
+// Replaces the IR16 images of the captures with 8 bit IR images tone mapped with config, NULL to output IR16 images.
+// The configuration must have been checked with depthfilter_validate_ir8_configuration(). Applies the next time the
+// dewrapper is started.
+void dewrapper_set_ir8_output(dewrapper_t dewrapper_handle, const k4a_ir8_configuration_t *config);
+
+// Tells the dewrapper that only one of every decimation raw frames is posted to it, so the GPU load it reserves scales
+// with the frames it processes. Applies the next time the dewrapper is started.
+void dewrapper_set_frame_decimation(dewrapper_t dewrapper_handle, uint32_t decimation);
+
+// Drops raw frames when the depth engine takes longer than the frame period for config->frame_count frames in a row,
+// NULL to never drop them. Applies the next time the dewrapper is started.
+void dewrapper_set_overload_policy(dewrapper_t dewrapper_handle,
+                                   const k4a_depth_engine_overload_configuration_t *config);
+
+// Gets the statistics of the depth engine, see dewrapper_stats_t.
+void dewrapper_get_stats(dewrapper_t dewrapper_handle, dewrapper_stats_t *stats);
+
 k4a_result_t dewrapper_start(dewrapper_t dewrapper_handle,
                              const k4a_device_configuration_t *config,
                              uint8_t *calibration_memory,
                              size_t calibration_memory_size);
 void dewrapper_stop(dewrapper_t dewrapper_handle);
+
+// Stops a started dewrapper and starts it again with config, keeping the depth engine thread. The depth engine is kept
+// as well when the depth mode is unchanged, otherwise it is recreated on the same thread.
+k4a_result_t dewrapper_restart(dewrapper_t dewrapper_handle, const k4a_device_configuration_t *config);
 void dewrapper_post_capture(k4a_result_t cb_result, k4a_capture_t capture_raw, void *context);
 
 #ifdef __cplusplus
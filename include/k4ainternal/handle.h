@@ -37,10 +37,10 @@ extern "C" {
 #define STR_INTERNAL_CONTEXT_TYPE(type) STRINGIFY(type##_c)
 #endif
 
-/* K4A_DECLARE_CONTEXT creates type matched C functions to create, destroy and get the context. The create and destroy
-functions will ensure matched CPP constructor and destructor are called. To protext against the create function being
-used with CPP and destroy being used with C, or vise-vesa, the types get c or cpp appended to them. */
-#define K4A_DECLARE_CONTEXT(_public_handle_name_, _internal_context_type_)                                             \
+/* Shared implementation of K4A_DECLARE_CONTEXT and K4A_DECLARE_POOLED_CONTEXT. _allocate_(type, _alloc_fn_) returns
+memory for the handle and _destroy_(ptr, _free_fn_) releases it. */
+#define K4A_DECLARE_CONTEXT_IMPL(                                                                                      \
+    _public_handle_name_, _internal_context_type_, _allocate_, _destroy_, _alloc_fn_, _free_fn_)                       \
     extern char PRIV_HANDLE_TYPE(_public_handle_name_)[];                                                              \
     KSELECTANY char PRIV_HANDLE_TYPE(_public_handle_name_)[] = STR_INTERNAL_CONTEXT_TYPE(_internal_context_type_);     \
     typedef struct PUB_HANDLE_TYPE(_public_handle_name_)                                                               \
@@ -54,7 +54,7 @@ used with CPP and destroy being used with C, or vise-vesa, the types get c or cp
     {                                                                                                                  \
         PUB_HANDLE_TYPE(_public_handle_name_) * pContextWrapper;                                                       \
         *handle = NULL;                                                                                                \
-        pContextWrapper = ALLOCATE(PUB_HANDLE_TYPE(_public_handle_name_));                                             \
+        pContextWrapper = _allocate_(PUB_HANDLE_TYPE(_public_handle_name_), _alloc_fn_);                               \
         if (pContextWrapper == NULL)                                                                                   \
         {                                                                                                              \
             IF_LOGGER(LOG_ERROR("Failed to allocate " #_public_handle_name_, 0);) return NULL;                         \
@@ -86,9 +86,29 @@ used with CPP and destroy being used with C, or vise-vesa, the types get c or cp
         (void)_public_handle_name_##_get_context(handle);                                                              \
         IF_LOGGER(LOG_TRACE("Destroyed " #_public_handle_name_ " %p", handle);)                                        \
         ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType = NULL;                                          \
-        DESTROY((PUB_HANDLE_TYPE(_public_handle_name_) *)handle);                                                      \
+        _destroy_((PUB_HANDLE_TYPE(_public_handle_name_) *)handle, _free_fn_);                                         \
     }
 
+#define HANDLE_HEAP_ALLOCATE(type, alloc_fn) ALLOCATE(type)
+#define HANDLE_HEAP_DESTROY(ptr, free_fn) DESTROY(ptr)
+#define HANDLE_POOL_ALLOCATE(type, alloc_fn) (type *)(alloc_fn(sizeof(type))) /* Zero initialized */
+#define HANDLE_POOL_DESTROY(ptr, free_fn) free_fn(ptr)
+
+/* K4A_DECLARE_CONTEXT creates type matched C functions to create, destroy and get the context. The create and destroy
+functions will ensure matched CPP constructor and destructor are called. To protext against the create function being
+used with CPP and destroy being used with C, or vise-vesa, the types get c or cpp appended to them. */
+#define K4A_DECLARE_CONTEXT(_public_handle_name_, _internal_context_type_)                                             \
+    K4A_DECLARE_CONTEXT_IMPL(                                                                                          \
+        _public_handle_name_, _internal_context_type_, HANDLE_HEAP_ALLOCATE, HANDLE_HEAP_DESTROY, NULL, NULL)
+
+/* K4A_DECLARE_POOLED_CONTEXT is K4A_DECLARE_CONTEXT for handles created at a high rate. Memory for the handle comes
+from "void *_alloc_fn_(size_t size)", which must return zeroed memory, and goes back to "void _free_fn_(void *ptr)",
+which may keep it for the next create. No constructor or destructor runs, so the context must be a plain C type. A
+destroyed handle that is kept by the pool still fails validation until the memory is handed out again. */
+#define K4A_DECLARE_POOLED_CONTEXT(_public_handle_name_, _internal_context_type_, _alloc_fn_, _free_fn_)             \
+    K4A_DECLARE_CONTEXT_IMPL(                                                                                          \
+        _public_handle_name_, _internal_context_type_, HANDLE_POOL_ALLOCATE, HANDLE_POOL_DESTROY, _alloc_fn_, _free_fn_)
+
 /*
  * Example:
 
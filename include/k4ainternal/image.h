@@ -48,12 +48,101 @@ k4a_result_t image_create(k4a_image_format_t format,
                           allocation_source_t source,
                           k4a_image_t *image);
 
+/** Sets whether image_create() rounds a default stride up to a multiple of ALLOCATOR_ALIGNMENT
+ *
+ * \param enable
+ * true to pad the rows of images created with a stride of 0, false to use the minimum stride
+ */
+void image_set_row_padding(bool enable);
+
 /** Create a handle to an image object.
  * internal function to allocate an image object and memory blob of 'size'. Used for USB layer where we need counted
  * objects and don't know anything about the image. Also wrapped by IMU but never exposed.
  */
 k4a_result_t image_create_empty_internal(allocation_source_t source, size_t size, k4a_image_t *image);
 
+/** Create a handle to an image object.
+ * internal function to wrap a pre allocated memory blob of 'size' in a counted image object. Like \ref
+ * image_create_empty_internal, the image has no format or dimensions. When the last reference to the image is released
+ * buffer_destroy_cb is called so that the owner of the memory can reclaim it. Used by the USB layer to recycle
+ * streaming buffers.
+ *
+ * If this function fails, the caller still owns the buffer.
+ */
+k4a_result_t image_create_empty_from_buffer(uint8_t *buffer,
+                                            size_t size,
+                                            image_destroy_cb_t *buffer_destroy_cb,
+                                            void *buffer_destroy_cb_context,
+                                            k4a_image_t *image);
+
+/** Decodes the payload of a deferred image into its buffer.
+ *
+ * Called at most once per image, with the image lock held. buffer holds buffer_size bytes, the size of the image.
+ */
+typedef k4a_result_t(image_decode_cb_t)(k4a_image_t image_handle,
+                                        const uint8_t *payload,
+                                        size_t payload_size,
+                                        uint8_t *buffer,
+                                        size_t buffer_size,
+                                        void *context);
+
+/** Create a handle to an image whose buffer is decoded from a payload when it is first accessed.
+ *
+ * \param format [IN]
+ * format of the decoded image
+ *
+ * \param width_pixels [IN]
+ * width of the decoded image
+ *
+ * \param height_pixels [IN]
+ * height of the decoded image
+ *
+ * \param stride_bytes [IN]
+ * stride of the decoded image, the buffer is height_pixels * stride_bytes
+ *
+ * \param source [IN]
+ * source of the decoded buffer for allocation accounting
+ *
+ * \param payload [IN]
+ * encoded data the buffer is decoded from
+ *
+ * \param payload_size [IN]
+ * size in bytes of the payload
+ *
+ * \param payload_destroy_cb [IN]
+ * function called to free the payload once it has been decoded, or when the image is destroyed without being decoded
+ *
+ * \param payload_destroy_cb_context [IN]
+ * context passed to payload_destroy_cb
+ *
+ * \param decode_cb [IN]
+ * function decoding the payload into the image buffer
+ *
+ * \param decode_cb_context [IN]
+ * context passed to decode_cb
+ *
+ * \param image_handle [OUT]
+ * handle to the image
+ *
+ * The first call to \ref image_get_buffer allocates the buffer and calls decode_cb, later calls return the cached
+ * buffer. Images that are released without their buffer being accessed are never decoded. If decoding fails
+ * \ref image_get_buffer returns NULL and the decode is not retried. \ref image_get_size reports the decoded size.
+ *
+ * If this function fails, the caller still owns the payload.
+ */
+k4a_result_t image_create_deferred(k4a_image_format_t format,
+                                   int width_pixels,
+                                   int height_pixels,
+                                   int stride_bytes,
+                                   allocation_source_t source,
+                                   uint8_t *payload,
+                                   size_t payload_size,
+                                   image_destroy_cb_t *payload_destroy_cb,
+                                   void *payload_destroy_cb_context,
+                                   image_decode_cb_t *decode_cb,
+                                   void *decode_cb_context,
+                                   k4a_image_t *image_handle);
+
 /** Create a handle to an image object.
  * \param format [IN]
  * format of the image being created.
@@ -97,6 +186,32 @@ k4a_result_t image_create_from_buffer(k4a_image_format_t format,
                                       void *buffer_destroy_cb_context,
                                       k4a_image_t *image_handle);
 
+/** Creates an image of a rectangle of another image, sharing its buffer
+ *
+ * \param parent_handle [IN]
+ * Image the view points into, of a format with a fixed number of bytes per pixel other than NV12
+ *
+ * \param x [IN]
+ * \param y [IN]
+ * Top left pixel of the view in the parent
+ *
+ * \param width_pixels [IN]
+ * \param height_pixels [IN]
+ * Size of the view, inside the parent. The x position and width must be even for YUY2.
+ *
+ * \param image_handle [OUT]
+ * Location to write the view
+ *
+ * The view has the stride of the parent and holds a reference to it until the view is released. Its timestamps and
+ * metadata are copied from the parent when the view is created.
+ */
+k4a_result_t image_create_view(k4a_image_t parent_handle,
+                               int x,
+                               int y,
+                               int width_pixels,
+                               int height_pixels,
+                               k4a_image_t *image_handle);
+
 /** Removes one reference on image_t, free's when it hits zero
  *
  * \param image_handle [IN]
@@ -104,6 +219,18 @@ k4a_result_t image_create_from_buffer(k4a_image_format_t format,
  * */
 void image_dec_ref(k4a_image_t image_handle);
 
+/** Removes one reference on image_t, recycling its buffer when it hits zero
+ *
+ * \param image_handle [IN]
+ * Handle to the image to remove the reference from
+ *
+ * \remarks
+ * Same as \ref image_dec_ref, except that a buffer from the allocator is returned with allocator_recycle(). Buffers
+ * with their own destroy callback, like the depth engine output and the USB transfer buffers, are already reused by
+ * their owner.
+ */
+void image_recycle(k4a_image_t image_handle);
+
 /** Removes one reference on image_t, free's when it hits zero
  *
  * \param image_handle [IN]
@@ -118,6 +245,9 @@ k4a_image_format_t image_get_format(k4a_image_t image_handle);
 int image_get_width_pixels(k4a_image_t image_handle);
 int image_get_height_pixels(k4a_image_t image_handle);
 int image_get_stride_bytes(k4a_image_t image_handle);
+
+// Returns the stride of the image without row padding, 0 for formats without a fixed number of bytes per pixel
+int image_get_packed_stride_bytes(k4a_image_t image_handle);
 uint64_t image_get_device_timestamp_usec(k4a_image_t image_handle);
 uint64_t image_get_system_timestamp_nsec(k4a_image_t image_handle);
 uint64_t image_get_exposure_usec(k4a_image_t image_handle);
@@ -126,6 +256,20 @@ uint32_t image_get_iso_speed(k4a_image_t image_handle);
 void image_set_device_timestamp_usec(k4a_image_t image_handle, uint64_t timestamp_usec);
 void image_set_system_timestamp_nsec(k4a_image_t image_handle, uint64_t timestamp_nsec);
 k4a_result_t image_apply_system_timestamp(k4a_image_t image_handle);
+
+// Attaches the GPU resource the image was exported to, NULL to detach it. image_get_gpu_resource() fails for images
+// without one.
+void image_set_gpu_resource(k4a_image_t image_handle, const k4a_gpu_resource_t *resource);
+k4a_result_t image_get_gpu_resource(k4a_image_t image_handle, k4a_gpu_resource_t *resource);
+
+// Attaches the statistics of a depth image, NULL to detach them. image_get_depth_statistics() fails for images without
+// them.
+void image_set_depth_statistics(k4a_image_t image_handle, const k4a_depth_statistics_t *statistics);
+k4a_result_t image_get_depth_statistics(k4a_image_t image_handle, k4a_depth_statistics_t *statistics);
+
+// Records the time the depth engine took to produce the image, 0 for images it didn't produce
+void image_set_compute_time_usec(k4a_image_t image_handle, uint64_t compute_time_usec);
+uint64_t image_get_compute_time_usec(k4a_image_t image_handle);
 void image_set_exposure_usec(k4a_image_t image_handle, uint64_t exposure_usec);
 void image_set_white_balance(k4a_image_t image_handle, uint32_t white_balance);
 void image_set_iso_speed(k4a_image_t image_handle, uint32_t iso_speed);
@@ -11,6 +11,7 @@
 #include <k4ainternal/handle.h>
 #include <k4ainternal/color_mcu.h>
 #include <k4ainternal/calibration.h>
+#include <k4ainternal/queue.h>
 #include <azure_c_shared_utility/tickcounter.h>
 
 #ifdef __cplusplus
@@ -58,6 +59,32 @@ void imu_destroy(imu_t imu_handle);
 
 k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms);
 
+/** Reads the oldest buffered IMU samples
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param imu_samples [OUT]
+ * Array to write up to \p max_sample_count samples to.
+ *
+ * \param max_sample_count [IN]
+ * Number of samples \p imu_samples can hold.
+ *
+ * \param sample_count [OUT]
+ * Number of samples written to \p imu_samples.
+ *
+ * \param timeout_in_ms [IN]
+ * Time to wait for the first sample when none is buffered.
+ *
+ * \return ::K4A_WAIT_RESULT_SUCCEEDED if at least one sample was read, ::K4A_WAIT_RESULT_TIMEOUT if no sample arrived
+ * in time, otherwise ::K4A_WAIT_RESULT_FAILED.
+ */
+k4a_wait_result_t imu_get_samples(imu_t imu_handle,
+                                  k4a_imu_sample_t *imu_samples,
+                                  size_t max_sample_count,
+                                  size_t *sample_count,
+                                  int32_t timeout_in_ms);
+
 /** Starts the IMU sensor streaming
  *
  * \param imu_handle [IN]
@@ -73,6 +100,96 @@ k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample,
  */
 k4a_result_t imu_start(imu_t imu_handle, tickcounter_ms_t color_camera_start_tick);
 
+/** Attaches a waiter that is notified each time samples are buffered for \ref imu_get_samples and when the IMU stops
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param waiter_handle [IN]
+ * A waiter from \ref queue_waiter_create.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the waiter was attached. ::K4A_RESULT_FAILED if \ref QUEUE_MAX_WAITERS waiters
+ * are already attached.
+ */
+k4a_result_t imu_add_waiter(imu_t imu_handle, queue_waiter_t waiter_handle);
+
+/** Detaches a waiter attached with \ref imu_add_waiter
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param waiter_handle [IN]
+ * The waiter to detach.
+ */
+void imu_remove_waiter(imu_t imu_handle, queue_waiter_t waiter_handle);
+
+/** Checks whether \ref imu_get_samples would return without waiting
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \return true if samples are buffered, or if the IMU is not streaming and reads fail immediately.
+ */
+bool imu_is_ready(imu_t imu_handle);
+
+/** Sets the number of samples buffered for \ref imu_get_samples and which one is dropped when the buffer is full
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param queue_depth [IN]
+ * Number of samples to buffer, 0 for the default of half a second of samples.
+ *
+ * \param policy [IN]
+ * ::K4A_QUEUE_POLICY_DROP_OLDEST or ::K4A_QUEUE_POLICY_DROP_NEWEST, blocking the producer isn't supported.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the buffer was configured. ::K4A_RESULT_FAILED if the IMU is running or an
+ * argument is invalid.
+ */
+k4a_result_t imu_set_queue_policy(imu_t imu_handle, uint32_t queue_depth, k4a_queue_policy_t policy);
+
+/** Keeps the latest second of samples for \ref imu_get_history_samples, in addition to the samples buffered for
+ * \ref imu_get_samples
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param enabled [IN]
+ * True to keep the samples, false to drop them.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the history was enabled or disabled. ::K4A_RESULT_FAILED if it could not be
+ * allocated.
+ */
+k4a_result_t imu_set_history_enabled(imu_t imu_handle, bool enabled);
+
+/** Copies the calibrated samples of a time range from the history, without consuming them
+ *
+ * \param imu_handle [IN]
+ * The IMU device handle.
+ *
+ * \param start_usec [IN]
+ * Device timestamp of the first sample to copy.
+ *
+ * \param end_usec [IN]
+ * Device timestamp of the last sample to copy.
+ *
+ * \param imu_samples [OUT]
+ * Samples allocated with malloc(), which the caller frees. NULL if no sample is in the range.
+ *
+ * \param sample_count [OUT]
+ * Number of samples in \p imu_samples.
+ *
+ * \return ::K4A_RESULT_SUCCEEDED if the samples in the range were copied, which may be none. ::K4A_RESULT_FAILED if
+ * the history isn't enabled or an allocation failed.
+ *
+ * Only samples that have arrived from the device are copied, the end of a recent range may still be missing.
+ */
+k4a_result_t imu_get_history_samples(imu_t imu_handle,
+                                     uint64_t start_usec,
+                                     uint64_t end_usec,
+                                     k4a_imu_sample_t **imu_samples,
+                                     size_t *sample_count);
+
 /** Stops the IMU sensor when it has been streaming
  *
  * \param imu_handle [IN]
@@ -0,0 +1,157 @@
+/** \file k4adecoderplugin.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure Color Decoder Plugin API.
+ * Defines the API which must be defined by a color decoder plugin, such as a VA-API or NVJPEG based decoder, to be
+ * used by the Azure Kinect SDK in place of its software MJPEG decoder.
+ */
+
+#ifndef K4A_DECODER_PLUGIN_H
+#define K4A_DECODER_PLUGIN_H
+
+#include <k4ainternal/k4aplugin.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Current Version of the Azure Kinect Color Decoder Plugin Interface
+ *
+ * \remarks
+ * When the color decoder plugin interface (k4a_decoder_plugin_t) is updated, this version should be increased.
+ */
+#define K4A_DECODER_PLUGIN_VERSION 1 /**< Azure Kinect color decoder plugin version */
+
+/**
+ * Expected name of the color decoder plugin's dynamic library
+ *
+ * \remarks The library is only loaded when the K4A_COLOR_HARDWARE_DECODE environment variable is set. See
+ * \ref dynlib_create for how the version is encoded in the file name.
+ */
+#define K4A_DECODER_PLUGIN_DYNAMIC_LIBRARY_NAME "k4acolordecoder"
+
+/**
+ * Name of the function all color decoder plugins must export in a dynamic library
+ *
+ * \remarks Please see \ref k4a_register_decoder_plugin_fn for the signature of that function.
+ */
+#define K4A_DECODER_PLUGIN_EXPORTED_FUNCTION "k4a_register_decoder_plugin"
+
+/** Color decoder return codes
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4adecoderplugin.h (include k4a/k4adecoderplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_DECODER_RESULT_SUCCEEDED = 0,   /**< Result succeeded */
+    K4A_DECODER_RESULT_DATA_ERROR = 1,  /**< The frame could not be decoded, it is dropped */
+    K4A_DECODER_RESULT_UNSUPPORTED = 2, /**< The request is not supported, the SDK decodes it in software instead */
+    K4A_DECODER_RESULT_FATAL_ERROR = 3, /**< The decoder failed and should not be used again */
+} k4a_decoder_result_code_t;
+
+/** Color decoder context handle to be implemented by plugin
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4adecoderplugin.h (include k4a/k4adecoderplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct k4a_decoder_context_t k4a_decoder_context_t;
+
+/** Function for creating a color decoder.
+ *
+ * \param context
+ * An opaque pointer to be passed around to the rest of the color decoder calls. A context is only used by one thread
+ * at a time, the SDK creates one context per decoding thread.
+ *
+ * \param width_pixels
+ * Width of the decoded frames, which may be smaller than the width of the MJPEG frames when they are scaled
+ *
+ * \param height_pixels
+ * Height of the decoded frames
+ *
+ * \returns
+ * K4A_DECODER_RESULT_SUCCEEDED on success, K4A_DECODER_RESULT_UNSUPPORTED if the plugin cannot decode to this size
+ */
+typedef k4a_decoder_result_code_t(__stdcall *k4a_decoder_create_fn_t)(k4a_decoder_context_t **context,
+                                                                      uint32_t width_pixels,
+                                                                      uint32_t height_pixels);
+
+/** Function to decode an MJPEG frame to BGRA32.
+ *
+ * \param context
+ * context created by \ref k4a_decoder_create_fn_t
+ *
+ * \param input_frame
+ * Input frame buffer containing the MJPEG frame
+ *
+ * \param input_frame_size
+ * Size of the input_frame buffer in bytes
+ *
+ * \param output_frame
+ * The buffer of the output frame, in system memory
+ *
+ * \param output_stride_bytes
+ * Stride of the output frame in bytes
+ *
+ * \param output_frame_size
+ * Size of the output_frame buffer in bytes
+ *
+ * \returns
+ * K4A_DECODER_RESULT_SUCCEEDED on success, or the proper failure code on failure
+ */
+typedef k4a_decoder_result_code_t(__stdcall *k4a_decoder_decode_mjpeg_fn_t)(k4a_decoder_context_t *context,
+                                                                            const uint8_t *input_frame,
+                                                                            size_t input_frame_size,
+                                                                            uint8_t *output_frame,
+                                                                            uint32_t output_stride_bytes,
+                                                                            size_t output_frame_size);
+
+/** Destroys the color decoder context.
+ *
+ * \param context
+ * context created by \ref k4a_decoder_create_fn_t
+ */
+typedef void(__stdcall *k4a_decoder_destroy_fn_t)(k4a_decoder_context_t **context);
+
+/** Color decoder plugin API which must be populated on plugin registration.
+ *
+ * \remarks
+ * The Azure Kinect SDK will call k4a_register_decoder_plugin, and pass in a pointer to a \ref k4a_decoder_plugin_t.
+ * The plugin must properly fill out all fields of the plugin for the Azure Kinect SDK to accept the plugin.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4adecoderplugin.h (include k4a/k4adecoderplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_decoder_plugin_t
+{
+    k4a_plugin_version_t version;               /**< Color decoder version */
+    k4a_decoder_create_fn_t decoder_create;     /**< Function pointer to a decoder_create function */
+    k4a_decoder_decode_mjpeg_fn_t decode_mjpeg; /**< Function pointer to a decode_mjpeg function */
+    k4a_decoder_destroy_fn_t decoder_destroy;   /**< Function pointer to a decoder_destroy function */
+} k4a_decoder_plugin_t;
+
+/** Function signature for \ref K4A_DECODER_PLUGIN_EXPORTED_FUNCTION.
+ *
+ * \param plugin
+ * function pointers and version of the plugin to filled out
+ *
+ * \returns
+ * True if the plugin believes it successfully registered, false otherwise.
+ */
+typedef bool(__cdecl *k4a_register_decoder_plugin_fn)(k4a_decoder_plugin_t *plugin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* K4A_DECODER_PLUGIN_H */
@@ -52,6 +52,13 @@ extern "C" {
  */
 #define K4A_PLUGIN_EXPORTED_FUNCTION "k4a_register_plugin"
 
+/**
+ * Number of frames an asynchronous depth engine must accept submitted and not yet completed
+ *
+ * \remarks See \ref k4a_de_submit_frame_fn_t.
+ */
+#define K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT (3)
+
 /** Supported Depth Engine modes
  *
  * \xmlonly
@@ -85,6 +92,8 @@ typedef enum
     K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH = 0,  /**< Output z depth */
     K4A_DEPTH_ENGINE_OUTPUT_TYPE_RADIAL_DEPTH, /**< Output radial depth */
     K4A_DEPTH_ENGINE_OUTPUT_TYPE_PCM,          /**< Output passive ir */
+    K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY, /**< Output z depth without the IR image, only passed to plugins that
+                                                  return its size from \ref k4a_de_get_output_type_frame_size_fn_t */
 } k4a_depth_engine_output_type_t;
 
 /** Depth Engine supported input formats
@@ -104,6 +113,22 @@ typedef enum
     K4A_DEPTH_ENGINE_INPUT_TYPE_8BIT_COMPRESSED = 4,  /**< 8bit compressed */
 } k4a_depth_engine_input_type_t;
 
+/** GPU context the depth and transform engines are created in
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4aplugin.h (include k4a/k4aplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_DEPTH_ENGINE_GPU_CONTEXT_DEFAULT = 0,  /**< Context picked by the plugin */
+    K4A_DEPTH_ENGINE_GPU_CONTEXT_WINDOWED = 1, /**< Context of the windowing system, for example GLX on X11 */
+    K4A_DEPTH_ENGINE_GPU_CONTEXT_HEADLESS = 2, /**< Surfaceless context that needs no display server, for example
+                                                  EGL on the EGL device platform */
+} k4a_depth_engine_gpu_context_t;
+
 /** Transform Engine types
  *
  * \xmlonly
@@ -134,6 +159,37 @@ typedef enum
     K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR       /**< Linear interpolation */
 } k4a_transform_engine_interpolation_t;
 
+/** GPU resource types the transform engine can export its output as
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4aplugin.h (include k4a/k4aplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_TEXTURE = 0,       /**< OpenGL texture in a shared context */
+    K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_BUFFER = 1,        /**< OpenGL buffer in a shared context */
+    K4A_TRANSFORM_ENGINE_GPU_EXPORT_CUDA_EXTERNAL_MEMORY = 2, /**< Memory and semaphore handles for CUDA to import */
+    K4A_TRANSFORM_ENGINE_GPU_EXPORT_D3D11_SHARED_HANDLE = 3,  /**< D3D11 shared texture and fence handles */
+} k4a_transform_engine_gpu_export_t;
+
+/** Transform engine output exported as a GPU resource
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4aplugin.h (include k4a/k4aplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_transform_engine_gpu_output_t
+{
+    uint64_t handle; /**< Handle of the resource, see \ref k4a_transform_engine_gpu_export_t */
+    size_t size;     /**< Size of the resource in bytes */
+    uint64_t fence;  /**< Fence signaled when the output is written, 0 if it was written before returning */
+} k4a_transform_engine_gpu_output_t;
+
 /** Depth Engine output frame information
  *
  * \xmlonly
@@ -367,6 +423,123 @@ typedef size_t(__stdcall *k4a_de_get_output_frame_size_fn_t)(k4a_depth_engine_co
  */
 typedef void(__stdcall *k4a_de_destroy_fn_t)(k4a_depth_engine_context_t **context);
 
+/** Function to get the number of GPUs the depth engine can run on.
+ *
+ * \returns
+ * The number of GPUs \ref k4a_de_create_and_initialize_on_gpu_fn_t accepts, GPU indices are 0 to the count - 1.
+ */
+typedef uint32_t(__stdcall *k4a_de_get_gpu_count_fn_t)(void);
+
+/** Function to create and initialize the depth engine on a given GPU.
+ *
+ * \param gpu_index
+ * The GPU to run the depth engine on, less than the count returned by \ref k4a_de_get_gpu_count_fn_t
+ *
+ * \remarks
+ * The other parameters and the return value are those of \ref k4a_de_create_and_initialize_fn_t
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_create_and_initialize_on_gpu_fn_t)(
+    k4a_depth_engine_context_t **context,
+    size_t cal_block_size_in_bytes,
+    void *cal_block,
+    k4a_depth_engine_mode_t mode,
+    k4a_depth_engine_input_type_t input_format,
+    void *camera_calibration,
+    k4a_processing_complete_cb_t *callback,
+    void *callback_context,
+    uint32_t gpu_index);
+
+/** Function to create and initialize a depth engine that shares its GPU resources with another depth engine.
+ *
+ * \param shared_context
+ * A depth engine created with the same mode and input format. The new depth engine runs on the same GPU and shares the
+ * GPU context, shaders and intermediate buffers of shared_context; only the state derived from the calibration is its
+ * own. The shared resources are kept until the last depth engine using them is destroyed, so shared_context may be
+ * destroyed first.
+ *
+ * \remarks
+ * The other parameters and the return value are those of \ref k4a_de_create_and_initialize_fn_t
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_create_and_initialize_shared_fn_t)(
+    k4a_depth_engine_context_t **context,
+    size_t cal_block_size_in_bytes,
+    void *cal_block,
+    k4a_depth_engine_mode_t mode,
+    k4a_depth_engine_input_type_t input_format,
+    void *camera_calibration,
+    k4a_processing_complete_cb_t *callback,
+    void *callback_context,
+    k4a_depth_engine_context_t *shared_context);
+
+/** One frame of a batch passed to \ref k4a_de_process_frame_batch_fn_t
+ *
+ * The fields are the parameters of \ref k4a_de_process_frame_fn_t, result is written by the depth engine.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4aplugin.h (include k4a/k4aplugin.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_depth_engine_batch_frame_t
+{
+    k4a_depth_engine_context_t *context;                     /**< Depth engine to process the frame with */
+    void *input_frame;                                       /**< Input frame buffer with raw captured data */
+    size_t input_frame_size;                                 /**< Size of input_frame in bytes */
+    k4a_depth_engine_output_type_t output_type;              /**< Type of frame to output */
+    void *output_frame;                                      /**< Buffer of the output frame */
+    size_t output_frame_size;                                /**< Size of output_frame in bytes */
+    k4a_depth_engine_output_frame_info_t *output_frame_info; /**< Output frame information */
+    k4a_depth_engine_input_frame_info_t *input_frame_info;   /**< Input frame information, NULL at runtime */
+    k4a_depth_engine_result_code_t result;                   /**< Result of processing this frame */
+} k4a_depth_engine_batch_frame_t;
+
+/** Function to process the frames of several depth engines in one GPU dispatch.
+ *
+ * \param frames
+ * The frames to process. All contexts were created with \ref k4a_de_create_and_initialize_shared_fn_t from the same
+ * depth engine, each context appears at most once.
+ *
+ * \param frame_count
+ * Number of entries in frames
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED if the batch was dispatched, the result of each frame is in its result field.
+ * Any other code is a failure of the whole batch.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_process_frame_batch_fn_t)(
+    k4a_depth_engine_batch_frame_t *frames,
+    uint32_t frame_count);
+
+/** Function to select the GPU context of the depth and transform engines.
+ *
+ * \param gpu_context
+ * The type of GPU context to create the engines in
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED if the plugin supports the context type, or the proper failure code on failure
+ *
+ * \remarks
+ * Called once after the plugin is registered, before any depth or transform engine is created.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_set_gpu_context_fn_t)(
+    k4a_depth_engine_gpu_context_t gpu_context);
+
+/** Function to set the directory the depth and transform engines cache their compiled GPU programs in.
+ *
+ * \param directory
+ * Directory for the cache, created by the plugin if it doesn't exist. NULL disables the cache.
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED if the cache is used, or the proper failure code on failure
+ *
+ * \remarks
+ * Called once after the plugin is registered, before any depth or transform engine is created. Cached programs are
+ * loaded instead of compiled when an engine is initialized, the plugin must not load programs built by another
+ * plugin version, GPU or driver.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_set_shader_cache_fn_t)(const char *directory);
+
 /** Function for creating and initializing the transform engine.
  *
  * \param context
@@ -468,6 +641,238 @@ typedef size_t(__stdcall *k4a_te_get_output_frame_size_fn_t)(k4a_transform_engin
  */
 typedef void(__stdcall *k4a_te_destroy_fn_t)(k4a_transform_engine_context_t **context);
 
+/** Function to process a transform engine frame into an exported GPU resource instead of host memory.
+ *
+ * \param context
+ * context created by \ref k4a_te_create_and_initialize_fn_t
+ *
+ * \param type
+ * K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR or K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH
+ *
+ * \param export_type
+ * How the output is shared
+ *
+ * \param output
+ * Receives the exported resource. It is laid out like the output_frame of \ref k4a_te_process_frame_fn_t.
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED on success, or the proper failure code on failure. Export types the plugin doesn't
+ * support fail with K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_INVALID_PARAMETER and leave the context usable.
+ *
+ * \remarks
+ * The other parameters are those of \ref k4a_te_process_frame_fn_t. The resource stays valid until it is passed to
+ * \ref k4a_te_release_gpu_output_fn_t, the plugin must not write it again before that. It is called on the thread
+ * that created the context.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_te_process_frame_gpu_fn_t)(
+    k4a_transform_engine_context_t *context,
+    k4a_transform_engine_type_t type,
+    k4a_transform_engine_interpolation_t interpolation,
+    uint32_t invalid_value,
+    const void *depth_frame,
+    size_t depth_frame_size,
+    const void *frame2,
+    size_t frame2_size,
+    k4a_transform_engine_gpu_export_t export_type,
+    k4a_transform_engine_gpu_output_t *output);
+
+/** Function to release a resource exported by \ref k4a_te_process_frame_gpu_fn_t.
+ *
+ * \param context
+ * context the resource was exported from
+ *
+ * \param export_type
+ * The export_type the resource was exported with
+ *
+ * \param output
+ * The resource to release
+ *
+ * \remarks
+ * Called on the thread that created the context, before the context is destroyed.
+ */
+typedef void(__stdcall *k4a_te_release_gpu_output_fn_t)(k4a_transform_engine_context_t *context,
+                                                       k4a_transform_engine_gpu_export_t export_type,
+                                                       k4a_transform_engine_gpu_output_t *output);
+
+/** Function to process a depth engine frame into an exported GPU resource.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param output_frame
+ * Host buffer that the frame is read back to as by \ref k4a_de_process_frame_fn_t
+ *
+ * \param skip_depth_readback
+ * Don't write the depth image to output_frame, only the IR image that follows it
+ *
+ * \param export_type
+ * How the output is shared. The resource uses the same values as \ref k4a_te_process_frame_gpu_fn_t: the depth and IR
+ * images are the two layers of a texture array for textures and follow each other in memory for buffers.
+ *
+ * \param slot
+ * Resource to write, below slot_count. The SDK cycles through the slots so a resource is not written while the
+ * application still reads the last frame in it.
+ *
+ * \param slot_count
+ * Number of slots, the same for every call to a context
+ *
+ * \param gpu_output
+ * Receives the exported resource. Resources are owned by the context and released when it is destroyed.
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED on success, or the proper failure code on failure. Export types the plugin doesn't
+ * support fail with K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_INVALID_PARAMETER.
+ *
+ * \remarks
+ * The other parameters are those of \ref k4a_de_process_frame_fn_t.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_process_frame_gpu_fn_t)(
+    k4a_depth_engine_context_t *context,
+    void *input_frame,
+    size_t input_frame_size,
+    k4a_depth_engine_output_type_t output_type,
+    void *output_frame,
+    size_t output_frame_size,
+    bool skip_depth_readback,
+    k4a_depth_engine_output_frame_info_t *output_frame_info,
+    k4a_depth_engine_input_frame_info_t *input_frame_info,
+    k4a_transform_engine_gpu_export_t export_type,
+    uint32_t slot,
+    uint32_t slot_count,
+    k4a_transform_engine_gpu_output_t *gpu_output);
+
+/** Function to process a transform engine frame whose depth image is a GPU resource exported by the depth engine.
+ *
+ * \param depth_export_type
+ * The export_type depth_input was exported with by \ref k4a_de_process_frame_gpu_fn_t
+ *
+ * \param depth_input
+ * The resource with the depth image, read on the GPU after waiting for its fence
+ *
+ * \remarks
+ * The other parameters are those of \ref k4a_te_process_frame_gpu_fn_t, the output is exported as a GPU resource as
+ * well and released with \ref k4a_te_release_gpu_output_fn_t.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_te_process_frame_gpu_input_fn_t)(
+    k4a_transform_engine_context_t *context,
+    k4a_transform_engine_type_t type,
+    k4a_transform_engine_interpolation_t interpolation,
+    uint32_t invalid_value,
+    k4a_transform_engine_gpu_export_t depth_export_type,
+    const k4a_transform_engine_gpu_output_t *depth_input,
+    const void *frame2,
+    size_t frame2_size,
+    k4a_transform_engine_gpu_export_t export_type,
+    k4a_transform_engine_gpu_output_t *output);
+
+/** Get the size of the output frame of one output type in bytes.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param output_type
+ * The output type passed to the process frame functions
+ *
+ * \returns
+ * The size of the output frame in bytes, or 0 if the plugin doesn't support the output type. Without this function
+ * only the output types before K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY are used, with the size returned by
+ * \ref k4a_de_get_output_frame_size_fn_t.
+ */
+typedef size_t(__stdcall *k4a_de_get_output_type_frame_size_fn_t)(k4a_depth_engine_context_t *context,
+                                                                   k4a_depth_engine_output_type_t output_type);
+
+/** Function to register the host buffers a depth engine context writes its asynchronous outputs to.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param output_frames
+ * The buffers, each output_frame_size bytes. They stay allocated until the context is destroyed or the function is
+ * called again.
+ *
+ * \param output_frame_count
+ * Number of buffers in output_frames, 0 to unregister the buffers
+ *
+ * \param output_frame_size
+ * Size of each buffer in bytes
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED on success, or the proper failure code on failure
+ *
+ * \remarks
+ * Lets the plugin map or pin the buffers once, for example as persistently mapped GPU buffers, so reading back a frame
+ * into them needs no staging copy. \ref k4a_de_submit_frame_fn_t accepts other buffers as well.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_register_output_frames_fn_t)(
+    k4a_depth_engine_context_t *context,
+    void *const *output_frames,
+    uint32_t output_frame_count,
+    size_t output_frame_size);
+
+/** Function to start processing a depth engine frame without waiting for it to complete.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param input_frame
+ * Frame buffer containing depth raw captured data. It is read before the function returns.
+ *
+ * \param output_frame
+ * Buffer the output is written to. It must not be read or freed until the frame is returned by
+ * \ref k4a_de_complete_frame_fn_t.
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED if the frame was submitted, or the proper failure code on failure. Errors of the
+ * processing itself are returned when the frame completes.
+ *
+ * \remarks
+ * The other parameters are those of \ref k4a_de_process_frame_fn_t. Up to K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT
+ * frames are submitted before the oldest one is completed, and frames complete in the order they were submitted.
+ * Submit, poll and complete are called from one thread at a time for a context.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_submit_frame_fn_t)(
+    k4a_depth_engine_context_t *context,
+    void *input_frame,
+    size_t input_frame_size,
+    k4a_depth_engine_output_type_t output_type,
+    void *output_frame,
+    size_t output_frame_size,
+    k4a_depth_engine_input_frame_info_t *input_frame_info);
+
+/** Function to check whether the oldest frame submitted by \ref k4a_de_submit_frame_fn_t is complete.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param completed
+ * Set to true if \ref k4a_de_complete_frame_fn_t would return the oldest frame without waiting
+ *
+ * \returns
+ * K4A_DEPTH_ENGINE_RESULT_SUCCEEDED on success, or the proper failure code on failure
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_poll_frame_fn_t)(k4a_depth_engine_context_t *context,
+                                                                          bool *completed);
+
+/** Function to wait for the oldest frame submitted by \ref k4a_de_submit_frame_fn_t to complete.
+ *
+ * \param context
+ * context created by \ref k4a_de_create_and_initialize_fn_t
+ *
+ * \param output_frame
+ * Set to the output_frame the frame was submitted with
+ *
+ * \param output_frame_info
+ * Output frame info, as written by \ref k4a_de_process_frame_fn_t
+ *
+ * \returns
+ * The result of processing the frame, as returned by \ref k4a_de_process_frame_fn_t. The frame is complete and its
+ * output_frame is returned to the caller whatever the result, unless no frame was submitted.
+ */
+typedef k4a_depth_engine_result_code_t(__stdcall *k4a_de_complete_frame_fn_t)(
+    k4a_depth_engine_context_t *context,
+    void **output_frame,
+    k4a_depth_engine_output_frame_info_t *output_frame_info);
+
 /** Plugin API which must be populated on plugin registration.
  *
  * \remarks
@@ -475,6 +880,17 @@ typedef void(__stdcall *k4a_te_destroy_fn_t)(k4a_transform_engine_context_t **co
  * k4a_plugin_t. The plugin must properly fill out all fields of the plugin for
  * the Azure Kinect SDK to accept the plugin.
  *
+ * \remarks
+ * The fields marked optional come last and are zeroed before k4a_register_plugin is called, so plugins built before
+ * they were added still load. Without them every depth engine runs on the GPU the plugin picks, depth engines of
+ * different devices don't share GPU resources, the plugin picks its GPU context, it compiles its GPU programs every
+ * time an engine is initialized, depth engine and transformation outputs are only read back into host memory, the
+ * depth engine always outputs the IR image with the depth image and it processes one frame at a time.
+ *
+ * \remarks
+ * The asynchronous entry points register_output_frames, submit_frame, poll_frame and complete_frame are used together.
+ * A plugin provides all four or none of them.
+ *
  * \xmlonly
  * <requirements>
  *   <requirement name="Header">k4aplugin.h (include k4a/k4aplugin.h)</requirement>
@@ -502,6 +918,40 @@ typedef struct _k4a_plugin_t
                                                                                  transform_engine_get_output_frame_size
                                                                                  function */
     k4a_te_destroy_fn_t transform_engine_destroy; /**< Function pointer to a transform_engine_destroy function */
+    k4a_de_get_gpu_count_fn_t depth_engine_get_gpu_count; /**< Optional function pointer to a
+                                                             depth_engine_get_gpu_count function */
+    k4a_de_create_and_initialize_on_gpu_fn_t depth_engine_create_and_initialize_on_gpu; /**< Optional function pointer
+                                                                                           to a depth_engine_create_and_
+                                                                                           initialize_on_gpu function */
+    k4a_de_create_and_initialize_shared_fn_t depth_engine_create_and_initialize_shared; /**< Optional function pointer
+                                                                                           to a depth_engine_create_and_
+                                                                                           initialize_shared function */
+    k4a_de_process_frame_batch_fn_t depth_engine_process_frame_batch; /**< Optional function pointer to a
+                                                                         depth_engine_process_frame_batch function */
+    k4a_de_set_gpu_context_fn_t set_gpu_context; /**< Optional function pointer to a set_gpu_context function */
+    k4a_de_set_shader_cache_fn_t set_shader_cache; /**< Optional function pointer to a set_shader_cache function */
+    k4a_te_process_frame_gpu_fn_t transform_engine_process_frame_gpu; /**< Optional function pointer to a
+                                                                         transform_engine_process_frame_gpu function */
+    k4a_te_release_gpu_output_fn_t transform_engine_release_gpu_output; /**< Optional function pointer to a
+                                                                           transform_engine_release_gpu_output
+                                                                           function */
+    k4a_de_process_frame_gpu_fn_t depth_engine_process_frame_gpu; /**< Optional function pointer to a
+                                                                     depth_engine_process_frame_gpu function */
+    k4a_te_process_frame_gpu_input_fn_t transform_engine_process_frame_gpu_input; /**< Optional function pointer to a
+                                                                                     transform_engine_process_frame_
+                                                                                     gpu_input function */
+    k4a_de_get_output_type_frame_size_fn_t depth_engine_get_output_type_frame_size; /**< Optional function pointer to
+                                                                                       a depth_engine_get_output_type_
+                                                                                       frame_size function */
+    k4a_de_register_output_frames_fn_t depth_engine_register_output_frames; /**< Optional function pointer to a
+                                                                               depth_engine_register_output_frames
+                                                                               function */
+    k4a_de_submit_frame_fn_t depth_engine_submit_frame; /**< Optional function pointer to a depth_engine_submit_frame
+                                                           function */
+    k4a_de_poll_frame_fn_t depth_engine_poll_frame; /**< Optional function pointer to a depth_engine_poll_frame
+                                                       function */
+    k4a_de_complete_frame_fn_t depth_engine_complete_frame; /**< Optional function pointer to a
+                                                               depth_engine_complete_frame function */
 } k4a_plugin_t;
 
 /** Function signature for \ref K4A_PLUGIN_EXPORTED_FUNCTION.
@@ -0,0 +1,67 @@
+/** \file latency.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Latency of the stages of the depth capture pipeline
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <k4a/k4atypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Reads the clock used for image system timestamps
+ *
+ * \return The current time in nanoseconds, 0 if the clock can not be read
+ */
+uint64_t latency_get_time_nsec(void);
+
+/** Records the latency of a stage
+ *
+ * \param stage
+ * The stage that ran
+ *
+ * \param start_nsec
+ * Time the stage started, read with latency_get_time_nsec() or from an image system timestamp
+ *
+ * \param end_nsec
+ * Time the stage ended
+ *
+ * \remarks
+ * Samples with a start time of 0 or an end time before the start time are ignored.
+ */
+void latency_record(k4a_latency_stage_t stage, uint64_t start_nsec, uint64_t end_nsec);
+
+/** Gets the bucket of the latency histograms a duration falls in
+ *
+ * \param latency_usec
+ * The duration in microseconds
+ *
+ * \return The index in k4a_latency_stats_t::histogram, the last bucket for durations past the others
+ */
+int latency_get_histogram_bucket(uint64_t latency_usec);
+
+/** Gets the latency statistics of a stage
+ *
+ * \param stage
+ * The stage to read
+ *
+ * \param stats
+ * Location to write the statistics
+ */
+k4a_result_t latency_get_stats(k4a_latency_stage_t stage, k4a_latency_stats_t *stats);
+
+/** Clears the statistics of every stage
+ */
+void latency_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H */
@@ -59,6 +59,77 @@ k4a_result_t logger_register_message_callback(k4a_logging_message_cb_t *message_
 
 void logger_log(k4a_log_level_t level, const char *file, const int line, const char *format, ...);
 
+/** Events recorded in the trace ring by \ref logger_trace. The meaning of the arguments of each event is listed next
+ * to it. Queues and captures are identified by their addresses.
+ *
+ * \remarks
+ * Values are stored in dumped files, add new events at the end.
+ */
+typedef enum
+{
+    LOGGER_TRACE_USB_TRANSFER = 0,   ///< USB transfer completed: interface, libusb status, bytes
+    LOGGER_TRACE_QUEUE_PUSH,         ///< Capture pushed: queue, capture, 0
+    LOGGER_TRACE_QUEUE_POP,          ///< Queue popped: queue, capture (0 if none), k4a_wait_result_t
+    LOGGER_TRACE_QUEUE_DROP,         ///< Capture dropped by a full queue: queue, capture, k4a_queue_policy_t
+    LOGGER_TRACE_DEPTH_ENGINE_START, ///< Raw depth frame submitted: device timestamp in usec, bytes, 0
+    LOGGER_TRACE_DEPTH_ENGINE_END,   ///< Depth frame completed: center of exposure in ticks, result code, dropped
+    LOGGER_TRACE_CAPTURESYNC_MATCH,  ///< Color and depth matched: color timestamp, depth timestamp in usec, 0
+    LOGGER_TRACE_CAPTURESYNC_DROP,   ///< Capture not matched: timestamp in usec, 1 for color, 1 if its queue was full
+    LOGGER_TRACE_EVENT_COUNT
+} logger_trace_event_t;
+
+/** Records an event in the trace ring.
+ *
+ * \remarks
+ * The ring is always on. Recording takes a timestamp and stores the event and its arguments without formatting or
+ * locking, so it is safe on the streaming paths where \ref logger_log at trace level would change their timing. The
+ * oldest events are overwritten once the ring is full.
+ *
+ * \remarks
+ * Timestamps use the same clock as the system timestamps of images.
+ */
+void logger_trace(logger_trace_event_t event, uint64_t arg0, uint64_t arg1, uint64_t arg2);
+
+/** Writes the events recorded in the trace ring to a file.
+ *
+ * \param path [IN]
+ * Path of the file to create.
+ *
+ * \param duration_usec [IN]
+ * Only events recorded in the last duration_usec microseconds are written, 0 writes every event still in the ring.
+ *
+ * \remarks
+ * The file starts with a \ref logger_trace_file_header_t, followed by the name of each event as a null terminated
+ * string in the order of \ref logger_trace_event_t, followed by a \ref logger_trace_record_t for each event from
+ * oldest to newest. All values are in the byte order of the host.
+ *
+ * \remarks
+ * Events keep being recorded while the file is written.
+ */
+k4a_result_t logger_trace_dump(const char *path, uint64_t duration_usec);
+
+#define LOGGER_TRACE_FILE_MAGIC "K4ATRACE"
+#define LOGGER_TRACE_FILE_VERSION (1)
+
+/** Header of a file written by \ref logger_trace_dump. */
+typedef struct
+{
+    char magic[8];             ///< LOGGER_TRACE_FILE_MAGIC without its null terminator
+    uint32_t version;          ///< LOGGER_TRACE_FILE_VERSION
+    uint32_t event_name_count; ///< Number of event names following the header
+    uint64_t record_count;     ///< Number of records following the event names
+    uint64_t dump_time_nsec;   ///< Time the file was written, on the clock of the record timestamps
+} logger_trace_file_header_t;
+
+/** An event in a file written by \ref logger_trace_dump. */
+typedef struct
+{
+    uint64_t time_nsec; ///< Time the event was recorded
+    uint32_t event;     ///< logger_trace_event_t
+    uint32_t reserved;
+    uint64_t args[3]; ///< Arguments of the event
+} logger_trace_record_t;
+
 FORCEINLINE k4a_result_t
 TraceError(k4a_result_t result, const char *szCall, const char *szFile, int line, const char *szFunction)
 {
@@ -93,10 +164,12 @@ FORCEINLINE k4a_result_t TraceReturn(k4a_result_t result, const char *szFile, in
     {
         logger_log(K4A_LOG_LEVEL_ERROR, szFile, line, "%s() returned failure.", szFunction);
     }
+#ifndef K4A_FAST_PATH
     else
     {
         logger_log(K4A_LOG_LEVEL_TRACE, szFile, line, "%s() returned success.", szFunction);
     }
+#endif
     return result;
 }
 
@@ -204,8 +277,21 @@ FORCEINLINE void TraceInvalidHandle(int result,
     }
 
 // Logs a message
+#ifdef K4A_FAST_PATH
+// Trace messages compile out entirely. The call stays in dead code so its arguments are still type checked and count
+// as used.
+#define LOG_TRACE(message, ...)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (0)                                                                                                         \
+        {                                                                                                              \
+            logger_log(K4A_LOG_LEVEL_TRACE, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__);            \
+        }                                                                                                              \
+    } while (0)
+#else
 #define LOG_TRACE(message, ...)                                                                                        \
     logger_log(K4A_LOG_LEVEL_TRACE, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__)
+#endif
 #define LOG_INFO(message, ...)                                                                                         \
     logger_log(K4A_LOG_LEVEL_INFO, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__)
 #define LOG_WARNING(message, ...)                                                                                      \
@@ -214,8 +300,7 @@ FORCEINLINE void TraceInvalidHandle(int result,
     logger_log(K4A_LOG_LEVEL_ERROR, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__)
 #define LOG_CRITICAL(message, ...)                                                                                     \
     logger_log(K4A_LOG_LEVEL_CRITICAL, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__)
-#define LOG_HANDLE(message, ...)                                                                                       \
-    logger_log(K4A_LOG_LEVEL_TRACE, __FILE__, __LINE__, "%s(). " message, __func__, __VA_ARGS__)
+#define LOG_HANDLE(message, ...) LOG_TRACE(message, __VA_ARGS__)
 
 #ifdef __cplusplus
 }
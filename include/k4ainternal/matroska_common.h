@@ -90,10 +90,30 @@ constexpr uint64_t operator"" _s(unsigned long long x)
 #define CUE_ENTRY_GAP_NS 1_s
 #endif
 
+#ifndef LIVE_INDEX_FLUSH_GAP_NS
+// A live sidecar index is flushed to disk at most this often, see k4a_record_set_live_index()
+#define LIVE_INDEX_FLUSH_GAP_NS 1_s
+#endif
+
 #ifndef CLUSTER_READ_AHEAD_COUNT
 #define CLUSTER_READ_AHEAD_COUNT 2
 #endif
 
+#ifndef IMAGE_BUFFER_POOL_COUNT
+// The number of released image buffers a playback handle keeps for reuse, see acquire_image_buffer()
+#define IMAGE_BUFFER_POOL_COUNT 16
+#endif
+
+#ifndef CUSTOM_IO_BLOCK_SIZE
+// Recordings opened with k4a_playback_open_custom_io() are read in blocks of this size
+#define CUSTOM_IO_BLOCK_SIZE (1024 * 1024)
+#endif
+
+#ifndef CUSTOM_IO_BLOCK_COUNT
+// The number of blocks kept in memory by a recording opened with k4a_playback_open_custom_io()
+#define CUSTOM_IO_BLOCK_COUNT 64
+#endif
+
 static_assert(MAX_CLUSTER_LENGTH_NS < INT16_MAX * MATROSKA_TIMESCALE_NS, "Cluster length must fit in a 16 bit int");
 static_assert(CLUSTER_WRITE_DELAY_NS >= MAX_CLUSTER_LENGTH_NS * 2, "Cluster write delay is shorter than 2 clusters");
 
@@ -154,6 +174,31 @@ private:
     std::thread::id m_owner;
 };
 
+// FOURCC of depth and IR tracks compressed with RVL, see rvl_encode()
+#define K4A_RVL_FOURCC 0x314C5652 // RVL1
+
+/**
+ * Returns the size of the buffer needed by rvl_encode() for pixel_count pixels.
+ */
+size_t rvl_max_encoded_size(size_t pixel_count);
+
+/**
+ * Losslessly compresses 16-bit depth or IR pixels with RVL (Run length encoding and Variable Length encoding).
+ *
+ * Returns the size of the encoded data written to output, or 0 if output_size is too small.
+ */
+size_t rvl_encode(const uint16_t *input, size_t pixel_count, uint8_t *output, size_t output_size);
+
+/**
+ * Returns the number of pixels in an RVL encoded buffer, or 0 if the buffer is too small.
+ */
+size_t rvl_get_pixel_count(const uint8_t *input, size_t input_size);
+
+/**
+ * Decodes an RVL encoded buffer of pixel_count pixels, as returned by rvl_get_pixel_count().
+ */
+k4a_result_t rvl_decode(const uint8_t *input, size_t input_size, uint16_t *output, size_t pixel_count);
+
 // Struct matches https://docs.microsoft.com/en-us/windows/desktop/wmdm/-bitmapinfoheader
 struct BITMAPINFOHEADER
 {
@@ -191,6 +236,60 @@ static_assert(sizeof(matroska_imu_sample_t) ==
                       sizeof(k4a_imu_sample_t().gyro_timestamp_usec) + sizeof(k4a_imu_sample_t().gyro_sample.v),
               "Size of IMU data structure has changed from on-disk format.");
 
+#ifndef CLUSTER_INDEX_EXTENSION
+// Sidecar index files are stored next to the recording, with this extension added to the file name.
+#define CLUSTER_INDEX_EXTENSION ".k4aidx"
+#endif
+
+#pragma pack(push, 1)
+// Header of a sidecar index file, see write_cluster_index(). An index written while recording has a recording_size and
+// entry_count of 0, its entries continue to the end of the index file, see k4a_record_set_live_index().
+struct cluster_index_header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t recording_size;
+    uint64_t first_cluster_offset;
+    uint64_t entry_count;
+};
+
+// One cluster of a sidecar index file. The struct padding and size must be exact. Version 1 entries end after
+// cluster_size, and don't list the previews.
+struct cluster_index_entry_t
+{
+    uint64_t timestamp_ns;
+    uint64_t file_offset; // Relative to the start of the segment
+    uint64_t cluster_size;
+
+    // The data of the preview block in the cluster, see k4a_record_add_preview_track(). The size is 0 if the cluster
+    // has no preview.
+    uint64_t preview_timestamp_ns;
+    uint64_t preview_offset; // Relative to the start of the segment
+    uint64_t preview_size;
+};
+
+// Header of each block of the preview track, followed by the JPEG color image and the 8 bit depth image. A preview
+// without a color or depth image has a width and height of 0 for it.
+struct preview_block_header_t
+{
+    uint32_t color_width;
+    uint32_t color_height;
+    uint32_t color_jpeg_size;
+    uint32_t depth_width;
+    uint32_t depth_height;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(cluster_index_entry_t) == sizeof(uint64_t) * 6,
+              "cluster_index_entry_t size does not match expected padding.");
+static_assert(sizeof(preview_block_header_t) == sizeof(uint32_t) * 5,
+              "preview_block_header_t size does not match expected padding.");
+
+static const char CLUSTER_INDEX_MAGIC[8] = { 'K', '4', 'A', 'I', 'D', 'X', '\0', '\0' };
+static const uint32_t CLUSTER_INDEX_VERSION = 2;
+static const uint32_t CLUSTER_INDEX_V1_ENTRY_SIZE = sizeof(uint64_t) * 3;
+
 static const k4a_color_resolution_t color_resolutions[] = { K4A_COLOR_RESOLUTION_720P,  K4A_COLOR_RESOLUTION_1080P,
                                                             K4A_COLOR_RESOLUTION_1440P, K4A_COLOR_RESOLUTION_1536P,
                                                             K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_RESOLUTION_3072P };
@@ -9,10 +9,13 @@
 #define RECORD_READ_H
 
 #include <k4ainternal/matroska_common.h>
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <future>
+#include <deque>
 #include <map>
+#include <unordered_map>
 
 namespace k4arecord
 {
@@ -20,6 +23,76 @@ namespace k4arecord
 static const std::pair<k4a_depth_mode_t, std::string> legacy_depth_modes[] =
     { { K4A_DEPTH_MODE_NFOV_2X2BINNED, "NFOV_2x2BINNED" }, { K4A_DEPTH_MODE_WFOV_2X2BINNED, "WFOV_2x2BINNED" } };
 
+/**
+ * Read-only EBML IO handler that reads the recording through a memory mapping, see k4a_playback_set_mapped_io()
+ *
+ * Reads are copied straight from the mapped file with mmap on Linux and MapViewOfFile on Windows, instead of going
+ * through a seek and a read system call for every element.
+ */
+class MappedFileIOCallback : public libebml::IOCallback
+{
+public:
+    MappedFileIOCallback(const char *path);
+    ~MappedFileIOCallback() override;
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+
+private:
+    const uint8_t *m_data = nullptr;
+    uint64_t m_size = 0;
+    uint64_t m_position = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+/**
+ * Read-only EBML IO handler that reads the recording through an application callback, see
+ * k4a_playback_open_custom_io()
+ *
+ * The recording is read in blocks of CUSTOM_IO_BLOCK_SIZE bytes, and the most recently used CUSTOM_IO_BLOCK_COUNT
+ * blocks are kept in memory, fewer under a memory budget. Blocks are fetched outside of the playback io_lock by
+ * prefetch(), so the clusters that are preloaded in the background are requested in parallel instead of one read at a
+ * time.
+ */
+class CustomIOCallback : public libebml::IOCallback
+{
+public:
+    CustomIOCallback(uint64_t size, k4a_playback_read_cb_t *read_cb, void *read_cb_context);
+    ~CustomIOCallback() override;
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+
+    // Reads the blocks of [offset, offset + size) into memory. Can be called from any thread, at the same time as the
+    // other methods.
+    void prefetch(uint64_t offset, uint64_t size);
+
+private:
+    typedef std::shared_future<std::shared_ptr<std::vector<uint8_t>>> future_block_t;
+
+    // Returns the block, starting to read it if it is not in memory. The block is nullptr if the read failed.
+    future_block_t get_block(uint64_t index);
+
+    k4a_playback_read_cb_t *m_read_cb;
+    void *m_read_cb_context;
+    uint64_t m_size;
+    uint64_t m_position = 0;
+    size_t m_block_count; // The number of blocks kept in memory
+
+    std::mutex m_lock; // Locks access to m_blocks and m_closed
+    std::list<std::pair<uint64_t, future_block_t>> m_blocks; // The most recently used block first
+    bool m_closed = false;
+};
+
 typedef struct _cluster_info_t
 {
     // The cluster size will be 0 until the actual cluster has been read from disk.
@@ -48,11 +121,9 @@ typedef struct _loaded_cluster_t
     cluster_info_t *cluster_info = NULL;
     std::shared_ptr<libmatroska::KaxCluster> cluster;
 
-#if CLUSTER_READ_AHEAD_COUNT
-    // Pointers to previous and next clusters to keep them preloaded in memory.
-    future_cluster_t previous_clusters[CLUSTER_READ_AHEAD_COUNT];
-    future_cluster_t next_clusters[CLUSTER_READ_AHEAD_COUNT];
-#endif
+    // Pointers to previous and next clusters to keep them preloaded in memory, see cluster_read_ahead_count.
+    std::vector<future_cluster_t> previous_clusters;
+    std::vector<future_cluster_t> next_clusters;
 } loaded_cluster_t;
 
 typedef struct _block_info_t
@@ -77,7 +148,6 @@ typedef struct _track_reader_t
     std::string codec_id;
     std::vector<uint8_t> codec_private;
 
-    std::shared_ptr<block_info_t> current_block;
     uint64_t frame_period_ns = 0;
     uint64_t sync_delay_ns = 0;
 
@@ -88,18 +158,113 @@ typedef struct _track_reader_t
     uint32_t height = 0;
     uint32_t stride = 0;
     k4a_image_format_t format = K4A_IMAGE_FORMAT_CUSTOM;
+    bool rvl_encoded = false;   // Depth and IR frames are compressed with RVL
+    bool video_encoded = false; // Color frames are compressed by a video encoder, see k4a_playback_set_color_decoder()
+    bool enabled = true;      // Image tracks can be disabled with k4a_playback_set_enabled_tracks()
+
+    // Sync timestamps of every block in the track, filled in by build_frame_index()
+    std::vector<uint64_t> block_timestamps_ns;
 } track_reader_t;
 
+// The location of one IMU block in the recording, see build_imu_index()
+typedef struct _imu_index_entry_t
+{
+    uint64_t first_timestamp_ns = 0;     // The accelerometer device timestamp of the first sample in the block.
+    cluster_info_t *cluster_info = NULL; // The cluster containing the block.
+    int index = -1;                      // Index of the block element within the cluster.
+} imu_index_entry_t;
+
+// The location of one block of the preview track in the recording, see build_preview_index()
+typedef struct _preview_index_entry_t
+{
+    uint64_t timestamp_ns = 0; // The timestamp of the block as written in the file.
+    uint64_t file_offset = 0;  // The start of the block data, relative to the start of the segment.
+    uint64_t size = 0;         // The size of the block data.
+} preview_index_entry_t;
+
+// A color image that is being converted in the background, before the capture containing it is read.
+typedef struct _read_ahead_image_t
+{
+    std::shared_ptr<block_info_t> block;
+    std::shared_future<k4a_image_t> image; // NULL if the conversion failed.
+} read_ahead_image_t;
+
+// The buffers of images converted by a playback handle. Released buffers are kept by size for the next image of the
+// same size, instead of being freed and allocated again for every frame. Images can outlive their playback handle, so
+// each buffer keeps the pool alive until it is released, see acquire_image_buffer().
+typedef struct _image_buffer_pool_t
+{
+    std::mutex lock; // Locks access to free_buffers, free_count, free_size and closed
+    std::unordered_map<size_t, std::vector<struct _image_buffer_t *>> free_buffers;
+    size_t free_count = 0;
+    size_t free_size = 0;            // The bytes held by free_buffers
+    size_t max_free_size = SIZE_MAX; // A quarter of the memory budget, see k4a_set_memory_budget()
+    bool closed = false; // Set by k4a_playback_close(), buffers released afterwards are freed
+} image_buffer_pool_t;
+
+typedef struct _image_buffer_t
+{
+    std::shared_ptr<image_buffer_pool_t> pool;
+    std::vector<uint8_t> data;
+} image_buffer_t;
+
+// The read position of a playback handle, or of a cursor created with k4a_playback_cursor_create(). Cursors share the
+// parsed recording and cluster cache of their playback handle, and only keep their own position in it.
+typedef struct _playback_cursor_t
+{
+    uint64_t seek_timestamp_ns = 0;
+    std::shared_ptr<loaded_cluster_t> seek_cluster;
+
+    // The last block read from each track, tracks without an entry are read from seek_timestamp_ns.
+    std::unordered_map<track_reader_t *, std::shared_ptr<block_info_t>> current_blocks;
+
+    // Color images of the next captures are converted in the background, see k4a_playback_set_color_read_ahead()
+    std::deque<read_ahead_image_t> color_read_ahead;
+    bool color_read_ahead_next = true; // False if color_read_ahead holds the captures before the current one
+
+    // The index in preview_index of the last preview read, -1 before the first preview and the preview count after the
+    // last. Previews are read from seek_timestamp_ns if the position is not valid, see get_preview().
+    bool preview_valid = false;
+    int64_t preview_position = -1;
+} playback_cursor_t;
+
 typedef struct _k4a_playback_context_t
 {
     const char *file_path;
     std::unique_ptr<IOCallback> ebml_file;
+
+    // If the recording was opened with k4a_playback_open_custom_io(), ebml_file is this CustomIOCallback for the whole
+    // life of the playback, and file_path points to custom_io_name.
+    CustomIOCallback *custom_io = nullptr;
+    std::string custom_io_name;
     std::mutex io_lock; // Locks access to ebml_file
     bool file_closing;
 
+    // If true, ebml_file is a MappedFileIOCallback and images that need no conversion reference the cluster data
+    // instead of a copy, see k4a_playback_set_mapped_io()
+    bool mapped_io;
+
     uint64_t timecode_scale;
     k4a_record_configuration_t record_config;
     k4a_image_format_t color_format_conversion;
+    k4a_color_scale_t color_scale;
+
+    // Buffers of converted images are reused between images, see acquire_image_buffer()
+    std::shared_ptr<image_buffer_pool_t> image_buffer_pool;
+
+    // TurboJPEG decompressors are reused between images, see acquire_turbojpeg_handle()
+    std::vector<void *> turbojpeg_handles;
+    std::mutex turbojpeg_lock; // Locks access to turbojpeg_handles
+
+    // Decodes color tracks written with k4a_record_set_color_encoder(), see k4a_playback_set_color_decoder()
+    k4a_playback_color_decode_cb_t *color_decode_cb;
+    void *color_decode_cb_context;
+    std::mutex color_decode_lock; // Locks access to the decoder and the state below
+    bool color_decoded_valid;     // The decoder holds the frame at color_decoded_timestamp_ns
+    uint64_t color_decoded_timestamp_ns;
+
+    // The number of color images converted ahead of the playback handle, see k4a_playback_set_color_read_ahead()
+    uint32_t color_read_ahead_count;
 
     std::unique_ptr<libebml::EbmlStream> stream;
     std::unique_ptr<libmatroska::KaxSegment> segment;
@@ -114,19 +279,51 @@ typedef struct _k4a_playback_context_t
     std::unique_ptr<k4a_calibration_t> device_calibration;
 
     uint64_t sync_period_ns;
-    uint64_t seek_timestamp_ns;
-    std::shared_ptr<loaded_cluster_t> seek_cluster;
+    playback_cursor_t cursor; // The read position of the playback handle itself
+    std::atomic<uint32_t> cursor_count; // The number of cursors created with k4a_playback_cursor_create()
 
     cluster_cache_t cluster_cache;
     std::recursive_mutex cache_lock; // Locks modification of cluster_cache
+    std::mutex cluster_ref_lock;     // Locks access to cluster_info_t::cluster, never held while taking another lock
+
+    // If a sidecar index was loaded with load_cluster_index(), cluster_index holds every cluster of the recording in
+    // timestamp order. The entries read from the file are only kept until the cluster cache is populated. A live index
+    // only lists the clusters at the start of the recording, it fills the cluster cache but not cluster_index.
+    std::vector<cluster_index_entry_t> index_entries;
+    bool index_complete;
+    bool index_has_previews; // The index locates the previews of its clusters, it isn't a version 1 index
+    std::vector<cluster_info_t *> cluster_index;
+
+    // The number of clusters preloaded on each side of the current cluster, see k4a_playback_set_cluster_read_ahead()
+    size_t cluster_read_ahead_count;
+
+    // The most recently used clusters stay loaded up to a total size of cluster_lru_budget bytes, see
+    // k4a_playback_set_cache_size(). The front of cluster_lru is the most recently used cluster.
+    typedef std::list<std::pair<cluster_info_t *, std::shared_ptr<libmatroska::KaxCluster>>> cluster_lru_t;
+    cluster_lru_t cluster_lru;
+    std::unordered_map<cluster_info_t *, cluster_lru_t::iterator> cluster_lru_index;
+    uint64_t cluster_lru_budget;
+    uint64_t cluster_lru_size;
+    std::mutex lru_lock; // Locks access to the cluster_lru fields
 
     track_reader_t *color_track = nullptr;
     track_reader_t *depth_track = nullptr;
     track_reader_t *ir_track = nullptr;
     track_reader_t *imu_track = nullptr;
+    track_reader_t *preview_track = nullptr; // Only device 0 has a preview track, see k4a_record_add_preview_track()
+
+    // The device of a multi-device recording whose tracks are the built-in tracks above, see k4a_playback_open_device()
+    uint32_t device_index;
 
     std::map<std::string, track_reader_t> track_map;
 
+    // If lazy_load is set, the attachments are read by load_attachments() and the cues and clusters by load_clusters()
+    // when they are first needed, instead of by parse_mkv(), see k4a_playback_open_lazy()
+    bool lazy_load;
+    std::atomic<bool> attachments_loaded;
+    std::atomic<bool> clusters_loaded;
+    std::mutex lazy_load_lock; // Locks the loading of the attachments and clusters
+
     uint64_t segment_info_offset;
     uint64_t first_cluster_offset;
     uint64_t tracks_offset;
@@ -136,8 +333,25 @@ typedef struct _k4a_playback_context_t
 
     uint64_t last_file_timestamp_ns; // Relative to start of file.
 
-    // Stats
-    uint64_t seek_count, load_count, cache_hits;
+    // The start sync timestamp of every capture in the recording, built on first use by build_frame_index()
+    std::vector<uint64_t> frame_index;
+    bool frame_index_built;
+    std::mutex frame_index_lock; // Locks access to frame_index and the block_timestamps_ns of each track
+
+    // Every block of the IMU track in timestamp order, built on first use by build_imu_index()
+    std::vector<imu_index_entry_t> imu_index;
+    bool imu_index_built;
+    std::mutex imu_index_lock; // Locks access to imu_index
+
+    // Every block of the preview track in timestamp order, built on first use by build_preview_index(). The previews of
+    // the clusters of a sidecar index are filled in by populate_cluster_cache(), up to preview_index_resume_ns.
+    std::vector<preview_index_entry_t> preview_index;
+    uint64_t preview_index_resume_ns; // The timestamp of the last cluster of the sidecar index
+    bool preview_index_built;
+    std::mutex preview_index_lock; // Locks access to preview_index
+
+    // Stats, updated by every cursor
+    std::atomic<uint64_t> seek_count, load_count, cache_hits;
 } k4a_playback_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_playback_t, k4a_playback_context_t);
@@ -146,20 +360,44 @@ typedef struct _k4a_playback_data_block_context_t
 {
     uint64_t device_timestamp_usec;
     std::vector<uint8_t> data_block;
+
+    // With mapped IO, the block data is referenced in its cluster instead of copied into data_block
+    std::shared_ptr<KaxCluster> cluster;
+    uint8_t *cluster_buffer;
+    size_t cluster_buffer_size;
 } k4a_playback_data_block_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_playback_data_block_t, k4a_playback_data_block_context_t);
 
+typedef struct _k4a_playback_cursor_context_t
+{
+    k4a_playback_context_t *playback_context;
+    playback_cursor_t cursor;
+} k4a_playback_cursor_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_playback_cursor_t, k4a_playback_cursor_context_t);
+
 std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlElement *parent);
 k4a_result_t skip_element(k4a_playback_context_t *context, EbmlElement *element);
 
 void match_ebml_id(k4a_playback_context_t *context, EbmlId &id, uint64_t offset);
 bool seek_info_ready(k4a_playback_context_t *context);
 k4a_result_t parse_mkv(k4a_playback_context_t *context);
+k4a_result_t load_attachments(k4a_playback_context_t *context);
+k4a_result_t load_clusters(k4a_playback_context_t *context);
 k4a_result_t populate_cluster_cache(k4a_playback_context_t *context);
+k4a_result_t load_cluster_index(k4a_playback_context_t *context);
+k4a_result_t write_cluster_index(k4a_playback_context_t *context);
+k4a_result_t read_cluster_size(k4a_playback_context_t *context, cluster_info_t *cluster_info);
+k4a_result_t write_cluster_range(k4a_playback_context_t *context,
+                                 const char *path,
+                                 uint64_t start_timestamp_ns,
+                                 uint64_t end_timestamp_ns);
+std::string device_name(k4a_playback_context_t *context, const char *name);
+uint32_t get_device_count(k4a_playback_context_t *context);
 k4a_result_t parse_recording_config(k4a_playback_context_t *context);
 k4a_result_t read_bitmap_info_header(track_reader_t *track);
-void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestamp_ns);
+void reset_seek_pointers(k4a_playback_context_t *context, playback_cursor_t *cursor, uint64_t seek_timestamp_ns);
 
 k4a_result_t parse_tracks(k4a_playback_context_t *context);
 track_reader_t *find_track(k4a_playback_context_t *context, const char *name, const char *tag_name);
@@ -176,6 +414,7 @@ void populate_cluster_info(k4a_playback_context_t *context,
                            cluster_info_t *cluster_info);
 cluster_info_t *find_cluster(k4a_playback_context_t *context, uint64_t timestamp_ns);
 cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *current, bool next);
+void set_cluster_lru_budget(k4a_playback_context_t *context, uint64_t budget_bytes);
 std::shared_ptr<libmatroska::KaxCluster> load_cluster_internal(k4a_playback_context_t *context,
                                                                cluster_info_t *cluster_info);
 std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info);
@@ -193,13 +432,78 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                     block_info_t *in_block,
                                     k4a_image_t *image_out,
                                     k4a_image_format_t target_format);
-k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k4a_capture_t *capture_handle);
-k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *capture_handle, bool next);
-k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_sample_t *imu_sample, bool next);
+void destroy_turbojpeg_handles(k4a_playback_context_t *context);
+image_buffer_t *acquire_image_buffer(k4a_playback_context_t *context, size_t size);
+void release_image_buffer(image_buffer_t *buffer);
+void close_image_buffer_pool(k4a_playback_context_t *context);
+k4a_result_t decode_color_to_bgra(k4a_playback_context_t *context,
+                                  k4a_image_format_t format,
+                                  const uint8_t *data,
+                                  size_t data_size,
+                                  int stride,
+                                  int width,
+                                  int height,
+                                  uint8_t *bgra,
+                                  int bgra_width,
+                                  int bgra_height,
+                                  int bgra_stride);
+void start_color_read_ahead(k4a_playback_context_t *context,
+                            playback_cursor_t *cursor,
+                            std::shared_ptr<block_info_t> &color_block,
+                            bool next);
+void clear_color_read_ahead(k4a_playback_context_t *context, playback_cursor_t *cursor);
+k4a_result_t new_capture(k4a_playback_context_t *context,
+                         playback_cursor_t *cursor,
+                         block_info_t *block,
+                         k4a_capture_t *capture_handle);
+k4a_result_t seek_timestamp(k4a_playback_context_t *context,
+                            playback_cursor_t *cursor,
+                            int64_t offset_usec,
+                            k4a_playback_seek_origin_t origin);
+k4a_result_t build_frame_index(k4a_playback_context_t *context);
+k4a_result_t seek_frame(k4a_playback_context_t *context, playback_cursor_t *cursor, uint64_t frame_index);
+k4a_stream_result_t get_capture(k4a_playback_context_t *context,
+                                playback_cursor_t *cursor,
+                                k4a_capture_t *capture_handle,
+                                bool next,
+                                uint64_t *capture_timestamp_ns = NULL);
+k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context,
+                                   playback_cursor_t *cursor,
+                                   k4a_imu_sample_t *imu_sample,
+                                   bool next);
+k4a_result_t build_imu_index(k4a_playback_context_t *context);
+k4a_buffer_result_t get_imu_samples(k4a_playback_context_t *context,
+                                    uint64_t start_device_timestamp_ns,
+                                    uint64_t end_device_timestamp_ns,
+                                    k4a_imu_sample_t *imu_samples,
+                                    size_t max_sample_count,
+                                    size_t *sample_count);
+k4a_result_t build_preview_index(k4a_playback_context_t *context);
+k4a_stream_result_t get_preview(k4a_playback_context_t *context,
+                                playback_cursor_t *cursor,
+                                k4a_capture_t *preview_handle,
+                                bool next);
 k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
+                                   playback_cursor_t *cursor,
                                    track_reader_t *track_reader,
                                    k4a_playback_data_block_t *data_block_handle,
                                    bool next);
+k4a_buffer_result_t get_data_blocks(k4a_playback_context_t *context,
+                                    track_reader_t *track_reader,
+                                    uint64_t start_ns,
+                                    uint64_t end_ns,
+                                    k4a_playback_data_block_info_t *blocks,
+                                    size_t max_block_count,
+                                    uint8_t *buffer,
+                                    size_t buffer_size,
+                                    size_t *block_count);
+k4a_result_t process_range(k4a_playback_context_t *context,
+                           uint64_t start_ns,
+                           uint64_t end_ns,
+                           uint32_t worker_count,
+                           bool in_order,
+                           k4a_playback_capture_cb_t *callback,
+                           void *callback_context);
 
 // Template helper functions
 template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElement *element)
@@ -10,13 +10,100 @@
 
 #include <k4ainternal/matroska_common.h>
 #include <set>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <unordered_map>
 
+#ifndef UNBUFFERED_IO_BUFFER_SIZE
+// Size of each write-behind buffer of UnbufferedFileIOCallback
+#define UNBUFFERED_IO_BUFFER_SIZE (4 * 1024 * 1024)
+#endif
+
+#ifndef UNBUFFERED_IO_QUEUE_DEPTH
+// Number of write-behind buffers, all but one of them can be written to disk at the same time
+#define UNBUFFERED_IO_QUEUE_DEPTH 4
+#endif
+
+#ifndef UNBUFFERED_IO_ALIGNMENT
+// File offsets, sizes and memory used for unbuffered IO are aligned to this, a multiple of the disk sector size
+#define UNBUFFERED_IO_ALIGNMENT 4096
+#endif
+
+#ifndef UNBUFFERED_IO_PREALLOCATE_SIZE
+// The file is preallocated in extents of this size as it grows
+#define UNBUFFERED_IO_PREALLOCATE_SIZE (64 * 1024 * 1024)
+#endif
+
+#ifndef COLOR_JPEG_QUALITY
+// The TurboJPEG quality of color frames compressed with K4A_RECORD_COLOR_CODEC_MJPG
+#define COLOR_JPEG_QUALITY 90
+#endif
+
+static_assert(UNBUFFERED_IO_BUFFER_SIZE % UNBUFFERED_IO_ALIGNMENT == 0, "Buffer size must be a multiple of alignment");
+static_assert(UNBUFFERED_IO_QUEUE_DEPTH >= 2, "Unbuffered IO needs a buffer to fill while another one is written");
+
 namespace k4arecord
 {
 
+/**
+ * EBML IO handler for recording that bypasses the OS file cache, see k4a_record_set_unbuffered_io()
+ *
+ * Writes are gathered in large aligned buffers and written with O_DIRECT on Linux or FILE_FLAG_NO_BUFFERING on
+ * Windows. If the file system doesn't support unbuffered IO, the file is opened with regular buffering instead.
+ *
+ * Full buffers are written asynchronously, with overlapped IO on Windows and a pool of IO threads on Linux, so several
+ * writes are in flight while the next buffer is filled. All writes complete before the file is read or closed.
+ */
+class UnbufferedFileIOCallback : public libebml::IOCallback
+{
+public:
+    UnbufferedFileIOCallback(const char *path);
+    ~UnbufferedFileIOCallback() override;
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+    void setOwnerThread();
+
+private:
+    struct io_queue_t;
+
+    void flush();
+    void load_window(uint64_t position);
+    void submit_write(size_t index, size_t begin, size_t end);
+    void wait_write(size_t index);
+    void wait_all_writes();
+    void close_file();
+
+#ifdef _WIN32
+    void *m_file;
+#else
+    int m_file;
+#endif
+    bool m_preallocate = true;
+
+    // Write-behind buffers and the state of the writes in flight
+    std::unique_ptr<io_queue_t> m_queue;
+    size_t m_current = 0;
+
+    // The current buffer holds the file contents starting at m_window_start. The first m_window_valid bytes are the
+    // file contents, and the dirty range still needs to be written to disk.
+    uint8_t *m_buffer = nullptr;
+    bool m_window_loaded = false;
+    uint64_t m_window_start = 0;
+    size_t m_window_valid = 0;
+    size_t m_dirty_begin = 0;
+    size_t m_dirty_end = 0;
+
+    uint64_t m_position = 0;
+    uint64_t m_file_size = 0;
+    uint64_t m_preallocated_size = 0;
+    std::thread::id m_owner;
+};
+
 typedef struct _track_header_t
 {
     libmatroska::KaxTrackEntry *track;
@@ -30,12 +117,35 @@ typedef struct _track_header_t
      * See k4a_record_subtitle_settings_t::high_freq_data in types.h for more information on timestamp behavior.
      */
     bool high_freq_data = false;
+
+    // Depth and IR frames are compressed with RVL in write_cluster(), see k4a_record_set_depth_codec()
+    bool rvl_encoded = false;
+
+    // NV12 and YUY2 color frames are compressed to JPEG in prepare_clusters(), see k4a_record_set_color_codec()
+    bool jpeg_encoded = false;
+
+    // Color frames are compressed by the application's encoder in prepare_clusters(), see
+    // k4a_record_set_color_encoder().
+    k4a_record_color_encode_cb_t *encode_cb = nullptr;
+    void *encode_cb_context = nullptr;
+
+    // The layout of the raw color frames that are compressed, see set_color_track_layout()
+    k4a_image_format_t encode_format = K4A_IMAGE_FORMAT_CUSTOM;
+    int encode_width = 0;
+    int encode_height = 0;
+    int encode_stride = 0;
+
+    // Previews of the color and depth images are made in prepare_clusters(), see k4a_record_add_preview_track()
+    bool preview = false;
+    k4a_record_preview_settings_t preview_settings = {};
 } track_header_t;
 
 typedef struct _track_data_t
 {
     track_header_t *track;
     libmatroska::DataBuffer *buffer;
+    bool encoded;     // The buffer holds the RVL or color encoder frame, see prepare_clusters()
+    bool delta_frame; // The encoded frame depends on the frames before it, and isn't written as a key frame
 } track_data_t;
 
 typedef struct _cluster_t
@@ -43,16 +153,28 @@ typedef struct _cluster_t
     // Clusters contain timestamps in the range: time_start_ns <= timestamp_ns < time_end_ns
     uint64_t time_start_ns;
     uint64_t time_end_ns;
+    size_t data_size; // Sum of the buffer sizes in data
     std::vector<std::pair<uint64_t, track_data_t>> data;
 } cluster_t;
 
+// The tracks of a device added with k4a_record_add_device(), see k4a_record_context_t::added_devices
+typedef struct _device_tracks_t
+{
+    k4a_device_configuration_t device_config;
+    track_header_t *color_track = nullptr;
+    track_header_t *depth_track = nullptr;
+    track_header_t *ir_track = nullptr;
+    track_header_t *imu_track = nullptr;
+    track_header_t *preview_track = nullptr; // Only set for device 0
+} device_tracks_t;
+
 typedef struct _k4a_record_context_t
 {
-    const char *file_path;
+    std::string file_path;       // The file being written, see segment_index
+    std::string first_file_path; // The path given to k4a_record_create()
     std::unique_ptr<IOCallback> ebml_file;
 
     uint64_t timecode_scale;
-    uint32_t camera_fps;
 
     k4a_device_configuration_t device_config;
 
@@ -62,6 +184,7 @@ typedef struct _k4a_record_context_t
      */
     uint64_t start_timestamp_offset;
     bool start_offset_tag_added;
+    libmatroska::KaxTag *start_offset_tag;
 
     /**
      * The end timestamp of the last cluster written to disk.
@@ -87,11 +210,41 @@ typedef struct _k4a_record_context_t
     track_header_t *depth_track = nullptr;
     track_header_t *ir_track = nullptr;
     track_header_t *imu_track = nullptr;
+    track_header_t *preview_track = nullptr;
     std::unordered_map<std::string, track_header_t> tracks;
 
+    // The capture timestamp from which the next preview is written, see k4a_record_add_preview_track()
+    uint64_t next_preview_ns;
+
+    /**
+     * The devices recorded in the same file as the device of k4a_record_create(), which is device 0 and uses the
+     * tracks above. Device index i is added_devices[i - 1]. The codecs are applied to the tracks of the devices added
+     * after they are set.
+     */
+    std::vector<device_tracks_t> added_devices;
+    k4a_record_depth_codec_t depth_codec;
+    k4a_record_color_codec_t color_codec;
+
     std::list<cluster_t *> pending_clusters;
     std::mutex pending_cluster_lock; // Locks last_written_timestamp, most_recent_timestamp, and pending_clusters
 
+    /**
+     * Size of the data in pending_clusters, including the clusters being written by the writer thread, which make up
+     * writing_data_size. These sizes are locked by pending_cluster_lock.
+     */
+    size_t pending_data_size;
+    size_t writing_data_size;
+    size_t blocked_data_size; // Data that k4a_record_write_capture() is waiting to queue, see wait_for_write_queue()
+
+    // Limit on pending_data_size and what to do when it is reached, see k4a_record_set_write_queue_limit()
+    size_t write_queue_limit;
+    k4a_record_write_queue_policy_t write_queue_policy;
+    std::atomic<uint64_t> dropped_image_count;
+
+    // Signaled with pending_cluster_lock when the writer thread has written clusters or stopped
+    std::unique_ptr<std::condition_variable> write_queue_notify;
+    bool writer_failed; // Locked by pending_cluster_lock
+
     bool writer_stopping;
     std::thread writer_thread;
     // std::condition_variable constructor may throw, so wrap this in a pointer.
@@ -99,6 +252,30 @@ typedef struct _k4a_record_context_t
     std::mutex writer_lock;
 
     bool header_written, first_cluster_written;
+
+    // Color images are referenced by the pending clusters instead of being copied, see k4a_record_set_zero_copy()
+    bool zero_copy;
+
+    /**
+     * Segmented recordings switch to a new file when the current one reaches one of these limits, see
+     * k4a_record_set_segment_limits(). Every file starts with the same header_data, and the next file is created with
+     * its header before it is needed. The segment and file state below is locked by writer_lock.
+     */
+    uint64_t segment_max_duration_ns;
+    uint64_t segment_max_size;
+    uint32_t segment_index;
+    std::vector<uint8_t> header_data;
+    std::unique_ptr<IOCallback> next_file;
+    std::string next_file_path;
+
+    /**
+     * A sidecar index of the current file is written while recording, see k4a_record_set_live_index(). The index is
+     * written along with the clusters and is locked by writer_lock.
+     */
+    bool live_index;
+    std::ofstream live_index_file;
+    uint64_t live_index_entry_count;
+    uint64_t live_index_flush_ns; // Timestamp of the last entry flushed to disk
 } k4a_record_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_record_t, k4a_record_context_t);
@@ -113,8 +290,25 @@ enum TagTargetType
 extern std::set<uint64_t> unique_ids;
 uint64_t new_unique_id();
 
-k4a_result_t
-populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t height, k4a_image_format_t format);
+k4a_result_t populate_bitmap_info_header(BITMAPINFOHEADER *header,
+                                         uint64_t width,
+                                         uint64_t height,
+                                         k4a_image_format_t format,
+                                         k4a_record_depth_codec_t depth_codec = K4A_RECORD_DEPTH_CODEC_RAW);
+
+k4a_result_t set_depth_track_codec(track_header_t *track, k4a_record_depth_codec_t depth_codec);
+
+k4a_result_t set_color_track_codec(track_header_t *track,
+                                   k4a_image_format_t format,
+                                   k4a_record_color_codec_t color_codec);
+
+k4a_result_t set_color_track_encoder(track_header_t *track,
+                                     k4a_image_format_t format,
+                                     const char *codec_id,
+                                     const uint8_t *codec_private,
+                                     size_t codec_private_size,
+                                     k4a_record_color_encode_cb_t *encode_cb,
+                                     void *encode_cb_context);
 
 bool validate_name_characters(const char *name);
 
@@ -132,10 +326,36 @@ k4a_result_t write_track_data(k4a_record_context_t *context,
                               uint64_t timestamp_ns,
                               libmatroska::DataBuffer *buffer);
 
+k4a_result_t write_track_data_batch(k4a_record_context_t *context,
+                                    track_header_t *track,
+                                    size_t count,
+                                    const uint64_t *timestamps_ns,
+                                    libmatroska::DataBuffer **buffers);
+
+k4a_result_t write_preview_data(k4a_record_context_t *context,
+                                track_header_t *track,
+                                uint64_t timestamp_ns,
+                                k4a_image_t color_image,
+                                k4a_image_t depth_image);
+
 cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t timestamp_ns);
 
+k4a_result_t prepare_clusters(const std::vector<cluster_t *> &clusters);
+
 k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, uint64_t *time_end_ns = NULL);
 
+bool wait_for_write_queue(k4a_record_context_t *context, size_t size);
+
+void set_file_owner_thread(libebml::IOCallback *file);
+
+k4a_result_t write_file_metadata(k4a_record_context_t *context, uint64_t end_timestamp_ns);
+
+k4a_result_t prepare_next_segment_file(k4a_record_context_t *context);
+
+void discard_next_segment_file(k4a_record_context_t *context);
+
+void close_live_index(k4a_record_context_t *context, bool file_complete);
+
 k4a_result_t start_matroska_writer_thread(k4a_record_context_t *context);
 
 void stop_matroska_writer_thread(k4a_record_context_t *context);
@@ -0,0 +1,168 @@
+/** \file metrics.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Metrics of the SDK, in the form of k4a_metric_t
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/dewrapper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Metrics being collected
+ */
+typedef struct
+{
+    k4a_metric_t *metrics; // Array to fill in, NULL to only count the metrics
+    size_t capacity;       // Number of elements of metrics
+    size_t count;          // Number of metrics added, metrics past capacity are counted but not written
+} metrics_list_t;
+
+/** Adds a counter
+ *
+ * \param list
+ * The list to add to
+ *
+ * \param name
+ * Static string naming the metric, see \ref k4a_metric_t
+ *
+ * \param help
+ * Static string describing the metric
+ *
+ * \param label_name
+ * Static string naming the label of the metric, NULL for none
+ *
+ * \param label_value
+ * Static string with the value of the label, NULL for none
+ *
+ * \param value
+ * Value of the counter
+ */
+void metrics_add_counter(metrics_list_t *list,
+                         const char *name,
+                         const char *help,
+                         const char *label_name,
+                         const char *label_value,
+                         double value);
+
+/** Adds a gauge, see \ref metrics_add_counter for the parameters
+ */
+void metrics_add_gauge(metrics_list_t *list,
+                       const char *name,
+                       const char *help,
+                       const char *label_name,
+                       const char *label_value,
+                       double value);
+
+/** Adds a histogram whose bucket bounds double from one bucket to the next
+ *
+ * \param list
+ * The list to add to
+ *
+ * \param name
+ * Static string naming the metric
+ *
+ * \param help
+ * Static string describing the metric
+ *
+ * \param label_name
+ * Static string naming the label of the metric, NULL for none
+ *
+ * \param label_value
+ * Static string with the value of the label, NULL for none
+ *
+ * \param bucket_counts
+ * Observations in each bucket, not cumulative
+ *
+ * \param bucket_count
+ * Number of buckets, up to K4A_METRIC_HISTOGRAM_BUCKETS
+ *
+ * \param first_upper_bound
+ * Upper bound of the first bucket. The last bucket has no upper bound.
+ *
+ * \param sum
+ * Sum of all observations
+ */
+void metrics_add_exponential_histogram(metrics_list_t *list,
+                                       const char *name,
+                                       const char *help,
+                                       const char *label_name,
+                                       const char *label_value,
+                                       const uint64_t *bucket_counts,
+                                       uint32_t bucket_count,
+                                       double first_upper_bound,
+                                       double sum);
+
+/** Adds the metrics of a USB streaming endpoint, labeled with the name of the stream
+ */
+void metrics_add_usb_stream_stats(metrics_list_t *list, const char *stream, const k4a_usb_stream_stats_t *stats);
+
+/** Adds the metrics of capture synchronization
+ */
+void metrics_add_capture_stats(metrics_list_t *list, const k4a_capture_stats_t *stats);
+
+/** Adds the metrics of the depth engine
+ */
+void metrics_add_depth_engine_stats(metrics_list_t *list, const dewrapper_stats_t *stats);
+
+/** Adds the metrics of the SDK allocator, which are process wide
+ */
+void metrics_add_allocator_stats(metrics_list_t *list, const k4a_allocator_stats_t *stats);
+
+/** Adds the latency metrics of the depth capture pipeline, which are process wide
+ */
+void metrics_add_latency_stats(metrics_list_t *list);
+
+/** Handle to a thread that runs a callback periodically
+ */
+K4A_DECLARE_HANDLE(metrics_sink_t);
+
+/** Callback run periodically by a metrics sink
+ *
+ * \param context
+ * The context passed to \ref metrics_sink_create
+ */
+typedef void(metrics_sink_cb_t)(void *context);
+
+/** Starts a thread that runs a callback periodically
+ *
+ * \param period_ms
+ * Time between the start of two runs of the callback, must not be 0
+ *
+ * \param callback
+ * The callback to run
+ *
+ * \param context
+ * Context passed to callback
+ *
+ * \param sink_handle
+ * Location to write the handle of the sink
+ *
+ * \remarks
+ * The first run is one period after the sink is created.
+ */
+k4a_result_t metrics_sink_create(uint32_t period_ms,
+                                 metrics_sink_cb_t *callback,
+                                 void *context,
+                                 metrics_sink_t *sink_handle);
+
+/** Stops the thread of a sink and destroys it
+ *
+ * \remarks
+ * Waits for a running callback to return, so it must not be called from the callback.
+ */
+void metrics_sink_destroy(metrics_sink_t sink_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
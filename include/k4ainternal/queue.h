@@ -39,6 +39,18 @@ extern "C" {
  */
 K4A_DECLARE_HANDLE(queue_t);
 
+/** Handle to a waiter that a thread blocks on until any of the queues it is attached to is ready.
+ *
+ * Waiters are created with \ref queue_waiter_create, attached to queues with \ref queue_add_waiter and destroyed
+ * with \ref queue_waiter_destroy.
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(queue_waiter_t);
+
+/** Maximum number of waiters attached to one queue at a time.
+ */
+#define QUEUE_MAX_WAITERS (8)
+
 /** Open a handle to the queue device.
  *
  * \param queue_depth [IN]
@@ -59,6 +71,46 @@ K4A_DECLARE_HANDLE(queue_t);
  */
 k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle);
 
+/** Open a handle to a lock-free single producer / single consumer queue.
+ *
+ * \param queue_depth [IN]
+ *  The max number of elements the queue can hold. This value is capped at 10,000.
+ *
+ * \param queue_name [IN]
+ *  The name of the queue, used by the logger to generate error messages.
+ *
+ * \param queue_handle [OUT]
+ *  A pointer to write the opened queue handle to
+ *
+ * \return K4A_RESULT_SUCCEEDED if the device was opened, otherwise K4A_RESULT_FAILED
+ *
+ * The queue behaves like one created with \ref queue_create, but \ref queue_push and \ref queue_pop do not take a
+ * lock unless \ref queue_pop has to wait for an empty queue. Only one thread may push into the queue and only one
+ * thread may pop from it. \ref queue_enable, \ref queue_disable and \ref queue_stop may be called from any thread.
+ */
+k4a_result_t queue_create_spsc(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle);
+
+/** Changes the depth of a queue and what \ref queue_push does when it is full.
+ *
+ * \param queue_handle [IN]
+ *  A queue handle from \ref queue_create
+ *
+ * \param queue_depth [IN]
+ *  The max number of elements the queue can hold. This value is capped at 10,000.
+ *
+ * \param policy [IN]
+ *  ::K4A_QUEUE_POLICY_DROP_OLDEST drops the oldest element to make room, the default.
+ *  ::K4A_QUEUE_POLICY_DROP_NEWEST drops the element being pushed.
+ *  ::K4A_QUEUE_POLICY_BLOCK waits in \ref queue_push until \ref queue_pop makes room or the queue is disabled.
+ *
+ * \return K4A_RESULT_SUCCEEDED if the queue was configured. K4A_RESULT_FAILED if the queue is enabled or was created
+ * with \ref queue_create_spsc.
+ *
+ * The queue must be disabled, see \ref queue_disable, unless it already has this depth and policy, in which case the
+ * call does nothing. The dropped element is returned by \ref queue_push_w_dropped for both drop policies.
+ */
+k4a_result_t queue_configure(queue_t queue_handle, uint32_t queue_depth, k4a_queue_policy_t policy);
+
 /** Destroys the handle to the queue device.
  *
  * \param queue_handle [in]
@@ -116,6 +168,15 @@ void queue_push_w_dropped(queue_t queue_handle, k4a_capture_t capture_handle, k4
  */
 k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_capture_t *capture_handle);
 
+/** Gets the number of \ref k4a_capture_t objects currently held by the queue.
+ *
+ * \param queue_handle [in]
+ *  A queue handle
+ *
+ * The count is a snapshot, it may already be stale when this returns if other threads push or pop.
+ */
+uint32_t queue_get_count(queue_t queue_handle);
+
 /** Enables the queue for accepting data
  *
  * \param queue_handle [in]
@@ -141,6 +202,88 @@ void queue_disable(queue_t queue_handle);
  */
 void queue_stop(queue_t queue_handle);
 
+/** Creates a waiter.
+ *
+ * \param waiter_handle [OUT]
+ *  A pointer to write the waiter handle to
+ *
+ * \return K4A_RESULT_SUCCEEDED if the waiter was created, otherwise K4A_RESULT_FAILED
+ *
+ * A waiter is notified by each queue it is attached to. It lets one thread wait on several queues, and on other
+ * sources that call \ref queue_waiter_notify, without polling them. Detach the waiter from every queue before
+ * destroying it with \ref queue_waiter_destroy.
+ */
+k4a_result_t queue_waiter_create(queue_waiter_t *waiter_handle);
+
+/** Destroys a waiter.
+ *
+ * \param waiter_handle [IN]
+ *  A waiter handle from \ref queue_waiter_create
+ */
+void queue_waiter_destroy(queue_waiter_t waiter_handle);
+
+/** Wakes the thread waiting in \ref queue_waiter_wait, or the next call to it if no thread is waiting.
+ *
+ * \param waiter_handle [IN]
+ *  A waiter handle from \ref queue_waiter_create
+ *
+ * May be called from any thread, including while holding the lock of a queue or of another source.
+ */
+void queue_waiter_notify(queue_waiter_t waiter_handle);
+
+/** Waits until the waiter is notified.
+ *
+ * \param waiter_handle [IN]
+ *  A waiter handle from \ref queue_waiter_create
+ *
+ * \param wait_in_ms [IN]
+ *  Time to wait for a notification. 0 means do not wait at all, K4A_WAIT_INFINITE waits indefinitely.
+ *
+ * \return K4A_WAIT_RESULT_SUCCEEDED if the waiter was notified since the last call returned,
+ * K4A_WAIT_RESULT_TIMEOUT if it wasn't notified in time, K4A_WAIT_RESULT_FAILED if the wait failed.
+ *
+ * A notification only says that an attached source may have become ready, the caller checks each source again with
+ * \ref queue_is_ready or its equivalent. Only one thread may wait on a waiter at a time.
+ */
+k4a_wait_result_t queue_waiter_wait(queue_waiter_t waiter_handle, int32_t wait_in_ms);
+
+/** Attaches a waiter to a queue.
+ *
+ * \param queue_handle [IN]
+ *  A queue handle
+ *
+ * \param waiter_handle [IN]
+ *  A waiter handle from \ref queue_waiter_create
+ *
+ * \return K4A_RESULT_SUCCEEDED if the waiter was attached. K4A_RESULT_FAILED if \ref QUEUE_MAX_WAITERS waiters are
+ * already attached to the queue.
+ *
+ * The queue notifies the waiter each time an element is pushed and when the queue is disabled. Attach the waiter
+ * before checking \ref queue_is_ready, so that an element pushed in between is not missed.
+ */
+k4a_result_t queue_add_waiter(queue_t queue_handle, queue_waiter_t waiter_handle);
+
+/** Detaches a waiter from a queue.
+ *
+ * \param queue_handle [IN]
+ *  A queue handle
+ *
+ * \param waiter_handle [IN]
+ *  A waiter handle attached with \ref queue_add_waiter
+ */
+void queue_remove_waiter(queue_t queue_handle, queue_waiter_t waiter_handle);
+
+/** Checks whether \ref queue_pop would return without waiting.
+ *
+ * \param queue_handle [IN]
+ *  A queue handle
+ *
+ * \return true if the queue holds an element, or if it is disabled and \ref queue_pop fails immediately.
+ *
+ * As with \ref queue_get_count, the result is a snapshot.
+ */
+bool queue_is_ready(queue_t queue_handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,8 +16,15 @@ extern "C" {
 #ifdef _WIN32
 typedef void *k4a_rwlock_t;
 #else
-#include <pthread.h>
-typedef pthread_rwlock_t k4a_rwlock_t;
+#include <stdint.h>
+
+// Lock word and writer count of a futex based reader-writer lock. Uncontended acquires and releases are a single atomic
+// operation, threads only enter the kernel to wait for a contended lock.
+typedef struct
+{
+    volatile uint32_t state;
+    volatile uint32_t writers_waiting;
+} k4a_rwlock_t;
 #endif
 
 void rwlock_init(k4a_rwlock_t *lock);
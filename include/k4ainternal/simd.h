@@ -0,0 +1,94 @@
+/** \file simd.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Runtime selection of the vectorized kernels
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <k4a/k4atypes.h>
+
+// The SSE4.1 and NEON kernels are the compiled baseline. The AVX2 and AVX-512 kernels are compiled for their
+// instruction set one function at a time with SIMD_TARGET_AVX2 and SIMD_TARGET_AVX512, so the library still runs on
+// processors without them and only calls them when simd_get_level() allows it.
+#if defined(__amd64__) || defined(_M_AMD64) || defined(__i386__) || defined(_M_IX86)
+#define K4A_USING_SSE
+#include <immintrin.h>
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || (defined(_MSC_VER) && _MSC_VER >= 1910)
+#define K4A_USING_AVX
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define K4A_USING_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(K4A_USING_AVX) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,f16c")))
+#else
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Name of the environment variable that limits the instruction set of the kernels, see simd_get_level()
+ */
+#define SIMD_LEVEL_ENV_VAR "K4A_SIMD_LEVEL"
+
+/** Instruction sets the vectorized kernels are built for
+ *
+ * \remarks
+ * The x86 levels are ordered, each includes the ones below it.
+ */
+typedef enum
+{
+    SIMD_LEVEL_NONE = 0, /**< Scalar kernels only */
+    SIMD_LEVEL_NEON,     /**< NEON kernels, on ARM64 */
+    SIMD_LEVEL_SSE41,    /**< SSE4.1 kernels */
+    SIMD_LEVEL_AVX2,     /**< AVX2 kernels, which may also use F16C */
+    SIMD_LEVEL_AVX512,   /**< AVX-512 kernels using the F, BW and VL extensions */
+} simd_level_t;
+
+/** Gets the instruction set of the vectorized kernels
+ *
+ * \return The best level the processor and the operating system support, lowered to the value of the
+ * K4A_SIMD_LEVEL environment variable if it is set.
+ *
+ * \remarks
+ * The level is detected once per process. K4A_SIMD_LEVEL takes the names of simd_parse_level(), so benchmarks can
+ * compare the kernels of each level in the same binary. A level the processor does not support is ignored with a
+ * warning.
+ */
+simd_level_t simd_get_level(void);
+
+/** Gets the best instruction set the processor and the operating system support, without the K4A_SIMD_LEVEL limit
+ */
+simd_level_t simd_get_supported_level(void);
+
+/** Gets the name of an instruction set, "None", "NEON", "SSE", "AVX2" or "AVX512"
+ */
+const char *simd_get_level_name(simd_level_t level);
+
+/** Parses the name of an instruction set
+ *
+ * \param name
+ * "none", "neon", "sse", "sse4.1", "avx2" or "avx512", in any case
+ *
+ * \param level
+ * Location to write the level
+ *
+ * \return K4A_RESULT_FAILED if the name is not known.
+ */
+k4a_result_t simd_parse_level(const char *name, simd_level_t *level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMD_H */
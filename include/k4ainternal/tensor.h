@@ -0,0 +1,80 @@
+/** \file tensor.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Conversion of camera images to the normalized input tensors of neural networks
+ */
+
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/transformation.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Largest thread_count of a tensor converter
+ */
+#define TENSOR_MAX_THREAD_COUNT (16)
+
+/** Creates a converter of images to NCHW tensors
+ *
+ * \param config
+ * Format and resolution of the images, resolution and element type of the tensors and the normalization
+ *
+ * \param thread_count
+ * Number of shared worker threads a conversion is split across, 0 or 1 to convert on the calling thread only
+ *
+ * \param converter_handle
+ * Location to write the handle
+ *
+ * \remarks
+ * The source columns and rows of the tensor are computed once. Tensor pixels are mapped to the image by their centers,
+ * BGRA32 and IR16 images are resized bilinearly and DEPTH16 images with the nearest pixel.
+ */
+k4a_result_t tensor_converter_create(const k4a_tensor_configuration_t *config,
+                                     uint32_t thread_count,
+                                     k4a_tensor_converter_t *converter_handle);
+
+/** Destroys a tensor converter
+ */
+void tensor_converter_destroy(k4a_tensor_converter_t converter_handle);
+
+/** Returns the size of the tensors written by a converter in bytes, 0 if the handle is invalid
+ */
+size_t tensor_converter_get_size(k4a_tensor_converter_t converter_handle);
+
+/** Converts an image to a tensor
+ *
+ * \param converter_handle
+ * The converter
+ *
+ * \param image_data
+ * Pixels of the image
+ *
+ * \param image_descriptor
+ * Image of the format and resolution of the configuration, rows may be padded
+ *
+ * \param tensor
+ * Tensor of 1 x C x H x W elements, C is 3 for BGRA32 images and 1 otherwise
+ *
+ * \param tensor_size
+ * Size of \p tensor in bytes, at least tensor_converter_get_size()
+ *
+ * \remarks
+ * Calls for one converter must not overlap.
+ */
+k4a_result_t tensor_converter_convert(k4a_tensor_converter_t converter_handle,
+                                      const uint8_t *image_data,
+                                      const k4a_transformation_image_descriptor_t *image_descriptor,
+                                      void *tensor,
+                                      size_t tensor_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TENSOR_H */
@@ -24,8 +24,59 @@ extern "C" {
  */
 K4A_DECLARE_HANDLE(tewrapper_t);
 
+// Work a tewrapper_frame_t asks the transform engine thread to do
+typedef enum
+{
+    TEWRAPPER_OPERATION_PROCESS = 0, // Process into the transformed_image buffers in host memory
+    TEWRAPPER_OPERATION_PROCESS_GPU, // Process into gpu_output
+    TEWRAPPER_OPERATION_RELEASE_GPU, // Release gpu_output, exported by an earlier TEWRAPPER_OPERATION_PROCESS_GPU
+} tewrapper_operation_t;
+
+/** A frame submitted to the transform engine.
+ *
+ * The caller fills in the request fields and owns the memory. Between \ref tewrapper_submit_frame and \ref
+ * tewrapper_wait_frame the frame is queued in the tewrapper and must not be changed or freed.
+ */
+typedef struct _tewrapper_frame_t
+{
+    tewrapper_operation_t operation;
+    k4a_transform_engine_type_t type;
+    const void *depth_image_data;
+    size_t depth_image_size;
+    const void *image2_data;
+    size_t image2_size;
+    void *transformed_image_data;
+    size_t transformed_image_size;
+    void *transformed_image2_data;
+    size_t transformed_image2_size;
+    k4a_transform_engine_interpolation_t interpolation;
+    uint32_t invalid_value;
+    k4a_transform_engine_gpu_export_t gpu_export_type;
+    k4a_transform_engine_gpu_output_t gpu_output;
+
+    // Depth image of a TEWRAPPER_OPERATION_PROCESS_GPU frame exported by the depth engine, used instead of
+    // depth_image_data when not NULL
+    const k4a_transform_engine_gpu_output_t *depth_gpu_input;
+    k4a_transform_engine_gpu_export_t depth_gpu_input_type;
+
+    // Completion of the frame, set by the tewrapper
+    struct _tewrapper_frame_t *next;
+    bool completed;
+    k4a_result_t result;
+} tewrapper_frame_t;
+
 tewrapper_t tewrapper_create(k4a_transform_engine_calibration_t *transform_engine_calibration);
 void tewrapper_destroy(tewrapper_t tewrapper_handle);
+
+// Queues a frame for the transform engine thread and returns without waiting for it. Frames of all callers are
+// processed in submission order, so a thread can submit the next frame while the engine works on the previous one.
+// Every successfully submitted frame must be waited for with tewrapper_wait_frame().
+k4a_result_t tewrapper_submit_frame(tewrapper_t tewrapper_handle, tewrapper_frame_t *frame);
+
+// Waits for a frame submitted with tewrapper_submit_frame() to be processed and returns its result.
+k4a_result_t tewrapper_wait_frame(tewrapper_t tewrapper_handle, tewrapper_frame_t *frame);
+
+// Submits a frame and waits for it.
 k4a_result_t tewrapper_process_frame(tewrapper_t tewrapper_handle,
                                      k4a_transform_engine_type_t type,
                                      const void *depth_image_data,
@@ -39,6 +90,31 @@ k4a_result_t tewrapper_process_frame(tewrapper_t tewrapper_handle,
                                      k4a_transform_engine_interpolation_t interpolation,
                                      uint32_t invalid_value);
 
+// Processes a depth to color or color to depth frame into a GPU resource instead of host memory. The output must be
+// released with tewrapper_release_gpu_output() before the tewrapper is destroyed.
+k4a_result_t tewrapper_process_frame_gpu(tewrapper_t tewrapper_handle,
+                                         k4a_transform_engine_type_t type,
+                                         const void *depth_image_data,
+                                         size_t depth_image_size,
+                                         const void *image2_data,
+                                         size_t image2_size,
+                                         k4a_transform_engine_gpu_export_t export_type,
+                                         k4a_transform_engine_gpu_output_t *output);
+
+// tewrapper_process_frame_gpu() with the depth image read from a GPU resource exported by the depth engine
+k4a_result_t tewrapper_process_frame_gpu_input(tewrapper_t tewrapper_handle,
+                                               k4a_transform_engine_type_t type,
+                                               k4a_transform_engine_gpu_export_t depth_export_type,
+                                               const k4a_transform_engine_gpu_output_t *depth_input,
+                                               const void *image2_data,
+                                               size_t image2_size,
+                                               k4a_transform_engine_gpu_export_t export_type,
+                                               k4a_transform_engine_gpu_output_t *output);
+
+k4a_result_t tewrapper_release_gpu_output(tewrapper_t tewrapper_handle,
+                                          k4a_transform_engine_gpu_export_t export_type,
+                                          const k4a_transform_engine_gpu_output_t *output);
+
 #ifdef __cplusplus
 }
 #endif
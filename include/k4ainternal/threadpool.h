@@ -0,0 +1,108 @@
+/** \file threadpool.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Process wide worker threads and scheduling settings of the SDK threads
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <k4a/k4atypes.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of worker threads in the pool
+ */
+#define THREADPOOL_MAX_WORKERS (64)
+
+/** Sets the CPUs the threads of a role may run on
+ *
+ * \param role
+ * The role of the threads
+ *
+ * \param cpu_mask
+ * Bit N allows CPU N, 0 removes the restriction
+ *
+ * \remarks
+ * Threads read the mask when they call threadpool_apply_thread_role(), threads already running are not moved.
+ */
+k4a_result_t threadpool_set_affinity(k4a_thread_role_t role, uint64_t cpu_mask);
+
+/** Sets the scheduling priority of the threads of a role
+ *
+ * \param role
+ * The role of the threads
+ *
+ * \param priority
+ * The priority of the threads
+ *
+ * \remarks
+ * Threads read the priority when they call threadpool_apply_thread_role(), threads already running keep theirs.
+ */
+k4a_result_t threadpool_set_priority(k4a_thread_role_t role, k4a_thread_priority_t priority);
+
+/** Applies the CPU mask and priority set for its role to the calling thread
+ *
+ * \param role
+ * The role of the calling thread
+ *
+ * \remarks
+ * Called first thing by every long running SDK thread. Settings left at their default are not applied. Failing to
+ * apply a setting is logged and otherwise ignored.
+ */
+void threadpool_apply_thread_role(k4a_thread_role_t role);
+
+/** Sets the number of worker threads
+ *
+ * \param worker_count
+ * Number of threads, 0 for one per CPU less one
+ *
+ * \remarks
+ * Applies the next time the pool is started by threadpool_acquire().
+ */
+k4a_result_t threadpool_set_worker_count(uint32_t worker_count);
+
+/** Takes a reference on the worker threads
+ *
+ * \remarks
+ * The first reference starts the workers. Each successful call must be matched by threadpool_release().
+ */
+k4a_result_t threadpool_acquire(void);
+
+/** Releases a reference from threadpool_acquire()
+ *
+ * \remarks
+ * The last reference stops and joins the workers. Must not be called from a task.
+ */
+void threadpool_release(void);
+
+/** Runs a set of tasks on the worker threads and waits for them to complete
+ *
+ * \param task_function
+ * Function called once for each task with a pointer to the task
+ *
+ * \param tasks
+ * Array of \p task_count tasks of \p task_size bytes each
+ *
+ * \param task_size
+ * Size of a task in bytes
+ *
+ * \param task_count
+ * Number of tasks
+ *
+ * \remarks
+ * The calling thread runs tasks as well, so the tasks complete even when no workers are running. Several threads may
+ * run tasks at the same time, their tasks share the workers. Tasks must not call threadpool_run_tasks().
+ */
+void threadpool_run_tasks(THREAD_START_FUNC task_function, void *tasks, size_t task_size, uint32_t task_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREADPOOL_H */
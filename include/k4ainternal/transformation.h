@@ -13,6 +13,13 @@
 extern "C" {
 #endif
 
+// Maximum number of threads the CPU depth to color transformation may split its work across
+#define TRANSFORMATION_MAX_THREAD_COUNT (16)
+
+// Largest downscale of a color image transformed to the depth camera, the smallest turbojpeg scaled decode. It also
+// bounds the downscale of a depth image transformed to the color camera.
+#define TRANSFORMATION_MAX_COLOR_SCALE (8)
+
 typedef struct _k4a_camera_calibration_mode_info_t
 {
     unsigned int calibration_image_binned_resolution[2];
@@ -36,6 +43,15 @@ typedef struct _k4a_transformation_xy_tables_t
     int height;     // height of x and y tables
 } k4a_transformation_xy_tables_t;
 
+typedef struct _k4a_transformation_ray_tables_t
+{
+    float *x_table; // color camera X coordinate per unit of depth camera depth, NAN marks invalid
+    float *y_table; // color camera Y coordinate per unit of depth camera depth
+    float *z_table; // color camera Z coordinate per unit of depth camera depth
+    int width;      // width of x, y and z tables
+    int height;     // height of x, y and z tables
+} k4a_transformation_ray_tables_t;
+
 typedef struct _k4a_transformation_pinhole_t
 {
     float px;
@@ -84,6 +100,23 @@ k4a_result_t transformation_3d_to_2d(const k4a_calibration_t *calibration,
                                      float target_point2d[2],
                                      int *valid);
 
+k4a_result_t transformation_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           size_t point_count,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           int *valid);
+
+k4a_result_t transformation_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           size_t point_count,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid);
+
 k4a_result_t transformation_2d_to_2d(const k4a_calibration_t *calibration,
                                      const float source_point2d[2],
                                      const float source_depth,
@@ -102,6 +135,48 @@ k4a_transformation_t transformation_create(const k4a_calibration_t *calibration,
 
 void transformation_destroy(k4a_transformation_t transformation_handle);
 
+k4a_result_t transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count);
+
+k4a_result_t transformation_enable_depth_to_color_ray_tables(k4a_transformation_t transformation_handle, bool enable);
+
+k4a_result_t transformation_set_region_of_interest(k4a_transformation_t transformation_handle,
+                                                   const k4a_transformation_roi_t *roi);
+
+k4a_result_t transformation_get_xy_table(k4a_transformation_t transformation_handle,
+                                         const k4a_calibration_type_t camera,
+                                         uint8_t *xy_table_data,
+                                         const k4a_transformation_image_descriptor_t *xy_table_descriptor);
+
+// Transforms point_count color camera pixels to depth camera pixels. The correspondences of every depth pixel are
+// computed once and inverted into a map of the color camera, each color pixel is then looked up in the map and refined
+// on the depth pixels around the one found.
+k4a_result_t transformation_color_2d_to_depth_2d_batch_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const float *source_points2d,
+    size_t point_count,
+    float *target_points2d,
+    int *valid,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera);
+
+k4a_result_t
+transformation_color_2d_to_depth_2d_batch(k4a_transformation_t transformation_handle,
+                                          const uint8_t *depth_image_data,
+                                          const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                          const float *source_points2d,
+                                          size_t point_count,
+                                          float *target_points2d,
+                                          int *valid);
+
+// Gets how many color camera pixels wide a pixel of a depth image transformed to the color camera is. The output is a
+// DEPTH16 image at the color camera resolution, or downscaled by a power of two up to TRANSFORMATION_MAX_COLOR_SCALE
+// and rounded up. Returns 0 for any other image.
+int transformation_get_depth_to_color_scale(const k4a_calibration_camera_t *color_camera_calibration,
+                                            const k4a_transformation_image_descriptor_t *transformed_image_descriptor);
+
 k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_parameters(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
@@ -126,7 +201,40 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     uint8_t *transformed_custom_image_data,
     k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor,
     k4a_transformation_interpolation_type_t interpolation_type,
-    uint32_t invalid_custom_value);
+    uint32_t invalid_custom_value,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera);
+
+k4a_buffer_result_t transformation_depth_image_to_color_camera_custom_images_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    const uint32_t *invalid_custom_values);
+
+k4a_buffer_result_t transformation_depth_image_to_color_camera_custom_images_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    const uint32_t *invalid_custom_values,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera);
 
 k4a_result_t transformation_depth_image_to_color_camera_custom(
     k4a_transformation_t transformation_handle,
@@ -141,6 +249,26 @@ k4a_result_t transformation_depth_image_to_color_camera_custom(
     k4a_transformation_interpolation_type_t interpolation_type,
     uint32_t invalid_custom_value);
 
+k4a_result_t transformation_depth_image_to_color_camera_custom_images(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    const uint32_t *invalid_custom_values);
+
+// Gets how many color camera pixels wide a pixel of a color image transformed to the depth camera is. Color is read
+// from BGRA32, NV12 or YUY2 images at the color camera resolution, or from BGRA32 images downscaled by a power of two
+// up to TRANSFORMATION_MAX_COLOR_SCALE. Returns 0 for any other image.
+int transformation_get_color_image_scale(const k4a_calibration_camera_t *color_camera_calibration,
+                                         const k4a_transformation_image_descriptor_t *color_image_descriptor);
+
 k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_parameters(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
@@ -159,7 +287,8 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     const uint8_t *color_image_data,
     const k4a_transformation_image_descriptor_t *color_image_descriptor,
     uint8_t *transformed_color_image_data,
-    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor);
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type);
 
 k4a_result_t
 transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
@@ -170,6 +299,25 @@ transformation_color_image_to_depth_camera(k4a_transformation_t transformation_h
                                            uint8_t *transformed_color_image_data,
                                            k4a_transformation_image_descriptor_t *transformed_color_image_descriptor);
 
+k4a_result_t transformation_color_image_to_depth_camera_with_interpolation(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *transformed_color_image_data,
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type);
+
+// Decodes an MJPEG color image for transformation_color_image_to_depth_camera_with_interpolation(). The image is
+// decoded at the smallest scale that still has the resolution of the depth camera, instead of decoding color pixels
+// that are never sampled. The caller frees the BGRA image with free().
+k4a_result_t transformation_decode_color_image(k4a_transformation_t transformation_handle,
+                                               const uint8_t *jpeg_data,
+                                               size_t jpeg_size,
+                                               uint8_t **bgra_image_data,
+                                               k4a_transformation_image_descriptor_t *bgra_image_descriptor);
+
 k4a_buffer_result_t
 transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_t *xy_tables,
                                                    const uint8_t *depth_image_data,
@@ -177,6 +325,25 @@ transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_
                                                    uint8_t *xyz_image_data,
                                                    k4a_transformation_image_descriptor_t *xyz_image_descriptor);
 
+k4a_buffer_result_t transformation_depth_image_to_point_cloud_with_format_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor);
+
+k4a_buffer_result_t transformation_depth_image_to_compact_point_cloud_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *index_image_data,
+    k4a_transformation_image_descriptor_t *index_image_descriptor,
+    size_t *point_count);
+
 k4a_result_t
 transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
                                           const uint8_t *depth_image_data,
@@ -185,6 +352,129 @@ transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_ha
                                           uint8_t *xyz_image_data,
                                           k4a_transformation_image_descriptor_t *xyz_image_descriptor);
 
+k4a_result_t transformation_depth_image_to_point_cloud_with_format(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor);
+
+k4a_result_t
+transformation_depth_image_to_compact_point_cloud(k4a_transformation_t transformation_handle,
+                                                  const uint8_t *depth_image_data,
+                                                  const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                  const k4a_calibration_type_t camera,
+                                                  k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                  uint8_t *xyz_image_data,
+                                                  k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+                                                  uint8_t *index_image_data,
+                                                  k4a_transformation_image_descriptor_t *index_image_descriptor,
+                                                  size_t *point_count);
+
+// Writes the float point cloud and the normals of the points of a depth image in one pass
+k4a_buffer_result_t transformation_depth_image_to_point_cloud_with_normals_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor);
+
+k4a_result_t transformation_depth_image_to_point_cloud_with_normals(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor);
+
+// Writes one float point, the centroid of the points of a depth image in a voxel of voxel_size meters, per occupied
+// voxel. The normal image is optional.
+k4a_buffer_result_t transformation_depth_image_to_voxel_point_cloud_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    float voxel_size,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor,
+    size_t *point_count);
+
+k4a_result_t
+transformation_depth_image_to_voxel_point_cloud(k4a_transformation_t transformation_handle,
+                                                const uint8_t *depth_image_data,
+                                                const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                const k4a_calibration_type_t camera,
+                                                float voxel_size,
+                                                uint8_t *xyz_image_data,
+                                                k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+                                                uint8_t *normal_image_data,
+                                                k4a_transformation_image_descriptor_t *normal_image_descriptor,
+                                                size_t *point_count);
+
+// Each point of a colored point cloud is int16_t x, y, z in millimeters followed by uint8_t b, g, r, a
+#define TRANSFORMATION_COLORED_POINT_SIZE (3 * (int)sizeof(int16_t) + 4 * (int)sizeof(uint8_t))
+
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *colored_xyz_image_data,
+    k4a_transformation_image_descriptor_t *colored_xyz_image_descriptor);
+
+k4a_result_t transformation_depth_image_to_colored_point_cloud(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *colored_xyz_image_data,
+    k4a_transformation_image_descriptor_t *colored_xyz_image_descriptor);
+
+// Runs the transform engine into a GPU resource that stays valid until transformation_release_gpu_resource()
+k4a_result_t transformation_depth_image_to_color_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_depth_resource);
+
+k4a_result_t transformation_color_image_to_depth_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_color_resource);
+
+// transformation_depth_image_to_color_camera_gpu() with the depth image read from a resource the depth engine exported
+k4a_result_t transformation_depth_resource_to_color_camera_gpu(k4a_transformation_t transformation_handle,
+                                                              const k4a_gpu_resource_t *depth_resource,
+                                                              k4a_gpu_interop_type_t type,
+                                                              k4a_gpu_resource_t *transformed_depth_resource);
+
+k4a_result_t transformation_release_gpu_resource(k4a_transformation_t transformation_handle,
+                                                 const k4a_gpu_resource_t *resource);
+
+// Queues the jobs to the worker thread of the transformation handle, callback is called once all of them completed
+k4a_result_t transformation_submit(k4a_transformation_t transformation_handle,
+                                   const k4a_transformation_job_t *jobs,
+                                   size_t job_count,
+                                   k4a_transformation_completion_cb_t *callback,
+                                   void *callback_context);
+
+k4a_wait_result_t transformation_wait_idle(k4a_transformation_t transformation_handle, int32_t timeout_in_ms);
+
 // Mode specific calibration
 k4a_result_t
 transformation_get_mode_specific_depth_camera_calibration(const k4a_calibration_camera_t *raw_camera_calibration,
@@ -214,6 +504,21 @@ k4a_result_t transformation_project(const k4a_calibration_camera_t *camera_calib
                                     float point2d[2],
                                     int *valid);
 
+// Batched variants of the above. points2d and points3d are tightly packed arrays of point_count 2D and 3D points, and
+// valid receives one flag per point. The camera calibration is validated once for the whole batch.
+k4a_result_t transformation_unproject_batch(const k4a_calibration_camera_t *camera_calibration,
+                                            const float *points2d,
+                                            const float *depths,
+                                            size_t point_count,
+                                            float *points3d,
+                                            int *valid);
+
+k4a_result_t transformation_project_batch(const k4a_calibration_camera_t *camera_calibration,
+                                          const float *points3d,
+                                          size_t point_count,
+                                          float *points2d,
+                                          int *valid);
+
 // Extrinsic transformations
 k4a_result_t transformation_get_extrinsic_transformation(const k4a_calibration_extrinsics_t *source_camera_calibration,
                                                          const k4a_calibration_extrinsics_t *target_camera_calibration,
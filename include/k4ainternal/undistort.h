@@ -0,0 +1,91 @@
+/** \file undistort.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Undistortion and rectification of camera images with a precomputed map
+ */
+
+#ifndef UNDISTORT_H
+#define UNDISTORT_H
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/transformation.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Largest thread_count of an undistortion map
+ */
+#define UNDISTORT_MAX_THREAD_COUNT (16)
+
+/** Creates a map from the pixels of a pinhole camera to the pixels of a calibrated camera
+ *
+ * \param camera_calibration
+ * Calibration of the camera whose images are remapped
+ *
+ * \param target
+ * Pinhole camera of the remapped images, NULL for the intrinsics and resolution of \p camera_calibration without
+ * distortion
+ *
+ * \param rotation
+ * Row major 3x3 rotation from the target camera to the calibrated camera, NULL for none
+ *
+ * \param thread_count
+ * Number of shared worker threads a remap is split across, 0 or 1 to remap on the calling thread only
+ *
+ * \param map_handle
+ * Location to write the handle
+ *
+ * \remarks
+ * The rays of the target pixels are projected a row at a time with transformation_project_batch(). Target pixels whose
+ * ray does not project between the centers of the first and last pixels of the calibrated camera are left 0 by a
+ * remap.
+ */
+k4a_result_t undistort_map_create(const k4a_calibration_camera_t *camera_calibration,
+                                  const k4a_pinhole_t *target,
+                                  const float *rotation,
+                                  uint32_t thread_count,
+                                  k4a_undistortion_map_t *map_handle);
+
+/** Destroys an undistortion map
+ */
+void undistort_map_destroy(k4a_undistortion_map_t map_handle);
+
+/** Remaps an image of the calibrated camera to the target camera
+ *
+ * \param map_handle
+ * The map
+ *
+ * \param source_data
+ * Pixels of the calibrated camera
+ *
+ * \param source_descriptor
+ * DEPTH16, IR16 or BGRA32 image of the calibrated camera resolution, rows may be padded
+ *
+ * \param destination_data
+ * Pixels of the target camera
+ *
+ * \param destination_descriptor
+ * Image of the format of \p source_descriptor and the target resolution, rows may be padded
+ *
+ * \param interpolation_type
+ * Nearest neighbor or bilinear sampling of the source
+ *
+ * \remarks
+ * Bilinear sampling of a DEPTH16 image writes 0 where a neighbor with a nonzero weight is 0, so depth is never blended
+ * with a pixel without depth. Calls for one map must not overlap.
+ */
+k4a_result_t undistort_map_remap(k4a_undistortion_map_t map_handle,
+                                 const uint8_t *source_data,
+                                 const k4a_transformation_image_descriptor_t *source_descriptor,
+                                 uint8_t *destination_data,
+                                 const k4a_transformation_image_descriptor_t *destination_descriptor,
+                                 k4a_transformation_interpolation_type_t interpolation_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UNDISTORT_H */
@@ -17,6 +17,7 @@ extern "C" {
 #endif
 
 //**************Symbolic Constant Macros (defines)  *************
+#define USB_CMD_BATCH_MAX_COMMANDS 8 // Upper limit to the number of commands queued in one batch
 
 //************************ Typedefs *****************************
 typedef enum
@@ -36,6 +37,12 @@ typedef enum
 
 K4A_DECLARE_HANDLE(usbcmd_t);
 
+/** Handle to a batch of commands pipelined on the command endpoints of one device.
+ *
+ * Handles are created with \ref usb_cmd_batch_create and closed with \ref usb_cmd_batch_destroy.
+ */
+K4A_DECLARE_HANDLE(usb_cmd_batch_t);
+
 /** Delivers a sample to the registered callback function when a capture is ready for processing.
  *
  * \param result
@@ -133,6 +140,77 @@ k4a_result_t usb_cmd_write_with_status(usbcmd_t usb_handle,
                                        size_t data_size,
                                        uint32_t *cmd_status);
 
+/** Create an empty batch of commands for a device.
+ *
+ * \param usb_handle [IN]
+ *    The device the commands are sent to, it must outlive the batch
+ *
+ * \param batch_handle [OUT]
+ *    A pointer to write the batch handle to
+ *
+ * \remarks
+ * The commands of a batch are sent back to back: every command, data and status transfer of the batch is submitted
+ * at once and the device works through them without waiting on a round trip per stage. A command is sent even if an
+ * earlier command of the batch reported a failing status, so only batch commands that do not depend on each other's
+ * success.
+ */
+k4a_result_t usb_cmd_batch_create(usbcmd_t usb_handle, usb_cmd_batch_t *batch_handle);
+
+/** Destroy a batch, waiting for its commands first if it was submitted and not waited on.
+ */
+void usb_cmd_batch_destroy(usb_cmd_batch_t batch_handle);
+
+/** Queue a read command, see \ref usb_cmd_read_with_status.
+ *
+ * \remarks
+ * The command data is copied. p_data, bytes_read and cmd_status must stay valid until \ref usb_cmd_batch_wait returns.
+ * If cmd_status is NULL a nonzero command status fails the batch, as with \ref usb_cmd_read.
+ */
+k4a_result_t usb_cmd_batch_add_read(usb_cmd_batch_t batch_handle,
+                                    uint32_t cmd,
+                                    uint8_t *p_cmd_data,
+                                    size_t cmd_data_size,
+                                    uint8_t *p_data,
+                                    size_t data_size,
+                                    size_t *bytes_read,
+                                    uint32_t *cmd_status);
+
+/** Queue a write command, see \ref usb_cmd_write_with_status.
+ *
+ * \remarks
+ * The command data is copied. p_data and cmd_status must stay valid until \ref usb_cmd_batch_wait returns.
+ * If cmd_status is NULL a nonzero command status fails the batch, as with \ref usb_cmd_write.
+ */
+k4a_result_t usb_cmd_batch_add_write(usb_cmd_batch_t batch_handle,
+                                     uint32_t cmd,
+                                     uint8_t *p_cmd_data,
+                                     size_t cmd_data_size,
+                                     uint8_t *p_data,
+                                     size_t data_size,
+                                     uint32_t *cmd_status);
+
+/** Submit the queued commands and return without waiting for them.
+ *
+ * \remarks
+ * Other commands and batches for the device wait until this batch is waited on with \ref usb_cmd_batch_wait, so the
+ * thread that submits a batch must wait on it before it sends another command to the same device.
+ */
+k4a_result_t usb_cmd_batch_submit(usb_cmd_batch_t batch_handle);
+
+/** Wait for a submitted batch to complete.
+ *
+ * \return K4A_RESULT_SUCCEEDED if every command of the batch completed, and every command queued without a cmd_status
+ * pointer returned a zero status.
+ *
+ * \remarks
+ * The batch is emptied and can be filled and submitted again.
+ */
+k4a_result_t usb_cmd_batch_wait(usb_cmd_batch_t batch_handle);
+
+/** Submit the queued commands and wait for them to complete.
+ */
+k4a_result_t usb_cmd_batch_execute(usb_cmd_batch_t batch_handle);
+
 // stream data callback
 k4a_result_t usb_cmd_stream_register_cb(usbcmd_t usbcmd, usb_cmd_stream_cb_t *frame_ready_cb, void *context);
 
@@ -140,9 +218,19 @@ k4a_result_t usb_cmd_stream_start(usbcmd_t usb_handle, size_t payload_size);
 
 k4a_result_t usb_cmd_stream_stop(usbcmd_t usb_handle);
 
+// Get the telemetry of the streaming endpoint, reset when the stream starts
+k4a_result_t usb_cmd_get_stream_stats(usbcmd_t usb_handle, k4a_usb_stream_stats_t *stats);
+
+// Get the NUMA node of the USB controller the device is connected to, -1 when unknown
+int usb_cmd_get_numa_node(usbcmd_t usb_handle);
+
 // Get the number of connected devices
 k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count);
 
+// Notifies hotplug_cb from a monitor thread when devices are attached or detached, NULL stops monitoring. While a
+// callback is registered, usb_cmd_get_device_count() returns the count kept by the monitor without enumerating.
+k4a_result_t usb_cmd_set_hotplug_callback(k4a_device_hotplug_cb_t *hotplug_cb, void *context);
+
 const guid_t *usb_cmd_get_container_id(usbcmd_t usbcmd_handle);
 
 #ifdef __cplusplus
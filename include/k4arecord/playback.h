@@ -47,6 +47,132 @@ extern "C" {
  */
 K4ARECORD_EXPORT k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle);
 
+/** Opens an existing recording file for reading, reading only its header, tracks and tags.
+ *
+ * \param path
+ * Filesystem path of the existing recording.
+ *
+ * \param playback_handle
+ * If successful, this contains a pointer to the recording handle. Caller must call k4a_playback_close() when
+ * finished with the recording.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * k4a_playback_open() reads the attachments and the index of the recording, and loads its first and last clusters of
+ * data. This function only reads what is needed for k4a_playback_get_record_configuration(), the tags and the track
+ * information, which makes it much faster to list the metadata of many recordings.
+ *
+ * \remarks
+ * The attachments are read by the first call that needs them, such as k4a_playback_get_calibration() or
+ * k4a_playback_get_attachment(). The index and clusters are loaded by the first call that reads or seeks the
+ * recording, or that needs its length, such as k4a_playback_get_recording_length_usec(). Errors in these parts of the
+ * recording are returned by that call instead of by the open.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_open_lazy(const char *path, k4a_playback_t *playback_handle);
+
+/** Opens an existing recording for reading through an application supplied read callback.
+ *
+ * \param name
+ * A name for the recording, used in log messages. The name is copied.
+ *
+ * \param size
+ * The size of the recording in bytes.
+ *
+ * \param read_cb
+ * The callback that reads the recording, see ::k4a_playback_read_cb_t.
+ *
+ * \param callback_context
+ * The context passed to \p read_cb. It must stay valid until k4a_playback_close() returns.
+ *
+ * \param playback_handle
+ * If successful, this contains a pointer to the recording handle. Caller must call k4a_playback_close() when
+ * finished with the recording.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Use this function to play back a recording that is not on a local disk, such as a recording in blob storage, without
+ * downloading it first. Only the header, the index and the clusters of data that are played back are read.
+ *
+ * \remarks
+ * The recording is read in blocks of 1 MB, which are kept in memory up to a total of 64 MB. The clusters preloaded
+ * around the read position, see k4a_playback_set_cluster_read_ahead(), are requested in parallel, so the latency of
+ * each request overlaps with the others and with the processing of the current captures.
+ *
+ * \remarks
+ * Recordings opened with this function don't use a sidecar index, and k4a_playback_set_mapped_io() and
+ * k4a_playback_write_index() are not supported.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_open_custom_io(const char *name,
+                                                          uint64_t size,
+                                                          k4a_playback_read_cb_t *read_cb,
+                                                          void *callback_context,
+                                                          k4a_playback_t *playback_handle);
+
+/** Opens one device of a recording of several devices for reading.
+ *
+ * \param path
+ * Filesystem path of the existing recording.
+ *
+ * \param device_index
+ * The index of the device in the recording, less than k4a_playback_get_device_count().
+ *
+ * \param playback_handle
+ * If successful, this contains a pointer to the recording handle. Caller must call k4a_playback_close() when
+ * finished with the recording.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the recording has no such device.
+ *
+ * \remarks
+ * A recording written with k4a_record_add_device() holds the color, depth, IR and IMU tracks of several devices. The
+ * playback handle reads the tracks, configuration and calibration of \p device_index as its captures and IMU samples,
+ * as if the device had been recorded alone. The tracks of the other devices are seen as custom tracks. Opening device
+ * 0 is the same as k4a_playback_open().
+ *
+ * \remarks
+ * To read the captures of every device together, open the recording with k4a_playback_group_open_devices().
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_open_device(const char *path,
+                                                       uint32_t device_index,
+                                                       k4a_playback_t *playback_handle);
+
 /** Get the raw calibration blob for the Azure Kinect device used during recording.
  *
  * \param playback_handle
@@ -134,6 +260,27 @@ K4ARECORD_EXPORT k4a_result_t k4a_playback_get_calibration(k4a_playback_t playba
 K4ARECORD_EXPORT k4a_result_t k4a_playback_get_record_configuration(k4a_playback_t playback_handle,
                                                                     k4a_record_configuration_t *config);
 
+/** Gets the number of devices recorded in a playback file.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \returns
+ * The number of devices whose tracks are in the recording, 1 unless devices were added with k4a_record_add_device().
+ * Returns 0 if the handle is invalid.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint32_t k4a_playback_get_device_count(k4a_playback_t playback_handle);
+
 /** Checks whether a track with the given track name exists in the playback file.
  *
  * \param playback_handle
@@ -406,26 +553,28 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_tag(k4a_playback_t playbac
 K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle,
                                                                 k4a_image_format_t target_format);
 
-/** Reads an attachment file from a recording.
+/** Set the scale that MJPG color images are decoded to. By default color images are decoded at the resolution stored in
+ * the recording file.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param file_name
- * The attachment file name.
+ * \param scale
+ * The scale of the color images returned in captures.
  *
- * \param data
- * Location to write the attachment data. If a NULL buffer is specified, \p data_size will be set to the size of
- * buffer needed to store the data.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the scale is supported. ::K4A_RESULT_FAILED otherwise.
  *
- * \param data_size
- * On input, the size of the \p data buffer. On output, this is set to the length of the attachment data.
+ * \remarks
+ * Scaling is done while decoding, so it only applies to recordings with a ::K4A_IMAGE_FORMAT_COLOR_MJPG color track
+ * once k4a_playback_set_color_conversion() has selected a format other than ::K4A_IMAGE_FORMAT_COLOR_MJPG. Decoding to
+ * a reduced resolution is significantly faster than a full resolution decode.
  *
- * \returns
- * A return of ::K4A_BUFFER_RESULT_SUCCEEDED means that the \p data has been filled in. If the buffer is too small the
- * function returns ::K4A_BUFFER_RESULT_TOO_SMALL and the needed size of the \p data buffer is returned in the
- * \p data_size parameter. ::K4A_BUFFER_RESULT_FAILED is returned if the attachment \p file_name does not exist. All
- * other failures return ::K4A_BUFFER_RESULT_FAILED.
+ * \remarks
+ * The calibration returned by k4a_playback_get_calibration() describes the full color resolution. Scaled color images
+ * can not be used with the k4a_transformation_t functions.
+ *
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -435,42 +584,38 @@ K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t p
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_attachment(k4a_playback_t playback_handle,
-                                                                 const char *file_name,
-                                                                 uint8_t *data,
-                                                                 size_t *data_size);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_scale(k4a_playback_t playback_handle, k4a_color_scale_t scale);
 
-/** Read the next capture in the recording sequence.
+/** Decode a color image read from a recording into an image provided by the application.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param capture_handle
- * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
- * this capture
+ * \param color_image
+ * A ::K4A_IMAGE_FORMAT_COLOR_MJPG, ::K4A_IMAGE_FORMAT_COLOR_NV12 or ::K4A_IMAGE_FORMAT_COLOR_YUY2 color image.
  *
- * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ * \param target_image
+ * The ::K4A_IMAGE_FORMAT_COLOR_BGRA32 image the color image is decoded into.
  *
- * \relates k4a_playback_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the image was decoded. ::K4A_RESULT_FAILED if the formats or sizes of the images are not
+ * supported, or if \p color_image could not be decoded.
  *
  * \remarks
- * k4a_playback_get_next_capture() always returns the next capture in sequence after the most recently returned capture.
+ * Decoding into the same \p target_image for every capture avoids allocating a new image for each frame, for example
+ * when the decoded frame is copied to a texture and not kept. Leave the color conversion of the playback handle at
+ * ::K4A_IMAGE_FORMAT_COLOR_MJPG, so the captures hold the color images as they are stored in the recording.
  *
  * \remarks
- * The first call to k4a_playback_get_next_capture() after k4a_playback_seek_timestamp() will return the capture
- * in the recording closest to the seek time with an image timestamp greater than or equal to the seek time.
+ * \p target_image must have the width and height of \p color_image. A ::K4A_IMAGE_FORMAT_COLOR_MJPG image can also be
+ * decoded to a size reduced by one of the scales of k4a_playback_set_color_scale(), rounded up to whole pixels. The
+ * device timestamp of \p color_image is copied to \p target_image.
  *
  * \remarks
- * If a call was made to k4a_playback_get_previous_capture() that returned ::K4A_STREAM_RESULT_EOF, the playback
- * position is at the beginning of the stream and k4a_playback_get_next_capture() will return the first capture in the
- * recording.
+ * Images decoded by k4a_playback_get_next_capture() with a color conversion set reuse the buffers of released images
+ * of the same size, so releasing a capture before reading the next one also avoids allocating new buffers.
  *
- * \remarks
- * Capture objects returned by the playback API will always contain at least one image, but may have images missing if
- * frames were dropped in the original recording. When calling k4a_capture_get_color_image(),
- * k4a_capture_get_depth_image(), or k4a_capture_get_ir_image(), the image should be checked for NULL.
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -480,41 +625,35 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_attachment(k4a_playback_t
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_t playback_handle,
-                                                                   k4a_capture_t *capture_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_decode_color_image(k4a_playback_t playback_handle,
+                                                              k4a_image_t color_image,
+                                                              k4a_image_t target_image);
 
-/** Read the previous capture in the recording sequence.
+/** Convert the color images of the next captures in the background while the current capture is processed.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param capture_handle
- * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
- * this capture.
+ * \param capture_count
+ * The number of captures after the current one to convert color images for, or 0 to convert color images only when
+ * their capture is read (Default).
  *
  * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
- *
- * \relates k4a_playback_t
- *
- * \remarks
- * k4a_playback_get_previous_capture() always returns the previous capture in the sequence before the most
- * recently returned capture.
+ * ::K4A_RESULT_SUCCEEDED if the read ahead count was set. ::K4A_RESULT_FAILED if the recording has no color track.
  *
  * \remarks
- * If a call was made to k4a_playback_get_next_capture() that returned ::K4A_STREAM_RESULT_EOF, the playback position
- * is at the end of the stream and k4a_playback_get_previous_capture() will return the last capture in
- * the recording.
+ * When playback moves forward with k4a_playback_get_next_capture(), the color images of the next \p capture_count
+ * captures are converted on background threads with the format and scale set by k4a_playback_set_color_conversion()
+ * and k4a_playback_set_color_scale(). When playback moves backward with k4a_playback_get_previous_capture(), the
+ * color images of the \p capture_count previous captures are converted instead, so playing a recording in reverse
+ * is as fast as playing it forward. Converting images ahead of time lets offline processing decode MJPG recordings
+ * on several cores instead of only the calling thread.
  *
  * \remarks
- * The first call to k4a_playback_get_previous_capture() after k4a_playback_seek_timestamp() will return the
- * capture in the recording closest to the seek time with all image timestamps less than the seek time.
+ * Images converted ahead of time are discarded when playback seeks or changes direction, or when the color conversion
+ * settings change. Each image converted ahead of time uses memory until its capture is read.
  *
- * \remarks
- * Capture objects returned by this API will always contain at least one image, but may have images missing if frames
- * were dropped in the original recording. When calling k4a_capture_get_color_image(), k4a_capture_get_depth_image(), or
- * k4a_capture_get_ir_image(), the image should be checked for NULL.
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -524,34 +663,36 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playback_t playback_handle,
-                                                                       k4a_capture_t *capture_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_read_ahead(k4a_playback_t playback_handle,
+                                                                uint32_t capture_count);
 
-/** Read the next IMU sample in the recording sequence.
+/** Sets the video decoder for a color track written with k4a_record_set_color_encoder().
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param imu_sample
- * The location to write the IMU sample.
+ * \param decode_cb
+ * The callback that decompresses each color frame, or NULL to remove the decoder.
  *
- * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ * \param callback_context
+ * Context passed to \p decode_cb.
  *
- * \relates k4a_playback_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the decoder was set. ::K4A_RESULT_FAILED if the recording has no color track.
  *
  * \remarks
- * k4a_playback_get_next_imu_sample() always returns the IMU sample after the most recently returned sample.
+ * The codec of an encoded color track is returned by k4a_playback_track_get_codec_id() for ::K4A_TRACK_NAME_COLOR,
+ * and the setup data of the decoder by k4a_playback_track_get_codec_context(). Without a decoder, reading the color
+ * image of an encoded track fails. The color format of the recording configuration is ::K4A_IMAGE_FORMAT_COLOR_BGRA32,
+ * the decoder is asked for the format set by k4a_playback_set_color_conversion().
  *
  * \remarks
- * If a call was made to k4a_playback_get_previous_imu_sample() which returned ::K4A_STREAM_RESULT_EOF, then the
- * playback position is at the beginning of the recording and k4a_playback_get_next_imu_sample() will return the first
- * IMU sample in the recording.
+ * Frames that aren't key frames are decoded after the frames they depend on. Playing the recording forward decodes
+ * each frame once. After a seek, or when playing backward, the frames from the previous key frame are decoded again
+ * with a NULL image, which is slower. Color images are not read ahead for encoded tracks, see
+ * k4a_playback_set_color_read_ahead().
  *
- * \remarks
- * The first call to k4a_playback_get_next_imu_sample() after k4a_playback_seek_timestamp() will return the IMU
- * sample in the recording closest to the seek time with a timestamp greater than or equal to the seek time.
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -561,34 +702,39 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playb
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playback_t playback_handle,
-                                                                      k4a_imu_sample_t *imu_sample);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_decoder(k4a_playback_t playback_handle,
+                                                             k4a_playback_color_decode_cb_t *decode_cb,
+                                                             void *callback_context);
 
-/** Read the previous IMU sample in the recording sequence.
+/** Choose which image tracks are read into captures.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param imu_sample [OUT]
- * The location to write the IMU sample.
+ * \param track_names
+ * The names of the tracks to read, out of ::K4A_TRACK_NAME_COLOR, ::K4A_TRACK_NAME_DEPTH and ::K4A_TRACK_NAME_IR. May be
+ * NULL if \p track_count is 0.
  *
- * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ * \param track_count
+ * The number of names in \p track_names, or 0 to read every image track in the recording (Default).
  *
- * \relates k4a_playback_t
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the enabled tracks were set. ::K4A_RESULT_FAILED if a track is not an image track of the
+ * recording, in which case the enabled tracks are left unchanged.
  *
  * \remarks
- * k4a_playback_get_previous_imu_sample() always returns the IMU sample before the most recently returned sample.
+ * Captures only contain images from the enabled tracks. The blocks of disabled tracks are skipped without being decoded
+ * or copied into images, so reading only depth from a recording with MJPG color doesn't pay for decoding color.
+ * k4a_playback_get_frame_count() and k4a_playback_seek_frame() count the captures made of the enabled tracks.
  *
  * \remarks
- * If a call was made to to k4a_playback_get_next_imu_sample() which returned ::K4A_STREAM_RESULT_EOF, then the playback
- * position is at the end of the recording and k4a_playback_get_previous_imu_sample() will return the last IMU sample in
- * the recording.
+ * For a device opened with k4a_playback_open_device(), these names select the image tracks of that device.
  *
  * \remarks
- * The first call to k4a_playback_get_previous_imu_sample() after k4a_playback_seek_timestamp() will return the
- * IMU sample closest to the seek time with a timestamp less than the seek time.
+ * Changing the enabled tracks moves the playback handle back to the start of the recording. Cursors created with
+ * k4a_playback_cursor_create() must be seeked before they are read again.
+ *
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -598,46 +744,57 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playba
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback_handle,
-                                                                          k4a_imu_sample_t *imu_sample);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_enabled_tracks(k4a_playback_t playback_handle,
+                                                              const char *const *track_names,
+                                                              size_t track_count);
 
-/** Read the next data block for a particular track.
+/** Keep recently used data in memory, so that seeking back to it doesn't read it from disk again.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param track_name
- * The name of the track to read the next data block from.
- *
- * \param data_block_handle
- * The location to write the data block handle.
+ * \param cache_size_bytes
+ * The amount of recording data to keep in memory, or 0 to disable the cache (Default).
  *
  * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ * ::K4A_RESULT_SUCCEEDED if the cache size was set.
+ *
+ * \remarks
+ * Recordings are read from disk in clusters of about 32ms of data. By default, only the clusters near the current
+ * position are kept in memory. With a cache, the most recently used clusters are kept until they add up to
+ * \p cache_size_bytes, which makes scrubbing back and forth in a recording much faster. The size is measured in
+ * recorded bytes, images returned in captures are not counted.
  *
  * \relates k4a_playback_t
  *
- * \remarks
- * k4a_playback_get_next_data_block() always returns the data block after the most recently returned data block for a
- * particular track.
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_cache_size(k4a_playback_t playback_handle, uint64_t cache_size_bytes);
+
+/** Set how many clusters of data are preloaded before and after the current playback position.
  *
- * \remarks
- * If a call was made to k4a_playback_get_previous_data_block() which returned ::K4A_STREAM_RESULT_EOF, then the
- * playback position is at the beginning of the recording and calling k4a_playback_get_next_data_block() with the same
- * track will return the first data block in the track.
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
  *
- * \remarks
- * The first call to k4a_playback_get_next_data_block() after k4a_playback_seek_timestamp() will return the data
- * block in the recording closest to the seek time with a timestamp greater than or equal to the seek time.
+ * \param cluster_count
+ * The number of clusters to preload in each direction. The default is 2.
  *
- * \remarks
- * k4a_playback_get_next_data_block() cannot be used with the built-in tracks: "COLOR", "DEPTH", etc...
- * k4a_playback_track_is_builtin() can be used to determine if a track is a built-in track.
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the read ahead depth was set.
  *
  * \remarks
- * If the call is successful, callers must call k4a_playback_data_block_release() to return the allocated memory for
- * data_block_handle.
+ * Clusters are loaded from disk on background threads while playback moves through the recording, ahead of the
+ * playback position in the direction it moves in. After a seek, the clusters on both sides of the new position start
+ * loading in the background. A deeper read ahead hides more disk latency at the cost of memory. Setting
+ * \p cluster_count to 0 loads each cluster when it is needed.
+ *
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -647,47 +804,1026 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_pl
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playback_t playback_handle,
-                                                                      const char *track_name,
-                                                                      k4a_playback_data_block_t *data_block_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_cluster_read_ahead(k4a_playback_t playback_handle,
+                                                                  uint32_t cluster_count);
 
-/** Read the previous data block for a particular track.
+/** Read the recording through a memory mapping of the file.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
- * \param track_name
- * The name of the track to read the previous data block from.
- *
- * \param data_block_handle
- * The location to write the data block.
+ * \param mapped_io
+ * If true, the recording is read through a read-only memory mapping. If false, the recording is read with regular file
+ * IO (Default).
  *
  * \returns
- * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
- * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ * ::K4A_RESULT_SUCCEEDED if the recording is read with the requested IO mode, or ::K4A_RESULT_FAILED if the file
+ * could not be opened or mapped.
+ *
+ * \remarks
+ * Mapped IO avoids a system call for every element read from the recording, which makes reading a whole recording
+ * bound by the disk speed.
+ *
+ * \remarks
+ * While mapped IO is enabled, images that need no conversion reference the data of the recording cluster they were
+ * read from instead of a copy of it. This applies to uncompressed color images read in their recorded format, and to
+ * depth and IR images of early recordings that stored them as YUY2. The cluster stays in memory until every image
+ * referencing it is released, and the contents of these images must not be modified. Depth and IR images recorded as
+ * big-endian grayscale or with RVL compression are always converted into a new buffer.
+ *
+ * \remarks
+ * Data blocks read while mapped IO is enabled reference their cluster in the same way, see
+ * k4a_playback_get_next_raw_block().
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_mapped_io(k4a_playback_t playback_handle, bool mapped_io);
+
+/** Write a sidecar index next to the recording, so that it opens and seeks faster the next time it is played back.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the index was written. ::K4A_RESULT_FAILED if the recording could not be read to the end,
+ * or the index file could not be written.
+ *
+ * \remarks
+ * The index lists the position and timestamp of every cluster of data in the recording, and of the previews of
+ * k4a_record_add_preview_track(). It is written to the recording path with ".k4aidx" appended, for example
+ * "output.mkv.k4aidx". Writing the index reads through the whole recording once.
+ *
+ * \remarks
+ * k4a_playback_open() uses the index if one exists for the recording, instead of the index stored in the recording.
+ * Seeking then uses a binary search, and recordings without an index of their own don't have to be read from start to
+ * end. An index written for a different version of the recording is ignored.
+ *
+ * \remarks
+ * Recordings can also write their index while they are recorded, see k4a_record_set_live_index(). Writing the index of
+ * an interrupted recording replaces its live index with a complete one.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_write_index(k4a_playback_t playback_handle);
+
+/** Reads an attachment file from a recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param file_name
+ * The attachment file name.
+ *
+ * \param data
+ * Location to write the attachment data. If a NULL buffer is specified, \p data_size will be set to the size of
+ * buffer needed to store the data.
+ *
+ * \param data_size
+ * On input, the size of the \p data buffer. On output, this is set to the length of the attachment data.
+ *
+ * \returns
+ * A return of ::K4A_BUFFER_RESULT_SUCCEEDED means that the \p data has been filled in. If the buffer is too small the
+ * function returns ::K4A_BUFFER_RESULT_TOO_SMALL and the needed size of the \p data buffer is returned in the
+ * \p data_size parameter. ::K4A_BUFFER_RESULT_FAILED is returned if the attachment \p file_name does not exist. All
+ * other failures return ::K4A_BUFFER_RESULT_FAILED.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_attachment(k4a_playback_t playback_handle,
+                                                                 const char *file_name,
+                                                                 uint8_t *data,
+                                                                 size_t *data_size);
+
+/** Read the next capture in the recording sequence.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
+ * this capture
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_next_capture() always returns the next capture in sequence after the most recently returned capture.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_next_capture() after k4a_playback_seek_timestamp() will return the capture
+ * in the recording closest to the seek time with an image timestamp greater than or equal to the seek time.
+ *
+ * \remarks
+ * If a call was made to k4a_playback_get_previous_capture() that returned ::K4A_STREAM_RESULT_EOF, the playback
+ * position is at the beginning of the stream and k4a_playback_get_next_capture() will return the first capture in the
+ * recording.
+ *
+ * \remarks
+ * Capture objects returned by the playback API will always contain at least one image, but may have images missing if
+ * frames were dropped in the original recording. When calling k4a_capture_get_color_image(),
+ * k4a_capture_get_depth_image(), or k4a_capture_get_ir_image(), the image should be checked for NULL.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_t playback_handle,
+                                                                   k4a_capture_t *capture_handle);
+
+/** Read the previous capture in the recording sequence.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done using
+ * this capture.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_previous_capture() always returns the previous capture in the sequence before the most
+ * recently returned capture.
+ *
+ * \remarks
+ * If a call was made to k4a_playback_get_next_capture() that returned ::K4A_STREAM_RESULT_EOF, the playback position
+ * is at the end of the stream and k4a_playback_get_previous_capture() will return the last capture in
+ * the recording.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_previous_capture() after k4a_playback_seek_timestamp() will return the
+ * capture in the recording closest to the seek time with all image timestamps less than the seek time.
+ *
+ * \remarks
+ * Capture objects returned by this API will always contain at least one image, but may have images missing if frames
+ * were dropped in the original recording. When calling k4a_capture_get_color_image(), k4a_capture_get_depth_image(), or
+ * k4a_capture_get_ir_image(), the image should be checked for NULL.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playback_t playback_handle,
+                                                                       k4a_capture_t *capture_handle);
+
+/** Read the next IMU sample in the recording sequence.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param imu_sample
+ * The location to write the IMU sample.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_next_imu_sample() always returns the IMU sample after the most recently returned sample.
+ *
+ * \remarks
+ * If a call was made to k4a_playback_get_previous_imu_sample() which returned ::K4A_STREAM_RESULT_EOF, then the
+ * playback position is at the beginning of the recording and k4a_playback_get_next_imu_sample() will return the first
+ * IMU sample in the recording.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_next_imu_sample() after k4a_playback_seek_timestamp() will return the IMU
+ * sample in the recording closest to the seek time with a timestamp greater than or equal to the seek time.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playback_t playback_handle,
+                                                                      k4a_imu_sample_t *imu_sample);
+
+/** Read the previous IMU sample in the recording sequence.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param imu_sample [OUT]
+ * The location to write the IMU sample.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_previous_imu_sample() always returns the IMU sample before the most recently returned sample.
+ *
+ * \remarks
+ * If a call was made to to k4a_playback_get_next_imu_sample() which returned ::K4A_STREAM_RESULT_EOF, then the playback
+ * position is at the end of the recording and k4a_playback_get_previous_imu_sample() will return the last IMU sample in
+ * the recording.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_previous_imu_sample() after k4a_playback_seek_timestamp() will return the
+ * IMU sample closest to the seek time with a timestamp less than the seek time.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback_handle,
+                                                                          k4a_imu_sample_t *imu_sample);
+
+/** Read the IMU samples in a time range.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param start_device_timestamp_usec
+ * The accelerometer device timestamp of the start of the range, inclusive.
+ *
+ * \param end_device_timestamp_usec
+ * The accelerometer device timestamp of the end of the range, exclusive.
+ *
+ * \param imu_samples
+ * Array of \p max_sample_count samples for the API to write the IMU samples to.
+ *
+ * \param max_sample_count
+ * The number of samples \p imu_samples can hold, at least 1.
+ *
+ * \param sample_count
+ * Location to write the number of samples written to \p imu_samples.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
+ *
+ * \relates k4a_playback_t
+ *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if all of the samples in the range were returned. ::K4A_BUFFER_RESULT_TOO_SMALL if
+ * \p imu_samples filled up first, in which case the samples that fit are returned. ::K4A_BUFFER_RESULT_FAILED if an
+ * error occurred.
+ *
+ * \remarks
+ * Samples are returned in timestamp order, and whole IMU blocks are decoded at once. The first call builds an index
+ * of the IMU blocks in the recording, which later calls use to go straight to the blocks of the range without reading
+ * through the blocks of the other tracks.
+ *
+ * \remarks
+ * When ::K4A_BUFFER_RESULT_TOO_SMALL is returned, samples that share the timestamp of the first sample that didn't fit
+ * are left out as well, so the remaining samples can be read by calling again with \p start_device_timestamp_usec set
+ * to one past the timestamp of the last returned sample.
+ *
+ * \remarks
+ * This function does not change the playback position used by k4a_playback_get_next_imu_sample() and the other
+ * reading functions. If the recording has no IMU track, no samples are returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_imu_samples(k4a_playback_t playback_handle,
+                                                                  uint64_t start_device_timestamp_usec,
+                                                                  uint64_t end_device_timestamp_usec,
+                                                                  k4a_imu_sample_t *imu_samples,
+                                                                  size_t max_sample_count,
+                                                                  size_t *sample_count);
+
+/** Read the next preview of the preview track of the recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param preview_handle [OUT]
+ * If successful this contains a handle to a capture holding the preview. Release it with k4a_capture_release().
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a preview is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The previews are written with k4a_record_add_preview_track(). The color image of a preview is a
+ * ::K4A_IMAGE_FORMAT_COLOR_MJPG image, and its depth image a ::K4A_IMAGE_FORMAT_CUSTOM8 image with 0 for invalid
+ * depth. A preview of a capture without a color or depth image has no image for it. Both images have the device
+ * timestamp of the preview.
+ *
+ * \remarks
+ * Only the preview track is read: the first call builds an index of the previews, and each preview is read on its own
+ * without loading the clusters of full resolution data around it. If the recording has a sidecar index written with
+ * k4a_record_set_live_index() or k4a_playback_write_index(), the index of the previews is read from it instead of the
+ * recording.
+ *
+ * \remarks
+ * k4a_playback_get_next_preview() returns the preview after the most recently returned preview, and the first call
+ * after k4a_playback_seek_timestamp() returns the first preview with a timestamp greater than or equal to the seek
+ * time. Reading previews doesn't change the position of the other reading functions. If the recording has no preview
+ * track, ::K4A_STREAM_RESULT_EOF is returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_preview(k4a_playback_t playback_handle,
+                                                                   k4a_capture_t *preview_handle);
+
+/** Read the previous preview of the preview track of the recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param preview_handle [OUT]
+ * If successful this contains a handle to a capture holding the preview. Release it with k4a_capture_release().
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a preview is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * Behaves like k4a_playback_get_next_preview() in the other direction. The first call after
+ * k4a_playback_seek_timestamp() returns the last preview with a timestamp less than the seek time.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_preview(k4a_playback_t playback_handle,
+                                                                       k4a_capture_t *preview_handle);
+
+/** Read the next data block for a particular track.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of the track to read the next data block from.
+ *
+ * \param data_block_handle
+ * The location to write the data block handle.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_next_data_block() always returns the data block after the most recently returned data block for a
+ * particular track.
+ *
+ * \remarks
+ * If a call was made to k4a_playback_get_previous_data_block() which returned ::K4A_STREAM_RESULT_EOF, then the
+ * playback position is at the beginning of the recording and calling k4a_playback_get_next_data_block() with the same
+ * track will return the first data block in the track.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_next_data_block() after k4a_playback_seek_timestamp() will return the data
+ * block in the recording closest to the seek time with a timestamp greater than or equal to the seek time.
+ *
+ * \remarks
+ * k4a_playback_get_next_data_block() cannot be used with the built-in tracks: "COLOR", "DEPTH", etc...
+ * k4a_playback_track_is_builtin() can be used to determine if a track is a built-in track.
+ *
+ * \remarks
+ * If the call is successful, callers must call k4a_playback_data_block_release() to return the allocated memory for
+ * data_block_handle.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playback_t playback_handle,
+                                                                      const char *track_name,
+                                                                      k4a_playback_data_block_t *data_block_handle);
+
+/** Read the previous data block for a particular track.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of the track to read the previous data block from.
+ *
+ * \param data_block_handle
+ * The location to write the data block.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * k4a_playback_get_previous_data_block() always returns the data block before the most recently returned data block for
+ * a particular track.
+ *
+ * \remarks
+ * If a call was made to to k4a_playback_get_next_data_block() which returned ::K4A_STREAM_RESULT_EOF, then the playback
+ * position is at the end of the recording and calling k4a_playback_get_previous_data_block() with the same track will
+ * return the last data block in the track.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_previous_data_block() after k4a_playback_seek_timestamp() will return the
+ * data block closest to the seek time with a timestamp less than the seek time.
+ *
+ * \remarks
+ * If the call is successful, callers must call k4a_playback_data_block_release() to return the allocated memory for
+ * data_block_handle.
+ *
+ * \remarks
+ * k4a_playback_get_previous_data_block() cannot be used with the built-in tracks: "COLOR", "DEPTH", etc...
+ * k4a_playback_track_is_builtin() can be used to determine if a track is a built-in track.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_playback_t playback_handle,
+                                                                          const char *track_name,
+                                                                          k4a_playback_data_block_t *data_block_handle);
+
+/** Read the next block of any track as it is stored in the recording, including the built-in tracks.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of the track, for example ::K4A_TRACK_NAME_COLOR.
+ *
+ * \param data_block_handle
+ * If successful this contains a handle to a data block object. Caller must call k4a_playback_data_block_release()
+ * when finished with this data block.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \remarks
+ * Behaves like k4a_playback_get_next_data_block(), and also reads the built-in tracks. No image is created and the
+ * data is not decoded or converted, so a ::K4A_IMAGE_FORMAT_COLOR_MJPG color block holds the compressed JPEG frame.
+ * The codec of the data is returned by k4a_playback_track_get_codec_id(). The depth and IR tracks are stored as
+ * big-endian 16-bit grayscale, or with RVL compression, and each IMU data block holds one sample.
+ *
+ * \remarks
+ * The data block timestamp is the device timestamp of the block. For images this is the timestamp of the image.
+ *
+ * \remarks
+ * Raw blocks of a built-in track are read from the same playback position as k4a_playback_get_next_capture() and
+ * k4a_playback_get_next_imu_sample(), so raw blocks and captures should not be read from the same handle at the same
+ * time. Use a cursor from k4a_playback_cursor_create() for the captures instead.
+ *
+ * \remarks
+ * While mapped IO is enabled, the data block references the recording cluster it was read from instead of a copy of
+ * the data, see k4a_playback_set_mapped_io(). The cluster stays in memory until the data block is released.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_raw_block(k4a_playback_t playback_handle,
+                                                                     const char *track_name,
+                                                                     k4a_playback_data_block_t *data_block_handle);
+
+/** Read the previous block of any track as it is stored in the recording, including the built-in tracks.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of the track, for example ::K4A_TRACK_NAME_COLOR.
+ *
+ * \param data_block_handle
+ * If successful this contains a handle to a data block object. Caller must call k4a_playback_data_block_release()
+ * when finished with this data block.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording
+ * is reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \remarks
+ * Behaves like k4a_playback_get_previous_data_block(), and also reads the built-in tracks. See
+ * k4a_playback_get_next_raw_block().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_raw_block(k4a_playback_t playback_handle,
+                                                                         const char *track_name,
+                                                                         k4a_playback_data_block_t *data_block_handle);
+
+/** Get the device timestamp of a data block in microseconds.
+ *
+ * \param data_block_handle
+ * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ *
+ * \returns
+ * Returns the device timestamp of the data block. If the \p data_block_handle is invalid this function will return 0.
+ * It is also possible for 0 to be a valid timestamp originating from when a device was first powered on.
+ *
+ * \relates k4a_playback_data_block_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint64_t
+k4a_playback_data_block_get_device_timestamp_usec(k4a_playback_data_block_t data_block_handle);
+
+/** Get the buffer size of a data block.
+ *
+ * \param data_block_handle
+ * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ *
+ * \returns
+ * Returns the buffer size of the data block, or 0 if the data block is invalid.
+ *
+ * \relates k4a_playback_data_block_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT size_t k4a_playback_data_block_get_buffer_size(k4a_playback_data_block_t data_block_handle);
+
+/** Get the buffer of a data block.
+ *
+ * \param data_block_handle
+ * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ *
+ * \remarks
+ * Use this buffer to access the data written to a custom recording track.
+ *
+ * \remarks
+ * While mapped IO is enabled, the buffer points into the recording cluster the block was read from, and its contents
+ * must not be modified. See k4a_playback_set_mapped_io().
+ *
+ * \returns
+ * Returns a pointer to the data block buffer, or NULL if the data block is invalid.
+ *
+ * \relates k4a_playback_data_block_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint8_t *k4a_playback_data_block_get_buffer(k4a_playback_data_block_t data_block_handle);
+
+/** Release a data block handle.
+ *
+ * \param data_block_handle
+ * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ *
+ * \remarks
+ * Release the memory of a data block. The caller must not access the object after it is released.
+ *
+ * \relates k4a_playback_data_block_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_playback_data_block_release(k4a_playback_data_block_t data_block_handle);
+
+/** Read the data blocks of a custom track in a time range into a single buffer.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of the custom track to read data from.
+ *
+ * \param start_device_timestamp_usec
+ * The device timestamp of the start of the range, inclusive.
+ *
+ * \param end_device_timestamp_usec
+ * The device timestamp of the end of the range, exclusive.
+ *
+ * \param blocks
+ * Array of \p max_block_count descriptors for the API to write the timestamp, offset and size of each block to.
+ *
+ * \param max_block_count
+ * The number of descriptors \p blocks can hold, at least 1.
+ *
+ * \param buffer
+ * Buffer of \p buffer_size bytes for the API to copy the data of the blocks to, one after the other.
+ *
+ * \param buffer_size
+ * The size of \p buffer in bytes.
+ *
+ * \param block_count
+ * Location to write the number of blocks written to \p blocks.
+ *
+ * \headerfile playback.h <k4arecord/playback.h>
  *
  * \relates k4a_playback_t
  *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if all of the blocks in the range were returned. ::K4A_BUFFER_RESULT_TOO_SMALL if
+ * \p blocks or \p buffer filled up first, in which case the blocks that fit are returned. ::K4A_BUFFER_RESULT_FAILED
+ * if an error occurred.
+ *
  * \remarks
- * k4a_playback_get_previous_data_block() always returns the data block before the most recently returned data block for
- * a particular track.
+ * Blocks are returned in timestamp order, with their data read directly from the cached clusters of the recording.
+ * Reading a high rate track this way avoids allocating and releasing a \ref k4a_playback_data_block_t per block.
  *
  * \remarks
- * If a call was made to to k4a_playback_get_next_data_block() which returned ::K4A_STREAM_RESULT_EOF, then the playback
- * position is at the end of the recording and calling k4a_playback_get_previous_data_block() with the same track will
- * return the last data block in the track.
+ * When ::K4A_BUFFER_RESULT_TOO_SMALL is returned, blocks that share the timestamp of the first block that didn't fit
+ * are left out as well, so the remaining blocks can be read by calling again with \p start_device_timestamp_usec set
+ * to one past the timestamp of the last returned block. If a single timestamp has more data than fits, no blocks are
+ * returned and larger buffers are needed.
+ *
+ * \remarks
+ * This function does not change the playback position used by k4a_playback_get_next_data_block() and the other reading
+ * functions.
+ *
+ * \remarks
+ * k4a_playback_get_data_blocks() cannot be used with the built-in tracks: "COLOR", "DEPTH", etc...
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_data_blocks(k4a_playback_t playback_handle,
+                                                                  const char *track_name,
+                                                                  uint64_t start_device_timestamp_usec,
+                                                                  uint64_t end_device_timestamp_usec,
+                                                                  k4a_playback_data_block_info_t *blocks,
+                                                                  size_t max_block_count,
+                                                                  uint8_t *buffer,
+                                                                  size_t buffer_size,
+                                                                  size_t *block_count);
+
+/** Seek to a specific timestamp within a recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param offset_usec
+ * The timestamp offset to seek to, relative to \p origin
+ *
+ * \param origin
+ * Specifies how the given timestamp should be interpreted. Seek can be done relative to the beginning or end of the
+ * recording, or using an absolute device timestamp.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the seek operation was successful, or ::K4A_RESULT_FAILED if an error occured. The current
+ * seek position is left unchanged if a failure is returned.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The first device timestamp in a recording is usually non-zero. The recording file starts at the device timestamp
+ * defined by start_timestamp_offset_usec, which is accessible via k4a_playback_get_record_configuration().
+ *
+ * \remarks
+ * The first call to k4a_playback_get_next_capture() after k4a_playback_seek_timestamp() will return the first capture
+ * containing an image timestamp greater than or equal to the seek time.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_previous_capture() after k4a_playback_seek_timestamp() will return the first
+ * capture with all image timestamps less than the seek time.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_next_imu_sample() after k4a_playback_seek_timestamp() will return the first imu
+ * sample with a timestamp greter than or equal to the seek time.
+ *
+ * \remarks
+ * The first call to k4a_playback_get_previous_imu_sample() after k4a_playback_seek_timestamp() will return the first
+ * imu sample with a timestamp less than the seek time.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_seek_timestamp(k4a_playback_t playback_handle,
+                                                          int64_t offset_usec,
+                                                          k4a_playback_seek_origin_t origin);
+
+/** Get the number of captures in a recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \returns
+ * The number of captures that k4a_playback_get_next_capture() returns when reading the whole recording, or 0 if an
+ * error occurred.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The first call to this function or to k4a_playback_seek_frame() builds an index of the recording's frames. This reads
+ * the block timestamps from every cluster in the file, but doesn't decode any images. Later calls use the index.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint64_t k4a_playback_get_frame_count(k4a_playback_t playback_handle);
+
+/** Seek to a capture by its index in the recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param frame_index
+ * The index of the capture to seek to, starting at 0. An index equal to k4a_playback_get_frame_count() seeks to the end
+ * of the recording.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the seek operation was successful, or ::K4A_RESULT_FAILED if an error occured or
+ * \p frame_index is past the end of the recording. The current seek position is left unchanged if a failure is
+ * returned.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The next call to k4a_playback_get_next_capture() returns capture \p frame_index, and the next call to
+ * k4a_playback_get_previous_capture() returns capture \p frame_index - 1. See k4a_playback_get_frame_count() for
+ * how frames are indexed.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_seek_frame(k4a_playback_t playback_handle, uint64_t frame_index);
+
+/** Get the seek offset at which a capture starts.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param frame_index
+ * The index of the capture, starting at 0.
+ *
+ * \param offset_usec
+ * Location to write the offset of the capture in microseconds, for use with k4a_playback_seek_timestamp() and
+ * ::K4A_PLAYBACK_SEEK_BEGIN.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the offset was written, or ::K4A_RESULT_FAILED if an error occured or \p frame_index is not
+ * smaller than k4a_playback_get_frame_count().
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * Seeking to this offset with k4a_playback_seek_timestamp() is equivalent to k4a_playback_seek_frame(). A reader that
+ * opens the same recording in several processes can build the frame index once, pass the offsets of all captures to
+ * the other processes, and seek by timestamp there without building the frame index again.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_get_frame_offset(k4a_playback_t playback_handle,
+                                                            uint64_t frame_index,
+                                                            uint64_t *offset_usec);
+
+/** Returns the length of the recording in microseconds.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \returns
+ * The recording length, calculated as the difference between the first and last timestamp in the file.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * The recording length may be longer than an individual track if, for example, the IMU continues to run after the last
+ * color image is recorded.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint64_t k4a_playback_get_recording_length_usec(k4a_playback_t playback_handle);
+
+/** Gets the last timestamp in a recording, relative to the start of the recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \returns
+ * The file timestamp of the last capture image or IMU sample in microseconds.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * This function returns a file timestamp, not an absolute device timestamp, meaning it is relative to the start of the
+ * recording. This function is equivalent to the length of the recording.
+ *
+ * \deprecated
+ * Deprecated starting in 1.2.0. Please use k4a_playback_get_recording_length_usec().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_DEPRECATED_EXPORT uint64_t k4a_playback_get_last_timestamp_usec(k4a_playback_t playback_handle);
+
+/** Create a cursor that reads a recording independently of the playback handle and of other cursors.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param cursor_handle
+ * If successful, this contains a pointer to the cursor handle. Caller must call
+ * k4a_playback_cursor_destroy() when finished with the cursor.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the cursor was created, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * A cursor shares the parsed recording, the cluster index and the cluster cache of \p playback_handle, so creating
+ * one doesn't read the recording again. Each cursor has its own read position, which starts at the beginning of the
+ * recording.
+ *
+ * \remarks
+ * Different cursors, and the playback handle itself, can be read from different threads at the same time. A single
+ * cursor must only be used by one thread at a time. The color conversion, cache and IO settings of \p playback_handle
+ * apply to every cursor, and must not be changed while cursors are being read. Color images are not converted ahead
+ * of cursors, see k4a_playback_set_color_read_ahead().
+ *
+ * \remarks
+ * All cursors must be destroyed before \p playback_handle is closed.
+ *
+ * \relates k4a_playback_cursor_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_cursor_create(k4a_playback_t playback_handle,
+                                                         k4a_playback_cursor_t *cursor_handle);
+
+/** Read the next capture at the position of a cursor.
+ *
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its
+ * done using this capture.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \remarks
+ * Behaves like k4a_playback_get_next_capture(), using the read position of \p cursor_handle.
+ *
+ * \relates k4a_playback_cursor_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_cursor_get_next_capture(k4a_playback_cursor_t cursor_handle,
+                                                                          k4a_capture_t *capture_handle);
+
+/** Read the previous capture at the position of a cursor.
+ *
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
  *
- * \remarks
- * The first call to k4a_playback_get_previous_data_block() after k4a_playback_seek_timestamp() will return the
- * data block closest to the seek time with a timestamp less than the seek time.
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its
+ * done using this capture.
  *
- * \remarks
- * If the call is successful, callers must call k4a_playback_data_block_release() to return the allocated memory for
- * data_block_handle.
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
  *
  * \remarks
- * k4a_playback_get_previous_data_block() cannot be used with the built-in tracks: "COLOR", "DEPTH", etc...
- * k4a_playback_track_is_builtin() can be used to determine if a track is a built-in track.
+ * Behaves like k4a_playback_get_previous_capture(), using the read position of \p cursor_handle.
+ *
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -697,20 +1833,25 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playba
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_playback_t playback_handle,
-                                                                          const char *track_name,
-                                                                          k4a_playback_data_block_t *data_block_handle);
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_cursor_get_previous_capture(k4a_playback_cursor_t cursor_handle,
+                                                                              k4a_capture_t *capture_handle);
 
-/** Get the device timestamp of a data block in microseconds.
+/** Read the next IMU sample at the position of a cursor.
  *
- * \param data_block_handle
- * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \param imu_sample
+ * The location to write the IMU sample.
  *
  * \returns
- * Returns the device timestamp of the data block. If the \p data_block_handle is invalid this function will return 0.
- * It is also possible for 0 to be a valid timestamp originating from when a device was first powered on.
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
  *
- * \relates k4a_playback_data_block_t
+ * \remarks
+ * Behaves like k4a_playback_get_next_imu_sample(), using the read position of \p cursor_handle.
+ *
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -720,18 +1861,25 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_pl
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT uint64_t
-k4a_playback_data_block_get_device_timestamp_usec(k4a_playback_data_block_t data_block_handle);
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_cursor_get_next_imu_sample(k4a_playback_cursor_t cursor_handle,
+                                                                             k4a_imu_sample_t *imu_sample);
 
-/** Get the buffer size of a data block.
+/** Read the previous IMU sample at the position of a cursor.
  *
- * \param data_block_handle
- * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \param imu_sample
+ * The location to write the IMU sample.
  *
  * \returns
- * Returns the buffer size of the data block, or 0 if the data block is invalid.
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a sample is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
  *
- * \relates k4a_playback_data_block_t
+ * \remarks
+ * Behaves like k4a_playback_get_previous_imu_sample(), using the read position of \p cursor_handle.
+ *
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -741,20 +1889,29 @@ k4a_playback_data_block_get_device_timestamp_usec(k4a_playback_data_block_t data
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT size_t k4a_playback_data_block_get_buffer_size(k4a_playback_data_block_t data_block_handle);
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_cursor_get_previous_imu_sample(k4a_playback_cursor_t cursor_handle,
+                                                                                 k4a_imu_sample_t *imu_sample);
 
-/** Get the buffer of a data block.
+/** Read the next data block of a custom track at the position of a cursor.
  *
- * \param data_block_handle
- * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
  *
- * \remarks
- * Use this buffer to access the data written to a custom recording track.
+ * \param track_name
+ * The name of the track to read the next data block from.
+ *
+ * \param data_block_handle
+ * The location to write the data block handle. Caller must call k4a_playback_data_block_release() when
+ * done using the data block.
  *
  * \returns
- * Returns a pointer to the data block buffer, or NULL if the data block is invalid.
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the end of the recording is
+ * reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
  *
- * \relates k4a_playback_data_block_t
+ * \remarks
+ * Behaves like k4a_playback_get_next_data_block(), using the read position of \p cursor_handle.
+ *
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -764,17 +1921,31 @@ K4ARECORD_EXPORT size_t k4a_playback_data_block_get_buffer_size(k4a_playback_dat
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT uint8_t *k4a_playback_data_block_get_buffer(k4a_playback_data_block_t data_block_handle);
+K4ARECORD_EXPORT k4a_stream_result_t
+k4a_playback_cursor_get_next_data_block(k4a_playback_cursor_t cursor_handle,
+                                        const char *track_name,
+                                        k4a_playback_data_block_t *data_block_handle);
 
-/** Release a data block handle.
+/** Read the previous data block of a custom track at the position of a cursor.
+ *
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \param track_name
+ * The name of the track to read the previous data block from.
  *
  * \param data_block_handle
- * Handle obtained by k4a_playback_get_next_data_block() or k4a_playback_get_previous_data_block().
+ * The location to write the data block handle. Caller must call k4a_playback_data_block_release() when
+ * done using the data block.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a data block is returned, or ::K4A_STREAM_RESULT_EOF if the start of the recording
+ * is reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
  *
  * \remarks
- * Release the memory of a data block. The caller must not access the object after it is released.
+ * Behaves like k4a_playback_get_previous_data_block(), using the read position of \p cursor_handle.
  *
- * \relates k4a_playback_data_block_t
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -784,12 +1955,15 @@ K4ARECORD_EXPORT uint8_t *k4a_playback_data_block_get_buffer(k4a_playback_data_b
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT void k4a_playback_data_block_release(k4a_playback_data_block_t data_block_handle);
+K4ARECORD_EXPORT k4a_stream_result_t
+k4a_playback_cursor_get_previous_data_block(k4a_playback_cursor_t cursor_handle,
+                                            const char *track_name,
+                                            k4a_playback_data_block_t *data_block_handle);
 
-/** Seek to a specific timestamp within a recording.
+/** Seek a cursor to a specific timestamp within a recording.
  *
- * \param playback_handle
- * Handle obtained by k4a_playback_open().
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
  *
  * \param offset_usec
  * The timestamp offset to seek to, relative to \p origin
@@ -802,27 +1976,40 @@ K4ARECORD_EXPORT void k4a_playback_data_block_release(k4a_playback_data_block_t
  * ::K4A_RESULT_SUCCEEDED if the seek operation was successful, or ::K4A_RESULT_FAILED if an error occured. The current
  * seek position is left unchanged if a failure is returned.
  *
- * \relates k4a_playback_t
- *
  * \remarks
- * The first device timestamp in a recording is usually non-zero. The recording file starts at the device timestamp
- * defined by start_timestamp_offset_usec, which is accessible via k4a_playback_get_record_configuration().
+ * Behaves like k4a_playback_seek_timestamp(), the position of the playback handle and of other cursors is not
+ * changed.
  *
- * \remarks
- * The first call to k4a_playback_get_next_capture() after k4a_playback_seek_timestamp() will return the first capture
- * containing an image timestamp greater than or equal to the seek time.
+ * \relates k4a_playback_cursor_t
  *
- * \remarks
- * The first call to k4a_playback_get_previous_capture() after k4a_playback_seek_timestamp() will return the first
- * capture with all image timestamps less than the seek time.
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_cursor_seek_timestamp(k4a_playback_cursor_t cursor_handle,
+                                                                 int64_t offset_usec,
+                                                                 k4a_playback_seek_origin_t origin);
+
+/** Seek a cursor to a capture by its index in the recording.
  *
- * \remarks
- * The first call to k4a_playback_get_next_imu_sample() after k4a_playback_seek_timestamp() will return the first imu
- * sample with a timestamp greter than or equal to the seek time.
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \param frame_index
+ * The index of the capture to seek to, starting at 0.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the seek operation was successful, or ::K4A_RESULT_FAILED if an error occured. The current
+ * seek position is left unchanged if a failure is returned.
  *
  * \remarks
- * The first call to k4a_playback_get_previous_imu_sample() after k4a_playback_seek_timestamp() will return the first
- * imu sample with a timestamp less than the seek time.
+ * Behaves like k4a_playback_seek_frame(), the position of the playback handle and of other cursors is not changed.
+ *
+ * \relates k4a_playback_cursor_t
  *
  * \xmlonly
  * <requirements>
@@ -832,23 +2019,69 @@ K4ARECORD_EXPORT void k4a_playback_data_block_release(k4a_playback_data_block_t
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_result_t k4a_playback_seek_timestamp(k4a_playback_t playback_handle,
-                                                          int64_t offset_usec,
-                                                          k4a_playback_seek_origin_t origin);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_cursor_seek_frame(k4a_playback_cursor_t cursor_handle, uint64_t frame_index);
 
-/** Returns the length of the recording in microseconds.
+/** Destroys a playback cursor.
+ *
+ * \param cursor_handle
+ * Handle obtained by k4a_playback_cursor_create().
+ *
+ * \relates k4a_playback_cursor_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_playback_cursor_destroy(k4a_playback_cursor_t cursor_handle);
+
+/** Read every capture in a time range of a recording, using several worker threads.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
+ * \param start_usec
+ * The start of the range, relative to the beginning of the recording. Captures with an image timestamp at or after
+ * this time are read.
+ *
+ * \param end_usec
+ * The end of the range, relative to the beginning of the recording. Captures starting at or after this time are not
+ * read. Use k4a_playback_get_recording_length_usec() + 1 to read until the end of the recording.
+ *
+ * \param worker_count
+ * The number of threads that read and decode the range. Must be at least 1.
+ *
+ * \param in_order
+ * If true, \p callback is called for each capture in timestamp order. If false, captures are passed to \p callback as
+ * soon as they are decoded, in no particular order.
+ *
+ * \param callback
+ * Called once for each capture in the range.
+ *
+ * \param callback_context
+ * Passed to \p callback.
+ *
  * \returns
- * The recording length, calculated as the difference between the first and last timestamp in the file.
+ * ::K4A_RESULT_SUCCEEDED if every capture in the range was read, or ::K4A_RESULT_FAILED if reading failed or
+ * \p callback returned ::K4A_RESULT_FAILED.
  *
- * \relates k4a_playback_t
+ * \remarks
+ * The range is split into chunks at the cluster boundaries of the recording, and each worker reads whole chunks with
+ * its own cursor, see k4a_playback_cursor_create(). Every capture that k4a_playback_get_next_capture() would return
+ * in the range is passed to \p callback exactly once.
  *
  * \remarks
- * The recording length may be longer than an individual track if, for example, the IMU continues to run after the last
- * color image is recorded.
+ * If \p in_order is false, \p callback is called from the worker threads and may be called concurrently. If
+ * \p in_order is true, \p callback is called from the calling thread one capture at a time, and workers read at most
+ * a few chunks ahead of it.
+ *
+ * \remarks
+ * The read position of the playback handle is not changed. This function returns once all workers have stopped.
+ *
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -858,24 +2091,47 @@ K4ARECORD_EXPORT k4a_result_t k4a_playback_seek_timestamp(k4a_playback_t playbac
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT uint64_t k4a_playback_get_recording_length_usec(k4a_playback_t playback_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_process_range(k4a_playback_t playback_handle,
+                                                         uint64_t start_usec,
+                                                         uint64_t end_usec,
+                                                         uint32_t worker_count,
+                                                         bool in_order,
+                                                         k4a_playback_capture_cb_t *callback,
+                                                         void *callback_context);
 
-/** Gets the last timestamp in a recording, relative to the start of the recording.
+/** Writes a range of a recording to a new recording file, without decoding it.
  *
  * \param playback_handle
  * Handle obtained by k4a_playback_open().
  *
+ * \param path
+ * Path of the new recording. An existing file is replaced. Must not be the path of the recording being played back.
+ *
+ * \param start_usec
+ * The start of the range, relative to the beginning of the recording.
+ *
+ * \param end_usec
+ * The end of the range, relative to the beginning of the recording. Use k4a_playback_get_recording_length_usec() to
+ * write until the end of the recording.
+ *
  * \returns
- * The file timestamp of the last capture image or IMU sample in microseconds.
+ * ::K4A_RESULT_SUCCEEDED if the range was written, or ::K4A_RESULT_FAILED if the range starts after the end of the
+ * recording, or the recording could not be read or the new file could not be written.
  *
- * \relates k4a_playback_t
+ * \remarks
+ * Recordings store their data in clusters of up to 32ms of data each. The clusters of the range are copied to the new
+ * file as they are stored, so writing a range of a recording is limited by the speed of the disk rather than by
+ * decoding and encoding the images. The new file starts with the cluster containing \p start_usec and ends with the
+ * last cluster starting at or before \p end_usec, so it can hold a few milliseconds of data on each side of the range.
+ * If the color track was written with k4a_record_set_color_encoder(), the new file starts at the key frame before the
+ * range instead.
  *
  * \remarks
- * This function returns a file timestamp, not an absolute device timestamp, meaning it is relative to the start of the
- * recording. This function is equivalent to the length of the recording.
+ * The tracks, attachments and tags of the recording are copied to the new file, and the data in it keeps its device
+ * timestamps. The start_timestamp_offset_usec of its ::k4a_record_configuration_t is the offset of the first copied
+ * cluster.
  *
- * \deprecated
- * Deprecated starting in 1.2.0. Please use k4a_playback_get_recording_length_usec().
+ * \relates k4a_playback_t
  *
  * \xmlonly
  * <requirements>
@@ -885,7 +2141,10 @@ K4ARECORD_EXPORT uint64_t k4a_playback_get_recording_length_usec(k4a_playback_t
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_DEPRECATED_EXPORT uint64_t k4a_playback_get_last_timestamp_usec(k4a_playback_t playback_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_playback_write_range(k4a_playback_t playback_handle,
+                                                       const char *path,
+                                                       uint64_t start_usec,
+                                                       uint64_t end_usec);
 
 /** Closes a recording playback handle.
  *
@@ -906,6 +2165,192 @@ K4ARECORD_DEPRECATED_EXPORT uint64_t k4a_playback_get_last_timestamp_usec(k4a_pl
  */
 K4ARECORD_EXPORT void k4a_playback_close(k4a_playback_t playback_handle);
 
+/** Opens the recordings of a synchronized multi-device rig to play them back together.
+ *
+ * \param paths
+ * The file paths of the recordings, typically one master and its subordinates.
+ *
+ * \param path_count
+ * The number of paths in \p paths. Must be at least 1.
+ *
+ * \param group_handle
+ * If successful, this contains a pointer to the group handle. Caller must call k4a_playback_group_close() when
+ * finished with the recordings.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if every recording was opened, or ::K4A_RESULT_FAILED if one of them could not be opened, or
+ * more than one of them was recorded as the master of the rig.
+ *
+ * \remarks
+ * The recordings are opened at the same time on separate threads, and each of them keeps reading the next capture in
+ * the background while the previous group of captures is processed, see k4a_playback_group_get_next_captures().
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_group_open(const char **paths,
+                                                      size_t path_count,
+                                                      k4a_playback_group_t *group_handle);
+
+/** Opens every device of a recording of several devices as a playback group.
+ *
+ * \param path
+ * Filesystem path of a recording written with k4a_record_add_device().
+ *
+ * \param group_handle
+ * If successful, this contains a pointer to the group handle. Caller must call k4a_playback_group_close() when
+ * finished with the recording.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if every device was opened, or ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * The group has one member per device, in the order of the device indices, each opened with
+ * k4a_playback_open_device(). The captures of the devices are matched as with k4a_playback_group_open(). The members
+ * read the same file, so the data of the devices that were recorded together is read from the disk once and then
+ * found in the file cache.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_group_open_devices(const char *path, k4a_playback_group_t *group_handle);
+
+/** Gets the playback handle of one recording of a group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \param index
+ * The index of the recording in the paths passed to k4a_playback_group_open(), or the index of the device for
+ * k4a_playback_group_open_devices().
+ *
+ * \returns
+ * The playback handle of the recording, or NULL if \p index is out of range.
+ *
+ * \remarks
+ * The handle can be used to read the calibration, configuration, tags and attachments of the recording, and to change
+ * its color conversion and read ahead settings before the first captures are read. It is owned by the group, and must
+ * not be closed, seeked or read from.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_playback_t k4a_playback_group_get_playback(k4a_playback_group_t group_handle, size_t index);
+
+/** Reads the next captures of a group that were taken at the same time.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \param capture_handles
+ * An array with an entry for each recording of the group, in the order of the paths passed to
+ * k4a_playback_group_open(). If successful, each entry contains the capture of its recording, or NULL if the
+ * recording has no capture at this time. Caller must call k4a_capture_release() on each capture that is returned.
+ *
+ * \param capture_count
+ * The number of entries in \p capture_handles. Must be the number of recordings in the group.
+ *
+ * \param sync_timestamp_usec
+ * If not NULL, this is set to the timestamp of the returned captures in the device time of the master.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if at least one capture is returned, or ::K4A_STREAM_RESULT_EOF if the end of every
+ * recording is reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \remarks
+ * The devices of a synchronized rig share a device time base, so the captures of the recordings are matched by device
+ * timestamp. The depth_delay_off_color_usec of each recording and the subordinate_delay_off_master_usec of each
+ * subordinate are taken out first, so a capture matches the master capture that triggered it. Captures are matched if
+ * they are less than half a frame period apart. Each call returns the earliest captures that were not returned yet.
+ *
+ * \remarks
+ * After the captures are returned, the next capture of each recording that was read is already being read in the
+ * background.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_group_get_next_captures(k4a_playback_group_t group_handle,
+                                                                         k4a_capture_t *capture_handles,
+                                                                         size_t capture_count,
+                                                                         uint64_t *sync_timestamp_usec);
+
+/** Seeks every recording of a group to a timestamp.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \param sync_timestamp_usec
+ * The timestamp to seek to, in the device time of the master, as returned by k4a_playback_group_get_next_captures().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if every recording was seeked, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * The next call to k4a_playback_group_get_next_captures() returns the first captures at or after
+ * \p sync_timestamp_usec.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_group_seek_timestamp(k4a_playback_group_t group_handle,
+                                                                uint64_t sync_timestamp_usec);
+
+/** Closes the recordings of a group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \remarks
+ * Waits for the background reads of the group to finish, and closes the playback handle of every recording.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_playback_group_close(k4a_playback_group_t group_handle);
+
 /**
  * @}
  */
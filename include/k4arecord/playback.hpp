@@ -12,6 +12,9 @@
 
 #include <algorithm>
 #include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -118,6 +121,251 @@ private:
     k4a_playback_data_block_t m_handle;
 };
 
+/** \class playback_cursor playback.hpp <k4arecord/playback.hpp>
+ * Wrapper for \ref k4a_playback_cursor_t
+ *
+ * Wraps a handle for an independent read position in a recording. The playback object the cursor was created from must
+ * stay open while the cursor is used.
+ *
+ * \sa k4a_playback_cursor_t
+ */
+class playback_cursor
+{
+public:
+    /** Creates a k4a::playback_cursor from a k4a_playback_cursor_t
+     * Takes ownership of the handle, you should not call k4a_playback_cursor_destroy on the handle after giving it to
+     * the playback_cursor; the playback_cursor will take care of that.
+     */
+    playback_cursor(k4a_playback_cursor_t handle = nullptr) noexcept : m_handle(handle) {}
+
+    // No Copies allowed
+    playback_cursor(const playback_cursor &) = delete;
+    playback_cursor &operator=(const playback_cursor &) = delete;
+
+    /** Moves another playback_cursor into a new playback_cursor
+     */
+    playback_cursor(playback_cursor &&other) noexcept : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+
+    ~playback_cursor()
+    {
+        reset();
+    }
+
+    /** Moves another playback_cursor into this playback_cursor; other is set to invalid
+     */
+    playback_cursor &operator=(playback_cursor &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+
+    /** Returns true if the playback_cursor is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return is_valid();
+    }
+
+    /** Returns true if the playback_cursor is valid, false otherwise
+     */
+    bool is_valid() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Destroys the underlying k4a_playback_cursor_t; the playback_cursor is set to invalid.
+     */
+    void reset() noexcept
+    {
+        if (m_handle)
+        {
+            k4a_playback_cursor_destroy(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /** Get the next capture at the position of the cursor.
+     * Returns true if a capture was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_next_capture
+     */
+    bool get_next_capture(capture *cap)
+    {
+        k4a_capture_t capture_handle;
+        k4a_stream_result_t result = k4a_playback_cursor_get_next_capture(m_handle, &capture_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *cap = capture(capture_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next capture!");
+    }
+
+    /** Get the previous capture at the position of the cursor.
+     * Returns true if a capture was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_previous_capture
+     */
+    bool get_previous_capture(capture *cap)
+    {
+        k4a_capture_t capture_handle;
+        k4a_stream_result_t result = k4a_playback_cursor_get_previous_capture(m_handle, &capture_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *cap = capture(capture_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get previous capture!");
+    }
+
+    /** Get the next IMU sample at the position of the cursor.
+     * Returns true if a sample was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_next_imu_sample
+     */
+    bool get_next_imu_sample(k4a_imu_sample_t *sample)
+    {
+        k4a_stream_result_t result = k4a_playback_cursor_get_next_imu_sample(m_handle, sample);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next IMU sample!");
+    }
+
+    /** Get the previous IMU sample at the position of the cursor.
+     * Returns true if a sample was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_previous_imu_sample
+     */
+    bool get_previous_imu_sample(k4a_imu_sample_t *sample)
+    {
+        k4a_stream_result_t result = k4a_playback_cursor_get_previous_imu_sample(m_handle, sample);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get previous IMU sample!");
+    }
+
+    /** Get the next data block at the position of the cursor.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_next_data_block
+     */
+    bool get_next_data_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_cursor_get_next_data_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next data block!");
+    }
+
+    /** Get the previous data block at the position of the cursor.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_get_previous_data_block
+     */
+    bool get_previous_data_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_cursor_get_previous_data_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get previous data block!");
+    }
+
+    /** Seeks the cursor to a specific time point in the recording
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_seek_timestamp
+     */
+    void seek_timestamp(std::chrono::microseconds offset, k4a_playback_seek_origin_t origin)
+    {
+        k4a_result_t result = k4a_playback_cursor_seek_timestamp(m_handle, offset.count(), origin);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to seek cursor!");
+        }
+    }
+
+    /** Seeks the cursor to a capture by its index in the recording
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_seek_frame
+     */
+    void seek_frame(uint64_t frame_index)
+    {
+        k4a_result_t result = k4a_playback_cursor_seek_frame(m_handle, frame_index);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to seek cursor!");
+        }
+    }
+
+private:
+    k4a_playback_cursor_t m_handle;
+};
+
 /** \class playback playback.hpp <k4arecord/playback.hpp>
  * Wrapper for \ref k4a_playback_t
  *
@@ -252,6 +500,15 @@ public:
         return config;
     }
 
+    /** Gets the number of devices recorded in the file
+     *
+     * \sa k4a_playback_get_device_count
+     */
+    uint32_t get_device_count() const noexcept
+    {
+        return k4a_playback_get_device_count(m_handle);
+    }
+
     /** Get the next capture in the recording.
      * Returns true if a capture was available, false if there are none left.
      * Throws error on failure.
@@ -378,61 +635,44 @@ public:
         throw error("Failed to get previous IMU sample!");
     }
 
-    /** Seeks to a specific time point in the recording
+    /** Get the next preview in the recording.
+     * Returns true if a preview was available, false if there are none left.
      * Throws error on failure.
      *
-     * \sa k4a_playback_seek_timestamp
+     * \sa k4a_playback_get_next_preview
      */
-    void seek_timestamp(std::chrono::microseconds offset, k4a_playback_seek_origin_t origin)
+    bool get_next_preview(capture *preview)
     {
-        k4a_result_t result = k4a_playback_seek_timestamp(m_handle, offset.count(), origin);
+        k4a_capture_t capture_handle;
+        k4a_stream_result_t result = k4a_playback_get_next_preview(m_handle, &capture_handle);
 
-        if (K4A_RESULT_SUCCEEDED != result)
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
         {
-            throw error("Failed to seek recording!");
+            *preview = capture(capture_handle);
+            return true;
         }
-    }
-
-    /** Get the last valid timestamp in the recording
-     *
-     * \sa k4a_playback_get_recording_length_usec
-     */
-    std::chrono::microseconds get_recording_length() const noexcept
-    {
-        return std::chrono::microseconds(k4a_playback_get_recording_length_usec(m_handle));
-    }
-
-    /** Set the image format that color captures will be converted to. By default the conversion format will be the
-     * same as the image format stored in the recording file, and no conversion will occur.
-     *
-     * Throws error on failure.
-     *
-     * \sa k4a_playback_set_color_conversion
-     */
-    void set_color_conversion(k4a_image_format_t format)
-    {
-        k4a_result_t result = k4a_playback_set_color_conversion(m_handle, format);
-
-        if (K4A_RESULT_SUCCEEDED != result)
+        else if (K4A_STREAM_RESULT_EOF == result)
         {
-            throw error("Failed to set color conversion!");
+            return false;
         }
+
+        throw error("Failed to get next preview!");
     }
 
-    /** Get the next data block in the recording.
-     * Returns true if a block was available, false if there are none left.
+    /** Get the previous preview in the recording.
+     * Returns true if a preview was available, false if there are none left.
      * Throws error on failure.
      *
-     * \sa k4a_playback_get_next_data_block
+     * \sa k4a_playback_get_previous_preview
      */
-    bool get_next_data_block(const char *track, data_block *block)
+    bool get_previous_preview(capture *preview)
     {
-        k4a_playback_data_block_t block_handle;
-        k4a_stream_result_t result = k4a_playback_get_next_data_block(m_handle, track, &block_handle);
+        k4a_capture_t capture_handle;
+        k4a_stream_result_t result = k4a_playback_get_previous_preview(m_handle, &capture_handle);
 
         if (K4A_STREAM_RESULT_SUCCEEDED == result)
         {
-            *block = data_block(block_handle);
+            *preview = capture(capture_handle);
             return true;
         }
         else if (K4A_STREAM_RESULT_EOF == result)
@@ -440,26 +680,314 @@ public:
             return false;
         }
 
-        throw error("Failed to get next data block!");
+        throw error("Failed to get previous preview!");
     }
 
-    /** Get the previous data block from the recording.
-     * Returns true if a block was available, false if there are none left.
+    /** Read the IMU samples in a time range.
+     * Returns true if all of the samples in the range were read, false if the array filled up first.
      * Throws error on failure.
      *
-     * \sa k4a_playback_get_previous_data_block
+     * \sa k4a_playback_get_imu_samples
      */
-    bool get_previous_data_block(const char *track, data_block *block)
+    bool get_imu_samples(std::chrono::microseconds start_timestamp,
+                         std::chrono::microseconds end_timestamp,
+                         k4a_imu_sample_t *samples,
+                         size_t max_sample_count,
+                         size_t *sample_count)
     {
-        k4a_playback_data_block_t block_handle;
-        k4a_stream_result_t result = k4a_playback_get_previous_data_block(m_handle, track, &block_handle);
-
-        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        k4a_buffer_result_t result =
+            k4a_playback_get_imu_samples(m_handle,
+                                         internal::clamp_cast<uint64_t>(start_timestamp.count()),
+                                         internal::clamp_cast<uint64_t>(end_timestamp.count()),
+                                         samples,
+                                         max_sample_count,
+                                         sample_count);
+
+        if (K4A_BUFFER_RESULT_SUCCEEDED == result)
         {
-            *block = data_block(block_handle);
             return true;
         }
-        else if (K4A_STREAM_RESULT_EOF == result)
+        else if (K4A_BUFFER_RESULT_TOO_SMALL == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get IMU samples!");
+    }
+
+    /** Seeks to a specific time point in the recording
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_seek_timestamp
+     */
+    void seek_timestamp(std::chrono::microseconds offset, k4a_playback_seek_origin_t origin)
+    {
+        k4a_result_t result = k4a_playback_seek_timestamp(m_handle, offset.count(), origin);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to seek recording!");
+        }
+    }
+
+    /** Seeks to a capture by its index in the recording
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_seek_frame
+     */
+    void seek_frame(uint64_t frame_index)
+    {
+        k4a_result_t result = k4a_playback_seek_frame(m_handle, frame_index);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to seek recording!");
+        }
+    }
+
+    /** Get the number of captures in the recording
+     *
+     * \sa k4a_playback_get_frame_count
+     */
+    uint64_t get_frame_count() const noexcept
+    {
+        return k4a_playback_get_frame_count(m_handle);
+    }
+
+    /** Get the seek offset at which a capture starts
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_frame_offset
+     */
+    std::chrono::microseconds get_frame_offset(uint64_t frame_index) const
+    {
+        uint64_t offset_usec = 0;
+        k4a_result_t result = k4a_playback_get_frame_offset(m_handle, frame_index, &offset_usec);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to get frame offset!");
+        }
+
+        return std::chrono::microseconds(offset_usec);
+    }
+
+    /** Get the last valid timestamp in the recording
+     *
+     * \sa k4a_playback_get_recording_length_usec
+     */
+    std::chrono::microseconds get_recording_length() const noexcept
+    {
+        return std::chrono::microseconds(k4a_playback_get_recording_length_usec(m_handle));
+    }
+
+    /** Set the image format that color captures will be converted to. By default the conversion format will be the
+     * same as the image format stored in the recording file, and no conversion will occur.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_color_conversion
+     */
+    void set_color_conversion(k4a_image_format_t format)
+    {
+        k4a_result_t result = k4a_playback_set_color_conversion(m_handle, format);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set color conversion!");
+        }
+    }
+
+    /** Set the scale MJPG color images are decoded to when they are converted to another format.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_color_scale
+     */
+    void set_color_scale(k4a_color_scale_t scale)
+    {
+        k4a_result_t result = k4a_playback_set_color_scale(m_handle, scale);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set color scale!");
+        }
+    }
+
+    /** Decode a color image read from the recording into an image provided by the application.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_decode_color_image
+     */
+    void decode_color_image(const image &color_image, const image &target_image)
+    {
+        k4a_result_t result = k4a_playback_decode_color_image(m_handle, color_image.handle(), target_image.handle());
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to decode color image!");
+        }
+    }
+
+    /** Convert the color images of the next captures in the background.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_color_read_ahead
+     */
+    void set_color_read_ahead(uint32_t capture_count)
+    {
+        k4a_result_t result = k4a_playback_set_color_read_ahead(m_handle, capture_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set color read ahead!");
+        }
+    }
+
+    /** Set the video decoder for a color track written with an application encoder.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_color_decoder
+     */
+    void set_color_decoder(k4a_playback_color_decode_cb_t *decode_cb, void *callback_context)
+    {
+        k4a_result_t result = k4a_playback_set_color_decoder(m_handle, decode_cb, callback_context);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set color decoder!");
+        }
+    }
+
+    /** Choose which image tracks are read into captures. An empty list reads every image track.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_enabled_tracks
+     */
+    void set_enabled_tracks(const std::vector<std::string> &track_names)
+    {
+        std::vector<const char *> names;
+        for (const std::string &name : track_names)
+        {
+            names.push_back(name.c_str());
+        }
+        k4a_result_t result = k4a_playback_set_enabled_tracks(m_handle, names.data(), names.size());
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set enabled tracks!");
+        }
+    }
+
+    /** Keep recently used data in memory, up to cache_size_bytes.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_cache_size
+     */
+    void set_cache_size(uint64_t cache_size_bytes)
+    {
+        k4a_result_t result = k4a_playback_set_cache_size(m_handle, cache_size_bytes);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set cache size!");
+        }
+    }
+
+    /** Set how many clusters of data are preloaded before and after the current playback position.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_cluster_read_ahead
+     */
+    void set_cluster_read_ahead(uint32_t cluster_count)
+    {
+        k4a_result_t result = k4a_playback_set_cluster_read_ahead(m_handle, cluster_count);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set cluster read ahead!");
+        }
+    }
+
+    /** Read the recording through a memory mapping of the file.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_mapped_io
+     */
+    void set_mapped_io(bool mapped_io)
+    {
+        k4a_result_t result = k4a_playback_set_mapped_io(m_handle, mapped_io);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set mapped IO!");
+        }
+    }
+
+    /** Write a sidecar index next to the recording, so that it opens and seeks faster the next time.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_write_index
+     */
+    void write_index()
+    {
+        k4a_result_t result = k4a_playback_write_index(m_handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to write recording index!");
+        }
+    }
+
+    /** Get the next data block in the recording.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_next_data_block
+     */
+    bool get_next_data_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_get_next_data_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next data block!");
+    }
+
+    /** Get the previous data block from the recording.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_previous_data_block
+     */
+    bool get_previous_data_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_get_previous_data_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
         {
             return false;
         }
@@ -467,6 +995,159 @@ public:
         throw error("Failed to get previous data block!");
     }
 
+    /** Get the next block of any track as it is stored in the recording, including the built-in tracks.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_next_raw_block
+     */
+    bool get_next_raw_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_get_next_raw_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next raw block!");
+    }
+
+    /** Get the previous block of any track as it is stored in the recording, including the built-in tracks.
+     * Returns true if a block was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_previous_raw_block
+     */
+    bool get_previous_raw_block(const char *track, data_block *block)
+    {
+        k4a_playback_data_block_t block_handle;
+        k4a_stream_result_t result = k4a_playback_get_previous_raw_block(m_handle, track, &block_handle);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *block = data_block(block_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get previous raw block!");
+    }
+
+    /** Read the data blocks of a custom track in a time range into a single buffer.
+     * Returns true if all of the blocks in the range were read, false if the arrays filled up first.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_data_blocks
+     */
+    bool get_data_blocks(const char *track,
+                         std::chrono::microseconds start_timestamp,
+                         std::chrono::microseconds end_timestamp,
+                         k4a_playback_data_block_info_t *blocks,
+                         size_t max_block_count,
+                         uint8_t *buffer,
+                         size_t buffer_size,
+                         size_t *block_count)
+    {
+        k4a_buffer_result_t result =
+            k4a_playback_get_data_blocks(m_handle,
+                                         track,
+                                         internal::clamp_cast<uint64_t>(start_timestamp.count()),
+                                         internal::clamp_cast<uint64_t>(end_timestamp.count()),
+                                         blocks,
+                                         max_block_count,
+                                         buffer,
+                                         buffer_size,
+                                         block_count);
+
+        if (K4A_BUFFER_RESULT_SUCCEEDED == result)
+        {
+            return true;
+        }
+        else if (K4A_BUFFER_RESULT_TOO_SMALL == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get data blocks!");
+    }
+
+    /** Create a cursor that reads the recording independently of this playback object.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_cursor_create
+     */
+    playback_cursor create_cursor()
+    {
+        k4a_playback_cursor_t cursor_handle = nullptr;
+        k4a_result_t result = k4a_playback_cursor_create(m_handle, &cursor_handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to create playback cursor!");
+        }
+
+        return playback_cursor(cursor_handle);
+    }
+
+    /** Read every capture in a time range of the recording, using several worker threads.
+     * \p callback is called once for each capture. If it throws, processing stops and the exception is rethrown here.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_process_range
+     */
+    void process_range(std::chrono::microseconds start,
+                       std::chrono::microseconds end,
+                       uint32_t worker_count,
+                       bool in_order,
+                       const std::function<void(capture &)> &callback)
+    {
+        range_context context{ callback, nullptr, {} };
+        k4a_result_t result = k4a_playback_process_range(m_handle,
+                                                         static_cast<uint64_t>(start.count()),
+                                                         static_cast<uint64_t>(end.count()),
+                                                         worker_count,
+                                                         in_order,
+                                                         &playback::range_callback,
+                                                         &context);
+
+        if (context.exception)
+        {
+            std::rethrow_exception(context.exception);
+        }
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to process recording range!");
+        }
+    }
+
+    /** Write a time range of the recording to a new recording file, copying its clusters without decoding them.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_write_range
+     */
+    void write_range(const char *path, std::chrono::microseconds start, std::chrono::microseconds end)
+    {
+        k4a_result_t result = k4a_playback_write_range(m_handle,
+                                                       path,
+                                                       static_cast<uint64_t>(start.count()),
+                                                       static_cast<uint64_t>(end.count()));
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to write recording range!");
+        }
+    }
+
     /** Get the attachment block from the recording.
      * Returns true if the attachment was available, false if it was not found.
      * Throws error on failure.
@@ -508,10 +1189,286 @@ public:
         return playback(handle);
     }
 
+    /** Opens one device of a K4A recording of several devices for playback.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_open_device
+     */
+    static playback open_device(const char *path, uint32_t device_index)
+    {
+        k4a_playback_t handle = nullptr;
+        k4a_result_t result = k4a_playback_open_device(path, device_index, &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recording device!");
+        }
+
+        return playback(handle);
+    }
+
+    /** Opens a K4A recording for playback, reading the rest of the recording when it is first needed.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_open_lazy
+     */
+    static playback open_lazy(const char *path)
+    {
+        k4a_playback_t handle = nullptr;
+        k4a_result_t result = k4a_playback_open_lazy(path, &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recording!");
+        }
+
+        return playback(handle);
+    }
+
+    /** Opens a K4A recording for playback through a read callback.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_open_custom_io
+     */
+    static playback
+    open_custom_io(const char *name, uint64_t size, k4a_playback_read_cb_t *read_cb, void *callback_context)
+    {
+        k4a_playback_t handle = nullptr;
+        k4a_result_t result = k4a_playback_open_custom_io(name, size, read_cb, callback_context, &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recording!");
+        }
+
+        return playback(handle);
+    }
+
 private:
+    struct range_context
+    {
+        const std::function<void(capture &)> &callback;
+        std::exception_ptr exception;
+        std::mutex exception_lock;
+    };
+
+    static k4a_result_t range_callback(k4a_capture_t capture_handle, void *context) noexcept
+    {
+        range_context *range = static_cast<range_context *>(context);
+        try
+        {
+            // The capture handle is released by k4a_playback_process_range, so the wrapper takes its own reference.
+            k4a_capture_reference(capture_handle);
+            capture cap(capture_handle);
+            range->callback(cap);
+            return K4A_RESULT_SUCCEEDED;
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(range->exception_lock);
+            if (!range->exception)
+            {
+                range->exception = std::current_exception();
+            }
+            return K4A_RESULT_FAILED;
+        }
+    }
+
     k4a_playback_t m_handle;
 };
 
+/** \class playback_group playback.hpp <k4arecord/playback.hpp>
+ * Wrapper for \ref k4a_playback_group_t
+ *
+ * Wraps a handle for the recordings of a synchronized multi-device rig that are played back together.
+ *
+ * \sa k4a_playback_group_t
+ */
+class playback_group
+{
+public:
+    /** Creates a k4a::playback_group from a k4a_playback_group_t
+     * Takes ownership of the handle, you should not call k4a_playback_group_close on the handle after giving it to the
+     * playback_group; the playback_group will take care of that.
+     */
+    playback_group(k4a_playback_group_t handle = nullptr, size_t count = 0) noexcept :
+        m_handle(handle),
+        m_count(count)
+    {
+    }
+
+    // No Copies allowed
+    playback_group(const playback_group &) = delete;
+    playback_group &operator=(const playback_group &) = delete;
+
+    /** Moves another playback_group into a new playback_group
+     */
+    playback_group(playback_group &&other) noexcept : m_handle(other.m_handle), m_count(other.m_count)
+    {
+        other.m_handle = nullptr;
+        other.m_count = 0;
+    }
+
+    ~playback_group()
+    {
+        close();
+    }
+
+    /** Moves another playback_group into this playback_group; other is set to invalid
+     */
+    playback_group &operator=(playback_group &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_handle = other.m_handle;
+            m_count = other.m_count;
+            other.m_handle = nullptr;
+            other.m_count = 0;
+        }
+        return *this;
+    }
+
+    /** Returns true if the playback_group is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return is_valid();
+    }
+
+    /** Returns true if the playback_group is valid, false otherwise
+     */
+    bool is_valid() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Closes the recordings of the group.
+     *
+     * \sa k4a_playback_group_close
+     */
+    void close() noexcept
+    {
+        if (m_handle != nullptr)
+        {
+            k4a_playback_group_close(m_handle);
+            m_handle = nullptr;
+            m_count = 0;
+        }
+    }
+
+    /** Returns the number of recordings in the group
+     */
+    size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+    /** Get the playback handle of one recording of the group. The handle is owned by the group.
+     *
+     * \sa k4a_playback_group_get_playback
+     */
+    k4a_playback_t get_playback(size_t index) const noexcept
+    {
+        return k4a_playback_group_get_playback(m_handle, index);
+    }
+
+    /** Get the next captures of the group that were taken at the same time, one entry for each recording.
+     * Returns true if captures were available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_get_next_captures
+     */
+    bool get_next_captures(std::vector<capture> *captures, std::chrono::microseconds *sync_timestamp = nullptr)
+    {
+        std::vector<k4a_capture_t> capture_handles(m_count);
+        uint64_t sync_timestamp_usec = 0;
+        k4a_stream_result_t result = k4a_playback_group_get_next_captures(m_handle,
+                                                                          capture_handles.data(),
+                                                                          capture_handles.size(),
+                                                                          &sync_timestamp_usec);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            captures->clear();
+            for (k4a_capture_t capture_handle : capture_handles)
+            {
+                captures->emplace_back(capture_handle);
+            }
+            if (sync_timestamp != nullptr)
+            {
+                *sync_timestamp = std::chrono::microseconds(sync_timestamp_usec);
+            }
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next captures!");
+    }
+
+    /** Seeks every recording of the group to a timestamp in the device time of the master.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_seek_timestamp
+     */
+    void seek_timestamp(std::chrono::microseconds sync_timestamp)
+    {
+        k4a_result_t result =
+            k4a_playback_group_seek_timestamp(m_handle, internal::clamp_cast<uint64_t>(sync_timestamp.count()));
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to seek recordings!");
+        }
+    }
+
+    /** Opens the recordings of a synchronized rig to play them back together.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_open
+     */
+    static playback_group open(const std::vector<const char *> &paths)
+    {
+        k4a_playback_group_t handle = nullptr;
+        std::vector<const char *> path_list(paths);
+        k4a_result_t result = k4a_playback_group_open(path_list.data(), path_list.size(), &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recordings!");
+        }
+
+        return playback_group(handle, paths.size());
+    }
+
+    /** Opens every device of a K4A recording of several devices as a playback group.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_open_devices
+     */
+    static playback_group open_devices(const char *path)
+    {
+        k4a_playback_group_t handle = nullptr;
+        k4a_result_t result = k4a_playback_group_open_devices(path, &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recording devices!");
+        }
+
+        // The group has a member for each device, the first member tells the device count
+        k4a_playback_t first = k4a_playback_group_get_playback(handle, 0);
+        return playback_group(handle, k4a_playback_get_device_count(first));
+    }
+
+private:
+    k4a_playback_group_t m_handle;
+    size_t m_count;
+};
+
 } // namespace k4a
 
 #endif
@@ -0,0 +1,154 @@
+/** \file pointcloud.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure Point Cloud Export SDK.
+ */
+
+#ifndef K4A_POINTCLOUD_H
+#define K4A_POINTCLOUD_H
+
+#include <k4arecord/types.h>
+#include <k4arecord/k4arecord_export.h>
+
+#ifdef __cplusplus
+
+extern "C" {
+#endif
+
+/**
+ *
+ * \addtogroup Functions
+ *
+ * @{
+ */
+
+/** Creates a writer of binary point cloud files.
+ *
+ * \param format
+ * The file format of the point clouds.
+ *
+ * \param background
+ * If true, files are written by a thread of the writer and k4a_point_cloud_writer_write() returns once the point cloud
+ * is queued. If false, k4a_point_cloud_writer_write() returns once the file is written.
+ *
+ * \param writer_handle
+ * If successful, this contains a pointer to the new writer handle. Caller must call k4a_point_cloud_writer_close() when
+ * finished writing.
+ *
+ * \headerfile pointcloud.h <k4arecord/pointcloud.h>
+ *
+ * \relates k4a_point_cloud_writer_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the format is unknown or an error
+ * occurred.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">pointcloud.h (include k4arecord/pointcloud.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_point_cloud_writer_create(k4a_point_cloud_file_format_t format,
+                                                            bool background,
+                                                            k4a_point_cloud_writer_t *writer_handle);
+
+/** Writes a point cloud to a new file.
+ *
+ * \param writer_handle
+ * Handle obtained by k4a_point_cloud_writer_create().
+ *
+ * \param path
+ * Path of the file. An existing file is replaced.
+ *
+ * \param xyz_image
+ * The point cloud, as written by k4a_transformation_depth_image_to_point_cloud() or
+ * k4a_transformation_depth_image_to_point_cloud_with_format().
+ *
+ * \param color_image
+ * A ::K4A_IMAGE_FORMAT_COLOR_BGRA32 image of the width and height of \p xyz_image with the color of every point, such
+ * as the output of k4a_transformation_color_image_to_depth_camera(), or NULL to write the points without color.
+ *
+ * \headerfile pointcloud.h <k4arecord/pointcloud.h>
+ *
+ * \relates k4a_point_cloud_writer_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the images are invalid or an error
+ * occurred. Errors of a background writer are returned by k4a_point_cloud_writer_flush().
+ *
+ * \remarks
+ * The points are written in the format of \p xyz_image: int16_t X, Y and Z in millimeters for an image with a stride
+ * of 6 bytes per pixel, and float X, Y and Z in meters for an image with a stride of 12 bytes per pixel. Points with a
+ * Z of 0 have no depth and are skipped, the others are written in row major pixel order. The red, green and blue values
+ * of a colored point follow its Z value in a PLY file. A PCD file stores them in a packed rgb field.
+ *
+ * \remarks
+ * The points are converted into a buffer of the writer and written to the file in large blocks, without formatting
+ * text. A background writer keeps a reference to the images until the file is written, so they must not be modified
+ * before k4a_point_cloud_writer_flush() returns. Up to 4 point clouds are queued, further calls wait for the queue to
+ * make room.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">pointcloud.h (include k4arecord/pointcloud.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_point_cloud_writer_write(k4a_point_cloud_writer_t writer_handle,
+                                                           const char *path,
+                                                           k4a_image_t xyz_image,
+                                                           k4a_image_t color_image);
+
+/** Waits until every queued point cloud is written.
+ *
+ * \param writer_handle
+ * Handle obtained by k4a_point_cloud_writer_create().
+ *
+ * \headerfile pointcloud.h <k4arecord/pointcloud.h>
+ *
+ * \relates k4a_point_cloud_writer_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED if every file written since the last flush was written, or ::K4A_RESULT_FAILED if
+ * one of them failed.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">pointcloud.h (include k4arecord/pointcloud.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_point_cloud_writer_flush(k4a_point_cloud_writer_t writer_handle);
+
+/** Writes the queued point clouds and closes a point cloud writer.
+ *
+ * \param writer_handle
+ * Handle obtained by k4a_point_cloud_writer_create().
+ *
+ * \headerfile pointcloud.h <k4arecord/pointcloud.h>
+ *
+ * \relates k4a_point_cloud_writer_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">pointcloud.h (include k4arecord/pointcloud.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_point_cloud_writer_close(k4a_point_cloud_writer_t writer_handle);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* K4A_POINTCLOUD_H */
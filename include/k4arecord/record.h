@@ -129,6 +129,87 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_add_tag(k4a_record_t recording_handle,
  */
 K4ARECORD_EXPORT k4a_result_t k4a_record_add_imu_track(k4a_record_t recording_handle);
 
+/** Adds the tracks of another device to the recording.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param device
+ * The Azure Kinect device that is being recorded, used to store its calibration and serial number. May be NULL.
+ *
+ * \param device_config
+ * The configuration the device was started with.
+ *
+ * \param device_index
+ * If successful, the index of the device in the recording, passed to k4a_record_write_device_capture(). The device
+ * of k4a_record_create() is device 0, and each added device takes the next index.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Recording several devices to one file writes their clusters interleaved by timestamp from a single writer thread,
+ * so the disk sees one sequential stream instead of one per file, and the devices are played back from one file.
+ * The devices should be in a wired synchronized rig, so that their device timestamps are close, or captures of a
+ * device running behind the others fail to write once their clusters have been flushed.
+ *
+ * \remarks
+ * The tracks, tags and calibration attachment of an added device are named like those of device 0 with a
+ * "_<device index>" suffix, such as COLOR_1 or calibration_1.json. Playback reads them with
+ * k4a_playback_open_device(), while k4a_playback_open() reads device 0 and sees the other devices as custom tracks.
+ *
+ * \remarks
+ * The codecs set with k4a_record_set_depth_codec() and k4a_record_set_color_codec() apply to every device. The
+ * color encoder of k4a_record_set_color_encoder() only compresses the color track of device 0.
+ *
+ * \remarks
+ * Devices need to be added before the recording header is written. If adding a device fails, its partial tracks stay
+ * in the file and the recording should be closed.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_add_device(k4a_record_t recording_handle,
+                                                    k4a_device_t device,
+                                                    const k4a_device_configuration_t device_config,
+                                                    uint32_t *device_index);
+
+/** Adds the track header for recording the IMU of a device.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param device_index
+ * The index of the device, 0 for the device of k4a_record_create() or an index returned by k4a_record_add_device().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * This is k4a_record_add_imu_track() for any device of the recording. The track needs to be added before the
+ * recording header is written.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_add_device_imu_track(k4a_record_t recording_handle, uint32_t device_index);
+
 /** Adds an attachment to the recording.
  *
  * \param recording_handle
@@ -281,6 +362,52 @@ k4a_record_add_custom_subtitle_track(const k4a_record_t recording_handle,
                                      size_t codec_context_size,
                                      const k4a_record_subtitle_settings_t *track_settings);
 
+/** Adds a low resolution preview track to the recording, for browsing it without reading the full resolution images.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param settings
+ * The size, rate and quality of the previews.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * A preview is added for the first capture written with k4a_record_write_capture(), and then for the first capture at
+ * least settings->interval_usec after the previous preview. Each preview holds the color image of the capture,
+ * downscaled by settings->scale and compressed to JPEG, and its depth image downscaled by settings->scale to 8 bits,
+ * with 0 for invalid depth and 1 to 255 up to settings->max_depth_mm. Color images in the MJPG, NV12, YUY2 and BGRA32
+ * formats are supported.
+ *
+ * \remarks
+ * The previews are made when the recording data is written to disk, not on the thread calling
+ * k4a_record_write_capture(), which only keeps a reference to the images of the capture until then. A preview that
+ * can't be made is left out of the track, and the recording continues.
+ *
+ * \remarks
+ * settings->interval_usec must be at least the length of a cluster of the recording, 32 ms by default, so that a
+ * cluster holds at most one preview. The previews are read back with k4a_playback_get_next_preview(), and their
+ * positions are stored in the sidecar index of k4a_record_set_live_index() and k4a_playback_write_index().
+ *
+ * \remarks
+ * Only the device of k4a_record_create() has a preview track. The track needs to be added before the recording header
+ * is written.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_add_preview_track(k4a_record_t recording_handle,
+                                                           const k4a_record_preview_settings_t *settings);
+
 /** Writes the recording header and metadata to file.
  *
  * \param recording_handle
@@ -336,13 +463,16 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_header(k4a_record_t recording_han
  */
 K4ARECORD_EXPORT k4a_result_t k4a_record_write_capture(k4a_record_t recording_handle, k4a_capture_t capture_handle);
 
-/** Writes an imu sample to file.
+/** Writes a camera capture of a device to file.
  *
  * \param recording_handle
  * The handle of a new recording, obtained by k4a_record_create().
  *
- * \param imu_sample
- * A structure containing the imu sample data and timestamps.
+ * \param device_index
+ * The index of the device, 0 for the device of k4a_record_create() or an index returned by k4a_record_add_device().
+ *
+ * \param capture_handle
+ * The handle of a capture of the device to write to file.
  *
  * \headerfile record.h <k4arecord/record.h>
  *
@@ -351,11 +481,48 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_capture(k4a_record_t recording_ha
  * \returns ::K4A_RESULT_SUCCEEDED is returned on success
  *
  * \remarks
- * Samples must be written in increasing order of timestamp, and the file's header must already be written.
+ * This is k4a_record_write_capture() for any device of the recording. The captures of each device must be written in
+ * increasing order of timestamp. Captures of different devices may be written from different threads, and are
+ * interleaved by timestamp in the clusters of the file.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_device_capture(k4a_record_t recording_handle,
+                                                              uint32_t device_index,
+                                                              k4a_capture_t capture_handle);
+
+/** Sets whether k4a_record_write_capture() copies the color images of captures.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param zero_copy
+ * If true, color images are written to file from their own buffer instead of from a copy of it.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
  *
  * \remarks
- * When writing imu samples at the same time as captures, the samples should be within 1 second of the most recently
- * written capture.
+ * Written data is held in memory for a short time before it is flushed to disk. By default every image is copied when
+ * it is written. With zero copy enabled, the recording instead holds a reference to each color image until the data
+ * is flushed, which avoids the copy and the memory it takes. The contents of an image written this way must not be
+ * modified after the call to k4a_record_write_capture(). Depth and IR images are still copied, since they are byte
+ * swapped when they are written, unless they are compressed with k4a_record_set_depth_codec().
+ *
+ * \remarks
+ * Each color image stays allocated until its data is flushed, which is up to a few seconds after it was written.
+ *
+ * \remarks
+ * The setting applies to captures written after this call. Zero copy is disabled by default.
  *
  * \xmlonly
  * <requirements>
@@ -365,25 +532,160 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_capture(k4a_record_t recording_ha
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_sample(k4a_record_t recording_handle, k4a_imu_sample_t imu_sample);
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_zero_copy(k4a_record_t recording_handle, bool zero_copy);
 
-/** Writes data for a custom track to file.
+/** Sets the codec used to store the depth and IR tracks of a recording.
  *
  * \param recording_handle
  * The handle of a new recording, obtained by k4a_record_create().
  *
- * \param track_name
- * The name of the custom track that the data is going to be written to.
+ * \param depth_codec
+ * The codec used for both the depth and the IR track.
  *
- * \param device_timestamp_usec
- * The timestamp in microseconds for the custom track data. This timestamp should be in the same time domain as the
- * device timestamp used for recording.
+ * \headerfile record.h <k4arecord/record.h>
  *
- * \param custom_data
- * The buffer of custom track data.
+ * \relates k4a_record_t
  *
- * \param custom_data_size
- * The size of the custom track data buffer.
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * By default depth and IR images are stored uncompressed. ::K4A_RECORD_DEPTH_CODEC_RVL compresses them losslessly with
+ * RVL, which typically makes depth frames a few times smaller. Frames are compressed in the background when they
+ * are flushed to disk, and decompressed by k4a_playback_get_next_capture() and the other capture reading functions.
+ *
+ * \remarks
+ * Recordings compressed with RVL can only be played back by versions of the SDK that support the codec, and not by
+ * tools that expect the raw b16g format.
+ *
+ * \remarks
+ * The codec applies to the depth and IR tracks of every device of the recording, see k4a_record_add_device().
+ *
+ * \remarks
+ * The codec must be set before the recording header is written with k4a_record_write_header().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_depth_codec(k4a_record_t recording_handle,
+                                                         k4a_record_depth_codec_t depth_codec);
+
+/** Sets the codec used to store the color track of a recording.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param color_codec
+ * The codec of the color track.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the recording has no color track or
+ * its color format can't be stored with \p color_codec.
+ *
+ * \remarks
+ * By default color images are stored in the format they are captured in. Some color modes are only available as
+ * ::K4A_IMAGE_FORMAT_COLOR_NV12 or ::K4A_IMAGE_FORMAT_COLOR_YUY2, whose frames take 3 to 4 times the disk bandwidth of
+ * MJPG. ::K4A_RECORD_COLOR_CODEC_MJPG compresses those frames to JPEG when they are flushed to disk, on several threads
+ * in the background instead of the thread calling k4a_record_write_capture(). The color track is written as a regular
+ * MJPG track, which is played back as ::K4A_IMAGE_FORMAT_COLOR_MJPG. Recordings of a MJPG color format are unchanged.
+ *
+ * \remarks
+ * Color images written to a compressed track must hold the full image of their resolution, JPEG compression fails
+ * otherwise.
+ *
+ * \remarks
+ * The codec applies to the color tracks of every device of the recording, see k4a_record_add_device().
+ *
+ * \remarks
+ * The codec must be set before the recording header is written with k4a_record_write_header().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_color_codec(k4a_record_t recording_handle,
+                                                         k4a_record_color_codec_t color_codec);
+
+/** Compresses the color track of a recording with a video encoder supplied by the application.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param codec_id
+ * A UTF8 null terminated string containing the Matroska codec ID of the encoded frames, such as "V_MPEG4/ISO/AVC" for
+ * H.264 or "V_MPEGH/ISO/HEVC" for HEVC. See https://www.matroska.org/technical/specs/codecid/index.html.
+ *
+ * \param codec_context
+ * The codec specific setup data of the encoder, mapped to the Matroska 'CodecPrivate' element. For H.264 and HEVC this
+ * is the AVCDecoderConfigurationRecord or HEVCDecoderConfigurationRecord with the parameter sets of the stream. May
+ * be NULL if \p codec_context_size is 0.
+ *
+ * \param codec_context_size
+ * The size of the codec context buffer.
+ *
+ * \param encode_cb
+ * The callback that compresses each color image.
+ *
+ * \param callback_context
+ * Context passed to \p encode_cb.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the recording has no color track.
+ *
+ * \remarks
+ * Raw color images take most of the size and disk bandwidth of a recording. A hardware video encoder, such as NVENC,
+ * VA-API or a Media Foundation transform, can compress them many times more than MJPG at little CPU cost. The SDK
+ * doesn't depend on an encoder, the application wraps the one of its platform in \p encode_cb. The track is written
+ * with the standard \p codec_id, so other tools can play back the color track.
+ *
+ * \remarks
+ * Color images are passed to \p encode_cb in timestamp order when the clusters are written, on the writer thread of
+ * the recording. The encoder needs to output one frame for each image, without reordering them, as low latency
+ * encoder presets do without B-frames. Frames that aren't key frames are written as such, and key frames are needed
+ * regularly to seek in the recording. If \p encode_cb fails, the color image is dropped.
+ *
+ * \remarks
+ * The images are decoded by playback once a decoder is set with k4a_playback_set_color_decoder().
+ *
+ * \remarks
+ * The encoder must be set before the recording header is written with k4a_record_write_header().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_color_encoder(k4a_record_t recording_handle,
+                                                           const char *codec_id,
+                                                           const uint8_t *codec_context,
+                                                           size_t codec_context_size,
+                                                           k4a_record_color_encode_cb_t *encode_cb,
+                                                           void *callback_context);
+
+/** Sets whether a recording is written to disk without going through the OS file cache.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param unbuffered_io
+ * If true, the recording file is written with unbuffered IO.
  *
  * \headerfile record.h <k4arecord/record.h>
  *
@@ -392,9 +694,15 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_sample(k4a_record_t recording
  * \returns ::K4A_RESULT_SUCCEEDED is returned on success
  *
  * \remarks
- * Custom track data must be written in increasing order of timestamp, and the file's header must already be written.
- * When writing custom track data at the same time as captures or IMU data, the custom data should be within 1 second of
- * the most recently written timestamp.
+ * Long recordings normally fill the OS file cache with data that isn't read again, which can push out the memory of
+ * other applications. With unbuffered IO, data is gathered in large blocks and written directly to disk, using
+ * O_DIRECT on Linux and FILE_FLAG_NO_BUFFERING on Windows. Several blocks are written at the same time to keep fast
+ * disks busy. The file is also preallocated as it grows to reduce fragmentation. If the file system doesn't support
+ * unbuffered IO, regular buffered IO is used instead.
+ *
+ * \remarks
+ * The file is created again when this setting changes, so it must be set before the recording header is written with
+ * k4a_record_write_header().
  *
  * \xmlonly
  * <requirements>
@@ -404,31 +712,37 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_sample(k4a_record_t recording
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_handle,
-                                                                 const char *track_name,
-                                                                 uint64_t device_timestamp_usec,
-                                                                 uint8_t *custom_data,
-                                                                 size_t custom_data_size);
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_unbuffered_io(k4a_record_t recording_handle, bool unbuffered_io);
 
-/** Flushes all pending recording data to disk.
+/** Splits a recording into several files, each limited in duration or size.
  *
  * \param recording_handle
- * Handle obtained by k4a_record_create().
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param max_duration_usec
+ * The duration of each file in microseconds, or 0 for no limit.
+ *
+ * \param max_size_bytes
+ * The size of each file in bytes, or 0 for no limit.
  *
  * \headerfile record.h <k4arecord/record.h>
  *
  * \relates k4a_record_t
  *
- * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if an error occurred.
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
  *
  * \remarks
- * k4a_record_flush() ensures that all data passed to the recording API prior to calling flush is written to disk.
- * If continuing to write recording data, care must be taken to ensure no new timestamps are added from before the
- * flush.
+ * When the current file reaches either limit, the recording continues in a new file without losing any data. The first
+ * file is the path passed to k4a_record_create(), and the next files insert a number before the extension, so
+ * "output.mkv" continues in "output_001.mkv", "output_002.mkv", and so on. Each file is a complete recording with the
+ * same tracks, attachments and tags, that can be played back on its own.
  *
  * \remarks
- * If an error occurs, best effort is made to flush as much data to disk as possible, but the integrity of the file is
- * not guaranteed.
+ * Files are switched between clusters of data, so they can be slightly longer or larger than the limits. The header of
+ * the next file is written ahead of time, so switching files doesn't delay the recording.
+ *
+ * \remarks
+ * The limits must be set before the recording header is written with k4a_record_write_header().
  *
  * \xmlonly
  * <requirements>
@@ -438,19 +752,40 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_data(const k4a_recor
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT k4a_result_t k4a_record_flush(k4a_record_t recording_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_segment_limits(k4a_record_t recording_handle,
+                                                            uint64_t max_duration_usec,
+                                                            uint64_t max_size_bytes);
 
-/** Closes a recording handle.
+/** Writes a sidecar index next to the recording while it is recorded.
  *
  * \param recording_handle
- * Handle obtained by k4a_record_create().
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param live_index
+ * If true, the index is written along with the recording.
  *
  * \headerfile record.h <k4arecord/record.h>
  *
  * \relates k4a_record_t
  *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
  * \remarks
- * If there is any unwritten data it will be flushed to disk before closing the recording.
+ * The index of a recording is normally only written when the recording is closed. A recording that was interrupted,
+ * or one that is still being recorded, has to be read from start to end to find its data. With a live index, the
+ * position and timestamp of every cluster of data is added to the recording path with ".k4aidx" appended, for example
+ * "output.mkv.k4aidx", as soon as the cluster is written. The index is flushed to disk about once per second of
+ * recording.
+ *
+ * \remarks
+ * k4a_playback_open() uses the clusters listed in the index and only reads the data written after them from the
+ * recording, so interrupted recordings open and seek quickly, and a recording can be played back while it grows. Once
+ * k4a_record_close() finishes the recording, the index is complete and is used like one written by
+ * k4a_playback_write_index(). Each file of a segmented recording has its own index.
+ *
+ * \remarks
+ * The live index must be set before the recording header is written with k4a_record_write_header(). If the index
+ * can't be written, it is removed and the recording continues without it.
  *
  * \xmlonly
  * <requirements>
@@ -460,7 +795,658 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_flush(k4a_record_t recording_handle);
  * </requirements>
  * \endxmlonly
  */
-K4ARECORD_EXPORT void k4a_record_close(k4a_record_t recording_handle);
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_live_index(k4a_record_t recording_handle, bool live_index);
+
+/** Limits the amount of data a recording holds in memory before it is written to disk.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param max_size_bytes
+ * The maximum size in bytes of the data waiting to be written to disk, or 0 for no limit.
+ *
+ * \param policy
+ * What k4a_record_write_capture() does with a capture that doesn't fit within the limit.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Written data is held in memory for a few seconds, so that data arriving out of order can be sorted before it is
+ * written to disk. If the disk can't keep up, the amount of data held keeps growing. There is no limit by default.
+ *
+ * \remarks
+ * When the limit is reached, the data that is already complete is written to disk right away. Data for those
+ * timestamps that arrives later can then no longer be written. If that doesn't make room for a capture, the policy
+ * decides what k4a_record_write_capture() does: it waits for more data to be written to disk, drops images, or fails.
+ * Dropped images are counted by k4a_record_get_dropped_image_count(), and k4a_record_write_capture() succeeds when
+ * it drops images.
+ *
+ * \remarks
+ * The limit is approximate. Only captures are checked against it, IMU samples and custom track data are always
+ * written. With ::K4A_RECORD_WRITE_QUEUE_BLOCK, a capture is written anyway if the data held in memory is too recent
+ * to be written to disk yet, so the limit should be larger than a few frames.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_write_queue_limit(k4a_record_t recording_handle,
+                                                               size_t max_size_bytes,
+                                                               k4a_record_write_queue_policy_t policy);
+
+/** Gets the number of images k4a_record_write_capture() has dropped because the write queue was full.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param dropped_image_count
+ * Location to write the number of dropped images.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Images are only dropped with the ::K4A_RECORD_WRITE_QUEUE_DROP_COLOR and ::K4A_RECORD_WRITE_QUEUE_DROP_CAPTURE
+ * policies, see k4a_record_set_write_queue_limit().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_get_dropped_image_count(k4a_record_t recording_handle,
+                                                                 uint64_t *dropped_image_count);
+
+/** Gets the metrics of a recording as counters and gauges.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param metrics
+ * Location to write the metrics to. If this input is NULL \p metric_count will still be updated to return the number
+ * of metrics.
+ *
+ * \param metric_count
+ * On input, the number of elements of \p metrics if that pointer is not NULL. On output, the number of metrics of the
+ * recording.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if \p metrics has been filled in. ::K4A_BUFFER_RESULT_TOO_SMALL if the buffer is too
+ * small, the metrics that fit are filled in and the number of metrics is returned in \p metric_count. All other
+ * failures return ::K4A_BUFFER_RESULT_FAILED.
+ *
+ * \remarks
+ * The metrics use the same form as k4a_device_get_metrics(): the size of the write queue, how far behind the newest
+ * data the writes to disk are in recording time, and the images dropped by the write queue limit, see
+ * k4a_record_set_write_queue_limit(). A write queue age that keeps growing means the disk can't keep up.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_buffer_result_t k4a_record_get_metrics(k4a_record_t recording_handle,
+                                                            k4a_metric_t *metrics,
+                                                            size_t *metric_count);
+
+/** Writes an imu sample to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param imu_sample
+ * A structure containing the imu sample data and timestamps.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Samples must be written in increasing order of timestamp, and the file's header must already be written.
+ *
+ * \remarks
+ * When writing imu samples at the same time as captures, the samples should be within 1 second of the most recently
+ * written capture.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_sample(k4a_record_t recording_handle, k4a_imu_sample_t imu_sample);
+
+/** Writes a batch of imu samples to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param imu_samples
+ * Array of \p sample_count imu samples, in increasing order of timestamp.
+ *
+ * \param sample_count
+ * The number of samples in \p imu_samples, at least 1.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned if every sample was written
+ *
+ * \remarks
+ * This is equivalent to calling k4a_record_write_imu_sample() for each sample, but queues all of the samples for
+ * writing at once. The IMU produces samples at over 1 kHz, so writing the samples of each k4a_device_get_imu_sample()
+ * burst together avoids most of the per sample overhead. The samples of each cluster are stored together in a single
+ * laced block, both with this function and with k4a_record_write_imu_sample().
+ *
+ * \remarks
+ * If some samples can't be written, for example because their timestamp is older than data that has already been
+ * written to disk, the other samples are still written and ::K4A_RESULT_FAILED is returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_samples(k4a_record_t recording_handle,
+                                                           const k4a_imu_sample_t *imu_samples,
+                                                           size_t sample_count);
+
+/** Writes a batch of imu samples of a device to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param device_index
+ * The index of the device, 0 for the device of k4a_record_create() or an index returned by k4a_record_add_device().
+ *
+ * \param imu_samples
+ * Array of \p sample_count imu samples, in increasing order of timestamp.
+ *
+ * \param sample_count
+ * The number of samples in \p imu_samples, at least 1.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned if every sample was written
+ *
+ * \remarks
+ * This is k4a_record_write_imu_samples() for any device of the recording. The IMU track of the device needs to be
+ * added with k4a_record_add_device_imu_track().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_device_imu_samples(k4a_record_t recording_handle,
+                                                                  uint32_t device_index,
+                                                                  const k4a_imu_sample_t *imu_samples,
+                                                                  size_t sample_count);
+
+/** Writes data for a custom track to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param track_name
+ * The name of the custom track that the data is going to be written to.
+ *
+ * \param device_timestamp_usec
+ * The timestamp in microseconds for the custom track data. This timestamp should be in the same time domain as the
+ * device timestamp used for recording.
+ *
+ * \param custom_data
+ * The buffer of custom track data.
+ *
+ * \param custom_data_size
+ * The size of the custom track data buffer.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Custom track data must be written in increasing order of timestamp, and the file's header must already be written.
+ * When writing custom track data at the same time as captures or IMU data, the custom data should be within 1 second of
+ * the most recently written timestamp.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_handle,
+                                                                 const char *track_name,
+                                                                 uint64_t device_timestamp_usec,
+                                                                 uint8_t *custom_data,
+                                                                 size_t custom_data_size);
+
+/** Writes data for a custom track to file, without copying the buffer.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param track_name
+ * The name of the custom track that the data is going to be written to.
+ *
+ * \param device_timestamp_usec
+ * The timestamp in microseconds for the custom track data. This timestamp should be in the same time domain as the
+ * device timestamp used for recording.
+ *
+ * \param custom_data
+ * The buffer of custom track data. The recording takes ownership of the buffer.
+ *
+ * \param custom_data_size
+ * The size of the custom track data buffer.
+ *
+ * \param custom_data_release_cb
+ * Callback that is called with \p custom_data once the recording no longer needs the buffer.
+ *
+ * \param custom_data_release_cb_context
+ * Context passed to \p custom_data_release_cb.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * Unlike k4a_record_write_custom_track_data(), the buffer is written to disk directly instead of being copied. The
+ * buffer must not be modified until \p custom_data_release_cb is called, which happens after the cluster containing it
+ * has been written, at the latest when the recording is flushed or closed.
+ *
+ * \remarks
+ * \p custom_data_release_cb is called exactly once. If the data can't be written, it is called before this function
+ * returns ::K4A_RESULT_FAILED. It may be called from the recording's writer thread.
+ *
+ * \remarks
+ * The same ordering rules as k4a_record_write_custom_track_data() apply.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t
+k4a_record_write_custom_track_data_owned(const k4a_record_t recording_handle,
+                                         const char *track_name,
+                                         uint64_t device_timestamp_usec,
+                                         uint8_t *custom_data,
+                                         size_t custom_data_size,
+                                         k4a_memory_destroy_cb_t *custom_data_release_cb,
+                                         void *custom_data_release_cb_context);
+
+/** Writes a batch of data blocks for a custom track to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param track_name
+ * The name of the custom track that the data is going to be written to.
+ *
+ * \param blocks
+ * Array of \p block_count blocks, each with its own timestamp and buffer.
+ *
+ * \param block_count
+ * The number of blocks in \p blocks, at least 1.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned if every block was written
+ *
+ * \remarks
+ * This is equivalent to calling k4a_record_write_custom_track_data() for each block, but queues all of the blocks for
+ * writing at once. High rate sensor data made of many small blocks avoids the per call overhead this way.
+ *
+ * \remarks
+ * The buffers are copied and may be reused once this function returns. If some blocks can't be written, for example
+ * because their timestamp is older than data that has already been written to disk, the other blocks are still
+ * written and ::K4A_RESULT_FAILED is returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_data_batch(const k4a_record_t recording_handle,
+                                                                       const char *track_name,
+                                                                       const k4a_record_custom_track_block_t *blocks,
+                                                                       size_t block_count);
+
+/** Writes the pixels of an image to a custom track.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param track_name
+ * The name of the custom track that the image is going to be written to.
+ *
+ * \param image_handle
+ * The image to write. Its device timestamp is used as the timestamp of the data block.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * The rows of the image are written without padding, so an image view created with k4a_image_create_view() stores
+ * only its own pixels. Images with packed rows are written from their own buffer without a copy, and a reference to
+ * the image is held until the cluster containing it has been written. Images of ::K4A_IMAGE_FORMAT_COLOR_MJPG and
+ * ::K4A_IMAGE_FORMAT_CUSTOM are written as-is.
+ *
+ * \remarks
+ * The same ordering rules as k4a_record_write_custom_track_data() apply.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_image(const k4a_record_t recording_handle,
+                                                                  const char *track_name,
+                                                                  k4a_image_t image_handle);
+
+/** Flushes all pending recording data to disk.
+ *
+ * \param recording_handle
+ * Handle obtained by k4a_record_create().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * k4a_record_flush() ensures that all data passed to the recording API prior to calling flush is written to disk.
+ * If continuing to write recording data, care must be taken to ensure no new timestamps are added from before the
+ * flush.
+ *
+ * \remarks
+ * If an error occurs, best effort is made to flush as much data to disk as possible, but the integrity of the file is
+ * not guaranteed.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_flush(k4a_record_t recording_handle);
+
+/** Closes a recording handle.
+ *
+ * \param recording_handle
+ * Handle obtained by k4a_record_create().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \remarks
+ * If there is any unwritten data it will be flushed to disk before closing the recording.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_record_close(k4a_record_t recording_handle);
+
+/** Creates a bounded history of the most recent captures.
+ *
+ * \param duration_usec
+ * How long captures are kept, in microseconds of device time behind the newest capture in the history.
+ *
+ * \param max_memory_bytes
+ * The maximum number of bytes of image data kept by the history.
+ *
+ * \param history_handle
+ * Location to write the new history handle.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * A capture history keeps copies of the last \p duration_usec of captures, so an event can be recorded together with
+ * what happened just before it. Captures added with k4a_capture_history_add_capture() are copied into buffers owned by
+ * the history, so the device capture can be released right away and the SDK keeps its own buffers for streaming.
+ *
+ * \remarks
+ * The buffers of evicted captures are reused for new ones, so a full history doesn't allocate memory.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_capture_history_create(uint64_t duration_usec,
+                                                         size_t max_memory_bytes,
+                                                         k4a_capture_history_t *history_handle);
+
+/** Adds a copy of a capture to a capture history.
+ *
+ * \param history_handle
+ * Handle obtained by k4a_capture_history_create().
+ *
+ * \param capture_handle
+ * The capture to add. The history doesn't keep a reference to it.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the capture has no images, is
+ * larger than the memory limit of the history, or an error occurred.
+ *
+ * \remarks
+ * The timestamp of a capture is the lowest device timestamp of its images. Captures older than the duration of the
+ * history behind the newest capture are evicted, followed by the oldest captures until the new one fits in the memory
+ * limit.
+ *
+ * \remarks
+ * The color, depth and IR images are copied along with their timestamps and exposure settings.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_capture_history_add_capture(k4a_capture_history_t history_handle,
+                                                              k4a_capture_t capture_handle);
+
+/** Gets the number of captures in a capture history.
+ *
+ * \param history_handle
+ * Handle obtained by k4a_capture_history_create().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \returns The number of captures in the history, or 0 if the handle is invalid.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT size_t k4a_capture_history_get_capture_count(k4a_capture_history_t history_handle);
+
+/** Gets the capture closest to a device timestamp from a capture history.
+ *
+ * \param history_handle
+ * Handle obtained by k4a_capture_history_create().
+ *
+ * \param device_timestamp_usec
+ * The device timestamp to look up.
+ *
+ * \param capture_handle
+ * Location to write the capture. The capture must be released with k4a_capture_release().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the history is empty or an error
+ * occurred.
+ *
+ * \remarks
+ * The returned capture is the copy held by the history. Its buffers are only reused once it has been evicted from the
+ * history and released by the caller.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_capture_history_get_capture(k4a_capture_history_t history_handle,
+                                                              uint64_t device_timestamp_usec,
+                                                              k4a_capture_t *capture_handle);
+
+/** Writes the most recent captures of a capture history to a recording in the background.
+ *
+ * \param history_handle
+ * Handle obtained by k4a_capture_history_create().
+ *
+ * \param recording_handle
+ * Handle obtained by k4a_record_create(), with its header already written.
+ *
+ * \param duration_usec
+ * How far back from the newest capture in the history to write, in microseconds.
+ *
+ * \param callback
+ * Optional function called from the writer thread once every capture has been written.
+ *
+ * \param callback_context
+ * Context passed to \p callback.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED if the writer was started, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * The captures to write are selected when this function is called. New captures can be added to the history while they
+ * are written, and the ones being written stay valid even once they are evicted.
+ *
+ * \remarks
+ * The recording must not be written to or closed by the caller until \p callback has been called. The captures are
+ * written with k4a_record_write_capture(); call k4a_record_flush() or k4a_record_close() afterwards as usual.
+ *
+ * \remarks
+ * k4a_capture_history_destroy() waits for the writers started on the history to finish.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_capture_history_dump(k4a_capture_history_t history_handle,
+                                                       k4a_record_t recording_handle,
+                                                       uint64_t duration_usec,
+                                                       k4a_capture_history_dump_cb_t *callback,
+                                                       void *callback_context);
+
+/** Destroys a capture history.
+ *
+ * \param history_handle
+ * Handle obtained by k4a_capture_history_create().
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_capture_history_t
+ *
+ * \remarks
+ * Waits for any writers started with k4a_capture_history_dump() to finish. Captures returned by
+ * k4a_capture_history_get_capture() stay valid until they are released.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_capture_history_destroy(k4a_capture_history_t history_handle);
 
 /**
  * @}
@@ -87,6 +87,15 @@ public:
         }
     }
 
+    /** Returns the underlying k4a_record_t handle
+     *
+     * Note that the k4a::record still owns the handle and closes it when it is destroyed.
+     */
+    k4a_record_t handle() const noexcept
+    {
+        return m_handle;
+    }
+
     /** Flushes all pending recording data to disk
      *
      * \sa k4a_record_flush
@@ -134,6 +143,38 @@ public:
         }
     }
 
+    /** Adds the tracks of another device to the recording, returns the index of the device
+     * Throws error on failure
+     *
+     * \sa k4a_record_add_device
+     */
+    uint32_t add_device(const device &device, const k4a_device_configuration_t &device_configuration)
+    {
+        uint32_t device_index = 0;
+        k4a_result_t result = k4a_record_add_device(m_handle, device.handle(), device_configuration, &device_index);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to add device!");
+        }
+        return device_index;
+    }
+
+    /** Adds the track header for recording the IMU of a device
+     * Throws error on failure
+     *
+     * \sa k4a_record_add_device_imu_track
+     */
+    void add_device_imu_track(uint32_t device_index)
+    {
+        k4a_result_t result = k4a_record_add_device_imu_track(m_handle, device_index);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to add device imu_track!");
+        }
+    }
+
     /** Adds an attachment to the recording
      * Throws error on failure
      *
@@ -197,6 +238,21 @@ public:
         }
     }
 
+    /** Adds a low resolution preview track to the recording
+     * Throws error on failure
+     *
+     * \sa k4a_record_add_preview_track
+     */
+    void add_preview_track(const k4a_record_preview_settings_t &settings)
+    {
+        k4a_result_t result = k4a_record_add_preview_track(m_handle, &settings);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to add preview track!");
+        }
+    }
+
     /** Writes the recording header and metadata to file
      * Throws error on failure
      *
@@ -227,6 +283,170 @@ public:
         }
     }
 
+    /** Writes a camera capture of a device to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_device_capture
+     */
+    void write_device_capture(uint32_t device_index, const capture &capture)
+    {
+        k4a_result_t result = k4a_record_write_device_capture(m_handle, device_index, capture.handle());
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write device capture!");
+        }
+    }
+
+    /** Sets whether color images are written without being copied
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_zero_copy
+     */
+    void set_zero_copy(bool zero_copy)
+    {
+        k4a_result_t result = k4a_record_set_zero_copy(m_handle, zero_copy);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set zero copy!");
+        }
+    }
+
+    /** Sets the codec used to store the depth and IR tracks
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_depth_codec
+     */
+    void set_depth_codec(k4a_record_depth_codec_t depth_codec)
+    {
+        k4a_result_t result = k4a_record_set_depth_codec(m_handle, depth_codec);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set depth codec!");
+        }
+    }
+
+    /** Sets the codec used to store the color track of the recording
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_color_codec
+     */
+    void set_color_codec(k4a_record_color_codec_t color_codec)
+    {
+        k4a_result_t result = k4a_record_set_color_codec(m_handle, color_codec);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set color codec!");
+        }
+    }
+
+    /** Compresses the color track of the recording with a video encoder supplied by the application
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_color_encoder
+     */
+    void set_color_encoder(const char *codec_id,
+                           const uint8_t *codec_context,
+                           size_t codec_context_size,
+                           k4a_record_color_encode_cb_t *encode_cb,
+                           void *callback_context)
+    {
+        k4a_result_t result = k4a_record_set_color_encoder(m_handle,
+                                                           codec_id,
+                                                           codec_context,
+                                                           codec_context_size,
+                                                           encode_cb,
+                                                           callback_context);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set color encoder!");
+        }
+    }
+
+    /** Sets whether the recording is written without going through the OS file cache
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_unbuffered_io
+     */
+    void set_unbuffered_io(bool unbuffered_io)
+    {
+        k4a_result_t result = k4a_record_set_unbuffered_io(m_handle, unbuffered_io);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set unbuffered IO!");
+        }
+    }
+
+    /** Splits the recording into several files, each limited in duration or size
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_segment_limits
+     */
+    void set_segment_limits(std::chrono::microseconds max_duration, uint64_t max_size_bytes)
+    {
+        k4a_result_t result = k4a_record_set_segment_limits(m_handle,
+                                                            static_cast<uint64_t>(max_duration.count()),
+                                                            max_size_bytes);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set segment limits!");
+        }
+    }
+
+    /** Sets whether a sidecar index is written while the recording is recorded
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_live_index
+     */
+    void set_live_index(bool live_index)
+    {
+        k4a_result_t result = k4a_record_set_live_index(m_handle, live_index);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set live index!");
+        }
+    }
+
+    /** Limits the amount of data held in memory before it is written to disk
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_write_queue_limit
+     */
+    void set_write_queue_limit(size_t max_size_bytes, k4a_record_write_queue_policy_t policy)
+    {
+        k4a_result_t result = k4a_record_set_write_queue_limit(m_handle, max_size_bytes, policy);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set write queue limit!");
+        }
+    }
+
+    /** Gets the number of images dropped because the write queue was full
+     * Throws error on failure
+     *
+     * \sa k4a_record_get_dropped_image_count
+     */
+    uint64_t get_dropped_image_count() const
+    {
+        uint64_t dropped_image_count = 0;
+        k4a_result_t result = k4a_record_get_dropped_image_count(m_handle, &dropped_image_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to get dropped image count!");
+        }
+
+        return dropped_image_count;
+    }
+
     /** Writes an imu sample to file
      * Throws error on failure
      *
@@ -242,6 +462,36 @@ public:
         }
     }
 
+    /** Writes a batch of imu samples to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_imu_samples
+     */
+    void write_imu_samples(const k4a_imu_sample_t *imu_samples, size_t sample_count)
+    {
+        k4a_result_t result = k4a_record_write_imu_samples(m_handle, imu_samples, sample_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write imu samples!");
+        }
+    }
+
+    /** Writes a batch of imu samples of a device to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_device_imu_samples
+     */
+    void write_device_imu_samples(uint32_t device_index, const k4a_imu_sample_t *imu_samples, size_t sample_count)
+    {
+        k4a_result_t result = k4a_record_write_device_imu_samples(m_handle, device_index, imu_samples, sample_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write device imu samples!");
+        }
+    }
+
     /** Writes data for a custom track to file
      * Throws error on failure
      *
@@ -265,6 +515,38 @@ public:
         }
     }
 
+    /** Writes a batch of data blocks for a custom track to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_custom_track_data_batch
+     */
+    void write_custom_track_data_batch(const char *track_name,
+                                       const k4a_record_custom_track_block_t *blocks,
+                                       size_t block_count)
+    {
+        k4a_result_t result = k4a_record_write_custom_track_data_batch(m_handle, track_name, blocks, block_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write custom track data!");
+        }
+    }
+
+    /** Writes the pixels of an image to a custom track
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_custom_track_image
+     */
+    void write_custom_track_image(const char *track_name, const image &img)
+    {
+        k4a_result_t result = k4a_record_write_custom_track_image(m_handle, track_name, img.handle());
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write custom track image!");
+        }
+    }
+
     /** Opens a new recording file for writing
      * Throws error on failure
      *
@@ -287,6 +569,171 @@ private:
     k4a_record_t m_handle;
 };
 
+/** \class capture_history record.hpp
+ * Wrapper for \ref k4a_capture_history_t
+ *
+ * Wraps a handle for a bounded history of recent captures
+ *
+ * \sa k4a_capture_history_t
+ */
+class capture_history
+{
+public:
+    /** Creates a k4a::capture_history from a k4a_capture_history_t
+     * Takes ownership of the handle, i.e. you should not call
+     * k4a_capture_history_destroy on the handle after giving it to the
+     * k4a::capture_history; the k4a::capture_history will take care of that.
+     */
+    capture_history(k4a_capture_history_t handle = nullptr) noexcept : m_handle(handle) {}
+
+    /** Moves another k4a::capture_history into a new k4a::capture_history
+     */
+    capture_history(capture_history &&other) noexcept : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+
+    capture_history(const capture_history &) = delete;
+
+    ~capture_history()
+    {
+        destroy();
+    }
+
+    capture_history &operator=(const capture_history &) = delete;
+
+    /** Moves another k4a::capture_history into this k4a::capture_history; other is set to invalid
+     */
+    capture_history &operator=(capture_history &&other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+
+        return *this;
+    }
+
+    /** Returns true if the k4a::capture_history is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return is_valid();
+    }
+
+    /** Returns true if the k4a::capture_history is valid, false otherwise
+     */
+    bool is_valid() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Destroys the history, waiting for its writers to finish
+     *
+     * \sa k4a_capture_history_destroy
+     */
+    void destroy() noexcept
+    {
+        if (is_valid())
+        {
+            k4a_capture_history_destroy(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /** Adds a copy of a capture to the history
+     * Throws error on failure
+     *
+     * \sa k4a_capture_history_add_capture
+     */
+    void add_capture(const capture &capture)
+    {
+        k4a_result_t result = k4a_capture_history_add_capture(m_handle, capture.handle());
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to add capture to history!");
+        }
+    }
+
+    /** Gets the number of captures in the history
+     *
+     * \sa k4a_capture_history_get_capture_count
+     */
+    size_t get_capture_count() const noexcept
+    {
+        return k4a_capture_history_get_capture_count(m_handle);
+    }
+
+    /** Gets the capture closest to a device timestamp
+     * Throws error on failure
+     *
+     * \sa k4a_capture_history_get_capture
+     */
+    capture get_capture(std::chrono::microseconds device_timestamp) const
+    {
+        k4a_capture_t capture_handle = nullptr;
+        k4a_result_t result =
+            k4a_capture_history_get_capture(m_handle,
+                                            internal::clamp_cast<uint64_t>(device_timestamp.count()),
+                                            &capture_handle);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to get capture from history!");
+        }
+
+        return capture(capture_handle);
+    }
+
+    /** Writes the most recent captures to a recording in the background
+     * Throws error on failure
+     *
+     * \sa k4a_capture_history_dump
+     */
+    void dump(const record &recording,
+              std::chrono::microseconds duration,
+              k4a_capture_history_dump_cb_t *callback = nullptr,
+              void *callback_context = nullptr)
+    {
+        k4a_result_t result = k4a_capture_history_dump(m_handle,
+                                                       recording.handle(),
+                                                       internal::clamp_cast<uint64_t>(duration.count()),
+                                                       callback,
+                                                       callback_context);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to dump capture history!");
+        }
+    }
+
+    /** Creates a bounded history of the most recent captures
+     * Throws error on failure
+     *
+     * \sa k4a_capture_history_create
+     */
+    static capture_history create(std::chrono::microseconds duration, size_t max_memory_bytes)
+    {
+        k4a_capture_history_t handle = nullptr;
+        k4a_result_t result = k4a_capture_history_create(internal::clamp_cast<uint64_t>(duration.count()),
+                                                         max_memory_bytes,
+                                                         &handle);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to create capture history!");
+        }
+
+        return capture_history(handle);
+    }
+
+private:
+    k4a_capture_history_t m_handle;
+};
+
 } // namespace k4a
 
 #endif
@@ -0,0 +1,370 @@
+/** \file stream.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure Network Streaming SDK.
+ */
+
+#ifndef K4A_STREAM_H
+#define K4A_STREAM_H
+
+#include <k4arecord/types.h>
+#include <k4arecord/k4arecord_export.h>
+
+#ifdef __cplusplus
+
+extern "C" {
+#endif
+
+/**
+ *
+ * \addtogroup Functions
+ *
+ * @{
+ */
+
+/** Starts a server streaming captures to clients over TCP.
+ *
+ * \param port
+ * The TCP port to listen on, or 0 to let the system pick one, see k4a_stream_server_get_port().
+ *
+ * \param device
+ * The Azure Kinect device that is being streamed. The device handle is used to send the device calibration to clients.
+ * May be NULL if streaming user-generated data.
+ *
+ * \param device_config
+ * The configuration the Azure Kinect device was started with.
+ *
+ * \param server_handle
+ * If successful, this contains a pointer to the new server handle. Caller must call k4a_stream_server_close() when
+ * finished streaming.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the port can not be listened on or
+ * an error occurred.
+ *
+ * \remarks
+ * The server accepts clients on every IPv4 interface of the host. Captures written with
+ * k4a_stream_server_write_capture() are sent to every connected client, encoded like a recording: color images are
+ * sent in the format they were captured in, so MJPEG images are passed through without decoding, and depth and IR
+ * images are compressed with the codec set by k4a_stream_server_set_depth_codec().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_server_create(uint16_t port,
+                                                       k4a_device_t device,
+                                                       const k4a_device_configuration_t device_config,
+                                                       k4a_stream_server_t *server_handle);
+
+/** Gets the TCP port a server listens on.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns The port, or 0 if the handle is invalid.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint16_t k4a_stream_server_get_port(k4a_stream_server_t server_handle);
+
+/** Sets the codec depth and IR images are sent with.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \param codec
+ * The codec. ::K4A_RECORD_DEPTH_CODEC_RVL is the default.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the codec is unknown.
+ *
+ * \remarks
+ * RVL compresses depth losslessly to a third of its size or less, at a small cost in CPU time on the server and the
+ * client. ::K4A_RECORD_DEPTH_CODEC_RAW sends the image buffers without copying them, for fast local networks.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_server_set_depth_codec(k4a_stream_server_t server_handle,
+                                                                k4a_record_depth_codec_t codec);
+
+/** Sets the number of captures queued for each client before the oldest is dropped.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \param max_queued_captures
+ * The number of captures, at least 1. The default is 2.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if \p max_queued_captures is 0.
+ *
+ * \remarks
+ * A client that reads slower than the camera, or a network slower than the stream, fills the TCP send buffer of its
+ * connection and then its queue. The oldest queued capture is dropped for the newest, so a slow client sees the most
+ * recent captures at a lower frame rate instead of falling further behind, and doesn't slow down other clients.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_server_set_queue_limit(k4a_stream_server_t server_handle,
+                                                                size_t max_queued_captures);
+
+/** Sends a capture to every connected client.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \param capture_handle
+ * The capture to send. The server keeps a reference to it until it has been sent.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \remarks
+ * This function queues the capture for each client and returns without waiting for the network. Images are sent from
+ * the buffers of the capture, so the capture should not be modified after it is written.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_server_write_capture(k4a_stream_server_t server_handle,
+                                                              k4a_capture_t capture_handle);
+
+/** Gets the number of captures dropped for slow clients.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \returns The number of captures dropped from the queues of all clients since the server was created, or 0 if the
+ * handle is invalid.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT uint64_t k4a_stream_server_get_dropped_capture_count(k4a_stream_server_t server_handle);
+
+/** Stops a server and disconnects its clients.
+ *
+ * \param server_handle
+ * Handle obtained by k4a_stream_server_create().
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_server_t
+ *
+ * \remarks
+ * Captures still queued for clients are dropped.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_stream_server_close(k4a_stream_server_t server_handle);
+
+/** Connects to a stream server.
+ *
+ * \param host
+ * Host name or address of the server.
+ *
+ * \param port
+ * TCP port of the server.
+ *
+ * \param client_handle
+ * If successful, this contains a pointer to the new client handle. Caller must call k4a_stream_client_close() when
+ * finished with the stream.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_client_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the server can not be reached or
+ * is not a stream server.
+ *
+ * \remarks
+ * A client is read like an opened device: k4a_stream_client_get_capture() waits for the next capture like
+ * k4a_device_get_capture(), and k4a_stream_client_get_calibration() returns the calibration of the streamed device.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_client_open(const char *host,
+                                                     uint16_t port,
+                                                     k4a_stream_client_t *client_handle);
+
+/** Gets the configuration the streamed device was started with.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_stream_client_open().
+ *
+ * \param device_config
+ * Location to write the configuration.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_client_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if an error occurred.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_client_get_device_configuration(k4a_stream_client_t client_handle,
+                                                                         k4a_device_configuration_t *device_config);
+
+/** Gets the calibration of the streamed device.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_stream_client_open().
+ *
+ * \param calibration
+ * Location to write the calibration.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_client_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success, or ::K4A_RESULT_FAILED if the server was created without a
+ * device or an error occurred.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_stream_client_get_calibration(k4a_stream_client_t client_handle,
+                                                                k4a_calibration_t *calibration);
+
+/** Reads the next capture from a stream server.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_stream_client_open().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done
+ * using this capture.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the capture. If set to 0, the function
+ * will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available
+ * or the connection is lost.
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_client_t
+ *
+ * \returns ::K4A_WAIT_RESULT_SUCCEEDED if a capture is returned, ::K4A_WAIT_RESULT_TIMEOUT if no capture arrived in
+ * time, or ::K4A_WAIT_RESULT_FAILED if the connection to the server was lost.
+ *
+ * \remarks
+ * Captures are received in the background and decoded to the image formats they were captured in. If the caller reads
+ * captures slower than they arrive, the oldest unread capture is dropped, as k4a_device_get_capture() does.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_wait_result_t k4a_stream_client_get_capture(k4a_stream_client_t client_handle,
+                                                                 k4a_capture_t *capture_handle,
+                                                                 int32_t timeout_in_ms);
+
+/** Disconnects from a stream server.
+ *
+ * \param client_handle
+ * Handle obtained by k4a_stream_client_open().
+ *
+ * \headerfile stream.h <k4arecord/stream.h>
+ *
+ * \relates k4a_stream_client_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">stream.h (include k4arecord/stream.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_stream_client_close(k4a_stream_client_t client_handle);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* K4A_STREAM_H */
@@ -63,6 +63,96 @@ K4A_DECLARE_HANDLE(k4a_playback_t);
  */
 K4A_DECLARE_HANDLE(k4a_playback_data_block_t)
 
+/** \class k4a_playback_cursor_t types.h <k4arecord/types.h>
+ * Handle to an independent read position in a k4a_playback_t recording.
+ *
+ * \remarks
+ * Handles are created with k4a_playback_cursor_create(), and destroyed with k4a_playback_cursor_destroy().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_playback_cursor_t);
+
+/** \class k4a_playback_group_t types.h <k4arecord/types.h>
+ * Handle to a group of recordings from synchronized devices that are played back together.
+ *
+ * \remarks
+ * Handles are created with k4a_playback_group_open(), and closed with k4a_playback_group_close().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_playback_group_t);
+
+/** \class k4a_capture_history_t types.h <k4arecord/types.h>
+ * Handle to a bounded history of the most recent captures.
+ *
+ * \remarks
+ * Handles are created with k4a_capture_history_create(), and destroyed with k4a_capture_history_destroy().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_capture_history_t);
+
+/** \class k4a_stream_server_t types.h <k4arecord/types.h>
+ * Handle to a server streaming captures to clients over the network.
+ *
+ * \remarks
+ * Handles are created with k4a_stream_server_create(), and closed with k4a_stream_server_close().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_stream_server_t);
+
+/** \class k4a_stream_client_t types.h <k4arecord/types.h>
+ * Handle to a connection receiving captures from a k4a_stream_server_t.
+ *
+ * \remarks
+ * Handles are created with k4a_stream_client_open(), and closed with k4a_stream_client_close().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_stream_client_t);
+
+/** \class k4a_point_cloud_writer_t types.h <k4arecord/types.h>
+ * Handle to a writer of point cloud files.
+ *
+ * \remarks
+ * Handles are created with k4a_point_cloud_writer_create(), and closed with k4a_point_cloud_writer_close().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_point_cloud_writer_t);
+
 /**
  * @}
  *
@@ -110,6 +200,18 @@ K4A_DECLARE_HANDLE(k4a_playback_data_block_t)
  */
 #define K4A_TRACK_NAME_IMU "IMU"
 
+/** Name of the built-in preview track used in recordings.
+ *
+ * \see k4a_record_add_preview_track()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+#define K4A_TRACK_NAME_PREVIEW "PREVIEW"
+
 /**
  * @}
  *
@@ -147,6 +249,213 @@ typedef enum
     K4A_PLAYBACK_SEEK_DEVICE_TIME /**< Seek to an absolute device timestamp. */
 } k4a_playback_seek_origin_t;
 
+/** Codecs used to store the depth and IR tracks of a recording.
+ *
+ * \see k4a_record_set_depth_codec()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_DEPTH_CODEC_RAW = 0, /**< Uncompressed 16-bit grayscale (b16g). */
+    K4A_RECORD_DEPTH_CODEC_RVL,     /**< Lossless RVL compression (RVL1). */
+} k4a_record_depth_codec_t;
+
+/** Codecs used to store the color track of a recording.
+ *
+ * \see k4a_record_set_color_codec()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_COLOR_CODEC_RAW = 0, /**< The color format of the device, as it is captured. */
+    K4A_RECORD_COLOR_CODEC_MJPG,    /**< NV12 and YUY2 color images are compressed to MJPG. */
+} k4a_record_color_codec_t;
+
+/** What k4a_record_write_capture() does when the recording write queue is full.
+ *
+ * \see k4a_record_set_write_queue_limit()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_WRITE_QUEUE_BLOCK = 0,    /**< Wait until data written to disk makes room for the capture. */
+    K4A_RECORD_WRITE_QUEUE_DROP_COLOR,   /**< Drop the color image, then the rest of the capture if it doesn't fit. */
+    K4A_RECORD_WRITE_QUEUE_DROP_CAPTURE, /**< Drop the whole capture. */
+    K4A_RECORD_WRITE_QUEUE_FAIL,         /**< Fail without writing the capture. */
+} k4a_record_write_queue_policy_t;
+
+/** File formats of point clouds written by a k4a_point_cloud_writer_t.
+ *
+ * \see k4a_point_cloud_writer_create()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_POINT_CLOUD_FILE_FORMAT_PLY = 0, /**< Binary little endian PLY. */
+    K4A_POINT_CLOUD_FILE_FORMAT_PCD,     /**< Binary PCD version 0.7. */
+} k4a_point_cloud_file_format_t;
+
+/**
+ * @}
+ *
+ * \addtogroup Prototypes
+ * @{
+ */
+
+/** Callback function for a capture read by k4a_playback_process_range().
+ *
+ * \param capture_handle
+ * The capture that was read. The capture is released when the callback returns, call k4a_capture_reference() to keep
+ * it longer.
+ *
+ * \param context
+ * The context supplied by the caller as \p callback_context to k4a_playback_process_range().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED to continue processing, or ::K4A_RESULT_FAILED to stop processing the range.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef k4a_result_t(k4a_playback_capture_cb_t)(k4a_capture_t capture_handle, void *context);
+
+/** Callback function called when k4a_capture_history_dump() has finished writing.
+ *
+ * \param result
+ * ::K4A_RESULT_SUCCEEDED if every capture was written to the recording, ::K4A_RESULT_FAILED otherwise.
+ *
+ * \param context
+ * The context supplied by the caller as \p callback_context to k4a_capture_history_dump().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef void(k4a_capture_history_dump_cb_t)(k4a_result_t result, void *context);
+
+/** Callback function that compresses a color image for a recording, see k4a_record_set_color_encoder().
+ *
+ * \param color_image
+ * The color image to compress, in the color format of the recording. The image is only valid during the call.
+ *
+ * \param encoded_data
+ * Set to the compressed frame. The data must stay valid until the next call to the callback.
+ *
+ * \param encoded_size
+ * Set to the size of the compressed frame in bytes.
+ *
+ * \param key_frame
+ * Set to true if the frame can be decoded without the frames before it.
+ *
+ * \param context
+ * The context supplied by the caller as \p callback_context to k4a_record_set_color_encoder().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the frame was compressed, or ::K4A_RESULT_FAILED to drop the frame.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef k4a_result_t(k4a_record_color_encode_cb_t)(k4a_image_t color_image,
+                                                   const uint8_t **encoded_data,
+                                                   size_t *encoded_size,
+                                                   bool *key_frame,
+                                                   void *context);
+
+/** Callback function that decompresses a color frame of a recording, see k4a_playback_set_color_decoder().
+ *
+ * \param encoded_data
+ * The compressed frame, as returned by the encoder of the recording. The data is only valid during the call.
+ *
+ * \param encoded_size
+ * The size of the compressed frame in bytes.
+ *
+ * \param device_timestamp_usec
+ * The device timestamp of the frame in microseconds.
+ *
+ * \param target_format
+ * The format of the image to create, see k4a_playback_set_color_conversion().
+ *
+ * \param color_image
+ * Set to a new image in \p target_format, which is released by the caller. NULL if the frame is only decoded as a
+ * reference for the frames after it, and no image is needed.
+ *
+ * \param context
+ * The context supplied by the caller as \p callback_context to k4a_playback_set_color_decoder().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the frame was decoded, ::K4A_RESULT_FAILED otherwise.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef k4a_result_t(k4a_playback_color_decode_cb_t)(const uint8_t *encoded_data,
+                                                     size_t encoded_size,
+                                                     uint64_t device_timestamp_usec,
+                                                     k4a_image_format_t target_format,
+                                                     k4a_image_t *color_image,
+                                                     void *context);
+
+/** Callback function that reads a recording opened with k4a_playback_open_custom_io().
+ *
+ * \param offset
+ * The position in the recording of the first byte to read.
+ *
+ * \param buffer
+ * Location to write the data.
+ *
+ * \param size
+ * The number of bytes to read. Reads never extend past the end of the recording.
+ *
+ * \param context
+ * The context supplied by the caller as \p callback_context to k4a_playback_open_custom_io().
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if all \p size bytes were written to \p buffer, ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * The callback is called from several threads at once to read different parts of the recording in parallel, for
+ * example with one HTTP range request per call.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef k4a_result_t(k4a_playback_read_cb_t)(uint64_t offset, void *buffer, size_t size, void *context);
+
 /**
  * @}
  *
@@ -250,6 +559,54 @@ typedef struct _k4a_record_subtitle_settings_t
     bool high_freq_data;
 } k4a_record_subtitle_settings_t;
 
+/** Structure containing the settings of the preview track of a recording.
+ *
+ * \see k4a_record_add_preview_track()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_record_preview_settings_t
+{
+    k4a_color_scale_t scale; /**< Size of the preview images relative to the color and depth resolutions */
+    uint32_t interval_usec;  /**< Minimum time between two previews in microseconds */
+    uint32_t jpeg_quality;   /**< JPEG quality of the preview color images, from 1 to 100 */
+    uint32_t max_depth_mm;   /**< Depth shown as 255 in the 8 bit preview depth images, farther depth is clamped */
+} k4a_record_preview_settings_t;
+
+/** Structure describing one block of data for k4a_record_write_custom_track_data_batch().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_record_custom_track_block_t
+{
+    uint64_t device_timestamp_usec; /**< Timestamp of the block in microseconds, in the device time domain */
+    const uint8_t *custom_data;     /**< Buffer of custom track data, copied by the recording */
+    size_t custom_data_size;        /**< Size of the custom track data buffer in bytes */
+} k4a_record_custom_track_block_t;
+
+/** Structure describing one data block returned by k4a_playback_get_data_blocks().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_playback_data_block_info_t
+{
+    uint64_t device_timestamp_usec; /**< Device timestamp of the block in microseconds */
+    size_t buffer_offset;           /**< Offset of the block's data in the caller's buffer */
+    size_t buffer_size;             /**< Size of the block's data in bytes */
+} k4a_playback_data_block_info_t;
+
 /**
  * @}
  */
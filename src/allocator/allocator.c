@@ -1,6 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#ifdef __linux__
+#define _GNU_SOURCE // MAP_HUGETLB and MADV_HUGEPAGE in sys/mman.h
+#endif
+
 // This library
 #include <k4ainternal/allocator.h>
 
@@ -16,6 +20,13 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 typedef enum
 {
@@ -25,15 +36,97 @@ typedef enum
     IMAGE_TYPE_COUNT,
 } image_type_index_t;
 
+#define ALLOCATION_SOURCE_COUNT (ALLOCATION_SOURCE_USB_IMU + 1)
+
+#ifdef _WIN32
+#define allocator_atomic_load(ptr) InterlockedCompareExchange((ptr), 0, 0)
+#define allocator_atomic_increment(ptr) InterlockedIncrement(ptr)
+#define allocator_atomic_load_pointer(ptr) InterlockedCompareExchangePointer((PVOID volatile *)(ptr), NULL, NULL)
+#define allocator_atomic_store_pointer(ptr, value)                                                                     \
+    ((void)InterlockedExchangePointer((PVOID volatile *)(ptr), (PVOID)(value)))
+#define allocator_atomic_exchange_pointer(ptr, value)                                                                  \
+    InterlockedExchangePointer((PVOID volatile *)(ptr), (PVOID)(value))
+#define allocator_atomic_load64(ptr) InterlockedCompareExchange64((ptr), 0, 0)
+#define allocator_atomic_add64(ptr, value) InterlockedExchangeAdd64((ptr), (value))
+#define allocator_atomic_cas64(ptr, expected, desired)                                                                 \
+    (InterlockedCompareExchange64((ptr), (desired), (expected)) == (expected))
+#else
+#define allocator_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define allocator_atomic_increment(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#define allocator_atomic_load_pointer(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define allocator_atomic_store_pointer(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define allocator_atomic_exchange_pointer(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define allocator_atomic_load64(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define allocator_atomic_add64(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_SEQ_CST)
+#define allocator_atomic_cas64(ptr, expected, desired)                                                                 \
+    __atomic_compare_exchange_n((ptr), &(int64_t){ (expected) }, (desired), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#endif
+
+// Freed buffers of a single allocation source kept for reuse. Buffer sizes for a source are fixed while streaming, so
+// each pool holds one size class; freeing a buffer of a different size releases the pooled buffers and starts a new
+// class. The free list is linked through the payload of each pooled buffer.
+typedef struct
+{
+    k4a_rwlock_t lock;
+
+    // Access to these members may only occur while holding lock
+    size_t alloc_size;
+    uint32_t count;
+    void *free_list;
+
+    // Buffers of alloc_size kept whatever the pooling limit, see allocator_pool_reserve(). Read without the lock to
+    // skip pools that are neither enabled nor reserved.
+    volatile uint32_t reserved;
+} allocator_pool_t;
+
+// Freed handles of a single handle type kept for reuse. The first pointer of a handle is its type tag, cleared when the
+// handle was destroyed so stale handles keep failing validation; the free list is linked through the second pointer.
+typedef struct
+{
+    k4a_rwlock_t lock;
+
+    // Access to these members may only occur while holding lock
+    size_t size;
+    uint32_t count;
+    void *free_list;
+} allocator_handle_pool_t;
+
+// Usage statistics of a single allocation source, see k4a_allocator_source_stats_t. Updated with atomic operations so
+// allocating and freeing never take a lock; a reader may see the counters of a single source slightly out of step.
+typedef struct
+{
+    volatile int64_t live_count;
+    volatile int64_t live_bytes;
+    volatile int64_t peak_bytes;
+    volatile int64_t total_allocations;
+} allocator_stats_t;
+
 // Global properties of the allocator
 typedef struct
 {
+    // Serializes changes of the allocate and free callbacks. Readers do not take it, see allocator_get_callbacks().
     k4a_rwlock_t lock;
 
-    // Access to these function pointers may only occur
-    // while holding lock
-    k4a_memory_allocate_cb_t *alloc;
-    k4a_memory_destroy_cb_t *free;
+    // Odd while the callbacks are being changed, incremented before and after each change
+    volatile long sequence;
+
+    // Access to these function pointers may only occur through allocator_get_callbacks() and
+    // allocator_set_callbacks(). alloc_ex is used instead of alloc when it is set.
+    k4a_memory_allocate_cb_t *volatile alloc;
+    k4a_memory_allocate_ex_cb_t *volatile alloc_ex;
+    void *volatile alloc_ex_context;
+    k4a_memory_destroy_cb_t *volatile free;
+
+    // Maximum number of freed buffers kept per allocation source, 0 disables pooling
+    volatile long pool_high_water_mark;
+
+    // Memory budget of each device, playback and recording, 0 for the default buffer counts
+    volatile size_t memory_budget;
+
+    allocator_pool_t pool[ALLOCATION_SOURCE_COUNT];
+    allocator_handle_pool_t handle_pool[HANDLE_POOL_COUNT];
+
+    allocator_stats_t stats[ALLOCATION_SOURCE_COUNT];
 } allocator_global_t;
 
 // This allocator implementation is used by default
@@ -55,6 +148,117 @@ static void default_free(void *buffer, void *context)
     free(buffer);
 }
 
+// Allocations smaller than this are not worth a huge page and are served from the heap by huge_page_alloc()
+#define HUGE_PAGE_MIN_ALLOC_SIZE (1024 * 1024)
+
+// Size of the huge pages requested on Linux
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// NUMA node huge_page_alloc() binds the buffers allocated by the calling thread to, -1 for no preference
+static THREAD_LOCAL int g_thread_numa_node = -1;
+
+#ifdef __linux__
+// MPOL_PREFERRED from linux/mempolicy.h, which is not installed by every distribution
+#define HUGE_PAGE_MPOL_PREFERRED (1)
+
+// Number of nodes covered by the node mask passed to mbind()
+#define HUGE_PAGE_MAX_NUMA_NODES (64)
+#endif
+
+// This allocator implementation is used by allocator_set_huge_pages(). Frame sized buffers are mapped from huge pages,
+// falling back to regular pages when none are available, and placed on the NUMA node set for the calling thread. The
+// context is NULL for buffers from the heap and the mapped size otherwise.
+static uint8_t *huge_page_alloc(int size, void **context)
+{
+    *context = NULL;
+    if (size < 0)
+    {
+        return NULL;
+    }
+    if (size < HUGE_PAGE_MIN_ALLOC_SIZE)
+    {
+        return (uint8_t *)malloc((size_t)size);
+    }
+
+#ifdef _WIN32
+    DWORD numa_node = g_thread_numa_node >= 0 ? (DWORD)g_thread_numa_node : NUMA_NO_PREFERRED_NODE;
+    SIZE_T large_page_size = GetLargePageMinimum();
+    void *buffer = NULL;
+    if (large_page_size != 0)
+    {
+        // Large pages require SeLockMemoryPrivilege, without it the allocation fails and regular pages are used
+        SIZE_T map_size = ((SIZE_T)size + large_page_size - 1) & ~(large_page_size - 1);
+        buffer = VirtualAllocExNuma(GetCurrentProcess(),
+                                    NULL,
+                                    map_size,
+                                    MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                    PAGE_READWRITE,
+                                    numa_node);
+    }
+    if (buffer == NULL)
+    {
+        buffer = VirtualAllocExNuma(
+            GetCurrentProcess(), NULL, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, numa_node);
+    }
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    *context = (void *)(uintptr_t)size;
+    return (uint8_t *)buffer;
+#elif defined(__linux__)
+    size_t map_size = ((size_t)size + HUGE_PAGE_SIZE - 1) & ~((size_t)HUGE_PAGE_SIZE - 1);
+    void *buffer = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (buffer == MAP_FAILED)
+    {
+        // No huge pages reserved, ask for transparent huge pages instead
+        buffer = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
+        {
+            return NULL;
+        }
+        (void)madvise(buffer, map_size, MADV_HUGEPAGE);
+    }
+
+    // Pages are not faulted in yet, so the policy decides where they land. Failing to set it leaves the buffer wherever
+    // the kernel puts it, which is still a valid buffer.
+    int numa_node = g_thread_numa_node;
+    if (numa_node >= 0 && numa_node < HUGE_PAGE_MAX_NUMA_NODES)
+    {
+        unsigned long node_mask = 1UL << numa_node;
+        (void)syscall(
+            SYS_mbind, buffer, map_size, HUGE_PAGE_MPOL_PREFERRED, &node_mask, HUGE_PAGE_MAX_NUMA_NODES + 1, 0);
+    }
+
+    *context = (void *)(uintptr_t)map_size;
+    return (uint8_t *)buffer;
+#else
+    return (uint8_t *)malloc((size_t)size);
+#endif
+}
+
+// This is the free function for the huge page allocator
+static void huge_page_free(void *buffer, void *context)
+{
+    if (context == NULL)
+    {
+        free(buffer);
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(buffer, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    munmap(buffer, (size_t)(uintptr_t)context);
+#endif
+}
+
 // This is a one time initialization of the global state for the allocator
 static void allocator_global_init(allocator_global_t *g_allocator)
 {
@@ -62,10 +266,21 @@ static void allocator_global_init(allocator_global_t *g_allocator)
 
     g_allocator->alloc = default_alloc;
     g_allocator->free = default_free;
+
+    g_allocator->pool_high_water_mark = 0;
+    for (int i = 0; i < ALLOCATION_SOURCE_COUNT; i++)
+    {
+        rwlock_init(&g_allocator->pool[i].lock);
+    }
+    for (int i = 0; i < HANDLE_POOL_COUNT; i++)
+    {
+        rwlock_init(&g_allocator->handle_pool[i].lock);
+    }
 }
 
-// The allocation context is pre-pended to memory returned by the allocator
-// This state is used to track the freeing of the allocation
+// The allocation context is stored immediately before each buffer returned by allocator_alloc(), the buffer itself
+// starts at the first ALLOCATOR_ALIGNMENT boundary after the context. This state is used to track the freeing of the
+// allocation.
 typedef struct _allocation_context_t
 {
     union _allocator_context
@@ -75,10 +290,11 @@ typedef struct _allocation_context_t
             allocation_source_t source;
             k4a_memory_destroy_cb_t *free;
             void *free_context;
+            void *full_buffer; // Memory returned by the allocate callback, passed back to the free callback
+            size_t size;
         } context;
 
-        // Keep 16 byte alignment so that allocations may be used with SSE
-        char alignment[32];
+        char alignment[ALLOCATOR_ALIGNMENT];
     } u;
 } allocation_context_t;
 
@@ -105,17 +321,213 @@ static volatile long g_allocated_image_count_usb_imu = 0;
 // Count the number of active sessions for this process. A session maps to k4a_device_open
 static volatile long g_allocator_sessions = 0;
 
+// Captures are filled in by the thread that creates them and are not changed once they are shared, so the accessors
+// don't lock. The image slots are still swapped atomically so a setter never loses a reference.
 typedef struct _capture_context_t
 {
     volatile long ref_count;
-    k4a_rwlock_t lock;
 
     k4a_image_t image[IMAGE_TYPE_COUNT];
 
     float temperature_c; /** Temperature in Celsius */
+
+    uint64_t latency_timestamp_nsec[K4A_LATENCY_STAGE_NUM]; /** End of each latency stage the capture went through */
+
+    k4a_imu_sample_t *imu_samples; /** IMU samples of the exposure, see capture_set_imu_samples() */
+    size_t imu_sample_count;
 } capture_context_t;
 
-K4A_DECLARE_CONTEXT(k4a_capture_t, capture_context_t);
+static void *capture_handle_alloc(size_t size)
+{
+    return allocator_handle_alloc(HANDLE_POOL_CAPTURE, size);
+}
+
+static void capture_handle_free(void *handle)
+{
+    allocator_handle_free(HANDLE_POOL_CAPTURE, handle);
+}
+
+K4A_DECLARE_POOLED_CONTEXT(k4a_capture_t, capture_context_t, capture_handle_alloc, capture_handle_free);
+
+// Allocate and free callbacks that are set and read together
+typedef struct
+{
+    k4a_memory_allocate_cb_t *alloc;
+    k4a_memory_allocate_ex_cb_t *alloc_ex; // Used instead of alloc when not NULL
+    void *alloc_ex_context;
+    k4a_memory_destroy_cb_t *free;
+} allocator_callbacks_t;
+
+// Replaces the allocate and free callbacks. Readers that overlap the change retry, see allocator_get_callbacks().
+static void allocator_set_callbacks(allocator_global_t *g_allocator, const allocator_callbacks_t *callbacks)
+{
+    rwlock_acquire_write(&g_allocator->lock);
+
+    allocator_atomic_increment(&g_allocator->sequence);
+    allocator_atomic_store_pointer(&g_allocator->alloc, callbacks->alloc);
+    allocator_atomic_store_pointer(&g_allocator->alloc_ex, callbacks->alloc_ex);
+    allocator_atomic_store_pointer(&g_allocator->alloc_ex_context, callbacks->alloc_ex_context);
+    allocator_atomic_store_pointer(&g_allocator->free, callbacks->free);
+    allocator_atomic_increment(&g_allocator->sequence);
+
+    rwlock_release_write(&g_allocator->lock);
+}
+
+// Reads a matching set of allocate and free callbacks. The callbacks change a handful of times per process at most,
+// so every allocation reads them without taking a lock and only retries when it overlaps a change.
+static void allocator_get_callbacks(allocator_global_t *g_allocator, allocator_callbacks_t *callbacks)
+{
+    long sequence;
+    do
+    {
+        sequence = allocator_atomic_load(&g_allocator->sequence);
+        callbacks->alloc = (k4a_memory_allocate_cb_t *)allocator_atomic_load_pointer(&g_allocator->alloc);
+        callbacks->alloc_ex = (k4a_memory_allocate_ex_cb_t *)allocator_atomic_load_pointer(&g_allocator->alloc_ex);
+        callbacks->alloc_ex_context = allocator_atomic_load_pointer(&g_allocator->alloc_ex_context);
+        callbacks->free = (k4a_memory_destroy_cb_t *)allocator_atomic_load_pointer(&g_allocator->free);
+    } while ((sequence & 1) != 0 || allocator_atomic_load(&g_allocator->sequence) != sequence);
+}
+
+// Frees a list of pooled buffers with the free function recorded at the time each one was allocated. The list holds the
+// allocation context of each buffer.
+static void allocator_release_list(void *header)
+{
+    while (header != NULL)
+    {
+        allocation_context_t allocation_context;
+        void *next;
+
+        memcpy(&allocation_context, header, sizeof(allocation_context));
+        memcpy(&next, (uint8_t *)header + sizeof(allocation_context_t), sizeof(next));
+
+        allocation_context.u.context.free(allocation_context.u.context.full_buffer,
+                                          allocation_context.u.context.free_context);
+        header = next;
+    }
+}
+
+// Releases every buffer held by the pools
+static void allocator_release_pools(allocator_global_t *g_allocator)
+{
+    for (int i = 0; i < ALLOCATION_SOURCE_COUNT; i++)
+    {
+        allocator_pool_t *pool = &g_allocator->pool[i];
+
+        rwlock_acquire_write(&pool->lock);
+        void *free_list = pool->free_list;
+        pool->free_list = NULL;
+        pool->count = 0;
+        rwlock_release_write(&pool->lock);
+
+        allocator_release_list(free_list);
+    }
+
+    for (int i = 0; i < HANDLE_POOL_COUNT; i++)
+    {
+        allocator_handle_pool_t *pool = &g_allocator->handle_pool[i];
+
+        rwlock_acquire_write(&pool->lock);
+        void *free_list = pool->free_list;
+        pool->free_list = NULL;
+        pool->count = 0;
+        rwlock_release_write(&pool->lock);
+
+        while (free_list != NULL)
+        {
+            void *next;
+            memcpy(&next, (uint8_t *)free_list + sizeof(void *), sizeof(next));
+            free(free_list);
+            free_list = next;
+        }
+    }
+}
+
+// Takes a buffer of alloc_size bytes from the pool, returns its allocation context or NULL if the pool has none
+static void *allocator_pool_take(allocator_pool_t *pool, size_t alloc_size)
+{
+    void *header = NULL;
+
+    rwlock_acquire_write(&pool->lock);
+    if (pool->count > 0 && pool->alloc_size == alloc_size)
+    {
+        header = pool->free_list;
+        memcpy(&pool->free_list, (uint8_t *)header + sizeof(allocation_context_t), sizeof(pool->free_list));
+        pool->count--;
+    }
+    rwlock_release_write(&pool->lock);
+
+    return header;
+}
+
+// Offers a freed buffer, by its allocation context, to the pool. Returns false if the buffer was not kept and must be
+// freed by the caller
+static bool allocator_pool_give(allocator_pool_t *pool, void *header, size_t alloc_size, uint32_t high_water_mark)
+{
+    void *stale_list = NULL;
+    bool pooled = false;
+
+    if ((high_water_mark == 0 && pool->reserved == 0) || alloc_size < sizeof(void *))
+    {
+        return false;
+    }
+
+    rwlock_acquire_write(&pool->lock);
+    if (pool->reserved > 0)
+    {
+        // A reserved pool keeps its size class, buffers of other sizes are freed
+        if (pool->alloc_size == alloc_size)
+        {
+            high_water_mark = MAX(high_water_mark, pool->reserved);
+        }
+    }
+    else if (pool->alloc_size != alloc_size)
+    {
+        // The source changed its buffer size, the pooled buffers will not be used again
+        stale_list = pool->free_list;
+        pool->free_list = NULL;
+        pool->count = 0;
+        pool->alloc_size = alloc_size;
+    }
+
+    if (pool->alloc_size == alloc_size && pool->count < high_water_mark)
+    {
+        memcpy((uint8_t *)header + sizeof(allocation_context_t), &pool->free_list, sizeof(pool->free_list));
+        pool->free_list = header;
+        pool->count++;
+        pooled = true;
+    }
+    rwlock_release_write(&pool->lock);
+
+    allocator_release_list(stale_list);
+
+    return pooled;
+}
+
+// Records an allocation (allocated == true) or free of alloc_size bytes
+static void allocator_update_stats(allocator_stats_t *stats, size_t alloc_size, bool allocated)
+{
+    if (allocated)
+    {
+        allocator_atomic_add64(&stats->live_count, 1);
+        allocator_atomic_add64(&stats->total_allocations, 1);
+        int64_t live_bytes = allocator_atomic_add64(&stats->live_bytes, (int64_t)alloc_size) + (int64_t)alloc_size;
+
+        // Raise peak_bytes to live_bytes unless another thread already raised it further
+        int64_t peak_bytes = allocator_atomic_load64(&stats->peak_bytes);
+        while (live_bytes > peak_bytes && !allocator_atomic_cas64(&stats->peak_bytes, peak_bytes, live_bytes))
+        {
+            peak_bytes = allocator_atomic_load64(&stats->peak_bytes);
+        }
+    }
+    else
+    {
+        int64_t live_count = allocator_atomic_add64(&stats->live_count, -1);
+        int64_t live_bytes = allocator_atomic_add64(&stats->live_bytes, -(int64_t)alloc_size);
+        assert(live_count > 0 && live_bytes >= (int64_t)alloc_size);
+        (void)live_count;
+        (void)live_bytes;
+    }
+}
 
 void allocator_initialize(void)
 {
@@ -124,7 +536,11 @@ void allocator_initialize(void)
 
 void allocator_deinitialize(void)
 {
-    DEC_REF_VAR(g_allocator_sessions);
+    if (DEC_REF_VAR(g_allocator_sessions) == 0)
+    {
+        // Don't hold on to pooled memory once the last session has ended
+        allocator_release_pools(allocator_global_t_get());
+    }
 }
 
 k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memory_destroy_cb_t free)
@@ -133,24 +549,236 @@ k4a_result_t allocator_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memo
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, allocate != NULL && free == NULL);
 
     allocator_global_t *g_allocator = allocator_global_t_get();
-    rwlock_acquire_write(&g_allocator->lock);
+    allocator_callbacks_t callbacks = { allocate ? allocate : default_alloc, NULL, NULL, free ? free : default_free };
+    allocator_set_callbacks(g_allocator, &callbacks);
 
-    g_allocator->alloc = allocate ? allocate : default_alloc;
-    g_allocator->free = free ? free : default_free;
+    // Buffers pooled from the previous allocator would otherwise keep being handed out
+    allocator_release_pools(g_allocator);
 
-    rwlock_release_write(&g_allocator->lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t allocator_set_allocator_ex(k4a_memory_allocate_ex_cb_t allocate,
+                                        k4a_memory_destroy_cb_t free,
+                                        void *user_context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, allocate == NULL && free != NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, allocate != NULL && free == NULL);
+
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    allocator_callbacks_t callbacks = { default_alloc, allocate, user_context, free ? free : default_free };
+    allocator_set_callbacks(g_allocator, &callbacks);
+
+    allocator_release_pools(g_allocator);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t allocator_set_huge_pages(bool enable)
+{
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    allocator_callbacks_t callbacks = {
+        enable ? huge_page_alloc : default_alloc, NULL, NULL, enable ? huge_page_free : default_free
+    };
+    allocator_set_callbacks(g_allocator, &callbacks);
+
+    allocator_release_pools(g_allocator);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void allocator_set_thread_numa_node(int numa_node)
+{
+    g_thread_numa_node = numa_node;
+}
+
+k4a_result_t allocator_set_pooling(uint32_t max_pooled_buffers)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, max_pooled_buffers > ALLOCATOR_MAX_POOLED_BUFFERS);
+
+    allocator_global_t *g_allocator = allocator_global_t_get();
+
+    g_allocator->pool_high_water_mark = (long)max_pooled_buffers;
+    allocator_release_pools(g_allocator);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t allocator_pool_reserve(allocation_source_t source, size_t alloc_size, uint32_t count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, alloc_size < sizeof(void *) || alloc_size > INT32_MAX);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, count == 0 || count > ALLOCATOR_MAX_POOLED_BUFFERS);
+
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    allocator_pool_t *pool = &g_allocator->pool[source];
+    void *stale_list = NULL;
+    uint32_t reserved = 0;
+
+    rwlock_acquire_write(&pool->lock);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(pool->reserved == 0 || pool->alloc_size == alloc_size);
+    if (K4A_SUCCEEDED(result))
+    {
+        if (pool->alloc_size != alloc_size)
+        {
+            stale_list = pool->free_list;
+            pool->free_list = NULL;
+            pool->count = 0;
+            pool->alloc_size = alloc_size;
+        }
+        pool->reserved = MIN(pool->reserved + count, ALLOCATOR_MAX_POOLED_BUFFERS);
+        reserved = pool->reserved;
+    }
+    rwlock_release_write(&pool->lock);
+
+    allocator_release_list(stale_list);
+
+    if (K4A_FAILED(result))
+    {
+        LOG_WARNING("Buffers of %llu bytes can't be reserved, the pool is reserved for buffers of another size",
+                    (unsigned long long)alloc_size);
+        return result;
+    }
+
+    // Allocating the reserved number of buffers and freeing them again fills the pool, the allocations take the buffers
+    // that are already pooled first
+    uint8_t **buffers = (uint8_t **)malloc(reserved * sizeof(uint8_t *));
+    result = K4A_RESULT_FROM_BOOL(buffers != NULL);
+    uint32_t allocated = 0;
+    while (K4A_SUCCEEDED(result) && allocated < reserved)
+    {
+        buffers[allocated] = allocator_alloc(source, alloc_size);
+        result = K4A_RESULT_FROM_BOOL(buffers[allocated] != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            allocated++;
+        }
+    }
+
+    for (uint32_t i = 0; i < allocated; i++)
+    {
+        allocator_free(buffers[i]);
+    }
+    free(buffers);
+
+    if (K4A_FAILED(result))
+    {
+        allocator_pool_unreserve(source, count);
+    }
+
+    return result;
+}
+
+void allocator_pool_unreserve(allocation_source_t source, uint32_t count)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    allocator_pool_t *pool = &g_allocator->pool[source];
+    void *stale_list = NULL;
+
+    rwlock_acquire_write(&pool->lock);
+    pool->reserved = pool->reserved > count ? pool->reserved - count : 0;
+
+    // Buffers beyond the remaining reservation and the pooling limit are released
+    uint32_t keep = MAX(pool->reserved, (uint32_t)g_allocator->pool_high_water_mark);
+    while (pool->count > keep)
+    {
+        void *header = pool->free_list;
+        memcpy(&pool->free_list, (uint8_t *)header + sizeof(allocation_context_t), sizeof(pool->free_list));
+        memcpy((uint8_t *)header + sizeof(allocation_context_t), &stale_list, sizeof(stale_list));
+        stale_list = header;
+        pool->count--;
+    }
+    rwlock_release_write(&pool->lock);
+
+    allocator_release_list(stale_list);
+}
+
+void allocator_set_memory_budget(size_t budget_bytes)
+{
+    allocator_global_t_get()->memory_budget = budget_bytes;
+}
+
+size_t allocator_get_memory_budget(void)
+{
+    return allocator_global_t_get()->memory_budget;
+}
+
+uint32_t allocator_budget_count(memory_budget_share_t share,
+                                size_t item_size,
+                                uint32_t min_count,
+                                uint32_t default_count)
+{
+    size_t budget = allocator_global_t_get()->memory_budget;
+    if (budget == 0 || item_size == 0)
+    {
+        return default_count;
+    }
+
+    size_t share_bytes = 0;
+    switch (share)
+    {
+    case MEMORY_BUDGET_USB_TRANSFERS:
+    case MEMORY_BUDGET_PLAYBACK_CACHE:
+        share_bytes = budget / 4;
+        break;
+    case MEMORY_BUDGET_CAPTURES:
+    case MEMORY_BUDGET_RECORDING:
+        share_bytes = budget / 2;
+        break;
+    default:
+        assert(0);
+        break;
+    }
+
+    size_t count = share_bytes / item_size;
+    return (uint32_t)MAX(MIN(count, (size_t)default_count), (size_t)min_count);
+}
+
+k4a_result_t allocator_get_stats(k4a_allocator_stats_t *stats)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    k4a_allocator_source_stats_t *values[ALLOCATION_SOURCE_COUNT];
+
+    values[ALLOCATION_SOURCE_USER] = &stats->user;
+    values[ALLOCATION_SOURCE_DEPTH] = &stats->depth;
+    values[ALLOCATION_SOURCE_COLOR] = &stats->color;
+    values[ALLOCATION_SOURCE_IMU] = &stats->imu;
+    values[ALLOCATION_SOURCE_USB_DEPTH] = &stats->usb_depth;
+    values[ALLOCATION_SOURCE_USB_IMU] = &stats->usb_imu;
+
+    for (int i = 0; i < ALLOCATION_SOURCE_COUNT; i++)
+    {
+        allocator_stats_t *source_stats = &g_allocator->stats[i];
+        values[i]->live_count = (uint64_t)allocator_atomic_load64(&source_stats->live_count);
+        values[i]->live_bytes = (uint64_t)allocator_atomic_load64(&source_stats->live_bytes);
+        values[i]->peak_bytes = (uint64_t)allocator_atomic_load64(&source_stats->peak_bytes);
+        values[i]->total_allocations = (uint64_t)allocator_atomic_load64(&source_stats->total_allocations);
+    }
 
     return K4A_RESULT_SUCCEEDED;
 }
 
 uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size)
+{
+    return allocator_alloc_image(source, K4A_IMAGE_FORMAT_CUSTOM, alloc_size);
+}
+
+uint8_t *allocator_alloc_image(allocation_source_t source, k4a_image_format_t format, size_t alloc_size)
 {
     allocator_global_t *g_allocator = allocator_global_t_get();
 
     RETURN_VALUE_IF_ARG(NULL, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
     RETURN_VALUE_IF_ARG(NULL, alloc_size == 0);
 
-    size_t required_bytes = alloc_size + sizeof(allocation_context_t);
+    RETURN_VALUE_IF_ARG(NULL, alloc_size > INT32_MAX);
+
+    // Round the size up so the last bytes of the buffer can be processed with full width vector instructions, and
+    // leave room to align the buffer after the allocation context
+    size_t required_bytes = ALLOCATOR_ALIGN_UP(alloc_size) + sizeof(allocation_context_t) + ALLOCATOR_ALIGNMENT - 1;
     RETURN_VALUE_IF_ARG(NULL, required_bytes > INT32_MAX);
 
     volatile long *ref = NULL;
@@ -181,42 +809,75 @@ uint8_t *allocator_alloc(allocation_source_t source, size_t alloc_size)
 
     INC_REF_VAR(*ref);
 
-    rwlock_acquire_read(&g_allocator->lock);
+    void *pooled_header = allocator_pool_take(&g_allocator->pool[source], alloc_size);
+    if (pooled_header != NULL)
+    {
+        allocator_update_stats(&g_allocator->stats[source], alloc_size, true);
+
+        // The allocation context of a pooled buffer is still valid
+        return (uint8_t *)pooled_header + sizeof(allocation_context_t);
+    }
 
-    void *user_context;
+    allocator_callbacks_t callbacks;
+    allocator_get_callbacks(g_allocator, &callbacks);
 
-    void *full_buffer = g_allocator->alloc((int)required_bytes, &user_context);
+    void *user_context = NULL;
+    void *full_buffer;
+    if (callbacks.alloc_ex != NULL)
+    {
+        // The buffer is requested aligned, so the allocation context starts it and no alignment slack is needed
+        k4a_allocation_info_t info;
+        info.size = ALLOCATOR_ALIGN_UP(alloc_size) + sizeof(allocation_context_t);
+        info.alignment = ALLOCATOR_ALIGNMENT;
+        info.source = (k4a_allocation_source_t)source;
+        info.format = format;
+        full_buffer = callbacks.alloc_ex(&info, callbacks.alloc_ex_context, &user_context);
+        if (full_buffer != NULL && ((uintptr_t)full_buffer & (ALLOCATOR_ALIGNMENT - 1)) != 0)
+        {
+            LOG_ERROR("User allocation function returned a buffer not aligned to %d bytes", ALLOCATOR_ALIGNMENT);
+            callbacks.free(full_buffer, user_context);
+            full_buffer = NULL;
+        }
+    }
+    else
+    {
+        full_buffer = callbacks.alloc((int)required_bytes, &user_context);
+    }
 
     // Store information about the allocation that we will need during free.
     allocation_context_t allocation_context;
 
     allocation_context.u.context.source = source;
-    allocation_context.u.context.free = g_allocator->free;
+    allocation_context.u.context.free = callbacks.free;
     allocation_context.u.context.free_context = user_context;
-
-    rwlock_release_read(&g_allocator->lock);
+    allocation_context.u.context.full_buffer = full_buffer;
+    allocation_context.u.context.size = alloc_size;
 
     if (full_buffer == NULL)
     {
         LOG_ERROR("User allocation function for %d bytes failed", required_bytes);
+        DEC_REF_VAR(*ref);
         return NULL;
     }
 
-    // Memcpy the context information to the header of the full buffer.
-    // Don't cast the buffer directly since there is no alignment constraint
-    memcpy(full_buffer, &allocation_context, sizeof(allocation_context));
+    allocator_update_stats(&g_allocator->stats[source], alloc_size, true);
+
+    // Provide the caller with the first aligned address after the allocation context header. The allocate callback of
+    // allocator_set_allocator() makes no alignment promise, so the header lands wherever the buffer alignment puts it.
+    uint8_t *buffer = (uint8_t *)ALLOCATOR_ALIGN_UP((uintptr_t)full_buffer + sizeof(allocation_context_t));
 
-    // Provide the caller with the buffer after the allocation context header.
-    uint8_t *buffer = (uint8_t *)full_buffer + sizeof(allocation_context_t);
+    // Memcpy the context information to the header in front of the buffer.
+    memcpy(buffer - sizeof(allocation_context_t), &allocation_context, sizeof(allocation_context));
 
     return buffer;
 }
 
-void allocator_free(void *buffer)
+// Frees a buffer, the pool of its source keeps it if it holds fewer than high_water_mark buffers
+static void allocator_free_buffer(void *buffer, uint32_t high_water_mark)
 {
-    void *full_buffer = (uint8_t *)buffer - sizeof(allocation_context_t);
+    void *header = (uint8_t *)buffer - sizeof(allocation_context_t);
     allocation_context_t allocation_context;
-    memcpy(&allocation_context, full_buffer, sizeof(allocation_context));
+    memcpy(&allocation_context, header, sizeof(allocation_context));
 
     allocation_source_t source = allocation_context.u.context.source;
 
@@ -252,8 +913,80 @@ void allocator_free(void *buffer)
 
     DEC_REF_VAR(*ref);
 
-    allocation_context.u.context.free(full_buffer, allocation_context.u.context.free_context);
-    full_buffer = NULL;
+    allocator_global_t *g_allocator = allocator_global_t_get();
+    allocator_update_stats(&g_allocator->stats[source], allocation_context.u.context.size, false);
+
+    if (allocator_pool_give(&g_allocator->pool[source], header, allocation_context.u.context.size, high_water_mark))
+    {
+        return;
+    }
+
+    allocation_context.u.context.free(allocation_context.u.context.full_buffer,
+                                      allocation_context.u.context.free_context);
+}
+
+void allocator_free(void *buffer)
+{
+    allocator_free_buffer(buffer, (uint32_t)allocator_global_t_get()->pool_high_water_mark);
+}
+
+void allocator_recycle(void *buffer)
+{
+    uint32_t high_water_mark = (uint32_t)allocator_global_t_get()->pool_high_water_mark;
+    allocator_free_buffer(buffer, MAX(high_water_mark, ALLOCATOR_RECYCLED_BUFFERS));
+}
+
+void *allocator_handle_alloc(handle_pool_t pool, size_t size)
+{
+    RETURN_VALUE_IF_ARG(NULL, pool < HANDLE_POOL_CAPTURE || pool >= HANDLE_POOL_COUNT);
+    RETURN_VALUE_IF_ARG(NULL, size < 2 * sizeof(void *));
+
+    allocator_handle_pool_t *handle_pool = &allocator_global_t_get()->handle_pool[pool];
+    void *handle = NULL;
+
+    rwlock_acquire_write(&handle_pool->lock);
+    assert(handle_pool->size == 0 || handle_pool->size == size);
+    handle_pool->size = size;
+    if (handle_pool->count > 0)
+    {
+        handle = handle_pool->free_list;
+        memcpy(&handle_pool->free_list, (uint8_t *)handle + sizeof(void *), sizeof(handle_pool->free_list));
+        handle_pool->count--;
+    }
+    rwlock_release_write(&handle_pool->lock);
+
+    if (handle != NULL)
+    {
+        memset(handle, 0, size);
+        return handle;
+    }
+
+    return calloc(1, size);
+}
+
+void allocator_handle_free(handle_pool_t pool, void *handle)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, pool < HANDLE_POOL_CAPTURE || pool >= HANDLE_POOL_COUNT);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, handle == NULL);
+
+    allocator_handle_pool_t *handle_pool = &allocator_global_t_get()->handle_pool[pool];
+    bool pooled = false;
+
+    // Handles are only pooled while a session is open, the pools are released when the last one ends
+    rwlock_acquire_write(&handle_pool->lock);
+    if (g_allocator_sessions > 0 && handle_pool->count < ALLOCATOR_MAX_POOLED_HANDLES)
+    {
+        memcpy((uint8_t *)handle + sizeof(void *), &handle_pool->free_list, sizeof(handle_pool->free_list));
+        handle_pool->free_list = handle;
+        handle_pool->count++;
+        pooled = true;
+    }
+    rwlock_release_write(&handle_pool->lock);
+
+    if (!pooled)
+    {
+        free(handle);
+    }
 }
 
 long allocator_test_for_leaks(void)
@@ -290,7 +1023,8 @@ long allocator_test_for_leaks(void)
            g_allocated_image_count_imu + g_allocated_image_count_usb_depth + g_allocated_image_count_usb_imu;
 }
 
-void capture_dec_ref(k4a_capture_t capture_handle)
+// Removes a reference, recycling the buffers of the images when it was the last reference and recycle is set
+static void capture_release(k4a_capture_t capture_handle, bool recycle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
@@ -300,20 +1034,33 @@ void capture_dec_ref(k4a_capture_t capture_handle)
 
     if (new_count == 0)
     {
-        rwlock_acquire_write(&capture->lock);
         for (int x = 0; x < IMAGE_TYPE_COUNT; x++)
         {
-            if (capture->image[x])
+            if (capture->image[x] && recycle)
+            {
+                image_recycle(capture->image[x]);
+            }
+            else if (capture->image[x])
             {
                 image_dec_ref(capture->image[x]);
             }
         }
-        rwlock_release_write(&capture->lock);
-        rwlock_deinit(&capture->lock);
+        free(capture->imu_samples);
+        capture->imu_samples = NULL;
         k4a_capture_t_destroy(capture_handle);
     }
 }
 
+void capture_dec_ref(k4a_capture_t capture_handle)
+{
+    capture_release(capture_handle, false);
+}
+
+void capture_recycle(k4a_capture_t capture_handle)
+{
+    capture_release(capture_handle, true);
+}
+
 void capture_inc_ref(k4a_capture_t capture_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
@@ -333,57 +1080,39 @@ k4a_result_t capture_create(k4a_capture_t *capture_handle)
     {
         capture->ref_count = 1;
         capture->temperature_c = NAN;
-        rwlock_init(&capture->lock);
     }
 
     return result;
 }
 
-k4a_image_t capture_get_color_image(k4a_capture_t capture_handle)
+static k4a_image_t capture_get_image(k4a_capture_t capture_handle, image_type_index_t type)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
 
-    rwlock_acquire_read(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_COLOR];
-    if (*image)
+    // The capture holds its reference until it is released, which the caller's own reference prevents
+    k4a_image_t image = (k4a_image_t)allocator_atomic_load_pointer(&capture->image[type]);
+    if (image)
     {
-        image_inc_ref(*image);
+        image_inc_ref(image);
     }
-    rwlock_release_read(&capture->lock);
-    return *image;
+    return image;
 }
-k4a_image_t capture_get_depth_image(k4a_capture_t capture_handle)
-{
-    RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
 
-    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+k4a_image_t capture_get_color_image(k4a_capture_t capture_handle)
+{
+    return capture_get_image(capture_handle, IMAGE_TYPE_COLOR);
+}
 
-    rwlock_acquire_read(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_DEPTH];
-    if (*image)
-    {
-        image_inc_ref(*image);
-    }
-    rwlock_release_read(&capture->lock);
-    return *image;
+k4a_image_t capture_get_depth_image(k4a_capture_t capture_handle)
+{
+    return capture_get_image(capture_handle, IMAGE_TYPE_DEPTH);
 }
 
 k4a_image_t capture_get_ir_image(k4a_capture_t capture_handle)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_capture_t, capture_handle);
-
-    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-
-    rwlock_acquire_read(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_IR];
-    if (*image)
-    {
-        image_inc_ref(*image);
-    }
-    rwlock_release_read(&capture->lock);
-    return *image;
+    return capture_get_image(capture_handle, IMAGE_TYPE_IR);
 }
 
 k4a_image_t capture_get_imu_image(k4a_capture_t capture_handle)
@@ -392,62 +1121,38 @@ k4a_image_t capture_get_imu_image(k4a_capture_t capture_handle)
     return capture_get_ir_image(capture_handle);
 }
 
-void capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+static void capture_set_image(k4a_capture_t capture_handle, image_type_index_t type, k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
 
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
 
-    rwlock_acquire_write(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_COLOR];
-    if (*image)
+    if (image_handle != NULL)
     {
-        image_dec_ref(*image); // drop the image that was here
+        image_inc_ref(image_handle);
     }
-    *image = image_handle;
-    if (image_handle != NULL)
+    k4a_image_t dropped = (k4a_image_t)allocator_atomic_exchange_pointer(&capture->image[type], image_handle);
+    if (dropped)
     {
-        image_inc_ref(*image);
+        image_dec_ref(dropped); // drop the image that was here
     }
-    rwlock_release_write(&capture->lock);
 }
-void capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
-{
-    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
 
-    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+void capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+{
+    capture_set_image(capture_handle, IMAGE_TYPE_COLOR, image_handle);
+}
 
-    rwlock_acquire_write(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_DEPTH];
-    if (*image)
-    {
-        image_dec_ref(*image); // drop the image that was here
-    }
-    *image = image_handle;
-    if (image_handle != NULL)
-    {
-        image_inc_ref(*image);
-    }
-    rwlock_release_write(&capture->lock);
+void capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+{
+    capture_set_image(capture_handle, IMAGE_TYPE_DEPTH, image_handle);
 }
+
 void capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
-
-    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
-    rwlock_acquire_write(&capture->lock);
-    k4a_image_t *image = &capture->image[IMAGE_TYPE_IR];
-    if (*image)
-    {
-        image_dec_ref(*image); // drop the image that was here
-    }
-    *image = image_handle;
-    if (image_handle != NULL)
-    {
-        image_inc_ref(*image);
-    }
-    rwlock_release_write(&capture->lock);
+    capture_set_image(capture_handle, IMAGE_TYPE_IR, image_handle);
 }
+
 void capture_set_imu_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
     // We just reuse the ir image location as this is never exposed to the user.
@@ -470,3 +1175,58 @@ float capture_get_temperature_c(k4a_capture_t capture_handle)
     capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
     return capture->temperature_c;
 }
+
+void capture_set_latency_timestamp_nsec(k4a_capture_t capture_handle,
+                                        k4a_latency_stage_t stage,
+                                        uint64_t timestamp_nsec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stage < K4A_LATENCY_STAGE_DEPTH_QUEUE || stage >= K4A_LATENCY_STAGE_NUM);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+    capture->latency_timestamp_nsec[stage] = timestamp_nsec;
+}
+
+uint64_t capture_get_latency_timestamp_nsec(k4a_capture_t capture_handle, k4a_latency_stage_t stage)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(0, stage < K4A_LATENCY_STAGE_DEPTH_QUEUE || stage >= K4A_LATENCY_STAGE_NUM);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+    return capture->latency_timestamp_nsec[stage];
+}
+
+void capture_set_imu_samples(k4a_capture_t capture_handle, k4a_imu_sample_t *imu_samples, size_t imu_sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, imu_samples == NULL && imu_sample_count != 0);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+
+    free(capture->imu_samples); // drop the samples that were here
+    capture->imu_samples = imu_samples;
+    capture->imu_sample_count = imu_sample_count;
+}
+
+k4a_buffer_result_t capture_get_imu_samples(k4a_capture_t capture_handle,
+                                            k4a_imu_sample_t *imu_samples,
+                                            size_t *imu_sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_capture_t, capture_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, imu_sample_count == NULL);
+
+    capture_context_t *capture = k4a_capture_t_get_context(capture_handle);
+    k4a_buffer_result_t result = K4A_BUFFER_RESULT_SUCCEEDED;
+
+    if (capture->imu_sample_count != 0 && (imu_samples == NULL || *imu_sample_count < capture->imu_sample_count))
+    {
+        result = K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+    else if (capture->imu_sample_count != 0)
+    {
+        memcpy(imu_samples, capture->imu_samples, capture->imu_sample_count * sizeof(k4a_imu_sample_t));
+    }
+    *imu_sample_count = capture->imu_sample_count;
+
+    return result;
+}
@@ -0,0 +1,1160 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // Robust process shared mutexes, shm_open() and kill()
+#endif
+
+// This library
+#include <k4ainternal/broker.h>
+
+// Dependent libraries
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/global.h>
+#include <k4ainternal/image.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/rwlock.h>
+#include <azure_c_shared_utility/refcount.h>
+
+// System dependencies
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define BROKER_MAGIC 0x314B5242 // BRK1
+#define BROKER_VERSION 1
+
+#define BROKER_MAX_NAME_LENGTH (48)
+#define BROKER_MAX_BUFFERS (1024)
+#define BROKER_PAGE_SIZE (4096)
+#define BROKER_ROUND_TO_PAGE(x) (((x) + (BROKER_PAGE_SIZE - 1)) & ~((size_t)BROKER_PAGE_SIZE - 1))
+
+// Waits for a capture wake up this often to notice a broker whose process exited
+#define BROKER_OWNER_CHECK_NSEC (1000000000ll)
+
+#define BROKER_IMAGE_COLOR 0
+#define BROKER_IMAGE_DEPTH 1
+#define BROKER_IMAGE_IR 2
+#define BROKER_IMAGE_COUNT 3
+
+#ifndef _WIN32
+
+static bool broker_name_valid(const char *name)
+{
+    size_t length = name != NULL ? strlen(name) : 0;
+    if (length == 0 || length > BROKER_MAX_NAME_LENGTH)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Everything below lives in shared memory, mapped at a different address by each process, so it holds offsets and
+// indices instead of pointers. Access to all of it may only occur while holding broker_shared_t::lock.
+
+typedef struct _broker_slot_t
+{
+    uint32_t in_use;
+    uint32_t owner_refs;                      // Allocations and copies of the owning process
+    uint32_t client_refs[BROKER_MAX_CLIENTS]; // Queued and received images of each attached process
+} broker_slot_t;
+
+typedef struct _broker_image_t
+{
+    uint32_t present;
+    uint32_t slot;
+    uint64_t offset; // Of the image buffer in the slot
+    uint64_t size;
+    uint32_t format;
+    int32_t width_pixels;
+    int32_t height_pixels;
+    int32_t stride_bytes;
+    uint64_t device_timestamp_usec;
+    uint64_t system_timestamp_nsec;
+    uint64_t exposure_usec;
+    uint32_t white_balance;
+    uint32_t iso_speed;
+} broker_image_t;
+
+typedef struct _broker_capture_t
+{
+    broker_image_t images[BROKER_IMAGE_COUNT];
+    float temperature_c;
+} broker_capture_t;
+
+typedef struct _broker_client_entry_t
+{
+    pid_t pid;       // 0 when the entry is free
+    uint32_t active; // 0 once the process detached, the entry is kept until it releases its images
+    uint32_t head;
+    uint32_t count;
+    broker_capture_t queue[BROKER_CLIENT_QUEUE_LENGTH];
+} broker_client_entry_t;
+
+typedef struct _broker_shared_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t mapped_size;
+    uint64_t data_offset; // Of the first slot buffer, the slot states follow this header
+    uint64_t slot_size;
+    uint32_t slot_count;
+    pid_t owner_pid;
+    uint32_t closed;
+
+    pthread_mutex_t lock; // Robust, a process exiting while holding it doesn't block the others
+    pthread_cond_t capture_condition;
+    uint32_t next_slot;
+
+    broker_client_entry_t clients[BROKER_MAX_CLIENTS];
+
+    uint32_t calibration_size;
+    uint32_t depth_mode;
+    uint32_t color_resolution;
+    char calibration[BROKER_MAX_CALIBRATION_BYTES];
+} broker_shared_t;
+
+// The mapping of the shared memory in this process. It is kept until the last buffer allocated from it or image
+// pointing into it is released, which may be after the handle is closed.
+typedef struct _broker_mapping_t
+{
+    broker_shared_t *shared;
+    broker_slot_t *slots;
+    uint8_t *data;
+    volatile long ref_count;
+    int client_index; // Entry in broker_shared_t::clients, -1 in the owning process
+} broker_mapping_t;
+
+typedef struct _broker_context_t
+{
+    broker_mapping_t *mapping;
+    char shm_name[BROKER_MAX_NAME_LENGTH + 16];
+} broker_context_t;
+
+typedef struct _broker_client_context_t
+{
+    broker_mapping_t *mapping;
+} broker_client_context_t;
+
+K4A_DECLARE_CONTEXT(broker_t, broker_context_t);
+K4A_DECLARE_CONTEXT(broker_client_t, broker_client_context_t);
+
+// The context of the release callback of an image received from the broker
+typedef struct _broker_image_ref_t
+{
+    broker_mapping_t *mapping;
+    uint32_t slot;
+} broker_image_ref_t;
+
+// The broker of this process, read by the allocate callback
+typedef struct
+{
+    k4a_rwlock_t lock;
+    broker_mapping_t *owner;
+} broker_global_t;
+
+static void broker_global_init(broker_global_t *global);
+
+// Creates a function called broker_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(broker_global_t, broker_global_init);
+
+static void broker_global_init(broker_global_t *global)
+{
+    rwlock_init(&global->lock);
+    global->owner = NULL;
+}
+
+static void broker_lock(broker_shared_t *shared)
+{
+    if (pthread_mutex_lock(&shared->lock) == EOWNERDEAD)
+    {
+        // Every update under the lock is a few stores, a process exiting in the middle leaves the counts usable
+        LOG_WARNING("A process attached to the broker exited while holding its lock", 0);
+        pthread_mutex_consistent(&shared->lock);
+    }
+}
+
+static void broker_unlock(broker_shared_t *shared)
+{
+    pthread_mutex_unlock(&shared->lock);
+}
+
+static bool broker_process_alive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+static void broker_shm_name(const char *name, char *shm_name, size_t shm_name_size)
+{
+    snprintf(shm_name, shm_name_size, "/k4a_broker_%s", name);
+}
+
+static uint8_t *broker_slot_buffer(broker_mapping_t *mapping, uint32_t slot)
+{
+    return mapping->data + (size_t)slot * mapping->shared->slot_size;
+}
+
+static void broker_try_free_slot_locked(broker_mapping_t *mapping, uint32_t slot)
+{
+    broker_slot_t *state = &mapping->slots[slot];
+    if (state->owner_refs != 0)
+    {
+        return;
+    }
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++)
+    {
+        if (state->client_refs[i] != 0)
+        {
+            return;
+        }
+    }
+    state->in_use = 0;
+}
+
+// Takes a free slot for the owning process, returns false when every slot is in use
+static bool broker_claim_slot_locked(broker_mapping_t *mapping, uint32_t *slot)
+{
+    broker_shared_t *shared = mapping->shared;
+    for (uint32_t i = 0; i < shared->slot_count; i++)
+    {
+        uint32_t candidate = (shared->next_slot + i) % shared->slot_count;
+        if (!mapping->slots[candidate].in_use)
+        {
+            mapping->slots[candidate].in_use = 1;
+            mapping->slots[candidate].owner_refs = 1;
+            shared->next_slot = (candidate + 1) % shared->slot_count;
+            *slot = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Drops the references of a queued capture held for a process
+static void broker_drop_capture_locked(broker_mapping_t *mapping, const broker_capture_t *capture, int client)
+{
+    for (int i = 0; i < BROKER_IMAGE_COUNT; i++)
+    {
+        if (capture->images[i].present)
+        {
+            mapping->slots[capture->images[i].slot].client_refs[client]--;
+            broker_try_free_slot_locked(mapping, capture->images[i].slot);
+        }
+    }
+}
+
+// Returns every buffer held by a process that exited without detaching
+static void broker_reclaim_client_locked(broker_mapping_t *mapping, int client)
+{
+    LOG_WARNING("Process %d exited while attached to the broker, reclaiming its buffers",
+                (int)mapping->shared->clients[client].pid);
+    for (uint32_t slot = 0; slot < mapping->shared->slot_count; slot++)
+    {
+        if (mapping->slots[slot].client_refs[client] != 0)
+        {
+            mapping->slots[slot].client_refs[client] = 0;
+            broker_try_free_slot_locked(mapping, slot);
+        }
+    }
+    memset(&mapping->shared->clients[client], 0, sizeof(mapping->shared->clients[client]));
+}
+
+static void broker_mapping_release(broker_mapping_t *mapping)
+{
+    if (DEC_REF_VAR(mapping->ref_count) != 0)
+    {
+        return;
+    }
+
+    if (mapping->client_index >= 0)
+    {
+        // The images of this process are all released, the entry can be reused
+        broker_lock(mapping->shared);
+        memset(&mapping->shared->clients[mapping->client_index], 0, sizeof(broker_client_entry_t));
+        broker_unlock(mapping->shared);
+    }
+
+    munmap(mapping->shared, (size_t)mapping->shared->mapped_size);
+    free(mapping);
+}
+
+static broker_mapping_t *broker_mapping_create(broker_shared_t *shared, int client_index)
+{
+    broker_mapping_t *mapping = (broker_mapping_t *)malloc(sizeof(broker_mapping_t));
+    if (mapping != NULL)
+    {
+        mapping->shared = shared;
+        mapping->slots = (broker_slot_t *)(shared + 1);
+        mapping->data = (uint8_t *)shared + shared->data_offset;
+        mapping->ref_count = 1;
+        mapping->client_index = client_index;
+    }
+    return mapping;
+}
+
+// This allocator implementation is used while a broker exists. Allocations that fit a slot take a free one, so the
+// images the device produces are written straight to shared memory. The context is the mapping for shared buffers and
+// NULL for buffers from the heap.
+static uint8_t *broker_alloc(int size, void **context)
+{
+    *context = NULL;
+    if (size < 0)
+    {
+        return NULL;
+    }
+
+    broker_global_t *global = broker_global_t_get();
+    uint8_t *buffer = NULL;
+
+    rwlock_acquire_read(&global->lock);
+    broker_mapping_t *mapping = global->owner;
+    if (mapping != NULL && size >= BROKER_MIN_SHARED_ALLOCATION && (uint64_t)size <= mapping->shared->slot_size)
+    {
+        uint32_t slot;
+        broker_lock(mapping->shared);
+        bool claimed = broker_claim_slot_locked(mapping, &slot);
+        broker_unlock(mapping->shared);
+
+        if (claimed)
+        {
+            INC_REF_VAR(mapping->ref_count);
+            buffer = broker_slot_buffer(mapping, slot);
+            *context = mapping;
+        }
+    }
+    rwlock_release_read(&global->lock);
+
+    if (buffer == NULL)
+    {
+        buffer = (uint8_t *)malloc((size_t)size);
+    }
+    return buffer;
+}
+
+static void broker_free(void *buffer, void *context)
+{
+    broker_mapping_t *mapping = (broker_mapping_t *)context;
+    if (mapping == NULL)
+    {
+        free(buffer);
+        return;
+    }
+
+    uint32_t slot = (uint32_t)(((uint8_t *)buffer - mapping->data) / mapping->shared->slot_size);
+    broker_lock(mapping->shared);
+    mapping->slots[slot].owner_refs--;
+    broker_try_free_slot_locked(mapping, slot);
+    broker_unlock(mapping->shared);
+
+    broker_mapping_release(mapping);
+}
+
+// Finds the slot of an image buffer, returns false when it is not in shared memory
+static bool broker_find_slot(broker_mapping_t *mapping,
+                             const uint8_t *buffer,
+                             size_t size,
+                             uint32_t *slot,
+                             uint64_t *offset)
+{
+    uintptr_t start = (uintptr_t)mapping->data;
+    uintptr_t end = start + (uintptr_t)(mapping->shared->slot_count * mapping->shared->slot_size);
+    uintptr_t address = (uintptr_t)buffer;
+    if (address < start || address >= end)
+    {
+        return false;
+    }
+
+    *slot = (uint32_t)((address - start) / mapping->shared->slot_size);
+    *offset = (uint64_t)((address - start) % mapping->shared->slot_size);
+    return *offset + size <= mapping->shared->slot_size;
+}
+
+// Maps a broker, checking the header when the memory was created by another process
+static broker_shared_t *broker_map(int fd, size_t size)
+{
+    void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return address != MAP_FAILED ? (broker_shared_t *)address : NULL;
+}
+
+static bool broker_shared_valid(const broker_shared_t *shared, size_t size)
+{
+    return shared->magic == BROKER_MAGIC && shared->version == BROKER_VERSION && shared->mapped_size == size;
+}
+
+// Opens new shared memory of the name, replacing memory left behind by a broker whose process exited
+static int broker_create_shm(const char *shm_name)
+{
+    int fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd >= 0 || errno != EEXIST)
+    {
+        return fd;
+    }
+
+    bool in_use = false;
+    fd = shm_open(shm_name, O_RDWR, 0);
+    struct stat status;
+    if (fd >= 0 && fstat(fd, &status) == 0 && (size_t)status.st_size >= sizeof(broker_shared_t))
+    {
+        broker_shared_t *shared = broker_map(fd, (size_t)status.st_size);
+        if (shared != NULL)
+        {
+            in_use = broker_shared_valid(shared, (size_t)status.st_size) && !shared->closed &&
+                     broker_process_alive(shared->owner_pid);
+            munmap(shared, (size_t)status.st_size);
+        }
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (in_use)
+    {
+        LOG_ERROR("A broker named %s already exists", shm_name);
+        return -1;
+    }
+
+    shm_unlink(shm_name);
+    return shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+}
+
+static k4a_result_t broker_init_shared(broker_shared_t *shared,
+                                       size_t mapped_size,
+                                       size_t data_offset,
+                                       uint32_t count,
+                                       size_t slot_size)
+{
+    shared->mapped_size = mapped_size;
+    shared->data_offset = data_offset;
+    shared->slot_size = slot_size;
+    shared->slot_count = count;
+    shared->owner_pid = getpid();
+
+    pthread_mutexattr_t mutex_attributes;
+    pthread_condattr_t condition_attributes;
+    bool initialized = pthread_mutexattr_init(&mutex_attributes) == 0 &&
+                       pthread_mutexattr_setpshared(&mutex_attributes, PTHREAD_PROCESS_SHARED) == 0 &&
+                       pthread_mutexattr_setrobust(&mutex_attributes, PTHREAD_MUTEX_ROBUST) == 0 &&
+                       pthread_mutex_init(&shared->lock, &mutex_attributes) == 0;
+    initialized = initialized && pthread_condattr_init(&condition_attributes) == 0 &&
+                  pthread_condattr_setpshared(&condition_attributes, PTHREAD_PROCESS_SHARED) == 0 &&
+                  pthread_condattr_setclock(&condition_attributes, CLOCK_MONOTONIC) == 0 &&
+                  pthread_cond_init(&shared->capture_condition, &condition_attributes) == 0;
+
+    // Attaching processes check the magic last, once everything else is set
+    shared->version = BROKER_VERSION;
+    shared->magic = BROKER_MAGIC;
+    return K4A_RESULT_FROM_BOOL(initialized);
+}
+
+k4a_result_t broker_create(const char *name, uint32_t buffer_count, size_t buffer_size, broker_t *broker_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !broker_name_valid(name));
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_count == 0 || buffer_count > BROKER_MAX_BUFFERS);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_size < BROKER_MIN_SHARED_ALLOCATION || buffer_size > INT32_MAX);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, broker_handle == NULL);
+
+    broker_global_t *global = broker_global_t_get();
+    broker_context_t *broker = broker_t_create(broker_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(broker != NULL);
+    if (K4A_FAILED(result))
+    {
+        return result;
+    }
+    broker_shm_name(name, broker->shm_name, sizeof(broker->shm_name));
+
+    size_t slot_size = BROKER_ROUND_TO_PAGE(buffer_size);
+    size_t data_offset = BROKER_ROUND_TO_PAGE(sizeof(broker_shared_t) + buffer_count * sizeof(broker_slot_t));
+    size_t mapped_size = data_offset + buffer_count * slot_size;
+    broker_shared_t *shared = NULL;
+    bool linked = false;
+
+    rwlock_acquire_write(&global->lock);
+    if (global->owner != NULL)
+    {
+        LOG_ERROR("Only one broker can be created in a process", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        int fd = broker_create_shm(broker->shm_name);
+        result = K4A_RESULT_FROM_BOOL(fd >= 0);
+        linked = K4A_SUCCEEDED(result);
+        if (K4A_SUCCEEDED(result))
+        {
+            // New shared memory is zero filled, so every slot starts free
+            result = K4A_RESULT_FROM_BOOL(ftruncate(fd, (off_t)mapped_size) == 0 &&
+                                          (shared = broker_map(fd, mapped_size)) != NULL);
+            close(fd);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(broker_init_shared(shared, mapped_size, data_offset, buffer_count, slot_size));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL((broker->mapping = broker_mapping_create(shared, -1)) != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // A pooled buffer would be handed out again while other processes still read it
+        global->owner = broker->mapping;
+        result = TRACE_CALL(allocator_set_allocator(broker_alloc, broker_free));
+        if (K4A_SUCCEEDED(result))
+        {
+            result = TRACE_CALL(allocator_set_pooling(0));
+        }
+        if (K4A_FAILED(result))
+        {
+            global->owner = NULL;
+            allocator_set_allocator(NULL, NULL);
+        }
+    }
+    rwlock_release_write(&global->lock);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        LOG_INFO("Broker %s shares %u buffers of %zu bytes", name, buffer_count, slot_size);
+    }
+    else
+    {
+        if (broker->mapping != NULL)
+        {
+            broker_mapping_release(broker->mapping);
+        }
+        else if (shared != NULL)
+        {
+            munmap(shared, mapped_size);
+        }
+        if (linked)
+        {
+            shm_unlink(broker->shm_name);
+        }
+        broker_t_destroy(*broker_handle);
+        *broker_handle = NULL;
+    }
+
+    return result;
+}
+
+void broker_destroy(broker_t broker_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, broker_t, broker_handle);
+    broker_context_t *broker = broker_t_get_context(broker_handle);
+    broker_mapping_t *mapping = broker->mapping;
+    broker_global_t *global = broker_global_t_get();
+
+    broker_lock(mapping->shared);
+    mapping->shared->closed = 1;
+    pthread_cond_broadcast(&mapping->shared->capture_condition);
+    broker_unlock(mapping->shared);
+
+    rwlock_acquire_write(&global->lock);
+    global->owner = NULL;
+    allocator_set_allocator(NULL, NULL);
+    rwlock_release_write(&global->lock);
+
+    // Processes still attached keep their mapping, a new broker of the same name gets new memory
+    shm_unlink(broker->shm_name);
+    broker_mapping_release(mapping);
+    broker_t_destroy(broker_handle);
+}
+
+k4a_result_t broker_set_calibration(broker_t broker_handle,
+                                    const uint8_t *raw_calibration,
+                                    size_t raw_calibration_size,
+                                    k4a_depth_mode_t depth_mode,
+                                    k4a_color_resolution_t color_resolution)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, broker_t, broker_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, raw_calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, raw_calibration_size > BROKER_MAX_CALIBRATION_BYTES);
+    broker_shared_t *shared = broker_t_get_context(broker_handle)->mapping->shared;
+
+    broker_lock(shared);
+    memcpy(shared->calibration, raw_calibration, raw_calibration_size);
+    shared->calibration_size = (uint32_t)raw_calibration_size;
+    shared->depth_mode = (uint32_t)depth_mode;
+    shared->color_resolution = (uint32_t)color_resolution;
+    broker_unlock(shared);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_image_t broker_get_capture_image(k4a_capture_t capture, int index)
+{
+    switch (index)
+    {
+    case BROKER_IMAGE_COLOR:
+        return capture_get_color_image(capture);
+    case BROKER_IMAGE_DEPTH:
+        return capture_get_depth_image(capture);
+    default:
+        return capture_get_ir_image(capture);
+    }
+}
+
+k4a_result_t broker_publish_capture(broker_t broker_handle, k4a_capture_t capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, broker_t, broker_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
+    broker_mapping_t *mapping = broker_t_get_context(broker_handle)->mapping;
+    broker_shared_t *shared = mapping->shared;
+
+    broker_capture_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.temperature_c = capture_get_temperature_c(capture_handle);
+    bool copied[BROKER_IMAGE_COUNT] = { false };
+
+    for (int i = 0; i < BROKER_IMAGE_COUNT; i++)
+    {
+        k4a_image_t image = broker_get_capture_image(capture_handle, i);
+        if (image == NULL)
+        {
+            continue;
+        }
+
+        broker_image_t *shared_image = &entry.images[i];
+        uint8_t *buffer = image_get_buffer(image);
+        size_t size = image_get_size(image);
+        if (buffer != NULL && broker_find_slot(mapping, buffer, size, &shared_image->slot, &shared_image->offset))
+        {
+            shared_image->present = 1;
+        }
+        else if (buffer != NULL && size <= shared->slot_size)
+        {
+            // The image is not in shared memory, copy it to a slot held until it is queued
+            broker_lock(shared);
+            bool claimed = broker_claim_slot_locked(mapping, &shared_image->slot);
+            broker_unlock(shared);
+            if (claimed)
+            {
+                memcpy(broker_slot_buffer(mapping, shared_image->slot), buffer, size);
+                shared_image->offset = 0;
+                shared_image->present = 1;
+                copied[i] = true;
+            }
+            else
+            {
+                LOG_WARNING("No free broker buffer, the image is not shared", 0);
+            }
+        }
+        else
+        {
+            LOG_WARNING("Image of %zu bytes is larger than the broker buffers, it is not shared", size);
+        }
+
+        if (shared_image->present)
+        {
+            shared_image->size = size;
+            shared_image->format = (uint32_t)image_get_format(image);
+            shared_image->width_pixels = image_get_width_pixels(image);
+            shared_image->height_pixels = image_get_height_pixels(image);
+            shared_image->stride_bytes = image_get_stride_bytes(image);
+            shared_image->device_timestamp_usec = image_get_device_timestamp_usec(image);
+            shared_image->system_timestamp_nsec = image_get_system_timestamp_nsec(image);
+            shared_image->exposure_usec = image_get_exposure_usec(image);
+            shared_image->white_balance = image_get_white_balance(image);
+            shared_image->iso_speed = image_get_iso_speed(image);
+        }
+        image_dec_ref(image);
+    }
+
+    broker_lock(shared);
+    for (int client = 0; client < BROKER_MAX_CLIENTS; client++)
+    {
+        broker_client_entry_t *queue = &shared->clients[client];
+        if (queue->pid == 0)
+        {
+            continue;
+        }
+        if (!broker_process_alive(queue->pid))
+        {
+            broker_reclaim_client_locked(mapping, client);
+            continue;
+        }
+        if (!queue->active)
+        {
+            continue;
+        }
+
+        // The process doesn't keep up, drop its oldest capture so it stays on the newest ones
+        if (queue->count == BROKER_CLIENT_QUEUE_LENGTH)
+        {
+            broker_drop_capture_locked(mapping, &queue->queue[queue->head], client);
+            queue->head = (queue->head + 1) % BROKER_CLIENT_QUEUE_LENGTH;
+            queue->count--;
+        }
+
+        queue->queue[(queue->head + queue->count) % BROKER_CLIENT_QUEUE_LENGTH] = entry;
+        queue->count++;
+        for (int i = 0; i < BROKER_IMAGE_COUNT; i++)
+        {
+            if (entry.images[i].present)
+            {
+                mapping->slots[entry.images[i].slot].client_refs[client]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < BROKER_IMAGE_COUNT; i++)
+    {
+        if (copied[i])
+        {
+            mapping->slots[entry.images[i].slot].owner_refs--;
+            broker_try_free_slot_locked(mapping, entry.images[i].slot);
+        }
+    }
+    pthread_cond_broadcast(&shared->capture_condition);
+    broker_unlock(shared);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+uint32_t broker_get_free_buffer_count(broker_t broker_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, broker_t, broker_handle);
+    broker_mapping_t *mapping = broker_t_get_context(broker_handle)->mapping;
+    uint32_t free_count = 0;
+
+    broker_lock(mapping->shared);
+    for (uint32_t slot = 0; slot < mapping->shared->slot_count; slot++)
+    {
+        free_count += mapping->slots[slot].in_use ? 0 : 1;
+    }
+    broker_unlock(mapping->shared);
+
+    return free_count;
+}
+
+k4a_result_t broker_attach(const char *name, broker_client_t *client_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !broker_name_valid(name));
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, client_handle == NULL);
+
+    char shm_name[BROKER_MAX_NAME_LENGTH + 16];
+    broker_shm_name(name, shm_name, sizeof(shm_name));
+
+    int fd = shm_open(shm_name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        LOG_ERROR("There is no broker named %s", name);
+        return K4A_RESULT_FAILED;
+    }
+
+    struct stat status;
+    broker_shared_t *shared = NULL;
+    size_t mapped_size = 0;
+    if (fstat(fd, &status) == 0 && (size_t)status.st_size >= sizeof(broker_shared_t))
+    {
+        mapped_size = (size_t)status.st_size;
+        shared = broker_map(fd, mapped_size);
+    }
+    close(fd);
+
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(shared != NULL && broker_shared_valid(shared, mapped_size));
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("Broker %s is not ready or was created by an incompatible version", name);
+        if (shared != NULL)
+        {
+            munmap(shared, mapped_size);
+        }
+        return result;
+    }
+
+    int client_index = -1;
+    broker_lock(shared);
+    for (int client = 0; client < BROKER_MAX_CLIENTS && client_index < 0; client++)
+    {
+        broker_client_entry_t *queue = &shared->clients[client];
+        if (queue->pid == 0)
+        {
+            client_index = client;
+        }
+    }
+    if (client_index >= 0)
+    {
+        memset(&shared->clients[client_index], 0, sizeof(broker_client_entry_t));
+        shared->clients[client_index].pid = getpid();
+        shared->clients[client_index].active = 1;
+    }
+    broker_unlock(shared);
+
+    broker_mapping_t *mapping = NULL;
+    result = K4A_RESULT_FROM_BOOL(client_index >= 0);
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("Broker %s has %d processes attached already", name, BROKER_MAX_CLIENTS);
+        munmap(shared, mapped_size);
+        return result;
+    }
+
+    result = K4A_RESULT_FROM_BOOL((mapping = broker_mapping_create(shared, client_index)) != NULL);
+    broker_client_context_t *client = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL((client = broker_client_t_create(client_handle)) != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        client->mapping = mapping;
+    }
+    else if (mapping != NULL)
+    {
+        broker_mapping_release(mapping);
+    }
+    else
+    {
+        broker_lock(shared);
+        memset(&shared->clients[client_index], 0, sizeof(broker_client_entry_t));
+        broker_unlock(shared);
+        munmap(shared, mapped_size);
+    }
+
+    return result;
+}
+
+void broker_detach(broker_client_t client_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, broker_client_t, client_handle);
+    broker_mapping_t *mapping = broker_client_t_get_context(client_handle)->mapping;
+    broker_client_entry_t *queue = &mapping->shared->clients[mapping->client_index];
+
+    // Stop receiving captures, the entry is freed with the mapping once every received image is released
+    broker_lock(mapping->shared);
+    queue->active = 0;
+    for (uint32_t i = 0; i < queue->count; i++)
+    {
+        broker_drop_capture_locked(mapping,
+                                   &queue->queue[(queue->head + i) % BROKER_CLIENT_QUEUE_LENGTH],
+                                   mapping->client_index);
+    }
+    queue->count = 0;
+    broker_unlock(mapping->shared);
+
+    broker_mapping_release(mapping);
+    broker_client_t_destroy(client_handle);
+}
+
+k4a_result_t broker_client_get_calibration(broker_client_t client_handle,
+                                           char *raw_calibration,
+                                           size_t *raw_calibration_size,
+                                           k4a_depth_mode_t *depth_mode,
+                                           k4a_color_resolution_t *color_resolution)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, broker_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, raw_calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, raw_calibration_size == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depth_mode == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, color_resolution == NULL);
+    broker_shared_t *shared = broker_client_t_get_context(client_handle)->mapping->shared;
+    k4a_result_t result = K4A_RESULT_FAILED;
+
+    broker_lock(shared);
+    if (shared->calibration_size > 0 && shared->calibration_size <= BROKER_MAX_CALIBRATION_BYTES)
+    {
+        memcpy(raw_calibration, shared->calibration, shared->calibration_size);
+        raw_calibration[shared->calibration_size] = '\0';
+        *raw_calibration_size = shared->calibration_size + 1;
+        *depth_mode = (k4a_depth_mode_t)shared->depth_mode;
+        *color_resolution = (k4a_color_resolution_t)shared->color_resolution;
+        result = K4A_RESULT_SUCCEEDED;
+    }
+    broker_unlock(shared);
+
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("The broker has not shared a device calibration", 0);
+    }
+    return result;
+}
+
+static void broker_release_client_image(void *buffer, void *context)
+{
+    (void)buffer;
+    broker_image_ref_t *ref = (broker_image_ref_t *)context;
+    broker_mapping_t *mapping = ref->mapping;
+
+    broker_lock(mapping->shared);
+    mapping->slots[ref->slot].client_refs[mapping->client_index]--;
+    broker_try_free_slot_locked(mapping, ref->slot);
+    broker_unlock(mapping->shared);
+
+    free(ref);
+    broker_mapping_release(mapping);
+}
+
+// Creates an image pointing into shared memory, taking over the reference of this process to its slot
+static k4a_image_t broker_create_client_image(broker_mapping_t *mapping, const broker_image_t *shared_image)
+{
+    broker_image_ref_t *ref = (broker_image_ref_t *)malloc(sizeof(broker_image_ref_t));
+    k4a_image_t image = NULL;
+    if (ref == NULL)
+    {
+        broker_lock(mapping->shared);
+        mapping->slots[shared_image->slot].client_refs[mapping->client_index]--;
+        broker_try_free_slot_locked(mapping, shared_image->slot);
+        broker_unlock(mapping->shared);
+        return NULL;
+    }
+
+    ref->mapping = mapping;
+    ref->slot = shared_image->slot;
+    INC_REF_VAR(mapping->ref_count);
+
+    k4a_result_t result = TRACE_CALL(
+        image_create_from_buffer((k4a_image_format_t)shared_image->format,
+                                 shared_image->width_pixels,
+                                 shared_image->height_pixels,
+                                 shared_image->stride_bytes,
+                                 broker_slot_buffer(mapping, shared_image->slot) + shared_image->offset,
+                                 (size_t)shared_image->size,
+                                 broker_release_client_image,
+                                 ref,
+                                 &image));
+    if (K4A_FAILED(result))
+    {
+        broker_release_client_image(NULL, ref);
+        return NULL;
+    }
+
+    image_set_device_timestamp_usec(image, shared_image->device_timestamp_usec);
+    image_set_system_timestamp_nsec(image, shared_image->system_timestamp_nsec);
+    image_set_exposure_usec(image, shared_image->exposure_usec);
+    image_set_white_balance(image, shared_image->white_balance);
+    image_set_iso_speed(image, shared_image->iso_speed);
+    return image;
+}
+
+static k4a_result_t broker_create_client_capture(broker_mapping_t *mapping,
+                                                 const broker_capture_t *entry,
+                                                 k4a_capture_t *capture_handle)
+{
+    k4a_result_t result = TRACE_CALL(capture_create(capture_handle));
+    if (K4A_SUCCEEDED(result))
+    {
+        capture_set_temperature_c(*capture_handle, entry->temperature_c);
+    }
+
+    // Every present image is created, or has its reference dropped, so no slot reference is left behind
+    for (int i = 0; i < BROKER_IMAGE_COUNT; i++)
+    {
+        if (!entry->images[i].present)
+        {
+            continue;
+        }
+
+        k4a_image_t image = broker_create_client_image(mapping, &entry->images[i]);
+        if (image == NULL)
+        {
+            result = K4A_RESULT_FAILED;
+            continue;
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            switch (i)
+            {
+            case BROKER_IMAGE_COLOR:
+                capture_set_color_image(*capture_handle, image);
+                break;
+            case BROKER_IMAGE_DEPTH:
+                capture_set_depth_image(*capture_handle, image);
+                break;
+            default:
+                capture_set_ir_image(*capture_handle, image);
+                break;
+            }
+        }
+        image_dec_ref(image);
+    }
+
+    if (K4A_FAILED(result) && *capture_handle != NULL)
+    {
+        capture_dec_ref(*capture_handle);
+        *capture_handle = NULL;
+    }
+    return result;
+}
+
+static int64_t broker_monotonic_nsec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000ll + now.tv_nsec;
+}
+
+k4a_wait_result_t broker_client_get_capture(broker_client_t client_handle,
+                                            k4a_capture_t *capture_handle,
+                                            int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, broker_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, capture_handle == NULL);
+    broker_mapping_t *mapping = broker_client_t_get_context(client_handle)->mapping;
+    broker_shared_t *shared = mapping->shared;
+    broker_client_entry_t *queue = &shared->clients[mapping->client_index];
+
+    int64_t deadline_nsec = broker_monotonic_nsec() + (int64_t)timeout_in_ms * 1000000ll;
+    bool owner_alive = true;
+    bool received = false;
+    broker_capture_t entry;
+
+    broker_lock(shared);
+    while (true)
+    {
+        owner_alive = !shared->closed && broker_process_alive(shared->owner_pid);
+        if (queue->count > 0 || !owner_alive)
+        {
+            break;
+        }
+
+        int64_t now_nsec = broker_monotonic_nsec();
+        if (timeout_in_ms != K4A_WAIT_INFINITE && now_nsec >= deadline_nsec)
+        {
+            break;
+        }
+
+        // Wake up at least once a second to notice a broker whose process exited without closing it
+        int64_t wake_nsec = now_nsec + BROKER_OWNER_CHECK_NSEC;
+        if (timeout_in_ms != K4A_WAIT_INFINITE && deadline_nsec < wake_nsec)
+        {
+            wake_nsec = deadline_nsec;
+        }
+        struct timespec wake;
+        wake.tv_sec = (time_t)(wake_nsec / 1000000000ll);
+        wake.tv_nsec = (long)(wake_nsec % 1000000000ll);
+        if (pthread_cond_timedwait(&shared->capture_condition, &shared->lock, &wake) == EOWNERDEAD)
+        {
+            pthread_mutex_consistent(&shared->lock);
+        }
+    }
+
+    // Captures queued before the broker went away are still returned
+    if (queue->count > 0)
+    {
+        entry = queue->queue[queue->head];
+        queue->head = (queue->head + 1) % BROKER_CLIENT_QUEUE_LENGTH;
+        queue->count--;
+        received = true;
+    }
+    broker_unlock(shared);
+
+    if (!received)
+    {
+        return owner_alive ? K4A_WAIT_RESULT_TIMEOUT : K4A_WAIT_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(broker_create_client_capture(mapping, &entry, capture_handle));
+    return K4A_SUCCEEDED(result) ? K4A_WAIT_RESULT_SUCCEEDED : K4A_WAIT_RESULT_FAILED;
+}
+
+#else // _WIN32
+
+// Brokers need process shared memory and locks, which are implemented for Linux only
+
+k4a_result_t broker_create(const char *name, uint32_t buffer_count, size_t buffer_size, broker_t *broker_handle)
+{
+    (void)name;
+    (void)buffer_count;
+    (void)buffer_size;
+    (void)broker_handle;
+    LOG_ERROR("Sharing a device with other processes is not supported on Windows", 0);
+    return K4A_RESULT_FAILED;
+}
+
+void broker_destroy(broker_t broker_handle)
+{
+    (void)broker_handle;
+}
+
+k4a_result_t broker_set_calibration(broker_t broker_handle,
+                                    const uint8_t *raw_calibration,
+                                    size_t raw_calibration_size,
+                                    k4a_depth_mode_t depth_mode,
+                                    k4a_color_resolution_t color_resolution)
+{
+    (void)broker_handle;
+    (void)raw_calibration;
+    (void)raw_calibration_size;
+    (void)depth_mode;
+    (void)color_resolution;
+    return K4A_RESULT_FAILED;
+}
+
+k4a_result_t broker_publish_capture(broker_t broker_handle, k4a_capture_t capture_handle)
+{
+    (void)broker_handle;
+    (void)capture_handle;
+    return K4A_RESULT_FAILED;
+}
+
+uint32_t broker_get_free_buffer_count(broker_t broker_handle)
+{
+    (void)broker_handle;
+    return 0;
+}
+
+k4a_result_t broker_attach(const char *name, broker_client_t *client_handle)
+{
+    (void)name;
+    (void)client_handle;
+    LOG_ERROR("Sharing a device with other processes is not supported on Windows", 0);
+    return K4A_RESULT_FAILED;
+}
+
+void broker_detach(broker_client_t client_handle)
+{
+    (void)client_handle;
+}
+
+k4a_result_t broker_client_get_calibration(broker_client_t client_handle,
+                                           char *raw_calibration,
+                                           size_t *raw_calibration_size,
+                                           k4a_depth_mode_t *depth_mode,
+                                           k4a_color_resolution_t *color_resolution)
+{
+    (void)client_handle;
+    (void)raw_calibration;
+    (void)raw_calibration_size;
+    (void)depth_mode;
+    (void)color_resolution;
+    return K4A_RESULT_FAILED;
+}
+
+k4a_wait_result_t broker_client_get_capture(broker_client_t client_handle,
+                                            k4a_capture_t *capture_handle,
+                                            int32_t timeout_in_ms)
+{
+    (void)client_handle;
+    (void)capture_handle;
+    (void)timeout_in_ms;
+    return K4A_WAIT_RESULT_FAILED;
+}
+
+#endif // _WIN32
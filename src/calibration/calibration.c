@@ -6,19 +6,29 @@
 
 // Dependent libraries
 #include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
 #include <cJSON.h>
 #include <locale.h> //cJSON.h need this set correctly.
+#include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/threadapi.h>
 
 // System dependencies
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
 
 #define READ_RETRY_ALLOC_INCREASE (5 * 1024)
 #define READ_RETRY_BASE_ALLOCATION (10 * 1024)
 #define MAX_READ_RETRIES (10)
 
+// Largest calibration file accepted from the cache, well above what a device stores
+#define CALIBRATION_CACHE_MAX_FILE_SIZE (1024 * 1024)
+#define CALIBRATION_CACHE_MAX_PATH (1024)
+
 typedef struct _INTRINSIC_TYPE_TO_STRING_MAPPER
 {
     k4a_calibration_model_type_t type_e;
@@ -42,6 +52,12 @@ typedef struct _calibration_context_t
     k4a_calibration_camera_t color_calibration;
     k4a_calibration_imu_t gyro_calibration;
     k4a_calibration_imu_t accel_calibration;
+
+    // Only set when the calibration was loaded from the cache. The lock guards the members above against the refresh
+    // thread replacing them.
+    LOCK_HANDLE lock;
+    THREAD_HANDLE refresh_thread;
+    char cache_path[CALIBRATION_CACHE_MAX_PATH];
 } calibration_context_t;
 
 K4A_DECLARE_CONTEXT(calibration_t, calibration_context_t);
@@ -536,7 +552,7 @@ static k4a_result_t get_imu_calibration(char *json, k4a_calibration_imu_t *cal,
     return result;
 }
 
-static k4a_result_t read_extrinsic_calibration(calibration_context_t *calibration)
+static k4a_result_t read_extrinsic_calibration(depthmcu_t depthmcu, size_t size_hint, char **json_out, size_t *size_out)
 {
     size_t json_size;
     char *json;
@@ -544,9 +560,9 @@ static k4a_result_t read_extrinsic_calibration(calibration_context_t *calibratio
     int tries = 0;
 
     json_size = READ_RETRY_BASE_ALLOCATION;
-    if (calibration->json_size != 0)
+    if (size_hint != 0)
     {
-        json_size = calibration->json_size;
+        json_size = size_hint;
     }
 
     do
@@ -558,7 +574,7 @@ static k4a_result_t read_extrinsic_calibration(calibration_context_t *calibratio
 
         if (K4A_SUCCEEDED(result))
         {
-            result = depthmcu_get_extrinsic_calibration(calibration->depthmcu, json, json_size, &bytes_read);
+            result = depthmcu_get_extrinsic_calibration(depthmcu, json, json_size, &bytes_read);
         }
 
         if (K4A_SUCCEEDED(result))
@@ -569,8 +585,8 @@ static k4a_result_t read_extrinsic_calibration(calibration_context_t *calibratio
         if (K4A_SUCCEEDED(result))
         {
             json[bytes_read] = '\0'; // NULL terminate the json calibration, which is ASCII text
-            calibration->json = json;
-            calibration->json_size = bytes_read + 1; // ++ for NULL
+            *json_out = json;
+            *size_out = bytes_read + 1; // ++ for NULL
         }
         else
         {
@@ -584,6 +600,192 @@ static k4a_result_t read_extrinsic_calibration(calibration_context_t *calibratio
     return result;
 }
 
+// A cached calibration may be replaced by the refresh thread while it is being read
+static void calibration_lock(calibration_context_t *calibration)
+{
+    if (calibration->lock)
+    {
+        Lock(calibration->lock);
+    }
+}
+
+static void calibration_unlock(calibration_context_t *calibration)
+{
+    if (calibration->lock)
+    {
+        Unlock(calibration->lock);
+    }
+}
+
+static k4a_result_t parse_calibration(calibration_context_t *calibration)
+{
+    return calibration_create_from_raw(calibration->json,
+                                       calibration->json_size,
+                                       &calibration->depth_calibration,
+                                       &calibration->color_calibration,
+                                       &calibration->gyro_calibration,
+                                       &calibration->accel_calibration);
+}
+
+static bool get_calibration_cache_path(const char *serial_number,
+                                       const depthmcu_firmware_versions_t *version,
+                                       char *path,
+                                       size_t path_size)
+{
+    const char *cache_dir = environment_get_variable("K4A_CALIBRATION_CACHE_DIR");
+    if (cache_dir == NULL || cache_dir[0] == '\0' || serial_number == NULL || version == NULL)
+    {
+        return false;
+    }
+
+    // The serial number becomes part of a file name
+    for (const char *c = serial_number; *c != '\0'; c++)
+    {
+        if (!isalnum((unsigned char)*c))
+        {
+            LOG_WARNING("Serial number %s is not alphanumeric, the calibration will not be cached.", serial_number);
+            return false;
+        }
+    }
+
+    int length = snprintf(path,
+                          path_size,
+                          "%s/k4a_calibration_%s_%u.%u.%u_%u.%u.%u_%u.%u.%u_%u.%u.json",
+                          cache_dir,
+                          serial_number,
+                          version->rgb_major,
+                          version->rgb_minor,
+                          version->rgb_build,
+                          version->depth_major,
+                          version->depth_minor,
+                          version->depth_build,
+                          version->audio_major,
+                          version->audio_minor,
+                          version->audio_build,
+                          version->depth_sensor_cfg_major,
+                          version->depth_sensor_cfg_minor);
+    if (length < 0 || (size_t)length >= path_size)
+    {
+        LOG_WARNING("K4A_CALIBRATION_CACHE_DIR is too long, the calibration will not be cached.", 0);
+        return false;
+    }
+    return true;
+}
+
+// Reads the JSON calibration stored in path, NULL terminated like the one read from the device so that both have the
+// same size when they hold the same calibration
+static bool load_cached_calibration(const char *path, char **json_out, size_t *size_out)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    char *json = NULL;
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        file_size = ftell(file);
+    }
+
+    bool loaded = file_size > 0 && file_size < CALIBRATION_CACHE_MAX_FILE_SIZE && fseek(file, 0, SEEK_SET) == 0 &&
+                  (json = malloc((size_t)file_size + 1)) != NULL &&
+                  fread(json, 1, (size_t)file_size, file) == (size_t)file_size;
+    fclose(file);
+
+    if (!loaded)
+    {
+        LOG_WARNING("Ignoring calibration cache file %s that could not be read.", path);
+        free(json);
+        return false;
+    }
+
+    json[file_size] = '\0';
+    *json_out = json;
+    *size_out = (size_t)file_size + 1;
+    return true;
+}
+
+static void store_cached_calibration(const char *path, const char *json, size_t json_size)
+{
+    // Write to a temporary file first so that other processes either see a complete file or no file at all
+    char temp_path[CALIBRATION_CACHE_MAX_PATH + 4];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL)
+    {
+        LOG_WARNING("Failed to create calibration cache file %s.", temp_path);
+        return;
+    }
+
+    // The NULL terminator added when reading the device is not stored
+    bool written = fwrite(json, 1, json_size - 1, file) == json_size - 1;
+    written = fclose(file) == 0 && written;
+
+    // rename does not replace an existing file on Windows
+    remove(path);
+    if (!written || rename(temp_path, path) != 0)
+    {
+        LOG_WARNING("Failed to write calibration cache file %s.", path);
+        remove(temp_path);
+    }
+}
+
+// Reads the calibration from the device after a cache hit, and replaces the cached one if it no longer matches
+static int calibration_refresh_thread(void *param)
+{
+    calibration_context_t *calibration = (calibration_context_t *)param;
+    calibration_context_t refreshed;
+    bool matches = false;
+
+    memset(&refreshed, 0, sizeof(refreshed));
+
+    // The members of the context are only replaced by this thread, so they are read here without holding the lock
+    k4a_result_t result = TRACE_CALL(read_extrinsic_calibration(calibration->depthmcu,
+                                                                calibration->json_size,
+                                                                &refreshed.json,
+                                                                &refreshed.json_size));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        matches = refreshed.json_size == calibration->json_size &&
+                  memcmp(refreshed.json, calibration->json, refreshed.json_size) == 0;
+    }
+
+    if (K4A_SUCCEEDED(result) && !matches)
+    {
+        result = TRACE_CALL(parse_calibration(&refreshed));
+    }
+
+    if (K4A_SUCCEEDED(result) && !matches)
+    {
+        LOG_WARNING("Calibration cache file %s does not match the device, refreshing it.", calibration->cache_path);
+        store_cached_calibration(calibration->cache_path, refreshed.json, refreshed.json_size);
+
+        Lock(calibration->lock);
+        char *stale_json = calibration->json;
+        calibration->json = refreshed.json;
+        calibration->json_size = refreshed.json_size;
+        calibration->depth_calibration = refreshed.depth_calibration;
+        calibration->color_calibration = refreshed.color_calibration;
+        calibration->gyro_calibration = refreshed.gyro_calibration;
+        calibration->accel_calibration = refreshed.accel_calibration;
+        Unlock(calibration->lock);
+
+        refreshed.json = stale_json;
+    }
+
+    if (K4A_FAILED(result))
+    {
+        LOG_WARNING("Failed to validate calibration cache file %s against the device.", calibration->cache_path);
+    }
+
+    free(refreshed.json);
+    return 0;
+}
+
 k4a_result_t calibration_create(depthmcu_t depthmcu, calibration_t *calibration_handle)
 {
     calibration_context_t *calibration;
@@ -599,17 +801,89 @@ k4a_result_t calibration_create(depthmcu_t depthmcu, calibration_t *calibration_
     {
         calibration->depthmcu = depthmcu;
 
-        result = read_extrinsic_calibration(calibration);
+        result = read_extrinsic_calibration(depthmcu, 0, &calibration->json, &calibration->json_size);
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        result = calibration_create_from_raw(calibration->json,
-                                             calibration->json_size,
-                                             &calibration->depth_calibration,
-                                             &calibration->color_calibration,
-                                             &calibration->gyro_calibration,
-                                             &calibration->accel_calibration);
+        result = parse_calibration(calibration);
+    }
+
+    if (K4A_FAILED(result) && *calibration_handle != NULL)
+    {
+        calibration_destroy(*calibration_handle);
+        *calibration_handle = NULL;
+        result = K4A_RESULT_FAILED;
+    }
+
+    return result;
+}
+
+k4a_result_t calibration_create_cached(depthmcu_t depthmcu,
+                                       const char *serial_number,
+                                       const depthmcu_firmware_versions_t *version,
+                                       calibration_t *calibration_handle)
+{
+    calibration_context_t *calibration;
+    char cache_path[CALIBRATION_CACHE_MAX_PATH];
+    k4a_result_t result;
+    bool cache_hit = false;
+
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depthmcu == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration_handle == NULL);
+
+    if (!get_calibration_cache_path(serial_number, version, cache_path, sizeof(cache_path)))
+    {
+        return calibration_create(depthmcu, calibration_handle);
+    }
+
+    calibration = calibration_t_create(calibration_handle);
+    result = K4A_RESULT_FROM_BOOL(calibration != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        calibration->depthmcu = depthmcu;
+        memcpy(calibration->cache_path, cache_path, sizeof(cache_path));
+
+        if (load_cached_calibration(cache_path, &calibration->json, &calibration->json_size))
+        {
+            cache_hit = K4A_SUCCEEDED(parse_calibration(calibration));
+            if (!cache_hit)
+            {
+                LOG_WARNING("Ignoring calibration cache file %s that could not be parsed.", cache_path);
+                free(calibration->json);
+                calibration->json = NULL;
+                calibration->json_size = 0;
+            }
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && cache_hit)
+    {
+        LOG_INFO("Using cached calibration %s, validating it in the background.", cache_path);
+        result = K4A_RESULT_FROM_BOOL((calibration->lock = Lock_Init()) != NULL);
+
+        if (K4A_SUCCEEDED(result))
+        {
+            result = K4A_RESULT_FROM_BOOL(ThreadAPI_Create(&calibration->refresh_thread,
+                                                           calibration_refresh_thread,
+                                                           calibration) == THREADAPI_OK);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && !cache_hit)
+    {
+        result = read_extrinsic_calibration(depthmcu, 0, &calibration->json, &calibration->json_size);
+
+        if (K4A_SUCCEEDED(result))
+        {
+            result = parse_calibration(calibration);
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            store_cached_calibration(cache_path, calibration->json, calibration->json_size);
+        }
     }
 
     if (K4A_FAILED(result) && *calibration_handle != NULL)
@@ -714,6 +988,20 @@ void calibration_destroy(calibration_t calibration_handle)
 
     calibration = calibration_t_get_context(calibration_handle);
 
+    if (calibration->refresh_thread)
+    {
+        // The refresh thread uses the depthmcu, which is destroyed after the calibration
+        int thread_result;
+        (void)ThreadAPI_Join(calibration->refresh_thread, &thread_result);
+        calibration->refresh_thread = NULL;
+    }
+
+    if (calibration->lock)
+    {
+        Lock_Deinit(calibration->lock);
+        calibration->lock = NULL;
+    }
+
     if (calibration->json)
     {
         free(calibration->json);
@@ -733,6 +1021,7 @@ k4a_result_t calibration_get_camera(calibration_t calibration_handle,
 
     calibration = calibration_t_get_context(calibration_handle);
 
+    calibration_lock(calibration);
     if (type == K4A_CALIBRATION_TYPE_DEPTH)
     {
         memcpy(cal_data, &calibration->depth_calibration, sizeof(k4a_calibration_camera_t));
@@ -742,6 +1031,7 @@ k4a_result_t calibration_get_camera(calibration_t calibration_handle,
         assert(type == K4A_CALIBRATION_TYPE_COLOR);
         memcpy(cal_data, &calibration->color_calibration, sizeof(k4a_calibration_camera_t));
     }
+    calibration_unlock(calibration);
     return K4A_RESULT_SUCCEEDED;
 }
 
@@ -756,6 +1046,7 @@ k4a_result_t calibration_get_imu(calibration_t calibration_handle,
 
     calibration = calibration_t_get_context(calibration_handle);
 
+    calibration_lock(calibration);
     if (type == K4A_CALIBRATION_TYPE_GYRO)
     {
         memcpy(cal_data, &calibration->gyro_calibration, sizeof(k4a_calibration_imu_t));
@@ -765,6 +1056,7 @@ k4a_result_t calibration_get_imu(calibration_t calibration_handle,
         assert(type == K4A_CALIBRATION_TYPE_ACCEL);
         memcpy(cal_data, &calibration->accel_calibration, sizeof(k4a_calibration_imu_t));
     }
+    calibration_unlock(calibration);
     return K4A_RESULT_SUCCEEDED;
 }
 
@@ -778,6 +1070,7 @@ k4a_buffer_result_t calibration_get_raw_data(calibration_t calibration_handle, u
 
     calibration = calibration_t_get_context(calibration_handle);
 
+    calibration_lock(calibration);
     if (data == NULL)
     {
         (*data_size) = calibration->json_size;
@@ -800,5 +1093,6 @@ k4a_buffer_result_t calibration_get_raw_data(calibration_t calibration_handle, u
             bresult = K4A_BUFFER_RESULT_TOO_SMALL;
         }
     }
+    calibration_unlock(calibration);
     return bresult;
 }
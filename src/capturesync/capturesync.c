@@ -5,8 +5,10 @@
 #include <k4ainternal/capturesync.h>
 
 // Dependent libraries
+#include <k4ainternal/allocator.h>
 #include <k4ainternal/handle.h>
 #include <k4ainternal/queue.h>
+#include <k4ainternal/latency.h>
 #include <k4ainternal/logging.h>
 #include <k4ainternal/common.h>
 
@@ -16,6 +18,7 @@
 // System dependencies
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 typedef k4a_image_t(pfn_get_typed_image_t)(k4a_capture_t capture);
 typedef struct _image_t
@@ -35,13 +38,18 @@ typedef struct _capturesync_context_t
     frame_info_t color;    // Oldest capture received from the color sensor
     frame_info_t depth_ir; // Timestamp in us of the oldest depth capture
 
+    uint32_t sync_queue_depth;            // Depth of sync_queue applied on start, 0 for the default
+    k4a_queue_policy_t sync_queue_policy; // What sync_queue does when full, applied on start
+
     uint64_t fps_period;           // The slowest sample period in micro seconds
     uint64_t fps_1_quarter_period; // fps_period / 4
     bool sync_captures;            // enables depth and color captures to be synchronized.
     bool synchronized_images_only; // Only send captures to the user if they contain both color and depth images
 
     bool waiting_for_clean_depth_ts; // Flag to indicate the TS on depth captures has been reset.
-    int depth_captures_dropped;      // Count of dropped captures waiting for waiting_for_clean_depth_ts.
+
+    k4a_capture_stats_t stats; // Counters reported by capturesync_get_stats(), guarded by lock
+    int64_t skew_sum_usec;     // Sum of depth minus color TS of synchronized captures, for stats.average_skew_usec
 
     bool disable_sync;      // Disables synchronizing depth and color captures. Instead releases them as they arrive.
     bool enable_ts_logging; // Write capture timestamps and type to the logger to analysis
@@ -49,6 +57,16 @@ typedef struct _capturesync_context_t
     volatile bool running;              // We have received start and should be processing data when true.
     LOCK_HANDLE lock;
 
+    k4a_capture_cb_t *capture_cb; // When set, synchronized captures are sent here instead of sync_queue
+    void *capture_cb_context;
+
+    capturesync_imu_samples_cb_t *imu_samples_cb; // When set, fills in the IMU samples of synchronized captures
+    void *imu_samples_cb_context;
+
+    k4a_capture_cb_t *depth_capture_cb; // When set, depth captures are sent here as soon as they arrive
+    void *depth_capture_cb_context;
+    LOCK_HANDLE depth_cb_lock; // Locks access to depth_capture_cb, held while it runs instead of lock
+
 } capturesync_context_t;
 
 K4A_DECLARE_CONTEXT(capturesync_t, capturesync_context_t);
@@ -59,6 +77,134 @@ K4A_DECLARE_CONTEXT(capturesync_t, capturesync_context_t);
 #define DEPTH_CAPTURE (false)
 #define COLOR_CAPTURE (true)
 
+// The IR image of a depth capture, or its depth image when the depth engine only outputs depth. Both carry the same
+// timestamps.
+static k4a_image_t capture_get_depth_ir_image(k4a_capture_t capture)
+{
+    k4a_image_t image = capture_get_ir_image(capture);
+    if (image == NULL)
+    {
+        image = capture_get_depth_image(capture);
+    }
+    return image;
+}
+
+// Finds the device time spanned by the exposures of the capture's images. Image timestamps are the middle of the
+// exposure. Returns false when the capture has no image.
+static bool get_capture_exposure(capturesync_context_t *sync,
+                                 k4a_capture_t capture,
+                                 uint64_t *start_usec,
+                                 uint64_t *end_usec)
+{
+    k4a_image_t images[] = { capture_get_color_image(capture),
+                             capture_get_depth_image(capture),
+                             capture_get_ir_image(capture) };
+    bool found = false;
+
+    *start_usec = UINT64_MAX;
+    *end_usec = 0;
+    for (size_t i = 0; i < COUNTOF(images); i++)
+    {
+        if (images[i] == NULL)
+        {
+            continue;
+        }
+
+        uint64_t ts = image_get_device_timestamp_usec(images[i]);
+        uint64_t half_exposure = image_get_exposure_usec(images[i]) / 2;
+        if (half_exposure == 0)
+        {
+            // Depth and IR images don't report an exposure
+            half_exposure = sync->fps_period / 2;
+        }
+
+        uint64_t start = TS_SUBTRACT(ts, half_exposure);
+        if (start < *start_usec)
+        {
+            *start_usec = start;
+        }
+        if (ts + half_exposure > *end_usec)
+        {
+            *end_usec = ts + half_exposure;
+        }
+        found = true;
+        image_dec_ref(images[i]);
+    }
+    return found;
+}
+
+// Hands a capture to the user, either through the registered callback or through sync_queue. Must be called with
+// sync->lock held.
+static void publish_capture(capturesync_context_t *sync, k4a_capture_t capture)
+{
+    uint64_t start_usec, end_usec;
+    if (sync->imu_samples_cb != NULL && get_capture_exposure(sync, capture, &start_usec, &end_usec))
+    {
+        sync->imu_samples_cb(capture, start_usec, end_usec, sync->imu_samples_cb_context);
+    }
+
+    // Depth captures carry the time the depth engine finished with them, color only captures are not timed
+    uint64_t engine_end_nsec = capture_get_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_DEPTH_ENGINE);
+    if (engine_end_nsec != 0)
+    {
+        uint64_t now_nsec = latency_get_time_nsec();
+        latency_record(K4A_LATENCY_STAGE_CAPTURE_SYNC, engine_end_nsec, now_nsec);
+        capture_set_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_CAPTURE_SYNC, now_nsec);
+    }
+
+    if (sync->capture_cb != NULL)
+    {
+        sync->capture_cb(K4A_RESULT_SUCCEEDED, capture, sync->capture_cb_context);
+    }
+    else
+    {
+        k4a_capture_t dropped = NULL;
+        queue_push_w_dropped(sync->sync_queue, capture, &dropped);
+        if (dropped)
+        {
+            sync->stats.output_queue_overflow++;
+            capture_dec_ref(dropped);
+        }
+    }
+}
+
+// Hands a depth capture to the depth callback before it is matched with color, so depth latency doesn't include the
+// color pipeline. The callback gets its own capture with the depth and IR images; the synchronized capture that follows
+// shares those images and adds color. Called without sync->lock held.
+static void publish_depth_capture(capturesync_context_t *sync, k4a_capture_t capture_raw, uint64_t ts_raw_capture)
+{
+    Lock(sync->depth_cb_lock);
+
+    // Depth timestamps from before the reset at color start are dropped, the same as in capturesync_add_capture()
+    bool publish = sync->depth_capture_cb != NULL && sync->running &&
+                   !(sync->sync_captures && !sync->disable_sync && sync->waiting_for_clean_depth_ts &&
+                     ts_raw_capture / sync->fps_period > 10);
+    if (publish)
+    {
+        k4a_capture_t depth_capture = NULL;
+        if (K4A_SUCCEEDED(TRACE_CALL(capture_create(&depth_capture))))
+        {
+            k4a_image_t image = capture_get_depth_image(capture_raw);
+            if (image)
+            {
+                capture_set_depth_image(depth_capture, image);
+                image_dec_ref(image);
+            }
+            image = capture_get_ir_image(capture_raw);
+            if (image)
+            {
+                capture_set_ir_image(depth_capture, image);
+                image_dec_ref(image);
+            }
+            capture_set_temperature_c(depth_capture, capture_get_temperature_c(capture_raw));
+
+            sync->depth_capture_cb(K4A_RESULT_SUCCEEDED, depth_capture, sync->depth_capture_cb_context);
+            capture_dec_ref(depth_capture);
+        }
+    }
+    Unlock(sync->depth_cb_lock);
+}
+
 /**
  * This function is responsible for updating the information in either capturesync_context_t->depth_ir or in
  * capturesync_context_t->color. capturesync_context_t holds the capture, image, and ts for the sample we are currenly
@@ -80,16 +226,27 @@ drop_sample(capturesync_context_t *sync, k4a_wait_result_t *wresult, bool color_
 
     if (drop_into_queue)
     {
+        logger_trace(LOGGER_TRACE_CAPTURESYNC_DROP, frame_info->ts, color_capture ? 1 : 0, 0);
+
         // Log the capture being dropped on the floor
         LOG_INFO("capturesync_drop, Dropping sample TS:%10lld type:%s",
                  frame_info->ts,
                  color_capture ? "Color" : "Depth");
 
+        if (color_capture)
+        {
+            sync->stats.color_unmatched++;
+        }
+        else
+        {
+            sync->stats.depth_unmatched++;
+        }
+
         // If drop_into_queue is provided, then that caller wants the capture to placed into the provided queue, if no
         // drop_into_queue is provided, then it is dropped on the floor
         if (!sync->synchronized_images_only)
         {
-            queue_push(sync->sync_queue, frame_info->capture);
+            publish_capture(sync, frame_info->capture);
         }
     }
 
@@ -136,14 +293,25 @@ drop_sample(capturesync_context_t *sync, k4a_wait_result_t *wresult, bool color_
 
 static void replace_sample(capturesync_context_t *sync, k4a_capture_t capture_new, frame_info_t *frame_info)
 {
+    logger_trace(LOGGER_TRACE_CAPTURESYNC_DROP, frame_info->ts, frame_info->color_capture ? 1 : 0, 1);
+
     // Log the capture being dropped
     LOG_ERROR("capturesync_drop, releasing capture early due to full queue TS:%10lld type:%s",
               frame_info->ts,
               frame_info->color_capture ? "Color" : "Depth");
 
+    if (frame_info->color_capture)
+    {
+        sync->stats.color_queue_overflow++;
+    }
+    else
+    {
+        sync->stats.depth_queue_overflow++;
+    }
+
     if (!sync->synchronized_images_only)
     {
-        queue_push(sync->sync_queue, frame_info->capture);
+        publish_capture(sync, frame_info->capture);
     }
     capture_dec_ref(frame_info->capture);
     image_dec_ref(frame_info->image);
@@ -204,6 +372,21 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
         queue_stop(sync->depth_ir.queue);
         queue_stop(sync->color.queue);
 
+        // Let a registered callback know the stream has ended
+        Lock(sync->lock);
+        if (sync->capture_cb != NULL && sync->running)
+        {
+            sync->capture_cb(K4A_RESULT_FAILED, NULL, sync->capture_cb_context);
+        }
+        Unlock(sync->lock);
+
+        Lock(sync->depth_cb_lock);
+        if (sync->depth_capture_cb != NULL && sync->running)
+        {
+            sync->depth_capture_cb(K4A_RESULT_FAILED, NULL, sync->depth_capture_cb_context);
+        }
+        Unlock(sync->depth_cb_lock);
+
         // Reflect the low level error in the current result
         result = capture_result;
     }
@@ -223,7 +406,7 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
         }
         else
         {
-            image = capture_get_ir_image(capture_raw);
+            image = capture_get_depth_ir_image(capture_raw);
         }
         result = K4A_RESULT_FROM_BOOL(image != NULL);
         if (K4A_SUCCEEDED(result))
@@ -234,6 +417,12 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
         }
     }
 
+    // Depth goes out first, before waiting on the capturesync lock or for a matching color capture
+    if (K4A_SUCCEEDED(result) && !color_capture)
+    {
+        publish_depth_capture(sync, capture_raw, ts_raw_capture);
+    }
+
     if (K4A_SUCCEEDED(result))
     {
         Lock(sync->lock);
@@ -255,7 +444,7 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
         if (sync->sync_captures == false || sync->disable_sync == true)
         {
             // we are not synchronizing samples, just copy to the queue
-            queue_push(sync->sync_queue, capture_raw);
+            publish_capture(sync, capture_raw);
             result = K4A_RESULT_FAILED; // Not an error, just a graceful exit
         }
         else if (!color_capture && sync->waiting_for_clean_depth_ts)
@@ -264,17 +453,17 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
             // started. This code protects against the depth timestamps from being reported before the reset happens.
             if (ts_raw_capture / sync->fps_period > 10)
             {
-                sync->depth_captures_dropped++;
+                sync->stats.depth_dropped_timestamp_reset++;
                 result = K4A_RESULT_FAILED; // Not an error, just a graceful exit
             }
             else
             {
                 // Once we get a good TS we are going to always get a good TS
                 sync->waiting_for_clean_depth_ts = false;
-                if (sync->depth_captures_dropped)
+                if (sync->stats.depth_dropped_timestamp_reset)
                 {
-                    LOG_INFO("Dropped %d depth captures waiting for time stamps to stabilize",
-                             sync->depth_captures_dropped);
+                    LOG_INFO("Dropped %llu depth captures waiting for time stamps to stabilize",
+                             sync->stats.depth_dropped_timestamp_reset);
                 }
             }
         }
@@ -368,8 +557,12 @@ void capturesync_add_capture(capturesync_t capturesync_handle,
                     LOG_INFO("capturesync_link,TS_Color, %10lld, TS_Depth, %10lld,", sync->color.ts, sync->depth_ir.ts);
                 }
 
+                logger_trace(LOGGER_TRACE_CAPTURESYNC_MATCH, sync->color.ts, sync->depth_ir.ts, 0);
+                sync->stats.synchronized_captures++;
+                sync->skew_sum_usec += (int64_t)sync->depth_ir.ts - (int64_t)sync->color.ts;
+
                 k4a_capture_t merged = merge_captures(sync->depth_ir.capture, sync->color.capture);
-                queue_push(sync->sync_queue, merged);
+                publish_capture(sync, merged);
                 merged = NULL; // No need to call capture_dec_ref() here.
 
                 // Use drop symantic to get another sample from the queue if present. Synchronized sample is
@@ -406,7 +599,7 @@ k4a_result_t capturesync_create(capturesync_t *capturesync_handle)
 
     // In this module we can either use depth or color, we are only after the timestamp which is the same on both.
     sync->depth_ir.color_capture = false;
-    sync->depth_ir.get_typed_image = capture_get_ir_image;
+    sync->depth_ir.get_typed_image = capture_get_depth_ir_image;
 
     if (K4A_SUCCEEDED(result))
     {
@@ -414,6 +607,12 @@ k4a_result_t capturesync_create(capturesync_t *capturesync_handle)
         result = K4A_RESULT_FROM_BOOL(sync->lock != NULL);
     }
 
+    if (K4A_SUCCEEDED(result))
+    {
+        sync->depth_cb_lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(sync->depth_cb_lock != NULL);
+    }
+
     if (K4A_SUCCEEDED(result))
     {
         result = TRACE_CALL(queue_create(QUEUE_DEFAULT_SIZE, "Queue_depth", &sync->depth_ir.queue));
@@ -478,6 +677,10 @@ void capturesync_destroy(capturesync_t capturesync_handle)
     }
 
     Lock_Deinit(sync->lock);
+    if (sync->depth_cb_lock)
+    {
+        Lock_Deinit(sync->depth_cb_lock);
+    }
     capturesync_t_destroy(capturesync_handle);
 }
 
@@ -495,7 +698,11 @@ k4a_result_t capturesync_start(capturesync_t capturesync_handle, const k4a_devic
     sync->fps_1_quarter_period = sync->fps_period / 4;
     sync->depth_delay_off_color_usec = config->depth_delay_off_color_usec;
     sync->sync_captures = true;
-    sync->depth_captures_dropped = 0;
+
+    Lock(sync->lock);
+    memset(&sync->stats, 0, sizeof(sync->stats));
+    sync->skew_sum_usec = 0;
+    Unlock(sync->lock);
 
     if (config->color_resolution == K4A_COLOR_RESOLUTION_OFF || config->depth_mode == K4A_DEPTH_MODE_OFF)
     {
@@ -503,6 +710,29 @@ k4a_result_t capturesync_start(capturesync_t capturesync_handle, const k4a_devic
         sync->sync_captures = false;
     }
 
+    // A memory budget limits the captures held by the queues to its share, an explicit sync_queue_depth is kept
+    size_t capture_size = k4a_estimate_capture_size(config);
+    uint32_t sync_queue_depth = sync->sync_queue_depth;
+    if (sync_queue_depth == 0)
+    {
+        sync_queue_depth = allocator_budget_count(MEMORY_BUDGET_CAPTURES, capture_size, 1, QUEUE_DEFAULT_SIZE / 2);
+    }
+    uint32_t image_queue_depth = allocator_budget_count(MEMORY_BUDGET_CAPTURES, capture_size, 2, QUEUE_DEFAULT_SIZE);
+
+    k4a_result_t result = TRACE_CALL(queue_configure(sync->sync_queue, sync_queue_depth, sync->sync_queue_policy));
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(queue_configure(sync->color.queue, image_queue_depth, K4A_QUEUE_POLICY_DROP_OLDEST));
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(queue_configure(sync->depth_ir.queue, image_queue_depth, K4A_QUEUE_POLICY_DROP_OLDEST));
+    }
+    if (K4A_FAILED(result))
+    {
+        return result;
+    }
+
     queue_enable(sync->color.queue);
     queue_enable(sync->depth_ir.queue);
     queue_enable(sync->sync_queue);
@@ -518,6 +748,12 @@ void capturesync_stop(capturesync_t capturesync_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, capturesync_t, capturesync_handle);
     capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
 
+    // A capture blocked on a full sync_queue holds the lock, disabling the queue first releases it
+    if (sync->sync_queue)
+    {
+        queue_disable(sync->sync_queue);
+    }
+
     Lock(sync->lock);
     sync->running = false;
 
@@ -529,10 +765,6 @@ void capturesync_stop(capturesync_t capturesync_handle)
     {
         queue_disable(sync->depth_ir.queue);
     }
-    if (sync->sync_queue)
-    {
-        queue_disable(sync->sync_queue);
-    }
 
     if (sync->color.capture)
     {
@@ -562,6 +794,130 @@ void capturesync_stop(capturesync_t capturesync_handle)
     Unlock(sync->lock);
 }
 
+k4a_result_t capturesync_set_capture_callback(capturesync_t capturesync_handle,
+                                              k4a_capture_cb_t *capture_cb,
+                                              void *capture_cb_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+
+    // Captures are published with the lock held, so once this returns the old callback is no longer in use
+    Lock(sync->lock);
+    sync->capture_cb = capture_cb;
+    sync->capture_cb_context = capture_cb_context;
+    Unlock(sync->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t capturesync_set_imu_samples_callback(capturesync_t capturesync_handle,
+                                                  capturesync_imu_samples_cb_t *imu_samples_cb,
+                                                  void *imu_samples_cb_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+
+    // Captures are published with the lock held, so once this returns the old callback is no longer in use
+    Lock(sync->lock);
+    sync->imu_samples_cb = imu_samples_cb;
+    sync->imu_samples_cb_context = imu_samples_cb_context;
+    Unlock(sync->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t capturesync_set_depth_capture_callback(capturesync_t capturesync_handle,
+                                                    k4a_capture_cb_t *depth_capture_cb,
+                                                    void *depth_capture_cb_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+
+    // Depth captures are published with depth_cb_lock held, so once this returns the old callback is no longer in use
+    Lock(sync->depth_cb_lock);
+    sync->depth_capture_cb = depth_capture_cb;
+    sync->depth_capture_cb_context = depth_capture_cb_context;
+    Unlock(sync->depth_cb_lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t capturesync_set_queue_policy(capturesync_t capturesync_handle,
+                                         uint32_t queue_depth,
+                                         k4a_queue_policy_t policy)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth > 10000);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        policy != K4A_QUEUE_POLICY_DROP_OLDEST && policy != K4A_QUEUE_POLICY_DROP_NEWEST &&
+                            policy != K4A_QUEUE_POLICY_BLOCK);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(sync->lock);
+    if (sync->running)
+    {
+        LOG_ERROR("The capture queue can't be configured while the cameras are running.", 0);
+        result = K4A_RESULT_FAILED;
+    }
+    else
+    {
+        sync->sync_queue_depth = queue_depth;
+        sync->sync_queue_policy = policy;
+    }
+    Unlock(sync->lock);
+
+    return result;
+}
+
+k4a_result_t capturesync_get_stats(capturesync_t capturesync_handle, k4a_capture_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+
+    Lock(sync->lock);
+    *stats = sync->stats;
+    if (sync->stats.synchronized_captures != 0)
+    {
+        stats->average_skew_usec = sync->skew_sum_usec / (int64_t)sync->stats.synchronized_captures;
+    }
+
+    // The captures held in depth_ir and color are waiting for a match as well as the ones queued behind them
+    stats->depth_queue_count = queue_get_count(sync->depth_ir.queue) + (sync->depth_ir.capture != NULL ? 1 : 0);
+    stats->color_queue_count = queue_get_count(sync->color.queue) + (sync->color.capture != NULL ? 1 : 0);
+    stats->output_queue_count = queue_get_count(sync->sync_queue);
+    Unlock(sync->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t capturesync_add_waiter(capturesync_t capturesync_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, capturesync_t, capturesync_handle);
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+    return TRACE_CALL(queue_add_waiter(sync->sync_queue, waiter_handle));
+}
+
+void capturesync_remove_waiter(capturesync_t capturesync_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, capturesync_t, capturesync_handle);
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+    queue_remove_waiter(sync->sync_queue, waiter_handle);
+}
+
+bool capturesync_is_ready(capturesync_t capturesync_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(false, capturesync_t, capturesync_handle);
+    capturesync_context_t *sync = capturesync_t_get_context(capturesync_handle);
+    return queue_is_ready(sync->sync_queue);
+}
+
 k4a_wait_result_t capturesync_get_capture(capturesync_t capturesync_handle,
                                           k4a_capture_t *capture,
                                           int32_t timeout_in_ms)
@@ -575,6 +931,23 @@ k4a_wait_result_t capturesync_get_capture(capturesync_t capturesync_handle,
     k4a_wait_result_t wresult = queue_pop(sync->sync_queue, timeout_in_ms, &capture_handle);
     if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
     {
+        uint64_t publish_nsec = capture_get_latency_timestamp_nsec(capture_handle, K4A_LATENCY_STAGE_CAPTURE_SYNC);
+        if (publish_nsec != 0)
+        {
+            uint64_t now_nsec = latency_get_time_nsec();
+            latency_record(K4A_LATENCY_STAGE_USER, publish_nsec, now_nsec);
+            capture_set_latency_timestamp_nsec(capture_handle, K4A_LATENCY_STAGE_USER, now_nsec);
+            capture_set_latency_timestamp_nsec(capture_handle, K4A_LATENCY_STAGE_TOTAL, now_nsec);
+
+            // The depth and IR images keep the system timestamp of the USB transfer in every depth mode
+            k4a_image_t image = capture_get_depth_ir_image(capture_handle);
+            if (image)
+            {
+                latency_record(K4A_LATENCY_STAGE_TOTAL, image_get_system_timestamp_nsec(image), now_nsec);
+                image_dec_ref(image);
+            }
+        }
+
         *capture = capture_handle;
     }
     return wresult;
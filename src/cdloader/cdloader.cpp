@@ -0,0 +1,162 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/cdloader.h>
+
+#include <k4a/k4atypes.h>
+#include <k4ainternal/global.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/dynlib.h>
+
+#include <azure_c_shared_utility/envvariable.h>
+
+typedef struct
+{
+    k4a_decoder_plugin_t plugin;
+    dynlib_t handle;
+    k4a_register_decoder_plugin_fn registerFn;
+    volatile bool loaded;
+} cdloader_global_context_t;
+
+static void cdloader_init_once(cdloader_global_context_t *global);
+static void cdloader_deinit(void);
+
+// Creates a function called cdloader_global_context_t_get() which returns the initialized
+// singleton global
+K4A_DECLARE_GLOBAL(cdloader_global_context_t, cdloader_init_once);
+
+// Tear down the singleton when the binary unloads, the same way as the depth engine loader
+class cdloader_global_destroy
+{
+public:
+    cdloader_global_destroy() {}
+    ~cdloader_global_destroy()
+    {
+        cdloader_deinit();
+    }
+};
+static cdloader_global_destroy destroy_cdloader_on_binary_unload;
+
+static bool verify_plugin(const k4a_decoder_plugin_t *plugin)
+{
+    RETURN_VALUE_IF_ARG(false, plugin == NULL);
+
+    LOG_INFO("Loaded Color Decoder version: %u.%u.%u",
+             plugin->version.major,
+             plugin->version.minor,
+             plugin->version.patch);
+
+    // All function pointers must be non NULL
+    RETURN_VALUE_IF_ARG(false, plugin->decoder_create == NULL);
+    RETURN_VALUE_IF_ARG(false, plugin->decode_mjpeg == NULL);
+    RETURN_VALUE_IF_ARG(false, plugin->decoder_destroy == NULL);
+
+    return true;
+}
+
+// Load the Color Decoder, only when it is asked for since most systems will not have one
+static void cdloader_init_once(cdloader_global_context_t *global)
+{
+    // All members are initialized to zero
+
+    const char *enable_hardware_decode = environment_get_variable("K4A_COLOR_HARDWARE_DECODE");
+    if (enable_hardware_decode == NULL || enable_hardware_decode[0] == '\0' || enable_hardware_decode[0] == '0')
+    {
+        return;
+    }
+
+    k4a_result_t result = dynlib_create(K4A_DECODER_PLUGIN_DYNAMIC_LIBRARY_NAME,
+                                        K4A_DECODER_PLUGIN_VERSION,
+                                        &global->handle);
+    if (K4A_FAILED(result))
+    {
+        LOG_WARNING("Failed to Load Color Decoder Plugin (%s). Color images will be decoded in software",
+                    K4A_DECODER_PLUGIN_DYNAMIC_LIBRARY_NAME);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = dynlib_find_symbol(global->handle,
+                                    K4A_DECODER_PLUGIN_EXPORTED_FUNCTION,
+                                    (void **)&global->registerFn);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL(global->registerFn(&global->plugin));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL(verify_plugin(&global->plugin));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        global->loaded = true;
+    }
+}
+
+bool cdloader_is_loaded(void)
+{
+    cdloader_global_context_t *global = cdloader_global_context_t_get();
+    return global->loaded;
+}
+
+k4a_decoder_result_code_t cdloader_decoder_create(k4a_decoder_context_t **context,
+                                                  uint32_t width_pixels,
+                                                  uint32_t height_pixels)
+{
+    cdloader_global_context_t *global = cdloader_global_context_t_get();
+
+    if (!global->loaded)
+    {
+        return K4A_DECODER_RESULT_UNSUPPORTED;
+    }
+
+    return global->plugin.decoder_create(context, width_pixels, height_pixels);
+}
+
+k4a_decoder_result_code_t cdloader_decode_mjpeg(k4a_decoder_context_t *context,
+                                                const uint8_t *input_frame,
+                                                size_t input_frame_size,
+                                                uint8_t *output_frame,
+                                                uint32_t output_stride_bytes,
+                                                size_t output_frame_size)
+{
+    cdloader_global_context_t *global = cdloader_global_context_t_get();
+
+    if (!global->loaded)
+    {
+        return K4A_DECODER_RESULT_UNSUPPORTED;
+    }
+
+    return global->plugin.decode_mjpeg(context,
+                                       input_frame,
+                                       input_frame_size,
+                                       output_frame,
+                                       output_stride_bytes,
+                                       output_frame_size);
+}
+
+void cdloader_decoder_destroy(k4a_decoder_context_t **context)
+{
+    cdloader_global_context_t *global = cdloader_global_context_t_get();
+
+    if (!global->loaded)
+    {
+        return;
+    }
+
+    global->plugin.decoder_destroy(context);
+}
+
+void cdloader_deinit(void)
+{
+    cdloader_global_context_t *global = cdloader_global_context_t_get();
+
+    if (global->handle)
+    {
+        dynlib_destroy(global->handle);
+    }
+}
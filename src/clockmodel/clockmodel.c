@@ -0,0 +1,286 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <k4ainternal/clockmodel.h>
+
+// Dependent libraries
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/lock.h>
+
+
+// Device time covered by one window, the earliest arrival of each window is kept for the fit
+#define CLOCKMODEL_WINDOW_USEC (500000)
+
+// Windows kept, so the fit covers the last 16 seconds
+#define CLOCKMODEL_WINDOW_COUNT (32)
+
+// Bound on the drift between the device crystal and the system clock
+#define CLOCKMODEL_MAX_DRIFT_PPM (500)
+
+// An observation this far off the model means the device clock restarted
+#define CLOCKMODEL_MAX_ERROR_NSEC (500000000)
+
+#define CLOCKMODEL_NOMINAL_SLOPE (1000.0) // Nanoseconds per microsecond
+
+typedef struct _clockmodel_window_t
+{
+    uint64_t window;      // device_timestamp_usec / CLOCKMODEL_WINDOW_USEC
+    uint64_t device_usec; // Observation with the earliest arrival relative to its device time
+    uint64_t system_nsec;
+} clockmodel_window_t;
+
+typedef struct _clockmodel_context_t
+{
+    LOCK_HANDLE lock;
+
+    // Access to these members may only occur while holding lock
+    clockmodel_window_t windows[CLOCKMODEL_WINDOW_COUNT]; // Ring of windows in device time order
+    uint32_t oldest;
+    uint32_t window_count;
+    uint32_t observation_count;
+
+    // system_nsec = ref_system_nsec + intercept_nsec + slope * (device_usec - ref_device_usec)
+    uint64_t ref_device_usec;
+    uint64_t ref_system_nsec;
+    double slope;
+    double intercept_nsec;
+} clockmodel_context_t;
+
+K4A_DECLARE_CONTEXT(clockmodel_t, clockmodel_context_t);
+
+k4a_result_t clockmodel_create(clockmodel_t *clockmodel_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, clockmodel_handle == NULL);
+
+    clockmodel_context_t *clockmodel;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL((clockmodel = clockmodel_t_create(clockmodel_handle)) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // All other members are initialized to zero
+        clockmodel->slope = CLOCKMODEL_NOMINAL_SLOPE;
+        result = K4A_RESULT_FROM_BOOL((clockmodel->lock = Lock_Init()) != NULL);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        clockmodel_destroy(*clockmodel_handle);
+        *clockmodel_handle = NULL;
+    }
+
+    return result;
+}
+
+void clockmodel_destroy(clockmodel_t clockmodel_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, clockmodel_t, clockmodel_handle);
+    clockmodel_context_t *clockmodel = clockmodel_t_get_context(clockmodel_handle);
+
+    if (clockmodel->lock)
+    {
+        Lock_Deinit(clockmodel->lock);
+    }
+
+    clockmodel_t_destroy(clockmodel_handle);
+}
+
+static void clockmodel_reset_locked(clockmodel_context_t *clockmodel)
+{
+    clockmodel->oldest = 0;
+    clockmodel->window_count = 0;
+    clockmodel->observation_count = 0;
+    clockmodel->slope = CLOCKMODEL_NOMINAL_SLOPE;
+    clockmodel->intercept_nsec = 0;
+}
+
+void clockmodel_reset(clockmodel_t clockmodel_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, clockmodel_t, clockmodel_handle);
+    clockmodel_context_t *clockmodel = clockmodel_t_get_context(clockmodel_handle);
+
+    Lock(clockmodel->lock);
+    clockmodel_reset_locked(clockmodel);
+    Unlock(clockmodel->lock);
+}
+
+static clockmodel_window_t *clockmodel_window_locked(clockmodel_context_t *clockmodel, uint32_t i)
+{
+    return &clockmodel->windows[(clockmodel->oldest + i) % CLOCKMODEL_WINDOW_COUNT];
+}
+
+static double clockmodel_predict_locked(clockmodel_context_t *clockmodel, uint64_t device_timestamp_usec)
+{
+    double x = (double)(int64_t)(device_timestamp_usec - clockmodel->ref_device_usec);
+    return clockmodel->intercept_nsec + clockmodel->slope * x;
+}
+
+// Fits the drift to the earliest arrivals by least squares, then lowers the line under all of them
+static void clockmodel_fit_locked(clockmodel_context_t *clockmodel)
+{
+    const clockmodel_window_t *reference = clockmodel_window_locked(clockmodel, 0);
+    clockmodel->ref_device_usec = reference->device_usec;
+    clockmodel->ref_system_nsec = reference->system_nsec;
+
+    double mean_x = 0;
+    double mean_y = 0;
+    for (uint32_t i = 0; i < clockmodel->window_count; i++)
+    {
+        const clockmodel_window_t *window = clockmodel_window_locked(clockmodel, i);
+        mean_x += (double)(int64_t)(window->device_usec - clockmodel->ref_device_usec);
+        mean_y += (double)(int64_t)(window->system_nsec - clockmodel->ref_system_nsec);
+    }
+    mean_x /= clockmodel->window_count;
+    mean_y /= clockmodel->window_count;
+
+    double sxx = 0;
+    double sxy = 0;
+    for (uint32_t i = 0; i < clockmodel->window_count; i++)
+    {
+        const clockmodel_window_t *window = clockmodel_window_locked(clockmodel, i);
+        double dx = (double)(int64_t)(window->device_usec - clockmodel->ref_device_usec) - mean_x;
+        double dy = (double)(int64_t)(window->system_nsec - clockmodel->ref_system_nsec) - mean_y;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+
+    double slope = CLOCKMODEL_NOMINAL_SLOPE;
+    if (sxx > 0)
+    {
+        const double max_drift = CLOCKMODEL_NOMINAL_SLOPE * CLOCKMODEL_MAX_DRIFT_PPM / 1000000.0;
+        slope = sxy / sxx;
+        if (slope < CLOCKMODEL_NOMINAL_SLOPE - max_drift)
+        {
+            slope = CLOCKMODEL_NOMINAL_SLOPE - max_drift;
+        }
+        else if (slope > CLOCKMODEL_NOMINAL_SLOPE + max_drift)
+        {
+            slope = CLOCKMODEL_NOMINAL_SLOPE + max_drift;
+        }
+    }
+
+    double intercept = 0;
+    for (uint32_t i = 0; i < clockmodel->window_count; i++)
+    {
+        const clockmodel_window_t *window = clockmodel_window_locked(clockmodel, i);
+        double x = (double)(int64_t)(window->device_usec - clockmodel->ref_device_usec);
+        double y = (double)(int64_t)(window->system_nsec - clockmodel->ref_system_nsec);
+        if (i == 0 || y - slope * x < intercept)
+        {
+            intercept = y - slope * x;
+        }
+    }
+
+    clockmodel->slope = slope;
+    clockmodel->intercept_nsec = intercept;
+}
+
+void clockmodel_add_observation(clockmodel_t clockmodel_handle,
+                                uint64_t device_timestamp_usec,
+                                uint64_t system_timestamp_nsec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, clockmodel_t, clockmodel_handle);
+    clockmodel_context_t *clockmodel = clockmodel_t_get_context(clockmodel_handle);
+
+    if (device_timestamp_usec == 0 || system_timestamp_nsec == 0)
+    {
+        return;
+    }
+
+    uint64_t window_number = device_timestamp_usec / CLOCKMODEL_WINDOW_USEC;
+
+    Lock(clockmodel->lock);
+
+    if (clockmodel->window_count > 0)
+    {
+        const clockmodel_window_t *newest = clockmodel_window_locked(clockmodel, clockmodel->window_count - 1);
+        double error = (double)(int64_t)(system_timestamp_nsec - clockmodel->ref_system_nsec) -
+                       clockmodel_predict_locked(clockmodel, device_timestamp_usec);
+        bool restarted = window_number + CLOCKMODEL_WINDOW_COUNT <= newest->window;
+        if (clockmodel->observation_count >= CLOCKMODEL_MIN_OBSERVATIONS)
+        {
+            restarted = restarted || error > CLOCKMODEL_MAX_ERROR_NSEC || error < -CLOCKMODEL_MAX_ERROR_NSEC;
+        }
+
+        if (restarted)
+        {
+            LOG_INFO("Device clock restarted at %llu usec, resetting the clock model",
+                     (unsigned long long)device_timestamp_usec);
+            clockmodel_reset_locked(clockmodel);
+        }
+    }
+
+    // Find the window of the observation, data of different sensors can arrive slightly out of device time order
+    clockmodel_window_t *window = NULL;
+    for (uint32_t i = 0; i < clockmodel->window_count && window == NULL; i++)
+    {
+        clockmodel_window_t *candidate = clockmodel_window_locked(clockmodel, i);
+        if (candidate->window == window_number)
+        {
+            window = candidate;
+        }
+    }
+
+    bool changed = false;
+    if (window != NULL)
+    {
+        // Keep the observation with the least latency, the one arriving earliest relative to its device time
+        int64_t offset = (int64_t)(system_timestamp_nsec - device_timestamp_usec * 1000);
+        int64_t window_offset = (int64_t)(window->system_nsec - window->device_usec * 1000);
+        if (offset < window_offset)
+        {
+            window->device_usec = device_timestamp_usec;
+            window->system_nsec = system_timestamp_nsec;
+            changed = true;
+        }
+    }
+    else if (clockmodel->window_count == 0 ||
+             window_number > clockmodel_window_locked(clockmodel, clockmodel->window_count - 1)->window)
+    {
+        if (clockmodel->window_count == CLOCKMODEL_WINDOW_COUNT)
+        {
+            clockmodel->oldest = (clockmodel->oldest + 1) % CLOCKMODEL_WINDOW_COUNT;
+            clockmodel->window_count--;
+        }
+        window = clockmodel_window_locked(clockmodel, clockmodel->window_count);
+        clockmodel->window_count++;
+        window->window = window_number;
+        window->device_usec = device_timestamp_usec;
+        window->system_nsec = system_timestamp_nsec;
+        changed = true;
+    }
+    // Otherwise the window was already dropped from the fit
+
+    clockmodel->observation_count++;
+    if (changed)
+    {
+        clockmodel_fit_locked(clockmodel);
+    }
+
+    Unlock(clockmodel->lock);
+}
+
+k4a_result_t clockmodel_get_system_timestamp_nsec(clockmodel_t clockmodel_handle,
+                                                  uint64_t device_timestamp_usec,
+                                                  uint64_t *system_timestamp_nsec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, clockmodel_t, clockmodel_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, system_timestamp_nsec == NULL);
+    clockmodel_context_t *clockmodel = clockmodel_t_get_context(clockmodel_handle);
+    k4a_result_t result = K4A_RESULT_FAILED;
+
+    Lock(clockmodel->lock);
+    if (clockmodel->observation_count >= CLOCKMODEL_MIN_OBSERVATIONS)
+    {
+        double offset_nsec = clockmodel_predict_locked(clockmodel, device_timestamp_usec);
+        int64_t offset = (int64_t)(offset_nsec >= 0 ? offset_nsec + 0.5 : offset_nsec - 0.5);
+        if (offset >= 0 || (uint64_t)(-offset) <= clockmodel->ref_system_nsec)
+        {
+            *system_timestamp_nsec = clockmodel->ref_system_nsec + (uint64_t)offset;
+            result = K4A_RESULT_SUCCEEDED;
+        }
+    }
+    Unlock(clockmodel->lock);
+
+    return result;
+}
@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L // clock_gettime() in time.h
+#endif
+
+// This library
+#include <k4ainternal/clockmodel.h>
+
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/latency.h>
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/lock.h>
+
+// System dependencies
+#ifndef _WIN32
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// The offset to the shared timebase is measured again after this long
+#define TIMEBASE_RESYNC_NSEC (1000000000ull)
+
+// Readings of each measurement, the one bracketed most tightly by the system clock is kept
+#define TIMEBASE_SYNC_READS (5)
+
+#ifndef _WIN32
+// Clock ID of a dynamic POSIX clock opened from a file descriptor, see FD_TO_CLOCKID in the Linux documentation
+#define TIMEBASE_FD_TO_CLOCKID(fd) ((~(clockid_t)(fd) << 3) | 3)
+#endif
+
+typedef enum
+{
+    TIMEBASE_SOURCE_SYSTEM = 0, // No shared timebase, system timestamps are returned unchanged
+    TIMEBASE_SOURCE_CALLBACK,
+    TIMEBASE_SOURCE_CLOCK,
+} timebase_source_t;
+
+// Process wide shared timebase, there is one system clock for every device
+typedef struct
+{
+    LOCK_HANDLE lock;
+
+    // Access to these members may only occur while holding lock
+    timebase_source_t source;
+    k4a_shared_timebase_cb_t *callback;
+    void *callback_context;
+#ifndef _WIN32
+    clockid_t clock_id;
+    int phc_fd; // Open PTP hardware clock, -1 when the clock is the realtime clock
+#endif
+
+    bool synced;
+    uint64_t sync_system_nsec; // System time of the last measurement
+    int64_t offset_nsec;       // shared = system + offset
+} timebase_global_t;
+
+static void timebase_global_init(timebase_global_t *global);
+
+// Creates a function called timebase_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(timebase_global_t, timebase_global_init);
+
+static void timebase_global_init(timebase_global_t *global)
+{
+    // All other members are initialized to zero
+    global->lock = Lock_Init();
+#ifndef _WIN32
+    global->phc_fd = -1;
+#endif
+}
+
+// Returns to the system clock, closing the PTP hardware clock if one is open
+static void timebase_clear_locked(timebase_global_t *global)
+{
+#ifndef _WIN32
+    if (global->phc_fd >= 0)
+    {
+        close(global->phc_fd);
+        global->phc_fd = -1;
+    }
+#endif
+    global->source = TIMEBASE_SOURCE_SYSTEM;
+    global->callback = NULL;
+    global->callback_context = NULL;
+    global->synced = false;
+}
+
+k4a_result_t clockmodel_set_shared_timebase_callback(k4a_shared_timebase_cb_t *timebase_cb, void *timebase_cb_context)
+{
+    timebase_global_t *global = timebase_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+    Lock(global->lock);
+    timebase_clear_locked(global);
+    if (timebase_cb != NULL)
+    {
+        global->source = TIMEBASE_SOURCE_CALLBACK;
+        global->callback = timebase_cb;
+        global->callback_context = timebase_cb_context;
+    }
+    Unlock(global->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t clockmodel_set_shared_timebase_clock(const char *phc_device_path)
+{
+    timebase_global_t *global = timebase_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+#ifdef _WIN32
+    (void)phc_device_path;
+    LOG_ERROR("A clock of the host as the shared timebase is not supported on Windows, use a callback", 0);
+    return K4A_RESULT_FAILED;
+#else
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    clockid_t clock_id = CLOCK_REALTIME;
+    int phc_fd = -1;
+
+    if (phc_device_path != NULL)
+    {
+        phc_fd = open(phc_device_path, O_RDONLY);
+        if (phc_fd < 0)
+        {
+            LOG_ERROR("Failed to open the PTP hardware clock %s", phc_device_path);
+            result = K4A_RESULT_FAILED;
+        }
+        else
+        {
+            clock_id = TIMEBASE_FD_TO_CLOCKID(phc_fd);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        struct timespec ts_time;
+        result = K4A_RESULT_FROM_BOOL(clock_gettime(clock_id, &ts_time) == 0);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        if (phc_fd >= 0)
+        {
+            close(phc_fd);
+        }
+        return result;
+    }
+
+    Lock(global->lock);
+    timebase_clear_locked(global);
+    global->source = TIMEBASE_SOURCE_CLOCK;
+    global->clock_id = clock_id;
+    global->phc_fd = phc_fd;
+    Unlock(global->lock);
+
+    LOG_INFO("Shared timebase is %s", phc_device_path != NULL ? phc_device_path : "the realtime clock");
+    return result;
+#endif
+}
+
+// Reads the shared timebase, 0 on failure
+static uint64_t timebase_read_locked(timebase_global_t *global)
+{
+    if (global->source == TIMEBASE_SOURCE_CALLBACK)
+    {
+        return global->callback(global->callback_context);
+    }
+
+#ifndef _WIN32
+    struct timespec ts_time;
+    if (clock_gettime(global->clock_id, &ts_time) == 0)
+    {
+        return (uint64_t)ts_time.tv_sec * 1000000000 + (uint64_t)ts_time.tv_nsec;
+    }
+#endif
+    return 0;
+}
+
+// Measures the offset from the system clock to the shared timebase, bracketing each reading with the system clock
+static k4a_result_t timebase_sync_locked(timebase_global_t *global)
+{
+    uint64_t best_bracket_nsec = UINT64_MAX;
+
+    for (int i = 0; i < TIMEBASE_SYNC_READS; i++)
+    {
+        uint64_t before_nsec = latency_get_time_nsec();
+        uint64_t shared_nsec = timebase_read_locked(global);
+        uint64_t after_nsec = latency_get_time_nsec();
+
+        if (before_nsec == 0 || shared_nsec == 0 || after_nsec < before_nsec)
+        {
+            continue;
+        }
+
+        // The reading is assumed to happen half way through the bracket
+        if (after_nsec - before_nsec < best_bracket_nsec)
+        {
+            best_bracket_nsec = after_nsec - before_nsec;
+            global->offset_nsec = (int64_t)(shared_nsec - (before_nsec + best_bracket_nsec / 2));
+            global->sync_system_nsec = after_nsec;
+        }
+    }
+
+    global->synced = best_bracket_nsec != UINT64_MAX;
+    if (!global->synced)
+    {
+        LOG_ERROR("Failed to read the shared timebase", 0);
+    }
+    return K4A_RESULT_FROM_BOOL(global->synced);
+}
+
+k4a_result_t clockmodel_system_to_shared_nsec(uint64_t system_timestamp_nsec, uint64_t *shared_timestamp_nsec)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, shared_timestamp_nsec == NULL);
+    timebase_global_t *global = timebase_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(global->lock);
+    if (global->source == TIMEBASE_SOURCE_SYSTEM)
+    {
+        *shared_timestamp_nsec = system_timestamp_nsec;
+    }
+    else
+    {
+        uint64_t now_nsec = latency_get_time_nsec();
+        if (!global->synced || now_nsec < global->sync_system_nsec ||
+            now_nsec - global->sync_system_nsec >= TIMEBASE_RESYNC_NSEC)
+        {
+            result = TRACE_CALL(timebase_sync_locked(global));
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            *shared_timestamp_nsec = system_timestamp_nsec + (uint64_t)global->offset_nsec;
+        }
+    }
+    Unlock(global->lock);
+
+    return result;
+}
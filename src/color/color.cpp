@@ -5,6 +5,9 @@
 #include <k4ainternal/color.h>
 
 // Dependent libraries
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/queue.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -12,6 +15,7 @@
 #include <assert.h>
 #include <new>
 #include <array>
+#include <mutex>
 
 #include "color_priv.h"
 
@@ -34,7 +38,17 @@ typedef struct _color_context_t
     color_cb_streaming_capture_t *capture_ready_cb;
     void *capture_ready_cb_context;
     tickcounter_ms_t sensor_start_time_tick;
+    k4a_color_scale_t scale;
     std::array<color_control_cap_t, K4A_COLOR_CONTROL_POWERLINE_FREQUENCY + 1> control_cap = {};
+
+    // Control values read from the device, so polling them doesn't cost a USB request each time. Manual values are
+    // cached until a control is set, auto values are taken from the metadata of the last color image.
+    std::mutex control_value_lock;
+    std::array<color_control_value_t, K4A_COLOR_CONTROL_POWERLINE_FREQUENCY + 1> control_value = {};
+    uint32_t control_generation; // Incremented when a control is set, values read before are not cached
+    int32_t frame_exposure_usec; // Exposure of the last color image, 0 when not streaming
+    int32_t frame_white_balance; // White balance of the last color image, 0 when not streaming
+    uint32_t reserved_buffers;   // Color buffers reserved with allocator_pool_reserve() while streaming
 #ifdef _WIN32
     Microsoft::WRL::ComPtr<CMFCameraReader> m_spCameraReader;
 #else
@@ -65,6 +79,7 @@ k4a_result_t color_create(TICK_COUNTER_HANDLE tick_handle,
         color->capture_ready_cb_context = capture_ready_context;
         color->sensor_start_time_tick = 0;
         color->tick = tick_handle;
+        color->scale = K4A_COLOR_SCALE_FULL;
 
 #ifdef _WIN32
         (void)(serial_number);
@@ -112,6 +127,18 @@ void color_capture_available(k4a_result_t result, k4a_capture_t capture_handle,
 {
     color_context_t *color = (color_context_t *)context;
 
+    if (result == K4A_RESULT_SUCCEEDED)
+    {
+        k4a_image_t image = capture_get_color_image(capture_handle);
+        if (image)
+        {
+            std::lock_guard<std::mutex> lock(color->control_value_lock);
+            color->frame_exposure_usec = (int32_t)image_get_exposure_usec(image);
+            color->frame_white_balance = (int32_t)image_get_white_balance(image);
+            image_dec_ref(image);
+        }
+    }
+
     if (color->capture_ready_cb)
     {
         color->capture_ready_cb(result, capture_handle, color->capture_ready_cb_context);
@@ -125,6 +152,52 @@ void color_capture_available(k4a_result_t result, k4a_capture_t capture_handle,
     }
 }
 
+k4a_result_t color_set_scale(color_t color_handle, k4a_color_scale_t scale)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, scale < K4A_COLOR_SCALE_FULL || scale > K4A_COLOR_SCALE_EIGHTH);
+    color_context_t *color = color_t_get_context(color_handle);
+    color->scale = scale;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// With a memory budget, the buffers of the color images the capture queues can hold are allocated before streaming
+static void color_reserve_buffers(color_context_t *color,
+                                  const k4a_device_configuration_t *config,
+                                  uint32_t width,
+                                  uint32_t height)
+{
+    size_t buffer_size = 0;
+    switch (config->color_format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        buffer_size = (size_t)width * height * 4;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        buffer_size = (size_t)width * height * 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        buffer_size = (size_t)width * height * 3 / 2;
+        break;
+    default:
+        // MJPG frames vary in size and can't be pooled
+        return;
+    }
+
+    if (allocator_get_memory_budget() == 0 || color->scale != K4A_COLOR_SCALE_FULL)
+    {
+        return;
+    }
+
+    // The queued captures, plus the image being received and the one waiting for its depth image
+    size_t capture_size = k4a_estimate_capture_size(config);
+    uint32_t count = allocator_budget_count(MEMORY_BUDGET_CAPTURES, capture_size, 1, QUEUE_DEFAULT_SIZE / 2) + 2;
+    if (K4A_SUCCEEDED(allocator_pool_reserve(ALLOCATION_SOURCE_COLOR, buffer_size, count)))
+    {
+        color->reserved_buffers = count;
+    }
+}
+
 k4a_result_t color_start(color_t color_handle, const k4a_device_configuration_t *config)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
@@ -182,16 +255,43 @@ k4a_result_t color_start(color_t color_handle, const k4a_device_configuration_t
         return K4A_RESULT_FAILED;
     }
 
+    if (color->scale != K4A_COLOR_SCALE_FULL)
+    {
+#ifdef _WIN32
+        LOG_ERROR("Scaled color images are not supported on this platform", 0);
+        return K4A_RESULT_FAILED;
+#else
+        if (config->color_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+        {
+            LOG_ERROR("Scaled color images require K4A_IMAGE_FORMAT_COLOR_BGRA32, color_format is %d",
+                      config->color_format);
+            return K4A_RESULT_FAILED;
+        }
+#endif
+    }
+
     result = K4A_RESULT_FROM_BOOL(tickcounter_get_current_ms(color->tick, &color->sensor_start_time_tick) == 0);
 
     if (K4A_SUCCEEDED(result))
     {
+        color_reserve_buffers(color, config, width, height);
+
+#ifdef _WIN32
         result = TRACE_CALL(color->m_spCameraReader->Start(width,
                                                            height,                   // Resolution
                                                            fps,                      // Framerate
                                                            config->color_format,     // Color format enum
                                                            &color_capture_available, // Callback
                                                            color));                  // Callback context
+#else
+        result = TRACE_CALL(color->m_spCameraReader->Start(width,
+                                                           height,                   // Resolution
+                                                           fps,                      // Framerate
+                                                           config->color_format,     // Color format enum
+                                                           color->scale,             // Decoded image scale
+                                                           &color_capture_available, // Callback
+                                                           color));                  // Callback context
+#endif
     }
 
     if (K4A_FAILED(result))
@@ -216,6 +316,17 @@ void color_stop(color_t color_handle)
         color->m_spCameraReader->Stop();
     }
 
+    if (color->reserved_buffers != 0)
+    {
+        allocator_pool_unreserve(ALLOCATION_SOURCE_COLOR, color->reserved_buffers);
+        color->reserved_buffers = 0;
+    }
+
+    // Auto values are read from the device again until the next color image
+    std::lock_guard<std::mutex> lock(color->control_value_lock);
+    color->frame_exposure_usec = 0;
+    color->frame_white_balance = 0;
+
     return;
 }
 
@@ -278,8 +389,53 @@ k4a_result_t color_get_control(const color_t handle,
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, mode == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, value == NULL);
     color_context_t *color = color_t_get_context(handle);
+    uint32_t generation = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(color->control_value_lock);
+        const color_control_value_t &cached = color->control_value[command];
+        if (cached.valid && cached.mode == K4A_COLOR_CONTROL_MODE_MANUAL)
+        {
+            *mode = cached.mode;
+            *value = cached.value;
+            return K4A_RESULT_SUCCEEDED;
+        }
 
-    return color->m_spCameraReader->GetCameraControl(command, mode, value);
+        // Auto values change from frame to frame, the color image metadata has them for exposure and white balance
+        int32_t frame_value = 0;
+        if (cached.valid && command == K4A_COLOR_CONTROL_EXPOSURE_TIME_ABSOLUTE)
+        {
+            frame_value = color->frame_exposure_usec;
+        }
+        else if (cached.valid && command == K4A_COLOR_CONTROL_WHITEBALANCE)
+        {
+            frame_value = color->frame_white_balance;
+        }
+        if (frame_value != 0)
+        {
+            *mode = K4A_COLOR_CONTROL_MODE_AUTO;
+            *value = frame_value;
+            return K4A_RESULT_SUCCEEDED;
+        }
+
+        generation = color->control_generation;
+    }
+
+    k4a_result_t result = color->m_spCameraReader->GetCameraControl(command, mode, value);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Not cached if a control was set while the value was read, it may be the value from before
+        std::lock_guard<std::mutex> lock(color->control_value_lock);
+        if (generation == color->control_generation)
+        {
+            color->control_value[command].mode = *mode;
+            color->control_value[command].value = *value;
+            color->control_value[command].valid = true;
+        }
+    }
+
+    return result;
 }
 
 k4a_result_t color_set_control(const color_t handle,
@@ -295,7 +451,20 @@ k4a_result_t color_set_control(const color_t handle,
                         mode != K4A_COLOR_CONTROL_MODE_AUTO && mode != K4A_COLOR_CONTROL_MODE_MANUAL);
     color_context_t *color = color_t_get_context(handle);
 
-    return color->m_spCameraReader->SetCameraControl(command, mode, value);
+    k4a_result_t result = color->m_spCameraReader->SetCameraControl(command, mode, value);
+
+    {
+        // Every value is read again, controls depend on each other, for example exposure on the powerline frequency.
+        // Also done on failure, the control may have been set partially.
+        std::lock_guard<std::mutex> lock(color->control_value_lock);
+        for (color_control_value_t &cached : color->control_value)
+        {
+            cached.valid = false;
+        }
+        color->control_generation++;
+    }
+
+    return result;
 }
 
 #ifdef __cplusplus
@@ -21,6 +21,13 @@ typedef struct _color_control_cap_t
     bool valid;
 } color_control_cap_t;
 
+typedef struct _color_control_value_t
+{
+    k4a_color_control_mode_t mode;
+    int32_t value;
+    bool valid;
+} color_control_value_t;
+
 typedef struct _exposure_mapping
 {
     int exponent;                  // Windows Media Foundation implementation detail
@@ -12,6 +12,10 @@
 #define COLOR_CAMERA_IDENTIFIER L"vid_045e&pid_097d"
 #define MetadataId_FrameAlignInfo 0x80000001
 
+// Number of ReadSample requests kept pending with the source reader. Each completed request is replaced before its
+// sample is processed, so the device always has somewhere to deliver the next frame while the callback runs.
+#define MFCAMERAREADER_PENDING_READS 3
+
 #pragma pack(push, 1)
 typedef struct tag_CUSTOM_METADATA_FrameAlignInfo
 {
@@ -179,6 +183,12 @@ CMFCameraReader::CMFCameraReader()
     {
         m_use_mf_buffer = false;
     }
+
+    const char *hardware_decode = environment_get_variable("K4A_COLOR_HARDWARE_DECODE");
+    if (hardware_decode != NULL && hardware_decode[0] != '\0' && hardware_decode[0] != '0')
+    {
+        m_use_hardware_transforms = true;
+    }
 }
 
 CMFCameraReader::~CMFCameraReader()
@@ -231,7 +241,7 @@ HRESULT CMFCameraReader::RuntimeClassInitialize(GUID *containerId)
         }
 
         // Create Source Reader
-        if (FAILED(hr = MFCreateAttributes(&spAttributes, 3)))
+        if (FAILED(hr = MFCreateAttributes(&spAttributes, 4)))
         {
             LOG_ERROR("Failed to create attribute bag in open camera: 0x%08x", hr);
             return hr;
@@ -255,6 +265,14 @@ HRESULT CMFCameraReader::RuntimeClassInitialize(GUID *containerId)
             return hr;
         }
 
+        // Let the source reader use the hardware MJPEG decoder and color converter instead of the software MFTs
+        if (m_use_hardware_transforms &&
+            FAILED(hr = spAttributes->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, 1)))
+        {
+            LOG_ERROR("Failed to enable hardware transforms: 0x%08x", hr);
+            return hr;
+        }
+
         if (FAILED(
                 hr = MFCreateSourceReaderFromMediaSource(spColorSource.Get(), spAttributes.Get(), &m_spSourceReader)))
         {
@@ -464,15 +482,17 @@ k4a_result_t CMFCameraReader::Start(const UINT32 width,
             m_pCallback = pCallback;
             m_pCallbackContext = pCallbackContext;
 
-            if (SUCCEEDED(hr = m_spSourceReader->ReadSample(
-                              (DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr)))
-            {
-                m_started = true;
-            }
-            else
+            for (int i = 0; SUCCEEDED(hr) && i < MFCAMERAREADER_PENDING_READS; i++)
             {
-                LOG_ERROR("Failed to request first sample at start: 0x%08x", hr);
+                if (FAILED(hr = m_spSourceReader->ReadSample(
+                               (DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr)))
+                {
+                    LOG_ERROR("Failed to request sample %d at start: 0x%08x", i, hr);
+                }
             }
+
+            // Requests that were issued before a failure complete while m_started is false and are dropped
+            m_started = SUCCEEDED(hr);
         }
         else
         {
@@ -994,7 +1014,7 @@ k4a_result_t CMFCameraReader::CreateImageCopy(CFrameContext *pFrameContext, k4a_
     size_t size = pFrameContext->GetFrameSize();
 
     k4a_result_t result;
-    uint8_t *buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, size);
+    uint8_t *buffer = allocator_alloc_image(ALLOCATION_SOURCE_COLOR, m_image_format, size);
     result = K4A_RESULT_FROM_BOOL(buffer != NULL);
 
     if (K4A_SUCCEEDED(result))
@@ -1034,6 +1054,7 @@ STDMETHODIMP CMFCameraReader::OnReadSample(HRESULT hrStatus,
                                            IMFSample *pSample)
 {
     HRESULT hr = S_OK;
+    HRESULT hrRequest = S_OK;
     UNREFERENCED_PARAMETER(dwStreamIndex);
     UNREFERENCED_PARAMETER(dwStreamFlags);
     UNREFERENCED_PARAMETER(llTimestamp);
@@ -1044,6 +1065,14 @@ STDMETHODIMP CMFCameraReader::OnReadSample(HRESULT hrStatus,
 
         if (m_started && !m_flushing)
         {
+            // Replace this request before processing the sample so the source reader keeps
+            // MFCAMERAREADER_PENDING_READS requests pending while the callback and the conversion run
+            if (FAILED(hrRequest = m_spSourceReader->ReadSample(
+                           (DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr)))
+            {
+                LOG_ERROR("Failed to request sample: 0x%08x", hrRequest);
+            }
+
             if (pSample && m_pCallback && m_pCallbackContext)
             {
                 k4a_capture_t capture = NULL;
@@ -1129,12 +1158,8 @@ STDMETHODIMP CMFCameraReader::OnReadSample(HRESULT hrStatus,
                 }
             }
 
-            // Request next sample
-            if (FAILED(hr = m_spSourceReader->ReadSample(
-                           (DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr)))
-            {
-                LOG_ERROR("Failed to request sample: 0x%08x", hr);
-            }
+            // Only a failed request stops the stream, a sample that fails to convert is reported and skipped
+            hr = hrRequest;
         }
     }
     else
@@ -157,6 +157,7 @@ private:
     bool m_started = false;
     bool m_flushing = false;
     bool m_use_mf_buffer = true;
+    bool m_use_hardware_transforms = false;
     bool m_using_60hz_power = true;
     HANDLE m_hStreamFlushed = NULL;
 
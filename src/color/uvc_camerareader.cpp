@@ -2,6 +2,11 @@
 #include "ksmetadata.h"
 #include <k4ainternal/common.h>
 #include <k4ainternal/capture.h>
+#include <k4ainternal/threadpool.h>
+#include <azure_c_shared_utility/envvariable.h>
+
+#include <stdlib.h>
+#include <string.h>
 
 #define COLOR_CAMERA_VID 0x045e
 #define COLOR_CAMERA_PID 0x097d // K4A
@@ -13,6 +18,14 @@
 
 #define CONV_100USEC_TO_USEC (100)
 
+// Number of threads decoding MJPEG to BGRA32, K4A_COLOR_DECODE_THREADS overrides it and 0 builds the captures on the
+// UVC callback thread. Formats that are not decoded use a single thread to keep that work off the callback thread.
+#define UVC_DEFAULT_DECODE_THREADS (2)
+#define UVC_MAX_DECODE_THREADS (16)
+
+// Frames in flight per frame worker before new frames are dropped
+#define UVC_FRAME_JOBS_PER_THREAD (2)
+
 // libUVC frame callback
 static void UVCFrameCallback(uvc_frame_t *frame, void *ptr)
 {
@@ -75,11 +88,14 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
                                     const uint32_t height,
                                     const float fps,
                                     const k4a_image_format_t imageFormat,
+                                    const k4a_color_scale_t scale,
                                     color_cb_stream_t *pCallback,
                                     void *pCallbackContext)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, pCallback == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, pCallbackContext == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        scale != K4A_COLOR_SCALE_FULL && imageFormat != K4A_IMAGE_FORMAT_COLOR_BGRA32);
     std::lock_guard<std::mutex> lock(m_mutex);
 
     if (!IsInitialized())
@@ -94,6 +110,17 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         return K4A_RESULT_FAILED;
     }
 
+    m_lazyDecode = false;
+
+    // Frames that are not decoded keep the buffer libuvc copied them into
+    const char *env_zero_copy = environment_get_variable("K4A_COLOR_ZERO_COPY");
+    m_zeroCopy = env_zero_copy != NULL && env_zero_copy[0] != '\0' && env_zero_copy[0] != '0';
+
+    // MJPEG frames decoded to BGRA32 are scaled by the IDCT, image dimensions are rounded up the same way as libjpeg
+    tjscalingfactor scalingFactor = { 1, 1 << scale };
+    m_width_pixels = (uint32_t)TJSCALED((int)width, scalingFactor);
+    m_height_pixels = (uint32_t)TJSCALED((int)height, scalingFactor);
+
     uvc_stream_ctrl_t ctrl;
     uvc_frame_format frameFormat = UVC_FRAME_FORMAT_UNKNOWN;
     switch (imageFormat)
@@ -120,16 +147,23 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         m_output_image_format = imageFormat;
         m_input_image_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
 
-        if (m_decoder == nullptr)
+        if (m_decoder.turbojpeg == nullptr)
         {
-            m_decoder = tjInitDecompress();
-            if (m_decoder == nullptr)
+            m_decoder.turbojpeg = tjInitDecompress();
+            if (m_decoder.turbojpeg == nullptr)
             {
                 LOG_ERROR("MJPEG decoder initialization failed\n", 0);
                 return K4A_RESULT_FAILED;
             }
         }
 
+        // Decoding on first access replaces decoding on the frame workers, frames the application drops are never
+        // decoded
+        {
+            const char *env_lazy_decode = environment_get_variable("K4A_COLOR_LAZY_DECODE");
+            m_lazyDecode = env_lazy_decode != NULL && env_lazy_decode[0] != '\0' && env_lazy_decode[0] != '0';
+        }
+
         frameFormat = UVC_COLOR_FORMAT_MJPEG;
         break;
     default:
@@ -137,8 +171,11 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         return K4A_RESULT_FAILED;
     }
 
-    m_width_pixels = width;
-    m_height_pixels = height;
+    if (K4A_FAILED(TRACE_CALL(StartFrameWorkers())))
+    {
+        StopFrameWorkers();
+        return K4A_RESULT_FAILED;
+    }
 
     // Set frame format
     uvc_error_t res =
@@ -152,6 +189,7 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
                   (int)fps,
                   imageFormat,
                   uvc_strerror(res));
+        StopFrameWorkers();
         return K4A_RESULT_FAILED;
     }
 
@@ -169,6 +207,7 @@ k4a_result_t UVCCameraReader::Start(const uint32_t width,
         m_height_pixels = 0;
         m_pCallback = nullptr;
         m_pCallbackContext = nullptr;
+        StopFrameWorkers();
 
         return K4A_RESULT_FAILED;
     }
@@ -189,14 +228,20 @@ void UVCCameraReader::Stop()
         }
 
         m_streaming = false;
-        m_pCallback = nullptr;
-        m_pCallbackContext = nullptr;
 
         // Call uvc_stop_streaming() without lock.
         // uvc_stop_streaming() returns when all callbacks are completed or cancelled.
         // Calling it with lock may cause deadlock.
         lock.unlock();
         uvc_stop_streaming(m_pDeviceHandle);
+
+        // The decode workers publish through m_pCallback, so it is cleared once they are stopped. Frames they have not
+        // published yet are dropped.
+        StopFrameWorkers();
+
+        lock.lock();
+        m_pCallback = nullptr;
+        m_pCallbackContext = nullptr;
     }
 }
 
@@ -226,12 +271,20 @@ void UVCCameraReader::Shutdown()
         m_pContext = nullptr;
     }
 
-    if (m_decoder)
+    if (m_decoder.turbojpeg)
     {
         // Destroy MJPEG decoder
-        (void)tjDestroy(m_decoder);
-        m_decoder = nullptr;
+        (void)tjDestroy(m_decoder.turbojpeg);
+        m_decoder.turbojpeg = nullptr;
+    }
+
+    for (MJPEGDecoder &decoder : m_workerDecoders)
+    {
+        (void)tjDestroy(decoder.turbojpeg);
     }
+    m_workerDecoders.clear();
+    m_frameJobPool.clear();
+    m_freeFrameJobs.clear();
 }
 
 k4a_result_t UVCCameraReader::GetCameraControlCapabilities(const k4a_color_control_command_t command,
@@ -1115,21 +1168,92 @@ static void uvc_camerareader_free_allocation(void *buffer, void *context)
     allocator_free(buffer);
 }
 
+// Callback function for when image objects holding frame data taken from libuvc are destroyed
+static void uvc_camerareader_free_frame_data(void *buffer, void *context)
+{
+    (void)context;
+    free(buffer);
+}
+
+// Returns a K4A buffer holding the frame data, and the function that frees it. With zero copy the buffer libuvc copied
+// the frame into is taken over. libuvc grows frame->data with realloc() whenever it is smaller than the next frame, so
+// clearing it makes libuvc allocate a new buffer for the next frame.
+uint8_t *UVCCameraReader::TakeFrameBuffer(uvc_frame_t *frame, image_destroy_cb_t **buffer_free)
+{
+    uint8_t *buffer = nullptr;
+
+    if (m_zeroCopy)
+    {
+        buffer = (uint8_t *)frame->data;
+        frame->data = nullptr;
+        frame->data_bytes = 0;
+        *buffer_free = uvc_camerareader_free_frame_data;
+    }
+    else
+    {
+        // Copy to K4A buffer
+        buffer = allocator_alloc_image(ALLOCATION_SOURCE_COLOR, m_input_image_format, frame->data_bytes);
+        if (buffer != NULL)
+        {
+            memcpy(buffer, frame->data, frame->data_bytes);
+        }
+        *buffer_free = uvc_camerareader_free_allocation;
+    }
+
+    return buffer;
+}
+
+// Decodes a deferred BGRA32 image from its MJPEG frame. The image may outlive the camera reader and be accessed from
+// any thread, so it uses a decoder of its own.
+static k4a_result_t uvc_camerareader_decode_deferred(k4a_image_t image,
+                                                     const uint8_t *payload,
+                                                     size_t payload_size,
+                                                     uint8_t *buffer,
+                                                     size_t buffer_size,
+                                                     void *context)
+{
+    (void)context;
+    int width = image_get_width_pixels(image);
+    int height = image_get_height_pixels(image);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, (size_t)width * (size_t)height * 4 > buffer_size);
+
+    tjhandle decoder = tjInitDecompress();
+    if (decoder == nullptr)
+    {
+        LOG_ERROR("MJPEG decoder initialization failed", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    int decompressStatus = tjDecompress2(decoder,
+                                         (unsigned char *)payload,
+                                         (unsigned long)payload_size,
+                                         buffer,
+                                         width,
+                                         0, // pitch
+                                         height,
+                                         TJPF_BGRA,
+                                         TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE);
+    (void)tjDestroy(decoder);
+
+    if (decompressStatus != 0)
+    {
+        LOG_WARNING("MJPEG decode failed: %d", decompressStatus);
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 void UVCCameraReader::Callback(uvc_frame_t *frame)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
 
     if (m_streaming && frame)
     {
-        void *context = nullptr;
-        k4a_image_t image = NULL;
         uint8_t *buffer = nullptr;
         size_t buffer_size = 0;
         int stride = 0;
-        uint64_t framePTS = 0;
-        uint64_t exposure_time = 0;
-        uint32_t iso_speed = 0;
-        uint32_t white_balance = 0;
+        FrameMetadata metadata = {};
         bool decodeMJPEG = false;
         bool drop_image = false;
 
@@ -1146,7 +1270,7 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                 {
                     PKSCAMERA_CUSTOM_METADATA_FrameAlignInfo pFrameAlignInfo =
                         (PKSCAMERA_CUSTOM_METADATA_FrameAlignInfo)pItem;
-                    framePTS = pFrameAlignInfo->FramePTS;
+                    metadata.framePTS = pFrameAlignInfo->FramePTS;
                 }
                 break;
                 case MetadataId_CaptureStats:
@@ -1154,15 +1278,15 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                     PKSCAMERA_METADATA_CAPTURESTATS pCaptureStats = (PKSCAMERA_METADATA_CAPTURESTATS)pItem;
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_EXPOSURETIME)
                     {
-                        exposure_time = pCaptureStats->ExposureTime / 10; // hns to micro-second
+                        metadata.exposureTime = pCaptureStats->ExposureTime / 10; // hns to micro-second
                     }
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_ISOSPEED)
                     {
-                        iso_speed = pCaptureStats->IsoSpeed;
+                        metadata.isoSpeed = pCaptureStats->IsoSpeed;
                     }
                     if (pCaptureStats->Flags & KSCAMERA_METADATA_CAPTURESTATS_FLAG_WHITEBALANCE)
                     {
-                        white_balance = pCaptureStats->WhiteBalance;
+                        metadata.whiteBalance = pCaptureStats->WhiteBalance;
                     }
                 }
                 break;
@@ -1186,114 +1310,550 @@ void UVCCameraReader::Callback(uvc_frame_t *frame)
                                                                         pItem->Size);
             }
         }
-        if (framePTS == 0)
+        if (metadata.framePTS == 0)
         {
             // Drop 0 time stamped frame
             return;
         }
 
-        if (m_input_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG &&
-            m_output_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+        metadata.systemTimestamp = (uint64_t)frame->capture_time_finished.tv_sec * 1000000000;
+        metadata.systemTimestamp += (uint64_t)frame->capture_time_finished.tv_nsec;
+
+        if (!m_frameWorkers.empty())
+        {
+            // The frame workers build and publish the capture once the frame data is copied, so decoding and the
+            // color callback do not hold up libusb event handling
+            QueueFrameJob(frame, metadata);
+            return;
+        }
+
+        if (IsDecodingMJPEG())
         {
-            stride = (int)frame->width * 4;
-            buffer_size = (size_t)stride * frame->height;
+            stride = (int)m_width_pixels * 4;
+            buffer_size = (size_t)stride * m_height_pixels;
             decodeMJPEG = true;
         }
         else
         {
+            // Lazily decoded images keep the MJPEG frame as their payload
             stride = (int)frame->step;
             buffer_size = frame->data_bytes;
         }
 
-        // Allocate K4A Color buffer
-        buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, buffer_size);
-        k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
-
-        if (K4A_SUCCEEDED(result))
+        image_destroy_cb_t *buffer_free = uvc_camerareader_free_allocation;
+        k4a_result_t result;
+        if (decodeMJPEG)
         {
-            if (decodeMJPEG)
+            // Allocate K4A Color buffer
+            buffer = allocator_alloc_image(ALLOCATION_SOURCE_COLOR, m_output_image_format, buffer_size);
+            result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+
+            if (K4A_SUCCEEDED(result))
             {
                 // Decode MJPG into BRGA32
-                result = DecodeMJPEGtoBGRA32((uint8_t *)frame->data, frame->data_bytes, buffer, buffer_size);
+                result = DecodeMJPEGtoBGRA32(m_decoder,
+                                             (uint8_t *)frame->data,
+                                             frame->data_bytes,
+                                             buffer,
+                                             buffer_size);
                 if (K4A_FAILED(result))
                 {
                     drop_image = true;
                 }
             }
+        }
+        else
+        {
+            buffer = TakeFrameBuffer(frame, &buffer_free);
+            result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+        }
+
+        k4a_capture_t capture = NULL;
+        if (K4A_SUCCEEDED(result))
+        {
+            if (m_lazyDecode)
+            {
+                result = TRACE_CALL(CreateDeferredCapture(metadata, buffer, buffer_size, buffer_free, &capture));
+            }
             else
             {
-                // Copy to K4A buffer
-                memcpy(buffer, frame->data, buffer_size);
+                result = TRACE_CALL(CreateCapture(metadata, buffer, buffer_size, stride, buffer_free, &capture));
             }
         }
+        else if (buffer)
+        {
+            // cleanup if there was an error
+            buffer_free(buffer, nullptr);
+        }
 
-        if (K4A_SUCCEEDED(result))
+        if (!drop_image)
         {
-            // The buffer size may be larger than the height * stride for some formats
-            // so we must use image_create_from_buffer rather than image_create
-            result = TRACE_CALL(image_create_from_buffer(m_output_image_format,
-                                                         (int)m_width_pixels,
-                                                         (int)m_height_pixels,
-                                                         stride,
-                                                         buffer,
-                                                         buffer_size,
-                                                         uvc_camerareader_free_allocation,
-                                                         context,
-                                                         &image));
+            // Calback to color
+            m_pCallback(result, capture, m_pCallbackContext);
         }
-        else
+
+        if (capture)
         {
-            // cleanup if there was an error
-            allocator_free(buffer);
+            // We guarantee that capture is valid for the duration of the callback function, if someone
+            // needs it to live longer, then they need to add a ref
+            capture_dec_ref(capture);
         }
+    }
+}
 
-        k4a_capture_t capture = NULL;
-        if (K4A_SUCCEEDED(result))
+// Wraps the color buffer in an image and a capture, the buffer is freed if this fails
+k4a_result_t UVCCameraReader::CreateCapture(const FrameMetadata &metadata,
+                                            uint8_t *buffer,
+                                            const size_t buffer_size,
+                                            const int stride,
+                                            image_destroy_cb_t *buffer_free,
+                                            k4a_capture_t *capture)
+{
+    void *context = nullptr;
+    k4a_image_t image = NULL;
+
+    // The buffer size may be larger than the height * stride for some formats
+    // so we must use image_create_from_buffer rather than image_create
+    k4a_result_t result = TRACE_CALL(image_create_from_buffer(m_output_image_format,
+                                                              (int)m_width_pixels,
+                                                              (int)m_height_pixels,
+                                                              stride,
+                                                              buffer,
+                                                              buffer_size,
+                                                              buffer_free,
+                                                              context,
+                                                              &image));
+    if (K4A_FAILED(result))
+    {
+        buffer_free(buffer, context);
+    }
+
+    *capture = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(CreateCaptureFromImage(metadata, image, capture));
+    }
+
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+
+    return result;
+}
+
+// Wraps the MJPEG frame in a BGRA32 image that is decoded on first access, and in a capture. The payload is freed if
+// this fails
+k4a_result_t UVCCameraReader::CreateDeferredCapture(const FrameMetadata &metadata,
+                                                    uint8_t *payload,
+                                                    const size_t payload_size,
+                                                    image_destroy_cb_t *payload_free,
+                                                    k4a_capture_t *capture)
+{
+    k4a_image_t image = NULL;
+    *capture = NULL;
+
+    k4a_result_t result = TRACE_CALL(image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                                           (int)m_width_pixels,
+                                                           (int)m_height_pixels,
+                                                           (int)m_width_pixels * 4,
+                                                           ALLOCATION_SOURCE_COLOR,
+                                                           payload,
+                                                           payload_size,
+                                                           payload_free,
+                                                           nullptr,
+                                                           uvc_camerareader_decode_deferred,
+                                                           nullptr,
+                                                           &image));
+    if (K4A_FAILED(result))
+    {
+        payload_free(payload, nullptr);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(CreateCaptureFromImage(metadata, image, capture));
+    }
+
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+
+    return result;
+}
+
+// Sets the frame metadata on the image and adds it to a new capture
+k4a_result_t UVCCameraReader::CreateCaptureFromImage(const FrameMetadata &metadata,
+                                                     k4a_image_t image,
+                                                     k4a_capture_t *capture)
+{
+    k4a_result_t result = TRACE_CALL(capture_create(capture));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Set metadata
+        image_set_system_timestamp_nsec(image, metadata.systemTimestamp);
+        image_set_device_timestamp_usec(image, K4A_90K_HZ_TICK_TO_USEC(metadata.framePTS));
+        image_set_exposure_usec(image, metadata.exposureTime);
+        image_set_iso_speed(image, metadata.isoSpeed);
+        image_set_white_balance(image, metadata.whiteBalance);
+
+        // Set image
+        capture_set_color_image(*capture, image);
+    }
+
+    return result;
+}
+
+k4a_result_t UVCCameraReader::StartFrameWorkers()
+{
+    uint32_t threadCount = UVC_DEFAULT_DECODE_THREADS;
+
+    // override the number of decode threads if the environment variable is defined
+    const char *env_decode_threads = environment_get_variable("K4A_COLOR_DECODE_THREADS");
+    if (env_decode_threads != NULL && env_decode_threads[0] != '\0')
+    {
+        threadCount = (uint32_t)strtoul(env_decode_threads, NULL, 10);
+        if (threadCount > UVC_MAX_DECODE_THREADS)
         {
-            result = TRACE_CALL(capture_create(&capture));
+            LOG_WARNING("K4A_COLOR_DECODE_THREADS of %d capped to %d", threadCount, UVC_MAX_DECODE_THREADS);
+            threadCount = UVC_MAX_DECODE_THREADS;
         }
+    }
 
-        if (K4A_SUCCEEDED(result))
+    bool decoding = IsDecodingMJPEG();
+    if (threadCount == 0)
+    {
+        // Frames are decoded on the callback thread
+        if (decoding)
+        {
+            StartHardwareDecoder(m_decoder);
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    if (!decoding)
+    {
+        // A single worker keeps the capture creation and the color callback off the libuvc thread
+        threadCount = 1;
+    }
+
+    try
+    {
+        // Decoders and jobs are kept across streaming sessions
+        while (decoding && m_workerDecoders.size() < threadCount)
         {
-            // Set metadata
-            uint64_t ts = (uint64_t)frame->capture_time_finished.tv_sec * 1000000000;
-            ts += (uint64_t)frame->capture_time_finished.tv_nsec;
-            image_set_system_timestamp_nsec(image, ts);
-            image_set_device_timestamp_usec(image, K4A_90K_HZ_TICK_TO_USEC(framePTS));
-            image_set_exposure_usec(image, exposure_time);
-            image_set_iso_speed(image, iso_speed);
-            image_set_white_balance(image, white_balance);
+            MJPEGDecoder decoder;
+            decoder.turbojpeg = tjInitDecompress();
+            if (decoder.turbojpeg == nullptr)
+            {
+                LOG_ERROR("MJPEG decoder initialization failed", 0);
+                return K4A_RESULT_FAILED;
+            }
+            m_workerDecoders.push_back(decoder);
+        }
 
-            // Set image
-            capture_set_color_image(capture, image);
+        while (m_frameJobPool.size() < threadCount * UVC_FRAME_JOBS_PER_THREAD)
+        {
+            m_frameJobPool.emplace_back(new FrameJob());
         }
 
-        if (!drop_image)
+        m_freeFrameJobs.clear();
+        for (std::unique_ptr<FrameJob> &job : m_frameJobPool)
         {
-            // Calback to color
-            m_pCallback(result, capture, m_pCallbackContext);
+            m_freeFrameJobs.push_back(job.get());
         }
+        m_frameJobs.clear();
+        m_frameStopping = false;
+        m_framePublishing = false;
 
-        if (image)
+        for (uint32_t i = 0; i < threadCount; i++)
         {
-            image_dec_ref(image);
+            MJPEGDecoder *decoder = nullptr;
+            if (decoding)
+            {
+                decoder = &m_workerDecoders[i];
+                StartHardwareDecoder(*decoder);
+            }
+            m_frameWorkers.emplace_back(&UVCCameraReader::FrameWorker, this, decoder);
         }
+    }
+    catch (std::exception &e)
+    {
+        LOG_ERROR("Failed to start color frame threads: %s", e.what());
+        StopFrameWorkers();
+        return K4A_RESULT_FAILED;
+    }
 
-        if (capture)
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void UVCCameraReader::StopFrameWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_frameStopping = true;
+    }
+    m_frameCondition.notify_all();
+
+    for (std::thread &worker : m_frameWorkers)
+    {
+        try
         {
-            // We guarantee that capture is valid for the duration of the callback function, if someone
-            // needs it to live longer, then they need to add a ref
-            capture_dec_ref(capture);
+            worker.join();
+        }
+        catch (std::system_error &e)
+        {
+            LOG_ERROR("Failed to stop color frame thread: %s", e.what());
         }
     }
+    m_frameWorkers.clear();
+
+    // Drop the frames that were not published
+    for (FrameJob *job : m_frameJobs)
+    {
+        if (job->capture)
+        {
+            capture_dec_ref(job->capture);
+            job->capture = NULL;
+        }
+        if (job->frameBuffer)
+        {
+            job->frameBufferFree(job->frameBuffer, nullptr);
+            job->frameBuffer = nullptr;
+        }
+    }
+    m_frameJobs.clear();
+
+    // Hardware decoders are created for the frame size of one streaming session
+    for (MJPEGDecoder &decoder : m_workerDecoders)
+    {
+        StopHardwareDecoder(decoder);
+    }
+    StopHardwareDecoder(m_decoder);
 }
 
-k4a_result_t
-UVCCameraReader::DecodeMJPEGtoBGRA32(uint8_t *in_buf, const size_t in_size, uint8_t *out_buf, const size_t out_size)
+void UVCCameraReader::StartHardwareDecoder(MJPEGDecoder &decoder)
+{
+    if (decoder.hardware != nullptr || !cdloader_is_loaded())
+    {
+        return;
+    }
+
+    k4a_decoder_result_code_t result = cdloader_decoder_create(&decoder.hardware, m_width_pixels, m_height_pixels);
+    if (result != K4A_DECODER_RESULT_SUCCEEDED)
+    {
+        LOG_WARNING("Hardware MJPEG decoder is not available for %ux%u (%d), decoding in software",
+                    m_width_pixels,
+                    m_height_pixels,
+                    result);
+        decoder.hardware = nullptr;
+    }
+}
+
+void UVCCameraReader::StopHardwareDecoder(MJPEGDecoder &decoder)
+{
+    if (decoder.hardware != nullptr)
+    {
+        cdloader_decoder_destroy(&decoder.hardware);
+        decoder.hardware = nullptr;
+    }
+}
+
+// Copies the frame out of the libuvc buffer and queues it to the frame workers, called with m_mutex held
+void UVCCameraReader::QueueFrameJob(uvc_frame_t *frame, const FrameMetadata &metadata)
+{
+    std::unique_lock<std::mutex> lock(m_frameMutex);
+    if (m_freeFrameJobs.empty())
+    {
+        LOG_WARNING("Color frame workers are not keeping up, dropping image", 0);
+        return;
+    }
+    FrameJob *job = m_freeFrameJobs.back();
+    m_freeFrameJobs.pop_back();
+    lock.unlock();
+
+    job->metadata = metadata;
+    job->started = false;
+    job->done = false;
+    job->dropImage = false;
+    job->capture = NULL;
+    job->frameSize = frame->data_bytes;
+    job->stride = (int)frame->step;
+
+    if (IsDecodingMJPEG())
+    {
+        // The job buffer only grows, so steady state streaming does not allocate here
+        if (job->mjpegCapacity < job->frameSize)
+        {
+            job->mjpegBuffer.reset(new (std::nothrow) uint8_t[job->frameSize]);
+            job->mjpegCapacity = job->mjpegBuffer ? job->frameSize : 0;
+        }
+
+        job->result = K4A_RESULT_FROM_BOOL(job->mjpegBuffer != nullptr && job->mjpegCapacity >= job->frameSize);
+        if (K4A_SUCCEEDED(job->result))
+        {
+            memcpy(job->mjpegBuffer.get(), frame->data, job->frameSize);
+        }
+    }
+    else
+    {
+        // The workers hand the buffer to the image
+        job->frameBuffer = TakeFrameBuffer(frame, &job->frameBufferFree);
+        job->result = K4A_RESULT_FROM_BOOL(job->frameBuffer != NULL);
+    }
+
+    lock.lock();
+
+    // Frames arrive in framePTS order, so the job almost always goes to the back
+    auto position = m_frameJobs.end();
+    while (position != m_frameJobs.begin() && (*(position - 1))->metadata.framePTS > metadata.framePTS)
+    {
+        --position;
+    }
+    m_frameJobs.insert(position, job);
+    lock.unlock();
+
+    m_frameCondition.notify_one();
+}
+
+void UVCCameraReader::FrameWorker(MJPEGDecoder *decoder)
+{
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_COLOR);
+
+    std::unique_lock<std::mutex> lock(m_frameMutex);
+
+    while (!m_frameStopping)
+    {
+        FrameJob *job = nullptr;
+        for (FrameJob *queued : m_frameJobs)
+        {
+            if (!queued->started)
+            {
+                job = queued;
+                break;
+            }
+        }
+
+        if (job == nullptr)
+        {
+            m_frameCondition.wait(lock);
+            continue;
+        }
+
+        job->started = true;
+        lock.unlock();
+
+        if (K4A_SUCCEEDED(job->result) && decoder == nullptr)
+        {
+            // The image takes ownership of the frame buffer, and frees it on failure
+            uint8_t *buffer = job->frameBuffer;
+            job->frameBuffer = nullptr;
+
+            if (m_lazyDecode)
+            {
+                job->result = TRACE_CALL(
+                    CreateDeferredCapture(job->metadata, buffer, job->frameSize, job->frameBufferFree, &job->capture));
+            }
+            else
+            {
+                job->result = TRACE_CALL(CreateCapture(
+                    job->metadata, buffer, job->frameSize, job->stride, job->frameBufferFree, &job->capture));
+            }
+        }
+        else if (K4A_SUCCEEDED(job->result))
+        {
+            int stride = (int)m_width_pixels * 4;
+            size_t buffer_size = (size_t)stride * m_height_pixels;
+
+            // Allocate K4A Color buffer
+            uint8_t *buffer = allocator_alloc_image(ALLOCATION_SOURCE_COLOR, m_output_image_format, buffer_size);
+            job->result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+
+            if (K4A_SUCCEEDED(job->result))
+            {
+                // Decode MJPG into BRGA32
+                job->result =
+                    DecodeMJPEGtoBGRA32(*decoder, job->mjpegBuffer.get(), job->frameSize, buffer, buffer_size);
+                if (K4A_FAILED(job->result))
+                {
+                    job->dropImage = true;
+                    allocator_free(buffer);
+                }
+            }
+
+            if (K4A_SUCCEEDED(job->result))
+            {
+                job->result = TRACE_CALL(CreateCapture(
+                    job->metadata, buffer, buffer_size, stride, uvc_camerareader_free_allocation, &job->capture));
+            }
+        }
+
+        lock.lock();
+        job->done = true;
+
+        // Completed jobs are published oldest first by one worker at a time, a job finished while another worker is
+        // publishing is picked up by that worker
+        if (!m_framePublishing)
+        {
+            m_framePublishing = true;
+            while (!m_frameStopping && !m_frameJobs.empty() && m_frameJobs.front()->done)
+            {
+                FrameJob *completed = m_frameJobs.front();
+                m_frameJobs.pop_front();
+                lock.unlock();
+
+                if (!completed->dropImage)
+                {
+                    // Calback to color
+                    m_pCallback(completed->result, completed->capture, m_pCallbackContext);
+                }
+
+                if (completed->capture)
+                {
+                    capture_dec_ref(completed->capture);
+                    completed->capture = NULL;
+                }
+
+                lock.lock();
+                m_freeFrameJobs.push_back(completed);
+            }
+            m_framePublishing = false;
+        }
+    }
+}
+
+k4a_result_t UVCCameraReader::DecodeMJPEGtoBGRA32(MJPEGDecoder &decoder,
+                                                  uint8_t *in_buf,
+                                                  const size_t in_size,
+                                                  uint8_t *out_buf,
+                                                  const size_t out_size)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, m_width_pixels * m_height_pixels * 4 > out_size);
 
-    int decompressStatus = tjDecompress2(m_decoder,
+    if (decoder.hardware != nullptr)
+    {
+        k4a_decoder_result_code_t hardwareResult =
+            cdloader_decode_mjpeg(decoder.hardware, in_buf, in_size, out_buf, m_width_pixels * 4, out_size);
+        switch (hardwareResult)
+        {
+        case K4A_DECODER_RESULT_SUCCEEDED:
+            return K4A_RESULT_SUCCEEDED;
+        case K4A_DECODER_RESULT_DATA_ERROR:
+            LOG_WARNING("Hardware MJPEG decode failed, dropping image", 0);
+            return K4A_RESULT_FAILED;
+        case K4A_DECODER_RESULT_UNSUPPORTED:
+            // Decode this frame in software
+            break;
+        default:
+            LOG_ERROR("Hardware MJPEG decoder failed (%d), decoding in software from now on", hardwareResult);
+            StopHardwareDecoder(decoder);
+            break;
+        }
+    }
+
+    int decompressStatus = tjDecompress2(decoder.turbojpeg,
                                          in_buf,
                                          (unsigned long)in_size,
                                          out_buf,
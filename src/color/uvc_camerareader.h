@@ -7,11 +7,17 @@
 #include "color_priv.h"
 
 // STL
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 // external
 #include <libuvc/libuvc.h>
 #include "turbojpeg.h"
+#include <k4ainternal/cdloader.h>
 
 class UVCCameraReader
 {
@@ -25,6 +31,7 @@ public:
                        const uint32_t height,
                        const float fps,
                        const k4a_image_format_t imageFormat,
+                       const k4a_color_scale_t scale,
                        color_cb_stream_t *pCallback,
                        void *pCallbackContext);
 
@@ -51,7 +58,80 @@ private:
         return m_pContext && m_pDevice && m_pDeviceHandle;
     }
 
-    k4a_result_t DecodeMJPEGtoBGRA32(uint8_t *in_buf, const size_t in_size, uint8_t *out_buf, const size_t out_size);
+    // MJPEG frames are decoded to BGRA32 before they are published, unless they are decoded on first access
+    bool IsDecodingMJPEG()
+    {
+        return m_input_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG &&
+               m_output_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32 && !m_lazyDecode;
+    }
+
+    // Per frame metadata parsed from the UVC frame
+    struct FrameMetadata
+    {
+        uint64_t framePTS;
+        uint64_t systemTimestamp;
+        uint64_t exposureTime;
+        uint32_t isoSpeed;
+        uint32_t whiteBalance;
+    };
+
+    // Frame copied out of the libuvc buffer and handed to the frame workers, recycled once its capture is published.
+    // MJPEG frames the workers decode are copied to mjpegBuffer, other frames to frameBuffer which becomes the image
+    // buffer or the payload of a lazily decoded image.
+    struct FrameJob
+    {
+        FrameMetadata metadata;
+        std::unique_ptr<uint8_t[]> mjpegBuffer;
+        size_t mjpegCapacity = 0;
+        uint8_t *frameBuffer = nullptr;
+        image_destroy_cb_t *frameBufferFree = nullptr;
+        size_t frameSize = 0;
+        int stride = 0;
+        bool started = false;
+        bool done = false;
+        bool dropImage = false;
+        k4a_result_t result = K4A_RESULT_FAILED;
+        k4a_capture_t capture = NULL;
+    };
+
+    // MJPEG decoder used by one thread at a time. The hardware decoder is created for the frame size of each streaming
+    // session when the color decoder plugin is loaded, frames it does not support are decoded by turbojpeg.
+    struct MJPEGDecoder
+    {
+        tjhandle turbojpeg = nullptr;
+        k4a_decoder_context_t *hardware = nullptr;
+    };
+
+    void StartHardwareDecoder(MJPEGDecoder &decoder);
+    void StopHardwareDecoder(MJPEGDecoder &decoder);
+
+    k4a_result_t DecodeMJPEGtoBGRA32(MJPEGDecoder &decoder,
+                                     uint8_t *in_buf,
+                                     const size_t in_size,
+                                     uint8_t *out_buf,
+                                     const size_t out_size);
+
+    k4a_result_t CreateCapture(const FrameMetadata &metadata,
+                               uint8_t *buffer,
+                               const size_t buffer_size,
+                               const int stride,
+                               image_destroy_cb_t *buffer_free,
+                               k4a_capture_t *capture);
+
+    k4a_result_t CreateDeferredCapture(const FrameMetadata &metadata,
+                                       uint8_t *payload,
+                                       const size_t payload_size,
+                                       image_destroy_cb_t *payload_free,
+                                       k4a_capture_t *capture);
+
+    uint8_t *TakeFrameBuffer(uvc_frame_t *frame, image_destroy_cb_t **buffer_free);
+
+    k4a_result_t CreateCaptureFromImage(const FrameMetadata &metadata, k4a_image_t image, k4a_capture_t *capture);
+
+    k4a_result_t StartFrameWorkers();
+    void StopFrameWorkers();
+    void QueueFrameJob(uvc_frame_t *frame, const FrameMetadata &metadata);
+    void FrameWorker(MJPEGDecoder *decoder);
 
     int32_t MapK4aExposureToLinux(int32_t K4aExposure);
     int32_t MapLinuxExposureToK4a(int32_t LinuxExposure);
@@ -78,7 +158,26 @@ private:
     void *m_pCallbackContext = nullptr;
 
     // MJPEG decoder
-    tjhandle m_decoder = nullptr;
+    MJPEGDecoder m_decoder;
+
+    // BGRA32 images keep the MJPEG frame and decode it on first access to their buffer, set by K4A_COLOR_LAZY_DECODE
+    bool m_lazyDecode = false;
+
+    // Frames that are not decoded take over the libuvc frame buffer instead of copying it, set by K4A_COLOR_ZERO_COPY
+    bool m_zeroCopy = false;
+
+    // Frame workers, which build and publish the captures so the libuvc callback only copies frames. When they decode
+    // MJPEG each worker owns one of the decoders. Jobs are kept in framePTS order and published in that order by
+    // whichever worker completes the oldest one.
+    std::vector<MJPEGDecoder> m_workerDecoders;
+    std::vector<std::thread> m_frameWorkers;
+    std::vector<std::unique_ptr<FrameJob>> m_frameJobPool;
+    std::vector<FrameJob *> m_freeFrameJobs;
+    std::deque<FrameJob *> m_frameJobs;
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameCondition;
+    bool m_frameStopping = false;
+    bool m_framePublishing = false;
 };
 
 #endif // UVC_CAMERAREADER_H
\ No newline at end of file
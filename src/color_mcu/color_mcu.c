@@ -182,6 +182,28 @@ k4a_result_t colormcu_imu_register_stream_cb(colormcu_t colormcu_handle,
     return TRACE_CALL(usb_cmd_stream_register_cb(colormcu->usb_cmd, frame_ready_cb, context));
 }
 
+/**
+ *  Function to read the telemetry of the IMU streaming endpoint
+ *
+ *  @param colormcu_handle
+ *   Handle to this object
+ *
+ *  @param stats
+ *   Location to write the statistics
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED    Operation successful
+ *   K4A_RESULT_FAILED       Operation failed
+ *
+ */
+k4a_result_t colormcu_imu_get_usb_stream_stats(colormcu_t colormcu_handle, k4a_usb_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, colormcu_t, colormcu_handle)
+    colormcu_context_t *colormcu = colormcu_t_get_context(colormcu_handle);
+
+    return TRACE_CALL(usb_cmd_get_stream_stats(colormcu->usb_cmd, stats));
+}
+
 /**
  *  Function to read the state of the synchronization jacks on the back of the device
  *
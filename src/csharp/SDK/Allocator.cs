@@ -61,12 +61,12 @@ namespace Microsoft.Azure.Kinect.Sensor
 
             // When managed code needs to provide access to memory that didn't originate from the managed allocator
             // the SafeCopyNativeBuffers options causes the managed code to make a safe cache copy of the native buffer
-            // in a managed byte[] array. This has a more significant performance impact, but generally is only needed for
-            // media foundation (color image) or potentially custom buffers. When set to true, the Memory<T> objects are safe
-            // copies of the native buffers. When set to false, the Memory<T> objects are direct pointers to the native buffers
-            // and can therefore cause native memory corruption if a Memory<T> (or Span<T>) is used after the Image is disposed
-            // or garbage collected.
-            this.SafeCopyNativeBuffers = true;
+            // in a managed byte[] array. This has a significant performance impact, since the whole buffer is copied
+            // each time it transitions between native and managed code. When set to false, the Memory<T> objects wrap the
+            // native buffers directly through an AzureKinectMemoryManager, which holds its own reference on the native image
+            // and keeps it alive while the memory is pinned. Accessing that Memory<T> after the Image is disposed throws an
+            // ObjectDisposedException, so the copy is only needed by callers that want a snapshot of the buffer.
+            this.SafeCopyNativeBuffers = false;
         }
 
         /// <summary>
@@ -112,9 +112,9 @@ namespace Microsoft.Azure.Kinect.Sensor
         }
 
         /// <summary>
-        /// Gets or sets a value indicating whether to make a safe copy of native buffers.
+        /// Gets or sets a value indicating whether to make a managed copy of native buffers.
         /// </summary>
-        public bool SafeCopyNativeBuffers { get; set; } = true;
+        public bool SafeCopyNativeBuffers { get; set; } = false;
 
         /// <summary>
         /// Register the object for disposal when the CLR shuts down.
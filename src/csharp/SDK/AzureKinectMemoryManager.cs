@@ -7,17 +7,24 @@
 using System;
 using System.Buffers;
 using System.Runtime.CompilerServices;
-using System.Threading;
 
 namespace Microsoft.Azure.Kinect.Sensor
 {
     /// <summary>
     /// Manages the native memory allocated by the Azure Kinect SDK.
     /// </summary>
+    /// <remarks>
+    /// The manager holds its own reference on the native image. Every outstanding pin holds an
+    /// additional count, so the native buffer is only released once the manager has been disposed
+    /// and the last <see cref="MemoryHandle"/> has been released. Once disposed, new calls to
+    /// <see cref="GetSpan"/> or <see cref="Pin(int)"/> throw an <see cref="ObjectDisposedException"/>
+    /// rather than exposing memory that may have been freed.
+    /// </remarks>
     internal class AzureKinectMemoryManager : MemoryManager<byte>
     {
         private Image image;
         private int pinCount = 0;
+        private bool disposed = false;
 
         /// <summary>
         /// Initializes a new instance of the <see cref="AzureKinectMemoryManager"/> class.
@@ -36,7 +43,7 @@ namespace Microsoft.Azure.Kinect.Sensor
         {
             lock (this)
             {
-                if (this.image == null)
+                if (this.disposed)
                 {
                     throw new ObjectDisposedException(nameof(AzureKinectMemoryManager));
                 }
@@ -50,12 +57,17 @@ namespace Microsoft.Azure.Kinect.Sensor
         {
             lock (this)
             {
-                if (this.image == null)
+                if (this.disposed)
                 {
                     throw new ObjectDisposedException(nameof(AzureKinectMemoryManager));
                 }
 
-                _ = Interlocked.Increment(ref this.pinCount);
+                if (elementIndex < 0 || elementIndex > this.image.Size)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(elementIndex));
+                }
+
+                this.pinCount++;
                 return new MemoryHandle(Unsafe.Add<byte>(this.image.GetUnsafeBuffer(), elementIndex), pinnable: this);
             }
         }
@@ -63,7 +75,16 @@ namespace Microsoft.Azure.Kinect.Sensor
         /// <inheritdoc/>
         public override void Unpin()
         {
-            _ = Interlocked.Decrement(ref this.pinCount);
+            lock (this)
+            {
+                this.pinCount--;
+
+                // The last pin released after disposal drops the native reference.
+                if (this.disposed && this.pinCount == 0)
+                {
+                    this.ReleaseImage();
+                }
+            }
         }
 
         /// <inheritdoc/>
@@ -73,18 +94,25 @@ namespace Microsoft.Azure.Kinect.Sensor
             {
                 lock (this)
                 {
-                    if (this.image != null)
-                    {
-                        this.image.Dispose();
-                        this.image = null;
-                    }
+                    this.disposed = true;
 
-                    if (this.pinCount != 0)
+                    // Pinned memory may still be in use by native code or by a consumer holding a
+                    // MemoryHandle, so keep the image alive until the last Unpin.
+                    if (this.pinCount == 0)
                     {
-                        throw new AzureKinectException("Buffer disposed while pinned");
+                        this.ReleaseImage();
                     }
                 }
             }
         }
+
+        private void ReleaseImage()
+        {
+            if (this.image != null)
+            {
+                this.image.Dispose();
+                this.image = null;
+            }
+        }
     }
 }
@@ -312,19 +312,15 @@ namespace Microsoft.Azure.Kinect.Sensor
                         // Get the native pointer
                         IntPtr imageHandleValue = nativeImageHandle.DangerousGetHandle();
 
-                        // Get the handle value from the cached image. If it has been disposed, this
-                        // will throw an exception, which will be passed to the caller.
-
-                        // Take an extra reference on the cachedImage to ensure it doesn't get disposed
-                        // after getting the IntPtr from the handle.
-                        using (Image reference = cachedImage.Reference())
+                        // Compare against the handle of the cached image. If it has been disposed, this
+                        // will throw an exception, which will be passed to the caller. The comparison is
+                        // made under the Image's lock, so no temporary reference wrapper is needed and
+                        // repeated reads of an unchanged image do not allocate.
+                        if (!cachedImage.WrapsNativeHandle(imageHandleValue))
                         {
-                            if (reference.DangerousGetHandle().DangerousGetHandle() != imageHandleValue)
-                            {
-                                // The image has changed, invalidate the current image and construct new wrappers
-                                cachedImage.Dispose();
-                                cachedImage = null;
-                            }
+                            // The image has changed, invalidate the current image and construct new wrappers
+                            cachedImage.Dispose();
+                            cachedImage = null;
                         }
                     }
 
@@ -384,9 +380,8 @@ namespace Microsoft.Azure.Kinect.Sensor
 
                 cachedImage = value;
 
-                // Take an extra reference on the image to ensure it isn't disposed
-                // prior while we have the handle.
-                using (Image reference = cachedImage.Reference())
+                // Hold the image's lock to ensure it isn't disposed while we have the handle.
+                lock (cachedImage)
                 {
                     nativeMethod(this.handle, cachedImage.DangerousGetHandle());
                 }
@@ -19,9 +19,19 @@ namespace Microsoft.Azure.Kinect.Sensor
         private string serialNum = null;
         private HardwareVersion version = null;
 
+        // Serializes registration of the native capture callback. This is separate from the
+        // Device lock so that capture handlers may call other Device methods.
+        private readonly object captureCallbackLock = new object();
+
+        // The delegate passed to the native layer must be kept alive while it is registered.
+        private readonly NativeMethods.k4a_capture_cb_t captureCallback;
+
         // The native handle to the device.
         private NativeMethods.k4a_device_t handle;
 
+        // Native sample buffer reused by GetImuSamples to avoid an allocation per call.
+        private NativeMethods.k4a_imu_sample_data_t[] imuSampleBuffer = null;
+
         // To detect redundant calls to Dispose
         private bool disposedValue = false;
 
@@ -32,6 +42,71 @@ namespace Microsoft.Azure.Kinect.Sensor
             Allocator.Singleton.RegisterForDisposal(this);
 
             this.handle = handle;
+            this.captureCallback = this.OnCapture;
+        }
+
+        private event Action<Capture> CaptureReadyHandlers;
+
+        /// <summary>
+        /// Occurs when the device produces a capture.
+        /// </summary>
+        /// <remarks>
+        /// Captures are pushed from the SDK thread that produces them, so no thread is needed to poll
+        /// <see cref="GetCapture(TimeSpan)"/>. While any handler is attached, captures are not buffered for
+        /// <see cref="GetCapture(TimeSpan)"/>.
+        ///
+        /// The Capture passed to the handlers is disposed once they return. To keep it longer, call
+        /// <see cref="Capture.Reference"/>.
+        ///
+        /// Handlers delay the delivery of the next capture until they return and should return quickly. They
+        /// must not throw, attach or detach handlers on this event, stop the cameras or dispose the Device.
+        /// </remarks>
+        public event Action<Capture> CaptureReady
+        {
+            add
+            {
+                lock (this.captureCallbackLock)
+                {
+                    if (this.disposedValue)
+                    {
+                        throw new ObjectDisposedException(nameof(Device));
+                    }
+
+                    bool firstHandler = this.CaptureReadyHandlers == null;
+                    this.CaptureReadyHandlers += value;
+
+                    if (firstHandler)
+                    {
+                        try
+                        {
+                            AzureKinectException.ThrowIfNotSuccess(() => NativeMethods.k4a_device_set_capture_callback(this.handle, this.captureCallback, IntPtr.Zero));
+                        }
+                        catch (Exception)
+                        {
+                            this.CaptureReadyHandlers -= value;
+                            throw;
+                        }
+                    }
+                }
+            }
+
+            remove
+            {
+                lock (this.captureCallbackLock)
+                {
+                    if (this.disposedValue || this.CaptureReadyHandlers == null)
+                    {
+                        return;
+                    }
+
+                    this.CaptureReadyHandlers -= value;
+
+                    if (this.CaptureReadyHandlers == null)
+                    {
+                        AzureKinectException.ThrowIfNotSuccess(() => NativeMethods.k4a_device_set_capture_callback(this.handle, null, IntPtr.Zero));
+                    }
+                }
+            }
         }
 
         /// <summary>
@@ -358,6 +433,81 @@ namespace Microsoft.Azure.Kinect.Sensor
             return this.GetImuSample(TimeSpan.FromMilliseconds(-1));
         }
 
+        /// <summary>
+        /// Reads the buffered IMU samples from the device.
+        /// </summary>
+        /// <param name="samples">Buffer to write the samples to. Existing ImuSample objects in the buffer are overwritten in place.</param>
+        /// <param name="timeout">Time to wait for an IMU sample when none is buffered.</param>
+        /// <returns>The number of samples written to the start of <paramref name="samples"/>.</returns>
+        /// <remarks>Gets the next samples in the streamed sequence of IMU samples from the device, oldest first, with a
+        /// single call to the native API. If no sample is currently available, this function will block until the timeout is
+        /// reached. Samples are read from the same stream as <see cref="GetImuSample(TimeSpan)"/>.
+        /// Reusing the same buffer across calls avoids allocating an ImuSample per sample at the IMU sample rate.
+        /// </remarks>
+        public int GetImuSamples(Span<ImuSample> samples, TimeSpan timeout)
+        {
+            if (samples.IsEmpty)
+            {
+                throw new ArgumentException("The sample buffer must hold at least one sample.", nameof(samples));
+            }
+
+            lock (this)
+            {
+                if (this.disposedValue)
+                {
+                    throw new ObjectDisposedException(nameof(Device));
+                }
+
+                if (this.imuSampleBuffer == null || this.imuSampleBuffer.Length < samples.Length)
+                {
+                    this.imuSampleBuffer = new NativeMethods.k4a_imu_sample_data_t[samples.Length];
+                }
+
+                using (LoggingTracer tracer = new LoggingTracer())
+                {
+                    NativeMethods.k4a_wait_result_t result = NativeMethods.k4a_device_get_imu_samples(
+                        this.handle,
+                        this.imuSampleBuffer,
+                        new UIntPtr((uint)samples.Length),
+                        out UIntPtr sampleCount,
+                        (int)timeout.TotalMilliseconds);
+
+                    if (result == NativeMethods.k4a_wait_result_t.K4A_WAIT_RESULT_TIMEOUT)
+                    {
+                        throw new TimeoutException("Timed out waiting for IMU sample");
+                    }
+
+                    AzureKinectException.ThrowIfNotSuccess(tracer, result);
+
+                    int count = Math.Min(checked((int)sampleCount.ToUInt32()), samples.Length);
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (samples[i] == null)
+                        {
+                            samples[i] = new ImuSample();
+                        }
+
+                        this.imuSampleBuffer[i].CopyTo(samples[i]);
+                    }
+
+                    return count;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Reads the buffered IMU samples from the device.
+        /// </summary>
+        /// <param name="samples">Buffer to write the samples to. Existing ImuSample objects in the buffer are overwritten in place.</param>
+        /// <returns>The number of samples written to the start of <paramref name="samples"/>.</returns>
+        /// <remarks>Gets the next samples in the streamed sequence of IMU samples from the device, oldest first.
+        /// If no sample is currently available, this function will block until one is available.
+        /// </remarks>
+        public int GetImuSamples(Span<ImuSample> samples)
+        {
+            return this.GetImuSamples(samples, TimeSpan.FromMilliseconds(-1));
+        }
+
         /// <summary>
         /// Get the Azure Kinect color sensor control value.
         /// </summary>
@@ -515,6 +665,15 @@ namespace Microsoft.Azure.Kinect.Sensor
                 {
                     Allocator.Singleton.UnregisterForDisposal(this);
 
+                    lock (this.captureCallbackLock)
+                    {
+                        if (this.CaptureReadyHandlers != null)
+                        {
+                            _ = NativeMethods.k4a_device_set_capture_callback(this.handle, null, IntPtr.Zero);
+                            this.CaptureReadyHandlers = null;
+                        }
+                    }
+
                     this.handle.Close();
                     this.handle = null;
 
@@ -522,5 +681,21 @@ namespace Microsoft.Azure.Kinect.Sensor
                 }
             }
         }
+
+        private void OnCapture(NativeMethods.k4a_result_t result, IntPtr captureHandle, IntPtr context)
+        {
+            Action<Capture> eventhandler = this.CaptureReadyHandlers;
+            if (eventhandler == null || result != NativeMethods.k4a_result_t.K4A_RESULT_SUCCEEDED || captureHandle == IntPtr.Zero)
+            {
+                return;
+            }
+
+            // The native capture is only valid for the duration of the callback, so take
+            // a reference that the Capture owns.
+            using (Capture capture = new Capture(NativeMethods.k4a_capture_t.FromBorrowedHandle(captureHandle)))
+            {
+                eventhandler(capture);
+            }
+        }
     }
 }
@@ -145,12 +145,12 @@ namespace Microsoft.Azure.Kinect.Sensor
                     // We can use one of two strategies to return a Memory<T>
 
                     // If we use the CopyNativeBuffers method, we will allocate and then copy the native memory
-                    // to a managed array, ensuring memory-safe access to the contents of memory, at the expense of
-                    // a memcpy each time we transition the buffer from native to managed, or from managed to native.
+                    // to a managed array, at the expense of a memcpy each time we transition the buffer from native
+                    // to managed, or from managed to native.
 
-                    // If we don't copy the native buffers, we can construct a MemoryManager<T> that wraps that native
-                    // buffer. This has no memcpy cost, but exposes the possibility of use after free bugs to consumers
-                    // of the library. This is therefore not enabled by default.
+                    // If we don't copy the native buffers, we construct a MemoryManager<T> that wraps that native
+                    // buffer. This has no memcpy cost. The manager holds its own reference on the native image and
+                    // refuses access once this Image has been disposed, so this is the default.
                     if (Allocator.Singleton.SafeCopyNativeBuffers)
                     {
                         // Create a copy
@@ -161,10 +161,8 @@ namespace Microsoft.Azure.Kinect.Sensor
                     }
                     else
                     {
-                        // Provide a Memory<T> object that wraps a native pointer
-                        // This is UNSAFE. Callers in safe code may access unowned native
-                        // memory if they use the Memory<T> or Span<T> after the Image has
-                        // been disposed.
+                        // Provide a Memory<T> object that wraps the native pointer. Pinned handles
+                        // keep the native buffer alive even if this Image is disposed first.
                         this.nativeBufferWrapper = new AzureKinectMemoryManager(this);
 
                         return this.nativeBufferWrapper.Memory;
@@ -701,6 +699,26 @@ namespace Microsoft.Azure.Kinect.Sensor
             }
         }
 
+        /// <summary>
+        /// Checks whether this Image wraps the given native image handle.
+        /// </summary>
+        /// <param name="handleValue">Native handle value to compare against.</param>
+        /// <returns>true if this Image wraps the native k4a_image_t.</returns>
+        /// <remarks>Unlike comparing through a <see cref="Reference"/>, this does not construct
+        /// a temporary Image wrapper.</remarks>
+        internal bool WrapsNativeHandle(IntPtr handleValue)
+        {
+            lock (this)
+            {
+                if (this.disposedValue)
+                {
+                    throw new ObjectDisposedException(nameof(Image));
+                }
+
+                return this.handle.DangerousGetHandle() == handleValue;
+            }
+        }
+
         /// <summary>
         /// Checks two Images to determine if they represent the same native image object.
         /// </summary>
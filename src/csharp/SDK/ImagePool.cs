@@ -0,0 +1,196 @@
+﻿//------------------------------------------------------------------------------
+// <copyright file="ImagePool.cs" company="Microsoft">
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+// </copyright>
+//------------------------------------------------------------------------------
+using System;
+using System.Collections.Generic;
+
+namespace Microsoft.Azure.Kinect.Sensor
+{
+    /// <summary>
+    /// A pool of Images of one format and size, reused as the outputs of operations that run every frame.
+    /// </summary>
+    /// <remarks>
+    /// <see cref="Rent"/> returns an idle Image of the pool, or creates one if none is idle. <see cref="Return(Image)"/>
+    /// keeps the Image for the next <see cref="Rent"/> instead of disposing it, so a transformation run every frame
+    /// does not create a new Image and allocate its buffer for each call.
+    ///
+    /// When the native allocator is hooked, see Allocator.UseManagedAllocator, the buffers of the Images come from the
+    /// same large array pool as the other Images of the SDK, and go back to it when the Images are disposed.
+    ///
+    /// Only return an Image once nothing uses its content any more. Images created from it with
+    /// <see cref="Image.Reference"/> share its buffer, which the next user of the Image overwrites.
+    /// </remarks>
+    public class ImagePool : IDisposable
+    {
+        // Images that can be rented.
+        private readonly Stack<Image> idle = new Stack<Image>();
+
+        // Images that were rented and not returned.
+        private readonly HashSet<Image> rented = new HashSet<Image>();
+
+        // To detect redundant calls to Dispose
+        private bool disposedValue = false;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="ImagePool"/> class.
+        /// </summary>
+        /// <param name="format">The pixel format of the images.</param>
+        /// <param name="widthPixels">Width of the images in pixels.</param>
+        /// <param name="heightPixels">Height of the images in pixels.</param>
+        /// <param name="strideBytes">Stride of the images in bytes, or zero for the default of the format.</param>
+        /// <param name="capacity">The most idle images the pool keeps. Images returned to a full pool are disposed.</param>
+        public ImagePool(ImageFormat format, int widthPixels, int heightPixels, int strideBytes, int capacity)
+        {
+            if (widthPixels <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(widthPixels));
+            }
+
+            if (heightPixels <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(heightPixels));
+            }
+
+            if (strideBytes < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(strideBytes));
+            }
+
+            if (capacity <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(capacity));
+            }
+
+            this.Format = format;
+            this.WidthPixels = widthPixels;
+            this.HeightPixels = heightPixels;
+            this.StrideBytes = strideBytes;
+            this.Capacity = capacity;
+        }
+
+        /// <summary>
+        /// Gets the pixel format of the images.
+        /// </summary>
+        public ImageFormat Format { get; }
+
+        /// <summary>
+        /// Gets the width of the images in pixels.
+        /// </summary>
+        public int WidthPixels { get; }
+
+        /// <summary>
+        /// Gets the height of the images in pixels.
+        /// </summary>
+        public int HeightPixels { get; }
+
+        /// <summary>
+        /// Gets the stride of the images in bytes, zero for the default of the format.
+        /// </summary>
+        public int StrideBytes { get; }
+
+        /// <summary>
+        /// Gets the most idle images the pool keeps.
+        /// </summary>
+        public int Capacity { get; }
+
+        /// <summary>
+        /// Rents an image from the pool.
+        /// </summary>
+        /// <returns>An idle image of the pool, or a new image. The content of the image is undefined.</returns>
+        /// <remarks>
+        /// Give the image back with <see cref="Return(Image)"/> once it is no longer used, or dispose it to remove it
+        /// from the pool.
+        /// </remarks>
+        public Image Rent()
+        {
+            lock (this)
+            {
+                if (this.disposedValue)
+                {
+                    throw new ObjectDisposedException(nameof(ImagePool));
+                }
+
+                Image image = this.idle.Count > 0 ?
+                    this.idle.Pop() :
+                    new Image(this.Format, this.WidthPixels, this.HeightPixels, this.StrideBytes);
+
+                _ = this.rented.Add(image);
+                return image;
+            }
+        }
+
+        /// <summary>
+        /// Returns an image rented from the pool.
+        /// </summary>
+        /// <param name="image">An image returned by <see cref="Rent"/> of this pool, that was not disposed.</param>
+        /// <remarks>
+        /// The image is disposed instead of being kept if the pool is full or was disposed.
+        /// </remarks>
+        public void Return(Image image)
+        {
+            if (image == null)
+            {
+                throw new ArgumentNullException(nameof(image));
+            }
+
+            lock (this)
+            {
+                if (!this.rented.Contains(image))
+                {
+                    throw new ArgumentException("The image was not rented from this pool.", nameof(image));
+                }
+
+                // Throws if the image was disposed, it can't be rented again.
+                _ = image.DangerousGetHandle();
+
+                _ = this.rented.Remove(image);
+                if (this.disposedValue || this.idle.Count >= this.Capacity)
+                {
+                    image.Dispose();
+                }
+                else
+                {
+                    this.idle.Push(image);
+                }
+            }
+        }
+
+        /// <inheritdoc/>
+        public void Dispose()
+        {
+            // Do not change this code. Put cleanup code in Dispose(bool disposing) below.
+            this.Dispose(true);
+
+            GC.SuppressFinalize(this);
+        }
+
+        /// <summary>
+        /// Disposes the idle images of the pool.
+        /// </summary>
+        /// <param name="disposing">True if called from Dispose.</param>
+        /// <remarks>
+        /// Rented images stay valid. They are disposed when they are returned.
+        /// </remarks>
+        protected virtual void Dispose(bool disposing)
+        {
+            lock (this)
+            {
+                if (!this.disposedValue)
+                {
+                    if (disposing)
+                    {
+                        while (this.idle.Count > 0)
+                        {
+                            this.idle.Pop().Dispose();
+                        }
+                    }
+
+                    this.disposedValue = true;
+                }
+            }
+        }
+    }
+}
@@ -25,6 +25,12 @@ namespace Microsoft.Azure.Kinect.Sensor
         [UnmanagedFunctionPointer(k4aCallingConvention)]
         public delegate void k4a_memory_destroy_cb_t(IntPtr buffer, IntPtr context);
 
+        [UnmanagedFunctionPointer(k4aCallingConvention)]
+        public delegate void k4a_capture_cb_t(k4a_result_t result, IntPtr capture_handle, IntPtr context);
+
+        [UnmanagedFunctionPointer(k4aCallingConvention)]
+        public delegate void k4a_transformation_completion_cb_t(k4a_result_t result, IntPtr context);
+
         [UnmanagedFunctionPointer(k4aCallingConvention)]
         public delegate void k4a_logging_message_cb_t(IntPtr context, LogLevel level, [MarshalAs(UnmanagedType.LPStr)] string file, int line, [MarshalAs(UnmanagedType.LPStr)] string message);
 
@@ -51,6 +57,22 @@ namespace Microsoft.Azure.Kinect.Sensor
             K4A_RESULT_FAILED,
         }
 
+        [NativeReference]
+        public enum k4a_transformation_job_type_t
+        {
+            K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR = 0,
+            K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR,
+            K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH,
+            K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD,
+        }
+
+        [NativeReference]
+        public enum k4a_transformation_point_cloud_format_t
+        {
+            K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS = 0,
+            K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+        }
+
         [NativeReference]
         public enum k4a_stream_result_t
         {
@@ -166,6 +188,21 @@ namespace Microsoft.Azure.Kinect.Sensor
                 CalibrationDeviceType camera,
                 k4a_image_t xyz_image);
 
+        [DllImport("k4a", CallingConvention = k4aCallingConvention)]
+        [NativeReference]
+        public static extern k4a_result_t k4a_transformation_submit(
+            k4a_transformation_t transformation_handle,
+            [In] k4a_transformation_job_t[] jobs,
+            UIntPtr job_count,
+            k4a_transformation_completion_cb_t callback,
+            IntPtr callback_context);
+
+        [DllImport("k4a", CallingConvention = k4aCallingConvention)]
+        [NativeReference]
+        public static extern k4a_wait_result_t k4a_transformation_wait_idle(
+            k4a_transformation_t transformation_handle,
+            int timeout_in_ms);
+
         [DllImport("k4a", CallingConvention = k4aCallingConvention)]
         [NativeReference]
         public static extern void k4a_device_close(IntPtr device_handle);
@@ -270,6 +307,22 @@ namespace Microsoft.Azure.Kinect.Sensor
             [Out] k4a_imu_sample_t imu_sample,
             int timeout_in_ms);
 
+        [DllImport("k4a", CallingConvention = k4aCallingConvention)]
+        [NativeReference]
+        public static extern k4a_wait_result_t k4a_device_get_imu_samples(
+            k4a_device_t device_handle,
+            [Out] k4a_imu_sample_data_t[] imu_samples,
+            UIntPtr max_sample_count,
+            out UIntPtr sample_count,
+            int timeout_in_ms);
+
+        [DllImport("k4a", CallingConvention = k4aCallingConvention)]
+        [NativeReference]
+        public static extern k4a_result_t k4a_device_set_capture_callback(
+            k4a_device_t device_handle,
+            k4a_capture_cb_t capture_cb,
+            IntPtr capture_cb_context);
+
         [DllImport("k4a", CallingConvention = k4aCallingConvention)]
         [NativeReference]
         public static extern k4a_result_t k4a_device_get_sync_jack(
@@ -444,6 +497,21 @@ namespace Microsoft.Azure.Kinect.Sensor
             public bool disable_streaming_indicator;
         }
 
+        [NativeReference]
+        [StructLayout(LayoutKind.Sequential)]
+        public struct k4a_transformation_job_t
+        {
+            public k4a_transformation_job_type_t type;
+            public IntPtr depth_image;
+            public IntPtr source_image;
+            public IntPtr transformed_image;
+            public IntPtr transformed_source_image;
+            public TransformationInterpolationType interpolation_type;
+            public uint invalid_custom_value;
+            public CalibrationDeviceType camera;
+            public k4a_transformation_point_cloud_format_t point_cloud_format;
+        }
+
         public class k4a_device_t : Win32.SafeHandles.SafeHandleZeroOrMinusOneIsInvalid
         {
             private k4a_device_t()
@@ -465,6 +533,16 @@ namespace Microsoft.Azure.Kinect.Sensor
             {
             }
 
+            public static k4a_capture_t FromBorrowedHandle(IntPtr handle)
+            {
+                k4a_capture_t capture = new k4a_capture_t();
+
+                k4a_capture_reference(handle);
+
+                capture.handle = handle;
+                return capture;
+            }
+
             public k4a_capture_t DuplicateReference()
             {
                 k4a_capture_t duplicate = new k4a_capture_t();
@@ -548,6 +626,26 @@ namespace Microsoft.Azure.Kinect.Sensor
                 };
             }
         }
+
+        [StructLayout(LayoutKind.Sequential)]
+        [Native.NativeReference("k4a_imu_sample_t")]
+        public struct k4a_imu_sample_data_t
+        {
+            public float temperature;
+            public Vector3 acc_sample;
+            public ulong acc_timestamp_usec;
+            public Vector3 gyro_sample;
+            public ulong gyro_timestamp_usec;
+
+            public void CopyTo(ImuSample sample)
+            {
+                sample.Temperature = this.temperature;
+                sample.AccelerometerSample = this.acc_sample;
+                sample.AccelerometerTimestamp = TimeSpan.FromTicks(checked((long)this.acc_timestamp_usec) * 10);
+                sample.GyroSample = this.gyro_sample;
+                sample.GyroTimestamp = TimeSpan.FromTicks(checked((long)this.gyro_timestamp_usec) * 10);
+            }
+        }
     }
 #pragma warning restore SA1602 // Enumeration items should be documented
 #pragma warning restore SA1600 // Elements should be documented
@@ -5,6 +5,8 @@
 // </copyright>
 //------------------------------------------------------------------------------
 using System;
+using System.Runtime.InteropServices;
+using System.Threading.Tasks;
 
 namespace Microsoft.Azure.Kinect.Sensor
 {
@@ -13,6 +15,9 @@ namespace Microsoft.Azure.Kinect.Sensor
     /// </summary>
     public class Transformation : IDisposable
     {
+        // Kept in a static field so the delegate passed to k4a_transformation_submit is never collected.
+        private static readonly NativeMethods.k4a_transformation_completion_cb_t SubmissionCompleted = OnSubmissionCompleted;
+
         private readonly NativeMethods.k4a_transformation_t handle;
         private readonly Calibration calibration;
         private bool disposedValue = false; // To detect redundant calls
@@ -493,6 +498,343 @@ namespace Microsoft.Azure.Kinect.Sensor
             }
         }
 
+        /// <summary>
+        /// Creates a pool of Images to hold the output of <see cref="DepthImageToColorCamera(Image, ImagePool)"/>.
+        /// </summary>
+        /// <param name="capacity">The most idle images the pool keeps.</param>
+        /// <returns>A pool of depth images of the resolution of the color camera.</returns>
+        public ImagePool CreateDepthImageToColorCameraPool(int capacity)
+        {
+            return new ImagePool(
+                ImageFormat.Depth16,
+                this.calibration.ColorCameraCalibration.ResolutionWidth,
+                this.calibration.ColorCameraCalibration.ResolutionHeight,
+                0,
+                capacity);
+        }
+
+        /// <summary>
+        /// Creates a pool of Images to hold the output of <see cref="ColorImageToDepthCamera(Image, Image, ImagePool)"/>.
+        /// </summary>
+        /// <param name="capacity">The most idle images the pool keeps.</param>
+        /// <returns>A pool of BGRA32 images of the resolution of the depth camera.</returns>
+        public ImagePool CreateColorImageToDepthCameraPool(int capacity)
+        {
+            return new ImagePool(
+                ImageFormat.ColorBGRA32,
+                this.calibration.DepthCameraCalibration.ResolutionWidth,
+                this.calibration.DepthCameraCalibration.ResolutionHeight,
+                0,
+                capacity);
+        }
+
+        /// <summary>
+        /// Creates a pool of Images to hold the output of <see cref="DepthImageToPointCloud(Image, ImagePool, CalibrationDeviceType)"/>.
+        /// </summary>
+        /// <param name="camera">The perspective of the depth maps the point clouds are generated from.</param>
+        /// <param name="capacity">The most idle images the pool keeps.</param>
+        /// <returns>A pool of point cloud images of the resolution of <paramref name="camera"/>.</returns>
+        public ImagePool CreatePointCloudPool(CalibrationDeviceType camera, int capacity)
+        {
+            CameraCalibration cameraCalibration;
+            switch (camera)
+            {
+                case CalibrationDeviceType.Depth:
+                    cameraCalibration = this.calibration.DepthCameraCalibration;
+                    break;
+                case CalibrationDeviceType.Color:
+                    cameraCalibration = this.calibration.ColorCameraCalibration;
+                    break;
+                default:
+                    throw new ArgumentOutOfRangeException(nameof(camera));
+            }
+
+            return new ImagePool(
+                ImageFormat.Custom,
+                cameraCalibration.ResolutionWidth,
+                cameraCalibration.ResolutionHeight,
+                sizeof(short) * 3 * cameraCalibration.ResolutionWidth,
+                capacity);
+        }
+
+        /// <summary>
+        /// Transforms an Image from the depth camera perspective to the color camera perspective, into an Image rented
+        /// from a pool.
+        /// </summary>
+        /// <param name="depth">The depth image to transform.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreateDepthImageToColorCameraPool(int)"/>.</param>
+        /// <returns>A depth image transformed in to the color camera perspective. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Image DepthImageToColorCamera(Image depth, ImagePool pool)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            return RentAndRun(pool, depth, (transformed) => this.DepthImageToColorCamera(depth, transformed));
+        }
+
+        /// <summary>
+        /// Transforms an Image from the color camera perspective to the depth camera perspective, into an Image rented
+        /// from a pool.
+        /// </summary>
+        /// <param name="depth">Depth map of the space the color image is being transformed in to.</param>
+        /// <param name="color">Color image to transform in to the depth space.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreateColorImageToDepthCameraPool(int)"/>.</param>
+        /// <returns>A color image in the perspective of the depth camera. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Image ColorImageToDepthCamera(Image depth, Image color, ImagePool pool)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (color == null)
+            {
+                throw new ArgumentNullException(nameof(color));
+            }
+
+            return RentAndRun(pool, color, (transformed) => this.ColorImageToDepthCamera(depth, color, transformed));
+        }
+
+        /// <summary>
+        /// Creates a point cloud from a depth image, into an Image rented from a pool.
+        /// </summary>
+        /// <param name="depth">The depth map to generate the point cloud from.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreatePointCloudPool(CalibrationDeviceType, int)"/>.</param>
+        /// <param name="camera">The perspective the depth map is from.</param>
+        /// <returns>A point cloud image. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Image DepthImageToPointCloud(Image depth, ImagePool pool, CalibrationDeviceType camera = CalibrationDeviceType.Depth)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            return RentAndRun(pool, depth, (pointCloud) => this.DepthImageToPointCloud(depth, pointCloud, camera));
+        }
+
+        /// <summary>
+        /// Transforms an Image from the depth camera perspective to the color camera perspective, on a thread of the SDK.
+        /// </summary>
+        /// <param name="depth">Depth image to transform.</param>
+        /// <param name="transformed">An Image to hold the output.</param>
+        /// <returns>A task that completes once <paramref name="transformed"/> holds the output.</returns>
+        /// <remarks>
+        /// The <paramref name="transformed"/> Image must be of the resolution of the color camera, and
+        /// of the pixel format of the depth image.
+        ///
+        /// The images are referenced until the task completes. Don't modify <paramref name="depth"/> or read
+        /// <paramref name="transformed"/> before then. The task fails with an <see cref="AzureKinectException"/> if
+        /// the transformation fails.
+        /// </remarks>
+        public Task DepthImageToColorCameraAsync(Image depth, Image transformed)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (transformed == null)
+            {
+                throw new ArgumentNullException(nameof(transformed));
+            }
+
+            return this.SubmitAsync(
+                new NativeMethods.k4a_transformation_job_t
+                {
+                    type = NativeMethods.k4a_transformation_job_type_t.K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR,
+                },
+                new Image[] { depth },
+                new Image[] { transformed });
+        }
+
+        /// <summary>
+        /// Transforms an Image from the depth camera perspective to the color camera perspective, on a thread of the SDK,
+        /// into an Image rented from a pool.
+        /// </summary>
+        /// <param name="depth">Depth image to transform.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreateDepthImageToColorCameraPool(int)"/>.</param>
+        /// <returns>A depth image transformed in to the color camera perspective. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Task<Image> DepthImageToColorCameraAsync(Image depth, ImagePool pool)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            return RentAndRunAsync(pool, depth, (transformed) => this.DepthImageToColorCameraAsync(depth, transformed));
+        }
+
+        /// <summary>
+        /// Transforms a depth Image and a custom Image from the depth camera perspective to the color camera perspective,
+        /// on a thread of the SDK.
+        /// </summary>
+        /// <param name="depth">Depth image to transform.</param>
+        /// <param name="custom">Custom image to transform.</param>
+        /// <param name="transformedDepth">An transformed depth image to hold the output.</param>
+        /// <param name="transformedCustom">An transformed custom image to hold the output.</param>
+        /// <param name="interpolationType">Parameter that controls how pixels in custom image should be interpolated when transformed to color camera space.</param>
+        /// <param name="invalidCustomValue">Defines the custom image pixel value that should be written to transformedCustom in case the corresponding depth pixel can not be transformed into the color camera space.</param>
+        /// <returns>A task that completes once <paramref name="transformedDepth"/> and <paramref name="transformedCustom"/> hold the output.</returns>
+        /// <remarks>
+        /// The images must be as for <see cref="DepthImageToColorCameraCustom(Image, Image, Image, Image, TransformationInterpolationType, uint)"/>,
+        /// and are referenced until the task completes.
+        /// </remarks>
+        public Task DepthImageToColorCameraCustomAsync(Image depth, Image custom, Image transformedDepth, Image transformedCustom, TransformationInterpolationType interpolationType, uint invalidCustomValue)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (custom == null)
+            {
+                throw new ArgumentNullException(nameof(custom));
+            }
+
+            if (transformedDepth == null)
+            {
+                throw new ArgumentNullException(nameof(transformedDepth));
+            }
+
+            if (transformedCustom == null)
+            {
+                throw new ArgumentNullException(nameof(transformedCustom));
+            }
+
+            if (custom.Format != ImageFormat.Custom8 && custom.Format != ImageFormat.Custom16)
+            {
+                throw new NotSupportedException("Failed to support this format of custom image!");
+            }
+
+            if (custom.Format != transformedCustom.Format)
+            {
+                throw new NotSupportedException("Failed to support this different format of custom image and transformed custom image!!");
+            }
+
+            return this.SubmitAsync(
+                new NativeMethods.k4a_transformation_job_t
+                {
+                    type = NativeMethods.k4a_transformation_job_type_t.K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR,
+                    interpolation_type = interpolationType,
+                    invalid_custom_value = invalidCustomValue,
+                },
+                new Image[] { depth, custom },
+                new Image[] { transformedDepth, transformedCustom });
+        }
+
+        /// <summary>
+        /// Transforms an Image from the color camera perspective to the depth camera perspective, on a thread of the SDK.
+        /// </summary>
+        /// <param name="depth">Depth map of the space the color image is being transformed in to.</param>
+        /// <param name="color">Color image to transform in to the depth space.</param>
+        /// <param name="transformed">An Image to hold the output.</param>
+        /// <returns>A task that completes once <paramref name="transformed"/> holds the output.</returns>
+        /// <remarks>
+        /// The <paramref name="transformed"/> Image must be of the resolution of the depth camera, and
+        /// of the pixel format of the color image. The images are referenced until the task completes.
+        /// </remarks>
+        public Task ColorImageToDepthCameraAsync(Image depth, Image color, Image transformed)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (color == null)
+            {
+                throw new ArgumentNullException(nameof(color));
+            }
+
+            if (transformed == null)
+            {
+                throw new ArgumentNullException(nameof(transformed));
+            }
+
+            return this.SubmitAsync(
+                new NativeMethods.k4a_transformation_job_t
+                {
+                    type = NativeMethods.k4a_transformation_job_type_t.K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH,
+                },
+                new Image[] { depth, color },
+                new Image[] { transformed });
+        }
+
+        /// <summary>
+        /// Transforms an Image from the color camera perspective to the depth camera perspective, on a thread of the SDK,
+        /// into an Image rented from a pool.
+        /// </summary>
+        /// <param name="depth">Depth map of the space the color image is being transformed in to.</param>
+        /// <param name="color">Color image to transform in to the depth space.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreateColorImageToDepthCameraPool(int)"/>.</param>
+        /// <returns>A color image in the perspective of the depth camera. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Task<Image> ColorImageToDepthCameraAsync(Image depth, Image color, ImagePool pool)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (color == null)
+            {
+                throw new ArgumentNullException(nameof(color));
+            }
+
+            return RentAndRunAsync(pool, color, (transformed) => this.ColorImageToDepthCameraAsync(depth, color, transformed));
+        }
+
+        /// <summary>
+        /// Creates a point cloud from a depth image, on a thread of the SDK.
+        /// </summary>
+        /// <param name="depth">The depth map to generate the point cloud from.</param>
+        /// <param name="pointCloud">The image to store the output point cloud.</param>
+        /// <param name="camera">The perspective the depth map is from.</param>
+        /// <returns>A task that completes once <paramref name="pointCloud"/> holds the output.</returns>
+        /// <remarks>
+        /// The <paramref name="pointCloud"/> image must be as for <see cref="DepthImageToPointCloud(Image, Image, CalibrationDeviceType)"/>.
+        /// The images are referenced until the task completes.
+        /// </remarks>
+        public Task DepthImageToPointCloudAsync(Image depth, Image pointCloud, CalibrationDeviceType camera = CalibrationDeviceType.Depth)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            if (pointCloud == null)
+            {
+                throw new ArgumentNullException(nameof(pointCloud));
+            }
+
+            return this.SubmitAsync(
+                new NativeMethods.k4a_transformation_job_t
+                {
+                    type = NativeMethods.k4a_transformation_job_type_t.K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD,
+                    camera = camera,
+                    point_cloud_format = NativeMethods.k4a_transformation_point_cloud_format_t.K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS,
+                },
+                new Image[] { depth },
+                new Image[] { pointCloud });
+        }
+
+        /// <summary>
+        /// Creates a point cloud from a depth image, on a thread of the SDK, into an Image rented from a pool.
+        /// </summary>
+        /// <param name="depth">The depth map to generate the point cloud from.</param>
+        /// <param name="pool">The pool of the output images, see <see cref="CreatePointCloudPool(CalibrationDeviceType, int)"/>.</param>
+        /// <param name="camera">The perspective the depth map is from.</param>
+        /// <returns>A point cloud image. Give it back with <see cref="ImagePool.Return(Image)"/>.</returns>
+        public Task<Image> DepthImageToPointCloudAsync(Image depth, ImagePool pool, CalibrationDeviceType camera = CalibrationDeviceType.Depth)
+        {
+            if (depth == null)
+            {
+                throw new ArgumentNullException(nameof(depth));
+            }
+
+            return RentAndRunAsync(pool, depth, (pointCloud) => this.DepthImageToPointCloudAsync(depth, pointCloud, camera));
+        }
+
         /// <inheritdoc/>
         public void Dispose()
         {
@@ -519,5 +861,199 @@ namespace Microsoft.Azure.Kinect.Sensor
                 this.disposedValue = true;
             }
         }
+
+        // Rents an output image and copies the timestamps and metadata of the source image to it. The image goes back
+        // to the pool if the operation fails.
+        private static Image RentAndRun(ImagePool pool, Image source, Action<Image> operation)
+        {
+            Image image = Rent(pool, source);
+            try
+            {
+                operation(image);
+                return image;
+            }
+            catch
+            {
+                pool.Return(image);
+                throw;
+            }
+        }
+
+        private static async Task<Image> RentAndRunAsync(ImagePool pool, Image source, Func<Image, Task> operation)
+        {
+            Image image = Rent(pool, source);
+            try
+            {
+                await operation(image).ConfigureAwait(false);
+                return image;
+            }
+            catch
+            {
+                pool.Return(image);
+                throw;
+            }
+        }
+
+        private static Image Rent(ImagePool pool, Image source)
+        {
+            if (pool == null)
+            {
+                throw new ArgumentNullException(nameof(pool));
+            }
+
+            Image image = pool.Rent();
+            image.DeviceTimestamp = source.DeviceTimestamp;
+            image.SystemTimestampNsec = source.SystemTimestampNsec;
+            image.Exposure = source.Exposure;
+            image.ISOSpeed = source.ISOSpeed;
+            image.WhiteBalance = source.WhiteBalance;
+            return image;
+        }
+
+        private static void OnSubmissionCompleted(NativeMethods.k4a_result_t result, IntPtr context)
+        {
+            // Runs on a thread of the SDK. Exceptions must not reach the native code.
+            GCHandle contextHandle = GCHandle.FromIntPtr(context);
+            Submission submission = (Submission)contextHandle.Target;
+            contextHandle.Free();
+
+            try
+            {
+                if (result == NativeMethods.k4a_result_t.K4A_RESULT_SUCCEEDED)
+                {
+                    // Copy the native memory back to managed memory if required
+                    foreach (Image output in submission.Outputs)
+                    {
+                        output.InvalidateMemory();
+                    }
+                }
+
+                submission.DisposeReferences();
+
+                if (result == NativeMethods.k4a_result_t.K4A_RESULT_SUCCEEDED)
+                {
+                    submission.Completion.SetResult(true);
+                }
+                else
+                {
+                    submission.Completion.SetException(new AzureKinectException($"result = {result}"));
+                }
+            }
+            catch (Exception e)
+            {
+                submission.DisposeReferences();
+                _ = submission.Completion.TrySetException(e);
+            }
+        }
+
+        // Submits a job to the native worker of the transformation. The job gets the handles of the images, inputs
+        // first and outputs after them, in the order of the fields of k4a_transformation_job_t.
+        private Task SubmitAsync(NativeMethods.k4a_transformation_job_t job, Image[] inputs, Image[] outputs)
+        {
+            lock (this)
+            {
+                if (this.disposedValue)
+                {
+                    throw new ObjectDisposedException(nameof(Transformation));
+                }
+
+                // Create new references to the Image objects so that they cannot be disposed before
+                // the job completes
+                Submission submission = new Submission(inputs, outputs);
+                GCHandle contextHandle = default;
+                try
+                {
+                    // Ensure changes made to the managed memory are visible to the native layer
+                    foreach (Image input in submission.Inputs)
+                    {
+                        input.FlushMemory();
+                    }
+
+                    job.depth_image = submission.Inputs[0].DangerousGetHandle().DangerousGetHandle();
+                    if (submission.Inputs.Length > 1)
+                    {
+                        job.source_image = submission.Inputs[1].DangerousGetHandle().DangerousGetHandle();
+                    }
+
+                    job.transformed_image = submission.Outputs[0].DangerousGetHandle().DangerousGetHandle();
+                    if (submission.Outputs.Length > 1)
+                    {
+                        job.transformed_source_image = submission.Outputs[1].DangerousGetHandle().DangerousGetHandle();
+                    }
+
+                    contextHandle = GCHandle.Alloc(submission);
+
+                    using (LoggingTracer tracer = new LoggingTracer())
+                    {
+                        NativeMethods.k4a_result_t result = NativeMethods.k4a_transformation_submit(
+                            this.handle,
+                            new NativeMethods.k4a_transformation_job_t[] { job },
+                            (UIntPtr)1,
+                            SubmissionCompleted,
+                            GCHandle.ToIntPtr(contextHandle));
+                        AzureKinectException.ThrowIfNotSuccess(tracer, result);
+                    }
+                }
+                catch
+                {
+                    if (contextHandle.IsAllocated)
+                    {
+                        contextHandle.Free();
+                    }
+
+                    submission.DisposeReferences();
+                    throw;
+                }
+
+                return submission.Completion.Task;
+            }
+        }
+
+        // The state of a submitted job, kept alive by a GCHandle until its callback.
+        private class Submission
+        {
+            public Submission(Image[] inputs, Image[] outputs)
+            {
+                this.Inputs = new Image[inputs.Length];
+                this.Outputs = new Image[outputs.Length];
+                try
+                {
+                    for (int i = 0; i < inputs.Length; i++)
+                    {
+                        this.Inputs[i] = inputs[i].Reference();
+                    }
+
+                    for (int i = 0; i < outputs.Length; i++)
+                    {
+                        this.Outputs[i] = outputs[i].Reference();
+                    }
+                }
+                catch
+                {
+                    this.DisposeReferences();
+                    throw;
+                }
+            }
+
+            public Image[] Inputs { get; }
+
+            public Image[] Outputs { get; }
+
+            // Continuations run on the thread pool, not on the callback thread of the SDK.
+            public TaskCompletionSource<bool> Completion { get; } = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+            public void DisposeReferences()
+            {
+                foreach (Image image in this.Inputs)
+                {
+                    image?.Dispose();
+                }
+
+                foreach (Image image in this.Outputs)
+                {
+                    image?.Dispose();
+                }
+            }
+        }
     }
 }
@@ -1,4 +1,4 @@
-//------------------------------------------------------------------------------
+﻿//------------------------------------------------------------------------------
 // <copyright file="DeviceFunctionTests.cs" company="Microsoft">
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
@@ -1009,6 +1009,89 @@ k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle, k4a_imu_
 
         }
 
+        [Test]
+        public void DeviceGetImuSamples()
+        {
+            SetOpenCloseImplementation();
+
+            NativeK4a.SetImplementation(@"
+
+k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle, k4a_imu_sample_t* imu_samples, size_t max_sample_count, size_t* sample_count, int32_t timeout_in_ms)
+{
+    STUB_ASSERT(device_handle == (k4a_device_t)0x1234ABCD);
+    STUB_ASSERT(imu_samples != NULL);
+    STUB_ASSERT(sample_count != NULL);
+    STUB_ASSERT(max_sample_count == 4);
+    STUB_ASSERT(timeout_in_ms == 2345);
+
+    for (int i = 0; i < 3; i++)
+    {
+        imu_samples[i].temperature = 0.123f;
+
+        imu_samples[i].acc_sample.v[0] = 0.0f;
+        imu_samples[i].acc_sample.v[1] = 0.1f;
+        imu_samples[i].acc_sample.v[2] = 0.2f;
+        // 10 seconds apart
+        imu_samples[i].acc_timestamp_usec = 10000000 * (i + 1);
+
+        imu_samples[i].gyro_sample.v[0] = 0.4f;
+        imu_samples[i].gyro_sample.v[1] = 0.5f;
+        imu_samples[i].gyro_sample.v[2] = 0.6f;
+
+        imu_samples[i].gyro_timestamp_usec = 60000000 * (i + 1);
+    }
+
+    *sample_count = 3;
+
+    return K4A_WAIT_RESULT_SUCCEEDED;
+}
+
+");
+            {
+                CallCount count = NativeK4a.CountCalls();
+                using (Device device = Device.Open(0))
+                {
+                    ImuSample[] samples = new ImuSample[4];
+                    ImuSample reused = new ImuSample();
+                    samples[0] = reused;
+
+                    Assert.AreEqual(0, count.Calls("k4a_device_get_imu_samples"));
+                    int read = device.GetImuSamples(samples, System.TimeSpan.FromMilliseconds(2345));
+                    Assert.AreEqual(1, count.Calls("k4a_device_get_imu_samples"));
+
+                    Assert.AreEqual(3, read);
+                    Assert.AreSame(reused, samples[0]);
+                    Assert.IsNull(samples[3]);
+
+                    for (int i = 0; i < read; i++)
+                    {
+                        Assert.AreEqual(0.123f, samples[i].Temperature);
+
+                        Assert.AreEqual(0.0f, samples[i].AccelerometerSample.X);
+                        Assert.AreEqual(0.1f, samples[i].AccelerometerSample.Y);
+                        Assert.AreEqual(0.2f, samples[i].AccelerometerSample.Z);
+                        Assert.AreEqual(TimeSpan.FromSeconds(10 * (i + 1)), samples[i].AccelerometerTimestamp);
+
+                        Assert.AreEqual(0.4f, samples[i].GyroSample.X);
+                        Assert.AreEqual(0.5f, samples[i].GyroSample.Y);
+                        Assert.AreEqual(0.6f, samples[i].GyroSample.Z);
+                        Assert.AreEqual(TimeSpan.FromMinutes(i + 1), samples[i].GyroTimestamp);
+                    }
+
+                    Assert.Throws(typeof(System.ArgumentException), () =>
+                    {
+                        device.GetImuSamples(new ImuSample[0], System.TimeSpan.FromMilliseconds(2345));
+                    });
+
+                    device.Dispose();
+                    Assert.Throws(typeof(System.ObjectDisposedException), () =>
+                    {
+                        device.GetImuSamples(samples, System.TimeSpan.FromMilliseconds(2345));
+                    });
+                }
+            }
+        }
+
         [Test]
         public void DeviceGetImuSampleTimeout()
         {
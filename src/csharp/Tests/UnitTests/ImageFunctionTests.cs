@@ -203,5 +203,32 @@ k4a_result_t k4a_set_debug_message_handler(
         
             Assert.AreEqual(count.Calls("k4a_image_reference") + 1, count.Calls("k4a_image_release"), "References not zero");
         }
+
+        [Test]
+        public void ImageMemoryAfterDispose()
+        {
+            SetImageStubImplementation();
+
+            CallCount count = NativeK4a.CountCalls();
+
+            Image image = new Image(ImageFormat.Custom, 640, 480, 640 * 2);
+            Memory<byte> memory = image.Memory;
+
+            System.Buffers.MemoryHandle pin = memory.Pin();
+
+            image.Dispose();
+
+            // The pin keeps one native reference alive after the Image is disposed
+            Assert.AreEqual(count.Calls("k4a_image_reference"), count.Calls("k4a_image_release"));
+
+            // New access to the memory of a disposed Image must not reach the native buffer
+            Assert.Throws<ObjectDisposedException>(() => { _ = memory.Span.Length; });
+            Assert.Throws<ObjectDisposedException>(() => { memory.Pin(); });
+
+            // Releasing the last pin releases the native image
+            pin.Dispose();
+
+            Assert.AreEqual(count.Calls("k4a_image_reference") + 1, count.Calls("k4a_image_release"), "References not zero");
+        }
     }
 }
@@ -0,0 +1,201 @@
+﻿// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+using System;
+using Microsoft.Azure.Kinect.Sensor.Test.StubGenerator;
+using NUnit.Framework;
+
+namespace Microsoft.Azure.Kinect.Sensor.UnitTests
+{
+    public class ImagePoolTests
+    {
+        private readonly StubbedModule NativeK4a;
+
+        public ImagePoolTests()
+        {
+            NativeK4a = StubbedModule.Get("k4a");
+            if (NativeK4a == null)
+            {
+                NativeInterface k4ainterface = NativeInterface.Create(
+                    EnvironmentInfo.CalculateFileLocation(@"k4a\k4a.dll"),
+                    EnvironmentInfo.CalculateFileLocation(@"k4a\k4a.h"));
+
+                NativeK4a = StubbedModule.Create("k4a", k4ainterface);
+            }
+        }
+
+        [SetUp]
+        public void Setup()
+        {
+            // Force garbage collection
+            System.GC.Collect(0, System.GCCollectionMode.Forced, true);
+            System.GC.WaitForPendingFinalizers();
+
+            // Don't hook the native allocator
+            Microsoft.Azure.Kinect.Sensor.Allocator.Singleton.UseManagedAllocator = false;
+        }
+
+        // Helper function to implement basic create/release behavior
+        private void SetImageStubImplementation()
+        {
+            NativeK4a.SetImplementation(@"
+
+uint16_t dummybuffer[640*480];
+
+int referenceCount = 0;
+
+k4a_result_t k4a_image_create(k4a_image_format_t format, int width_pixels, int height_pixels, int stride_bytes, k4a_image_t* image_handle)
+{
+    STUB_ASSERT(image_handle != NULL);
+
+    STUB_ASSERT(format == K4A_IMAGE_FORMAT_CUSTOM);
+    STUB_ASSERT(width_pixels == 640);
+    STUB_ASSERT(height_pixels == 480);
+    STUB_ASSERT(stride_bytes == (640*2));
+
+    *image_handle = (k4a_image_t)0x0D001234;
+
+    for (int i = 0; i < 640 * 480; i++)
+    {
+        dummybuffer[i] = (uint16_t)i; 
+    }
+
+    //STUB_ASSERT(referenceCount == 0);
+    referenceCount = 1;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+size_t k4a_image_get_size(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+
+    return 640*2*480;
+}
+
+uint8_t* k4a_image_get_buffer(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+
+    return (uint8_t*)dummybuffer; 
+}
+
+int k4a_image_get_stride_bytes(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+
+    return 640*2;
+}
+
+int k4a_image_get_width_pixels(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+
+    return 640;
+}
+
+int k4a_image_get_height_pixels(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+
+    return 480;
+}
+
+void k4a_image_reference(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+    referenceCount++;
+}
+
+void k4a_image_release(k4a_image_t image_handle)
+{
+    STUB_ASSERT(image_handle == (k4a_image_t)0x0D001234);
+    referenceCount--;
+    if (referenceCount == 0)
+    {
+        memset(dummybuffer, 0, sizeof(dummybuffer));
+    }
+}
+
+k4a_result_t k4a_set_debug_message_handler(
+    k4a_logging_message_cb_t *message_cb,
+    void *message_cb_context,
+    k4a_log_level_t min_level)
+{
+    STUB_ASSERT(message_cb != NULL);
+
+    return K4A_RESULT_SUCCEEDED;
+}");
+        }
+
+        // Validate that a returned image is rented again instead of creating a new one
+        [Test]
+        public void ImagePoolReusesReturnedImages()
+        {
+            SetImageStubImplementation();
+
+            CallCount count = NativeK4a.CountCalls();
+
+            using (ImagePool pool = new ImagePool(ImageFormat.Custom, 640, 480, 640 * 2, 1))
+            {
+                Image first = pool.Rent();
+                pool.Return(first);
+
+                Image second = pool.Rent();
+                Assert.AreSame(first, second);
+                Assert.AreEqual(1, count.Calls("k4a_image_create"));
+                Assert.AreEqual(0, count.Calls("k4a_image_release"));
+
+                pool.Return(second);
+            }
+
+            // Disposing the pool disposes its idle images
+            Assert.AreEqual(1, count.Calls("k4a_image_create"));
+            Assert.AreEqual(count.Calls("k4a_image_reference") + 1, count.Calls("k4a_image_release"));
+        }
+
+        // Validate that images returned to a full pool are disposed
+        [Test]
+        public void ImagePoolDisposesImagesBeyondCapacity()
+        {
+            SetImageStubImplementation();
+
+            CallCount count = NativeK4a.CountCalls();
+
+            using (ImagePool pool = new ImagePool(ImageFormat.Custom, 640, 480, 640 * 2, 1))
+            {
+                Image first = pool.Rent();
+                Image second = pool.Rent();
+                Assert.AreEqual(2, count.Calls("k4a_image_create"));
+
+                pool.Return(first);
+                Assert.AreEqual(0, count.Calls("k4a_image_release"));
+
+                pool.Return(second);
+                Assert.AreEqual(1, count.Calls("k4a_image_release"));
+                _ = Assert.Throws<ObjectDisposedException>(() => _ = second.Exposure);
+            }
+        }
+
+        // Validate that only images rented from the pool, and not disposed, can be returned
+        [Test]
+        public void ImagePoolRejectsForeignImages()
+        {
+            SetImageStubImplementation();
+
+            using (ImagePool pool = new ImagePool(ImageFormat.Custom, 640, 480, 640 * 2, 1))
+            using (Image foreign = new Image(ImageFormat.Custom, 640, 480, 640 * 2))
+            {
+                _ = Assert.Throws<ArgumentNullException>(() => pool.Return(null));
+                _ = Assert.Throws<ArgumentException>(() => pool.Return(foreign));
+
+                Image rented = pool.Rent();
+                pool.Return(rented);
+                _ = Assert.Throws<ArgumentException>(() => pool.Return(rented));
+
+                Image disposed = pool.Rent();
+                disposed.Dispose();
+                _ = Assert.Throws<ObjectDisposedException>(() => pool.Return(disposed));
+            }
+        }
+    }
+}
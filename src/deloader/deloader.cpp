@@ -8,17 +8,71 @@
 #include <k4ainternal/logging.h>
 #include <k4ainternal/dynlib.h>
 
+#include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+// Number of GPUs the depth engine load is tracked for
+#define DELOADER_MAX_GPUS 16
+
+// How long a frame of a shared depth engine waits for the frames of the other depth engines in its group before it is
+// dispatched without them
+#define DELOADER_BATCH_WINDOW_USEC 2000
+
+typedef struct
+{
+    k4a_depth_engine_batch_frame_t *frame;
+    bool done;
+} deloader_pending_frame_t;
+
+// Depth engines of different devices with the same mode on the same GPU, sharing the GPU resources of the first one
+typedef struct
+{
+    k4a_depth_engine_mode_t mode;
+    k4a_depth_engine_input_type_t input_format;
+    int32_t gpu_index; // -1 for the GPU picked by the plugin
+
+    std::vector<k4a_depth_engine_context_t *> members;
+    std::vector<deloader_pending_frame_t *> pending; // Frames waiting for the next batch
+    bool dispatching;                                // A batch of this group is being processed
+} deloader_shared_group_t;
+
+typedef struct
+{
+    std::mutex lock;
+    std::condition_variable condition; // Signaled when a batch completes or a group loses a member
+    std::list<deloader_shared_group_t> groups;
+} deloader_shared_engines_t;
+
 typedef struct
 {
     k4a_plugin_t plugin;
     dynlib_t handle;
     k4a_register_plugin_fn registerFn;
     volatile bool loaded;
+
+    std::mutex *gpu_lock;
+    uint64_t gpu_load[DELOADER_MAX_GPUS]; // Sum of the load of the depth engines running on each GPU
+
+    deloader_shared_engines_t *shared_engines;
 } deloader_global_context_t;
 
 static void deloader_init_once(deloader_global_context_t *global);
 static void deloader_deinit(void);
 
+// Thread started by deloader_preload(), joined when the deloader is torn down. Declared before the object that tears
+// the deloader down so the lock outlives it.
+static std::mutex g_preload_lock;
+static THREAD_HANDLE g_preload_thread = NULL;
+static bool g_preload_started = false;
+
 // Creates a function called deloader_global_context_t_get() which returns the initialized
 // singleton global
 K4A_DECLARE_GLOBAL(deloader_global_context_t, deloader_init_once);
@@ -63,11 +117,137 @@ static bool verify_plugin(const k4a_plugin_t *plugin)
     return true;
 }
 
+static k4a_depth_engine_gpu_context_t get_gpu_context(void)
+{
+    // K4A_DEPTH_ENGINE_CONTEXT is "headless", "windowed" or "default"
+    const char *env_context = environment_get_variable("K4A_DEPTH_ENGINE_CONTEXT");
+    if (env_context != NULL && env_context[0] != '\0')
+    {
+        if (strcmp(env_context, "headless") == 0)
+        {
+            return K4A_DEPTH_ENGINE_GPU_CONTEXT_HEADLESS;
+        }
+        if (strcmp(env_context, "windowed") == 0)
+        {
+            return K4A_DEPTH_ENGINE_GPU_CONTEXT_WINDOWED;
+        }
+        if (strcmp(env_context, "default") != 0)
+        {
+            LOG_WARNING("Ignoring unknown K4A_DEPTH_ENGINE_CONTEXT value \"%s\"", env_context);
+        }
+        return K4A_DEPTH_ENGINE_GPU_CONTEXT_DEFAULT;
+    }
+
+#ifndef _WIN32
+    // Servers and containers usually have no display server to create a windowed context with
+    const char *display = environment_get_variable("DISPLAY");
+    const char *wayland_display = environment_get_variable("WAYLAND_DISPLAY");
+    if ((display == NULL || display[0] == '\0') && (wayland_display == NULL || wayland_display[0] == '\0'))
+    {
+        return K4A_DEPTH_ENGINE_GPU_CONTEXT_HEADLESS;
+    }
+#endif
+
+    return K4A_DEPTH_ENGINE_GPU_CONTEXT_DEFAULT;
+}
+
+static void set_gpu_context(deloader_global_context_t *global)
+{
+    k4a_depth_engine_gpu_context_t gpu_context = get_gpu_context();
+    if (gpu_context == K4A_DEPTH_ENGINE_GPU_CONTEXT_DEFAULT)
+    {
+        return;
+    }
+
+    const char *name = gpu_context == K4A_DEPTH_ENGINE_GPU_CONTEXT_HEADLESS ? "headless" : "windowed";
+    if (global->plugin.set_gpu_context == NULL)
+    {
+        if (gpu_context == K4A_DEPTH_ENGINE_GPU_CONTEXT_HEADLESS)
+        {
+            LOG_WARNING("Depth engine plugin doesn't support headless GPU contexts, it may need a display server", 0);
+        }
+        return;
+    }
+
+    // Not fatal, the plugin keeps the context it would have picked
+    k4a_depth_engine_result_code_t deresult = global->plugin.set_gpu_context(gpu_context);
+    if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        LOG_WARNING("Depth engine plugin failed to select a %s GPU context with error code: %d.", name, deresult);
+    }
+    else
+    {
+        LOG_INFO("Depth engine uses a %s GPU context", name);
+    }
+}
+
+// Fills directory with the shader cache directory, returns false if the cache is disabled
+static bool get_shader_cache_directory(char *directory, size_t directory_size)
+{
+    // K4A_DEPTH_ENGINE_SHADER_CACHE is a directory, or 0 to disable the cache
+    const char *env_cache = environment_get_variable("K4A_DEPTH_ENGINE_SHADER_CACHE");
+    if (env_cache != NULL && env_cache[0] != '\0')
+    {
+        if (strcmp(env_cache, "0") == 0)
+        {
+            return false;
+        }
+        return snprintf(directory, directory_size, "%s", env_cache) < (int)directory_size;
+    }
+
+    // Default to the per user cache directory of the platform
+    int length = -1;
+#ifdef _WIN32
+    const char *local_app_data = environment_get_variable("LOCALAPPDATA");
+    if (local_app_data != NULL && local_app_data[0] != '\0')
+    {
+        length = snprintf(directory, directory_size, "%s\\Azure Kinect\\shader_cache", local_app_data);
+    }
+#else
+    const char *xdg_cache_home = environment_get_variable("XDG_CACHE_HOME");
+    const char *home = environment_get_variable("HOME");
+    if (xdg_cache_home != NULL && xdg_cache_home[0] != '\0')
+    {
+        length = snprintf(directory, directory_size, "%s/k4a/shader_cache", xdg_cache_home);
+    }
+    else if (home != NULL && home[0] != '\0')
+    {
+        length = snprintf(directory, directory_size, "%s/.cache/k4a/shader_cache", home);
+    }
+#endif
+
+    return length > 0 && length < (int)directory_size;
+}
+
+static void set_shader_cache(deloader_global_context_t *global)
+{
+    char directory[1024];
+
+    if (global->plugin.set_shader_cache == NULL || !get_shader_cache_directory(directory, sizeof(directory)))
+    {
+        return;
+    }
+
+    // Not fatal, GPU programs are compiled every time instead
+    k4a_depth_engine_result_code_t deresult = global->plugin.set_shader_cache(directory);
+    if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        LOG_WARNING("Depth engine plugin can't use shader cache %s, error code: %d.", directory, deresult);
+    }
+    else
+    {
+        LOG_INFO("Depth engine shader cache: %s", directory);
+    }
+}
+
 // Load Depth Engine
 static void deloader_init_once(deloader_global_context_t *global)
 {
     // All members are initialized to zero
 
+    global->gpu_lock = new (std::nothrow) std::mutex();
+    global->shared_engines = new (std::nothrow) deloader_shared_engines_t();
+
     k4a_result_t result = dynlib_create(K4A_PLUGIN_DYNAMIC_LIBRARY_NAME, K4A_PLUGIN_VERSION, &global->handle);
     if (K4A_FAILED(result))
     {
@@ -93,10 +273,49 @@ static void deloader_init_once(deloader_global_context_t *global)
 
     if (K4A_SUCCEEDED(result))
     {
+        set_gpu_context(global);
+        set_shader_cache(global);
         global->loaded = true;
     }
 }
 
+static int deloader_preload_thread(void *param)
+{
+    (void)param;
+
+    // Runs deloader_init_once(), a depth engine created meanwhile waits for it to finish instead of loading again
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    LOG_INFO("Depth engine plugin %s in the background", is_plugin_loaded(global) ? "loaded" : "failed to load");
+    return 0;
+}
+
+void deloader_preload(void)
+{
+    std::lock_guard<std::mutex> lock(g_preload_lock);
+    if (g_preload_started)
+    {
+        return;
+    }
+    g_preload_started = true;
+
+    if (ThreadAPI_Create(&g_preload_thread, deloader_preload_thread, NULL) != THREADAPI_OK)
+    {
+        // Not fatal, the plugin is loaded by the first depth engine instead
+        LOG_WARNING("Could not start loading the depth engine plugin in the background", 0);
+        g_preload_thread = NULL;
+    }
+}
+
+void deloader_preload_if_requested(void)
+{
+    // K4A_DEPTH_ENGINE_PRELOAD is 1 to load the plugin when a device is opened
+    const char *env_preload = environment_get_variable("K4A_DEPTH_ENGINE_PRELOAD");
+    if (env_preload != NULL && strcmp(env_preload, "1") == 0)
+    {
+        deloader_preload();
+    }
+}
+
 k4a_depth_engine_result_code_t deloader_depth_engine_create_and_initialize(k4a_depth_engine_context_t **context,
                                                                            size_t cal_block_size_in_bytes,
                                                                            void *cal_block,
@@ -163,6 +382,342 @@ size_t deloader_depth_engine_get_output_frame_size(k4a_depth_engine_context_t *c
     return global->plugin.depth_engine_get_output_frame_size(context);
 }
 
+size_t deloader_depth_engine_get_output_type_frame_size(k4a_depth_engine_context_t *context,
+                                                        k4a_depth_engine_output_type_t output_type)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    if (!is_plugin_loaded(global))
+    {
+        return 0;
+    }
+
+    // Plugins without the optional entry point only support the output types that were there from the start
+    if (global->plugin.depth_engine_get_output_type_frame_size == NULL)
+    {
+        if (output_type >= K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY)
+        {
+            return 0;
+        }
+        return global->plugin.depth_engine_get_output_frame_size(context);
+    }
+
+    return global->plugin.depth_engine_get_output_type_frame_size(context, output_type);
+}
+
+static uint32_t get_gpu_count(deloader_global_context_t *global)
+{
+    // Both entry points are optional, a plugin has to provide both to place depth engines on GPUs
+    if (!is_plugin_loaded(global) || global->gpu_lock == NULL ||
+        global->plugin.depth_engine_get_gpu_count == NULL ||
+        global->plugin.depth_engine_create_and_initialize_on_gpu == NULL)
+    {
+        return 0;
+    }
+
+    uint32_t count = global->plugin.depth_engine_get_gpu_count();
+    return count < DELOADER_MAX_GPUS ? count : DELOADER_MAX_GPUS;
+}
+
+int32_t deloader_depth_engine_reserve_gpu(int32_t gpu_index, uint64_t load)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    uint32_t count = get_gpu_count(global);
+
+    if (count == 0)
+    {
+        return -1;
+    }
+
+    if (gpu_index != K4A_DEPTH_ENGINE_GPU_AUTO && (gpu_index < 0 || (uint32_t)gpu_index >= count))
+    {
+        LOG_ERROR("Depth engine GPU %d is out of range, the depth engine plugin reports %u GPUs", gpu_index, count);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(*global->gpu_lock);
+
+    if (gpu_index == K4A_DEPTH_ENGINE_GPU_AUTO)
+    {
+        gpu_index = 0;
+        for (uint32_t i = 1; i < count; i++)
+        {
+            if (global->gpu_load[i] < global->gpu_load[gpu_index])
+            {
+                gpu_index = (int32_t)i;
+            }
+        }
+    }
+
+    global->gpu_load[gpu_index] += load;
+    return gpu_index;
+}
+
+void deloader_depth_engine_release_gpu(int32_t gpu_index, uint64_t load)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    if (gpu_index < 0 || gpu_index >= DELOADER_MAX_GPUS || global->gpu_lock == NULL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(*global->gpu_lock);
+    global->gpu_load[gpu_index] -= load < global->gpu_load[gpu_index] ? load : global->gpu_load[gpu_index];
+}
+
+k4a_depth_engine_result_code_t
+deloader_depth_engine_create_and_initialize_on_gpu(k4a_depth_engine_context_t **context,
+                                                   size_t cal_block_size_in_bytes,
+                                                   void *cal_block,
+                                                   k4a_depth_engine_mode_t mode,
+                                                   k4a_depth_engine_input_type_t input_format,
+                                                   void *camera_calibration,
+                                                   k4a_processing_complete_cb_t *callback,
+                                                   void *callback_context,
+                                                   uint32_t gpu_index)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    if (gpu_index >= get_gpu_count(global))
+    {
+        LOG_ERROR("Depth engine plugin can't create a depth engine on GPU %u", gpu_index);
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    return global->plugin.depth_engine_create_and_initialize_on_gpu(context,
+                                                                    cal_block_size_in_bytes,
+                                                                    cal_block,
+                                                                    mode,
+                                                                    input_format,
+                                                                    camera_calibration,
+                                                                    callback,
+                                                                    callback_context,
+                                                                    gpu_index);
+}
+
+static deloader_shared_group_t *find_shared_group(deloader_shared_engines_t *shared,
+                                                  const k4a_depth_engine_context_t *context)
+{
+    for (deloader_shared_group_t &group : shared->groups)
+    {
+        for (const k4a_depth_engine_context_t *member : group.members)
+        {
+            if (member == context)
+            {
+                return &group;
+            }
+        }
+    }
+    return NULL;
+}
+
+static k4a_depth_engine_result_code_t create_depth_engine(deloader_global_context_t *global,
+                                                          k4a_depth_engine_context_t **context,
+                                                          size_t cal_block_size_in_bytes,
+                                                          void *cal_block,
+                                                          k4a_depth_engine_mode_t mode,
+                                                          k4a_depth_engine_input_type_t input_format,
+                                                          void *camera_calibration,
+                                                          int32_t gpu_index)
+{
+    if (gpu_index >= 0)
+    {
+        return deloader_depth_engine_create_and_initialize_on_gpu(context,
+                                                                  cal_block_size_in_bytes,
+                                                                  cal_block,
+                                                                  mode,
+                                                                  input_format,
+                                                                  camera_calibration,
+                                                                  NULL,
+                                                                  NULL,
+                                                                  (uint32_t)gpu_index);
+    }
+
+    return global->plugin.depth_engine_create_and_initialize(
+        context, cal_block_size_in_bytes, cal_block, mode, input_format, camera_calibration, NULL, NULL);
+}
+
+k4a_depth_engine_result_code_t deloader_depth_engine_create_shared(k4a_depth_engine_context_t **context,
+                                                                   size_t cal_block_size_in_bytes,
+                                                                   void *cal_block,
+                                                                   k4a_depth_engine_mode_t mode,
+                                                                   k4a_depth_engine_input_type_t input_format,
+                                                                   void *camera_calibration,
+                                                                   int32_t gpu_index,
+                                                                   bool *shared)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    *shared = false;
+
+    if (!is_plugin_loaded(global))
+    {
+        LOG_ERROR("Failed to load depth engine plugin", 0);
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    if (global->plugin.depth_engine_create_and_initialize_shared == NULL || global->shared_engines == NULL)
+    {
+        LOG_INFO("Depth engine plugin doesn't support sharing depth engines, creating a separate depth engine", 0);
+        return create_depth_engine(
+            global, context, cal_block_size_in_bytes, cal_block, mode, input_format, camera_calibration, gpu_index);
+    }
+
+    deloader_shared_engines_t *shared_engines = global->shared_engines;
+
+    // Held while the depth engine is created so two devices starting together don't both create a group
+    std::lock_guard<std::mutex> lock(shared_engines->lock);
+
+    deloader_shared_group_t *group = NULL;
+    for (deloader_shared_group_t &candidate : shared_engines->groups)
+    {
+        if (candidate.mode == mode && candidate.input_format == input_format && candidate.gpu_index == gpu_index)
+        {
+            group = &candidate;
+            break;
+        }
+    }
+
+    k4a_depth_engine_result_code_t result;
+    if (group != NULL)
+    {
+        result = global->plugin.depth_engine_create_and_initialize_shared(context,
+                                                                           cal_block_size_in_bytes,
+                                                                           cal_block,
+                                                                           mode,
+                                                                           input_format,
+                                                                           camera_calibration,
+                                                                           NULL,
+                                                                           NULL,
+                                                                           group->members[0]);
+    }
+    else
+    {
+        result = create_depth_engine(
+            global, context, cal_block_size_in_bytes, cal_block, mode, input_format, camera_calibration, gpu_index);
+    }
+
+    if (result == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        if (group == NULL)
+        {
+            shared_engines->groups.emplace_back();
+            group = &shared_engines->groups.back();
+            group->mode = mode;
+            group->input_format = input_format;
+            group->gpu_index = gpu_index;
+            group->dispatching = false;
+        }
+        group->members.push_back(*context);
+        *shared = true;
+
+        LOG_INFO("Depth engine shared by %d devices", (int)group->members.size());
+    }
+
+    return result;
+}
+
+// Processes the pending frames of group in one dispatch, lock is released while the depth engine runs
+static void dispatch_shared_batch(deloader_global_context_t *global,
+                                  deloader_shared_group_t *group,
+                                  std::unique_lock<std::mutex> &lock)
+{
+    std::vector<deloader_pending_frame_t *> batch;
+    batch.swap(group->pending);
+    group->dispatching = true;
+
+    std::vector<k4a_depth_engine_batch_frame_t> frames;
+    frames.reserve(batch.size());
+    for (deloader_pending_frame_t *pending : batch)
+    {
+        frames.push_back(*pending->frame);
+    }
+
+    lock.unlock();
+    k4a_depth_engine_result_code_t result = global->plugin.depth_engine_process_frame_batch(frames.data(),
+                                                                                           (uint32_t)frames.size());
+    lock.lock();
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        batch[i]->frame->result = result == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED ? frames[i].result : result;
+        batch[i]->done = true;
+    }
+    group->dispatching = false;
+    global->shared_engines->condition.notify_all();
+}
+
+k4a_depth_engine_result_code_t
+deloader_depth_engine_process_frame_shared(k4a_depth_engine_context_t *context,
+                                           void *input_frame,
+                                           size_t input_frame_size,
+                                           k4a_depth_engine_output_type_t output_type,
+                                           void *output_frame,
+                                           size_t output_frame_size,
+                                           k4a_depth_engine_output_frame_info_t *output_frame_info,
+                                           k4a_depth_engine_input_frame_info_t *input_frame_info)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    if (!is_plugin_loaded(global))
+    {
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    if (global->plugin.depth_engine_process_frame_batch == NULL || global->shared_engines == NULL)
+    {
+        return global->plugin.depth_engine_process_frame(context,
+                                                         input_frame,
+                                                         input_frame_size,
+                                                         output_type,
+                                                         output_frame,
+                                                         output_frame_size,
+                                                         output_frame_info,
+                                                         input_frame_info);
+    }
+
+    k4a_depth_engine_batch_frame_t frame = { context,
+                                             input_frame,
+                                             input_frame_size,
+                                             output_type,
+                                             output_frame,
+                                             output_frame_size,
+                                             output_frame_info,
+                                             input_frame_info,
+                                             K4A_DEPTH_ENGINE_RESULT_SUCCEEDED };
+    deloader_pending_frame_t pending = { &frame, false };
+    deloader_shared_engines_t *shared_engines = global->shared_engines;
+
+    std::unique_lock<std::mutex> lock(shared_engines->lock);
+    deloader_shared_group_t *group = find_shared_group(shared_engines, context);
+    RETURN_VALUE_IF_ARG(K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_NULL_ENGINE_POINTER, group == NULL);
+
+    group->pending.push_back(&pending);
+
+    // The first frame to find all members pending, or to reach the end of its window, dispatches the batch. The others
+    // wait for it to complete.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                                                     std::chrono::microseconds(DELOADER_BATCH_WINDOW_USEC);
+    while (!pending.done)
+    {
+        bool expired = std::chrono::steady_clock::now() >= deadline;
+        if (!group->dispatching && (group->pending.size() >= group->members.size() || expired))
+        {
+            dispatch_shared_batch(global, group, lock);
+        }
+        else if (group->dispatching || expired)
+        {
+            shared_engines->condition.wait(lock);
+        }
+        else
+        {
+            shared_engines->condition.wait_until(lock, deadline);
+        }
+    }
+
+    return frame.result;
+}
+
 void deloader_depth_engine_destroy(k4a_depth_engine_context_t **context)
 {
     deloader_global_context_t *global = deloader_global_context_t_get();
@@ -171,9 +726,168 @@ void deloader_depth_engine_destroy(k4a_depth_engine_context_t **context)
         return;
     }
 
+    if (global->shared_engines != NULL && context != NULL)
+    {
+        deloader_shared_engines_t *shared_engines = global->shared_engines;
+        std::lock_guard<std::mutex> lock(shared_engines->lock);
+
+        deloader_shared_group_t *group = find_shared_group(shared_engines, *context);
+        if (group != NULL)
+        {
+            for (size_t i = 0; i < group->members.size(); i++)
+            {
+                if (group->members[i] == *context)
+                {
+                    group->members.erase(group->members.begin() + (ptrdiff_t)i);
+                    break;
+                }
+            }
+
+            if (group->members.empty())
+            {
+                shared_engines->groups.remove_if(
+                    [group](const deloader_shared_group_t &candidate) { return &candidate == group; });
+            }
+
+            // Frames waiting for this member can be dispatched without it
+            shared_engines->condition.notify_all();
+        }
+    }
+
     global->plugin.depth_engine_destroy(context);
 }
 
+bool deloader_depth_engine_supports_gpu_export(void)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return is_plugin_loaded(global) && global->plugin.depth_engine_process_frame_gpu != NULL;
+}
+
+k4a_depth_engine_result_code_t
+deloader_depth_engine_process_frame_gpu(k4a_depth_engine_context_t *context,
+                                        void *input_frame,
+                                        size_t input_frame_size,
+                                        k4a_depth_engine_output_type_t output_type,
+                                        void *output_frame,
+                                        size_t output_frame_size,
+                                        bool skip_depth_readback,
+                                        k4a_depth_engine_output_frame_info_t *output_frame_info,
+                                        k4a_depth_engine_input_frame_info_t *input_frame_info,
+                                        k4a_transform_engine_gpu_export_t export_type,
+                                        uint32_t slot,
+                                        uint32_t slot_count,
+                                        k4a_transform_engine_gpu_output_t *gpu_output)
+{
+    if (!deloader_depth_engine_supports_gpu_export())
+    {
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return global->plugin.depth_engine_process_frame_gpu(context,
+                                                         input_frame,
+                                                         input_frame_size,
+                                                         output_type,
+                                                         output_frame,
+                                                         output_frame_size,
+                                                         skip_depth_readback,
+                                                         output_frame_info,
+                                                         input_frame_info,
+                                                         export_type,
+                                                         slot,
+                                                         slot_count,
+                                                         gpu_output);
+}
+
+bool deloader_depth_engine_supports_async(void)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return is_plugin_loaded(global) && global->plugin.depth_engine_register_output_frames != NULL &&
+           global->plugin.depth_engine_submit_frame != NULL && global->plugin.depth_engine_poll_frame != NULL &&
+           global->plugin.depth_engine_complete_frame != NULL;
+}
+
+k4a_depth_engine_result_code_t deloader_depth_engine_register_output_frames(k4a_depth_engine_context_t *context,
+                                                                            void *const *output_frames,
+                                                                            uint32_t output_frame_count,
+                                                                            size_t output_frame_size)
+{
+    if (!deloader_depth_engine_supports_async())
+    {
+        return K4A_DEPTH_ENGINE_RESULT_SUCCEEDED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return global->plugin.depth_engine_register_output_frames(context,
+                                                              output_frames,
+                                                              output_frame_count,
+                                                              output_frame_size);
+}
+
+k4a_depth_engine_result_code_t deloader_depth_engine_submit_frame(k4a_depth_engine_context_t *context,
+                                                                  deloader_depth_engine_frame_t *frame)
+{
+    frame->submitted = false;
+    if (!deloader_depth_engine_supports_async())
+    {
+        // Compatibility with synchronous plugins, the frame is complete once submitted
+        frame->result = deloader_depth_engine_process_frame(context,
+                                                            frame->input_frame,
+                                                            frame->input_frame_size,
+                                                            frame->output_type,
+                                                            frame->output_frame,
+                                                            frame->output_frame_size,
+                                                            &frame->output_frame_info,
+                                                            NULL);
+        return K4A_DEPTH_ENGINE_RESULT_SUCCEEDED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    k4a_depth_engine_result_code_t result = global->plugin.depth_engine_submit_frame(context,
+                                                                                     frame->input_frame,
+                                                                                     frame->input_frame_size,
+                                                                                     frame->output_type,
+                                                                                     frame->output_frame,
+                                                                                     frame->output_frame_size,
+                                                                                     NULL);
+    frame->submitted = result == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED;
+    return result;
+}
+
+k4a_depth_engine_result_code_t deloader_depth_engine_poll_frame(k4a_depth_engine_context_t *context,
+                                                                deloader_depth_engine_frame_t *frame,
+                                                                bool *completed)
+{
+    if (!frame->submitted)
+    {
+        *completed = true;
+        return K4A_DEPTH_ENGINE_RESULT_SUCCEEDED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return global->plugin.depth_engine_poll_frame(context, completed);
+}
+
+k4a_depth_engine_result_code_t deloader_depth_engine_complete_frame(k4a_depth_engine_context_t *context,
+                                                                    deloader_depth_engine_frame_t *frame)
+{
+    if (!frame->submitted)
+    {
+        return frame->result;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    void *output_frame = NULL;
+    frame->result = global->plugin.depth_engine_complete_frame(context, &output_frame, &frame->output_frame_info);
+    frame->submitted = false;
+    if (frame->result == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED && output_frame != frame->output_frame)
+    {
+        LOG_ERROR("Depth engine completed frames out of order", 0);
+        frame->result = K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_INTERNAL;
+    }
+    return frame->result;
+}
+
 k4a_depth_engine_result_code_t deloader_transform_engine_create_and_initialize(k4a_transform_engine_context_t **context,
                                                                                void *camera_calibration,
                                                                                k4a_processing_complete_cb_t *callback,
@@ -253,12 +967,143 @@ void deloader_transform_engine_destroy(k4a_transform_engine_context_t **context)
     global->plugin.transform_engine_destroy(context);
 }
 
+bool deloader_get_gpu_export_type(k4a_gpu_interop_type_t type, k4a_transform_engine_gpu_export_t *export_type)
+{
+    switch (type)
+    {
+    case K4A_GPU_INTEROP_TYPE_OPENGL_TEXTURE:
+        *export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_TEXTURE;
+        return true;
+
+    case K4A_GPU_INTEROP_TYPE_OPENGL_BUFFER:
+        *export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_BUFFER;
+        return true;
+
+    case K4A_GPU_INTEROP_TYPE_CUDA_EXTERNAL_MEMORY:
+        *export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_CUDA_EXTERNAL_MEMORY;
+        return true;
+
+    case K4A_GPU_INTEROP_TYPE_D3D11_SHARED_HANDLE:
+        *export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_D3D11_SHARED_HANDLE;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool deloader_transform_engine_supports_gpu_export(void)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    // Both entry points are optional, a plugin has to provide both to export outputs
+    return is_plugin_loaded(global) && global->plugin.transform_engine_process_frame_gpu != NULL &&
+           global->plugin.transform_engine_release_gpu_output != NULL;
+}
+
+k4a_depth_engine_result_code_t
+deloader_transform_engine_process_frame_gpu(k4a_transform_engine_context_t *context,
+                                            k4a_transform_engine_type_t type,
+                                            const void *depth_frame,
+                                            size_t depth_frame_size,
+                                            const void *frame2,
+                                            size_t frame2_size,
+                                            k4a_transform_engine_interpolation_t interpolation,
+                                            uint32_t invalid_value,
+                                            k4a_transform_engine_gpu_export_t export_type,
+                                            k4a_transform_engine_gpu_output_t *output)
+{
+    if (!deloader_transform_engine_supports_gpu_export())
+    {
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return global->plugin.transform_engine_process_frame_gpu(context,
+                                                             type,
+                                                             interpolation,
+                                                             invalid_value,
+                                                             depth_frame,
+                                                             depth_frame_size,
+                                                             frame2,
+                                                             frame2_size,
+                                                             export_type,
+                                                             output);
+}
+
+void deloader_transform_engine_release_gpu_output(k4a_transform_engine_context_t *context,
+                                                  k4a_transform_engine_gpu_export_t export_type,
+                                                  k4a_transform_engine_gpu_output_t *output)
+{
+    if (!deloader_transform_engine_supports_gpu_export())
+    {
+        return;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    global->plugin.transform_engine_release_gpu_output(context, export_type, output);
+}
+
+bool deloader_transform_engine_supports_gpu_input(void)
+{
+    deloader_global_context_t *global = deloader_global_context_t_get();
+
+    // The output is exported, so it is released with the entry point of the GPU export
+    return deloader_transform_engine_supports_gpu_export() &&
+           global->plugin.transform_engine_process_frame_gpu_input != NULL;
+}
+
+k4a_depth_engine_result_code_t
+deloader_transform_engine_process_frame_gpu_input(k4a_transform_engine_context_t *context,
+                                                  k4a_transform_engine_type_t type,
+                                                  k4a_transform_engine_gpu_export_t depth_export_type,
+                                                  const k4a_transform_engine_gpu_output_t *depth_input,
+                                                  const void *frame2,
+                                                  size_t frame2_size,
+                                                  k4a_transform_engine_interpolation_t interpolation,
+                                                  uint32_t invalid_value,
+                                                  k4a_transform_engine_gpu_export_t export_type,
+                                                  k4a_transform_engine_gpu_output_t *output)
+{
+    if (!deloader_transform_engine_supports_gpu_input())
+    {
+        return K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_ENGINE_NOT_LOADED;
+    }
+
+    deloader_global_context_t *global = deloader_global_context_t_get();
+    return global->plugin.transform_engine_process_frame_gpu_input(context,
+                                                                   type,
+                                                                   interpolation,
+                                                                   invalid_value,
+                                                                   depth_export_type,
+                                                                   depth_input,
+                                                                   frame2,
+                                                                   frame2_size,
+                                                                   export_type,
+                                                                   output);
+}
+
 void deloader_deinit(void)
 {
+    {
+        std::lock_guard<std::mutex> lock(g_preload_lock);
+        if (g_preload_thread != NULL)
+        {
+            int thread_result;
+            (void)ThreadAPI_Join(g_preload_thread, &thread_result);
+            g_preload_thread = NULL;
+        }
+    }
+
     deloader_global_context_t *global = deloader_global_context_t_get();
 
     if (global->handle)
     {
         dynlib_destroy(global->handle);
     }
+
+    delete global->gpu_lock;
+    global->gpu_lock = NULL;
+    delete global->shared_engines;
+    global->shared_engines = NULL;
 }
@@ -11,6 +11,7 @@
 
 // Dependent libraries
 #include <k4ainternal/common.h>
+#include <k4ainternal/depthfilter.h>
 #include <k4ainternal/dewrapper.h>
 
 // System dependencies
@@ -46,6 +47,9 @@ typedef struct _depth_context_t
 
     depth_cb_streaming_capture_t *capture_ready_cb;
     void *capture_ready_cb_context;
+
+    uint32_t frame_decimation; // Set with depth_set_frame_decimation(), 0 or 1 to process every raw frame
+    uint32_t frame_counter;    // Raw frames received since depth_start(), only touched by the streaming callback
 } depth_context_t;
 
 K4A_DECLARE_CONTEXT(depth_t, depth_context_t);
@@ -166,6 +170,12 @@ k4a_result_t depth_create(depthmcu_t depthmcu,
         result = K4A_RESULT_FROM_BOOL(depth->dewrapper != NULL);
     }
 
+    if (K4A_SUCCEEDED(result))
+    {
+        // Keep the depth buffers on the NUMA node of the USB controller the raw frames arrive on
+        dewrapper_set_numa_node(depth->dewrapper, depthmcu_get_numa_node(depthmcu));
+    }
+
     if (K4A_SUCCEEDED(result))
     {
         // SDK may have crashed last session, so call stop
@@ -268,6 +278,18 @@ void depth_capture_available(k4a_result_t cb_result, k4a_image_t image_raw, void
     depth_context_t *depth = (depth_context_t *)context;
     k4a_capture_t capture_raw = NULL;
 
+    // Decimated raw frames are dropped before a capture is allocated or the depth engine sees them. Errors are still
+    // posted so the dewrapper stops on them.
+    if (K4A_SUCCEEDED(cb_result) && depth->frame_decimation > 1)
+    {
+        uint32_t frame = depth->frame_counter;
+        depth->frame_counter = frame + 1 < depth->frame_decimation ? frame + 1 : 0;
+        if (frame != 0)
+        {
+            return;
+        }
+    }
+
     if (K4A_SUCCEEDED(cb_result))
     {
         cb_result = TRACE_CALL(capture_create(&capture_raw));
@@ -405,6 +427,8 @@ k4a_result_t depth_start(depth_t depth_handle, const k4a_device_configuration_t
 
     if (K4A_SUCCEEDED(result))
     {
+        // The first raw frame of the stream is processed
+        depth->frame_counter = 0;
         result = TRACE_CALL(depthmcu_depth_start_streaming(depth->depthmcu, depth_capture_available, depth));
     }
 
@@ -416,6 +440,214 @@ k4a_result_t depth_start(depth_t depth_handle, const k4a_device_configuration_t
     return result;
 }
 
+k4a_result_t depth_reconfigure(depth_t depth_handle, const k4a_device_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (!depth->running)
+    {
+        LOG_ERROR("The depth sensor can only be reconfigured while it is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // Only the stream is stopped, the sensor stays on and the depth engine thread is kept for the new mode
+    bool quiet = false;
+    depthmcu_depth_stop_streaming(depth->depthmcu, quiet);
+
+    k4a_result_t result = TRACE_CALL(depthmcu_depth_set_capture_mode(depth->depthmcu, config->depth_mode));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // As in depth_start, the depth engine restarts after the mode is set in the sensor
+        result = TRACE_CALL(dewrapper_restart(depth->dewrapper, config));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(depthmcu_depth_set_fps(depth->depthmcu, config->camera_fps));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        depth->frame_counter = 0;
+        result = TRACE_CALL(depthmcu_depth_start_streaming(depth->depthmcu, depth_capture_available, depth));
+    }
+
+    if (K4A_FAILED(result))
+    {
+        depth_stop(depth_handle);
+    }
+
+    return result;
+}
+
+k4a_result_t depth_set_depth_engine_gpu(depth_t depth_handle, int32_t gpu_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The depth engine GPU can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_depth_engine_gpu(depth->dewrapper, gpu_index);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_engine_shared(depth_t depth_handle, bool shared)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("Depth engine sharing can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_depth_engine_shared(depth->dewrapper, shared);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_engine_keep_alive(depth_t depth_handle, bool keep_alive)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("Depth engine keep alive can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_keep_depth_engine(depth->dewrapper, keep_alive);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_filter(depth_t depth_handle, const k4a_depth_filter_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The depth filter can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (config != NULL && K4A_FAILED(TRACE_CALL(depthfilter_validate_configuration(config))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_depth_filter(depth->dewrapper, config);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_gpu_export(depth_t depth_handle, const k4a_depth_gpu_export_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The depth GPU export can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (config != NULL &&
+        (config->type < K4A_GPU_INTEROP_TYPE_OPENGL_TEXTURE || config->type > K4A_GPU_INTEROP_TYPE_D3D11_SHARED_HANDLE))
+    {
+        LOG_ERROR("Unexpected GPU interop type %d.", config->type);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_depth_gpu_export(depth->dewrapper, config);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_only(depth_t depth_handle, bool depth_only)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("Depth only output can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_depth_only(depth->dewrapper, depth_only);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_ir8_output(depth_t depth_handle, const k4a_ir8_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The IR output can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (config != NULL && K4A_FAILED(TRACE_CALL(depthfilter_validate_ir8_configuration(config))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_ir8_output(depth->dewrapper, config);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_frame_decimation(depth_t depth_handle, uint32_t decimation)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The depth frame decimation can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    depth->frame_decimation = decimation;
+    dewrapper_set_frame_decimation(depth->dewrapper, decimation);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_set_depth_engine_overload_policy(depth_t depth_handle,
+                                                    const k4a_depth_engine_overload_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    if (depth->running)
+    {
+        LOG_ERROR("The depth engine overload policy can't be changed while the depth sensor is running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    dewrapper_set_overload_policy(depth->dewrapper, config);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t depth_get_depth_engine_stats(depth_t depth_handle, dewrapper_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depth_t, depth_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    depth_context_t *depth = depth_t_get_context(depth_handle);
+
+    dewrapper_get_stats(depth->dewrapper, stats);
+    return K4A_RESULT_SUCCEEDED;
+}
+
 void depth_stop(depth_t depth_handle)
 {
     bool quiet = false;
@@ -323,13 +323,28 @@ k4a_result_t depthmcu_depth_start_streaming(depthmcu_t depthmcu_handle,
     depthmcu->callback = callback;
     depthmcu->callback_context = callback_context;
 
-    // Send start sensor command (Note, sensor MUST be in the ON state)
-    result = TRACE_CALL(usb_cmd_write(depthmcu->usb_cmd, DEV_CMD_DEPTH_START, NULL, 0, NULL, 0));
+    // Send the start sensor and start streaming commands back to back (Note, sensor MUST be in the ON state)
+    usb_cmd_batch_t batch = NULL;
+    result = TRACE_CALL(usb_cmd_batch_create(depthmcu->usb_cmd, &batch));
 
     if (K4A_SUCCEEDED(result))
     {
-        // Send start streaming command (Note, sensor MUST be in the ON state)
-        result = TRACE_CALL(usb_cmd_write(depthmcu->usb_cmd, DEV_CMD_DEPTH_STREAM_START, NULL, 0, NULL, 0));
+        result = TRACE_CALL(usb_cmd_batch_add_write(batch, DEV_CMD_DEPTH_START, NULL, 0, NULL, 0, NULL));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(usb_cmd_batch_add_write(batch, DEV_CMD_DEPTH_STREAM_START, NULL, 0, NULL, 0, NULL));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(usb_cmd_batch_execute(batch));
+    }
+
+    if (batch)
+    {
+        usb_cmd_batch_destroy(batch);
     }
 
     if (K4A_SUCCEEDED(result))
@@ -376,6 +391,22 @@ void depthmcu_depth_stop_streaming(depthmcu_t depthmcu_handle, bool quiet)
     }
 }
 
+k4a_result_t depthmcu_depth_get_usb_stream_stats(depthmcu_t depthmcu_handle, k4a_usb_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depthmcu_t, depthmcu_handle);
+    depthmcu_context_t *depthmcu = depthmcu_t_get_context(depthmcu_handle);
+
+    return TRACE_CALL(usb_cmd_get_stream_stats(depthmcu->usb_cmd, stats));
+}
+
+int depthmcu_get_numa_node(depthmcu_t depthmcu_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(-1, depthmcu_t, depthmcu_handle);
+    depthmcu_context_t *depthmcu = depthmcu_t_get_context(depthmcu_handle);
+
+    return usb_cmd_get_numa_node(depthmcu->usb_cmd);
+}
+
 k4a_result_t depthmcu_get_cal(depthmcu_t depthmcu_handle, uint8_t *calibration, size_t cal_size, size_t *bytes_read)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, depthmcu_t, depthmcu_handle);
@@ -0,0 +1,1312 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library filters the depth images of the depth engine
+#include <k4ainternal/depthfilter.h>
+
+// Dependent libraries
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/simd.h>
+#include <k4ainternal/threadpool.h>
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+
+// Number of pixels the SSE4.1 and NEON kernels process per iteration, the AVX2 and AVX-512 kernels process two and four
+// times as many
+#define DEPTHFILTER_GROUP_SIZE (8)
+
+// Shift from a depth to its bin of the depth statistics, log2 of K4A_DEPTH_STATISTICS_BIN_WIDTH_MM
+#define DEPTHFILTER_STATISTICS_BIN_SHIFT (9)
+
+typedef enum
+{
+    DEPTHFILTER_STAGE_EDGE = 0,
+    DEPTHFILTER_STAGE_TEMPORAL,
+    DEPTHFILTER_STAGE_HOLE_FILL,
+} depthfilter_stage_t;
+
+struct _depthfilter_context_t;
+
+// Vectorized kernels of the instruction set selected by simd_get_level(), each filters the start of a row and returns
+// the first column it did not filter. NULL where only the scalar kernels run.
+typedef struct _depthfilter_kernels_t
+{
+    int (*edge_row)(const uint16_t *above,
+                    const uint16_t *row,
+                    const uint16_t *below,
+                    uint16_t *output,
+                    int width,
+                    uint16_t threshold);
+    int (*temporal_row)(uint16_t *row, uint16_t *history, int width, uint16_t weight, uint16_t threshold);
+    int (*hole_fill_row)(const uint16_t *above,
+                         const uint16_t *row,
+                         const uint16_t *below,
+                         uint16_t *output,
+                         int width);
+} depthfilter_kernels_t;
+
+// Statistics of the pixels of an image processed so far
+typedef struct _depthfilter_statistics_sum_t
+{
+    uint64_t total;         // Sum of the depths
+    uint16_t min_minus_one; // Smallest valid depth minus 1, invalid pixels wrap to UINT16_MAX and never win
+    uint16_t max;
+    uint32_t histogram[K4A_DEPTH_STATISTICS_HISTOGRAM_BINS];
+} depthfilter_statistics_sum_t;
+
+// Vectorized statistics kernel, adds the start of a row to the sum and returns the first column it did not add. The 32
+// bit lanes of the kernels can't overflow for rows narrower than 262144 pixels.
+typedef int(depthfilter_statistics_row_t)(const uint16_t *row, int width, depthfilter_statistics_sum_t *sum);
+
+// Groups of pixels the vectorized statistics kernels count in 8 bit lanes before adding the lanes to the histogram
+#define DEPTHFILTER_STATISTICS_CHUNK_GROUPS (255)
+
+// Shift from an IR value to its bin of the histogram the tone mapping percentiles are taken from
+#define DEPTHFILTER_IR8_HISTOGRAM_SHIFT (4)
+#define DEPTHFILTER_IR8_HISTOGRAM_BINS ((UINT16_MAX >> DEPTHFILTER_IR8_HISTOGRAM_SHIFT) + 1)
+
+// Linear map of IR values to 8 bits, min(max(ir - low, 0), range) * scale / 65536. The scale is split in 16 bit halves
+// so the vectorized kernels multiply in 16 bit lanes; range * scale stays below 2^24, so the product of the high half
+// fits in 16 bits.
+typedef struct _depthfilter_tone_map_t
+{
+    uint16_t low;
+    uint16_t range;
+    uint16_t scale_high;
+    uint16_t scale_low;
+} depthfilter_tone_map_t;
+
+// Vectorized tone mapping kernel, maps the start of a row and returns the first column it did not map
+typedef int(depthfilter_tone_map_row_t)(const uint16_t *row,
+                                        uint8_t *output,
+                                        int width,
+                                        const depthfilter_tone_map_t *map);
+
+// Rows [first_row, last_row) of the image that one thread filters
+typedef struct _depthfilter_band_t
+{
+    struct _depthfilter_context_t *context;
+    depthfilter_stage_t stage;
+    uint16_t *depth_image;
+    int first_row;
+    int last_row;
+} depthfilter_band_t;
+
+typedef struct _depthfilter_context_t
+{
+    k4a_depth_filter_configuration_t config;
+    int width;
+    int height;
+    uint16_t temporal_weight; // Weight of the new image in the temporal filter, in 1/65536
+    depthfilter_kernels_t kernels;
+
+    uint16_t *scratch;  // Copy of the image the edge and hole filters read while writing the image
+    uint16_t *history;  // Previous output of the temporal filter, 0 where no depth was known
+    uint16_t *zero_row; // Neighbors of the first and last row
+
+    uint32_t band_count;
+    bool threadpool_acquired; // Held while band_count is above 1
+    depthfilter_band_t bands[DEPTHFILTER_MAX_THREAD_COUNT];
+} depthfilter_context_t;
+
+K4A_DECLARE_CONTEXT(depthfilter_t, depthfilter_context_t);
+
+static inline uint16_t depthfilter_abs_diff(uint16_t a, uint16_t b)
+{
+    return (uint16_t)(a > b ? a - b : b - a);
+}
+
+static inline bool depthfilter_is_edge(uint16_t depth, uint16_t neighbor, uint16_t threshold)
+{
+    return neighbor != 0 && depthfilter_abs_diff(depth, neighbor) > threshold;
+}
+
+static inline uint16_t depthfilter_max(uint16_t a, uint16_t b)
+{
+    return a > b ? a : b;
+}
+
+// Filters pixels [first, last) of a row with the scalar kernels; columns outside the image count as invalid
+static void depthfilter_edge_pixels(const uint16_t *above,
+                                    const uint16_t *row,
+                                    const uint16_t *below,
+                                    uint16_t *output,
+                                    int width,
+                                    int first,
+                                    int last,
+                                    uint16_t threshold)
+{
+    for (int x = first; x < last; x++)
+    {
+        uint16_t depth = row[x];
+        uint16_t left = x > 0 ? row[x - 1] : 0;
+        uint16_t right = x < width - 1 ? row[x + 1] : 0;
+        bool edge = depthfilter_is_edge(depth, left, threshold) || depthfilter_is_edge(depth, right, threshold) ||
+                    depthfilter_is_edge(depth, above[x], threshold) || depthfilter_is_edge(depth, below[x], threshold);
+        output[x] = edge ? (uint16_t)0 : depth;
+    }
+}
+
+static void depthfilter_temporal_pixels(uint16_t *row,
+                                        uint16_t *history,
+                                        int first,
+                                        int last,
+                                        uint16_t weight,
+                                        uint16_t threshold)
+{
+    uint32_t previous_weight = 65536u - weight;
+    for (int x = first; x < last; x++)
+    {
+        uint16_t depth = row[x];
+        uint16_t previous = history[x];
+        if (depth != 0 && previous != 0 && depthfilter_abs_diff(depth, previous) <= threshold)
+        {
+            depth = (uint16_t)(((uint32_t)depth * weight + (uint32_t)previous * previous_weight + 32768u) >> 16);
+        }
+        row[x] = depth;
+        history[x] = depth;
+    }
+}
+
+static void depthfilter_hole_fill_pixels(const uint16_t *above,
+                                         const uint16_t *row,
+                                         const uint16_t *below,
+                                         uint16_t *output,
+                                         int width,
+                                         int first,
+                                         int last)
+{
+    for (int x = first; x < last; x++)
+    {
+        uint16_t depth = row[x];
+        if (depth == 0)
+        {
+            uint16_t left = x > 0 ? row[x - 1] : 0;
+            uint16_t right = x < width - 1 ? row[x + 1] : 0;
+            depth = depthfilter_max(depthfilter_max(left, right), depthfilter_max(above[x], below[x]));
+        }
+        output[x] = depth;
+    }
+}
+
+static void depthfilter_statistics_pixels(const uint16_t *row, int first, int last, depthfilter_statistics_sum_t *sum)
+{
+    for (int x = first; x < last; x++)
+    {
+        uint16_t depth = row[x];
+        if (depth != 0)
+        {
+            int bin = depth >> DEPTHFILTER_STATISTICS_BIN_SHIFT;
+            sum->histogram[bin < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS ? bin : K4A_DEPTH_STATISTICS_HISTOGRAM_BINS - 1]++;
+            sum->total += depth;
+            sum->max = depthfilter_max(sum->max, depth);
+            sum->min_minus_one = depth - 1 < sum->min_minus_one ? (uint16_t)(depth - 1) : sum->min_minus_one;
+        }
+    }
+}
+
+static inline void depthfilter_statistics_add_extremes(depthfilter_statistics_sum_t *sum,
+                                                       uint16_t min_minus_one,
+                                                       uint16_t max)
+{
+    sum->max = depthfilter_max(sum->max, max);
+    sum->min_minus_one = min_minus_one < sum->min_minus_one ? min_minus_one : sum->min_minus_one;
+}
+
+static void depthfilter_tone_map_pixels(const uint16_t *row,
+                                        uint8_t *output,
+                                        int first,
+                                        int last,
+                                        const depthfilter_tone_map_t *map)
+{
+    uint32_t scale = ((uint32_t)map->scale_high << 16) | map->scale_low;
+    for (int x = first; x < last; x++)
+    {
+        uint32_t value = row[x] > map->low ? (uint32_t)(row[x] - map->low) : 0;
+        value = value < map->range ? value : map->range;
+        output[x] = (uint8_t)((value * scale) >> 16);
+    }
+}
+
+// The vectorized statistics kernels compute the bin of each pixel in 8 bit lanes, 255 for invalid pixels, and count
+// each bin by comparing every lane with it. Chunks of DEPTHFILTER_STATISTICS_CHUNK_GROUPS keep the counts in 8 bits.
+// The vectorized kernels cover the columns whose left and right neighbors are in the image and return the first column
+// they did not filter. The first column and the remaining columns are filtered by the scalar kernels.
+#if defined(K4A_USING_SSE)
+
+static int depthfilter_edge_row_sse41(const uint16_t *above,
+                                      const uint16_t *row,
+                                      const uint16_t *below,
+                                      uint16_t *output,
+                                      int width,
+                                      uint16_t threshold)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i threshold_x8 = _mm_set1_epi16((short)threshold);
+
+    int x = 1;
+    for (; x + DEPTHFILTER_GROUP_SIZE < width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        __m128i depth = _mm_loadu_si128((const __m128i *)(row + x));
+        __m128i neighbors[4] = { _mm_loadu_si128((const __m128i *)(row + x - 1)),
+                                 _mm_loadu_si128((const __m128i *)(row + x + 1)),
+                                 _mm_loadu_si128((const __m128i *)(above + x)),
+                                 _mm_loadu_si128((const __m128i *)(below + x)) };
+
+        // A pixel is kept while every neighbor is invalid or within the threshold
+        __m128i keep = _mm_set1_epi16(-1);
+        for (int i = 0; i < 4; i++)
+        {
+            __m128i diff = _mm_or_si128(_mm_subs_epu16(depth, neighbors[i]), _mm_subs_epu16(neighbors[i], depth));
+            __m128i within = _mm_cmpeq_epi16(_mm_subs_epu16(diff, threshold_x8), zero);
+            __m128i invalid = _mm_cmpeq_epi16(neighbors[i], zero);
+            keep = _mm_and_si128(keep, _mm_or_si128(within, invalid));
+        }
+        _mm_storeu_si128((__m128i *)(output + x), _mm_and_si128(keep, depth));
+    }
+    return x;
+}
+
+static int depthfilter_temporal_row_sse41(uint16_t *row,
+                                          uint16_t *history,
+                                          int width,
+                                          uint16_t weight,
+                                          uint16_t threshold)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i threshold_x8 = _mm_set1_epi16((short)threshold);
+    const __m128i weight_x8 = _mm_set1_epi16((short)weight);
+    const __m128i previous_weight_x8 = _mm_set1_epi16((short)(65536u - weight));
+    const __m128i round = _mm_set1_epi32(32768);
+
+    int x = 0;
+    for (; x + DEPTHFILTER_GROUP_SIZE <= width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        __m128i depth = _mm_loadu_si128((const __m128i *)(row + x));
+        __m128i previous = _mm_loadu_si128((const __m128i *)(history + x));
+
+        __m128i diff = _mm_or_si128(_mm_subs_epu16(depth, previous), _mm_subs_epu16(previous, depth));
+        __m128i within = _mm_cmpeq_epi16(_mm_subs_epu16(diff, threshold_x8), zero);
+        __m128i invalid = _mm_or_si128(_mm_cmpeq_epi16(depth, zero), _mm_cmpeq_epi16(previous, zero));
+        __m128i smooth = _mm_andnot_si128(invalid, within);
+
+        // 32 bit products from the low and high halves of the 16 bit products
+        __m128i depth_lo = _mm_mullo_epi16(depth, weight_x8);
+        __m128i depth_hi = _mm_mulhi_epu16(depth, weight_x8);
+        __m128i previous_lo = _mm_mullo_epi16(previous, previous_weight_x8);
+        __m128i previous_hi = _mm_mulhi_epu16(previous, previous_weight_x8);
+        __m128i sum_lo = _mm_add_epi32(_mm_unpacklo_epi16(depth_lo, depth_hi),
+                                       _mm_unpacklo_epi16(previous_lo, previous_hi));
+        __m128i sum_hi = _mm_add_epi32(_mm_unpackhi_epi16(depth_lo, depth_hi),
+                                       _mm_unpackhi_epi16(previous_lo, previous_hi));
+        sum_lo = _mm_srli_epi32(_mm_add_epi32(sum_lo, round), 16);
+        sum_hi = _mm_srli_epi32(_mm_add_epi32(sum_hi, round), 16);
+        __m128i blended = _mm_packus_epi32(sum_lo, sum_hi);
+
+        __m128i result = _mm_blendv_epi8(depth, blended, smooth);
+        _mm_storeu_si128((__m128i *)(row + x), result);
+        _mm_storeu_si128((__m128i *)(history + x), result);
+    }
+    return x;
+}
+
+static int depthfilter_hole_fill_row_sse41(const uint16_t *above,
+                                           const uint16_t *row,
+                                           const uint16_t *below,
+                                           uint16_t *output,
+                                           int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 1;
+    for (; x + DEPTHFILTER_GROUP_SIZE < width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        __m128i depth = _mm_loadu_si128((const __m128i *)(row + x));
+        __m128i farthest = _mm_max_epu16(_mm_max_epu16(_mm_loadu_si128((const __m128i *)(row + x - 1)),
+                                                       _mm_loadu_si128((const __m128i *)(row + x + 1))),
+                                         _mm_max_epu16(_mm_loadu_si128((const __m128i *)(above + x)),
+                                                       _mm_loadu_si128((const __m128i *)(below + x))));
+        __m128i hole = _mm_cmpeq_epi16(depth, zero);
+        _mm_storeu_si128((__m128i *)(output + x), _mm_or_si128(depth, _mm_and_si128(hole, farthest)));
+    }
+    return x;
+}
+
+static int depthfilter_statistics_row_sse41(const uint16_t *row, int width, depthfilter_statistics_sum_t *sum)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i last_bin = _mm_set1_epi16(K4A_DEPTH_STATISTICS_HISTOGRAM_BINS - 1);
+    __m128i min_minus_one = _mm_set1_epi16(-1);
+    __m128i max = zero;
+    __m128i total = zero;
+
+    int x = 0;
+    while (x + 2 * DEPTHFILTER_GROUP_SIZE <= width)
+    {
+        __m128i counts[K4A_DEPTH_STATISTICS_HISTOGRAM_BINS];
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            counts[i] = zero;
+        }
+
+        for (int group = 0; group < DEPTHFILTER_STATISTICS_CHUNK_GROUPS && x + 2 * DEPTHFILTER_GROUP_SIZE <= width;
+             group++, x += 2 * DEPTHFILTER_GROUP_SIZE)
+        {
+            __m128i depth[2] = { _mm_loadu_si128((const __m128i *)(row + x)),
+                                 _mm_loadu_si128((const __m128i *)(row + x + DEPTHFILTER_GROUP_SIZE)) };
+            __m128i bin[2];
+            for (int half = 0; half < 2; half++)
+            {
+                min_minus_one = _mm_min_epu16(min_minus_one, _mm_sub_epi16(depth[half], _mm_set1_epi16(1)));
+                max = _mm_max_epu16(max, depth[half]);
+                total = _mm_add_epi32(total,
+                                      _mm_add_epi32(_mm_unpacklo_epi16(depth[half], zero),
+                                                    _mm_unpackhi_epi16(depth[half], zero)));
+                bin[half] = _mm_or_si128(_mm_min_epu16(_mm_srli_epi16(depth[half], DEPTHFILTER_STATISTICS_BIN_SHIFT),
+                                                       last_bin),
+                                         _mm_srli_epi16(_mm_cmpeq_epi16(depth[half], zero), 8));
+            }
+
+            __m128i bins = _mm_packus_epi16(bin[0], bin[1]);
+            for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+            {
+                counts[i] = _mm_sub_epi8(counts[i], _mm_cmpeq_epi8(bins, _mm_set1_epi8((char)i)));
+            }
+        }
+
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            __m128i count = _mm_sad_epu8(counts[i], zero);
+            sum->histogram[i] += (uint32_t)(_mm_cvtsi128_si32(count) + _mm_extract_epi16(count, 4));
+        }
+    }
+
+    uint32_t totals[4];
+    _mm_storeu_si128((__m128i *)totals, total);
+    sum->total += (uint64_t)totals[0] + totals[1] + totals[2] + totals[3];
+
+    // The maximum is the complement of the minimum of the complements
+    depthfilter_statistics_add_extremes(sum,
+                                        (uint16_t)_mm_cvtsi128_si32(_mm_minpos_epu16(min_minus_one)),
+                                        (uint16_t)~_mm_cvtsi128_si32(
+                                            _mm_minpos_epu16(_mm_xor_si128(max, _mm_set1_epi16(-1)))));
+    return x;
+}
+
+static int
+depthfilter_tone_map_row_sse41(const uint16_t *row, uint8_t *output, int width, const depthfilter_tone_map_t *map)
+{
+    const __m128i low = _mm_set1_epi16((short)map->low);
+    const __m128i range = _mm_set1_epi16((short)map->range);
+    const __m128i scale_high = _mm_set1_epi16((short)map->scale_high);
+    const __m128i scale_low = _mm_set1_epi16((short)map->scale_low);
+
+    int x = 0;
+    for (; x + 2 * DEPTHFILTER_GROUP_SIZE <= width; x += 2 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m128i mapped[2];
+        for (int half = 0; half < 2; half++)
+        {
+            __m128i ir = _mm_loadu_si128((const __m128i *)(row + x + half * DEPTHFILTER_GROUP_SIZE));
+            __m128i value = _mm_min_epu16(_mm_subs_epu16(ir, low), range);
+            mapped[half] = _mm_add_epi16(_mm_mullo_epi16(value, scale_high), _mm_mulhi_epu16(value, scale_low));
+        }
+        _mm_storeu_si128((__m128i *)(output + x), _mm_packus_epi16(mapped[0], mapped[1]));
+    }
+    return x;
+}
+
+#endif
+
+#if defined(K4A_USING_AVX)
+
+SIMD_TARGET_AVX2 static int depthfilter_edge_row_avx2(const uint16_t *above,
+                                                      const uint16_t *row,
+                                                      const uint16_t *below,
+                                                      uint16_t *output,
+                                                      int width,
+                                                      uint16_t threshold)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i threshold_x16 = _mm256_set1_epi16((short)threshold);
+
+    int x = 1;
+    for (; x + 2 * DEPTHFILTER_GROUP_SIZE < width; x += 2 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m256i depth = _mm256_loadu_si256((const __m256i *)(row + x));
+        __m256i neighbors[4] = { _mm256_loadu_si256((const __m256i *)(row + x - 1)),
+                                 _mm256_loadu_si256((const __m256i *)(row + x + 1)),
+                                 _mm256_loadu_si256((const __m256i *)(above + x)),
+                                 _mm256_loadu_si256((const __m256i *)(below + x)) };
+
+        // A pixel is kept while every neighbor is invalid or within the threshold
+        __m256i keep = _mm256_set1_epi16(-1);
+        for (int i = 0; i < 4; i++)
+        {
+            __m256i diff = _mm256_or_si256(_mm256_subs_epu16(depth, neighbors[i]),
+                                           _mm256_subs_epu16(neighbors[i], depth));
+            __m256i within = _mm256_cmpeq_epi16(_mm256_subs_epu16(diff, threshold_x16), zero);
+            __m256i invalid = _mm256_cmpeq_epi16(neighbors[i], zero);
+            keep = _mm256_and_si256(keep, _mm256_or_si256(within, invalid));
+        }
+        _mm256_storeu_si256((__m256i *)(output + x), _mm256_and_si256(keep, depth));
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX2 static int
+depthfilter_temporal_row_avx2(uint16_t *row, uint16_t *history, int width, uint16_t weight, uint16_t threshold)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i threshold_x16 = _mm256_set1_epi16((short)threshold);
+    const __m256i weight_x16 = _mm256_set1_epi16((short)weight);
+    const __m256i previous_weight_x16 = _mm256_set1_epi16((short)(65536u - weight));
+    const __m256i round = _mm256_set1_epi32(32768);
+
+    int x = 0;
+    for (; x + 2 * DEPTHFILTER_GROUP_SIZE <= width; x += 2 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m256i depth = _mm256_loadu_si256((const __m256i *)(row + x));
+        __m256i previous = _mm256_loadu_si256((const __m256i *)(history + x));
+
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu16(depth, previous), _mm256_subs_epu16(previous, depth));
+        __m256i within = _mm256_cmpeq_epi16(_mm256_subs_epu16(diff, threshold_x16), zero);
+        __m256i invalid = _mm256_or_si256(_mm256_cmpeq_epi16(depth, zero), _mm256_cmpeq_epi16(previous, zero));
+        __m256i smooth = _mm256_andnot_si256(invalid, within);
+
+        // The unpacks and the pack work within each 128 bit lane, so the pixels come back in order
+        __m256i depth_lo = _mm256_mullo_epi16(depth, weight_x16);
+        __m256i depth_hi = _mm256_mulhi_epu16(depth, weight_x16);
+        __m256i previous_lo = _mm256_mullo_epi16(previous, previous_weight_x16);
+        __m256i previous_hi = _mm256_mulhi_epu16(previous, previous_weight_x16);
+        __m256i sum_lo = _mm256_add_epi32(_mm256_unpacklo_epi16(depth_lo, depth_hi),
+                                          _mm256_unpacklo_epi16(previous_lo, previous_hi));
+        __m256i sum_hi = _mm256_add_epi32(_mm256_unpackhi_epi16(depth_lo, depth_hi),
+                                          _mm256_unpackhi_epi16(previous_lo, previous_hi));
+        sum_lo = _mm256_srli_epi32(_mm256_add_epi32(sum_lo, round), 16);
+        sum_hi = _mm256_srli_epi32(_mm256_add_epi32(sum_hi, round), 16);
+        __m256i blended = _mm256_packus_epi32(sum_lo, sum_hi);
+
+        __m256i result = _mm256_blendv_epi8(depth, blended, smooth);
+        _mm256_storeu_si256((__m256i *)(row + x), result);
+        _mm256_storeu_si256((__m256i *)(history + x), result);
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX2 static int depthfilter_hole_fill_row_avx2(const uint16_t *above,
+                                                           const uint16_t *row,
+                                                           const uint16_t *below,
+                                                           uint16_t *output,
+                                                           int width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    int x = 1;
+    for (; x + 2 * DEPTHFILTER_GROUP_SIZE < width; x += 2 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m256i depth = _mm256_loadu_si256((const __m256i *)(row + x));
+        __m256i farthest = _mm256_max_epu16(_mm256_max_epu16(_mm256_loadu_si256((const __m256i *)(row + x - 1)),
+                                                             _mm256_loadu_si256((const __m256i *)(row + x + 1))),
+                                            _mm256_max_epu16(_mm256_loadu_si256((const __m256i *)(above + x)),
+                                                             _mm256_loadu_si256((const __m256i *)(below + x))));
+        __m256i hole = _mm256_cmpeq_epi16(depth, zero);
+        _mm256_storeu_si256((__m256i *)(output + x), _mm256_or_si256(depth, _mm256_and_si256(hole, farthest)));
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX2 static int
+depthfilter_statistics_row_avx2(const uint16_t *row, int width, depthfilter_statistics_sum_t *sum)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i last_bin = _mm256_set1_epi16(K4A_DEPTH_STATISTICS_HISTOGRAM_BINS - 1);
+    __m256i min_minus_one = _mm256_set1_epi16(-1);
+    __m256i max = zero;
+    __m256i total = zero;
+
+    int x = 0;
+    while (x + 4 * DEPTHFILTER_GROUP_SIZE <= width)
+    {
+        __m256i counts[K4A_DEPTH_STATISTICS_HISTOGRAM_BINS];
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            counts[i] = zero;
+        }
+
+        for (int group = 0; group < DEPTHFILTER_STATISTICS_CHUNK_GROUPS && x + 4 * DEPTHFILTER_GROUP_SIZE <= width;
+             group++, x += 4 * DEPTHFILTER_GROUP_SIZE)
+        {
+            __m256i depth[2] = { _mm256_loadu_si256((const __m256i *)(row + x)),
+                                 _mm256_loadu_si256((const __m256i *)(row + x + 2 * DEPTHFILTER_GROUP_SIZE)) };
+            __m256i bin[2];
+            for (int half = 0; half < 2; half++)
+            {
+                min_minus_one = _mm256_min_epu16(min_minus_one, _mm256_sub_epi16(depth[half], _mm256_set1_epi16(1)));
+                max = _mm256_max_epu16(max, depth[half]);
+                total = _mm256_add_epi32(total,
+                                         _mm256_add_epi32(_mm256_unpacklo_epi16(depth[half], zero),
+                                                          _mm256_unpackhi_epi16(depth[half], zero)));
+                bin[half] = _mm256_or_si256(
+                    _mm256_min_epu16(_mm256_srli_epi16(depth[half], DEPTHFILTER_STATISTICS_BIN_SHIFT), last_bin),
+                    _mm256_srli_epi16(_mm256_cmpeq_epi16(depth[half], zero), 8));
+            }
+
+            // The bins are counted in any order, so the interleaving of the 128 bit lanes by the packing doesn't matter
+            __m256i bins = _mm256_packus_epi16(bin[0], bin[1]);
+            for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+            {
+                counts[i] = _mm256_sub_epi8(counts[i], _mm256_cmpeq_epi8(bins, _mm256_set1_epi8((char)i)));
+            }
+        }
+
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            __m256i count64 = _mm256_sad_epu8(counts[i], zero);
+            __m128i count = _mm_add_epi64(_mm256_castsi256_si128(count64), _mm256_extracti128_si256(count64, 1));
+            sum->histogram[i] += (uint32_t)(_mm_cvtsi128_si32(count) + _mm_extract_epi16(count, 4));
+        }
+    }
+
+    uint32_t totals[8];
+    _mm256_storeu_si256((__m256i *)totals, total);
+    for (int lane = 0; lane < 8; lane++)
+    {
+        sum->total += totals[lane];
+    }
+
+    __m128i min_x8 = _mm_min_epu16(_mm256_castsi256_si128(min_minus_one), _mm256_extracti128_si256(min_minus_one, 1));
+    __m128i max_x8 = _mm_max_epu16(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+    depthfilter_statistics_add_extremes(sum,
+                                        (uint16_t)_mm_cvtsi128_si32(_mm_minpos_epu16(min_x8)),
+                                        (uint16_t)~_mm_cvtsi128_si32(
+                                            _mm_minpos_epu16(_mm_xor_si128(max_x8, _mm_set1_epi16(-1)))));
+    return x;
+}
+
+SIMD_TARGET_AVX2 static int
+depthfilter_tone_map_row_avx2(const uint16_t *row, uint8_t *output, int width, const depthfilter_tone_map_t *map)
+{
+    const __m256i low = _mm256_set1_epi16((short)map->low);
+    const __m256i range = _mm256_set1_epi16((short)map->range);
+    const __m256i scale_high = _mm256_set1_epi16((short)map->scale_high);
+    const __m256i scale_low = _mm256_set1_epi16((short)map->scale_low);
+
+    int x = 0;
+    for (; x + 4 * DEPTHFILTER_GROUP_SIZE <= width; x += 4 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m256i mapped[2];
+        for (int half = 0; half < 2; half++)
+        {
+            __m256i ir = _mm256_loadu_si256((const __m256i *)(row + x + half * 2 * DEPTHFILTER_GROUP_SIZE));
+            __m256i value = _mm256_min_epu16(_mm256_subs_epu16(ir, low), range);
+            mapped[half] = _mm256_add_epi16(_mm256_mullo_epi16(value, scale_high),
+                                            _mm256_mulhi_epu16(value, scale_low));
+        }
+
+        // The packing interleaves the 128 bit lanes of the two halves, the permutation puts the pixels back in order
+        __m256i packed = _mm256_packus_epi16(mapped[0], mapped[1]);
+        _mm256_storeu_si256((__m256i *)(output + x), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    return x;
+}
+
+// The AVX-512 kernels select pixels with mask registers instead of comparison vectors
+SIMD_TARGET_AVX512 static int depthfilter_edge_row_avx512(const uint16_t *above,
+                                                          const uint16_t *row,
+                                                          const uint16_t *below,
+                                                          uint16_t *output,
+                                                          int width,
+                                                          uint16_t threshold)
+{
+    const __m512i threshold_x32 = _mm512_set1_epi16((short)threshold);
+
+    int x = 1;
+    for (; x + 4 * DEPTHFILTER_GROUP_SIZE < width; x += 4 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m512i depth = _mm512_loadu_si512((const void *)(row + x));
+        __m512i neighbors[4] = { _mm512_loadu_si512((const void *)(row + x - 1)),
+                                 _mm512_loadu_si512((const void *)(row + x + 1)),
+                                 _mm512_loadu_si512((const void *)(above + x)),
+                                 _mm512_loadu_si512((const void *)(below + x)) };
+
+        // A pixel is kept while every neighbor is invalid or within the threshold
+        __mmask32 keep = 0xffffffff;
+        for (int i = 0; i < 4; i++)
+        {
+            __m512i diff = _mm512_or_si512(_mm512_subs_epu16(depth, neighbors[i]),
+                                           _mm512_subs_epu16(neighbors[i], depth));
+            keep &= _mm512_cmple_epu16_mask(diff, threshold_x32) | _mm512_testn_epi16_mask(neighbors[i], neighbors[i]);
+        }
+        _mm512_storeu_si512((void *)(output + x), _mm512_maskz_mov_epi16(keep, depth));
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX512 static int
+depthfilter_temporal_row_avx512(uint16_t *row, uint16_t *history, int width, uint16_t weight, uint16_t threshold)
+{
+    const __m512i threshold_x32 = _mm512_set1_epi16((short)threshold);
+    const __m512i weight_x32 = _mm512_set1_epi16((short)weight);
+    const __m512i previous_weight_x32 = _mm512_set1_epi16((short)(65536u - weight));
+    const __m512i round = _mm512_set1_epi32(32768);
+
+    int x = 0;
+    for (; x + 4 * DEPTHFILTER_GROUP_SIZE <= width; x += 4 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m512i depth = _mm512_loadu_si512((const void *)(row + x));
+        __m512i previous = _mm512_loadu_si512((const void *)(history + x));
+
+        __m512i diff = _mm512_or_si512(_mm512_subs_epu16(depth, previous), _mm512_subs_epu16(previous, depth));
+        __mmask32 smooth = _mm512_cmple_epu16_mask(diff, threshold_x32) & _mm512_test_epi16_mask(depth, depth) &
+                           _mm512_test_epi16_mask(previous, previous);
+
+        // The unpacks and the pack work within each 128 bit lane, so the pixels come back in order
+        __m512i depth_lo = _mm512_mullo_epi16(depth, weight_x32);
+        __m512i depth_hi = _mm512_mulhi_epu16(depth, weight_x32);
+        __m512i previous_lo = _mm512_mullo_epi16(previous, previous_weight_x32);
+        __m512i previous_hi = _mm512_mulhi_epu16(previous, previous_weight_x32);
+        __m512i sum_lo = _mm512_add_epi32(_mm512_unpacklo_epi16(depth_lo, depth_hi),
+                                          _mm512_unpacklo_epi16(previous_lo, previous_hi));
+        __m512i sum_hi = _mm512_add_epi32(_mm512_unpackhi_epi16(depth_lo, depth_hi),
+                                          _mm512_unpackhi_epi16(previous_lo, previous_hi));
+        sum_lo = _mm512_srli_epi32(_mm512_add_epi32(sum_lo, round), 16);
+        sum_hi = _mm512_srli_epi32(_mm512_add_epi32(sum_hi, round), 16);
+        __m512i blended = _mm512_packus_epi32(sum_lo, sum_hi);
+
+        __m512i result = _mm512_mask_mov_epi16(depth, smooth, blended);
+        _mm512_storeu_si512((void *)(row + x), result);
+        _mm512_storeu_si512((void *)(history + x), result);
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX512 static int depthfilter_hole_fill_row_avx512(const uint16_t *above,
+                                                               const uint16_t *row,
+                                                               const uint16_t *below,
+                                                               uint16_t *output,
+                                                               int width)
+{
+    int x = 1;
+    for (; x + 4 * DEPTHFILTER_GROUP_SIZE < width; x += 4 * DEPTHFILTER_GROUP_SIZE)
+    {
+        __m512i depth = _mm512_loadu_si512((const void *)(row + x));
+        __m512i farthest = _mm512_max_epu16(_mm512_max_epu16(_mm512_loadu_si512((const void *)(row + x - 1)),
+                                                             _mm512_loadu_si512((const void *)(row + x + 1))),
+                                            _mm512_max_epu16(_mm512_loadu_si512((const void *)(above + x)),
+                                                             _mm512_loadu_si512((const void *)(below + x))));
+        __mmask32 hole = _mm512_testn_epi16_mask(depth, depth);
+        _mm512_storeu_si512((void *)(output + x), _mm512_mask_mov_epi16(depth, hole, farthest));
+    }
+    return x;
+}
+
+#endif
+
+#if defined(K4A_USING_NEON)
+
+static int depthfilter_edge_row_neon(const uint16_t *above,
+                                     const uint16_t *row,
+                                     const uint16_t *below,
+                                     uint16_t *output,
+                                     int width,
+                                     uint16_t threshold)
+{
+    const uint16x8_t threshold_x8 = vdupq_n_u16(threshold);
+
+    int x = 1;
+    for (; x + DEPTHFILTER_GROUP_SIZE < width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        uint16x8_t depth = vld1q_u16(row + x);
+        uint16x8_t neighbors[4] = { vld1q_u16(row + x - 1),
+                                    vld1q_u16(row + x + 1),
+                                    vld1q_u16(above + x),
+                                    vld1q_u16(below + x) };
+
+        // A pixel is kept while every neighbor is invalid or within the threshold
+        uint16x8_t keep = vdupq_n_u16(0xffff);
+        for (int i = 0; i < 4; i++)
+        {
+            uint16x8_t within = vcleq_u16(vabdq_u16(depth, neighbors[i]), threshold_x8);
+            uint16x8_t valid = vtstq_u16(neighbors[i], neighbors[i]);
+            keep = vandq_u16(keep, vorrq_u16(within, vmvnq_u16(valid)));
+        }
+        vst1q_u16(output + x, vandq_u16(keep, depth));
+    }
+    return x;
+}
+
+static int depthfilter_temporal_row_neon(uint16_t *row,
+                                         uint16_t *history,
+                                         int width,
+                                         uint16_t weight,
+                                         uint16_t threshold)
+{
+    const uint16x8_t threshold_x8 = vdupq_n_u16(threshold);
+    const uint16x4_t weight_x4 = vdup_n_u16(weight);
+    const uint16x4_t previous_weight_x4 = vdup_n_u16((uint16_t)(65536u - weight));
+
+    int x = 0;
+    for (; x + DEPTHFILTER_GROUP_SIZE <= width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        uint16x8_t depth = vld1q_u16(row + x);
+        uint16x8_t previous = vld1q_u16(history + x);
+
+        uint16x8_t smooth = vandq_u16(vcleq_u16(vabdq_u16(depth, previous), threshold_x8),
+                                      vandq_u16(vtstq_u16(depth, depth), vtstq_u16(previous, previous)));
+
+        uint32x4_t sum_lo = vmlal_u16(vmull_u16(vget_low_u16(depth), weight_x4),
+                                      vget_low_u16(previous),
+                                      previous_weight_x4);
+        uint32x4_t sum_hi = vmlal_u16(vmull_u16(vget_high_u16(depth), weight_x4),
+                                      vget_high_u16(previous),
+                                      previous_weight_x4);
+        uint16x8_t blended = vcombine_u16(vrshrn_n_u32(sum_lo, 16), vrshrn_n_u32(sum_hi, 16));
+
+        uint16x8_t result = vbslq_u16(smooth, blended, depth);
+        vst1q_u16(row + x, result);
+        vst1q_u16(history + x, result);
+    }
+    return x;
+}
+
+static int depthfilter_hole_fill_row_neon(const uint16_t *above,
+                                          const uint16_t *row,
+                                          const uint16_t *below,
+                                          uint16_t *output,
+                                          int width)
+{
+    int x = 1;
+    for (; x + DEPTHFILTER_GROUP_SIZE < width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        uint16x8_t depth = vld1q_u16(row + x);
+        uint16x8_t farthest = vmaxq_u16(vmaxq_u16(vld1q_u16(row + x - 1), vld1q_u16(row + x + 1)),
+                                        vmaxq_u16(vld1q_u16(above + x), vld1q_u16(below + x)));
+        uint16x8_t hole = vceqq_u16(depth, vdupq_n_u16(0));
+        vst1q_u16(output + x, vorrq_u16(depth, vandq_u16(hole, farthest)));
+    }
+    return x;
+}
+
+static int depthfilter_statistics_row_neon(const uint16_t *row, int width, depthfilter_statistics_sum_t *sum)
+{
+    const uint16x8_t last_bin = vdupq_n_u16(K4A_DEPTH_STATISTICS_HISTOGRAM_BINS - 1);
+    uint16x8_t min_minus_one = vdupq_n_u16(0xffff);
+    uint16x8_t max = vdupq_n_u16(0);
+    uint32x4_t total = vdupq_n_u32(0);
+
+    int x = 0;
+    while (x + 2 * DEPTHFILTER_GROUP_SIZE <= width)
+    {
+        uint8x16_t counts[K4A_DEPTH_STATISTICS_HISTOGRAM_BINS];
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            counts[i] = vdupq_n_u8(0);
+        }
+
+        for (int group = 0; group < DEPTHFILTER_STATISTICS_CHUNK_GROUPS && x + 2 * DEPTHFILTER_GROUP_SIZE <= width;
+             group++, x += 2 * DEPTHFILTER_GROUP_SIZE)
+        {
+            uint16x8_t depth[2] = { vld1q_u16(row + x), vld1q_u16(row + x + DEPTHFILTER_GROUP_SIZE) };
+            uint8x8_t bin[2];
+            for (int half = 0; half < 2; half++)
+            {
+                min_minus_one = vminq_u16(min_minus_one, vsubq_u16(depth[half], vdupq_n_u16(1)));
+                max = vmaxq_u16(max, depth[half]);
+                total = vpadalq_u16(total, depth[half]);
+                uint16x8_t bin16 = vorrq_u16(vminq_u16(vshrq_n_u16(depth[half], DEPTHFILTER_STATISTICS_BIN_SHIFT),
+                                                       last_bin),
+                                             vceqq_u16(depth[half], vdupq_n_u16(0)));
+                bin[half] = vqmovn_u16(bin16);
+            }
+
+            // Narrowing saturates the bin of invalid pixels to 255
+            uint8x16_t bins = vcombine_u8(bin[0], bin[1]);
+            for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+            {
+                counts[i] = vsubq_u8(counts[i], vceqq_u8(bins, vdupq_n_u8((uint8_t)i)));
+            }
+        }
+
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            sum->histogram[i] += vaddlvq_u8(counts[i]);
+        }
+    }
+
+    sum->total += vaddlvq_u32(total);
+    depthfilter_statistics_add_extremes(sum, vminvq_u16(min_minus_one), vmaxvq_u16(max));
+    return x;
+}
+
+static int
+depthfilter_tone_map_row_neon(const uint16_t *row, uint8_t *output, int width, const depthfilter_tone_map_t *map)
+{
+    const uint16x8_t low = vdupq_n_u16(map->low);
+    const uint16x8_t range = vdupq_n_u16(map->range);
+    const uint16x8_t scale_high = vdupq_n_u16(map->scale_high);
+    const uint16x4_t scale_low = vdup_n_u16(map->scale_low);
+
+    int x = 0;
+    for (; x + DEPTHFILTER_GROUP_SIZE <= width; x += DEPTHFILTER_GROUP_SIZE)
+    {
+        uint16x8_t value = vminq_u16(vqsubq_u16(vld1q_u16(row + x), low), range);
+        uint16x8_t product_low = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(value), scale_low), 16),
+                                              vshrn_n_u32(vmull_u16(vget_high_u16(value), scale_low), 16));
+        uint16x8_t mapped = vaddq_u16(vmulq_u16(value, scale_high), product_low);
+        vst1_u8(output + x, vqmovn_u16(mapped));
+    }
+    return x;
+}
+
+#endif
+
+// Returns the statistics kernel of the instruction set selected by simd_get_level(), NULL where only the scalar kernel
+// runs. The AVX-512 level uses the AVX2 kernel.
+static depthfilter_statistics_row_t *depthfilter_select_statistics_kernel(void)
+{
+    switch (simd_get_level())
+    {
+#if defined(K4A_USING_AVX)
+    case SIMD_LEVEL_AVX512:
+    case SIMD_LEVEL_AVX2:
+        return depthfilter_statistics_row_avx2;
+#endif
+#if defined(K4A_USING_SSE)
+    case SIMD_LEVEL_SSE41:
+        return depthfilter_statistics_row_sse41;
+#endif
+#if defined(K4A_USING_NEON)
+    case SIMD_LEVEL_NEON:
+        return depthfilter_statistics_row_neon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// Returns the tone mapping kernel of the instruction set selected by simd_get_level(), NULL where only the scalar
+// kernel runs. The AVX-512 level uses the AVX2 kernel.
+static depthfilter_tone_map_row_t *depthfilter_select_tone_map_kernel(void)
+{
+    switch (simd_get_level())
+    {
+#if defined(K4A_USING_AVX)
+    case SIMD_LEVEL_AVX512:
+    case SIMD_LEVEL_AVX2:
+        return depthfilter_tone_map_row_avx2;
+#endif
+#if defined(K4A_USING_SSE)
+    case SIMD_LEVEL_SSE41:
+        return depthfilter_tone_map_row_sse41;
+#endif
+#if defined(K4A_USING_NEON)
+    case SIMD_LEVEL_NEON:
+        return depthfilter_tone_map_row_neon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static void depthfilter_select_kernels(depthfilter_kernels_t *kernels)
+{
+    memset(kernels, 0, sizeof(*kernels));
+    switch (simd_get_level())
+    {
+#if defined(K4A_USING_AVX)
+    case SIMD_LEVEL_AVX512:
+        kernels->edge_row = depthfilter_edge_row_avx512;
+        kernels->temporal_row = depthfilter_temporal_row_avx512;
+        kernels->hole_fill_row = depthfilter_hole_fill_row_avx512;
+        break;
+    case SIMD_LEVEL_AVX2:
+        kernels->edge_row = depthfilter_edge_row_avx2;
+        kernels->temporal_row = depthfilter_temporal_row_avx2;
+        kernels->hole_fill_row = depthfilter_hole_fill_row_avx2;
+        break;
+#endif
+#if defined(K4A_USING_SSE)
+    case SIMD_LEVEL_SSE41:
+        kernels->edge_row = depthfilter_edge_row_sse41;
+        kernels->temporal_row = depthfilter_temporal_row_sse41;
+        kernels->hole_fill_row = depthfilter_hole_fill_row_sse41;
+        break;
+#endif
+#if defined(K4A_USING_NEON)
+    case SIMD_LEVEL_NEON:
+        kernels->edge_row = depthfilter_edge_row_neon;
+        kernels->temporal_row = depthfilter_temporal_row_neon;
+        kernels->hole_fill_row = depthfilter_hole_fill_row_neon;
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+static int depthfilter_band_worker(void *param)
+{
+    depthfilter_band_t *band = (depthfilter_band_t *)param;
+    depthfilter_context_t *context = band->context;
+    int width = context->width;
+    int height = context->height;
+
+    for (int y = band->first_row; y < band->last_row; y++)
+    {
+        uint16_t *output = band->depth_image + (size_t)y * (size_t)width;
+        if (band->stage == DEPTHFILTER_STAGE_TEMPORAL)
+        {
+            uint16_t *history = context->history + (size_t)y * (size_t)width;
+            int x = 0;
+            if (context->kernels.temporal_row != NULL)
+            {
+                x = context->kernels.temporal_row(output,
+                                                  history,
+                                                  width,
+                                                  context->temporal_weight,
+                                                  context->config.temporal_threshold_mm);
+            }
+            depthfilter_temporal_pixels(output,
+                                        history,
+                                        x,
+                                        width,
+                                        context->temporal_weight,
+                                        context->config.temporal_threshold_mm);
+            continue;
+        }
+
+        const uint16_t *row = context->scratch + (size_t)y * (size_t)width;
+        const uint16_t *above = y > 0 ? row - width : context->zero_row;
+        const uint16_t *below = y < height - 1 ? row + width : context->zero_row;
+        if (band->stage == DEPTHFILTER_STAGE_EDGE)
+        {
+            uint16_t threshold = context->config.edge_threshold_mm;
+            int x = 0;
+            if (context->kernels.edge_row != NULL)
+            {
+                x = context->kernels.edge_row(above, row, below, output, width, threshold);
+            }
+            depthfilter_edge_pixels(above, row, below, output, width, 0, x == 0 ? 0 : 1, threshold);
+            depthfilter_edge_pixels(above, row, below, output, width, x, width, threshold);
+        }
+        else
+        {
+            int x = 0;
+            if (context->kernels.hole_fill_row != NULL)
+            {
+                x = context->kernels.hole_fill_row(above, row, below, output, width);
+            }
+            depthfilter_hole_fill_pixels(above, row, below, output, width, 0, x == 0 ? 0 : 1);
+            depthfilter_hole_fill_pixels(above, row, below, output, width, x, width);
+        }
+    }
+    return 0;
+}
+
+static void depthfilter_run_stage(depthfilter_context_t *context, depthfilter_stage_t stage, uint16_t *depth_image)
+{
+    if (stage != DEPTHFILTER_STAGE_TEMPORAL)
+    {
+        // The edge and hole filters read the neighbors of a pixel before this stage changed them
+        memcpy(context->scratch, depth_image, (size_t)context->width * (size_t)context->height * sizeof(uint16_t));
+    }
+
+    for (uint32_t i = 0; i < context->band_count; i++)
+    {
+        context->bands[i].stage = stage;
+        context->bands[i].depth_image = depth_image;
+    }
+
+    if (context->band_count == 1)
+    {
+        (void)depthfilter_band_worker(&context->bands[0]);
+    }
+    else
+    {
+        threadpool_run_tasks(depthfilter_band_worker, context->bands, sizeof(depthfilter_band_t), context->band_count);
+    }
+}
+
+k4a_result_t depthfilter_validate_configuration(const k4a_depth_filter_configuration_t *config)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+
+    if (!(config->temporal_alpha >= 0.0f && config->temporal_alpha < 1.0f))
+    {
+        LOG_ERROR("Temporal alpha %f of the depth filter is not in [0, 1).", (double)config->temporal_alpha);
+        return K4A_RESULT_FAILED;
+    }
+    if (config->thread_count > DEPTHFILTER_MAX_THREAD_COUNT)
+    {
+        LOG_ERROR("Depth filter thread count %u is above the maximum of %u.",
+                  config->thread_count,
+                  DEPTHFILTER_MAX_THREAD_COUNT);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+bool depthfilter_is_enabled(const k4a_depth_filter_configuration_t *config)
+{
+    return config->edge_threshold_mm != 0 || config->temporal_alpha > 0.0f || config->hole_fill_passes != 0;
+}
+
+k4a_result_t depthfilter_create(const k4a_depth_filter_configuration_t *config,
+                                int width,
+                                int height,
+                                depthfilter_t *depthfilter_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depthfilter_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, width <= 0 || height <= 0);
+    if (K4A_FAILED(TRACE_CALL(depthfilter_validate_configuration(config))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    depthfilter_context_t *context = depthfilter_t_create(depthfilter_handle);
+    if (context == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    context->config = *config;
+    context->width = width;
+    context->height = height;
+    depthfilter_select_kernels(&context->kernels);
+    if (context->config.temporal_threshold_mm == 0)
+    {
+        context->config.temporal_threshold_mm = UINT16_MAX;
+    }
+
+    // The weight of the new image is at least 1/65536 so that the previous weight fits 16 bits
+    uint32_t weight = (uint32_t)(config->temporal_alpha * 65536.0f + 0.5f);
+    context->temporal_weight = (uint16_t)(weight < 1 ? 1 : (weight > 65535 ? 65535 : weight));
+
+    size_t pixel_count = (size_t)width * (size_t)height;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (config->edge_threshold_mm != 0 || config->hole_fill_passes != 0)
+    {
+        context->scratch = (uint16_t *)malloc(pixel_count * sizeof(uint16_t));
+        context->zero_row = (uint16_t *)calloc((size_t)width, sizeof(uint16_t));
+        result = K4A_RESULT_FROM_BOOL(context->scratch != NULL && context->zero_row != NULL);
+    }
+    if (K4A_SUCCEEDED(result) && config->temporal_alpha > 0.0f)
+    {
+        // No depth is known yet, so the first image passes unchanged
+        context->history = (uint16_t *)calloc(pixel_count, sizeof(uint16_t));
+        result = K4A_RESULT_FROM_BOOL(context->history != NULL);
+    }
+
+    context->band_count = config->thread_count > 1 ? config->thread_count : 1;
+    if (context->band_count > (uint32_t)height)
+    {
+        context->band_count = (uint32_t)height;
+    }
+    if (K4A_SUCCEEDED(result) && context->band_count > 1)
+    {
+        result = TRACE_CALL(threadpool_acquire());
+        context->threadpool_acquired = K4A_SUCCEEDED(result);
+    }
+
+    for (uint32_t i = 0; i < context->band_count; i++)
+    {
+        context->bands[i].context = context;
+        context->bands[i].first_row = (int)((uint32_t)height * i / context->band_count);
+        context->bands[i].last_row = (int)((uint32_t)height * (i + 1) / context->band_count);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        depthfilter_destroy(*depthfilter_handle);
+        *depthfilter_handle = NULL;
+    }
+    return result;
+}
+
+void depthfilter_destroy(depthfilter_t depthfilter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, depthfilter_t, depthfilter_handle);
+    depthfilter_context_t *context = depthfilter_t_get_context(depthfilter_handle);
+
+    if (context->threadpool_acquired)
+    {
+        threadpool_release();
+    }
+    free(context->scratch);
+    free(context->history);
+    free(context->zero_row);
+    depthfilter_t_destroy(depthfilter_handle);
+}
+
+void depthfilter_process(depthfilter_t depthfilter_handle, uint16_t *depth_image)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, depthfilter_t, depthfilter_handle);
+    depthfilter_context_t *context = depthfilter_t_get_context(depthfilter_handle);
+
+    // Hole filled depth stays out of the temporal history, so it is never mistaken for a measurement
+    if (context->config.edge_threshold_mm != 0)
+    {
+        depthfilter_run_stage(context, DEPTHFILTER_STAGE_EDGE, depth_image);
+    }
+    if (context->history != NULL)
+    {
+        depthfilter_run_stage(context, DEPTHFILTER_STAGE_TEMPORAL, depth_image);
+    }
+    for (uint32_t i = 0; i < context->config.hole_fill_passes; i++)
+    {
+        depthfilter_run_stage(context, DEPTHFILTER_STAGE_HOLE_FILL, depth_image);
+    }
+}
+
+void depthfilter_compute_statistics(const uint16_t *depth_image,
+                                    int width,
+                                    int height,
+                                    k4a_depth_statistics_t *statistics)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, statistics == NULL);
+    memset(statistics, 0, sizeof(*statistics));
+    RETURN_VALUE_IF_ARG(VOID_VALUE, depth_image == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, width <= 0 || height <= 0);
+
+    depthfilter_statistics_row_t *kernel = depthfilter_select_statistics_kernel();
+    depthfilter_statistics_sum_t sum;
+    memset(&sum, 0, sizeof(sum));
+    sum.min_minus_one = UINT16_MAX;
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint16_t *row = depth_image + (size_t)y * (size_t)width;
+        int x = kernel != NULL ? kernel(row, width, &sum) : 0;
+        depthfilter_statistics_pixels(row, x, width, &sum);
+    }
+
+    for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+    {
+        statistics->histogram[i] = sum.histogram[i];
+        statistics->valid_pixel_count += sum.histogram[i];
+    }
+    if (statistics->valid_pixel_count != 0)
+    {
+        statistics->min_mm = (uint16_t)(sum.min_minus_one + 1);
+        statistics->max_mm = sum.max;
+        statistics->mean_mm = (float)((double)sum.total / statistics->valid_pixel_count);
+    }
+}
+
+k4a_result_t depthfilter_validate_ir8_configuration(const k4a_ir8_configuration_t *config)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+
+    switch (config->tone_mapping)
+    {
+    case K4A_IR_TONE_MAPPING_SHIFT:
+        if (config->shift > DEPTHFILTER_IR8_MAX_SHIFT)
+        {
+            LOG_ERROR("IR tone mapping shift %u is above the maximum of %u.", config->shift, DEPTHFILTER_IR8_MAX_SHIFT);
+            return K4A_RESULT_FAILED;
+        }
+        return K4A_RESULT_SUCCEEDED;
+    case K4A_IR_TONE_MAPPING_PERCENTILE:
+        if (!(config->low_percentile >= 0.0f && config->low_percentile < config->high_percentile &&
+              config->high_percentile <= 100.0f))
+        {
+            LOG_ERROR("IR tone mapping percentiles %f and %f are not increasing in [0, 100].",
+                      (double)config->low_percentile,
+                      (double)config->high_percentile);
+            return K4A_RESULT_FAILED;
+        }
+        return K4A_RESULT_SUCCEEDED;
+    default:
+        LOG_ERROR("Unknown IR tone mapping %d.", config->tone_mapping);
+        return K4A_RESULT_FAILED;
+    }
+}
+
+// Finds the IR values [low, high] between the percentiles of the configuration in a sample of the image
+static void depthfilter_ir8_percentile_range(const k4a_ir8_configuration_t *config,
+                                             const uint16_t *ir_image,
+                                             int width,
+                                             int height,
+                                             uint32_t *low,
+                                             uint32_t *high)
+{
+    uint32_t histogram[DEPTHFILTER_IR8_HISTOGRAM_BINS];
+    memset(histogram, 0, sizeof(histogram));
+    uint32_t sample_count = 0;
+    for (int y = 0; y < height; y += DEPTHFILTER_IR8_SAMPLE_STEP)
+    {
+        const uint16_t *row = ir_image + (size_t)y * (size_t)width;
+        for (int x = 0; x < width; x += DEPTHFILTER_IR8_SAMPLE_STEP)
+        {
+            histogram[row[x] >> DEPTHFILTER_IR8_HISTOGRAM_SHIFT]++;
+            sample_count++;
+        }
+    }
+
+    // The low end is the first bin with more than low_rank samples at or below it, the high end the end of the first
+    // bin with high_rank samples at or below it
+    uint32_t low_rank = (uint32_t)((double)config->low_percentile / 100.0 * sample_count);
+    uint32_t high_rank = (uint32_t)((double)config->high_percentile / 100.0 * sample_count);
+    low_rank = low_rank < sample_count ? low_rank : sample_count - 1;
+
+    uint32_t count = 0;
+    uint32_t low_bin = DEPTHFILTER_IR8_HISTOGRAM_BINS;
+    uint32_t high_bin = DEPTHFILTER_IR8_HISTOGRAM_BINS - 1;
+    for (uint32_t bin = 0; bin < DEPTHFILTER_IR8_HISTOGRAM_BINS; bin++)
+    {
+        count += histogram[bin];
+        if (low_bin == DEPTHFILTER_IR8_HISTOGRAM_BINS && count > low_rank)
+        {
+            low_bin = bin;
+        }
+        if (low_bin != DEPTHFILTER_IR8_HISTOGRAM_BINS && count >= high_rank)
+        {
+            high_bin = bin;
+            break;
+        }
+    }
+
+    *low = low_bin << DEPTHFILTER_IR8_HISTOGRAM_SHIFT;
+    *high = ((high_bin + 1) << DEPTHFILTER_IR8_HISTOGRAM_SHIFT) - 1;
+}
+
+void depthfilter_tone_map_ir(const k4a_ir8_configuration_t *config,
+                             const uint16_t *ir_image,
+                             int width,
+                             int height,
+                             uint8_t *ir8_image)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, config == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, ir_image == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, ir8_image == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, width <= 0 || height <= 0);
+
+    uint32_t low = 0;
+    uint32_t high = (255u << config->shift);
+    if (config->tone_mapping == K4A_IR_TONE_MAPPING_PERCENTILE)
+    {
+        depthfilter_ir8_percentile_range(config, ir_image, width, height, &low, &high);
+    }
+
+    // Rounding the scale up maps the high end to 255, which a shift maps exactly
+    depthfilter_tone_map_t map;
+    uint32_t range = high - low;
+    uint32_t scale = (255u * 65536u + range - 1) / range;
+    map.low = (uint16_t)low;
+    map.range = (uint16_t)range;
+    map.scale_high = (uint16_t)(scale >> 16);
+    map.scale_low = (uint16_t)(scale & 0xffff);
+
+    depthfilter_tone_map_row_t *kernel = depthfilter_select_tone_map_kernel();
+    for (int y = 0; y < height; y++)
+    {
+        const uint16_t *row = ir_image + (size_t)y * (size_t)width;
+        uint8_t *output = ir8_image + (size_t)y * (size_t)width;
+        int x = kernel != NULL ? kernel(row, output, width, &map) : 0;
+        depthfilter_tone_map_pixels(row, output, x, width, &map);
+    }
+}
@@ -0,0 +1,414 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <k4ainternal/devicegroup.h>
+
+// Dependent libraries
+#include <k4ainternal/handle.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/queue.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/common.h>
+
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Captures of one device waiting for the other devices, the same depth as the capturesync queues. QUEUE_DEFAULT_SIZE
+// calls k4a_convert_fps_to_uint(), so the depth at 30 FPS is spelled out to size the arrays with a constant.
+#define DEVICEGROUP_PENDING_DEPTH (QUEUE_CALC_DEPTH(30, QUEUE_DEFAULT_DEPTH_USEC))
+
+// Matched sets waiting for devicegroup_get_capture(), the same depth as the synchronized capture queue
+#define DEVICEGROUP_OUTPUT_DEPTH (DEVICEGROUP_PENDING_DEPTH / 2)
+
+typedef struct _devicegroup_device_t
+{
+    int64_t subordinate_delay_usec;     // Delay of the device's color camera after the color camera of the master
+    int32_t depth_delay_off_color_usec; // Delay of the device's depth camera after its color camera
+    k4a_capture_t pending[DEVICEGROUP_PENDING_DEPTH]; // Oldest capture first, starting at pending_first
+    uint64_t pending_ts[DEVICEGROUP_PENDING_DEPTH];   // Aligned timestamp of each pending capture
+    uint32_t pending_first;
+    uint32_t pending_count;
+} devicegroup_device_t;
+
+typedef struct _devicegroup_set_t
+{
+    k4a_capture_t captures[DEVICEGROUP_MAX_DEVICES];
+    uint64_t skew_usec;
+} devicegroup_set_t;
+
+typedef struct _devicegroup_context_t
+{
+    uint32_t device_count;
+    devicegroup_device_t devices[DEVICEGROUP_MAX_DEVICES];
+
+    devicegroup_set_t output[DEVICEGROUP_OUTPUT_DEPTH]; // Matched sets, oldest first, starting at output_first
+    uint32_t output_first;
+    uint32_t output_count;
+
+    uint64_t fps_1_quarter_period; // Captures within this of each other belong to the same set
+    uint64_t dropped_count;        // Captures dropped without a match, see devicegroup_get_dropped_count()
+
+    bool running;
+    uint32_t blocked_count; // Threads waiting in devicegroup_get_capture()
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+} devicegroup_context_t;
+
+K4A_DECLARE_CONTEXT(devicegroup_t, devicegroup_context_t);
+
+// Timestamp of the capture aligned to the color camera of the master. Color is used when present, IR or depth is
+// moved back by depth_delay_off_color_usec so devices with the color camera off still line up.
+static bool get_aligned_timestamp(devicegroup_device_t *device, k4a_capture_t capture, uint64_t *ts)
+{
+    k4a_image_t image = capture_get_color_image(capture);
+    int64_t offset_usec = device->subordinate_delay_usec;
+    if (image == NULL)
+    {
+        // Captures of a depth only device have no IR image
+        image = capture_get_ir_image(capture);
+        if (image == NULL)
+        {
+            image = capture_get_depth_image(capture);
+        }
+        offset_usec += device->depth_delay_off_color_usec;
+    }
+
+    if (image == NULL)
+    {
+        return false;
+    }
+
+    int64_t aligned = (int64_t)image_get_device_timestamp_usec(image) - offset_usec;
+    image_dec_ref(image);
+    *ts = aligned < 0 ? 0 : (uint64_t)aligned;
+    return true;
+}
+
+static void pop_pending(devicegroup_device_t *device, k4a_capture_t *capture)
+{
+    *capture = device->pending[device->pending_first];
+    device->pending[device->pending_first] = NULL;
+    device->pending_first = (device->pending_first + 1) % DEVICEGROUP_PENDING_DEPTH;
+    device->pending_count--;
+}
+
+static void release_set(devicegroup_context_t *group, devicegroup_set_t *set)
+{
+    for (uint32_t i = 0; i < group->device_count; i++)
+    {
+        if (set->captures[i])
+        {
+            capture_dec_ref(set->captures[i]);
+            set->captures[i] = NULL;
+        }
+    }
+}
+
+// Publishes complete sets while every device has a pending capture. Must be called with group->lock held.
+static void match_pending_locked(devicegroup_context_t *group)
+{
+    while (true)
+    {
+        uint64_t max_ts = 0;
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            devicegroup_device_t *device = &group->devices[i];
+            if (device->pending_count == 0)
+            {
+                return;
+            }
+            uint64_t ts = device->pending_ts[device->pending_first];
+            max_ts = ts > max_ts ? ts : max_ts;
+        }
+
+        // A capture too far behind the latest head can't be matched anymore, the devices it would match have moved on
+        bool dropped = false;
+        uint64_t min_ts = max_ts;
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            devicegroup_device_t *device = &group->devices[i];
+            uint64_t ts = device->pending_ts[device->pending_first];
+            if (ts + group->fps_1_quarter_period < max_ts)
+            {
+                k4a_capture_t capture;
+                pop_pending(device, &capture);
+                capture_dec_ref(capture);
+                group->dropped_count++;
+                dropped = true;
+            }
+            else if (ts < min_ts)
+            {
+                min_ts = ts;
+            }
+        }
+        if (dropped)
+        {
+            continue;
+        }
+
+        if (group->output_count == DEVICEGROUP_OUTPUT_DEPTH)
+        {
+            // The reader isn't keeping up, drop the oldest set
+            release_set(group, &group->output[group->output_first]);
+            group->output_first = (group->output_first + 1) % DEVICEGROUP_OUTPUT_DEPTH;
+            group->output_count--;
+            group->dropped_count += group->device_count;
+        }
+
+        devicegroup_set_t *set = &group->output[(group->output_first + group->output_count) % DEVICEGROUP_OUTPUT_DEPTH];
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            pop_pending(&group->devices[i], &set->captures[i]);
+        }
+        set->skew_usec = max_ts - min_ts;
+        group->output_count++;
+        Condition_Post(group->condition);
+    }
+}
+
+// Releases every capture held by the group. Must be called with group->lock held.
+static void release_all_locked(devicegroup_context_t *group)
+{
+    for (uint32_t i = 0; i < group->device_count; i++)
+    {
+        devicegroup_device_t *device = &group->devices[i];
+        while (device->pending_count != 0)
+        {
+            k4a_capture_t capture;
+            pop_pending(device, &capture);
+            capture_dec_ref(capture);
+        }
+        device->pending_first = 0;
+    }
+
+    while (group->output_count != 0)
+    {
+        release_set(group, &group->output[group->output_first]);
+        group->output_first = (group->output_first + 1) % DEVICEGROUP_OUTPUT_DEPTH;
+        group->output_count--;
+    }
+    group->output_first = 0;
+}
+
+k4a_result_t devicegroup_create(uint32_t device_count, devicegroup_t *devicegroup_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_count > DEVICEGROUP_MAX_DEVICES);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, devicegroup_handle == NULL);
+
+    devicegroup_context_t *group = devicegroup_t_create(devicegroup_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(group != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        group->device_count = device_count;
+        group->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(group->lock != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        group->condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(group->condition != NULL);
+    }
+
+    if (K4A_FAILED(result) && group != NULL)
+    {
+        devicegroup_destroy(*devicegroup_handle);
+        *devicegroup_handle = NULL;
+    }
+
+    return result;
+}
+
+void devicegroup_destroy(devicegroup_t devicegroup_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, devicegroup_t, devicegroup_handle);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+
+    if (group->lock)
+    {
+        devicegroup_stop(devicegroup_handle);
+        Lock_Deinit(group->lock);
+    }
+
+    if (group->condition)
+    {
+        Condition_Deinit(group->condition);
+    }
+
+    devicegroup_t_destroy(devicegroup_handle);
+}
+
+k4a_result_t devicegroup_start(devicegroup_t devicegroup_handle, const k4a_device_configuration_t *configs)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, devicegroup_t, devicegroup_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, configs == NULL);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+
+    for (uint32_t i = 1; i < group->device_count; i++)
+    {
+        if (configs[i].camera_fps != configs[0].camera_fps)
+        {
+            LOG_ERROR("Device %u of the group uses a different camera_fps than device 0.", i);
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    Lock(group->lock);
+    release_all_locked(group);
+    for (uint32_t i = 0; i < group->device_count; i++)
+    {
+        devicegroup_device_t *device = &group->devices[i];
+        device->subordinate_delay_usec = configs[i].wired_sync_mode == K4A_WIRED_SYNC_MODE_SUBORDINATE ?
+                                             (int64_t)configs[i].subordinate_delay_off_master_usec :
+                                             0;
+        device->depth_delay_off_color_usec = configs[i].depth_delay_off_color_usec;
+    }
+    group->fps_1_quarter_period = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(configs[0].camera_fps)) / 4;
+    group->dropped_count = 0;
+    group->running = true;
+    Unlock(group->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void devicegroup_stop(devicegroup_t devicegroup_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, devicegroup_t, devicegroup_handle);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+
+    Lock(group->lock);
+    group->running = false;
+    while (group->blocked_count != 0)
+    {
+        LOG_INFO("Device group waiting for blocking call to complete.", 0);
+        Condition_Post(group->condition);
+        Unlock(group->lock);
+        ThreadAPI_Sleep(25);
+        Lock(group->lock);
+    }
+    release_all_locked(group);
+    Unlock(group->lock);
+}
+
+void devicegroup_add_capture(devicegroup_t devicegroup_handle,
+                             uint32_t device_index,
+                             k4a_result_t result,
+                             k4a_capture_t capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, devicegroup_t, devicegroup_handle);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, device_index >= group->device_count);
+
+    Lock(group->lock);
+    if (K4A_FAILED(result))
+    {
+        // No more sets can be completed, fail the readers
+        if (group->running)
+        {
+            LOG_WARNING("Capture error detected on device %u of the group.", device_index);
+        }
+        group->running = false;
+        Condition_Post(group->condition);
+    }
+    else if (group->running && capture_handle != NULL)
+    {
+        devicegroup_device_t *device = &group->devices[device_index];
+        uint64_t ts = 0;
+        if (get_aligned_timestamp(device, capture_handle, &ts))
+        {
+            if (device->pending_count == DEVICEGROUP_PENDING_DEPTH)
+            {
+                // The other devices stopped producing captures, drop the oldest
+                k4a_capture_t capture;
+                pop_pending(device, &capture);
+                capture_dec_ref(capture);
+                group->dropped_count++;
+            }
+
+            uint32_t slot = (device->pending_first + device->pending_count) % DEVICEGROUP_PENDING_DEPTH;
+            capture_inc_ref(capture_handle);
+            device->pending[slot] = capture_handle;
+            device->pending_ts[slot] = ts;
+            device->pending_count++;
+
+            match_pending_locked(group);
+        }
+    }
+    Unlock(group->lock);
+}
+
+k4a_wait_result_t devicegroup_get_capture(devicegroup_t devicegroup_handle,
+                                          k4a_capture_t *capture_handles,
+                                          uint64_t *skew_usec,
+                                          int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, devicegroup_t, devicegroup_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, capture_handles == NULL);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
+
+    Lock(group->lock);
+    if (group->output_count == 0 && group->running && timeout_in_ms != 0)
+    {
+        group->blocked_count++;
+        do
+        {
+            // Anything less than 0 is a wait forever condition, which Condition_Wait expresses with 0
+            COND_RESULT cond_result = Condition_Wait(group->condition,
+                                                     group->lock,
+                                                     timeout_in_ms < 0 ? 0 : timeout_in_ms);
+            if (cond_result == COND_ERROR)
+            {
+                wresult = K4A_WAIT_RESULT_FAILED;
+                break;
+            }
+            // An infinite wait does not time out
+        } while (group->output_count == 0 && group->running && timeout_in_ms < 0);
+        group->blocked_count--;
+    }
+
+    if (wresult == K4A_WAIT_RESULT_SUCCEEDED && group->output_count != 0)
+    {
+        // Sets matched before a stream error are still returned
+        devicegroup_set_t *set = &group->output[group->output_first];
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            capture_handles[i] = set->captures[i];
+            set->captures[i] = NULL;
+        }
+        if (skew_usec)
+        {
+            *skew_usec = set->skew_usec;
+        }
+        group->output_first = (group->output_first + 1) % DEVICEGROUP_OUTPUT_DEPTH;
+        group->output_count--;
+    }
+    else if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        wresult = group->running ? K4A_WAIT_RESULT_TIMEOUT : K4A_WAIT_RESULT_FAILED;
+    }
+    Unlock(group->lock);
+
+    return wresult;
+}
+
+uint64_t devicegroup_get_dropped_count(devicegroup_t devicegroup_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, devicegroup_t, devicegroup_handle);
+    devicegroup_context_t *group = devicegroup_t_get_context(devicegroup_handle);
+
+    Lock(group->lock);
+    uint64_t dropped_count = group->dropped_count;
+    Unlock(group->lock);
+
+    return dropped_count;
+}
@@ -5,14 +5,19 @@
 #include <k4ainternal/dewrapper.h>
 
 // Dependent libraries
+#include <k4ainternal/allocator.h>
 #include <k4ainternal/queue.h>
 #include <k4ainternal/calibration.h>
 #include <k4ainternal/deloader.h>
+#include <k4ainternal/depthfilter.h>
+#include <k4ainternal/latency.h>
+#include <k4ainternal/threadpool.h>
 #include <azure_c_shared_utility/threadapi.h>
 #include <azure_c_shared_utility/condition.h>
 #include <azure_c_shared_utility/tickcounter.h>
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/refcount.h>
+#include <azure_c_shared_utility/envvariable.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -21,6 +26,25 @@
 
 #define DEWRAPPER_QUEUE_DEPTH ((uint32_t)2) // We should not need to store more than 1
 
+// Max number of processed captures waiting to be published when the depth engine is pipelined
+#define DEWRAPPER_MAX_PIPELINE_DEPTH ((uint32_t)3)
+
+// Number of depth engine output buffers kept for reuse. Buffers held downstream beyond this fall back to the allocator.
+#define DEWRAPPER_OUTPUT_RING_SIZE ((uint32_t)4)
+#define DEWRAPPER_OUTPUT_RING_MAX_SIZE (DEWRAPPER_OUTPUT_RING_SIZE + DEWRAPPER_MAX_PIPELINE_DEPTH)
+
+// Depth engine output buffers allocated once at start. The ring is reference counted: the depth engine thread holds one
+// reference and every buffer lent out to a capture holds one, so the ring outlives the stream while captures are held.
+typedef struct _depth_output_ring_t
+{
+    LOCK_HANDLE lock;
+    volatile long ref_count;
+    uint32_t buffer_count;
+    uint32_t free_count;
+    uint8_t *buffers[DEWRAPPER_OUTPUT_RING_MAX_SIZE];
+    uint8_t *free_list[DEWRAPPER_OUTPUT_RING_MAX_SIZE];
+} depth_output_ring_t;
+
 typedef struct _dewrapper_context_t
 {
     queue_t queue;
@@ -34,10 +58,25 @@ typedef struct _dewrapper_context_t
     COND_HANDLE condition;
     volatile bool thread_started;
     volatile bool thread_stop;
+    volatile bool thread_parked; // Thread is waiting for the next start with the depth engine kept
+    volatile bool thread_exit;   // Parked thread should exit
+    volatile bool thread_exited; // Thread is exiting instead of parking
+    volatile bool restarting;    // Park the thread and keep the depth engine for dewrapper_restart()
+    COND_HANDLE park_condition;
     k4a_result_t thread_start_result;
 
     k4a_fps_t fps;
     k4a_depth_mode_t depth_mode;
+    int numa_node;
+    int32_t gpu_index;        // Requested GPU, K4A_DEPTH_ENGINE_GPU_AUTO or K4A_DEPTH_ENGINE_GPU_DEFAULT
+    int32_t gpu_reserved;     // GPU reserved with deloader_depth_engine_reserve_gpu() while started, otherwise -1
+    uint64_t gpu_load;        // Load reserved on gpu_reserved
+    bool share_depth_engine;  // Sharing requested with dewrapper_set_depth_engine_shared()
+    bool depth_engine_shared; // depth_engine was created by deloader_depth_engine_create_shared()
+    bool keep_depth_engine;   // Keep the depth engine and its thread across stop and start
+
+    k4a_depth_mode_t engine_depth_mode; // Depth mode depth_engine was created for
+    int32_t engine_gpu_index;           // gpu_index when depth_engine was created
 
     TICK_COUNTER_HANDLE tick;
     dewrapper_streaming_capture_cb_t *capture_ready_cb;
@@ -45,6 +84,31 @@ typedef struct _dewrapper_context_t
 
     k4a_depth_engine_context_t *depth_engine;
 
+    // When pipelined, processed captures are handed to a publish thread so the next frame can be submitted to the depth
+    // engine without waiting for the capture to be delivered. NULL when not pipelined.
+    queue_t output_queue;
+    THREAD_HANDLE publish_thread;
+
+    depth_output_ring_t *output_ring;
+
+    k4a_depth_filter_configuration_t depth_filter_config; // Zero initialized when no filter is set
+    depthfilter_t depth_filter;                           // Created for the first depth image of a session
+
+    bool gpu_export_enabled; // Set with dewrapper_set_depth_gpu_export()
+    k4a_depth_gpu_export_configuration_t gpu_export_config;
+
+    bool depth_only; // Set with dewrapper_set_depth_only()
+
+    bool ir8_enabled; // Set with dewrapper_set_ir8_output()
+    k4a_ir8_configuration_t ir8_config;
+
+    uint32_t frame_decimation; // Set with dewrapper_set_frame_decimation(), 0 or 1 when every frame is processed
+
+    // Set with dewrapper_set_overload_policy(), zero initialized when raw frames are never dropped
+    k4a_depth_engine_overload_configuration_t overload_config;
+
+    dewrapper_stats_t stats; // Updated by the depth engine thread under lock
+
 } dewrapper_context_t;
 
 typedef struct _shared_image_context_t
@@ -52,10 +116,13 @@ typedef struct _shared_image_context_t
     // Overall shared buffer
     uint8_t *buffer;
     volatile long ref;
+    depth_output_ring_t *ring; // Ring the buffer is returned to, NULL if it came from the allocator
 } shared_image_context_t;
 
 K4A_DECLARE_CONTEXT(dewrapper_t, dewrapper_context_t);
 
+static void dewrapper_stop_internal(dewrapper_t dewrapper_handle, bool exit_thread);
+
 static k4a_depth_engine_mode_t get_de_mode_from_depth_mode(k4a_depth_mode_t mode)
 {
     k4a_depth_engine_mode_t de_mode;
@@ -97,6 +164,91 @@ static k4a_depth_engine_input_type_t get_input_format_from_depth_mode(k4a_depth_
     return format;
 }
 
+static void depth_output_ring_dec_ref(depth_output_ring_t *ring)
+{
+    if (DEC_REF_VAR(ring->ref_count) == 0)
+    {
+        assert(ring->free_count == ring->buffer_count);
+        for (uint32_t i = 0; i < ring->buffer_count; i++)
+        {
+            allocator_free(ring->buffers[i]);
+        }
+        Lock_Deinit(ring->lock);
+        free(ring);
+    }
+}
+
+static k4a_result_t depth_output_ring_create(size_t buffer_size, uint32_t buffer_count, depth_output_ring_t **ring_out)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_count == 0 || buffer_count > DEWRAPPER_OUTPUT_RING_MAX_SIZE);
+
+    depth_output_ring_t *ring = (depth_output_ring_t *)calloc(1, sizeof(depth_output_ring_t));
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(ring != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        ring->ref_count = 1;
+        ring->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(ring->lock != NULL);
+    }
+
+    for (uint32_t i = 0; K4A_SUCCEEDED(result) && i < buffer_count; i++)
+    {
+        ring->buffers[i] = allocator_alloc_image(ALLOCATION_SOURCE_DEPTH, K4A_IMAGE_FORMAT_DEPTH16, buffer_size);
+        result = K4A_RESULT_FROM_BOOL(ring->buffers[i] != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            ring->free_list[ring->free_count++] = ring->buffers[i];
+            ring->buffer_count++;
+        }
+    }
+
+    if (K4A_FAILED(result) && ring != NULL)
+    {
+        if (ring->lock)
+        {
+            depth_output_ring_dec_ref(ring);
+        }
+        else
+        {
+            free(ring);
+        }
+        ring = NULL;
+    }
+
+    *ring_out = ring;
+    return result;
+}
+
+// Takes a buffer from the ring, the buffer holds a reference on the ring until it is returned
+static uint8_t *depth_output_ring_take(depth_output_ring_t *ring)
+{
+    uint8_t *buffer = NULL;
+
+    Lock(ring->lock);
+    if (ring->free_count > 0)
+    {
+        buffer = ring->free_list[--ring->free_count];
+    }
+    Unlock(ring->lock);
+
+    if (buffer != NULL)
+    {
+        INC_REF_VAR(ring->ref_count);
+    }
+    return buffer;
+}
+
+static void depth_output_ring_return(depth_output_ring_t *ring, uint8_t *buffer)
+{
+    Lock(ring->lock);
+    assert(ring->free_count < ring->buffer_count);
+    ring->free_list[ring->free_count++] = buffer;
+    Unlock(ring->lock);
+
+    depth_output_ring_dec_ref(ring);
+}
+
 /** Depth engine uses 1 large allocation to write two images; depth & IR. We then create 2 k4a_image_t's to manage the
  * lifetime. This function is the destroy callback when each of the two images is destroyed. Once both have been
  * destroyed this function will destroy the shared memory between the two.
@@ -116,11 +268,20 @@ static void free_shared_depth_image(void *buffer, void *context)
 
     if (count == 0)
     {
-        allocator_free(shared_context->buffer);
-        free(context);
+        if (shared_context->ring)
+        {
+            depth_output_ring_return(shared_context->ring, shared_context->buffer);
+        }
+        else
+        {
+            allocator_free(shared_context->buffer);
+        }
+        allocator_handle_free(HANDLE_POOL_SHARED_BUFFER, context);
     }
 }
 
+static void depth_engine_stop_helper(dewrapper_context_t *dewrapper);
+
 static k4a_result_t depth_engine_start_helper(dewrapper_context_t *dewrapper,
                                               k4a_fps_t fps,
                                               k4a_depth_mode_t depth_mode,
@@ -131,24 +292,87 @@ static k4a_result_t depth_engine_start_helper(dewrapper_context_t *dewrapper,
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depth_mode <= K4A_DEPTH_MODE_OFF || depth_mode > K4A_DEPTH_MODE_PASSIVE_IR);
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
 
-    assert(dewrapper->depth_engine == NULL);
     assert(dewrapper->calibration_memory != NULL);
 
     // Max comput time is the configured FPS
     *depth_engine_max_compute_time_ms = HZ_TO_PERIOD_MS(k4a_convert_fps_to_uint(fps));
     result = K4A_RESULT_FROM_BOOL(*depth_engine_max_compute_time_ms != 0);
 
+    if (K4A_SUCCEEDED(result) && dewrapper->depth_engine != NULL)
+    {
+        // A depth engine kept from the last start is reused if nothing it was created with has changed
+        if (dewrapper->engine_depth_mode == depth_mode && dewrapper->engine_gpu_index == dewrapper->gpu_index &&
+            !dewrapper->share_depth_engine)
+        {
+            LOG_INFO("Reusing the depth engine kept from the last start", 0);
+            *depth_engine_output_buffer_size = deloader_depth_engine_get_output_frame_size(dewrapper->depth_engine);
+            return K4A_RESULT_FROM_BOOL(0 != *depth_engine_output_buffer_size);
+        }
+        depth_engine_stop_helper(dewrapper);
+    }
+
+    if (K4A_SUCCEEDED(result) && dewrapper->gpu_index != K4A_DEPTH_ENGINE_GPU_DEFAULT)
+    {
+        // The load of a depth engine is estimated from the pixel rate of its depth mode and the frames it processes
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t decimation = dewrapper->frame_decimation > 1 ? dewrapper->frame_decimation : 1;
+        k4a_convert_depth_mode_to_width_height(depth_mode, &width, &height);
+        dewrapper->gpu_load = (uint64_t)width * height * ((k4a_convert_fps_to_uint(fps) + decimation - 1) / decimation);
+        dewrapper->gpu_reserved = deloader_depth_engine_reserve_gpu(dewrapper->gpu_index, dewrapper->gpu_load);
+
+        if (dewrapper->gpu_reserved < 0 && dewrapper->gpu_index == K4A_DEPTH_ENGINE_GPU_AUTO)
+        {
+            LOG_INFO("Depth engine plugin doesn't support GPU selection, using the default GPU", 0);
+        }
+        else if (dewrapper->gpu_reserved < 0)
+        {
+            LOG_ERROR("Depth engine can't be placed on GPU %d", dewrapper->gpu_index);
+            result = K4A_RESULT_FAILED;
+        }
+        else
+        {
+            LOG_INFO("Depth engine placed on GPU %d", dewrapper->gpu_reserved);
+        }
+    }
+
     if (K4A_SUCCEEDED(result))
     {
-        k4a_depth_engine_result_code_t deresult =
-            deloader_depth_engine_create_and_initialize(&dewrapper->depth_engine,
-                                                        dewrapper->calibration_memory_size,
-                                                        dewrapper->calibration_memory,
-                                                        get_de_mode_from_depth_mode(depth_mode),
-                                                        get_input_format_from_depth_mode(depth_mode),
-                                                        dewrapper->calibration, // k4a_calibration_camera_t*
-                                                        NULL,                   // Callback
-                                                        NULL);                  // Callback Context
+        k4a_depth_engine_result_code_t deresult;
+        if (dewrapper->share_depth_engine)
+        {
+            deresult = deloader_depth_engine_create_shared(&dewrapper->depth_engine,
+                                                           dewrapper->calibration_memory_size,
+                                                           dewrapper->calibration_memory,
+                                                           get_de_mode_from_depth_mode(depth_mode),
+                                                           get_input_format_from_depth_mode(depth_mode),
+                                                           dewrapper->calibration,
+                                                           dewrapper->gpu_reserved,
+                                                           &dewrapper->depth_engine_shared);
+        }
+        else if (dewrapper->gpu_reserved >= 0)
+        {
+            deresult = deloader_depth_engine_create_and_initialize_on_gpu(&dewrapper->depth_engine,
+                                                                          dewrapper->calibration_memory_size,
+                                                                          dewrapper->calibration_memory,
+                                                                          get_de_mode_from_depth_mode(depth_mode),
+                                                                          get_input_format_from_depth_mode(depth_mode),
+                                                                          dewrapper->calibration,
+                                                                          NULL,
+                                                                          NULL,
+                                                                          (uint32_t)dewrapper->gpu_reserved);
+        }
+        else
+        {
+            deresult = deloader_depth_engine_create_and_initialize(&dewrapper->depth_engine,
+                                                                   dewrapper->calibration_memory_size,
+                                                                   dewrapper->calibration_memory,
+                                                                   get_de_mode_from_depth_mode(depth_mode),
+                                                                   get_input_format_from_depth_mode(depth_mode),
+                                                                   dewrapper->calibration, // k4a_calibration_camera_t*
+                                                                   NULL,                   // Callback
+                                                                   NULL);                  // Callback Context
+        }
         if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
         {
             LOG_ERROR("Depth engine create and initialize failed with error code: %d.", deresult);
@@ -157,41 +381,779 @@ static k4a_result_t depth_engine_start_helper(dewrapper_context_t *dewrapper,
                 LOG_ERROR("OpenGL 4.4 context creation failed. You could try updating your graphics drivers.", 0);
             }
         }
-        result = K4A_RESULT_FROM_BOOL(deresult == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED);
+        result = K4A_RESULT_FROM_BOOL(deresult == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        dewrapper->engine_depth_mode = depth_mode;
+        dewrapper->engine_gpu_index = dewrapper->gpu_index;
+        *depth_engine_output_buffer_size = deloader_depth_engine_get_output_frame_size(dewrapper->depth_engine);
+        result = K4A_RESULT_FROM_BOOL(0 != *depth_engine_output_buffer_size);
+    }
+
+    return result;
+}
+
+static void depth_engine_stop_helper(dewrapper_context_t *dewrapper)
+{
+    if (dewrapper->depth_engine != NULL)
+    {
+        deloader_depth_engine_destroy(&dewrapper->depth_engine);
+        dewrapper->depth_engine = NULL;
+        dewrapper->depth_engine_shared = false;
+    }
+
+    if (dewrapper->gpu_reserved >= 0)
+    {
+        deloader_depth_engine_release_gpu(dewrapper->gpu_reserved, dewrapper->gpu_load);
+        dewrapper->gpu_reserved = -1;
+    }
+}
+
+static int depth_engine_publish_thread(void *param)
+{
+    dewrapper_context_t *dewrapper = (dewrapper_context_t *)param;
+    k4a_capture_t capture = NULL;
+
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_DEPTH_ENGINE);
+
+    // Runs until the output queue is stopped by depth_engine_pipeline_stop()
+    while (queue_pop(dewrapper->output_queue, K4A_WAIT_INFINITE, &capture) == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        dewrapper->capture_ready_cb(K4A_RESULT_SUCCEEDED, capture, dewrapper->capture_ready_cb_context);
+        capture_dec_ref(capture);
+    }
+
+    return 0;
+}
+
+static k4a_result_t depth_engine_pipeline_start(dewrapper_context_t *dewrapper)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    uint32_t pipeline_depth = 0;
+
+    assert(dewrapper->output_queue == NULL);
+    assert(dewrapper->publish_thread == NULL);
+
+    // Pipelining is enabled by the number of captures allowed in flight between processing and publishing
+    const char *env_pipeline_depth = environment_get_variable("K4A_DEPTH_ENGINE_PIPELINE_DEPTH");
+    if (env_pipeline_depth != NULL && env_pipeline_depth[0] != '\0')
+    {
+        pipeline_depth = (uint32_t)strtoul(env_pipeline_depth, NULL, 10);
+        if (pipeline_depth > DEWRAPPER_MAX_PIPELINE_DEPTH)
+        {
+            LOG_WARNING("K4A_DEPTH_ENGINE_PIPELINE_DEPTH of %d capped to %d",
+                        pipeline_depth,
+                        DEWRAPPER_MAX_PIPELINE_DEPTH);
+            pipeline_depth = DEWRAPPER_MAX_PIPELINE_DEPTH;
+        }
+    }
+
+    if (pipeline_depth == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    result = TRACE_CALL(queue_create_spsc(pipeline_depth, "dewrapper_output", &dewrapper->output_queue));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        queue_enable(dewrapper->output_queue);
+        THREADAPI_RESULT tresult = ThreadAPI_Create(&dewrapper->publish_thread, depth_engine_publish_thread, dewrapper);
+        result = K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        LOG_INFO("Depth engine pipelined with %d captures in flight", pipeline_depth);
+    }
+
+    return result;
+}
+
+static void depth_engine_pipeline_stop(dewrapper_context_t *dewrapper)
+{
+    if (dewrapper->output_queue)
+    {
+        // Unblocks the publish thread, captures not yet published are dropped
+        queue_stop(dewrapper->output_queue);
+    }
+
+    if (dewrapper->publish_thread)
+    {
+        int thread_result;
+        THREADAPI_RESULT tresult = ThreadAPI_Join(dewrapper->publish_thread, &thread_result);
+        (void)K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK); // Trace the issue, but we don't return a failure
+        dewrapper->publish_thread = NULL;
+    }
+
+    if (dewrapper->output_queue)
+    {
+        queue_destroy(dewrapper->output_queue);
+        dewrapper->output_queue = NULL;
+    }
+}
+
+// Settings of a depth engine session, decided when it starts
+typedef struct _depth_engine_session_t
+{
+    size_t output_buffer_size;
+    int max_compute_time_ms;
+    k4a_depth_engine_output_type_t output_type;
+    bool depth16_present;
+    bool async; // Frames go through the asynchronous depth engine entry points, several at a time
+    bool gpu_export;
+    k4a_transform_engine_gpu_export_t gpu_export_type;
+    uint32_t gpu_export_slot;  // Next GPU resource slot to write
+    bool depth_filter_pending; // The depth filter is created for the first depth image
+    bool received_valid_image;
+    uint64_t frame_period_usec; // Time between two raw frames posted to the dewrapper
+    bool overloaded;            // Raw frames are dropped by the overload policy
+    uint32_t overload_streak;   // Frames in a row whose compute time disagrees with overloaded
+    bool drop_next_frame;       // Alternates while overloaded, so every other raw frame is dropped
+} depth_engine_session_t;
+
+// A raw capture from its submit to the depth engine until the capture with its depth and IR images is published
+typedef struct _depth_engine_frame_t
+{
+    k4a_capture_t capture_raw;
+    k4a_image_t image_raw;
+    uint8_t *output_buffer;           // Owned by the frame until the images of the capture wrap it
+    depth_output_ring_t *output_ring; // Ring output_buffer is returned to, NULL if it came from the allocator
+    deloader_depth_engine_frame_t engine_frame;
+    k4a_transform_engine_gpu_output_t gpu_output;
+    tickcounter_ms_t start_time;
+    uint64_t engine_start_nsec;
+} depth_engine_frame_t;
+
+// Gets an output buffer for the raw capture of frame and submits it to the depth engine
+static k4a_result_t depth_engine_frame_submit(dewrapper_context_t *dewrapper,
+                                              depth_engine_session_t *session,
+                                              depth_engine_frame_t *frame)
+{
+    frame->image_raw = capture_get_ir_image(frame->capture_raw);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(frame->image_raw != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Get 1 buffer for depth engine to write depth and IR images to, from the ring if one is free. It only
+        // holds the depth image with K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY.
+        assert(session->output_buffer_size != 0);
+        if (dewrapper->output_ring)
+        {
+            frame->output_buffer = depth_output_ring_take(dewrapper->output_ring);
+            if (frame->output_buffer)
+            {
+                frame->output_ring = dewrapper->output_ring;
+            }
+        }
+        if (frame->output_buffer == NULL)
+        {
+            frame->output_buffer = allocator_alloc_image(ALLOCATION_SOURCE_DEPTH,
+                                                         K4A_IMAGE_FORMAT_DEPTH16,
+                                                         session->output_buffer_size);
+        }
+        if (frame->output_buffer == NULL)
+        {
+            LOG_ERROR("Depth streaming callback failed to allocate output buffer", 0);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        deloader_depth_engine_frame_t *engine_frame = &frame->engine_frame;
+        engine_frame->input_frame = image_get_buffer(frame->image_raw);
+        engine_frame->input_frame_size = image_get_size(frame->image_raw);
+        engine_frame->output_type = session->output_type;
+        engine_frame->output_frame = frame->output_buffer;
+        engine_frame->output_frame_size = session->output_buffer_size;
+
+        // The system timestamp of the raw image was taken when its USB transfer completed
+        frame->engine_start_nsec = latency_get_time_nsec();
+        latency_record(K4A_LATENCY_STAGE_DEPTH_QUEUE,
+                       image_get_system_timestamp_nsec(frame->image_raw),
+                       frame->engine_start_nsec);
+
+        logger_trace(LOGGER_TRACE_DEPTH_ENGINE_START,
+                     image_get_device_timestamp_usec(frame->image_raw),
+                     (uint64_t)engine_frame->input_frame_size,
+                     0);
+
+        tickcounter_get_current_ms(dewrapper->tick, &frame->start_time);
+        // GPU export and shared depth engines process the frame at submit, it completes with their result
+        k4a_depth_engine_result_code_t deresult = K4A_DEPTH_ENGINE_RESULT_SUCCEEDED;
+        bool skip_depth_readback = dewrapper->gpu_export_config.skip_depth_readback;
+        if (session->gpu_export)
+        {
+            engine_frame->result = deloader_depth_engine_process_frame_gpu(dewrapper->depth_engine,
+                                                                           engine_frame->input_frame,
+                                                                           engine_frame->input_frame_size,
+                                                                           engine_frame->output_type,
+                                                                           engine_frame->output_frame,
+                                                                           engine_frame->output_frame_size,
+                                                                           skip_depth_readback,
+                                                                           &engine_frame->output_frame_info,
+                                                                           NULL,
+                                                                           session->gpu_export_type,
+                                                                           session->gpu_export_slot,
+                                                                           K4A_DEPTH_GPU_EXPORT_SLOT_COUNT,
+                                                                           &frame->gpu_output);
+            session->gpu_export_slot = (session->gpu_export_slot + 1) % K4A_DEPTH_GPU_EXPORT_SLOT_COUNT;
+        }
+        else if (dewrapper->depth_engine_shared)
+        {
+            engine_frame->result = deloader_depth_engine_process_frame_shared(dewrapper->depth_engine,
+                                                                              engine_frame->input_frame,
+                                                                              engine_frame->input_frame_size,
+                                                                              engine_frame->output_type,
+                                                                              engine_frame->output_frame,
+                                                                              engine_frame->output_frame_size,
+                                                                              &engine_frame->output_frame_info,
+                                                                              NULL);
+        }
+        else
+        {
+            deresult = deloader_depth_engine_submit_frame(dewrapper->depth_engine, engine_frame);
+        }
+
+        if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+        {
+            LOG_ERROR("Depth engine submit frame failed with error code: %d.", deresult);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    return result;
+}
+
+// Updates the overload state of the session with the compute time of a completed frame. Returns true when it changed.
+static bool depth_engine_update_overload(dewrapper_context_t *dewrapper,
+                                         depth_engine_session_t *session,
+                                         uint64_t compute_time_usec)
+{
+    if (dewrapper->overload_config.frame_count == 0)
+    {
+        return false;
+    }
+
+    bool slow = compute_time_usec > session->frame_period_usec;
+    if (slow == session->overloaded)
+    {
+        session->overload_streak = 0;
+        return false;
+    }
+
+    if (++session->overload_streak < dewrapper->overload_config.frame_count)
+    {
+        return false;
+    }
+
+    session->overload_streak = 0;
+    session->overloaded = slow;
+    return true;
+}
+
+// Tells the application the overload state changed, from the depth engine thread
+static void depth_engine_notify_overload(dewrapper_context_t *dewrapper, bool overloaded, uint64_t compute_time_usec)
+{
+    if (overloaded)
+    {
+        LOG_WARNING("Depth engine overloaded at %llu us per frame, dropping raw frames",
+                    (unsigned long long)compute_time_usec);
+    }
+    else
+    {
+        LOG_INFO("Depth engine no longer overloaded at %llu us per frame", (unsigned long long)compute_time_usec);
+    }
+
+    if (dewrapper->overload_config.callback)
+    {
+        dewrapper->overload_config.callback(dewrapper->overload_config.callback_context,
+                                            overloaded,
+                                            (uint32_t)compute_time_usec);
+    }
+}
+
+// While overloaded, replaces capture_raw with the newest raw capture of the queue and drops every other one, so the
+// depth engine has two frame periods per frame and captures don't wait behind stale raw frames. Returns the raw capture
+// to process, NULL when it was dropped.
+static k4a_capture_t depth_engine_drop_overload_frames(dewrapper_context_t *dewrapper,
+                                                       depth_engine_session_t *session,
+                                                       k4a_capture_t capture_raw)
+{
+    uint64_t dropped = 0;
+    k4a_capture_t newer_capture_raw = NULL;
+    while (queue_pop(dewrapper->queue, 0, &newer_capture_raw) == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        capture_dec_ref(capture_raw);
+        capture_raw = newer_capture_raw;
+        dropped++;
+    }
+
+    session->drop_next_frame = !session->drop_next_frame;
+    if (session->drop_next_frame)
+    {
+        capture_dec_ref(capture_raw);
+        capture_raw = NULL;
+        dropped++;
+    }
+
+    if (dropped != 0)
+    {
+        Lock(dewrapper->lock);
+        dewrapper->stats.overload_dropped_frames += dropped;
+        Unlock(dewrapper->lock);
+    }
+
+    return capture_raw;
+}
+
+// Waits for the depth engine to complete frame and publishes its capture. Sets dropped for failures that don't stop
+// the depth engine.
+static k4a_result_t depth_engine_frame_complete(dewrapper_context_t *dewrapper,
+                                                depth_engine_session_t *session,
+                                                depth_engine_frame_t *frame,
+                                                bool *dropped)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_capture_t capture = NULL;
+    shared_image_context_t *shared_image_context = NULL;
+    tickcounter_ms_t stop_time = 0;
+    bool slow = false;
+    const k4a_depth_engine_output_frame_info_t *outputCaptureInfo = &frame->engine_frame.output_frame_info;
+
+    k4a_depth_engine_result_code_t deresult = deloader_depth_engine_complete_frame(dewrapper->depth_engine,
+                                                                                   &frame->engine_frame);
+    tickcounter_get_current_ms(dewrapper->tick, &stop_time);
+    uint64_t engine_end_nsec = latency_get_time_nsec();
+    uint64_t compute_time_usec = 0;
+    if (engine_end_nsec > frame->engine_start_nsec)
+    {
+        compute_time_usec = (engine_end_nsec - frame->engine_start_nsec) / 1000;
+    }
+    bool overload_changed = false;
+    if (deresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_WAIT_PROCESSING_COMPLETE_FAILED ||
+        deresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_TIMEOUT)
+    {
+        LOG_ERROR("Timeout during depth engine process frame.", 0);
+        LOG_ERROR("SDK should be restarted since it looks like GPU has encountered an unrecoverable error.", 0);
+        *dropped = true;
+        result = K4A_RESULT_FAILED;
+    }
+    else if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        LOG_ERROR("Depth engine process frame failed with error code: %d.", deresult);
+        result = K4A_RESULT_FAILED;
+    }
+    else if ((stop_time - frame->start_time) > (unsigned)session->max_compute_time_ms)
+    {
+        slow = true;
+        LOG_WARNING("Depth image processing is too slow at %lldms (this may be transient).",
+                    stop_time - frame->start_time);
+    }
+
+    if (deresult == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        overload_changed = depth_engine_update_overload(dewrapper, session, compute_time_usec);
+    }
+
+    if (K4A_SUCCEEDED(result) && session->received_valid_image && outputCaptureInfo->center_of_exposure_in_ticks == 0)
+    {
+        // We drop samples with a timestamp of zero when starting up.
+        LOG_WARNING("Dropping depth image due to bad timestamp at startup", 0);
+        *dropped = true;
+        result = K4A_RESULT_FAILED;
+    }
+
+    logger_trace(LOGGER_TRACE_DEPTH_ENGINE_END,
+                 outputCaptureInfo->center_of_exposure_in_ticks,
+                 (uint64_t)deresult,
+                 (uint64_t)*dropped);
+
+    Lock(dewrapper->lock);
+    if (K4A_SUCCEEDED(result))
+    {
+        dewrapper->stats.processed_frames++;
+    }
+    else
+    {
+        dewrapper->stats.failed_frames++;
+    }
+    if (slow)
+    {
+        dewrapper->stats.slow_frames++;
+    }
+    dewrapper->stats.max_compute_time_ms = (uint32_t)session->max_compute_time_ms;
+    dewrapper->stats.last_compute_time_ms = (uint32_t)(stop_time - frame->start_time);
+    if (deresult == K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        dewrapper->stats.compute_time_histogram[latency_get_histogram_bucket(compute_time_usec)]++;
+        dewrapper->stats.compute_time_total_usec += compute_time_usec;
+    }
+    if (overload_changed)
+    {
+        dewrapper->stats.overloaded = session->overloaded;
+        if (session->overloaded)
+        {
+            dewrapper->stats.overloads++;
+        }
+    }
+    Unlock(dewrapper->lock);
+
+    if (overload_changed)
+    {
+        depth_engine_notify_overload(dewrapper, session->overloaded, compute_time_usec);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Pooled like the image handles, so steady state streaming doesn't go to the heap for it
+        shared_image_context = (shared_image_context_t *)allocator_handle_alloc(HANDLE_POOL_SHARED_BUFFER,
+                                                                                sizeof(shared_image_context_t));
+        result = K4A_RESULT_FROM_BOOL(shared_image_context != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        shared_image_context->ref = 0;
+        shared_image_context->buffer = frame->output_buffer;
+        shared_image_context->ring = frame->output_ring;
+
+        result = TRACE_CALL(capture_create(&capture));
+    }
+
+    // The depth plane is still part of the output buffer when its readback is skipped, but it holds no image
+    bool depth_image_present = session->depth16_present &&
+                               !(session->gpu_export && dewrapper->gpu_export_config.skip_depth_readback);
+
+    // The depth and IR images carry the resource they were exported to
+    k4a_gpu_resource_t gpu_resource = { 0 };
+    if (session->gpu_export)
+    {
+        gpu_resource.type = dewrapper->gpu_export_config.type;
+        gpu_resource.format = session->depth16_present ? K4A_IMAGE_FORMAT_DEPTH16 : K4A_IMAGE_FORMAT_IR16;
+        gpu_resource.width_pixels = (int)outputCaptureInfo->output_width;
+        gpu_resource.height_pixels = (int)outputCaptureInfo->output_height;
+        gpu_resource.stride_bytes = (int)outputCaptureInfo->output_width * (int)sizeof(uint16_t);
+        gpu_resource.size = frame->gpu_output.size;
+        gpu_resource.handle = frame->gpu_output.handle;
+        gpu_resource.fence = frame->gpu_output.fence;
+    }
+
+    if (K4A_SUCCEEDED(result) && depth_image_present && session->depth_filter_pending)
+    {
+        // The filter is sized by the depth engine output, not fatal if it can't be created
+        session->depth_filter_pending = false;
+        if (K4A_FAILED(TRACE_CALL(depthfilter_create(&dewrapper->depth_filter_config,
+                                                     (int)outputCaptureInfo->output_width,
+                                                     (int)outputCaptureInfo->output_height,
+                                                     &dewrapper->depth_filter))))
+        {
+            LOG_WARNING("Could not create the depth filter, depth images are delivered unfiltered", 0);
+        }
+    }
+
+    uint8_t *output_buffer = frame->output_buffer;
+    if (K4A_SUCCEEDED(result) && depth_image_present)
+    {
+        k4a_image_t image;
+        int stride_bytes = (int)outputCaptureInfo->output_width * (int)sizeof(uint16_t);
+        if (dewrapper->depth_filter)
+        {
+            // Filtered in the depth engine output buffer, which the depth image wraps without a copy
+            depthfilter_process(dewrapper->depth_filter, (uint16_t *)(void *)output_buffer);
+        }
+
+        // Computed while the filtered pixels are still in cache, so consumers don't each make a pass over them
+        k4a_depth_statistics_t depth_statistics;
+        depthfilter_compute_statistics((const uint16_t *)(const void *)output_buffer,
+                                       (int)outputCaptureInfo->output_width,
+                                       (int)outputCaptureInfo->output_height,
+                                       &depth_statistics);
+        result = TRACE_CALL(image_create_from_buffer(K4A_IMAGE_FORMAT_DEPTH16,
+                                                     outputCaptureInfo->output_width,
+                                                     outputCaptureInfo->output_height,
+                                                     stride_bytes,
+                                                     output_buffer,
+                                                     (size_t)stride_bytes * (size_t)outputCaptureInfo->output_height,
+                                                     free_shared_depth_image,
+                                                     shared_image_context,
+                                                     &image));
+        if (K4A_SUCCEEDED(result))
+        {
+            frame->output_buffer = NULL; // buffer is now owned by image;
+            INC_REF_VAR(shared_image_context->ref);
+            image_set_device_timestamp_usec(image,
+                                            K4A_90K_HZ_TICK_TO_USEC(outputCaptureInfo->center_of_exposure_in_ticks));
+            image_set_system_timestamp_nsec(image, image_get_system_timestamp_nsec(frame->image_raw));
+            image_set_depth_statistics(image, &depth_statistics);
+            image_set_compute_time_usec(image, compute_time_usec);
+            if (session->gpu_export)
+            {
+                image_set_gpu_resource(image, &gpu_resource);
+            }
+            capture_set_depth_image(capture, image);
+            image_dec_ref(image);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && session->output_type != K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY)
+    {
+        k4a_image_t image;
+        int stride_bytes = (int)outputCaptureInfo->output_width * (int)sizeof(uint16_t);
+        uint8_t *image_buf = output_buffer;
+        if (session->depth16_present)
+        {
+            image_buf = image_buf + stride_bytes * outputCaptureInfo->output_height;
+        }
+
+        if (dewrapper->ir8_enabled)
+        {
+            // Tone mapped to an image of its own, the output buffer goes back with the depth image or right away
+            result = TRACE_CALL(image_create(K4A_IMAGE_FORMAT_CUSTOM8,
+                                             (int)outputCaptureInfo->output_width,
+                                             (int)outputCaptureInfo->output_height,
+                                             (int)outputCaptureInfo->output_width,
+                                             ALLOCATION_SOURCE_DEPTH,
+                                             &image));
+            if (K4A_SUCCEEDED(result))
+            {
+                depthfilter_tone_map_ir(&dewrapper->ir8_config,
+                                        (const uint16_t *)(const void *)image_buf,
+                                        (int)outputCaptureInfo->output_width,
+                                        (int)outputCaptureInfo->output_height,
+                                        image_get_buffer(image));
+            }
+        }
+        else
+        {
+            result = TRACE_CALL(
+                image_create_from_buffer(K4A_IMAGE_FORMAT_IR16,
+                                         outputCaptureInfo->output_width,
+                                         outputCaptureInfo->output_height,
+                                         stride_bytes,
+                                         image_buf,
+                                         (size_t)stride_bytes * (size_t)outputCaptureInfo->output_height,
+                                         free_shared_depth_image,
+                                         shared_image_context,
+                                         &image));
+            if (K4A_SUCCEEDED(result))
+            {
+                frame->output_buffer = NULL; // buffer is now owned by image;
+                INC_REF_VAR(shared_image_context->ref);
+            }
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            image_set_device_timestamp_usec(image,
+                                            K4A_90K_HZ_TICK_TO_USEC(outputCaptureInfo->center_of_exposure_in_ticks));
+            image_set_system_timestamp_nsec(image, image_get_system_timestamp_nsec(frame->image_raw));
+            image_set_compute_time_usec(image, compute_time_usec);
+            if (session->gpu_export && !dewrapper->ir8_enabled)
+            {
+                image_set_gpu_resource(image, &gpu_resource);
+            }
+            capture_set_ir_image(capture, image);
+            image_dec_ref(image);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // set capture attributes
+        capture_set_temperature_c(capture, outputCaptureInfo->sensor_temp);
+
+        latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, frame->engine_start_nsec, engine_end_nsec);
+        capture_set_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_DEPTH_QUEUE, frame->engine_start_nsec);
+        capture_set_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_DEPTH_ENGINE, engine_end_nsec);
+
+        session->received_valid_image = true;
+        if (dewrapper->output_queue)
+        {
+            queue_push(dewrapper->output_queue, capture);
+        }
+        else
+        {
+            dewrapper->capture_ready_cb(result, capture, dewrapper->capture_ready_cb_context);
+        }
+    }
+
+    if (shared_image_context && shared_image_context->ref == 0)
+    {
+        // No image wraps the buffer, after a failure or when the only IR image is tone mapped to a buffer of its own
+        allocator_handle_free(HANDLE_POOL_SHARED_BUFFER, shared_image_context);
+    }
+
+    if (capture)
+    {
+        capture_dec_ref(capture);
+    }
+
+    return result;
+}
+
+// Releases what frame still holds, a frame still in flight must have been completed
+static void depth_engine_frame_release(depth_engine_frame_t *frame)
+{
+    if (frame->capture_raw)
+    {
+        capture_dec_ref(frame->capture_raw);
+    }
+    if (frame->image_raw)
+    {
+        image_dec_ref(frame->image_raw);
+    }
+
+    if (frame->output_buffer)
+    {
+        if (frame->output_ring)
+        {
+            depth_output_ring_return(frame->output_ring, frame->output_buffer);
+        }
+        else
+        {
+            allocator_free(frame->output_buffer);
+        }
+    }
+
+    memset(frame, 0, sizeof(*frame));
+}
+
+// Runs the depth engine from dewrapper_start() to dewrapper_stop()
+static k4a_result_t depth_engine_session(dewrapper_context_t *dewrapper)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    depth_engine_session_t session = { 0 };
+    session.depth_filter_pending = depthfilter_is_enabled(&dewrapper->depth_filter_config);
+    session.gpu_export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_TEXTURE;
+    session.output_type = K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH;
+    session.depth16_present = (dewrapper->depth_mode == K4A_DEPTH_MODE_NFOV_2X2BINNED ||
+                               dewrapper->depth_mode == K4A_DEPTH_MODE_NFOV_UNBINNED ||
+                               dewrapper->depth_mode == K4A_DEPTH_MODE_WFOV_2X2BINNED ||
+                               dewrapper->depth_mode == K4A_DEPTH_MODE_WFOV_UNBINNED);
+
+    // Frames in flight, oldest first
+    depth_engine_frame_t frames[K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT];
+    uint32_t first_frame = 0;
+    uint32_t frame_count = 0;
+    memset(frames, 0, sizeof(frames));
+
+    result = TRACE_CALL(depth_engine_start_helper(dewrapper,
+                                                  dewrapper->fps,
+                                                  dewrapper->depth_mode,
+                                                  &session.max_compute_time_ms,
+                                                  &session.output_buffer_size));
+
+    if (K4A_SUCCEEDED(result) && dewrapper->gpu_export_enabled)
+    {
+        // Not fatal, the captures are delivered in host memory only
+        if (!deloader_depth_engine_supports_gpu_export())
+        {
+            LOG_WARNING("The depth engine plugin does not export GPU resources, depth is read back to host memory", 0);
+        }
+        else if (dewrapper->depth_engine_shared)
+        {
+            LOG_WARNING("A shared depth engine does not export GPU resources, depth is read back to host memory", 0);
+        }
+        else
+        {
+            session.gpu_export = deloader_get_gpu_export_type(dewrapper->gpu_export_config.type,
+                                                              &session.gpu_export_type);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && dewrapper->depth_only)
+    {
+        // Not fatal either, captures then carry the IR image as well. A capture needs at least one image, so the IR
+        // image stays when the depth image is not read back.
+        size_t depth_only_size = 0;
+        if (!session.depth16_present)
+        {
+            LOG_WARNING("Depth only output is ignored in a depth mode without depth images", 0);
+        }
+        else if (dewrapper->depth_engine_shared)
+        {
+            LOG_WARNING("A shared depth engine does not output depth only, the IR image is read back as well", 0);
+        }
+        else if (session.gpu_export && dewrapper->gpu_export_config.skip_depth_readback)
+        {
+            LOG_WARNING("Depth only output is ignored while the depth readback is skipped", 0);
+        }
+        else
+        {
+            depth_only_size =
+                deloader_depth_engine_get_output_type_frame_size(dewrapper->depth_engine,
+                                                                 K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY);
+            if (depth_only_size == 0)
+            {
+                LOG_WARNING("The depth engine plugin does not output depth only, the IR image is read back as well", 0);
+            }
+        }
+
+        if (depth_only_size != 0)
+        {
+            session.output_type = K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH_ONLY;
+            session.output_buffer_size = depth_only_size;
+        }
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        *depth_engine_output_buffer_size = deloader_depth_engine_get_output_frame_size(dewrapper->depth_engine);
-        result = K4A_RESULT_FROM_BOOL(0 != *depth_engine_output_buffer_size);
+        // Only one of every frame_decimation raw frames is posted to the dewrapper
+        uint32_t decimation = dewrapper->frame_decimation > 1 ? dewrapper->frame_decimation : 1;
+        session.frame_period_usec = (uint64_t)1000000 * decimation / k4a_convert_fps_to_uint(dewrapper->fps);
     }
 
-    return result;
-}
+    // GPU export and shared depth engines have no asynchronous entry points, they process one frame at a time
+    session.async = deloader_depth_engine_supports_async() && !session.gpu_export && !dewrapper->depth_engine_shared;
 
-static void depth_engine_stop_helper(dewrapper_context_t *dewrapper)
-{
-    if (dewrapper->depth_engine != NULL)
+    if (K4A_SUCCEEDED(result))
     {
-        deloader_depth_engine_destroy(&dewrapper->depth_engine);
-        dewrapper->depth_engine = NULL;
+        result = TRACE_CALL(depth_engine_pipeline_start(dewrapper));
     }
-}
 
-static int depth_engine_thread(void *param)
-{
-    dewrapper_context_t *dewrapper = (dewrapper_context_t *)param;
+    if (K4A_SUCCEEDED(result))
+    {
+        // Captures in flight to the publish thread need their own buffer as well
+        uint32_t ring_size = DEWRAPPER_OUTPUT_RING_SIZE;
+        if (dewrapper->output_queue)
+        {
+            ring_size = DEWRAPPER_OUTPUT_RING_MAX_SIZE;
+        }
 
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
-    size_t depth_engine_output_buffer_size;
-    int depth_engine_max_compute_time_ms;
-    bool received_valid_image = false;
+        // A memory budget limits the ring to its share, frames beyond it allocate their own output buffer
+        ring_size = allocator_budget_count(MEMORY_BUDGET_CAPTURES, session.output_buffer_size, 2, ring_size);
 
-    result = TRACE_CALL(depth_engine_start_helper(dewrapper,
-                                                  dewrapper->fps,
-                                                  dewrapper->depth_mode,
-                                                  &depth_engine_max_compute_time_ms,
-                                                  &depth_engine_output_buffer_size));
+        k4a_result_t ring_result = TRACE_CALL(
+            depth_output_ring_create(session.output_buffer_size, ring_size, &dewrapper->output_ring));
+        if (K4A_FAILED(ring_result))
+        {
+            // Not fatal, every frame will allocate its output buffer instead
+            LOG_WARNING("Could not allocate a ring of %d depth engine output buffers", ring_size);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && session.async && dewrapper->output_ring)
+    {
+        // Not fatal, the depth engine then reads back to buffers it doesn't know in advance
+        k4a_depth_engine_result_code_t deresult =
+            deloader_depth_engine_register_output_frames(dewrapper->depth_engine,
+                                                         (void *const *)dewrapper->output_ring->buffers,
+                                                         dewrapper->output_ring->buffer_count,
+                                                         session.output_buffer_size);
+        if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+        {
+            LOG_WARNING("Depth engine register output frames failed with error code: %d.", deresult);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result) && session.async)
+    {
+        LOG_INFO("Depth engine processes up to %d frames at a time", K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT);
+    }
 
     // The Start routine is blocked waiting for this thread to complete startup, so we signal it here and share our
     // startup status.
@@ -203,204 +1165,105 @@ static int depth_engine_thread(void *param)
 
     // NOTE: Failures after this point are reported to the user via the k4a_device_get_capture()
 
+    uint32_t max_frame_count = session.async ? K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT : 1;
     while (result != K4A_RESULT_FAILED && dewrapper->thread_stop == false)
     {
-        k4a_capture_t capture = NULL;
         k4a_capture_t capture_raw = NULL;
-        k4a_image_t image_raw = NULL;
-        k4a_depth_engine_output_frame_info_t outputCaptureInfo = { 0 };
-        uint8_t *capture_byte_ptr = NULL;
-        bool cleanup_capture_byte_ptr = true;
-        shared_image_context_t *shared_image_context = NULL;
-        uint8_t *raw_image_buffer = NULL;
-        size_t raw_image_buffer_size = 0;
         bool dropped = false;
 
-        k4a_wait_result_t wresult = queue_pop(dewrapper->queue, K4A_WAIT_INFINITE, &capture_raw);
-        if (wresult != K4A_WAIT_RESULT_SUCCEEDED)
-        {
-            result = K4A_RESULT_FAILED;
-        }
-
-        if (K4A_SUCCEEDED(result))
-        {
-            image_raw = capture_get_ir_image(capture_raw);
-            result = K4A_RESULT_FROM_BOOL(image_raw != NULL);
-        }
-
-        if (K4A_SUCCEEDED(result))
+        // A frame the depth engine already finished is published before more raw frames are submitted, so its capture
+        // doesn't wait for the frames in flight behind it. Poll failures are reported when the frame is completed.
+        bool oldest_completed = false;
+        if (frame_count > 0 && session.async)
         {
-            raw_image_buffer = image_get_buffer(image_raw);
-            raw_image_buffer_size = image_get_size(image_raw);
-
-            // Allocate 1 buffer for depth engine to write depth and IR images to
-            assert(depth_engine_output_buffer_size != 0);
-            capture_byte_ptr = allocator_alloc(ALLOCATION_SOURCE_DEPTH, depth_engine_output_buffer_size);
-            if (capture_byte_ptr == NULL)
+            k4a_depth_engine_result_code_t deresult =
+                deloader_depth_engine_poll_frame(dewrapper->depth_engine,
+                                                 &frames[first_frame].engine_frame,
+                                                 &oldest_completed);
+            if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
             {
-                LOG_ERROR("Depth streaming callback failed to allocate output buffer", 0);
-                result = K4A_RESULT_FAILED;
+                oldest_completed = true;
             }
         }
 
-        if (K4A_SUCCEEDED(result))
+        if (frame_count < max_frame_count && !oldest_completed)
         {
-            tickcounter_ms_t start_time = 0;
-            tickcounter_ms_t stop_time = 0;
-
-            tickcounter_get_current_ms(dewrapper->tick, &start_time);
-            k4a_depth_engine_result_code_t deresult =
-                deloader_depth_engine_process_frame(dewrapper->depth_engine,
-                                                    raw_image_buffer,
-                                                    raw_image_buffer_size,
-                                                    K4A_DEPTH_ENGINE_OUTPUT_TYPE_Z_DEPTH,
-                                                    capture_byte_ptr,
-                                                    depth_engine_output_buffer_size,
-                                                    &outputCaptureInfo,
-                                                    NULL);
-            tickcounter_get_current_ms(dewrapper->tick, &stop_time);
-            if (deresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_WAIT_PROCESSING_COMPLETE_FAILED ||
-                deresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_TIMEOUT)
+            // Only wait for a raw capture when no frame is in flight, otherwise the oldest frame is completed
+            k4a_wait_result_t wresult = queue_pop(dewrapper->queue,
+                                                  frame_count == 0 ? K4A_WAIT_INFINITE : 0,
+                                                  &capture_raw);
+            if (wresult == K4A_WAIT_RESULT_FAILED)
             {
-                LOG_ERROR("Timeout during depth engine process frame.", 0);
-                LOG_ERROR("SDK should be restarted since it looks like GPU has encountered an unrecoverable error.", 0);
-                dropped = true;
                 result = K4A_RESULT_FAILED;
             }
-            else if (deresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
-            {
-                LOG_ERROR("Depth engine process frame failed with error code: %d.", deresult);
-                result = K4A_RESULT_FAILED;
-            }
-            else if ((stop_time - start_time) > (unsigned)depth_engine_max_compute_time_ms)
-            {
-                LOG_WARNING("Depth image processing is too slow at %lldms (this may be transient).",
-                            stop_time - start_time);
-            }
-        }
-
-        if (K4A_SUCCEEDED(result) && received_valid_image && outputCaptureInfo.center_of_exposure_in_ticks == 0)
-        {
-            // We drop samples with a timestamp of zero when starting up.
-            LOG_WARNING("Dropping depth image due to bad timestamp at startup", 0);
-            dropped = true;
-            result = K4A_RESULT_FAILED;
         }
 
-        if (K4A_SUCCEEDED(result))
+        if (K4A_SUCCEEDED(result) && capture_raw != NULL && session.overloaded)
         {
-            shared_image_context = (shared_image_context_t *)malloc(sizeof(shared_image_context_t));
-            result = K4A_RESULT_FROM_BOOL(shared_image_context != NULL);
+            capture_raw = depth_engine_drop_overload_frames(dewrapper, &session, capture_raw);
         }
 
-        if (K4A_SUCCEEDED(result))
+        if (K4A_SUCCEEDED(result) && capture_raw != NULL)
         {
-            shared_image_context->ref = 0;
-            shared_image_context->buffer = capture_byte_ptr;
-
-            result = TRACE_CALL(capture_create(&capture));
+            depth_engine_frame_t *frame = &frames[(first_frame + frame_count) % K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT];
+            frame->capture_raw = capture_raw;
+            frame_count++;
+            result = TRACE_CALL(depth_engine_frame_submit(dewrapper, &session, frame));
         }
-
-        bool depth16_present = (dewrapper->depth_mode == K4A_DEPTH_MODE_NFOV_2X2BINNED ||
-                                dewrapper->depth_mode == K4A_DEPTH_MODE_NFOV_UNBINNED ||
-                                dewrapper->depth_mode == K4A_DEPTH_MODE_WFOV_2X2BINNED ||
-                                dewrapper->depth_mode == K4A_DEPTH_MODE_WFOV_UNBINNED);
-
-        if (K4A_SUCCEEDED(result) & depth16_present)
+        else if (K4A_SUCCEEDED(result) && frame_count > 0)
         {
-            k4a_image_t image;
-            int stride_bytes = (int)outputCaptureInfo.output_width * (int)sizeof(uint16_t);
-            result = TRACE_CALL(image_create_from_buffer(K4A_IMAGE_FORMAT_DEPTH16,
-                                                         outputCaptureInfo.output_width,
-                                                         outputCaptureInfo.output_height,
-                                                         stride_bytes,
-                                                         capture_byte_ptr,
-                                                         (size_t)stride_bytes * (size_t)outputCaptureInfo.output_height,
-                                                         free_shared_depth_image,
-                                                         shared_image_context,
-                                                         &image));
-            if (K4A_SUCCEEDED(result))
-            {
-                cleanup_capture_byte_ptr = false; // buffer is now owned by image;
-                INC_REF_VAR(shared_image_context->ref);
-                image_set_device_timestamp_usec(image,
-                                                K4A_90K_HZ_TICK_TO_USEC(outputCaptureInfo.center_of_exposure_in_ticks));
-                image_set_system_timestamp_nsec(image, image_get_system_timestamp_nsec(image_raw));
-                capture_set_depth_image(capture, image);
-                image_dec_ref(image);
-            }
+            depth_engine_frame_t *frame = &frames[first_frame];
+            result = TRACE_CALL(depth_engine_frame_complete(dewrapper, &session, frame, &dropped));
+            depth_engine_frame_release(frame);
+            first_frame = (first_frame + 1) % K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT;
+            frame_count--;
         }
 
-        if (K4A_SUCCEEDED(result))
+        if (dropped)
         {
-            k4a_image_t image;
-            int stride_bytes = (int)outputCaptureInfo.output_width * (int)sizeof(uint16_t);
-            uint8_t *image_buf = capture_byte_ptr;
-            if (depth16_present)
-            {
-                image_buf = image_buf + stride_bytes * outputCaptureInfo.output_height;
-            }
-
-            result = TRACE_CALL(image_create_from_buffer(K4A_IMAGE_FORMAT_IR16,
-                                                         outputCaptureInfo.output_width,
-                                                         outputCaptureInfo.output_height,
-                                                         stride_bytes,
-                                                         image_buf,
-                                                         (size_t)stride_bytes * (size_t)outputCaptureInfo.output_height,
-                                                         free_shared_depth_image,
-                                                         shared_image_context,
-                                                         &image));
-            if (K4A_SUCCEEDED(result))
-            {
-                cleanup_capture_byte_ptr = false; // buffer is now owned by image;
-                INC_REF_VAR(shared_image_context->ref);
-                image_set_device_timestamp_usec(image,
-                                                K4A_90K_HZ_TICK_TO_USEC(outputCaptureInfo.center_of_exposure_in_ticks));
-                image_set_system_timestamp_nsec(image, image_get_system_timestamp_nsec(image_raw));
-                capture_set_ir_image(capture, image);
-                image_dec_ref(image);
-            }
+            // It is not a fatal error when we drop a frame, so we reset 'result' so that we can continue to run.
+            result = K4A_RESULT_SUCCEEDED;
         }
+    }
 
-        if (K4A_SUCCEEDED(result))
-        {
-            // set capture attributes
-            capture_set_temperature_c(capture, outputCaptureInfo.sensor_temp);
+    // Frames still in flight are waited for and dropped, the depth engine may still write their output buffers
+    while (frame_count > 0)
+    {
+        depth_engine_frame_t *frame = &frames[first_frame];
+        (void)deloader_depth_engine_complete_frame(dewrapper->depth_engine, &frame->engine_frame);
+        depth_engine_frame_release(frame);
+        first_frame = (first_frame + 1) % K4A_DEPTH_ENGINE_MAX_FRAMES_IN_FLIGHT;
+        frame_count--;
+    }
 
-            received_valid_image = true;
-            dewrapper->capture_ready_cb(result, capture, dewrapper->capture_ready_cb_context);
-        }
+    if (session.async && dewrapper->output_ring)
+    {
+        // A kept depth engine must not hold on to the buffers of this session
+        (void)deloader_depth_engine_register_output_frames(dewrapper->depth_engine, NULL, 0, 0);
+    }
 
-        if (shared_image_context && shared_image_context->ref == 0)
-        {
-            // It didn't get used due to a failure
-            free(shared_image_context);
-        }
+    depth_engine_pipeline_stop(dewrapper);
 
-        if (capture)
-        {
-            capture_dec_ref(capture);
-        }
-        if (capture_raw)
-        {
-            capture_dec_ref(capture_raw);
-        }
-        if (image_raw)
-        {
-            image_dec_ref(image_raw);
-            image_raw = NULL;
-        }
+    if (session.overloaded)
+    {
+        // Raw frames stop being dropped with the session
+        Lock(dewrapper->lock);
+        dewrapper->stats.overloaded = false;
+        Unlock(dewrapper->lock);
+        depth_engine_notify_overload(dewrapper, false, 0);
+    }
 
-        if (capture_byte_ptr && cleanup_capture_byte_ptr)
-        {
-            allocator_free(capture_byte_ptr);
-        }
+    if (dewrapper->depth_filter)
+    {
+        depthfilter_destroy(dewrapper->depth_filter);
+        dewrapper->depth_filter = NULL;
+    }
 
-        if (dropped)
-        {
-            // It is not a fatal error when we drop a frame, so we reset 'result' so that we can continue to run.
-            result = K4A_RESULT_SUCCEEDED;
-        }
+    // Captures still held by the user keep their own reference on the ring
+    if (dewrapper->output_ring)
+    {
+        depth_output_ring_dec_ref(dewrapper->output_ring);
+        dewrapper->output_ring = NULL;
     }
 
     if (K4A_FAILED(result))
@@ -408,9 +1271,60 @@ static int depth_engine_thread(void *param)
         dewrapper->capture_ready_cb(result, NULL, dewrapper->capture_ready_cb_context);
     }
 
-    depth_engine_stop_helper(dewrapper);
+    // Shared depth engines aren't kept, an idle member would hold up the batches of its group. An engine that failed
+    // isn't kept either.
+    bool keep = dewrapper->keep_depth_engine || dewrapper->restarting;
+    if (!keep || dewrapper->depth_engine_shared || !dewrapper->thread_stop)
+    {
+        depth_engine_stop_helper(dewrapper);
+    }
 
     // This will always return failure, because stop is trigged by the queue being disabled
+    return result;
+}
+
+// Waits for the next dewrapper_start() when the depth engine is kept. Returns false when the thread should exit.
+static bool depth_engine_thread_park(dewrapper_context_t *dewrapper)
+{
+    Lock(dewrapper->lock);
+    if (!dewrapper->keep_depth_engine && !dewrapper->restarting)
+    {
+        // A restart waiting for the thread to park joins it instead
+        dewrapper->thread_exited = true;
+        Condition_Post(dewrapper->park_condition);
+        Unlock(dewrapper->lock);
+        return false;
+    }
+
+    dewrapper->thread_parked = true;
+    Condition_Post(dewrapper->park_condition);
+    while (dewrapper->thread_parked && !dewrapper->thread_exit)
+    {
+        int infinite_timeout = 0;
+        (void)Condition_Wait(dewrapper->park_condition, dewrapper->lock, infinite_timeout);
+    }
+    bool resume = !dewrapper->thread_exit;
+    Unlock(dewrapper->lock);
+
+    return resume;
+}
+
+static int depth_engine_thread(void *param)
+{
+    dewrapper_context_t *dewrapper = (dewrapper_context_t *)param;
+    k4a_result_t result;
+
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_DEPTH_ENGINE);
+    allocator_set_thread_numa_node(dewrapper->numa_node);
+
+    // The depth engine is created, used and destroyed on this thread, it may be bound to the thread's GPU context
+    do
+    {
+        result = depth_engine_session(dewrapper);
+    } while (depth_engine_thread_park(dewrapper));
+
+    depth_engine_stop_helper(dewrapper);
+
     return (int)result;
 }
 
@@ -429,6 +1343,9 @@ dewrapper_t dewrapper_create(k4a_calibration_camera_t *calibration,
     dewrapper->capture_ready_cb = capture_ready_cb;
     dewrapper->capture_ready_cb_context = capture_ready_context;
     dewrapper->thread_start_result = K4A_RESULT_FAILED;
+    dewrapper->numa_node = -1;
+    dewrapper->gpu_index = K4A_DEPTH_ENGINE_GPU_DEFAULT;
+    dewrapper->gpu_reserved = -1;
     dewrapper->tick = tickcounter_create();
     result = K4A_RESULT_FROM_BOOL(NULL != dewrapper->tick);
 
@@ -441,11 +1358,12 @@ dewrapper_t dewrapper_create(k4a_calibration_camera_t *calibration,
     if (K4A_SUCCEEDED(result))
     {
         dewrapper->condition = Condition_Init();
+        dewrapper->park_condition = Condition_Init();
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        result = TRACE_CALL(queue_create(DEWRAPPER_QUEUE_DEPTH, "dewrapper", &dewrapper->queue));
+        result = TRACE_CALL(queue_create_spsc(DEWRAPPER_QUEUE_DEPTH, "dewrapper", &dewrapper->queue));
     }
 
     if (K4A_FAILED(result))
@@ -462,7 +1380,8 @@ void dewrapper_destroy(dewrapper_t dewrapper_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
     dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
 
-    dewrapper_stop(dewrapper_handle);
+    bool exit_thread = true;
+    dewrapper_stop_internal(dewrapper_handle, exit_thread);
 
     if (dewrapper->queue)
     {
@@ -479,6 +1398,11 @@ void dewrapper_destroy(dewrapper_t dewrapper_handle)
         Condition_Deinit(dewrapper->condition);
     }
 
+    if (dewrapper->park_condition)
+    {
+        Condition_Deinit(dewrapper->park_condition);
+    }
+
     if (dewrapper->lock)
     {
         Lock_Deinit(dewrapper->lock);
@@ -486,6 +1410,128 @@ void dewrapper_destroy(dewrapper_t dewrapper_handle)
     dewrapper_t_destroy(dewrapper_handle);
 }
 
+void dewrapper_set_numa_node(dewrapper_t dewrapper_handle, int numa_node)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->numa_node = numa_node;
+}
+
+void dewrapper_set_depth_engine_gpu(dewrapper_t dewrapper_handle, int32_t gpu_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->gpu_index = gpu_index;
+}
+
+void dewrapper_set_depth_engine_shared(dewrapper_t dewrapper_handle, bool shared)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->share_depth_engine = shared;
+}
+
+void dewrapper_set_keep_depth_engine(dewrapper_t dewrapper_handle, bool keep)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->keep_depth_engine = keep;
+}
+
+void dewrapper_set_depth_filter(dewrapper_t dewrapper_handle, const k4a_depth_filter_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    if (config == NULL)
+    {
+        memset(&dewrapper->depth_filter_config, 0, sizeof(dewrapper->depth_filter_config));
+    }
+    else
+    {
+        dewrapper->depth_filter_config = *config;
+    }
+}
+
+void dewrapper_set_depth_gpu_export(dewrapper_t dewrapper_handle, const k4a_depth_gpu_export_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->gpu_export_enabled = config != NULL;
+    if (config == NULL)
+    {
+        memset(&dewrapper->gpu_export_config, 0, sizeof(dewrapper->gpu_export_config));
+    }
+    else
+    {
+        dewrapper->gpu_export_config = *config;
+    }
+}
+
+void dewrapper_set_depth_only(dewrapper_t dewrapper_handle, bool depth_only)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->depth_only = depth_only;
+}
+
+void dewrapper_set_ir8_output(dewrapper_t dewrapper_handle, const k4a_ir8_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->ir8_enabled = config != NULL;
+    if (config == NULL)
+    {
+        memset(&dewrapper->ir8_config, 0, sizeof(dewrapper->ir8_config));
+    }
+    else
+    {
+        dewrapper->ir8_config = *config;
+    }
+}
+
+void dewrapper_set_frame_decimation(dewrapper_t dewrapper_handle, uint32_t decimation)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    dewrapper->frame_decimation = decimation;
+}
+
+void dewrapper_set_overload_policy(dewrapper_t dewrapper_handle,
+                                   const k4a_depth_engine_overload_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    if (config == NULL)
+    {
+        memset(&dewrapper->overload_config, 0, sizeof(dewrapper->overload_config));
+    }
+    else
+    {
+        dewrapper->overload_config = *config;
+    }
+}
+
+void dewrapper_get_stats(dewrapper_t dewrapper_handle, dewrapper_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stats == NULL);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    Lock(dewrapper->lock);
+    *stats = dewrapper->stats;
+    Unlock(dewrapper->lock);
+}
+
 void dewrapper_post_capture(k4a_result_t cb_result, k4a_capture_t capture_raw, void *context)
 {
     dewrapper_t dewrapper_handle = (dewrapper_t)context;
@@ -519,7 +1565,8 @@ k4a_result_t dewrapper_start(dewrapper_t dewrapper_handle,
     dewrapper->calibration_memory_size = calibration_memory_size;
     dewrapper->thread_start_result = K4A_RESULT_FAILED;
 
-    k4a_result_t result = K4A_RESULT_FROM_BOOL(dewrapper->thread == NULL);
+    // A parked thread is resumed instead of starting a new one
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(dewrapper->thread == NULL || dewrapper->thread_parked);
 
     if (K4A_SUCCEEDED(result))
     {
@@ -532,8 +1579,18 @@ k4a_result_t dewrapper_start(dewrapper_t dewrapper_handle,
         dewrapper->thread_stop = false;
         dewrapper->thread_started = false;
 
-        THREADAPI_RESULT tresult = ThreadAPI_Create(&dewrapper->thread, depth_engine_thread, dewrapper);
-        result = K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK);
+        if (dewrapper->thread != NULL)
+        {
+            Lock(dewrapper->lock);
+            dewrapper->thread_parked = false;
+            Condition_Post(dewrapper->park_condition);
+            Unlock(dewrapper->lock);
+        }
+        else
+        {
+            THREADAPI_RESULT tresult = ThreadAPI_Create(&dewrapper->thread, depth_engine_thread, dewrapper);
+            result = K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK);
+        }
 
         if (K4A_SUCCEEDED(result))
         {
@@ -568,6 +1625,12 @@ k4a_result_t dewrapper_start(dewrapper_t dewrapper_handle,
 }
 
 void dewrapper_stop(dewrapper_t dewrapper_handle)
+{
+    bool exit_thread = false;
+    dewrapper_stop_internal(dewrapper_handle, exit_thread);
+}
+
+static void dewrapper_stop_internal(dewrapper_t dewrapper_handle, bool exit_thread)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, dewrapper_t, dewrapper_handle);
     dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
@@ -577,7 +1640,30 @@ void dewrapper_stop(dewrapper_t dewrapper_handle)
 
     Lock(dewrapper->lock);
     THREAD_HANDLE thread = dewrapper->thread;
-    dewrapper->thread = NULL;
+    if (thread && (dewrapper->keep_depth_engine || dewrapper->restarting) && !exit_thread)
+    {
+        // The thread keeps the depth engine and waits for the next start, unless it failed before a restart
+        while (!dewrapper->thread_parked && !dewrapper->thread_exited)
+        {
+            int infinite_timeout = 0;
+            (void)Condition_Wait(dewrapper->park_condition, dewrapper->lock, infinite_timeout);
+        }
+        if (dewrapper->thread_parked)
+        {
+            thread = NULL;
+            dewrapper->fps = (k4a_fps_t)-1;
+            dewrapper->depth_mode = K4A_DEPTH_MODE_OFF;
+        }
+    }
+    dewrapper->restarting = false;
+
+    if (thread)
+    {
+        // Wakes the thread if it is parked, it exits once its current session ends
+        dewrapper->thread = NULL;
+        dewrapper->thread_exit = true;
+        Condition_Post(dewrapper->park_condition);
+    }
     Unlock(dewrapper->lock);
 
     if (thread)
@@ -588,7 +1674,26 @@ void dewrapper_stop(dewrapper_t dewrapper_handle)
 
         dewrapper->fps = (k4a_fps_t)-1;
         dewrapper->depth_mode = K4A_DEPTH_MODE_OFF;
+        dewrapper->thread_parked = false;
+        dewrapper->thread_exit = false;
+        dewrapper->thread_exited = false;
     }
 
     queue_disable(dewrapper->queue);
 }
+
+k4a_result_t dewrapper_restart(dewrapper_t dewrapper_handle, const k4a_device_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, dewrapper_t, dewrapper_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+    dewrapper_context_t *dewrapper = dewrapper_t_get_context(dewrapper_handle);
+
+    // The thread parks across the restart even when the depth engine isn't kept, so the thread and its GPU context are
+    // reused. depth_engine_start_helper() reuses the depth engine too when the depth mode is unchanged.
+    dewrapper->restarting = true;
+    bool exit_thread = false;
+    dewrapper_stop_internal(dewrapper_handle, exit_thread);
+
+    return TRACE_CALL(dewrapper_start(
+        dewrapper_handle, config, dewrapper->calibration_memory, dewrapper->calibration_memory_size));
+}
@@ -20,7 +20,7 @@
 typedef struct _image_context_t
 {
     volatile long ref_count;
-    LOCK_HANDLE lock;
+    LOCK_HANDLE lock; // Serializes the decode of deferred images, NULL for the other images
 
     uint8_t *buffer;
     size_t buffer_size;
@@ -37,6 +37,24 @@ typedef struct _image_context_t
     image_destroy_cb_t *memory_free_cb;
     void *memory_free_cb_context;
 
+    // Deferred images hold the payload until the first image_get_buffer() decodes it, see image_create_deferred()
+    bool deferred;
+    uint8_t *payload;
+    size_t payload_size;
+    image_destroy_cb_t *payload_free_cb;
+    void *payload_free_cb_context;
+    image_decode_cb_t *decode_cb;
+    void *decode_cb_context;
+    allocation_source_t decode_source;
+
+    bool has_gpu_resource;           /** GPU resource the pixels were exported to, see image_set_gpu_resource() */
+    k4a_gpu_resource_t gpu_resource; /** Valid when has_gpu_resource is set */
+
+    bool has_depth_statistics;               /** Statistics of the pixels, see image_set_depth_statistics() */
+    k4a_depth_statistics_t depth_statistics; /** Valid when has_depth_statistics is set */
+
+    uint64_t compute_time_usec; /** Depth engine time of the image, see image_set_compute_time_usec() */
+
     union
     {
         struct
@@ -48,7 +66,45 @@ typedef struct _image_context_t
 
 } image_context_t;
 
-K4A_DECLARE_CONTEXT(k4a_image_t, image_context_t);
+static void *image_handle_alloc(size_t size)
+{
+    return allocator_handle_alloc(HANDLE_POOL_IMAGE, size);
+}
+
+static void image_handle_free(void *handle)
+{
+    allocator_handle_free(HANDLE_POOL_IMAGE, handle);
+}
+
+K4A_DECLARE_POOLED_CONTEXT(k4a_image_t, image_context_t, image_handle_alloc, image_handle_free);
+
+// Non zero when image_create() pads default strides to ALLOCATOR_ALIGNMENT, see image_set_row_padding()
+static volatile long g_image_row_padding = 0;
+
+// Returns the minimum stride of a format with a constant number of bytes per pixel, 0 for other formats
+static int image_min_stride_bytes(k4a_image_format_t format, int width_pixels)
+{
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+    case K4A_IMAGE_FORMAT_CUSTOM8:
+        return width_pixels;
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+    case K4A_IMAGE_FORMAT_CUSTOM16:
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        return width_pixels * 2;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        return width_pixels * 4;
+    default:
+        return 0;
+    }
+}
+
+void image_set_row_padding(bool enable)
+{
+    g_image_row_padding = enable ? 1 : 0;
+}
 
 k4a_result_t image_create_from_buffer(k4a_image_format_t format,
                                       int width_pixels,
@@ -83,8 +139,6 @@ k4a_result_t image_create_from_buffer(k4a_image_format_t format,
         image->ref_count = 1;
         image->memory_free_cb = buffer_destroy_cb;
         image->memory_free_cb_context = buffer_destroy_cb_context;
-        image->lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(image->lock != NULL);
     }
 
     //
@@ -111,7 +165,10 @@ static void image_default_free_function(void *buffer, void *context)
     allocator_free(buffer);
 }
 
-static k4a_result_t image_create_empty_image(allocation_source_t source, size_t size, k4a_image_t *image_handle)
+static k4a_result_t image_create_empty_image(allocation_source_t source,
+                                             k4a_image_format_t format,
+                                             size_t size,
+                                             k4a_image_t *image_handle)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, size == 0);
@@ -124,7 +181,7 @@ static k4a_result_t image_create_empty_image(allocation_source_t source, size_t
 
     if (K4A_SUCCEEDED(result))
     {
-        result = K4A_RESULT_FROM_BOOL((image->buffer = allocator_alloc(source, size)) != NULL);
+        result = K4A_RESULT_FROM_BOOL((image->buffer = allocator_alloc_image(source, format, size)) != NULL);
     }
 
     if (K4A_SUCCEEDED(result))
@@ -133,8 +190,6 @@ static k4a_result_t image_create_empty_image(allocation_source_t source, size_t
         image->buffer_size = size;
         image->memory_free_cb = image_default_free_function;
         image->memory_free_cb_context = NULL;
-        image->lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(image->lock != NULL);
     }
 
     if (K4A_FAILED(result))
@@ -152,7 +207,216 @@ k4a_result_t image_create_empty_internal(allocation_source_t source, size_t size
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source == ALLOCATION_SOURCE_USER);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, size == 0);
 
-    return image_create_empty_image(source, size, image_handle);
+    return image_create_empty_image(source, K4A_IMAGE_FORMAT_CUSTOM, size, image_handle);
+}
+
+k4a_result_t image_create_empty_from_buffer(uint8_t *buffer,
+                                            size_t size,
+                                            image_destroy_cb_t *buffer_destroy_cb,
+                                            void *buffer_destroy_cb_context,
+                                            k4a_image_t *image_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, size == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
+
+    image_context_t *image = NULL;
+    k4a_result_t result;
+
+    result = K4A_RESULT_FROM_BOOL((image = k4a_image_t_create(image_handle)) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        image->ref_count = 1;
+        image->buffer = buffer;
+        image->buffer_size = size;
+        image->memory_free_cb = buffer_destroy_cb;
+        image->memory_free_cb_context = buffer_destroy_cb_context;
+    }
+
+    // Same contract as image_create_from_buffer; the caller keeps ownership of buffer on failure.
+    if (K4A_FAILED(result) && *image_handle)
+    {
+        if (image)
+        {
+            image->buffer = NULL;
+        }
+        k4a_image_t_destroy(*image_handle);
+        *image_handle = NULL;
+    }
+
+    return result;
+}
+
+k4a_result_t image_create_deferred(k4a_image_format_t format,
+                                   int width_pixels,
+                                   int height_pixels,
+                                   int stride_bytes,
+                                   allocation_source_t source,
+                                   uint8_t *payload,
+                                   size_t payload_size,
+                                   image_destroy_cb_t *payload_destroy_cb,
+                                   void *payload_destroy_cb_context,
+                                   image_decode_cb_t *decode_cb,
+                                   void *decode_cb_context,
+                                   k4a_image_t *image_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, format < K4A_IMAGE_FORMAT_COLOR_MJPG || format > K4A_IMAGE_FORMAT_CUSTOM);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, width_pixels <= 0 || width_pixels > 20000);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, height_pixels <= 0 || height_pixels > 20000);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stride_bytes <= 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source < ALLOCATION_SOURCE_USER || source > ALLOCATION_SOURCE_USB_IMU);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, payload == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, payload_size == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, decode_cb == NULL);
+
+    image_context_t *image = NULL;
+    k4a_result_t result;
+
+    result = K4A_RESULT_FROM_BOOL((image = k4a_image_t_create(image_handle)) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        image->format = format;
+        image->width_pixels = width_pixels;
+        image->height_pixels = height_pixels;
+        image->stride_bytes = stride_bytes;
+        image->buffer_size = (size_t)height_pixels * (size_t)stride_bytes;
+        image->ref_count = 1;
+        image->memory_free_cb = image_default_free_function;
+        image->memory_free_cb_context = NULL;
+        image->deferred = true;
+        image->payload = payload;
+        image->payload_size = payload_size;
+        image->payload_free_cb = payload_destroy_cb;
+        image->payload_free_cb_context = payload_destroy_cb_context;
+        image->decode_cb = decode_cb;
+        image->decode_cb_context = decode_cb_context;
+        image->decode_source = source;
+        image->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(image->lock != NULL);
+    }
+
+    // Same contract as image_create_from_buffer; the caller keeps ownership of payload on failure.
+    if (K4A_FAILED(result) && *image_handle)
+    {
+        k4a_image_t_destroy(*image_handle);
+        *image_handle = NULL;
+    }
+
+    return result;
+}
+
+// Releases the reference a view holds on its parent
+static void image_release_view(void *buffer, void *context)
+{
+    (void)buffer;
+    image_dec_ref((k4a_image_t)context);
+}
+
+k4a_result_t image_create_view(k4a_image_t parent_handle,
+                               int x,
+                               int y,
+                               int width_pixels,
+                               int height_pixels,
+                               k4a_image_t *image_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_image_t, parent_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
+    image_context_t *parent = k4a_image_t_get_context(parent_handle);
+
+    // NV12 stores its chroma in a second plane, which a view of the luma rows can't describe
+    int pixel_bytes = image_min_stride_bytes(parent->format, 1);
+    if (pixel_bytes == 0 || parent->format == K4A_IMAGE_FORMAT_COLOR_NV12)
+    {
+        LOG_ERROR("Views of images of format %d are not supported", parent->format);
+        return K4A_RESULT_FAILED;
+    }
+
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, x < 0 || y < 0 || width_pixels <= 0 || height_pixels <= 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, x > parent->width_pixels - width_pixels);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, y > parent->height_pixels - height_pixels);
+
+    // YUY2 shares the chroma of each pair of pixels
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        parent->format == K4A_IMAGE_FORMAT_COLOR_YUY2 && (x % 2 != 0 || width_pixels % 2 != 0));
+
+    // Decodes a deferred parent, the view points into the decoded pixels
+    uint8_t *parent_buffer = image_get_buffer(parent_handle);
+    size_t offset = (size_t)y * (size_t)parent->stride_bytes + (size_t)x * (size_t)pixel_bytes;
+    size_t size = (size_t)(height_pixels - 1) * (size_t)parent->stride_bytes +
+                  (size_t)width_pixels * (size_t)pixel_bytes;
+    if (parent_buffer == NULL || offset + size > parent->buffer_size)
+    {
+        LOG_ERROR("Image of %zu bytes doesn't hold a %dx%d view at %d,%d",
+                  parent->buffer_size,
+                  width_pixels,
+                  height_pixels,
+                  x,
+                  y);
+        return K4A_RESULT_FAILED;
+    }
+
+    image_inc_ref(parent_handle);
+    k4a_result_t result = TRACE_CALL(image_create_from_buffer(parent->format,
+                                                              width_pixels,
+                                                              height_pixels,
+                                                              parent->stride_bytes,
+                                                              parent_buffer + offset,
+                                                              size,
+                                                              image_release_view,
+                                                              parent_handle,
+                                                              image_handle));
+    if (K4A_FAILED(result))
+    {
+        image_dec_ref(parent_handle);
+        return result;
+    }
+
+    image_context_t *image = k4a_image_t_get_context(*image_handle);
+    image->dev_timestamp_usec = parent->dev_timestamp_usec;
+    image->sys_timestamp_nsec = parent->sys_timestamp_nsec;
+    image->exposure_time_usec = parent->exposure_time_usec;
+    image->metadata = parent->metadata;
+    return result;
+}
+
+// Decodes the payload of a deferred image into a newly allocated buffer, called once with the image lock held
+static void image_decode_payload(k4a_image_t image_handle, image_context_t *image)
+{
+    uint8_t *buffer = allocator_alloc_image(image->decode_source, image->format, image->buffer_size);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(image->decode_cb(image_handle,
+                                             image->payload,
+                                             image->payload_size,
+                                             buffer,
+                                             image->buffer_size,
+                                             image->decode_cb_context));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        image->buffer = buffer;
+    }
+    else
+    {
+        LOG_ERROR("Failed to decode deferred image of format %d", image->format);
+        if (buffer)
+        {
+            allocator_free(buffer);
+        }
+    }
+
+    // The payload is released after the first attempt, a failed decode is not retried
+    if (image->payload_free_cb)
+    {
+        image->payload_free_cb(image->payload, image->payload_free_cb_context);
+    }
+    image->payload = NULL;
 }
 
 k4a_result_t image_create(k4a_image_format_t format,
@@ -175,6 +439,12 @@ k4a_result_t image_create(k4a_image_format_t format,
 
     *image_handle = NULL;
 
+    if (stride_bytes == 0 && g_image_row_padding)
+    {
+        // Start every row on an aligned boundary, the buffer itself is always aligned by the allocator
+        stride_bytes = (int)ALLOCATOR_ALIGN_UP((size_t)image_min_stride_bytes(format, width_pixels));
+    }
+
     switch (format)
     {
     case K4A_IMAGE_FORMAT_COLOR_MJPG:
@@ -333,7 +603,7 @@ k4a_result_t image_create(k4a_image_format_t format,
 
     if (K4A_SUCCEEDED(result))
     {
-        result = TRACE_CALL(image_create_empty_image(source, size, image_handle));
+        result = TRACE_CALL(image_create_empty_image(source, format, size, image_handle));
     }
 
     if (K4A_SUCCEEDED(result))
@@ -358,7 +628,8 @@ k4a_result_t image_create(k4a_image_format_t format,
     return result;
 }
 
-void image_dec_ref(k4a_image_t image_handle)
+// Removes a reference, recycling a buffer from the allocator when it was the last reference and recycle is set
+static void image_release(k4a_image_t image_handle, bool recycle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_image_t, image_handle);
     image_context_t *image = k4a_image_t_get_context(image_handle);
@@ -367,15 +638,36 @@ void image_dec_ref(k4a_image_t image_handle)
 
     if (count == 0)
     {
-        if (image->memory_free_cb)
+        if (image->payload && image->payload_free_cb)
+        {
+            image->payload_free_cb(image->payload, image->payload_free_cb_context);
+        }
+        if (recycle && image->memory_free_cb == image_default_free_function && image->buffer)
+        {
+            allocator_recycle(image->buffer);
+        }
+        else if (image->memory_free_cb && (!image->deferred || image->buffer))
         {
             image->memory_free_cb(image->buffer, image->memory_free_cb_context);
         }
-        Lock_Deinit(image->lock);
+        if (image->lock)
+        {
+            Lock_Deinit(image->lock);
+        }
         k4a_image_t_destroy(image_handle);
     }
 }
 
+void image_dec_ref(k4a_image_t image_handle)
+{
+    image_release(image_handle, false);
+}
+
+void image_recycle(k4a_image_t image_handle)
+{
+    image_release(image_handle, true);
+}
+
 void image_inc_ref(k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_image_t, image_handle);
@@ -388,6 +680,18 @@ uint8_t *image_get_buffer(k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_image_t, image_handle);
     image_context_t *image = k4a_image_t_get_context(image_handle);
+
+    if (image->deferred)
+    {
+        // The buffer only changes here, under the lock, so it is safe to read once the payload has been handled
+        Lock(image->lock);
+        if (image->payload)
+        {
+            image_decode_payload(image_handle, image);
+        }
+        Unlock(image->lock);
+    }
+
     return image->buffer;
 }
 
@@ -436,6 +740,13 @@ int image_get_stride_bytes(k4a_image_t image_handle)
     return image->stride_bytes;
 }
 
+int image_get_packed_stride_bytes(k4a_image_t image_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_image_t, image_handle);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    return image_min_stride_bytes(image->format, image->width_pixels);
+}
+
 uint64_t image_get_device_timestamp_usec(k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_image_t, image_handle);
@@ -485,6 +796,68 @@ void image_set_system_timestamp_nsec(k4a_image_t image_handle, uint64_t timestam
     image->sys_timestamp_nsec = timestamp_nsec;
 }
 
+void image_set_gpu_resource(k4a_image_t image_handle, const k4a_gpu_resource_t *resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_image_t, image_handle);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    image->has_gpu_resource = resource != NULL;
+    if (resource != NULL)
+    {
+        image->gpu_resource = *resource;
+    }
+}
+
+k4a_result_t image_get_gpu_resource(k4a_image_t image_handle, k4a_gpu_resource_t *resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_image_t, image_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, resource == NULL);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    if (!image->has_gpu_resource)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    *resource = image->gpu_resource;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void image_set_depth_statistics(k4a_image_t image_handle, const k4a_depth_statistics_t *statistics)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_image_t, image_handle);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    image->has_depth_statistics = statistics != NULL;
+    if (statistics != NULL)
+    {
+        image->depth_statistics = *statistics;
+    }
+}
+
+k4a_result_t image_get_depth_statistics(k4a_image_t image_handle, k4a_depth_statistics_t *statistics)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_image_t, image_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, statistics == NULL);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    if (!image->has_depth_statistics)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    *statistics = image->depth_statistics;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void image_set_compute_time_usec(k4a_image_t image_handle, uint64_t compute_time_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_image_t, image_handle);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    image->compute_time_usec = compute_time_usec;
+}
+
+uint64_t image_get_compute_time_usec(k4a_image_t image_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_image_t, image_handle);
+    image_context_t *image = k4a_image_t_get_context(image_handle);
+    return image->compute_time_usec;
+}
+
 k4a_result_t image_apply_system_timestamp(k4a_image_t image_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_image_t, image_handle);
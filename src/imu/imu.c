@@ -11,6 +11,10 @@
 #include <k4ainternal/math.h>
 #include <k4ainternal/queue.h>
 #include <k4ainternal/calibration.h>
+#include <k4ainternal/simd.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/threadapi.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -39,6 +43,12 @@ extern "C" {
 // IMU start.
 #define MAX_IMU_TIME_STAMP_MS 1500
 
+// Default number of samples buffered before one is dropped, the same depth as the capture queues
+#define IMU_SAMPLE_RING_CAPACITY QUEUE_CALC_DEPTH(K4A_IMU_SAMPLE_RATE, QUEUE_DEFAULT_DEPTH_USEC)
+
+// Number of samples kept for captures, one second covers the exposure and the processing of a capture at any frame rate
+#define IMU_HISTORY_CAPACITY K4A_IMU_SAMPLE_RATE
+
 //************************ Typedefs *****************************
 
 // parameters used to compute the calibrated IMU
@@ -50,14 +60,52 @@ typedef struct _imu_calibration_rectifier_t
     float mixing_matrix_accel[3 * 3];
 } imu_calibration_rectifier_t;
 
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+#if defined(K4A_USING_SSE)
+typedef __m128 imu_vector_t;
+#else
+typedef float32x4_t imu_vector_t;
+#endif
+
+// The rectifier laid out as matrix columns, so a sample is rectified with a few vector multiply-adds
+typedef struct _imu_vector_rectifier_t
+{
+    imu_vector_t bias_gyro;
+    imu_vector_t bias_accel;
+    imu_vector_t mixing_matrix_gyro[3];
+    imu_vector_t mixing_matrix_accel[3];
+    imu_vector_t second_order_scaling_accel[3];
+} imu_vector_rectifier_t;
+#endif
+
 typedef struct _imu_context_t
 {
     TICK_COUNTER_HANDLE tick;
     colormcu_t color_mcu;
-    queue_t queue;
     uint32_t dropped_count;
     float temperature;
 
+    // Ring of the samples not read yet, calibration is applied when they are read
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    k4a_imu_sample_t *samples;
+    uint32_t sample_capacity;  // Number of samples the ring holds, see imu_set_queue_policy()
+    k4a_queue_policy_t policy; // Sample dropped when the ring is full
+    uint32_t sample_read_index;
+    uint32_t sample_count;
+    uint32_t overwritten_count; // Samples dropped from the full ring since the last read
+    uint32_t blocked_count;     // Threads waiting in imu_get_samples()
+    bool samples_enabled;
+    queue_waiter_t waiters[QUEUE_MAX_WAITERS]; // Notified like condition, see imu_add_waiter()
+    uint32_t waiter_count;
+
+    // Latest samples kept for captures, they are not consumed by reads. NULL unless enabled with
+    // imu_set_history_enabled(). Locked by lock.
+    k4a_imu_sample_t *history;
+    uint32_t history_write_index;
+    uint32_t history_count;
+
+    LOCK_HANDLE calibration_lock; // Serializes the temperature updates of calibration_rectifier between readers
     k4a_calibration_imu_t gyro_calibration;
     k4a_calibration_imu_t accel_calibration;
     imu_calibration_rectifier_t calibration_rectifier;
@@ -73,6 +121,76 @@ K4A_DECLARE_CONTEXT(imu_t, imu_context_t);
 usb_cmd_stream_cb_t imu_capture_ready;
 
 //*********************** Functions *****************************
+static void imu_notify_waiters_locked(imu_context_t *p_imu)
+{
+    for (uint32_t i = 0; i < p_imu->waiter_count; i++)
+    {
+        queue_waiter_notify(p_imu->waiters[i]);
+    }
+}
+
+static void imu_enable_samples(imu_context_t *p_imu)
+{
+    Lock(p_imu->lock);
+    p_imu->sample_read_index = 0;
+    p_imu->sample_count = 0;
+    p_imu->overwritten_count = 0;
+    p_imu->history_count = 0;
+    p_imu->samples_enabled = true;
+    Unlock(p_imu->lock);
+}
+
+// Drops the buffered samples and fails the pending and future reads until imu_enable_samples() is called
+static void imu_disable_samples(imu_context_t *p_imu)
+{
+    Lock(p_imu->lock);
+    p_imu->samples_enabled = false;
+    imu_notify_waiters_locked(p_imu);
+    while (p_imu->blocked_count != 0)
+    {
+        LOG_INFO("IMU waiting for blocking call to complete.", 0);
+        Condition_Post(p_imu->condition);
+        Unlock(p_imu->lock);
+        ThreadAPI_Sleep(25);
+        Lock(p_imu->lock);
+    }
+    p_imu->sample_count = 0;
+    Unlock(p_imu->lock);
+}
+
+static void imu_push_sample_locked(imu_context_t *p_imu, const k4a_imu_sample_t *sample)
+{
+    if (p_imu->sample_count == p_imu->sample_capacity)
+    {
+        p_imu->overwritten_count++;
+        if (p_imu->policy == K4A_QUEUE_POLICY_DROP_NEWEST)
+        {
+            return;
+        }
+        p_imu->sample_read_index = (p_imu->sample_read_index + 1) % p_imu->sample_capacity;
+        p_imu->sample_count--;
+    }
+    p_imu->samples[(p_imu->sample_read_index + p_imu->sample_count) % p_imu->sample_capacity] = *sample;
+    p_imu->sample_count++;
+}
+
+static void imu_push_history_locked(imu_context_t *p_imu, const k4a_imu_sample_t *sample)
+{
+    // Starting the color camera resets the timestamps, the history is searched by timestamp so it starts over
+    uint32_t last_index = (p_imu->history_write_index + IMU_HISTORY_CAPACITY - 1) % IMU_HISTORY_CAPACITY;
+    if (p_imu->history_count != 0 && sample->acc_timestamp_usec < p_imu->history[last_index].acc_timestamp_usec)
+    {
+        p_imu->history_count = 0;
+    }
+
+    p_imu->history[p_imu->history_write_index] = *sample;
+    p_imu->history_write_index = (p_imu->history_write_index + 1) % IMU_HISTORY_CAPACITY;
+    if (p_imu->history_count < IMU_HISTORY_CAPACITY)
+    {
+        p_imu->history_count++;
+    }
+}
+
 /**
  *  Callback function used with the command module to handle received captures from the IMU device
  *
@@ -84,7 +202,7 @@ usb_cmd_stream_cb_t imu_capture_ready;
  *   image resource for IMU. This contains all of the information on the received capture.
  *
  *  @param p_context
- *   Callback context.  In this function, this is the handle to the initiating object that has the queue.
+ *   Callback context.  In this function, this is the handle to the initiating object that has the sample ring.
  *
  * \remarks
  * Capture is safe to use during this callback as the caller ensures a ref is held. If the callback function wants the
@@ -99,12 +217,13 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
     xyz_vector_t *p_accel_data = NULL;
     size_t capture_size;
 
-    // place capture in queue
+    // place samples in the ring
     if (result != K4A_RESULT_SUCCEEDED)
     {
         LOG_WARNING("A streaming IMU transfer failed", 0);
-        // Stop the queue - this will notify users waiting for data.
-        queue_stop(p_imu->queue);
+        // Stop the samples - this will notify users waiting for data.
+        LOG_INFO("IMU stopped, shutting down and notifying consumers.", 0);
+        imu_disable_samples(p_imu);
     }
 
     if (K4A_SUCCEEDED(result))
@@ -114,7 +233,7 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
 
     if (K4A_SUCCEEDED(result))
     {
-        // Take apart the capture packet data and create captures for each sample
+        // Take apart the capture packet data and write each sample to the ring
         p_packet = image_get_buffer(image);
         capture_size = image_get_size(image);
 
@@ -162,7 +281,17 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                         p_metadata->gyro.sample_count);
         }
 
-        for (uint32_t i = 0; i < p_metadata->gyro.sample_count && i < p_metadata->accel.sample_count; i++)
+        // One lock for all samples of the packet
+        Lock(p_imu->lock);
+        if (!p_imu->samples_enabled)
+        {
+            LOG_WARNING("IMU samples received while the IMU is not streaming.", 0);
+        }
+
+        uint32_t pushed_count = 0;
+        for (uint32_t i = 0;
+             p_imu->samples_enabled && i < p_metadata->gyro.sample_count && i < p_metadata->accel.sample_count;
+             i++)
         {
             result = K4A_RESULT_SUCCEEDED;
 
@@ -188,15 +317,6 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                 }
             }
 
-            k4a_capture_t imu_capture = NULL;
-            k4a_image_t imu_image = NULL;
-
-            if (K4A_SUCCEEDED(result))
-            {
-                result = TRACE_CALL(
-                    image_create_empty_internal(ALLOCATION_SOURCE_IMU, sizeof(k4a_imu_sample_t), &imu_image));
-            }
-
             if (K4A_SUCCEEDED(result))
             {
                 k4a_imu_sample_t sample = { 0 };
@@ -217,31 +337,21 @@ void imu_capture_ready(k4a_result_t result, k4a_image_t image, void *p_context)
                                           IMU_GRAVITATIONAL_CONSTANT / IMU_SCALE_NORMALIZATION;
                 sample.acc_timestamp_usec = K4A_90K_HZ_TICK_TO_USEC(p_accel_data[i].pts);
 
-                memcpy(image_get_buffer(imu_image), &sample, sizeof(k4a_imu_sample_t));
-            }
-
-            if (K4A_SUCCEEDED(result))
-            {
-                result = TRACE_CALL(capture_create(&imu_capture));
-            }
-
-            if (K4A_SUCCEEDED(result))
-            {
-                capture_set_imu_image(imu_capture, imu_image);
-                queue_push(p_imu->queue, imu_capture);
+                imu_push_sample_locked(p_imu, &sample);
+                if (p_imu->history != NULL)
+                {
+                    imu_push_history_locked(p_imu, &sample);
+                }
+                pushed_count++;
             }
+        }
 
-            if (imu_image)
-            {
-                // remove local ref on image
-                image_dec_ref(imu_image);
-            }
-            if (imu_capture)
-            {
-                // remove local ref on capture
-                capture_dec_ref(imu_capture); // release our interest in the new capture
-            }
+        if (pushed_count != 0)
+        {
+            Condition_Post(p_imu->condition);
+            imu_notify_waiters_locked(p_imu);
         }
+        Unlock(p_imu->lock);
     }
 }
 
@@ -346,10 +456,29 @@ imu_create(TICK_COUNTER_HANDLE tick_handle, colormcu_t color_mcu, calibration_t
     p_imu->tick = tick_handle;
     p_imu->temperature = 0;
 
-    // Create allocator handle
+    // Create the sample ring
+    p_imu->sample_capacity = IMU_SAMPLE_RING_CAPACITY;
+    p_imu->policy = K4A_QUEUE_POLICY_DROP_OLDEST;
+    p_imu->samples = (k4a_imu_sample_t *)malloc(p_imu->sample_capacity * sizeof(k4a_imu_sample_t));
+    result = K4A_RESULT_FROM_BOOL(p_imu->samples != NULL);
 
-    result = TRACE_CALL(
-        queue_create(QUEUE_CALC_DEPTH(K4A_IMU_SAMPLE_RATE, QUEUE_DEFAULT_DEPTH_USEC), "Queue_imu", &p_imu->queue));
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(p_imu->lock != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(p_imu->condition != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->calibration_lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(p_imu->calibration_lock != NULL);
+    }
 
     if (K4A_SUCCEEDED(result))
     {
@@ -409,116 +538,508 @@ void imu_destroy(imu_t imu_handle)
     // implicit stop
     imu_stop(imu_handle);
 
-    // Destroy queue
-    if (imu->queue != NULL)
+    // Destroy the sample ring
+    if (imu->condition != NULL)
+    {
+        Condition_Deinit(imu->condition);
+        imu->condition = NULL;
+    }
+    if (imu->lock != NULL)
+    {
+        Lock_Deinit(imu->lock);
+        imu->lock = NULL;
+    }
+    if (imu->calibration_lock != NULL)
+    {
+        Lock_Deinit(imu->calibration_lock);
+        imu->calibration_lock = NULL;
+    }
+    if (imu->samples != NULL)
     {
-        queue_destroy(imu->queue);
-        imu->queue = NULL;
+        free(imu->samples);
+        imu->samples = NULL;
     }
+    free(imu->history);
+    imu->history = NULL;
 
     imu_t_destroy(imu_handle);
 }
 
+#if defined(K4A_USING_SSE)
+static void imu_load_vector_columns(const float matrix[3 * 3], imu_vector_t columns[3])
+{
+    for (int col = 0; col < 3; col++)
+    {
+        columns[col] = _mm_setr_ps(matrix[col], matrix[3 + col], matrix[6 + col], 0.f);
+    }
+}
+
+static void imu_load_vector_rectifier(const imu_context_t *p_imu, imu_vector_rectifier_t *rectifier)
+{
+    const float *bias_gyro = p_imu->calibration_rectifier.bias_gyro;
+    const float *bias_accel = p_imu->calibration_rectifier.bias_accel;
+    rectifier->bias_gyro = _mm_setr_ps(bias_gyro[0], bias_gyro[1], bias_gyro[2], 0.f);
+    rectifier->bias_accel = _mm_setr_ps(bias_accel[0], bias_accel[1], bias_accel[2], 0.f);
+    imu_load_vector_columns(p_imu->calibration_rectifier.mixing_matrix_gyro, rectifier->mixing_matrix_gyro);
+    imu_load_vector_columns(p_imu->calibration_rectifier.mixing_matrix_accel, rectifier->mixing_matrix_accel);
+    imu_load_vector_columns(p_imu->accel_calibration.second_order_scaling, rectifier->second_order_scaling_accel);
+}
+
+// out = A*x + b, summed in the same order as math_affine_transform_3()
+static imu_vector_t imu_vector_affine_transform(const imu_vector_t columns[3], const float x[3], imu_vector_t b)
+{
+    __m128 out = _mm_mul_ps(columns[0], _mm_set1_ps(x[0]));
+    out = _mm_add_ps(out, _mm_mul_ps(columns[1], _mm_set1_ps(x[1])));
+    out = _mm_add_ps(out, _mm_mul_ps(columns[2], _mm_set1_ps(x[2])));
+    return _mm_add_ps(out, b);
+}
+
+static void imu_store_vector(imu_vector_t v, float out[3])
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    memcpy(out, lanes, 3 * sizeof(float));
+}
+
+#elif defined(K4A_USING_NEON)
+static void imu_load_vector_columns(const float matrix[3 * 3], imu_vector_t columns[3])
+{
+    for (int col = 0; col < 3; col++)
+    {
+        float column[4] = { matrix[col], matrix[3 + col], matrix[6 + col], 0.f };
+        columns[col] = vld1q_f32(column);
+    }
+}
+
+static void imu_load_vector_rectifier(const imu_context_t *p_imu, imu_vector_rectifier_t *rectifier)
+{
+    const float *bias_gyro = p_imu->calibration_rectifier.bias_gyro;
+    const float *bias_accel = p_imu->calibration_rectifier.bias_accel;
+    float gyro[4] = { bias_gyro[0], bias_gyro[1], bias_gyro[2], 0.f };
+    float accel[4] = { bias_accel[0], bias_accel[1], bias_accel[2], 0.f };
+    rectifier->bias_gyro = vld1q_f32(gyro);
+    rectifier->bias_accel = vld1q_f32(accel);
+    imu_load_vector_columns(p_imu->calibration_rectifier.mixing_matrix_gyro, rectifier->mixing_matrix_gyro);
+    imu_load_vector_columns(p_imu->calibration_rectifier.mixing_matrix_accel, rectifier->mixing_matrix_accel);
+    imu_load_vector_columns(p_imu->accel_calibration.second_order_scaling, rectifier->second_order_scaling_accel);
+}
+
+// out = A*x + b, summed in the same order as math_affine_transform_3()
+static imu_vector_t imu_vector_affine_transform(const imu_vector_t columns[3], const float x[3], imu_vector_t b)
+{
+    float32x4_t out = vmulq_n_f32(columns[0], x[0]);
+    out = vaddq_f32(out, vmulq_n_f32(columns[1], x[1]));
+    out = vaddq_f32(out, vmulq_n_f32(columns[2], x[2]));
+    return vaddq_f32(out, b);
+}
+
+static void imu_store_vector(imu_vector_t v, float out[3])
+{
+    float lanes[4];
+    vst1q_f32(lanes, v);
+    memcpy(out, lanes, 3 * sizeof(float));
+}
+#endif
+
 /**
- *  Function to adjust the sensor measurement according to calibration data
+ *  Function to adjust the sensor measurements according to calibration data. Samples of a USB packet share one
+ *  temperature, so the bias and mixing matrix are refreshed at most once per packet and applied to the whole run.
  *
- *  @param p_imu_sample
- *   Pointer to this specific imu sample
+ *  @param imu_samples
+ *   Pointer to the samples to adjust in place
+ *
+ *  @param sample_count
+ *   Number of samples to adjust
  *
  *  @param p_imu
  *   Pointer to the imu context, which includes the calibration information.
  *
  */
-static void imu_apply_intrinsic_calibration(k4a_imu_sample_t *p_imu_sample, const imu_context_t *p_imu)
+static void imu_apply_intrinsic_calibration(k4a_imu_sample_t *imu_samples, size_t sample_count, imu_context_t *p_imu)
 {
-    math_affine_transform_3(p_imu->calibration_rectifier.mixing_matrix_gyro,
-                            p_imu_sample->gyro_sample.v,
-                            p_imu->calibration_rectifier.bias_gyro,
-                            p_imu_sample->gyro_sample.v);
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+    bool vectorized = simd_get_level() != SIMD_LEVEL_NONE;
+    imu_vector_rectifier_t rectifier;
+    if (vectorized)
+    {
+        imu_load_vector_rectifier(p_imu, &rectifier);
+    }
+#endif
+
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        k4a_imu_sample_t *imu_sample = &imu_samples[i];
+
+        // update the calibration when the temperature changes more than 0.25C
+        if ((imu_sample->temperature > (p_imu->temperature + 0.25f)) ||
+            (imu_sample->temperature < (p_imu->temperature - 0.25f)))
+        {
+            imu_update_calibration_with_temperature(imu_sample->temperature, imu_sample->temperature, p_imu);
+            p_imu->temperature = imu_sample->temperature;
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+            if (vectorized)
+            {
+                imu_load_vector_rectifier(p_imu, &rectifier);
+            }
+#endif
+        }
 
-    math_quadratic_transform_3(p_imu->calibration_rectifier.mixing_matrix_accel,
-                               p_imu->accel_calibration.second_order_scaling,
-                               p_imu_sample->acc_sample.v,
-                               p_imu->calibration_rectifier.bias_accel,
-                               p_imu_sample->acc_sample.v);
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+        if (vectorized)
+        {
+            const float *acc = imu_sample->acc_sample.v;
+            const float acc_squared[3] = { acc[0] * acc[0], acc[1] * acc[1], acc[2] * acc[2] };
+            imu_vector_t gyro = imu_vector_affine_transform(rectifier.mixing_matrix_gyro,
+                                                            imu_sample->gyro_sample.v,
+                                                            rectifier.bias_gyro);
+            imu_vector_t accel = imu_vector_affine_transform(rectifier.mixing_matrix_accel,
+                                                             acc,
+                                                             rectifier.bias_accel);
+            accel = imu_vector_affine_transform(rectifier.second_order_scaling_accel, acc_squared, accel);
+            imu_store_vector(gyro, imu_sample->gyro_sample.v);
+            imu_store_vector(accel, imu_sample->acc_sample.v);
+            continue;
+        }
+#endif
+
+        math_affine_transform_3(p_imu->calibration_rectifier.mixing_matrix_gyro,
+                                imu_sample->gyro_sample.v,
+                                p_imu->calibration_rectifier.bias_gyro,
+                                imu_sample->gyro_sample.v);
+
+        math_quadratic_transform_3(p_imu->calibration_rectifier.mixing_matrix_accel,
+                                   p_imu->accel_calibration.second_order_scaling,
+                                   imu_sample->acc_sample.v,
+                                   p_imu->calibration_rectifier.bias_accel,
+                                   imu_sample->acc_sample.v);
+    }
 }
 
 /**
- *  Function to get the next capture in the stream.  Note, if excessive time has passed since the last call, some
- * captures may have been discarded.
+ *  Function to get the oldest samples of the stream. Note, if excessive time has passed since the last call, some
+ * samples may have been discarded.
  *
  *  @param imu_handle
  *   Handle to this specific object
  *
- *  @param imu_sample
- *   Pointer to where the sample will be written to
+ *  @param imu_samples
+ *   Pointer to where up to max_sample_count samples will be written to
+ *
+ *  @param max_sample_count
+ *   Maximum number of samples to read
+ *
+ *  @param sample_count
+ *   Pointer to where the number of samples read will be written to
  *
  *  @param timeout_in_ms
- *   Number of mSecs to wait until timing out for getting a capture
+ *   Number of mSecs to wait until timing out for getting a sample
  *
  *  @return
  *   K4A_WAIT_RESULT_TIMEOUT     Operation timed out
- *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and a capture was retrieved
+ *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and at least one sample was retrieved
  *   K4A_WAIT_RESULT_FAILED      Operation failed due to invalid input or unknown reason
  */
-k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms)
+k4a_wait_result_t imu_get_samples(imu_t imu_handle,
+                                  k4a_imu_sample_t *imu_samples,
+                                  size_t max_sample_count,
+                                  size_t *sample_count,
+                                  int32_t timeout_in_ms)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, imu_t, imu_handle);
-    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (imu_sample == NULL));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (imu_samples == NULL));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (max_sample_count == 0));
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, (sample_count == NULL));
 
     k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
     imu_context_t *p_imu = imu_t_get_context(imu_handle);
-    k4a_capture_t capture = NULL;
-    k4a_image_t image = NULL;
-    uint8_t *buffer = NULL;
+    size_t read_count = 0;
+
+    Lock(p_imu->lock);
+
+    if (!p_imu->samples_enabled)
+    {
+        LOG_ERROR("IMU samples were read while the IMU is not streaming.", 0);
+        wresult = K4A_WAIT_RESULT_FAILED;
+    }
 
-    wresult = queue_pop(p_imu->queue, timeout_in_ms, &capture);
+    if (wresult == K4A_WAIT_RESULT_SUCCEEDED && p_imu->sample_count == 0 && timeout_in_ms != 0)
+    {
+        p_imu->blocked_count++;
+        do
+        {
+            // Anything less than 0 is a wait forever condition, which Condition_Wait expresses with 0
+            COND_RESULT cond_result = Condition_Wait(p_imu->condition,
+                                                     p_imu->lock,
+                                                     timeout_in_ms < 0 ? 0 : timeout_in_ms);
+            if (cond_result == COND_ERROR)
+            {
+                wresult = K4A_WAIT_RESULT_FAILED;
+                break;
+            }
+            // An infinite wait does not time out
+        } while (p_imu->sample_count == 0 && p_imu->samples_enabled && timeout_in_ms < 0);
+        p_imu->blocked_count--;
+    }
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    if (!p_imu->samples_enabled)
     {
-        k4a_result_t result = K4A_RESULT_FROM_BOOL((image = capture_get_imu_image(capture)) != NULL);
-        if (K4A_FAILED(result))
+        wresult = K4A_WAIT_RESULT_FAILED;
+    }
+    else if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        read_count = p_imu->sample_count < max_sample_count ? p_imu->sample_count : max_sample_count;
+        if (read_count == 0)
+        {
+            wresult = K4A_WAIT_RESULT_TIMEOUT;
+        }
+
+        // The samples may wrap around the end of the ring
+        size_t first_count = p_imu->sample_capacity - p_imu->sample_read_index;
+        if (first_count > read_count)
         {
-            wresult = K4A_WAIT_RESULT_FAILED;
+            first_count = read_count;
         }
+        memcpy(imu_samples, &p_imu->samples[p_imu->sample_read_index], first_count * sizeof(k4a_imu_sample_t));
+        memcpy(imu_samples + first_count, p_imu->samples, (read_count - first_count) * sizeof(k4a_imu_sample_t));
+        p_imu->sample_read_index = (uint32_t)((p_imu->sample_read_index + read_count) % p_imu->sample_capacity);
+        p_imu->sample_count -= (uint32_t)read_count;
     }
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    if (p_imu->overwritten_count != 0)
+    {
+        LOG_INFO("IMU dropped %d samples.", p_imu->overwritten_count);
+        p_imu->overwritten_count = 0;
+    }
+
+    Unlock(p_imu->lock);
+
+    // The application of intrinsic calibration is delayed until the IMU samples are queried.
+    Lock(p_imu->calibration_lock);
+    imu_apply_intrinsic_calibration(imu_samples, read_count, p_imu);
+    Unlock(p_imu->calibration_lock);
+
+    *sample_count = read_count;
+    return wresult;
+}
+
+// Returns the position in the history of the first sample at or after timestamp_usec
+static uint32_t imu_history_lower_bound_locked(const imu_context_t *p_imu, uint64_t timestamp_usec)
+{
+    uint32_t first_index = (p_imu->history_write_index + IMU_HISTORY_CAPACITY - p_imu->history_count) %
+                           IMU_HISTORY_CAPACITY;
+    uint32_t low = 0;
+    uint32_t high = p_imu->history_count;
+    while (low < high)
     {
-        buffer = image_get_buffer(image);
-        k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
-        if (K4A_FAILED(result))
+        uint32_t middle = low + (high - low) / 2;
+        if (p_imu->history[(first_index + middle) % IMU_HISTORY_CAPACITY].acc_timestamp_usec < timestamp_usec)
+        {
+            low = middle + 1;
+        }
+        else
         {
-            wresult = K4A_WAIT_RESULT_FAILED;
+            high = middle;
         }
     }
+    return low;
+}
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+/**
+ *  Function to copy the samples of a time range from the history, without consuming them.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param start_usec
+ *   Device timestamp of the first sample to copy
+ *
+ *  @param end_usec
+ *   Device timestamp of the last sample to copy
+ *
+ *  @param imu_samples
+ *   Pointer to where the calibrated samples are written to, allocated with malloc(). NULL when no sample is in range.
+ *
+ *  @param sample_count
+ *   Pointer to where the number of samples copied will be written to
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED    Operation was successful, possibly without samples in range
+ *   K4A_RESULT_FAILED       The history isn't enabled or an allocation failed
+ */
+k4a_result_t imu_get_history_samples(imu_t imu_handle,
+                                     uint64_t start_usec,
+                                     uint64_t end_usec,
+                                     k4a_imu_sample_t **imu_samples,
+                                     size_t *sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imu_t, imu_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sample_count == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, start_usec > end_usec);
+
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_imu_sample_t *samples = NULL;
+    uint32_t start = 0;
+    size_t copy_count = 0;
+
+    *imu_samples = NULL;
+    *sample_count = 0;
+
+    Lock(p_imu->lock);
+    if (p_imu->history == NULL)
     {
-        assert(sizeof(k4a_imu_sample_t) <= image_get_size(image));
-        memcpy(imu_sample, buffer, sizeof(k4a_imu_sample_t));
+        LOG_ERROR("IMU samples were read from the history while it isn't enabled.", 0);
+        result = K4A_RESULT_FAILED;
+    }
 
-        // update the calibration when the temperature changes more than 0.25C
-        if ((imu_sample->temperature > (p_imu->temperature + 0.25f)) ||
-            (imu_sample->temperature < (p_imu->temperature - 0.25f)))
+    if (K4A_SUCCEEDED(result))
+    {
+        start = imu_history_lower_bound_locked(p_imu, start_usec);
+        uint32_t end = end_usec == UINT64_MAX ? p_imu->history_count :
+                                                imu_history_lower_bound_locked(p_imu, end_usec + 1);
+        copy_count = end - start;
+    }
+
+    if (K4A_SUCCEEDED(result) && copy_count != 0)
+    {
+        samples = (k4a_imu_sample_t *)malloc(copy_count * sizeof(k4a_imu_sample_t));
+        result = K4A_RESULT_FROM_BOOL(samples != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result) && copy_count != 0)
+    {
+        uint32_t first_index = (p_imu->history_write_index + IMU_HISTORY_CAPACITY - p_imu->history_count + start) %
+                               IMU_HISTORY_CAPACITY;
+
+        // The samples may wrap around the end of the history
+        size_t first_count = IMU_HISTORY_CAPACITY - first_index;
+        if (first_count > copy_count)
         {
-            imu_update_calibration_with_temperature(imu_sample->temperature, imu_sample->temperature, p_imu);
-            p_imu->temperature = imu_sample->temperature;
+            first_count = copy_count;
         }
-        // The application of intrinsic calibration is delayed until the IMU sample is queried.
-        imu_apply_intrinsic_calibration(imu_sample, p_imu);
+        memcpy(samples, &p_imu->history[first_index], first_count * sizeof(k4a_imu_sample_t));
+        memcpy(samples + first_count, p_imu->history, (copy_count - first_count) * sizeof(k4a_imu_sample_t));
     }
+    Unlock(p_imu->lock);
 
-    if (image)
+    if (K4A_SUCCEEDED(result) && copy_count != 0)
     {
-        image_dec_ref(image);
+        Lock(p_imu->calibration_lock);
+        imu_apply_intrinsic_calibration(samples, copy_count, p_imu);
+        Unlock(p_imu->calibration_lock);
+
+        *imu_samples = samples;
+        *sample_count = copy_count;
     }
-    if (capture)
+
+    return result;
+}
+
+/**
+ *  Function to get the next sample in the stream.  Note, if excessive time has passed since the last call, some
+ * samples may have been discarded.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param imu_sample
+ *   Pointer to where the sample will be written to
+ *
+ *  @param timeout_in_ms
+ *   Number of mSecs to wait until timing out for getting a sample
+ *
+ *  @return
+ *   K4A_WAIT_RESULT_TIMEOUT     Operation timed out
+ *   K4A_WAIT_RESULT_SUCCEEDED   Operation was successful and a sample was retrieved
+ *   K4A_WAIT_RESULT_FAILED      Operation failed due to invalid input or unknown reason
+ */
+k4a_wait_result_t imu_get_sample(imu_t imu_handle, k4a_imu_sample_t *imu_sample, int32_t timeout_in_ms)
+{
+    size_t sample_count = 0;
+    return imu_get_samples(imu_handle, imu_sample, 1, &sample_count, timeout_in_ms);
+}
+
+/**
+ *  Function to attach a waiter that is notified when samples arrive or the stream stops.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param waiter_handle
+ *   Waiter created with queue_waiter_create()
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED    Operation was successful
+ *   K4A_RESULT_FAILED       QUEUE_MAX_WAITERS waiters are already attached
+ */
+k4a_result_t imu_add_waiter(imu_t imu_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imu_t, imu_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, waiter_handle == NULL);
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(p_imu->lock);
+    if (p_imu->waiter_count == QUEUE_MAX_WAITERS)
     {
-        capture_dec_ref(capture);
+        LOG_ERROR("IMU already has %d waiters attached.", QUEUE_MAX_WAITERS);
+        result = K4A_RESULT_FAILED;
     }
+    else
+    {
+        p_imu->waiters[p_imu->waiter_count++] = waiter_handle;
+    }
+    Unlock(p_imu->lock);
 
-    return wresult;
+    return result;
+}
+
+/**
+ *  Function to detach a waiter attached with imu_add_waiter().
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param waiter_handle
+ *   Waiter to detach
+ */
+void imu_remove_waiter(imu_t imu_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imu_t, imu_handle);
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+
+    Lock(p_imu->lock);
+    for (uint32_t i = 0; i < p_imu->waiter_count; i++)
+    {
+        if (p_imu->waiters[i] == waiter_handle)
+        {
+            p_imu->waiters[i] = p_imu->waiters[--p_imu->waiter_count];
+            break;
+        }
+    }
+    Unlock(p_imu->lock);
+}
+
+/**
+ *  Function to check whether imu_get_samples() would return without waiting.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @return
+ *   true if samples are buffered, or if the IMU is not streaming and reads fail immediately
+ */
+bool imu_is_ready(imu_t imu_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(false, imu_t, imu_handle);
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+
+    Lock(p_imu->lock);
+    bool ready = !p_imu->samples_enabled || p_imu->sample_count != 0;
+    Unlock(p_imu->lock);
+
+    return ready;
 }
 
 /**
@@ -540,7 +1061,7 @@ k4a_result_t imu_start(imu_t imu_handle, tickcounter_ms_t color_camera_start_tic
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, p_imu == NULL);
 
     p_imu->running = true;
-    queue_enable(p_imu->queue);
+    imu_enable_samples(p_imu);
 
     p_imu->wait_for_ts_reset = false;
     if (color_camera_start_tick != 0)
@@ -565,6 +1086,117 @@ k4a_result_t imu_start(imu_t imu_handle, tickcounter_ms_t color_camera_start_tic
     return result;
 }
 
+/**
+ *  Function to set the number of samples buffered and which sample is dropped when the buffer is full.
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param queue_depth
+ *   Number of samples to buffer, 0 for the default
+ *
+ *  @param policy
+ *   K4A_QUEUE_POLICY_DROP_OLDEST or K4A_QUEUE_POLICY_DROP_NEWEST. Blocking isn't supported, samples arrive on the
+ *   USB thread of the color MCU.
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED    Operation was successful
+ *   K4A_RESULT_FAILED       The IMU is running or an argument is invalid
+ */
+k4a_result_t imu_set_queue_policy(imu_t imu_handle, uint32_t queue_depth, k4a_queue_policy_t policy)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imu_t, imu_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth > 10000);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        policy != K4A_QUEUE_POLICY_DROP_OLDEST && policy != K4A_QUEUE_POLICY_DROP_NEWEST);
+
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    if (queue_depth == 0)
+    {
+        queue_depth = IMU_SAMPLE_RING_CAPACITY;
+    }
+
+    Lock(p_imu->lock);
+    if (p_imu->running)
+    {
+        LOG_ERROR("The IMU sample queue can't be configured while the IMU is running.", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result) && queue_depth != p_imu->sample_capacity)
+    {
+        // The ring is empty while the IMU is stopped, so samples don't need to be carried over
+        k4a_imu_sample_t *samples = (k4a_imu_sample_t *)malloc(queue_depth * sizeof(k4a_imu_sample_t));
+        result = K4A_RESULT_FROM_BOOL(samples != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            free(p_imu->samples);
+            p_imu->samples = samples;
+            p_imu->sample_capacity = queue_depth;
+            p_imu->sample_read_index = 0;
+            p_imu->sample_count = 0;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        p_imu->policy = policy;
+    }
+    Unlock(p_imu->lock);
+
+    return result;
+}
+
+/**
+ *  Function to keep the latest samples for imu_get_history_samples().
+ *
+ *  @param imu_handle
+ *   Handle to this specific object
+ *
+ *  @param enabled
+ *   True to keep a second of samples, false to drop them
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED    Operation was successful
+ *   K4A_RESULT_FAILED       The history could not be allocated
+ */
+k4a_result_t imu_set_history_enabled(imu_t imu_handle, bool enabled)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imu_t, imu_handle);
+
+    imu_context_t *p_imu = imu_t_get_context(imu_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_imu_sample_t *history = NULL;
+
+    if (enabled)
+    {
+        history = (k4a_imu_sample_t *)malloc(IMU_HISTORY_CAPACITY * sizeof(k4a_imu_sample_t));
+        result = K4A_RESULT_FROM_BOOL(history != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        Lock(p_imu->lock);
+        if (enabled && p_imu->history != NULL)
+        {
+            // Already enabled, keep the samples
+            free(history);
+        }
+        else
+        {
+            free(p_imu->history);
+            p_imu->history = history;
+            p_imu->history_write_index = 0;
+            p_imu->history_count = 0;
+        }
+        Unlock(p_imu->lock);
+    }
+
+    return result;
+}
+
 /**
  *  Function to stop the IMU stream.
  *
@@ -583,7 +1215,7 @@ void imu_stop(imu_t imu_handle)
     if (p_imu->running)
     {
         colormcu_imu_stop_streaming(p_imu->color_mcu);
-        queue_disable(p_imu->queue);
+        imu_disable_samples(p_imu);
     }
     p_imu->running = false;
 }
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L // clock_gettime() in time.h
+#endif
+
+// This library
+#include <k4ainternal/latency.h>
+
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/lock.h>
+
+// System dependencies
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Bucket 0 of the histograms ends at 2^LATENCY_FIRST_BUCKET_SHIFT microseconds
+#define LATENCY_FIRST_BUCKET_SHIFT (6)
+
+// Process wide latency statistics
+typedef struct
+{
+    LOCK_HANDLE lock;
+
+    // Access to these members may only occur while holding lock
+    k4a_latency_stats_t stats[K4A_LATENCY_STAGE_NUM];
+} latency_global_t;
+
+static void latency_global_init(latency_global_t *global);
+
+// Creates a function called latency_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(latency_global_t, latency_global_init);
+
+static void latency_global_init(latency_global_t *global)
+{
+    // All other members are initialized to zero
+    global->lock = Lock_Init();
+}
+
+uint64_t latency_get_time_nsec(void)
+{
+    // Same clock as image_apply_system_timestamp(), so stages can start at the system timestamp of an image
+#ifdef _WIN32
+    LARGE_INTEGER qpc = { 0 }, freq = { 0 };
+    if (!QueryPerformanceCounter(&qpc) || !QueryPerformanceFrequency(&freq))
+    {
+        return 0;
+    }
+    return (uint64_t)(qpc.QuadPart / freq.QuadPart * 1000000000 +
+                      qpc.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart);
+#else
+    struct timespec ts_time;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts_time) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)ts_time.tv_sec * 1000000000 + (uint64_t)ts_time.tv_nsec;
+#endif
+}
+
+int latency_get_histogram_bucket(uint64_t latency_usec)
+{
+    int bucket = 0;
+    while (bucket < K4A_LATENCY_HISTOGRAM_BUCKETS - 1 && (latency_usec >> (LATENCY_FIRST_BUCKET_SHIFT + bucket)) != 0)
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+void latency_record(k4a_latency_stage_t stage, uint64_t start_nsec, uint64_t end_nsec)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stage < K4A_LATENCY_STAGE_DEPTH_QUEUE || stage >= K4A_LATENCY_STAGE_NUM);
+    latency_global_t *global = latency_global_t_get();
+
+    if (global->lock == NULL || start_nsec == 0 || end_nsec < start_nsec)
+    {
+        return;
+    }
+
+    uint64_t latency_usec = (end_nsec - start_nsec) / 1000;
+    int bucket = latency_get_histogram_bucket(latency_usec);
+
+    Lock(global->lock);
+    k4a_latency_stats_t *stats = &global->stats[stage];
+    if (stats->count == 0 || latency_usec < stats->min_usec)
+    {
+        stats->min_usec = latency_usec;
+    }
+    if (latency_usec > stats->max_usec)
+    {
+        stats->max_usec = latency_usec;
+    }
+    stats->count++;
+    stats->total_usec += latency_usec;
+    stats->histogram[bucket]++;
+    Unlock(global->lock);
+}
+
+k4a_result_t latency_get_stats(k4a_latency_stage_t stage, k4a_latency_stats_t *stats)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stage < K4A_LATENCY_STAGE_DEPTH_QUEUE || stage >= K4A_LATENCY_STAGE_NUM);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    latency_global_t *global = latency_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+    Lock(global->lock);
+    *stats = global->stats[stage];
+    Unlock(global->lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void latency_reset_stats(void)
+{
+    latency_global_t *global = latency_global_t_get();
+    RETURN_VALUE_IF_ARG(VOID_VALUE, global->lock == NULL);
+
+    Lock(global->lock);
+    memset(global->stats, 0, sizeof(global->stats));
+    Unlock(global->lock);
+}
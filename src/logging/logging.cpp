@@ -15,6 +15,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <chrono>
+#include <mutex>
+#include <new>
 
 // External dependencies
 
@@ -47,9 +50,32 @@ extern "C" {
 
 static const char K4A_ENABLE_LOG_TO_STDOUT[] = "K4A_ENABLE_LOG_TO_STDOUT";
 static const char K4A_LOG_LEVEL[] = "K4A_LOG_LEVEL";
+static const char K4A_LOG_ASYNC[] = "K4A_LOG_ASYNC";
+static const char K4A_LOG_RATE_LIMIT[] = "K4A_LOG_RATE_LIMIT";
 static const char K4A_LOG_FILE_NAME[] = "k4a.log";
 static size_t K4A_LOG_FILE_50MB_MAX_SIZE = (1048576 * 50);
 
+// Messages waiting for the background thread in async mode, must be a power of 2. Messages logged while the queue is
+// full are dropped rather than blocking the thread logging them.
+#define LOG_ASYNC_QUEUE_SIZE (8192)
+#define LOG_ASYNC_FLUSH_INTERVAL_MS (1000)
+
+// Warnings and errors logged by a single call site are limited to K4A_LOG_RATE_LIMIT per window, off by default so
+// the messages reaching a k4a_set_debug_message_handler callback are unchanged unless the user asks for it
+#define LOG_RATE_LIMIT_DEFAULT (0)
+#define LOG_RATE_LIMIT_WINDOW_MS (1000)
+#define LOG_RATE_LIMIT_SITES (256) // Must be a power of 2
+
+// Rate limiting state of a call site, identified by the file and line of the message
+typedef struct
+{
+    const char *file;
+    int line;
+    int64_t window_start_ms;
+    uint32_t count;      // Messages logged in the current window
+    uint32_t suppressed; // Messages dropped in the current window
+} logger_rate_limit_site_t;
+
 typedef struct
 {
     k4a_rwlock_t lock;
@@ -63,6 +89,14 @@ typedef struct
     std::shared_ptr<spdlog::logger> env_logger;
     bool env_logger_is_file_based;
     k4a_log_level_t env_log_level;
+
+    // Maximum number of warnings and errors per call site and window, 0 disables rate limiting. Set at init.
+    uint32_t rate_limit;
+
+    // Call sites that logged warnings or errors, taken under rate_limit_lock only. Sites that do not fit are not
+    // limited.
+    std::mutex *rate_limit_lock;
+    logger_rate_limit_site_t rate_limit_sites[LOG_RATE_LIMIT_SITES];
 } logger_global_context_t;
 
 static void logger_init_once(logger_global_context_t *global);
@@ -133,12 +167,36 @@ static void logger_init_once(logger_global_context_t *global)
     const char *enable_file_logging = nullptr;
     const char *enable_stdout_logging = nullptr;
     const char *logging_level = nullptr;
+    const char *enable_async_logging = nullptr;
+    const char *rate_limit = nullptr;
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
 
     // environment_get_variable will return null or "\0" if the env var is not set - depends on the OS.
     enable_file_logging = environment_get_variable(K4A_ENV_VAR_LOG_TO_A_FILE);
     enable_stdout_logging = environment_get_variable(K4A_ENABLE_LOG_TO_STDOUT);
     logging_level = environment_get_variable(K4A_LOG_LEVEL);
+    enable_async_logging = environment_get_variable(K4A_LOG_ASYNC);
+    rate_limit = environment_get_variable(K4A_LOG_RATE_LIMIT);
+
+    global->rate_limit = LOG_RATE_LIMIT_DEFAULT;
+    if (rate_limit && rate_limit[0] != '\0')
+    {
+        global->rate_limit = (uint32_t)strtoul(rate_limit, NULL, 10);
+    }
+    if (global->rate_limit != 0)
+    {
+        global->rate_limit_lock = new (std::nothrow) std::mutex();
+    }
+
+    if (enable_async_logging && enable_async_logging[0] != '\0' && enable_async_logging[0] != '0')
+    {
+        // Loggers created from here on write from a background thread, so the SDK threads logging a message never
+        // wait for the file or console
+        spdlog::set_async_mode(LOG_ASYNC_QUEUE_SIZE,
+                               spdlog::async_overflow_policy::discard_log_msg,
+                               nullptr,
+                               std::chrono::milliseconds(LOG_ASYNC_FLUSH_INTERVAL_MS));
+    }
 
     if (enable_file_logging && enable_file_logging[0] != '\0')
     {
@@ -262,6 +320,66 @@ void logger_deinit(void)
     rwlock_release_write(&g_context->lock);
 }
 
+static int64_t logger_get_time_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Returns true if the message of a call site may be logged. When messages of the site were dropped in the window that
+// just ended, *suppressed receives their count so the message can report them.
+static bool logger_rate_limit(logger_global_context_t *g_context, const char *file, int line, uint32_t *suppressed)
+{
+    *suppressed = 0;
+    if (g_context->rate_limit_lock == nullptr)
+    {
+        return true;
+    }
+
+    // The file name is a string literal, its address and the line identify the call site
+    size_t hash = ((size_t)(uintptr_t)file >> 3) * 31 + (size_t)line;
+    int64_t now_ms = logger_get_time_ms();
+    bool log = true;
+
+    std::lock_guard<std::mutex> guard(*g_context->rate_limit_lock);
+    for (size_t probe = 0; probe < LOG_RATE_LIMIT_SITES; probe++)
+    {
+        logger_rate_limit_site_t *site = &g_context->rate_limit_sites[(hash + probe) & (LOG_RATE_LIMIT_SITES - 1)];
+        if (site->file == nullptr)
+        {
+            site->file = file;
+            site->line = line;
+            site->window_start_ms = now_ms;
+        }
+        else if (site->file != file || site->line != line)
+        {
+            continue;
+        }
+
+        if (now_ms - site->window_start_ms >= LOG_RATE_LIMIT_WINDOW_MS)
+        {
+            *suppressed = site->suppressed;
+            site->window_start_ms = now_ms;
+            site->count = 0;
+            site->suppressed = 0;
+        }
+
+        if (site->count < g_context->rate_limit)
+        {
+            site->count++;
+        }
+        else
+        {
+            site->suppressed++;
+            log = false;
+        }
+        break;
+    }
+
+    return log;
+}
+
 #if defined(__GNUC__) || defined(__clang__)
 // Enable printf type checking in clang and gcc
 __attribute__((__format__ (__printf__, 2, 0)))
@@ -280,6 +398,14 @@ void logger_log(k4a_log_level_t level, const char * file, const int line, const
         return;
     }
 
+    // A storm of warnings or errors from one place must not stall the thread producing them on logging I/O
+    uint32_t suppressed = 0;
+    if (level <= K4A_LOG_LEVEL_WARNING && !logger_rate_limit(g_context, file, line, &suppressed))
+    {
+        rwlock_release_read(&g_context->lock);
+        return;
+    }
+
     char buffer[1024];
     va_list args;
     va_start(args, format);
@@ -293,6 +419,15 @@ void logger_log(k4a_log_level_t level, const char * file, const int line, const
 #endif
     va_end(args);
 
+    if (suppressed != 0)
+    {
+        size_t length = strlen(buffer);
+        snprintf(buffer + length,
+                 sizeof(buffer) - length,
+                 " (%u more messages from here were dropped by the rate limit)",
+                 suppressed);
+    }
+
     if ((level <= g_context->user_log_level) && (g_context->user_log_level != K4A_LOG_LEVEL_OFF))
     {
         if (g_context->user_callback)
@@ -0,0 +1,162 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <k4ainternal/logging.h>
+
+// System dependencies
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// The trace ring is a flight recorder of binary events. Writers claim a slot with an atomic increment and publish it
+// with a sequence number, so recording never blocks and never formats. The dump copies out the slots whose sequence
+// number did not change while they were read.
+//
+
+#define LOGGER_TRACE_RING_SIZE (32768) // Must be a power of 2
+
+typedef struct
+{
+    std::atomic<uint64_t> sequence; // Position of the event + 1 once written, 0 while it is being written
+    std::atomic<uint64_t> time_nsec;
+    std::atomic<uint64_t> event;
+    std::atomic<uint64_t> args[3];
+} logger_trace_entry_t;
+
+static std::atomic<uint64_t> g_trace_position;
+static logger_trace_entry_t g_trace_ring[LOGGER_TRACE_RING_SIZE];
+
+static const char *const g_trace_event_names[] = {
+    "usb_transfer",       "queue_push",       "queue_pop",         "queue_drop",
+    "depth_engine_start", "depth_engine_end", "capturesync_match", "capturesync_drop",
+};
+static_assert(sizeof(g_trace_event_names) / sizeof(g_trace_event_names[0]) == LOGGER_TRACE_EVENT_COUNT,
+              "Every trace event needs a name");
+
+static uint64_t logger_trace_time_nsec()
+{
+    // steady_clock is the monotonic clock used for image system timestamps
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void logger_trace(logger_trace_event_t event, uint64_t arg0, uint64_t arg1, uint64_t arg2)
+{
+    uint64_t position = g_trace_position.fetch_add(1, std::memory_order_relaxed);
+    logger_trace_entry_t *entry = &g_trace_ring[position & (LOGGER_TRACE_RING_SIZE - 1)];
+
+    entry->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry->time_nsec.store(logger_trace_time_nsec(), std::memory_order_relaxed);
+    entry->event.store((uint64_t)event, std::memory_order_relaxed);
+    entry->args[0].store(arg0, std::memory_order_relaxed);
+    entry->args[1].store(arg1, std::memory_order_relaxed);
+    entry->args[2].store(arg2, std::memory_order_relaxed);
+
+    entry->sequence.store(position + 1, std::memory_order_release);
+}
+
+// Copies the entry recorded at position, returns false if it was overwritten or is still being written
+static bool logger_trace_read(uint64_t position, logger_trace_record_t *record)
+{
+    logger_trace_entry_t *entry = &g_trace_ring[position & (LOGGER_TRACE_RING_SIZE - 1)];
+
+    if (entry->sequence.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+
+    record->time_nsec = entry->time_nsec.load(std::memory_order_relaxed);
+    record->event = (uint32_t)entry->event.load(std::memory_order_relaxed);
+    record->reserved = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        record->args[i] = entry->args[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return entry->sequence.load(std::memory_order_relaxed) == position + 1;
+}
+
+k4a_result_t logger_trace_dump(const char *path, uint64_t duration_usec)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+
+    uint64_t dump_time_nsec = logger_trace_time_nsec();
+    uint64_t end = g_trace_position.load(std::memory_order_acquire);
+    uint64_t begin = end > LOGGER_TRACE_RING_SIZE ? end - LOGGER_TRACE_RING_SIZE : 0;
+    uint64_t min_time_nsec = 0;
+    if (duration_usec != 0 && duration_usec * 1000 < dump_time_nsec)
+    {
+        min_time_nsec = dump_time_nsec - duration_usec * 1000;
+    }
+
+    std::vector<logger_trace_record_t> records;
+    try
+    {
+        records.reserve((size_t)(end - begin));
+    }
+    catch (std::bad_alloc &)
+    {
+        LOG_ERROR("Unable to allocate %llu trace records.", (unsigned long long)(end - begin));
+        return K4A_RESULT_FAILED;
+    }
+
+    for (uint64_t position = begin; position < end; position++)
+    {
+        logger_trace_record_t record;
+        if (logger_trace_read(position, &record) && record.time_nsec >= min_time_nsec)
+        {
+            records.push_back(record);
+        }
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Unable to create trace file \"%s\".", path);
+        return K4A_RESULT_FAILED;
+    }
+
+    logger_trace_file_header_t header = {};
+    memcpy(header.magic, LOGGER_TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOGGER_TRACE_FILE_VERSION;
+    header.event_name_count = LOGGER_TRACE_EVENT_COUNT;
+    header.record_count = records.size();
+    header.dump_time_nsec = dump_time_nsec;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; written && i < LOGGER_TRACE_EVENT_COUNT; i++)
+    {
+        written = fwrite(g_trace_event_names[i], strlen(g_trace_event_names[i]) + 1, 1, file) == 1;
+    }
+    if (written && !records.empty())
+    {
+        written = fwrite(records.data(), sizeof(logger_trace_record_t), records.size(), file) == records.size();
+    }
+    written = fclose(file) == 0 && written;
+
+    if (!written)
+    {
+        LOG_ERROR("Unable to write trace file \"%s\".", path);
+        return K4A_RESULT_FAILED;
+    }
+
+    LOG_INFO("Wrote %llu trace events to \"%s\".", (unsigned long long)records.size(), path);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,485 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <k4ainternal/metrics.h>
+
+// Dependent libraries
+#include <k4ainternal/common.h>
+#include <k4ainternal/latency.h>
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+// System dependencies
+#include <math.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define USEC_TO_SECONDS(usec) ((double)(usec) / 1000000.0)
+#define MS_TO_SECONDS(ms) ((double)(ms) / 1000.0)
+
+// Returns the next metric of the list to fill in, NULL once the list is full
+static k4a_metric_t *metrics_add(metrics_list_t *list,
+                                 k4a_metric_type_t type,
+                                 const char *name,
+                                 const char *help,
+                                 const char *label_name,
+                                 const char *label_value)
+{
+    k4a_metric_t *metric = NULL;
+    if (list->metrics != NULL && list->count < list->capacity)
+    {
+        metric = &list->metrics[list->count];
+        memset(metric, 0, sizeof(*metric));
+        metric->name = name;
+        metric->help = help;
+        metric->label_name = label_name;
+        metric->label_value = label_value;
+        metric->type = type;
+    }
+    list->count++;
+    return metric;
+}
+
+void metrics_add_counter(metrics_list_t *list,
+                         const char *name,
+                         const char *help,
+                         const char *label_name,
+                         const char *label_value,
+                         double value)
+{
+    k4a_metric_t *metric = metrics_add(list, K4A_METRIC_TYPE_COUNTER, name, help, label_name, label_value);
+    if (metric)
+    {
+        metric->value = value;
+    }
+}
+
+void metrics_add_gauge(metrics_list_t *list,
+                       const char *name,
+                       const char *help,
+                       const char *label_name,
+                       const char *label_value,
+                       double value)
+{
+    k4a_metric_t *metric = metrics_add(list, K4A_METRIC_TYPE_GAUGE, name, help, label_name, label_value);
+    if (metric)
+    {
+        metric->value = value;
+    }
+}
+
+void metrics_add_exponential_histogram(metrics_list_t *list,
+                                       const char *name,
+                                       const char *help,
+                                       const char *label_name,
+                                       const char *label_value,
+                                       const uint64_t *bucket_counts,
+                                       uint32_t bucket_count,
+                                       double first_upper_bound,
+                                       double sum)
+{
+    k4a_metric_t *metric = metrics_add(list, K4A_METRIC_TYPE_HISTOGRAM, name, help, label_name, label_value);
+    if (metric)
+    {
+        if (bucket_count > K4A_METRIC_HISTOGRAM_BUCKETS)
+        {
+            bucket_count = K4A_METRIC_HISTOGRAM_BUCKETS;
+        }
+
+        double upper_bound = first_upper_bound;
+        for (uint32_t i = 0; i < bucket_count; i++)
+        {
+            metric->bucket_upper_bounds[i] = i + 1 == bucket_count ? INFINITY : upper_bound;
+            metric->bucket_counts[i] = bucket_counts[i];
+            metric->count += bucket_counts[i];
+            upper_bound *= 2;
+        }
+        metric->bucket_count = bucket_count;
+        metric->value = sum;
+    }
+}
+
+void metrics_add_usb_stream_stats(metrics_list_t *list, const char *stream, const k4a_usb_stream_stats_t *stats)
+{
+    metrics_add_counter(list,
+                        "k4a_usb_completed_transfers_total",
+                        "USB transfers that completed with data",
+                        "stream",
+                        stream,
+                        (double)stats->completed_transfers);
+    metrics_add_counter(list,
+                        "k4a_usb_received_bytes_total",
+                        "Bytes received by completed USB transfers",
+                        "stream",
+                        stream,
+                        (double)stats->bytes_transferred);
+    metrics_add_gauge(list,
+                      "k4a_usb_receive_rate_bytes_per_second",
+                      "USB receive rate over the last full second of streaming",
+                      "stream",
+                      stream,
+                      (double)stats->bytes_per_second);
+    metrics_add_counter(list,
+                        "k4a_usb_timed_out_transfers_total",
+                        "USB transfers that timed out waiting for the device",
+                        "stream",
+                        stream,
+                        (double)stats->timed_out_transfers);
+    metrics_add_counter(list,
+                        "k4a_usb_overflow_transfers_total",
+                        "USB transfers that ended because the device sent more than the transfer size",
+                        "stream",
+                        stream,
+                        (double)stats->overflow_transfers);
+    metrics_add_counter(list,
+                        "k4a_usb_failed_transfers_total",
+                        "USB transfers that ended with any other error",
+                        "stream",
+                        stream,
+                        (double)stats->failed_transfers);
+    metrics_add_counter(list,
+                        "k4a_usb_resubmit_failures_total",
+                        "Completed USB transfers that could not be submitted again",
+                        "stream",
+                        stream,
+                        (double)stats->resubmit_failures);
+    metrics_add_counter(list,
+                        "k4a_usb_stream_recoveries_total",
+                        "Times the USB endpoint was restarted after a transfer error",
+                        "stream",
+                        stream,
+                        (double)stats->stream_recoveries);
+    metrics_add_gauge(list,
+                      "k4a_usb_transfers_in_flight",
+                      "USB transfers submitted and waiting for data",
+                      "stream",
+                      stream,
+                      (double)stats->transfers_in_flight);
+    metrics_add_gauge(list,
+                      "k4a_usb_transfer_target",
+                      "USB transfers the stream keeps submitted",
+                      "stream",
+                      stream,
+                      (double)stats->transfer_target);
+    metrics_add_gauge(list,
+                      "k4a_usb_transfer_size_bytes",
+                      "Size of each USB transfer",
+                      "stream",
+                      stream,
+                      (double)stats->transfer_size);
+
+    // Only the buckets of the transfer latency are kept, not the sum
+    metrics_add_exponential_histogram(list,
+                                      "k4a_usb_transfer_latency_seconds",
+                                      "Time from submitting a USB transfer to its completion",
+                                      "stream",
+                                      stream,
+                                      stats->latency_histogram,
+                                      K4A_USB_LATENCY_HISTOGRAM_BUCKETS,
+                                      MS_TO_SECONDS(1),
+                                      NAN);
+}
+
+void metrics_add_capture_stats(metrics_list_t *list, const k4a_capture_stats_t *stats)
+{
+    metrics_add_counter(list,
+                        "k4a_capture_sync_synchronized_captures_total",
+                        "Captures published with matching color and depth images",
+                        NULL,
+                        NULL,
+                        (double)stats->synchronized_captures);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_timestamp_reset_drops_total",
+                        "Depth captures dropped at start while the device timestamps reset",
+                        NULL,
+                        NULL,
+                        (double)stats->depth_dropped_timestamp_reset);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_unmatched_captures_total",
+                        "Captures that had no match within the sync window",
+                        "stream",
+                        "depth",
+                        (double)stats->depth_unmatched);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_unmatched_captures_total",
+                        "Captures that had no match within the sync window",
+                        "stream",
+                        "color",
+                        (double)stats->color_unmatched);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_queue_overflows_total",
+                        "Captures dropped because a queue was full",
+                        "queue",
+                        "depth",
+                        (double)stats->depth_queue_overflow);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_queue_overflows_total",
+                        "Captures dropped because a queue was full",
+                        "queue",
+                        "color",
+                        (double)stats->color_queue_overflow);
+    metrics_add_counter(list,
+                        "k4a_capture_sync_queue_overflows_total",
+                        "Captures dropped because a queue was full",
+                        "queue",
+                        "output",
+                        (double)stats->output_queue_overflow);
+    metrics_add_gauge(list,
+                      "k4a_capture_sync_skew_seconds",
+                      "Average depth minus color timestamp of synchronized captures",
+                      NULL,
+                      NULL,
+                      USEC_TO_SECONDS(stats->average_skew_usec));
+    metrics_add_gauge(list,
+                      "k4a_capture_sync_queued_captures",
+                      "Captures waiting in a queue",
+                      "queue",
+                      "depth",
+                      (double)stats->depth_queue_count);
+    metrics_add_gauge(list,
+                      "k4a_capture_sync_queued_captures",
+                      "Captures waiting in a queue",
+                      "queue",
+                      "color",
+                      (double)stats->color_queue_count);
+    metrics_add_gauge(list,
+                      "k4a_capture_sync_queued_captures",
+                      "Captures waiting in a queue",
+                      "queue",
+                      "output",
+                      (double)stats->output_queue_count);
+}
+
+void metrics_add_depth_engine_stats(metrics_list_t *list, const dewrapper_stats_t *stats)
+{
+    metrics_add_counter(list,
+                        "k4a_depth_engine_processed_frames_total",
+                        "Frames the depth engine completed",
+                        NULL,
+                        NULL,
+                        (double)stats->processed_frames);
+    metrics_add_counter(list,
+                        "k4a_depth_engine_failed_frames_total",
+                        "Frames the depth engine failed or dropped",
+                        NULL,
+                        NULL,
+                        (double)stats->failed_frames);
+    metrics_add_counter(list,
+                        "k4a_depth_engine_slow_frames_total",
+                        "Frames the depth engine took longer than the frame period to process",
+                        NULL,
+                        NULL,
+                        (double)stats->slow_frames);
+    metrics_add_gauge(list,
+                      "k4a_depth_engine_compute_budget_seconds",
+                      "Processing time of a frame that keeps up with the frame rate",
+                      NULL,
+                      NULL,
+                      MS_TO_SECONDS(stats->max_compute_time_ms));
+    metrics_add_gauge(list,
+                      "k4a_depth_engine_last_compute_time_seconds",
+                      "Processing time of the last frame completed by the depth engine",
+                      NULL,
+                      NULL,
+                      MS_TO_SECONDS(stats->last_compute_time_ms));
+    metrics_add_exponential_histogram(list,
+                                      "k4a_depth_engine_compute_time_seconds",
+                                      "Processing time of the frames completed by the depth engine",
+                                      NULL,
+                                      NULL,
+                                      stats->compute_time_histogram,
+                                      K4A_LATENCY_HISTOGRAM_BUCKETS,
+                                      USEC_TO_SECONDS(64),
+                                      USEC_TO_SECONDS(stats->compute_time_total_usec));
+    metrics_add_gauge(list,
+                      "k4a_depth_engine_overloaded",
+                      "1 while the depth engine overload policy drops raw frames, otherwise 0",
+                      NULL,
+                      NULL,
+                      stats->overloaded ? 1 : 0);
+    metrics_add_counter(list,
+                        "k4a_depth_engine_overloads_total",
+                        "Times the depth engine became overloaded",
+                        NULL,
+                        NULL,
+                        (double)stats->overloads);
+    metrics_add_counter(list,
+                        "k4a_depth_engine_overload_dropped_frames_total",
+                        "Raw frames dropped by the depth engine overload policy",
+                        NULL,
+                        NULL,
+                        (double)stats->overload_dropped_frames);
+}
+
+static void metrics_add_allocator_source_stats(metrics_list_t *list,
+                                               const char *source,
+                                               const k4a_allocator_source_stats_t *stats)
+{
+    metrics_add_gauge(list,
+                      "k4a_allocator_live_buffers",
+                      "Buffers currently allocated by the SDK",
+                      "source",
+                      source,
+                      (double)stats->live_count);
+    metrics_add_gauge(list,
+                      "k4a_allocator_live_bytes",
+                      "Bytes currently allocated by the SDK",
+                      "source",
+                      source,
+                      (double)stats->live_bytes);
+    metrics_add_gauge(list,
+                      "k4a_allocator_peak_bytes",
+                      "Largest number of bytes allocated by the SDK at once",
+                      "source",
+                      source,
+                      (double)stats->peak_bytes);
+    metrics_add_counter(list,
+                        "k4a_allocator_allocations_total",
+                        "Buffers allocated by the SDK",
+                        "source",
+                        source,
+                        (double)stats->total_allocations);
+}
+
+void metrics_add_allocator_stats(metrics_list_t *list, const k4a_allocator_stats_t *stats)
+{
+    metrics_add_allocator_source_stats(list, "user", &stats->user);
+    metrics_add_allocator_source_stats(list, "depth", &stats->depth);
+    metrics_add_allocator_source_stats(list, "color", &stats->color);
+    metrics_add_allocator_source_stats(list, "imu", &stats->imu);
+    metrics_add_allocator_source_stats(list, "usb_depth", &stats->usb_depth);
+    metrics_add_allocator_source_stats(list, "usb_imu", &stats->usb_imu);
+}
+
+void metrics_add_latency_stats(metrics_list_t *list)
+{
+    static const char *const stage_names[K4A_LATENCY_STAGE_NUM] = {
+        "depth_queue", "depth_engine", "capture_sync", "user", "total",
+    };
+
+    for (int stage = 0; stage < K4A_LATENCY_STAGE_NUM; stage++)
+    {
+        k4a_latency_stats_t stats;
+        if (K4A_SUCCEEDED(latency_get_stats((k4a_latency_stage_t)stage, &stats)))
+        {
+            metrics_add_exponential_histogram(list,
+                                              "k4a_pipeline_latency_seconds",
+                                              "Time captures spent in a stage of the depth capture pipeline",
+                                              "stage",
+                                              stage_names[stage],
+                                              stats.histogram,
+                                              K4A_LATENCY_HISTOGRAM_BUCKETS,
+                                              USEC_TO_SECONDS(64),
+                                              USEC_TO_SECONDS(stats.total_usec));
+        }
+    }
+}
+
+typedef struct _metrics_sink_context_t
+{
+    uint32_t period_ms;
+    metrics_sink_cb_t *callback;
+    void *context;
+
+    THREAD_HANDLE thread;
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    bool stop;
+} metrics_sink_context_t;
+
+K4A_DECLARE_CONTEXT(metrics_sink_t, metrics_sink_context_t);
+
+static int metrics_sink_thread(void *param)
+{
+    metrics_sink_context_t *sink = (metrics_sink_context_t *)param;
+
+    Lock(sink->lock);
+    while (!sink->stop)
+    {
+        (void)Condition_Wait(sink->condition, sink->lock, (int)sink->period_ms);
+        if (!sink->stop)
+        {
+            Unlock(sink->lock);
+            sink->callback(sink->context);
+            Lock(sink->lock);
+        }
+    }
+    Unlock(sink->lock);
+
+    return 0;
+}
+
+k4a_result_t metrics_sink_create(uint32_t period_ms,
+                                 metrics_sink_cb_t *callback,
+                                 void *context,
+                                 metrics_sink_t *sink_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, period_ms == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, callback == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sink_handle == NULL);
+
+    metrics_sink_context_t *sink = metrics_sink_t_create(sink_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(sink != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        sink->period_ms = period_ms;
+        sink->callback = callback;
+        sink->context = context;
+
+        sink->lock = Lock_Init();
+        sink->condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(sink->lock != NULL && sink->condition != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL(ThreadAPI_Create(&sink->thread, metrics_sink_thread, sink) == THREADAPI_OK);
+    }
+
+    if (K4A_FAILED(result) && sink != NULL)
+    {
+        metrics_sink_destroy(*sink_handle);
+        *sink_handle = NULL;
+    }
+
+    return result;
+}
+
+void metrics_sink_destroy(metrics_sink_t sink_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, metrics_sink_t, sink_handle);
+    metrics_sink_context_t *sink = metrics_sink_t_get_context(sink_handle);
+
+    if (sink->thread)
+    {
+        Lock(sink->lock);
+        sink->stop = true;
+        Condition_Post(sink->condition);
+        Unlock(sink->lock);
+
+        int thread_result;
+        (void)K4A_RESULT_FROM_BOOL(ThreadAPI_Join(sink->thread, &thread_result) == THREADAPI_OK);
+    }
+
+    if (sink->condition)
+    {
+        Condition_Deinit(sink->condition);
+    }
+    if (sink->lock)
+    {
+        Lock_Deinit(sink->lock);
+    }
+
+    metrics_sink_t_destroy(sink_handle);
+}
+
+#ifdef __cplusplus
+}
+#endif
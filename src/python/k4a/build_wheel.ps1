@@ -9,6 +9,12 @@ If (-not (Test-Path -Path "$PSScriptRoot\src\k4a\_libs\k4a.dll")) {
     exit 1
 }
 
+If (-not (Test-Path -Path "$PSScriptRoot\src\k4a\_libs\k4arecord.dll")) {
+    Write-Host "File not found: $PSScriptRoot\src\k4a\_libs\k4arecord.dll"
+    Write-Host "Please manually copy the k4arecord library into that folder."
+    exit 1
+}
+
 If (-not(Test-Path -Path "$PSScriptRoot\src\k4a\_libs\depthengine*.dll")) {
     Write-Host "File not found: $PSScriptRoot\src\k4a\_libs\depthengine*.dll"
     Write-Host "Please manually copy the depth engine library into that folder."
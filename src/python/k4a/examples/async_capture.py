@@ -0,0 +1,91 @@
+'''
+async_capture.py
+
+A program that reads the captures and IMU samples of every connected Azure
+Kinect device from asyncio coroutines, next to a processing coroutine that
+stands in for an inference loop, all in one Python process.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+Licensed under the MIT License.
+Kinect For Azure SDK.
+'''
+
+import asyncio
+
+# This will import all the public symbols into the k4a namespace.
+import k4a
+
+
+async def read_captures(reader, device, index, queue, count):
+
+    for n in range(count):
+        # Other coroutines run while the reader waits for the capture.
+        capture = await reader.get_capture(device)
+        if capture is None:
+            break
+
+        # Keep only the latest captures if processing falls behind.
+        if queue.full():
+            queue.get_nowait()
+        queue.put_nowait((index, capture))
+
+
+async def read_imu(reader, device, index, count):
+
+    samples_read = 0
+    while samples_read < count:
+        # All the buffered samples are returned at once.
+        imu_samples = await reader.get_imu_samples(device, 32)
+        if imu_samples is None:
+            break
+        samples_read = samples_read + len(imu_samples)
+
+    print('Device {}: read {} IMU samples.'.format(index, samples_read))
+
+
+async def process_captures(queue):
+
+    while True:
+        (index, capture) = await queue.get()
+        if capture.depth is not None:
+            print('Device {}: depth image at {} usec.'.format(
+                index, capture.depth.device_timestamp_usec))
+
+
+async def async_capture():
+
+    devices = []
+    for index in range(k4a.Device.get_device_count()):
+        device = k4a.Device.open(index)
+        if device is None:
+            continue
+        device.start_cameras(k4a.DEVICE_CONFIG_BGRA32_1080P_WFOV_2X2BINNED_FPS15)
+        device.start_imu()
+        devices.append(device)
+
+    if len(devices) == 0:
+        print('No device could be opened.')
+        return
+
+    # One reader waits for the streams of all the devices on a single thread.
+    queue = asyncio.Queue(maxsize=len(devices) * 2)
+    with k4a.AsyncDeviceReader() as reader:
+        processing = asyncio.ensure_future(process_captures(queue))
+
+        readers = []
+        for (index, device) in enumerate(devices):
+            readers.append(read_captures(reader, device, index, queue, 60))
+            readers.append(read_imu(reader, device, index, 1000))
+        await asyncio.gather(*readers)
+
+        processing.cancel()
+
+    for device in devices:
+        device.stop_imu()
+        device.stop_cameras()
+        device.close()
+
+
+if __name__ == '__main__':
+    loop = asyncio.get_event_loop()
+    loop.run_until_complete(async_capture())
@@ -1,6 +1,9 @@
 from ._bindings.k4atypes import *
+from ._bindings.k4arecordtypes import EStreamResult, EPlaybackSeekOrigin
 from ._bindings.device import Device
 from ._bindings.capture import Capture
 from ._bindings.image import Image
 from ._bindings.calibration import Calibration
-from ._bindings.transformation import Transformation
\ No newline at end of file
+from ._bindings.transformation import Transformation
+from ._bindings.playback import PlaybackReader
+from ._bindings.async_reader import AsyncDeviceReader
\ No newline at end of file
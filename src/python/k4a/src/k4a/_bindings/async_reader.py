@@ -0,0 +1,313 @@
+'''!
+@file async_reader.py
+
+Defines an AsyncDeviceReader class that reads the captures and IMU samples of
+several devices from asyncio coroutines.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+Licensed under the MIT License.
+Kinect For Azure SDK.
+'''
+
+import asyncio as _asyncio
+import collections as _collections
+import ctypes as _ctypes
+import threading as _threading
+
+from .k4atypes import _CaptureHandle, _WaitSource, EQueueStream, \
+    EWaitStatus, ImuSample
+
+from .k4a import k4a_device_wait_any, k4a_device_get_capture, \
+    k4a_device_get_imu_samples
+
+from .capture import Capture
+
+
+# The reads of one stream of one device, in the order they were started.
+class _StreamReads:
+
+    def __init__(self, device_handle, stream:EQueueStream):
+        self.device_handle = device_handle
+        self.stream = stream
+
+        # (loop, future, max_count) of each read that is waiting for data.
+        self.reads = _collections.deque()
+
+        # Data read for a read that was cancelled, returned by the next read.
+        self.unclaimed = _collections.deque()
+
+
+class AsyncDeviceReader:
+    '''! A class that reads captures and IMU samples from asyncio coroutines.
+
+    @remarks
+    - One thread of the reader waits for every stream with a pending read,
+        across all devices, with a single call to the SDK. The Python global
+        interpreter lock is released while it waits, so the event loop and
+        the other threads of the process keep running, and no thread polls
+        the devices. Data is read once its stream is ready and returned on
+        the event loop that started the read.
+
+    @remarks
+    - A read started while the thread is waiting for other streams joins the
+        wait within @p wake_interval_ms. Reads of streams that are already
+        being waited for don't wait for the interval.
+
+    @remarks
+    - Read each stream of a device through one reader, and don't call
+        Device.get_capture() or Device.get_imu_sample() for that stream at
+        the same time. Captures of a device with a capture callback are not
+        queued, and can't be read with an AsyncDeviceReader.
+
+    @remarks
+    - If a read is cancelled after its data was read from the device, the
+        data is returned by the next read of the same stream instead of being
+        lost.
+
+    @remarks
+    - Reads complete with None when the stream fails, for example when the
+        device is disconnected or the stream is stopped while waiting, as
+        Device.get_capture() does.
+    '''
+
+    def __init__(self, wake_interval_ms:int=10):
+        '''! Create a reader. The thread of the reader is started by the
+            first read.
+
+        @param wake_interval_ms (int, optional): The longest time a read of a
+            stream that isn't being waited for waits to join the wait of the
+            thread. Defaults to 10.
+        '''
+        self._wake_interval_ms = max(1, wake_interval_ms)
+        self._condition = _threading.Condition()
+        self._streams = {}
+        self._thread = None
+        self._closed = False
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    async def get_capture(self, device)->Capture:
+        '''! Waits for the next capture of a device.
+
+        @param device (Device): A device whose cameras were started with
+            Device.start_cameras().
+
+        @returns The next Capture in the streamed sequence of captures, or
+            None if the stream failed.
+        '''
+        return await self._start_read(device, EQueueStream.CAPTURE, 0)
+
+    async def get_imu_samples(self, device, max_count:int=64)->list:
+        '''! Waits for the next IMU samples of a device.
+
+        @param device (Device): A device whose IMU was started with
+            Device.start_imu().
+
+        @param max_count (int, optional): The most samples to return.
+            Defaults to 64.
+
+        @returns A list of the buffered ImuSample, oldest first, with at
+            least one sample and at most @p max_count. None if the stream
+            failed.
+
+        @remarks
+        - All the samples buffered when the stream becomes ready are read at
+            once, up to @p max_count, so the backlog is read without waking
+            the event loop for each sample.
+        '''
+        if max_count < 1:
+            raise ValueError('max_count must be at least 1.')
+        return await self._start_read(device, EQueueStream.IMU, max_count)
+
+    def close(self):
+        '''! Stops the thread of the reader and cancels the pending reads.
+
+        @remarks
+        - Waits for the thread to finish its current wait, at most
+            @p wake_interval_ms.
+        '''
+        with self._condition:
+            if self._closed:
+                return
+            self._closed = True
+            self._condition.notify()
+            thread = self._thread
+
+        if thread is not None and thread is not _threading.current_thread():
+            thread.join()
+
+        for stream in self._streams.values():
+            for (loop, future, _) in stream.reads:
+                try:
+                    loop.call_soon_threadsafe(future.cancel)
+                except RuntimeError:
+                    # The event loop of the read was already closed.
+                    pass
+            stream.reads.clear()
+            stream.unclaimed.clear()
+
+    def _start_read(self, device, stream:EQueueStream, max_count:int):
+        loop = _asyncio.get_event_loop()
+        future = loop.create_future()
+
+        with self._condition:
+            if self._closed:
+                raise RuntimeError('The AsyncDeviceReader is closed.')
+
+            device_handle = device._get_handle()
+            if device_handle is None:
+                raise ValueError('The device is not open.')
+
+            key = (_ctypes.cast(device_handle, _ctypes.c_void_p).value, stream)
+            stream_reads = self._streams.get(key)
+            if stream_reads is None:
+                stream_reads = _StreamReads(device_handle, stream)
+                self._streams[key] = stream_reads
+
+            if stream_reads.unclaimed and not stream_reads.reads:
+                future.set_result(self._claim(stream_reads, max_count))
+                return future
+
+            stream_reads.reads.append((loop, future, max_count))
+
+            if self._thread is None:
+                self._thread = _threading.Thread(
+                    target=self._run, name='k4a AsyncDeviceReader', daemon=True)
+                self._thread.start()
+            self._condition.notify()
+
+        return future
+
+    # Returns the data of a cancelled read to a new read. Lock(self._condition)
+    # must be held.
+    def _claim(self, stream_reads:_StreamReads, max_count:int):
+        result = stream_reads.unclaimed.popleft()
+        if stream_reads.stream == EQueueStream.IMU and len(result) > max_count:
+            stream_reads.unclaimed.appendleft(result[max_count:])
+            result = result[:max_count]
+        return result
+
+    # Returns the streams that have a read waiting for data, after dropping the
+    # reads that were cancelled. Lock(self._condition) must be held.
+    def _get_waiting_streams(self)->list:
+        waiting = []
+        for stream_reads in self._streams.values():
+            while stream_reads.reads and stream_reads.reads[0][1].cancelled():
+                stream_reads.reads.popleft()
+            if stream_reads.reads:
+                waiting.append(stream_reads)
+        return waiting
+
+    def _run(self):
+        while True:
+            with self._condition:
+                waiting = self._get_waiting_streams()
+                while not self._closed and not waiting:
+                    self._condition.wait()
+                    waiting = self._get_waiting_streams()
+                if self._closed:
+                    return
+
+                # The data of cancelled reads goes to the next reads before the
+                # devices are read again.
+                claimed = []
+                for stream_reads in waiting:
+                    while stream_reads.reads and stream_reads.unclaimed:
+                        (loop, future, max_count) = stream_reads.reads.popleft()
+                        result = self._claim(stream_reads, max_count)
+                        claimed.append((loop, stream_reads, future, result))
+                waiting = [stream_reads for stream_reads in waiting if stream_reads.reads]
+
+            for (loop, stream_reads, future, result) in claimed:
+                self._deliver(loop, stream_reads, future, result)
+            if not waiting:
+                continue
+
+            sources = (_WaitSource * len(waiting))()
+            for n in range(len(waiting)):
+                sources[n].device = waiting[n].device_handle
+                sources[n].stream = waiting[n].stream
+
+            # The global interpreter lock is released for the wait.
+            status = k4a_device_wait_any(
+                sources, len(waiting), _ctypes.c_int32(self._wake_interval_ms))
+
+            if status == EWaitStatus.TIMEOUT:
+                continue
+
+            for n in range(len(waiting)):
+                if status == EWaitStatus.FAILED or sources[n].ready:
+                    self._read(waiting[n], status == EWaitStatus.SUCCEEDED)
+
+    # Reads the data of a ready stream for its oldest read. A failed stream
+    # completes the read with None. Only the thread of the reader removes
+    # reads from a stream.
+    def _read(self, stream_reads:_StreamReads, ready:bool):
+        with self._condition:
+            (loop, future, max_count) = stream_reads.reads[0]
+
+        result = None
+        status = EWaitStatus.FAILED
+        if ready and stream_reads.stream == EQueueStream.CAPTURE:
+            capture_handle = _CaptureHandle()
+            status = k4a_device_get_capture(
+                stream_reads.device_handle,
+                _ctypes.byref(capture_handle),
+                _ctypes.c_int32(0))
+            if status == EWaitStatus.SUCCEEDED:
+                result = Capture(capture_handle=capture_handle)
+        elif ready:
+            imu_samples = (ImuSample * max_count)()
+            sample_count = _ctypes.c_size_t(0)
+            status = k4a_device_get_imu_samples(
+                stream_reads.device_handle,
+                imu_samples,
+                max_count,
+                _ctypes.byref(sample_count),
+                _ctypes.c_int32(0))
+            if status == EWaitStatus.SUCCEEDED:
+                result = list(imu_samples[:sample_count.value])
+
+        if status == EWaitStatus.TIMEOUT:
+            # The data was taken by another reader of the stream, wait again.
+            return
+
+        with self._condition:
+            stream_reads.reads.popleft()
+
+        self._deliver(loop, stream_reads, future, result)
+
+    def _deliver(self, loop, stream_reads:_StreamReads, future, result):
+        try:
+            loop.call_soon_threadsafe(self._complete, stream_reads, future, result)
+        except RuntimeError:
+            # The event loop of the read was closed, nobody is waiting.
+            pass
+
+    # Completes a read on its event loop. The data of a read that was
+    # cancelled is kept for the next read of the stream.
+    def _complete(self, stream_reads:_StreamReads, future, result):
+        if not future.done():
+            future.set_result(result)
+            return
+
+        if result is None:
+            return
+
+        with self._condition:
+            if not self._closed:
+                stream_reads.unclaimed.append(result)
+                self._condition.notify()
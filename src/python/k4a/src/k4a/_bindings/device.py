@@ -326,6 +326,10 @@ class Device:
         - If this function is waiting for data (non-zero timeout) when
             stop_cameras() or close() is called on another thread, this 
             function will encounter an error and return None.
+
+        @remarks
+        - The Python global interpreter lock is released while this function
+            waits, so other Python threads keep running.
         '''
         capture = None
 
@@ -666,6 +670,11 @@ class Device:
 
         return calibration
 
+    # The device handle, for the readers of the package that wait on several
+    # devices at once.
+    def _get_handle(self)->_DeviceHandle:
+        return self.__device_handle
+
     # Define properties and get/set functions. ############### 
     @property
     def serial_number(self):
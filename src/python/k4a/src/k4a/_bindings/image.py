@@ -26,6 +26,24 @@ from .k4a import k4a_image_create, k4a_image_create_from_buffer, \
     k4a_image_get_white_balance, k4a_image_set_white_balance, \
     k4a_image_get_iso_speed, k4a_image_set_iso_speed
 
+class _ImageBufferReference:
+    '''! Holds a reference on an SDK image for as long as an ndarray maps its
+    buffer.
+
+    @remarks
+    - The ndarray returned by Image.data maps the image buffer without
+        copying it. This reference is attached to the ctypes array the ndarray
+        is built on, so the buffer stays valid while the ndarray (or any view of
+        it) is alive, even after the Image is deleted.
+    '''
+
+    def __init__(self, image_handle:_ImageHandle):
+        self._image_handle = image_handle
+        k4a_image_reference(self._image_handle)
+
+    def __del__(self):
+        k4a_image_release(self._image_handle)
+
 class Image:
     '''! A class that represents an image from an imaging sensor in an
     Azure Kinect device.
@@ -584,11 +602,25 @@ class Image:
             assert(array_type is not None), "Unrecognized image format."
             assert(array_len_bytes <= buffer_size), "ndarray size should be less than buffer size in bytes."
 
-            self._data = _np.ctypeslib.as_array(array_type.from_address(
-                _ctypes.c_void_p.from_buffer(buffer_ptr).value))
+            # Map the buffer without copying it, the ndarray keeps its own
+            # reference on the image.
+            buffer = array_type.from_address(
+                _ctypes.c_void_p.from_buffer(buffer_ptr).value)
+            buffer._image_reference = _ImageBufferReference(self.__image_handle)
+            self._data = _np.ctypeslib.as_array(buffer)
 
         return self._data
 
+    @property
+    def __array_interface__(self):
+        '''! NumPy array interface over the image buffer.
+
+        @remarks
+        - numpy.asarray(image) returns an ndarray that shares the image buffer
+            instead of copying it, the ndarray keeps the Image alive.
+        '''
+        return self.data.__array_interface__
+
     @data.deleter
     def data(self):
         del self._data
@@ -21,13 +21,15 @@ import platform as _platform
 from .k4atypes import *
 from .k4atypes import _DeviceHandle, _CaptureHandle, _ImageHandle, \
     _TransformationHandle, _Calibration, _Float2, _Float3, \
-    _memory_allocate_cb, _memory_destroy_cb
+    _memory_allocate_cb, _memory_destroy_cb, _WaitSource
 
 
 __all__ = []
 
 
 # Load the k4a.dll.
+# CDLL releases the global interpreter lock during each call, which lets
+# blocking calls such as k4a_device_get_capture() run alongside other threads.
 try:
     _IS_WINDOWS = 'Windows' == _platform.system()
     _lib_dir = _os_path.join(_os_path.dirname(_os_path.dirname(__file__)), '_libs')
@@ -92,6 +94,26 @@ k4a_device_get_imu_sample.restype = EWaitStatus
 k4a_device_get_imu_sample.argtypes = (_DeviceHandle, _ctypes.POINTER(ImuSample), _ctypes.c_int32)
 
 
+#K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+#                                                        k4a_imu_sample_t *imu_samples,
+#                                                        size_t max_sample_count,
+#                                                        size_t *sample_count,
+#                                                        int32_t timeout_in_ms);
+k4a_device_get_imu_samples = _k4a_lib.k4a_device_get_imu_samples
+k4a_device_get_imu_samples.restype = EWaitStatus
+k4a_device_get_imu_samples.argtypes = (
+    _DeviceHandle, _ctypes.POINTER(ImuSample), _ctypes.c_size_t,
+    _ctypes.POINTER(_ctypes.c_size_t), _ctypes.c_int32)
+
+
+#K4A_EXPORT k4a_wait_result_t k4a_device_wait_any(k4a_wait_source_t *sources,
+#                                                 size_t source_count,
+#                                                 int32_t timeout_in_ms);
+k4a_device_wait_any = _k4a_lib.k4a_device_wait_any
+k4a_device_wait_any.restype = EWaitStatus
+k4a_device_wait_any.argtypes = (_ctypes.POINTER(_WaitSource), _ctypes.c_size_t, _ctypes.c_int32)
+
+
 #K4A_EXPORT k4a_status_t k4a_capture_create(k4a_capture_t *capture_handle);
 k4a_capture_create = _k4a_lib.k4a_capture_create
 k4a_capture_create.restype = EStatus
@@ -0,0 +1,104 @@
+'''!
+@file k4arecord.py
+
+Defines Python _ctypes equivalent functions to those defined in
+k4arecord/playback.h.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+Licensed under the MIT License.
+Kinect For Azure SDK.
+'''
+
+
+import ctypes as _ctypes
+import os.path as _os_path
+import sys as _sys
+import platform as _platform
+
+from .k4atypes import EStatus, _CaptureHandle
+from .k4arecordtypes import EStreamResult, _PlaybackHandle
+
+# Load the k4a library first, the k4arecord library links against it.
+from . import k4a as _k4a
+
+
+__all__ = []
+
+
+# Load the k4arecord.dll.
+try:
+    _IS_WINDOWS = 'Windows' == _platform.system()
+    _lib_dir = _os_path.join(_os_path.dirname(_os_path.dirname(__file__)), '_libs')
+
+    if _IS_WINDOWS:
+        _k4arecord_lib = _ctypes.CDLL(_os_path.join(_lib_dir, 'k4arecord.dll'))
+    else:
+        _k4arecord_lib = _ctypes.CDLL(_os_path.join(_lib_dir, 'libk4arecord.so'))
+
+except Exception as ee:
+    print("Failed to load library", ee)
+    _sys.exit(1)
+
+
+# Map _ctypes symbols to functions in the k4arecord.dll.
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_open_device(const char *path,
+#                                                       uint32_t device_index,
+#                                                       k4a_playback_t *playback_handle);
+k4a_playback_open_device = _k4arecord_lib.k4a_playback_open_device
+k4a_playback_open_device.restype = EStatus
+k4a_playback_open_device.argtypes = (_ctypes.c_char_p, _ctypes.c_uint32, _ctypes.POINTER(_PlaybackHandle))
+
+
+#K4ARECORD_EXPORT void k4a_playback_close(k4a_playback_t playback_handle);
+k4a_playback_close = _k4arecord_lib.k4a_playback_close
+k4a_playback_close.restype = None
+k4a_playback_close.argtypes = (_PlaybackHandle,)
+
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_set_mapped_io(k4a_playback_t playback_handle, bool mapped_io);
+k4a_playback_set_mapped_io = _k4arecord_lib.k4a_playback_set_mapped_io
+k4a_playback_set_mapped_io.restype = EStatus
+k4a_playback_set_mapped_io.argtypes = (_PlaybackHandle, _ctypes.c_bool)
+
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle,
+#                                                                k4a_image_format_t target_format);
+k4a_playback_set_color_conversion = _k4arecord_lib.k4a_playback_set_color_conversion
+k4a_playback_set_color_conversion.restype = EStatus
+k4a_playback_set_color_conversion.argtypes = (_PlaybackHandle, _ctypes.c_int)
+
+
+#K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_t playback_handle,
+#                                                                   k4a_capture_t *capture_handle);
+k4a_playback_get_next_capture = _k4arecord_lib.k4a_playback_get_next_capture
+k4a_playback_get_next_capture.restype = EStreamResult
+k4a_playback_get_next_capture.argtypes = (_PlaybackHandle, _ctypes.POINTER(_CaptureHandle))
+
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_seek_timestamp(k4a_playback_t playback_handle,
+#                                                          int64_t offset_usec,
+#                                                          k4a_playback_seek_origin_t origin);
+k4a_playback_seek_timestamp = _k4arecord_lib.k4a_playback_seek_timestamp
+k4a_playback_seek_timestamp.restype = EStatus
+k4a_playback_seek_timestamp.argtypes = (_PlaybackHandle, _ctypes.c_int64, _ctypes.c_int)
+
+
+#K4ARECORD_EXPORT uint64_t k4a_playback_get_frame_count(k4a_playback_t playback_handle);
+k4a_playback_get_frame_count = _k4arecord_lib.k4a_playback_get_frame_count
+k4a_playback_get_frame_count.restype = _ctypes.c_uint64
+k4a_playback_get_frame_count.argtypes = (_PlaybackHandle,)
+
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_get_frame_offset(k4a_playback_t playback_handle,
+#                                                            uint64_t frame_index,
+#                                                            uint64_t *offset_usec);
+k4a_playback_get_frame_offset = _k4arecord_lib.k4a_playback_get_frame_offset
+k4a_playback_get_frame_offset.restype = EStatus
+k4a_playback_get_frame_offset.argtypes = (_PlaybackHandle, _ctypes.c_uint64, _ctypes.POINTER(_ctypes.c_uint64))
+
+
+#K4ARECORD_EXPORT k4a_result_t k4a_playback_write_index(k4a_playback_t playback_handle);
+k4a_playback_write_index = _k4arecord_lib.k4a_playback_write_index
+k4a_playback_write_index.restype = EStatus
+k4a_playback_write_index.argtypes = (_PlaybackHandle,)
@@ -0,0 +1,54 @@
+'''!
+@file k4arecordtypes.py
+
+Defines the enums and handles used by the Azure Kinect recording API.
+These are analogous to those defined in k4arecord/types.h.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+Licensed under the MIT License.
+Kinect For Azure SDK.
+'''
+
+
+from enum import IntEnum as _IntEnum
+from enum import unique as _unique
+from enum import auto as _auto
+import ctypes as _ctypes
+
+
+@_unique
+class EStreamResult(_IntEnum):
+    '''! Result code returned by the playback APIs that read a stream.
+
+    Name                    | Description
+    ----------------------- | -------------------------------------------------
+    EStreamResult.SUCCEEDED | The result was successful.
+    EStreamResult.FAILED    | The result was a failure.
+    EStreamResult.EOF       | The end of the data stream was reached.
+    '''
+    SUCCEEDED = 0
+    FAILED = _auto()
+    EOF = _auto()
+
+
+@_unique
+class EPlaybackSeekOrigin(_IntEnum):
+    '''! Playback seeking positions.
+
+    Name                              | Description
+    --------------------------------- | ---------------------------------------
+    EPlaybackSeekOrigin.BEGIN         | Seek relative to the beginning of a recording.
+    EPlaybackSeekOrigin.END           | Seek relative to the end of a recording.
+    EPlaybackSeekOrigin.DEVICE_TIME   | Seek to an absolute device timestamp.
+    '''
+    BEGIN = 0
+    END = _auto()
+    DEVICE_TIME = _auto()
+
+
+# K4A_DECLARE_HANDLE(k4a_playback_t);
+class __handle_k4a_playback_t(_ctypes.Structure):
+     _fields_= [
+        ("_rsvd", _ctypes.c_size_t),
+    ]
+_PlaybackHandle = _ctypes.POINTER(__handle_k4a_playback_t)
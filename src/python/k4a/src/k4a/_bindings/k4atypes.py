@@ -520,6 +520,19 @@ class EFirmwareSignature(_IntEnum):
     UNSIGNED = _auto()
 
 
+@_unique
+class EQueueStream(_IntEnum):
+    '''! A stream of a device that is read from a queue.
+
+    Name                    | Description
+    ----------------------- | -------------------------------------------------
+    EQueueStream.CAPTURE    | Captures read with Device.get_capture().
+    EQueueStream.IMU        | Samples read with Device.get_imu_sample().
+    '''
+    CAPTURE = 0
+    IMU = _auto()
+
+
 #define K4A_SUCCEEDED(_result_) (_result_ == SUCCEEDED)
 def K4A_SUCCEEDED(result:EStatus):
     '''! Validate that an EStatus is successful.
@@ -594,6 +607,20 @@ class __handle_k4a_transformation_t(_ctypes.Structure):
 _TransformationHandle = _ctypes.POINTER(__handle_k4a_transformation_t)
 
 
+#typedef struct _k4a_wait_source_t
+#{
+#    k4a_device_t device;
+#    k4a_queue_stream_t stream;
+#    bool ready;
+#} k4a_wait_source_t;
+class _WaitSource(_ctypes.Structure):
+    _fields_= [
+        ("device", _DeviceHandle),
+        ("stream", _ctypes.c_int),
+        ("ready", _ctypes.c_bool),
+    ]
+
+
 class DeviceConfiguration(_ctypes.Structure):
     '''! Configuration parameters for an Azure Kinect device.
 
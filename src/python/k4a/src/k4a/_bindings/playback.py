@@ -0,0 +1,280 @@
+'''!
+@file playback.py
+
+Defines a PlaybackReader class that reads the captures of a recording by
+frame index, for use as a dataset in multi-process data loaders.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+Licensed under the MIT License.
+Kinect For Azure SDK.
+'''
+
+import ctypes as _ctypes
+import os as _os
+import numpy as _np
+
+from .k4atypes import _CaptureHandle, EStatus, EImageFormat
+from .k4arecordtypes import _PlaybackHandle, EStreamResult, EPlaybackSeekOrigin
+
+from .k4a import k4a_capture_release, k4a_capture_get_color_image, \
+    k4a_capture_get_depth_image, k4a_capture_get_ir_image
+
+from .k4arecord import k4a_playback_open_device, k4a_playback_close, \
+    k4a_playback_set_mapped_io, k4a_playback_set_color_conversion, \
+    k4a_playback_get_next_capture, k4a_playback_seek_timestamp, \
+    k4a_playback_get_frame_count, k4a_playback_get_frame_offset, \
+    k4a_playback_write_index
+
+from .image import Image
+
+class PlaybackReader:
+    '''! A class that reads the captures of a recording by frame index.
+
+    @remarks
+    - A PlaybackReader only stores the path of the recording until it is
+        read from. The recording is opened on first use in each process, so a
+        reader can be created in a parent process and handed to worker
+        processes, whether they are forked or spawned. A worker never uses a
+        playback handle opened by another process. A forked worker ignores
+        the handle it inherited without closing it, since the threads and
+        file state behind it belong to the parent.
+
+    @remarks
+    - The start offset of every frame is computed once, the first time the
+        length of the reader is requested or a frame is read, and is passed
+        to the workers along with the path. Workers then seek by timestamp
+        and don't read every cluster of the recording to build their own
+        frame index. Calling len() on the reader in the parent process, as
+        data loaders do, computes the offsets before the workers start.
+
+    @remarks
+    - Opening a recording reads its sidecar index if one was written, see
+        write_index(). Each worker then opens the recording without searching
+        it for its clusters.
+
+    @remarks
+    - Images are read and decoded in the process that calls read_frame() or
+        indexes the reader, so the decoding cost is spread over the workers.
+
+    @remarks
+    - The recording is read through a memory mapping by default. The numpy
+        arrays returned for each image map the SDK image buffer without
+        copying it. Images stored without conversion, such as uncompressed
+        color images in their recorded format, reference the mapped file
+        directly. Depth and IR images stored as big-endian grayscale or with
+        RVL compression are converted into a new buffer once.
+
+    @remarks
+    - Do not use the same PlaybackReader from several threads of one
+        process at a time, a playback handle has a single read position.
+    '''
+
+    def __init__(self,
+        path:str,
+        device_index:int=0,
+        color_format:EImageFormat=None,
+        mapped_io:bool=True):
+        '''! Create a reader for a recording. The recording is not opened
+            until it is read from.
+
+        @param path (str): Filesystem path of the recording.
+
+        @param device_index (int, optional): The device to read from a
+            recording that holds several devices. Defaults to 0.
+
+        @param color_format (EImageFormat, optional): The format color images
+            are converted to, for example EImageFormat.COLOR_BGRA32 to decode
+            MJPG images. If None, color images are returned in the format
+            they were recorded in.
+
+        @param mapped_io (bool, optional): Read the recording through a memory
+            mapping of the file. Defaults to True.
+        '''
+        self._path = path
+        self._device_index = device_index
+        self._color_format = color_format
+        self._mapped_io = mapped_io
+
+        # The start offset of each frame in microseconds, shared with workers.
+        self._frame_offsets = None
+
+        # The playback handle and the id of the process that opened it.
+        self._playback_handle = None
+        self._pid = None
+
+    def __getstate__(self):
+        # Only the description of the recording is passed to other processes,
+        # never the playback handle.
+        return {
+            'path': self._path,
+            'device_index': self._device_index,
+            'color_format': self._color_format,
+            'mapped_io': self._mapped_io,
+            'frame_offsets': self._frame_offsets,
+        }
+
+    def __setstate__(self, state):
+        self.__init__(
+            state['path'],
+            state['device_index'],
+            state['color_format'],
+            state['mapped_io'])
+        self._frame_offsets = state['frame_offsets']
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def __len__(self):
+        return len(self._get_frame_offsets())
+
+    def __getitem__(self, frame_index:int):
+        frame_count = len(self)
+        if frame_index < 0:
+            frame_index = frame_index + frame_count
+        if frame_index < 0 or frame_index >= frame_count:
+            raise IndexError("frame_index is out of range.")
+
+        return self.read_frame(frame_index)
+
+    def _get_playback_handle(self):
+        # A handle inherited from a parent process is dropped, not closed.
+        if self._pid != _os.getpid():
+            self._playback_handle = None
+            self._pid = None
+
+        if self._playback_handle is None:
+            playback_handle = _PlaybackHandle()
+            status = k4a_playback_open_device(
+                self._path.encode('utf-8'),
+                _ctypes.c_uint32(self._device_index),
+                _ctypes.byref(playback_handle))
+
+            if status != EStatus.SUCCEEDED:
+                return None
+
+            status = k4a_playback_set_mapped_io(playback_handle, self._mapped_io)
+
+            if status == EStatus.SUCCEEDED and self._color_format is not None:
+                status = k4a_playback_set_color_conversion(playback_handle, self._color_format)
+
+            if status != EStatus.SUCCEEDED:
+                k4a_playback_close(playback_handle)
+                return None
+
+            self._playback_handle = playback_handle
+            self._pid = _os.getpid()
+
+        return self._playback_handle
+
+    def _get_frame_offsets(self):
+        if self._frame_offsets is None:
+            playback_handle = self._get_playback_handle()
+            if playback_handle is None:
+                return _np.zeros(0, dtype=_np.uint64)
+
+            frame_count = k4a_playback_get_frame_count(playback_handle)
+            frame_offsets = _np.zeros(frame_count, dtype=_np.uint64)
+            offset_usec = _ctypes.c_uint64()
+            for frame_index in range(frame_count):
+                status = k4a_playback_get_frame_offset(
+                    playback_handle,
+                    _ctypes.c_uint64(frame_index),
+                    _ctypes.byref(offset_usec))
+
+                if status != EStatus.SUCCEEDED:
+                    return _np.zeros(0, dtype=_np.uint64)
+
+                frame_offsets[frame_index] = offset_usec.value
+
+            self._frame_offsets = frame_offsets
+
+        return self._frame_offsets
+
+    @staticmethod
+    def _get_image_data(image_handle):
+        # The capture getters add a reference that the Image releases.
+        if not image_handle:
+            return None
+
+        image = Image._create_from_existing_image_handle(image_handle)
+        return image.data
+
+    def read_frame(self, frame_index:int)->dict:
+        '''! Read a capture of the recording by its index.
+
+        @param frame_index (int): The index of the capture, starting at 0.
+
+        @returns A dict with the keys 'color', 'depth' and 'ir', holding a
+            numpy ndarray for each image of the capture, or None for images
+            missing from the capture. The 'offset_usec' key holds the start
+            offset of the capture in the recording. If the frame could not be
+            read, None is returned.
+
+        @remarks
+        - The ndarrays keep their image buffer alive on their own, they stay
+            valid after the next frame is read or the reader is closed.
+        '''
+        frame_offsets = self._get_frame_offsets()
+        if frame_index < 0 or frame_index >= len(frame_offsets):
+            return None
+
+        playback_handle = self._get_playback_handle()
+        if playback_handle is None:
+            return None
+
+        offset_usec = int(frame_offsets[frame_index])
+        status = k4a_playback_seek_timestamp(
+            playback_handle,
+            _ctypes.c_int64(offset_usec),
+            EPlaybackSeekOrigin.BEGIN)
+
+        if status != EStatus.SUCCEEDED:
+            return None
+
+        capture_handle = _CaptureHandle()
+        result = k4a_playback_get_next_capture(playback_handle, _ctypes.byref(capture_handle))
+
+        if result != EStreamResult.SUCCEEDED:
+            return None
+
+        frame = {
+            'color': PlaybackReader._get_image_data(k4a_capture_get_color_image(capture_handle)),
+            'depth': PlaybackReader._get_image_data(k4a_capture_get_depth_image(capture_handle)),
+            'ir': PlaybackReader._get_image_data(k4a_capture_get_ir_image(capture_handle)),
+            'offset_usec': offset_usec,
+        }
+        k4a_capture_release(capture_handle)
+
+        return frame
+
+    def write_index(self)->EStatus:
+        '''! Write a sidecar index next to the recording, so that every
+            process opening it later finds its clusters without a search.
+
+        @returns EStatus.SUCCEEDED if the index was written.
+
+        @remarks
+        - Writing the index reads through the whole recording once. Write it
+            once, before the recording is used for training.
+        '''
+        playback_handle = self._get_playback_handle()
+        if playback_handle is None:
+            return EStatus.FAILED
+
+        return k4a_playback_write_index(playback_handle)
+
+    def close(self):
+        '''! Close the recording in this process. It is opened again if the
+            reader is read from afterwards.
+        '''
+        if self._playback_handle is not None and self._pid == _os.getpid():
+            k4a_playback_close(self._playback_handle)
+
+        self._playback_handle = None
+        self._pid = None
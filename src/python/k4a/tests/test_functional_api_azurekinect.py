@@ -620,6 +620,17 @@ class Test_Functional_API_Image_AzureKinect(unittest.TestCase):
         self.assertIsNotNone(data)
         self.assertIsInstance(data, np.ndarray)
 
+    def test_functional_fast_api_get_data_zero_copy(self):
+        # The ndarray maps the image buffer, and keeps it valid after the
+        # image is deleted.
+        depth = copy.copy(self.depth)
+        data = np.asarray(depth)
+        self.assertTrue(np.shares_memory(data, depth.data))
+
+        expected = int(data[100, 100])
+        del depth
+        self.assertEqual(int(data[100, 100]), expected)
+
     def test_functional_fast_api_get_image_format(self):
         image_format = self.color.image_format
         self.assertIsNotNone(image_format)
@@ -0,0 +1,52 @@
+'''
+test_unit_async_reader.py
+
+Tests for the AsyncDeviceReader that don't need a device.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+'''
+
+import unittest
+import asyncio
+
+import k4a
+
+
+class TestAsyncDeviceReader(unittest.TestCase):
+    '''Test the state of an AsyncDeviceReader around its reads.
+    '''
+
+    def test_unit_AsyncDeviceReader_close_without_reads(self):
+        reader = k4a.AsyncDeviceReader()
+        reader.close()
+        self.assertIsNone(reader._thread)
+
+        # Closing again does nothing.
+        reader.close()
+
+    def test_unit_AsyncDeviceReader_read_after_close(self):
+        reader = k4a.AsyncDeviceReader()
+        reader.close()
+
+        loop = asyncio.new_event_loop()
+        try:
+            with self.assertRaises(RuntimeError):
+                loop.run_until_complete(reader.get_capture(k4a.Device()))
+        finally:
+            loop.close()
+
+    def test_unit_AsyncDeviceReader_device_not_open(self):
+        loop = asyncio.new_event_loop()
+        try:
+            with k4a.AsyncDeviceReader() as reader:
+                with self.assertRaises(ValueError):
+                    loop.run_until_complete(reader.get_capture(k4a.Device()))
+                with self.assertRaises(ValueError):
+                    loop.run_until_complete(reader.get_imu_samples(k4a.Device(), 0))
+                self.assertIsNone(reader._thread)
+        finally:
+            loop.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,50 @@
+'''
+test_unit_playback_reader.py
+
+Tests for the PlaybackReader state that is passed to worker processes.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+'''
+
+import unittest
+import pickle
+
+import numpy as np
+
+import k4a
+
+
+class TestPlaybackReader(unittest.TestCase):
+    '''Test that a PlaybackReader can be handed to other processes.
+    '''
+
+    def test_unit_PlaybackReader_not_opened(self):
+        reader = k4a.PlaybackReader('not_a_recording.mkv')
+        self.assertIsNone(reader._playback_handle)
+        reader.close()
+
+    def test_unit_PlaybackReader_pickle(self):
+        reader = k4a.PlaybackReader('recording.mkv', 1, k4a.EImageFormat.COLOR_BGRA32, False)
+        reader._frame_offsets = np.array([0, 33333, 66666], dtype=np.uint64)
+
+        copy = pickle.loads(pickle.dumps(reader))
+        self.assertEqual(copy._path, 'recording.mkv')
+        self.assertEqual(copy._device_index, 1)
+        self.assertEqual(copy._color_format, k4a.EImageFormat.COLOR_BGRA32)
+        self.assertFalse(copy._mapped_io)
+        self.assertIsNone(copy._playback_handle)
+        self.assertEqual(len(copy), 3)
+        np.testing.assert_array_equal(copy._frame_offsets, reader._frame_offsets)
+
+    def test_unit_PlaybackReader_index_range(self):
+        reader = k4a.PlaybackReader('recording.mkv')
+        reader._frame_offsets = np.array([0, 33333], dtype=np.uint64)
+
+        with self.assertRaises(IndexError):
+            reader[2]
+        with self.assertRaises(IndexError):
+            reader[-3]
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -14,30 +14,81 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+// Sequentially consistent atomics on 64 bit values used by the lock-free mode
+#ifdef _MSC_VER
+#define queue_atomic_load(ptr) InterlockedCompareExchange64((ptr), 0, 0)
+#define queue_atomic_store(ptr, value) ((void)InterlockedExchange64((ptr), (value)))
+#define queue_atomic_add(ptr, value) InterlockedExchangeAdd64((ptr), (value))
+#define queue_atomic_exchange(ptr, value) InterlockedExchange64((ptr), (value))
+#define queue_atomic_cas(ptr, expected, desired)                                                                      \
+    (InterlockedCompareExchange64((ptr), (desired), (expected)) == (expected))
+#else
+#define queue_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define queue_atomic_store(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define queue_atomic_add(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_SEQ_CST)
+#define queue_atomic_exchange(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define queue_atomic_cas(ptr, expected, desired)                                                                      \
+    __atomic_compare_exchange_n((ptr), &(int64_t){ (expected) }, (desired), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#endif
 
 typedef struct _queue_entry_t
 {
     k4a_capture_t capture;
 } queue_entry_t;
 
+// State of a queue created with queue_create_spsc(). Positions are free running counts of elements written and read,
+// the slot of a position is (position % depth). Only the producer advances write_position. read_position is claimed
+// with a compare and swap, which lets the producer drop the oldest element of a full queue without locking.
+typedef struct _queue_spsc_t
+{
+    volatile int64_t write_position;
+    volatile int64_t read_position;
+    volatile int64_t enabled;
+    volatile int64_t waiters;       // number of consumers blocked on condition, only then does the producer lock
+    volatile int64_t dropped_count; // Count of the dropped captures
+    volatile int64_t waiter_count;  // number of attached queue_waiter_t, the producer locks to notify them
+} queue_spsc_t;
+
 typedef struct _queue_context_t
 {
+    bool spsc; // lock-free single producer / single consumer mode, see queue_create_spsc()
+    queue_spsc_t ring;
+
     bool enabled;
     bool stopped;
     uint32_t queue_pop_blocked; // number of waiting threads for queue_pop so complete
+    uint32_t queue_push_blocked; // number of threads waiting in queue_push for room, see K4A_QUEUE_POLICY_BLOCK
     uint32_t read_location;     // current location to read frokm
     uint32_t write_location;    // current location to write to
     queue_entry_t *queue;       // the queue array
     uint32_t depth;             // 1 element larger than the max elements the queue can hold.
     const char *name;           // Queue name in logger
     uint32_t dropped_count;     // Count of the dropped captures
+    k4a_queue_policy_t policy;  // What queue_push does when the queue is full
 
     LOCK_HANDLE lock;
     COND_HANDLE condition;
+    COND_HANDLE space_condition; // Posted when queue_pop makes room for a blocked queue_push
+
+    queue_waiter_t waiters[QUEUE_MAX_WAITERS]; // Notified on push and disable, see queue_add_waiter()
+    uint32_t waiter_count;
 } queue_context_t;
 
 K4A_DECLARE_CONTEXT(queue_t, queue_context_t);
 
+typedef struct _queue_waiter_context_t
+{
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    bool notified; // Set by queue_waiter_notify(), cleared when queue_waiter_wait() returns
+} queue_waiter_context_t;
+
+K4A_DECLARE_CONTEXT(queue_waiter_t, queue_waiter_context_t);
+
 // This queue is empty if read and write pointers index the same location. The queue is full when the write pointer is
 // one away from pointing at the read location. This means that while we allocate a size of N, we can only hold N-1
 // elements. This allows us to maintain state through the read and write pointers only.
@@ -45,7 +96,18 @@ K4A_DECLARE_CONTEXT(queue_t, queue_context_t);
 #define is_queue_empty(queue) ((queue)->write_location == (queue)->read_location)
 #define is_queue_full(queue) (inc_read_write_location((queue), (queue)->write_location) == (queue)->read_location)
 
-k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle)
+static void queue_notify_waiters_locked(queue_context_t *queue)
+{
+    for (uint32_t i = 0; i < queue->waiter_count; i++)
+    {
+        queue_waiter_notify(queue->waiters[i]);
+    }
+}
+
+static k4a_result_t queue_create_internal(uint32_t queue_depth,
+                                          bool spsc,
+                                          const char *queue_name,
+                                          queue_t *queue_handle)
 {
     k4a_result_t result;
     queue_context_t *queue = queue_t_create(queue_handle);
@@ -53,6 +115,7 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth == 0);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth > 10000); // Sanity Check
     queue->depth = queue_depth + 1;                              // Adding one; see comment on inc_read_write_location()
+    queue->spsc = spsc;
     queue->name = queue_name;
     if (queue->name == NULL)
     {
@@ -71,6 +134,7 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
     if (K4A_SUCCEEDED(result))
     {
         queue->condition = Condition_Init();
+        queue->space_condition = Condition_Init();
     }
     else
     {
@@ -83,6 +147,219 @@ k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t
     return result;
 }
 
+k4a_result_t queue_create(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle)
+{
+    return queue_create_internal(queue_depth, false, queue_name, queue_handle);
+}
+
+k4a_result_t queue_create_spsc(uint32_t queue_depth, const char *queue_name, queue_t *queue_handle)
+{
+    return queue_create_internal(queue_depth, true, queue_name, queue_handle);
+}
+
+k4a_result_t queue_configure(queue_t queue_handle, uint32_t queue_depth, k4a_queue_policy_t policy)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, queue_t, queue_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue_depth > 10000); // Sanity Check
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        policy != K4A_QUEUE_POLICY_DROP_OLDEST && policy != K4A_QUEUE_POLICY_DROP_NEWEST &&
+                            policy != K4A_QUEUE_POLICY_BLOCK);
+
+    queue_context_t *queue = queue_t_get_context(queue_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, queue->spsc);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(queue->lock);
+    if (queue->enabled && (queue_depth + 1 != queue->depth || policy != queue->policy))
+    {
+        LOG_ERROR("Queue \"%s\" must be disabled to be configured.", queue->name);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result) && queue_depth + 1 != queue->depth)
+    {
+        // A disabled queue is empty, so the entries don't need to be carried over
+        assert(is_queue_empty(queue));
+        queue_entry_t *entries = malloc(sizeof(queue_entry_t) * (queue_depth + 1));
+        result = K4A_RESULT_FROM_BOOL(entries != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            free(queue->queue);
+            queue->queue = entries;
+            queue->depth = queue_depth + 1; // Adding one; see comment on inc_read_write_location()
+            queue->read_location = 0;
+            queue->write_location = 0;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        queue->policy = policy;
+    }
+    Unlock(queue->lock);
+
+    return result;
+}
+
+// Removes the oldest element of a lock-free queue. Safe to call from the producer to drop an element while the
+// consumer is popping; the slot is read before the claim, the producer never rewrites a slot that is still unread.
+static k4a_capture_t queue_spsc_claim(queue_context_t *queue)
+{
+    int64_t read_position = queue_atomic_load(&queue->ring.read_position);
+
+    while (read_position != queue_atomic_load(&queue->ring.write_position))
+    {
+        k4a_capture_t capture = queue->queue[read_position % queue->depth].capture;
+        if (queue_atomic_cas(&queue->ring.read_position, read_position, read_position + 1))
+        {
+            return capture;
+        }
+        read_position = queue_atomic_load(&queue->ring.read_position);
+    }
+    return NULL;
+}
+
+static bool queue_spsc_is_empty(queue_context_t *queue)
+{
+    return queue_atomic_load(&queue->ring.read_position) == queue_atomic_load(&queue->ring.write_position);
+}
+
+static k4a_wait_result_t queue_spsc_pop(queue_context_t *queue, int32_t wait_in_ms, k4a_capture_t *out_capture)
+{
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
+    k4a_capture_t capture = NULL;
+
+    if (queue_atomic_load(&queue->ring.enabled) == 0)
+    {
+        LOG_ERROR("Queue \"%s\" was popped in a disabled state.", queue->name);
+        wresult = K4A_WAIT_RESULT_FAILED;
+    }
+
+    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        wresult = K4A_WAIT_RESULT_TIMEOUT;
+
+        capture = queue_spsc_claim(queue);
+        if (capture != NULL)
+        {
+            wresult = K4A_WAIT_RESULT_SUCCEEDED;
+        }
+        else if (wait_in_ms != 0)
+        {
+            // Only an empty queue blocks. Registering as a waiter before checking for data again guarantees that either
+            // the check sees the producer's element or the producer sees the waiter and posts the condition.
+            queue_atomic_add(&queue->ring.waiters, 1);
+            Lock(queue->lock);
+            do
+            {
+                if (queue_atomic_load(&queue->ring.enabled) == 0)
+                {
+                    break;
+                }
+
+                if (queue_spsc_is_empty(queue))
+                {
+                    COND_RESULT cond_result = Condition_Wait(queue->condition,
+                                                             queue->lock,
+                                                             wait_in_ms < 0 ? 0 : wait_in_ms);
+                    if (cond_result == COND_ERROR)
+                    {
+                        wresult = K4A_WAIT_RESULT_FAILED;
+                        break;
+                    }
+                }
+
+                capture = queue_spsc_claim(queue);
+                if (capture != NULL)
+                {
+                    wresult = K4A_WAIT_RESULT_SUCCEEDED;
+                }
+                // An infinite wait does not time out
+            } while (capture == NULL && wait_in_ms < 0);
+            Unlock(queue->lock);
+            queue_atomic_add(&queue->ring.waiters, -1);
+        }
+    }
+
+    if (queue_atomic_load(&queue->ring.enabled) == 0)
+    {
+        wresult = K4A_WAIT_RESULT_FAILED;
+        if (capture)
+        {
+            // drop the capture
+            capture_dec_ref(capture);
+            capture = NULL;
+        }
+    }
+
+    logger_trace(LOGGER_TRACE_QUEUE_POP, (uintptr_t)queue, (uintptr_t)capture, (uint64_t)wresult);
+
+    int64_t dropped_count = queue_atomic_exchange(&queue->ring.dropped_count, 0);
+    if (dropped_count != 0)
+    {
+        LOG_INFO("Queue \"%s\" dropped oldest %d captures from queue.", queue->name, (int)dropped_count);
+    }
+
+    *out_capture = capture;
+
+    return wresult;
+}
+
+static void queue_spsc_push(queue_context_t *queue, k4a_capture_t capture, k4a_capture_t *dropped)
+{
+    if (queue_atomic_load(&queue->ring.enabled) == 0)
+    {
+        LOG_WARNING("Capture pushed into disabled queue.", queue->name);
+        return;
+    }
+
+    int64_t write_position = queue->ring.write_position;
+    if (write_position - queue_atomic_load(&queue->ring.read_position) >= queue->depth - 1)
+    {
+        // Full; if the consumer claims the oldest element first there is room without dropping
+        k4a_capture_t oldest = queue_spsc_claim(queue);
+        if (oldest != NULL)
+        {
+            logger_trace(LOGGER_TRACE_QUEUE_DROP, (uintptr_t)queue, (uintptr_t)oldest, (uint64_t)queue->policy);
+            if (dropped == NULL)
+            {
+                queue_atomic_add(&queue->ring.dropped_count, 1);
+                capture_dec_ref(oldest);
+            }
+            else
+            {
+                *dropped = oldest;
+            }
+        }
+    }
+
+    // We are accepting this into our queue, so add a ref to prevent it
+    // from being freed
+    capture_inc_ref(capture);
+
+    queue->queue[write_position % queue->depth].capture = capture;
+    queue_atomic_store(&queue->ring.write_position, write_position + 1);
+
+    if (queue_atomic_load(&queue->ring.waiters) != 0 || queue_atomic_load(&queue->ring.waiter_count) != 0)
+    {
+        Lock(queue->lock);
+        Condition_Post(queue->condition);
+        queue_notify_waiters_locked(queue);
+        Unlock(queue->lock);
+    }
+
+    if (queue_atomic_load(&queue->ring.enabled) == 0)
+    {
+        // Raced with queue_disable, which may have drained the queue before this element was published
+        while ((capture = queue_spsc_claim(queue)) != NULL)
+        {
+            capture_dec_ref(capture);
+        }
+    }
+}
+
 static k4a_capture_t queue_pop_internal_locked(queue_context_t *queue)
 {
     if (is_queue_empty(queue) == false)
@@ -91,6 +368,11 @@ static k4a_capture_t queue_pop_internal_locked(queue_context_t *queue)
 
         queue->read_location = inc_read_write_location(queue, queue->read_location);
 
+        if (queue->queue_push_blocked != 0)
+        {
+            Condition_Post(queue->space_condition);
+        }
+
         return entry->capture;
     }
     return NULL;
@@ -105,6 +387,11 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
     k4a_capture_t capture = NULL;
     k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
 
+    if (queue->spsc)
+    {
+        return queue_spsc_pop(queue, wait_in_ms, out_capture);
+    }
+
     Lock(queue->lock);
 
     if (queue->enabled != true)
@@ -165,9 +452,11 @@ k4a_wait_result_t queue_pop(queue_t queue_handle, int32_t wait_in_ms, k4a_captur
         }
     }
 
+    logger_trace(LOGGER_TRACE_QUEUE_POP, (uintptr_t)queue, (uintptr_t)capture, (uint64_t)wresult);
+
     if (queue->dropped_count != 0)
     {
-        LOG_INFO("Queue \"%s\" dropped oldest %d captures from queue.", queue->name, queue->dropped_count);
+        LOG_INFO("Queue \"%s\" dropped %d captures from queue.", queue->name, queue->dropped_count);
         queue->dropped_count = 0;
     }
 
@@ -195,6 +484,14 @@ void queue_push_w_dropped(queue_t queue_handle, k4a_capture_t capture, k4a_captu
 
     queue_context_t *queue = queue_t_get_context(queue_handle);
 
+    logger_trace(LOGGER_TRACE_QUEUE_PUSH, (uintptr_t)queue, (uintptr_t)capture, 0);
+
+    if (queue->spsc)
+    {
+        queue_spsc_push(queue, capture, dropped);
+        return;
+    }
+
     Lock(queue->lock);
 
     if (queue->enabled == false)
@@ -203,26 +500,63 @@ void queue_push_w_dropped(queue_t queue_handle, k4a_capture_t capture, k4a_captu
     }
     else
     {
-        if (is_queue_full(queue))
+        bool accepted = true;
+        if (is_queue_full(queue) && queue->policy == K4A_QUEUE_POLICY_BLOCK)
+        {
+            queue->queue_push_blocked++;
+            while (is_queue_full(queue) && queue->enabled)
+            {
+                (void)Condition_Wait(queue->space_condition, queue->lock, 0);
+            }
+            queue->queue_push_blocked--;
+
+            if (queue->enabled == false)
+            {
+                LOG_WARNING("Queue \"%s\" was disabled while a push was blocked.", queue->name);
+                accepted = false;
+            }
+        }
+        else if (is_queue_full(queue) && queue->policy == K4A_QUEUE_POLICY_DROP_NEWEST)
+        {
+            accepted = false;
+            logger_trace(LOGGER_TRACE_QUEUE_DROP, (uintptr_t)queue, (uintptr_t)capture, (uint64_t)queue->policy);
+            if (dropped == NULL)
+            {
+                queue->dropped_count++;
+            }
+            else
+            {
+                // Dropped captures hold a ref the caller releases, the same as those dropped from the queue
+                capture_inc_ref(capture);
+                *dropped = capture;
+            }
+        }
+        else if (is_queue_full(queue))
         {
+            k4a_capture_t oldest = queue_pop_internal_locked(queue);
+            logger_trace(LOGGER_TRACE_QUEUE_DROP, (uintptr_t)queue, (uintptr_t)oldest, (uint64_t)queue->policy);
             if (dropped == NULL)
             {
                 queue->dropped_count++;
-                capture_dec_ref(queue_pop_internal_locked(queue));
+                capture_dec_ref(oldest);
             }
             else
             {
-                *dropped = queue_pop_internal_locked(queue);
+                *dropped = oldest;
             }
         }
 
-        // We are accepting this into our queue, so add a ref to prevent it
-        // from being freed
-        capture_inc_ref(capture);
+        if (accepted)
+        {
+            // We are accepting this into our queue, so add a ref to prevent it
+            // from being freed
+            capture_inc_ref(capture);
 
-        queue_push_internal_locked(queue, capture);
+            queue_push_internal_locked(queue, capture);
 
-        Condition_Post(queue->condition);
+            Condition_Post(queue->condition);
+            queue_notify_waiters_locked(queue);
+        }
     }
     Unlock(queue->lock);
 }
@@ -232,6 +566,27 @@ void queue_push(queue_t queue_handle, k4a_capture_t capture)
     queue_push_w_dropped(queue_handle, capture, NULL);
 }
 
+uint32_t queue_get_count(queue_t queue_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, queue_t, queue_handle);
+    queue_context_t *queue = queue_t_get_context(queue_handle);
+    uint32_t count;
+
+    if (queue->spsc)
+    {
+        int64_t read_position = queue_atomic_load(&queue->ring.read_position);
+        int64_t write_position = queue_atomic_load(&queue->ring.write_position);
+        count = write_position > read_position ? (uint32_t)(write_position - read_position) : 0;
+    }
+    else
+    {
+        Lock(queue->lock);
+        count = (queue->write_location + queue->depth - queue->read_location) % queue->depth;
+        Unlock(queue->lock);
+    }
+    return count;
+}
+
 void queue_destroy(queue_t queue_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_t, queue_handle);
@@ -244,6 +599,11 @@ void queue_destroy(queue_t queue_handle)
         Condition_Deinit(queue->condition);
     }
 
+    if (queue->space_condition)
+    {
+        Condition_Deinit(queue->space_condition);
+    }
+
     if (queue->queue)
     {
         free(queue->queue);
@@ -261,6 +621,7 @@ void queue_enable(queue_t queue_handle)
     Lock(queue->lock);
     queue->enabled = true;
     queue->stopped = false;
+    queue_atomic_store(&queue->ring.enabled, 1);
     Unlock(queue->lock);
 }
 
@@ -272,16 +633,31 @@ void queue_disable(queue_t queue_handle)
     Lock(queue->lock);
 
     queue->enabled = false;
+    queue_atomic_store(&queue->ring.enabled, 0);
+
+    // A disabled queue fails pops immediately, which waiters treat as ready
+    queue_notify_waiters_locked(queue);
 
-    while (queue->queue_pop_blocked != 0)
+    while (queue->queue_pop_blocked != 0 || queue->queue_push_blocked != 0 ||
+           queue_atomic_load(&queue->ring.waiters) != 0)
     {
         LOG_INFO("Queue \"%s\" waiting for blocking call to complete.", queue->name);
         Condition_Post(queue->condition);
+        Condition_Post(queue->space_condition);
         Unlock(queue->lock);
         ThreadAPI_Sleep(25);
         Lock(queue->lock);
     }
 
+    if (queue->spsc)
+    {
+        k4a_capture_t capture;
+        while ((capture = queue_spsc_claim(queue)) != NULL)
+        {
+            capture_dec_ref(capture);
+        }
+    }
+
     while (is_queue_empty(queue) == false)
     {
         capture_dec_ref(queue_pop_internal_locked(queue));
@@ -300,3 +676,158 @@ void queue_stop(queue_t queue_handle)
     LOG_INFO("Queue \"%s\" stopped, shutting down and notifying consumers.", queue->name);
     queue_disable(queue_handle);
 }
+
+k4a_result_t queue_waiter_create(queue_waiter_t *waiter_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, waiter_handle == NULL);
+
+    queue_waiter_context_t *waiter = queue_waiter_t_create(waiter_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(waiter != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        waiter->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(waiter->lock != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        waiter->condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(waiter->condition != NULL);
+    }
+
+    if (K4A_FAILED(result) && waiter != NULL)
+    {
+        queue_waiter_destroy(*waiter_handle);
+        *waiter_handle = NULL;
+    }
+    return result;
+}
+
+void queue_waiter_destroy(queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_waiter_t, waiter_handle);
+    queue_waiter_context_t *waiter = queue_waiter_t_get_context(waiter_handle);
+
+    if (waiter->condition)
+    {
+        Condition_Deinit(waiter->condition);
+    }
+
+    if (waiter->lock)
+    {
+        Lock_Deinit(waiter->lock);
+    }
+
+    queue_waiter_t_destroy(waiter_handle);
+}
+
+void queue_waiter_notify(queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_waiter_t, waiter_handle);
+    queue_waiter_context_t *waiter = queue_waiter_t_get_context(waiter_handle);
+
+    Lock(waiter->lock);
+    waiter->notified = true;
+    Condition_Post(waiter->condition);
+    Unlock(waiter->lock);
+}
+
+k4a_wait_result_t queue_waiter_wait(queue_waiter_t waiter_handle, int32_t wait_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, queue_waiter_t, waiter_handle);
+    queue_waiter_context_t *waiter = queue_waiter_t_get_context(waiter_handle);
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
+
+    Lock(waiter->lock);
+    while (!waiter->notified && wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        if (wait_in_ms == 0)
+        {
+            wresult = K4A_WAIT_RESULT_TIMEOUT;
+            break;
+        }
+
+        // Anything less than 0 is a wait forever condition, which Condition_Wait expresses with 0
+        COND_RESULT cond_result = Condition_Wait(waiter->condition, waiter->lock, wait_in_ms < 0 ? 0 : wait_in_ms);
+        if (cond_result == COND_TIMEOUT)
+        {
+            wresult = K4A_WAIT_RESULT_TIMEOUT;
+        }
+        else if (cond_result != COND_OK)
+        {
+            wresult = K4A_WAIT_RESULT_FAILED;
+        }
+    }
+
+    if (waiter->notified)
+    {
+        waiter->notified = false;
+        wresult = K4A_WAIT_RESULT_SUCCEEDED;
+    }
+    Unlock(waiter->lock);
+
+    return wresult;
+}
+
+k4a_result_t queue_add_waiter(queue_t queue_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, queue_t, queue_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, queue_waiter_t, waiter_handle);
+    queue_context_t *queue = queue_t_get_context(queue_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(queue->lock);
+    if (queue->waiter_count == QUEUE_MAX_WAITERS)
+    {
+        LOG_ERROR("Queue \"%s\" already has %d waiters attached.", queue->name, QUEUE_MAX_WAITERS);
+        result = K4A_RESULT_FAILED;
+    }
+    else
+    {
+        queue->waiters[queue->waiter_count++] = waiter_handle;
+
+        // The producer of a lock-free queue only takes the lock to notify once it sees the count
+        queue_atomic_add(&queue->ring.waiter_count, 1);
+    }
+    Unlock(queue->lock);
+
+    return result;
+}
+
+void queue_remove_waiter(queue_t queue_handle, queue_waiter_t waiter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, queue_t, queue_handle);
+    queue_context_t *queue = queue_t_get_context(queue_handle);
+
+    Lock(queue->lock);
+    for (uint32_t i = 0; i < queue->waiter_count; i++)
+    {
+        if (queue->waiters[i] == waiter_handle)
+        {
+            queue->waiters[i] = queue->waiters[--queue->waiter_count];
+            queue_atomic_add(&queue->ring.waiter_count, -1);
+            break;
+        }
+    }
+    Unlock(queue->lock);
+}
+
+bool queue_is_ready(queue_t queue_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(false, queue_t, queue_handle);
+    queue_context_t *queue = queue_t_get_context(queue_handle);
+    bool ready;
+
+    if (queue->spsc)
+    {
+        ready = queue_atomic_load(&queue->ring.enabled) == 0 || !queue_spsc_is_empty(queue);
+    }
+    else
+    {
+        Lock(queue->lock);
+        ready = !queue->enabled || !is_queue_empty(queue);
+        Unlock(queue->lock);
+    }
+    return ready;
+}
@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4a/k4a.h>
+#include <k4ainternal/matroska_read.h>
+#include <k4ainternal/logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace k4arecord;
+
+CustomIOCallback::CustomIOCallback(uint64_t size, k4a_playback_read_cb_t *read_cb, void *read_cb_context) :
+    m_read_cb(read_cb),
+    m_read_cb_context(read_cb_context),
+    m_size(size),
+    m_block_count(CUSTOM_IO_BLOCK_COUNT)
+{
+    assert(read_cb);
+
+    // Under a memory budget the blocks hold at most a quarter of it, see k4a_set_memory_budget()
+    size_t memory_budget = k4a_get_memory_budget();
+    if (memory_budget != 0)
+    {
+        m_block_count = std::max((size_t)4, std::min(m_block_count, memory_budget / 4 / CUSTOM_IO_BLOCK_SIZE));
+    }
+}
+
+CustomIOCallback::~CustomIOCallback()
+{
+    close();
+}
+
+CustomIOCallback::future_block_t CustomIOCallback::get_block(uint64_t index)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_closed)
+    {
+        std::promise<std::shared_ptr<std::vector<uint8_t>>> closed;
+        closed.set_value(nullptr);
+        return closed.get_future().share();
+    }
+
+    for (auto it = m_blocks.begin(); it != m_blocks.end(); it++)
+    {
+        if (it->first == index)
+        {
+            // A failed read is retried the next time the block is needed.
+            bool ready = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if (ready && it->second.get() == nullptr)
+            {
+                m_blocks.erase(it);
+                break;
+            }
+
+            m_blocks.splice(m_blocks.begin(), m_blocks, it);
+            return m_blocks.front().second;
+        }
+    }
+
+    // Blocks that are still being read are never evicted, so close() can wait for every read in progress.
+    auto it = m_blocks.end();
+    while (m_blocks.size() >= m_block_count && it != m_blocks.begin())
+    {
+        it--;
+        if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            it = m_blocks.erase(it);
+        }
+    }
+
+    auto read_block = [this, index]() -> std::shared_ptr<std::vector<uint8_t>> {
+        {
+            // A deferred read can run after close(), when the callback context may already be gone.
+            std::lock_guard<std::mutex> closed_lock(m_lock);
+            if (m_closed)
+            {
+                return nullptr;
+            }
+        }
+
+        uint64_t offset = index * CUSTOM_IO_BLOCK_SIZE;
+        size_t size = (size_t)std::min((uint64_t)CUSTOM_IO_BLOCK_SIZE, m_size - offset);
+        std::shared_ptr<std::vector<uint8_t>> block = std::make_shared<std::vector<uint8_t>>(size);
+        if (K4A_FAILED(m_read_cb(offset, block->data(), size, m_read_cb_context)))
+        {
+            LOG_ERROR("Failed to read %llu bytes of the recording at offset %llu.",
+                      (unsigned long long)size,
+                      (unsigned long long)offset);
+            return nullptr;
+        }
+        return block;
+    };
+
+    future_block_t block;
+    try
+    {
+        block = std::async(std::launch::async, read_block).share();
+    }
+    catch (std::system_error &)
+    {
+        // The block is read by the first thread that needs it instead.
+        block = std::async(std::launch::deferred, read_block).share();
+    }
+    m_blocks.emplace_front(index, block);
+    return block;
+}
+
+void CustomIOCallback::prefetch(uint64_t offset, uint64_t size)
+{
+    if (offset >= m_size || size == 0)
+    {
+        return;
+    }
+
+    uint64_t end = std::min(m_size - offset, size) + offset;
+    std::vector<future_block_t> blocks;
+    for (uint64_t index = offset / CUSTOM_IO_BLOCK_SIZE; index * CUSTOM_IO_BLOCK_SIZE < end; index++)
+    {
+        blocks.push_back(get_block(index));
+    }
+    for (future_block_t &block : blocks)
+    {
+        block.wait();
+    }
+}
+
+uint32 CustomIOCallback::read(void *buffer, size_t size)
+{
+    assert(size <= UINT32_MAX); // can't properly return > uint32
+
+    if (m_position >= m_size || size == 0)
+    {
+        return 0;
+    }
+
+    size_t read_size = (size_t)std::min((uint64_t)size, m_size - m_position);
+    uint64_t end = m_position + read_size;
+
+    // Start reading every block before waiting for the first one.
+    std::vector<future_block_t> blocks;
+    for (uint64_t index = m_position / CUSTOM_IO_BLOCK_SIZE; index * CUSTOM_IO_BLOCK_SIZE < end; index++)
+    {
+        blocks.push_back(get_block(index));
+    }
+
+    uint8_t *output = static_cast<uint8_t *>(buffer);
+    for (future_block_t &block : blocks)
+    {
+        std::shared_ptr<std::vector<uint8_t>> data = block.get();
+        if (data == nullptr)
+        {
+            throw std::ios_base::failure("Failed to read recording");
+        }
+
+        size_t block_offset = (size_t)(m_position % CUSTOM_IO_BLOCK_SIZE);
+        size_t copy_size = (size_t)std::min((uint64_t)(data->size() - block_offset), end - m_position);
+        memcpy(output, data->data() + block_offset, copy_size);
+        output += copy_size;
+        m_position += copy_size;
+    }
+    return (uint32)read_size;
+}
+
+void CustomIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+
+    int64_t base = 0;
+    switch (mode)
+    {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = (int64_t)m_position;
+        break;
+    case SEEK_END:
+        base = (int64_t)m_size;
+        break;
+    }
+
+    // Seeking past the end of the recording is allowed, reads there return no data.
+    if (offset < -base)
+    {
+        throw std::ios_base::failure("Failed to seek before the start of the recording");
+    }
+    m_position = (uint64_t)(base + offset);
+}
+
+size_t CustomIOCallback::write(const void *buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    throw std::ios_base::failure("Failed to write recording, the recording is opened as read-only");
+}
+
+uint64 CustomIOCallback::getFilePointer()
+{
+    return m_position;
+}
+
+void CustomIOCallback::close()
+{
+    // The read callback must not be called after the playback is closed, wait for the reads that are in progress.
+    std::list<std::pair<uint64_t, future_block_t>> blocks;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_closed = true;
+        blocks.swap(m_blocks);
+    }
+    for (auto &block : blocks)
+    {
+        block.second.wait();
+    }
+}
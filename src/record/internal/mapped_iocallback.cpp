@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/matroska_read.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace k4arecord;
+
+#ifdef _WIN32
+
+static std::ios_base::failure last_error(const char *message, DWORD error = GetLastError())
+{
+    return std::ios_base::failure(message, std::error_code((int)error, std::system_category()));
+}
+
+MappedFileIOCallback::MappedFileIOCallback(const char *path)
+{
+    assert(path);
+
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        m_file = nullptr;
+        throw last_error("Failed to open file");
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(m_file, &file_size))
+    {
+        std::ios_base::failure error = last_error("Failed to get file size");
+        close();
+        throw error;
+    }
+    m_size = (uint64_t)file_size.QuadPart;
+    if (m_size > SIZE_MAX)
+    {
+        close();
+        throw std::ios_base::failure("File is too large to be mapped on this architecture");
+    }
+
+    // Empty files can't be mapped, they are read as a file without data.
+    if (m_size > 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_mapping == NULL)
+        {
+            std::ios_base::failure error = last_error("Failed to map file");
+            close();
+            throw error;
+        }
+
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            std::ios_base::failure error = last_error("Failed to map file");
+            close();
+            throw error;
+        }
+    }
+}
+
+void MappedFileIOCallback::close()
+{
+    // MappedFileIOCallback::close() can be called more than once, only unmap the file the first time.
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != nullptr)
+    {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+}
+
+#else
+
+static std::ios_base::failure last_error(const char *message, int error = errno)
+{
+    return std::ios_base::failure(message, std::error_code(error, std::generic_category()));
+}
+
+MappedFileIOCallback::MappedFileIOCallback(const char *path)
+{
+    assert(path);
+
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        throw last_error("Failed to open file");
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0)
+    {
+        std::ios_base::failure error = last_error("Failed to get file size");
+        (void)::close(file);
+        throw error;
+    }
+    m_size = (uint64_t)file_stat.st_size;
+    if (m_size > SIZE_MAX)
+    {
+        (void)::close(file);
+        throw std::ios_base::failure("File is too large to be mapped on this architecture");
+    }
+
+    // Empty files can't be mapped, they are read as a file without data.
+    if (m_size > 0)
+    {
+        void *data = mmap(NULL, (size_t)m_size, PROT_READ, MAP_SHARED, file, 0);
+        if (data == MAP_FAILED)
+        {
+            std::ios_base::failure error = last_error("Failed to map file");
+            (void)::close(file);
+            throw error;
+        }
+        m_data = static_cast<const uint8_t *>(data);
+    }
+
+    // The mapping stays valid after the file descriptor is closed.
+    (void)::close(file);
+}
+
+void MappedFileIOCallback::close()
+{
+    // MappedFileIOCallback::close() can be called more than once, only unmap the file the first time.
+    if (m_data != nullptr)
+    {
+        if (munmap(const_cast<uint8_t *>(m_data), (size_t)m_size) != 0)
+        {
+            m_data = nullptr;
+            throw last_error("Failed to unmap file");
+        }
+        m_data = nullptr;
+    }
+}
+
+#endif
+
+MappedFileIOCallback::~MappedFileIOCallback()
+{
+    try
+    {
+        close();
+    }
+    catch (std::ios_base::failure &)
+    {
+        // The file was mapped as read-only, there is nothing to flush.
+    }
+}
+
+uint32 MappedFileIOCallback::read(void *buffer, size_t size)
+{
+    assert(size <= UINT32_MAX); // can't properly return > uint32
+
+    if (m_data == nullptr || m_position >= m_size)
+    {
+        return 0;
+    }
+
+    size_t read_size = (size_t)std::min((uint64_t)size, m_size - m_position);
+    memcpy(buffer, m_data + m_position, read_size);
+    m_position += read_size;
+    return (uint32)read_size;
+}
+
+void MappedFileIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+
+    int64_t base = 0;
+    switch (mode)
+    {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = (int64_t)m_position;
+        break;
+    case SEEK_END:
+        base = (int64_t)m_size;
+        break;
+    }
+
+    // Seeking past the end of the file is allowed, reads there return no data.
+    if (offset < -base)
+    {
+        throw std::ios_base::failure("Failed to seek before the start of the file");
+    }
+    m_position = (uint64_t)(base + offset);
+}
+
+size_t MappedFileIOCallback::write(const void *buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    throw std::ios_base::failure("Failed to write file, the file is mapped as read-only");
+}
+
+uint64 MappedFileIOCallback::getFilePointer()
+{
+    return m_position;
+}
@@ -0,0 +1,287 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/matroska_read.h>
+#include <k4ainternal/logging.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace LIBMATROSKA_NAMESPACE;
+
+// A sidecar index file lists every cluster of a recording, so that the cluster cache can be populated without reading
+// the recording. The file starts with a cluster_index_header_t, followed by entry_count cluster_index_entry_t sorted by
+// timestamp. The index is only used if it was written for a recording of the same size and layout. The entries also
+// locate the preview of each cluster, so that the previews can be read without reading the recording, see
+// build_preview_index(). Version 1 indexes don't have the preview fields, and are still read.
+//
+// A recording written with k4a_record_set_live_index() has an index that grows with it. Until the recording is closed,
+// the header has no recording size or entry count, and the entries that were written so far follow it. Such an index
+// lists the clusters at the start of the recording, the rest is read from the file.
+
+namespace k4arecord
+{
+static std::string get_index_path(k4a_playback_context_t *context)
+{
+    return std::string(context->file_path) + CLUSTER_INDEX_EXTENSION;
+}
+
+static bool get_recording_size(k4a_playback_context_t *context, uint64_t *recording_size)
+{
+    std::ifstream recording(context->file_path, std::ios::binary | std::ios::ate);
+    std::streamoff size = recording ? (std::streamoff)recording.tellg() : -1;
+    if (size < 0)
+    {
+        LOG_ERROR("Failed to get the size of recording '%s'", context->file_path);
+        return false;
+    }
+    *recording_size = (uint64_t)size;
+    return true;
+}
+
+// Reads the size and real start timestamp of a cluster that is only known from a Cue entry. Must be called with
+// cache_lock held.
+k4a_result_t read_cluster_size(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    std::lock_guard<std::mutex> io_lock(context->io_lock);
+    if (context->file_closing)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+    if (file_io != NULL)
+    {
+        file_io->setOwnerThread();
+    }
+
+    RETURN_IF_ERROR(seek_offset(context, cluster_info->file_offset));
+    std::shared_ptr<KaxCluster> cluster = find_next<KaxCluster>(context);
+    if (cluster == nullptr)
+    {
+        LOG_ERROR("Failed to read cluster at: %llu", cluster_info->file_offset);
+        return K4A_RESULT_FAILED;
+    }
+    populate_cluster_info(context, cluster, cluster_info);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Returns true if the cluster of a live index entry is completely written to the recording. Clusters are written to the
+// index once they are rendered, but the recording itself may not have reached the disk when it stopped.
+static bool index_entry_written(k4a_playback_context_t *context,
+                                const cluster_index_entry_t &entry,
+                                uint64_t recording_size)
+{
+    if (context->segment->GetGlobalPosition(entry.file_offset + entry.cluster_size) > recording_size)
+    {
+        return false;
+    }
+
+    cluster_info_t cluster_info;
+    cluster_info.file_offset = entry.file_offset;
+    if (K4A_FAILED(read_cluster_size(context, &cluster_info)))
+    {
+        return false;
+    }
+    return cluster_info.file_offset == entry.file_offset && cluster_info.cluster_size == entry.cluster_size &&
+           cluster_info.timestamp_ns == entry.timestamp_ns;
+}
+
+// Reads the sidecar index of the recording into context->index_entries, which populate_cluster_cache() uses instead of
+// the Cue entries. Returns K4A_RESULT_FAILED without logging an error if there is no usable index.
+k4a_result_t load_cluster_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache != nullptr);
+
+    // The name of a recording read through a callback is not a path.
+    if (context->custom_io != nullptr)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    std::string index_path = get_index_path(context);
+    std::ifstream index_file(index_path, std::ios::binary | std::ios::ate);
+    if (!index_file)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    std::streamoff index_size = (std::streamoff)index_file.tellg();
+    index_file.seekg(0);
+
+    uint64_t recording_size = 0;
+    if (!get_recording_size(context, &recording_size))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    cluster_index_header_t header = {};
+    index_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    bool version_1 = header.version == 1 && header.entry_size == CLUSTER_INDEX_V1_ENTRY_SIZE;
+    if (!index_file || memcmp(header.magic, CLUSTER_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        (!version_1 &&
+         (header.version != CLUSTER_INDEX_VERSION || header.entry_size != sizeof(cluster_index_entry_t))))
+    {
+        LOG_WARNING("Ignoring invalid recording index '%s'", index_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    // A live index holds every entry that was completely written, a partial entry at the end is ignored.
+    bool live_index = header.recording_size == 0 && header.entry_count == 0;
+    if (live_index)
+    {
+        header.entry_count = (uint64_t)(index_size - (std::streamoff)sizeof(header)) / header.entry_size;
+        if (header.entry_count == 0)
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+    if ((!live_index && header.recording_size != recording_size) ||
+        header.first_cluster_offset != context->first_cluster_offset || header.entry_count == 0 ||
+        header.entry_count > recording_size / header.entry_size)
+    {
+        LOG_WARNING("Ignoring recording index '%s', it was written for a different recording.", index_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    // Version 1 entries are the start of the current entries, the preview fields stay 0.
+    std::vector<cluster_index_entry_t> entries((size_t)header.entry_count);
+    std::vector<uint8_t> entry_data((size_t)header.entry_count * header.entry_size);
+    index_file.read(reinterpret_cast<char *>(entry_data.data()), (std::streamsize)entry_data.size());
+    if (!index_file)
+    {
+        LOG_WARNING("Ignoring truncated recording index '%s'", index_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        entries[i] = {};
+        memcpy(&entries[i], entry_data.data() + i * header.entry_size, header.entry_size);
+    }
+
+    // The clusters must be contiguous and in order for the cluster cache to link them together.
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].cluster_size == 0 ||
+            (i > 0 && (entries[i].timestamp_ns < entries[i - 1].timestamp_ns ||
+                       entries[i].file_offset <= entries[i - 1].file_offset)))
+        {
+            LOG_WARNING("Ignoring recording index '%s', cluster %zu is out of order.", index_path.c_str(), i);
+            return K4A_RESULT_FAILED;
+        }
+    }
+    if (entries[0].file_offset != context->first_cluster_offset)
+    {
+        LOG_WARNING("Ignoring recording index '%s', it doesn't start at the first cluster.", index_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    if (live_index)
+    {
+        // Only the last clusters can be missing, the ones before the last written cluster are trusted.
+        while (!entries.empty() && !index_entry_written(context, entries.back(), recording_size))
+        {
+            entries.pop_back();
+        }
+        if (entries.empty())
+        {
+            return K4A_RESULT_FAILED;
+        }
+        LOG_INFO("Using live recording index '%s' of %zu clusters", index_path.c_str(), entries.size());
+    }
+
+    context->index_entries = std::move(entries);
+    context->index_complete = !live_index;
+    context->index_has_previews = !version_1;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Walks every cluster of the recording and writes the sidecar index read by load_cluster_index().
+k4a_result_t write_cluster_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache == nullptr);
+
+    // The previews are found before the clusters are walked, the preview index is never modified once it is built.
+    RETURN_IF_ERROR(build_preview_index(context));
+    auto preview = context->preview_index.begin();
+
+    std::vector<cluster_index_entry_t> entries;
+    try
+    {
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+        cluster_info_t *last_cluster = NULL;
+        for (cluster_info_t *cluster_info = context->cluster_cache.get(); cluster_info != NULL;
+             cluster_info = next_cluster(context, cluster_info, true))
+        {
+            if (cluster_info->cluster_size == 0)
+            {
+                RETURN_IF_ERROR(read_cluster_size(context, cluster_info));
+            }
+
+            cluster_index_entry_t entry = {};
+            entry.timestamp_ns = cluster_info->timestamp_ns;
+            entry.file_offset = cluster_info->file_offset;
+            entry.cluster_size = cluster_info->cluster_size;
+
+            // Only the first preview of a cluster fits in its entry, see k4a_record_add_preview_track().
+            uint64_t cluster_end = cluster_info->file_offset + cluster_info->cluster_size;
+            if (preview != context->preview_index.end() && preview->file_offset < cluster_end)
+            {
+                entry.preview_timestamp_ns = preview->timestamp_ns;
+                entry.preview_offset = preview->file_offset;
+                entry.preview_size = preview->size;
+            }
+            while (preview != context->preview_index.end() && preview->file_offset < cluster_end)
+            {
+                preview++;
+            }
+
+            entries.push_back(entry);
+            last_cluster = cluster_info;
+        }
+
+        // next_cluster() also returns NULL if the file can't be read, only index recordings that were read to the end.
+        if (last_cluster == NULL || !last_cluster->next_known || last_cluster->next != NULL)
+        {
+            LOG_ERROR("Failed to read all the clusters of recording '%s'", context->file_path);
+            return K4A_RESULT_FAILED;
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to index recording: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    cluster_index_header_t header = {};
+    memcpy(header.magic, CLUSTER_INDEX_MAGIC, sizeof(header.magic));
+    header.version = CLUSTER_INDEX_VERSION;
+    header.entry_size = sizeof(cluster_index_entry_t);
+    header.first_cluster_offset = context->first_cluster_offset;
+    header.entry_count = entries.size();
+    if (!get_recording_size(context, &header.recording_size))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    std::string index_path = get_index_path(context);
+    std::ofstream index_file(index_path, std::ios::binary | std::ios::trunc);
+    index_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    index_file.write(reinterpret_cast<const char *>(entries.data()),
+                     (std::streamsize)(entries.size() * sizeof(cluster_index_entry_t)));
+    index_file.close();
+    if (!index_file)
+    {
+        LOG_ERROR("Failed to write recording index '%s'", index_path.c_str());
+        (void)std::remove(index_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    LOG_INFO("Wrote index of %llu clusters to '%s'", header.entry_count, index_path.c_str());
+    return K4A_RESULT_SUCCEEDED;
+}
+
+} // namespace k4arecord
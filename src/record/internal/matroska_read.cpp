@@ -5,6 +5,8 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <cstring>
+#include <condition_variable>
 #include <sstream>
 
 #include <k4a/k4a.h>
@@ -215,17 +217,108 @@ k4a_result_t parse_mkv(k4a_playback_context_t *context)
         return K4A_RESULT_FAILED;
     }
 
-    // Populate each element from the file (minus the actual Cluster data)
+    // Populate each element from the file (minus the actual Cluster data). The recording configuration is made of the
+    // tracks and tags, the attachments and cues are only read when they are needed if the recording is opened lazily.
     RETURN_IF_ERROR(read_offset(context, context->segment_info, context->segment_info_offset));
     RETURN_IF_ERROR(read_offset(context, context->tracks, context->tracks_offset));
-    if (context->cues_offset > 0)
-        RETURN_IF_ERROR(read_offset(context, context->cues, context->cues_offset));
-    if (context->attachments_offset > 0)
-        RETURN_IF_ERROR(read_offset(context, context->attachments, context->attachments_offset));
     if (context->tags_offset > 0)
         RETURN_IF_ERROR(read_offset(context, context->tags, context->tags_offset));
 
     RETURN_IF_ERROR(parse_recording_config(context));
+
+    if (!context->lazy_load)
+    {
+        RETURN_IF_ERROR(load_attachments(context));
+        RETURN_IF_ERROR(load_clusters(context));
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Reads the attachments and finds the device calibration. Called by parse_mkv(), or before the first use of the
+// attachments if the recording was opened with k4a_playback_open_lazy().
+k4a_result_t load_attachments(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->attachments_loaded)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lazy_load_lock);
+    if (context->attachments_loaded)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    if (context->attachments_offset > 0)
+    {
+        // Clusters may already be loading in the background.
+        std::lock_guard<std::mutex> io_lock(context->io_lock);
+        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+        if (file_io != NULL)
+        {
+            file_io->setOwnerThread();
+        }
+        RETURN_IF_ERROR(read_offset(context, context->attachments, context->attachments_offset));
+    }
+
+    context->calibration_attachment = get_attachment_by_tag(context,
+                                                            device_name(context, "K4A_CALIBRATION_FILE").c_str());
+    if (context->calibration_attachment == NULL)
+    {
+        std::string calibration_file = device_name(context, "calibration") + ".json";
+        context->calibration_attachment = get_attachment_by_name(context, calibration_file.c_str());
+    }
+    if (context->calibration_attachment == NULL)
+    {
+        // The rest of the recording can still be read if no device calibration blob exists.
+        LOG_WARNING("Device calibration is missing from recording.", 0);
+    }
+
+    context->attachments_loaded = true;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Reads the cues, fills the cluster cache, finds the end of the recording and moves the playback handle to its start.
+// Called by parse_mkv(), or before the first read or seek if the recording was opened with k4a_playback_open_lazy().
+k4a_result_t load_clusters(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->clusters_loaded)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lazy_load_lock);
+    if (context->clusters_loaded)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+    if (context->cluster_cache != nullptr)
+    {
+        // A previous attempt failed after the cache was created.
+        LOG_ERROR("Failed to load the clusters of recording '%s'.", context->file_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    {
+        // No cluster is loading in the background yet, the lock only hands the file to this thread.
+        std::lock_guard<std::mutex> io_lock(context->io_lock);
+        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+        if (file_io != NULL)
+        {
+            file_io->setOwnerThread();
+        }
+        if (context->cues_offset > 0)
+        {
+            RETURN_IF_ERROR(read_offset(context, context->cues, context->cues_offset));
+        }
+    }
+
+    // A sidecar index is optional, without one the Cue entries are used.
+    (void)load_cluster_index(context);
     RETURN_IF_ERROR(populate_cluster_cache(context));
 
     // Find the last timestamp in the file
@@ -289,6 +382,22 @@ k4a_result_t parse_mkv(k4a_playback_context_t *context)
     }
     LOG_TRACE("Found last file timestamp: %llu", context->last_file_timestamp_ns);
 
+    // Seek to the first cluster
+    cluster_info_t *seek_cluster_info = find_cluster(context, 0);
+    if (seek_cluster_info == NULL)
+    {
+        LOG_ERROR("Failed to parse recording, recording is empty.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    context->cursor.seek_cluster = load_cluster(context, seek_cluster_info);
+    if (context->cursor.seek_cluster == nullptr)
+    {
+        LOG_ERROR("Failed to load first data cluster of recording.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    reset_seek_pointers(context, &context->cursor, 0);
+
+    context->clusters_loaded = true;
     return K4A_RESULT_SUCCEEDED;
 }
 
@@ -329,7 +438,57 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
 
         // Populate the rest of the cache with the Cue data stored in the file.
         cluster_info_t *cluster_cache_end = context->cluster_cache.get();
-        if (context->cues)
+        if (!context->index_entries.empty() &&
+            context->index_entries[0].cluster_size == context->cluster_cache->cluster_size &&
+            context->index_entries[0].timestamp_ns == context->cluster_cache->timestamp_ns)
+        {
+            // The sidecar index lists every cluster with its real size and timestamp, so the cache is complete and
+            // there are no gaps to fill in from the file. The clusters after the last entry of a live index are found
+            // by reading the file.
+            if (context->index_complete)
+            {
+                context->cluster_index.reserve(context->index_entries.size());
+                context->cluster_index.push_back(cluster_cache_end);
+            }
+            for (size_t i = 1; i < context->index_entries.size(); i++)
+            {
+                cluster_info_t *cluster_info = new cluster_info_t;
+                cluster_info->timestamp_ns = context->index_entries[i].timestamp_ns;
+                cluster_info->file_offset = context->index_entries[i].file_offset;
+                cluster_info->cluster_size = context->index_entries[i].cluster_size;
+                cluster_info->previous = cluster_cache_end;
+
+                cluster_cache_end->next = cluster_info;
+                cluster_cache_end->next_known = true;
+                cluster_cache_end = cluster_info;
+                if (context->index_complete)
+                {
+                    context->cluster_index.push_back(cluster_info);
+                }
+            }
+            cluster_cache_end->next_known = context->index_complete;
+
+            if (context->index_has_previews)
+            {
+                std::lock_guard<std::mutex> preview_lock(context->preview_index_lock);
+                for (const cluster_index_entry_t &entry : context->index_entries)
+                {
+                    if (entry.preview_size > 0)
+                    {
+                        preview_index_entry_t preview;
+                        preview.timestamp_ns = entry.preview_timestamp_ns;
+                        preview.file_offset = entry.preview_offset;
+                        preview.size = entry.preview_size;
+                        context->preview_index.push_back(preview);
+                    }
+                }
+
+                // The previews of the clusters after a live index are found by build_preview_index().
+                context->preview_index_resume_ns = cluster_cache_end->timestamp_ns;
+                context->preview_index_built = context->index_complete;
+            }
+        }
+        else if (context->cues)
         {
             uint64_t last_offset = context->first_cluster_offset;
             uint64_t last_timestamp_ns = context->cluster_cache->timestamp_ns;
@@ -376,6 +535,7 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
         {
             LOG_WARNING("Recording is missing Cue entries, playback performance may be impacted.", 0);
         }
+        std::vector<cluster_index_entry_t>().swap(context->index_entries);
     }
     catch (std::system_error &e)
     {
@@ -386,6 +546,38 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
     return K4A_RESULT_SUCCEEDED;
 }
 
+std::string device_name(k4a_playback_context_t *context, const char *name)
+{
+    if (context->device_index == 0)
+    {
+        return name;
+    }
+    std::ostringstream name_str;
+    name_str << name << "_" << context->device_index;
+    return name_str.str();
+}
+
+uint32_t get_device_count(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    KaxTag *device_count_tag = get_tag(context, "K4A_DEVICE_COUNT");
+    if (device_count_tag == NULL)
+    {
+        return 1;
+    }
+
+    uint32_t device_count = 0;
+    std::istringstream device_count_str(get_tag_string(device_count_tag));
+    device_count_str >> device_count;
+    if (device_count_str.fail() || device_count == 0)
+    {
+        LOG_WARNING("Tag K4A_DEVICE_COUNT contains invalid value: %s", get_tag_string(device_count_tag).c_str());
+        return 1;
+    }
+    return device_count;
+}
+
 k4a_result_t parse_recording_config(k4a_playback_context_t *context)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
@@ -399,26 +591,32 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
         return K4A_RESULT_FAILED;
     }
 
-    context->color_track = find_track(context, "COLOR", "K4A_COLOR_TRACK");
-    context->depth_track = find_track(context, "DEPTH", "K4A_DEPTH_TRACK");
-    context->ir_track = find_track(context, "IR", "K4A_IR_TRACK");
-    if (context->ir_track == NULL)
+    if (context->device_index >= get_device_count(context))
     {
-        // Support legacy IR track naming.
-        context->ir_track = find_track(context, "DEPTH_IR", NULL);
+        LOG_ERROR("The recording has no device %u.", context->device_index);
+        return K4A_RESULT_FAILED;
     }
-    context->imu_track = find_track(context, "IMU", "K4A_IMU_TRACK");
 
-    // Read device calibration attachment
-    context->calibration_attachment = get_attachment_by_tag(context, "K4A_CALIBRATION_FILE");
-    if (context->calibration_attachment == NULL)
+    context->color_track = find_track(context,
+                                      device_name(context, "COLOR").c_str(),
+                                      device_name(context, "K4A_COLOR_TRACK").c_str());
+    context->depth_track = find_track(context,
+                                      device_name(context, "DEPTH").c_str(),
+                                      device_name(context, "K4A_DEPTH_TRACK").c_str());
+    context->ir_track = find_track(context,
+                                   device_name(context, "IR").c_str(),
+                                   device_name(context, "K4A_IR_TRACK").c_str());
+    if (context->ir_track == NULL && context->device_index == 0)
     {
-        context->calibration_attachment = get_attachment_by_name(context, "calibration.json");
+        // Support legacy IR track naming.
+        context->ir_track = find_track(context, "DEPTH_IR", NULL);
     }
-    if (context->calibration_attachment == NULL)
+    context->imu_track = find_track(context,
+                                    device_name(context, "IMU").c_str(),
+                                    device_name(context, "K4A_IMU_TRACK").c_str());
+    if (context->device_index == 0)
     {
-        // The rest of the recording can still be read if no device calibration blob exists.
-        LOG_WARNING("Device calibration is missing from recording.", 0);
+        context->preview_track = find_track(context, K4A_TRACK_NAME_PREVIEW, "K4A_PREVIEW_TRACK");
     }
 
     uint64_t frame_period_ns = 0;
@@ -432,7 +630,18 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
 
         frame_period_ns = context->color_track->frame_period_ns;
 
-        RETURN_IF_ERROR(read_bitmap_info_header(context->color_track));
+        if (context->color_track->codec_id == "V_MS/VFW/FOURCC")
+        {
+            RETURN_IF_ERROR(read_bitmap_info_header(context->color_track));
+        }
+        else
+        {
+            // The color track was compressed by a video encoder of the application, see
+            // k4a_record_set_color_encoder(). The images are decoded to BGRA unless another format is requested.
+            context->color_track->video_encoded = true;
+            context->color_track->format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+            context->color_track->stride = context->color_track->width * 4;
+        }
         context->record_config.color_resolution = K4A_COLOR_RESOLUTION_OFF;
         for (size_t i = 0; i < arraysize(color_resolutions); i++)
         {
@@ -458,6 +667,7 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
         context->record_config.color_track_enabled = true;
         context->record_config.color_format = context->color_track->format;
         context->color_format_conversion = context->color_track->format;
+        context->color_scale = K4A_COLOR_SCALE_FULL;
     }
     else
     {
@@ -465,9 +675,10 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
         // Set to a default color format if color track is disabled.
         context->record_config.color_format = K4A_IMAGE_FORMAT_CUSTOM;
         context->color_format_conversion = K4A_IMAGE_FORMAT_CUSTOM;
+        context->color_scale = K4A_COLOR_SCALE_FULL;
     }
 
-    KaxTag *depth_mode_tag = get_tag(context, "K4A_DEPTH_MODE");
+    KaxTag *depth_mode_tag = get_tag(context, device_name(context, "K4A_DEPTH_MODE").c_str());
     if (depth_mode_tag == NULL && (context->depth_track || context->ir_track))
     {
         LOG_ERROR("K4A_DEPTH_MODE tag is missing.", 0);
@@ -631,7 +842,7 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
     }
 
     // Read depth_delay_off_color_usec and set offsets for each builtin track accordingly.
-    KaxTag *depth_delay_tag = get_tag(context, "K4A_DEPTH_DELAY_NS");
+    KaxTag *depth_delay_tag = get_tag(context, device_name(context, "K4A_DEPTH_DELAY_NS").c_str());
     if (depth_delay_tag != NULL)
     {
         int64_t depth_delay_ns;
@@ -679,8 +890,14 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
         }
     }
 
+    if (context->preview_track && context->preview_track->type != track_subtitle)
+    {
+        LOG_WARNING("Preview track is not correct type, treating as a custom track.", 0);
+        context->preview_track = nullptr;
+    }
+
     // Read wired_sync_mode and subordinate_delay_off_master_usec.
-    KaxTag *sync_mode_tag = get_tag(context, "K4A_WIRED_SYNC_MODE");
+    KaxTag *sync_mode_tag = get_tag(context, device_name(context, "K4A_WIRED_SYNC_MODE").c_str());
     if (sync_mode_tag != NULL)
     {
         bool sync_mode_found = false;
@@ -702,7 +919,7 @@ k4a_result_t parse_recording_config(k4a_playback_context_t *context)
 
         if (context->record_config.wired_sync_mode == K4A_WIRED_SYNC_MODE_SUBORDINATE)
         {
-            KaxTag *subordinate_delay_tag = get_tag(context, "K4A_SUBORDINATE_DELAY_NS");
+            KaxTag *subordinate_delay_tag = get_tag(context, device_name(context, "K4A_SUBORDINATE_DELAY_NS").c_str());
             if (subordinate_delay_tag != NULL)
             {
                 uint64_t subordinate_delay_ns;
@@ -796,6 +1013,11 @@ k4a_result_t read_bitmap_info_header(track_reader_t *track)
             track->format = K4A_IMAGE_FORMAT_DEPTH16;
             track->stride = track->width * 2;
             break;
+        case K4A_RVL_FOURCC:
+            track->format = K4A_IMAGE_FORMAT_DEPTH16;
+            track->stride = track->width * 2;
+            track->rvl_encoded = true;
+            break;
         case 0x41524742: // BGRA
             track->format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
             track->stride = track->width * 4;
@@ -818,17 +1040,15 @@ k4a_result_t read_bitmap_info_header(track_reader_t *track)
     }
 }
 
-void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestamp_ns)
+void reset_seek_pointers(k4a_playback_context_t *context, playback_cursor_t *cursor, uint64_t seek_timestamp_ns)
 {
     RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, cursor == NULL);
 
-    context->seek_timestamp_ns = seek_timestamp_ns;
-
-    for (auto &itr : context->track_map)
-    {
-        auto &track_reader = itr.second;
-        track_reader.current_block.reset();
-    }
+    cursor->seek_timestamp_ns = seek_timestamp_ns;
+    clear_color_read_ahead(context, cursor);
+    cursor->current_blocks.clear();
+    cursor->preview_valid = false;
 }
 
 k4a_result_t parse_tracks(k4a_playback_context_t *context)
@@ -932,7 +1152,8 @@ bool check_track_reader_is_builtin(k4a_playback_context_t *context, track_reader
     RETURN_VALUE_IF_ARG(false, track_reader == NULL);
 
     return track_reader == context->color_track || track_reader == context->depth_track ||
-           track_reader == context->ir_track || track_reader == context->imu_track;
+           track_reader == context->ir_track || track_reader == context->imu_track ||
+           track_reader == context->preview_track;
 }
 
 track_reader_t *get_track_reader_by_name(k4a_playback_context_t *context, std::string track_name)
@@ -1133,6 +1354,18 @@ cluster_info_t *find_cluster(k4a_playback_context_t *context, uint64_t timestamp
     {
         std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
 
+        if (!context->cluster_index.empty())
+        {
+            // Binary search for the last cluster starting at or before the timestamp.
+            auto itr = std::upper_bound(context->cluster_index.begin(),
+                                        context->cluster_index.end(),
+                                        timestamp_ns,
+                                        [](uint64_t timestamp, const cluster_info_t *cluster_info) {
+                                            return timestamp < cluster_info->timestamp_ns;
+                                        });
+            return itr == context->cluster_index.begin() ? *itr : *(itr - 1);
+        }
+
         // Find the closest cluster in the cache
         cluster_info_t *cluster_info = context->cluster_cache.get();
         while (cluster_info->next)
@@ -1294,6 +1527,88 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
     }
 }
 
+// Evicts the least recently used clusters until the cache fits in cluster_lru_budget, lru_lock must be held.
+static void trim_cluster_lru_locked(k4a_playback_context_t *context)
+{
+    while (!context->cluster_lru.empty() && context->cluster_lru_size > context->cluster_lru_budget)
+    {
+        auto &oldest = context->cluster_lru.back();
+        context->cluster_lru_size -= oldest.second->GetSize();
+        context->cluster_lru_index.erase(oldest.first);
+        context->cluster_lru.pop_back();
+    }
+}
+
+// Moves a cluster to the front of the LRU cache, so it stays loaded while it is one of the most recently used clusters
+// that fit in the budget set by k4a_playback_set_cache_size().
+static void touch_cluster_lru(k4a_playback_context_t *context,
+                              cluster_info_t *cluster_info,
+                              std::shared_ptr<KaxCluster> &cluster)
+{
+    std::lock_guard<std::mutex> lock(context->lru_lock);
+    if (context->cluster_lru_budget == 0)
+    {
+        return;
+    }
+
+    auto itr = context->cluster_lru_index.find(cluster_info);
+    if (itr != context->cluster_lru_index.end())
+    {
+        context->cluster_lru.splice(context->cluster_lru.begin(), context->cluster_lru, itr->second);
+    }
+    else
+    {
+        context->cluster_lru.emplace_front(cluster_info, cluster);
+        context->cluster_lru_index[cluster_info] = context->cluster_lru.begin();
+        context->cluster_lru_size += cluster->GetSize();
+        trim_cluster_lru_locked(context);
+    }
+}
+
+void set_cluster_lru_budget(k4a_playback_context_t *context, uint64_t budget_bytes)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->lru_lock);
+    context->cluster_lru_budget = budget_bytes;
+    trim_cluster_lru_locked(context);
+}
+
+// Links the blocks of a cluster that was just read to the cluster and their track, so that their timestamps and
+// durations can be read. This is done once before the cluster is shared, cursors on other threads only read blocks.
+static void link_cluster_blocks(k4a_playback_context_t *context, KaxCluster *cluster)
+{
+    KaxSimpleBlock *simple_block = NULL;
+    KaxBlockGroup *block_group = NULL;
+    for (EbmlElement *e : cluster->GetElementList())
+    {
+        if (check_element_type(e, &simple_block))
+        {
+            simple_block->SetParent(*cluster);
+        }
+        else if (check_element_type(e, &block_group))
+        {
+            block_group->SetParent(*cluster);
+            for (auto &itr : context->track_map)
+            {
+                KaxTrackEntry *track = itr.second.track;
+                if (track != NULL && track->TrackNumber().GetValue() == (uint64)block_group->TrackNumber())
+                {
+                    block_group->SetParentTrack(*track);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Returns the cluster of cluster_info if it is still loaded, or nullptr otherwise.
+static std::shared_ptr<KaxCluster> get_loaded_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    std::lock_guard<std::mutex> lock(context->cluster_ref_lock);
+    return cluster_info->cluster.lock();
+}
+
 // Load a cluster from the cluster cache / disk without any neighbor preloading.
 // This should never fail unless there is a file IO error.
 std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context, cluster_info_t *cluster_info)
@@ -1304,13 +1619,31 @@ std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *contex
     try
     {
         // Check if the cluster already exists in memory, and if so, return it.
-        std::shared_ptr<KaxCluster> cluster = cluster_info->cluster.lock();
+        std::shared_ptr<KaxCluster> cluster = get_loaded_cluster(context, cluster_info);
         if (cluster)
         {
             context->cache_hits++;
         }
         else
         {
+            if (context->custom_io != nullptr)
+            {
+                // Fetch the cluster before taking the io lock, so that the clusters preloaded by other threads are
+                // requested at the same time. A cluster that is only known from a Cue entry has no size yet, the
+                // block containing its start is fetched.
+                uint64_t cluster_size = 0;
+                {
+                    std::lock_guard<std::recursive_mutex> cache_lock(context->cache_lock);
+                    cluster_size = cluster_info->cluster_size;
+                    if (cluster_size == 0 && cluster_info->next_known && cluster_info->next != NULL)
+                    {
+                        cluster_size = cluster_info->next->file_offset - cluster_info->file_offset;
+                    }
+                }
+                context->custom_io->prefetch(context->segment->GetGlobalPosition(cluster_info->file_offset),
+                                             std::max(cluster_size, (uint64_t)1));
+            }
+
             std::lock_guard<std::mutex> lock(context->io_lock);
             if (context->file_closing)
             {
@@ -1320,7 +1653,7 @@ std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *contex
 
             // The cluster may have been loaded while we were acquiring the io lock, check again before actually loading
             // from disk.
-            cluster = cluster_info->cluster.lock();
+            cluster = get_loaded_cluster(context, cluster_info);
             if (cluster)
             {
                 context->cache_hits++;
@@ -1353,11 +1686,18 @@ std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *contex
                     uint64_t timecode = GetChild<KaxClusterTimecode>(*cluster).GetValue();
                     assert(context->timecode_scale <= INT64_MAX);
                     cluster->InitTimecode(timecode, (int64_t)context->timecode_scale);
+                    link_cluster_blocks(context, cluster.get());
 
+                    std::lock_guard<std::mutex> cluster_ref_lock(context->cluster_ref_lock);
                     cluster_info->cluster = cluster;
                 }
             }
         }
+
+        if (cluster)
+        {
+            touch_cluster_lru(context, cluster_info, cluster);
+        }
         return cluster;
     }
     catch (std::system_error &e)
@@ -1385,13 +1725,16 @@ std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context,
     result->cluster_info = cluster_info;
     result->cluster = cluster;
 
-#if CLUSTER_READ_AHEAD_COUNT
+    size_t read_ahead_count = context->cluster_read_ahead_count;
     try
     {
-        // Preload the neighboring clusters immediately
+        // Start preloading the neighboring clusters on both sides, nearest first. The direction playback moves in after
+        // a seek isn't known yet, and neither direction waits for the other's clusters to load.
+        result->previous_clusters.resize(read_ahead_count);
+        result->next_clusters.resize(read_ahead_count);
         cluster_info_t *previous_cluster_info = cluster_info;
         cluster_info_t *next_cluster_info = cluster_info;
-        for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT; i++)
+        for (size_t i = 0; i < read_ahead_count; i++)
         {
             if (previous_cluster_info != NULL)
             {
@@ -1401,14 +1744,12 @@ std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context,
             {
                 next_cluster_info = next_cluster(context, next_cluster_info, true);
             }
-            result->previous_clusters[i] = std::async(std::launch::deferred, [context, previous_cluster_info] {
-                return previous_cluster_info ? load_cluster_internal(context, previous_cluster_info) : nullptr;
-            });
-            result->next_clusters[i] = std::async(std::launch::deferred, [context, next_cluster_info] {
+            result->next_clusters[i] = std::async(std::launch::async, [context, next_cluster_info] {
                 return next_cluster_info ? load_cluster_internal(context, next_cluster_info) : nullptr;
             });
-            result->previous_clusters[i].wait();
-            result->next_clusters[i].wait();
+            result->previous_clusters[i] = std::async(std::launch::async, [context, previous_cluster_info] {
+                return previous_cluster_info ? load_cluster_internal(context, previous_cluster_info) : nullptr;
+            });
         }
     }
     catch (std::system_error &e)
@@ -1416,7 +1757,6 @@ std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context,
         LOG_ERROR("Failed to load read-ahead clusters: %s", e.what());
         return nullptr;
     }
-#endif
 
     return result;
 }
@@ -1438,18 +1778,33 @@ std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *cont
         return nullptr;
     }
 
+    size_t read_ahead_count = context->cluster_read_ahead_count;
+    if (current_cluster->next_clusters.size() != read_ahead_count)
+    {
+        // The read-ahead depth was changed by k4a_playback_set_cluster_read_ahead(), start preloading from scratch.
+        return load_cluster(context, cluster_info);
+    }
+
     std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
     result->cluster_info = cluster_info;
 
-#if CLUSTER_READ_AHEAD_COUNT
+    if (read_ahead_count == 0)
+    {
+        result->cluster = load_cluster_internal(context, cluster_info);
+        return result;
+    }
+
     try
     {
+        result->previous_clusters.resize(read_ahead_count);
+        result->next_clusters.resize(read_ahead_count);
+
         // Use the current cluster as one of the neightbors, and then wait for the target cluster to be available.
         std::shared_ptr<KaxCluster> old_cluster = current_cluster->cluster;
         if (next)
         {
             result->previous_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+            for (size_t i = 1; i < read_ahead_count; i++)
             {
                 result->previous_clusters[i] = current_cluster->previous_clusters[i - 1];
             }
@@ -1460,7 +1815,7 @@ std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *cont
         else
         {
             result->next_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+            for (size_t i = 1; i < read_ahead_count; i++)
             {
                 result->next_clusters[i] = current_cluster->next_clusters[i - 1];
             }
@@ -1472,13 +1827,13 @@ std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *cont
         // Spawn a new async task to preload the next cluster in sequence.
         if (next)
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
+            for (size_t i = 0; i < read_ahead_count - 1; i++)
             {
                 result->next_clusters[i] = current_cluster->next_clusters[i + 1];
             }
-            result->next_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
+            result->next_clusters[read_ahead_count - 1] = std::async([context, cluster_info, read_ahead_count] {
                 cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
+                for (size_t i = 0; i < read_ahead_count && new_cluster != NULL; i++)
                 {
                     new_cluster = next_cluster(context, new_cluster, true);
                 }
@@ -1487,13 +1842,13 @@ std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *cont
         }
         else
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
+            for (size_t i = 0; i < read_ahead_count - 1; i++)
             {
                 result->previous_clusters[i] = current_cluster->previous_clusters[i + 1];
             }
-            result->previous_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
+            result->previous_clusters[read_ahead_count - 1] = std::async([context, cluster_info, read_ahead_count] {
                 cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
+                for (size_t i = 0; i < read_ahead_count && new_cluster != NULL; i++)
                 {
                     new_cluster = next_cluster(context, new_cluster, false);
                 }
@@ -1506,9 +1861,6 @@ std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *cont
         LOG_ERROR("Failed to load next cluster: %s", e.what());
         return nullptr;
     }
-#else
-    result->cluster = load_cluster_internal(context, cluster_info);
-#endif
 
     return result;
 }
@@ -1526,70 +1878,266 @@ uint64_t estimate_block_timestamp_ns(std::shared_ptr<block_info_t> &block)
     return timestamp_ns;
 }
 
-// Find the first block with a timestamp >= the specified timestamp. If a block group containing the specified timestamp
-// is found, it will be returned. If no blocks are found, a pointer to EOF will be returned, or nullptr if an error
-// occurs.
-std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context, track_reader_t *reader, uint64_t timestamp_ns)
+k4a_result_t seek_timestamp(k4a_playback_context_t *context,
+                            playback_cursor_t *cursor,
+                            int64_t offset_usec,
+                            k4a_playback_seek_origin_t origin)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, reader == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, reader->track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->segment == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        origin != K4A_PLAYBACK_SEEK_BEGIN && origin != K4A_PLAYBACK_SEEK_END &&
+                            origin != K4A_PLAYBACK_SEEK_DEVICE_TIME);
 
-    // Create a new block pointing to the start of the cluster containing timestamp_ns.
-    std::shared_ptr<block_info_t> block = std::make_shared<block_info_t>();
-    block->reader = reader;
-    block->index = -1;
-    block->sub_index = 0;
-    cluster_info_t *cluster_info = find_cluster(context, timestamp_ns);
-    if (cluster_info == NULL)
+    // If seeking to a device timestamp, calculate the offset relative to the start of file.
+    if (origin == K4A_PLAYBACK_SEEK_DEVICE_TIME)
     {
-        LOG_ERROR("Failed to find data cluster for timestamp: %llu", timestamp_ns);
-        return nullptr;
+        origin = K4A_PLAYBACK_SEEK_BEGIN;
+        offset_usec -= (int64_t)context->record_config.start_timestamp_offset_usec;
     }
 
-    block->cluster = load_cluster(context, cluster_info);
-    if (block->cluster == nullptr || block->cluster->cluster == nullptr)
+    // Clamp the offset timestamp so the seek direction is correct reletive to the specified origin.
+    if (origin == K4A_PLAYBACK_SEEK_BEGIN && offset_usec < 0)
     {
-        LOG_ERROR("Failed to load initial data cluster from disk.", 0);
-        return nullptr;
+        offset_usec = 0;
+    }
+    else if (origin == K4A_PLAYBACK_SEEK_END && offset_usec > 0)
+    {
+        offset_usec = 0;
     }
 
-    // Start searching through the blocks for the timestamp we want.
-    while (block)
+    uint64_t target_time_ns = 0;
+    if (origin == K4A_PLAYBACK_SEEK_END)
     {
-        block = next_block(context, block.get(), true);
-        if (block)
+        uint64_t offset_ns = (uint64_t)(-offset_usec * 1000);
+        if (offset_ns > context->last_file_timestamp_ns)
         {
-            // Return this block if EOF was reached, or the timestamp is >= the search timestamp.
-            if (block->block == NULL || estimate_block_timestamp_ns(block) >= timestamp_ns)
-            {
-                return block;
-            }
+            // If the target timestamp is negative, clamp to 0 so we don't underflow.
+            target_time_ns = 0;
         }
+        else
+        {
+            target_time_ns = context->last_file_timestamp_ns + 1 - offset_ns;
+        }
+    }
+    else
+    {
+        target_time_ns = (uint64_t)offset_usec * 1000;
     }
 
-    LOG_ERROR("Failed to find block for timestamp: %llu ns.", timestamp_ns);
-    return nullptr;
+    cluster_info_t *seek_cluster_info = find_cluster(context, target_time_ns);
+    if (seek_cluster_info == NULL)
+    {
+        LOG_ERROR("Failed to find cluster for timestamp: %llu ns", target_time_ns);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::shared_ptr<loaded_cluster_t> seek_cluster = load_cluster(context, seek_cluster_info);
+    if (seek_cluster == nullptr || seek_cluster->cluster == nullptr)
+    {
+        LOG_ERROR("Failed to load data cluster at timestamp: %llu ns", target_time_ns);
+        return K4A_RESULT_FAILED;
+    }
+
+    cursor->seek_cluster = seek_cluster;
+    reset_seek_pointers(context, cursor, target_time_ns);
+
+    return K4A_RESULT_SUCCEEDED;
 }
 
-// Find the next / previous block given a current block. If there is no next block, a block pointing to EOF will be
-// returned, or nullptr if an error occurs.
-std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_info_t *current, bool next)
+// Returns the track if it is read into captures, or NULL if it is missing or disabled with
+// k4a_playback_set_enabled_tracks().
+static track_reader_t *enabled_track(track_reader_t *track)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, current == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, current->reader == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, current->cluster == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, current->cluster->cluster == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, current->cluster->cluster_info == nullptr);
+    return track != NULL && track->enabled ? track : NULL;
+}
 
-    // Get the track number of the current block.
-    uint64_t track_number = current->reader->track->TrackNumber().GetValue();
-    assert(track_number <= UINT16_MAX);
-    uint16_t search_number = static_cast<uint16_t>(track_number);
+// Reads the timestamp of every color, depth and IR block in the recording, and groups them into captures the same way
+// get_capture() does. Only the cluster contents are read, no images are decoded. The index is built once and kept for
+// the lifetime of the playback handle.
+k4a_result_t build_frame_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
 
-    // Copy the current block and start the search at the next index / sub-index.
-    std::shared_ptr<block_info_t> next_block = std::shared_ptr<block_info_t>(new block_info_t(*current));
+    std::lock_guard<std::mutex> lock(context->frame_index_lock);
+    if (context->frame_index_built)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    track_reader_t *tracks[] = { enabled_track(context->color_track),
+                                 enabled_track(context->depth_track),
+                                 enabled_track(context->ir_track) };
+    for (track_reader_t *track : tracks)
+    {
+        if (track != NULL)
+        {
+            track->block_timestamps_ns.clear();
+        }
+    }
+
+    cluster_info_t *cluster_info = find_cluster(context, 0);
+    while (cluster_info != NULL)
+    {
+        std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
+        if (cluster == nullptr)
+        {
+            LOG_ERROR("Failed to load data cluster at timestamp %llu ns while indexing frames.",
+                      cluster_info->timestamp_ns);
+            return K4A_RESULT_FAILED;
+        }
+
+        KaxSimpleBlock *simple_block = NULL;
+        KaxBlockGroup *block_group = NULL;
+        for (EbmlElement *e : cluster->GetElementList())
+        {
+            KaxInternalBlock *block = NULL;
+            if (check_element_type(e, &simple_block))
+            {
+                block = simple_block;
+            }
+            else if (check_element_type(e, &block_group))
+            {
+                block = &GetChild<KaxBlock>(*block_group);
+            }
+
+            for (track_reader_t *track : tracks)
+            {
+                if (block != NULL && track != NULL && track->track->TrackNumber().GetValue() == block->TrackNum())
+                {
+                    track->block_timestamps_ns.push_back(block->GlobalTimecode() + track->sync_delay_ns);
+                    break;
+                }
+            }
+        }
+
+        cluster_info = next_cluster(context, cluster_info, true);
+    }
+
+    // Each capture starts at the lowest timestamp left in any track, and contains one block from each track within
+    // half a sync period of it.
+    size_t positions[arraysize(tracks)] = {};
+    context->frame_index.clear();
+    while (true)
+    {
+        uint64_t capture_start_ns = UINT64_MAX;
+        for (size_t i = 0; i < arraysize(tracks); i++)
+        {
+            if (tracks[i] != NULL && positions[i] < tracks[i]->block_timestamps_ns.size())
+            {
+                capture_start_ns = std::min(capture_start_ns, tracks[i]->block_timestamps_ns[positions[i]]);
+            }
+        }
+        if (capture_start_ns == UINT64_MAX)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < arraysize(tracks); i++)
+        {
+            if (tracks[i] != NULL && positions[i] < tracks[i]->block_timestamps_ns.size() &&
+                tracks[i]->block_timestamps_ns[positions[i]] - capture_start_ns < context->sync_period_ns / 2)
+            {
+                positions[i]++;
+            }
+        }
+        context->frame_index.push_back(capture_start_ns);
+    }
+
+    context->frame_index_built = true;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t seek_frame(k4a_playback_context_t *context, playback_cursor_t *cursor, uint64_t frame_index)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor == NULL);
+    RETURN_IF_ERROR(build_frame_index(context));
+
+    uint64_t frame_count = context->frame_index.size();
+    if (frame_index > frame_count)
+    {
+        LOG_ERROR("Frame %llu is past the end of the recording, which has %llu frames.", frame_index, frame_count);
+        return K4A_RESULT_FAILED;
+    }
+    else if (frame_index == frame_count)
+    {
+        return seek_timestamp(context, cursor, 0, K4A_PLAYBACK_SEEK_END);
+    }
+
+    // The first capture at or after the seek time is the one starting at the frame timestamp. Capture timestamps are
+    // more than a microsecond apart, so rounding down doesn't include the previous capture.
+    return seek_timestamp(context,
+                          cursor,
+                          (int64_t)(context->frame_index[(size_t)frame_index] / 1000),
+                          K4A_PLAYBACK_SEEK_BEGIN);
+}
+
+// Find the first block with a timestamp >= the specified timestamp. If a block group containing the specified timestamp
+// is found, it will be returned. If no blocks are found, a pointer to EOF will be returned, or nullptr if an error
+// occurs.
+std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context, track_reader_t *reader, uint64_t timestamp_ns)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, reader == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, reader->track == NULL);
+
+    // Create a new block pointing to the start of the cluster containing timestamp_ns.
+    std::shared_ptr<block_info_t> block = std::make_shared<block_info_t>();
+    block->reader = reader;
+    block->index = -1;
+    block->sub_index = 0;
+    cluster_info_t *cluster_info = find_cluster(context, timestamp_ns);
+    if (cluster_info == NULL)
+    {
+        LOG_ERROR("Failed to find data cluster for timestamp: %llu", timestamp_ns);
+        return nullptr;
+    }
+
+    block->cluster = load_cluster(context, cluster_info);
+    if (block->cluster == nullptr || block->cluster->cluster == nullptr)
+    {
+        LOG_ERROR("Failed to load initial data cluster from disk.", 0);
+        return nullptr;
+    }
+
+    // Start searching through the blocks for the timestamp we want.
+    while (block)
+    {
+        block = next_block(context, block.get(), true);
+        if (block)
+        {
+            // Return this block if EOF was reached, or the timestamp is >= the search timestamp.
+            if (block->block == NULL || estimate_block_timestamp_ns(block) >= timestamp_ns)
+            {
+                return block;
+            }
+        }
+    }
+
+    LOG_ERROR("Failed to find block for timestamp: %llu ns.", timestamp_ns);
+    return nullptr;
+}
+
+// Find the next / previous block given a current block. If there is no next block, a block pointing to EOF will be
+// returned, or nullptr if an error occurs.
+std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_info_t *current, bool next)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, current == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, current->reader == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, current->cluster == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, current->cluster->cluster == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, current->cluster->cluster_info == nullptr);
+
+    // Get the track number of the current block.
+    uint64_t track_number = current->reader->track->TrackNumber().GetValue();
+    assert(track_number <= UINT16_MAX);
+    uint16_t search_number = static_cast<uint16_t>(track_number);
+
+    // Copy the current block and start the search at the next index / sub-index.
+    std::shared_ptr<block_info_t> next_block = std::shared_ptr<block_info_t>(new block_info_t(*current));
     if (next_block->block != NULL)
     {
         next_block->sub_index += next ? 1 : -1;
@@ -1616,7 +2164,6 @@ std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_
             {
                 if (simple_block->TrackNum() == search_number)
                 {
-                    simple_block->SetParent(*next_block->cluster->cluster);
                     next_block->block = simple_block;
                     next_block->block_duration_ns = 0;
                 }
@@ -1625,8 +2172,6 @@ std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_
             {
                 if (block_group->TrackNumber() == search_number)
                 {
-                    block_group->SetParent(*next_block->cluster->cluster);
-                    block_group->SetParentTrack(*current->reader->track);
                     next_block->block = &GetChild<KaxBlock>(*block_group);
                     if (!block_group->GetBlockDuration(next_block->block_duration_ns))
                     {
@@ -1663,12 +2208,305 @@ std::shared_ptr<block_info_t> next_block(k4a_playback_context_t *context, block_
     return next_block;
 }
 
-static void free_vector_buffer(void *buffer, void *context)
+// Returns a buffer of the given size, reusing a released buffer of the same size if the pool has one.
+image_buffer_t *acquire_image_buffer(k4a_playback_context_t *context, size_t size)
+{
+    image_buffer_pool_t *pool = context->image_buffer_pool.get();
+    {
+        std::lock_guard<std::mutex> lock(pool->lock);
+        auto free_buffers = pool->free_buffers.find(size);
+        if (free_buffers != pool->free_buffers.end() && !free_buffers->second.empty())
+        {
+            image_buffer_t *buffer = free_buffers->second.back();
+            free_buffers->second.pop_back();
+            pool->free_count--;
+            pool->free_size -= size;
+            return buffer;
+        }
+    }
+
+    image_buffer_t *buffer = new image_buffer_t();
+    buffer->pool = context->image_buffer_pool;
+    buffer->data.resize(size);
+    return buffer;
+}
+
+// Returns a buffer to its pool, or frees it if the pool is full or its playback handle was closed.
+void release_image_buffer(image_buffer_t *buffer)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, buffer == NULL);
+
+    {
+        image_buffer_pool_t *pool = buffer->pool.get();
+        std::lock_guard<std::mutex> lock(pool->lock);
+        if (!pool->closed && pool->free_count < IMAGE_BUFFER_POOL_COUNT &&
+            buffer->data.size() <= pool->max_free_size - pool->free_size)
+        {
+            pool->free_buffers[buffer->data.size()].push_back(buffer);
+            pool->free_count++;
+            pool->free_size += buffer->data.size();
+            return;
+        }
+    }
+
+    // The buffer may hold the last reference to the pool, so it is deleted after the pool lock is released.
+    delete buffer;
+}
+
+// Frees the buffers kept by the pool. Buffers of images that are still in use are freed when they are released.
+void close_image_buffer_pool(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context->image_buffer_pool == nullptr);
+
+    std::vector<image_buffer_t *> free_buffers;
+    {
+        image_buffer_pool_t *pool = context->image_buffer_pool.get();
+        std::lock_guard<std::mutex> lock(pool->lock);
+        pool->closed = true;
+        for (auto &size_buffers : pool->free_buffers)
+        {
+            free_buffers.insert(free_buffers.end(), size_buffers.second.begin(), size_buffers.second.end());
+        }
+        pool->free_buffers.clear();
+        pool->free_count = 0;
+        pool->free_size = 0;
+    }
+    for (image_buffer_t *buffer : free_buffers)
+    {
+        delete buffer;
+    }
+}
+
+static void free_image_buffer(void *buffer, void *context)
+{
+    (void)buffer;
+    assert(context != nullptr);
+    release_image_buffer(static_cast<image_buffer_t *>(context));
+}
+
+// Returns a buffer from the pool holding a copy of data.
+static image_buffer_t *copy_image_buffer(k4a_playback_context_t *context, const uint8_t *data, size_t size)
+{
+    image_buffer_t *buffer = acquire_image_buffer(context, size);
+    memcpy(buffer->data.data(), data, size);
+    return buffer;
+}
+
+// Releases the cluster referenced by an image created from the block data, see k4a_playback_set_mapped_io()
+static void release_cluster_reference(void *buffer, void *context)
 {
     (void)buffer;
     assert(context != nullptr);
-    std::vector<uint8_t> *vector = static_cast<std::vector<uint8_t> *>(context);
-    delete vector;
+    delete static_cast<std::shared_ptr<KaxCluster> *>(context);
+}
+
+// Returns a TurboJPEG decompressor that isn't used by another thread. Creating a decompressor allocates its internal
+// buffers, so they are kept for the next image with release_turbojpeg_handle().
+static tjhandle acquire_turbojpeg_handle(k4a_playback_context_t *context)
+{
+    {
+        std::lock_guard<std::mutex> lock(context->turbojpeg_lock);
+        if (!context->turbojpeg_handles.empty())
+        {
+            tjhandle turbojpeg_handle = context->turbojpeg_handles.back();
+            context->turbojpeg_handles.pop_back();
+            return turbojpeg_handle;
+        }
+    }
+    return tjInitDecompress();
+}
+
+static void release_turbojpeg_handle(k4a_playback_context_t *context, tjhandle turbojpeg_handle)
+{
+    if (turbojpeg_handle != NULL)
+    {
+        std::lock_guard<std::mutex> lock(context->turbojpeg_lock);
+        context->turbojpeg_handles.push_back(turbojpeg_handle);
+    }
+}
+
+void destroy_turbojpeg_handles(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->turbojpeg_lock);
+    for (tjhandle turbojpeg_handle : context->turbojpeg_handles)
+    {
+        (void)tjDestroy(turbojpeg_handle);
+    }
+    context->turbojpeg_handles.clear();
+}
+
+// Returns false if the block is an encoded color frame that depends on the frames before it.
+static bool is_key_frame(block_info_t *block)
+{
+    KaxSimpleBlock *simple_block = dynamic_cast<KaxSimpleBlock *>(block->block);
+    return simple_block == NULL || simple_block->IsKeyframe();
+}
+
+// Passes one encoded color frame to the application's decoder. image_out is NULL for frames that are only decoded as a
+// reference for the frames after them.
+static k4a_result_t decode_color_frame(k4a_playback_context_t *context,
+                                       block_info_t *block,
+                                       k4a_image_format_t target_format,
+                                       k4a_image_t *image_out)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block->block->NumberFrames() != 1);
+
+    DataBuffer &data_buffer = block->block->GetBuffer(0);
+    uint64_t device_timestamp_usec = block->timestamp_ns / 1000 +
+                                     (uint64_t)context->record_config.start_timestamp_offset_usec;
+    k4a_result_t result = context->color_decode_cb(data_buffer.Buffer(),
+                                                   data_buffer.Size(),
+                                                   device_timestamp_usec,
+                                                   target_format,
+                                                   image_out,
+                                                   context->color_decode_cb_context);
+
+    context->color_decoded_valid = K4A_SUCCEEDED(result);
+    context->color_decoded_timestamp_ns = block->timestamp_ns;
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("The color decoder failed to decode the frame at timestamp %llu ns.", block->timestamp_ns);
+    }
+    return result;
+}
+
+// Decodes a color block written with k4a_record_set_color_encoder(). Frames that aren't key frames depend on the
+// frames before them, so those are decoded first, starting from the last key frame or the frame the decoder holds.
+// Playing the recording forward only decodes each frame once.
+static k4a_result_t decode_color_block(k4a_playback_context_t *context,
+                                       block_info_t *in_block,
+                                       k4a_image_t *image_out,
+                                       k4a_image_format_t target_format)
+{
+    if (context->color_decode_cb == NULL)
+    {
+        LOG_ERROR("The color track is encoded as '%s', a decoder must be set with k4a_playback_set_color_decoder().",
+                  in_block->reader->codec_id.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    std::lock_guard<std::mutex> lock(context->color_decode_lock);
+
+    // The frames the block depends on, newest first.
+    std::vector<std::shared_ptr<block_info_t>> reference_blocks;
+    if (!is_key_frame(in_block))
+    {
+        std::shared_ptr<block_info_t> previous = next_block(context, in_block, false);
+        while (previous != nullptr &&
+               !(context->color_decoded_valid && previous->timestamp_ns == context->color_decoded_timestamp_ns))
+        {
+            reference_blocks.push_back(previous);
+            if (is_key_frame(previous.get()))
+            {
+                break;
+            }
+            previous = next_block(context, previous.get(), false);
+        }
+    }
+
+    for (auto block = reference_blocks.rbegin(); block != reference_blocks.rend(); block++)
+    {
+        RETURN_IF_ERROR(decode_color_frame(context, block->get(), target_format, NULL));
+    }
+
+    *image_out = NULL;
+    RETURN_IF_ERROR(decode_color_frame(context, in_block, target_format, image_out));
+    if (*image_out == NULL || k4a_image_get_format(*image_out) != target_format)
+    {
+        LOG_ERROR("The color decoder didn't return an image in format %d.", target_format);
+        if (*image_out != NULL)
+        {
+            k4a_image_release(*image_out);
+            *image_out = NULL;
+        }
+        return K4A_RESULT_FAILED;
+    }
+
+    uint64_t device_timestamp_usec = in_block->timestamp_ns / 1000 +
+                                     (uint64_t)context->record_config.start_timestamp_offset_usec;
+    k4a_image_set_device_timestamp_usec(*image_out, device_timestamp_usec);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Decodes an MJPG frame or converts an NV12 or YUY2 frame of width x height pixels into bgra, which holds bgra_height
+// rows of bgra_stride bytes. MJPG frames can be decoded to a size reduced by a turbojpeg scaling factor, turbojpeg
+// picks the factor from the requested size. The other formats are converted at their own size.
+k4a_result_t decode_color_to_bgra(k4a_playback_context_t *context,
+                                  k4a_image_format_t format,
+                                  const uint8_t *data,
+                                  size_t data_size,
+                                  int stride,
+                                  int width,
+                                  int height,
+                                  uint8_t *bgra,
+                                  int bgra_width,
+                                  int bgra_height,
+                                  int bgra_stride)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, bgra == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        format != K4A_IMAGE_FORMAT_COLOR_MJPG && (bgra_width != width || bgra_height != height));
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        tjhandle turbojpeg_handle = acquire_turbojpeg_handle(context);
+        if (turbojpeg_handle == NULL)
+        {
+            LOG_ERROR("Failed to initialize the jpeg decompressor.", 0);
+            result = K4A_RESULT_FAILED;
+        }
+        else if (tjDecompress2(turbojpeg_handle,
+                               data,
+                               (unsigned long)data_size,
+                               bgra,
+                               bgra_width,
+                               bgra_stride,
+                               bgra_height,
+                               TJPF_BGRA,
+                               TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+        {
+            LOG_ERROR("Failed to decompress jpeg image to BGRA format.", 0);
+            result = K4A_RESULT_FAILED;
+        }
+        release_turbojpeg_handle(context, turbojpeg_handle);
+    }
+    else if (format == K4A_IMAGE_FORMAT_COLOR_NV12)
+    {
+        // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
+        if (libyuv::NV12ToARGB(data,
+                               stride,
+                               data + (height * stride),
+                               stride,
+                               bgra,
+                               bgra_stride,
+                               width,
+                               height) != 0)
+        {
+            LOG_ERROR("Failed to convert NV12 image to BGRA format.", 0);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+    else if (format == K4A_IMAGE_FORMAT_COLOR_YUY2)
+    {
+        // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
+        if (libyuv::YUY2ToARGB(data, stride, bgra, bgra_stride, width, height) != 0)
+        {
+            LOG_ERROR("Failed to convert YUY2 image to BGRA format.", 0);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+    else
+    {
+        LOG_ERROR("Unsupported image format conversion: %d to %d", format, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        result = K4A_RESULT_FAILED;
+    }
+    return result;
 }
 
 // Allocates a new image in the specified format from in_block
@@ -1684,10 +2522,16 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, in_block->block == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, in_block->block->NumberFrames() != 1);
 
+    if (in_block->reader->video_encoded)
+    {
+        return decode_color_block(context, in_block, image_out, target_format);
+    }
+
     DataBuffer &data_buffer = in_block->block->GetBuffer(0);
 
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
-    std::vector<uint8_t> *buffer = NULL;
+    image_buffer_t *buffer = NULL;
+    bool reference_block = false; // The image points into the block data, which stays owned by the cluster.
     assert(in_block->reader->width <= INT_MAX);
     assert(in_block->reader->height <= INT_MAX);
     assert(in_block->reader->stride <= INT_MAX);
@@ -1700,22 +2544,47 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     {
     case K4A_IMAGE_FORMAT_DEPTH16:
     case K4A_IMAGE_FORMAT_IR16:
-        buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
-        if (in_block->reader->format == K4A_IMAGE_FORMAT_DEPTH16 || in_block->reader->format == K4A_IMAGE_FORMAT_IR16)
+        if (in_block->reader->rvl_encoded)
         {
-            // 16 bit grayscale needs to be converted from big-endian back to little-endian.
-            assert(buffer->size() % sizeof(uint16_t) == 0);
-            uint16_t *buffer_raw = reinterpret_cast<uint16_t *>(buffer->data());
-            size_t buffer_size = buffer->size() / sizeof(uint16_t);
-            for (size_t i = 0; i < buffer_size; i++)
+            size_t pixel_count = rvl_get_pixel_count(data_buffer.Buffer(), data_buffer.Size());
+            if (pixel_count > (size_t)out_width * (size_t)out_height)
             {
-                buffer_raw[i] = swap_bytes_16(buffer_raw[i]);
+                LOG_ERROR("RVL frame is larger than the track resolution.", 0);
+                result = K4A_RESULT_FAILED;
             }
-        }
-        else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2)
-        {
+            else
+            {
+                buffer = acquire_image_buffer(context, pixel_count * sizeof(uint16_t));
+                result = TRACE_CALL(rvl_decode(data_buffer.Buffer(),
+                                               data_buffer.Size(),
+                                               reinterpret_cast<uint16_t *>(buffer->data.data()),
+                                               pixel_count));
+            }
+            break;
+        }
+
+        if (in_block->reader->format == K4A_IMAGE_FORMAT_DEPTH16 || in_block->reader->format == K4A_IMAGE_FORMAT_IR16)
+        {
+            buffer = copy_image_buffer(context, data_buffer.Buffer(), data_buffer.Size());
+
+            // 16 bit grayscale needs to be converted from big-endian back to little-endian.
+            assert(buffer->data.size() % sizeof(uint16_t) == 0);
+            uint16_t *buffer_raw = reinterpret_cast<uint16_t *>(buffer->data.data());
+            size_t buffer_size = buffer->data.size() / sizeof(uint16_t);
+            for (size_t i = 0; i < buffer_size; i++)
+            {
+                buffer_raw[i] = swap_bytes_16(buffer_raw[i]);
+            }
+        }
+        else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2)
+        {
             // For backward compatibility with early recordings, the YUY2 format was used. The actual data buffer is
             // 16-bit little-endian, so we can just use the buffer as-is.
+            reference_block = context->mapped_io;
+            if (!reference_block)
+            {
+                buffer = copy_image_buffer(context, data_buffer.Buffer(), data_buffer.Size());
+            }
         }
         else
         {
@@ -1729,69 +2598,39 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     case K4A_IMAGE_FORMAT_COLOR_BGRA32:
         if (in_block->reader->format == target_format)
         {
-            // No format conversion is required, just copy the buffer.
-            buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+            // No format conversion is required, just copy the buffer, or reference it with mapped IO.
+            reference_block = context->mapped_io;
+            if (!reference_block)
+            {
+                buffer = copy_image_buffer(context, data_buffer.Buffer(), data_buffer.Size());
+            }
         }
         else
         {
-            // Convert the buffer to BGRA format first
-            out_stride = out_width * 4 * (int)sizeof(uint8_t);
-            buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
-
-            if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG)
-            {
-                tjhandle turbojpeg_handle = tjInitDecompress();
-                if (tjDecompress2(turbojpeg_handle,
-                                  data_buffer.Buffer(),
-                                  data_buffer.Size(),
-                                  buffer->data(),
-                                  out_width,
-                                  0, // pitch
-                                  out_height,
-                                  TJPF_BGRA,
-                                  TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
-                {
-                    LOG_ERROR("Failed to decompress jpeg image to BGRA format.", 0);
-                    result = K4A_RESULT_FAILED;
-                }
-                (void)tjDestroy(turbojpeg_handle);
-            }
-            else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_NV12)
-            {
-                // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
-                if (libyuv::NV12ToARGB(data_buffer.Buffer(),
-                                       (int)in_block->reader->stride,
-                                       data_buffer.Buffer() + (out_height * (int)in_block->reader->stride),
-                                       (int)in_block->reader->stride,
-                                       buffer->data(),
-                                       out_stride,
-                                       out_width,
-                                       out_height) != 0)
-                {
-                    LOG_ERROR("Failed to convert NV12 image to BGRA format.", 0);
-                    result = K4A_RESULT_FAILED;
-                }
-            }
-            else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2)
+            if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG && context->color_scale != K4A_COLOR_SCALE_FULL)
             {
-                // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
-                if (libyuv::YUY2ToARGB(data_buffer.Buffer(),
-                                       (int)in_block->reader->stride,
-                                       buffer->data(),
-                                       out_stride,
-                                       out_width,
-                                       out_height) != 0)
-                {
-                    LOG_ERROR("Failed to convert YUY2 image to BGRA format.", 0);
-                    result = K4A_RESULT_FAILED;
-                }
-            }
-            else
-            {
-                LOG_ERROR("Unsupported image format conversion: %d to %d", in_block->reader->format, target_format);
-                result = K4A_RESULT_FAILED;
+                // The jpeg is decoded straight to the reduced resolution, turbojpeg picks the scaling factor from the
+                // requested size
+                tjscalingfactor scaling_factor = { 1, 1 << context->color_scale };
+                out_width = TJSCALED(out_width, scaling_factor);
+                out_height = TJSCALED(out_height, scaling_factor);
             }
 
+            // Convert the buffer to BGRA format first
+            out_stride = out_width * 4 * (int)sizeof(uint8_t);
+            buffer = acquire_image_buffer(context, (size_t)(out_height * out_stride));
+            result = TRACE_CALL(decode_color_to_bgra(context,
+                                                     in_block->reader->format,
+                                                     data_buffer.Buffer(),
+                                                     data_buffer.Size(),
+                                                     (int)in_block->reader->stride,
+                                                     (int)in_block->reader->width,
+                                                     (int)in_block->reader->height,
+                                                     buffer->data.data(),
+                                                     out_width,
+                                                     out_height,
+                                                     out_stride));
+
             if (K4A_SUCCEEDED(result) && target_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
             {
                 auto bgra_buffer = buffer;
@@ -1804,13 +2643,13 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                     size_t y_plane_size = (size_t)(out_height * out_stride);
                     // Round up the size of the UV plane in case the resolution is odd.
                     size_t uv_plane_size = (size_t)(out_height * out_stride + 1) / 2;
-                    buffer = new std::vector<uint8_t>(y_plane_size + uv_plane_size);
+                    buffer = acquire_image_buffer(context, y_plane_size + uv_plane_size);
 
-                    if (libyuv::ARGBToNV12(bgra_buffer->data(),
+                    if (libyuv::ARGBToNV12(bgra_buffer->data.data(),
                                            bgra_stride,
-                                           buffer->data(),
+                                           buffer->data.data(),
                                            out_stride,
-                                           buffer->data() + y_plane_size,
+                                           buffer->data.data() + y_plane_size,
                                            out_stride,
                                            out_width,
                                            out_height) != 0)
@@ -1822,10 +2661,14 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                 else if (target_format == K4A_IMAGE_FORMAT_COLOR_YUY2)
                 {
                     out_stride = out_width * 2;
-                    buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
+                    buffer = acquire_image_buffer(context, (size_t)(out_height * out_stride));
 
-                    if (libyuv::ARGBToYUY2(
-                            bgra_buffer->data(), bgra_stride, buffer->data(), out_stride, out_width, out_height) != 0)
+                    if (libyuv::ARGBToYUY2(bgra_buffer->data.data(),
+                                           bgra_stride,
+                                           buffer->data.data(),
+                                           out_stride,
+                                           out_width,
+                                           out_height) != 0)
                     {
                         LOG_ERROR("Failed to convert BGRA image to YUY2 format.", 0);
                         result = K4A_RESULT_FAILED;
@@ -1837,10 +2680,7 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                     result = K4A_RESULT_FAILED;
                 }
 
-                if (bgra_buffer != NULL)
-                {
-                    delete bgra_buffer;
-                }
+                release_image_buffer(bgra_buffer);
             }
         }
         break;
@@ -1849,17 +2689,39 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
         result = K4A_RESULT_FAILED;
     }
 
-    if (K4A_SUCCEEDED(result) && buffer != NULL)
+    if (K4A_SUCCEEDED(result) && reference_block)
     {
+        // The image keeps the cluster loaded until it is released, instead of copying the data out of it.
+        auto cluster_reference = new std::shared_ptr<KaxCluster>(in_block->cluster->cluster);
         result = TRACE_CALL(k4a_image_create_from_buffer(target_format,
                                                          out_width,
                                                          out_height,
                                                          out_stride,
-                                                         buffer->data(),
-                                                         buffer->size(),
-                                                         &free_vector_buffer,
+                                                         data_buffer.Buffer(),
+                                                         data_buffer.Size(),
+                                                         &release_cluster_reference,
+                                                         cluster_reference,
+                                                         image_out));
+        if (K4A_FAILED(result))
+        {
+            delete cluster_reference;
+        }
+    }
+    else if (K4A_SUCCEEDED(result) && buffer != NULL)
+    {
+        result = TRACE_CALL(k4a_image_create_from_buffer(target_format,
+                                                         out_width,
+                                                         out_height,
+                                                         out_stride,
+                                                         buffer->data.data(),
+                                                         buffer->data.size(),
+                                                         &free_image_buffer,
                                                          buffer,
                                                          image_out));
+    }
+
+    if (K4A_SUCCEEDED(result) && (reference_block || buffer != NULL))
+    {
         uint64_t device_timestamp_usec = in_block->timestamp_ns / 1000 +
                                          (uint64_t)context->record_config.start_timestamp_offset_usec;
         k4a_image_set_device_timestamp_usec(*image_out, device_timestamp_usec);
@@ -1867,15 +2729,114 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
 
     if (K4A_FAILED(result) && buffer != NULL)
     {
-        delete buffer;
+        release_image_buffer(buffer);
     }
 
     return result;
 }
 
-k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k4a_capture_t *capture_handle)
+// Starts converting the color images of the captures after color_block in the background, or before it when playing
+// backward, until color_read_ahead_count images are queued.
+void start_color_read_ahead(k4a_playback_context_t *context,
+                            playback_cursor_t *cursor,
+                            std::shared_ptr<block_info_t> &color_block,
+                            bool next)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, cursor == NULL);
+
+    if (context->color_track != NULL && context->color_track->video_encoded)
+    {
+        // Encoded color frames need to be decoded in order by the application's decoder, one at a time.
+        return;
+    }
+
+    if (!cursor->color_read_ahead.empty() && cursor->color_read_ahead_next != next)
+    {
+        // Playback changed direction, the queued images are behind the current capture.
+        clear_color_read_ahead(context, cursor);
+    }
+    cursor->color_read_ahead_next = next;
+
+    std::shared_ptr<block_info_t> block = cursor->color_read_ahead.empty() ? color_block :
+                                                                              cursor->color_read_ahead.back().block;
+    while (block && block->block && cursor->color_read_ahead.size() < context->color_read_ahead_count)
+    {
+        block = next_block(context, block.get(), next);
+        if (block && block->block)
+        {
+            k4a_image_format_t target_format = context->color_format_conversion;
+            read_ahead_image_t read_ahead;
+            read_ahead.block = block;
+            read_ahead.image = std::async(std::launch::async, [context, block, target_format] {
+                k4a_image_t image = NULL;
+                if (K4A_FAILED(TRACE_CALL(convert_block_to_image(context, block.get(), &image, target_format))))
+                {
+                    image = NULL;
+                }
+                return image;
+            });
+            cursor->color_read_ahead.push_back(read_ahead);
+        }
+    }
+}
+
+// Waits for the color images being converted in the background and releases them. The images are no longer valid after
+// a seek, or once the color conversion settings change.
+void clear_color_read_ahead(k4a_playback_context_t *context, playback_cursor_t *cursor)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, cursor == NULL);
+
+    for (read_ahead_image_t &read_ahead : cursor->color_read_ahead)
+    {
+        k4a_image_t image = read_ahead.image.get();
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+    cursor->color_read_ahead.clear();
+}
+
+// Returns the color image of color_block if it was converted in the background, or NULL otherwise.
+static k4a_image_t take_read_ahead_image(k4a_playback_context_t *context,
+                                         playback_cursor_t *cursor,
+                                         block_info_t *color_block)
+{
+    auto itr = std::find_if(cursor->color_read_ahead.begin(),
+                            cursor->color_read_ahead.end(),
+                            [color_block](const read_ahead_image_t &read_ahead) {
+                                return read_ahead.block->block == color_block->block;
+                            });
+    if (itr == cursor->color_read_ahead.end())
+    {
+        // Playback moved in the other direction, none of the queued images will be used.
+        clear_color_read_ahead(context, cursor);
+        return NULL;
+    }
+
+    // Images of blocks that were skipped over are dropped.
+    for (auto skipped = cursor->color_read_ahead.begin(); skipped != itr; skipped++)
+    {
+        k4a_image_t image = skipped->image.get();
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+    k4a_image_t image = itr->image.get();
+    cursor->color_read_ahead.erase(cursor->color_read_ahead.begin(), itr + 1);
+    return image;
+}
+
+k4a_result_t new_capture(k4a_playback_context_t *context,
+                         playback_cursor_t *cursor,
+                         block_info_t *block,
+                         k4a_capture_t *capture_handle)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block == nullptr);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block->reader == NULL);
@@ -1890,7 +2851,12 @@ k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
     if (block->reader == context->color_track)
     {
-        result = TRACE_CALL(convert_block_to_image(context, block, &image_handle, context->color_format_conversion));
+        image_handle = take_read_ahead_image(context, cursor, block);
+        if (image_handle == NULL)
+        {
+            result = TRACE_CALL(
+                convert_block_to_image(context, block, &image_handle, context->color_format_conversion));
+        }
         k4a_capture_set_color_image(*capture_handle, image_handle);
     }
     else if (block->reader == context->depth_track)
@@ -1916,12 +2882,20 @@ k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k
     return result;
 }
 
-k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *capture_handle, bool next)
+// If capture_timestamp_ns is not NULL, it is set to the lowest sync timestamp of the blocks in the returned capture.
+k4a_stream_result_t get_capture(k4a_playback_context_t *context,
+                                playback_cursor_t *cursor,
+                                k4a_capture_t *capture_handle,
+                                bool next,
+                                uint64_t *capture_timestamp_ns)
 {
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
 
-    track_reader_t *blocks[] = { context->color_track, context->depth_track, context->ir_track };
+    track_reader_t *blocks[] = { enabled_track(context->color_track),
+                                 enabled_track(context->depth_track),
+                                 enabled_track(context->ir_track) };
     std::shared_ptr<block_info_t> next_blocks[arraysize(blocks)];
 
     uint64_t timestamp_start_ns = UINT64_MAX;
@@ -1936,9 +2910,9 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             enabled_tracks++;
 
             // If the current block is NULL, find the next block before/after the seek timestamp.
-            if (blocks[i]->current_block == nullptr)
+            if (cursor->current_blocks[blocks[i]] == nullptr)
             {
-                next_blocks[i] = find_block(context, blocks[i], context->seek_timestamp_ns);
+                next_blocks[i] = find_block(context, blocks[i], cursor->seek_timestamp_ns);
                 if (!next && next_blocks[i])
                 {
                     next_blocks[i] = next_block(context, next_blocks[i].get(), false);
@@ -1946,7 +2920,7 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             }
             else
             {
-                next_blocks[i] = next_block(context, blocks[i]->current_block.get(), next);
+                next_blocks[i] = next_block(context, cursor->current_blocks[blocks[i]].get(), next);
             }
             if (next_blocks[i] && next_blocks[i]->block)
             {
@@ -1963,7 +2937,7 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             else
             {
                 LOG_TRACE("%s of recording reached", next ? "End" : "Beginning");
-                blocks[i]->current_block = next_blocks[i];
+                cursor->current_blocks[blocks[i]] = next_blocks[i];
             }
         }
     }
@@ -2016,11 +2990,11 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             bool filled = false;
             for (size_t i = 0; i < arraysize(blocks); i++)
             {
-                if (blocks[i] != NULL && next_blocks[i] == nullptr && blocks[i]->current_block == nullptr)
+                if (blocks[i] != NULL && next_blocks[i] == nullptr && cursor->current_blocks[blocks[i]] == nullptr)
                 {
                     std::shared_ptr<block_info_t> test_block = find_block(context,
                                                                           blocks[i],
-                                                                          context->seek_timestamp_ns);
+                                                                          cursor->seek_timestamp_ns);
                     if (next)
                     {
                         test_block = next_block(context, test_block.get(), false);
@@ -2051,11 +3025,11 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
                 {
                     if (next_blocks[i])
                     {
-                        blocks[i]->current_block = next_blocks[i];
+                        cursor->current_blocks[blocks[i]] = next_blocks[i];
                     }
                 }
 
-                return get_capture(context, capture_handle, false);
+                return get_capture(context, cursor, capture_handle, false, capture_timestamp_ns);
             }
         }
     }
@@ -2067,12 +3041,21 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
               timestamp_end_ns / 1_ms);
 
     *capture_handle = NULL;
+    if (capture_timestamp_ns != NULL)
+    {
+        *capture_timestamp_ns = UINT64_MAX;
+    }
     for (size_t i = 0; i < arraysize(blocks); i++)
     {
         if (next_blocks[i] && next_blocks[i]->block)
         {
-            blocks[i]->current_block = next_blocks[i];
-            k4a_result_t result = TRACE_CALL(new_capture(context, blocks[i]->current_block.get(), capture_handle));
+            if (capture_timestamp_ns != NULL && next_blocks[i]->sync_timestamp_ns < *capture_timestamp_ns)
+            {
+                *capture_timestamp_ns = next_blocks[i]->sync_timestamp_ns;
+            }
+            cursor->current_blocks[blocks[i]] = next_blocks[i];
+            k4a_result_t result = TRACE_CALL(
+                new_capture(context, cursor, cursor->current_blocks[blocks[i]].get(), capture_handle));
             if (K4A_FAILED(result))
             {
                 if (*capture_handle != NULL)
@@ -2084,6 +3067,13 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             }
         }
     }
+
+    // Color images are only converted ahead for the playback handle itself, cursors convert them when they are read.
+    if (cursor == &context->cursor && context->color_read_ahead_count > 0 &&
+        enabled_track(context->color_track) != NULL && cursor->current_blocks[context->color_track])
+    {
+        start_color_read_ahead(context, cursor, cursor->current_blocks[context->color_track], next);
+    }
     return valid_blocks == 0 ? K4A_STREAM_RESULT_EOF : K4A_STREAM_RESULT_SUCCEEDED;
 }
 
@@ -2108,9 +3098,25 @@ static matroska_imu_sample_t *parse_imu_sample_buffer(DataBuffer &data_buffer)
     }
 }
 
-k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_sample_t *imu_sample, bool next)
+static void convert_imu_sample(const matroska_imu_sample_t *sample, k4a_imu_sample_t *imu_sample)
+{
+    imu_sample->acc_timestamp_usec = sample->acc_timestamp_ns / 1000;
+    imu_sample->gyro_timestamp_usec = sample->gyro_timestamp_ns / 1000;
+    imu_sample->temperature = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < 3; i++)
+    {
+        imu_sample->acc_sample.v[i] = sample->acc_data[i];
+        imu_sample->gyro_sample.v[i] = sample->gyro_data[i];
+    }
+}
+
+k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context,
+                                   playback_cursor_t *cursor,
+                                   k4a_imu_sample_t *imu_sample,
+                                   bool next)
 {
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_sample == NULL);
 
     if (context->imu_track == NULL)
@@ -2120,12 +3126,12 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
         return K4A_STREAM_RESULT_EOF;
     }
 
-    std::shared_ptr<block_info_t> block_info = context->imu_track->current_block;
+    std::shared_ptr<block_info_t> block_info = cursor->current_blocks[context->imu_track];
 
     if (block_info == nullptr)
     {
         // There is no current IMU sample, find the next/previous sample based on seek_timestamp.
-        block_info = find_block(context, context->imu_track, context->seek_timestamp_ns);
+        block_info = find_block(context, context->imu_track, cursor->seek_timestamp_ns);
         if (block_info && !block_info->block)
         {
             // The seek timestamp is past the end of the file, get the last block instead.
@@ -2137,12 +3143,12 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
             // The returned block will not have an accurate sub_index due to timestamp estimation, select the correct
             // sub_index based on the real timestamp stored in the sample.
             size_t sample_count = block_info->block->NumberFrames();
-            if (block_info->sync_timestamp_ns > context->seek_timestamp_ns)
+            if (block_info->sync_timestamp_ns > cursor->seek_timestamp_ns)
             {
                 // The timestamp we're looking for is before the found block.
                 block_info->sub_index = next ? 0 : -1;
             }
-            else if (block_info->sync_timestamp_ns + block_info->block_duration_ns <= context->seek_timestamp_ns)
+            else if (block_info->sync_timestamp_ns + block_info->block_duration_ns <= cursor->seek_timestamp_ns)
             {
                 // The timestamp we're looking for is after the found block.
                 block_info->sub_index = (int)sample_count + (next ? 0 : -1);
@@ -2152,7 +3158,7 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
                 // The timestamp we're looking for is within the found block.
                 // IMU timestamps within the sample buffer are device timestamps, not relative to start of file.
                 // The seek timestamp needs to be converted to a device timestamp when comparing.
-                uint64_t seek_device_timestamp_ns = context->seek_timestamp_ns +
+                uint64_t seek_device_timestamp_ns = cursor->seek_timestamp_ns +
                                                     ((uint64_t)context->record_config.start_timestamp_offset_usec *
                                                      1000);
                 block_info->sub_index = -1;
@@ -2183,7 +3189,7 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
         block_info = next_block(context, block_info.get(), next);
     }
 
-    context->imu_track->current_block = block_info;
+    cursor->current_blocks[context->imu_track] = block_info;
 
     if (block_info && block_info->block && block_info->sub_index >= 0 &&
         block_info->sub_index < (int)block_info->block->NumberFrames())
@@ -2197,14 +3203,7 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
         }
         else
         {
-            imu_sample->acc_timestamp_usec = sample->acc_timestamp_ns / 1000;
-            imu_sample->gyro_timestamp_usec = sample->gyro_timestamp_ns / 1000;
-            imu_sample->temperature = std::numeric_limits<float>::quiet_NaN();
-            for (size_t i = 0; i < 3; i++)
-            {
-                imu_sample->acc_sample.v[i] = sample->acc_data[i];
-                imu_sample->gyro_sample.v[i] = sample->gyro_data[i];
-            }
+            convert_imu_sample(sample, imu_sample);
             return K4A_STREAM_RESULT_SUCCEEDED;
         }
     }
@@ -2214,21 +3213,426 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
     return K4A_STREAM_RESULT_EOF;
 }
 
+// Returns the block stored in a cluster element, or NULL if the element isn't a block of the given track.
+static KaxInternalBlock *get_element_block(EbmlElement *element, uint64_t track_number)
+{
+    KaxSimpleBlock *simple_block = NULL;
+    KaxBlockGroup *block_group = NULL;
+    KaxInternalBlock *block = NULL;
+    if (check_element_type(element, &simple_block))
+    {
+        block = simple_block;
+    }
+    else if (check_element_type(element, &block_group))
+    {
+        block = &GetChild<KaxBlock>(*block_group);
+    }
+    return block != NULL && block->TrackNum() == track_number ? block : NULL;
+}
+
+// Builds an index of every IMU block in the recording. This reads through the whole file once, afterwards IMU samples
+// can be read by time range without walking through the blocks of the other tracks.
+k4a_result_t build_imu_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->imu_index_lock);
+    if (context->imu_index_built)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    context->imu_index.clear();
+    if (context->imu_track != NULL)
+    {
+        uint64_t track_number = context->imu_track->track->TrackNumber().GetValue();
+        cluster_info_t *cluster_info = find_cluster(context, 0);
+        while (cluster_info != NULL)
+        {
+            std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
+            if (cluster == nullptr)
+            {
+                LOG_ERROR("Failed to load data cluster at timestamp %llu ns while indexing IMU samples.",
+                          cluster_info->timestamp_ns);
+                return K4A_RESULT_FAILED;
+            }
+
+            std::vector<EbmlElement *> elements = cluster->GetElementList();
+            for (size_t i = 0; i < elements.size(); i++)
+            {
+                KaxInternalBlock *block = get_element_block(elements[i], track_number);
+                if (block != NULL && block->NumberFrames() > 0)
+                {
+                    matroska_imu_sample_t *sample = parse_imu_sample_buffer(block->GetBuffer(0));
+                    if (sample == NULL)
+                    {
+                        return K4A_RESULT_FAILED;
+                    }
+
+                    imu_index_entry_t entry;
+                    entry.first_timestamp_ns = sample->acc_timestamp_ns;
+                    entry.cluster_info = cluster_info;
+                    entry.index = (int)i;
+                    context->imu_index.push_back(entry);
+                }
+            }
+
+            cluster_info = next_cluster(context, cluster_info, true);
+        }
+    }
+
+    context->imu_index_built = true;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_buffer_result_t get_imu_samples(k4a_playback_context_t *context,
+                                    uint64_t start_device_timestamp_ns,
+                                    uint64_t end_device_timestamp_ns,
+                                    k4a_imu_sample_t *imu_samples,
+                                    size_t max_sample_count,
+                                    size_t *sample_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, sample_count == NULL);
+
+    *sample_count = 0;
+    if (context->imu_track == NULL)
+    {
+        LOG_WARNING("Recording has no IMU track.", 0);
+        return K4A_BUFFER_RESULT_SUCCEEDED;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(build_imu_index(context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    // The index is never modified once it is built. Start at the last block beginning at or before the range, the
+    // start of the range may be in the middle of it.
+    const std::vector<imu_index_entry_t> &imu_index = context->imu_index;
+    auto itr = std::upper_bound(imu_index.begin(),
+                                imu_index.end(),
+                                start_device_timestamp_ns,
+                                [](uint64_t timestamp_ns, const imu_index_entry_t &entry) {
+                                    return timestamp_ns < entry.first_timestamp_ns;
+                                });
+    if (itr != imu_index.begin())
+    {
+        itr--;
+    }
+
+    uint64_t track_number = context->imu_track->track->TrackNumber().GetValue();
+    cluster_info_t *cluster_info = NULL;
+    std::shared_ptr<KaxCluster> cluster;
+    size_t count = 0;
+    for (; itr != imu_index.end() && itr->first_timestamp_ns < end_device_timestamp_ns; itr++)
+    {
+        // Consecutive IMU blocks are usually stored in the same cluster.
+        if (itr->cluster_info != cluster_info)
+        {
+            cluster_info = itr->cluster_info;
+            cluster = load_cluster_internal(context, cluster_info);
+            if (cluster == nullptr)
+            {
+                LOG_ERROR("Failed to load data cluster at timestamp %llu ns.", cluster_info->timestamp_ns);
+                return K4A_BUFFER_RESULT_FAILED;
+            }
+        }
+
+        std::vector<EbmlElement *> elements = cluster->GetElementList();
+        KaxInternalBlock *block = (size_t)itr->index < elements.size() ?
+                                      get_element_block(elements[(size_t)itr->index], track_number) :
+                                      NULL;
+        if (block == NULL)
+        {
+            LOG_ERROR("IMU index does not match the data cluster at timestamp %llu ns.", cluster_info->timestamp_ns);
+            return K4A_BUFFER_RESULT_FAILED;
+        }
+
+        // Decode the whole block at once.
+        for (unsigned int i = 0; i < block->NumberFrames(); i++)
+        {
+            matroska_imu_sample_t *sample = parse_imu_sample_buffer(block->GetBuffer(i));
+            if (sample == NULL)
+            {
+                return K4A_BUFFER_RESULT_FAILED;
+            }
+            else if (sample->acc_timestamp_ns < start_device_timestamp_ns)
+            {
+                continue;
+            }
+            else if (sample->acc_timestamp_ns >= end_device_timestamp_ns)
+            {
+                *sample_count = count;
+                return K4A_BUFFER_RESULT_SUCCEEDED;
+            }
+
+            if (count == max_sample_count)
+            {
+                // Don't split the samples of a timestamp, so the caller can continue reading after the last one.
+                uint64_t timestamp_usec = sample->acc_timestamp_ns / 1000;
+                while (count > 0 && imu_samples[count - 1].acc_timestamp_usec == timestamp_usec)
+                {
+                    count--;
+                }
+                *sample_count = count;
+                return K4A_BUFFER_RESULT_TOO_SMALL;
+            }
+
+            convert_imu_sample(sample, &imu_samples[count]);
+            count++;
+        }
+    }
+
+    *sample_count = count;
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+// Builds an index of every block of the preview track. The previews listed in a sidecar index are already in the
+// index, the rest of the preview track is read through once. Afterwards each preview is read on its own, without
+// loading the clusters around it.
+k4a_result_t build_preview_index(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->preview_index_lock);
+    if (context->preview_index_built)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    if (context->preview_track != NULL)
+    {
+        // The last cluster of a live index may have a preview that is already in the index.
+        std::shared_ptr<block_info_t> block = find_block(context,
+                                                         context->preview_track,
+                                                         context->preview_index_resume_ns);
+        while (block != nullptr && block->block != nullptr)
+        {
+            uint64_t data_position = block->block->GetDataPosition((size_t)block->sub_index);
+            uint64_t file_offset = context->segment->GetRelativePosition(data_position);
+            if (context->preview_index.empty() || file_offset > context->preview_index.back().file_offset)
+            {
+                preview_index_entry_t entry;
+                entry.timestamp_ns = block->timestamp_ns;
+                entry.file_offset = file_offset;
+                entry.size = block->block->GetFrameSize((size_t)block->sub_index);
+                context->preview_index.push_back(entry);
+            }
+            block = next_block(context, block.get(), true);
+        }
+
+        if (block == nullptr)
+        {
+            LOG_ERROR("Failed to read the preview track.", 0);
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    context->preview_index_built = true;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Creates an image holding a copy of data and adds it to a preview capture.
+static k4a_result_t add_preview_image(k4a_playback_context_t *context,
+                                      k4a_capture_t preview_handle,
+                                      k4a_image_format_t format,
+                                      uint32_t width,
+                                      uint32_t height,
+                                      uint32_t stride,
+                                      const uint8_t *data,
+                                      size_t size,
+                                      uint64_t device_timestamp_usec)
+{
+    image_buffer_t *buffer = copy_image_buffer(context, data, size);
+    k4a_image_t image_handle = NULL;
+    k4a_result_t result = TRACE_CALL(k4a_image_create_from_buffer(format,
+                                                                  (int)width,
+                                                                  (int)height,
+                                                                  (int)stride,
+                                                                  buffer->data.data(),
+                                                                  buffer->data.size(),
+                                                                  &free_image_buffer,
+                                                                  buffer,
+                                                                  &image_handle));
+    if (K4A_FAILED(result))
+    {
+        release_image_buffer(buffer);
+        return result;
+    }
+
+    k4a_image_set_device_timestamp_usec(image_handle, device_timestamp_usec);
+    if (format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        k4a_capture_set_color_image(preview_handle, image_handle);
+    }
+    else
+    {
+        k4a_capture_set_depth_image(preview_handle, image_handle);
+    }
+    k4a_image_release(image_handle);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Reads one preview of the preview index into a new capture, see preview_block_header_t.
+static k4a_result_t read_preview(k4a_playback_context_t *context,
+                                 const preview_index_entry_t &entry,
+                                 k4a_capture_t *preview_handle)
+{
+    std::vector<uint8_t> data((size_t)entry.size);
+    {
+        std::lock_guard<std::mutex> io_lock(context->io_lock);
+        if (context->file_closing)
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+        if (file_io != NULL)
+        {
+            file_io->setOwnerThread();
+        }
+
+        RETURN_IF_ERROR(seek_offset(context, entry.file_offset));
+        try
+        {
+            if (context->ebml_file->read(data.data(), data.size()) != data.size())
+            {
+                LOG_ERROR("Failed to read the preview at timestamp %llu ns.", entry.timestamp_ns);
+                return K4A_RESULT_FAILED;
+            }
+        }
+        catch (std::ios_base::failure &e)
+        {
+            LOG_ERROR("Failed to read the preview at timestamp %llu ns: %s", entry.timestamp_ns, e.what());
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    preview_block_header_t header;
+    if (data.size() < sizeof(header))
+    {
+        LOG_ERROR("The preview at timestamp %llu ns is too small.", entry.timestamp_ns);
+        return K4A_RESULT_FAILED;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    size_t image_data_size = data.size() - sizeof(header);
+    size_t depth_size = (size_t)header.depth_width * (size_t)header.depth_height;
+    if (header.color_jpeg_size > image_data_size || depth_size != image_data_size - header.color_jpeg_size)
+    {
+        LOG_ERROR("The preview at timestamp %llu ns is invalid.", entry.timestamp_ns);
+        return K4A_RESULT_FAILED;
+    }
+
+    RETURN_IF_ERROR(k4a_capture_create(preview_handle));
+
+    const uint8_t *color_data = data.data() + sizeof(header);
+    uint64_t device_timestamp_usec = entry.timestamp_ns / 1000 + context->record_config.start_timestamp_offset_usec;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (header.color_jpeg_size > 0)
+    {
+        result = TRACE_CALL(add_preview_image(context,
+                                              *preview_handle,
+                                              K4A_IMAGE_FORMAT_COLOR_MJPG,
+                                              header.color_width,
+                                              header.color_height,
+                                              0,
+                                              color_data,
+                                              header.color_jpeg_size,
+                                              device_timestamp_usec));
+    }
+    if (K4A_SUCCEEDED(result) && depth_size > 0)
+    {
+        result = TRACE_CALL(add_preview_image(context,
+                                              *preview_handle,
+                                              K4A_IMAGE_FORMAT_CUSTOM8,
+                                              header.depth_width,
+                                              header.depth_height,
+                                              header.depth_width,
+                                              color_data + header.color_jpeg_size,
+                                              depth_size,
+                                              device_timestamp_usec));
+    }
+
+    if (K4A_FAILED(result))
+    {
+        k4a_capture_release(*preview_handle);
+        *preview_handle = NULL;
+    }
+    return result;
+}
+
+k4a_stream_result_t get_preview(k4a_playback_context_t *context,
+                                playback_cursor_t *cursor,
+                                k4a_capture_t *preview_handle,
+                                bool next)
+{
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, preview_handle == NULL);
+
+    *preview_handle = NULL;
+    if (context->preview_track == NULL)
+    {
+        LOG_WARNING("Recording has no preview track.", 0);
+        return K4A_STREAM_RESULT_EOF;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(build_preview_index(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    // The index is never modified once it is built.
+    const std::vector<preview_index_entry_t> &preview_index = context->preview_index;
+    int64_t preview_count = (int64_t)preview_index.size();
+    if (!cursor->preview_valid)
+    {
+        // Start between the last preview before the seek timestamp and the first one at or after it.
+        auto itr = std::lower_bound(preview_index.begin(),
+                                    preview_index.end(),
+                                    cursor->seek_timestamp_ns,
+                                    [](const preview_index_entry_t &entry, uint64_t timestamp_ns) {
+                                        return entry.timestamp_ns < timestamp_ns;
+                                    });
+        cursor->preview_position = (int64_t)(itr - preview_index.begin()) - (next ? 1 : 0);
+        cursor->preview_valid = true;
+    }
+
+    int64_t position = cursor->preview_position + (next ? 1 : -1);
+    if (position < 0 || position >= preview_count)
+    {
+        cursor->preview_position = position < 0 ? -1 : preview_count;
+        LOG_TRACE("%s of preview track reached", next ? "End" : "Beginning");
+        return K4A_STREAM_RESULT_EOF;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(read_preview(context, preview_index[(size_t)position], preview_handle))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+    cursor->preview_position = position;
+    return K4A_STREAM_RESULT_SUCCEEDED;
+}
+
 k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
+                                   playback_cursor_t *cursor,
                                    track_reader_t *track_reader,
                                    k4a_playback_data_block_t *data_block_handle,
                                    bool next)
 {
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_reader == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
 
-    std::shared_ptr<block_info_t> read_block = track_reader->current_block;
+    std::shared_ptr<block_info_t> read_block = cursor->current_blocks[track_reader];
     if (read_block == nullptr)
     {
         // If the track current block is nullptr, it means we just performed a seek frame operation.
         // find_block() always finds the block with timestamp >= seek_timestamp.
-        read_block = find_block(context, track_reader, context->seek_timestamp_ns);
+        read_block = find_block(context, track_reader, cursor->seek_timestamp_ns);
         if (!next && read_block)
         {
             // In order to find the first timestamp < seek_timestamp, we need to query the previous block.
@@ -2245,7 +3649,7 @@ k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    track_reader->current_block = read_block;
+    cursor->current_blocks[track_reader] = read_block;
 
     // Reach EOF
     if (read_block->block == nullptr)
@@ -2260,14 +3664,313 @@ k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    DataBuffer &data_buffer = track_reader->current_block->block->GetBuffer(
-        (unsigned int)track_reader->current_block->sub_index);
+    DataBuffer &data_buffer = read_block->block->GetBuffer((unsigned int)read_block->sub_index);
 
-    data_block_context->device_timestamp_usec = estimate_block_timestamp_ns(track_reader->current_block) / 1000 +
+    data_block_context->device_timestamp_usec = estimate_block_timestamp_ns(read_block) / 1000 +
                                                 context->record_config.start_timestamp_offset_usec;
-    data_block_context->data_block.assign(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+    if (context->mapped_io)
+    {
+        // The data block keeps the cluster loaded until it is released, instead of copying the data out of it.
+        data_block_context->cluster = read_block->cluster->cluster;
+        data_block_context->cluster_buffer = data_buffer.Buffer();
+        data_block_context->cluster_buffer_size = data_buffer.Size();
+    }
+    else
+    {
+        data_block_context->data_block.assign(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+    }
 
     return K4A_STREAM_RESULT_SUCCEEDED;
 }
 
+// Copies the blocks of a track with timestamps in [start_ns, end_ns) into a single buffer, without moving any cursor.
+k4a_buffer_result_t get_data_blocks(k4a_playback_context_t *context,
+                                    track_reader_t *track_reader,
+                                    uint64_t start_ns,
+                                    uint64_t end_ns,
+                                    k4a_playback_data_block_info_t *blocks,
+                                    size_t max_block_count,
+                                    uint8_t *buffer,
+                                    size_t buffer_size,
+                                    size_t *block_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, track_reader == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, blocks == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, block_count == NULL);
+
+    *block_count = 0;
+    std::shared_ptr<block_info_t> read_block = find_block(context, track_reader, start_ns);
+
+    k4a_buffer_result_t result = K4A_BUFFER_RESULT_SUCCEEDED;
+    size_t count = 0;
+    size_t buffer_used = 0;
+    while (read_block != nullptr && read_block->block != nullptr)
+    {
+        uint64_t timestamp_ns = estimate_block_timestamp_ns(read_block);
+        if (timestamp_ns >= end_ns)
+        {
+            break;
+        }
+
+        uint64_t device_timestamp_usec = timestamp_ns / 1000 + context->record_config.start_timestamp_offset_usec;
+        DataBuffer &data_buffer = read_block->block->GetBuffer((unsigned int)read_block->sub_index);
+        if (count == max_block_count || data_buffer.Size() > buffer_size - buffer_used)
+        {
+            // Don't split the blocks of a timestamp, so the caller can continue reading after the last one returned.
+            while (count > 0 && blocks[count - 1].device_timestamp_usec == device_timestamp_usec)
+            {
+                count--;
+                buffer_used = blocks[count].buffer_offset;
+            }
+            result = K4A_BUFFER_RESULT_TOO_SMALL;
+            break;
+        }
+
+        memcpy(buffer + buffer_used, data_buffer.Buffer(), data_buffer.Size());
+        blocks[count].device_timestamp_usec = device_timestamp_usec;
+        blocks[count].buffer_offset = buffer_used;
+        blocks[count].buffer_size = data_buffer.Size();
+        buffer_used += data_buffer.Size();
+        count++;
+
+        read_block = next_block(context, read_block.get(), true);
+    }
+
+    if (read_block == nullptr)
+    {
+        LOG_ERROR("Failed to read data blocks of track %s.", track_reader->track_name.c_str());
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    *block_count = count;
+    return result;
+}
+
+// A part of the range read by process_range(). Each chunk is read by a single worker with its own cursor.
+typedef struct _range_chunk_t
+{
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    std::vector<k4a_capture_t> captures; // Captures waiting to be passed to the callback in order.
+    bool done = false;
+} range_chunk_t;
+
+typedef struct _range_state_t
+{
+    std::vector<range_chunk_t> chunks;
+    size_t next_chunk = 0;       // The next chunk to be read by a worker.
+    size_t delivered_chunks = 0; // The number of chunks passed to the callback in order.
+    size_t max_chunks_ahead = 0; // How far workers may read ahead of the in-order callback.
+    bool failed = false;
+    std::mutex lock; // Locks access to all fields, and to chunks[i].captures once chunks[i].done is set.
+    std::condition_variable condition;
+} range_state_t;
+
+// Reads the captures that start inside a chunk. A capture that starts before the chunk but is returned after the seek
+// belongs to the previous chunk, which reads past its own end until it finds a capture starting in the next chunk.
+static k4a_result_t read_range_chunk(k4a_playback_context_t *context,
+                                     range_state_t *state,
+                                     range_chunk_t *chunk,
+                                     bool in_order,
+                                     k4a_playback_capture_cb_t *callback,
+                                     void *callback_context)
+{
+    playback_cursor_t cursor;
+    k4a_result_t result = TRACE_CALL(
+        seek_timestamp(context, &cursor, (int64_t)(chunk->start_ns / 1000), K4A_PLAYBACK_SEEK_BEGIN));
+
+    while (K4A_SUCCEEDED(result))
+    {
+        if (!in_order)
+        {
+            std::lock_guard<std::mutex> lock(state->lock);
+            if (state->failed)
+            {
+                break;
+            }
+        }
+
+        k4a_capture_t capture = NULL;
+        uint64_t capture_timestamp_ns = 0;
+        k4a_stream_result_t stream_result = get_capture(context, &cursor, &capture, true, &capture_timestamp_ns);
+        if (stream_result == K4A_STREAM_RESULT_FAILED)
+        {
+            LOG_ERROR("Failed to read capture in range starting at %llu ns", chunk->start_ns);
+            result = K4A_RESULT_FAILED;
+        }
+        else if (stream_result == K4A_STREAM_RESULT_EOF || capture_timestamp_ns >= chunk->end_ns)
+        {
+            if (capture != NULL)
+            {
+                k4a_capture_release(capture);
+            }
+            break;
+        }
+        else if (capture_timestamp_ns < chunk->start_ns)
+        {
+            k4a_capture_release(capture);
+        }
+        else if (in_order)
+        {
+            chunk->captures.push_back(capture);
+        }
+        else
+        {
+            result = callback(capture, callback_context);
+            k4a_capture_release(capture);
+        }
+    }
+    return result;
+}
+
+static void range_worker_thread(k4a_playback_context_t *context,
+                                range_state_t *state,
+                                bool in_order,
+                                k4a_playback_capture_cb_t *callback,
+                                void *callback_context)
+{
+    while (true)
+    {
+        range_chunk_t *chunk = NULL;
+        {
+            std::unique_lock<std::mutex> lock(state->lock);
+            state->condition.wait(lock, [state, in_order] {
+                return state->failed || state->next_chunk >= state->chunks.size() || !in_order ||
+                       state->next_chunk < state->delivered_chunks + state->max_chunks_ahead;
+            });
+            if (state->failed || state->next_chunk >= state->chunks.size())
+            {
+                return;
+            }
+            chunk = &state->chunks[state->next_chunk++];
+        }
+
+        k4a_result_t result = read_range_chunk(context, state, chunk, in_order, callback, callback_context);
+        {
+            std::lock_guard<std::mutex> lock(state->lock);
+            chunk->done = true;
+            if (K4A_FAILED(result))
+            {
+                state->failed = true;
+            }
+        }
+        state->condition.notify_all();
+    }
+}
+
+k4a_result_t process_range(k4a_playback_context_t *context,
+                           uint64_t start_ns,
+                           uint64_t end_ns,
+                           uint32_t worker_count,
+                           bool in_order,
+                           k4a_playback_capture_cb_t *callback,
+                           void *callback_context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, worker_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, callback == NULL);
+
+    range_state_t state;
+
+    // Split the range at the start of each cluster. Chunks start on a whole microsecond so they can be seeked to.
+    cluster_info_t *cluster_info = start_ns < end_ns ? find_cluster(context, start_ns) : NULL;
+    uint64_t chunk_start_ns = start_ns;
+    while (cluster_info != NULL && chunk_start_ns < end_ns)
+    {
+        cluster_info_t *next_cluster_info = next_cluster(context, cluster_info, true);
+        uint64_t chunk_end_ns = end_ns;
+        if (next_cluster_info != NULL)
+        {
+            chunk_end_ns = std::min(end_ns, next_cluster_info->timestamp_ns / 1000 * 1000);
+        }
+        if (chunk_end_ns > chunk_start_ns)
+        {
+            range_chunk_t chunk;
+            chunk.start_ns = chunk_start_ns;
+            chunk.end_ns = chunk_end_ns;
+            state.chunks.push_back(std::move(chunk));
+            chunk_start_ns = chunk_end_ns;
+        }
+        cluster_info = next_cluster_info;
+    }
+    if (state.chunks.empty())
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    state.max_chunks_ahead = (size_t)worker_count * 2;
+    worker_count = (uint32_t)std::min((size_t)worker_count, state.chunks.size());
+
+    std::vector<std::thread> workers;
+    try
+    {
+        for (uint32_t i = 0; i < worker_count; i++)
+        {
+            workers.emplace_back(range_worker_thread, context, &state, in_order, callback, callback_context);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start range worker thread: %s", e.what());
+        {
+            std::lock_guard<std::mutex> lock(state.lock);
+            state.failed = true;
+        }
+        state.condition.notify_all();
+    }
+
+    // Captures are passed to the callback in order from this thread, as each chunk is completed.
+    for (size_t i = 0; in_order && i < state.chunks.size() && !workers.empty(); i++)
+    {
+        range_chunk_t &chunk = state.chunks[i];
+        {
+            std::unique_lock<std::mutex> lock(state.lock);
+            state.condition.wait(lock, [&state, &chunk] { return state.failed || chunk.done; });
+            if (state.failed)
+            {
+                break;
+            }
+        }
+
+        k4a_result_t result = K4A_RESULT_SUCCEEDED;
+        for (k4a_capture_t capture : chunk.captures)
+        {
+            if (K4A_SUCCEEDED(result))
+            {
+                result = callback(capture, callback_context);
+            }
+            k4a_capture_release(capture);
+        }
+        chunk.captures.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(state.lock);
+            state.delivered_chunks++;
+            if (K4A_FAILED(result))
+            {
+                state.failed = true;
+            }
+        }
+        state.condition.notify_all();
+    }
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Release any captures that were read after processing stopped.
+    for (range_chunk_t &chunk : state.chunks)
+    {
+        for (k4a_capture_t capture : chunk.captures)
+        {
+            k4a_capture_release(capture);
+        }
+    }
+
+    return state.failed ? K4A_RESULT_FAILED : K4A_RESULT_SUCCEEDED;
+}
+
 } // namespace k4arecord
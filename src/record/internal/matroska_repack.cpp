@@ -0,0 +1,390 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/matroska_read.h>
+#include <k4ainternal/logging.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+using namespace LIBMATROSKA_NAMESPACE;
+
+// A range of a recording is written to a new file by copying its clusters as they are stored, without reading the
+// blocks. Block timestamps are relative to their cluster, so only the timestamp of each cluster and its CRC-32 are
+// rewritten. The new file starts at the first copied cluster, and its K4A_START_OFFSET_NS tag moves by the same amount
+// so that the device timestamps of the copied data don't change.
+
+namespace k4arecord
+{
+// Reads an EBML variable length integer and advances offset past it. Element IDs keep their length marker, element
+// sizes don't. Returns false if the integer doesn't fit in the data.
+static bool read_vint(const uint8_t *data, size_t size, size_t *offset, uint64_t *value, bool keep_marker)
+{
+    if (*offset >= size || data[*offset] == 0)
+    {
+        return false;
+    }
+
+    size_t length = 1;
+    uint8_t marker = 0x80;
+    while ((data[*offset] & marker) == 0)
+    {
+        marker >>= 1;
+        length++;
+    }
+    if (length > size - *offset)
+    {
+        return false;
+    }
+
+    uint64_t result = keep_marker ? data[*offset] : (uint64_t)(data[*offset] & (marker - 1));
+    for (size_t i = 1; i < length; i++)
+    {
+        result = (result << 8) | data[*offset + i];
+    }
+    *offset += length;
+    *value = result;
+    return true;
+}
+
+// Rewrites the timestamp of a rendered cluster in place. The timestamp keeps its encoded width, so the size and layout
+// of the cluster don't change. The CRC-32 of the cluster is updated if it has one.
+static bool rebase_cluster(uint8_t *data, size_t size, uint64_t timecode)
+{
+    size_t offset = 0;
+    uint64_t id = 0;
+    uint64_t element_size = 0;
+    if (!read_vint(data, size, &offset, &id, true) || id != KaxCluster::ClassInfos.GlobalId.GetValue() ||
+        !read_vint(data, size, &offset, &element_size, false))
+    {
+        return false;
+    }
+
+    uint8_t *crc = NULL;
+    size_t checked_start = offset;
+    while (offset < size)
+    {
+        if (!read_vint(data, size, &offset, &id, true) || !read_vint(data, size, &offset, &element_size, false) ||
+            element_size > size - offset)
+        {
+            return false;
+        }
+
+        if (id == EbmlCrc32::ClassInfos.GlobalId.GetValue() && element_size == 4)
+        {
+            crc = data + offset;
+            checked_start = offset + 4;
+        }
+        else if (id == KaxClusterTimecode::ClassInfos.GlobalId.GetValue())
+        {
+            if (element_size == 0 || element_size > 8 || (element_size < 8 && (timecode >> (8 * element_size)) != 0))
+            {
+                return false;
+            }
+            for (size_t i = 0; i < element_size; i++)
+            {
+                data[offset + element_size - 1 - i] = (uint8_t)(timecode >> (8 * i));
+            }
+
+            if (crc != NULL)
+            {
+                // The CRC-32 covers the rest of the cluster, and is stored little endian.
+                EbmlCrc32 checksum;
+                checksum.FillCRC32(data + checked_start, (uint32)(size - checked_start));
+                uint32_t value = checksum.GetCrc32();
+                for (size_t i = 0; i < 4; i++)
+                {
+                    crc[i] = (uint8_t)(value >> (8 * i));
+                }
+            }
+            return true;
+        }
+        offset += (size_t)element_size;
+    }
+    return false;
+}
+
+// Color tracks written with k4a_record_set_color_encoder() can only be decoded from a key frame. Cue entries are only
+// written for key frames, so the copy starts at the cluster of the last Cue entry at or before the range. Must be
+// called with cache_lock held.
+static cluster_info_t *find_key_frame_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    uint64_t key_frame_offset = context->first_cluster_offset;
+    if (context->cues)
+    {
+        KaxCuePoint *cue = NULL;
+        for (EbmlElement *e : context->cues->GetElementList())
+        {
+            if (check_element_type(e, &cue))
+            {
+                const KaxCueTrackPositions *positions = cue->GetSeekPosition();
+                if (positions && positions->ClusterPosition() <= cluster_info->file_offset &&
+                    positions->ClusterPosition() > key_frame_offset)
+                {
+                    key_frame_offset = positions->ClusterPosition();
+                }
+            }
+        }
+    }
+
+    while (cluster_info != NULL && cluster_info->file_offset > key_frame_offset)
+    {
+        cluster_info = next_cluster(context, cluster_info, false);
+    }
+    return cluster_info;
+}
+
+k4a_result_t write_cluster_range(k4a_playback_context_t *context,
+                                 const char *path,
+                                 uint64_t start_timestamp_ns,
+                                 uint64_t end_timestamp_ns)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, start_timestamp_ns > end_timestamp_ns);
+
+    if (strcmp(path, context->file_path) == 0)
+    {
+        LOG_ERROR("A range of recording '%s' can't be written to the recording itself.", path);
+        return K4A_RESULT_FAILED;
+    }
+    if (start_timestamp_ns > context->last_file_timestamp_ns)
+    {
+        LOG_ERROR("The range starts after the end of recording '%s'.", context->file_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<cluster_index_entry_t> clusters;
+    uint64_t end_of_range_ns = context->last_file_timestamp_ns;
+    try
+    {
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+        cluster_info_t *cluster_info = find_cluster(context, start_timestamp_ns);
+        if (cluster_info != NULL && context->color_track != NULL && context->color_track->video_encoded)
+        {
+            cluster_info = find_key_frame_cluster(context, cluster_info);
+        }
+
+        for (; cluster_info != NULL; cluster_info = next_cluster(context, cluster_info, true))
+        {
+            if (cluster_info->cluster_size == 0)
+            {
+                RETURN_IF_ERROR(read_cluster_size(context, cluster_info));
+            }
+            if (cluster_info->timestamp_ns > end_timestamp_ns)
+            {
+                end_of_range_ns = cluster_info->timestamp_ns;
+                break;
+            }
+
+            cluster_index_entry_t entry = {};
+            entry.timestamp_ns = cluster_info->timestamp_ns;
+            entry.file_offset = cluster_info->file_offset;
+            entry.cluster_size = cluster_info->cluster_size;
+            clusters.push_back(entry);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to find the clusters of the range: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    if (clusters.empty())
+    {
+        LOG_ERROR("Failed to find the clusters of the range in recording '%s'.", context->file_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    uint64_t base_timestamp_ns = clusters.front().timestamp_ns;
+    uint64_t base_timecode = base_timestamp_ns / context->timecode_scale;
+    uint64_t cluster_bytes = 0;
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    try
+    {
+        LargeFileIOCallback file(path, MODE_CREATE);
+
+        { // Render Ebml header
+            EbmlHead file_head;
+
+            GetChild<EDocType>(file_head).SetValue("matroska");
+            GetChild<EDocTypeVersion>(file_head).SetValue(2);
+            GetChild<EDocTypeReadVersion>(file_head).SetValue(2);
+
+            file_head.Render(file, true);
+        }
+
+        KaxSegment segment;
+        segment.WriteHead(file, 8);
+
+        EbmlVoid seek_void;
+        seek_void.SetSize(1024);
+        seek_void.Render(file);
+
+        // The metadata of the recording is copied, with the duration and start offset of the range.
+        std::unique_ptr<KaxInfo> segment_info(static_cast<KaxInfo *>(context->segment_info->Clone()));
+        GetChild<KaxDuration>(*segment_info)
+            .SetValue((double)((end_of_range_ns - base_timestamp_ns) / context->timecode_scale));
+        segment_info->Render(file);
+
+        std::unique_ptr<KaxTracks> tracks(static_cast<KaxTracks *>(context->tracks->Clone()));
+        tracks->Render(file);
+
+        std::unique_ptr<KaxAttachments> attachments;
+        if (context->attachments)
+        {
+            attachments.reset(static_cast<KaxAttachments *>(context->attachments->Clone()));
+            attachments->Render(file);
+        }
+
+        std::unique_ptr<KaxTags> tags;
+        if (context->tags)
+        {
+            tags.reset(static_cast<KaxTags *>(context->tags->Clone()));
+
+            KaxTag *tag = NULL;
+            for (EbmlElement *e : tags->GetElementList())
+            {
+                if (check_element_type(e, &tag))
+                {
+                    KaxTagSimple &tag_simple = GetChild<KaxTagSimple>(*tag);
+                    if (GetChild<KaxTagName>(tag_simple).GetValueUTF8() == "K4A_START_OFFSET_NS")
+                    {
+                        uint64_t start_offset_ns = 0;
+                        std::istringstream(get_tag_string(tag)) >> start_offset_ns;
+
+                        std::ostringstream offset_str;
+                        offset_str << start_offset_ns + base_timestamp_ns;
+                        GetChild<KaxTagString>(tag_simple).SetValueUTF8(offset_str.str());
+                    }
+                }
+            }
+            tags->Render(file);
+        }
+
+        // Copy the clusters, and remember where each of them moved for the Cue entries.
+        std::unordered_map<uint64_t, uint64_t> cluster_offsets;
+        std::vector<uint8_t> buffer;
+        for (const cluster_index_entry_t &entry : clusters)
+        {
+            buffer.resize((size_t)entry.cluster_size);
+            {
+                std::lock_guard<std::mutex> io_lock(context->io_lock);
+                if (context->file_closing)
+                {
+                    result = K4A_RESULT_FAILED;
+                    break;
+                }
+
+                LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+                if (file_io != NULL)
+                {
+                    file_io->setOwnerThread();
+                }
+
+                if (K4A_FAILED(seek_offset(context, entry.file_offset)) ||
+                    context->ebml_file->read(buffer.data(), buffer.size()) != buffer.size())
+                {
+                    LOG_ERROR("Failed to read cluster at: %llu", entry.file_offset);
+                    result = K4A_RESULT_FAILED;
+                    break;
+                }
+            }
+
+            uint64_t timecode = entry.timestamp_ns / context->timecode_scale - base_timecode;
+            if (!rebase_cluster(buffer.data(), buffer.size(), timecode))
+            {
+                LOG_ERROR("Failed to rewrite the timestamp of cluster at: %llu", entry.file_offset);
+                result = K4A_RESULT_FAILED;
+                break;
+            }
+
+            cluster_offsets[entry.file_offset] = segment.GetRelativePosition(file.getFilePointer());
+            file.write(buffer.data(), buffer.size());
+            cluster_bytes += buffer.size();
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            KaxCues cues;
+            if (context->cues)
+            {
+                KaxCuePoint *cue = NULL;
+                for (EbmlElement *e : context->cues->GetElementList())
+                {
+                    if (check_element_type(e, &cue))
+                    {
+                        const KaxCueTrackPositions *positions = cue->GetSeekPosition();
+                        auto cluster_offset = positions ? cluster_offsets.find(positions->ClusterPosition()) :
+                                                          cluster_offsets.end();
+                        if (cluster_offset != cluster_offsets.end())
+                        {
+                            KaxCuePoint *new_cue = static_cast<KaxCuePoint *>(cue->Clone());
+                            GetChild<KaxCueTime>(*new_cue).SetValue(GetChild<KaxCueTime>(*cue).GetValue() -
+                                                                    base_timecode);
+                            GetChild<KaxCueClusterPosition>(GetChild<KaxCueTrackPositions>(*new_cue))
+                                .SetValue(cluster_offset->second);
+                            cues.PushElement(*new_cue); // The cue point is freed with cues.
+                        }
+                    }
+                }
+            }
+            if (cues.ListSize() > 0)
+            {
+                cues.Render(file);
+            }
+
+            KaxSeekHead seek_head;
+            seek_head.IndexThis(*segment_info, segment);
+            seek_head.IndexThis(*tracks, segment);
+            if (attachments)
+            {
+                seek_head.IndexThis(*attachments, segment);
+            }
+            if (tags)
+            {
+                seek_head.IndexThis(*tags, segment);
+            }
+            if (cues.ListSize() > 0)
+            {
+                seek_head.IndexThis(cues, segment);
+            }
+            seek_void.ReplaceWith(seek_head, file);
+
+            file.setFilePointer(0, seek_end);
+            uint64 segment_size = file.getFilePointer() - segment.GetElementPosition() - segment.HeadSize();
+            segment.SetSizeInfinite(true);
+            if (!segment.ForceSize(segment_size))
+            {
+                LOG_ERROR("Failed set file segment size.", 0);
+            }
+            segment.OverwriteHead(file);
+        }
+
+        file.close();
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to write recording '%s': %s", path, e.what());
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_FAILED(result))
+    {
+        (void)std::remove(path);
+        return result;
+    }
+
+    // An index next to the new file belongs to a recording that was replaced.
+    (void)std::remove((std::string(path) + CLUSTER_INDEX_EXTENSION).c_str());
+
+    LOG_INFO("Copied %llu clusters (%llu bytes) to '%s'", (uint64_t)clusters.size(), cluster_bytes, path);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+} // namespace k4arecord
@@ -1,15 +1,22 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <sstream>
 
 #include <k4a/k4a.h>
 #include <k4ainternal/matroska_write.h>
 #include <k4ainternal/logging.h>
 
+#include <turbojpeg.h>
+#include <libyuv.h>
+
 using namespace LIBMATROSKA_NAMESPACE;
 
 namespace k4arecord
@@ -56,8 +63,11 @@ uint64_t new_unique_id()
     return result;
 }
 
-k4a_result_t
-populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t height, k4a_image_format_t format)
+k4a_result_t populate_bitmap_info_header(BITMAPINFOHEADER *header,
+                                         uint64_t width,
+                                         uint64_t height,
+                                         k4a_image_format_t format,
+                                         k4a_record_depth_codec_t depth_codec)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, header == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, width > UINT32_MAX);
@@ -91,10 +101,18 @@ populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t h
         break;
     case K4A_IMAGE_FORMAT_DEPTH16:
     case K4A_IMAGE_FORMAT_IR16:
-        // Store depth in b16g format, which is supported by ffmpeg.
         header->biBitCount = 16;
-        header->biCompression = 0x67363162; // b16g (16 bit grayscale, big endian)
-        header->biSizeImage = sizeof(uint8_t) * header->biWidth * header->biHeight * 2;
+        if (depth_codec == K4A_RECORD_DEPTH_CODEC_RVL)
+        {
+            header->biCompression = K4A_RVL_FOURCC;
+            header->biSizeImage = 0; // RVL is variable size
+        }
+        else
+        {
+            // Store depth in b16g format, which is supported by ffmpeg.
+            header->biCompression = 0x67363162; // b16g (16 bit grayscale, big endian)
+            header->biSizeImage = sizeof(uint8_t) * header->biWidth * header->biHeight * 2;
+        }
         break;
     case K4A_IMAGE_FORMAT_COLOR_BGRA32:
         header->biBitCount = 32;
@@ -109,6 +127,142 @@ populate_bitmap_info_header(BITMAPINFOHEADER *header, uint64_t width, uint64_t h
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Updates the codec of a depth or IR track added by k4a_record_create(), before the header is written.
+k4a_result_t set_depth_track_codec(track_header_t *track, k4a_record_depth_codec_t depth_codec)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+
+    KaxCodecPrivate &codec_private = GetChild<KaxCodecPrivate>(*track->track);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_private.GetSize() != sizeof(BITMAPINFOHEADER));
+
+    BITMAPINFOHEADER codec_info = *reinterpret_cast<BITMAPINFOHEADER *>(codec_private.GetBuffer());
+    RETURN_IF_ERROR(populate_bitmap_info_header(&codec_info,
+                                                codec_info.biWidth,
+                                                codec_info.biHeight,
+                                                K4A_IMAGE_FORMAT_DEPTH16,
+                                                depth_codec));
+
+    codec_private.CopyBuffer(reinterpret_cast<uint8_t *>(&codec_info), sizeof(codec_info));
+    track->rvl_encoded = depth_codec == K4A_RECORD_DEPTH_CODEC_RVL;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Stores the layout of the raw frames of the color track, which are compressed when the clusters are written.
+static k4a_result_t set_color_track_layout(track_header_t *track, k4a_image_format_t format)
+{
+    auto &video_track = GetChild<KaxTrackVideo>(*track->track);
+    uint64_t width = GetChild<KaxVideoPixelWidth>(video_track).GetValue();
+    uint64_t height = GetChild<KaxVideoPixelHeight>(video_track).GetValue();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, width == 0 || width > INT32_MAX / 4);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, height == 0 || height > INT32_MAX);
+
+    int stride;
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        stride = (int)width;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        stride = (int)width * 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        stride = (int)width * 4;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        stride = 0;
+        break;
+    default:
+        LOG_ERROR("Unsupported color format for the color track: %d", format);
+        return K4A_RESULT_FAILED;
+    }
+
+    track->encode_format = format;
+    track->encode_width = (int)width;
+    track->encode_height = (int)height;
+    track->encode_stride = stride;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Updates the codec of the color track added by k4a_record_create(), before the header is written.
+k4a_result_t set_color_track_codec(track_header_t *track,
+                                   k4a_image_format_t format,
+                                   k4a_record_color_codec_t color_codec)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+
+    if (track->encode_cb != nullptr)
+    {
+        LOG_ERROR("The color track is compressed by the color encoder.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    bool jpeg_encoded = color_codec == K4A_RECORD_COLOR_CODEC_MJPG && format != K4A_IMAGE_FORMAT_COLOR_MJPG;
+    if (jpeg_encoded && format != K4A_IMAGE_FORMAT_COLOR_NV12 && format != K4A_IMAGE_FORMAT_COLOR_YUY2)
+    {
+        LOG_ERROR("Only NV12 and YUY2 color images can be compressed to MJPG: %d", format);
+        return K4A_RESULT_FAILED;
+    }
+
+    KaxCodecPrivate &codec_private = GetChild<KaxCodecPrivate>(*track->track);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_private.GetSize() != sizeof(BITMAPINFOHEADER));
+
+    BITMAPINFOHEADER codec_info = *reinterpret_cast<BITMAPINFOHEADER *>(codec_private.GetBuffer());
+    RETURN_IF_ERROR(populate_bitmap_info_header(&codec_info,
+                                                codec_info.biWidth,
+                                                codec_info.biHeight,
+                                                jpeg_encoded ? K4A_IMAGE_FORMAT_COLOR_MJPG : format));
+    RETURN_IF_ERROR(set_color_track_layout(track, format));
+
+    codec_private.CopyBuffer(reinterpret_cast<uint8_t *>(&codec_info), sizeof(codec_info));
+    track->jpeg_encoded = jpeg_encoded;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Replaces the codec of the color track added by k4a_record_create(), before the header is written. The raw color
+// frames are compressed by encode_cb when the clusters are written.
+k4a_result_t set_color_track_encoder(track_header_t *track,
+                                     k4a_image_format_t format,
+                                     const char *codec_id,
+                                     const uint8_t *codec_private,
+                                     size_t codec_private_size,
+                                     k4a_record_color_encode_cb_t *encode_cb,
+                                     void *encode_cb_context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_id == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_private == NULL && codec_private_size > 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_private_size > UINT32_MAX);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, encode_cb == NULL);
+    RETURN_IF_ERROR(set_color_track_layout(track, format));
+
+    GetChild<KaxCodecID>(*track->track).SetValue(codec_id);
+    KaxCodecPrivate &track_codec_private = GetChild<KaxCodecPrivate>(*track->track);
+    if (codec_private_size > 0)
+    {
+        track_codec_private.CopyBuffer(codec_private, (uint32)codec_private_size);
+    }
+    else
+    {
+        // The bitmap info header of the raw format doesn't describe the encoded frames.
+        auto &elements = track->track->GetElementList();
+        for (size_t i = 0; i < elements.size(); i++)
+        {
+            if (EbmlId(*elements[i]) == KaxCodecPrivate::ClassInfos.GlobalId)
+            {
+                delete elements[i];
+                elements.erase(elements.begin() + (ptrdiff_t)i);
+                break;
+            }
+        }
+    }
+
+    // The encoder is given the raw frames, which replaces JPEG compression.
+    track->jpeg_encoded = false;
+    track->encode_cb = encode_cb;
+    track->encode_cb_context = encode_cb_context;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 bool validate_name_characters(const char *name)
 {
     const char *ch = name;
@@ -192,31 +346,60 @@ void set_track_info_video(track_header_t *track, uint64_t width, uint64_t height
 // If a failure is returned, the caller will need to free the buffer.
 k4a_result_t
 write_track_data(k4a_record_context_t *context, track_header_t *track, uint64_t timestamp_ns, DataBuffer *buffer)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+
+    return write_track_data_batch(context, track, 1, &timestamp_ns, &buffer);
+}
+
+// Queues several buffers for the same track with a single acquisition of pending_cluster_lock. Each buffer that is
+// queued is set to NULL in the buffers array, the caller will need to free the buffers that are left. A failure is
+// returned if any buffer could not be queued.
+k4a_result_t write_track_data_batch(k4a_record_context_t *context,
+                                    track_header_t *track,
+                                    size_t count,
+                                    const uint64_t *timestamps_ns,
+                                    DataBuffer **buffers)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track->track == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, timestamps_ns == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffers == NULL);
 
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
     try
     {
         std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
 
-        if (context->most_recent_timestamp < timestamp_ns)
+        for (size_t i = 0; i < count; i++)
         {
-            context->most_recent_timestamp = timestamp_ns;
-        }
+            if (buffers[i] == NULL)
+            {
+                result = K4A_RESULT_FAILED;
+                continue;
+            }
 
-        cluster_t *cluster = get_cluster_for_timestamp(context, timestamp_ns);
-        if (cluster == NULL)
-        {
-            // The timestamp is too old, the block of data has already been written.
-            return K4A_RESULT_FAILED;
-        }
+            if (context->most_recent_timestamp < timestamps_ns[i])
+            {
+                context->most_recent_timestamp = timestamps_ns[i];
+            }
+
+            cluster_t *cluster = get_cluster_for_timestamp(context, timestamps_ns[i]);
+            if (cluster == NULL)
+            {
+                // The timestamp is too old, the block of data has already been written.
+                result = K4A_RESULT_FAILED;
+                continue;
+            }
 
-        track_data_t data = { track, buffer };
-        cluster->data.push_back(std::make_pair(timestamp_ns, data));
+            track_data_t data = { track, buffers[i], false, false };
+            cluster->data.push_back(std::make_pair(timestamps_ns[i], data));
+            cluster->data_size += buffers[i]->Size();
+            context->pending_data_size += buffers[i]->Size();
+            buffers[i] = NULL;
+        }
     }
     catch (std::system_error &e)
     {
@@ -229,7 +412,85 @@ write_track_data(k4a_record_context_t *context, track_header_t *track, uint64_t
         context->writer_notify->notify_one();
     }
 
-    return K4A_RESULT_SUCCEEDED;
+    return result;
+}
+
+// DataBuffer of a preview, which holds references to the color and depth images of a capture until the preview is
+// made from them in prepare_clusters(). The buffer is empty until then, see encode_preview_data().
+class PreviewDataBuffer : public DataBuffer
+{
+public:
+    PreviewDataBuffer(k4a_image_t color_image, k4a_image_t depth_image) :
+        DataBuffer(NULL, 0, &PreviewDataBuffer::ReleaseImages, false),
+        m_color_image(color_image),
+        m_depth_image(depth_image)
+    {
+    }
+
+    k4a_image_t color_image() const
+    {
+        return m_color_image;
+    }
+
+    k4a_image_t depth_image() const
+    {
+        return m_depth_image;
+    }
+
+private:
+    static bool ReleaseImages(const DataBuffer &buffer)
+    {
+        const PreviewDataBuffer &preview_buffer = static_cast<const PreviewDataBuffer &>(buffer);
+        if (preview_buffer.m_color_image != NULL)
+        {
+            k4a_image_release(preview_buffer.m_color_image);
+        }
+        if (preview_buffer.m_depth_image != NULL)
+        {
+            k4a_image_release(preview_buffer.m_depth_image);
+        }
+        return true;
+    }
+
+    k4a_image_t m_color_image;
+    k4a_image_t m_depth_image;
+};
+
+// Queues a preview of the color and depth images of a capture, either of which may be NULL. The images are referenced
+// until the preview is made when its cluster is written, so the capture thread only queues the preview.
+k4a_result_t write_preview_data(k4a_record_context_t *context,
+                                track_header_t *track,
+                                uint64_t timestamp_ns,
+                                k4a_image_t color_image,
+                                k4a_image_t depth_image)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !track->preview);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, color_image == NULL && depth_image == NULL);
+
+    DataBuffer *buffer = new (std::nothrow) PreviewDataBuffer(color_image, depth_image);
+    if (buffer == NULL)
+    {
+        LOG_ERROR("Failed to allocate a buffer for the preview.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (color_image != NULL)
+    {
+        k4a_image_reference(color_image);
+    }
+    if (depth_image != NULL)
+    {
+        k4a_image_reference(depth_image);
+    }
+
+    k4a_result_t result = TRACE_CALL(write_track_data(context, track, timestamp_ns, buffer));
+    if (K4A_FAILED(result))
+    {
+        buffer->FreeBuffer(*buffer);
+        delete buffer;
+    }
+    return result;
 }
 
 // Lock(context->pending_cluster_lock) should be active when calling this function
@@ -271,6 +532,7 @@ cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t tim
         cluster_t *new_cluster = new cluster_t;
         new_cluster->time_start_ns = time_start_ns;
         new_cluster->time_end_ns = time_start_ns + MAX_CLUSTER_LENGTH_NS;
+        new_cluster->data_size = 0;
         assert(new_cluster->time_start_ns <= timestamp_ns && new_cluster->time_end_ns > timestamp_ns);
 
         if (selected_cluster == cluster_end)
@@ -296,159 +558,1268 @@ static bool sort_by_pair_asc(const std::pair<uint64_t, track_data_t> &a, const s
     return (a.first < b.first);
 }
 
-// Writes the cluster to disk and frees the cluster.
-// Updated time_end_ns is optionally returned through the argument pointer.
-k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, uint64_t *time_end_ns)
+// Frees a cluster that was not written, along with its data.
+static void free_cluster(cluster_t *cluster)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cluster == NULL);
-
-    if (cluster->data.size() == 0)
+    // The data has not been added to a block yet, so it is freed here.
+    for (std::pair<uint64_t, track_data_t> data : cluster->data)
     {
-        LOG_WARNING("Tried to write empty cluster to disk", 0);
-        delete cluster;
-        return K4A_RESULT_FAILED;
+        data.second.buffer->FreeBuffer(*data.second.buffer);
+        delete data.second.buffer;
     }
+    delete cluster;
+}
 
-    // Sort the data in the cluster by timestamp so it can be written in order
-    std::sort(cluster->data.begin(), cluster->data.end(), sort_by_pair_asc);
-
-    KaxCluster *new_cluster = new KaxCluster();
-
-    // KaxCluster will be freed by libmatroska when the file is closed.
-    context->file_segment->PushElement(*new_cluster);
-
-    cluster->time_start_ns = cluster->data.front().first;
-    if (context->first_cluster_written)
+// Encodes the frames of RVL tracks in place. Returns false if the data couldn't be encoded and is still raw.
+static bool encode_track_data(track_data_t *data, std::unique_ptr<uint8_t[]> &scratch, size_t &scratch_size)
+{
+    DataBuffer *raw_buffer = data->buffer;
+    size_t pixel_count = raw_buffer->Size() / sizeof(uint16_t);
+    size_t max_size = rvl_max_encoded_size(pixel_count);
+    if (scratch_size < max_size)
     {
-        new_cluster->InitTimecode((cluster->time_start_ns - context->start_timestamp_offset) / context->timecode_scale,
-                                  (int64)context->timecode_scale);
+        scratch.reset(new (std::nothrow) uint8_t[max_size]);
+        scratch_size = scratch ? max_size : 0;
     }
-    else
+
+    size_t encoded_size = 0;
+    if (scratch)
     {
-        context->start_timestamp_offset = cluster->time_start_ns;
-        new_cluster->InitTimecode(0, (int64)context->timecode_scale);
-        context->first_cluster_written = true;
+        encoded_size = rvl_encode(reinterpret_cast<uint16_t *>(raw_buffer->Buffer()),
+                                  pixel_count,
+                                  scratch.get(),
+                                  scratch_size);
     }
 
-    if (!context->start_offset_tag_added)
+    DataBuffer *encoded_buffer = NULL;
+    if (encoded_size > 0)
     {
-        std::ostringstream offset_str;
-        offset_str << context->start_timestamp_offset;
-        add_tag(context, "K4A_START_OFFSET_NS", offset_str.str().c_str());
-        context->start_offset_tag_added = true;
+        assert(encoded_size <= UINT32_MAX);
+        encoded_buffer = new (std::nothrow) DataBuffer(scratch.get(), (uint32)encoded_size, NULL, true);
     }
 
-    new_cluster->SetParent(*context->file_segment);
-    new_cluster->EnableChecksum();
-
-    KaxBlockBlob *block_blob = NULL;
-    KaxBlockGroup *block_group = NULL;
-    track_header_t *current_track = NULL;
-    uint64_t block_blob_start = 0;
-
-    std::vector<std::unique_ptr<KaxBlockBlob>> blob_list;
-
-    bool first = true;
-    for (std::pair<uint64_t, track_data_t> data : cluster->data)
+    if (encoded_buffer == NULL)
     {
-        // Only store high frequency data together in a block group, all other tracks store 1 frame per block.
-        if (block_blob == NULL || current_track != data.second.track || !data.second.track->high_freq_data)
-        {
-            // Automatically switching between SimpleBlock and BlockGroup is not implemented in libmatroska,
-            // We need to decide the block type ahead of time to force high frequency data into a BlockGroup
-            block_blob = new KaxBlockBlob(data.second.track->high_freq_data ? BLOCK_BLOB_NO_SIMPLE :
-                                                                              BLOCK_BLOB_ALWAYS_SIMPLE);
-            // BlockBlob needs to be valid until the cluster is rendered.
-            // The blob will be freed at the end of write_cluster().
-            blob_list.emplace_back(block_blob);
-            new_cluster->AddBlockBlob(block_blob);
-            block_blob->SetParent(*new_cluster);
-            block_blob_start = data.first;
-
-            if (!block_blob->IsSimpleBlock())
-            {
-                block_group = new KaxBlockGroup();
-                block_blob->SetBlockGroup(*block_group); // Block group will be freed when BlockBlob is destroyed.
-                block_group->SetParentTrack(*data.second.track->track);
-            }
-            else
-            {
-                block_group = NULL;
-            }
-            current_track = data.second.track;
-        }
+        return false;
+    }
 
-        if (!block_blob->IsSimpleBlock())
-        {
-            // Update the block duration to the last written sample
-            block_group->SetBlockDuration(data.first - block_blob_start + context->timecode_scale);
-        }
+    raw_buffer->FreeBuffer(*raw_buffer);
+    delete raw_buffer;
+    data->buffer = encoded_buffer;
+    data->encoded = true;
+    return true;
+}
 
-        block_blob->AddFrameAuto(*data.second.track->track,
-                                 data.first - context->start_timestamp_offset,
-                                 *data.second.buffer);
+// Compresses a NV12 or YUY2 color frame to JPEG in place. Returns false if the data couldn't be encoded and is still
+// raw. Each encoding thread has its own TurboJPEG compressor, which is created on first use.
+static bool
+encode_jpeg_data(track_data_t *data, tjhandle &jpeg_handle, std::unique_ptr<uint8_t[]> &scratch, size_t &scratch_size)
+{
+    track_header_t *track = data->track;
+    DataBuffer *raw_buffer = data->buffer;
+    bool nv12 = track->encode_format == K4A_IMAGE_FORMAT_COLOR_NV12;
+    int width = track->encode_width;
+    int height = track->encode_height;
+    int stride = track->encode_stride;
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = nv12 ? (height + 1) / 2 : height;
+
+    size_t raw_size = (size_t)stride * (size_t)(nv12 ? height + chroma_height : height);
+    if (raw_buffer->Size() < raw_size)
+    {
+        LOG_ERROR("Color image is smaller than its resolution: %u < %zu", raw_buffer->Size(), raw_size);
+        return false;
+    }
 
-        // Only add one Cue entry once per cluster
-        // We only need to write Cue entries for the first track.
-        if (first && GetChild<KaxTrackNumber>(*data.second.track->track).GetValue() == 1)
+    if (jpeg_handle == NULL)
+    {
+        jpeg_handle = tjInitCompress();
+        if (jpeg_handle == NULL)
         {
-            // Add cue entries at a maximum rate specified by CUE_ENTRY_GAP_NS so that the index doesn't get too large.
-            if (context->last_cues_entry_ns == 0 ||
-                data.first - context->start_timestamp_offset >= context->last_cues_entry_ns + CUE_ENTRY_GAP_NS)
-            {
-                context->last_cues_entry_ns = data.first - context->start_timestamp_offset;
-                auto &cues = GetChild<KaxCues>(*context->file_segment);
-                cues.AddBlockBlob(*block_blob);
-            }
-            first = false;
+            LOG_ERROR("Failed to initialize the jpeg compressor.", 0);
+            return false;
         }
     }
 
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
-
-    auto &cues = GetChild<KaxCues>(*context->file_segment);
-    try
+    // TurboJPEG compresses planar YUV, so the chroma samples are split into U and V planes first. The scratch buffer
+    // holds the planes followed by the JPEG output.
+    int subsamp = nv12 ? TJSAMP_420 : TJSAMP_422;
+    size_t y_size = (size_t)width * (size_t)height;
+    size_t chroma_size = (size_t)chroma_width * (size_t)chroma_height;
+    size_t planes_size = y_size + 2 * chroma_size;
+    unsigned long max_jpeg_size = tjBufSize(width, height, subsamp);
+    if (scratch_size < planes_size + max_jpeg_size)
     {
-        new_cluster->Render(*context->ebml_file, cues);
+        scratch.reset(new (std::nothrow) uint8_t[planes_size + max_jpeg_size]);
+        scratch_size = scratch ? planes_size + max_jpeg_size : 0;
     }
-    catch (std::ios_base::failure &e)
+    if (!scratch)
     {
-        LOG_ERROR("Failed to write recording data '%s': %s", context->file_path, e.what());
-        result = K4A_RESULT_FAILED;
+        return false;
     }
 
-    if (time_end_ns != NULL)
+    uint8_t *planes[3] = { scratch.get(), scratch.get() + y_size, scratch.get() + y_size + chroma_size };
+    int plane_strides[3] = { width, chroma_width, chroma_width };
+    int convert_result;
+    if (nv12)
     {
-        // Cluster data is in the range [time_start_ns, time_end_ns), add 1 ns to the end timestamp.
-        *time_end_ns = cluster->data.back().first + 1;
+        convert_result = libyuv::NV12ToI420(raw_buffer->Buffer(),
+                                            stride,
+                                            raw_buffer->Buffer() + (size_t)stride * (size_t)height,
+                                            stride,
+                                            planes[0],
+                                            plane_strides[0],
+                                            planes[1],
+                                            plane_strides[1],
+                                            planes[2],
+                                            plane_strides[2],
+                                            width,
+                                            height);
+    }
+    else
+    {
+        convert_result = libyuv::YUY2ToI422(raw_buffer->Buffer(),
+                                            stride,
+                                            planes[0],
+                                            plane_strides[0],
+                                            planes[1],
+                                            plane_strides[1],
+                                            planes[2],
+                                            plane_strides[2],
+                                            width,
+                                            height);
+    }
+    if (convert_result != 0)
+    {
+        LOG_ERROR("Failed to convert the color image to planar YUV.", 0);
+        return false;
     }
 
-    // KaxCluster->ReleaseFrames() has a bug and will not free SimpleBlocks, we need to do this ourselves.
-    for (std::pair<uint64_t, track_data_t> data : cluster->data)
+    const uint8_t *source_planes[3] = { planes[0], planes[1], planes[2] };
+    uint8_t *jpeg_buffer = scratch.get() + planes_size;
+    unsigned long jpeg_size = max_jpeg_size;
+    if (tjCompressFromYUVPlanes(jpeg_handle,
+                                source_planes,
+                                width,
+                                plane_strides,
+                                height,
+                                subsamp,
+                                &jpeg_buffer,
+                                &jpeg_size,
+                                COLOR_JPEG_QUALITY,
+                                TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0)
     {
-        data.second.buffer->FreeBuffer(*data.second.buffer);
+        LOG_ERROR("Failed to compress color image to jpeg: %s", tjGetErrorStr());
+        return false;
     }
 
-    // Both KaxCluster and KaxBlockBlob will try to free the same element due to a bug in libmatroska.
-    // In order to prevent this, we need to go through and remove the Block elements from the cluster.
-    auto &elements = new_cluster->GetElementList();
-    for (size_t i = 0; i < elements.size(); i++)
+    assert(jpeg_size <= UINT32_MAX);
+    DataBuffer *encoded_buffer = new (std::nothrow) DataBuffer(jpeg_buffer, (uint32)jpeg_size, NULL, true);
+    if (encoded_buffer == NULL)
     {
-        if (EbmlId(*elements[i]) == KaxBlockGroup::ClassInfos.GlobalId ||
-            EbmlId(*elements[i]) == KaxSimpleBlock::ClassInfos.GlobalId)
-        {
-            // Remove this element from the list.
-            // We don't care about preserving order because the Cluster has already been rendered.
-            elements[i] = elements.back();
-            elements.pop_back();
-            i--;
-        }
+        return false;
     }
 
-    delete cluster;
-    return result;
+    raw_buffer->FreeBuffer(*raw_buffer);
+    delete raw_buffer;
+    data->buffer = encoded_buffer;
+    data->encoded = true;
+    return true;
+}
+
+// Compresses a raw color frame in place with the application's encoder, see k4a_record_set_color_encoder(). Returns
+// false if the encoder failed or skipped the frame, and the data is still raw.
+static bool encode_color_frame(uint64_t timestamp_ns, track_data_t *data)
+{
+    track_header_t *track = data->track;
+    DataBuffer *raw_buffer = data->buffer;
+
+    // The image only wraps the buffer of the cluster, which is freed below.
+    k4a_image_t color_image = NULL;
+    if (K4A_FAILED(TRACE_CALL(k4a_image_create_from_buffer(track->encode_format,
+                                                           track->encode_width,
+                                                           track->encode_height,
+                                                           track->encode_stride,
+                                                           raw_buffer->Buffer(),
+                                                           raw_buffer->Size(),
+                                                           NULL,
+                                                           NULL,
+                                                           &color_image))))
+    {
+        return false;
+    }
+    k4a_image_set_device_timestamp_usec(color_image, timestamp_ns / 1000);
+
+    const uint8_t *encoded_data = NULL;
+    size_t encoded_size = 0;
+    bool key_frame = false;
+    k4a_result_t result = track->encode_cb(color_image,
+                                           &encoded_data,
+                                           &encoded_size,
+                                           &key_frame,
+                                           track->encode_cb_context);
+    k4a_image_release(color_image);
+
+    DataBuffer *encoded_buffer = NULL;
+    if (K4A_SUCCEEDED(result) && encoded_data != NULL && encoded_size > 0 && encoded_size <= UINT32_MAX)
+    {
+        // The encoder owns its output, so it is copied.
+        encoded_buffer = new (std::nothrow)
+            DataBuffer(const_cast<uint8_t *>(encoded_data), (uint32)encoded_size, NULL, true);
+    }
+
+    if (encoded_buffer == NULL)
+    {
+        return false;
+    }
+
+    raw_buffer->FreeBuffer(*raw_buffer);
+    delete raw_buffer;
+    data->buffer = encoded_buffer;
+    data->encoded = true;
+    data->delta_frame = !key_frame;
+    return true;
+}
+
+// Compresses the color frames of a cluster with the application's encoder. Encoded frames can depend on the frames
+// before them, so the frames are encoded one at a time in timestamp order, and frames that fail are dropped.
+static void encode_color_frames(cluster_t *cluster)
+{
+    auto needs_encoding = [](const std::pair<uint64_t, track_data_t> &data) {
+        return data.second.track->encode_cb != nullptr && !data.second.encoded;
+    };
+    if (std::none_of(cluster->data.begin(), cluster->data.end(), needs_encoding))
+    {
+        return;
+    }
+
+    std::sort(cluster->data.begin(), cluster->data.end(), sort_by_pair_asc);
+    for (auto data = cluster->data.begin(); data != cluster->data.end();)
+    {
+        if (!needs_encoding(*data) || encode_color_frame(data->first, &data->second))
+        {
+            data++;
+            continue;
+        }
+
+        LOG_WARNING("Dropped a color frame the color encoder didn't compress at timestamp %llu ns.", data->first);
+        data->second.buffer->FreeBuffer(*data->second.buffer);
+        delete data->second.buffer;
+        data = cluster->data.erase(data);
+    }
+}
+
+// Returns the size of an image dimension reduced by a preview scale, rounded up.
+static int get_preview_size(int size, k4a_color_scale_t scale)
+{
+    int divisor = 1 << (int)scale;
+    return (size + divisor - 1) / divisor;
+}
+
+// Returns the size of a planar YUV 4:2:0 image.
+static size_t get_i420_size(int width, int height)
+{
+    return (size_t)width * (size_t)height + 2 * (size_t)((width + 1) / 2) * (size_t)((height + 1) / 2);
+}
+
+// Scales the color image of a preview to width x height BGRA pixels. MJPG images are decoded straight to the reduced
+// size. NV12 and YUY2 images are scaled in planar YUV, full_yuv and small_yuv hold the image at its full and reduced
+// size, which is less memory than a full size BGRA image.
+static bool scale_preview_color(k4a_image_t image,
+                                tjhandle decompress_handle,
+                                uint8_t *full_yuv,
+                                uint8_t *small_yuv,
+                                uint8_t *bgra,
+                                int width,
+                                int height)
+{
+    k4a_image_format_t format = k4a_image_get_format(image);
+    const uint8_t *buffer = k4a_image_get_buffer(image);
+    size_t buffer_size = k4a_image_get_size(image);
+    int image_width = k4a_image_get_width_pixels(image);
+    int image_height = k4a_image_get_height_pixels(image);
+    int stride = k4a_image_get_stride_bytes(image);
+    int bgra_stride = width * 4;
+
+    if (format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        // TurboJPEG picks the scaling factor from the requested size, which is the image size rounded up by the scale.
+        if (tjDecompress2(decompress_handle,
+                          buffer,
+                          (unsigned long)buffer_size,
+                          bgra,
+                          width,
+                          bgra_stride,
+                          height,
+                          TJPF_BGRA,
+                          TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+        {
+            LOG_ERROR("Failed to decompress the color image of a preview: %s", tjGetErrorStr());
+            return false;
+        }
+        return true;
+    }
+
+    int chroma_height = format == K4A_IMAGE_FORMAT_COLOR_NV12 ? (image_height + 1) / 2 : 0;
+    size_t raw_size = (size_t)stride * (size_t)(image_height + chroma_height);
+    if (buffer_size < raw_size)
+    {
+        LOG_ERROR("Color image is smaller than its resolution: %zu < %zu", buffer_size, raw_size);
+        return false;
+    }
+
+    if (format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        if (libyuv::ARGBScale(buffer,
+                              stride,
+                              image_width,
+                              image_height,
+                              bgra,
+                              bgra_stride,
+                              width,
+                              height,
+                              libyuv::kFilterBox) != 0)
+        {
+            LOG_ERROR("Failed to scale the color image of a preview.", 0);
+            return false;
+        }
+        return true;
+    }
+
+    int full_chroma_width = (image_width + 1) / 2;
+    uint8_t *full_planes[3] = { full_yuv,
+                                full_yuv + (size_t)image_width * (size_t)image_height,
+                                full_yuv + (size_t)image_width * (size_t)image_height +
+                                    (size_t)full_chroma_width * (size_t)((image_height + 1) / 2) };
+    int small_chroma_width = (width + 1) / 2;
+    uint8_t *small_planes[3] = { small_yuv,
+                                 small_yuv + (size_t)width * (size_t)height,
+                                 small_yuv + (size_t)width * (size_t)height +
+                                     (size_t)small_chroma_width * (size_t)((height + 1) / 2) };
+
+    int convert_result;
+    if (format == K4A_IMAGE_FORMAT_COLOR_NV12)
+    {
+        convert_result = libyuv::NV12ToI420(buffer,
+                                            stride,
+                                            buffer + (size_t)stride * (size_t)image_height,
+                                            stride,
+                                            full_planes[0],
+                                            image_width,
+                                            full_planes[1],
+                                            full_chroma_width,
+                                            full_planes[2],
+                                            full_chroma_width,
+                                            image_width,
+                                            image_height);
+    }
+    else
+    {
+        convert_result = libyuv::YUY2ToI420(buffer,
+                                            stride,
+                                            full_planes[0],
+                                            image_width,
+                                            full_planes[1],
+                                            full_chroma_width,
+                                            full_planes[2],
+                                            full_chroma_width,
+                                            image_width,
+                                            image_height);
+    }
+    if (convert_result == 0)
+    {
+        convert_result = libyuv::I420Scale(full_planes[0],
+                                           image_width,
+                                           full_planes[1],
+                                           full_chroma_width,
+                                           full_planes[2],
+                                           full_chroma_width,
+                                           image_width,
+                                           image_height,
+                                           small_planes[0],
+                                           width,
+                                           small_planes[1],
+                                           small_chroma_width,
+                                           small_planes[2],
+                                           small_chroma_width,
+                                           width,
+                                           height,
+                                           libyuv::kFilterBox);
+    }
+    if (convert_result == 0)
+    {
+        convert_result = libyuv::I420ToARGB(small_planes[0],
+                                            width,
+                                            small_planes[1],
+                                            small_chroma_width,
+                                            small_planes[2],
+                                            small_chroma_width,
+                                            bgra,
+                                            bgra_stride,
+                                            width,
+                                            height);
+    }
+    if (convert_result != 0)
+    {
+        LOG_ERROR("Failed to scale the color image of a preview.", 0);
+        return false;
+    }
+    return true;
+}
+
+// Makes a preview in place from the images referenced by its PreviewDataBuffer, see preview_block_header_t. Returns
+// false if the preview couldn't be made. Each encoding thread has its own TurboJPEG compressor and decompressor, which
+// are created on first use.
+static bool encode_preview_data(track_data_t *data,
+                                tjhandle &jpeg_handle,
+                                tjhandle &decompress_handle,
+                                std::unique_ptr<uint8_t[]> &scratch,
+                                size_t &scratch_size)
+{
+    const k4a_record_preview_settings_t &settings = data->track->preview_settings;
+    PreviewDataBuffer *preview_buffer = static_cast<PreviewDataBuffer *>(data->buffer);
+    k4a_image_t color_image = preview_buffer->color_image();
+    k4a_image_t depth_image = preview_buffer->depth_image();
+
+    preview_block_header_t header = {};
+    int color_width = 0;
+    int color_height = 0;
+    bool planar_color = false;
+    if (color_image != NULL)
+    {
+        k4a_image_format_t color_format = k4a_image_get_format(color_image);
+        color_width = k4a_image_get_width_pixels(color_image);
+        color_height = k4a_image_get_height_pixels(color_image);
+        planar_color = color_format == K4A_IMAGE_FORMAT_COLOR_NV12 || color_format == K4A_IMAGE_FORMAT_COLOR_YUY2;
+        if (color_format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+        {
+            if (decompress_handle == NULL)
+            {
+                decompress_handle = tjInitDecompress();
+                if (decompress_handle == NULL)
+                {
+                    LOG_ERROR("Failed to initialize the jpeg decompressor.", 0);
+                    return false;
+                }
+            }
+
+            // The size of the compressed image is read from its header.
+            int subsamp = 0;
+            int colorspace = 0;
+            if (tjDecompressHeader3(decompress_handle,
+                                    k4a_image_get_buffer(color_image),
+                                    (unsigned long)k4a_image_get_size(color_image),
+                                    &color_width,
+                                    &color_height,
+                                    &subsamp,
+                                    &colorspace) != 0)
+            {
+                LOG_ERROR("Failed to read the jpeg header of the color image of a preview: %s", tjGetErrorStr());
+                return false;
+            }
+        }
+        else if (!planar_color && color_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+        {
+            LOG_ERROR("Color images in format %d can't be previewed.", color_format);
+            return false;
+        }
+        header.color_width = (uint32_t)get_preview_size(color_width, settings.scale);
+        header.color_height = (uint32_t)get_preview_size(color_height, settings.scale);
+    }
+
+    if (depth_image != NULL)
+    {
+        if (k4a_image_get_format(depth_image) != K4A_IMAGE_FORMAT_DEPTH16 ||
+            k4a_image_get_size(depth_image) <
+                (size_t)k4a_image_get_stride_bytes(depth_image) * (size_t)k4a_image_get_height_pixels(depth_image))
+        {
+            LOG_ERROR("The depth image of a preview is not a valid DEPTH16 image.", 0);
+            return false;
+        }
+        header.depth_width = (uint32_t)get_preview_size(k4a_image_get_width_pixels(depth_image), settings.scale);
+        header.depth_height = (uint32_t)get_preview_size(k4a_image_get_height_pixels(depth_image), settings.scale);
+    }
+
+    // The scratch buffer holds the color image at each step of the scaling, followed by the preview itself.
+    int preview_width = (int)header.color_width;
+    int preview_height = (int)header.color_height;
+    size_t full_yuv_size = planar_color ? get_i420_size(color_width, color_height) : 0;
+    size_t small_yuv_size = planar_color ? get_i420_size(preview_width, preview_height) : 0;
+    size_t bgra_size = (size_t)preview_width * (size_t)preview_height * 4;
+    unsigned long max_jpeg_size = color_image != NULL ? tjBufSize(preview_width, preview_height, TJSAMP_420) : 0;
+    size_t depth_size = (size_t)header.depth_width * (size_t)header.depth_height;
+    size_t needed_size = full_yuv_size + small_yuv_size + bgra_size + sizeof(header) + max_jpeg_size + depth_size;
+    if (scratch_size < needed_size)
+    {
+        scratch.reset(new (std::nothrow) uint8_t[needed_size]);
+        scratch_size = scratch ? needed_size : 0;
+    }
+    if (!scratch)
+    {
+        return false;
+    }
+
+    uint8_t *full_yuv = scratch.get();
+    uint8_t *small_yuv = full_yuv + full_yuv_size;
+    uint8_t *bgra = small_yuv + small_yuv_size;
+    uint8_t *preview = bgra + bgra_size;
+
+    if (color_image != NULL)
+    {
+        if (jpeg_handle == NULL)
+        {
+            jpeg_handle = tjInitCompress();
+            if (jpeg_handle == NULL)
+            {
+                LOG_ERROR("Failed to initialize the jpeg compressor.", 0);
+                return false;
+            }
+        }
+
+        if (!scale_preview_color(color_image,
+                                 decompress_handle,
+                                 full_yuv,
+                                 small_yuv,
+                                 bgra,
+                                 preview_width,
+                                 preview_height))
+        {
+            return false;
+        }
+
+        uint8_t *jpeg_buffer = preview + sizeof(header);
+        unsigned long jpeg_size = max_jpeg_size;
+        if (tjCompress2(jpeg_handle,
+                        bgra,
+                        preview_width,
+                        preview_width * 4,
+                        preview_height,
+                        TJPF_BGRA,
+                        &jpeg_buffer,
+                        &jpeg_size,
+                        TJSAMP_420,
+                        (int)settings.jpeg_quality,
+                        TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0)
+        {
+            LOG_ERROR("Failed to compress the color image of a preview to jpeg: %s", tjGetErrorStr());
+            return false;
+        }
+        header.color_jpeg_size = (uint32_t)jpeg_size;
+    }
+
+    if (depth_image != NULL)
+    {
+        // Depth is sampled rather than averaged, so invalid pixels don't blend into their neighbors.
+        const uint8_t *depth_buffer = k4a_image_get_buffer(depth_image);
+        size_t depth_stride = (size_t)k4a_image_get_stride_bytes(depth_image);
+        uint32_t divisor = 1u << (int)settings.scale;
+        uint8_t *preview_depth = preview + sizeof(header) + header.color_jpeg_size;
+        for (uint32_t y = 0; y < header.depth_height; y++)
+        {
+            const uint8_t *row_start = depth_buffer + (size_t)(y * divisor) * depth_stride;
+            const uint16_t *row = reinterpret_cast<const uint16_t *>(row_start);
+            for (uint32_t x = 0; x < header.depth_width; x++)
+            {
+                uint32_t depth_mm = row[x * divisor];
+                uint32_t value = 0;
+                if (depth_mm != 0)
+                {
+                    value = std::max(1u, std::min(255u, depth_mm * 255 / settings.max_depth_mm));
+                }
+                preview_depth[(size_t)y * header.depth_width + x] = (uint8_t)value;
+            }
+        }
+    }
+
+    memcpy(preview, &header, sizeof(header));
+    size_t preview_size = sizeof(header) + header.color_jpeg_size + depth_size;
+    assert(preview_size <= UINT32_MAX);
+    DataBuffer *encoded_buffer = new (std::nothrow) DataBuffer(preview, (uint32)preview_size, NULL, true);
+    if (encoded_buffer == NULL)
+    {
+        return false;
+    }
+
+    // Releases the references to the images.
+    preview_buffer->FreeBuffer(*preview_buffer);
+    delete preview_buffer;
+    data->buffer = encoded_buffer;
+    data->encoded = true;
+    return true;
+}
+
+// Removes the previews of a cluster that encode_preview_data() couldn't make. The recording continues without them.
+static void drop_failed_previews(cluster_t *cluster)
+{
+    for (auto data = cluster->data.begin(); data != cluster->data.end();)
+    {
+        if (!data->second.track->preview || data->second.encoded)
+        {
+            data++;
+            continue;
+        }
+
+        LOG_WARNING("Dropped the preview at timestamp %llu ns.", data->first);
+        data->second.buffer->FreeBuffer(*data->second.buffer);
+        delete data->second.buffer;
+        data = cluster->data.erase(data);
+    }
+}
+
+// Does the per frame work of writing the clusters ahead of write_cluster(), which renders them in order. The RVL and
+// JPEG frames of all the clusters are encoded in parallel, so a backlog of clusters is spread over all cores instead of
+// being encoded one cluster at a time by the writer thread.
+k4a_result_t prepare_clusters(const std::vector<cluster_t *> &clusters)
+{
+    std::vector<track_data_t *> frames;
+    for (cluster_t *cluster : clusters)
+    {
+        encode_color_frames(cluster);
+        for (std::pair<uint64_t, track_data_t> &data : cluster->data)
+        {
+            track_header_t *track = data.second.track;
+            if ((track->rvl_encoded || track->jpeg_encoded || track->preview) && !data.second.encoded)
+            {
+                frames.push_back(&data.second);
+            }
+        }
+    }
+
+    if (frames.empty())
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    std::atomic<size_t> next_frame(0);
+    std::atomic<bool> failed(false);
+    auto encode_frames = [&frames, &next_frame, &failed]() {
+        std::unique_ptr<uint8_t[]> scratch;
+        size_t scratch_size = 0;
+        tjhandle jpeg_handle = NULL;
+        tjhandle decompress_handle = NULL;
+        for (size_t i = next_frame++; i < frames.size(); i = next_frame++)
+        {
+            if (frames[i]->track->preview)
+            {
+                // Previews that fail are dropped after the frames are encoded.
+                (void)encode_preview_data(frames[i], jpeg_handle, decompress_handle, scratch, scratch_size);
+                continue;
+            }
+
+            bool encoded = frames[i]->track->jpeg_encoded ?
+                               encode_jpeg_data(frames[i], jpeg_handle, scratch, scratch_size) :
+                               encode_track_data(frames[i], scratch, scratch_size);
+            if (!encoded)
+            {
+                failed = true;
+            }
+        }
+        if (jpeg_handle != NULL)
+        {
+            (void)tjDestroy(jpeg_handle);
+        }
+        if (decompress_handle != NULL)
+        {
+            (void)tjDestroy(decompress_handle);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t thread_count = std::min<size_t>(frames.size(), std::max(1u, std::thread::hardware_concurrency()));
+    try
+    {
+        for (size_t i = 1; i < thread_count; i++)
+        {
+            threads.emplace_back(encode_frames);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        // The frames left over are encoded on this thread.
+        LOG_WARNING("Failed to start frame encoder thread: %s", e.what());
+    }
+
+    encode_frames();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (cluster_t *cluster : clusters)
+    {
+        drop_failed_previews(cluster);
+    }
+
+    if (failed)
+    {
+        LOG_ERROR("Failed to encode RVL or JPEG frames.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void set_file_owner_thread(IOCallback *file)
+{
+    LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(file);
+    UnbufferedFileIOCallback *unbuffered_io = dynamic_cast<UnbufferedFileIOCallback *>(file);
+    if (file_io != NULL)
+    {
+        file_io->setOwnerThread();
+    }
+    else if (unbuffered_io != NULL)
+    {
+        unbuffered_io->setOwnerThread();
+    }
+}
+
+// Writes the segment info, cues, tags and seek head of the current file, and updates the segment size. The file
+// pointer is left at the end of the last cluster so more clusters can be written afterwards.
+k4a_result_t write_file_metadata(k4a_record_context_t *context, uint64_t end_timestamp_ns)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+
+    try
+    {
+        auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
+
+        uint64_t current_position = context->ebml_file->getFilePointer();
+
+        // Update segment info
+        GetChild<KaxDuration>(segment_info)
+            .SetValue((double)((end_timestamp_ns - context->start_timestamp_offset) / context->timecode_scale));
+        context->segment_info_void->ReplaceWith(segment_info, *context->ebml_file);
+
+        // Render cues
+        auto &cues = GetChild<KaxCues>(*context->file_segment);
+        cues.Render(*context->ebml_file);
+
+        // Update tags
+        auto &tags = GetChild<KaxTags>(*context->file_segment);
+        if (tags.GetElementPosition() > 0)
+        {
+            context->ebml_file->setFilePointer((int64_t)tags.GetElementPosition());
+            tags.Render(*context->ebml_file);
+            if (tags.GetEndPosition() != context->tags_void->GetElementPosition())
+            {
+                // Rewrite the void block after tags
+                EbmlVoid tags_void;
+                tags_void.SetSize(context->tags_void->GetSize() -
+                                  (tags.GetEndPosition() - context->tags_void->GetElementPosition()));
+                tags_void.Render(*context->ebml_file);
+            }
+        }
+
+        { // Update seek info
+            auto &seek_head = GetChild<KaxSeekHead>(*context->file_segment);
+            // RemoveAll() has a bug and does not free the elements before emptying the list.
+            for (auto element : seek_head.GetElementList())
+            {
+                delete element;
+            }
+            seek_head.RemoveAll(); // Remove any seek entries from previous flushes
+
+            seek_head.IndexThis(segment_info, *context->file_segment);
+
+            auto &tracks = GetChild<KaxTracks>(*context->file_segment);
+            if (tracks.GetElementPosition() > 0)
+            {
+                seek_head.IndexThis(tracks, *context->file_segment);
+            }
+
+            auto &attachments = GetChild<KaxAttachments>(*context->file_segment);
+            if (attachments.GetElementPosition() > 0)
+            {
+                seek_head.IndexThis(attachments, *context->file_segment);
+            }
+
+            if (tags.GetElementPosition() > 0)
+            {
+                seek_head.IndexThis(tags, *context->file_segment);
+            }
+
+            if (cues.GetElementPosition() > 0)
+            {
+                seek_head.IndexThis(cues, *context->file_segment);
+            }
+
+            context->seek_void->ReplaceWith(seek_head, *context->ebml_file);
+        }
+
+        // Update the file segment head to write the current size
+        context->ebml_file->setFilePointer(0, seek_end);
+        uint64 segment_size = context->ebml_file->getFilePointer() - context->file_segment->GetElementPosition() -
+                              context->file_segment->HeadSize();
+        // Segment size can only be set once normally, so force the flag.
+        context->file_segment->SetSizeInfinite(true);
+        if (!context->file_segment->ForceSize(segment_size))
+        {
+            LOG_ERROR("Failed set file segment size.", 0);
+        }
+        context->file_segment->OverwriteHead(*context->ebml_file);
+
+        // Set the write pointer back in case we're not done recording yet.
+        assert(current_position <= INT64_MAX);
+        context->ebml_file->setFilePointer((int64_t)current_position);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to write recording '%s': %s", context->file_path.c_str(), e.what());
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Returns the path of a file of a segmented recording, the first file is the path given to k4a_record_create()
+static std::string get_segment_file_path(const std::string &path, uint32_t segment_index)
+{
+    if (segment_index == 0)
+    {
+        return path;
+    }
+
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "_%03u", segment_index);
+
+    size_t extension = path.find_last_of('.');
+    size_t separator = path.find_last_of("/\\");
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+    {
+        return path + suffix;
+    }
+    return path.substr(0, extension) + suffix + path.substr(extension);
+}
+
+// Creates the file for the next segment of the recording and writes its header, so that switching files doesn't
+// delay the recording.
+k4a_result_t prepare_next_segment_file(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->header_data.empty());
+
+    if (context->next_file)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    std::string path = get_segment_file_path(context->first_file_path, context->segment_index + 1);
+    try
+    {
+        std::unique_ptr<IOCallback> file;
+        if (dynamic_cast<UnbufferedFileIOCallback *>(context->ebml_file.get()) != NULL)
+        {
+            file = make_unique<UnbufferedFileIOCallback>(path.c_str());
+        }
+        else
+        {
+            file = make_unique<LargeFileIOCallback>(path.c_str(), MODE_CREATE);
+        }
+        file->write(context->header_data.data(), context->header_data.size());
+
+        context->next_file = std::move(file);
+        context->next_file_path = path;
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Unable to create recording file '%s': %s", path.c_str(), e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Closes and deletes the next segment file if the recording ends before it is used.
+void discard_next_segment_file(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    if (context->next_file)
+    {
+        try
+        {
+            context->next_file->close();
+        }
+        catch (std::ios_base::failure &)
+        {
+            // The file is deleted anyway.
+        }
+        context->next_file.reset();
+        (void)std::remove(context->next_file_path.c_str());
+    }
+}
+
+// Location of the first preview of a cluster in the file, filled in once the cluster is rendered.
+typedef struct
+{
+    uint64_t timestamp_ns;
+    uint64_t file_offset;
+    uint64_t size;
+} preview_index_location_t;
+
+// Appends a cluster that was written to the current file to its live index, see k4a_record_set_live_index(). The index
+// is created with the first cluster of each file, and flushed to disk every LIVE_INDEX_FLUSH_GAP_NS of recording. If
+// the index can't be written it is removed, and the recording continues without it.
+static void write_live_index_entry(k4a_record_context_t *context,
+                                   KaxCluster *cluster,
+                                   uint64_t timestamp_ns,
+                                   const preview_index_location_t &preview)
+{
+    cluster_index_entry_t entry = {};
+    entry.timestamp_ns = timestamp_ns;
+    entry.file_offset = context->file_segment->GetRelativePosition(*cluster);
+    entry.cluster_size = cluster->HeadSize() + cluster->GetSize();
+    entry.preview_timestamp_ns = preview.timestamp_ns;
+    entry.preview_offset = preview.file_offset;
+    entry.preview_size = preview.size;
+
+    std::string index_path = context->file_path + CLUSTER_INDEX_EXTENSION;
+    if (!context->live_index_file.is_open())
+    {
+        // The recording size and entry count stay 0 until the file is complete, see close_live_index().
+        cluster_index_header_t header = {};
+        memcpy(header.magic, CLUSTER_INDEX_MAGIC, sizeof(header.magic));
+        header.version = CLUSTER_INDEX_VERSION;
+        header.entry_size = sizeof(cluster_index_entry_t);
+        header.first_cluster_offset = entry.file_offset;
+
+        context->live_index_file.clear();
+        context->live_index_file.open(index_path, std::ios::binary | std::ios::trunc);
+        context->live_index_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        context->live_index_entry_count = 0;
+    }
+
+    context->live_index_file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    context->live_index_entry_count++;
+
+    if (context->live_index_entry_count == 1 || timestamp_ns >= context->live_index_flush_ns + LIVE_INDEX_FLUSH_GAP_NS)
+    {
+        context->live_index_file.flush();
+        context->live_index_flush_ns = timestamp_ns;
+    }
+
+    if (!context->live_index_file)
+    {
+        LOG_WARNING("Failed to write recording index '%s', recording continues without it.", index_path.c_str());
+        context->live_index_file.close();
+        context->live_index = false;
+        (void)std::remove(index_path.c_str());
+    }
+}
+
+// Closes the live index of the current file after the file was closed. If the file is complete, the recording size and
+// entry count are filled in, and the index is used like one written by k4a_playback_write_index(). Otherwise the index
+// stays live and playback checks which of its clusters made it to disk.
+void close_live_index(k4a_record_context_t *context, bool file_complete)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    if (!context->live_index_file.is_open())
+    {
+        return;
+    }
+
+    std::string index_path = context->file_path + CLUSTER_INDEX_EXTENSION;
+    if (file_complete)
+    {
+        std::ifstream recording(context->file_path, std::ios::binary | std::ios::ate);
+        std::streamoff recording_size = recording ? (std::streamoff)recording.tellg() : -1;
+        if (recording_size > 0)
+        {
+            uint64_t size = (uint64_t)recording_size;
+            context->live_index_file.seekp((std::streamoff)offsetof(cluster_index_header_t, recording_size));
+            context->live_index_file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            context->live_index_file.seekp((std::streamoff)offsetof(cluster_index_header_t, entry_count));
+            context->live_index_file.write(reinterpret_cast<const char *>(&context->live_index_entry_count),
+                                           sizeof(context->live_index_entry_count));
+        }
+    }
+
+    context->live_index_file.close();
+    if (!context->live_index_file)
+    {
+        LOG_WARNING("Failed to write recording index '%s'", index_path.c_str());
+    }
+}
+
+// Finishes the current file of a segmented recording and continues the recording in the next file, starting at
+// timestamp_ns. All the state that is specific to a file is reset, the tracks, attachments and tags are kept.
+static k4a_result_t start_next_segment(k4a_record_context_t *context, uint64_t timestamp_ns)
+{
+    RETURN_IF_ERROR(prepare_next_segment_file(context));
+    RETURN_IF_ERROR(write_file_metadata(context, timestamp_ns));
+
+    bool file_complete = true;
+    try
+    {
+        context->ebml_file->close();
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to close recording '%s': %s", context->file_path.c_str(), e.what());
+        file_complete = false;
+    }
+
+    close_live_index(context, file_complete);
+
+    context->ebml_file = std::move(context->next_file);
+    set_file_owner_thread(context->ebml_file.get());
+    context->file_path = context->next_file_path;
+    context->segment_index++;
+
+    // The cue points and clusters of the previous file are no longer needed.
+    auto &cues = GetChild<KaxCues>(*context->file_segment);
+    for (auto element : cues.GetElementList())
+    {
+        delete element;
+    }
+    cues.RemoveAll();
+
+    auto &elements = context->file_segment->GetElementList();
+    auto clusters_end = std::remove_if(elements.begin(), elements.end(), [](EbmlElement *element) {
+        if (EbmlId(*element) == KaxCluster::ClassInfos.GlobalId)
+        {
+            delete element;
+            return true;
+        }
+        return false;
+    });
+    elements.erase(clusters_end, elements.end());
+
+    // The header written to the new file has an unknown segment size, just like the first file.
+    context->file_segment->SetSizeInfinite(true);
+    context->first_cluster_written = false;
+    context->start_offset_tag_added = false;
+    context->last_cues_entry_ns = 0;
+
+    LOG_INFO("Recording continues in '%s'.", context->file_path.c_str());
+
+    // Get the file after this one ready now, if it fails it is tried again when it is needed.
+    (void)TRACE_CALL(prepare_next_segment_file(context));
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Writes the cluster to disk and frees the cluster.
+// Updated time_end_ns is optionally returned through the argument pointer.
+k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, uint64_t *time_end_ns)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cluster == NULL);
+
+    if (cluster->data.size() == 0)
+    {
+        LOG_WARNING("Tried to write empty cluster to disk", 0);
+        delete cluster;
+        return K4A_RESULT_FAILED;
+    }
+
+    // Clusters are usually prepared in a batch by the caller already, this only encodes what is left.
+    if (K4A_FAILED(TRACE_CALL(prepare_clusters({ cluster }))))
+    {
+        free_cluster(cluster);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (cluster->data.empty())
+    {
+        // Every frame was dropped by the color encoder.
+        delete cluster;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    // Sort the data in the cluster by timestamp so it can be written in order
+    std::sort(cluster->data.begin(), cluster->data.end(), sort_by_pair_asc);
+
+    // Segmented recordings switch files between clusters, so no data is lost. If the next file can't be started, the
+    // recording continues in the current file.
+    if (context->first_cluster_written && !context->header_data.empty())
+    {
+        uint64_t file_duration = cluster->data.front().first - context->start_timestamp_offset;
+        if ((context->segment_max_duration_ns != 0 && file_duration >= context->segment_max_duration_ns) ||
+            (context->segment_max_size != 0 && context->ebml_file->getFilePointer() >= context->segment_max_size))
+        {
+            (void)TRACE_CALL(start_next_segment(context, cluster->data.front().first));
+        }
+    }
+
+    KaxCluster *new_cluster = new KaxCluster();
+
+    // KaxCluster will be freed by libmatroska when the file is closed.
+    context->file_segment->PushElement(*new_cluster);
+
+    cluster->time_start_ns = cluster->data.front().first;
+    if (context->first_cluster_written)
+    {
+        new_cluster->InitTimecode((cluster->time_start_ns - context->start_timestamp_offset) / context->timecode_scale,
+                                  (int64)context->timecode_scale);
+    }
+    else
+    {
+        context->start_timestamp_offset = cluster->time_start_ns;
+        new_cluster->InitTimecode(0, (int64)context->timecode_scale);
+        context->first_cluster_written = true;
+    }
+
+    if (!context->start_offset_tag_added)
+    {
+        std::ostringstream offset_str;
+        offset_str << context->start_timestamp_offset;
+        if (context->start_offset_tag == NULL)
+        {
+            context->start_offset_tag = add_tag(context, "K4A_START_OFFSET_NS", offset_str.str().c_str());
+        }
+        else
+        {
+            // Each file of a segmented recording has its own start offset.
+            auto &tag_simple = GetChild<KaxTagSimple>(*context->start_offset_tag);
+            GetChild<KaxTagString>(tag_simple).SetValueUTF8(offset_str.str());
+        }
+        context->start_offset_tag_added = true;
+    }
+
+    new_cluster->SetParent(*context->file_segment);
+    new_cluster->EnableChecksum();
+
+    KaxBlockBlob *block_blob = NULL;
+    KaxBlockGroup *block_group = NULL;
+    track_header_t *current_track = NULL;
+    uint64_t block_blob_start = 0;
+
+    std::vector<std::unique_ptr<KaxBlockBlob>> blob_list;
+
+    // The first preview of the cluster goes in the live index, see write_live_index_entry().
+    KaxBlockBlob *preview_blob = NULL;
+    preview_index_location_t preview = {};
+
+    bool first = true;
+    for (std::pair<uint64_t, track_data_t> data : cluster->data)
+    {
+        // Only store high frequency data together in a block group, all other tracks store 1 frame per block.
+        if (block_blob == NULL || current_track != data.second.track || !data.second.track->high_freq_data)
+        {
+            // Automatically switching between SimpleBlock and BlockGroup is not implemented in libmatroska,
+            // We need to decide the block type ahead of time to force high frequency data into a BlockGroup
+            block_blob = new KaxBlockBlob(data.second.track->high_freq_data ? BLOCK_BLOB_NO_SIMPLE :
+                                                                              BLOCK_BLOB_ALWAYS_SIMPLE);
+            // BlockBlob needs to be valid until the cluster is rendered.
+            // The blob will be freed at the end of write_cluster().
+            blob_list.emplace_back(block_blob);
+            new_cluster->AddBlockBlob(block_blob);
+            block_blob->SetParent(*new_cluster);
+            block_blob_start = data.first;
+
+            if (!block_blob->IsSimpleBlock())
+            {
+                block_group = new KaxBlockGroup();
+                block_blob->SetBlockGroup(*block_group); // Block group will be freed when BlockBlob is destroyed.
+                block_group->SetParentTrack(*data.second.track->track);
+            }
+            else
+            {
+                block_group = NULL;
+            }
+            current_track = data.second.track;
+        }
+
+        if (!block_blob->IsSimpleBlock())
+        {
+            // Update the block duration to the last written sample
+            block_group->SetBlockDuration(data.first - block_blob_start + context->timecode_scale);
+        }
+
+        block_blob->AddFrameAuto(*data.second.track->track,
+                                 data.first - context->start_timestamp_offset,
+                                 *data.second.buffer);
+        if (data.second.delta_frame && block_blob->IsSimpleBlock())
+        {
+            static_cast<KaxSimpleBlock &>(*block_blob).SetKeyframe(false);
+        }
+
+        if (data.second.track->preview && preview_blob == NULL)
+        {
+            // Previews are never laced, each one is alone in a SimpleBlock.
+            preview_blob = block_blob;
+            preview.timestamp_ns = ((data.first - context->start_timestamp_offset) / context->timecode_scale) *
+                                   context->timecode_scale;
+            preview.size = data.second.buffer->Size();
+        }
+
+        // Only add one Cue entry once per cluster
+        // We only need to write Cue entries for the first track.
+        if (first && GetChild<KaxTrackNumber>(*data.second.track->track).GetValue() == 1)
+        {
+            // Add cue entries at a maximum rate specified by CUE_ENTRY_GAP_NS so that the index doesn't get too large.
+            // Encoded color frames that depend on the frames before them can't be seeked to.
+            if (!data.second.delta_frame &&
+                (context->last_cues_entry_ns == 0 ||
+                 data.first - context->start_timestamp_offset >= context->last_cues_entry_ns + CUE_ENTRY_GAP_NS))
+            {
+                context->last_cues_entry_ns = data.first - context->start_timestamp_offset;
+                auto &cues = GetChild<KaxCues>(*context->file_segment);
+                cues.AddBlockBlob(*block_blob);
+            }
+            first = false;
+        }
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    auto &cues = GetChild<KaxCues>(*context->file_segment);
+    try
+    {
+        new_cluster->Render(*context->ebml_file, cues);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to write recording data '%s': %s", context->file_path.c_str(), e.what());
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result) && context->live_index)
+    {
+        // Playback reads the cluster timestamp in whole timecode units.
+        uint64_t timecode = (cluster->time_start_ns - context->start_timestamp_offset) / context->timecode_scale;
+        if (preview_blob != NULL)
+        {
+            // The frame data is at the end of the rendered SimpleBlock, after the block header.
+            KaxSimpleBlock &preview_block = static_cast<KaxSimpleBlock &>(*preview_blob);
+            uint64_t data_position = preview_block.GetElementPosition() + preview_block.HeadSize() +
+                                     preview_block.GetSize() - preview.size;
+            preview.file_offset = context->file_segment->GetRelativePosition(data_position);
+        }
+        write_live_index_entry(context, new_cluster, timecode * context->timecode_scale, preview);
+    }
+
+    if (time_end_ns != NULL)
+    {
+        // Cluster data is in the range [time_start_ns, time_end_ns), add 1 ns to the end timestamp.
+        *time_end_ns = cluster->data.back().first + 1;
+    }
+
+    // KaxCluster->ReleaseFrames() has a bug and will not free SimpleBlocks, we need to do this ourselves.
+    for (std::pair<uint64_t, track_data_t> data : cluster->data)
+    {
+        data.second.buffer->FreeBuffer(*data.second.buffer);
+    }
+
+    // Both KaxCluster and KaxBlockBlob will try to free the same element due to a bug in libmatroska.
+    // In order to prevent this, we need to go through and remove the Block elements from the cluster.
+    auto &elements = new_cluster->GetElementList();
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        if (EbmlId(*elements[i]) == KaxBlockGroup::ClassInfos.GlobalId ||
+            EbmlId(*elements[i]) == KaxSimpleBlock::ClassInfos.GlobalId)
+        {
+            // Remove this element from the list.
+            // We don't care about preserving order because the Cluster has already been rendered.
+            elements[i] = elements.back();
+            elements.pop_back();
+            i--;
+        }
+    }
+
+    delete cluster;
+    return result;
 }
 
 static void matroska_writer_thread(k4a_record_context_t *context)
@@ -459,60 +1830,84 @@ static void matroska_writer_thread(k4a_record_context_t *context)
     {
         std::unique_lock<std::mutex> lock(context->writer_lock);
 
-        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
-        if (file_io != NULL)
-        {
-            file_io->setOwnerThread();
-        }
+        set_file_owner_thread(context->ebml_file.get());
 
         while (!context->writer_stopping)
         {
             context->pending_cluster_lock.lock();
 
-            // Check the oldest pending cluster to see if we should write to disk.
-            cluster_t *oldest_cluster = NULL;
-            if (!context->pending_clusters.empty())
+            // Take all the pending clusters that are old enough to be written to disk. If the write queue is over its
+            // limit, complete clusters are written right away, without waiting for late data.
+            std::vector<cluster_t *> ready_clusters;
+            size_t ready_data_size = 0;
+            while (!context->pending_clusters.empty())
             {
-                oldest_cluster = context->pending_clusters.front();
-                if (context->most_recent_timestamp >= oldest_cluster->time_end_ns)
+                cluster_t *oldest_cluster = context->pending_clusters.front();
+                if (context->most_recent_timestamp < oldest_cluster->time_end_ns)
                 {
-                    uint64_t age = context->most_recent_timestamp - oldest_cluster->time_end_ns;
-                    if (age > CLUSTER_WRITE_DELAY_NS)
-                    {
-                        assert(oldest_cluster->time_start_ns >= context->last_written_timestamp);
-                        context->pending_clusters.pop_front();
-                        context->last_written_timestamp = oldest_cluster->time_end_ns;
-                        if (age > CLUSTER_WRITE_QUEUE_WARNING_NS)
-                        {
-                            LOG_ERROR("Disk write speed is too low, write queue is filling up.", 0);
-                        }
-                    }
-                    else
-                    {
-                        oldest_cluster = NULL;
-                    }
+                    break;
                 }
-                else
+
+                uint64_t age = context->most_recent_timestamp - oldest_cluster->time_end_ns;
+                bool queue_full = context->write_queue_limit != 0 &&
+                                  context->pending_data_size - ready_data_size + context->blocked_data_size >
+                                      context->write_queue_limit;
+                if (age <= CLUSTER_WRITE_DELAY_NS && !queue_full)
+                {
+                    break;
+                }
+
+                assert(oldest_cluster->time_start_ns >= context->last_written_timestamp);
+                context->pending_clusters.pop_front();
+                context->last_written_timestamp = oldest_cluster->time_end_ns;
+                if (age > CLUSTER_WRITE_QUEUE_WARNING_NS)
                 {
-                    oldest_cluster = NULL;
+                    LOG_ERROR("Disk write speed is too low, write queue is filling up.", 0);
                 }
+                ready_clusters.push_back(oldest_cluster);
+                ready_data_size += oldest_cluster->data_size;
             }
+            context->writing_data_size = ready_data_size;
 
             context->pending_cluster_lock.unlock();
 
-            if (oldest_cluster)
+            // The clusters are encoded in parallel, and then written to the file in order by this thread.
+            k4a_result_t result = K4A_RESULT_SUCCEEDED;
+            if (!ready_clusters.empty())
             {
-                k4a_result_t result = TRACE_CALL(write_cluster(context, oldest_cluster));
-                if (K4A_FAILED(result))
+                result = TRACE_CALL(prepare_clusters(ready_clusters));
+            }
+
+            for (cluster_t *cluster : ready_clusters)
+            {
+                if (K4A_SUCCEEDED(result))
                 {
-                    // write_cluster failures are not recoverable (file IO errors only, the file is likely corrupt)
-                    LOG_ERROR("Cluster write failed, writer thread exiting.", 0);
-                    break;
+                    result = TRACE_CALL(write_cluster(context, cluster));
                 }
+                else
+                {
+                    free_cluster(cluster);
+                }
+            }
+
+            if (!ready_clusters.empty())
+            {
+                std::lock_guard<std::mutex> cluster_lock(context->pending_cluster_lock);
+                context->pending_data_size -= ready_data_size;
+                context->writing_data_size = 0;
+                context->writer_failed = K4A_FAILED(result);
+                context->write_queue_notify->notify_all();
+            }
+
+            if (K4A_FAILED(result))
+            {
+                // write_cluster failures are not recoverable (file IO errors only, the file is likely corrupt)
+                LOG_ERROR("Cluster write failed, writer thread exiting.", 0);
+                break;
             }
 
             // Wait until more clusters arrive up to 100ms, or 1ms if the queue is not empty.
-            context->writer_notify->wait_for(lock, std::chrono::milliseconds(oldest_cluster ? 1 : 100));
+            context->writer_notify->wait_for(lock, std::chrono::milliseconds(ready_clusters.empty() ? 100 : 1));
 
             if (file_io != NULL)
             {
@@ -523,7 +1918,43 @@ static void matroska_writer_thread(k4a_record_context_t *context)
     catch (std::system_error &e)
     {
         LOG_ERROR("Writer thread threw exception: %s", e.what());
+
+        std::lock_guard<std::mutex> cluster_lock(context->pending_cluster_lock);
+        context->writer_failed = true;
+        context->write_queue_notify->notify_all();
+    }
+}
+
+// Returns true if size bytes of data fit in the write queue, see k4a_record_set_write_queue_limit(). With
+// K4A_RECORD_WRITE_QUEUE_BLOCK this waits for the writer thread to make room, and then always returns true. It stops
+// waiting when the writer thread has no complete clusters left to write, since it can't drain the queue any further.
+bool wait_for_write_queue(k4a_record_context_t *context, size_t size)
+{
+    RETURN_VALUE_IF_ARG(false, context == NULL);
+
+    std::unique_lock<std::mutex> lock(context->pending_cluster_lock);
+    while (context->write_queue_limit != 0 && context->pending_data_size + size > context->write_queue_limit)
+    {
+        if (context->write_queue_policy != K4A_RECORD_WRITE_QUEUE_BLOCK)
+        {
+            return false;
+        }
+
+        bool writable = context->writing_data_size > 0 ||
+                        (!context->pending_clusters.empty() &&
+                         context->pending_clusters.front()->time_end_ns <= context->most_recent_timestamp);
+        if (!writable || context->writer_failed || context->writer_stopping || !context->write_queue_notify)
+        {
+            break;
+        }
+
+        // Wake the writer thread up so it writes the complete clusters right away.
+        context->blocked_data_size += size;
+        context->writer_notify->notify_one();
+        context->write_queue_notify->wait(lock);
+        context->blocked_data_size -= size;
     }
+    return true;
 }
 
 k4a_result_t start_matroska_writer_thread(k4a_record_context_t *context)
@@ -534,6 +1965,7 @@ k4a_result_t start_matroska_writer_thread(k4a_record_context_t *context)
     try
     {
         context->writer_notify.reset(new std::condition_variable());
+        context->write_queue_notify.reset(new std::condition_variable());
 
         context->writer_stopping = false;
         context->writer_thread = std::thread(matroska_writer_thread, context);
@@ -555,7 +1987,11 @@ void stop_matroska_writer_thread(k4a_record_context_t *context)
 
     try
     {
-        context->writer_stopping = true;
+        {
+            std::lock_guard<std::mutex> cluster_lock(context->pending_cluster_lock);
+            context->writer_stopping = true;
+            context->write_queue_notify->notify_all();
+        }
         context->writer_notify->notify_one();
         context->writer_thread.join();
     }
@@ -0,0 +1,226 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/matroska_common.h>
+#include <k4ainternal/logging.h>
+
+#include <algorithm>
+
+// RVL (Run length encoding and Variable Length encoding) lossless depth compression, from "Fast Lossless Depth Image
+// Compression" by Andrew D. Wilson. The image is split in alternating runs of zero and non-zero pixels. Each run length
+// is written as a variable length integer, followed by the zigzag encoded delta of each non-zero pixel from the
+// previous non-zero pixel. Variable length integers are written in nibbles, 3 bits of value and a continuation bit.
+//
+// The encoded stream starts with the pixel count as a 32-bit little-endian integer, followed by the nibbles packed 2 per
+// byte, high nibble first.
+
+namespace k4arecord
+{
+static const size_t RVL_HEADER_SIZE = sizeof(uint32_t);
+
+namespace
+{
+class nibble_writer
+{
+public:
+    nibble_writer(uint8_t *output, size_t output_size) : m_output(output), m_end(output + output_size) {}
+
+    bool write_vle(uint32_t value)
+    {
+        do
+        {
+            uint8_t nibble = value & 0x7;
+            value >>= 3;
+            if (value != 0)
+            {
+                nibble |= 0x8;
+            }
+
+            if (m_high)
+            {
+                if (m_output == m_end)
+                {
+                    return false;
+                }
+                *m_output = (uint8_t)(nibble << 4);
+            }
+            else
+            {
+                *m_output++ |= nibble;
+            }
+            m_high = !m_high;
+        } while (value != 0);
+        return true;
+    }
+
+    uint8_t *end()
+    {
+        // A partially written byte is kept, its low nibble is padding.
+        return m_high ? m_output : m_output + 1;
+    }
+
+private:
+    uint8_t *m_output;
+    uint8_t *m_end;
+    bool m_high = true;
+};
+
+class nibble_reader
+{
+public:
+    nibble_reader(const uint8_t *input, size_t input_size) : m_input(input), m_end(input + input_size) {}
+
+    bool read_vle(uint32_t *value)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 3)
+        {
+            if (m_input == m_end)
+            {
+                return false;
+            }
+
+            uint8_t nibble;
+            if (m_high)
+            {
+                nibble = *m_input >> 4;
+            }
+            else
+            {
+                nibble = *m_input++ & 0xF;
+            }
+            m_high = !m_high;
+
+            result |= (uint32_t)(nibble & 0x7) << shift;
+            if ((nibble & 0x8) == 0)
+            {
+                *value = result;
+                return true;
+            }
+        }
+
+        // Values written by the encoder never have more than 11 nibbles
+        return false;
+    }
+
+private:
+    const uint8_t *m_input;
+    const uint8_t *m_end;
+    bool m_high = true;
+};
+} // namespace
+
+size_t rvl_max_encoded_size(size_t pixel_count)
+{
+    // Each non-zero pixel takes at most 6 nibbles for its delta. Budgeting 8 nibbles per pixel leaves room for the
+    // lengths of every pair of runs, the extra bytes cover a leading empty zero run and the padding.
+    return RVL_HEADER_SIZE + pixel_count * 4 + 16;
+}
+
+size_t rvl_encode(const uint16_t *input, size_t pixel_count, uint8_t *output, size_t output_size)
+{
+    RETURN_VALUE_IF_ARG(0, input == NULL);
+    RETURN_VALUE_IF_ARG(0, output == NULL);
+    RETURN_VALUE_IF_ARG(0, pixel_count > UINT32_MAX);
+    RETURN_VALUE_IF_ARG(0, output_size < RVL_HEADER_SIZE);
+
+    for (size_t i = 0; i < RVL_HEADER_SIZE; i++)
+    {
+        output[i] = (uint8_t)(pixel_count >> (i * 8));
+    }
+
+    nibble_writer writer(output + RVL_HEADER_SIZE, output_size - RVL_HEADER_SIZE);
+    const uint16_t *end = input + pixel_count;
+    int32_t previous = 0;
+    while (input != end)
+    {
+        const uint16_t *run_start = input;
+        while (input != end && *input == 0)
+        {
+            input++;
+        }
+        if (!writer.write_vle((uint32_t)(input - run_start)))
+        {
+            return 0;
+        }
+
+        run_start = input;
+        while (input != end && *input != 0)
+        {
+            input++;
+        }
+        if (!writer.write_vle((uint32_t)(input - run_start)))
+        {
+            return 0;
+        }
+
+        for (const uint16_t *pixel = run_start; pixel != input; pixel++)
+        {
+            int32_t delta = (int32_t)*pixel - previous;
+            previous = *pixel;
+            if (!writer.write_vle(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31)))
+            {
+                return 0;
+            }
+        }
+    }
+
+    return (size_t)(writer.end() - output);
+}
+
+size_t rvl_get_pixel_count(const uint8_t *input, size_t input_size)
+{
+    RETURN_VALUE_IF_ARG(0, input == NULL);
+    RETURN_VALUE_IF_ARG(0, input_size < RVL_HEADER_SIZE);
+
+    size_t pixel_count = 0;
+    for (size_t i = 0; i < RVL_HEADER_SIZE; i++)
+    {
+        pixel_count |= (size_t)input[i] << (i * 8);
+    }
+    return pixel_count;
+}
+
+k4a_result_t rvl_decode(const uint8_t *input, size_t input_size, uint16_t *output, size_t pixel_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, input == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, input_size < RVL_HEADER_SIZE);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, output == NULL && pixel_count > 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, rvl_get_pixel_count(input, input_size) != pixel_count);
+
+    nibble_reader reader(input + RVL_HEADER_SIZE, input_size - RVL_HEADER_SIZE);
+    uint16_t *end = output + pixel_count;
+    int32_t previous = 0;
+    while (output != end)
+    {
+        uint32_t zeros = 0, non_zeros = 0;
+        if (!reader.read_vle(&zeros) || zeros > (size_t)(end - output))
+        {
+            LOG_ERROR("Invalid RVL zero run length.", 0);
+            return K4A_RESULT_FAILED;
+        }
+        std::fill(output, output + zeros, (uint16_t)0);
+        output += zeros;
+
+        if (!reader.read_vle(&non_zeros) || non_zeros > (size_t)(end - output))
+        {
+            LOG_ERROR("Invalid RVL run length.", 0);
+            return K4A_RESULT_FAILED;
+        }
+        for (uint32_t i = 0; i < non_zeros; i++)
+        {
+            uint32_t encoded_delta = 0;
+            if (!reader.read_vle(&encoded_delta))
+            {
+                LOG_ERROR("RVL stream is truncated.", 0);
+                return K4A_RESULT_FAILED;
+            }
+            previous += (int32_t)(encoded_delta >> 1) ^ -(int32_t)(encoded_delta & 1);
+            *output++ = (uint16_t)previous;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+} // namespace k4arecord
@@ -0,0 +1,650 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/matroska_write.h>
+#include <k4ainternal/logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+using namespace k4arecord;
+
+static uint64_t align_down(uint64_t value)
+{
+    return value - value % UNBUFFERED_IO_ALIGNMENT;
+}
+
+static uint64_t align_up(uint64_t value)
+{
+    return align_down(value + UNBUFFERED_IO_ALIGNMENT - 1);
+}
+
+namespace
+{
+// A write-behind buffer, and the write of the range [begin, begin + size) of it to the file at offset
+struct write_slot_t
+{
+    uint8_t *buffer = nullptr;
+    bool in_flight = false;
+    size_t begin = 0;
+    size_t size = 0;
+    uint64_t offset = 0;
+#ifdef _WIN32
+    OVERLAPPED overlapped = {};
+#else
+    int error = 0;
+#endif
+};
+} // namespace
+
+#ifdef _WIN32
+
+struct UnbufferedFileIOCallback::io_queue_t
+{
+    write_slot_t slots[UNBUFFERED_IO_QUEUE_DEPTH];
+
+    ~io_queue_t()
+    {
+        for (write_slot_t &slot : slots)
+        {
+            _aligned_free(slot.buffer);
+            if (slot.overlapped.hEvent != NULL)
+            {
+                CloseHandle(slot.overlapped.hEvent);
+            }
+        }
+    }
+};
+
+static std::ios_base::failure last_error(const char *message, DWORD error = GetLastError())
+{
+    return std::ios_base::failure(message, std::error_code((int)error, std::system_category()));
+}
+
+static void set_offset(OVERLAPPED *overlapped, uint64_t offset)
+{
+    overlapped->Offset = (DWORD)offset;
+    overlapped->OffsetHigh = (DWORD)(offset >> 32);
+}
+
+UnbufferedFileIOCallback::UnbufferedFileIOCallback(const char *path) :
+    m_queue(new io_queue_t()),
+    m_owner(std::this_thread::get_id())
+{
+    assert(path);
+
+    for (write_slot_t &slot : m_queue->slots)
+    {
+        slot.buffer = (uint8_t *)_aligned_malloc(UNBUFFERED_IO_BUFFER_SIZE, UNBUFFERED_IO_ALIGNMENT);
+        slot.overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (slot.buffer == nullptr || slot.overlapped.hEvent == NULL)
+        {
+            throw std::ios_base::failure("Failed to allocate the file buffers");
+        }
+    }
+    m_buffer = m_queue->slots[m_current].buffer;
+
+    m_file = CreateFileA(path,
+                         GENERIC_READ | GENERIC_WRITE,
+                         FILE_SHARE_READ,
+                         NULL,
+                         CREATE_ALWAYS,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED,
+                         NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        throw last_error("Failed to create file");
+    }
+}
+
+static size_t read_at(HANDLE file, uint8_t *buffer, size_t size, uint64_t offset)
+{
+    OVERLAPPED overlapped = {};
+    set_offset(&overlapped, offset);
+    overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (overlapped.hEvent == NULL)
+    {
+        throw last_error("Failed to read file");
+    }
+
+    DWORD bytes_read = 0;
+    BOOL success = ReadFile(file, buffer, (DWORD)size, NULL, &overlapped);
+    if (success || GetLastError() == ERROR_IO_PENDING)
+    {
+        success = GetOverlappedResult(file, &overlapped, &bytes_read, TRUE);
+    }
+    DWORD error = GetLastError();
+    CloseHandle(overlapped.hEvent);
+
+    if (!success && error != ERROR_HANDLE_EOF)
+    {
+        throw last_error("Failed to read file", error);
+    }
+    return bytes_read;
+}
+
+void UnbufferedFileIOCallback::submit_write(size_t index, size_t begin, size_t end)
+{
+    write_slot_t &slot = m_queue->slots[index];
+    assert(!slot.in_flight);
+
+    slot.begin = begin;
+    slot.size = end - begin;
+    slot.offset = m_window_start + begin;
+    set_offset(&slot.overlapped, slot.offset);
+    if (!WriteFile(m_file, slot.buffer + slot.begin, (DWORD)slot.size, NULL, &slot.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        throw last_error("Failed to write file");
+    }
+    slot.in_flight = true;
+}
+
+void UnbufferedFileIOCallback::wait_write(size_t index)
+{
+    write_slot_t &slot = m_queue->slots[index];
+    if (slot.in_flight)
+    {
+        DWORD bytes_written = 0;
+        BOOL success = GetOverlappedResult(m_file, &slot.overlapped, &bytes_written, TRUE);
+        slot.in_flight = false;
+        if (!success)
+        {
+            throw last_error("Failed to write file");
+        }
+        else if (bytes_written != slot.size)
+        {
+            throw last_error("Failed to write file", ERROR_WRITE_FAULT);
+        }
+    }
+}
+
+static bool preallocate(HANDLE file, uint64_t size)
+{
+    FILE_ALLOCATION_INFO info = {};
+    info.AllocationSize.QuadPart = (LONGLONG)size;
+    return SetFileInformationByHandle(file, FileAllocationInfo, &info, sizeof(info)) != 0;
+}
+
+static void set_file_size(HANDLE file, uint64_t size)
+{
+    FILE_END_OF_FILE_INFO info = {};
+    info.EndOfFile.QuadPart = (LONGLONG)size;
+    if (!SetFileInformationByHandle(file, FileEndOfFileInfo, &info, sizeof(info)))
+    {
+        throw last_error("Failed to set file size");
+    }
+}
+
+void UnbufferedFileIOCallback::close_file()
+{
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        // The buffers must outlive the writes in flight, even if they failed.
+        for (write_slot_t &slot : m_queue->slots)
+        {
+            if (slot.in_flight)
+            {
+                DWORD bytes_written = 0;
+                (void)GetOverlappedResult(m_file, &slot.overlapped, &bytes_written, TRUE);
+                slot.in_flight = false;
+            }
+        }
+
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+#define FILE_IS_OPEN(file) ((file) != INVALID_HANDLE_VALUE)
+
+#else
+
+struct UnbufferedFileIOCallback::io_queue_t
+{
+    write_slot_t slots[UNBUFFERED_IO_QUEUE_DEPTH];
+
+    // Locks the state of the slots, pending and stopping
+    std::mutex lock;
+    std::condition_variable notify;
+    std::deque<write_slot_t *> pending;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    ~io_queue_t()
+    {
+        for (write_slot_t &slot : slots)
+        {
+            free(slot.buffer);
+        }
+    }
+};
+
+static std::ios_base::failure last_error(const char *message, int error = errno)
+{
+    return std::ios_base::failure(message, std::error_code(error, std::generic_category()));
+}
+
+// Returns 0 on success, or the errno of the failure
+static int write_at(int file, const uint8_t *buffer, size_t size, uint64_t offset)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t count = pwrite(file, buffer + total, size - total, (off_t)(offset + total));
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (count < 0)
+        {
+            return errno;
+        }
+        else if (count == 0)
+        {
+            return EIO;
+        }
+        total += (size_t)count;
+    }
+    return 0;
+}
+
+static size_t read_at(int file, uint8_t *buffer, size_t size, uint64_t offset)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t count = pread(file, buffer + total, size - total, (off_t)(offset + total));
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (count < 0)
+        {
+            throw last_error("Failed to read file");
+        }
+        else if (count == 0)
+        {
+            break;
+        }
+        total += (size_t)count;
+    }
+    return total;
+}
+
+// Writes the buffers passed to UnbufferedFileIOCallback::submit_write(), each thread has one write in flight.
+static void io_thread(int file, std::mutex *lock, std::condition_variable *notify, std::deque<write_slot_t *> *pending,
+                      const bool *stopping)
+{
+    std::unique_lock<std::mutex> queue_lock(*lock);
+    while (true)
+    {
+        notify->wait(queue_lock, [&]() { return *stopping || !pending->empty(); });
+        if (pending->empty())
+        {
+            // Only stop once every submitted write is done.
+            return;
+        }
+
+        write_slot_t *slot = pending->front();
+        pending->pop_front();
+
+        queue_lock.unlock();
+        int error = write_at(file, slot->buffer + slot->begin, slot->size, slot->offset);
+        queue_lock.lock();
+
+        slot->error = error;
+        slot->in_flight = false;
+        notify->notify_all();
+    }
+}
+
+UnbufferedFileIOCallback::UnbufferedFileIOCallback(const char *path) :
+    m_queue(new io_queue_t()),
+    m_owner(std::this_thread::get_id())
+{
+    assert(path);
+
+    for (write_slot_t &slot : m_queue->slots)
+    {
+        void *buffer = nullptr;
+        if (posix_memalign(&buffer, UNBUFFERED_IO_ALIGNMENT, UNBUFFERED_IO_BUFFER_SIZE) != 0)
+        {
+            throw std::ios_base::failure("Failed to allocate the file buffers");
+        }
+        slot.buffer = (uint8_t *)buffer;
+    }
+    m_buffer = m_queue->slots[m_current].buffer;
+
+    int flags = O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC;
+    m_file = open(path, flags | O_DIRECT, 0644);
+    if (m_file < 0 && errno == EINVAL)
+    {
+        // Some file systems such as tmpfs don't support O_DIRECT.
+        LOG_WARNING("Unbuffered IO is not supported for '%s', using buffered IO.", path);
+        m_file = open(path, flags, 0644);
+    }
+    if (m_file < 0)
+    {
+        throw last_error("Failed to create file");
+    }
+
+    try
+    {
+        // One buffer is always being filled, so at most UNBUFFERED_IO_QUEUE_DEPTH - 1 writes are in flight.
+        for (size_t i = 0; i < UNBUFFERED_IO_QUEUE_DEPTH - 1; i++)
+        {
+            m_queue->threads.emplace_back(io_thread,
+                                          m_file,
+                                          &m_queue->lock,
+                                          &m_queue->notify,
+                                          &m_queue->pending,
+                                          &m_queue->stopping);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        close_file();
+        throw std::ios_base::failure(e.what());
+    }
+}
+
+void UnbufferedFileIOCallback::submit_write(size_t index, size_t begin, size_t end)
+{
+    write_slot_t &slot = m_queue->slots[index];
+
+    std::lock_guard<std::mutex> lock(m_queue->lock);
+    assert(!slot.in_flight);
+    slot.begin = begin;
+    slot.size = end - begin;
+    slot.offset = m_window_start + begin;
+    slot.in_flight = true;
+    m_queue->pending.push_back(&slot);
+    m_queue->notify.notify_all();
+}
+
+void UnbufferedFileIOCallback::wait_write(size_t index)
+{
+    write_slot_t &slot = m_queue->slots[index];
+
+    std::unique_lock<std::mutex> lock(m_queue->lock);
+    m_queue->notify.wait(lock, [&slot]() { return !slot.in_flight; });
+    if (slot.error != 0)
+    {
+        int error = slot.error;
+        slot.error = 0;
+        throw last_error("Failed to write file", error);
+    }
+}
+
+static bool preallocate(int file, uint64_t size)
+{
+    // Keep the file size so the recording can still be read if it isn't closed.
+    return fallocate(file, FALLOC_FL_KEEP_SIZE, 0, (off_t)size) == 0;
+}
+
+static void set_file_size(int file, uint64_t size)
+{
+    if (ftruncate(file, (off_t)size) != 0)
+    {
+        throw last_error("Failed to set file size");
+    }
+}
+
+void UnbufferedFileIOCallback::close_file()
+{
+    if (m_file >= 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queue->lock);
+            m_queue->stopping = true;
+            m_queue->notify.notify_all();
+        }
+        for (std::thread &thread : m_queue->threads)
+        {
+            thread.join();
+        }
+        m_queue->threads.clear();
+
+        ::close(m_file);
+        m_file = -1;
+    }
+}
+
+#define FILE_IS_OPEN(file) ((file) >= 0)
+
+#endif
+
+UnbufferedFileIOCallback::~UnbufferedFileIOCallback()
+{
+    try
+    {
+        close();
+    }
+    catch (std::ios_base::failure &)
+    {
+        // Errors are reported by calling close() before the destructor.
+    }
+}
+
+void UnbufferedFileIOCallback::wait_all_writes()
+{
+    // Wait for every write even if one of them failed, then report the first failure.
+    std::unique_ptr<std::ios_base::failure> failure;
+    for (size_t i = 0; i < UNBUFFERED_IO_QUEUE_DEPTH; i++)
+    {
+        try
+        {
+            wait_write(i);
+        }
+        catch (std::ios_base::failure &e)
+        {
+            if (!failure)
+            {
+                failure.reset(new std::ios_base::failure(e));
+            }
+        }
+    }
+
+    if (failure)
+    {
+        throw *failure;
+    }
+}
+
+void UnbufferedFileIOCallback::flush()
+{
+    if (!m_window_loaded)
+    {
+        return;
+    }
+    m_window_loaded = false;
+
+    if (m_dirty_begin == m_dirty_end)
+    {
+        return;
+    }
+
+    // Unbuffered writes need to be whole aligned blocks. The start of the first block is always valid, since the
+    // window starts on a block, and anything after the end of the file is cut off in close().
+    size_t begin = (size_t)align_down(m_dirty_begin);
+    size_t end = (size_t)align_up(m_dirty_end);
+    uint64_t end_offset = m_window_start + end;
+    m_dirty_begin = m_dirty_end = 0;
+
+    if (m_preallocate && end_offset > m_preallocated_size)
+    {
+        uint64_t size = (end_offset + UNBUFFERED_IO_PREALLOCATE_SIZE - 1) / UNBUFFERED_IO_PREALLOCATE_SIZE *
+                        UNBUFFERED_IO_PREALLOCATE_SIZE;
+        m_preallocate = preallocate(m_file, size);
+        m_preallocated_size = size;
+    }
+
+    // Fill the next buffer while this one is written, once the previous write from it is done.
+    submit_write(m_current, begin, end);
+    m_current = (m_current + 1) % UNBUFFERED_IO_QUEUE_DEPTH;
+    m_buffer = m_queue->slots[m_current].buffer;
+    wait_write(m_current);
+}
+
+void UnbufferedFileIOCallback::load_window(uint64_t position)
+{
+    flush();
+
+    m_window_start = align_down(position);
+    m_window_valid = 0;
+    m_window_loaded = true;
+    if (m_window_start < m_file_size)
+    {
+        // Only seeking back to update headers reads the file, writes at the end of the file never do. The writes in
+        // flight must be done first, they may overlap what is read.
+        wait_all_writes();
+
+        size_t size = (size_t)std::min<uint64_t>(UNBUFFERED_IO_BUFFER_SIZE, align_up(m_file_size - m_window_start));
+        size_t count = read_at(m_file, m_buffer, size, m_window_start);
+        m_window_valid = (size_t)std::min<uint64_t>(count, m_file_size - m_window_start);
+    }
+}
+
+uint32 UnbufferedFileIOCallback::read(void *buffer, size_t size)
+{
+    assert(size <= UINT32_MAX); // can't properly return > uint32
+    assert(m_owner == std::this_thread::get_id());
+
+    size_t total = 0;
+    while (total < size && m_position < m_file_size)
+    {
+        if (!m_window_loaded || m_position < m_window_start || m_position >= m_window_start + m_window_valid)
+        {
+            load_window(m_position);
+            if (m_position >= m_window_start + m_window_valid)
+            {
+                break;
+            }
+        }
+
+        size_t offset = (size_t)(m_position - m_window_start);
+        size_t count = std::min(size - total, m_window_valid - offset);
+        memcpy((uint8_t *)buffer + total, m_buffer + offset, count);
+        total += count;
+        m_position += count;
+    }
+    return (uint32)total;
+}
+
+void UnbufferedFileIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+    assert(m_owner == std::this_thread::get_id());
+
+    int64_t position = offset;
+    switch (mode)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        position += (int64_t)m_position;
+        break;
+    case SEEK_END:
+        position += (int64_t)m_file_size;
+        break;
+    }
+
+    if (position < 0)
+    {
+        throw std::ios_base::failure("Invalid file position");
+    }
+    m_position = (uint64_t)position;
+}
+
+size_t UnbufferedFileIOCallback::write(const void *buffer, size_t size)
+{
+    assert(m_owner == std::this_thread::get_id());
+    assert(FILE_IS_OPEN(m_file));
+
+    size_t total = 0;
+    while (total < size)
+    {
+        if (!m_window_loaded || m_position < m_window_start ||
+            m_position >= m_window_start + UNBUFFERED_IO_BUFFER_SIZE)
+        {
+            load_window(m_position);
+        }
+
+        size_t offset = (size_t)(m_position - m_window_start);
+        if (offset > m_window_valid)
+        {
+            // Writing past the end of the file leaves a gap of zeros.
+            memset(m_buffer + m_window_valid, 0, offset - m_window_valid);
+        }
+
+        size_t count = std::min(size - total, (size_t)UNBUFFERED_IO_BUFFER_SIZE - offset);
+        memcpy(m_buffer + offset, (const uint8_t *)buffer + total, count);
+        if (m_dirty_begin == m_dirty_end)
+        {
+            m_dirty_begin = offset;
+            m_dirty_end = offset + count;
+        }
+        else
+        {
+            m_dirty_begin = std::min(m_dirty_begin, offset);
+            m_dirty_end = std::max(m_dirty_end, offset + count);
+        }
+        m_window_valid = std::max(m_window_valid, offset + count);
+
+        total += count;
+        m_position += count;
+        m_file_size = std::max(m_file_size, m_position);
+
+        if (offset + count == UNBUFFERED_IO_BUFFER_SIZE)
+        {
+            flush();
+        }
+    }
+    return size;
+}
+
+uint64 UnbufferedFileIOCallback::getFilePointer()
+{
+    assert(m_owner == std::this_thread::get_id());
+    return m_position;
+}
+
+void UnbufferedFileIOCallback::close()
+{
+    // UnbufferedFileIOCallback::close() can be called more than once, only close the file the first time.
+    if (FILE_IS_OPEN(m_file))
+    {
+        try
+        {
+            flush();
+            wait_all_writes();
+
+            // Remove the padding of the last block and any preallocated space.
+            set_file_size(m_file, m_file_size);
+        }
+        catch (std::ios_base::failure &)
+        {
+            close_file();
+            throw;
+        }
+        close_file();
+    }
+}
+
+void UnbufferedFileIOCallback::setOwnerThread()
+{
+    m_owner = std::this_thread::get_id();
+}
@@ -0,0 +1,475 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <k4a/k4a.h>
+#include <k4arecord/record.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/common.h>
+
+// Buffers for the image copies of a capture history. A buffer is returned to the pool when the last reference to its
+// image is released, which may happen after the history has been destroyed, so the pool is reference counted.
+typedef struct _history_buffer_pool_t
+{
+    std::mutex lock;
+    std::vector<std::pair<size_t, uint8_t *>> idle_buffers;
+    size_t idle_bytes = 0;
+    size_t live_bytes = 0;
+    size_t max_bytes = 0; // Idle buffers are freed instead of kept once live_bytes + idle_bytes would exceed this.
+
+    ~_history_buffer_pool_t()
+    {
+        for (auto &buffer : idle_buffers)
+        {
+            delete[] buffer.second;
+        }
+    }
+} history_buffer_pool_t;
+
+// The context of the release callback of an image copy.
+typedef struct _history_buffer_t
+{
+    std::shared_ptr<history_buffer_pool_t> pool;
+    size_t size;
+} history_buffer_t;
+
+typedef struct _history_entry_t
+{
+    uint64_t timestamp_usec;
+    k4a_capture_t capture;
+    size_t size;
+} history_entry_t;
+
+typedef struct _k4a_capture_history_context_t
+{
+    uint64_t duration_usec;
+    size_t max_memory_bytes;
+    std::shared_ptr<history_buffer_pool_t> pool;
+
+    std::deque<history_entry_t> captures; // Sorted by timestamp, the newest capture is at the back.
+    size_t memory_bytes;                  // The total size of the images of captures.
+    std::mutex lock;                      // Locks access to captures and memory_bytes
+
+    std::list<std::future<void>> writers; // Writers started by k4a_capture_history_dump()
+    std::mutex writers_lock;              // Locks access to writers
+} k4a_capture_history_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_capture_history_t, k4a_capture_history_context_t);
+
+static void release_history_buffer(void *buffer, void *context)
+{
+    history_buffer_t *history_buffer = static_cast<history_buffer_t *>(context);
+    history_buffer_pool_t *pool = history_buffer->pool.get();
+    {
+        std::lock_guard<std::mutex> lock(pool->lock);
+        pool->live_bytes -= history_buffer->size;
+        if (pool->live_bytes + pool->idle_bytes + history_buffer->size <= pool->max_bytes)
+        {
+            pool->idle_buffers.emplace_back(history_buffer->size, static_cast<uint8_t *>(buffer));
+            pool->idle_bytes += history_buffer->size;
+            buffer = NULL;
+        }
+    }
+    delete[] static_cast<uint8_t *>(buffer);
+    delete history_buffer;
+}
+
+// Returns a buffer of the given size from the pool, or a newly allocated one if no idle buffer has that size.
+static uint8_t *acquire_history_buffer(history_buffer_pool_t *pool, size_t size)
+{
+    std::vector<uint8_t *> unused_buffers;
+    uint8_t *buffer = NULL;
+    {
+        std::lock_guard<std::mutex> lock(pool->lock);
+        auto itr = std::find_if(pool->idle_buffers.begin(),
+                                pool->idle_buffers.end(),
+                                [size](const std::pair<size_t, uint8_t *> &idle) { return idle.first == size; });
+        if (itr != pool->idle_buffers.end())
+        {
+            buffer = itr->second;
+            pool->idle_buffers.erase(itr);
+            pool->idle_bytes -= size;
+        }
+        else
+        {
+            // Image sizes only change with the camera configuration, free idle buffers of other sizes to make room.
+            while (!pool->idle_buffers.empty() && pool->live_bytes + pool->idle_bytes + size > pool->max_bytes)
+            {
+                unused_buffers.push_back(pool->idle_buffers.front().second);
+                pool->idle_bytes -= pool->idle_buffers.front().first;
+                pool->idle_buffers.erase(pool->idle_buffers.begin());
+            }
+        }
+        pool->live_bytes += size;
+    }
+
+    for (uint8_t *unused_buffer : unused_buffers)
+    {
+        delete[] unused_buffer;
+    }
+
+    if (buffer == NULL)
+    {
+        buffer = new (std::nothrow) uint8_t[size];
+        if (buffer == NULL)
+        {
+            std::lock_guard<std::mutex> lock(pool->lock);
+            pool->live_bytes -= size;
+        }
+    }
+    return buffer;
+}
+
+// Copies an image and its metadata into a buffer from the pool.
+static k4a_image_t copy_history_image(const std::shared_ptr<history_buffer_pool_t> &pool, k4a_image_t image)
+{
+    size_t size = k4a_image_get_size(image);
+    const uint8_t *source = k4a_image_get_buffer(image);
+    if (source == NULL || size == 0)
+    {
+        return NULL;
+    }
+
+    uint8_t *buffer = acquire_history_buffer(pool.get(), size);
+    history_buffer_t *history_buffer = buffer != NULL ? new (std::nothrow) history_buffer_t() : NULL;
+    if (history_buffer == NULL)
+    {
+        LOG_ERROR("Failed to allocate a %zu byte buffer for the capture history.", size);
+        if (buffer != NULL)
+        {
+            std::lock_guard<std::mutex> lock(pool->lock);
+            pool->live_bytes -= size;
+        }
+        delete[] buffer;
+        return NULL;
+    }
+    history_buffer->pool = pool;
+    history_buffer->size = size;
+    memcpy(buffer, source, size);
+
+    k4a_image_t copy = NULL;
+    if (K4A_FAILED(TRACE_CALL(k4a_image_create_from_buffer(k4a_image_get_format(image),
+                                                           k4a_image_get_width_pixels(image),
+                                                           k4a_image_get_height_pixels(image),
+                                                           k4a_image_get_stride_bytes(image),
+                                                           buffer,
+                                                           size,
+                                                           release_history_buffer,
+                                                           history_buffer,
+                                                           &copy))))
+    {
+        release_history_buffer(buffer, history_buffer);
+        return NULL;
+    }
+
+    k4a_image_set_device_timestamp_usec(copy, k4a_image_get_device_timestamp_usec(image));
+    k4a_image_set_system_timestamp_nsec(copy, k4a_image_get_system_timestamp_nsec(image));
+    k4a_image_set_exposure_usec(copy, k4a_image_get_exposure_usec(image));
+    k4a_image_set_white_balance(copy, k4a_image_get_white_balance(image));
+    k4a_image_set_iso_speed(copy, k4a_image_get_iso_speed(image));
+    return copy;
+}
+
+// Removes the oldest capture of the history. The history lock must be held.
+static void evict_oldest_capture(k4a_capture_history_context_t *context)
+{
+    history_entry_t &entry = context->captures.front();
+    context->memory_bytes -= entry.size;
+    k4a_capture_release(entry.capture);
+    context->captures.pop_front();
+}
+
+k4a_result_t k4a_capture_history_create(uint64_t duration_usec,
+                                        size_t max_memory_bytes,
+                                        k4a_capture_history_t *history_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, max_memory_bytes == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, history_handle == NULL);
+
+    k4a_capture_history_context_t *context = k4a_capture_history_t_create(history_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->duration_usec = duration_usec;
+        context->max_memory_bytes = max_memory_bytes;
+        context->memory_bytes = 0;
+        context->pool = std::shared_ptr<history_buffer_pool_t>(new (std::nothrow) history_buffer_pool_t());
+        result = K4A_RESULT_FROM_BOOL(context->pool != nullptr);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->pool->max_bytes = max_memory_bytes;
+    }
+    else if (context != NULL)
+    {
+        k4a_capture_history_t_destroy(*history_handle);
+        *history_handle = NULL;
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_capture_history_add_capture(k4a_capture_history_t history_handle, k4a_capture_t capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_capture_history_t, history_handle);
+    k4a_capture_history_context_t *context = k4a_capture_history_t_get_context(history_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
+
+    k4a_image_t images[] = {
+        k4a_capture_get_color_image(capture_handle),
+        k4a_capture_get_depth_image(capture_handle),
+        k4a_capture_get_ir_image(capture_handle),
+    };
+
+    size_t size = 0;
+    uint64_t timestamp_usec = UINT64_MAX;
+    for (k4a_image_t image : images)
+    {
+        if (image != NULL)
+        {
+            size += k4a_image_get_size(image);
+            timestamp_usec = std::min(timestamp_usec, k4a_image_get_device_timestamp_usec(image));
+        }
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (size == 0)
+    {
+        LOG_ERROR("Captures added to a capture history need at least one image.", 0);
+        result = K4A_RESULT_FAILED;
+    }
+    else if (size > context->max_memory_bytes)
+    {
+        LOG_ERROR("Capture of %zu bytes is larger than the capture history limit of %zu bytes.",
+                  size,
+                  context->max_memory_bytes);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+
+        // Evict before copying, so the buffers of the evicted captures can be reused for the copy.
+        uint64_t newest_usec = std::max(timestamp_usec,
+                                        context->captures.empty() ? 0 : context->captures.back().timestamp_usec);
+        while (!context->captures.empty() &&
+               (newest_usec - context->captures.front().timestamp_usec > context->duration_usec ||
+                context->memory_bytes + size > context->max_memory_bytes))
+        {
+            evict_oldest_capture(context);
+        }
+
+        k4a_capture_t copy = NULL;
+        result = TRACE_CALL(k4a_capture_create(&copy));
+        if (K4A_SUCCEEDED(result))
+        {
+            k4a_capture_set_temperature_c(copy, k4a_capture_get_temperature_c(capture_handle));
+
+            void (*set_image[])(k4a_capture_t, k4a_image_t) = { k4a_capture_set_color_image,
+                                                                k4a_capture_set_depth_image,
+                                                                k4a_capture_set_ir_image };
+            static_assert(std::extent<decltype(images)>::value == std::extent<decltype(set_image)>::value,
+                          "Invalid mapping from images to setters");
+            for (size_t i = 0; i < std::extent<decltype(images)>::value && K4A_SUCCEEDED(result); i++)
+            {
+                if (images[i] != NULL)
+                {
+                    k4a_image_t image_copy = copy_history_image(context->pool, images[i]);
+                    result = K4A_RESULT_FROM_BOOL(image_copy != NULL);
+                    if (K4A_SUCCEEDED(result))
+                    {
+                        set_image[i](copy, image_copy);
+                        k4a_image_release(image_copy);
+                    }
+                }
+            }
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            history_entry_t entry = { timestamp_usec, copy, size };
+            auto itr = std::upper_bound(context->captures.begin(),
+                                        context->captures.end(),
+                                        timestamp_usec,
+                                        [](uint64_t timestamp, const history_entry_t &other) {
+                                            return timestamp < other.timestamp_usec;
+                                        });
+            context->captures.insert(itr, entry);
+            context->memory_bytes += size;
+        }
+        else if (copy != NULL)
+        {
+            k4a_capture_release(copy);
+        }
+    }
+
+    for (k4a_image_t image : images)
+    {
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+
+    return result;
+}
+
+size_t k4a_capture_history_get_capture_count(k4a_capture_history_t history_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_capture_history_t, history_handle);
+    k4a_capture_history_context_t *context = k4a_capture_history_t_get_context(history_handle);
+    RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    return context->captures.size();
+}
+
+k4a_result_t k4a_capture_history_get_capture(k4a_capture_history_t history_handle,
+                                             uint64_t device_timestamp_usec,
+                                             k4a_capture_t *capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_capture_history_t, history_handle);
+    k4a_capture_history_context_t *context = k4a_capture_history_t_get_context(history_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->captures.empty())
+    {
+        LOG_ERROR("The capture history is empty.", 0);
+        *capture_handle = NULL;
+        return K4A_RESULT_FAILED;
+    }
+
+    // Pick the closer of the first capture at or after the timestamp and the one before it.
+    auto itr = std::lower_bound(context->captures.begin(),
+                                context->captures.end(),
+                                device_timestamp_usec,
+                                [](const history_entry_t &entry, uint64_t timestamp) {
+                                    return entry.timestamp_usec < timestamp;
+                                });
+    if (itr == context->captures.end() ||
+        (itr != context->captures.begin() &&
+         device_timestamp_usec - (itr - 1)->timestamp_usec < itr->timestamp_usec - device_timestamp_usec))
+    {
+        itr--;
+    }
+
+    k4a_capture_reference(itr->capture);
+    *capture_handle = itr->capture;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_capture_history_dump(k4a_capture_history_t history_handle,
+                                      k4a_record_t recording_handle,
+                                      uint64_t duration_usec,
+                                      k4a_capture_history_dump_cb_t *callback,
+                                      void *callback_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_capture_history_t, history_handle);
+    k4a_capture_history_context_t *context = k4a_capture_history_t_get_context(history_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
+
+    // Take references to the captures to write, so they stay valid once evicted.
+    std::shared_ptr<std::vector<k4a_capture_t>> captures = std::make_shared<std::vector<k4a_capture_t>>();
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        if (!context->captures.empty())
+        {
+            uint64_t newest_usec = context->captures.back().timestamp_usec;
+            for (const history_entry_t &entry : context->captures)
+            {
+                if (newest_usec - entry.timestamp_usec <= duration_usec)
+                {
+                    k4a_capture_reference(entry.capture);
+                    captures->push_back(entry.capture);
+                }
+            }
+        }
+    }
+
+    auto writer = [recording_handle, captures, callback, callback_context]() {
+        k4a_result_t result = K4A_RESULT_SUCCEEDED;
+        for (k4a_capture_t capture : *captures)
+        {
+            if (K4A_SUCCEEDED(result))
+            {
+                result = TRACE_CALL(k4a_record_write_capture(recording_handle, capture));
+            }
+            k4a_capture_release(capture);
+        }
+
+        if (callback != NULL)
+        {
+            callback(result, callback_context);
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(context->writers_lock);
+
+    // Forget the writers that are already done.
+    context->writers.remove_if([](const std::future<void> &finished) {
+        return finished.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+
+    try
+    {
+        context->writers.push_back(std::async(std::launch::async, writer));
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start the capture history writer: %s", e.what());
+        for (k4a_capture_t capture : *captures)
+        {
+            k4a_capture_release(capture);
+        }
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void k4a_capture_history_destroy(k4a_capture_history_t history_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_capture_history_t, history_handle);
+    k4a_capture_history_context_t *context = k4a_capture_history_t_get_context(history_handle);
+
+    if (context != NULL)
+    {
+        {
+            std::lock_guard<std::mutex> lock(context->writers_lock);
+            for (std::future<void> &writer : context->writers)
+            {
+                writer.wait();
+            }
+            context->writers.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(context->lock);
+        while (!context->captures.empty())
+        {
+            evict_oldest_capture(context);
+        }
+
+        // Buffers of captures still referenced by the caller are freed once released.
+        std::lock_guard<std::mutex> pool_lock(context->pool->lock);
+        context->pool->max_bytes = 0;
+    }
+    k4a_capture_history_t_destroy(history_handle);
+}
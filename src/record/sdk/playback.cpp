@@ -13,10 +13,15 @@
 using namespace k4arecord;
 using namespace LIBMATROSKA_NAMESPACE;
 
-k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle)
+// Opens a recording from a file, or through custom_io if it is not null. If lazy_load is true, only the header,
+// tracks and tags are read, see k4a_playback_open_lazy(). The built-in tracks are those of device_index, see
+// k4a_playback_open_device().
+static k4a_result_t open_playback(const char *path,
+                                  std::unique_ptr<CustomIOCallback> custom_io,
+                                  bool lazy_load,
+                                  uint32_t device_index,
+                                  k4a_playback_t *playback_handle)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
     k4a_playback_context_t *context = NULL;
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
 
@@ -27,10 +32,33 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
     {
         context->file_path = path;
         context->file_closing = false;
+        context->cluster_read_ahead_count = CLUSTER_READ_AHEAD_COUNT;
+        context->lazy_load = lazy_load;
+        context->device_index = device_index;
+        context->image_buffer_pool = std::make_shared<image_buffer_pool_t>();
+
+        // Under a memory budget, read ahead a single cluster and cache at most a quarter of it in image buffers, see
+        // k4a_set_memory_budget()
+        size_t memory_budget = k4a_get_memory_budget();
+        if (memory_budget != 0)
+        {
+            context->cluster_read_ahead_count = 1;
+            context->image_buffer_pool->max_free_size = memory_budget / 4;
+        }
 
         try
         {
-            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_READ);
+            if (custom_io)
+            {
+                context->custom_io_name = path;
+                context->file_path = context->custom_io_name.c_str();
+                context->custom_io = custom_io.get();
+                context->ebml_file = std::move(custom_io);
+            }
+            else
+            {
+                context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_READ);
+            }
             context->stream = make_unique<libebml::EbmlStream>(*context->ebml_file);
         }
         catch (std::ios_base::failure &e)
@@ -45,31 +73,7 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
         result = TRACE_CALL(parse_mkv(context));
     }
 
-    if (K4A_SUCCEEDED(result))
-    {
-        // Seek to the first cluster
-        cluster_info_t *seek_cluster_info = find_cluster(context, 0);
-        if (seek_cluster_info == NULL)
-        {
-            LOG_ERROR("Failed to parse recording, recording is empty.", 0);
-            result = K4A_RESULT_FAILED;
-        }
-        else
-        {
-            context->seek_cluster = load_cluster(context, seek_cluster_info);
-            if (context->seek_cluster == nullptr)
-            {
-                LOG_ERROR("Failed to load first data cluster of recording.", 0);
-                result = K4A_RESULT_FAILED;
-            }
-        }
-    }
-
-    if (K4A_SUCCEEDED(result))
-    {
-        reset_seek_pointers(context, 0);
-    }
-    else
+    if (K4A_FAILED(result))
     {
         if (context && context->ebml_file)
         {
@@ -90,6 +94,56 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
     return result;
 }
 
+k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
+
+    return open_playback(path, nullptr, false, 0, playback_handle);
+}
+
+k4a_result_t k4a_playback_open_lazy(const char *path, k4a_playback_t *playback_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
+
+    return open_playback(path, nullptr, true, 0, playback_handle);
+}
+
+k4a_result_t k4a_playback_open_custom_io(const char *name,
+                                         uint64_t size,
+                                         k4a_playback_read_cb_t *read_cb,
+                                         void *callback_context,
+                                         k4a_playback_t *playback_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, read_cb == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
+
+    return open_playback(name,
+                         make_unique<CustomIOCallback>(size, read_cb, callback_context),
+                         false,
+                         0,
+                         playback_handle);
+}
+
+k4a_result_t k4a_playback_open_device(const char *path, uint32_t device_index, k4a_playback_t *playback_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, playback_handle == NULL);
+
+    return open_playback(path, nullptr, false, device_index, playback_handle);
+}
+
+uint32_t k4a_playback_get_device_count(k4a_playback_t playback_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    return get_device_count(context);
+}
+
 k4a_buffer_result_t k4a_playback_get_raw_calibration(k4a_playback_t playback_handle, uint8_t *data, size_t *data_size)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_playback_t, playback_handle);
@@ -97,6 +151,11 @@ k4a_buffer_result_t k4a_playback_get_raw_calibration(k4a_playback_t playback_han
     RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, data_size == NULL);
 
+    if (K4A_FAILED(TRACE_CALL(load_attachments(context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
     if (context->calibration_attachment == NULL)
     {
         LOG_ERROR("The device calibration is missing from the recording.", 0);
@@ -136,6 +195,11 @@ k4a_result_t k4a_playback_get_calibration(k4a_playback_t playback_handle, k4a_ca
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
 
+    if (K4A_FAILED(TRACE_CALL(load_attachments(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
     if (context->calibration_attachment == NULL)
     {
         LOG_ERROR("The device calibration is missing from the recording.", 0);
@@ -386,6 +450,9 @@ k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle, k
         return K4A_RESULT_FAILED;
     }
 
+    // Images already converted in the background use the previous format.
+    clear_color_read_ahead(context, &context->cursor);
+
     switch (target_format)
     {
     case K4A_IMAGE_FORMAT_COLOR_MJPG:
@@ -412,6 +479,290 @@ k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle, k
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_playback_set_color_scale(k4a_playback_t playback_handle, k4a_color_scale_t scale)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, scale < K4A_COLOR_SCALE_FULL || scale > K4A_COLOR_SCALE_EIGHTH);
+
+    if (context->color_track == NULL)
+    {
+        LOG_ERROR("The color track is not enabled in this recording. The color scale cannot be set.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (scale != K4A_COLOR_SCALE_FULL && context->color_track->format != K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        LOG_ERROR("Scaling color images is only supported for K4A_IMAGE_FORMAT_COLOR_MJPG recordings.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    clear_color_read_ahead(context, &context->cursor);
+    context->color_scale = scale;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_decode_color_image(k4a_playback_t playback_handle,
+                                             k4a_image_t color_image,
+                                             k4a_image_t target_image)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, color_image == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, target_image == NULL);
+
+    k4a_image_format_t format = k4a_image_get_format(color_image);
+    if (format != K4A_IMAGE_FORMAT_COLOR_MJPG && format != K4A_IMAGE_FORMAT_COLOR_NV12 &&
+        format != K4A_IMAGE_FORMAT_COLOR_YUY2)
+    {
+        LOG_ERROR("Unsupported color image format for decoding: %d", format);
+        return K4A_RESULT_FAILED;
+    }
+    if (k4a_image_get_format(target_image) != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        LOG_ERROR("Color images can only be decoded into K4A_IMAGE_FORMAT_COLOR_BGRA32 images.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    int width = k4a_image_get_width_pixels(color_image);
+    int height = k4a_image_get_height_pixels(color_image);
+    int target_width = k4a_image_get_width_pixels(target_image);
+    int target_height = k4a_image_get_height_pixels(target_image);
+    int target_stride = k4a_image_get_stride_bytes(target_image);
+
+    // MJPG images can be decoded to the sizes of k4a_playback_set_color_scale(), which turbojpeg rounds up.
+    bool size_supported = false;
+    int max_scale = format == K4A_IMAGE_FORMAT_COLOR_MJPG ? K4A_COLOR_SCALE_EIGHTH : K4A_COLOR_SCALE_FULL;
+    for (int scale = K4A_COLOR_SCALE_FULL; scale <= max_scale; scale++)
+    {
+        int divisor = 1 << scale;
+        if (target_width == (width + divisor - 1) / divisor && target_height == (height + divisor - 1) / divisor)
+        {
+            size_supported = true;
+        }
+    }
+    if (!size_supported)
+    {
+        LOG_ERROR("Cannot decode a %dx%d color image into a %dx%d image.", width, height, target_width, target_height);
+        return K4A_RESULT_FAILED;
+    }
+    if (target_stride < target_width * 4 ||
+        k4a_image_get_size(target_image) < (size_t)target_stride * (size_t)target_height)
+    {
+        LOG_ERROR("The target image is too small for a %dx%d BGRA image.", target_width, target_height);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(decode_color_to_bgra(context,
+                                                          format,
+                                                          k4a_image_get_buffer(color_image),
+                                                          k4a_image_get_size(color_image),
+                                                          k4a_image_get_stride_bytes(color_image),
+                                                          width,
+                                                          height,
+                                                          k4a_image_get_buffer(target_image),
+                                                          target_width,
+                                                          target_height,
+                                                          target_stride));
+    if (K4A_SUCCEEDED(result))
+    {
+        k4a_image_set_device_timestamp_usec(target_image, k4a_image_get_device_timestamp_usec(color_image));
+    }
+    return result;
+}
+
+k4a_result_t k4a_playback_set_color_read_ahead(k4a_playback_t playback_handle, uint32_t capture_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->color_track == NULL)
+    {
+        LOG_ERROR("The color track is not enabled in this recording. Color images cannot be read ahead.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    clear_color_read_ahead(context, &context->cursor);
+    context->color_read_ahead_count = capture_count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_color_decoder(k4a_playback_t playback_handle,
+                                            k4a_playback_color_decode_cb_t *decode_cb,
+                                            void *callback_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->color_track == NULL)
+    {
+        LOG_ERROR("The color track is not enabled in this recording. The color decoder cannot be set.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::lock_guard<std::mutex> lock(context->color_decode_lock);
+    context->color_decode_cb = decode_cb;
+    context->color_decode_cb_context = callback_context;
+    context->color_decoded_valid = false;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_enabled_tracks(k4a_playback_t playback_handle,
+                                             const char *const *track_names,
+                                             size_t track_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_names == NULL && track_count > 0);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    track_reader_t *image_tracks[] = { context->color_track, context->depth_track, context->ir_track };
+    bool enabled[arraysize(image_tracks)] = {};
+    for (size_t i = 0; i < track_count; i++)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_names[i] == NULL);
+
+        // The built-in track names select the tracks of the device opened with k4a_playback_open_device().
+        track_reader_t *track_reader = get_track_reader_by_name(context, device_name(context, track_names[i]));
+        if (track_reader == NULL)
+        {
+            track_reader = get_track_reader_by_name(context, track_names[i]);
+        }
+        size_t index = 0;
+        while (index < arraysize(image_tracks) && (track_reader == NULL || image_tracks[index] != track_reader))
+        {
+            index++;
+        }
+        if (index == arraysize(image_tracks))
+        {
+            LOG_ERROR("Track '%s' is not an image track of this recording and cannot be enabled.", track_names[i]);
+            return K4A_RESULT_FAILED;
+        }
+        enabled[index] = true;
+    }
+
+    for (size_t i = 0; i < arraysize(image_tracks); i++)
+    {
+        if (image_tracks[i] != NULL)
+        {
+            image_tracks[i]->enabled = track_count == 0 || enabled[i];
+        }
+    }
+
+    {
+        // Captures and frame indices change with the set of tracks.
+        std::lock_guard<std::mutex> lock(context->frame_index_lock);
+        context->frame_index_built = false;
+    }
+    clear_color_read_ahead(context, &context->cursor);
+    return TRACE_CALL(seek_timestamp(context, &context->cursor, 0, K4A_PLAYBACK_SEEK_BEGIN));
+}
+
+k4a_result_t k4a_playback_set_cache_size(k4a_playback_t playback_handle, uint64_t cache_size_bytes)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    set_cluster_lru_budget(context, cache_size_bytes);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_cluster_read_ahead(k4a_playback_t playback_handle, uint32_t cluster_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    // Clusters that are already loaded keep their neighbors, the new depth is used from the next cluster on.
+    context->cluster_read_ahead_count = cluster_count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_mapped_io(k4a_playback_t playback_handle, bool mapped_io)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->io_lock);
+    if (context->mapped_io == mapped_io)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+    if (context->custom_io != nullptr)
+    {
+        LOG_ERROR("Recording '%s' is read through a callback and can't be mapped.", context->file_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    // Every read seeks to the element it reads first, so the file can be swapped between reads. Images that already
+    // reference cluster data keep their cluster loaded, independently of the file.
+    std::unique_ptr<IOCallback> ebml_file;
+    std::unique_ptr<libebml::EbmlStream> stream;
+    try
+    {
+        if (mapped_io)
+        {
+            ebml_file = make_unique<MappedFileIOCallback>(context->file_path);
+        }
+        else
+        {
+            ebml_file = make_unique<LargeFileIOCallback>(context->file_path, MODE_READ);
+        }
+        stream = make_unique<libebml::EbmlStream>(*ebml_file);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Unable to open file '%s': %s", context->file_path, e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    std::swap(context->stream, stream);
+    std::swap(context->ebml_file, ebml_file);
+    context->mapped_io = mapped_io;
+
+    try
+    {
+        ebml_file->close();
+    }
+    catch (std::ios_base::failure &)
+    {
+        // The file was opened as read-only, ignore any close failures.
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_write_index(k4a_playback_t playback_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->custom_io != nullptr)
+    {
+        LOG_ERROR("Recording '%s' is read through a callback and has no path to write an index next to.",
+                  context->file_path);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    return TRACE_CALL(write_cluster_index(context));
+}
+
 k4a_buffer_result_t
 k4a_playback_get_attachment(k4a_playback_t playback_handle, const char *file_name, uint8_t *data, size_t *data_size)
 {
@@ -421,6 +772,11 @@ k4a_playback_get_attachment(k4a_playback_t playback_handle, const char *file_nam
     RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, file_name == NULL);
     RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, data_size == NULL);
 
+    if (K4A_FAILED(TRACE_CALL(load_attachments(context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
     KaxAttached *attachment = get_attachment_by_name(context, file_name);
     if (attachment != NULL)
     {
@@ -451,7 +807,12 @@ k4a_stream_result_t k4a_playback_get_next_capture(k4a_playback_t playback_handle
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
 
-    return get_capture(context, capture_handle, true);
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_capture(context, &context->cursor, capture_handle, true);
 }
 
 k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playback_t playback_handle, k4a_capture_t *capture_handle)
@@ -461,7 +822,12 @@ k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playback_t playback_ha
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
 
-    return get_capture(context, capture_handle, false);
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_capture(context, &context->cursor, capture_handle, false);
 }
 
 k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playback_t playback_handle, k4a_imu_sample_t *imu_sample)
@@ -471,7 +837,12 @@ k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playback_t playback_han
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_sample == NULL);
 
-    return get_imu_sample(context, imu_sample, true);
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_imu_sample(context, &context->cursor, imu_sample, true);
 }
 
 k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback_handle, k4a_imu_sample_t *imu_sample)
@@ -481,7 +852,95 @@ k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_sample == NULL);
 
-    return get_imu_sample(context, imu_sample, false);
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_imu_sample(context, &context->cursor, imu_sample, false);
+}
+
+k4a_buffer_result_t k4a_playback_get_imu_samples(k4a_playback_t playback_handle,
+                                                 uint64_t start_device_timestamp_usec,
+                                                 uint64_t end_device_timestamp_usec,
+                                                 k4a_imu_sample_t *imu_samples,
+                                                 size_t max_sample_count,
+                                                 size_t *sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, max_sample_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, sample_count == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, start_device_timestamp_usec > end_device_timestamp_usec);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    // Timestamps past the range of nanoseconds are clamped, so UINT64_MAX can be used as an open end.
+    uint64_t start_ns = start_device_timestamp_usec > UINT64_MAX / 1000 ? UINT64_MAX :
+                                                                           start_device_timestamp_usec * 1000;
+    uint64_t end_ns = end_device_timestamp_usec > UINT64_MAX / 1000 ? UINT64_MAX : end_device_timestamp_usec * 1000;
+
+    return get_imu_samples(context,
+                           start_ns,
+                           end_ns,
+                           imu_samples,
+                           max_sample_count,
+                           sample_count);
+}
+
+k4a_stream_result_t k4a_playback_get_next_preview(k4a_playback_t playback_handle, k4a_capture_t *preview_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, preview_handle == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_preview(context, &context->cursor, preview_handle, true);
+}
+
+k4a_stream_result_t k4a_playback_get_previous_preview(k4a_playback_t playback_handle, k4a_capture_t *preview_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, preview_handle == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_preview(context, &context->cursor, preview_handle, false);
+}
+
+// Returns the reader of a custom track, or NULL if the track doesn't exist or is one of the built-in tracks.
+static track_reader_t *get_custom_track_reader(k4a_playback_context_t *context,
+                                               const char *track_name,
+                                               const char *function_name)
+{
+    track_reader_t *track_reader = get_track_reader_by_name(context, track_name);
+    if (track_reader == nullptr)
+    {
+        LOG_ERROR("Track name cannot be found: %s", track_name);
+        return NULL;
+    }
+
+    if (check_track_reader_is_builtin(context, track_reader))
+    {
+        LOG_ERROR("%s cannot be used with the built-in track: %s", function_name, track_name);
+        return NULL;
+    }
+    return track_reader;
 }
 
 k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playback_t playback_handle,
@@ -494,20 +953,18 @@ k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playback_t playback_han
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
 
-    track_reader_t *track_reader = get_track_reader_by_name(context, track_name);
-    if (track_reader == nullptr)
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
     {
-        LOG_ERROR("Track name cannot be found: %s", track_name);
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    if (check_track_reader_is_builtin(context, track_reader))
+    track_reader_t *track_reader = get_custom_track_reader(context, track_name, "k4a_playback_get_next_data_block");
+    if (track_reader == nullptr)
     {
-        LOG_ERROR("k4a_playback_get_next_data_block cannot be used with the built-in track: %s", track_name);
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    return get_data_block(context, track_reader, data_block_handle, true);
+    return get_data_block(context, &context->cursor, track_reader, data_block_handle, true);
 }
 
 k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_playback_t playback_handle,
@@ -520,6 +977,35 @@ k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_playback_t playback
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
 
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    track_reader_t *track_reader = get_custom_track_reader(context, track_name, "k4a_playback_get_previous_data_block");
+    if (track_reader == nullptr)
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_data_block(context, &context->cursor, track_reader, data_block_handle, false);
+}
+
+k4a_stream_result_t k4a_playback_get_next_raw_block(k4a_playback_t playback_handle,
+                                                    const char *track_name,
+                                                    k4a_playback_data_block_t *data_block_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
     track_reader_t *track_reader = get_track_reader_by_name(context, track_name);
     if (track_reader == nullptr)
     {
@@ -527,13 +1013,83 @@ k4a_stream_result_t k4a_playback_get_previous_data_block(k4a_playback_t playback
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    if (check_track_reader_is_builtin(context, track_reader))
+    return get_data_block(context, &context->cursor, track_reader, data_block_handle, true);
+}
+
+k4a_stream_result_t k4a_playback_get_previous_raw_block(k4a_playback_t playback_handle,
+                                                        const char *track_name,
+                                                        k4a_playback_data_block_t *data_block_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    track_reader_t *track_reader = get_track_reader_by_name(context, track_name);
+    if (track_reader == nullptr)
     {
-        LOG_ERROR("k4a_playback_get_previous_data_block cannot be used with the built-in track: %s", track_name);
+        LOG_ERROR("Track name cannot be found: %s", track_name);
         return K4A_STREAM_RESULT_FAILED;
     }
 
-    return get_data_block(context, track_reader, data_block_handle, false);
+    return get_data_block(context, &context->cursor, track_reader, data_block_handle, false);
+}
+
+k4a_buffer_result_t k4a_playback_get_data_blocks(k4a_playback_t playback_handle,
+                                                 const char *track_name,
+                                                 uint64_t start_device_timestamp_usec,
+                                                 uint64_t end_device_timestamp_usec,
+                                                 k4a_playback_data_block_info_t *blocks,
+                                                 size_t max_block_count,
+                                                 uint8_t *buffer,
+                                                 size_t buffer_size,
+                                                 size_t *block_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, blocks == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, max_block_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, block_count == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, start_device_timestamp_usec > end_device_timestamp_usec);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    track_reader_t *track_reader = get_custom_track_reader(context, track_name, "k4a_playback_get_data_blocks");
+    if (track_reader == nullptr)
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    // Block timestamps are stored relative to the start of the recording.
+    uint64_t start_offset_usec = context->record_config.start_timestamp_offset_usec;
+    uint64_t start_ns = start_device_timestamp_usec > start_offset_usec ?
+                            (start_device_timestamp_usec - start_offset_usec) * 1000 :
+                            0;
+    uint64_t end_ns = end_device_timestamp_usec > start_offset_usec ?
+                          (end_device_timestamp_usec - start_offset_usec) * 1000 :
+                          0;
+
+    return get_data_blocks(context,
+                           track_reader,
+                           start_ns,
+                           end_ns,
+                           blocks,
+                           max_block_count,
+                           buffer,
+                           buffer_size,
+                           block_count);
 }
 
 uint64_t k4a_playback_data_block_get_device_timestamp_usec(k4a_playback_data_block_t data_block_handle)
@@ -549,6 +1105,10 @@ size_t k4a_playback_data_block_get_buffer_size(k4a_playback_data_block_t data_bl
     RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_playback_data_block_t, data_block_handle);
     k4a_playback_data_block_context_t *data_block_context = k4a_playback_data_block_t_get_context(data_block_handle);
     RETURN_VALUE_IF_ARG(0, data_block_context == NULL);
+    if (data_block_context->cluster != nullptr)
+    {
+        return data_block_context->cluster_buffer_size;
+    }
     return data_block_context->data_block.size();
 }
 
@@ -557,6 +1117,10 @@ uint8_t *k4a_playback_data_block_get_buffer(k4a_playback_data_block_t data_block
     RETURN_VALUE_IF_HANDLE_INVALID(nullptr, k4a_playback_data_block_t, data_block_handle);
     k4a_playback_data_block_context_t *data_block_context = k4a_playback_data_block_t_get_context(data_block_handle);
     RETURN_VALUE_IF_ARG(nullptr, data_block_context == NULL);
+    if (data_block_context->cluster != nullptr)
+    {
+        return data_block_context->cluster_buffer;
+    }
     return data_block_context->data_block.data();
 }
 
@@ -574,64 +1138,71 @@ k4a_result_t k4a_playback_seek_timestamp(k4a_playback_t playback_handle,
 
     k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->segment == nullptr);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
-                        origin != K4A_PLAYBACK_SEEK_BEGIN && origin != K4A_PLAYBACK_SEEK_END &&
-                            origin != K4A_PLAYBACK_SEEK_DEVICE_TIME);
 
-    // If seeking to a device timestamp, calculate the offset relative to the start of file.
-    if (origin == K4A_PLAYBACK_SEEK_DEVICE_TIME)
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
     {
-        origin = K4A_PLAYBACK_SEEK_BEGIN;
-        offset_usec -= (int64_t)context->record_config.start_timestamp_offset_usec;
+        return K4A_RESULT_FAILED;
     }
 
-    // Clamp the offset timestamp so the seek direction is correct reletive to the specified origin.
-    if (origin == K4A_PLAYBACK_SEEK_BEGIN && offset_usec < 0)
-    {
-        offset_usec = 0;
-    }
-    else if (origin == K4A_PLAYBACK_SEEK_END && offset_usec > 0)
+    return seek_timestamp(context, &context->cursor, offset_usec, origin);
+}
+
+uint64_t k4a_playback_get_frame_count(k4a_playback_t playback_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_playback_t, playback_handle);
+
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
     {
-        offset_usec = 0;
+        return 0;
     }
 
-    uint64_t target_time_ns = 0;
-    if (origin == K4A_PLAYBACK_SEEK_END)
+    if (K4A_FAILED(TRACE_CALL(build_frame_index(context))))
     {
-        uint64_t offset_ns = (uint64_t)(-offset_usec * 1000);
-        if (offset_ns > context->last_file_timestamp_ns)
-        {
-            // If the target timestamp is negative, clamp to 0 so we don't underflow.
-            target_time_ns = 0;
-        }
-        else
-        {
-            target_time_ns = context->last_file_timestamp_ns + 1 - offset_ns;
-        }
+        return 0;
     }
-    else
+    return context->frame_index.size();
+}
+
+k4a_result_t k4a_playback_seek_frame(k4a_playback_t playback_handle, uint64_t frame_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
     {
-        target_time_ns = (uint64_t)offset_usec * 1000;
+        return K4A_RESULT_FAILED;
     }
 
-    cluster_info_t *seek_cluster_info = find_cluster(context, target_time_ns);
-    if (seek_cluster_info == NULL)
+    return seek_frame(context, &context->cursor, frame_index);
+}
+
+k4a_result_t k4a_playback_get_frame_offset(k4a_playback_t playback_handle, uint64_t frame_index, uint64_t *offset_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, offset_usec == NULL);
+
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))) || K4A_FAILED(TRACE_CALL(build_frame_index(context))))
     {
-        LOG_ERROR("Failed to find cluster for timestamp: %llu ns", target_time_ns);
         return K4A_RESULT_FAILED;
     }
 
-    std::shared_ptr<loaded_cluster_t> seek_cluster = load_cluster(context, seek_cluster_info);
-    if (seek_cluster == nullptr || seek_cluster->cluster == nullptr)
+    uint64_t frame_count = context->frame_index.size();
+    if (frame_index >= frame_count)
     {
-        LOG_ERROR("Failed to load data cluster at timestamp: %llu ns", target_time_ns);
+        LOG_ERROR("Frame %llu is past the end of the recording, which has %llu frames.", frame_index, frame_count);
         return K4A_RESULT_FAILED;
     }
 
-    context->seek_cluster = seek_cluster;
-    reset_seek_pointers(context, target_time_ns);
-
+    // Matches the offset seek_frame() seeks to
+    *offset_usec = context->frame_index[(size_t)frame_index] / 1000;
     return K4A_RESULT_SUCCEEDED;
 }
 
@@ -641,6 +1212,11 @@ uint64_t k4a_playback_get_recording_length_usec(k4a_playback_t playback_handle)
 
     k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
     RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return 0;
+    }
     return context->last_file_timestamp_ns / 1000;
 }
 
@@ -650,9 +1226,218 @@ uint64_t k4a_playback_get_last_timestamp_usec(k4a_playback_t playback_handle)
 
     k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
     RETURN_VALUE_IF_ARG(0, context == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return 0;
+    }
     return context->last_file_timestamp_ns / 1000;
 }
 
+k4a_result_t k4a_playback_cursor_create(k4a_playback_t playback_handle, k4a_playback_cursor_t *cursor_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor_handle == NULL);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_create(cursor_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(cursor_context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // New cursors start at the beginning of the recording.
+        cursor_context->playback_context = context;
+        result = TRACE_CALL(seek_timestamp(context, &cursor_context->cursor, 0, K4A_PLAYBACK_SEEK_BEGIN));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->cursor_count++;
+    }
+    else if (cursor_context != NULL)
+    {
+        k4a_playback_cursor_t_destroy(*cursor_handle);
+        *cursor_handle = NULL;
+    }
+    return result;
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_next_capture(k4a_playback_cursor_t cursor_handle,
+                                                         k4a_capture_t *capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
+
+    return get_capture(cursor_context->playback_context, &cursor_context->cursor, capture_handle, true);
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_previous_capture(k4a_playback_cursor_t cursor_handle,
+                                                             k4a_capture_t *capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
+
+    return get_capture(cursor_context->playback_context, &cursor_context->cursor, capture_handle, false);
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_next_imu_sample(k4a_playback_cursor_t cursor_handle,
+                                                            k4a_imu_sample_t *imu_sample)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_sample == NULL);
+
+    return get_imu_sample(cursor_context->playback_context, &cursor_context->cursor, imu_sample, true);
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_previous_imu_sample(k4a_playback_cursor_t cursor_handle,
+                                                                k4a_imu_sample_t *imu_sample)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_sample == NULL);
+
+    return get_imu_sample(cursor_context->playback_context, &cursor_context->cursor, imu_sample, false);
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_next_data_block(k4a_playback_cursor_t cursor_handle,
+                                                            const char *track_name,
+                                                            k4a_playback_data_block_t *data_block_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
+
+    k4a_playback_context_t *context = cursor_context->playback_context;
+    track_reader_t *track_reader = get_custom_track_reader(context,
+                                                           track_name,
+                                                           "k4a_playback_cursor_get_next_data_block");
+    if (track_reader == nullptr)
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_data_block(context, &cursor_context->cursor, track_reader, data_block_handle, true);
+}
+
+k4a_stream_result_t k4a_playback_cursor_get_previous_data_block(k4a_playback_cursor_t cursor_handle,
+                                                                const char *track_name,
+                                                                k4a_playback_data_block_t *data_block_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, cursor_context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
+
+    k4a_playback_context_t *context = cursor_context->playback_context;
+    track_reader_t *track_reader = get_custom_track_reader(context,
+                                                           track_name,
+                                                           "k4a_playback_cursor_get_previous_data_block");
+    if (track_reader == nullptr)
+    {
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    return get_data_block(context, &cursor_context->cursor, track_reader, data_block_handle, false);
+}
+
+k4a_result_t k4a_playback_cursor_seek_timestamp(k4a_playback_cursor_t cursor_handle,
+                                                int64_t offset_usec,
+                                                k4a_playback_seek_origin_t origin)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor_context == NULL);
+
+    return seek_timestamp(cursor_context->playback_context, &cursor_context->cursor, offset_usec, origin);
+}
+
+k4a_result_t k4a_playback_cursor_seek_frame(k4a_playback_cursor_t cursor_handle, uint64_t frame_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_cursor_t, cursor_handle);
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cursor_context == NULL);
+
+    return seek_frame(cursor_context->playback_context, &cursor_context->cursor, frame_index);
+}
+
+void k4a_playback_cursor_destroy(k4a_playback_cursor_t cursor_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_playback_cursor_t, cursor_handle);
+
+    k4a_playback_cursor_context_t *cursor_context = k4a_playback_cursor_t_get_context(cursor_handle);
+    if (cursor_context != NULL && cursor_context->playback_context != NULL)
+    {
+        cursor_context->playback_context->cursor_count--;
+    }
+    k4a_playback_cursor_t_destroy(cursor_handle);
+}
+
+k4a_result_t k4a_playback_process_range(k4a_playback_t playback_handle,
+                                        uint64_t start_usec,
+                                        uint64_t end_usec,
+                                        uint32_t worker_count,
+                                        bool in_order,
+                                        k4a_playback_capture_cb_t *callback,
+                                        void *callback_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, worker_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, callback == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, start_usec > UINT64_MAX / 1000);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    uint64_t end_ns = end_usec > UINT64_MAX / 1000 ? UINT64_MAX : end_usec * 1000;
+    return process_range(context, start_usec * 1000, end_ns, worker_count, in_order, callback, callback_context);
+}
+
+k4a_result_t k4a_playback_write_range(k4a_playback_t playback_handle,
+                                      const char *path,
+                                      uint64_t start_usec,
+                                      uint64_t end_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, start_usec > end_usec);
+
+    if (K4A_FAILED(TRACE_CALL(load_clusters(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(load_attachments(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    uint64_t start_ns = start_usec > UINT64_MAX / 1000 ? UINT64_MAX : start_usec * 1000;
+    uint64_t end_ns = end_usec > UINT64_MAX / 1000 ? UINT64_MAX : end_usec * 1000;
+    return TRACE_CALL(write_cluster_range(context, path, start_ns, end_ns));
+}
+
 void k4a_playback_close(const k4a_playback_t playback_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_playback_t, playback_handle);
@@ -661,12 +1446,22 @@ void k4a_playback_close(const k4a_playback_t playback_handle)
     if (context != NULL)
     {
         LOG_TRACE("File reading stats:", 0);
-        LOG_TRACE("  Seek count: %llu", context->seek_count);
-        LOG_TRACE("  Cluster load count: %llu", context->load_count);
-        LOG_TRACE("  Cluster cache hits: %llu", context->cache_hits);
+        LOG_TRACE("  Seek count: %llu", context->seek_count.load());
+        LOG_TRACE("  Cluster load count: %llu", context->load_count.load());
+        LOG_TRACE("  Cluster cache hits: %llu", context->cache_hits.load());
+
+        if (context->cursor_count > 0)
+        {
+            LOG_ERROR("Playback closed with %u cursors that were not destroyed.", context->cursor_count.load());
+        }
 
         context->file_closing = true;
 
+        clear_color_read_ahead(context, &context->cursor);
+        destroy_turbojpeg_handles(context);
+        close_image_buffer_pool(context);
+        set_cluster_lru_budget(context, 0);
+
         try
         {
             try
@@ -0,0 +1,362 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <future>
+#include <system_error>
+#include <vector>
+
+#include <k4a/k4a.h>
+#include <k4arecord/playback.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/common.h>
+
+// A recording of a playback group. The next capture of each recording is read in the background, so the recordings of
+// a group are read at the same time and while the application processes the previous captures.
+typedef struct _group_member_t
+{
+    k4a_playback_t playback = NULL;
+    k4a_record_configuration_t config = {};
+
+    // The next capture of the recording, valid once read has completed.
+    std::future<k4a_stream_result_t> read;
+    k4a_stream_result_t read_result = K4A_STREAM_RESULT_EOF;
+    k4a_capture_t capture = NULL;
+    uint64_t sync_timestamp_usec = 0; // The timestamp of capture in the device time of the master
+} group_member_t;
+
+typedef struct _k4a_playback_group_context_t
+{
+    std::vector<group_member_t> members; // In the order of the paths or devices the group was opened with
+    uint64_t match_window_usec;          // Captures less than this far apart were taken at the same time
+
+    // Reading starts with the first captures, so the playback settings of each recording can still be changed
+    bool reading;
+} k4a_playback_group_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_playback_group_t, k4a_playback_group_context_t);
+
+static void start_read(group_member_t *member)
+{
+    auto read = [member]() { return k4a_playback_get_next_capture(member->playback, &member->capture); };
+    try
+    {
+        member->read = std::async(std::launch::async, read);
+    }
+    catch (std::system_error &e)
+    {
+        // The capture is read when it is needed instead.
+        LOG_WARNING("Failed to start reading ahead: %s", e.what());
+        member->read = std::async(std::launch::deferred, read);
+    }
+}
+
+// Returns the timestamp of a capture in the device time of the master. Depth and IR images are taken
+// depth_delay_off_color_usec after the color image, and subordinates are triggered subordinate_delay_off_master_usec
+// after the master.
+static uint64_t get_sync_timestamp(const group_member_t *member, k4a_capture_t capture)
+{
+    int64_t delay_usec = (int64_t)member->config.subordinate_delay_off_master_usec;
+    k4a_image_t image = k4a_capture_get_color_image(capture);
+    if (image == NULL)
+    {
+        delay_usec += member->config.depth_delay_off_color_usec;
+        image = k4a_capture_get_depth_image(capture);
+        if (image == NULL)
+        {
+            image = k4a_capture_get_ir_image(capture);
+        }
+    }
+    if (image == NULL)
+    {
+        return 0;
+    }
+
+    int64_t timestamp_usec = (int64_t)k4a_image_get_device_timestamp_usec(image) - delay_usec;
+    k4a_image_release(image);
+    return timestamp_usec < 0 ? 0 : (uint64_t)timestamp_usec;
+}
+
+static void wait_read(group_member_t *member)
+{
+    if (member->read.valid())
+    {
+        member->read_result = member->read.get();
+        if (member->read_result == K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            member->sync_timestamp_usec = get_sync_timestamp(member, member->capture);
+        }
+    }
+}
+
+static void clear_reads(k4a_playback_group_context_t *context)
+{
+    for (group_member_t &member : context->members)
+    {
+        wait_read(&member);
+        if (member.capture != NULL)
+        {
+            k4a_capture_release(member.capture);
+            member.capture = NULL;
+        }
+        member.read_result = K4A_STREAM_RESULT_EOF;
+    }
+}
+
+// Opens a group of path_count members, member i plays back device device_indices[i] of the recording paths[i]
+static k4a_result_t open_group(const char **paths,
+                               const uint32_t *device_indices,
+                               size_t path_count,
+                               k4a_playback_group_t *group_handle)
+{
+    k4a_playback_group_context_t *context = k4a_playback_group_t_create(group_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->members = std::vector<group_member_t>(path_count);
+
+        // Opening a recording mostly waits for the disk, so the recordings are opened at the same time.
+        std::vector<std::future<k4a_result_t>> opens;
+        for (size_t i = 0; i < path_count; i++)
+        {
+            group_member_t *member = &context->members[i];
+            const char *path = paths[i];
+            uint32_t device_index = device_indices[i];
+            auto open = [member, path, device_index]() {
+                k4a_result_t open_result = TRACE_CALL(
+                    k4a_playback_open_device(path, device_index, &member->playback));
+                if (K4A_SUCCEEDED(open_result))
+                {
+                    open_result = TRACE_CALL(k4a_playback_get_record_configuration(member->playback, &member->config));
+                }
+                return open_result;
+            };
+            try
+            {
+                opens.push_back(std::async(std::launch::async, open));
+            }
+            catch (std::system_error &)
+            {
+                opens.push_back(std::async(std::launch::deferred, open));
+            }
+        }
+
+        for (size_t i = 0; i < path_count; i++)
+        {
+            if (K4A_FAILED(opens[i].get()))
+            {
+                LOG_ERROR("Failed to open device %u of recording '%s' of the playback group.",
+                          device_indices[i],
+                          paths[i]);
+                result = K4A_RESULT_FAILED;
+            }
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        size_t master_count = 0;
+        context->match_window_usec = UINT64_MAX;
+        context->reading = false;
+        for (group_member_t &member : context->members)
+        {
+            if (member.config.wired_sync_mode == K4A_WIRED_SYNC_MODE_MASTER)
+            {
+                master_count++;
+            }
+
+            uint32_t fps = k4a_convert_fps_to_uint(member.config.camera_fps);
+            if (fps > 0 && HZ_TO_PERIOD_US(fps) / 2 < context->match_window_usec)
+            {
+                context->match_window_usec = HZ_TO_PERIOD_US(fps) / 2;
+            }
+        }
+
+        if (master_count > 1)
+        {
+            LOG_ERROR("The playback group has %llu master recordings, a synchronized rig has one.",
+                      (unsigned long long)master_count);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_FAILED(result) && context != NULL)
+    {
+        for (group_member_t &member : context->members)
+        {
+            if (member.playback != NULL)
+            {
+                k4a_playback_close(member.playback);
+            }
+        }
+        k4a_playback_group_t_destroy(*group_handle);
+        *group_handle = NULL;
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_playback_group_open(const char **paths, size_t path_count, k4a_playback_group_t *group_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, paths == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, group_handle == NULL);
+    for (size_t i = 0; i < path_count; i++)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, paths[i] == NULL);
+    }
+
+    std::vector<uint32_t> device_indices(path_count, 0);
+    return open_group(paths, device_indices.data(), path_count, group_handle);
+}
+
+k4a_result_t k4a_playback_group_open_devices(const char *path, k4a_playback_group_t *group_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, group_handle == NULL);
+
+    // Only the tags are needed to count the devices, the members open the recording in full.
+    k4a_playback_t playback = NULL;
+    if (K4A_FAILED(TRACE_CALL(k4a_playback_open_lazy(path, &playback))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    uint32_t device_count = k4a_playback_get_device_count(playback);
+    k4a_playback_close(playback);
+
+    std::vector<const char *> paths(device_count, path);
+    std::vector<uint32_t> device_indices(device_count);
+    for (uint32_t i = 0; i < device_count; i++)
+    {
+        device_indices[i] = i;
+    }
+    return open_group(paths.data(), device_indices.data(), device_count, group_handle);
+}
+
+k4a_playback_t k4a_playback_group_get_playback(k4a_playback_group_t group_handle, size_t index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    RETURN_VALUE_IF_ARG(NULL, context == NULL);
+    RETURN_VALUE_IF_ARG(NULL, index >= context->members.size());
+
+    return context->members[index].playback;
+}
+
+k4a_stream_result_t k4a_playback_group_get_next_captures(k4a_playback_group_t group_handle,
+                                                         k4a_capture_t *capture_handles,
+                                                         size_t capture_count,
+                                                         uint64_t *sync_timestamp_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handles == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_count != context->members.size());
+
+    if (!context->reading)
+    {
+        for (group_member_t &member : context->members)
+        {
+            start_read(&member);
+        }
+        context->reading = true;
+    }
+
+    bool found = false;
+    uint64_t first_timestamp_usec = UINT64_MAX;
+    for (size_t i = 0; i < capture_count; i++)
+    {
+        capture_handles[i] = NULL;
+
+        group_member_t *member = &context->members[i];
+        wait_read(member);
+        if (member->read_result == K4A_STREAM_RESULT_FAILED)
+        {
+            LOG_ERROR("Failed to read recording %llu of the playback group.", (unsigned long long)i);
+            return K4A_STREAM_RESULT_FAILED;
+        }
+        if (member->read_result == K4A_STREAM_RESULT_SUCCEEDED && member->sync_timestamp_usec < first_timestamp_usec)
+        {
+            first_timestamp_usec = member->sync_timestamp_usec;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return K4A_STREAM_RESULT_EOF;
+    }
+
+    for (size_t i = 0; i < capture_count; i++)
+    {
+        group_member_t *member = &context->members[i];
+        if (member->read_result == K4A_STREAM_RESULT_SUCCEEDED &&
+            member->sync_timestamp_usec - first_timestamp_usec < context->match_window_usec)
+        {
+            capture_handles[i] = member->capture;
+            member->capture = NULL;
+            start_read(member);
+        }
+    }
+
+    if (sync_timestamp_usec != NULL)
+    {
+        *sync_timestamp_usec = first_timestamp_usec;
+    }
+    return K4A_STREAM_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_group_seek_timestamp(k4a_playback_group_t group_handle, uint64_t sync_timestamp_usec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sync_timestamp_usec > INT64_MAX / 2);
+
+    clear_reads(context);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (group_member_t &member : context->members)
+    {
+        int64_t device_timestamp_usec = (int64_t)sync_timestamp_usec +
+                                        (int64_t)member.config.subordinate_delay_off_master_usec;
+        if (K4A_FAILED(TRACE_CALL(
+                k4a_playback_seek_timestamp(member.playback, device_timestamp_usec, K4A_PLAYBACK_SEEK_DEVICE_TIME))))
+        {
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    // If a recording failed to seek, the next read fails instead of matching captures from different times.
+    for (group_member_t &member : context->members)
+    {
+        if (K4A_SUCCEEDED(result))
+        {
+            start_read(&member);
+        }
+        else
+        {
+            member.read_result = K4A_STREAM_RESULT_FAILED;
+        }
+    }
+    context->reading = true;
+    return result;
+}
+
+void k4a_playback_group_close(k4a_playback_group_t group_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+
+    if (context != NULL)
+    {
+        clear_reads(context);
+        for (group_member_t &member : context->members)
+        {
+            k4a_playback_close(member.playback);
+        }
+    }
+    k4a_playback_group_t_destroy(group_handle);
+}
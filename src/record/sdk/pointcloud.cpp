@@ -0,0 +1,400 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <k4a/k4a.h>
+#include <k4arecord/pointcloud.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/common.h>
+
+// Points are converted into a buffer of this size and written a buffer at a time
+#define POINT_CLOUD_WRITE_BUFFER_BYTES (1024 * 1024)
+
+// Point clouds queued by a background writer before k4a_point_cloud_writer_write() waits
+#define POINT_CLOUD_QUEUE_LIMIT 4
+
+// A point cloud waiting to be written, which holds a reference to its images
+typedef struct _point_cloud_job_t
+{
+    std::string path;
+    k4a_image_t xyz_image;
+    k4a_image_t color_image; // NULL without color
+} point_cloud_job_t;
+
+typedef struct _k4a_point_cloud_writer_context_t
+{
+    k4a_point_cloud_file_format_t format;
+    std::thread writer_thread;
+
+    std::mutex lock; // Locks access to the members below
+    std::condition_variable queue_condition;
+    std::deque<point_cloud_job_t> queue;
+    bool writing; // Set while the writer thread writes a job it removed from the queue
+    bool failed;  // Set when a file fails to be written, cleared by k4a_point_cloud_writer_flush()
+    bool closing;
+} k4a_point_cloud_writer_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_point_cloud_writer_t, k4a_point_cloud_writer_context_t);
+
+static size_t point_cloud_point_size(k4a_point_cloud_file_format_t format, bool float_points, bool has_color)
+{
+    size_t size = float_points ? 3 * sizeof(float) : 3 * sizeof(int16_t);
+    if (has_color)
+    {
+        // 3 bytes of red, green and blue in a PLY file, a packed 4 byte rgb field in a PCD file
+        size += format == K4A_POINT_CLOUD_FILE_FORMAT_PLY ? 3 : 4;
+    }
+    return size;
+}
+
+static k4a_result_t validate_point_cloud_images(k4a_image_t xyz_image, k4a_image_t color_image)
+{
+    int width = k4a_image_get_width_pixels(xyz_image);
+    int height = k4a_image_get_height_pixels(xyz_image);
+    int stride = k4a_image_get_stride_bytes(xyz_image);
+
+    if (width <= 0 || height <= 0 || k4a_image_get_buffer(xyz_image) == NULL ||
+        (stride != width * 3 * (int)sizeof(int16_t) && stride != width * 3 * (int)sizeof(float)))
+    {
+        LOG_ERROR("The point cloud image must have a stride of 6 or 12 bytes per pixel.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (color_image != NULL &&
+        (k4a_image_get_format(color_image) != K4A_IMAGE_FORMAT_COLOR_BGRA32 ||
+         k4a_image_get_width_pixels(color_image) != width || k4a_image_get_height_pixels(color_image) != height ||
+         k4a_image_get_stride_bytes(color_image) < width * 4 || k4a_image_get_buffer(color_image) == NULL))
+    {
+        LOG_ERROR("The color image must be a BGRA32 image of the size of the point cloud image.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static size_t count_valid_points(const uint8_t *xyz, int width, int height, bool float_points)
+{
+    size_t count = 0;
+    size_t pixel_count = (size_t)width * (size_t)height;
+    if (float_points)
+    {
+        const float *points = (const float *)(const void *)xyz;
+        for (size_t i = 0; i < pixel_count; i++)
+        {
+            count += points[3 * i + 2] != 0.0f;
+        }
+    }
+    else
+    {
+        const int16_t *points = (const int16_t *)(const void *)xyz;
+        for (size_t i = 0; i < pixel_count; i++)
+        {
+            count += points[3 * i + 2] != 0;
+        }
+    }
+    return count;
+}
+
+static std::string point_cloud_header(k4a_point_cloud_file_format_t format,
+                                      bool float_points,
+                                      bool has_color,
+                                      size_t point_count)
+{
+    std::string header;
+    std::string count = std::to_string(point_count);
+    if (format == K4A_POINT_CLOUD_FILE_FORMAT_PLY)
+    {
+        const char *type = float_points ? "float" : "short";
+        header = "ply\nformat binary_little_endian 1.0\nelement vertex " + count + "\n";
+        header += std::string("property ") + type + " x\nproperty " + type + " y\nproperty " + type + " z\n";
+        if (has_color)
+        {
+            header += "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+        }
+        header += "end_header\n";
+    }
+    else
+    {
+        header = "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\n";
+        header += has_color ? "FIELDS x y z rgb\n" : "FIELDS x y z\n";
+        header += float_points ? "SIZE 4 4 4" : "SIZE 2 2 2";
+        header += has_color ? " 4\n" : "\n";
+        header += float_points ? "TYPE F F F" : "TYPE I I I";
+        header += has_color ? " U\n" : "\n";
+        header += has_color ? "COUNT 1 1 1 1\n" : "COUNT 1 1 1\n";
+        header += "WIDTH " + count + "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS " + count + "\nDATA binary\n";
+    }
+    return header;
+}
+
+// Writes the file of a point cloud. The files are little endian, which is the byte order of every platform the SDK
+// supports, so points are copied without swapping bytes.
+static k4a_result_t write_point_cloud(k4a_point_cloud_writer_context_t *context, const point_cloud_job_t &job)
+{
+    int width = k4a_image_get_width_pixels(job.xyz_image);
+    int height = k4a_image_get_height_pixels(job.xyz_image);
+    bool float_points = k4a_image_get_stride_bytes(job.xyz_image) == width * 3 * (int)sizeof(float);
+    bool has_color = job.color_image != NULL;
+    const uint8_t *xyz = k4a_image_get_buffer(job.xyz_image);
+    const uint8_t *color = has_color ? k4a_image_get_buffer(job.color_image) : NULL;
+    int color_stride = has_color ? k4a_image_get_stride_bytes(job.color_image) : 0;
+
+    size_t xyz_size = float_points ? 3 * sizeof(float) : 3 * sizeof(int16_t);
+    size_t point_size = point_cloud_point_size(context->format, float_points, has_color);
+    size_t point_count = count_valid_points(xyz, width, height, float_points);
+    std::string header = point_cloud_header(context->format, float_points, has_color, point_count);
+
+    FILE *file = fopen(job.path.c_str(), "wb");
+    if (file == NULL)
+    {
+        LOG_ERROR("Failed to open point cloud file: %s", job.path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    // Writes are already a buffer at a time, the stream buffer would only add a copy
+    setvbuf(file, NULL, _IONBF, 0);
+
+    std::vector<uint8_t> buffer_storage(POINT_CLOUD_WRITE_BUFFER_BYTES);
+    uint8_t *buffer = buffer_storage.data();
+    size_t used = 0;
+
+    bool written = fwrite(header.data(), 1, header.size(), file) == header.size();
+    for (int y = 0; written && y < height; y++)
+    {
+        const uint8_t *xyz_row = xyz + (size_t)y * (size_t)width * xyz_size;
+        const uint8_t *color_row = has_color ? color + (size_t)y * (size_t)color_stride : NULL;
+        for (int x = 0; x < width; x++)
+        {
+            const uint8_t *point = xyz_row + (size_t)x * xyz_size;
+            bool valid;
+            if (float_points)
+            {
+                float z;
+                memcpy(&z, point + 2 * sizeof(float), sizeof(z));
+                valid = z != 0.0f;
+            }
+            else
+            {
+                int16_t z;
+                memcpy(&z, point + 2 * sizeof(int16_t), sizeof(z));
+                valid = z != 0;
+            }
+            if (!valid)
+            {
+                continue;
+            }
+
+            if (used + point_size > POINT_CLOUD_WRITE_BUFFER_BYTES)
+            {
+                written = fwrite(buffer, 1, used, file) == used;
+                used = 0;
+                if (!written)
+                {
+                    break;
+                }
+            }
+
+            uint8_t *out = buffer + used;
+            memcpy(out, point, xyz_size);
+            if (has_color)
+            {
+                const uint8_t *bgra = color_row + 4 * x;
+                if (context->format == K4A_POINT_CLOUD_FILE_FORMAT_PLY)
+                {
+                    out[xyz_size + 0] = bgra[2];
+                    out[xyz_size + 1] = bgra[1];
+                    out[xyz_size + 2] = bgra[0];
+                }
+                else
+                {
+                    // PCD packs rgb as the uint32_t 0x00RRGGBB, which is the BGRA bytes in little endian order
+                    out[xyz_size + 0] = bgra[0];
+                    out[xyz_size + 1] = bgra[1];
+                    out[xyz_size + 2] = bgra[2];
+                    out[xyz_size + 3] = 0;
+                }
+            }
+            used += point_size;
+        }
+    }
+
+    if (written && used > 0)
+    {
+        written = fwrite(buffer, 1, used, file) == used;
+    }
+
+    if (fclose(file) != 0)
+    {
+        written = false;
+    }
+
+    if (!written)
+    {
+        LOG_ERROR("Failed to write point cloud file: %s", job.path.c_str());
+    }
+    return K4A_RESULT_FROM_BOOL(written);
+}
+
+static void release_job(point_cloud_job_t &job)
+{
+    k4a_image_release(job.xyz_image);
+    if (job.color_image != NULL)
+    {
+        k4a_image_release(job.color_image);
+    }
+}
+
+static void point_cloud_writer_thread(k4a_point_cloud_writer_context_t *context)
+{
+    std::unique_lock<std::mutex> lock(context->lock);
+    while (true)
+    {
+        context->queue_condition.wait(lock, [context] { return context->closing || !context->queue.empty(); });
+        if (context->queue.empty())
+        {
+            // Closing, and every queued point cloud is written
+            return;
+        }
+
+        point_cloud_job_t job = context->queue.front();
+        context->queue.pop_front();
+        context->writing = true;
+        lock.unlock();
+
+        // Wake a caller waiting for room in the queue
+        context->queue_condition.notify_all();
+        k4a_result_t result = write_point_cloud(context, job);
+        release_job(job);
+
+        lock.lock();
+        context->writing = false;
+        if (K4A_FAILED(result))
+        {
+            context->failed = true;
+        }
+        context->queue_condition.notify_all();
+    }
+}
+
+k4a_result_t k4a_point_cloud_writer_create(k4a_point_cloud_file_format_t format,
+                                           bool background,
+                                           k4a_point_cloud_writer_t *writer_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, writer_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        format != K4A_POINT_CLOUD_FILE_FORMAT_PLY && format != K4A_POINT_CLOUD_FILE_FORMAT_PCD);
+
+    k4a_point_cloud_writer_context_t *context = k4a_point_cloud_writer_t_create(writer_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+    if (K4A_FAILED(result))
+    {
+        return result;
+    }
+
+    context->format = format;
+    context->writing = false;
+    context->failed = false;
+    context->closing = false;
+
+    if (background)
+    {
+        try
+        {
+            context->writer_thread = std::thread(point_cloud_writer_thread, context);
+        }
+        catch (const std::system_error &e)
+        {
+            LOG_ERROR("Failed to start the point cloud writer thread: %s", e.what());
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_FAILED(result))
+    {
+        k4a_point_cloud_writer_t_destroy(*writer_handle);
+        *writer_handle = NULL;
+    }
+    return result;
+}
+
+k4a_result_t k4a_point_cloud_writer_write(k4a_point_cloud_writer_t writer_handle,
+                                          const char *path,
+                                          k4a_image_t xyz_image,
+                                          k4a_image_t color_image)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_point_cloud_writer_t, writer_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, xyz_image == NULL);
+    k4a_point_cloud_writer_context_t *context = k4a_point_cloud_writer_t_get_context(writer_handle);
+
+    if (K4A_FAILED(validate_point_cloud_images(xyz_image, color_image)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    point_cloud_job_t job;
+    job.path = path;
+    job.xyz_image = xyz_image;
+    job.color_image = color_image;
+
+    if (!context->writer_thread.joinable())
+    {
+        return write_point_cloud(context, job);
+    }
+
+    k4a_image_reference(xyz_image);
+    if (color_image != NULL)
+    {
+        k4a_image_reference(color_image);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(context->lock);
+        context->queue_condition.wait(lock, [context] { return context->queue.size() < POINT_CLOUD_QUEUE_LIMIT; });
+        context->queue.push_back(job);
+    }
+    context->queue_condition.notify_all();
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_point_cloud_writer_flush(k4a_point_cloud_writer_t writer_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_point_cloud_writer_t, writer_handle);
+    k4a_point_cloud_writer_context_t *context = k4a_point_cloud_writer_t_get_context(writer_handle);
+
+    std::unique_lock<std::mutex> lock(context->lock);
+    context->queue_condition.wait(lock, [context] { return context->queue.empty() && !context->writing; });
+    bool failed = context->failed;
+    context->failed = false;
+    return K4A_RESULT_FROM_BOOL(!failed);
+}
+
+void k4a_point_cloud_writer_close(k4a_point_cloud_writer_t writer_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_point_cloud_writer_t, writer_handle);
+    k4a_point_cloud_writer_context_t *context = k4a_point_cloud_writer_t_get_context(writer_handle);
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        context->closing = true;
+    }
+    context->queue_condition.notify_all();
+
+    if (context->writer_thread.joinable())
+    {
+        context->writer_thread.join();
+    }
+
+    k4a_point_cloud_writer_t_destroy(writer_handle);
+}
@@ -1,58 +1,99 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <sstream>
 
+#include <ebml/MemIOCallback.h>
+
 #include <k4a/k4a.h>
 #include <k4arecord/record.h>
 #include <k4ainternal/matroska_write.h>
 #include <k4ainternal/logging.h>
+#include <k4ainternal/metrics.h>
 #include <k4ainternal/common.h>
 
 using namespace k4arecord;
 using namespace LIBMATROSKA_NAMESPACE;
 
-k4a_result_t k4a_record_create(const char *path,
-                               k4a_device_t device,
-                               const k4a_device_configuration_t device_config,
-                               k4a_record_t *recording_handle)
+// DataBuffer pointing at the buffer of an image instead of a copy of it. The reference to the image is released when
+// the buffer is freed, after the cluster containing it has been written to disk.
+class ImageDataBuffer : public DataBuffer
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
-    k4a_record_context_t *context = NULL;
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+public:
+    ImageDataBuffer(k4a_image_t image, binary *buffer, uint32 size) :
+        DataBuffer(buffer, size, &ImageDataBuffer::ReleaseImage, false),
+        m_image(image)
+    {
+    }
 
-    context = k4a_record_t_create(recording_handle);
-    result = K4A_RESULT_FROM_BOOL(context != NULL);
+private:
+    static bool ReleaseImage(const DataBuffer &buffer)
+    {
+        k4a_image_release(static_cast<const ImageDataBuffer &>(buffer).m_image);
+        return true;
+    }
 
-    if (K4A_SUCCEEDED(result))
+    k4a_image_t m_image;
+};
+
+// DataBuffer pointing at a buffer passed to k4a_record_write_custom_track_data_owned(). The release callback is called
+// when the buffer is freed, after the cluster containing it has been written to disk.
+class CustomDataBuffer : public DataBuffer
+{
+public:
+    CustomDataBuffer(binary *buffer, uint32 size, k4a_memory_destroy_cb_t *release_cb, void *release_cb_context) :
+        DataBuffer(buffer, size, &CustomDataBuffer::ReleaseBuffer, false),
+        m_buffer(buffer),
+        m_release_cb(release_cb),
+        m_release_cb_context(release_cb_context)
     {
-        context->file_path = path;
+    }
 
-        try
-        {
-            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_CREATE);
-        }
-        catch (std::ios_base::failure &e)
-        {
-            LOG_ERROR("Unable to open file '%s': %s", path, e.what());
-            result = K4A_RESULT_FAILED;
-        }
+private:
+    static bool ReleaseBuffer(const DataBuffer &buffer)
+    {
+        const CustomDataBuffer &custom_buffer = static_cast<const CustomDataBuffer &>(buffer);
+        custom_buffer.m_release_cb(custom_buffer.m_buffer, custom_buffer.m_release_cb_context);
+        return true;
     }
 
-    if (K4A_SUCCEEDED(result))
+    binary *m_buffer;
+    k4a_memory_destroy_cb_t *m_release_cb;
+    void *m_release_cb_context;
+};
+
+// Returns the name of a track, tag or attachment of a device. The names of device 0, the device of k4a_record_create(),
+// have no suffix, those of the devices added with k4a_record_add_device() end with "_<device index>".
+static std::string device_name(const char *name, uint32_t device_index)
+{
+    if (device_index == 0)
     {
-        context->device_config = device_config;
+        return name;
+    }
+    std::ostringstream name_str;
+    name_str << name << "_" << device_index;
+    return name_str.str();
+}
 
-        context->timecode_scale = MATROSKA_TIMESCALE_NS;
-        context->camera_fps = k4a_convert_fps_to_uint(device_config.camera_fps);
-        if (context->camera_fps == 0)
-        {
-            // Set camera FPS to 30 if no cameras are enabled so IMU can still be written.
-            context->camera_fps = 30;
-        }
+// Adds the color, depth and IR tracks of a device to the recording, along with the tags describing its configuration
+// and its calibration attachment.
+static k4a_result_t add_device_tracks(k4a_record_context_t *context,
+                                      uint32_t device_index,
+                                      k4a_device_t device,
+                                      const k4a_device_configuration_t &device_config,
+                                      device_tracks_t *tracks)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    tracks->device_config = device_config;
+
+    uint32_t camera_fps = k4a_convert_fps_to_uint(device_config.camera_fps);
+    if (camera_fps == 0)
+    {
+        // Set camera FPS to 30 if no cameras are enabled so IMU can still be written.
+        camera_fps = 30;
     }
 
     uint32_t color_width = 0;
@@ -124,47 +165,35 @@ k4a_result_t k4a_record_create(const char *path,
         }
     }
 
-    if (K4A_SUCCEEDED(result))
-    {
-        context->file_segment = make_unique<KaxSegment>();
-
-        { // Setup segment info
-            auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
-
-            GetChild<KaxTimecodeScale>(segment_info).SetValue(context->timecode_scale);
-            GetChild<KaxMuxingApp>(segment_info).SetValue(L"libmatroska-1.4.9");
-            std::ostringstream version_str;
-            version_str << "k4arecord-" << K4A_VERSION_STR;
-            GetChild<KaxWritingApp>(segment_info).SetValueUTF8(version_str.str());
-            GetChild<KaxDateUTC>(segment_info).SetEpochDate(time(0));
-            GetChild<KaxTitle>(segment_info).SetValue(L"Azure Kinect");
-        }
-
-        auto &tags = GetChild<KaxTags>(*context->file_segment);
-        tags.EnableChecksum();
-    }
-
     if (K4A_SUCCEEDED(result) && device_config.color_resolution != K4A_COLOR_RESOLUTION_OFF)
     {
         BITMAPINFOHEADER codec_info = {};
         result = TRACE_CALL(
             populate_bitmap_info_header(&codec_info, color_width, color_height, device_config.color_format));
 
-        context->color_track = add_track(context,
-                                         K4A_TRACK_NAME_COLOR,
-                                         track_video,
-                                         "V_MS/VFW/FOURCC",
-                                         reinterpret_cast<uint8_t *>(&codec_info),
-                                         sizeof(codec_info));
-        if (context->color_track != nullptr)
+        tracks->color_track = add_track(context,
+                                        device_name(K4A_TRACK_NAME_COLOR, device_index).c_str(),
+                                        track_video,
+                                        "V_MS/VFW/FOURCC",
+                                        reinterpret_cast<uint8_t *>(&codec_info),
+                                        sizeof(codec_info));
+        if (tracks->color_track != nullptr)
         {
-            set_track_info_video(context->color_track, color_width, color_height, context->camera_fps);
+            set_track_info_video(tracks->color_track, color_width, color_height, camera_fps);
 
-            uint64_t track_uid = GetChild<KaxTrackUID>(*context->color_track->track).GetValue();
+            uint64_t track_uid = GetChild<KaxTrackUID>(*tracks->color_track->track).GetValue();
             std::ostringstream track_uid_str;
             track_uid_str << track_uid;
-            add_tag(context, "K4A_COLOR_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
-            add_tag(context, "K4A_COLOR_MODE", color_mode_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
+            add_tag(context,
+                    device_name("K4A_COLOR_TRACK", device_index).c_str(),
+                    track_uid_str.str().c_str(),
+                    TAG_TARGET_TYPE_TRACK,
+                    track_uid);
+            add_tag(context,
+                    device_name("K4A_COLOR_MODE", device_index).c_str(),
+                    color_mode_str.str().c_str(),
+                    TAG_TARGET_TYPE_TRACK,
+                    track_uid);
         }
         else
         {
@@ -177,7 +206,7 @@ k4a_result_t k4a_record_create(const char *path,
     {
         if (device_config.depth_mode == K4A_DEPTH_MODE_PASSIVE_IR)
         {
-            add_tag(context, "K4A_DEPTH_MODE", depth_mode_str);
+            add_tag(context, device_name("K4A_DEPTH_MODE", device_index).c_str(), depth_mode_str);
         }
         else if (device_config.depth_mode != K4A_DEPTH_MODE_OFF)
         {
@@ -186,21 +215,29 @@ k4a_result_t k4a_record_create(const char *path,
             result = TRACE_CALL(
                 populate_bitmap_info_header(&codec_info, depth_width, depth_height, K4A_IMAGE_FORMAT_DEPTH16));
 
-            context->depth_track = add_track(context,
-                                             K4A_TRACK_NAME_DEPTH,
-                                             track_video,
-                                             "V_MS/VFW/FOURCC",
-                                             reinterpret_cast<uint8_t *>(&codec_info),
-                                             sizeof(codec_info));
-            if (context->depth_track != nullptr)
+            tracks->depth_track = add_track(context,
+                                            device_name(K4A_TRACK_NAME_DEPTH, device_index).c_str(),
+                                            track_video,
+                                            "V_MS/VFW/FOURCC",
+                                            reinterpret_cast<uint8_t *>(&codec_info),
+                                            sizeof(codec_info));
+            if (tracks->depth_track != nullptr)
             {
-                set_track_info_video(context->depth_track, depth_width, depth_height, context->camera_fps);
+                set_track_info_video(tracks->depth_track, depth_width, depth_height, camera_fps);
 
-                uint64_t track_uid = GetChild<KaxTrackUID>(*context->depth_track->track).GetValue();
+                uint64_t track_uid = GetChild<KaxTrackUID>(*tracks->depth_track->track).GetValue();
                 std::ostringstream track_uid_str;
                 track_uid_str << track_uid;
-                add_tag(context, "K4A_DEPTH_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
-                add_tag(context, "K4A_DEPTH_MODE", depth_mode_str, TAG_TARGET_TYPE_TRACK, track_uid);
+                add_tag(context,
+                        device_name("K4A_DEPTH_TRACK", device_index).c_str(),
+                        track_uid_str.str().c_str(),
+                        TAG_TARGET_TYPE_TRACK,
+                        track_uid);
+                add_tag(context,
+                        device_name("K4A_DEPTH_MODE", device_index).c_str(),
+                        depth_mode_str,
+                        TAG_TARGET_TYPE_TRACK,
+                        track_uid);
             }
             else
             {
@@ -216,22 +253,26 @@ k4a_result_t k4a_record_create(const char *path,
         BITMAPINFOHEADER codec_info = {};
         result = TRACE_CALL(populate_bitmap_info_header(&codec_info, depth_width, depth_height, K4A_IMAGE_FORMAT_IR16));
 
-        context->ir_track = add_track(context,
-                                      K4A_TRACK_NAME_IR,
-                                      track_video,
-                                      "V_MS/VFW/FOURCC",
-                                      reinterpret_cast<uint8_t *>(&codec_info),
-                                      sizeof(codec_info));
-        if (context->ir_track != nullptr)
+        tracks->ir_track = add_track(context,
+                                     device_name(K4A_TRACK_NAME_IR, device_index).c_str(),
+                                     track_video,
+                                     "V_MS/VFW/FOURCC",
+                                     reinterpret_cast<uint8_t *>(&codec_info),
+                                     sizeof(codec_info));
+        if (tracks->ir_track != nullptr)
         {
-            set_track_info_video(context->ir_track, depth_width, depth_height, context->camera_fps);
+            set_track_info_video(tracks->ir_track, depth_width, depth_height, camera_fps);
 
-            uint64_t track_uid = GetChild<KaxTrackUID>(*context->ir_track->track).GetValue();
+            uint64_t track_uid = GetChild<KaxTrackUID>(*tracks->ir_track->track).GetValue();
             std::ostringstream track_uid_str;
             track_uid_str << track_uid;
-            add_tag(context, "K4A_IR_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
             add_tag(context,
-                    "K4A_IR_MODE",
+                    device_name("K4A_IR_TRACK", device_index).c_str(),
+                    track_uid_str.str().c_str(),
+                    TAG_TARGET_TYPE_TRACK,
+                    track_uid);
+            add_tag(context,
+                    device_name("K4A_IR_MODE", device_index).c_str(),
                     device_config.depth_mode == K4A_DEPTH_MODE_PASSIVE_IR ? "PASSIVE" : "ACTIVE",
                     TAG_TARGET_TYPE_TRACK,
                     track_uid);
@@ -248,7 +289,7 @@ k4a_result_t k4a_record_create(const char *path,
     {
         std::ostringstream delay_str;
         delay_str << device_config.depth_delay_off_color_usec * 1000;
-        add_tag(context, "K4A_DEPTH_DELAY_NS", delay_str.str().c_str());
+        add_tag(context, device_name("K4A_DEPTH_DELAY_NS", device_index).c_str(), delay_str.str().c_str());
     }
 
     if (K4A_SUCCEEDED(result))
@@ -256,17 +297,17 @@ k4a_result_t k4a_record_create(const char *path,
         switch (device_config.wired_sync_mode)
         {
         case K4A_WIRED_SYNC_MODE_STANDALONE:
-            add_tag(context, "K4A_WIRED_SYNC_MODE", "STANDALONE");
+            add_tag(context, device_name("K4A_WIRED_SYNC_MODE", device_index).c_str(), "STANDALONE");
             break;
         case K4A_WIRED_SYNC_MODE_MASTER:
-            add_tag(context, "K4A_WIRED_SYNC_MODE", "MASTER");
+            add_tag(context, device_name("K4A_WIRED_SYNC_MODE", device_index).c_str(), "MASTER");
             break;
         case K4A_WIRED_SYNC_MODE_SUBORDINATE:
-            add_tag(context, "K4A_WIRED_SYNC_MODE", "SUBORDINATE");
+            add_tag(context, device_name("K4A_WIRED_SYNC_MODE", device_index).c_str(), "SUBORDINATE");
 
             std::ostringstream delay_str;
             delay_str << device_config.subordinate_delay_off_master_usec * 1000;
-            add_tag(context, "K4A_SUBORDINATE_DELAY_NS", delay_str.str().c_str());
+            add_tag(context, device_name("K4A_SUBORDINATE_DELAY_NS", device_index).c_str(), delay_str.str().c_str());
             break;
         }
     }
@@ -283,8 +324,12 @@ k4a_result_t k4a_record_create(const char *path,
         std::ostringstream depth_firmware_str;
         depth_firmware_str << version_info.depth.major << "." << version_info.depth.minor << "."
                            << version_info.depth.iteration;
-        add_tag(context, "K4A_COLOR_FIRMWARE_VERSION", color_firmware_str.str().c_str());
-        add_tag(context, "K4A_DEPTH_FIRMWARE_VERSION", depth_firmware_str.str().c_str());
+        add_tag(context,
+                device_name("K4A_COLOR_FIRMWARE_VERSION", device_index).c_str(),
+                color_firmware_str.str().c_str());
+        add_tag(context,
+                device_name("K4A_DEPTH_FIRMWARE_VERSION", device_index).c_str(),
+                depth_firmware_str.str().c_str());
 
         char serial_number_buffer[256];
         size_t serial_number_buffer_size = sizeof(serial_number_buffer);
@@ -292,13 +337,15 @@ k4a_result_t k4a_record_create(const char *path,
         if (TRACE_BUFFER_CALL(k4a_device_get_serialnum(device, serial_number_buffer, &serial_number_buffer_size)) ==
             K4A_BUFFER_RESULT_SUCCEEDED)
         {
-            add_tag(context, "K4A_DEVICE_SERIAL_NUMBER", serial_number_buffer);
+            add_tag(context, device_name("K4A_DEVICE_SERIAL_NUMBER", device_index).c_str(), serial_number_buffer);
         }
     }
 
     if (K4A_SUCCEEDED(result) && device != NULL)
     {
-        // Add calibration.json to the recording
+        // Add calibration.json to the recording, calibration_<device index>.json for the added devices
+        std::string calibration_file = device_index == 0 ? std::string("calibration.json") :
+                                                           device_name("calibration", device_index) + ".json";
         size_t calibration_size = 0;
         k4a_buffer_result_t buffer_result = TRACE_BUFFER_CALL(
             k4a_device_get_raw_calibration(device, NULL, &calibration_size));
@@ -315,13 +362,13 @@ k4a_result_t k4a_record_create(const char *path,
                     calibration_size--;
                 }
                 KaxAttached *attached = add_attachment(context,
-                                                       "calibration.json",
+                                                       calibration_file.c_str(),
                                                        "application/octet-stream",
                                                        calibration_buffer.data(),
                                                        calibration_size);
                 add_tag(context,
-                        "K4A_CALIBRATION_FILE",
-                        "calibration.json",
+                        device_name("K4A_CALIBRATION_FILE", device_index).c_str(),
+                        calibration_file.c_str(),
                         TAG_TARGET_TYPE_ATTACHMENT,
                         get_attachment_uid(attached));
             }
@@ -335,6 +382,81 @@ k4a_result_t k4a_record_create(const char *path,
             result = K4A_RESULT_FAILED;
         }
     }
+    return result;
+}
+
+k4a_result_t k4a_record_create(const char *path,
+                               k4a_device_t device,
+                               const k4a_device_configuration_t device_config,
+                               k4a_record_t *recording_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
+    k4a_record_context_t *context = NULL;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    context = k4a_record_t_create(recording_handle);
+    result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->file_path = path;
+        context->first_file_path = path;
+
+        try
+        {
+            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_CREATE);
+        }
+        catch (std::ios_base::failure &e)
+        {
+            LOG_ERROR("Unable to open file '%s': %s", path, e.what());
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->device_config = device_config;
+
+        context->timecode_scale = MATROSKA_TIMESCALE_NS;
+
+        // Under a memory budget, hold at most half of it before writing, see k4a_set_memory_budget()
+        size_t memory_budget = k4a_get_memory_budget();
+        if (memory_budget != 0)
+        {
+            context->write_queue_limit = memory_budget / 2;
+            context->write_queue_policy = K4A_RECORD_WRITE_QUEUE_BLOCK;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->file_segment = make_unique<KaxSegment>();
+
+        { // Setup segment info
+            auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
+
+            GetChild<KaxTimecodeScale>(segment_info).SetValue(context->timecode_scale);
+            GetChild<KaxMuxingApp>(segment_info).SetValue(L"libmatroska-1.4.9");
+            std::ostringstream version_str;
+            version_str << "k4arecord-" << K4A_VERSION_STR;
+            GetChild<KaxWritingApp>(segment_info).SetValueUTF8(version_str.str());
+            GetChild<KaxDateUTC>(segment_info).SetEpochDate(time(0));
+            GetChild<KaxTitle>(segment_info).SetValue(L"Azure Kinect");
+        }
+
+        auto &tags = GetChild<KaxTags>(*context->file_segment);
+        tags.EnableChecksum();
+    }
+
+    device_tracks_t tracks;
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(add_device_tracks(context, 0, device, device_config, &tracks));
+        context->color_track = tracks.color_track;
+        context->depth_track = tracks.depth_track;
+        context->ir_track = tracks.ir_track;
+    }
 
     if (K4A_SUCCEEDED(result))
     {
@@ -404,43 +526,116 @@ k4a_result_t k4a_record_add_attachment(const k4a_record_t recording_handle,
     return K4A_RESULT_FROM_BOOL(attached != NULL);
 }
 
-k4a_result_t k4a_record_add_imu_track(const k4a_record_t recording_handle)
+// Adds the IMU track of a device to a recording, the track is named and tagged as the other tracks of the device
+static k4a_result_t add_imu_track(k4a_record_context_t *context, uint32_t device_index, track_header_t **imu_track)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
-
-    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
-
     if (context->header_written)
     {
         LOG_ERROR("The IMU track must be added before the recording header is written.", 0);
         return K4A_RESULT_FAILED;
     }
 
-    if (context->imu_track)
+    if (*imu_track)
     {
         LOG_ERROR("The IMU track has already been added to this recording.", 0);
         return K4A_RESULT_FAILED;
     }
 
-    context->imu_track = add_track(context, K4A_TRACK_NAME_IMU, track_subtitle, "S_K4A/IMU");
-    if (context->imu_track == nullptr)
+    *imu_track = add_track(context, device_name(K4A_TRACK_NAME_IMU, device_index).c_str(), track_subtitle, "S_K4A/IMU");
+    if (*imu_track == nullptr)
     {
         LOG_ERROR("Failed to add imu track.", 0);
         return K4A_RESULT_FAILED;
     }
 
-    context->imu_track->high_freq_data = true;
+    (*imu_track)->high_freq_data = true;
 
-    uint64_t track_uid = GetChild<KaxTrackUID>(*context->imu_track->track).GetValue();
+    uint64_t track_uid = GetChild<KaxTrackUID>(*(*imu_track)->track).GetValue();
     std::ostringstream track_uid_str;
     track_uid_str << track_uid;
-    add_tag(context, "K4A_IMU_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
-    add_tag(context, "K4A_IMU_MODE", "ON", TAG_TARGET_TYPE_TRACK, track_uid);
+    add_tag(context,
+            device_name("K4A_IMU_TRACK", device_index).c_str(),
+            track_uid_str.str().c_str(),
+            TAG_TARGET_TYPE_TRACK,
+            track_uid);
+    add_tag(context, device_name("K4A_IMU_MODE", device_index).c_str(), "ON", TAG_TARGET_TYPE_TRACK, track_uid);
 
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_record_add_imu_track(const k4a_record_t recording_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    return add_imu_track(context, 0, &context->imu_track);
+}
+
+k4a_result_t k4a_record_add_device(const k4a_record_t recording_handle,
+                                   k4a_device_t device,
+                                   const k4a_device_configuration_t device_config,
+                                   uint32_t *device_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_index == NULL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("Devices must be added before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // On failure the tracks already added stay in the file but belong to no device, so the recording should be closed.
+    uint32_t index = (uint32_t)context->added_devices.size() + 1;
+    device_tracks_t tracks;
+    k4a_result_t result = TRACE_CALL(add_device_tracks(context, index, device, device_config, &tracks));
+
+    // The codecs set with k4a_record_set_depth_codec() and k4a_record_set_color_codec() apply to every device.
+    if (K4A_SUCCEEDED(result) && context->depth_codec != K4A_RECORD_DEPTH_CODEC_RAW)
+    {
+        if (tracks.depth_track != nullptr)
+        {
+            result = TRACE_CALL(set_depth_track_codec(tracks.depth_track, context->depth_codec));
+        }
+        if (K4A_SUCCEEDED(result) && tracks.ir_track != nullptr)
+        {
+            result = TRACE_CALL(set_depth_track_codec(tracks.ir_track, context->depth_codec));
+        }
+    }
+    if (K4A_SUCCEEDED(result) && context->color_codec != K4A_RECORD_COLOR_CODEC_RAW && tracks.color_track != nullptr)
+    {
+        result = TRACE_CALL(
+            set_color_track_codec(tracks.color_track, device_config.color_format, context->color_codec));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->added_devices.push_back(tracks);
+        *device_index = index;
+    }
+    return result;
+}
+
+k4a_result_t k4a_record_add_device_imu_track(const k4a_record_t recording_handle, uint32_t device_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_index > context->added_devices.size());
+
+    if (device_index == 0)
+    {
+        return add_imu_track(context, 0, &context->imu_track);
+    }
+    return add_imu_track(context, device_index, &context->added_devices[device_index - 1].imu_track);
+}
+
 k4a_result_t k4a_record_add_custom_video_track(const k4a_record_t recording_handle,
                                                const char *track_name,
                                                const char *codec_id,
@@ -521,6 +716,67 @@ k4a_result_t k4a_record_add_custom_subtitle_track(const k4a_record_t recording_h
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_record_add_preview_track(const k4a_record_t recording_handle,
+                                          const k4a_record_preview_settings_t *settings)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, settings == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, settings->scale > K4A_COLOR_SCALE_EIGHTH);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, settings->jpeg_quality < 1 || settings->jpeg_quality > 100);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, settings->max_depth_mm == 0);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The preview track must be added before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (context->preview_track)
+    {
+        LOG_ERROR("The preview track has already been added to this recording.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // A cluster holds at most one preview, so the sidecar index has room for the location of each one.
+    if ((uint64_t)settings->interval_usec * 1000 < MAX_CLUSTER_LENGTH_NS)
+    {
+        LOG_ERROR("The preview interval must be at least the cluster length: %u us < %llu us",
+                  settings->interval_usec,
+                  (unsigned long long)(MAX_CLUSTER_LENGTH_NS / 1000));
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_image_format_t color_format = context->device_config.color_format;
+    if (context->device_config.color_resolution != K4A_COLOR_RESOLUTION_OFF &&
+        color_format != K4A_IMAGE_FORMAT_COLOR_MJPG && color_format != K4A_IMAGE_FORMAT_COLOR_NV12 &&
+        color_format != K4A_IMAGE_FORMAT_COLOR_YUY2 && color_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        LOG_ERROR("Color images in format %d can't be previewed.", color_format);
+        return K4A_RESULT_FAILED;
+    }
+
+    track_header_t *track = add_track(context, K4A_TRACK_NAME_PREVIEW, track_subtitle, "S_K4A/PREVIEW");
+    if (track == NULL)
+    {
+        LOG_ERROR("Failed to add preview track.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    track->preview = true;
+    track->preview_settings = *settings;
+    context->preview_track = track;
+    context->next_preview_ns = 0;
+
+    uint64_t track_uid = GetChild<KaxTrackUID>(*track->track).GetValue();
+    std::ostringstream track_uid_str;
+    track_uid_str << track_uid;
+    add_tag(context, "K4A_PREVIEW_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
@@ -534,10 +790,21 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
         return K4A_RESULT_FAILED;
     }
 
+    // The file is missing if k4a_record_set_unbuffered_io() failed to create it again.
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->ebml_file == nullptr);
+
+    if (!context->added_devices.empty())
+    {
+        // Playback looks for the tracks of the devices after the first one from this count.
+        std::ostringstream device_count_str;
+        device_count_str << context->added_devices.size() + 1;
+        add_tag(context, "K4A_DEVICE_COUNT", device_count_str.str().c_str());
+    }
+
     try
     {
-        // Make sure we're at the beginning of the file in case we're rewriting a file.
-        context->ebml_file->setFilePointer(0, libebml::seek_beginning);
+        // The header is rendered in memory first, so that every file of a segmented recording can start with it.
+        MemIOCallback header;
 
         { // Render Ebml header
             EbmlHead file_head;
@@ -546,48 +813,63 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
             GetChild<EDocTypeVersion>(file_head).SetValue(2);
             GetChild<EDocTypeReadVersion>(file_head).SetValue(2);
 
-            file_head.Render(*context->ebml_file, true);
+            file_head.Render(header, true);
         }
 
         // Recordings can get very large, so pad the length field up to 8 bytes from the start.
-        context->file_segment->WriteHead(*context->ebml_file, 8);
+        context->file_segment->WriteHead(header, 8);
 
         { // Write void blocks to reserve space for seeking metadata and the segment info so they can be updated at
           // the end
             context->seek_void = make_unique<EbmlVoid>();
             context->seek_void->SetSize(1024);
-            context->seek_void->Render(*context->ebml_file);
+            context->seek_void->Render(header);
 
             context->segment_info_void = make_unique<EbmlVoid>();
             context->segment_info_void->SetSize(256);
-            context->segment_info_void->Render(*context->ebml_file);
+            context->segment_info_void->Render(header);
         }
 
         { // Write tracks
             auto &tracks = GetChild<KaxTracks>(*context->file_segment);
-            tracks.Render(*context->ebml_file);
+            tracks.Render(header);
         }
 
         { // Write attachments
             auto &attachments = GetChild<KaxAttachments>(*context->file_segment);
-            attachments.Render(*context->ebml_file);
+            attachments.Render(header);
         }
 
         { // Write tags with a void block after to make editing easier
             auto &tags = GetChild<KaxTags>(*context->file_segment);
-            tags.Render(*context->ebml_file);
+            tags.Render(header);
 
             context->tags_void = make_unique<EbmlVoid>();
             context->tags_void->SetSize(1024);
-            context->tags_void->Render(*context->ebml_file);
+            context->tags_void->Render(header);
+        }
+
+        // Make sure we're at the beginning of the file in case we're rewriting a file.
+        context->ebml_file->setFilePointer(0, libebml::seek_beginning);
+        context->ebml_file->write(header.GetDataBuffer(), (size_t)header.GetDataBufferSize());
+
+        if (context->segment_max_duration_ns != 0 || context->segment_max_size != 0)
+        {
+            context->header_data.assign(header.GetDataBuffer(), header.GetDataBuffer() + header.GetDataBufferSize());
         }
     }
     catch (std::ios_base::failure &e)
     {
-        LOG_ERROR("Failed to write recording header '%s': %s", context->file_path, e.what());
+        LOG_ERROR("Failed to write recording header '%s': %s", context->file_path.c_str(), e.what());
         return K4A_RESULT_FAILED;
     }
 
+    if (!context->header_data.empty())
+    {
+        // If this fails, it is tried again when the next file is needed.
+        (void)TRACE_CALL(prepare_next_segment_file(context));
+    }
+
     RETURN_IF_ERROR(start_matroska_writer_thread(context));
 
     context->header_written = true;
@@ -595,33 +877,142 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
     return K4A_RESULT_SUCCEEDED;
 }
 
-k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_capture_t capture)
+static void drop_image(k4a_record_context_t *context, k4a_image_t *image)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
-
-    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    if (context->dropped_image_count++ == 0)
+    {
+        LOG_WARNING("The recording write queue is full, images are being dropped.", 0);
+    }
+    k4a_image_release(*image);
+    *image = NULL;
+}
 
-    if (!context->header_written)
+// Applies the write queue policy to the images of a capture, see k4a_record_set_write_queue_limit(). The color image
+// is images[0]. Dropped images are released and set to NULL.
+static k4a_result_t apply_write_queue_limit(k4a_record_context_t *context, k4a_image_t *images, size_t image_count)
+{
+    k4a_record_write_queue_policy_t policy;
     {
-        LOG_ERROR("The recording header needs to be written before any captures.", 0);
-        return K4A_RESULT_FAILED;
+        std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
+        if (context->write_queue_limit == 0)
+        {
+            return K4A_RESULT_SUCCEEDED;
+        }
+        policy = context->write_queue_policy;
     }
 
-    // Arrays used to map image formats to tracks, these 3 arrays are order dependant.
+    size_t capture_size = 0;
+    for (size_t i = 0; i < image_count; i++)
+    {
+        if (images[i])
+        {
+            capture_size += k4a_image_get_size(images[i]);
+        }
+    }
+
+    if (wait_for_write_queue(context, capture_size))
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (policy == K4A_RECORD_WRITE_QUEUE_DROP_COLOR && images[0] != NULL)
+    {
+        capture_size -= k4a_image_get_size(images[0]);
+        drop_image(context, &images[0]);
+        if (wait_for_write_queue(context, capture_size))
+        {
+            return K4A_RESULT_SUCCEEDED;
+        }
+    }
+    else if (policy == K4A_RECORD_WRITE_QUEUE_FAIL)
+    {
+        LOG_ERROR("The recording write queue is full, the capture was not written.", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    for (size_t i = 0; i < image_count; i++)
+    {
+        if (images[i] != NULL && K4A_FAILED(result))
+        {
+            k4a_image_release(images[i]);
+            images[i] = NULL;
+        }
+        else if (images[i] != NULL)
+        {
+            drop_image(context, &images[i]);
+        }
+    }
+    return result;
+}
+
+// Returns the tracks of a device of the recording, device 0 is the device of k4a_record_create()
+static device_tracks_t get_device_tracks(k4a_record_context_t *context, uint32_t device_index)
+{
+    if (device_index > 0)
+    {
+        return context->added_devices[device_index - 1];
+    }
+
+    device_tracks_t device;
+    device.device_config = context->device_config;
+    device.color_track = context->color_track;
+    device.depth_track = context->depth_track;
+    device.ir_track = context->ir_track;
+    device.imu_track = context->imu_track;
+    device.preview_track = context->preview_track;
+    return device;
+}
+
+static k4a_result_t write_device_capture(k4a_record_context_t *context,
+                                         const device_tracks_t &device,
+                                         k4a_capture_t capture)
+{
+    if (!context->header_written)
+    {
+        LOG_ERROR("The recording header needs to be written before any captures.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // Arrays used to map image formats to tracks, these 3 arrays are order dependant.
     k4a_image_t images[] = {
         k4a_capture_get_color_image(capture),
         k4a_capture_get_depth_image(capture),
         k4a_capture_get_ir_image(capture),
     };
-    k4a_image_format_t expected_formats[] = { context->device_config.color_format,
+    k4a_image_format_t expected_formats[] = { device.device_config.color_format,
                                               K4A_IMAGE_FORMAT_DEPTH16,
                                               K4A_IMAGE_FORMAT_IR16 };
-    track_header_t *tracks[] = { context->color_track, context->depth_track, context->ir_track };
+    track_header_t *tracks[] = { device.color_track, device.depth_track, device.ir_track };
     static_assert(arraysize(images) == arraysize(tracks), "Invalid mapping from images to track");
     static_assert(arraysize(images) == arraysize(expected_formats), "Invalid mapping from images to formats");
 
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_result_t result = apply_write_queue_limit(context, images, arraysize(images));
+
+    if (device.preview_track != nullptr)
+    {
+        // The preview keeps its own references to the color and depth images, it is made when the cluster is written.
+        k4a_image_t timestamp_image = images[0] != NULL ? images[0] : images[1];
+        if (timestamp_image != NULL)
+        {
+            uint64_t timestamp_ns = k4a_image_get_device_timestamp_usec(timestamp_image) * 1000;
+            if (timestamp_ns >= context->next_preview_ns)
+            {
+                // A missing preview doesn't fail the capture.
+                if (K4A_SUCCEEDED(TRACE_CALL(
+                        write_preview_data(context, device.preview_track, timestamp_ns, images[0], images[1]))))
+                {
+                    const k4a_record_preview_settings_t &settings = device.preview_track->preview_settings;
+                    context->next_preview_ns = timestamp_ns + (uint64_t)settings.interval_usec * 1000;
+                }
+                else
+                {
+                    LOG_WARNING("Failed to add the preview at timestamp %llu ns.", (unsigned long long)timestamp_ns);
+                }
+            }
+        }
+    }
+
     for (size_t i = 0; i < arraysize(images); i++)
     {
         if (images[i])
@@ -633,30 +1024,56 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
                 k4a_image_format_t image_format = k4a_image_get_format(images[i]);
                 if (image_format == expected_formats[i])
                 {
-                    // Create a copy of the image buffer for writing to file.
+                    uint64_t timestamp_ns = k4a_image_get_device_timestamp_usec(images[i]) * 1000;
+
+                    // 16 bit grayscale needs to be converted to big-endian in the file, so it is always copied.
+                    // RVL tracks are encoded from the image buffer when the cluster is written instead.
+                    bool byte_swap = (image_format == K4A_IMAGE_FORMAT_DEPTH16 ||
+                                      image_format == K4A_IMAGE_FORMAT_IR16) &&
+                                     (tracks[i] == nullptr || !tracks[i]->rvl_encoded);
                     assert(buffer_size <= UINT32_MAX);
-                    DataBuffer *data_buffer = new (std::nothrow)
-                        DataBuffer(image_buffer, (uint32)buffer_size, NULL, true);
-                    if (image_format == K4A_IMAGE_FORMAT_DEPTH16 || image_format == K4A_IMAGE_FORMAT_IR16)
+                    DataBuffer *data_buffer = NULL;
+                    if (context->zero_copy && !byte_swap)
                     {
-                        // 16 bit grayscale needs to be converted to big-endian in the file.
-                        assert(data_buffer->Size() % sizeof(uint16_t) == 0);
-                        uint16_t *data_buffer_raw = reinterpret_cast<uint16_t *>(data_buffer->Buffer());
-                        for (size_t j = 0; j < data_buffer->Size() / sizeof(uint16_t); j++)
+                        // The data buffer takes over our reference to the image and is written from its buffer.
+                        data_buffer = new (std::nothrow) ImageDataBuffer(images[i], image_buffer, (uint32)buffer_size);
+                        if (data_buffer != NULL)
                         {
-                            data_buffer_raw[j] = swap_bytes_16(data_buffer_raw[j]);
+                            images[i] = NULL;
                         }
                     }
+                    else
+                    {
+                        // Create a copy of the image buffer for writing to file.
+                        data_buffer = new (std::nothrow) DataBuffer(image_buffer, (uint32)buffer_size, NULL, true);
+                    }
 
-                    uint64_t timestamp_ns = k4a_image_get_device_timestamp_usec(images[i]) * 1000;
-                    k4a_result_t tmp_result = TRACE_CALL(
-                        write_track_data(context, tracks[i], timestamp_ns, data_buffer));
-                    if (K4A_FAILED(tmp_result))
+                    if (data_buffer == NULL)
                     {
-                        // Write as many of the image buffers as possible, even if some fail due to timestamp.
-                        result = tmp_result;
-                        data_buffer->FreeBuffer(*data_buffer);
-                        delete data_buffer;
+                        LOG_ERROR("Failed to allocate a buffer for the image.", 0);
+                        result = K4A_RESULT_FAILED;
+                    }
+                    else
+                    {
+                        if (byte_swap)
+                        {
+                            assert(data_buffer->Size() % sizeof(uint16_t) == 0);
+                            uint16_t *data_buffer_raw = reinterpret_cast<uint16_t *>(data_buffer->Buffer());
+                            for (size_t j = 0; j < data_buffer->Size() / sizeof(uint16_t); j++)
+                            {
+                                data_buffer_raw[j] = swap_bytes_16(data_buffer_raw[j]);
+                            }
+                        }
+
+                        k4a_result_t tmp_result = TRACE_CALL(
+                            write_track_data(context, tracks[i], timestamp_ns, data_buffer));
+                        if (K4A_FAILED(tmp_result))
+                        {
+                            // Write as many of the image buffers as possible, even if some fail due to timestamp.
+                            result = tmp_result;
+                            data_buffer->FreeBuffer(*data_buffer);
+                            delete data_buffer;
+                        }
                     }
                 }
                 else
@@ -665,21 +1082,336 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
                     result = K4A_RESULT_FAILED;
                 }
             }
-            k4a_image_release(images[i]);
+            if (images[i])
+            {
+                k4a_image_release(images[i]);
+            }
         }
     }
 
     return result;
 }
 
-k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4a_imu_sample_t imu_sample)
+k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_capture_t capture)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    return write_device_capture(context, get_device_tracks(context, 0), capture);
+}
+
+k4a_result_t k4a_record_write_device_capture(const k4a_record_t recording_handle,
+                                             uint32_t device_index,
+                                             k4a_capture_t capture)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_index > context->added_devices.size());
+
+    return write_device_capture(context, get_device_tracks(context, device_index), capture);
+}
+
+k4a_result_t k4a_record_set_zero_copy(const k4a_record_t recording_handle, bool zero_copy)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
 
     k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
 
-    if (!context->imu_track)
+    context->zero_copy = zero_copy;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_write_queue_limit(const k4a_record_t recording_handle,
+                                              size_t max_size_bytes,
+                                              k4a_record_write_queue_policy_t policy)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        policy != K4A_RECORD_WRITE_QUEUE_BLOCK && policy != K4A_RECORD_WRITE_QUEUE_DROP_COLOR &&
+                            policy != K4A_RECORD_WRITE_QUEUE_DROP_CAPTURE && policy != K4A_RECORD_WRITE_QUEUE_FAIL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
+    context->write_queue_limit = max_size_bytes;
+    context->write_queue_policy = policy;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_get_dropped_image_count(const k4a_record_t recording_handle, uint64_t *dropped_image_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, dropped_image_count == NULL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    *dropped_image_count = context->dropped_image_count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_buffer_result_t k4a_record_get_metrics(const k4a_record_t recording_handle,
+                                           k4a_metric_t *metrics,
+                                           size_t *metric_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, metric_count == NULL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+
+    size_t pending_data_size;
+    uint64_t pending_ns;
+    {
+        std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
+        pending_data_size = context->pending_data_size;
+        pending_ns = context->most_recent_timestamp > context->last_written_timestamp ?
+                         context->most_recent_timestamp - context->last_written_timestamp :
+                         0;
+    }
+
+    metrics_list_t list = { metrics, metrics == NULL ? 0 : *metric_count, 0 };
+    metrics_add_gauge(&list,
+                      "k4a_record_write_queue_bytes",
+                      "Data held in memory waiting to be written to disk",
+                      NULL,
+                      NULL,
+                      (double)pending_data_size);
+    metrics_add_gauge(&list,
+                      "k4a_record_write_queue_age_seconds",
+                      "Recording time between the newest data and the last data written to disk",
+                      NULL,
+                      NULL,
+                      (double)pending_ns / 1e9);
+    metrics_add_counter(&list,
+                        "k4a_record_dropped_images_total",
+                        "Images dropped because the write queue was full",
+                        NULL,
+                        NULL,
+                        (double)context->dropped_image_count);
+
+    *metric_count = list.count;
+    return list.count > list.capacity ? K4A_BUFFER_RESULT_TOO_SMALL : K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_depth_codec(const k4a_record_t recording_handle, k4a_record_depth_codec_t depth_codec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        depth_codec != K4A_RECORD_DEPTH_CODEC_RAW && depth_codec != K4A_RECORD_DEPTH_CODEC_RVL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The depth codec must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<track_header_t *> tracks = { context->depth_track, context->ir_track };
+    for (device_tracks_t &device : context->added_devices)
+    {
+        tracks.push_back(device.depth_track);
+        tracks.push_back(device.ir_track);
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (track_header_t *track : tracks)
+    {
+        if (K4A_SUCCEEDED(result) && track != nullptr)
+        {
+            result = TRACE_CALL(set_depth_track_codec(track, depth_codec));
+        }
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        context->depth_codec = depth_codec;
+    }
+    return result;
+}
+
+k4a_result_t k4a_record_set_color_codec(const k4a_record_t recording_handle, k4a_record_color_codec_t color_codec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        color_codec != K4A_RECORD_COLOR_CODEC_RAW && color_codec != K4A_RECORD_COLOR_CODEC_MJPG);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The color codec must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<std::pair<track_header_t *, k4a_image_format_t>> tracks;
+    if (context->color_track != nullptr)
+    {
+        tracks.emplace_back(context->color_track, context->device_config.color_format);
+    }
+    for (device_tracks_t &device : context->added_devices)
+    {
+        if (device.color_track != nullptr)
+        {
+            tracks.emplace_back(device.color_track, device.device_config.color_format);
+        }
+    }
+
+    if (tracks.empty())
+    {
+        LOG_ERROR("The recording has no color track.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (auto &track : tracks)
+    {
+        if (K4A_SUCCEEDED(result))
+        {
+            result = TRACE_CALL(set_color_track_codec(track.first, track.second, color_codec));
+        }
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        context->color_codec = color_codec;
+    }
+    return result;
+}
+
+k4a_result_t k4a_record_set_color_encoder(const k4a_record_t recording_handle,
+                                          const char *codec_id,
+                                          const uint8_t *codec_context,
+                                          size_t codec_context_size,
+                                          k4a_record_color_encode_cb_t *encode_cb,
+                                          void *callback_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_id == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, encode_cb == NULL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The color encoder must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (context->color_track == nullptr)
+    {
+        LOG_ERROR("The recording has no color track to encode.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    return TRACE_CALL(set_color_track_encoder(context->color_track,
+                                              context->device_config.color_format,
+                                              codec_id,
+                                              codec_context,
+                                              codec_context_size,
+                                              encode_cb,
+                                              callback_context));
+}
+
+k4a_result_t k4a_record_set_unbuffered_io(const k4a_record_t recording_handle, bool unbuffered_io)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("Unbuffered IO must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    bool is_unbuffered = dynamic_cast<UnbufferedFileIOCallback *>(context->ebml_file.get()) != NULL;
+    if (is_unbuffered == unbuffered_io)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    // Nothing has been written to the file yet, so it can be created again with the other IO handler.
+    try
+    {
+        context->ebml_file->close();
+        context->ebml_file.reset();
+        if (unbuffered_io)
+        {
+            context->ebml_file = make_unique<UnbufferedFileIOCallback>(context->file_path.c_str());
+        }
+        else
+        {
+            context->ebml_file = make_unique<LargeFileIOCallback>(context->file_path.c_str(), MODE_CREATE);
+        }
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Unable to open file '%s': %s", context->file_path.c_str(), e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_live_index(const k4a_record_t recording_handle, bool live_index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The live index must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->live_index = live_index;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_segment_limits(const k4a_record_t recording_handle,
+                                           uint64_t max_duration_usec,
+                                           uint64_t max_size_bytes)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, max_duration_usec > UINT64_MAX / 1000);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("Segment limits must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->segment_max_duration_ns = max_duration_usec * 1000;
+    context->segment_max_size = max_size_bytes;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4a_imu_sample_t imu_sample)
+{
+    return k4a_record_write_imu_samples(recording_handle, &imu_sample, 1);
+}
+
+static k4a_result_t write_imu_samples(k4a_record_context_t *context,
+                                      track_header_t *imu_track,
+                                      const k4a_imu_sample_t *imu_samples,
+                                      size_t sample_count)
+{
+    if (!imu_track)
     {
         LOG_ERROR("The IMU track needs to be added with k4a_record_add_imu_track() before IMU samples can be written.",
                   0);
@@ -692,56 +1424,121 @@ k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4
         return K4A_RESULT_FAILED;
     }
 
-    matroska_imu_sample_t sample_data = { 0 };
-    sample_data.acc_timestamp_ns = imu_sample.acc_timestamp_usec * 1000;
-    sample_data.gyro_timestamp_ns = imu_sample.gyro_timestamp_usec * 1000;
-    for (size_t i = 0; i < 3; i++)
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    std::vector<uint64_t> timestamps_ns(sample_count);
+    std::vector<DataBuffer *> data_buffers(sample_count, NULL);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        matroska_imu_sample_t sample_data = { 0 };
+        sample_data.acc_timestamp_ns = imu_samples[i].acc_timestamp_usec * 1000;
+        sample_data.gyro_timestamp_ns = imu_samples[i].gyro_timestamp_usec * 1000;
+        for (size_t j = 0; j < 3; j++)
+        {
+            sample_data.acc_data[j] = imu_samples[i].acc_sample.v[j];
+            sample_data.gyro_data[j] = imu_samples[i].gyro_sample.v[j];
+        }
+
+        // Each sample is a frame of the laced IMU block of its cluster, see track_header_t::high_freq_data.
+        timestamps_ns[i] = sample_data.acc_timestamp_ns;
+        data_buffers[i] = new (std::nothrow)
+            DataBuffer(reinterpret_cast<binary *>(&sample_data), sizeof(matroska_imu_sample_t), NULL, true);
+        if (data_buffers[i] == NULL)
+        {
+            LOG_ERROR("Failed to allocate a buffer for imu sample %zu.", i);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    // Samples that failed to copy are left NULL and skipped, the rest are queued under a single lock.
+    k4a_result_t write_result = TRACE_CALL(
+        write_track_data_batch(context, imu_track, sample_count, timestamps_ns.data(), data_buffers.data()));
+    if (K4A_FAILED(write_result))
     {
-        sample_data.acc_data[i] = imu_sample.acc_sample.v[i];
-        sample_data.gyro_data[i] = imu_sample.gyro_sample.v[i];
+        result = write_result;
     }
 
-    DataBuffer *data_buffer = new (std::nothrow)
-        DataBuffer(reinterpret_cast<binary *>(&sample_data), sizeof(matroska_imu_sample_t), NULL, true);
-    k4a_result_t result = write_track_data(context, context->imu_track, sample_data.acc_timestamp_ns, data_buffer);
-    if (K4A_FAILED(result))
+    // Clean up the samples that were not queued.
+    for (DataBuffer *data_buffer : data_buffers)
     {
-        data_buffer->FreeBuffer(*data_buffer);
-        delete data_buffer;
-        return result;
+        if (data_buffer != NULL)
+        {
+            data_buffer->FreeBuffer(*data_buffer);
+            delete data_buffer;
+        }
     }
 
-    return K4A_RESULT_SUCCEEDED;
+    return result;
 }
 
-k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_handle,
-                                                const char *track_name,
-                                                uint64_t device_timestamp_usec,
-                                                uint8_t *buffer,
-                                                size_t buffer_size)
+k4a_result_t k4a_record_write_imu_samples(const k4a_record_t recording_handle,
+                                          const k4a_imu_sample_t *imu_samples,
+                                          size_t sample_count)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sample_count == 0);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    return write_imu_samples(context, context->imu_track, imu_samples, sample_count);
+}
+
+k4a_result_t k4a_record_write_device_imu_samples(const k4a_record_t recording_handle,
+                                                 uint32_t device_index,
+                                                 const k4a_imu_sample_t *imu_samples,
+                                                 size_t sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sample_count == 0);
 
     k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_index > context->added_devices.size());
+
+    return write_imu_samples(context, get_device_tracks(context, device_index).imu_track, imu_samples, sample_count);
+}
 
+// Looks up a custom track that data can be written to, logging the reason on failure.
+static track_header_t *get_custom_track(k4a_record_context_t *context, const char *track_name)
+{
     if (!context->header_written)
     {
         LOG_ERROR("The recording header needs to be written before any track data.", 0);
-        return K4A_RESULT_FAILED;
+        return NULL;
     }
 
     auto itr = context->tracks.find(track_name);
     if (itr == context->tracks.end())
     {
         LOG_ERROR("The custom track does not exist: %s", track_name);
-        return K4A_RESULT_FAILED;
+        return NULL;
     }
     if (!itr->second.custom_track)
     {
         LOG_ERROR("Custom track data cannot be written to built-in track: %s", track_name);
+        return NULL;
+    }
+    return &itr->second;
+}
+
+k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_handle,
+                                                const char *track_name,
+                                                uint64_t device_timestamp_usec,
+                                                uint8_t *buffer,
+                                                size_t buffer_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer == NULL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    track_header_t *track = get_custom_track(context, track_name);
+    if (track == NULL)
+    {
         return K4A_RESULT_FAILED;
     }
 
@@ -749,8 +1546,7 @@ k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_han
     assert(buffer_size <= UINT32_MAX);
     DataBuffer *data_buffer = new DataBuffer(buffer, (uint32_t)buffer_size, NULL, true);
 
-    k4a_result_t result = TRACE_CALL(
-        write_track_data(context, &itr->second, device_timestamp_usec * 1000, data_buffer));
+    k4a_result_t result = TRACE_CALL(write_track_data(context, track, device_timestamp_usec * 1000, data_buffer));
     if (K4A_FAILED(result))
     {
         // Clean up the data_buffer if write_track_data failed.
@@ -761,133 +1557,285 @@ k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_han
     return result;
 }
 
-k4a_result_t k4a_record_flush(const k4a_record_t recording_handle)
+k4a_result_t k4a_record_write_custom_track_data_owned(const k4a_record_t recording_handle,
+                                                      const char *track_name,
+                                                      uint64_t device_timestamp_usec,
+                                                      uint8_t *custom_data,
+                                                      size_t custom_data_size,
+                                                      k4a_memory_destroy_cb_t *custom_data_release_cb,
+                                                      void *custom_data_release_cb_context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, custom_data_release_cb == NULL);
+
+    // Argument failures don't return early, since the release callback still needs to be called.
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL(track_name != NULL && custom_data != NULL && custom_data_size <= UINT32_MAX);
+    }
+
+    track_header_t *track = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        track = get_custom_track(context, track_name);
+        result = K4A_RESULT_FROM_BOOL(track != NULL);
+    }
+
+    DataBuffer *data_buffer = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        data_buffer = new (std::nothrow) CustomDataBuffer(custom_data,
+                                                          (uint32)custom_data_size,
+                                                          custom_data_release_cb,
+                                                          custom_data_release_cb_context);
+        result = K4A_RESULT_FROM_BOOL(data_buffer != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(write_track_data(context, track, device_timestamp_usec * 1000, data_buffer));
+        if (K4A_FAILED(result))
+        {
+            // Freeing the data_buffer calls the release callback.
+            data_buffer->FreeBuffer(*data_buffer);
+            delete data_buffer;
+        }
+    }
+    else
+    {
+        // The callback is called exactly once, including when the data can't be written.
+        custom_data_release_cb(custom_data, custom_data_release_cb_context);
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_record_write_custom_track_data_batch(const k4a_record_t recording_handle,
+                                                      const char *track_name,
+                                                      const k4a_record_custom_track_block_t *blocks,
+                                                      size_t block_count)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, blocks == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, block_count == 0);
 
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
     k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
 
-    try
+    track_header_t *track = get_custom_track(context, track_name);
+    if (track == NULL)
     {
-        // Lock the writer thread first so we don't have conflicts
-        std::lock_guard<std::mutex> writer_lock(context->writer_lock);
+        return K4A_RESULT_FAILED;
+    }
 
-        LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
-        if (file_io != NULL)
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    std::vector<uint64_t> timestamps_ns(block_count);
+    std::vector<DataBuffer *> data_buffers(block_count, NULL);
+    for (size_t i = 0; i < block_count; i++)
+    {
+        const k4a_record_custom_track_block_t &block = blocks[i];
+        if (block.custom_data == NULL || block.custom_data_size > UINT32_MAX)
         {
-            file_io->setOwnerThread();
+            LOG_ERROR("Invalid custom track data block %zu.", i);
+            result = K4A_RESULT_FAILED;
+            continue;
         }
 
-        std::lock_guard<std::mutex> cluster_lock(context->pending_cluster_lock);
+        // Create a copy of the block for writing to file. The buffer is only read while copying.
+        timestamps_ns[i] = block.device_timestamp_usec * 1000;
+        data_buffers[i] = new (std::nothrow)
+            DataBuffer(const_cast<binary *>(block.custom_data), (uint32)block.custom_data_size, NULL, true);
+        if (data_buffers[i] == NULL)
+        {
+            LOG_ERROR("Failed to allocate a buffer for custom track data block %zu.", i);
+            result = K4A_RESULT_FAILED;
+        }
+    }
 
-        if (!context->pending_clusters.empty())
+    // Blocks that failed to copy are left NULL and skipped, the rest are queued under a single lock.
+    k4a_result_t write_result = TRACE_CALL(
+        write_track_data_batch(context, track, block_count, timestamps_ns.data(), data_buffers.data()));
+    if (K4A_FAILED(write_result))
+    {
+        result = write_result;
+    }
+
+    // Clean up the blocks that were not queued.
+    for (DataBuffer *data_buffer : data_buffers)
+    {
+        if (data_buffer != NULL)
         {
-            for (cluster_t *cluster : context->pending_clusters)
-            {
-                k4a_result_t write_result = TRACE_CALL(
-                    write_cluster(context, cluster, &context->last_written_timestamp));
-                if (K4A_FAILED(write_result))
-                {
-                    // Try to flush as much of the recording as possible to disk before returning any errors.
-                    result = write_result;
-                }
-            }
-            context->pending_clusters.clear();
+            data_buffer->FreeBuffer(*data_buffer);
+            delete data_buffer;
         }
+    }
+
+    return result;
+}
 
-        auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
+// Gets the size of a row of an image without padding, or 0 for formats that are written as-is.
+static size_t get_packed_row_bytes(k4a_image_format_t format, int width_pixels)
+{
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+    case K4A_IMAGE_FORMAT_CUSTOM8:
+        return (size_t)width_pixels;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+    case K4A_IMAGE_FORMAT_CUSTOM16:
+        return (size_t)width_pixels * 2;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        return (size_t)width_pixels * 4;
+    default:
+        return 0;
+    }
+}
 
-        uint64_t current_position = context->ebml_file->getFilePointer();
+static void free_packed_image_rows(void *buffer, void *context)
+{
+    (void)context;
+    delete[] static_cast<uint8_t *>(buffer);
+}
 
-        // Update segment info
-        GetChild<KaxDuration>(segment_info)
-            .SetValue(
-                (double)((context->most_recent_timestamp - context->start_timestamp_offset) / context->timecode_scale));
-        context->segment_info_void->ReplaceWith(segment_info, *context->ebml_file);
+k4a_result_t k4a_record_write_custom_track_image(const k4a_record_t recording_handle,
+                                                 const char *track_name,
+                                                 k4a_image_t image_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_handle == NULL);
 
-        // Render cues
-        auto &cues = GetChild<KaxCues>(*context->file_segment);
-        cues.Render(*context->ebml_file);
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
 
-        // Update tags
-        auto &tags = GetChild<KaxTags>(*context->file_segment);
-        if (tags.GetElementPosition() > 0)
+    track_header_t *track = get_custom_track(context, track_name);
+    if (track == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    uint8_t *image_buffer = k4a_image_get_buffer(image_handle);
+    size_t buffer_size = k4a_image_get_size(image_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_buffer == NULL || buffer_size == 0);
+
+    k4a_image_format_t format = k4a_image_get_format(image_handle);
+    int height = k4a_image_get_height_pixels(image_handle);
+    size_t stride_bytes = (size_t)k4a_image_get_stride_bytes(image_handle);
+    size_t row_bytes = get_packed_row_bytes(format, k4a_image_get_width_pixels(image_handle));
+    size_t rows = format == K4A_IMAGE_FORMAT_COLOR_NV12 ? (size_t)height * 3 / 2 : (size_t)height;
+
+    // Images with padded rows, such as views of a larger image, have their rows gathered into a packed copy. Packed
+    // images are written from their own buffer, with a reference held until the cluster is written.
+    size_t data_size = buffer_size;
+    if (row_bytes != 0)
+    {
+        data_size = row_bytes * rows;
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, rows == 0 || stride_bytes < row_bytes);
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, (rows - 1) * stride_bytes + row_bytes > buffer_size);
+    }
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_size > UINT32_MAX);
+
+    DataBuffer *data_buffer = NULL;
+    if (row_bytes == 0 || stride_bytes == row_bytes)
+    {
+        k4a_image_reference(image_handle);
+        data_buffer = new (std::nothrow) ImageDataBuffer(image_handle, image_buffer, (uint32)data_size);
+        if (data_buffer == NULL)
+        {
+            k4a_image_release(image_handle);
+        }
+    }
+    else
+    {
+        uint8_t *packed = new (std::nothrow) uint8_t[data_size];
+        if (packed != NULL)
         {
-            context->ebml_file->setFilePointer((int64_t)tags.GetElementPosition());
-            tags.Render(*context->ebml_file);
-            if (tags.GetEndPosition() != context->tags_void->GetElementPosition())
+            for (size_t row = 0; row < rows; row++)
             {
-                // Rewrite the void block after tags
-                EbmlVoid tags_void;
-                tags_void.SetSize(context->tags_void->GetSize() -
-                                  (tags.GetEndPosition() - context->tags_void->GetElementPosition()));
-                tags_void.Render(*context->ebml_file);
+                memcpy(packed + row * row_bytes, image_buffer + row * stride_bytes, row_bytes);
             }
-        }
 
-        { // Update seek info
-            auto &seek_head = GetChild<KaxSeekHead>(*context->file_segment);
-            // RemoveAll() has a bug and does not free the elements before emptying the list.
-            for (auto element : seek_head.GetElementList())
+            data_buffer = new (std::nothrow) CustomDataBuffer(packed, (uint32)data_size, free_packed_image_rows, NULL);
+            if (data_buffer == NULL)
             {
-                delete element;
+                delete[] packed;
             }
-            seek_head.RemoveAll(); // Remove any seek entries from previous flushes
+        }
+    }
 
-            seek_head.IndexThis(segment_info, *context->file_segment);
+    if (data_buffer == NULL)
+    {
+        LOG_ERROR("Failed to allocate a buffer for the image.", 0);
+        return K4A_RESULT_FAILED;
+    }
 
-            auto &tracks = GetChild<KaxTracks>(*context->file_segment);
-            if (tracks.GetElementPosition() > 0)
-            {
-                seek_head.IndexThis(tracks, *context->file_segment);
-            }
+    uint64_t timestamp_ns = k4a_image_get_device_timestamp_usec(image_handle) * 1000;
+    k4a_result_t result = TRACE_CALL(write_track_data(context, track, timestamp_ns, data_buffer));
+    if (K4A_FAILED(result))
+    {
+        // Freeing the data_buffer releases the image or the packed copy.
+        data_buffer->FreeBuffer(*data_buffer);
+        delete data_buffer;
+    }
 
-            auto &attachments = GetChild<KaxAttachments>(*context->file_segment);
-            if (attachments.GetElementPosition() > 0)
-            {
-                seek_head.IndexThis(attachments, *context->file_segment);
-            }
+    return result;
+}
+
+k4a_result_t k4a_record_flush(const k4a_record_t recording_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+
+    try
+    {
+        // Lock the writer thread first so we don't have conflicts
+        std::lock_guard<std::mutex> writer_lock(context->writer_lock);
 
-            if (tags.GetElementPosition() > 0)
+        set_file_owner_thread(context->ebml_file.get());
+
+        std::lock_guard<std::mutex> cluster_lock(context->pending_cluster_lock);
+
+        if (!context->pending_clusters.empty())
+        {
+            // Encode all the clusters in parallel first, write_cluster() retries any cluster that failed.
+            std::vector<cluster_t *> clusters(context->pending_clusters.begin(), context->pending_clusters.end());
+            (void)prepare_clusters(clusters);
+
+            for (cluster_t *cluster : context->pending_clusters)
             {
-                seek_head.IndexThis(tags, *context->file_segment);
+                k4a_result_t write_result = TRACE_CALL(
+                    write_cluster(context, cluster, &context->last_written_timestamp));
+                if (K4A_FAILED(write_result))
+                {
+                    // Try to flush as much of the recording as possible to disk before returning any errors.
+                    result = write_result;
+                }
             }
-
-            if (cues.GetElementPosition() > 0)
+            context->pending_clusters.clear();
+            context->pending_data_size = 0;
+            if (context->write_queue_notify)
             {
-                seek_head.IndexThis(cues, *context->file_segment);
+                context->write_queue_notify->notify_all();
             }
-
-            context->seek_void->ReplaceWith(seek_head, *context->ebml_file);
         }
 
-        // Update the file segment head to write the current size
-        context->ebml_file->setFilePointer(0, seek_end);
-        uint64 segment_size = context->ebml_file->getFilePointer() - context->file_segment->GetElementPosition() -
-                              context->file_segment->HeadSize();
-        // Segment size can only be set once normally, so force the flag.
-        context->file_segment->SetSizeInfinite(true);
-        if (!context->file_segment->ForceSize(segment_size))
+        k4a_result_t metadata_result = TRACE_CALL(write_file_metadata(context, context->most_recent_timestamp));
+        if (K4A_FAILED(metadata_result))
         {
-            LOG_ERROR("Failed set file segment size.", 0);
+            result = metadata_result;
         }
-        context->file_segment->OverwriteHead(*context->ebml_file);
-
-        // Set the write pointer back in case we're not done recording yet.
-        assert(current_position <= INT64_MAX);
-        context->ebml_file->setFilePointer((int64_t)current_position);
-    }
-    catch (std::ios_base::failure &e)
-    {
-        LOG_ERROR("Failed to write recording '%s': %s", context->file_path, e.what());
-        return K4A_RESULT_FAILED;
     }
     catch (std::system_error &e)
     {
-        LOG_ERROR("Failed to flush recording '%s': %s", context->file_path, e.what());
+        LOG_ERROR("Failed to flush recording '%s': %s", context->file_path.c_str(), e.what());
         return K4A_RESULT_FAILED;
     }
     return result;
@@ -901,21 +1849,28 @@ void k4a_record_close(const k4a_record_t recording_handle)
     if (context != NULL)
     {
         // If the recording was started, flush any unwritten data.
+        bool file_complete = false;
         if (context->header_written)
         {
             // If these fail, there's nothing we can do but log.
-            (void)TRACE_CALL(k4a_record_flush(recording_handle));
+            file_complete = K4A_SUCCEEDED(TRACE_CALL(k4a_record_flush(recording_handle)));
             stop_matroska_writer_thread(context);
+            discard_next_segment_file(context);
         }
 
         try
         {
-            context->ebml_file->close();
+            if (context->ebml_file)
+            {
+                context->ebml_file->close();
+            }
         }
         catch (std::ios_base::failure &e)
         {
-            LOG_ERROR("Failed to close recording '%s': %s", context->file_path, e.what());
+            LOG_ERROR("Failed to close recording '%s': %s", context->file_path.c_str(), e.what());
+            file_complete = false;
         }
+        close_live_index(context, file_complete);
     }
     k4a_record_t_destroy(recording_handle);
 }
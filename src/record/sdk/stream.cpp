@@ -0,0 +1,1057 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <k4a/k4a.h>
+#include <k4arecord/stream.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/matroska_common.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET stream_socket_t;
+#define STREAM_INVALID_SOCKET INVALID_SOCKET
+#define STREAM_SHUT_RDWR SD_BOTH
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+typedef int stream_socket_t;
+#define STREAM_INVALID_SOCKET (-1)
+#define STREAM_SHUT_RDWR SHUT_RDWR
+#endif
+
+using namespace k4arecord;
+
+// The wire format is a hello message from the server, followed by one frame per capture. Headers are sent in the byte
+// order of the host, which is little endian on every platform the SDK supports.
+#define STREAM_MAGIC 0x314D5453 // STM1
+#define STREAM_VERSION 1
+
+#define STREAM_SLOT_COLOR 0
+#define STREAM_SLOT_DEPTH 1
+#define STREAM_SLOT_IR 2
+#define STREAM_SLOT_COUNT 3
+
+// Bounds on what a client accepts from the network, a 4096x3072 BGRA image is 48 MB
+#define STREAM_MAX_PAYLOAD_BYTES (64 * 1024 * 1024)
+#define STREAM_MAX_CALIBRATION_BYTES (1024 * 1024)
+
+#define STREAM_DEFAULT_QUEUE_LIMIT 2
+#define STREAM_CLIENT_QUEUE_LIMIT 2
+
+// How often the accept thread checks for the server closing
+#define STREAM_ACCEPT_POLL_USEC 100000
+
+typedef struct _stream_hello_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t color_format;
+    uint32_t color_resolution;
+    uint32_t depth_mode;
+    uint32_t camera_fps;
+    int32_t depth_delay_off_color_usec;
+    uint32_t wired_sync_mode;
+    uint32_t subordinate_delay_off_master_usec;
+    uint32_t synchronized_images_only;
+    uint32_t calibration_size; // Size of the raw calibration following the hello, 0 without a device
+    uint32_t reserved;
+} stream_hello_t;
+
+typedef struct _stream_frame_header_t
+{
+    uint32_t magic;
+    uint32_t image_count; // Number of image headers, each followed by its payload
+} stream_frame_header_t;
+
+typedef struct _stream_image_header_t
+{
+    uint32_t slot;
+    uint32_t format; // k4a_image_format_t
+    uint32_t codec;  // k4a_record_depth_codec_t of the payload
+    uint32_t width_pixels;
+    uint32_t height_pixels;
+    uint32_t stride_bytes;
+    uint64_t device_timestamp_usec;
+    uint64_t system_timestamp_nsec;
+    uint64_t exposure_usec;
+    uint32_t white_balance;
+    uint32_t iso_speed;
+    uint64_t payload_size;
+} stream_image_header_t;
+
+static_assert(sizeof(stream_hello_t) == 48, "stream_hello_t is part of the wire format");
+static_assert(sizeof(stream_frame_header_t) == 8, "stream_frame_header_t is part of the wire format");
+static_assert(sizeof(stream_image_header_t) == 64, "stream_image_header_t is part of the wire format");
+
+// A connected client of a server, served by its own sender thread
+typedef struct _stream_connection_t
+{
+    stream_socket_t socket;
+    std::thread sender;
+    std::deque<k4a_capture_t> queue; // Captures waiting to be sent, the newest capture is at the back.
+    bool closed = false;             // Set by the sender thread when the connection fails
+
+    std::vector<uint8_t> encode_buffers[STREAM_SLOT_COUNT]; // RVL output, only used by the sender thread
+} stream_connection_t;
+
+typedef struct _k4a_stream_server_context_t
+{
+    stream_socket_t listen_socket;
+    uint16_t port;
+    std::vector<uint8_t> hello; // Hello message and raw calibration sent to every client
+    std::thread accept_thread;
+
+    std::mutex lock; // Locks access to the members below and the queues of connections
+    std::condition_variable queue_condition;
+    std::list<std::unique_ptr<stream_connection_t>> connections;
+    k4a_record_depth_codec_t depth_codec;
+    size_t max_queued_captures;
+    uint64_t dropped_capture_count;
+    bool closing;
+} k4a_stream_server_context_t;
+
+typedef struct _k4a_stream_client_context_t
+{
+    stream_socket_t socket;
+    k4a_device_configuration_t device_config;
+    std::vector<char> raw_calibration; // Null terminated
+    std::thread receiver;
+
+    std::mutex lock; // Locks access to the members below
+    std::condition_variable capture_condition;
+    std::deque<k4a_capture_t> captures; // Received captures, the newest capture is at the back.
+    bool connected;
+} k4a_stream_client_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_stream_server_t, k4a_stream_server_context_t);
+K4A_DECLARE_CONTEXT(k4a_stream_client_t, k4a_stream_client_context_t);
+
+// A buffer of a message, sent without copying it into the message
+typedef struct _stream_buffer_t
+{
+    const void *data;
+    size_t size;
+} stream_buffer_t;
+
+static bool stream_startup()
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        LOG_ERROR("WSAStartup failed", 0);
+        return false;
+    }
+#endif
+    return true;
+}
+
+static void stream_cleanup()
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+static void close_socket(stream_socket_t socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static void set_no_delay(stream_socket_t socket)
+{
+    // Frames are written whole, waiting to coalesce them only adds latency
+    int no_delay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&no_delay), sizeof(no_delay));
+}
+
+// Sends a list of buffers with one gather write, so image buffers are sent straight from the capture.
+static bool send_buffers(stream_socket_t socket, const std::vector<stream_buffer_t> &buffers)
+{
+#ifdef _WIN32
+    std::vector<WSABUF> wsa_buffers;
+    for (const stream_buffer_t &buffer : buffers)
+    {
+        if (buffer.size > ULONG_MAX)
+        {
+            return false;
+        }
+        WSABUF wsa_buffer;
+        wsa_buffer.buf = static_cast<CHAR *>(const_cast<void *>(buffer.data));
+        wsa_buffer.len = static_cast<ULONG>(buffer.size);
+        wsa_buffers.push_back(wsa_buffer);
+    }
+
+    // A blocking WSASend() returns once every buffer has been sent
+    DWORD bytes_sent = 0;
+    return WSASend(socket, wsa_buffers.data(), (DWORD)wsa_buffers.size(), &bytes_sent, 0, NULL, NULL) == 0;
+#else
+    std::vector<struct iovec> iov;
+    for (const stream_buffer_t &buffer : buffers)
+    {
+        struct iovec entry;
+        entry.iov_base = const_cast<void *>(buffer.data);
+        entry.iov_len = buffer.size;
+        iov.push_back(entry);
+    }
+
+    size_t next = 0;
+    while (next < iov.size())
+    {
+        struct msghdr message = {};
+        message.msg_iov = &iov[next];
+        message.msg_iovlen = iov.size() - next;
+
+        // MSG_NOSIGNAL reports a closed connection as an error instead of raising SIGPIPE
+        ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            return false;
+        }
+
+        // Skip what was sent, sendmsg() can return before sending every buffer
+        size_t remaining = (size_t)sent;
+        while (next < iov.size() && remaining >= iov[next].iov_len)
+        {
+            remaining -= iov[next].iov_len;
+            next++;
+        }
+        if (next < iov.size())
+        {
+            iov[next].iov_base = static_cast<uint8_t *>(iov[next].iov_base) + remaining;
+            iov[next].iov_len -= remaining;
+        }
+    }
+    return true;
+#endif
+}
+
+static bool receive_buffer(stream_socket_t socket, void *data, size_t size)
+{
+    uint8_t *next = static_cast<uint8_t *>(data);
+    while (size > 0)
+    {
+        int chunk = size > INT32_MAX ? INT32_MAX : (int)size;
+        int received = (int)recv(socket, reinterpret_cast<char *>(next), chunk, 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        next += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+static void free_vector_buffer(void *buffer, void *context)
+{
+    (void)buffer;
+    delete static_cast<std::vector<uint8_t> *>(context);
+}
+
+static k4a_image_t get_capture_image(k4a_capture_t capture, uint32_t slot)
+{
+    switch (slot)
+    {
+    case STREAM_SLOT_COLOR:
+        return k4a_capture_get_color_image(capture);
+    case STREAM_SLOT_DEPTH:
+        return k4a_capture_get_depth_image(capture);
+    default:
+        return k4a_capture_get_ir_image(capture);
+    }
+}
+
+static void set_capture_image(k4a_capture_t capture, uint32_t slot, k4a_image_t image)
+{
+    switch (slot)
+    {
+    case STREAM_SLOT_COLOR:
+        k4a_capture_set_color_image(capture, image);
+        break;
+    case STREAM_SLOT_DEPTH:
+        k4a_capture_set_depth_image(capture, image);
+        break;
+    default:
+        k4a_capture_set_ir_image(capture, image);
+        break;
+    }
+}
+
+// Sends one capture as a frame, encoding depth and IR images with the codec and sending other payloads in place.
+static bool send_capture(stream_connection_t *connection, k4a_capture_t capture, k4a_record_depth_codec_t codec)
+{
+    k4a_image_t images[STREAM_SLOT_COUNT] = {};
+    stream_image_header_t headers[STREAM_SLOT_COUNT] = {};
+    stream_frame_header_t frame_header = {};
+    frame_header.magic = STREAM_MAGIC;
+
+    std::vector<stream_buffer_t> buffers;
+    buffers.push_back({ &frame_header, sizeof(frame_header) });
+
+    bool result = true;
+    for (uint32_t slot = 0; slot < STREAM_SLOT_COUNT && result; slot++)
+    {
+        k4a_image_t image = images[slot] = get_capture_image(capture, slot);
+        if (image == NULL)
+        {
+            continue;
+        }
+
+        stream_image_header_t *header = &headers[slot];
+        header->slot = slot;
+        header->format = (uint32_t)k4a_image_get_format(image);
+        header->codec = K4A_RECORD_DEPTH_CODEC_RAW;
+        header->width_pixels = (uint32_t)k4a_image_get_width_pixels(image);
+        header->height_pixels = (uint32_t)k4a_image_get_height_pixels(image);
+        header->stride_bytes = (uint32_t)k4a_image_get_stride_bytes(image);
+        header->device_timestamp_usec = k4a_image_get_device_timestamp_usec(image);
+        header->system_timestamp_nsec = k4a_image_get_system_timestamp_nsec(image);
+        header->exposure_usec = k4a_image_get_exposure_usec(image);
+        header->white_balance = k4a_image_get_white_balance(image);
+        header->iso_speed = k4a_image_get_iso_speed(image);
+
+        const uint8_t *payload = k4a_image_get_buffer(image);
+        size_t payload_size = k4a_image_get_size(image);
+
+        // Only packed depth and IR images are compressed, anything else is sent as is
+        bool is_depth = header->format == K4A_IMAGE_FORMAT_DEPTH16 || header->format == K4A_IMAGE_FORMAT_IR16;
+        size_t pixel_count = (size_t)header->width_pixels * header->height_pixels;
+        if (codec == K4A_RECORD_DEPTH_CODEC_RVL && is_depth &&
+            header->stride_bytes == header->width_pixels * sizeof(uint16_t) &&
+            payload_size >= pixel_count * sizeof(uint16_t))
+        {
+            std::vector<uint8_t> &encoded = connection->encode_buffers[slot];
+            encoded.resize(rvl_max_encoded_size(pixel_count));
+            payload_size = rvl_encode(reinterpret_cast<const uint16_t *>(payload),
+                                      pixel_count,
+                                      encoded.data(),
+                                      encoded.size());
+            payload = encoded.data();
+            header->codec = K4A_RECORD_DEPTH_CODEC_RVL;
+            result = payload_size > 0;
+        }
+
+        header->payload_size = payload_size;
+        buffers.push_back({ header, sizeof(*header) });
+        buffers.push_back({ payload, payload_size });
+        frame_header.image_count++;
+    }
+
+    if (result)
+    {
+        result = send_buffers(connection->socket, buffers);
+    }
+
+    for (k4a_image_t image : images)
+    {
+        if (image != NULL)
+        {
+            k4a_image_release(image);
+        }
+    }
+    return result;
+}
+
+static void connection_sender_thread(k4a_stream_server_context_t *context, stream_connection_t *connection)
+{
+    bool connected = send_buffers(connection->socket, { { context->hello.data(), context->hello.size() } });
+
+    std::unique_lock<std::mutex> lock(context->lock);
+    while (connected)
+    {
+        context->queue_condition.wait(lock, [&]() { return context->closing || !connection->queue.empty(); });
+        if (context->closing)
+        {
+            break;
+        }
+
+        k4a_capture_t capture = connection->queue.front();
+        connection->queue.pop_front();
+        k4a_record_depth_codec_t codec = context->depth_codec;
+        lock.unlock();
+
+        connected = send_capture(connection, capture, codec);
+        k4a_capture_release(capture);
+
+        lock.lock();
+    }
+
+    if (!connected)
+    {
+        LOG_INFO("Stream client disconnected", 0);
+    }
+
+    connection->closed = true;
+    for (k4a_capture_t capture : connection->queue)
+    {
+        k4a_capture_release(capture);
+    }
+    connection->queue.clear();
+}
+
+static void close_connection(std::unique_ptr<stream_connection_t> &connection)
+{
+    // Shutting the socket down makes a blocked send fail, so the sender thread returns
+    shutdown(connection->socket, STREAM_SHUT_RDWR);
+    if (connection->sender.joinable())
+    {
+        connection->sender.join();
+    }
+    close_socket(connection->socket);
+}
+
+static void server_accept_thread(k4a_stream_server_context_t *context)
+{
+    while (true)
+    {
+        std::list<std::unique_ptr<stream_connection_t>> closed_connections;
+        {
+            std::lock_guard<std::mutex> lock(context->lock);
+            if (context->closing)
+            {
+                break;
+            }
+            for (auto it = context->connections.begin(); it != context->connections.end();)
+            {
+                auto next = std::next(it);
+                if ((*it)->closed)
+                {
+                    closed_connections.splice(closed_connections.end(), context->connections, it);
+                }
+                it = next;
+            }
+        }
+        for (auto &connection : closed_connections)
+        {
+            close_connection(connection);
+        }
+
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(context->listen_socket, &read_set);
+        struct timeval timeout = { 0, STREAM_ACCEPT_POLL_USEC };
+        if (select((int)context->listen_socket + 1, &read_set, NULL, NULL, &timeout) <= 0)
+        {
+            continue;
+        }
+
+        stream_socket_t socket = accept(context->listen_socket, NULL, NULL);
+        if (socket == STREAM_INVALID_SOCKET)
+        {
+            continue;
+        }
+        set_no_delay(socket);
+
+        std::unique_ptr<stream_connection_t> connection = make_unique<stream_connection_t>();
+        connection->socket = socket;
+        std::lock_guard<std::mutex> lock(context->lock);
+        connection->sender = std::thread(connection_sender_thread, context, connection.get());
+        context->connections.push_back(std::move(connection));
+        LOG_INFO("Stream client connected", 0);
+    }
+}
+
+// Builds the hello message sent to every client
+static k4a_result_t create_hello(k4a_device_t device,
+                                 const k4a_device_configuration_t &device_config,
+                                 std::vector<uint8_t> &hello)
+{
+    std::vector<uint8_t> calibration;
+    if (device != NULL)
+    {
+        size_t calibration_size = 0;
+        k4a_buffer_result_t buffer_result = TRACE_BUFFER_CALL(
+            k4a_device_get_raw_calibration(device, NULL, &calibration_size));
+        if (buffer_result == K4A_BUFFER_RESULT_TOO_SMALL)
+        {
+            calibration.resize(calibration_size);
+            buffer_result = TRACE_BUFFER_CALL(
+                k4a_device_get_raw_calibration(device, calibration.data(), &calibration_size));
+        }
+        if (buffer_result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            LOG_ERROR("Failed to read the device calibration", 0);
+            return K4A_RESULT_FAILED;
+        }
+        calibration.resize(calibration_size);
+    }
+
+    stream_hello_t message = {};
+    message.magic = STREAM_MAGIC;
+    message.version = STREAM_VERSION;
+    message.color_format = (uint32_t)device_config.color_format;
+    message.color_resolution = (uint32_t)device_config.color_resolution;
+    message.depth_mode = (uint32_t)device_config.depth_mode;
+    message.camera_fps = (uint32_t)device_config.camera_fps;
+    message.depth_delay_off_color_usec = device_config.depth_delay_off_color_usec;
+    message.wired_sync_mode = (uint32_t)device_config.wired_sync_mode;
+    message.subordinate_delay_off_master_usec = device_config.subordinate_delay_off_master_usec;
+    message.synchronized_images_only = device_config.synchronized_images_only ? 1 : 0;
+    message.calibration_size = (uint32_t)calibration.size();
+
+    hello.resize(sizeof(message) + calibration.size());
+    memcpy(hello.data(), &message, sizeof(message));
+    if (!calibration.empty())
+    {
+        memcpy(hello.data() + sizeof(message), calibration.data(), calibration.size());
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_stream_server_create(uint16_t port,
+                                      k4a_device_t device,
+                                      const k4a_device_configuration_t device_config,
+                                      k4a_stream_server_t *server_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, server_handle == NULL);
+
+    if (!stream_startup())
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_stream_server_context_t *context = k4a_stream_server_t_create(server_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+    if (K4A_FAILED(result))
+    {
+        stream_cleanup();
+        return result;
+    }
+
+    context->listen_socket = STREAM_INVALID_SOCKET;
+    context->depth_codec = K4A_RECORD_DEPTH_CODEC_RVL;
+    context->max_queued_captures = STREAM_DEFAULT_QUEUE_LIMIT;
+    context->dropped_capture_count = 0;
+    context->closing = false;
+
+    result = create_hello(device, device_config, context->hello);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->listen_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        result = K4A_RESULT_FROM_BOOL(context->listen_socket != STREAM_INVALID_SOCKET);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+#ifndef _WIN32
+        // Allow restarting a server on its port while connections of the last one are in TIME_WAIT
+        int reuse = 1;
+        setsockopt(context->listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (bind(context->listen_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(context->listen_socket, SOMAXCONN) != 0)
+        {
+            LOG_ERROR("Failed to listen on port %u", port);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        struct sockaddr_in address = {};
+        socklen_t address_size = sizeof(address);
+        result = K4A_RESULT_FROM_BOOL(
+            getsockname(context->listen_socket, reinterpret_cast<struct sockaddr *>(&address), &address_size) == 0);
+        context->port = ntohs(address.sin_port);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->accept_thread = std::thread(server_accept_thread, context);
+        LOG_INFO("Streaming captures on port %u", context->port);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        k4a_stream_server_close(*server_handle);
+        *server_handle = NULL;
+    }
+
+    return result;
+}
+
+uint16_t k4a_stream_server_get_port(k4a_stream_server_t server_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_stream_server_t, server_handle);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+    return context->port;
+}
+
+k4a_result_t k4a_stream_server_set_depth_codec(k4a_stream_server_t server_handle, k4a_record_depth_codec_t codec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_stream_server_t, server_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec != K4A_RECORD_DEPTH_CODEC_RAW && codec != K4A_RECORD_DEPTH_CODEC_RVL);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    context->depth_codec = codec;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_stream_server_set_queue_limit(k4a_stream_server_t server_handle, size_t max_queued_captures)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_stream_server_t, server_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, max_queued_captures == 0);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    context->max_queued_captures = max_queued_captures;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_stream_server_write_capture(k4a_stream_server_t server_handle, k4a_capture_t capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_stream_server_t, server_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        for (auto &connection : context->connections)
+        {
+            if (connection->closed)
+            {
+                continue;
+            }
+
+            // The client can't keep up, drop its oldest capture so it stays on the newest ones
+            while (connection->queue.size() >= context->max_queued_captures)
+            {
+                k4a_capture_release(connection->queue.front());
+                connection->queue.pop_front();
+                context->dropped_capture_count++;
+            }
+
+            k4a_capture_reference(capture_handle);
+            connection->queue.push_back(capture_handle);
+        }
+    }
+    context->queue_condition.notify_all();
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+uint64_t k4a_stream_server_get_dropped_capture_count(k4a_stream_server_t server_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_stream_server_t, server_handle);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    return context->dropped_capture_count;
+}
+
+void k4a_stream_server_close(k4a_stream_server_t server_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_stream_server_t, server_handle);
+    k4a_stream_server_context_t *context = k4a_stream_server_t_get_context(server_handle);
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        context->closing = true;
+    }
+    context->queue_condition.notify_all();
+
+    if (context->accept_thread.joinable())
+    {
+        context->accept_thread.join();
+    }
+
+    // The accept thread has stopped, so the list of connections doesn't change anymore
+    for (auto &connection : context->connections)
+    {
+        close_connection(connection);
+    }
+    context->connections.clear();
+
+    if (context->listen_socket != STREAM_INVALID_SOCKET)
+    {
+        close_socket(context->listen_socket);
+    }
+
+    k4a_stream_server_t_destroy(server_handle);
+    stream_cleanup();
+}
+
+// Receives the payload of an image into a new image
+static k4a_result_t receive_image(k4a_stream_client_context_t *context,
+                                  const stream_image_header_t &header,
+                                  k4a_image_t *image)
+{
+    if (header.slot >= STREAM_SLOT_COUNT || header.payload_size > STREAM_MAX_PAYLOAD_BYTES)
+    {
+        LOG_ERROR("Invalid image received from the stream server", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<uint8_t> *buffer = nullptr;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (header.codec == K4A_RECORD_DEPTH_CODEC_RVL)
+    {
+        // Decoded images are always packed, so the size is known before decoding
+        size_t pixel_count = (size_t)header.width_pixels * header.height_pixels;
+        std::vector<uint8_t> encoded((size_t)header.payload_size);
+        result = K4A_RESULT_FROM_BOOL(receive_buffer(context->socket, encoded.data(), encoded.size()));
+        if (K4A_SUCCEEDED(result) && (pixel_count * sizeof(uint16_t) > STREAM_MAX_PAYLOAD_BYTES ||
+                                      header.stride_bytes != header.width_pixels * sizeof(uint16_t) ||
+                                      rvl_get_pixel_count(encoded.data(), encoded.size()) != pixel_count))
+        {
+            LOG_ERROR("Invalid RVL image received from the stream server", 0);
+            result = K4A_RESULT_FAILED;
+        }
+        if (K4A_SUCCEEDED(result))
+        {
+            buffer = new std::vector<uint8_t>(pixel_count * sizeof(uint16_t));
+            result = TRACE_CALL(rvl_decode(encoded.data(),
+                                           encoded.size(),
+                                           reinterpret_cast<uint16_t *>(buffer->data()),
+                                           pixel_count));
+        }
+    }
+    else if (header.codec == K4A_RECORD_DEPTH_CODEC_RAW)
+    {
+        // Receive straight into the buffer of the image
+        buffer = new std::vector<uint8_t>((size_t)header.payload_size);
+        result = K4A_RESULT_FROM_BOOL(receive_buffer(context->socket, buffer->data(), buffer->size()));
+    }
+    else
+    {
+        LOG_ERROR("Unknown codec received from the stream server: %u", header.codec);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(k4a_image_create_from_buffer((k4a_image_format_t)header.format,
+                                                         (int)header.width_pixels,
+                                                         (int)header.height_pixels,
+                                                         (int)header.stride_bytes,
+                                                         buffer->data(),
+                                                         buffer->size(),
+                                                         &free_vector_buffer,
+                                                         buffer,
+                                                         image));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        k4a_image_set_device_timestamp_usec(*image, header.device_timestamp_usec);
+        k4a_image_set_system_timestamp_nsec(*image, header.system_timestamp_nsec);
+        k4a_image_set_exposure_usec(*image, header.exposure_usec);
+        k4a_image_set_white_balance(*image, header.white_balance);
+        k4a_image_set_iso_speed(*image, header.iso_speed);
+    }
+    else if (buffer != nullptr)
+    {
+        delete buffer;
+    }
+
+    return result;
+}
+
+static k4a_result_t receive_capture(k4a_stream_client_context_t *context, k4a_capture_t *capture)
+{
+    stream_frame_header_t frame_header;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(
+        receive_buffer(context->socket, &frame_header, sizeof(frame_header)));
+    if (K4A_SUCCEEDED(result) &&
+        (frame_header.magic != STREAM_MAGIC || frame_header.image_count > STREAM_SLOT_COUNT))
+    {
+        LOG_ERROR("Invalid frame received from the stream server", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(k4a_capture_create(capture));
+    }
+
+    for (uint32_t i = 0; K4A_SUCCEEDED(result) && i < frame_header.image_count; i++)
+    {
+        stream_image_header_t header;
+        k4a_image_t image = NULL;
+        result = K4A_RESULT_FROM_BOOL(receive_buffer(context->socket, &header, sizeof(header)));
+        if (K4A_SUCCEEDED(result))
+        {
+            result = receive_image(context, header, &image);
+        }
+        if (K4A_SUCCEEDED(result))
+        {
+            set_capture_image(*capture, header.slot, image);
+            k4a_image_release(image);
+        }
+    }
+
+    if (K4A_FAILED(result) && *capture != NULL)
+    {
+        k4a_capture_release(*capture);
+        *capture = NULL;
+    }
+    return result;
+}
+
+static void client_receiver_thread(k4a_stream_client_context_t *context)
+{
+    while (true)
+    {
+        k4a_capture_t capture = NULL;
+        if (K4A_FAILED(receive_capture(context, &capture)))
+        {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(context->lock);
+            // The caller can't keep up, drop the oldest capture like the device does
+            while (context->captures.size() >= STREAM_CLIENT_QUEUE_LIMIT)
+            {
+                k4a_capture_release(context->captures.front());
+                context->captures.pop_front();
+            }
+            context->captures.push_back(capture);
+        }
+        context->capture_condition.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        context->connected = false;
+    }
+    context->capture_condition.notify_all();
+}
+
+static stream_socket_t connect_to_server(const char *host, uint16_t port)
+{
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    struct addrinfo *addresses = NULL;
+    if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &addresses) != 0)
+    {
+        LOG_ERROR("Failed to resolve stream server %s", host);
+        return STREAM_INVALID_SOCKET;
+    }
+
+    stream_socket_t result = STREAM_INVALID_SOCKET;
+    for (struct addrinfo *address = addresses; address != NULL && result == STREAM_INVALID_SOCKET;
+         address = address->ai_next)
+    {
+        stream_socket_t socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socket == STREAM_INVALID_SOCKET)
+        {
+            continue;
+        }
+        if (connect(socket, address->ai_addr, (socklen_t)address->ai_addrlen) != 0)
+        {
+            close_socket(socket);
+            continue;
+        }
+        result = socket;
+    }
+    freeaddrinfo(addresses);
+
+    if (result == STREAM_INVALID_SOCKET)
+    {
+        LOG_ERROR("Failed to connect to stream server %s:%u", host, port);
+    }
+    return result;
+}
+
+// Reads the hello message of the server
+static k4a_result_t receive_hello(k4a_stream_client_context_t *context)
+{
+    stream_hello_t hello;
+    if (!receive_buffer(context->socket, &hello, sizeof(hello)))
+    {
+        LOG_ERROR("Failed to read the hello message of the stream server", 0);
+        return K4A_RESULT_FAILED;
+    }
+    if (hello.magic != STREAM_MAGIC || hello.version != STREAM_VERSION ||
+        hello.calibration_size > STREAM_MAX_CALIBRATION_BYTES)
+    {
+        LOG_ERROR("Unsupported stream server, version %u", hello.version);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->device_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    context->device_config.color_format = (k4a_image_format_t)hello.color_format;
+    context->device_config.color_resolution = (k4a_color_resolution_t)hello.color_resolution;
+    context->device_config.depth_mode = (k4a_depth_mode_t)hello.depth_mode;
+    context->device_config.camera_fps = (k4a_fps_t)hello.camera_fps;
+    context->device_config.depth_delay_off_color_usec = hello.depth_delay_off_color_usec;
+    context->device_config.wired_sync_mode = (k4a_wired_sync_mode_t)hello.wired_sync_mode;
+    context->device_config.subordinate_delay_off_master_usec = hello.subordinate_delay_off_master_usec;
+    context->device_config.synchronized_images_only = hello.synchronized_images_only != 0;
+
+    // The calibration is kept null terminated for k4a_calibration_get_from_raw()
+    if (hello.calibration_size > 0)
+    {
+        context->raw_calibration.resize(hello.calibration_size + 1);
+        if (!receive_buffer(context->socket, context->raw_calibration.data(), hello.calibration_size))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        context->raw_calibration[hello.calibration_size] = '\0';
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_stream_client_open(const char *host, uint16_t port, k4a_stream_client_t *client_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, host == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, client_handle == NULL);
+
+    if (!stream_startup())
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_stream_client_context_t *context = k4a_stream_client_t_create(client_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+    if (K4A_FAILED(result))
+    {
+        stream_cleanup();
+        return result;
+    }
+
+    context->connected = false;
+    context->socket = connect_to_server(host, port);
+    result = K4A_RESULT_FROM_BOOL(context->socket != STREAM_INVALID_SOCKET);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        set_no_delay(context->socket);
+        result = receive_hello(context);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->connected = true;
+        context->receiver = std::thread(client_receiver_thread, context);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        k4a_stream_client_close(*client_handle);
+        *client_handle = NULL;
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_stream_client_get_device_configuration(k4a_stream_client_t client_handle,
+                                                        k4a_device_configuration_t *device_config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_stream_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_config == NULL);
+    k4a_stream_client_context_t *context = k4a_stream_client_t_get_context(client_handle);
+
+    *device_config = context->device_config;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_stream_client_get_calibration(k4a_stream_client_t client_handle, k4a_calibration_t *calibration)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_stream_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    k4a_stream_client_context_t *context = k4a_stream_client_t_get_context(client_handle);
+
+    if (context->raw_calibration.empty())
+    {
+        LOG_ERROR("The stream server did not send a device calibration.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    return TRACE_CALL(k4a_calibration_get_from_raw(context->raw_calibration.data(),
+                                                   context->raw_calibration.size(),
+                                                   context->device_config.depth_mode,
+                                                   context->device_config.color_resolution,
+                                                   calibration));
+}
+
+k4a_wait_result_t k4a_stream_client_get_capture(k4a_stream_client_t client_handle,
+                                                k4a_capture_t *capture_handle,
+                                                int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_stream_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, capture_handle == NULL);
+    k4a_stream_client_context_t *context = k4a_stream_client_t_get_context(client_handle);
+
+    std::unique_lock<std::mutex> lock(context->lock);
+    auto ready = [&]() { return !context->captures.empty() || !context->connected; };
+    if (timeout_in_ms == K4A_WAIT_INFINITE)
+    {
+        context->capture_condition.wait(lock, ready);
+    }
+    else
+    {
+        context->capture_condition.wait_for(lock, std::chrono::milliseconds(timeout_in_ms), ready);
+    }
+
+    // Captures received before the connection was lost are still returned
+    if (!context->captures.empty())
+    {
+        *capture_handle = context->captures.front();
+        context->captures.pop_front();
+        return K4A_WAIT_RESULT_SUCCEEDED;
+    }
+    return context->connected ? K4A_WAIT_RESULT_TIMEOUT : K4A_WAIT_RESULT_FAILED;
+}
+
+void k4a_stream_client_close(k4a_stream_client_t client_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_stream_client_t, client_handle);
+    k4a_stream_client_context_t *context = k4a_stream_client_t_get_context(client_handle);
+
+    if (context->socket != STREAM_INVALID_SOCKET)
+    {
+        // Shutting the socket down makes a blocked receive fail, so the receiver thread returns
+        shutdown(context->socket, STREAM_SHUT_RDWR);
+        if (context->receiver.joinable())
+        {
+            context->receiver.join();
+        }
+        close_socket(context->socket);
+    }
+
+    for (k4a_capture_t capture : context->captures)
+    {
+        k4a_capture_release(capture);
+    }
+    context->captures.clear();
+
+    k4a_stream_client_t_destroy(client_handle);
+    stream_cleanup();
+}
@@ -8,69 +8,175 @@
 
 // System dependencies
 #include <assert.h>
-#include <pthread.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
-// TODO: static_assert be available with C11. See Issue #482
-// static_assert(sizeof(k4a_rwlock_t) == sizeof(pthread_rwlock_t),
-//              "Linux pthread_rwlock_t size doesn't match generic k4a_rwlock_t size");
+// Layout of k4a_rwlock_t::state. The low bits count the readers holding the lock.
+#define RWLOCK_WRITER (0x80000000u)  // A writer holds the lock
+#define RWLOCK_WAITERS (0x40000000u) // A thread may be sleeping on the lock word
+#define RWLOCK_READERS (0x3FFFFFFFu)
 
-// If one of the lock synchronization functions fails, retry forever
-// rather than return an error code since callers are unlikeley to
-// properly test the error condition and crashing should be avoided.
+// Attempts to take the lock before sleeping on it. A holder usually releases the lock within this many attempts, and
+// sleeping costs two system calls.
+#define RWLOCK_SPIN_COUNT (100)
 
-void rwlock_init(k4a_rwlock_t *lock)
+#define rwlock_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define rwlock_atomic_compare_exchange(ptr, expected, desired)                                                         \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+
+static void rwlock_wait(k4a_rwlock_t *lock, uint32_t state)
+{
+    // Returns immediately if the lock word no longer matches, which is the wake up we could otherwise miss
+    syscall(SYS_futex, &lock->state, FUTEX_WAIT_PRIVATE, state, NULL, NULL, 0);
+}
+
+static void rwlock_wake_all(k4a_rwlock_t *lock)
+{
+    syscall(SYS_futex, &lock->state, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+// Flags the lock word so the next release wakes the sleepers, then sleeps until it changes. Returns without sleeping
+// if the lock word changed in the meantime.
+static void rwlock_wait_for_change(k4a_rwlock_t *lock, uint32_t state)
 {
-    int err;
-    while ((err = pthread_rwlock_init((pthread_rwlock_t *)lock, NULL)))
+    if ((state & RWLOCK_WAITERS) == 0)
     {
-        assert(err == 0);
+        if (!rwlock_atomic_compare_exchange(&lock->state, &state, state | RWLOCK_WAITERS))
+        {
+            return;
+        }
+        state |= RWLOCK_WAITERS;
     }
+    rwlock_wait(lock, state);
 }
-void rwlock_deinit(k4a_rwlock_t *lock)
+
+// Sleeps until the lock word changes, for a reader that rwlock_try_acquire_read() turned away. A reader turned away
+// because a writer is waiting sleeps on a lock word that doesn't hold that condition, and the writer can take and
+// release the lock before the reader flags it, leaving the word as it was with nobody to wake the reader. Once the
+// sleepers are flagged, a writer that is still waiting will wake them when it releases the lock, so the reader only
+// sleeps if it is still turned away.
+static void rwlock_wait_for_read(k4a_rwlock_t *lock, uint32_t state)
 {
-    int err;
-    while ((err = pthread_rwlock_destroy((pthread_rwlock_t *)lock)))
+    if ((state & RWLOCK_WAITERS) == 0)
     {
-        assert(err == 0);
+        if (!rwlock_atomic_compare_exchange(&lock->state, &state, state | RWLOCK_WAITERS))
+        {
+            return;
+        }
+        state |= RWLOCK_WAITERS;
     }
+
+    if ((state & RWLOCK_WRITER) == 0 && __atomic_load_n(&lock->writers_waiting, __ATOMIC_SEQ_CST) == 0)
+    {
+        return;
+    }
+    rwlock_wait(lock, state);
 }
 
-void rwlock_acquire_read(k4a_rwlock_t *lock)
+void rwlock_init(k4a_rwlock_t *lock)
+{
+    lock->state = 0;
+    lock->writers_waiting = 0;
+}
+
+void rwlock_deinit(k4a_rwlock_t *lock)
+{
+    (void)lock;
+    assert(lock->state == 0);
+}
+
+bool rwlock_try_acquire_read(k4a_rwlock_t *lock)
 {
-    int err;
-    while ((err = pthread_rwlock_rdlock((pthread_rwlock_t *)lock)))
+    uint32_t state = rwlock_atomic_load(&lock->state);
+
+    // Waiting writers go first so a steady stream of readers cannot starve them
+    while ((state & RWLOCK_WRITER) == 0 && rwlock_atomic_load(&lock->writers_waiting) == 0)
     {
-        assert(err == 0);
+        assert((state & RWLOCK_READERS) != RWLOCK_READERS);
+        if (rwlock_atomic_compare_exchange(&lock->state, &state, state + 1))
+        {
+            return true;
+        }
     }
+    return false;
 }
 
-bool rwlock_try_acquire_read(k4a_rwlock_t *lock)
+void rwlock_acquire_read(k4a_rwlock_t *lock)
 {
-    int err = pthread_rwlock_tryrdlock((pthread_rwlock_t *)lock);
-    return err == 0;
+    for (int spin = 0; spin < RWLOCK_SPIN_COUNT; spin++)
+    {
+        if (rwlock_try_acquire_read(lock))
+        {
+            return;
+        }
+    }
+
+    while (!rwlock_try_acquire_read(lock))
+    {
+        rwlock_wait_for_read(lock, rwlock_atomic_load(&lock->state));
+    }
 }
 
-void rwlock_acquire_write(k4a_rwlock_t *lock)
+// Takes the lock for writing if nobody holds it, ignoring other waiting writers
+static bool rwlock_try_acquire_write_internal(k4a_rwlock_t *lock)
 {
-    int err;
-    while ((err = pthread_rwlock_wrlock((pthread_rwlock_t *)lock)))
+    uint32_t state = rwlock_atomic_load(&lock->state);
+    while ((state & (RWLOCK_WRITER | RWLOCK_READERS)) == 0)
     {
-        assert(err == 0);
+        if (rwlock_atomic_compare_exchange(&lock->state, &state, state | RWLOCK_WRITER))
+        {
+            return true;
+        }
     }
+    return false;
 }
 
 bool rwlock_try_acquire_write(k4a_rwlock_t *lock)
 {
-    int err = pthread_rwlock_trywrlock((pthread_rwlock_t *)lock);
-    return err == 0;
+    return rwlock_try_acquire_write_internal(lock);
+}
+
+void rwlock_acquire_write(k4a_rwlock_t *lock)
+{
+    for (int spin = 0; spin < RWLOCK_SPIN_COUNT; spin++)
+    {
+        if (rwlock_try_acquire_write_internal(lock))
+        {
+            return;
+        }
+    }
+
+    // Hold off new readers until this writer got the lock
+    __atomic_add_fetch(&lock->writers_waiting, 1, __ATOMIC_SEQ_CST);
+    while (!rwlock_try_acquire_write_internal(lock))
+    {
+        rwlock_wait_for_change(lock, rwlock_atomic_load(&lock->state));
+    }
+    __atomic_sub_fetch(&lock->writers_waiting, 1, __ATOMIC_SEQ_CST);
 }
 
 void rwlock_release_read(k4a_rwlock_t *lock)
 {
-    pthread_rwlock_unlock((pthread_rwlock_t *)lock);
+    uint32_t state = __atomic_sub_fetch(&lock->state, 1, __ATOMIC_RELEASE);
+
+    // Only a writer can be waiting for readers to leave, and it needs all of them gone
+    if (state == RWLOCK_WAITERS)
+    {
+        if (__atomic_fetch_and(&lock->state, ~RWLOCK_WAITERS, __ATOMIC_RELAXED) & RWLOCK_WAITERS)
+        {
+            rwlock_wake_all(lock);
+        }
+    }
 }
 
 void rwlock_release_write(k4a_rwlock_t *lock)
 {
-    pthread_rwlock_unlock((pthread_rwlock_t *)lock);
+    uint32_t state = __atomic_fetch_and(&lock->state, ~(RWLOCK_WRITER | RWLOCK_WAITERS), __ATOMIC_RELEASE);
+    assert(state & RWLOCK_WRITER);
+    if (state & RWLOCK_WAITERS)
+    {
+        rwlock_wake_all(lock);
+    }
 }
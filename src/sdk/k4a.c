@@ -6,7 +6,9 @@
 
 // Dependent libraries
 #include <k4ainternal/common.h>
+#include <k4ainternal/broker.h>
 #include <k4ainternal/capture.h>
+#include <k4ainternal/deloader.h>
 #include <k4ainternal/depth.h>
 #include <k4ainternal/imu.h>
 #include <k4ainternal/color.h>
@@ -14,9 +16,17 @@
 #include <k4ainternal/depth_mcu.h>
 #include <k4ainternal/calibration.h>
 #include <k4ainternal/capturesync.h>
+#include <k4ainternal/clockmodel.h>
+#include <k4ainternal/devicegroup.h>
+#include <k4ainternal/latency.h>
+#include <k4ainternal/metrics.h>
+#include <k4ainternal/threadpool.h>
 #include <k4ainternal/transformation.h>
+#include <k4ainternal/tensor.h>
+#include <k4ainternal/undistort.h>
 #include <k4ainternal/logging.h>
 #include <azure_c_shared_utility/tickcounter.h>
+#include <azure_c_shared_utility/threadapi.h>
 
 // System dependencies
 #include <stdlib.h>
@@ -40,6 +50,7 @@ typedef struct _k4a_context_t
     colormcu_t colormcu;
 
     capturesync_t capturesync;
+    clockmodel_t clockmodel; // Fit from the arrival of depth and color captures
 
     imu_t imu;
     color_t color;
@@ -48,10 +59,59 @@ typedef struct _k4a_context_t
     bool depth_started;
     bool color_started;
     bool imu_started;
+
+    k4a_device_configuration_t config; // Configuration of the running cameras
+
+    // Periodic delivery of the metrics, set with k4a_device_set_metrics_callback()
+    k4a_device_t handle;
+    metrics_sink_t metrics_sink;
+    k4a_metrics_cb_t *metrics_cb;
+    void *metrics_cb_context;
+    k4a_metric_t *metrics; // Buffer the metrics are collected into for metrics_cb, only used by the sink thread
+    size_t metrics_capacity;
 } k4a_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_device_t, k4a_context_t);
 
+typedef struct _k4a_device_group_member_t
+{
+    devicegroup_t devicegroup;
+    uint32_t index; // Index of the device in the group
+} k4a_device_group_member_t;
+
+typedef struct _k4a_device_group_context_t
+{
+    uint32_t device_count;
+    k4a_device_t devices[DEVICEGROUP_MAX_DEVICES];
+    k4a_device_group_member_t members[DEVICEGROUP_MAX_DEVICES]; // Capture callback context of each device
+    devicegroup_t devicegroup;
+    bool started;
+} k4a_device_group_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_device_group_t, k4a_device_group_context_t);
+
+typedef struct _k4a_broker_context_t
+{
+    broker_t broker;
+} k4a_broker_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_broker_t, k4a_broker_context_t);
+
+typedef struct _k4a_broker_client_context_t
+{
+    broker_client_t client;
+} k4a_broker_client_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_broker_client_t, k4a_broker_client_context_t);
+
+typedef struct _k4a_device_open_job_t
+{
+    uint32_t index;
+    k4a_device_t handle;
+    k4a_result_t result;
+    THREAD_HANDLE thread;
+} k4a_device_open_job_t;
+
 #define DEPTH_CAPTURE (false)
 #define COLOR_CAPTURE (true)
 #define TRANSFORM_ENABLE_GPU_OPTIMIZATION (true)
@@ -75,6 +135,11 @@ uint32_t k4a_device_get_installed_count(void)
     return device_count;
 }
 
+k4a_result_t k4a_set_device_hotplug_callback(k4a_device_hotplug_cb_t *hotplug_cb, void *hotplug_cb_context)
+{
+    return usb_cmd_set_hotplug_callback(hotplug_cb, hotplug_cb_context);
+}
+
 k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *message_cb,
                                            void *message_cb_context,
                                            k4a_log_level_t min_level)
@@ -82,19 +147,109 @@ k4a_result_t k4a_set_debug_message_handler(k4a_logging_message_cb_t *message_cb,
     return logger_register_message_callback(message_cb, message_cb_context, min_level);
 }
 
+k4a_result_t k4a_trace_dump(const char *path, uint64_t duration_usec)
+{
+    return logger_trace_dump(path, duration_usec);
+}
+
 k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memory_destroy_cb_t free)
 {
     return allocator_set_allocator(allocate, free);
 }
 
+k4a_result_t k4a_set_allocator_ex(k4a_memory_allocate_ex_cb_t allocate,
+                                  k4a_memory_destroy_cb_t free,
+                                  void *user_context)
+{
+    return allocator_set_allocator_ex(allocate, free, user_context);
+}
+
+k4a_result_t k4a_set_allocator_pooling(uint32_t max_pooled_buffers)
+{
+    return allocator_set_pooling(max_pooled_buffers);
+}
+
+k4a_result_t k4a_set_allocator_huge_pages(bool enable)
+{
+    return allocator_set_huge_pages(enable);
+}
+
+void k4a_set_image_row_padding(bool enable)
+{
+    image_set_row_padding(enable);
+}
+
+k4a_result_t k4a_get_allocator_stats(k4a_allocator_stats_t *stats)
+{
+    return allocator_get_stats(stats);
+}
+
+void k4a_set_memory_budget(size_t budget_bytes)
+{
+    allocator_set_memory_budget(budget_bytes);
+}
+
+size_t k4a_get_memory_budget(void)
+{
+    return allocator_get_memory_budget();
+}
+
+k4a_result_t k4a_get_latency_stats(k4a_latency_stage_t stage, k4a_latency_stats_t *stats)
+{
+    return latency_get_stats(stage, stats);
+}
+
+void k4a_reset_latency_stats(void)
+{
+    latency_reset_stats();
+}
+
+k4a_result_t k4a_set_thread_affinity(k4a_thread_role_t role, uint64_t cpu_mask)
+{
+    return threadpool_set_affinity(role, cpu_mask);
+}
+
+k4a_result_t k4a_set_thread_priority(k4a_thread_role_t role, k4a_thread_priority_t priority)
+{
+    return threadpool_set_priority(role, priority);
+}
+
+k4a_result_t k4a_set_worker_thread_count(uint32_t worker_count)
+{
+    return threadpool_set_worker_count(worker_count);
+}
+
+void k4a_preload_depth_engine(void)
+{
+    deloader_preload();
+}
+
 depth_cb_streaming_capture_t depth_capture_ready;
 color_cb_streaming_capture_t color_capture_ready;
 
+// Adds the arrival of an image to the clock model of the device
+static void add_clock_observation(k4a_context_t *device, k4a_image_t image)
+{
+    if (image != NULL)
+    {
+        clockmodel_add_observation(device->clockmodel,
+                                   image_get_device_timestamp_usec(image),
+                                   image_get_system_timestamp_nsec(image));
+        image_dec_ref(image);
+    }
+}
+
 void depth_capture_ready(k4a_result_t result, k4a_capture_t capture_handle, void *callback_context)
 {
     k4a_device_t device_handle = (k4a_device_t)callback_context;
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    if (K4A_SUCCEEDED(result) && capture_handle != NULL)
+    {
+        // The depth and IR images share the arrival time of the raw frame
+        k4a_image_t image = capture_get_ir_image(capture_handle);
+        add_clock_observation(device, image != NULL ? image : capture_get_depth_image(capture_handle));
+    }
     capturesync_add_capture(device->capturesync, result, capture_handle, DEPTH_CAPTURE);
 }
 
@@ -103,6 +258,10 @@ void color_capture_ready(k4a_result_t result, k4a_capture_t capture_handle, void
     k4a_device_t device_handle = (k4a_device_t)callback_context;
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    if (K4A_SUCCEEDED(result) && capture_handle != NULL)
+    {
+        add_clock_observation(device, capture_get_color_image(capture_handle));
+    }
     capturesync_add_capture(device->capturesync, result, capture_handle, COLOR_CAPTURE);
 }
 
@@ -118,6 +277,9 @@ k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle)
 
     allocator_initialize();
 
+    // Loads the depth engine plugin while the device opens, instead of in the first k4a_device_start_cameras()
+    deloader_preload_if_requested();
+
     device = k4a_device_t_create(&handle);
     result = K4A_RESULT_FROM_BOOL(device != NULL);
 
@@ -155,7 +317,16 @@ k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle)
     // Create calibration module - ensure we can read calibration before proceeding
     if (K4A_SUCCEEDED(result))
     {
-        result = TRACE_CALL(calibration_create(device->depthmcu, &device->calibration));
+        // The firmware version is part of the key of the calibration cache, the cache is not used without it
+        depthmcu_firmware_versions_t version;
+        const depthmcu_firmware_versions_t *cache_version = NULL;
+        if (K4A_SUCCEEDED(depthmcu_get_version(device->depthmcu, &version)))
+        {
+            cache_version = &version;
+        }
+
+        result = TRACE_CALL(
+            calibration_create_cached(device->depthmcu, serial_number, cache_version, &device->calibration));
     }
 
     if (K4A_SUCCEEDED(result))
@@ -163,6 +334,11 @@ k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle)
         result = TRACE_CALL(capturesync_create(&device->capturesync));
     }
 
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(clockmodel_create(&device->clockmodel));
+    }
+
     // Open Depth Module
     if (K4A_SUCCEEDED(result))
     {
@@ -196,11 +372,90 @@ k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle)
     return result;
 }
 
+static int k4a_device_open_thread(void *param)
+{
+    k4a_device_open_job_t *job = (k4a_device_open_job_t *)param;
+    job->result = k4a_device_open(job->index, &job->handle);
+    return 0;
+}
+
+k4a_result_t k4a_device_open_all(uint32_t device_count, k4a_device_t *device_handles)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_handles == NULL);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_device_open_job_t *jobs = NULL;
+
+    memset(device_handles, 0, device_count * sizeof(k4a_device_t));
+
+    result = K4A_RESULT_FROM_BOOL((jobs = (k4a_device_open_job_t *)calloc(device_count, sizeof(*jobs))) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        for (uint32_t i = 0; i < device_count; i++)
+        {
+            jobs[i].index = i;
+            jobs[i].result = K4A_RESULT_FAILED;
+            if (ThreadAPI_Create(&jobs[i].thread, k4a_device_open_thread, &jobs[i]) != THREADAPI_OK)
+            {
+                // Open this one on the calling thread instead
+                LOG_WARNING("Failed to create a thread to open device %u, opening it synchronously", i);
+                jobs[i].thread = NULL;
+                (void)k4a_device_open_thread(&jobs[i]);
+            }
+        }
+
+        for (uint32_t i = 0; i < device_count; i++)
+        {
+            if (jobs[i].thread)
+            {
+                int thread_result;
+                (void)ThreadAPI_Join(jobs[i].thread, &thread_result);
+                jobs[i].thread = NULL;
+            }
+
+            if (K4A_FAILED(jobs[i].result))
+            {
+                LOG_ERROR("Failed to open device %u", i);
+                result = K4A_RESULT_FAILED;
+            }
+        }
+
+        for (uint32_t i = 0; i < device_count; i++)
+        {
+            if (K4A_SUCCEEDED(result))
+            {
+                device_handles[i] = jobs[i].handle;
+            }
+            else if (jobs[i].handle)
+            {
+                k4a_device_close(jobs[i].handle);
+            }
+        }
+
+        free(jobs);
+    }
+
+    return result;
+}
+
 void k4a_device_close(k4a_device_t device_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
 
+    // The metrics callback reads from every module
+    if (device->metrics_sink)
+    {
+        metrics_sink_destroy(device->metrics_sink);
+        device->metrics_sink = NULL;
+    }
+    if (device->metrics)
+    {
+        free(device->metrics);
+        device->metrics = NULL;
+    }
+
     if (device->capturesync)
     {
         // Stop capturesync first so that imu, depth, and color can destroy cleanly
@@ -231,6 +486,12 @@ void k4a_device_close(k4a_device_t device_handle)
         device->capturesync = NULL;
     }
 
+    if (device->clockmodel)
+    {
+        clockmodel_destroy(device->clockmodel);
+        device->clockmodel = NULL;
+    }
+
     // calibration rely's on depthmcu, so it needs to be destroyed first.
     if (device->calibration)
     {
@@ -269,111 +530,629 @@ k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
     return TRACE_WAIT_CALL(capturesync_get_capture(device->capturesync, capture_handle, timeout_in_ms));
 }
 
-k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
-                                            k4a_imu_sample_t *imu_sample,
-                                            int32_t timeout_in_ms)
+k4a_result_t k4a_device_set_capture_callback(k4a_device_t device_handle,
+                                             k4a_capture_cb_t *capture_cb,
+                                             void *capture_cb_context)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, device_handle);
-    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, imu_sample == NULL);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
-    return TRACE_WAIT_CALL(imu_get_sample(device->imu, imu_sample, timeout_in_ms));
+    return TRACE_CALL(capturesync_set_capture_callback(device->capturesync, capture_cb, capture_cb_context));
 }
 
-k4a_result_t k4a_device_start_imu(k4a_device_t device_handle)
+k4a_result_t k4a_device_set_depth_capture_callback(k4a_device_t device_handle,
+                                                   k4a_capture_cb_t *depth_capture_cb,
+                                                   void *depth_capture_cb_context)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_CALL(
+        capturesync_set_depth_capture_callback(device->capturesync, depth_capture_cb, depth_capture_cb_context));
+}
 
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device->imu_started == true);
-
-    if (device->depth_started == false && device->color_started == false)
-    {
-        // Color camera resets the IMU timestamp so we avoid letting the IMU run without the camera already running.
-        LOG_ERROR("k4a_device_start_imu called while the color/depth camera is not running is not supported", 0);
-        result = K4A_RESULT_FAILED;
-    }
+// Attaches the IMU samples of a capture's exposure, called by capturesync before the capture is published
+static void k4a_capture_imu_samples_cb(k4a_capture_t capture_handle,
+                                       uint64_t start_usec,
+                                       uint64_t end_usec,
+                                       void *context)
+{
+    k4a_context_t *device = (k4a_context_t *)context;
+    k4a_imu_sample_t *imu_samples = NULL;
+    size_t sample_count = 0;
 
+    k4a_result_t result = TRACE_CALL(
+        imu_get_history_samples(device->imu, start_usec, end_usec, &imu_samples, &sample_count));
     if (K4A_SUCCEEDED(result))
     {
-        LOG_TRACE("k4a_device_start_imu starting", 0);
-        result = TRACE_CALL(imu_start(device->imu, color_get_sensor_start_time_tick(device->color)));
+        capture_set_imu_samples(capture_handle, imu_samples, sample_count);
     }
+}
 
-    if (K4A_SUCCEEDED(result))
+k4a_result_t k4a_device_set_capture_imu_samples(k4a_device_t device_handle, bool enabled)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (enabled)
     {
-        device->imu_started = true;
+        result = TRACE_CALL(imu_set_history_enabled(device->imu, true));
+        if (K4A_SUCCEEDED(result))
+        {
+            result = TRACE_CALL(
+                capturesync_set_imu_samples_callback(device->capturesync, k4a_capture_imu_samples_cb, device));
+        }
     }
 
-    if (K4A_FAILED(result) && device->imu_started == true)
+    // The callback is removed before the history it reads from
+    if (!enabled || K4A_FAILED(result))
     {
-        k4a_device_stop_imu(device_handle);
+        capturesync_set_imu_samples_callback(device->capturesync, NULL, NULL);
+        imu_set_history_enabled(device->imu, false);
     }
-    LOG_INFO("k4a_device_start_imu started", 0);
-
     return result;
 }
 
-void k4a_device_stop_imu(k4a_device_t device_handle)
+k4a_result_t k4a_device_get_capture_stats(k4a_device_t device_handle, k4a_capture_stats_t *stats)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
     k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_CALL(capturesync_get_stats(device->capturesync, stats));
+}
 
-    LOG_INFO("k4a_device_stop_imu stopping", 0);
-    if (device->imu)
+k4a_result_t k4a_device_get_usb_stream_stats(k4a_device_t device_handle,
+                                             k4a_usb_stream_t stream,
+                                             k4a_usb_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stream != K4A_USB_STREAM_DEPTH && stream != K4A_USB_STREAM_IMU);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    if (stream == K4A_USB_STREAM_DEPTH)
     {
-        imu_stop(device->imu);
-        device->imu_started = false;
+        return TRACE_CALL(depthmcu_depth_get_usb_stream_stats(device->depthmcu, stats));
     }
-    LOG_TRACE("k4a_device_stop_imu stopped", 0);
+    return TRACE_CALL(colormcu_imu_get_usb_stream_stats(device->colormcu, stats));
 }
 
-k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle)
+// Collects the metrics of a device and the process wide metrics
+static void device_collect_metrics(k4a_context_t *device, metrics_list_t *list)
 {
-    return capture_create(capture_handle);
+    k4a_capture_stats_t capture_stats;
+    if (K4A_SUCCEEDED(capturesync_get_stats(device->capturesync, &capture_stats)))
+    {
+        metrics_add_capture_stats(list, &capture_stats);
+    }
+
+    k4a_usb_stream_stats_t usb_stats;
+    if (K4A_SUCCEEDED(depthmcu_depth_get_usb_stream_stats(device->depthmcu, &usb_stats)))
+    {
+        metrics_add_usb_stream_stats(list, "depth", &usb_stats);
+    }
+    if (K4A_SUCCEEDED(colormcu_imu_get_usb_stream_stats(device->colormcu, &usb_stats)))
+    {
+        metrics_add_usb_stream_stats(list, "imu", &usb_stats);
+    }
+
+    dewrapper_stats_t depth_engine_stats;
+    if (K4A_SUCCEEDED(depth_get_depth_engine_stats(device->depth, &depth_engine_stats)))
+    {
+        metrics_add_depth_engine_stats(list, &depth_engine_stats);
+    }
+
+    k4a_allocator_stats_t allocator_stats;
+    if (K4A_SUCCEEDED(allocator_get_stats(&allocator_stats)))
+    {
+        metrics_add_allocator_stats(list, &allocator_stats);
+    }
+
+    metrics_add_latency_stats(list);
 }
 
-void k4a_capture_release(k4a_capture_t capture_handle)
+k4a_buffer_result_t k4a_device_get_metrics(k4a_device_t device_handle, k4a_metric_t *metrics, size_t *metric_count)
 {
-    capture_dec_ref(capture_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, metric_count == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    metrics_list_t list = { metrics, metrics == NULL ? 0 : *metric_count, 0 };
+    device_collect_metrics(device, &list);
+
+    k4a_buffer_result_t result = list.count > list.capacity ? K4A_BUFFER_RESULT_TOO_SMALL : K4A_BUFFER_RESULT_SUCCEEDED;
+    *metric_count = list.count;
+    return result;
 }
 
-void k4a_capture_reference(k4a_capture_t capture_handle)
+static void device_deliver_metrics(void *context)
 {
-    capture_inc_ref(capture_handle);
+    k4a_context_t *device = (k4a_context_t *)context;
+
+    metrics_list_t list = { device->metrics, device->metrics_capacity, 0 };
+    device_collect_metrics(device, &list);
+    if (list.count > list.capacity)
+    {
+        // Metrics were added since the buffer was sized, the next delivery has room for them
+        k4a_metric_t *metrics = (k4a_metric_t *)malloc(list.count * sizeof(k4a_metric_t));
+        if (metrics != NULL)
+        {
+            free(device->metrics);
+            device->metrics = metrics;
+            device->metrics_capacity = list.count;
+        }
+        list.count = list.capacity;
+    }
+
+    device->metrics_cb(device->handle, device->metrics, list.count, device->metrics_cb_context);
 }
 
-float k4a_capture_get_temperature_c(k4a_capture_t capture_handle)
+k4a_result_t k4a_device_set_metrics_callback(k4a_device_t device_handle,
+                                             k4a_metrics_cb_t *metrics_cb,
+                                             void *metrics_cb_context,
+                                             uint32_t period_ms)
 {
-    return capture_get_temperature_c(capture_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, metrics_cb != NULL && period_ms == 0);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    if (device->metrics_sink)
+    {
+        metrics_sink_destroy(device->metrics_sink);
+        device->metrics_sink = NULL;
+    }
+
+    device->handle = device_handle;
+    device->metrics_cb = metrics_cb;
+    device->metrics_cb_context = metrics_cb_context;
+    if (metrics_cb == NULL)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (device->metrics == NULL)
+    {
+        // Sized once, the sink thread grows it if more metrics show up
+        metrics_list_t list = { NULL, 0, 0 };
+        device_collect_metrics(device, &list);
+        device->metrics = (k4a_metric_t *)malloc(list.count * sizeof(k4a_metric_t));
+        device->metrics_capacity = device->metrics == NULL ? 0 : list.count;
+        result = K4A_RESULT_FROM_BOOL(device->metrics != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(metrics_sink_create(period_ms, device_deliver_metrics, device, &device->metrics_sink));
+    }
+
+    if (K4A_FAILED(result))
+    {
+        device->metrics_cb = NULL;
+        device->metrics_cb_context = NULL;
+    }
+    return result;
 }
 
-k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
+k4a_result_t k4a_device_set_queue_policy(k4a_device_t device_handle,
+                                         k4a_queue_stream_t stream,
+                                         uint32_t queue_depth,
+                                         k4a_queue_policy_t policy)
 {
-    return capture_get_color_image(capture_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stream != K4A_QUEUE_STREAM_CAPTURE && stream != K4A_QUEUE_STREAM_IMU);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    if (stream == K4A_QUEUE_STREAM_IMU)
+    {
+        return TRACE_CALL(imu_set_queue_policy(device->imu, queue_depth, policy));
+    }
+    return TRACE_CALL(capturesync_set_queue_policy(device->capturesync, queue_depth, policy));
 }
 
-k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle)
+k4a_result_t k4a_device_set_depth_engine_gpu(k4a_device_t device_handle, int32_t gpu_index)
 {
-    return capture_get_depth_image(capture_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, gpu_index < K4A_DEPTH_ENGINE_GPU_AUTO);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_engine_gpu(device->depth, gpu_index));
 }
 
-k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle)
+k4a_result_t k4a_device_set_depth_engine_shared(k4a_device_t device_handle, bool shared)
 {
-    return capture_get_ir_image(capture_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_engine_shared(device->depth, shared));
 }
 
-void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+k4a_result_t k4a_device_set_depth_engine_keep_alive(k4a_device_t device_handle, bool keep_alive)
 {
-    capture_set_color_image(capture_handle, image_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_engine_keep_alive(device->depth, keep_alive));
 }
 
-void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+k4a_result_t k4a_device_set_depth_filter(k4a_device_t device_handle, const k4a_depth_filter_configuration_t *config)
 {
-    capture_set_depth_image(capture_handle, image_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_filter(device->depth, config));
 }
 
-void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+k4a_result_t k4a_device_set_depth_gpu_export(k4a_device_t device_handle,
+                                             const k4a_depth_gpu_export_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_gpu_export(device->depth, config));
+}
+
+k4a_result_t k4a_device_set_depth_only(k4a_device_t device_handle, bool depth_only)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_only(device->depth, depth_only));
+}
+
+k4a_result_t k4a_device_set_ir8_output(k4a_device_t device_handle, const k4a_ir8_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_ir8_output(device->depth, config));
+}
+
+k4a_result_t k4a_device_set_depth_frame_decimation(k4a_device_t device_handle, uint32_t decimation)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_frame_decimation(device->depth, decimation));
+}
+
+k4a_result_t k4a_device_set_depth_engine_overload_policy(k4a_device_t device_handle,
+                                                         const k4a_depth_engine_overload_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_set_depth_engine_overload_policy(device->depth, config));
+}
+
+k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
+                                            k4a_imu_sample_t *imu_sample,
+                                            int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, imu_sample == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_WAIT_CALL(imu_get_sample(device->imu, imu_sample, timeout_in_ms));
+}
+
+k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                             k4a_imu_sample_t *imu_samples,
+                                             size_t max_sample_count,
+                                             size_t *sample_count,
+                                             int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, max_sample_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, sample_count == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return TRACE_WAIT_CALL(imu_get_samples(device->imu, imu_samples, max_sample_count, sample_count, timeout_in_ms));
+}
+
+// Sets the ready flag of each source, returns true if any of them is ready
+static bool k4a_wait_sources_ready(k4a_wait_source_t *sources, size_t source_count)
+{
+    bool any_ready = false;
+    for (size_t i = 0; i < source_count; i++)
+    {
+        k4a_context_t *device = k4a_device_t_get_context(sources[i].device);
+        if (sources[i].stream == K4A_QUEUE_STREAM_IMU)
+        {
+            sources[i].ready = imu_is_ready(device->imu);
+        }
+        else
+        {
+            sources[i].ready = capturesync_is_ready(device->capturesync);
+        }
+        any_ready = any_ready || sources[i].ready;
+    }
+    return any_ready;
+}
+
+static k4a_result_t k4a_wait_source_add_waiter(const k4a_wait_source_t *source, queue_waiter_t waiter)
+{
+    k4a_context_t *device = k4a_device_t_get_context(source->device);
+    if (source->stream == K4A_QUEUE_STREAM_IMU)
+    {
+        return TRACE_CALL(imu_add_waiter(device->imu, waiter));
+    }
+    return TRACE_CALL(capturesync_add_waiter(device->capturesync, waiter));
+}
+
+static void k4a_wait_source_remove_waiter(const k4a_wait_source_t *source, queue_waiter_t waiter)
+{
+    k4a_context_t *device = k4a_device_t_get_context(source->device);
+    if (source->stream == K4A_QUEUE_STREAM_IMU)
+    {
+        imu_remove_waiter(device->imu, waiter);
+    }
+    else
+    {
+        capturesync_remove_waiter(device->capturesync, waiter);
+    }
+}
+
+k4a_wait_result_t k4a_device_wait_any(k4a_wait_source_t *sources, size_t source_count, int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, sources == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, source_count == 0);
+    for (size_t i = 0; i < source_count; i++)
+    {
+        RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, sources[i].device);
+        RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED,
+                            sources[i].stream != K4A_QUEUE_STREAM_CAPTURE && sources[i].stream != K4A_QUEUE_STREAM_IMU);
+    }
+
+    // The waiter is only needed when nothing is ready yet
+    if (k4a_wait_sources_ready(sources, source_count))
+    {
+        return K4A_WAIT_RESULT_SUCCEEDED;
+    }
+    if (timeout_in_ms == 0)
+    {
+        return K4A_WAIT_RESULT_TIMEOUT;
+    }
+
+    queue_waiter_t waiter = NULL;
+    size_t attached_count = 0;
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_FAILED;
+    uint64_t deadline_nsec = latency_get_time_nsec() + (uint64_t)(timeout_in_ms < 0 ? 0 : timeout_in_ms) * 1000000;
+
+    k4a_result_t result = TRACE_CALL(queue_waiter_create(&waiter));
+    while (K4A_SUCCEEDED(result) && attached_count < source_count)
+    {
+        result = k4a_wait_source_add_waiter(&sources[attached_count], waiter);
+        if (K4A_SUCCEEDED(result))
+        {
+            attached_count++;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Attaching before checking again guarantees that data arriving in between notifies the waiter. A notification
+        // can be left over from data that was already seen, so the streams are checked again after each one.
+        wresult = K4A_WAIT_RESULT_SUCCEEDED;
+        while (wresult == K4A_WAIT_RESULT_SUCCEEDED && !k4a_wait_sources_ready(sources, source_count))
+        {
+            int32_t wait_in_ms = timeout_in_ms;
+            if (timeout_in_ms > 0)
+            {
+                uint64_t now_nsec = latency_get_time_nsec();
+                wait_in_ms = now_nsec < deadline_nsec ? (int32_t)((deadline_nsec - now_nsec + 999999) / 1000000) : 0;
+            }
+            wresult = queue_waiter_wait(waiter, wait_in_ms);
+        }
+
+        if (wresult == K4A_WAIT_RESULT_TIMEOUT && k4a_wait_sources_ready(sources, source_count))
+        {
+            wresult = K4A_WAIT_RESULT_SUCCEEDED;
+        }
+    }
+
+    for (size_t i = 0; i < attached_count; i++)
+    {
+        k4a_wait_source_remove_waiter(&sources[i], waiter);
+    }
+
+    if (waiter)
+    {
+        queue_waiter_destroy(waiter);
+    }
+
+    return wresult;
+}
+
+k4a_result_t k4a_device_get_system_timestamp_nsec(k4a_device_t device_handle,
+                                                  uint64_t device_timestamp_usec,
+                                                  uint64_t *system_timestamp_nsec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, system_timestamp_nsec == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    return clockmodel_get_system_timestamp_nsec(device->clockmodel, device_timestamp_usec, system_timestamp_nsec);
+}
+
+k4a_result_t k4a_set_shared_timebase_callback(k4a_shared_timebase_cb_t *timebase_cb, void *timebase_cb_context)
+{
+    return TRACE_CALL(clockmodel_set_shared_timebase_callback(timebase_cb, timebase_cb_context));
+}
+
+k4a_result_t k4a_set_shared_timebase_clock(const char *phc_device_path)
+{
+    return TRACE_CALL(clockmodel_set_shared_timebase_clock(phc_device_path));
+}
+
+k4a_result_t k4a_device_get_shared_timestamp_nsec(k4a_device_t device_handle,
+                                                  uint64_t device_timestamp_usec,
+                                                  uint64_t *shared_timestamp_nsec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, shared_timestamp_nsec == NULL);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    uint64_t system_timestamp_nsec = 0;
+
+    k4a_result_t result =
+        clockmodel_get_system_timestamp_nsec(device->clockmodel, device_timestamp_usec, &system_timestamp_nsec);
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(clockmodel_system_to_shared_nsec(system_timestamp_nsec, shared_timestamp_nsec));
+    }
+    return result;
+}
+
+// Maps the device timestamp of an image of a capture, and releases the image. Leaves 0 when there is no image.
+static k4a_result_t get_image_shared_timestamp(k4a_device_t device_handle, k4a_image_t image, uint64_t *timestamp_nsec)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    *timestamp_nsec = 0;
+    if (image != NULL)
+    {
+        result = k4a_device_get_shared_timestamp_nsec(device_handle,
+                                                      image_get_device_timestamp_usec(image),
+                                                      timestamp_nsec);
+        image_dec_ref(image);
+    }
+    return result;
+}
+
+k4a_result_t k4a_device_get_capture_shared_timestamps(k4a_device_t device_handle,
+                                                      k4a_capture_t capture_handle,
+                                                      k4a_capture_shared_timestamps_t *timestamps)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, timestamps == NULL);
+
+    k4a_result_t result = get_image_shared_timestamp(device_handle,
+                                                     capture_get_color_image(capture_handle),
+                                                     &timestamps->color_timestamp_nsec);
+    if (K4A_SUCCEEDED(result))
+    {
+        result = get_image_shared_timestamp(device_handle,
+                                            capture_get_depth_image(capture_handle),
+                                            &timestamps->depth_timestamp_nsec);
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        result = get_image_shared_timestamp(device_handle,
+                                            capture_get_ir_image(capture_handle),
+                                            &timestamps->ir_timestamp_nsec);
+    }
+    return result;
+}
+
+k4a_result_t k4a_device_start_imu(k4a_device_t device_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device->imu_started == true);
+
+    if (device->depth_started == false && device->color_started == false)
+    {
+        // Color camera resets the IMU timestamp so we avoid letting the IMU run without the camera already running.
+        LOG_ERROR("k4a_device_start_imu called while the color/depth camera is not running is not supported", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        LOG_TRACE("k4a_device_start_imu starting", 0);
+        result = TRACE_CALL(imu_start(device->imu, color_get_sensor_start_time_tick(device->color)));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        device->imu_started = true;
+    }
+
+    if (K4A_FAILED(result) && device->imu_started == true)
+    {
+        k4a_device_stop_imu(device_handle);
+    }
+    LOG_INFO("k4a_device_start_imu started", 0);
+
+    return result;
+}
+
+void k4a_device_stop_imu(k4a_device_t device_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    LOG_INFO("k4a_device_stop_imu stopping", 0);
+    if (device->imu)
+    {
+        imu_stop(device->imu);
+        device->imu_started = false;
+    }
+    LOG_TRACE("k4a_device_stop_imu stopped", 0);
+}
+
+k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle)
+{
+    return capture_create(capture_handle);
+}
+
+void k4a_capture_release(k4a_capture_t capture_handle)
+{
+    capture_dec_ref(capture_handle);
+}
+
+void k4a_capture_recycle(k4a_capture_t capture_handle)
+{
+    capture_recycle(capture_handle);
+}
+
+void k4a_capture_reference(k4a_capture_t capture_handle)
+{
+    capture_inc_ref(capture_handle);
+}
+
+float k4a_capture_get_temperature_c(k4a_capture_t capture_handle)
+{
+    return capture_get_temperature_c(capture_handle);
+}
+
+uint64_t k4a_capture_get_latency_timestamp_nsec(k4a_capture_t capture_handle, k4a_latency_stage_t stage)
+{
+    return capture_get_latency_timestamp_nsec(capture_handle, stage);
+}
+
+k4a_buffer_result_t k4a_capture_get_imu_samples(k4a_capture_t capture_handle,
+                                                k4a_imu_sample_t *imu_samples,
+                                                size_t *imu_sample_count)
+{
+    return capture_get_imu_samples(capture_handle, imu_samples, imu_sample_count);
+}
+
+k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
+{
+    return capture_get_color_image(capture_handle);
+}
+
+k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle)
+{
+    return capture_get_depth_image(capture_handle);
+}
+
+k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle)
+{
+    return capture_get_ir_image(capture_handle);
+}
+
+void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+{
+    capture_set_color_image(capture_handle, image_handle);
+}
+
+void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
+{
+    capture_set_depth_image(capture_handle, image_handle);
+}
+
+void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
 {
     capture_set_ir_image(capture_handle, image_handle);
 }
@@ -413,6 +1192,16 @@ k4a_result_t k4a_image_create_from_buffer(k4a_image_format_t format,
                                     image_handle);
 }
 
+k4a_result_t k4a_image_create_view(k4a_image_t parent_handle,
+                                   int x,
+                                   int y,
+                                   int width_pixels,
+                                   int height_pixels,
+                                   k4a_image_t *image_handle)
+{
+    return TRACE_CALL(image_create_view(parent_handle, x, y, width_pixels, height_pixels, image_handle));
+}
+
 uint8_t *k4a_image_get_buffer(k4a_image_t image_handle)
 {
     return image_get_buffer(image_handle);
@@ -458,6 +1247,21 @@ uint64_t k4a_image_get_system_timestamp_nsec(k4a_image_t image_handle)
     return image_get_system_timestamp_nsec(image_handle);
 }
 
+k4a_result_t k4a_image_get_gpu_resource(k4a_image_t image_handle, k4a_gpu_resource_t *resource)
+{
+    return image_get_gpu_resource(image_handle, resource);
+}
+
+k4a_result_t k4a_image_get_depth_statistics(k4a_image_t image_handle, k4a_depth_statistics_t *statistics)
+{
+    return image_get_depth_statistics(image_handle, statistics);
+}
+
+uint64_t k4a_image_get_compute_time_usec(k4a_image_t image_handle)
+{
+    return image_get_compute_time_usec(image_handle);
+}
+
 uint64_t k4a_image_get_exposure_usec(k4a_image_t image_handle)
 {
     return image_get_exposure_usec(image_handle);
@@ -840,6 +1644,20 @@ static k4a_result_t validate_configuration(k4a_context_t *device, const k4a_devi
     return result;
 }
 
+k4a_result_t k4a_device_set_color_scale(k4a_device_t device_handle, k4a_color_scale_t scale)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    if (device->color_started == true)
+    {
+        LOG_ERROR("k4a_device_set_color_scale called while the color camera is running, stop the cameras", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    return TRACE_CALL(color_set_scale(device->color, scale));
+}
+
 k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_device_configuration_t *config)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
@@ -880,11 +1698,14 @@ k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_devi
 
     if (K4A_SUCCEEDED(result))
     {
+        device->config = *config;
         result = TRACE_CALL(colormcu_set_multi_device_mode(device->colormcu, config));
     }
 
     if (K4A_SUCCEEDED(result))
     {
+        // Starting the color camera restarts the device clock
+        clockmodel_reset(device->clockmodel);
         result = TRACE_CALL(capturesync_start(device->capturesync, config));
     }
 
@@ -923,6 +1744,64 @@ k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_devi
     return result;
 }
 
+k4a_result_t k4a_device_reconfigure_depth(k4a_device_t device_handle, k4a_depth_mode_t depth_mode, k4a_fps_t camera_fps)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    if (!device->depth_started || device->config.depth_mode == K4A_DEPTH_MODE_OFF)
+    {
+        LOG_ERROR("k4a_device_reconfigure_depth called while the depth camera isn't running", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result) && depth_mode == K4A_DEPTH_MODE_OFF)
+    {
+        LOG_ERROR("k4a_device_reconfigure_depth can't turn the depth camera off, use k4a_device_stop_cameras", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    if (K4A_SUCCEEDED(result) && device->color_started &&
+        device->config.color_resolution != K4A_COLOR_RESOLUTION_OFF && camera_fps != device->config.camera_fps)
+    {
+        // The color camera and the synchronization of the captures run at camera_fps
+        LOG_ERROR("k4a_device_reconfigure_depth can't change the frame rate while the color camera is running", 0);
+        result = K4A_RESULT_FAILED;
+    }
+
+    k4a_device_configuration_t config = device->config;
+    config.depth_mode = depth_mode;
+    config.camera_fps = camera_fps;
+
+    if (K4A_SUCCEEDED(result))
+    {
+        LOG_INFO("Reconfiguring the depth camera to depth_mode:%d camera_fps:%d", depth_mode, camera_fps);
+        result = TRACE_CALL(validate_configuration(device, &config));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Capturesync is restarted so no capture pairs a depth image of the old mode, the clock model and the color
+        // camera keep running
+        capturesync_stop(device->capturesync);
+        result = TRACE_CALL(depth_reconfigure(device->depth, &config));
+
+        if (K4A_SUCCEEDED(result))
+        {
+            device->config = config;
+            result = TRACE_CALL(capturesync_start(device->capturesync, &config));
+        }
+
+        if (K4A_FAILED(result))
+        {
+            k4a_device_stop_cameras(device_handle);
+        }
+    }
+
+    return result;
+}
+
 void k4a_device_stop_cameras(k4a_device_t device_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_t, device_handle);
@@ -941,44 +1820,337 @@ void k4a_device_stop_cameras(k4a_device_t device_handle)
         depth_stop(device->depth);
         device->depth_started = false;
     }
-
-    if (device->color)
+
+    if (device->color)
+    {
+        // This call will block waiting for all outstanding allocations to be released
+        color_stop(device->color);
+        device->color_started = false;
+    }
+
+    LOG_INFO("k4a_device_stop_cameras stopped", 0);
+}
+
+k4a_buffer_result_t k4a_device_get_serialnum(k4a_device_t device_handle,
+                                             char *serial_number,
+                                             size_t *serial_number_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_BUFFER_CALL(depth_get_device_serialnum(device->depth, serial_number, serial_number_size));
+}
+
+k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_version_t *version)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(depth_get_device_version(device->depth, version));
+}
+
+k4a_result_t k4a_device_get_sync_jack(k4a_device_t device_handle,
+                                      bool *sync_in_jack_connected,
+                                      bool *sync_out_jack_connected)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    return TRACE_CALL(
+        colormcu_get_external_sync_jack_state(device->colormcu, sync_in_jack_connected, sync_out_jack_connected));
+}
+
+static void device_group_capture_ready(k4a_result_t result, k4a_capture_t capture_handle, void *callback_context)
+{
+    k4a_device_group_member_t *member = (k4a_device_group_member_t *)callback_context;
+    devicegroup_add_capture(member->devicegroup, member->index, result, capture_handle);
+}
+
+k4a_result_t k4a_device_group_create(const k4a_device_t *device_handles,
+                                     uint32_t device_count,
+                                     k4a_device_group_t *group_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_handles == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_count > DEVICEGROUP_MAX_DEVICES);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, group_handle == NULL);
+    for (uint32_t i = 0; i < device_count; i++)
+    {
+        RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handles[i]);
+    }
+
+    k4a_device_group_t handle = NULL;
+    k4a_device_group_context_t *group = k4a_device_group_t_create(&handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(group != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(devicegroup_create(device_count, &group->devicegroup));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        group->device_count = device_count;
+        for (uint32_t i = 0; i < device_count; i++)
+        {
+            group->devices[i] = device_handles[i];
+            group->members[i].devicegroup = group->devicegroup;
+            group->members[i].index = i;
+        }
+        *group_handle = handle;
+    }
+    else if (group != NULL)
+    {
+        // The caller keeps the devices, so don't go through k4a_device_group_destroy()
+        k4a_device_group_t_destroy(handle);
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_device_group_start_cameras(k4a_device_group_t group_handle, const k4a_device_configuration_t *configs)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_group_t, group_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, configs == NULL);
+    k4a_device_group_context_t *group = k4a_device_group_t_get_context(group_handle);
+
+    if (group->started)
+    {
+        LOG_ERROR("k4a_device_group_start_cameras called while the group is already started.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(devicegroup_start(group->devicegroup, configs));
+
+    for (uint32_t i = 0; K4A_SUCCEEDED(result) && i < group->device_count; i++)
+    {
+        result = TRACE_CALL(
+            k4a_device_set_capture_callback(group->devices[i], device_group_capture_ready, &group->members[i]));
+    }
+
+    // Subordinates first, they must be waiting for the sync pulse before the master starts sending it
+    bool started[DEVICEGROUP_MAX_DEVICES] = { false };
+    for (int pass = 0; pass < 2 && K4A_SUCCEEDED(result); pass++)
+    {
+        for (uint32_t i = 0; i < group->device_count && K4A_SUCCEEDED(result); i++)
+        {
+            bool subordinate = configs[i].wired_sync_mode == K4A_WIRED_SYNC_MODE_SUBORDINATE;
+            if (subordinate == (pass == 0))
+            {
+                result = TRACE_CALL(k4a_device_start_cameras(group->devices[i], &configs[i]));
+                started[i] = K4A_SUCCEEDED(result);
+            }
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        group->started = true;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            if (started[i])
+            {
+                k4a_device_stop_cameras(group->devices[i]);
+            }
+            k4a_device_set_capture_callback(group->devices[i], NULL, NULL);
+        }
+        devicegroup_stop(group->devicegroup);
+    }
+
+    return result;
+}
+
+k4a_wait_result_t k4a_device_group_get_capture(k4a_device_group_t group_handle,
+                                               k4a_capture_t *capture_handles,
+                                               uint64_t *skew_usec,
+                                               int32_t timeout_in_ms)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_group_t, group_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, capture_handles == NULL);
+    k4a_device_group_context_t *group = k4a_device_group_t_get_context(group_handle);
+    return TRACE_WAIT_CALL(devicegroup_get_capture(group->devicegroup, capture_handles, skew_usec, timeout_in_ms));
+}
+
+void k4a_device_group_stop_cameras(k4a_device_group_t group_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_group_t, group_handle);
+    k4a_device_group_context_t *group = k4a_device_group_t_get_context(group_handle);
+
+    if (group->started)
+    {
+        for (uint32_t i = 0; i < group->device_count; i++)
+        {
+            k4a_device_stop_cameras(group->devices[i]);
+
+            // Once the callback is cleared it is no longer running, so the group can release what it holds
+            k4a_device_set_capture_callback(group->devices[i], NULL, NULL);
+        }
+        devicegroup_stop(group->devicegroup);
+        group->started = false;
+    }
+}
+
+void k4a_device_group_destroy(k4a_device_group_t group_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_device_group_t, group_handle);
+    k4a_device_group_context_t *group = k4a_device_group_t_get_context(group_handle);
+
+    k4a_device_group_stop_cameras(group_handle);
+    for (uint32_t i = 0; i < group->device_count; i++)
+    {
+        k4a_device_close(group->devices[i]);
+    }
+    devicegroup_destroy(group->devicegroup);
+    k4a_device_group_t_destroy(group_handle);
+}
+
+k4a_result_t k4a_broker_create(const char *name,
+                               uint32_t buffer_count,
+                               size_t buffer_size,
+                               k4a_broker_t *broker_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, broker_handle == NULL);
+
+    k4a_broker_t handle = NULL;
+    k4a_broker_context_t *broker = k4a_broker_t_create(&handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(broker != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(broker_create(name, buffer_count, buffer_size, &broker->broker));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        *broker_handle = handle;
+    }
+    else if (handle != NULL)
+    {
+        k4a_broker_t_destroy(handle);
+    }
+    return result;
+}
+
+k4a_result_t k4a_broker_set_device(k4a_broker_t broker_handle,
+                                   k4a_device_t device_handle,
+                                   k4a_depth_mode_t depth_mode,
+                                   k4a_color_resolution_t color_resolution)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_broker_t, broker_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    k4a_broker_context_t *broker = k4a_broker_t_get_context(broker_handle);
+    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+
+    uint8_t *raw_calibration = (uint8_t *)malloc(BROKER_MAX_CALIBRATION_BYTES);
+    size_t raw_calibration_size = BROKER_MAX_CALIBRATION_BYTES;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(raw_calibration != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL(calibration_get_raw_data(device->calibration,
+                                                               raw_calibration,
+                                                               &raw_calibration_size) == K4A_BUFFER_RESULT_SUCCEEDED);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(broker_set_calibration(
+            broker->broker, raw_calibration, raw_calibration_size, depth_mode, color_resolution));
+    }
+
+    free(raw_calibration);
+    return result;
+}
+
+k4a_result_t k4a_broker_publish_capture(k4a_broker_t broker_handle, k4a_capture_t capture_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_broker_t, broker_handle);
+    k4a_broker_context_t *broker = k4a_broker_t_get_context(broker_handle);
+
+    return TRACE_CALL(broker_publish_capture(broker->broker, capture_handle));
+}
+
+void k4a_broker_destroy(k4a_broker_t broker_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_broker_t, broker_handle);
+    k4a_broker_context_t *broker = k4a_broker_t_get_context(broker_handle);
+
+    broker_destroy(broker->broker);
+    k4a_broker_t_destroy(broker_handle);
+}
+
+k4a_result_t k4a_broker_attach(const char *name, k4a_broker_client_t *client_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, client_handle == NULL);
+
+    k4a_broker_client_t handle = NULL;
+    k4a_broker_client_context_t *client = k4a_broker_client_t_create(&handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(client != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(broker_attach(name, &client->client));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        *client_handle = handle;
+    }
+    else if (handle != NULL)
     {
-        // This call will block waiting for all outstanding allocations to be released
-        color_stop(device->color);
-        device->color_started = false;
+        k4a_broker_client_t_destroy(handle);
     }
-
-    LOG_INFO("k4a_device_stop_cameras stopped", 0);
+    return result;
 }
 
-k4a_buffer_result_t k4a_device_get_serialnum(k4a_device_t device_handle,
-                                             char *serial_number,
-                                             size_t *serial_number_size)
+k4a_result_t k4a_broker_client_get_calibration(k4a_broker_client_t client_handle, k4a_calibration_t *calibration)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_device_t, device_handle);
-    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_broker_client_t, client_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    k4a_broker_client_context_t *client = k4a_broker_client_t_get_context(client_handle);
 
-    return TRACE_BUFFER_CALL(depth_get_device_serialnum(device->depth, serial_number, serial_number_size));
+    char *raw_calibration = (char *)malloc(BROKER_MAX_CALIBRATION_BYTES + 1);
+    size_t raw_calibration_size = 0;
+    k4a_depth_mode_t depth_mode;
+    k4a_color_resolution_t color_resolution;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(raw_calibration != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(broker_client_get_calibration(
+            client->client, raw_calibration, &raw_calibration_size, &depth_mode, &color_resolution));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(k4a_calibration_get_from_raw(
+            raw_calibration, raw_calibration_size, depth_mode, color_resolution, calibration));
+    }
+
+    free(raw_calibration);
+    return result;
 }
 
-k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_version_t *version)
+k4a_wait_result_t k4a_broker_client_get_capture(k4a_broker_client_t client_handle,
+                                                k4a_capture_t *capture_handle,
+                                                int32_t timeout_in_ms)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
-    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_broker_client_t, client_handle);
+    k4a_broker_client_context_t *client = k4a_broker_client_t_get_context(client_handle);
 
-    return TRACE_CALL(depth_get_device_version(device->depth, version));
+    return TRACE_WAIT_CALL(broker_client_get_capture(client->client, capture_handle, timeout_in_ms));
 }
 
-k4a_result_t k4a_device_get_sync_jack(k4a_device_t device_handle,
-                                      bool *sync_in_jack_connected,
-                                      bool *sync_out_jack_connected)
+void k4a_broker_detach(k4a_broker_client_t client_handle)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
-    k4a_context_t *device = k4a_device_t_get_context(device_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_broker_client_t, client_handle);
+    k4a_broker_client_context_t *client = k4a_broker_client_t_get_context(client_handle);
 
-    return TRACE_CALL(
-        colormcu_get_external_sync_jack_state(device->colormcu, sync_in_jack_connected, sync_out_jack_connected));
+    broker_detach(client->client);
+    k4a_broker_client_t_destroy(client_handle);
 }
 
 k4a_result_t k4a_device_get_color_control_capabilities(k4a_device_t device_handle,
@@ -1126,6 +2298,54 @@ k4a_result_t k4a_calibration_3d_to_2d(const k4a_calibration_t *calibration,
         calibration, source_point3d_mm->v, source_camera, target_camera, target_point2d->v, valid));
 }
 
+k4a_result_t k4a_calibration_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float2_t *source_points2d,
+                                            const float *source_depths_mm,
+                                            size_t point_count,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float3_t *target_points3d_mm,
+                                            int *valid)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points2d == NULL || source_depths_mm == NULL ||
+                                            target_points3d_mm == NULL || valid == NULL));
+    if (point_count == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    return TRACE_CALL(transformation_2d_to_3d_batch(calibration,
+                                                    source_points2d->v,
+                                                    source_depths_mm,
+                                                    point_count,
+                                                    source_camera,
+                                                    target_camera,
+                                                    target_points3d_mm->v,
+                                                    valid));
+}
+
+k4a_result_t k4a_calibration_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                            const k4a_float3_t *source_points3d_mm,
+                                            size_t point_count,
+                                            const k4a_calibration_type_t source_camera,
+                                            const k4a_calibration_type_t target_camera,
+                                            k4a_float2_t *target_points2d,
+                                            int *valid)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points3d_mm == NULL || target_points2d == NULL || valid == NULL));
+    if (point_count == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    return TRACE_CALL(transformation_3d_to_2d_batch(
+        calibration, source_points3d_mm->v, point_count, source_camera, target_camera, target_points2d->v, valid));
+}
+
 k4a_result_t k4a_calibration_2d_to_2d(const k4a_calibration_t *calibration,
                                       const k4a_float2_t *source_point2d,
                                       const float source_depth_mm,
@@ -1158,6 +2378,17 @@ void k4a_transformation_destroy(k4a_transformation_t transformation_handle)
     transformation_destroy(transformation_handle);
 }
 
+k4a_result_t k4a_transformation_set_region_of_interest(k4a_transformation_t transformation_handle,
+                                                       const k4a_transformation_roi_t *roi)
+{
+    return TRACE_CALL(transformation_set_region_of_interest(transformation_handle, roi));
+}
+
+k4a_result_t k4a_transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count)
+{
+    return TRACE_CALL(transformation_set_thread_count(transformation_handle, thread_count));
+}
+
 static k4a_transformation_image_descriptor_t k4a_image_get_descriptor(const k4a_image_t image)
 {
     k4a_transformation_image_descriptor_t descriptor;
@@ -1168,16 +2399,115 @@ static k4a_transformation_image_descriptor_t k4a_image_get_descriptor(const k4a_
     return descriptor;
 }
 
+// An image passed to a transformation, which reads and writes packed rows. Images with padded rows, such as views
+// created with k4a_image_create_view(), are copied to a packed buffer and written back when they are an output.
+typedef struct _k4a_transformation_image_t
+{
+    k4a_transformation_image_descriptor_t descriptor;
+    uint8_t *buffer;
+    uint8_t *packed; // NULL when the image is used in place
+    uint8_t *image_buffer;
+    int image_stride_bytes;
+    int rows;
+} k4a_transformation_image_t;
+
+// Releases the packed copies, writing the images from first_output on back when the transformation succeeded
+static void k4a_transformation_images_complete(k4a_transformation_image_t *transformation_images,
+                                               size_t count,
+                                               size_t first_output,
+                                               k4a_result_t result)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        k4a_transformation_image_t *image = &transformation_images[i];
+        if (image->packed == NULL)
+        {
+            continue;
+        }
+
+        int packed_stride_bytes = image->descriptor.stride_bytes;
+        for (int row = 0; i >= first_output && K4A_SUCCEEDED(result) && row < image->rows; row++)
+        {
+            memcpy(image->image_buffer + (size_t)row * (size_t)image->image_stride_bytes,
+                   image->packed + (size_t)row * (size_t)packed_stride_bytes,
+                   (size_t)packed_stride_bytes);
+        }
+        free(image->packed);
+        image->packed = NULL;
+    }
+}
+
+// Prepares the images of a transformation, images may be NULL
+static k4a_result_t k4a_transformation_images_init(const k4a_image_t *images,
+                                                   k4a_transformation_image_t *transformation_images,
+                                                   size_t count)
+{
+    memset(transformation_images, 0, count * sizeof(k4a_transformation_image_t));
+    for (size_t i = 0; i < count; i++)
+    {
+        k4a_transformation_image_t *image = &transformation_images[i];
+        image->descriptor = k4a_image_get_descriptor(images[i]);
+        image->buffer = k4a_image_get_buffer(images[i]);
+
+        // Missing images are left to the validation of the transformation
+        int packed_stride_bytes = images[i] != NULL ? image_get_packed_stride_bytes(images[i]) : 0;
+        if (image->buffer == NULL || packed_stride_bytes == 0 || image->descriptor.stride_bytes <= packed_stride_bytes)
+        {
+            continue;
+        }
+
+        image->rows = image->descriptor.height_pixels;
+        if (image->descriptor.format == K4A_IMAGE_FORMAT_COLOR_NV12)
+        {
+            image->rows += image->rows / 2;
+        }
+
+        image->packed = (uint8_t *)malloc((size_t)image->rows * (size_t)packed_stride_bytes);
+        if (image->packed == NULL)
+        {
+            LOG_ERROR("Failed to allocate a packed copy of a %d byte wide image", packed_stride_bytes);
+            k4a_transformation_images_complete(transformation_images, i, count, K4A_RESULT_FAILED);
+            return K4A_RESULT_FAILED;
+        }
+
+        // Outputs are copied too, transformations may leave pixels unwritten
+        for (int row = 0; row < image->rows; row++)
+        {
+            memcpy(image->packed + (size_t)row * (size_t)packed_stride_bytes,
+                   image->buffer + (size_t)row * (size_t)image->descriptor.stride_bytes,
+                   (size_t)packed_stride_bytes);
+        }
+
+        image->image_buffer = image->buffer;
+        image->image_stride_bytes = image->descriptor.stride_bytes;
+        image->buffer = image->packed;
+        image->descriptor.stride_bytes = packed_stride_bytes;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_transformation_get_xy_table(k4a_transformation_t transformation_handle,
+                                             const k4a_calibration_type_t camera,
+                                             k4a_image_t xy_table_image)
+{
+    k4a_transformation_image_descriptor_t xy_table_image_descriptor = k4a_image_get_descriptor(xy_table_image);
+    uint8_t *xy_table_image_buffer = k4a_image_get_buffer(xy_table_image);
+
+    return TRACE_CALL(transformation_get_xy_table(
+        transformation_handle, camera, xy_table_image_buffer, &xy_table_image_descriptor));
+}
+
 k4a_result_t k4a_transformation_depth_image_to_color_camera(k4a_transformation_t transformation_handle,
                                                             const k4a_image_t depth_image,
                                                             k4a_image_t transformed_depth_image)
 {
-    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
-    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = k4a_image_get_descriptor(
-        transformed_depth_image);
-
-    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
-    uint8_t *transformed_depth_image_buffer = k4a_image_get_buffer(transformed_depth_image);
+    // The depth image is the input, the transformed depth image the output
+    const k4a_image_t images[] = { depth_image, transformed_depth_image };
+    k4a_transformation_image_t bound[2];
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(images, bound, 2))))
+    {
+        return K4A_RESULT_FAILED;
+    }
 
     // Both k4a_transformation_depth_image_to_color_camera and k4a_transformation_depth_image_to_color_camera_custom
     // call the same implementation of transformation_depth_image_to_color_camera_custom. The below parameters need
@@ -1188,17 +2518,19 @@ k4a_result_t k4a_transformation_depth_image_to_color_camera(k4a_transformation_t
     k4a_transformation_interpolation_type_t interpolation_type = K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR;
     uint32_t invalid_custom_value = 0;
 
-    return TRACE_CALL(transformation_depth_image_to_color_camera_custom(transformation_handle,
-                                                                        depth_image_buffer,
-                                                                        &depth_image_descriptor,
-                                                                        custom_image_buffer,
-                                                                        &dummy_descriptor,
-                                                                        transformed_depth_image_buffer,
-                                                                        &transformed_depth_image_descriptor,
-                                                                        transformed_custom_image_buffer,
-                                                                        &dummy_descriptor,
-                                                                        interpolation_type,
-                                                                        invalid_custom_value));
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                                        bound[0].buffer,
+                                                                                        &bound[0].descriptor,
+                                                                                        custom_image_buffer,
+                                                                                        &dummy_descriptor,
+                                                                                        bound[1].buffer,
+                                                                                        &bound[1].descriptor,
+                                                                                        transformed_custom_image_buffer,
+                                                                                        &dummy_descriptor,
+                                                                                        interpolation_type,
+                                                                                        invalid_custom_value));
+    k4a_transformation_images_complete(bound, 2, 1, result);
+    return result;
 }
 
 k4a_result_t
@@ -1210,29 +2542,87 @@ k4a_transformation_depth_image_to_color_camera_custom(k4a_transformation_t trans
                                                       k4a_transformation_interpolation_type_t interpolation_type,
                                                       uint32_t invalid_custom_value)
 {
-    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
-    k4a_transformation_image_descriptor_t custom_image_descriptor = k4a_image_get_descriptor(custom_image);
-    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = k4a_image_get_descriptor(
-        transformed_depth_image);
-    k4a_transformation_image_descriptor_t transformed_custom_image_descriptor = k4a_image_get_descriptor(
-        transformed_custom_image);
+    const k4a_image_t images[] = { depth_image, custom_image, transformed_depth_image, transformed_custom_image };
+    k4a_transformation_image_t bound[4];
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(images, bound, 4))))
+    {
+        return K4A_RESULT_FAILED;
+    }
 
-    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
-    uint8_t *custom_image_buffer = k4a_image_get_buffer(custom_image);
-    uint8_t *transformed_depth_image_buffer = k4a_image_get_buffer(transformed_depth_image);
-    uint8_t *transformed_custom_image_buffer = k4a_image_get_buffer(transformed_custom_image);
-
-    return TRACE_CALL(transformation_depth_image_to_color_camera_custom(transformation_handle,
-                                                                        depth_image_buffer,
-                                                                        &depth_image_descriptor,
-                                                                        custom_image_buffer,
-                                                                        &custom_image_descriptor,
-                                                                        transformed_depth_image_buffer,
-                                                                        &transformed_depth_image_descriptor,
-                                                                        transformed_custom_image_buffer,
-                                                                        &transformed_custom_image_descriptor,
-                                                                        interpolation_type,
-                                                                        invalid_custom_value));
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                                        bound[0].buffer,
+                                                                                        &bound[0].descriptor,
+                                                                                        bound[1].buffer,
+                                                                                        &bound[1].descriptor,
+                                                                                        bound[2].buffer,
+                                                                                        &bound[2].descriptor,
+                                                                                        bound[3].buffer,
+                                                                                        &bound[3].descriptor,
+                                                                                        interpolation_type,
+                                                                                        invalid_custom_value));
+    k4a_transformation_images_complete(bound, 4, 2, result);
+    return result;
+}
+
+k4a_result_t
+k4a_transformation_depth_image_to_color_camera_custom_images(k4a_transformation_t transformation_handle,
+                                                             const k4a_image_t depth_image,
+                                                             const k4a_image_t *custom_images,
+                                                             size_t custom_image_count,
+                                                             k4a_image_t transformed_depth_image,
+                                                             k4a_image_t *transformed_custom_images,
+                                                             k4a_transformation_interpolation_type_t interpolation_type,
+                                                             const uint32_t *invalid_custom_values)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, custom_image_count > K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        custom_image_count > 0 && (custom_images == NULL || transformed_custom_images == NULL ||
+                                                   invalid_custom_values == NULL));
+
+    // Inputs first: the depth image and the custom images, then the transformed depth and custom images
+    k4a_image_t images[2 + 2 * K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    k4a_transformation_image_t bound[2 + 2 * K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    size_t first_output = 1 + custom_image_count;
+    size_t count = 2 + 2 * custom_image_count;
+    images[0] = depth_image;
+    images[first_output] = transformed_depth_image;
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        images[1 + i] = custom_images[i];
+        images[first_output + 1 + i] = transformed_custom_images[i];
+    }
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(images, bound, count))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t custom_image_descriptors[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    k4a_transformation_image_descriptor_t transformed_custom_image_descriptors[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    const uint8_t *custom_image_buffers[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    uint8_t *transformed_custom_image_buffers[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        custom_image_descriptors[i] = bound[1 + i].descriptor;
+        transformed_custom_image_descriptors[i] = bound[first_output + 1 + i].descriptor;
+        custom_image_buffers[i] = bound[1 + i].buffer;
+        transformed_custom_image_buffers[i] = bound[first_output + 1 + i].buffer;
+    }
+
+    k4a_result_t result = TRACE_CALL(
+        transformation_depth_image_to_color_camera_custom_images(transformation_handle,
+                                                                 bound[0].buffer,
+                                                                 &bound[0].descriptor,
+                                                                 custom_image_count,
+                                                                 custom_image_buffers,
+                                                                 custom_image_descriptors,
+                                                                 bound[first_output].buffer,
+                                                                 &bound[first_output].descriptor,
+                                                                 transformed_custom_image_buffers,
+                                                                 transformed_custom_image_descriptors,
+                                                                 interpolation_type,
+                                                                 invalid_custom_values));
+    k4a_transformation_images_complete(bound, count, first_output, result);
+    return result;
 }
 
 k4a_result_t k4a_transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
@@ -1240,31 +2630,148 @@ k4a_result_t k4a_transformation_color_image_to_depth_camera(k4a_transformation_t
                                                             const k4a_image_t color_image,
                                                             k4a_image_t transformed_color_image)
 {
-    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
-    k4a_transformation_image_descriptor_t color_image_descriptor = k4a_image_get_descriptor(color_image);
-    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = k4a_image_get_descriptor(
-        transformed_color_image);
+    return TRACE_CALL(k4a_transformation_color_image_to_depth_camera_with_interpolation(
+        transformation_handle,
+        depth_image,
+        color_image,
+        transformed_color_image,
+        K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR));
+}
 
+k4a_result_t k4a_transformation_color_image_to_depth_camera_with_interpolation(
+    k4a_transformation_t transformation_handle,
+    const k4a_image_t depth_image,
+    const k4a_image_t color_image,
+    k4a_image_t transformed_color_image,
+    k4a_transformation_interpolation_type_t interpolation_type)
+{
     k4a_image_format_t color_image_format = k4a_image_get_format(color_image);
     k4a_image_format_t transformed_color_image_format = k4a_image_get_format(transformed_color_image);
-    if (!(color_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32 &&
+    if (!((color_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32 || color_image_format == K4A_IMAGE_FORMAT_COLOR_NV12 ||
+           color_image_format == K4A_IMAGE_FORMAT_COLOR_YUY2 || color_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG) &&
           transformed_color_image_format == K4A_IMAGE_FORMAT_COLOR_BGRA32))
     {
-        LOG_ERROR("Require color image and transformed color image both have bgra32 format.", 0);
+        LOG_ERROR("Require color image of bgra32, nv12, yuy2 or mjpg format and transformed color image of bgra32 "
+                  "format.",
+                  0);
         return K4A_RESULT_FAILED;
     }
 
+    const k4a_image_t images[] = { depth_image, color_image, transformed_color_image };
+    k4a_transformation_image_t bound[3];
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(images, bound, 3))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // NV12 and YUY2 are sampled in place. MJPEG is decoded at a reduced scale, only to the resolution the depth
+    // camera samples.
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    uint8_t *decoded_color_buffer = NULL;
+    k4a_transformation_image_descriptor_t decoded_color_descriptor = bound[1].descriptor;
+    if (color_image_format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        result = TRACE_CALL(transformation_decode_color_image(transformation_handle,
+                                                              bound[1].buffer,
+                                                              k4a_image_get_size(color_image),
+                                                              &decoded_color_buffer,
+                                                              &decoded_color_descriptor));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(transformation_color_image_to_depth_camera_with_interpolation(
+            transformation_handle,
+            bound[0].buffer,
+            &bound[0].descriptor,
+            decoded_color_buffer != NULL ? decoded_color_buffer : bound[1].buffer,
+            &decoded_color_descriptor,
+            bound[2].buffer,
+            &bound[2].descriptor,
+            interpolation_type));
+    }
+    free(decoded_color_buffer);
+    k4a_transformation_images_complete(bound, 3, 2, result);
+    return result;
+}
+
+k4a_result_t k4a_transformation_depth_image_to_color_camera_gpu(k4a_transformation_t transformation_handle,
+                                                                const k4a_image_t depth_image,
+                                                                k4a_gpu_interop_type_t type,
+                                                                k4a_gpu_resource_t *transformed_depth_resource)
+{
+    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
+    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
+
+    return TRACE_CALL(transformation_depth_image_to_color_camera_gpu(
+        transformation_handle, depth_image_buffer, &depth_image_descriptor, type, transformed_depth_resource));
+}
+
+k4a_result_t k4a_transformation_color_image_to_depth_camera_gpu(k4a_transformation_t transformation_handle,
+                                                                const k4a_image_t depth_image,
+                                                                const k4a_image_t color_image,
+                                                                k4a_gpu_interop_type_t type,
+                                                                k4a_gpu_resource_t *transformed_color_resource)
+{
+    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
+    k4a_transformation_image_descriptor_t color_image_descriptor = k4a_image_get_descriptor(color_image);
+
     uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
     uint8_t *color_image_buffer = k4a_image_get_buffer(color_image);
-    uint8_t *transformed_color_image_buffer = k4a_image_get_buffer(transformed_color_image);
 
-    return TRACE_CALL(transformation_color_image_to_depth_camera(transformation_handle,
-                                                                 depth_image_buffer,
-                                                                 &depth_image_descriptor,
-                                                                 color_image_buffer,
-                                                                 &color_image_descriptor,
-                                                                 transformed_color_image_buffer,
-                                                                 &transformed_color_image_descriptor));
+    return TRACE_CALL(transformation_color_image_to_depth_camera_gpu(transformation_handle,
+                                                                     depth_image_buffer,
+                                                                     &depth_image_descriptor,
+                                                                     color_image_buffer,
+                                                                     &color_image_descriptor,
+                                                                     type,
+                                                                     transformed_color_resource));
+}
+
+k4a_result_t k4a_transformation_depth_resource_to_color_camera_gpu(k4a_transformation_t transformation_handle,
+                                                                   const k4a_gpu_resource_t *depth_resource,
+                                                                   k4a_gpu_interop_type_t type,
+                                                                   k4a_gpu_resource_t *transformed_depth_resource)
+{
+    return TRACE_CALL(transformation_depth_resource_to_color_camera_gpu(
+        transformation_handle, depth_resource, type, transformed_depth_resource));
+}
+
+void k4a_transformation_release_gpu_resource(k4a_transformation_t transformation_handle,
+                                             const k4a_gpu_resource_t *resource)
+{
+    (void)TRACE_CALL(transformation_release_gpu_resource(transformation_handle, resource));
+}
+
+k4a_result_t k4a_transformation_color_2d_to_depth_2d_batch(k4a_transformation_t transformation_handle,
+                                                           const k4a_image_t depth_image,
+                                                           const k4a_float2_t *source_points2d,
+                                                           size_t point_count,
+                                                           k4a_float2_t *target_points2d,
+                                                           int *valid)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        point_count > 0 && (source_points2d == NULL || target_points2d == NULL || valid == NULL));
+    if (point_count == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(transformation_color_2d_to_depth_2d_batch(transformation_handle,
+                                                                               depth.buffer,
+                                                                               &depth.descriptor,
+                                                                               source_points2d->v,
+                                                                               point_count,
+                                                                               target_points2d->v,
+                                                                               valid));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
 }
 
 k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
@@ -1272,18 +2779,276 @@ k4a_result_t k4a_transformation_depth_image_to_point_cloud(k4a_transformation_t
                                                            const k4a_calibration_type_t camera,
                                                            k4a_image_t xyz_image)
 {
-    k4a_transformation_image_descriptor_t depth_image_descriptor = k4a_image_get_descriptor(depth_image);
+    // Point clouds have no fixed bytes per pixel format, only the depth image is packed
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
     k4a_transformation_image_descriptor_t xyz_image_descriptor = k4a_image_get_descriptor(xyz_image);
+    uint8_t *xyz_image_buffer = k4a_image_get_buffer(xyz_image);
 
-    uint8_t *depth_image_buffer = k4a_image_get_buffer(depth_image);
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_point_cloud(
+        transformation_handle, depth.buffer, &depth.descriptor, camera, xyz_image_buffer, &xyz_image_descriptor));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
+}
+
+k4a_result_t
+k4a_transformation_depth_image_to_point_cloud_with_format(k4a_transformation_t transformation_handle,
+                                                          const k4a_image_t depth_image,
+                                                          const k4a_calibration_type_t camera,
+                                                          k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                          k4a_image_t xyz_image)
+{
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = k4a_image_get_descriptor(xyz_image);
+    uint8_t *xyz_image_buffer = k4a_image_get_buffer(xyz_image);
+
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_point_cloud_with_format(transformation_handle,
+                                                                                          depth.buffer,
+                                                                                          &depth.descriptor,
+                                                                                          camera,
+                                                                                          point_cloud_format,
+                                                                                          xyz_image_buffer,
+                                                                                          &xyz_image_descriptor));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
+}
+
+k4a_result_t
+k4a_transformation_depth_image_to_compact_point_cloud(k4a_transformation_t transformation_handle,
+                                                      const k4a_image_t depth_image,
+                                                      const k4a_calibration_type_t camera,
+                                                      k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                      k4a_image_t xyz_image,
+                                                      k4a_image_t index_image,
+                                                      size_t *point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, point_count == NULL);
+
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = k4a_image_get_descriptor(xyz_image);
+    uint8_t *xyz_image_buffer = k4a_image_get_buffer(xyz_image);
+
+    // The index image is optional
+    k4a_transformation_image_descriptor_t index_image_descriptor;
+    k4a_transformation_image_descriptor_t *index_image_descriptor_ptr = NULL;
+    uint8_t *index_image_buffer = NULL;
+    if (index_image != NULL)
+    {
+        index_image_descriptor = k4a_image_get_descriptor(index_image);
+        index_image_descriptor_ptr = &index_image_descriptor;
+        index_image_buffer = k4a_image_get_buffer(index_image);
+    }
+
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_compact_point_cloud(transformation_handle,
+                                                                                      depth.buffer,
+                                                                                      &depth.descriptor,
+                                                                                      camera,
+                                                                                      point_cloud_format,
+                                                                                      xyz_image_buffer,
+                                                                                      &xyz_image_descriptor,
+                                                                                      index_image_buffer,
+                                                                                      index_image_descriptor_ptr,
+                                                                                      point_count));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
+}
+
+k4a_result_t
+k4a_transformation_depth_image_to_point_cloud_with_normals(k4a_transformation_t transformation_handle,
+                                                           const k4a_image_t depth_image,
+                                                           const k4a_calibration_type_t camera,
+                                                           k4a_image_t xyz_image,
+                                                           k4a_image_t normal_image)
+{
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = k4a_image_get_descriptor(xyz_image);
+    uint8_t *xyz_image_buffer = k4a_image_get_buffer(xyz_image);
+    k4a_transformation_image_descriptor_t normal_image_descriptor = k4a_image_get_descriptor(normal_image);
+    uint8_t *normal_image_buffer = k4a_image_get_buffer(normal_image);
+
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_point_cloud_with_normals(transformation_handle,
+                                                                                           depth.buffer,
+                                                                                           &depth.descriptor,
+                                                                                           camera,
+                                                                                           xyz_image_buffer,
+                                                                                           &xyz_image_descriptor,
+                                                                                           normal_image_buffer,
+                                                                                           &normal_image_descriptor));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
+}
+
+k4a_result_t k4a_transformation_depth_image_to_voxel_point_cloud(k4a_transformation_t transformation_handle,
+                                                                 const k4a_image_t depth_image,
+                                                                 const k4a_calibration_type_t camera,
+                                                                 float voxel_size,
+                                                                 k4a_image_t xyz_image,
+                                                                 k4a_image_t normal_image,
+                                                                 size_t *point_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, point_count == NULL);
+
+    k4a_transformation_image_t depth;
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(&depth_image, &depth, 1))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = k4a_image_get_descriptor(xyz_image);
     uint8_t *xyz_image_buffer = k4a_image_get_buffer(xyz_image);
 
-    return TRACE_CALL(transformation_depth_image_to_point_cloud(transformation_handle,
-                                                                depth_image_buffer,
-                                                                &depth_image_descriptor,
-                                                                camera,
-                                                                xyz_image_buffer,
-                                                                &xyz_image_descriptor));
+    // The normal image is optional
+    k4a_transformation_image_descriptor_t normal_image_descriptor;
+    k4a_transformation_image_descriptor_t *normal_image_descriptor_ptr = NULL;
+    uint8_t *normal_image_buffer = NULL;
+    if (normal_image != NULL)
+    {
+        normal_image_descriptor = k4a_image_get_descriptor(normal_image);
+        normal_image_descriptor_ptr = &normal_image_descriptor;
+        normal_image_buffer = k4a_image_get_buffer(normal_image);
+    }
+
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_voxel_point_cloud(transformation_handle,
+                                                                                    depth.buffer,
+                                                                                    &depth.descriptor,
+                                                                                    camera,
+                                                                                    voxel_size,
+                                                                                    xyz_image_buffer,
+                                                                                    &xyz_image_descriptor,
+                                                                                    normal_image_buffer,
+                                                                                    normal_image_descriptor_ptr,
+                                                                                    point_count));
+    k4a_transformation_images_complete(&depth, 1, 1, result);
+    return result;
+}
+
+k4a_result_t k4a_transformation_depth_image_to_colored_point_cloud(k4a_transformation_t transformation_handle,
+                                                                   const k4a_image_t depth_image,
+                                                                   const k4a_image_t color_image,
+                                                                   k4a_image_t colored_xyz_image)
+{
+    if (k4a_image_get_format(color_image) != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        LOG_ERROR("Require color image to have bgra32 format.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_image_t images[] = { depth_image, color_image };
+    k4a_transformation_image_t bound[2];
+    if (K4A_FAILED(TRACE_CALL(k4a_transformation_images_init(images, bound, 2))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t colored_xyz_image_descriptor = k4a_image_get_descriptor(colored_xyz_image);
+    uint8_t *colored_xyz_image_buffer = k4a_image_get_buffer(colored_xyz_image);
+
+    k4a_result_t result = TRACE_CALL(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                                      bound[0].buffer,
+                                                                                      &bound[0].descriptor,
+                                                                                      bound[1].buffer,
+                                                                                      &bound[1].descriptor,
+                                                                                      colored_xyz_image_buffer,
+                                                                                      &colored_xyz_image_descriptor));
+    k4a_transformation_images_complete(bound, 2, 2, result);
+    return result;
+}
+
+k4a_result_t k4a_transformation_submit(k4a_transformation_t transformation_handle,
+                                       const k4a_transformation_job_t *jobs,
+                                       size_t job_count,
+                                       k4a_transformation_completion_cb_t *callback,
+                                       void *callback_context)
+{
+    return TRACE_CALL(transformation_submit(transformation_handle, jobs, job_count, callback, callback_context));
+}
+
+k4a_wait_result_t k4a_transformation_wait_idle(k4a_transformation_t transformation_handle, int32_t timeout_in_ms)
+{
+    return TRACE_WAIT_CALL(transformation_wait_idle(transformation_handle, timeout_in_ms));
+}
+
+k4a_result_t k4a_undistortion_map_create(const k4a_calibration_t *calibration,
+                                         k4a_calibration_type_t camera,
+                                         const k4a_pinhole_t *target,
+                                         const float *rotation,
+                                         uint32_t thread_count,
+                                         k4a_undistortion_map_t *map_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        camera != K4A_CALIBRATION_TYPE_DEPTH && camera != K4A_CALIBRATION_TYPE_COLOR);
+
+    const k4a_calibration_camera_t *camera_calibration = camera == K4A_CALIBRATION_TYPE_DEPTH ?
+                                                             &calibration->depth_camera_calibration :
+                                                             &calibration->color_camera_calibration;
+    return TRACE_CALL(undistort_map_create(camera_calibration, target, rotation, thread_count, map_handle));
+}
+
+k4a_result_t k4a_undistortion_map_remap(k4a_undistortion_map_t map_handle,
+                                        const k4a_image_t source_image,
+                                        k4a_image_t destination_image,
+                                        k4a_transformation_interpolation_type_t interpolation_type)
+{
+    k4a_transformation_image_descriptor_t source_descriptor = k4a_image_get_descriptor(source_image);
+    k4a_transformation_image_descriptor_t destination_descriptor = k4a_image_get_descriptor(destination_image);
+    return TRACE_CALL(undistort_map_remap(map_handle,
+                                          k4a_image_get_buffer(source_image),
+                                          &source_descriptor,
+                                          k4a_image_get_buffer(destination_image),
+                                          &destination_descriptor,
+                                          interpolation_type));
+}
+
+void k4a_undistortion_map_destroy(k4a_undistortion_map_t map_handle)
+{
+    undistort_map_destroy(map_handle);
+}
+
+k4a_result_t k4a_tensor_converter_create(const k4a_tensor_configuration_t *config,
+                                         uint32_t thread_count,
+                                         k4a_tensor_converter_t *converter_handle)
+{
+    return TRACE_CALL(tensor_converter_create(config, thread_count, converter_handle));
+}
+
+size_t k4a_tensor_converter_get_size(k4a_tensor_converter_t converter_handle)
+{
+    return tensor_converter_get_size(converter_handle);
+}
+
+k4a_result_t k4a_tensor_converter_convert(k4a_tensor_converter_t converter_handle,
+                                          const k4a_image_t image,
+                                          void *tensor,
+                                          size_t tensor_size)
+{
+    k4a_transformation_image_descriptor_t descriptor = k4a_image_get_descriptor(image);
+    return TRACE_CALL(
+        tensor_converter_convert(converter_handle, k4a_image_get_buffer(image), &descriptor, tensor, tensor_size));
+}
+
+void k4a_tensor_converter_destroy(k4a_tensor_converter_t converter_handle)
+{
+    tensor_converter_destroy(converter_handle);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <k4ainternal/simd.h>
+
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/envvariable.h>
+
+// System dependencies
+#include <ctype.h>
+#include <stdint.h>
+#if defined(K4A_USING_SSE)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Bits of the CPUID leaves and of XCR0 the levels depend on
+#define SIMD_CPUID1_ECX_SSE41 (1u << 19)
+#define SIMD_CPUID1_ECX_OSXSAVE (1u << 27)
+#define SIMD_CPUID1_ECX_AVX (1u << 28)
+#define SIMD_CPUID1_ECX_F16C (1u << 29)
+#define SIMD_CPUID7_EBX_AVX2 (1u << 5)
+#define SIMD_CPUID7_EBX_AVX512F (1u << 16)
+#define SIMD_CPUID7_EBX_AVX512BW (1u << 30)
+#define SIMD_CPUID7_EBX_AVX512VL (1u << 31)
+#define SIMD_XCR0_AVX_STATE (0x06u)    // XMM and YMM registers
+#define SIMD_XCR0_AVX512_STATE (0xe6u) // XMM, YMM, opmask and ZMM registers
+
+// Process wide instruction set of the kernels
+typedef struct
+{
+    simd_level_t supported_level;
+    simd_level_t level;
+} simd_global_t;
+
+static void simd_global_init(simd_global_t *global);
+
+// Creates a function called simd_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(simd_global_t, simd_global_init);
+
+#if defined(K4A_USING_SSE)
+// Reads a CPUID leaf into eax, ebx, ecx and edx, all zero if the leaf is not supported
+static void simd_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#if defined(_MSC_VER)
+    int info[4] = { 0 };
+    __cpuid(info, 0);
+    if ((uint32_t)info[0] >= leaf)
+    {
+        __cpuidex(info, (int)leaf, (int)subleaf);
+        for (int i = 0; i < 4; i++)
+        {
+            registers[i] = (uint32_t)info[i];
+        }
+        return;
+    }
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0, NULL) >= leaf)
+    {
+        __cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+        registers[0] = eax;
+        registers[1] = ebx;
+        registers[2] = ecx;
+        registers[3] = edx;
+        return;
+    }
+#endif
+    registers[0] = registers[1] = registers[2] = registers[3] = 0;
+}
+
+// Reads XCR0, the register states the operating system saves on a context switch
+static uint32_t simd_xgetbv(void)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)_xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+#endif
+
+static simd_level_t simd_detect_level(void)
+{
+#if defined(K4A_USING_SSE)
+    uint32_t leaf1[4];
+    uint32_t leaf7[4];
+    simd_cpuid(1, 0, leaf1);
+    simd_cpuid(7, 0, leaf7);
+
+    if ((leaf1[2] & SIMD_CPUID1_ECX_SSE41) == 0)
+    {
+        return SIMD_LEVEL_NONE;
+    }
+
+    uint32_t avx_bits = SIMD_CPUID1_ECX_OSXSAVE | SIMD_CPUID1_ECX_AVX | SIMD_CPUID1_ECX_F16C;
+    if ((leaf1[2] & avx_bits) != avx_bits || (leaf7[1] & SIMD_CPUID7_EBX_AVX2) == 0)
+    {
+        return SIMD_LEVEL_SSE41;
+    }
+    uint32_t xcr0 = simd_xgetbv();
+    if ((xcr0 & SIMD_XCR0_AVX_STATE) != SIMD_XCR0_AVX_STATE)
+    {
+        return SIMD_LEVEL_SSE41;
+    }
+
+#if defined(K4A_USING_AVX)
+    uint32_t avx512_bits = SIMD_CPUID7_EBX_AVX512F | SIMD_CPUID7_EBX_AVX512BW | SIMD_CPUID7_EBX_AVX512VL;
+    if ((leaf7[1] & avx512_bits) != avx512_bits || (xcr0 & SIMD_XCR0_AVX512_STATE) != SIMD_XCR0_AVX512_STATE)
+    {
+        return SIMD_LEVEL_AVX2;
+    }
+    return SIMD_LEVEL_AVX512;
+#else
+    // The compiler can't build the AVX kernels
+    return SIMD_LEVEL_SSE41;
+#endif
+#elif defined(K4A_USING_NEON)
+    // NEON is part of the ARM64 baseline
+    return SIMD_LEVEL_NEON;
+#else
+    return SIMD_LEVEL_NONE;
+#endif
+}
+
+// Returns true if the kernels of level run where supported_level is detected
+static bool simd_level_is_supported(simd_level_t level, simd_level_t supported_level)
+{
+    if (level == SIMD_LEVEL_NONE || supported_level == SIMD_LEVEL_NEON)
+    {
+        return level == SIMD_LEVEL_NONE || level == SIMD_LEVEL_NEON;
+    }
+    return level != SIMD_LEVEL_NEON && level <= supported_level;
+}
+
+static void simd_global_init(simd_global_t *global)
+{
+    global->supported_level = simd_detect_level();
+    global->level = global->supported_level;
+
+    const char *env_level = environment_get_variable(SIMD_LEVEL_ENV_VAR);
+    if (env_level != NULL && env_level[0] != '\0')
+    {
+        simd_level_t level;
+        if (K4A_FAILED(simd_parse_level(env_level, &level)))
+        {
+            LOG_WARNING("Ignoring unknown %s value \"%s\".", SIMD_LEVEL_ENV_VAR, env_level);
+        }
+        else if (!simd_level_is_supported(level, global->supported_level))
+        {
+            LOG_WARNING("Ignoring %s value \"%s\", this processor supports %s.",
+                        SIMD_LEVEL_ENV_VAR,
+                        env_level,
+                        simd_get_level_name(global->supported_level));
+        }
+        else
+        {
+            global->level = level;
+        }
+    }
+
+    LOG_INFO("Vectorized kernels use %s, the processor supports %s.",
+             simd_get_level_name(global->level),
+             simd_get_level_name(global->supported_level));
+}
+
+simd_level_t simd_get_level(void)
+{
+    return simd_global_t_get()->level;
+}
+
+simd_level_t simd_get_supported_level(void)
+{
+    return simd_global_t_get()->supported_level;
+}
+
+const char *simd_get_level_name(simd_level_t level)
+{
+    switch (level)
+    {
+    case SIMD_LEVEL_NONE:
+        return "None";
+    case SIMD_LEVEL_NEON:
+        return "NEON";
+    case SIMD_LEVEL_SSE41:
+        return "SSE";
+    case SIMD_LEVEL_AVX2:
+        return "AVX2";
+    case SIMD_LEVEL_AVX512:
+        return "AVX512";
+    default:
+        return "Unknown";
+    }
+}
+
+// Compares an ASCII name with a lower case name, ignoring case
+static bool simd_name_equals(const char *name, const char *lower_case_name)
+{
+    for (; *name != '\0' && *lower_case_name != '\0'; name++, lower_case_name++)
+    {
+        if (tolower((unsigned char)*name) != *lower_case_name)
+        {
+            return false;
+        }
+    }
+    return *name == '\0' && *lower_case_name == '\0';
+}
+
+k4a_result_t simd_parse_level(const char *name, simd_level_t *level)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, level == NULL);
+
+    static const struct
+    {
+        const char *name;
+        simd_level_t level;
+    } names[] = {
+        { "none", SIMD_LEVEL_NONE }, { "neon", SIMD_LEVEL_NEON }, { "sse", SIMD_LEVEL_SSE41 },
+        { "sse4.1", SIMD_LEVEL_SSE41 }, { "avx2", SIMD_LEVEL_AVX2 }, { "avx512", SIMD_LEVEL_AVX512 },
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (simd_name_equals(name, names[i].name))
+        {
+            *level = names[i].level;
+            return K4A_RESULT_SUCCEEDED;
+        }
+    }
+    return K4A_RESULT_FAILED;
+}
@@ -0,0 +1,614 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library converts camera images to the normalized input tensors of neural networks
+#include <k4ainternal/tensor.h>
+
+// Dependent libraries
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/simd.h>
+#include <k4ainternal/threadpool.h>
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+
+// Image pixels a tensor column or row is sampled from. A bilinear sample blends first with second by weight, a nearest
+// sample reads first only.
+typedef struct _tensor_sample_t
+{
+    int first;
+    int second;
+    float weight;
+} tensor_sample_t;
+
+struct _tensor_context_t;
+
+// Rows [first_row, last_row) of the tensor that one thread converts
+typedef struct _tensor_band_t
+{
+    struct _tensor_context_t *context;
+    int first_row;
+    int last_row;
+
+    // Two image rows and one tensor row of float values per channel
+    float *scratch;
+} tensor_band_t;
+
+typedef struct _tensor_context_t
+{
+    k4a_tensor_configuration_t config;
+    int channel_count;
+    int bytes_per_pixel;
+    size_t tensor_size;
+    simd_level_t simd_level; // Instruction set of the row kernels, see simd_get_level()
+
+    // Each tensor value of channel c is value * gain[c] + offset[c], read from the image plane plane[c]
+    float gain[3];
+    float offset[3];
+    int plane[3];
+
+    // Without a resize the image rows are converted directly
+    bool resize;
+    bool nearest;
+    tensor_sample_t *columns;
+    tensor_sample_t *rows;
+
+    // Arguments of the conversion in progress
+    const uint8_t *image_data;
+    int image_stride;
+    uint8_t *tensor;
+
+    uint32_t band_count;
+    bool threadpool_acquired; // Held while band_count is above 1
+    tensor_band_t bands[TENSOR_MAX_THREAD_COUNT];
+} tensor_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_tensor_converter_t, tensor_context_t);
+
+// Maps the pixel centers of the tensor to the image
+static void tensor_fill_samples(int image_size, int tensor_size, bool nearest, tensor_sample_t *samples)
+{
+    float ratio = (float)image_size / (float)tensor_size;
+    float last = (float)(image_size - 1);
+    for (int i = 0; i < tensor_size; i++)
+    {
+        float center = ((float)i + 0.5f) * ratio;
+        if (nearest)
+        {
+            int pixel = (int)center;
+            samples[i].first = pixel < image_size ? pixel : image_size - 1;
+            samples[i].second = samples[i].first;
+            samples[i].weight = 0.f;
+            continue;
+        }
+
+        float position = center - 0.5f;
+        position = position < 0.f ? 0.f : (position > last ? last : position);
+        int pixel = (int)position;
+        samples[i].first = pixel;
+        samples[i].second = pixel + 1 < image_size ? pixel + 1 : pixel;
+        samples[i].weight = position - (float)pixel;
+    }
+}
+
+#if defined(K4A_USING_AVX)
+// The AVX2 and AVX-512 kernels convert the start of a row and return the first pixel they did not convert
+SIMD_TARGET_AVX2 static int tensor_load_row_bgra_avx2(const uint8_t *row, int width, float *planes, int plane_stride)
+{
+    // Each 128 bit lane is split into B, G, R and A groups of 4 pixels, then the groups of both lanes are paired
+    const __m256i deinterleave = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                                                  0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256i pair_groups = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(const void *)(row + 4 * x));
+        pixels = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels, deinterleave), pair_groups);
+        __m128i blue_green = _mm256_castsi256_si128(pixels);
+        __m128i red = _mm256_extracti128_si256(pixels, 1);
+        _mm256_storeu_ps(planes + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(blue_green)));
+        _mm256_storeu_ps(planes + plane_stride + x,
+                         _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(blue_green, 8))));
+        _mm256_storeu_ps(planes + 2 * plane_stride + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(red)));
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX2 static int tensor_load_row_16_avx2(const uint16_t *row, int width, float *values)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(const void *)(row + x));
+        _mm256_storeu_ps(values + x, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(pixels)));
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX512 static int tensor_load_row_16_avx512(const uint16_t *row, int width, float *values)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(const void *)(row + x));
+        _mm512_storeu_ps(values + x, _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(pixels)));
+    }
+    return x;
+}
+
+// The products and sums are rounded separately, as in the other paths, so no fused multiply add is used
+SIMD_TARGET_AVX2 static int tensor_store_row_avx2(const float *values,
+                                                  int width,
+                                                  float gain,
+                                                  float offset,
+                                                  k4a_tensor_data_type_t data_type,
+                                                  uint8_t *output)
+{
+    __m256 gains = _mm256_set1_ps(gain);
+    __m256 offsets = _mm256_set1_ps(offset);
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256 normalized = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(values + x), gains), offsets);
+        if (data_type == K4A_TENSOR_DATA_TYPE_FLOAT32)
+        {
+            _mm256_storeu_ps((float *)(void *)output + x, normalized);
+        }
+        else
+        {
+            __m128i halves = _mm256_cvtps_ph(normalized, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128((__m128i *)(void *)((uint16_t *)(void *)output + x), halves);
+        }
+    }
+    return x;
+}
+
+SIMD_TARGET_AVX512 static int tensor_store_row_avx512(const float *values,
+                                                      int width,
+                                                      float gain,
+                                                      float offset,
+                                                      k4a_tensor_data_type_t data_type,
+                                                      uint8_t *output)
+{
+    __m512 gains = _mm512_set1_ps(gain);
+    __m512 offsets = _mm512_set1_ps(offset);
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m512 normalized = _mm512_add_round_ps(_mm512_mul_round_ps(_mm512_loadu_ps(values + x),
+                                                                    gains,
+                                                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC),
+                                                offsets,
+                                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        if (data_type == K4A_TENSOR_DATA_TYPE_FLOAT32)
+        {
+            _mm512_storeu_ps((float *)(void *)output + x, normalized);
+        }
+        else
+        {
+            __m256i halves = _mm512_cvtps_ph(normalized, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm256_storeu_si256((__m256i *)(void *)((uint16_t *)(void *)output + x), halves);
+        }
+    }
+    return x;
+}
+#endif
+
+// Splits a row of BGRA pixels into B, G and R planes of plane_stride floats, alpha is dropped
+static void tensor_load_row_bgra(const uint8_t *row, int width, float *planes, int plane_stride, simd_level_t level)
+{
+    float *blue = planes;
+    float *green = planes + plane_stride;
+    float *red = planes + 2 * plane_stride;
+    int x = 0;
+#if defined(K4A_USING_AVX)
+    if (level >= SIMD_LEVEL_AVX2)
+    {
+        x = tensor_load_row_bgra_avx2(row, width, planes, plane_stride);
+    }
+#endif
+#if defined(K4A_USING_SSE)
+    const __m128i deinterleave = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    for (; level >= SIMD_LEVEL_SSE41 && x + 4 <= width; x += 4)
+    {
+        __m128i pixels = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(row + 4 * x)),
+                                          deinterleave);
+        _mm_storeu_ps(blue + x, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(pixels)));
+        _mm_storeu_ps(green + x, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 4))));
+        _mm_storeu_ps(red + x, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 8))));
+    }
+#elif defined(K4A_USING_NEON)
+    for (; level == SIMD_LEVEL_NEON && x + 8 <= width; x += 8)
+    {
+        uint8x8x4_t pixels = vld4_u8(row + 4 * x);
+        for (int c = 0; c < 3; c++)
+        {
+            uint16x8_t wide = vmovl_u8(pixels.val[c]);
+            float *plane = planes + c * plane_stride + x;
+            vst1q_f32(plane, vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide))));
+            vst1q_f32(plane + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide))));
+        }
+    }
+#endif
+    for (; x < width; x++)
+    {
+        blue[x] = (float)row[4 * x];
+        green[x] = (float)row[4 * x + 1];
+        red[x] = (float)row[4 * x + 2];
+    }
+}
+
+static void tensor_load_row_16(const uint16_t *row, int width, float *values, simd_level_t level)
+{
+    int x = 0;
+#if defined(K4A_USING_AVX)
+    if (level >= SIMD_LEVEL_AVX512)
+    {
+        x = tensor_load_row_16_avx512(row, width, values);
+    }
+    else if (level >= SIMD_LEVEL_AVX2)
+    {
+        x = tensor_load_row_16_avx2(row, width, values);
+    }
+#endif
+#if defined(K4A_USING_SSE)
+    for (; level >= SIMD_LEVEL_SSE41 && x + 8 <= width; x += 8)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(const void *)(row + x));
+        _mm_storeu_ps(values + x, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(pixels)));
+        _mm_storeu_ps(values + x + 4, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(pixels, 8))));
+    }
+#elif defined(K4A_USING_NEON)
+    for (; level == SIMD_LEVEL_NEON && x + 8 <= width; x += 8)
+    {
+        uint16x8_t pixels = vld1q_u16(row + x);
+        vst1q_f32(values + x, vcvtq_f32_u32(vmovl_u16(vget_low_u16(pixels))));
+        vst1q_f32(values + x + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(pixels))));
+    }
+#endif
+    for (; x < width; x++)
+    {
+        values[x] = (float)row[x];
+    }
+}
+
+// Converts a float to a half float, rounding to nearest even. Values too large for a half become infinity.
+static uint16_t tensor_float_to_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    // Infinity, NaN and values of 65520 and above
+    if (bits >= 0x47800000)
+    {
+        return (uint16_t)(sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00));
+    }
+
+    // Subnormal halves and zero. Adding 0.5 shifts the mantissa into place and rounds it with the float unit.
+    if (bits < 0x38800000)
+    {
+        float shifted;
+        memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += 0.5f;
+        memcpy(&bits, &shifted, sizeof(bits));
+        return (uint16_t)(sign | (bits - 0x3f000000));
+    }
+
+    // Rebias the exponent and round the 13 dropped mantissa bits, a carry correctly moves into the exponent
+    uint32_t odd = (bits >> 13) & 1;
+    bits += 0xc8000fff + odd;
+    return (uint16_t)(sign | (bits >> 13));
+}
+
+// Normalizes a row of values and stores it in the element type of the tensor
+static void tensor_store_row(const float *values,
+                             int width,
+                             float gain,
+                             float offset,
+                             k4a_tensor_data_type_t data_type,
+                             uint8_t *output,
+                             simd_level_t level)
+{
+    int x = 0;
+#if defined(K4A_USING_AVX)
+    if (level >= SIMD_LEVEL_AVX512)
+    {
+        x = tensor_store_row_avx512(values, width, gain, offset, data_type, output);
+    }
+    else if (level >= SIMD_LEVEL_AVX2)
+    {
+        x = tensor_store_row_avx2(values, width, gain, offset, data_type, output);
+    }
+#endif
+
+    if (data_type == K4A_TENSOR_DATA_TYPE_FLOAT32)
+    {
+        float *elements = (float *)(void *)output;
+#if defined(K4A_USING_SSE)
+        __m128 gains = _mm_set1_ps(gain);
+        __m128 offsets = _mm_set1_ps(offset);
+        for (; level >= SIMD_LEVEL_SSE41 && x + 4 <= width; x += 4)
+        {
+            _mm_storeu_ps(elements + x, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(values + x), gains), offsets));
+        }
+#elif defined(K4A_USING_NEON)
+        float32x4_t gains = vdupq_n_f32(gain);
+        float32x4_t offsets = vdupq_n_f32(offset);
+        for (; level == SIMD_LEVEL_NEON && x + 4 <= width; x += 4)
+        {
+            vst1q_f32(elements + x, vaddq_f32(vmulq_f32(vld1q_f32(values + x), gains), offsets));
+        }
+#endif
+        for (; x < width; x++)
+        {
+            elements[x] = values[x] * gain + offset;
+        }
+    }
+    else
+    {
+        uint16_t *elements = (uint16_t *)(void *)output;
+#if defined(K4A_USING_NEON)
+        float32x4_t gains = vdupq_n_f32(gain);
+        float32x4_t offsets = vdupq_n_f32(offset);
+        for (; level == SIMD_LEVEL_NEON && x + 4 <= width; x += 4)
+        {
+            float32x4_t normalized = vaddq_f32(vmulq_f32(vld1q_f32(values + x), gains), offsets);
+            vst1_u16(elements + x, vreinterpret_u16_f16(vcvt_f16_f32(normalized)));
+        }
+#endif
+        for (; x < width; x++)
+        {
+            elements[x] = tensor_float_to_half(values[x] * gain + offset);
+        }
+    }
+}
+
+// Reads one image row into channel_count planes of plane_stride floats
+static void tensor_load_row(tensor_context_t *context, int y, float *planes, int plane_stride)
+{
+    const uint8_t *row = context->image_data + (size_t)y * (size_t)context->image_stride;
+    if (context->channel_count == 3)
+    {
+        tensor_load_row_bgra(row, context->config.image_width, planes, plane_stride, context->simd_level);
+    }
+    else
+    {
+        tensor_load_row_16((const uint16_t *)(const void *)row,
+                           context->config.image_width,
+                           planes,
+                           context->simd_level);
+    }
+}
+
+static int tensor_band_worker(void *param)
+{
+    tensor_band_t *band = (tensor_band_t *)param;
+    tensor_context_t *context = band->context;
+    int image_width = context->config.image_width;
+    int tensor_width = context->config.tensor_width;
+    size_t element_size = context->config.data_type == K4A_TENSOR_DATA_TYPE_FLOAT32 ? sizeof(float) : sizeof(uint16_t);
+    size_t plane_size = (size_t)tensor_width * (size_t)context->config.tensor_height * element_size;
+
+    float *first_row = band->scratch;
+    float *second_row = first_row + context->channel_count * image_width;
+    float *resized = second_row + context->channel_count * image_width;
+
+    for (int y = band->first_row; y < band->last_row; y++)
+    {
+        const float *values = first_row;
+        int plane_stride = image_width;
+        if (!context->resize)
+        {
+            tensor_load_row(context, y, first_row, image_width);
+        }
+        else
+        {
+            const tensor_sample_t *row = &context->rows[y];
+            tensor_load_row(context, row->first, first_row, image_width);
+
+            // Blend the two image rows first, then sample the columns of the blended row
+            if (!context->nearest && row->weight > 0.f)
+            {
+                tensor_load_row(context, row->second, second_row, image_width);
+                for (int i = 0; i < context->channel_count * image_width; i++)
+                {
+                    first_row[i] += (second_row[i] - first_row[i]) * row->weight;
+                }
+            }
+
+            for (int c = 0; c < context->channel_count; c++)
+            {
+                const float *source = first_row + c * image_width;
+                float *destination = resized + c * tensor_width;
+                for (int x = 0; x < tensor_width; x++)
+                {
+                    const tensor_sample_t *column = &context->columns[x];
+                    destination[x] = source[column->first] +
+                                     (source[column->second] - source[column->first]) * column->weight;
+                }
+            }
+            values = resized;
+            plane_stride = tensor_width;
+        }
+
+        for (int c = 0; c < context->channel_count; c++)
+        {
+            uint8_t *output = context->tensor + (size_t)c * plane_size +
+                              (size_t)y * (size_t)tensor_width * element_size;
+            tensor_store_row(values + context->plane[c] * plane_stride,
+                             tensor_width,
+                             context->gain[c],
+                             context->offset[c],
+                             context->config.data_type,
+                             output,
+                             context->simd_level);
+        }
+    }
+    return 0;
+}
+
+k4a_result_t tensor_converter_create(const k4a_tensor_configuration_t *config,
+                                     uint32_t thread_count,
+                                     k4a_tensor_converter_t *converter_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, converter_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > TENSOR_MAX_THREAD_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        config->format != K4A_IMAGE_FORMAT_COLOR_BGRA32 &&
+                            config->format != K4A_IMAGE_FORMAT_DEPTH16 && config->format != K4A_IMAGE_FORMAT_IR16);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        config->data_type != K4A_TENSOR_DATA_TYPE_FLOAT32 &&
+                            config->data_type != K4A_TENSOR_DATA_TYPE_FLOAT16);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config->image_width <= 0 || config->image_height <= 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config->tensor_width <= 0 || config->tensor_height <= 0);
+
+    int channel_count = config->format == K4A_IMAGE_FORMAT_COLOR_BGRA32 ? 3 : 1;
+    for (int c = 0; c < channel_count; c++)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !(config->std[c] != 0.f));
+    }
+
+    tensor_context_t *context = k4a_tensor_converter_t_create(converter_handle);
+    if (context == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    context->config = *config;
+    context->channel_count = channel_count;
+    context->simd_level = simd_get_level();
+    context->bytes_per_pixel = channel_count == 3 ? 4 * (int)sizeof(uint8_t) : (int)sizeof(uint16_t);
+    context->tensor_size = (size_t)channel_count * (size_t)config->tensor_width * (size_t)config->tensor_height *
+                           (config->data_type == K4A_TENSOR_DATA_TYPE_FLOAT32 ? sizeof(float) : sizeof(uint16_t));
+    for (int c = 0; c < channel_count; c++)
+    {
+        context->gain[c] = config->scale / config->std[c];
+        context->offset[c] = -config->mean[c] / config->std[c];
+
+        // The planes of a BGRA row are in B, G, R order
+        context->plane[c] = channel_count == 3 && config->rgb ? 2 - c : c;
+    }
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    context->resize = config->tensor_width != config->image_width || config->tensor_height != config->image_height;
+    if (context->resize)
+    {
+        // Depth is never blended, so that pixels without depth do not pull their neighbors towards 0
+        context->nearest = config->format == K4A_IMAGE_FORMAT_DEPTH16;
+        context->columns = (tensor_sample_t *)malloc((size_t)config->tensor_width * sizeof(tensor_sample_t));
+        context->rows = (tensor_sample_t *)malloc((size_t)config->tensor_height * sizeof(tensor_sample_t));
+        result = K4A_RESULT_FROM_BOOL(context->columns != NULL && context->rows != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            tensor_fill_samples(config->image_width, config->tensor_width, context->nearest, context->columns);
+            tensor_fill_samples(config->image_height, config->tensor_height, context->nearest, context->rows);
+        }
+    }
+
+    context->band_count = thread_count > 1 ? thread_count : 1;
+    if (context->band_count > (uint32_t)config->tensor_height)
+    {
+        context->band_count = (uint32_t)config->tensor_height;
+    }
+
+    size_t scratch_count = (size_t)channel_count * (2 * (size_t)config->image_width + (size_t)config->tensor_width);
+    for (uint32_t i = 0; i < context->band_count && K4A_SUCCEEDED(result); i++)
+    {
+        context->bands[i].context = context;
+        context->bands[i].first_row = (int)((uint32_t)config->tensor_height * i / context->band_count);
+        context->bands[i].last_row = (int)((uint32_t)config->tensor_height * (i + 1) / context->band_count);
+        context->bands[i].scratch = (float *)malloc(scratch_count * sizeof(float));
+        result = K4A_RESULT_FROM_BOOL(context->bands[i].scratch != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result) && context->band_count > 1)
+    {
+        result = TRACE_CALL(threadpool_acquire());
+        context->threadpool_acquired = K4A_SUCCEEDED(result);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        tensor_converter_destroy(*converter_handle);
+        *converter_handle = NULL;
+    }
+    return result;
+}
+
+void tensor_converter_destroy(k4a_tensor_converter_t converter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_tensor_converter_t, converter_handle);
+    tensor_context_t *context = k4a_tensor_converter_t_get_context(converter_handle);
+
+    if (context->threadpool_acquired)
+    {
+        threadpool_release();
+    }
+    for (uint32_t i = 0; i < context->band_count; i++)
+    {
+        free(context->bands[i].scratch);
+    }
+    free(context->columns);
+    free(context->rows);
+    k4a_tensor_converter_t_destroy(converter_handle);
+}
+
+size_t tensor_converter_get_size(k4a_tensor_converter_t converter_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_tensor_converter_t, converter_handle);
+    tensor_context_t *context = k4a_tensor_converter_t_get_context(converter_handle);
+    return context->tensor_size;
+}
+
+k4a_result_t tensor_converter_convert(k4a_tensor_converter_t converter_handle,
+                                      const uint8_t *image_data,
+                                      const k4a_transformation_image_descriptor_t *image_descriptor,
+                                      void *tensor,
+                                      size_t tensor_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_tensor_converter_t, converter_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image_data == NULL || image_descriptor == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, tensor == NULL);
+    tensor_context_t *context = k4a_tensor_converter_t_get_context(converter_handle);
+
+    if (image_descriptor->format != context->config.format ||
+        image_descriptor->width_pixels != context->config.image_width ||
+        image_descriptor->height_pixels != context->config.image_height ||
+        image_descriptor->stride_bytes < context->config.image_width * context->bytes_per_pixel)
+    {
+        LOG_ERROR("Image of %dx%d and format %d does not match the configured %dx%d and format %d.",
+                  image_descriptor->width_pixels,
+                  image_descriptor->height_pixels,
+                  image_descriptor->format,
+                  context->config.image_width,
+                  context->config.image_height,
+                  context->config.format);
+        return K4A_RESULT_FAILED;
+    }
+    if (tensor_size < context->tensor_size)
+    {
+        LOG_ERROR("Tensor of %llu bytes is smaller than the %llu bytes of the converted image.",
+                  (unsigned long long)tensor_size,
+                  (unsigned long long)context->tensor_size);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->image_data = image_data;
+    context->image_stride = image_descriptor->stride_bytes;
+    context->tensor = (uint8_t *)tensor;
+
+    if (context->band_count == 1)
+    {
+        (void)tensor_band_worker(&context->bands[0]);
+    }
+    else
+    {
+        threadpool_run_tasks(tensor_band_worker, context->bands, sizeof(tensor_band_t), context->band_count);
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
@@ -6,6 +6,7 @@
 
 // Dependent libraries
 #include <k4ainternal/deloader.h>
+#include <k4ainternal/threadpool.h>
 #include <azure_c_shared_utility/threadapi.h>
 #include <azure_c_shared_utility/condition.h>
 #include <azure_c_shared_utility/lock.h>
@@ -21,27 +22,17 @@ typedef struct _tewrapper_context_t
     k4a_transform_engine_context_t *transform_engine;
 
     THREAD_HANDLE thread;
-    LOCK_HANDLE main_lock;
-    COND_HANDLE main_condition;
-    LOCK_HANDLE worker_lock;
-    COND_HANDLE worker_condition;
+    LOCK_HANDLE lock;
+    COND_HANDLE work_condition;       // Signaled when a frame is queued or the thread has to stop
+    COND_HANDLE completion_condition; // Signaled when the thread started or completed frames
     volatile bool thread_started;
     volatile bool thread_stop;
-    volatile bool worker_locked;
+    bool thread_exited; // The thread stopped taking frames, after a failure or when stopped
     k4a_result_t thread_start_result;
-    k4a_result_t thread_processing_result;
-
-    k4a_transform_engine_type_t type;
-    const void *depth_image_data;
-    size_t depth_image_size;
-    const void *image2_data;
-    size_t image2_size;
-    void *transformed_image_data;
-    size_t transformed_image_size;
-    void *transformed_image2_data;
-    size_t transformed_image2_size;
-    k4a_transform_engine_interpolation_t interpolation;
-    uint32_t invalid_value;
+
+    // Frames waiting for the transform engine thread, in submission order
+    tewrapper_frame_t *queue_head;
+    tewrapper_frame_t *queue_tail;
 
 } tewrapper_context_t;
 
@@ -77,119 +68,264 @@ static void transform_engine_stop_helper(tewrapper_context_t *tewrapper)
     }
 }
 
+static k4a_result_t transform_engine_process_frame(tewrapper_context_t *tewrapper, const tewrapper_frame_t *frame)
+{
+    if (frame->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR ||
+        frame->type == K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH)
+    {
+        size_t transform_engine_output_buffer_size =
+            deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine, frame->type);
+        if (frame->transformed_image_size != transform_engine_output_buffer_size)
+        {
+            LOG_ERROR("Transform engine output buffer size not expected. Expect: %zu, Actual: %zu.",
+                      transform_engine_output_buffer_size,
+                      frame->transformed_image_size);
+            return K4A_RESULT_FAILED;
+        }
+    }
+    else if (frame->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM8_TO_COLOR ||
+             frame->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM16_TO_COLOR)
+    {
+        size_t transform_engine_output_buffer_size =
+            deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine,
+                                                            K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR);
+        if (frame->transformed_image_size != transform_engine_output_buffer_size)
+        {
+            LOG_ERROR("Transform engine output buffer size not expected. Expect: %zu, Actual: %zu.",
+                      transform_engine_output_buffer_size,
+                      frame->transformed_image_size);
+            return K4A_RESULT_FAILED;
+        }
+
+        size_t transform_engine_output_buffer2_size =
+            deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine, frame->type);
+        if (frame->transformed_image2_size != transform_engine_output_buffer2_size)
+        {
+            LOG_ERROR("Transform engine output buffer 2 size not expected. Expect: %zu, Actual: %zu.",
+                      transform_engine_output_buffer2_size,
+                      frame->transformed_image2_size);
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    k4a_depth_engine_result_code_t teresult = deloader_transform_engine_process_frame(tewrapper->transform_engine,
+                                                                                      frame->type,
+                                                                                      frame->depth_image_data,
+                                                                                      frame->depth_image_size,
+                                                                                      frame->image2_data,
+                                                                                      frame->image2_size,
+                                                                                      frame->transformed_image_data,
+                                                                                      frame->transformed_image_size,
+                                                                                      frame->transformed_image2_data,
+                                                                                      frame->transformed_image2_size,
+                                                                                      frame->interpolation,
+                                                                                      frame->invalid_value);
+    if (teresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_WAIT_PROCESSING_COMPLETE_FAILED ||
+        teresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_TIMEOUT)
+    {
+        LOG_ERROR("Timeout during depth engine process frame.", 0);
+        LOG_ERROR("SDK should be restarted since it looks like GPU has encountered an unrecoverable error.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    else if (teresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        LOG_ERROR("Transform engine process frame failed with error code: %d.", teresult);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t transform_engine_process_frame_gpu(tewrapper_context_t *tewrapper, tewrapper_frame_t *frame)
+{
+    k4a_depth_engine_result_code_t teresult;
+    if (frame->depth_gpu_input)
+    {
+        teresult = deloader_transform_engine_process_frame_gpu_input(tewrapper->transform_engine,
+                                                                     frame->type,
+                                                                     frame->depth_gpu_input_type,
+                                                                     frame->depth_gpu_input,
+                                                                     frame->image2_data,
+                                                                     frame->image2_size,
+                                                                     frame->interpolation,
+                                                                     frame->invalid_value,
+                                                                     frame->gpu_export_type,
+                                                                     &frame->gpu_output);
+    }
+    else
+    {
+        teresult = deloader_transform_engine_process_frame_gpu(tewrapper->transform_engine,
+                                                               frame->type,
+                                                               frame->depth_image_data,
+                                                               frame->depth_image_size,
+                                                               frame->image2_data,
+                                                               frame->image2_size,
+                                                               frame->interpolation,
+                                                               frame->invalid_value,
+                                                               frame->gpu_export_type,
+                                                               &frame->gpu_output);
+    }
+    if (teresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
+    {
+        LOG_ERROR("Transform engine GPU export of type %d failed with error code: %d.",
+                  frame->gpu_export_type,
+                  teresult);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
 static int transform_engine_thread(void *param)
 {
     tewrapper_context_t *tewrapper = (tewrapper_context_t *)param;
 
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
 
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_TRANSFORM_ENGINE);
+
     result = TRACE_CALL(transform_engine_start_helper(tewrapper));
 
     // The Start routine is blocked waiting for this thread to complete startup, so we signal it here and share our
     // startup status.
-    Lock(tewrapper->main_lock);
+    Lock(tewrapper->lock);
     tewrapper->thread_started = true;
     tewrapper->thread_start_result = result;
-    tewrapper->worker_locked = false;
-    Condition_Post(tewrapper->main_condition);
-    Unlock(tewrapper->main_lock);
+    Condition_Post(tewrapper->completion_condition);
 
-    while (result != K4A_RESULT_FAILED && tewrapper->thread_stop == false)
+    while (K4A_SUCCEEDED(result))
     {
-        // Waiting the main thread to request processing a frame
-        Lock(tewrapper->worker_lock);
-        tewrapper->worker_locked = true;
-        Condition_Post(tewrapper->main_condition);
-        int infinite_timeout = 0;
-        COND_RESULT cond_result = Condition_Wait(tewrapper->worker_condition, tewrapper->worker_lock, infinite_timeout);
-        result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
-
-        if (tewrapper->thread_stop == false)
+        while (tewrapper->queue_head == NULL && !tewrapper->thread_stop)
         {
-            if (K4A_SUCCEEDED(result))
+            int infinite_timeout = 0;
+            COND_RESULT cond_result = Condition_Wait(tewrapper->work_condition, tewrapper->lock, infinite_timeout);
+            result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
+            if (K4A_FAILED(result))
             {
-                if (tewrapper->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR ||
-                    tewrapper->type == K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH)
-                {
-                    size_t transform_engine_output_buffer_size =
-                        deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine, tewrapper->type);
-                    if (tewrapper->transformed_image_size != transform_engine_output_buffer_size)
-                    {
-                        LOG_ERROR("Transform engine output buffer size not expected. Expect: %d, Actual: %d.",
-                                  transform_engine_output_buffer_size,
-                                  tewrapper->transformed_image_size);
-                        result = K4A_RESULT_FAILED;
-                    }
-                }
-                else if (tewrapper->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM8_TO_COLOR ||
-                         tewrapper->type == K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM16_TO_COLOR)
-                {
-                    size_t transform_engine_output_buffer_size =
-                        deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine,
-                                                                        K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR);
-                    if (tewrapper->transformed_image_size != transform_engine_output_buffer_size)
-                    {
-                        LOG_ERROR("Transform engine output buffer size not expected. Expect: %d, Actual: %d.",
-                                  transform_engine_output_buffer_size,
-                                  tewrapper->transformed_image_size);
-                        result = K4A_RESULT_FAILED;
-                    }
-
-                    size_t transform_engine_output_buffer2_size =
-                        deloader_transform_engine_get_output_frame_size(tewrapper->transform_engine, tewrapper->type);
-                    if (tewrapper->transformed_image2_size != transform_engine_output_buffer2_size)
-                    {
-                        LOG_ERROR("Transform engine output buffer 2 size not expected. Expect: %d, Actual: %d.",
-                                  transform_engine_output_buffer2_size,
-                                  tewrapper->transformed_image2_size);
-                        result = K4A_RESULT_FAILED;
-                    }
-                }
+                break;
             }
+        }
+        if (K4A_FAILED(result) || tewrapper->thread_stop)
+        {
+            break;
+        }
 
-            if (K4A_SUCCEEDED(result))
-            {
-                k4a_depth_engine_result_code_t teresult =
-                    deloader_transform_engine_process_frame(tewrapper->transform_engine,
-                                                            tewrapper->type,
-                                                            tewrapper->depth_image_data,
-                                                            tewrapper->depth_image_size,
-                                                            tewrapper->image2_data,
-                                                            tewrapper->image2_size,
-                                                            tewrapper->transformed_image_data,
-                                                            tewrapper->transformed_image_size,
-                                                            tewrapper->transformed_image2_data,
-                                                            tewrapper->transformed_image2_size,
-                                                            tewrapper->interpolation,
-                                                            tewrapper->invalid_value);
-                if (teresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_WAIT_PROCESSING_COMPLETE_FAILED ||
-                    teresult == K4A_DEPTH_ENGINE_RESULT_FATAL_ERROR_GPU_TIMEOUT)
-                {
-                    LOG_ERROR("Timeout during depth engine process frame.", 0);
-                    LOG_ERROR("SDK should be restarted since it looks like GPU has encountered an unrecoverable error.",
-                              0);
-                    result = K4A_RESULT_FAILED;
-                }
-                else if (teresult != K4A_DEPTH_ENGINE_RESULT_SUCCEEDED)
-                {
-                    LOG_ERROR("Transform engine process frame failed with error code: %d.", teresult);
-                    result = K4A_RESULT_FAILED;
-                }
-            }
+        tewrapper_frame_t *frame = tewrapper->queue_head;
+        tewrapper->queue_head = frame->next;
+        if (tewrapper->queue_head == NULL)
+        {
+            tewrapper->queue_tail = NULL;
         }
 
-        // Notify the API thread that transform engine thread completed a frame processing
-        tewrapper->thread_processing_result = result;
-        Condition_Post(tewrapper->main_condition);
-        Unlock(tewrapper->worker_lock);
-        tewrapper->worker_locked = false;
+        // Callers keep queueing frames while the transform engine processes this one
+        Unlock(tewrapper->lock);
+        k4a_result_t frame_result = K4A_RESULT_SUCCEEDED;
+        switch (frame->operation)
+        {
+        case TEWRAPPER_OPERATION_PROCESS:
+            frame_result = transform_engine_process_frame(tewrapper, frame);
+            result = frame_result;
+            break;
+
+        case TEWRAPPER_OPERATION_PROCESS_GPU:
+            // An export type the plugin can't do on this GPU fails the frame but leaves the engine usable
+            frame_result = transform_engine_process_frame_gpu(tewrapper, frame);
+            break;
+
+        case TEWRAPPER_OPERATION_RELEASE_GPU:
+            deloader_transform_engine_release_gpu_output(tewrapper->transform_engine,
+                                                         frame->gpu_export_type,
+                                                         &frame->gpu_output);
+            break;
+
+        default:
+            frame_result = K4A_RESULT_FAILED;
+            break;
+        }
+        Lock(tewrapper->lock);
+
+        frame->result = frame_result;
+        frame->completed = true;
+        Condition_Post(tewrapper->completion_condition);
     }
 
+    // A failed transform engine takes no more frames, the queued ones fail
+    tewrapper->thread_exited = true;
+    for (tewrapper_frame_t *frame = tewrapper->queue_head; frame != NULL; frame = frame->next)
+    {
+        frame->result = K4A_RESULT_FAILED;
+        frame->completed = true;
+    }
+    tewrapper->queue_head = NULL;
+    tewrapper->queue_tail = NULL;
+    Condition_Post(tewrapper->completion_condition);
+    Unlock(tewrapper->lock);
+
     transform_engine_stop_helper(tewrapper);
 
     return (int)result;
 }
 
+k4a_result_t tewrapper_submit_frame(tewrapper_t tewrapper_handle, tewrapper_frame_t *frame)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, tewrapper_t, tewrapper_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, frame == NULL);
+    tewrapper_context_t *tewrapper = tewrapper_t_get_context(tewrapper_handle);
+
+    frame->next = NULL;
+    frame->completed = false;
+    frame->result = K4A_RESULT_FAILED;
+
+    Lock(tewrapper->lock);
+    if (tewrapper->thread_exited)
+    {
+        Unlock(tewrapper->lock);
+        LOG_ERROR("Transform Engine thread is not running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (tewrapper->queue_tail)
+    {
+        tewrapper->queue_tail->next = frame;
+    }
+    else
+    {
+        tewrapper->queue_head = frame;
+    }
+    tewrapper->queue_tail = frame;
+    Condition_Post(tewrapper->work_condition);
+    Unlock(tewrapper->lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t tewrapper_wait_frame(tewrapper_t tewrapper_handle, tewrapper_frame_t *frame)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, tewrapper_t, tewrapper_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, frame == NULL);
+    tewrapper_context_t *tewrapper = tewrapper_t_get_context(tewrapper_handle);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    // Completions of all frames share the condition, each waiter checks its own frame
+    Lock(tewrapper->lock);
+    while (!frame->completed && K4A_SUCCEEDED(result))
+    {
+        int infinite_timeout = 0;
+        COND_RESULT cond_result = Condition_Wait(tewrapper->completion_condition, tewrapper->lock, infinite_timeout);
+        result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        result = frame->result;
+    }
+    Unlock(tewrapper->lock);
+
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("Transform Engine thread failed to process", 0);
+    }
+    return result;
+}
+
 k4a_result_t tewrapper_process_frame(tewrapper_t tewrapper_handle,
                                      k4a_transform_engine_type_t type,
                                      const void *depth_image_data,
@@ -203,55 +339,115 @@ k4a_result_t tewrapper_process_frame(tewrapper_t tewrapper_handle,
                                      k4a_transform_engine_interpolation_t interpolation,
                                      uint32_t invalid_value)
 {
-    tewrapper_context_t *tewrapper = tewrapper_t_get_context(tewrapper_handle);
+    tewrapper_frame_t frame = { 0 };
+    frame.operation = TEWRAPPER_OPERATION_PROCESS;
+    frame.type = type;
+    frame.depth_image_data = depth_image_data;
+    frame.depth_image_size = depth_image_size;
+    frame.image2_data = image2_data;
+    frame.image2_size = image2_size;
+    frame.transformed_image_data = transformed_image_data;
+    frame.transformed_image_size = transformed_image_size;
+    frame.transformed_image2_data = transformed_image2_data;
+    frame.transformed_image2_size = transformed_image2_size;
+    frame.interpolation = interpolation;
+    frame.invalid_value = invalid_value;
+
+    if (K4A_FAILED(TRACE_CALL(tewrapper_submit_frame(tewrapper_handle, &frame))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    return TRACE_CALL(tewrapper_wait_frame(tewrapper_handle, &frame));
+}
 
-    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+static k4a_result_t tewrapper_export_frame(tewrapper_t tewrapper_handle,
+                                           tewrapper_frame_t *frame,
+                                           k4a_transform_engine_gpu_output_t *output)
+{
+    if (K4A_FAILED(TRACE_CALL(tewrapper_submit_frame(tewrapper_handle, frame))) ||
+        K4A_FAILED(TRACE_CALL(tewrapper_wait_frame(tewrapper_handle, frame))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    *output = frame->gpu_output;
+    return K4A_RESULT_SUCCEEDED;
+}
 
-    Lock(tewrapper->main_lock);
+k4a_result_t tewrapper_process_frame_gpu(tewrapper_t tewrapper_handle,
+                                         k4a_transform_engine_type_t type,
+                                         const void *depth_image_data,
+                                         size_t depth_image_size,
+                                         const void *image2_data,
+                                         size_t image2_size,
+                                         k4a_transform_engine_gpu_export_t export_type,
+                                         k4a_transform_engine_gpu_output_t *output)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, output == NULL);
 
-    // Ensure the worker thread loop to acquire the worker lock before this function acquires the worker lock to avoid
-    // dead lock
-    if (!tewrapper->worker_locked)
+    if (!deloader_transform_engine_supports_gpu_export())
     {
-        int infinite_timeout = 0;
-        COND_RESULT cond_result = Condition_Wait(tewrapper->main_condition, tewrapper->main_lock, infinite_timeout);
-        result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
+        LOG_ERROR("The depth engine plugin does not export transform engine outputs as GPU resources.", 0);
+        return K4A_RESULT_FAILED;
     }
 
-    if (K4A_SUCCEEDED(result))
-    {
-        // Notify the transform engine thread to process a frame
-        Lock(tewrapper->worker_lock);
-        tewrapper->type = type;
-        tewrapper->depth_image_data = depth_image_data;
-        tewrapper->depth_image_size = depth_image_size;
-        tewrapper->image2_data = image2_data;
-        tewrapper->image2_size = image2_size;
-        tewrapper->transformed_image_data = transformed_image_data;
-        tewrapper->transformed_image_size = transformed_image_size;
-        tewrapper->transformed_image2_data = transformed_image2_data;
-        tewrapper->transformed_image2_size = transformed_image2_size;
-        tewrapper->interpolation = interpolation;
-        tewrapper->invalid_value = invalid_value;
-        Condition_Post(tewrapper->worker_condition);
-
-        // Waiting the transform engine thread to finish processing
-        int infinite_timeout = 0;
-        COND_RESULT cond_result = Condition_Wait(tewrapper->main_condition, tewrapper->worker_lock, infinite_timeout);
-        result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
+    tewrapper_frame_t frame = { 0 };
+    frame.operation = TEWRAPPER_OPERATION_PROCESS_GPU;
+    frame.type = type;
+    frame.depth_image_data = depth_image_data;
+    frame.depth_image_size = depth_image_size;
+    frame.image2_data = image2_data;
+    frame.image2_size = image2_size;
+    frame.interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
+    frame.gpu_export_type = export_type;
+    return tewrapper_export_frame(tewrapper_handle, &frame, output);
+}
 
-        if (K4A_SUCCEEDED(result) && K4A_FAILED(tewrapper->thread_processing_result))
-        {
-            LOG_ERROR("Transform Engine thread failed to process", 0);
-            result = tewrapper->thread_processing_result;
-        }
+k4a_result_t tewrapper_process_frame_gpu_input(tewrapper_t tewrapper_handle,
+                                               k4a_transform_engine_type_t type,
+                                               k4a_transform_engine_gpu_export_t depth_export_type,
+                                               const k4a_transform_engine_gpu_output_t *depth_input,
+                                               const void *image2_data,
+                                               size_t image2_size,
+                                               k4a_transform_engine_gpu_export_t export_type,
+                                               k4a_transform_engine_gpu_output_t *output)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depth_input == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, output == NULL);
 
-        Unlock(tewrapper->worker_lock);
+    if (!deloader_transform_engine_supports_gpu_input())
+    {
+        LOG_ERROR("The depth engine plugin does not read transform engine inputs from GPU resources.", 0);
+        return K4A_RESULT_FAILED;
     }
 
-    Unlock(tewrapper->main_lock);
+    tewrapper_frame_t frame = { 0 };
+    frame.operation = TEWRAPPER_OPERATION_PROCESS_GPU;
+    frame.type = type;
+    frame.depth_gpu_input = depth_input;
+    frame.depth_gpu_input_type = depth_export_type;
+    frame.image2_data = image2_data;
+    frame.image2_size = image2_size;
+    frame.interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
+    frame.gpu_export_type = export_type;
+    return tewrapper_export_frame(tewrapper_handle, &frame, output);
+}
 
-    return result;
+k4a_result_t tewrapper_release_gpu_output(tewrapper_t tewrapper_handle,
+                                          k4a_transform_engine_gpu_export_t export_type,
+                                          const k4a_transform_engine_gpu_output_t *output)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, output == NULL);
+
+    tewrapper_frame_t frame = { 0 };
+    frame.operation = TEWRAPPER_OPERATION_RELEASE_GPU;
+    frame.gpu_export_type = export_type;
+    frame.gpu_output = *output;
+
+    if (K4A_FAILED(TRACE_CALL(tewrapper_submit_frame(tewrapper_handle, &frame))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    return TRACE_CALL(tewrapper_wait_frame(tewrapper_handle, &frame));
 }
 
 tewrapper_t tewrapper_create(k4a_transform_engine_calibration_t *transform_engine_calibration)
@@ -264,24 +460,18 @@ tewrapper_t tewrapper_create(k4a_transform_engine_calibration_t *transform_engin
     tewrapper->transform_engine_calibration = transform_engine_calibration;
     tewrapper->thread_start_result = K4A_RESULT_FAILED;
 
-    tewrapper->main_lock = Lock_Init();
-    k4a_result_t result = K4A_RESULT_FROM_BOOL(tewrapper->main_lock != NULL);
-    if (K4A_SUCCEEDED(result))
-    {
-        tewrapper->worker_lock = Lock_Init();
-        result = K4A_RESULT_FROM_BOOL(tewrapper->worker_lock != NULL);
-    }
-
+    tewrapper->lock = Lock_Init();
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(tewrapper->lock != NULL);
     if (K4A_SUCCEEDED(result))
     {
-        tewrapper->main_condition = Condition_Init();
-        result = K4A_RESULT_FROM_BOOL(tewrapper->main_condition != NULL);
+        tewrapper->work_condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(tewrapper->work_condition != NULL);
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        tewrapper->worker_condition = Condition_Init();
-        result = K4A_RESULT_FROM_BOOL(tewrapper->worker_condition != NULL);
+        tewrapper->completion_condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(tewrapper->completion_condition != NULL);
     }
 
     // Start transform engine thread
@@ -296,13 +486,13 @@ tewrapper_t tewrapper_create(k4a_transform_engine_calibration_t *transform_engin
 
         if (K4A_SUCCEEDED(result))
         {
-            Lock(tewrapper->main_lock);
+            Lock(tewrapper->lock);
             locked = true;
-            if (!tewrapper->thread_started)
+            while (!tewrapper->thread_started && K4A_SUCCEEDED(result))
             {
                 int infinite_timeout = 0;
-                COND_RESULT cond_result = Condition_Wait(tewrapper->main_condition,
-                                                         tewrapper->main_lock,
+                COND_RESULT cond_result = Condition_Wait(tewrapper->completion_condition,
+                                                         tewrapper->lock,
                                                          infinite_timeout);
                 result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
             }
@@ -316,7 +506,7 @@ tewrapper_t tewrapper_create(k4a_transform_engine_calibration_t *transform_engin
 
         if (locked)
         {
-            Unlock(tewrapper->main_lock);
+            Unlock(tewrapper->lock);
             locked = false;
         }
     }
@@ -335,16 +525,17 @@ void tewrapper_destroy(tewrapper_t tewrapper_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, tewrapper_t, tewrapper_handle);
     tewrapper_context_t *tewrapper = tewrapper_t_get_context(tewrapper_handle);
 
-    // Notify the transform engine thread to stop
-    Lock(tewrapper->worker_lock);
-    tewrapper->thread_stop = true;
-    Condition_Post(tewrapper->worker_condition);
-    Unlock(tewrapper->worker_lock);
-
-    Lock(tewrapper->main_lock);
-    THREAD_HANDLE thread = tewrapper->thread;
-    tewrapper->thread = NULL;
-    Unlock(tewrapper->main_lock);
+    // Notify the transform engine thread to stop, frames still queued fail
+    THREAD_HANDLE thread = NULL;
+    if (tewrapper->lock)
+    {
+        Lock(tewrapper->lock);
+        tewrapper->thread_stop = true;
+        Condition_Post(tewrapper->work_condition);
+        thread = tewrapper->thread;
+        tewrapper->thread = NULL;
+        Unlock(tewrapper->lock);
+    }
 
     if (thread)
     {
@@ -353,24 +544,19 @@ void tewrapper_destroy(tewrapper_t tewrapper_handle)
         (void)K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK); // Trace the issue, but we don't return a failure
     }
 
-    if (tewrapper->main_condition)
-    {
-        Condition_Deinit(tewrapper->main_condition);
-    }
-
-    if (tewrapper->worker_condition)
+    if (tewrapper->work_condition)
     {
-        Condition_Deinit(tewrapper->worker_condition);
+        Condition_Deinit(tewrapper->work_condition);
     }
 
-    if (tewrapper->main_lock)
+    if (tewrapper->completion_condition)
     {
-        Lock_Deinit(tewrapper->main_lock);
+        Condition_Deinit(tewrapper->completion_condition);
     }
 
-    if (tewrapper->worker_lock)
+    if (tewrapper->lock)
     {
-        Lock_Deinit(tewrapper->worker_lock);
+        Lock_Deinit(tewrapper->lock);
     }
 
     tewrapper_t_destroy(tewrapper_handle);
@@ -0,0 +1,421 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifdef __linux__
+#define _GNU_SOURCE // pthread_setaffinity_np() and CPU_SET() in pthread.h and sched.h
+#endif
+
+
+// This library
+#include <k4ainternal/threadpool.h>
+
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/logging.h>
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <avrt.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+// On Linux, threads raised to K4A_THREAD_PRIORITY_HIGH get this nice value and threads raised to
+// K4A_THREAD_PRIORITY_REALTIME this SCHED_FIFO priority. The SCHED_FIFO priority stays below the kernel's interrupt
+// threads, which run at 50, so the USB controller interrupts are still serviced before the SDK threads.
+#define THREADPOOL_HIGH_PRIORITY_NICE (-10)
+#define THREADPOOL_REALTIME_PRIORITY (10)
+
+// A set of tasks submitted by threadpool_run_tasks(). Jobs live on the stack of the submitting thread, which does not
+// return before every task of the job completed.
+typedef struct _threadpool_job_t
+{
+    THREAD_START_FUNC task_function;
+    uint8_t *tasks;
+    size_t task_size;
+    uint32_t task_count;
+    uint32_t next_task;       // Next task to be claimed by a thread
+    uint32_t remaining_tasks; // Tasks not completed yet
+    struct _threadpool_job_t *next;
+} threadpool_job_t;
+
+// Process wide state of the pool
+typedef struct
+{
+    LOCK_HANDLE lock;
+    COND_HANDLE work_condition; // Signaled when a job is queued or the workers have to stop
+    COND_HANDLE done_condition; // Signaled when the last task of a job completed
+
+    // Access to these members may only occur while holding lock
+    uint64_t affinity[K4A_THREAD_ROLE_NUM];
+    k4a_thread_priority_t priority[K4A_THREAD_ROLE_NUM];
+    uint32_t configured_worker_count;
+    uint32_t ref_count;
+    uint32_t worker_count;
+    THREAD_HANDLE workers[THREADPOOL_MAX_WORKERS];
+    uint32_t generation; // Incremented to stop the workers started before, so a restart does not wait for them
+    threadpool_job_t *job_head; // Jobs with tasks left to claim
+    threadpool_job_t *job_tail;
+} threadpool_global_t;
+
+static void threadpool_global_init(threadpool_global_t *global);
+
+// Creates a function called threadpool_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(threadpool_global_t, threadpool_global_init);
+
+static void threadpool_global_init(threadpool_global_t *global)
+{
+    // All other members are initialized to zero
+    global->lock = Lock_Init();
+    global->work_condition = Condition_Init();
+    global->done_condition = Condition_Init();
+}
+
+static uint32_t threadpool_default_worker_count(void)
+{
+    long cpu_count = 1;
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    cpu_count = (long)system_info.dwNumberOfProcessors;
+#elif defined(__linux__)
+    cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpu_count <= 1)
+    {
+        return 0;
+    }
+    return (uint32_t)(cpu_count - 1 > THREADPOOL_MAX_WORKERS ? THREADPOOL_MAX_WORKERS : cpu_count - 1);
+}
+
+k4a_result_t threadpool_set_affinity(k4a_thread_role_t role, uint64_t cpu_mask)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, role < K4A_THREAD_ROLE_USB || role >= K4A_THREAD_ROLE_NUM);
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+    Lock(global->lock);
+    global->affinity[role] = cpu_mask;
+    Unlock(global->lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t threadpool_set_priority(k4a_thread_role_t role, k4a_thread_priority_t priority)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, role < K4A_THREAD_ROLE_USB || role >= K4A_THREAD_ROLE_NUM);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        priority < K4A_THREAD_PRIORITY_DEFAULT || priority > K4A_THREAD_PRIORITY_REALTIME);
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+    Lock(global->lock);
+    global->priority[role] = priority;
+    Unlock(global->lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static void threadpool_apply_priority(k4a_thread_role_t role, k4a_thread_priority_t priority)
+{
+    bool applied = false;
+#ifdef _WIN32
+    if (priority == K4A_THREAD_PRIORITY_HIGH)
+    {
+        applied = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) != 0;
+    }
+    else
+    {
+        // MMCSS boosts the thread for as long as it is registered; the registration ends when the thread exits
+        DWORD task_index = 0;
+        HANDLE task = AvSetMmThreadCharacteristicsA("Capture", &task_index);
+        applied = task != NULL && AvSetMmThreadPriority(task, AVRT_PRIORITY_HIGH) != 0;
+    }
+#elif defined(__linux__)
+    if (priority == K4A_THREAD_PRIORITY_HIGH)
+    {
+        // On Linux the nice value is per thread when set for the thread id
+        applied = setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), THREADPOOL_HIGH_PRIORITY_NICE) == 0;
+    }
+    else
+    {
+        struct sched_param param = { 0 };
+        param.sched_priority = THREADPOOL_REALTIME_PRIORITY;
+        applied = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+#endif
+
+    if (!applied)
+    {
+        LOG_WARNING("Failed to raise priority of thread of role %d to %d", role, priority);
+    }
+}
+
+void threadpool_apply_thread_role(k4a_thread_role_t role)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, role < K4A_THREAD_ROLE_USB || role >= K4A_THREAD_ROLE_NUM);
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(VOID_VALUE, global->lock == NULL);
+
+    Lock(global->lock);
+    uint64_t cpu_mask = global->affinity[role];
+    k4a_thread_priority_t priority = global->priority[role];
+    Unlock(global->lock);
+
+    if (priority != K4A_THREAD_PRIORITY_DEFAULT)
+    {
+        threadpool_apply_priority(role, priority);
+    }
+
+    if (cpu_mask == 0)
+    {
+        return;
+    }
+
+    bool pinned = false;
+#ifdef _WIN32
+    pinned = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)cpu_mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu = 0; cpu < 64; cpu++)
+    {
+        if (cpu_mask & (1ULL << cpu))
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#endif
+
+    if (!pinned)
+    {
+        LOG_WARNING("Failed to pin thread of role %d to CPU mask 0x%llx", role, (unsigned long long)cpu_mask);
+    }
+}
+
+k4a_result_t threadpool_set_worker_count(uint32_t worker_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, worker_count > THREADPOOL_MAX_WORKERS);
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, global->lock == NULL);
+
+    Lock(global->lock);
+    global->configured_worker_count = worker_count;
+    Unlock(global->lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Claims the next task of the first queued job. Called with global->lock held.
+static threadpool_job_t *threadpool_claim_task(threadpool_global_t *global, threadpool_job_t *job, uint32_t *task)
+{
+    if (job == NULL)
+    {
+        job = global->job_head;
+    }
+    if (job == NULL || job->next_task >= job->task_count)
+    {
+        return NULL;
+    }
+
+    *task = job->next_task++;
+    if (job->next_task == job->task_count)
+    {
+        // Every task is claimed, the job leaves the list while its last tasks run. Jobs are only claimed from the
+        // head, except by their own submitter, so the job can be anywhere in the list.
+        threadpool_job_t **link = &global->job_head;
+        threadpool_job_t *previous = NULL;
+        while (*link != NULL && *link != job)
+        {
+            previous = *link;
+            link = &(*link)->next;
+        }
+        if (*link == job)
+        {
+            *link = job->next;
+            if (global->job_tail == job)
+            {
+                global->job_tail = previous;
+            }
+        }
+        job->next = NULL;
+    }
+    return job;
+}
+
+// Runs a claimed task and completes it. Called with global->lock held, which is released while the task runs.
+static void threadpool_run_task(threadpool_global_t *global, threadpool_job_t *job, uint32_t task)
+{
+    Unlock(global->lock);
+    (void)job->task_function(job->tasks + (size_t)task * job->task_size);
+    Lock(global->lock);
+
+    job->remaining_tasks--;
+    if (job->remaining_tasks == 0)
+    {
+        Condition_Post(global->done_condition);
+    }
+}
+
+static int threadpool_worker_thread(void *param)
+{
+    threadpool_global_t *global = threadpool_global_t_get();
+    uint32_t generation = (uint32_t)(uintptr_t)param;
+
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_WORKER);
+
+    Lock(global->lock);
+    while (global->generation == generation)
+    {
+        uint32_t task;
+        threadpool_job_t *job = threadpool_claim_task(global, NULL, &task);
+        if (job == NULL)
+        {
+            (void)Condition_Wait(global->work_condition, global->lock, 0);
+            continue;
+        }
+        threadpool_run_task(global, job, task);
+    }
+    Unlock(global->lock);
+    return 0;
+}
+
+// Stops and joins the workers. Called with global->lock held, which is released while joining.
+static void threadpool_stop_workers(threadpool_global_t *global)
+{
+    THREAD_HANDLE workers[THREADPOOL_MAX_WORKERS];
+    uint32_t worker_count = global->worker_count;
+    memcpy(workers, global->workers, worker_count * sizeof(THREAD_HANDLE));
+    global->worker_count = 0;
+    global->generation++;
+    Condition_Post(global->work_condition);
+    Unlock(global->lock);
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        int thread_result;
+        THREADAPI_RESULT tresult = ThreadAPI_Join(workers[i], &thread_result);
+        (void)K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK); // Trace the issue, but we don't return a failure
+    }
+
+    Lock(global->lock);
+}
+
+k4a_result_t threadpool_acquire(void)
+{
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        global->lock == NULL || global->work_condition == NULL || global->done_condition == NULL);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(global->lock);
+    if (global->ref_count == 0)
+    {
+        uint32_t worker_count = global->configured_worker_count != 0 ? global->configured_worker_count :
+                                                                        threadpool_default_worker_count();
+        for (uint32_t i = 0; i < worker_count && K4A_SUCCEEDED(result); i++)
+        {
+            result = K4A_RESULT_FROM_BOOL(ThreadAPI_Create(&global->workers[i],
+                                                           threadpool_worker_thread,
+                                                           (void *)(uintptr_t)global->generation) == THREADAPI_OK);
+            if (K4A_SUCCEEDED(result))
+            {
+                global->worker_count++;
+            }
+        }
+
+        if (K4A_FAILED(result))
+        {
+            threadpool_stop_workers(global);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        global->ref_count++;
+    }
+    Unlock(global->lock);
+
+    return result;
+}
+
+void threadpool_release(void)
+{
+    threadpool_global_t *global = threadpool_global_t_get();
+    RETURN_VALUE_IF_ARG(VOID_VALUE, global->lock == NULL);
+
+    Lock(global->lock);
+    if (K4A_SUCCEEDED(K4A_RESULT_FROM_BOOL(global->ref_count > 0)))
+    {
+        global->ref_count--;
+        if (global->ref_count == 0)
+        {
+            threadpool_stop_workers(global);
+        }
+    }
+    Unlock(global->lock);
+}
+
+void threadpool_run_tasks(THREAD_START_FUNC task_function, void *tasks, size_t task_size, uint32_t task_count)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, task_function == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, tasks == NULL && task_count > 0);
+    threadpool_global_t *global = threadpool_global_t_get();
+
+    if (task_count == 0)
+    {
+        return;
+    }
+
+    if (task_count == 1 || global->lock == NULL || global->done_condition == NULL)
+    {
+        for (uint32_t i = 0; i < task_count; i++)
+        {
+            (void)task_function((uint8_t *)tasks + (size_t)i * task_size);
+        }
+        return;
+    }
+
+    threadpool_job_t job = { 0 };
+    job.task_function = task_function;
+    job.tasks = (uint8_t *)tasks;
+    job.task_size = task_size;
+    job.task_count = task_count;
+    job.remaining_tasks = task_count;
+
+    Lock(global->lock);
+    if (global->worker_count > 0)
+    {
+        if (global->job_tail != NULL)
+        {
+            global->job_tail->next = &job;
+        }
+        else
+        {
+            global->job_head = &job;
+        }
+        global->job_tail = &job;
+        Condition_Post(global->work_condition);
+    }
+
+    // The calling thread works on its own job until every task is claimed, then waits for the workers to finish theirs
+    uint32_t task;
+    while (threadpool_claim_task(global, &job, &task) != NULL)
+    {
+        threadpool_run_task(global, &job, task);
+    }
+    while (job.remaining_tasks != 0)
+    {
+        (void)Condition_Wait(global->done_condition, global->lock, 0);
+    }
+    Unlock(global->lock);
+}
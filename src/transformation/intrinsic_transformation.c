@@ -3,9 +3,13 @@
 
 #include <k4ainternal/transformation.h>
 #include <k4ainternal/logging.h>
+#include <k4ainternal/simd.h>
 
 #include <float.h>
 
+// Maximum number of Newton iterations used to undistort a point
+#define TRANSFORMATION_MAX_UNPROJECT_PASSES (20)
+
 // We don't like globals if we can help it. This one is for reducing critical logging noise when recorded files are used
 // with Rational 6KT calibration. Production devices never had this calibration but recordings were made with this
 // calibration. So we fire the warning 1 time instead of every time a transformation call is made
@@ -324,7 +328,7 @@ static k4a_result_t transformation_unproject_internal(const k4a_calibration_came
     xy[0] += codx;
     xy[1] += cody;
 
-    return transformation_iterative_unproject(camera_calibration, uv, xy, valid, 20);
+    return transformation_iterative_unproject(camera_calibration, uv, xy, valid, TRANSFORMATION_MAX_UNPROJECT_PASSES);
 }
 
 k4a_result_t transformation_unproject(const k4a_calibration_camera_t *camera_calibration,
@@ -378,3 +382,681 @@ k4a_result_t transformation_project(const k4a_calibration_camera_t *camera_calib
 
     return K4A_RESULT_SUCCEEDED;
 }
+
+typedef struct _k4a_transformation_projection_t
+{
+    float cx, cy, fx, fy;    // principal point and focal length
+    float k1, k2, k3;        // radial distortion numerator
+    float k4, k5, k6;        // radial distortion denominator
+    float codx, cody;        // center of distortion
+    float p1, p2;            // tangential distortion
+    float tangential_scale;  // 2 for Brown Conrady, 1 for Rational 6KT
+    float max_radius_square; // largest squared radius that is projected
+} k4a_transformation_projection_t;
+
+// The kernels below project 4 points at a time with the same operations, in the same order, as
+// transformation_project() does, so both produce identical results for valid points.
+#if defined(K4A_USING_NEON)
+static void transformation_project_4(const k4a_transformation_projection_t *projection,
+                                     const float *points3d,
+                                     float *points2d,
+                                     int *valid)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t two = vdupq_n_f32(2.f);
+
+    // x0 x1 x2 x3, y0 y1 y2 y3, z0 z1 z2 z3
+    float32x4x3_t point3d = vld3q_f32(points3d);
+    float32x4_t z = point3d.val[2];
+    uint32x4_t in_front = vmvnq_u32(vcleq_f32(z, zero));
+
+    float32x4_t xp = vsubq_f32(vdivq_f32(point3d.val[0], z), vdupq_n_f32(projection->codx));
+    float32x4_t yp = vsubq_f32(vdivq_f32(point3d.val[1], z), vdupq_n_f32(projection->cody));
+    float32x4_t xp2 = vmulq_f32(xp, xp);
+    float32x4_t yp2 = vmulq_f32(yp, yp);
+    float32x4_t xyp = vmulq_f32(xp, yp);
+    float32x4_t rs = vaddq_f32(xp2, yp2);
+    uint32x4_t in_radius = vmvnq_u32(vcgtq_f32(rs, vdupq_n_f32(projection->max_radius_square)));
+    float32x4_t rss = vmulq_f32(rs, rs);
+    float32x4_t rsc = vmulq_f32(rss, rs);
+    float32x4_t a = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k1)),
+                                        vmulq_n_f32(rss, projection->k2)),
+                              vmulq_n_f32(rsc, projection->k3));
+    float32x4_t b = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k4)),
+                                        vmulq_n_f32(rss, projection->k5)),
+                              vmulq_n_f32(rsc, projection->k6));
+    float32x4_t bi = vbslq_f32(vceqq_f32(b, zero), one, vdivq_f32(one, b));
+    float32x4_t d = vmulq_f32(a, bi);
+
+    float32x4_t xp_d = vmulq_f32(xp, d);
+    float32x4_t yp_d = vmulq_f32(yp, d);
+    float32x4_t rs_2xp2 = vaddq_f32(rs, vmulq_f32(two, xp2));
+    float32x4_t rs_2yp2 = vaddq_f32(rs, vmulq_f32(two, yp2));
+    float32x4_t scaled_xyp = vmulq_n_f32(xyp, projection->tangential_scale);
+    xp_d = vaddq_f32(xp_d, vaddq_f32(vmulq_n_f32(rs_2xp2, projection->p2), vmulq_n_f32(scaled_xyp, projection->p1)));
+    yp_d = vaddq_f32(yp_d, vaddq_f32(vmulq_n_f32(rs_2yp2, projection->p1), vmulq_n_f32(scaled_xyp, projection->p2)));
+
+    // points behind the camera are projected to 0
+    float32x4x2_t point2d;
+    point2d.val[0] = vaddq_f32(vmulq_n_f32(vaddq_f32(xp_d, vdupq_n_f32(projection->codx)), projection->fx),
+                               vdupq_n_f32(projection->cx));
+    point2d.val[1] = vaddq_f32(vmulq_n_f32(vaddq_f32(yp_d, vdupq_n_f32(projection->cody)), projection->fy),
+                               vdupq_n_f32(projection->cy));
+    point2d.val[0] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(point2d.val[0]), in_front));
+    point2d.val[1] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(point2d.val[1]), in_front));
+    vst2q_f32(points2d, point2d);
+
+    vst1q_s32(valid, vreinterpretq_s32_u32(vandq_u32(vandq_u32(in_front, in_radius), vdupq_n_u32(1))));
+}
+
+#elif defined(K4A_USING_SSE)
+static void transformation_project_4(const k4a_transformation_projection_t *projection,
+                                     const float *points3d,
+                                     float *points2d,
+                                     int *valid)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+
+    __m128 x = _mm_setr_ps(points3d[0], points3d[3], points3d[6], points3d[9]);
+    __m128 y = _mm_setr_ps(points3d[1], points3d[4], points3d[7], points3d[10]);
+    __m128 z = _mm_setr_ps(points3d[2], points3d[5], points3d[8], points3d[11]);
+    __m128 in_front = _mm_cmpnle_ps(z, zero);
+
+    __m128 codx = _mm_set1_ps(projection->codx);
+    __m128 cody = _mm_set1_ps(projection->cody);
+    __m128 xp = _mm_sub_ps(_mm_div_ps(x, z), codx);
+    __m128 yp = _mm_sub_ps(_mm_div_ps(y, z), cody);
+    __m128 xp2 = _mm_mul_ps(xp, xp);
+    __m128 yp2 = _mm_mul_ps(yp, yp);
+    __m128 xyp = _mm_mul_ps(xp, yp);
+    __m128 rs = _mm_add_ps(xp2, yp2);
+    __m128 in_radius = _mm_cmpngt_ps(rs, _mm_set1_ps(projection->max_radius_square));
+    __m128 rss = _mm_mul_ps(rs, rs);
+    __m128 rsc = _mm_mul_ps(rss, rs);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k1), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k2), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k3), rsc));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k4), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k5), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k6), rsc));
+    __m128 bi = _mm_blendv_ps(one, _mm_div_ps(one, b), _mm_cmpneq_ps(b, zero));
+    __m128 d = _mm_mul_ps(a, bi);
+
+    __m128 xp_d = _mm_mul_ps(xp, d);
+    __m128 yp_d = _mm_mul_ps(yp, d);
+    __m128 rs_2xp2 = _mm_add_ps(rs, _mm_mul_ps(two, xp2));
+    __m128 rs_2yp2 = _mm_add_ps(rs, _mm_mul_ps(two, yp2));
+    __m128 scaled_xyp = _mm_mul_ps(_mm_set1_ps(projection->tangential_scale), xyp);
+    __m128 p1 = _mm_set1_ps(projection->p1);
+    __m128 p2 = _mm_set1_ps(projection->p2);
+    xp_d = _mm_add_ps(xp_d, _mm_add_ps(_mm_mul_ps(rs_2xp2, p2), _mm_mul_ps(scaled_xyp, p1)));
+    yp_d = _mm_add_ps(yp_d, _mm_add_ps(_mm_mul_ps(rs_2yp2, p1), _mm_mul_ps(scaled_xyp, p2)));
+
+    // points behind the camera are projected to 0
+    __m128 u = _mm_add_ps(_mm_mul_ps(_mm_add_ps(xp_d, codx), _mm_set1_ps(projection->fx)), _mm_set1_ps(projection->cx));
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_add_ps(yp_d, cody), _mm_set1_ps(projection->fy)), _mm_set1_ps(projection->cy));
+    u = _mm_and_ps(u, in_front);
+    v = _mm_and_ps(v, in_front);
+
+    // u0 v0 u1 v1, u2 v2 u3 v3
+    _mm_storeu_ps(points2d, _mm_unpacklo_ps(u, v));
+    _mm_storeu_ps(points2d + 4, _mm_unpackhi_ps(u, v));
+
+    __m128i valid_mask = _mm_castps_si128(_mm_and_ps(in_front, in_radius));
+    _mm_storeu_si128((__m128i *)(void *)valid, _mm_and_si128(valid_mask, _mm_set1_epi32(1)));
+}
+
+#if defined(K4A_USING_AVX)
+// transformation_project_4() over 8 points. Products and sums are rounded separately, no fused multiply add is used.
+SIMD_TARGET_AVX2 static void transformation_project_8_avx2(const k4a_transformation_projection_t *projection,
+                                                           const float *points3d,
+                                                           float *points2d,
+                                                           int *valid)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+
+    const __m256i point_offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256 x = _mm256_i32gather_ps(points3d, point_offsets, 4);
+    __m256 y = _mm256_i32gather_ps(points3d + 1, point_offsets, 4);
+    __m256 z = _mm256_i32gather_ps(points3d + 2, point_offsets, 4);
+    __m256 in_front = _mm256_cmp_ps(z, zero, _CMP_NLE_UQ);
+
+    __m256 codx = _mm256_set1_ps(projection->codx);
+    __m256 cody = _mm256_set1_ps(projection->cody);
+    __m256 xp = _mm256_sub_ps(_mm256_div_ps(x, z), codx);
+    __m256 yp = _mm256_sub_ps(_mm256_div_ps(y, z), cody);
+    __m256 xp2 = _mm256_mul_ps(xp, xp);
+    __m256 yp2 = _mm256_mul_ps(yp, yp);
+    __m256 xyp = _mm256_mul_ps(xp, yp);
+    __m256 rs = _mm256_add_ps(xp2, yp2);
+    __m256 in_radius = _mm256_cmp_ps(rs, _mm256_set1_ps(projection->max_radius_square), _CMP_NGT_UQ);
+    __m256 rss = _mm256_mul_ps(rs, rs);
+    __m256 rsc = _mm256_mul_ps(rss, rs);
+    __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(one, _mm256_mul_ps(_mm256_set1_ps(projection->k1), rs)),
+                                           _mm256_mul_ps(_mm256_set1_ps(projection->k2), rss)),
+                             _mm256_mul_ps(_mm256_set1_ps(projection->k3), rsc));
+    __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(one, _mm256_mul_ps(_mm256_set1_ps(projection->k4), rs)),
+                                           _mm256_mul_ps(_mm256_set1_ps(projection->k5), rss)),
+                             _mm256_mul_ps(_mm256_set1_ps(projection->k6), rsc));
+    __m256 bi = _mm256_blendv_ps(one, _mm256_div_ps(one, b), _mm256_cmp_ps(b, zero, _CMP_NEQ_UQ));
+    __m256 d = _mm256_mul_ps(a, bi);
+
+    __m256 xp_d = _mm256_mul_ps(xp, d);
+    __m256 yp_d = _mm256_mul_ps(yp, d);
+    __m256 rs_2xp2 = _mm256_add_ps(rs, _mm256_mul_ps(two, xp2));
+    __m256 rs_2yp2 = _mm256_add_ps(rs, _mm256_mul_ps(two, yp2));
+    __m256 scaled_xyp = _mm256_mul_ps(_mm256_set1_ps(projection->tangential_scale), xyp);
+    __m256 p1 = _mm256_set1_ps(projection->p1);
+    __m256 p2 = _mm256_set1_ps(projection->p2);
+    xp_d = _mm256_add_ps(xp_d, _mm256_add_ps(_mm256_mul_ps(rs_2xp2, p2), _mm256_mul_ps(scaled_xyp, p1)));
+    yp_d = _mm256_add_ps(yp_d, _mm256_add_ps(_mm256_mul_ps(rs_2yp2, p1), _mm256_mul_ps(scaled_xyp, p2)));
+
+    // points behind the camera are projected to 0
+    __m256 u = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(xp_d, codx), _mm256_set1_ps(projection->fx)),
+                             _mm256_set1_ps(projection->cx));
+    __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(yp_d, cody), _mm256_set1_ps(projection->fy)),
+                             _mm256_set1_ps(projection->cy));
+    u = _mm256_and_ps(u, in_front);
+    v = _mm256_and_ps(v, in_front);
+
+    // u0 v0 u1 v1 u4 v4 u5 v5, u2 v2 u3 v3 u6 v6 u7 v7
+    __m256 low = _mm256_unpacklo_ps(u, v);
+    __m256 high = _mm256_unpackhi_ps(u, v);
+    _mm256_storeu_ps(points2d, _mm256_permute2f128_ps(low, high, 0x20));
+    _mm256_storeu_ps(points2d + 8, _mm256_permute2f128_ps(low, high, 0x31));
+
+    __m256i valid_mask = _mm256_castps_si256(_mm256_and_ps(in_front, in_radius));
+    _mm256_storeu_si256((__m256i *)(void *)valid, _mm256_and_si256(valid_mask, _mm256_set1_epi32(1)));
+}
+#endif
+#endif
+
+// The kernels below undistort 4 points at a time with the same Newton iterations as
+// transformation_iterative_unproject(). Each lane stops iterating on its own: a lane leaves the active mask once it
+// converges, stops improving or leaves the valid radius, and the loop ends when no lane is active.
+#if defined(K4A_USING_NEON)
+static void transformation_project_jacobian_4(const k4a_transformation_projection_t *projection,
+                                              float32x4_t x,
+                                              float32x4_t y,
+                                              float32x4_t *u,
+                                              float32x4_t *v,
+                                              uint32x4_t *in_radius,
+                                              float32x4_t J[2 * 2])
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t two = vdupq_n_f32(2.f);
+    const float32x4_t six = vdupq_n_f32(6.f);
+    const float32x4_t tangential_scale = vdupq_n_f32(projection->tangential_scale);
+
+    float32x4_t xp = vsubq_f32(x, vdupq_n_f32(projection->codx));
+    float32x4_t yp = vsubq_f32(y, vdupq_n_f32(projection->cody));
+    float32x4_t xp2 = vmulq_f32(xp, xp);
+    float32x4_t yp2 = vmulq_f32(yp, yp);
+    float32x4_t xyp = vmulq_f32(xp, yp);
+    float32x4_t rs = vaddq_f32(xp2, yp2);
+    *in_radius = vmvnq_u32(vcgtq_f32(rs, vdupq_n_f32(projection->max_radius_square)));
+    float32x4_t rss = vmulq_f32(rs, rs);
+    float32x4_t rsc = vmulq_f32(rss, rs);
+    float32x4_t a = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k1)),
+                                        vmulq_n_f32(rss, projection->k2)),
+                              vmulq_n_f32(rsc, projection->k3));
+    float32x4_t b = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k4)),
+                                        vmulq_n_f32(rss, projection->k5)),
+                              vmulq_n_f32(rsc, projection->k6));
+    float32x4_t bi = vbslq_f32(vceqq_f32(b, zero), one, vdivq_f32(one, b));
+    float32x4_t d = vmulq_f32(a, bi);
+
+    float32x4_t xp_d = vmulq_f32(xp, d);
+    float32x4_t yp_d = vmulq_f32(yp, d);
+    float32x4_t rs_2xp2 = vaddq_f32(rs, vmulq_f32(two, xp2));
+    float32x4_t rs_2yp2 = vaddq_f32(rs, vmulq_f32(two, yp2));
+    float32x4_t scaled_xyp = vmulq_f32(tangential_scale, xyp);
+    xp_d = vaddq_f32(xp_d, vaddq_f32(vmulq_n_f32(rs_2xp2, projection->p2), vmulq_n_f32(scaled_xyp, projection->p1)));
+    yp_d = vaddq_f32(yp_d, vaddq_f32(vmulq_n_f32(rs_2yp2, projection->p1), vmulq_n_f32(scaled_xyp, projection->p2)));
+
+    *u = vaddq_f32(vmulq_n_f32(vaddq_f32(xp_d, vdupq_n_f32(projection->codx)), projection->fx),
+                   vdupq_n_f32(projection->cx));
+    *v = vaddq_f32(vmulq_n_f32(vaddq_f32(yp_d, vdupq_n_f32(projection->cody)), projection->fy),
+                   vdupq_n_f32(projection->cy));
+
+    // compute Jacobian matrix
+    float32x4_t dudrs = vaddq_f32(vaddq_f32(vdupq_n_f32(projection->k1), vmulq_n_f32(rs, 2.f * projection->k2)),
+                                  vmulq_n_f32(rss, 3.f * projection->k3));
+    // compute d(b)/d(r^2)
+    float32x4_t dvdrs = vaddq_f32(vaddq_f32(vdupq_n_f32(projection->k4), vmulq_n_f32(rs, 2.f * projection->k5)),
+                                  vmulq_n_f32(rss, 3.f * projection->k6));
+    float32x4_t bis = vmulq_f32(bi, bi);
+    float32x4_t dddrs = vmulq_f32(vsubq_f32(vmulq_f32(dudrs, b), vmulq_f32(a, dvdrs)), bis);
+
+    float32x4_t dddrs_2 = vmulq_f32(dddrs, two);
+    float32x4_t xp_dddrs_2 = vmulq_f32(xp, dddrs_2);
+    float32x4_t yp_xp_dddrs_2 = vmulq_f32(yp, xp_dddrs_2);
+    float32x4_t scaled_xp = vmulq_f32(tangential_scale, xp);
+    float32x4_t scaled_yp = vmulq_f32(tangential_scale, yp);
+    J[0] = vmulq_n_f32(vaddq_f32(vaddq_f32(vaddq_f32(d, vmulq_f32(xp, xp_dddrs_2)),
+                                           vmulq_n_f32(vmulq_f32(six, xp), projection->p2)),
+                                 vmulq_n_f32(scaled_yp, projection->p1)),
+                       projection->fx);
+    J[1] = vmulq_n_f32(vaddq_f32(vaddq_f32(yp_xp_dddrs_2, vmulq_n_f32(vmulq_f32(two, yp), projection->p2)),
+                                 vmulq_n_f32(scaled_xp, projection->p1)),
+                       projection->fx);
+    J[2] = vmulq_n_f32(vaddq_f32(vaddq_f32(yp_xp_dddrs_2, vmulq_n_f32(vmulq_f32(two, xp), projection->p1)),
+                                 vmulq_n_f32(scaled_yp, projection->p2)),
+                       projection->fy);
+    J[3] = vmulq_n_f32(vaddq_f32(vaddq_f32(vaddq_f32(d, vmulq_f32(vmulq_f32(yp, yp), dddrs_2)),
+                                           vmulq_n_f32(vmulq_f32(six, yp), projection->p1)),
+                                 vmulq_n_f32(scaled_xp, projection->p2)),
+                       projection->fy);
+}
+
+static void transformation_unproject_4(const k4a_transformation_projection_t *projection,
+                                       const float *points2d,
+                                       const float *depths,
+                                       float *points3d,
+                                       int *valid)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t two = vdupq_n_f32(2.f);
+    const float32x4_t three = vdupq_n_f32(3.f);
+    const float32x4_t codx = vdupq_n_f32(projection->codx);
+    const float32x4_t cody = vdupq_n_f32(projection->cody);
+
+    // u0 u1 u2 u3, v0 v1 v2 v3
+    float32x4x2_t uv = vld2q_f32(points2d);
+    float32x4_t u = uv.val[0];
+    float32x4_t v = uv.val[1];
+    float32x4_t depth = vld1q_f32(depths);
+
+    // correction for radial distortion
+    float32x4_t xp_d = vsubq_f32(vdivq_f32(vsubq_f32(u, vdupq_n_f32(projection->cx)), vdupq_n_f32(projection->fx)),
+                                 codx);
+    float32x4_t yp_d = vsubq_f32(vdivq_f32(vsubq_f32(v, vdupq_n_f32(projection->cy)), vdupq_n_f32(projection->fy)),
+                                 cody);
+    float32x4_t rs = vaddq_f32(vmulq_f32(xp_d, xp_d), vmulq_f32(yp_d, yp_d));
+    float32x4_t rss = vmulq_f32(rs, rs);
+    float32x4_t rsc = vmulq_f32(rss, rs);
+    float32x4_t a = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k1)),
+                                        vmulq_n_f32(rss, projection->k2)),
+                              vmulq_n_f32(rsc, projection->k3));
+    float32x4_t b = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, projection->k4)),
+                                        vmulq_n_f32(rss, projection->k5)),
+                              vmulq_n_f32(rsc, projection->k6));
+    float32x4_t ai = vbslq_f32(vceqq_f32(a, zero), one, vdivq_f32(one, a));
+    float32x4_t di = vmulq_f32(ai, b);
+    float32x4_t x = vmulq_f32(xp_d, di);
+    float32x4_t y = vmulq_f32(yp_d, di);
+
+    // approximate correction for tangential params
+    float32x4_t two_xy = vmulq_f32(vmulq_f32(two, x), y);
+    float32x4_t xx = vmulq_f32(x, x);
+    float32x4_t yy = vmulq_f32(y, y);
+    x = vsubq_f32(x,
+                  vaddq_f32(vmulq_n_f32(vaddq_f32(yy, vmulq_f32(three, xx)), projection->p2),
+                            vmulq_n_f32(two_xy, projection->p1)));
+    y = vsubq_f32(y,
+                  vaddq_f32(vmulq_n_f32(vaddq_f32(xx, vmulq_f32(three, yy)), projection->p1),
+                            vmulq_n_f32(two_xy, projection->p2)));
+
+    // add on center of distortion
+    x = vaddq_f32(x, codx);
+    y = vaddq_f32(y, cody);
+
+    uint32x4_t has_depth = vmvnq_u32(vceqq_f32(depth, zero));
+    uint32x4_t lane_valid = has_depth;
+    uint32x4_t active = has_depth;
+    float32x4_t best_x = zero;
+    float32x4_t best_y = zero;
+    float32x4_t best_err = vdupq_n_f32(FLT_MAX);
+    for (unsigned int pass = 0; pass < TRANSFORMATION_MAX_UNPROJECT_PASSES && vmaxvq_u32(active) != 0; pass++)
+    {
+        float32x4_t p_u, p_v;
+        uint32x4_t in_radius;
+        float32x4_t J[2 * 2];
+        transformation_project_jacobian_4(projection, x, y, &p_u, &p_v, &in_radius, J);
+
+        lane_valid = vbicq_u32(lane_valid, vbicq_u32(active, in_radius));
+        active = vandq_u32(active, in_radius);
+
+        float32x4_t err_x = vsubq_f32(u, p_u);
+        float32x4_t err_y = vsubq_f32(v, p_v);
+        float32x4_t err = vaddq_f32(vmulq_f32(err_x, err_x), vmulq_f32(err_y, err_y));
+        uint32x4_t worse = vandq_u32(active, vcgeq_f32(err, best_err));
+        x = vbslq_f32(worse, best_x, x);
+        y = vbslq_f32(worse, best_y, y);
+        active = vbicq_u32(active, worse);
+
+        best_err = vbslq_f32(active, err, best_err);
+        best_x = vbslq_f32(active, x, best_x);
+        best_y = vbslq_f32(active, y, best_y);
+        if (pass + 1 == TRANSFORMATION_MAX_UNPROJECT_PASSES)
+        {
+            break;
+        }
+        active = vbicq_u32(active, vcltq_f32(best_err, vdupq_n_f32(1e-22f)));
+
+        float32x4_t inv_detJ = vdivq_f32(one, vsubq_f32(vmulq_f32(J[0], J[3]), vmulq_f32(J[1], J[2])));
+        float32x4_t neg_inv_detJ = vnegq_f32(inv_detJ);
+        float32x4_t dx = vaddq_f32(vmulq_f32(vmulq_f32(inv_detJ, J[3]), err_x),
+                                   vmulq_f32(vmulq_f32(neg_inv_detJ, J[1]), err_y));
+        float32x4_t dy = vaddq_f32(vmulq_f32(vmulq_f32(neg_inv_detJ, J[2]), err_x),
+                                   vmulq_f32(vmulq_f32(inv_detJ, J[0]), err_y));
+        x = vbslq_f32(active, vaddq_f32(x, dx), x);
+        y = vbslq_f32(active, vaddq_f32(y, dy), y);
+    }
+    lane_valid = vbicq_u32(lane_valid, vcgtq_f32(best_err, vdupq_n_f32(1e-6f)));
+
+    // points with zero depth are unprojected to 0
+    float32x4x3_t point3d;
+    point3d.val[0] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(x, depth)), has_depth));
+    point3d.val[1] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(y, depth)), has_depth));
+    point3d.val[2] = depth;
+    vst3q_f32(points3d, point3d);
+
+    vst1q_s32(valid, vreinterpretq_s32_u32(vandq_u32(lane_valid, vdupq_n_u32(1))));
+}
+
+#elif defined(K4A_USING_SSE)
+static void transformation_project_jacobian_4(const k4a_transformation_projection_t *projection,
+                                              __m128 x,
+                                              __m128 y,
+                                              __m128 *u,
+                                              __m128 *v,
+                                              __m128 *in_radius,
+                                              __m128 J[2 * 2])
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 six = _mm_set1_ps(6.f);
+    const __m128 tangential_scale = _mm_set1_ps(projection->tangential_scale);
+    const __m128 codx = _mm_set1_ps(projection->codx);
+    const __m128 cody = _mm_set1_ps(projection->cody);
+    const __m128 fx = _mm_set1_ps(projection->fx);
+    const __m128 fy = _mm_set1_ps(projection->fy);
+    const __m128 p1 = _mm_set1_ps(projection->p1);
+    const __m128 p2 = _mm_set1_ps(projection->p2);
+
+    __m128 xp = _mm_sub_ps(x, codx);
+    __m128 yp = _mm_sub_ps(y, cody);
+    __m128 xp2 = _mm_mul_ps(xp, xp);
+    __m128 yp2 = _mm_mul_ps(yp, yp);
+    __m128 xyp = _mm_mul_ps(xp, yp);
+    __m128 rs = _mm_add_ps(xp2, yp2);
+    *in_radius = _mm_cmpngt_ps(rs, _mm_set1_ps(projection->max_radius_square));
+    __m128 rss = _mm_mul_ps(rs, rs);
+    __m128 rsc = _mm_mul_ps(rss, rs);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k1), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k2), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k3), rsc));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k4), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k5), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k6), rsc));
+    __m128 bi = _mm_blendv_ps(one, _mm_div_ps(one, b), _mm_cmpneq_ps(b, zero));
+    __m128 d = _mm_mul_ps(a, bi);
+
+    __m128 xp_d = _mm_mul_ps(xp, d);
+    __m128 yp_d = _mm_mul_ps(yp, d);
+    __m128 rs_2xp2 = _mm_add_ps(rs, _mm_mul_ps(two, xp2));
+    __m128 rs_2yp2 = _mm_add_ps(rs, _mm_mul_ps(two, yp2));
+    __m128 scaled_xyp = _mm_mul_ps(tangential_scale, xyp);
+    xp_d = _mm_add_ps(xp_d, _mm_add_ps(_mm_mul_ps(rs_2xp2, p2), _mm_mul_ps(scaled_xyp, p1)));
+    yp_d = _mm_add_ps(yp_d, _mm_add_ps(_mm_mul_ps(rs_2yp2, p1), _mm_mul_ps(scaled_xyp, p2)));
+
+    *u = _mm_add_ps(_mm_mul_ps(_mm_add_ps(xp_d, codx), fx), _mm_set1_ps(projection->cx));
+    *v = _mm_add_ps(_mm_mul_ps(_mm_add_ps(yp_d, cody), fy), _mm_set1_ps(projection->cy));
+
+    // compute Jacobian matrix
+    __m128 dudrs = _mm_add_ps(_mm_set1_ps(projection->k1), _mm_mul_ps(_mm_set1_ps(2.f * projection->k2), rs));
+    dudrs = _mm_add_ps(dudrs, _mm_mul_ps(_mm_set1_ps(3.f * projection->k3), rss));
+    // compute d(b)/d(r^2)
+    __m128 dvdrs = _mm_add_ps(_mm_set1_ps(projection->k4), _mm_mul_ps(_mm_set1_ps(2.f * projection->k5), rs));
+    dvdrs = _mm_add_ps(dvdrs, _mm_mul_ps(_mm_set1_ps(3.f * projection->k6), rss));
+    __m128 bis = _mm_mul_ps(bi, bi);
+    __m128 dddrs = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dudrs, b), _mm_mul_ps(a, dvdrs)), bis);
+
+    __m128 dddrs_2 = _mm_mul_ps(dddrs, two);
+    __m128 xp_dddrs_2 = _mm_mul_ps(xp, dddrs_2);
+    __m128 yp_xp_dddrs_2 = _mm_mul_ps(yp, xp_dddrs_2);
+    __m128 scaled_xp = _mm_mul_ps(tangential_scale, xp);
+    __m128 scaled_yp = _mm_mul_ps(tangential_scale, yp);
+    J[0] = _mm_mul_ps(fx,
+                      _mm_add_ps(_mm_add_ps(_mm_add_ps(d, _mm_mul_ps(xp, xp_dddrs_2)),
+                                            _mm_mul_ps(_mm_mul_ps(six, xp), p2)),
+                                 _mm_mul_ps(scaled_yp, p1)));
+    J[1] = _mm_mul_ps(
+        fx, _mm_add_ps(_mm_add_ps(yp_xp_dddrs_2, _mm_mul_ps(_mm_mul_ps(two, yp), p2)), _mm_mul_ps(scaled_xp, p1)));
+    J[2] = _mm_mul_ps(
+        fy, _mm_add_ps(_mm_add_ps(yp_xp_dddrs_2, _mm_mul_ps(_mm_mul_ps(two, xp), p1)), _mm_mul_ps(scaled_yp, p2)));
+    J[3] = _mm_mul_ps(fy,
+                      _mm_add_ps(_mm_add_ps(_mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(yp, yp), dddrs_2)),
+                                            _mm_mul_ps(_mm_mul_ps(six, yp), p1)),
+                                 _mm_mul_ps(scaled_xp, p2)));
+}
+
+static void transformation_unproject_4(const k4a_transformation_projection_t *projection,
+                                       const float *points2d,
+                                       const float *depths,
+                                       float *points3d,
+                                       int *valid)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 three = _mm_set1_ps(3.f);
+    const __m128 codx = _mm_set1_ps(projection->codx);
+    const __m128 cody = _mm_set1_ps(projection->cody);
+    const __m128 p1 = _mm_set1_ps(projection->p1);
+    const __m128 p2 = _mm_set1_ps(projection->p2);
+
+    // u0 v0 u1 v1, u2 v2 u3 v3 -> u0 u1 u2 u3, v0 v1 v2 v3
+    __m128 uv_lo = _mm_loadu_ps(points2d);
+    __m128 uv_hi = _mm_loadu_ps(points2d + 4);
+    __m128 u = _mm_shuffle_ps(uv_lo, uv_hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 v = _mm_shuffle_ps(uv_lo, uv_hi, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 depth = _mm_loadu_ps(depths);
+
+    // correction for radial distortion
+    __m128 xp_d = _mm_sub_ps(_mm_div_ps(_mm_sub_ps(u, _mm_set1_ps(projection->cx)), _mm_set1_ps(projection->fx)), codx);
+    __m128 yp_d = _mm_sub_ps(_mm_div_ps(_mm_sub_ps(v, _mm_set1_ps(projection->cy)), _mm_set1_ps(projection->fy)), cody);
+    __m128 rs = _mm_add_ps(_mm_mul_ps(xp_d, xp_d), _mm_mul_ps(yp_d, yp_d));
+    __m128 rss = _mm_mul_ps(rs, rs);
+    __m128 rsc = _mm_mul_ps(rss, rs);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k1), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k2), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k3), rsc));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(projection->k4), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(projection->k5), rss)),
+                          _mm_mul_ps(_mm_set1_ps(projection->k6), rsc));
+    __m128 ai = _mm_blendv_ps(one, _mm_div_ps(one, a), _mm_cmpneq_ps(a, zero));
+    __m128 di = _mm_mul_ps(ai, b);
+    __m128 x = _mm_mul_ps(xp_d, di);
+    __m128 y = _mm_mul_ps(yp_d, di);
+
+    // approximate correction for tangential params
+    __m128 two_xy = _mm_mul_ps(_mm_mul_ps(two, x), y);
+    __m128 xx = _mm_mul_ps(x, x);
+    __m128 yy = _mm_mul_ps(y, y);
+    x = _mm_sub_ps(x, _mm_add_ps(_mm_mul_ps(_mm_add_ps(yy, _mm_mul_ps(three, xx)), p2), _mm_mul_ps(two_xy, p1)));
+    y = _mm_sub_ps(y, _mm_add_ps(_mm_mul_ps(_mm_add_ps(xx, _mm_mul_ps(three, yy)), p1), _mm_mul_ps(two_xy, p2)));
+
+    // add on center of distortion
+    x = _mm_add_ps(x, codx);
+    y = _mm_add_ps(y, cody);
+
+    __m128 has_depth = _mm_cmpneq_ps(depth, zero);
+    __m128 lane_valid = has_depth;
+    __m128 active = has_depth;
+    __m128 best_x = zero;
+    __m128 best_y = zero;
+    __m128 best_err = _mm_set1_ps(FLT_MAX);
+    for (unsigned int pass = 0; pass < TRANSFORMATION_MAX_UNPROJECT_PASSES && _mm_movemask_ps(active) != 0; pass++)
+    {
+        __m128 p_u, p_v, in_radius;
+        __m128 J[2 * 2];
+        transformation_project_jacobian_4(projection, x, y, &p_u, &p_v, &in_radius, J);
+
+        lane_valid = _mm_andnot_ps(_mm_andnot_ps(in_radius, active), lane_valid);
+        active = _mm_and_ps(active, in_radius);
+
+        __m128 err_x = _mm_sub_ps(u, p_u);
+        __m128 err_y = _mm_sub_ps(v, p_v);
+        __m128 err = _mm_add_ps(_mm_mul_ps(err_x, err_x), _mm_mul_ps(err_y, err_y));
+        __m128 worse = _mm_and_ps(active, _mm_cmpge_ps(err, best_err));
+        x = _mm_blendv_ps(x, best_x, worse);
+        y = _mm_blendv_ps(y, best_y, worse);
+        active = _mm_andnot_ps(worse, active);
+
+        best_err = _mm_blendv_ps(best_err, err, active);
+        best_x = _mm_blendv_ps(best_x, x, active);
+        best_y = _mm_blendv_ps(best_y, y, active);
+        if (pass + 1 == TRANSFORMATION_MAX_UNPROJECT_PASSES)
+        {
+            break;
+        }
+        active = _mm_andnot_ps(_mm_cmplt_ps(best_err, _mm_set1_ps(1e-22f)), active);
+
+        __m128 inv_detJ = _mm_div_ps(one, _mm_sub_ps(_mm_mul_ps(J[0], J[3]), _mm_mul_ps(J[1], J[2])));
+        __m128 neg_inv_detJ = _mm_xor_ps(inv_detJ, _mm_set1_ps(-0.f));
+        __m128 dx = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(inv_detJ, J[3]), err_x),
+                               _mm_mul_ps(_mm_mul_ps(neg_inv_detJ, J[1]), err_y));
+        __m128 dy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(neg_inv_detJ, J[2]), err_x),
+                               _mm_mul_ps(_mm_mul_ps(inv_detJ, J[0]), err_y));
+        x = _mm_blendv_ps(x, _mm_add_ps(x, dx), active);
+        y = _mm_blendv_ps(y, _mm_add_ps(y, dy), active);
+    }
+    lane_valid = _mm_andnot_ps(_mm_cmpgt_ps(best_err, _mm_set1_ps(1e-6f)), lane_valid);
+
+    // points with zero depth are unprojected to 0
+    float point3d_x[4], point3d_y[4], point3d_z[4];
+    _mm_storeu_ps(point3d_x, _mm_and_ps(_mm_mul_ps(x, depth), has_depth));
+    _mm_storeu_ps(point3d_y, _mm_and_ps(_mm_mul_ps(y, depth), has_depth));
+    _mm_storeu_ps(point3d_z, depth);
+    for (int i = 0; i < 4; i++)
+    {
+        points3d[3 * i + 0] = point3d_x[i];
+        points3d[3 * i + 1] = point3d_y[i];
+        points3d[3 * i + 2] = point3d_z[i];
+    }
+
+    __m128i valid_mask = _mm_castps_si128(lane_valid);
+    _mm_storeu_si128((__m128i *)(void *)valid, _mm_and_si128(valid_mask, _mm_set1_epi32(1)));
+}
+#endif
+
+static k4a_result_t transformation_init_projection(const k4a_calibration_camera_t *camera_calibration,
+                                                   k4a_transformation_projection_t *projection)
+{
+    // Project one point through the scalar path so that the camera model is validated once for the whole batch
+    float point3d[3] = { 0.f, 0.f, 1.f };
+    float point2d[2];
+    int point_valid;
+    if (K4A_FAILED(TRACE_CALL(transformation_project(camera_calibration, point3d, point2d, &point_valid))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_intrinsic_parameters_t *params = &camera_calibration->intrinsics.parameters;
+    projection->cx = params->param.cx;
+    projection->cy = params->param.cy;
+    projection->fx = params->param.fx;
+    projection->fy = params->param.fy;
+    projection->k1 = params->param.k1;
+    projection->k2 = params->param.k2;
+    projection->k3 = params->param.k3;
+    projection->k4 = params->param.k4;
+    projection->k5 = params->param.k5;
+    projection->k6 = params->param.k6;
+    projection->codx = params->param.codx;
+    projection->cody = params->param.cody;
+    projection->p1 = params->param.p1;
+    projection->p2 = params->param.p2;
+    projection->tangential_scale =
+        camera_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT ? 1.f : 2.f;
+    projection->max_radius_square = camera_calibration->metric_radius * camera_calibration->metric_radius;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_project_batch(const k4a_calibration_camera_t *camera_calibration,
+                                          const float *points3d,
+                                          size_t point_count,
+                                          float *points2d,
+                                          int *valid)
+{
+    k4a_transformation_projection_t projection;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_projection(camera_calibration, &projection))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    size_t i = 0;
+    simd_level_t level = simd_get_level();
+#if defined(K4A_USING_AVX)
+    for (; level >= SIMD_LEVEL_AVX2 && i + 8 <= point_count; i += 8)
+    {
+        transformation_project_8_avx2(&projection, points3d + 3 * i, points2d + 2 * i, valid + i);
+    }
+#endif
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+    for (; level != SIMD_LEVEL_NONE && i + 4 <= point_count; i += 4)
+    {
+        transformation_project_4(&projection, points3d + 3 * i, points2d + 2 * i, valid + i);
+    }
+#else
+    (void)level;
+#endif
+
+    for (; i < point_count; i++)
+    {
+        if (K4A_FAILED(
+                TRACE_CALL(transformation_project(camera_calibration, points3d + 3 * i, points2d + 2 * i, valid + i))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_unproject_batch(const k4a_calibration_camera_t *camera_calibration,
+                                            const float *points2d,
+                                            const float *depths,
+                                            size_t point_count,
+                                            float *points3d,
+                                            int *valid)
+{
+    k4a_transformation_projection_t projection;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_projection(camera_calibration, &projection))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    size_t i = 0;
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+    simd_level_t level = simd_get_level();
+    for (; level != SIMD_LEVEL_NONE && i + 4 <= point_count; i += 4)
+    {
+        transformation_unproject_4(&projection, points2d + 2 * i, depths + i, points3d + 3 * i, valid + i);
+    }
+#endif
+
+    for (; i < point_count; i++)
+    {
+        const float *point2d = points2d + 2 * i;
+        float *point3d = points3d + 3 * i;
+        if (K4A_FAILED(
+                TRACE_CALL(transformation_unproject(camera_calibration, point2d, depths[i], point3d, valid + i))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
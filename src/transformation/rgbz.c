@@ -1,22 +1,22 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#ifndef _MSC_VER
+#define _ISOC11_SOURCE /* for aligned_alloc() */
+#endif
+
 #include <k4ainternal/transformation.h>
 #include <k4ainternal/logging.h>
 
+// Dependent libraries
+#include <k4ainternal/simd.h>
+#include <k4ainternal/threadpool.h>
+#include <azure_c_shared_utility/threadapi.h>
+
 #include <stdlib.h>
 #include <limits.h>
 #include <math.h>
-
-#if defined(__amd64__) || defined(_M_AMD64) || defined(__i386__) || defined(_M_IX86)
-#define K4A_USING_SSE
-#include <emmintrin.h> // SSE2
-#include <tmmintrin.h> // SSE3
-#include <smmintrin.h> // SSE4.1
-#elif defined(__aarch64__) || defined(_M_ARM64)
-#define K4A_USING_NEON
-#include <arm_neon.h>
-#endif
+#include <float.h>
 
 typedef struct _k4a_transformation_input_image_t
 {
@@ -32,19 +32,44 @@ typedef struct _k4a_transformation_output_image_t
     uint16_t *data_uint16;
 } k4a_transformation_output_image_t;
 
+typedef struct _k4a_transformation_correspondence_params_t
+{
+    float rotation[9];       // depth camera to color camera rotation
+    float translation[3];    // depth camera to color camera translation
+    float cx, cy, fx, fy;    // color camera principal point and focal length
+    float k1, k2, k3;        // color camera radial distortion numerator
+    float k4, k5, k6;        // color camera radial distortion denominator
+    float codx, cody;        // color camera center of distortion
+    float p1, p2;            // color camera tangential distortion
+    float tangential_scale;  // 2 for Brown Conrady, 1 for Rational 6KT
+    float max_radius_square; // largest squared radius that is projected
+} k4a_transformation_correspondence_params_t;
+
+// A custom image that is transformed together with the depth image
+typedef struct _k4a_transformation_custom_channel_t
+{
+    k4a_transformation_input_image_t image;
+    k4a_transformation_output_image_t transformed_image;
+    uint16_t invalid_value;
+    bool is_custom16; // K4A_IMAGE_FORMAT_CUSTOM16, otherwise K4A_IMAGE_FORMAT_CUSTOM8
+} k4a_transformation_custom_channel_t;
+
 typedef struct _k4a_transformation_rgbz_context_t
 {
     const k4a_calibration_t *calibration;
     const k4a_transformation_xy_tables_t *xy_tables;
+    const k4a_transformation_ray_tables_t *ray_tables; // optional, precomputed depth to color rays
     k4a_transformation_input_image_t depth_image;
     k4a_transformation_input_image_t color_image;
-    k4a_transformation_input_image_t custom_image;
+    int color_scale; // color camera pixels per color image pixel, more than 1 for reduced resolution MJPEG decodes
+    int output_scale; // color camera pixels per transformed image pixel, more than 1 for reduced resolution outputs
     k4a_transformation_output_image_t transformed_image;
-    k4a_transformation_output_image_t transformed_custom_image;
+    k4a_transformation_custom_channel_t custom_channels[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    size_t custom_channel_count;
     k4a_transformation_interpolation_type_t interpolation_type;
-    uint16_t invalid_value;
-    bool enable_custom8;
-    bool enable_custom16;
+    uint32_t thread_count;
+    k4a_transformation_correspondence_params_t correspondence_params;
+    simd_level_t simd_level; // instruction set of the kernels, set with the correspondence params
 } k4a_transformation_rgbz_context_t;
 
 typedef struct _k4a_correspondence_t
@@ -54,32 +79,38 @@ typedef struct _k4a_correspondence_t
     int valid;
 } k4a_correspondence_t;
 
+// Custom values of every channel at the four corners of a quad
+typedef struct _k4a_custom_quad_t
+{
+    uint16_t top_left[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    uint16_t top_right[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    uint16_t bottom_right[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    uint16_t bottom_left[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+} k4a_custom_quad_t;
+
+// Areas of the sub triangles of the triangle that covers an output pixel, see transformation_point_inside_triangle().
+// Custom values of all channels are interpolated from the same areas.
+typedef struct _k4a_triangle_weights_t
+{
+    float area_top_left;     // weight of the bottom right vertex
+    float area_intermediate; // weight of the intermediate vertex
+    float area_bottom_right; // weight of the top left vertex
+    float inverse_area_sum;
+    bool counter_clockwise; // the intermediate vertex is the bottom left vertex, otherwise the top right one
+} k4a_triangle_weights_t;
+
 typedef struct _k4a_bounding_box_t
 {
     int top_left[2];
     int bottom_right[2];
 } k4a_bounding_box_t;
 
-// g_transformation_instruction_type is set to SSE, NEON, None, or NULL
-static char g_transformation_instruction_type[5] = { 0 };
-
-// Share g_transformation_instruction_type with tests to confirm this is built correctly.
-char *transformation_get_instruction_type(void);
-char *transformation_get_instruction_type(void)
+// Share the instruction set of the kernels with tests to confirm this is built correctly. The kernels are picked at
+// runtime, so this is the name of simd_get_level(): None, NEON, SSE, AVX2 or AVX512.
+const char *transformation_get_instruction_type(void);
+const char *transformation_get_instruction_type(void)
 {
-    return g_transformation_instruction_type;
-}
-
-// Set the special instruction
-static void set_special_instruction_optimization(char *opt)
-{
-    // Only set this once
-    if (g_transformation_instruction_type[0] == '\0')
-    {
-        size_t sz = MIN(sizeof(opt), sizeof(g_transformation_instruction_type) - 1);
-        memcpy(g_transformation_instruction_type, opt, sz);
-        LOG_INFO("Compiled special instruction type is: %s\n", opt);
-    }
+    return simd_get_level_name(simd_get_level());
 }
 
 static k4a_transformation_image_descriptor_t
@@ -147,19 +178,29 @@ static k4a_result_t transformation_compute_correspondence(const int depth_index,
         return K4A_RESULT_SUCCEEDED;
     }
 
-    k4a_float3_t depth_point3d;
-    depth_point3d.xyz.z = (float)depth;
-    depth_point3d.xyz.x = context->xy_tables->x_table[depth_index] * depth_point3d.xyz.z;
-    depth_point3d.xyz.y = context->xy_tables->y_table[depth_index] * depth_point3d.xyz.z;
-
     k4a_float3_t color_point3d;
-    if (K4A_FAILED(TRACE_CALL(transformation_3d_to_3d(context->calibration,
-                                                      depth_point3d.v,
-                                                      K4A_CALIBRATION_TYPE_DEPTH,
-                                                      K4A_CALIBRATION_TYPE_COLOR,
-                                                      color_point3d.v))))
+    if (context->ray_tables != NULL)
     {
-        return K4A_RESULT_FAILED;
+        const float *t = context->correspondence_params.translation;
+        color_point3d.xyz.x = (float)depth * context->ray_tables->x_table[depth_index] + t[0];
+        color_point3d.xyz.y = (float)depth * context->ray_tables->y_table[depth_index] + t[1];
+        color_point3d.xyz.z = (float)depth * context->ray_tables->z_table[depth_index] + t[2];
+    }
+    else
+    {
+        k4a_float3_t depth_point3d;
+        depth_point3d.xyz.z = (float)depth;
+        depth_point3d.xyz.x = context->xy_tables->x_table[depth_index] * depth_point3d.xyz.z;
+        depth_point3d.xyz.y = context->xy_tables->y_table[depth_index] * depth_point3d.xyz.z;
+
+        if (K4A_FAILED(TRACE_CALL(transformation_3d_to_3d(context->calibration,
+                                                          depth_point3d.v,
+                                                          K4A_CALIBRATION_TYPE_DEPTH,
+                                                          K4A_CALIBRATION_TYPE_COLOR,
+                                                          color_point3d.v))))
+        {
+            return K4A_RESULT_FAILED;
+        }
     }
     correspondence->depth = color_point3d.xyz.z;
 
@@ -175,6 +216,390 @@ static k4a_result_t transformation_compute_correspondence(const int depth_index,
     return K4A_RESULT_SUCCEEDED;
 }
 
+static k4a_result_t transformation_init_correspondence_params(k4a_transformation_rgbz_context_t *context)
+{
+    context->simd_level = simd_get_level();
+
+    // Project one point through the scalar path so that an unsupported calibration is reported the same way
+    float point3d[3] = { 0.f, 0.f, 1000.f };
+    float point2d[2];
+    int valid;
+    if (K4A_FAILED(TRACE_CALL(transformation_3d_to_2d(context->calibration,
+                                                      point3d,
+                                                      K4A_CALIBRATION_TYPE_DEPTH,
+                                                      K4A_CALIBRATION_TYPE_COLOR,
+                                                      point2d,
+                                                      &valid))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_extrinsics_t *extrinsics =
+        &context->calibration->extrinsics[K4A_CALIBRATION_TYPE_DEPTH][K4A_CALIBRATION_TYPE_COLOR];
+    const k4a_calibration_camera_t *color_calibration = &context->calibration->color_camera_calibration;
+    const k4a_calibration_intrinsic_parameters_t *intrinsics = &color_calibration->intrinsics.parameters;
+    k4a_transformation_correspondence_params_t *params = &context->correspondence_params;
+
+    memcpy(params->rotation, extrinsics->rotation, sizeof(params->rotation));
+    memcpy(params->translation, extrinsics->translation, sizeof(params->translation));
+    params->cx = intrinsics->param.cx;
+    params->cy = intrinsics->param.cy;
+    params->fx = intrinsics->param.fx;
+    params->fy = intrinsics->param.fy;
+    params->k1 = intrinsics->param.k1;
+    params->k2 = intrinsics->param.k2;
+    params->k3 = intrinsics->param.k3;
+    params->k4 = intrinsics->param.k4;
+    params->k5 = intrinsics->param.k5;
+    params->k6 = intrinsics->param.k6;
+    params->codx = intrinsics->param.codx;
+    params->cody = intrinsics->param.cody;
+    params->p1 = intrinsics->param.p1;
+    params->p2 = intrinsics->param.p2;
+    params->tangential_scale =
+        color_calibration->intrinsics.type == K4A_CALIBRATION_LENS_DISTORTION_MODEL_RATIONAL_6KT ? 1.f : 2.f;
+    params->max_radius_square = color_calibration->metric_radius * color_calibration->metric_radius;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// The kernels below compute 8 correspondences at a time with the same operations, in the same order, as
+// transformation_compute_correspondence() does through transformation_3d_to_3d() and transformation_3d_to_2d(), so
+// both paths produce identical results.
+#if defined(K4A_USING_NEON)
+static inline float32x4_t neon_mask_f32(float32x4_t v, uint32x4_t mask)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), mask));
+}
+
+// Projects color camera points qx, qy, qz into the color camera and stores 4 correspondences.
+static inline void transformation_project_correspondences_4(const k4a_transformation_correspondence_params_t *params,
+                                                            uint32x4_t has_depth,
+                                                            float32x4_t qx,
+                                                            float32x4_t qy,
+                                                            float32x4_t qz,
+                                                            k4a_correspondence_t *correspondences)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t two = vdupq_n_f32(2.f);
+
+    uint32x4_t in_front = vcgtq_f32(qz, zero);
+
+    float32x4_t xp = vsubq_f32(vdivq_f32(qx, qz), vdupq_n_f32(params->codx));
+    float32x4_t yp = vsubq_f32(vdivq_f32(qy, qz), vdupq_n_f32(params->cody));
+    float32x4_t xp2 = vmulq_f32(xp, xp);
+    float32x4_t yp2 = vmulq_f32(yp, yp);
+    float32x4_t xyp = vmulq_f32(xp, yp);
+    float32x4_t rs = vaddq_f32(xp2, yp2);
+    uint32x4_t in_radius = vmvnq_u32(vcgtq_f32(rs, vdupq_n_f32(params->max_radius_square)));
+    float32x4_t rss = vmulq_f32(rs, rs);
+    float32x4_t rsc = vmulq_f32(rss, rs);
+    float32x4_t a = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, params->k1)), vmulq_n_f32(rss, params->k2)),
+                              vmulq_n_f32(rsc, params->k3));
+    float32x4_t b = vaddq_f32(vaddq_f32(vaddq_f32(one, vmulq_n_f32(rs, params->k4)), vmulq_n_f32(rss, params->k5)),
+                              vmulq_n_f32(rsc, params->k6));
+    float32x4_t bi = vbslq_f32(vceqq_f32(b, zero), one, vdivq_f32(one, b));
+    float32x4_t d = vmulq_f32(a, bi);
+
+    float32x4_t xp_d = vmulq_f32(xp, d);
+    float32x4_t yp_d = vmulq_f32(yp, d);
+    float32x4_t rs_2xp2 = vaddq_f32(rs, vmulq_f32(two, xp2));
+    float32x4_t rs_2yp2 = vaddq_f32(rs, vmulq_f32(two, yp2));
+    float32x4_t scaled_xyp = vmulq_n_f32(xyp, params->tangential_scale);
+    xp_d = vaddq_f32(xp_d, vaddq_f32(vmulq_n_f32(rs_2xp2, params->p2), vmulq_n_f32(scaled_xyp, params->p1)));
+    yp_d = vaddq_f32(yp_d, vaddq_f32(vmulq_n_f32(rs_2yp2, params->p1), vmulq_n_f32(scaled_xyp, params->p2)));
+
+    float32x4_t u = vaddq_f32(vmulq_n_f32(vaddq_f32(xp_d, vdupq_n_f32(params->codx)), params->fx),
+                              vdupq_n_f32(params->cx));
+    float32x4_t v = vaddq_f32(vmulq_n_f32(vaddq_f32(yp_d, vdupq_n_f32(params->cody)), params->fy),
+                              vdupq_n_f32(params->cy));
+
+    // points without depth are all zero, points behind the color camera have a zero point2d
+    uint32x4_t has_point2d = vandq_u32(has_depth, in_front);
+    uint32x4_t valid = vandq_u32(vandq_u32(has_point2d, in_radius), vdupq_n_u32(1));
+
+    float32x4x4_t store;
+    store.val[0] = neon_mask_f32(u, has_point2d);
+    store.val[1] = neon_mask_f32(v, has_point2d);
+    store.val[2] = neon_mask_f32(qz, has_depth);
+    store.val[3] = vreinterpretq_f32_u32(valid);
+    vst4q_f32((float *)(void *)correspondences, store);
+}
+
+static inline void transformation_compute_correspondences_4(const k4a_transformation_correspondence_params_t *params,
+                                                            float32x4_t x_tab,
+                                                            float32x4_t y_tab,
+                                                            float32x4_t depth,
+                                                            k4a_correspondence_t *correspondences)
+{
+    const float *R = params->rotation;
+    const float *t = params->translation;
+
+    // equivalent to depth != 0 && !isnan(x_tab)
+    uint32x4_t has_depth = vandq_u32(vmvnq_u32(vceqq_f32(depth, vdupq_n_f32(0.f))), vceqq_f32(x_tab, x_tab));
+
+    // unproject with the xy table and move into the color camera
+    float32x4_t x = vmulq_f32(x_tab, depth);
+    float32x4_t y = vmulq_f32(y_tab, depth);
+    float32x4_t qx = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, R[0]), vmulq_n_f32(y, R[1])),
+                                         vmulq_n_f32(depth, R[2])),
+                               vdupq_n_f32(t[0]));
+    float32x4_t qy = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, R[3]), vmulq_n_f32(y, R[4])),
+                                         vmulq_n_f32(depth, R[5])),
+                               vdupq_n_f32(t[1]));
+    float32x4_t qz = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, R[6]), vmulq_n_f32(y, R[7])),
+                                         vmulq_n_f32(depth, R[8])),
+                               vdupq_n_f32(t[2]));
+
+    transformation_project_correspondences_4(params, has_depth, qx, qy, qz, correspondences);
+}
+
+static inline void
+transformation_compute_correspondences_from_rays_4(const k4a_transformation_correspondence_params_t *params,
+                                                   float32x4_t ray_x,
+                                                   float32x4_t ray_y,
+                                                   float32x4_t ray_z,
+                                                   float32x4_t depth,
+                                                   k4a_correspondence_t *correspondences)
+{
+    const float *t = params->translation;
+
+    // equivalent to depth != 0 && !isnan(ray_x)
+    uint32x4_t has_depth = vandq_u32(vmvnq_u32(vceqq_f32(depth, vdupq_n_f32(0.f))), vceqq_f32(ray_x, ray_x));
+
+    float32x4_t qx = vaddq_f32(vmulq_f32(depth, ray_x), vdupq_n_f32(t[0]));
+    float32x4_t qy = vaddq_f32(vmulq_f32(depth, ray_y), vdupq_n_f32(t[1]));
+    float32x4_t qz = vaddq_f32(vmulq_f32(depth, ray_z), vdupq_n_f32(t[2]));
+
+    transformation_project_correspondences_4(params, has_depth, qx, qy, qz, correspondences);
+}
+
+static void transformation_compute_correspondences_8(const k4a_transformation_rgbz_context_t *context,
+                                                     const int depth_index,
+                                                     k4a_correspondence_t *correspondences)
+{
+    const k4a_transformation_correspondence_params_t *params = &context->correspondence_params;
+    uint16x8_t depth = vld1q_u16(context->depth_image.data_uint16 + depth_index);
+    float32x4_t depth_lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(depth)));
+    float32x4_t depth_hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(depth)));
+
+    if (context->ray_tables != NULL)
+    {
+        const float *x_table = context->ray_tables->x_table + depth_index;
+        const float *y_table = context->ray_tables->y_table + depth_index;
+        const float *z_table = context->ray_tables->z_table + depth_index;
+        transformation_compute_correspondences_from_rays_4(
+            params, vld1q_f32(x_table), vld1q_f32(y_table), vld1q_f32(z_table), depth_lo, correspondences);
+        transformation_compute_correspondences_from_rays_4(params,
+                                                           vld1q_f32(x_table + 4),
+                                                           vld1q_f32(y_table + 4),
+                                                           vld1q_f32(z_table + 4),
+                                                           depth_hi,
+                                                           correspondences + 4);
+    }
+    else
+    {
+        const float *x_table = context->xy_tables->x_table + depth_index;
+        const float *y_table = context->xy_tables->y_table + depth_index;
+        transformation_compute_correspondences_4(
+            params, vld1q_f32(x_table), vld1q_f32(y_table), depth_lo, correspondences);
+        transformation_compute_correspondences_4(
+            params, vld1q_f32(x_table + 4), vld1q_f32(y_table + 4), depth_hi, correspondences + 4);
+    }
+}
+
+#elif defined(K4A_USING_SSE)
+// Projects color camera points qx, qy, qz into the color camera and stores 4 correspondences.
+static inline void transformation_project_correspondences_4(const k4a_transformation_correspondence_params_t *params,
+                                                            __m128 has_depth,
+                                                            __m128 qx,
+                                                            __m128 qy,
+                                                            __m128 qz,
+                                                            k4a_correspondence_t *correspondences)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+
+    __m128 in_front = _mm_cmpgt_ps(qz, zero);
+
+    __m128 codx = _mm_set1_ps(params->codx);
+    __m128 cody = _mm_set1_ps(params->cody);
+    __m128 xp = _mm_sub_ps(_mm_div_ps(qx, qz), codx);
+    __m128 yp = _mm_sub_ps(_mm_div_ps(qy, qz), cody);
+    __m128 xp2 = _mm_mul_ps(xp, xp);
+    __m128 yp2 = _mm_mul_ps(yp, yp);
+    __m128 xyp = _mm_mul_ps(xp, yp);
+    __m128 rs = _mm_add_ps(xp2, yp2);
+    __m128 in_radius = _mm_cmpngt_ps(rs, _mm_set1_ps(params->max_radius_square));
+    __m128 rss = _mm_mul_ps(rs, rs);
+    __m128 rsc = _mm_mul_ps(rss, rs);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(params->k1), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(params->k2), rss)),
+                          _mm_mul_ps(_mm_set1_ps(params->k3), rsc));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(params->k4), rs)),
+                                     _mm_mul_ps(_mm_set1_ps(params->k5), rss)),
+                          _mm_mul_ps(_mm_set1_ps(params->k6), rsc));
+    __m128 bi = _mm_blendv_ps(one, _mm_div_ps(one, b), _mm_cmpneq_ps(b, zero));
+    __m128 d = _mm_mul_ps(a, bi);
+
+    __m128 xp_d = _mm_mul_ps(xp, d);
+    __m128 yp_d = _mm_mul_ps(yp, d);
+    __m128 rs_2xp2 = _mm_add_ps(rs, _mm_mul_ps(two, xp2));
+    __m128 rs_2yp2 = _mm_add_ps(rs, _mm_mul_ps(two, yp2));
+    __m128 scaled_xyp = _mm_mul_ps(_mm_set1_ps(params->tangential_scale), xyp);
+    __m128 p1 = _mm_set1_ps(params->p1);
+    __m128 p2 = _mm_set1_ps(params->p2);
+    xp_d = _mm_add_ps(xp_d, _mm_add_ps(_mm_mul_ps(rs_2xp2, p2), _mm_mul_ps(scaled_xyp, p1)));
+    yp_d = _mm_add_ps(yp_d, _mm_add_ps(_mm_mul_ps(rs_2yp2, p1), _mm_mul_ps(scaled_xyp, p2)));
+
+    __m128 u = _mm_add_ps(_mm_mul_ps(_mm_add_ps(xp_d, codx), _mm_set1_ps(params->fx)), _mm_set1_ps(params->cx));
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_add_ps(yp_d, cody), _mm_set1_ps(params->fy)), _mm_set1_ps(params->cy));
+
+    // points without depth are all zero, points behind the color camera have a zero point2d
+    __m128 has_point2d = _mm_and_ps(has_depth, in_front);
+    __m128 valid = _mm_and_ps(_mm_and_ps(has_point2d, in_radius), _mm_castsi128_ps(_mm_set1_epi32(1)));
+
+    u = _mm_and_ps(u, has_point2d);
+    v = _mm_and_ps(v, has_point2d);
+    qz = _mm_and_ps(qz, has_depth);
+
+    // u0 v0 z0 valid0, u1 v1 z1 valid1, ...
+    _MM_TRANSPOSE4_PS(u, v, qz, valid);
+    float *out = (float *)(void *)correspondences;
+    _mm_storeu_ps(out, u);
+    _mm_storeu_ps(out + 4, v);
+    _mm_storeu_ps(out + 8, qz);
+    _mm_storeu_ps(out + 12, valid);
+}
+
+static inline void transformation_compute_correspondences_4(const k4a_transformation_correspondence_params_t *params,
+                                                            __m128 x_tab,
+                                                            __m128 y_tab,
+                                                            __m128 depth,
+                                                            k4a_correspondence_t *correspondences)
+{
+    const float *R = params->rotation;
+    const float *t = params->translation;
+
+    // equivalent to depth != 0 && !isnan(x_tab)
+    __m128 has_depth = _mm_and_ps(_mm_cmpneq_ps(depth, _mm_setzero_ps()), _mm_cmpord_ps(x_tab, x_tab));
+
+    // unproject with the xy table and move into the color camera
+    __m128 x = _mm_mul_ps(x_tab, depth);
+    __m128 y = _mm_mul_ps(y_tab, depth);
+    __m128 qx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(R[0]), x), _mm_mul_ps(_mm_set1_ps(R[1]), y)),
+                                      _mm_mul_ps(_mm_set1_ps(R[2]), depth)),
+                           _mm_set1_ps(t[0]));
+    __m128 qy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(R[3]), x), _mm_mul_ps(_mm_set1_ps(R[4]), y)),
+                                      _mm_mul_ps(_mm_set1_ps(R[5]), depth)),
+                           _mm_set1_ps(t[1]));
+    __m128 qz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(R[6]), x), _mm_mul_ps(_mm_set1_ps(R[7]), y)),
+                                      _mm_mul_ps(_mm_set1_ps(R[8]), depth)),
+                           _mm_set1_ps(t[2]));
+
+    transformation_project_correspondences_4(params, has_depth, qx, qy, qz, correspondences);
+}
+
+static inline void
+transformation_compute_correspondences_from_rays_4(const k4a_transformation_correspondence_params_t *params,
+                                                   __m128 ray_x,
+                                                   __m128 ray_y,
+                                                   __m128 ray_z,
+                                                   __m128 depth,
+                                                   k4a_correspondence_t *correspondences)
+{
+    const float *t = params->translation;
+
+    // equivalent to depth != 0 && !isnan(ray_x)
+    __m128 has_depth = _mm_and_ps(_mm_cmpneq_ps(depth, _mm_setzero_ps()), _mm_cmpord_ps(ray_x, ray_x));
+
+    __m128 qx = _mm_add_ps(_mm_mul_ps(depth, ray_x), _mm_set1_ps(t[0]));
+    __m128 qy = _mm_add_ps(_mm_mul_ps(depth, ray_y), _mm_set1_ps(t[1]));
+    __m128 qz = _mm_add_ps(_mm_mul_ps(depth, ray_z), _mm_set1_ps(t[2]));
+
+    transformation_project_correspondences_4(params, has_depth, qx, qy, qz, correspondences);
+}
+
+static void transformation_compute_correspondences_8(const k4a_transformation_rgbz_context_t *context,
+                                                     const int depth_index,
+                                                     k4a_correspondence_t *correspondences)
+{
+    const k4a_transformation_correspondence_params_t *params = &context->correspondence_params;
+    __m128i depth = _mm_loadu_si128((const __m128i *)(const void *)(context->depth_image.data_uint16 + depth_index));
+    __m128 depth_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(depth, _mm_setzero_si128()));
+    __m128 depth_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(depth, _mm_setzero_si128()));
+
+    if (context->ray_tables != NULL)
+    {
+        const float *x_table = context->ray_tables->x_table + depth_index;
+        const float *y_table = context->ray_tables->y_table + depth_index;
+        const float *z_table = context->ray_tables->z_table + depth_index;
+        transformation_compute_correspondences_from_rays_4(
+            params, _mm_loadu_ps(x_table), _mm_loadu_ps(y_table), _mm_loadu_ps(z_table), depth_lo, correspondences);
+        transformation_compute_correspondences_from_rays_4(params,
+                                                           _mm_loadu_ps(x_table + 4),
+                                                           _mm_loadu_ps(y_table + 4),
+                                                           _mm_loadu_ps(z_table + 4),
+                                                           depth_hi,
+                                                           correspondences + 4);
+    }
+    else
+    {
+        const float *x_table = context->xy_tables->x_table + depth_index;
+        const float *y_table = context->xy_tables->y_table + depth_index;
+        transformation_compute_correspondences_4(
+            params, _mm_loadu_ps(x_table), _mm_loadu_ps(y_table), depth_lo, correspondences);
+        transformation_compute_correspondences_4(
+            params, _mm_loadu_ps(x_table + 4), _mm_loadu_ps(y_table + 4), depth_hi, correspondences + 4);
+    }
+}
+#endif
+
+// Computes the correspondences of count consecutive depth pixels starting at depth_index.
+static k4a_result_t transformation_compute_correspondences(const int depth_index,
+                                                           const int count,
+                                                           const k4a_transformation_rgbz_context_t *context,
+                                                           k4a_correspondence_t *correspondences)
+{
+    int i = 0;
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+    if (context->simd_level != SIMD_LEVEL_NONE)
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            transformation_compute_correspondences_8(context, depth_index + i, correspondences + i);
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
+                depth_index + i, context->depth_image.data_uint16[depth_index + i], context, correspondences + i))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    if (context->output_scale > 1)
+    {
+        // Pixel i of a downscaled output covers color camera pixels i * scale to i * scale + scale - 1. Both paths are
+        // rescaled after the projection, so they still produce identical results.
+        float inverse_scale = 1.f / (float)context->output_scale;
+        float offset = ((float)context->output_scale - 1.f) / 2.f;
+        for (i = 0; i < count; i++)
+        {
+            if (correspondences[i].valid)
+            {
+                correspondences[i].point2d.xy.x = (correspondences[i].point2d.xy.x - offset) * inverse_scale;
+                correspondences[i].point2d.xy.y = (correspondences[i].point2d.xy.y - offset) * inverse_scale;
+            }
+        }
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
 static inline int transformation_min2(const int v1, const int v2)
 {
     return (v1 < v2) ? v1 : v2;
@@ -263,10 +688,8 @@ static bool transformation_check_valid_correspondences(const k4a_correspondence_
                                                        k4a_correspondence_t *valid_top_right,
                                                        k4a_correspondence_t *valid_bottom_right,
                                                        k4a_correspondence_t *valid_bottom_left,
-                                                       uint16_t *custom_top_left,
-                                                       uint16_t *custom_top_right,
-                                                       uint16_t *custom_bottom_right,
-                                                       uint16_t *custom_bottom_left,
+                                                       k4a_custom_quad_t *custom,
+                                                       size_t custom_channel_count,
                                                        bool use_linear_interpolation)
 {
     *valid_top_left = *top_left;
@@ -282,41 +705,53 @@ static bool transformation_check_valid_correspondences(const k4a_correspondence_
     {
         num_invalid++;
         *valid_top_left = transformation_interpolate_correspondences(top_right, bottom_left);
-        *custom_top_left = transformation_interpolate_custom(custom_top_right,
-                                                             custom_bottom_left,
-                                                             custom_bottom_right,
-                                                             use_linear_interpolation);
+        for (size_t c = 0; c < custom_channel_count; c++)
+        {
+            custom->top_left[c] = transformation_interpolate_custom(&custom->top_right[c],
+                                                                    &custom->bottom_left[c],
+                                                                    &custom->bottom_right[c],
+                                                                    use_linear_interpolation);
+        }
     }
     if (top_right->valid == 0)
     {
         num_invalid++;
         *valid_top_right = *bottom_right;
         *valid_bottom_right = transformation_interpolate_correspondences(bottom_right, bottom_left);
-        *custom_top_right = *custom_bottom_right;
-        *custom_bottom_right = transformation_interpolate_custom(custom_bottom_right,
-                                                                 custom_bottom_left,
-                                                                 custom_bottom_left,
-                                                                 use_linear_interpolation);
+        for (size_t c = 0; c < custom_channel_count; c++)
+        {
+            custom->top_right[c] = custom->bottom_right[c];
+            custom->bottom_right[c] = transformation_interpolate_custom(&custom->bottom_right[c],
+                                                                        &custom->bottom_left[c],
+                                                                        &custom->bottom_left[c],
+                                                                        use_linear_interpolation);
+        }
     }
     if (bottom_right->valid == 0)
     {
         num_invalid++;
         *valid_bottom_right = transformation_interpolate_correspondences(top_right, bottom_left);
-        *custom_bottom_right = transformation_interpolate_custom(custom_top_right,
-                                                                 custom_bottom_left,
-                                                                 custom_top_left,
-                                                                 use_linear_interpolation);
+        for (size_t c = 0; c < custom_channel_count; c++)
+        {
+            custom->bottom_right[c] = transformation_interpolate_custom(&custom->top_right[c],
+                                                                        &custom->bottom_left[c],
+                                                                        &custom->top_left[c],
+                                                                        use_linear_interpolation);
+        }
     }
     if (bottom_left->valid == 0)
     {
         num_invalid++;
         *valid_bottom_left = *bottom_right;
         *valid_bottom_right = transformation_interpolate_correspondences(top_right, bottom_right);
-        *custom_bottom_left = *custom_bottom_right;
-        *custom_bottom_right = transformation_interpolate_custom(custom_top_right,
-                                                                 custom_bottom_right,
-                                                                 custom_top_right,
-                                                                 use_linear_interpolation);
+        for (size_t c = 0; c < custom_channel_count; c++)
+        {
+            custom->bottom_left[c] = custom->bottom_right[c];
+            custom->bottom_right[c] = transformation_interpolate_custom(&custom->top_right[c],
+                                                                        &custom->bottom_right[c],
+                                                                        &custom->top_right[c],
+                                                                        use_linear_interpolation);
+        }
     }
 
     // If two or more vertices are invalid then we can't create a valid triangle
@@ -358,15 +793,11 @@ static inline float transformation_area_function(const k4a_float2_t *a, const k4
 static bool transformation_point_inside_triangle(const k4a_correspondence_t *valid_top_left,
                                                  const k4a_correspondence_t *valid_intermediate,
                                                  const k4a_correspondence_t *valid_bottom_right,
-                                                 uint16_t custom_top_left,
-                                                 uint16_t custom_intermediate,
-                                                 uint16_t custom_bottom_right,
                                                  const k4a_float2_t *point,
                                                  float area_intermediate,
                                                  bool counter_clockwise,
                                                  float *depth,
-                                                 float *custom,
-                                                 bool use_linear_interpolation)
+                                                 k4a_triangle_weights_t *weights)
 {
     // Calculate sub triangle areas
     float area_top_left = transformation_area_function(&valid_intermediate->point2d, &valid_top_left->point2d, point);
@@ -398,25 +829,11 @@ static bool transformation_point_inside_triangle(const k4a_correspondence_t *val
                   area_bottom_right * valid_top_left->depth) *
                  sum_weights;
 
-        if (use_linear_interpolation)
-        {
-            *custom = (area_top_left * (float)custom_bottom_right + area_intermediate * (float)custom_intermediate +
-                       area_bottom_right * (float)custom_top_left) *
-                      sum_weights;
-        }
-        else
-        {
-            // Select custom based on highest weight (nearest neighbor)
-            if (area_top_left > area_intermediate)
-            {
-                *custom = area_top_left > area_bottom_right ? (float)custom_bottom_right : (float)custom_top_left;
-            }
-            else
-            {
-                *custom = area_intermediate > area_bottom_right ? (float)custom_intermediate : (float)custom_top_left;
-            }
-        }
-
+        weights->area_top_left = area_top_left;
+        weights->area_intermediate = area_intermediate;
+        weights->area_bottom_right = area_bottom_right;
+        weights->inverse_area_sum = sum_weights;
+        weights->counter_clockwise = counter_clockwise;
         return true;
     }
 
@@ -427,14 +844,9 @@ static bool transformation_point_inside_quad(const k4a_correspondence_t *valid_t
                                              const k4a_correspondence_t *valid_top_right,
                                              const k4a_correspondence_t *valid_bottom_right,
                                              const k4a_correspondence_t *valid_bottom_left,
-                                             uint16_t custom_top_left,
-                                             uint16_t custom_top_right,
-                                             uint16_t custom_bottom_right,
-                                             uint16_t custom_bottom_left,
                                              const k4a_float2_t *point,
                                              float *depth,
-                                             float *custom,
-                                             bool use_linear_interpolation)
+                                             k4a_triangle_weights_t *weights)
 {
     // Calculate area to see if point is to the left or right of vector (valid_top_left - valid_bottom_right).
     // Set counter_clockwise flag true for all positions to the right of the aforementioned vector.
@@ -447,48 +859,78 @@ static bool transformation_point_inside_quad(const k4a_correspondence_t *valid_t
     return transformation_point_inside_triangle(valid_top_left,
                                                 counter_clockwise ? valid_bottom_left : valid_top_right,
                                                 valid_bottom_right,
-                                                custom_top_left,
-                                                counter_clockwise ? custom_bottom_left : custom_top_right,
-                                                custom_bottom_right,
                                                 point,
                                                 area_intermediate,
                                                 counter_clockwise,
                                                 depth,
-                                                custom,
-                                                use_linear_interpolation);
-}
-
-static void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box,
-                                          const k4a_correspondence_t *valid_top_left,
-                                          const k4a_correspondence_t *valid_top_right,
-                                          const k4a_correspondence_t *valid_bottom_right,
-                                          const k4a_correspondence_t *valid_bottom_left,
-                                          uint16_t custom_top_left,
-                                          uint16_t custom_top_right,
-                                          uint16_t custom_bottom_right,
-                                          uint16_t custom_bottom_left,
-                                          bool use_linear_interpolation,
-                                          bool enable_custom8,
-                                          bool enable_custom16,
-                                          k4a_transformation_output_image_t *depth_out,
-                                          k4a_transformation_output_image_t *custom_out)
+                                                weights);
+}
+
+// Interpolates the value of custom channel c at an output pixel from the weights of the triangle that covers it
+static inline float transformation_interpolate_triangle_custom(const k4a_custom_quad_t *custom,
+                                                               size_t c,
+                                                               const k4a_triangle_weights_t *weights,
+                                                               bool use_linear_interpolation)
+{
+    float custom_top_left = (float)custom->top_left[c];
+    float custom_intermediate = (float)(weights->counter_clockwise ? custom->bottom_left[c] : custom->top_right[c]);
+    float custom_bottom_right = (float)custom->bottom_right[c];
+
+    if (use_linear_interpolation)
+    {
+        return (weights->area_top_left * custom_bottom_right + weights->area_intermediate * custom_intermediate +
+                weights->area_bottom_right * custom_top_left) *
+               weights->inverse_area_sum;
+    }
+
+    // Select custom based on highest weight (nearest neighbor)
+    if (weights->area_top_left > weights->area_intermediate)
+    {
+        return weights->area_top_left > weights->area_bottom_right ? custom_bottom_right : custom_top_left;
+    }
+    return weights->area_intermediate > weights->area_bottom_right ? custom_intermediate : custom_top_left;
+}
+
+// Layouts of the custom channels that the rasterization kernels are specialized for
+typedef enum
+{
+    TRANSFORMATION_CUSTOM_LAYOUT_NONE = 0, // no custom channels
+    TRANSFORMATION_CUSTOM_LAYOUT_8,        // only K4A_IMAGE_FORMAT_CUSTOM8 channels
+    TRANSFORMATION_CUSTOM_LAYOUT_16,       // only K4A_IMAGE_FORMAT_CUSTOM16 channels
+    TRANSFORMATION_CUSTOM_LAYOUT_MIXED,    // both, the format is checked per channel
+} k4a_transformation_custom_layout_t;
+
+static inline bool transformation_custom_layout_is_custom16(k4a_transformation_custom_layout_t custom_layout,
+                                                           const k4a_transformation_custom_channel_t *channel)
+{
+    return custom_layout == TRANSFORMATION_CUSTOM_LAYOUT_16 ||
+           (custom_layout == TRANSFORMATION_CUSTOM_LAYOUT_MIXED && channel->is_custom16);
+}
+
+// Always inlined into the kernels of transformation_depth_to_color_quad_row(), where use_linear_interpolation and
+// custom_layout are constants, so the inner loop has no branches on them.
+static FORCEINLINE void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box,
+                                                      const k4a_correspondence_t *valid_top_left,
+                                                      const k4a_correspondence_t *valid_top_right,
+                                                      const k4a_correspondence_t *valid_bottom_right,
+                                                      const k4a_correspondence_t *valid_bottom_left,
+                                                      const k4a_custom_quad_t *custom,
+                                                      bool use_linear_interpolation,
+                                                      k4a_transformation_custom_layout_t custom_layout,
+                                                      k4a_transformation_output_image_t *depth_out,
+                                                      k4a_transformation_custom_channel_t *custom_channels,
+                                                      size_t custom_channel_count)
 {
+    if (custom_layout == TRANSFORMATION_CUSTOM_LAYOUT_NONE)
+    {
+        custom_channel_count = 0;
+    }
+
     k4a_float2_t point;
     for (int y = bounding_box->top_left[1]; y < bounding_box->bottom_right[1]; y++)
     {
         uint16_t *depth_row = depth_out->data_uint16 + y * depth_out->descriptor->width_pixels;
 
-        uint8_t *custom8_row = 0;
-        uint16_t *custom16_row = 0;
-        if (enable_custom8)
-        {
-            custom8_row = custom_out->data_uint8 + y * custom_out->descriptor->width_pixels;
-        }
-        else if (enable_custom16)
-        {
-            custom16_row = custom_out->data_uint16 + y * custom_out->descriptor->width_pixels;
-        }
-
         point.xy.y = (float)y;
 
         for (int x = bounding_box->top_left[0]; x < bounding_box->bottom_right[0]; x++)
@@ -496,19 +938,14 @@ static void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box
             point.xy.x = (float)x;
 
             float interpolated_depth = 0.0f;
-            float interpolated_custom = 0.0f;
+            k4a_triangle_weights_t weights;
             if (transformation_point_inside_quad(valid_top_left,
                                                  valid_top_right,
                                                  valid_bottom_right,
                                                  valid_bottom_left,
-                                                 custom_top_left,
-                                                 custom_top_right,
-                                                 custom_bottom_right,
-                                                 custom_bottom_left,
                                                  &point,
                                                  &interpolated_depth,
-                                                 &interpolated_custom,
-                                                 use_linear_interpolation))
+                                                 &weights))
             {
                 uint16_t depth = (uint16_t)(interpolated_depth + 0.5f);
 
@@ -517,13 +954,21 @@ static void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box
                 {
                     depth_row[x] = depth;
 
-                    if (enable_custom8)
-                    {
-                        custom8_row[x] = (uint8_t)(interpolated_custom + 0.5f);
-                    }
-                    else if (enable_custom16)
+                    // All channels share the triangle weights, custom values are only interpolated for visible pixels
+                    for (size_t c = 0; c < custom_channel_count; c++)
                     {
-                        custom16_row[x] = (uint16_t)(interpolated_custom + 0.5f);
+                        k4a_transformation_output_image_t *custom_out = &custom_channels[c].transformed_image;
+                        int pixel = y * custom_out->descriptor->width_pixels + x;
+                        float interpolated_custom = transformation_interpolate_triangle_custom(
+                            custom, c, &weights, use_linear_interpolation);
+                        if (transformation_custom_layout_is_custom16(custom_layout, &custom_channels[c]))
+                        {
+                            custom_out->data_uint16[pixel] = (uint16_t)(interpolated_custom + 0.5f);
+                        }
+                        else
+                        {
+                            custom_out->data_uint8[pixel] = (uint8_t)(interpolated_custom + 0.5f);
+                        }
                     }
                 }
             }
@@ -531,176 +976,447 @@ static void transformation_draw_rectangle(const k4a_bounding_box_t *bounding_box
     }
 }
 
-static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_context_t *context)
+static void transformation_depth_to_color_clear(k4a_transformation_rgbz_context_t *context, int first_row, int last_row)
 {
-    memset(context->transformed_image.data_uint8,
+    memset(context->transformed_image.data_uint8 + first_row * context->transformed_image.descriptor->stride_bytes,
            0,
-           (size_t)(context->transformed_image.descriptor->stride_bytes *
-                    context->transformed_image.descriptor->height_pixels));
+           (size_t)(context->transformed_image.descriptor->stride_bytes * (last_row - first_row)));
 
-    if (context->enable_custom8)
+    for (size_t c = 0; c < context->custom_channel_count; c++)
     {
-        int num_pixels = context->transformed_custom_image.descriptor->width_pixels *
-                         context->transformed_custom_image.descriptor->height_pixels;
-        for (int i = 0; i < num_pixels; i++)
+        k4a_transformation_custom_channel_t *channel = &context->custom_channels[c];
+        int width = channel->transformed_image.descriptor->width_pixels;
+        if (channel->is_custom16)
+        {
+            for (int i = first_row * width; i < last_row * width; i++)
+            {
+                channel->transformed_image.data_uint16[i] = channel->invalid_value;
+            }
+        }
+        else
         {
-            context->transformed_custom_image.data_uint8[i] = (uint8_t)context->invalid_value;
+            memset(channel->transformed_image.data_uint8 + first_row * width,
+                   (uint8_t)channel->invalid_value,
+                   (size_t)((last_row - first_row) * width));
         }
     }
-    else if (context->enable_custom16)
+}
+
+// Rasterizes the quad whose bottom right corner is depth pixel (x, y). Only output rows in [first_row, last_row) are
+// written, which lets several threads share one output image without overlapping writes.
+static FORCEINLINE void transformation_depth_to_color_quad(k4a_transformation_rgbz_context_t *context,
+                                                           int x,
+                                                           int y,
+                                                           const k4a_correspondence_t *top_left,
+                                                           const k4a_correspondence_t *top_right,
+                                                           const k4a_correspondence_t *bottom_right,
+                                                           const k4a_correspondence_t *bottom_left,
+                                                           bool use_linear_interpolation,
+                                                           k4a_transformation_custom_layout_t custom_layout,
+                                                           int first_row,
+                                                           int last_row)
+{
+    size_t custom_channel_count = context->custom_channel_count;
+    if (custom_layout == TRANSFORMATION_CUSTOM_LAYOUT_NONE)
+    {
+        custom_channel_count = 0;
+    }
+    k4a_custom_quad_t custom;
+    for (size_t c = 0; c < custom_channel_count; c++)
     {
-        int num_pixels = context->transformed_custom_image.descriptor->width_pixels *
-                         context->transformed_custom_image.descriptor->height_pixels;
-        for (int i = 0; i < num_pixels; i++)
+        const k4a_transformation_input_image_t *custom_image = &context->custom_channels[c].image;
+        int custom_width = custom_image->descriptor->width_pixels;
+        if (transformation_custom_layout_is_custom16(custom_layout, &context->custom_channels[c]))
+        {
+            custom.top_left[c] = custom_image->data_uint16[(y - 1) * custom_width + x - 1];
+            custom.top_right[c] = custom_image->data_uint16[(y - 1) * custom_width + x];
+            custom.bottom_right[c] = custom_image->data_uint16[y * custom_width + x];
+            custom.bottom_left[c] = custom_image->data_uint16[y * custom_width + x - 1];
+        }
+        else
         {
-            context->transformed_custom_image.data_uint16[i] = context->invalid_value;
+            custom.top_left[c] = custom_image->data_uint8[(y - 1) * custom_width + x - 1];
+            custom.top_right[c] = custom_image->data_uint8[(y - 1) * custom_width + x];
+            custom.bottom_right[c] = custom_image->data_uint8[y * custom_width + x];
+            custom.bottom_left[c] = custom_image->data_uint8[y * custom_width + x - 1];
         }
     }
 
+    k4a_correspondence_t valid_top_left, valid_top_right, valid_bottom_right, valid_bottom_left;
+    if (transformation_check_valid_correspondences(top_left,
+                                                   top_right,
+                                                   bottom_right,
+                                                   bottom_left,
+                                                   &valid_top_left,
+                                                   &valid_top_right,
+                                                   &valid_bottom_right,
+                                                   &valid_bottom_left,
+                                                   &custom,
+                                                   custom_channel_count,
+                                                   use_linear_interpolation))
+    {
+        k4a_bounding_box_t bounding_box =
+            transformation_compute_bounding_box(&valid_top_left,
+                                                &valid_top_right,
+                                                &valid_bottom_right,
+                                                &valid_bottom_left,
+                                                context->transformed_image.descriptor->width_pixels,
+                                                context->transformed_image.descriptor->height_pixels);
+        bounding_box.top_left[1] = transformation_max2(bounding_box.top_left[1], first_row);
+        bounding_box.bottom_right[1] = transformation_min2(bounding_box.bottom_right[1], last_row);
+
+        transformation_draw_rectangle(&bounding_box,
+                                      &valid_top_left,
+                                      &valid_top_right,
+                                      &valid_bottom_right,
+                                      &valid_bottom_left,
+                                      &custom,
+                                      use_linear_interpolation,
+                                      custom_layout,
+                                      &context->transformed_image,
+                                      context->custom_channels,
+                                      custom_channel_count);
+    }
+}
+
+// Rasterizes the row of quads between depth rows y - 1 and y into the output rows [first_row, last_row)
+typedef void (*k4a_transformation_quad_row_fn)(k4a_transformation_rgbz_context_t *context,
+                                               int y,
+                                               const k4a_correspondence_t *top_row,
+                                               const k4a_correspondence_t *bottom_row,
+                                               int first_row,
+                                               int last_row);
+
+// Defines a kernel of transformation_depth_to_color_quad_row() for one interpolation type and custom layout
+#define TRANSFORMATION_DEFINE_QUAD_ROW(_name_, _use_linear_interpolation_, _custom_layout_)                            \
+    static void transformation_depth_to_color_quad_row_##_name_(k4a_transformation_rgbz_context_t *context,           \
+                                                                int y,                                                 \
+                                                                const k4a_correspondence_t *top_row,                   \
+                                                                const k4a_correspondence_t *bottom_row,                \
+                                                                int first_row,                                         \
+                                                                int last_row)                                          \
+    {                                                                                                                  \
+        int width = context->depth_image.descriptor->width_pixels;                                                     \
+        for (int x = 1; x < width; x++)                                                                                \
+        {                                                                                                              \
+            transformation_depth_to_color_quad(context,                                                                \
+                                               x,                                                                      \
+                                               y,                                                                      \
+                                               &top_row[x - 1],                                                        \
+                                               &top_row[x],                                                            \
+                                               &bottom_row[x],                                                         \
+                                               &bottom_row[x - 1],                                                     \
+                                               _use_linear_interpolation_,                                             \
+                                               _custom_layout_,                                                        \
+                                               first_row,                                                              \
+                                               last_row);                                                              \
+        }                                                                                                              \
+    }
+
+TRANSFORMATION_DEFINE_QUAD_ROW(nearest, false, TRANSFORMATION_CUSTOM_LAYOUT_NONE)
+TRANSFORMATION_DEFINE_QUAD_ROW(nearest_custom8, false, TRANSFORMATION_CUSTOM_LAYOUT_8)
+TRANSFORMATION_DEFINE_QUAD_ROW(nearest_custom16, false, TRANSFORMATION_CUSTOM_LAYOUT_16)
+TRANSFORMATION_DEFINE_QUAD_ROW(nearest_custom_mixed, false, TRANSFORMATION_CUSTOM_LAYOUT_MIXED)
+TRANSFORMATION_DEFINE_QUAD_ROW(linear, true, TRANSFORMATION_CUSTOM_LAYOUT_NONE)
+TRANSFORMATION_DEFINE_QUAD_ROW(linear_custom8, true, TRANSFORMATION_CUSTOM_LAYOUT_8)
+TRANSFORMATION_DEFINE_QUAD_ROW(linear_custom16, true, TRANSFORMATION_CUSTOM_LAYOUT_16)
+TRANSFORMATION_DEFINE_QUAD_ROW(linear_custom_mixed, true, TRANSFORMATION_CUSTOM_LAYOUT_MIXED)
+
+// Selects the kernel for the interpolation type and custom channels of a call
+static k4a_transformation_quad_row_fn transformation_depth_to_color_quad_row(
+    const k4a_transformation_rgbz_context_t *context)
+{
+    static const k4a_transformation_quad_row_fn kernels[2][4] = {
+        { transformation_depth_to_color_quad_row_nearest,
+          transformation_depth_to_color_quad_row_nearest_custom8,
+          transformation_depth_to_color_quad_row_nearest_custom16,
+          transformation_depth_to_color_quad_row_nearest_custom_mixed },
+        { transformation_depth_to_color_quad_row_linear,
+          transformation_depth_to_color_quad_row_linear_custom8,
+          transformation_depth_to_color_quad_row_linear_custom16,
+          transformation_depth_to_color_quad_row_linear_custom_mixed },
+    };
+
+    size_t custom16_count = 0;
+    for (size_t c = 0; c < context->custom_channel_count; c++)
+    {
+        custom16_count += context->custom_channels[c].is_custom16 ? 1 : 0;
+    }
+
+    k4a_transformation_custom_layout_t custom_layout = TRANSFORMATION_CUSTOM_LAYOUT_MIXED;
+    if (context->custom_channel_count == 0)
+    {
+        custom_layout = TRANSFORMATION_CUSTOM_LAYOUT_NONE;
+    }
+    else if (custom16_count == 0)
+    {
+        custom_layout = TRANSFORMATION_CUSTOM_LAYOUT_8;
+    }
+    else if (custom16_count == context->custom_channel_count)
+    {
+        custom_layout = TRANSFORMATION_CUSTOM_LAYOUT_16;
+    }
+
     bool use_linear_interpolation = context->interpolation_type == K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR;
+    return kernels[use_linear_interpolation ? 1 : 0][custom_layout];
+}
+
+static k4a_result_t transformation_depth_to_color_single_thread(k4a_transformation_rgbz_context_t *context)
+{
+    int output_height = context->transformed_image.descriptor->height_pixels;
+    transformation_depth_to_color_clear(context, 0, output_height);
+
+    k4a_transformation_quad_row_fn quad_row = transformation_depth_to_color_quad_row(context);
 
-    k4a_correspondence_t *vertex_row = (k4a_correspondence_t *)malloc(
-        (size_t)context->depth_image.descriptor->width_pixels * sizeof(k4a_correspondence_t));
+    int width = context->depth_image.descriptor->width_pixels;
+    k4a_correspondence_t *vertex_rows = (k4a_correspondence_t *)malloc(2 * (size_t)width *
+                                                                     sizeof(k4a_correspondence_t));
+    k4a_correspondence_t *top_row = vertex_rows;
+    k4a_correspondence_t *bottom_row = vertex_rows + width;
 
-    int idx = 0;
-    for (; idx < context->depth_image.descriptor->width_pixels; idx++)
+    if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondences(0, width, context, top_row))))
     {
-        if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
-                idx, context->depth_image.data_uint16[idx], context, vertex_row + idx))))
-        {
-            free(vertex_row);
-            return K4A_RESULT_FAILED;
-        }
+        free(vertex_rows);
+        return K4A_RESULT_FAILED;
     }
 
     for (int y = 1; y < context->depth_image.descriptor->height_pixels; y++)
     {
-        k4a_correspondence_t top_left = vertex_row[0];
-        k4a_correspondence_t bottom_left;
-        if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
-                idx, context->depth_image.data_uint16[idx], context, &bottom_left))))
+        if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondences(y * width, width, context, bottom_row))))
         {
-            free(vertex_row);
+            free(vertex_rows);
             return K4A_RESULT_FAILED;
         }
-        idx++;
-        vertex_row[0] = bottom_left;
 
-        for (int x = 1; x < context->depth_image.descriptor->width_pixels; x++, idx++)
+        quad_row(context, y, top_row, bottom_row, 0, output_height);
+
+        k4a_correspondence_t *swap = top_row;
+        top_row = bottom_row;
+        bottom_row = swap;
+    }
+    free(vertex_rows);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+typedef struct _k4a_transformation_band_t
+{
+    k4a_transformation_rgbz_context_t *context;
+    k4a_correspondence_t *correspondences; // correspondence of every depth pixel
+    float *row_min_y;                      // smallest color y of the valid correspondences of each depth row
+    float *row_max_y;                      // largest color y of the valid correspondences of each depth row
+    int first_row;                         // first row of the band
+    int last_row;                          // one past the last row of the band
+    k4a_result_t result;
+} k4a_transformation_band_t;
+
+// Computes the correspondences of the depth rows [first_row, last_row) of the band.
+static int transformation_depth_to_color_correspondence_band(void *param)
+{
+    k4a_transformation_band_t *band = (k4a_transformation_band_t *)param;
+    k4a_transformation_rgbz_context_t *context = band->context;
+    int width = context->depth_image.descriptor->width_pixels;
+
+    band->result = K4A_RESULT_SUCCEEDED;
+    for (int y = band->first_row; y < band->last_row && K4A_SUCCEEDED(band->result); y++)
+    {
+        k4a_correspondence_t *row = band->correspondences + y * width;
+        band->result = TRACE_CALL(transformation_compute_correspondences(y * width, width, context, row));
+
+        float min_y = FLT_MAX;
+        float max_y = -FLT_MAX;
+        for (int x = 0; x < width; x++)
         {
-            k4a_correspondence_t top_right = vertex_row[x];
-            k4a_correspondence_t bottom_right;
-            if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
-                    idx, context->depth_image.data_uint16[idx], context, &bottom_right))))
+            if (row[x].valid)
             {
-                free(vertex_row);
-                return K4A_RESULT_FAILED;
+                min_y = transformation_min2f(min_y, row[x].point2d.xy.y);
+                max_y = transformation_max2f(max_y, row[x].point2d.xy.y);
             }
+        }
+        band->row_min_y[y] = min_y;
+        band->row_max_y[y] = max_y;
+    }
+    return 0;
+}
 
-            uint16_t custom_top_left = 0;
-            uint16_t custom_top_right = 0;
-            uint16_t custom_bottom_right = 0;
-            uint16_t custom_bottom_left = 0;
+// Rasterizes every quad into the output rows [first_row, last_row) of the band. Each output pixel is owned by exactly
+// one band and quads are visited in the same order as the single threaded path, so the min-depth rule in
+// transformation_draw_rectangle() resolves overlapping quads exactly like it does on a single thread.
+static int transformation_depth_to_color_raster_band(void *param)
+{
+    k4a_transformation_band_t *band = (k4a_transformation_band_t *)param;
+    k4a_transformation_rgbz_context_t *context = band->context;
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
 
-            if (context->enable_custom8)
-            {
-                int custom_width = context->custom_image.descriptor->width_pixels;
-                custom_top_left = context->custom_image.data_uint8[(y - 1) * custom_width + x - 1];
-                custom_top_right = context->custom_image.data_uint8[(y - 1) * custom_width + x];
-                custom_bottom_right = context->custom_image.data_uint8[y * custom_width + x];
-                custom_bottom_left = context->custom_image.data_uint8[y * custom_width + x - 1];
-            }
-            else if (context->enable_custom16)
-            {
-                int custom_width = context->custom_image.descriptor->width_pixels;
-                custom_top_left = context->custom_image.data_uint16[(y - 1) * custom_width + x - 1];
-                custom_top_right = context->custom_image.data_uint16[(y - 1) * custom_width + x];
-                custom_bottom_right = context->custom_image.data_uint16[y * custom_width + x];
-                custom_bottom_left = context->custom_image.data_uint16[y * custom_width + x - 1];
-            }
+    transformation_depth_to_color_clear(context, band->first_row, band->last_row);
 
-            k4a_correspondence_t valid_top_left, valid_top_right, valid_bottom_right, valid_bottom_left;
-            if (transformation_check_valid_correspondences(&top_left,
-                                                           &top_right,
-                                                           &bottom_right,
-                                                           &bottom_left,
-                                                           &valid_top_left,
-                                                           &valid_top_right,
-                                                           &valid_bottom_right,
-                                                           &valid_bottom_left,
-                                                           &custom_top_left,
-                                                           &custom_top_right,
-                                                           &custom_bottom_right,
-                                                           &custom_bottom_left,
-                                                           use_linear_interpolation))
-            {
-                k4a_bounding_box_t bounding_box =
-                    transformation_compute_bounding_box(&valid_top_left,
-                                                        &valid_top_right,
-                                                        &valid_bottom_right,
-                                                        &valid_bottom_left,
-                                                        context->transformed_image.descriptor->width_pixels,
-                                                        context->transformed_image.descriptor->height_pixels);
-
-                transformation_draw_rectangle(&bounding_box,
-                                              &valid_top_left,
-                                              &valid_top_right,
-                                              &valid_bottom_right,
-                                              &valid_bottom_left,
-                                              custom_top_left,
-                                              custom_top_right,
-                                              custom_bottom_right,
-                                              custom_bottom_left,
-                                              use_linear_interpolation,
-                                              context->enable_custom8,
-                                              context->enable_custom16,
-                                              &context->transformed_image,
-                                              &context->transformed_custom_image);
-            }
+    k4a_transformation_quad_row_fn quad_row = transformation_depth_to_color_quad_row(context);
 
-            vertex_row[x] = bottom_right;
-            top_left = top_right;
-            bottom_left = bottom_right;
+    for (int y = 1; y < height; y++)
+    {
+        // Valid quads only use valid corners or midpoints of them, so a row of quads can not reach past the color
+        // rows spanned by the valid correspondences of its two depth rows.
+        float min_y = transformation_min2f(band->row_min_y[y - 1], band->row_min_y[y]);
+        float max_y = transformation_max2f(band->row_max_y[y - 1], band->row_max_y[y]);
+        if (min_y > max_y || (int)(ceilf(max_y)) <= band->first_row || (int)(ceilf(min_y)) >= band->last_row)
+        {
+            continue;
         }
+
+        const k4a_correspondence_t *top_row = band->correspondences + (y - 1) * width;
+        const k4a_correspondence_t *bottom_row = band->correspondences + y * width;
+        quad_row(context, y, top_row, bottom_row, band->first_row, band->last_row);
     }
-    free(vertex_row);
-    return K4A_RESULT_SUCCEEDED;
+
+    band->result = K4A_RESULT_SUCCEEDED;
+    return 0;
 }
 
-k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_parameters(
-    const k4a_calibration_t *calibration,
-    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
-    const uint8_t *depth_image_data,
-    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-    const uint8_t *custom_image_data,
-    const k4a_transformation_image_descriptor_t *custom_image_descriptor,
-    uint8_t *transformed_depth_image_data,
-    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
-    uint8_t *transformed_custom_image_data,
-    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor)
+// Splits rows [0, height) into band_count horizontal bands and runs worker on each of them on the shared thread pool.
+// The calling thread runs bands as well, so every band runs even when the pool has no threads.
+static k4a_result_t transformation_run_bands(k4a_transformation_band_t *bands,
+                                             int band_count,
+                                             int height,
+                                             THREAD_START_FUNC worker)
 {
-    if (depth_image_descriptor == 0 || custom_image_descriptor == 0 || transformed_depth_image_descriptor == 0 ||
-        transformed_custom_image_descriptor == 0)
+    for (int i = 0; i < band_count; i++)
     {
-        return K4A_BUFFER_RESULT_FAILED;
+        bands[i].first_row = height * i / band_count;
+        bands[i].last_row = height * (i + 1) / band_count;
+        bands[i].result = K4A_RESULT_FAILED;
     }
 
-    if (calibration == 0)
+    threadpool_run_tasks(worker, bands, sizeof(k4a_transformation_band_t), (uint32_t)band_count);
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (int i = 0; i < band_count; i++)
     {
-        LOG_ERROR("Calibration is null.", 0);
-        return K4A_BUFFER_RESULT_FAILED;
+        if (K4A_FAILED(bands[i].result))
+        {
+            result = K4A_RESULT_FAILED;
+        }
     }
+    return result;
+}
 
-    if (xy_tables_depth_camera == 0)
+static k4a_result_t transformation_depth_to_color_multi_thread(k4a_transformation_rgbz_context_t *context)
+{
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
+    int output_height = context->transformed_image.descriptor->height_pixels;
+    int band_count = (int)context->thread_count;
+    band_count = transformation_min2(band_count, transformation_min2(height, output_height));
+
+    k4a_transformation_band_t bands[TRANSFORMATION_MAX_THREAD_COUNT];
+    k4a_correspondence_t *correspondences = (k4a_correspondence_t *)malloc((size_t)width * (size_t)height *
+                                                                         sizeof(k4a_correspondence_t));
+    float *row_min_y = (float *)malloc((size_t)height * sizeof(float));
+    float *row_max_y = (float *)malloc((size_t)height * sizeof(float));
+
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(correspondences != NULL && row_min_y != NULL && row_max_y != NULL);
+
+    if (K4A_SUCCEEDED(result))
     {
-        LOG_ERROR("Depth camera xy table is null.", 0);
-        return K4A_BUFFER_RESULT_FAILED;
+        for (int i = 0; i < band_count; i++)
+        {
+            bands[i].context = context;
+            bands[i].correspondences = correspondences;
+            bands[i].row_min_y = row_min_y;
+            bands[i].row_max_y = row_max_y;
+        }
+
+        // Correspondences of the depth image are computed in depth row bands
+        result = TRACE_CALL(
+            transformation_run_bands(bands, band_count, height, transformation_depth_to_color_correspondence_band));
     }
 
-    if (depth_image_data == 0)
+    if (K4A_SUCCEEDED(result))
     {
-        LOG_ERROR("Depth image data is null.", 0);
-        return K4A_BUFFER_RESULT_FAILED;
+        // The output image is rasterized in color row bands
+        result = TRACE_CALL(
+            transformation_run_bands(bands, band_count, output_height, transformation_depth_to_color_raster_band));
+    }
+
+    free(correspondences);
+    free(row_min_y);
+    free(row_max_y);
+    return result;
+}
+
+static k4a_result_t transformation_depth_to_color(k4a_transformation_rgbz_context_t *context)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_init_correspondence_params(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (context->thread_count > 1)
+    {
+        return transformation_depth_to_color_multi_thread(context);
+    }
+    return transformation_depth_to_color_single_thread(context);
+}
+
+int transformation_get_depth_to_color_scale(const k4a_calibration_camera_t *color_camera_calibration,
+                                            const k4a_transformation_image_descriptor_t *transformed_image_descriptor)
+{
+    int width = color_camera_calibration->resolution_width;
+    int height = color_camera_calibration->resolution_height;
+    const k4a_transformation_image_descriptor_t *descriptor = transformed_image_descriptor;
+
+    if (descriptor == NULL || descriptor->format != K4A_IMAGE_FORMAT_DEPTH16)
+    {
+        return 0;
+    }
+
+    for (int scale = 1; scale <= TRANSFORMATION_MAX_COLOR_SCALE; scale *= 2)
+    {
+        // Rounded up like the color images of a scaled MJPEG decode
+        int scaled_width = (width + scale - 1) / scale;
+        int scaled_height = (height + scale - 1) / scale;
+        if (descriptor->width_pixels == scaled_width && descriptor->height_pixels == scaled_height &&
+            descriptor->stride_bytes == scaled_width * (int)sizeof(uint16_t))
+        {
+            return scale;
+        }
+    }
+    return 0;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptor,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor)
+{
+    if (depth_image_descriptor == 0 || custom_image_descriptor == 0 || transformed_depth_image_descriptor == 0 ||
+        transformed_custom_image_descriptor == 0)
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (calibration == 0)
+    {
+        LOG_ERROR("Calibration is null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (xy_tables_depth_camera == 0)
+    {
+        LOG_ERROR("Depth camera xy table is null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (depth_image_data == 0)
+    {
+        LOG_ERROR("Depth image data is null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
     }
 
     if (transformed_depth_image_data == 0)
@@ -721,11 +1437,11 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
         return K4A_BUFFER_RESULT_FAILED;
     }
 
+    // The xy tables cover the full depth image or only its region of interest
     k4a_transformation_image_descriptor_t expected_depth_image_descriptor =
-        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
-                                             calibration->depth_camera_calibration.resolution_height,
-                                             calibration->depth_camera_calibration.resolution_width *
-                                                 (int)sizeof(uint16_t),
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * (int)sizeof(uint16_t),
                                              K4A_IMAGE_FORMAT_DEPTH16);
 
     if (transformation_compare_image_descriptors(depth_image_descriptor, &expected_depth_image_descriptor) == false)
@@ -743,10 +1459,9 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
     }
 
     k4a_transformation_image_descriptor_t expected_custom_image_descriptor =
-        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
-                                             calibration->depth_camera_calibration.resolution_height,
-                                             calibration->depth_camera_calibration.resolution_width *
-                                                 custom_bytes_per_pixel,
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * custom_bytes_per_pixel,
                                              custom_format);
 
     if (custom_image_data != 0 &&
@@ -756,11 +1471,18 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
         return K4A_BUFFER_RESULT_FAILED;
     }
 
+    // The output has the color camera resolution or is downscaled by a power of two, an unexpected output is reported
+    // against the full resolution
+    int scale = transformation_get_depth_to_color_scale(&calibration->color_camera_calibration,
+                                                        transformed_depth_image_descriptor);
+    scale = scale == 0 ? 1 : scale;
+    int transformed_width = (calibration->color_camera_calibration.resolution_width + scale - 1) / scale;
+    int transformed_height = (calibration->color_camera_calibration.resolution_height + scale - 1) / scale;
+
     k4a_transformation_image_descriptor_t expected_transformed_depth_image_descriptor =
-        transformation_init_image_descriptor(calibration->color_camera_calibration.resolution_width,
-                                             calibration->color_camera_calibration.resolution_height,
-                                             calibration->color_camera_calibration.resolution_width *
-                                                 (int)sizeof(uint16_t),
+        transformation_init_image_descriptor(transformed_width,
+                                             transformed_height,
+                                             transformed_width * (int)sizeof(uint16_t),
                                              K4A_IMAGE_FORMAT_DEPTH16);
 
     if (transformation_compare_image_descriptors(transformed_depth_image_descriptor,
@@ -771,10 +1493,9 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
     }
 
     k4a_transformation_image_descriptor_t expected_transformed_custom_image_descriptor =
-        transformation_init_image_descriptor(calibration->color_camera_calibration.resolution_width,
-                                             calibration->color_camera_calibration.resolution_height,
-                                             calibration->color_camera_calibration.resolution_width *
-                                                 custom_bytes_per_pixel,
+        transformation_init_image_descriptor(transformed_width,
+                                             transformed_height,
+                                             transformed_width * custom_bytes_per_pixel,
                                              custom_format);
 
     if (transformed_custom_image_data != 0 &&
@@ -788,6 +1509,59 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_validate_paramete
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
 
+// Transforms the depth image and custom_image_count custom images, the parameters are already validated
+static k4a_buffer_result_t
+transformation_depth_to_color_custom_images(const k4a_calibration_t *calibration,
+                                            const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+                                            const uint8_t *depth_image_data,
+                                            const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                            size_t custom_image_count,
+                                            const uint8_t *const *custom_image_data,
+                                            const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+                                            uint8_t *transformed_depth_image_data,
+                                            k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+                                            uint8_t *const *transformed_custom_image_data,
+                                            k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+                                            k4a_transformation_interpolation_type_t interpolation_type,
+                                            const uint32_t *invalid_custom_values,
+                                            uint32_t thread_count,
+                                            const k4a_transformation_ray_tables_t *ray_tables_depth_camera)
+{
+    k4a_transformation_rgbz_context_t context;
+    memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
+
+    context.xy_tables = xy_tables_depth_camera;
+    context.ray_tables = ray_tables_depth_camera;
+    context.calibration = calibration;
+
+    context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
+
+    context.transformed_image = transformation_init_output_image(transformed_depth_image_descriptor,
+                                                                 transformed_depth_image_data);
+    context.output_scale = transformation_get_depth_to_color_scale(&calibration->color_camera_calibration,
+                                                                   transformed_depth_image_descriptor);
+
+    context.custom_channel_count = custom_image_count;
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        k4a_transformation_custom_channel_t *channel = &context.custom_channels[i];
+        channel->image = transformation_init_input_image(&custom_image_descriptors[i], custom_image_data[i]);
+        channel->transformed_image = transformation_init_output_image(&transformed_custom_image_descriptors[i],
+                                                                      transformed_custom_image_data[i]);
+        channel->invalid_value = (uint16_t)(invalid_custom_values[i] & 0xffff);
+        channel->is_custom16 = custom_image_descriptors[i].format == K4A_IMAGE_FORMAT_CUSTOM16;
+    }
+
+    context.interpolation_type = interpolation_type;
+    context.thread_count = MIN(thread_count, TRANSFORMATION_MAX_THREAD_COUNT);
+
+    if (K4A_FAILED(TRACE_CALL(transformation_depth_to_color(&context))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
 k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
@@ -800,7 +1574,9 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
     uint8_t *transformed_custom_image_data,
     k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor,
     k4a_transformation_interpolation_type_t interpolation_type,
-    uint32_t invalid_custom_value)
+    uint32_t invalid_custom_value,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera)
 {
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
         TRACE_BUFFER_CALL(
@@ -818,183 +1594,892 @@ k4a_buffer_result_t transformation_depth_image_to_color_camera_internal(
         return K4A_BUFFER_RESULT_FAILED;
     }
 
-    k4a_transformation_rgbz_context_t context;
-    memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
-
-    context.xy_tables = xy_tables_depth_camera;
-    context.calibration = calibration;
-
-    context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
-
-    context.custom_image = transformation_init_input_image(custom_image_descriptor, custom_image_data);
-
-    context.transformed_image = transformation_init_output_image(transformed_depth_image_descriptor,
-                                                                 transformed_depth_image_data);
-
-    context.transformed_custom_image = transformation_init_output_image(transformed_custom_image_descriptor,
-                                                                        transformed_custom_image_data);
+    // Only a custom image with data is transformed
+    size_t custom_image_count = custom_image_data != 0 ? 1 : 0;
+    return TRACE_BUFFER_CALL(transformation_depth_to_color_custom_images(calibration,
+                                                                         xy_tables_depth_camera,
+                                                                         depth_image_data,
+                                                                         depth_image_descriptor,
+                                                                         custom_image_count,
+                                                                         &custom_image_data,
+                                                                         custom_image_descriptor,
+                                                                         transformed_depth_image_data,
+                                                                         transformed_depth_image_descriptor,
+                                                                         &transformed_custom_image_data,
+                                                                         transformed_custom_image_descriptor,
+                                                                         interpolation_type,
+                                                                         &invalid_custom_value,
+                                                                         thread_count,
+                                                                         ray_tables_depth_camera));
+}
 
-    context.enable_custom8 = false;
-    context.enable_custom16 = false;
-    if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM8)
+k4a_buffer_result_t transformation_depth_image_to_color_camera_custom_images_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    const uint32_t *invalid_custom_values)
+{
+    if (custom_image_count > K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES)
     {
-        context.enable_custom8 = true;
+        LOG_ERROR("Expect at most %d custom images, got %d.",
+                  K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES,
+                  (int)custom_image_count);
+        return K4A_BUFFER_RESULT_FAILED;
     }
-    else if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM16)
+
+    if (custom_image_count > 0 && (custom_image_data == 0 || custom_image_descriptors == 0 ||
+                                   transformed_custom_image_data == 0 || transformed_custom_image_descriptors == 0 ||
+                                   invalid_custom_values == 0))
     {
-        context.enable_custom16 = true;
+        LOG_ERROR("Custom image arrays are null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
     }
 
-    context.interpolation_type = interpolation_type;
-    context.invalid_value = (uint16_t)(invalid_custom_value & 0xffff);
+    if (custom_image_count == 0)
+    {
+        // Validate the depth images alone, the custom descriptors are ignored without custom image data
+        k4a_transformation_image_descriptor_t dummy_descriptor = { 0 };
+        return TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_validate_parameters(
+            calibration,
+            xy_tables_depth_camera,
+            depth_image_data,
+            depth_image_descriptor,
+            NULL,
+            &dummy_descriptor,
+            transformed_depth_image_data,
+            transformed_depth_image_descriptor,
+            NULL,
+            &dummy_descriptor));
+    }
 
-    if (K4A_FAILED(TRACE_CALL(transformation_depth_to_color(&context))))
+    for (size_t i = 0; i < custom_image_count; i++)
     {
-        return K4A_BUFFER_RESULT_FAILED;
+        if (custom_image_data[i] == 0 || transformed_custom_image_data[i] == 0)
+        {
+            LOG_ERROR("Custom image %d or its transformed image data is null.", (int)i);
+            return K4A_BUFFER_RESULT_FAILED;
+        }
+
+        if (custom_image_descriptors[i].format != K4A_IMAGE_FORMAT_CUSTOM8 &&
+            custom_image_descriptors[i].format != K4A_IMAGE_FORMAT_CUSTOM16)
+        {
+            LOG_ERROR("Custom image %d has format %d, expect K4A_IMAGE_FORMAT_CUSTOM8 (%d) or "
+                      "K4A_IMAGE_FORMAT_CUSTOM16 (%d).",
+                      (int)i,
+                      custom_image_descriptors[i].format,
+                      K4A_IMAGE_FORMAT_CUSTOM8,
+                      K4A_IMAGE_FORMAT_CUSTOM16);
+            return K4A_BUFFER_RESULT_FAILED;
+        }
+
+        k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+            transformation_depth_image_to_color_camera_validate_parameters(calibration,
+                                                                           xy_tables_depth_camera,
+                                                                           depth_image_data,
+                                                                           depth_image_descriptor,
+                                                                           custom_image_data[i],
+                                                                           &custom_image_descriptors[i],
+                                                                           transformed_depth_image_data,
+                                                                           transformed_depth_image_descriptor,
+                                                                           transformed_custom_image_data[i],
+                                                                           &transformed_custom_image_descriptors[i]));
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            return result;
+        }
     }
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
 
-static inline int transformation_point_inside_image(int width, int height, k4a_float2_t *point2d)
+k4a_buffer_result_t transformation_depth_image_to_color_camera_custom_images_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    const uint32_t *invalid_custom_values,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera)
 {
-    int point_floor[2];
-    point_floor[0] = (int)(floorf(point2d->xy.x));
-    point_floor[1] = (int)(floorf(point2d->xy.y));
-    if (point_floor[0] < 0 || point_floor[1] < 0 || point_floor[0] + 1 >= width || point_floor[1] + 1 >= height)
+    if (K4A_BUFFER_RESULT_SUCCEEDED !=
+        TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_custom_images_validate_parameters(
+            calibration,
+            xy_tables_depth_camera,
+            depth_image_data,
+            depth_image_descriptor,
+            custom_image_count,
+            custom_image_data,
+            custom_image_descriptors,
+            transformed_depth_image_data,
+            transformed_depth_image_descriptor,
+            transformed_custom_image_data,
+            transformed_custom_image_descriptors,
+            invalid_custom_values)))
     {
-        return 0;
+        return K4A_BUFFER_RESULT_FAILED;
     }
-    return 1;
+
+    return TRACE_BUFFER_CALL(transformation_depth_to_color_custom_images(calibration,
+                                                                         xy_tables_depth_camera,
+                                                                         depth_image_data,
+                                                                         depth_image_descriptor,
+                                                                         custom_image_count,
+                                                                         custom_image_data,
+                                                                         custom_image_descriptors,
+                                                                         transformed_depth_image_data,
+                                                                         transformed_depth_image_descriptor,
+                                                                         transformed_custom_image_data,
+                                                                         transformed_custom_image_descriptors,
+                                                                         interpolation_type,
+                                                                         invalid_custom_values,
+                                                                         thread_count,
+                                                                         ray_tables_depth_camera));
 }
 
-static inline uint8_t transformation_bilinear_interpolation(const uint8_t *image, int stride, k4a_float2_t *point2d)
+// Largest reprojection error in color camera pixels of a color pixel transformed to the depth camera, the same bound as
+// the epipolar search of transformation_color_2d_to_depth_2d()
+#define TRANSFORMATION_COLOR_TO_DEPTH_MAX_ERROR (10.f)
+
+// Largest number of depth pixels the lookup of a color pixel walks from the depth pixel found in the inverse map
+#define TRANSFORMATION_COLOR_TO_DEPTH_MAX_STEPS (8)
+
+// Inverse of the correspondences of a depth image. Each cell covers cell_size x cell_size color camera pixels and holds
+// the depth pixel nearest to the color camera whose correspondence falls into it.
+typedef struct _k4a_transformation_inverse_map_t
 {
-    int point_floor[2];
-    point_floor[0] = (int)(floorf(point2d->xy.x));
-    point_floor[1] = (int)(floorf(point2d->xy.y));
+    const k4a_correspondence_t *correspondences; // correspondence of every depth pixel
+    int depth_width;                             // width of the depth image
+    int depth_height;                            // height of the depth image
+    int *cells;                                  // depth pixel index of each cell, -1 for none
+    int cell_size;                               // color camera pixels per cell in both directions
+    int width;                                   // cells per row
+    int height;                                  // rows of cells
+    float color_width;                           // width of the color camera
+    float color_height;                          // height of the color camera
+} k4a_transformation_inverse_map_t;
+
+// Cells are at most as wide as a depth pixel appears in the color camera, so that most of them hold a depth pixel
+static int transformation_inverse_map_cell_size(const k4a_calibration_t *calibration)
+{
+    float depth_fx = calibration->depth_camera_calibration.intrinsics.parameters.param.fx;
+    float color_fx = calibration->color_camera_calibration.intrinsics.parameters.param.fx;
+    int cell_size = depth_fx > 0.f ? (int)(color_fx / depth_fx) : 1;
+    return transformation_max2(cell_size, 1);
+}
 
-    float fractional[2];
-    fractional[0] = point2d->xy.x - point_floor[0];
-    fractional[1] = point2d->xy.y - point_floor[1];
+static inline bool transformation_inverse_map_get_cell(const k4a_transformation_inverse_map_t *map,
+                                                       const float point2d[2],
+                                                       int *cell_x,
+                                                       int *cell_y)
+{
+    // Color camera pixel x covers [x - 0.5, x + 0.5)
+    if (!(point2d[0] >= -0.5f && point2d[0] < map->color_width - 0.5f && point2d[1] >= -0.5f &&
+          point2d[1] < map->color_height - 0.5f))
+    {
+        return false;
+    }
+    *cell_x = transformation_min2((int)((point2d[0] + 0.5f) / (float)map->cell_size), map->width - 1);
+    *cell_y = transformation_min2((int)((point2d[1] + 0.5f) / (float)map->cell_size), map->height - 1);
+    return true;
+}
 
-    float vals[4];
-    int idx = point_floor[1] * stride + 4 * point_floor[0];
-    vals[0] = (float)image[idx];
-    vals[1] = (float)image[idx + 4];
-    idx += stride;
-    vals[2] = (float)image[idx];
-    vals[3] = (float)image[idx + 4];
+static void transformation_build_inverse_map(k4a_transformation_inverse_map_t *map)
+{
+    for (int i = 0; i < map->width * map->height; i++)
+    {
+        map->cells[i] = -1;
+    }
 
-    float interpol_x[2];
-    interpol_x[0] = (1.f - fractional[0]) * vals[0] + fractional[0] * vals[1];
-    interpol_x[1] = (1.f - fractional[0]) * vals[2] + fractional[0] * vals[3];
+    for (int i = 0; i < map->depth_width * map->depth_height; i++)
+    {
+        const k4a_correspondence_t *correspondence = &map->correspondences[i];
+        int cell_x, cell_y;
+        if (!correspondence->valid ||
+            !transformation_inverse_map_get_cell(map, correspondence->point2d.v, &cell_x, &cell_y))
+        {
+            continue;
+        }
 
-    float interpol_y = (1.f - fractional[1]) * interpol_x[0] + fractional[1] * interpol_x[1];
-    return (uint8_t)(interpol_y + 0.5f);
+        // The depth pixel nearest to the color camera occludes the others, as in the depth to color transformation
+        int *cell = &map->cells[cell_y * map->width + cell_x];
+        if (*cell < 0 || correspondence->depth < map->correspondences[*cell].depth)
+        {
+            *cell = i;
+        }
+    }
 }
 
-static k4a_result_t transformation_color_to_depth(k4a_transformation_rgbz_context_t *context)
+static inline float transformation_inverse_map_distance(const k4a_correspondence_t *correspondence,
+                                                        const float point2d[2])
 {
-    memset(context->transformed_image.data_uint8,
-           0,
-           (size_t)(context->transformed_image.descriptor->stride_bytes *
-                    context->transformed_image.descriptor->height_pixels));
+    float dx = correspondence->point2d.xy.x - point2d[0];
+    float dy = correspondence->point2d.xy.y - point2d[1];
+    return dx * dx + dy * dy;
+}
 
-    for (int idx = 0;
-         idx < context->depth_image.descriptor->width_pixels * context->depth_image.descriptor->height_pixels;
-         idx++)
+// Change of the correspondence of depth pixel (x, y) per depth pixel in direction (step_x, step_y), from the next
+// depth pixel or, when it is invalid, from the previous one
+static bool transformation_inverse_map_gradient(const k4a_transformation_inverse_map_t *map,
+                                                int x,
+                                                int y,
+                                                int step_x,
+                                                int step_y,
+                                                k4a_float2_t *gradient)
+{
+    const k4a_correspondence_t *center = &map->correspondences[y * map->depth_width + x];
+    for (int sign = 1; sign >= -1; sign -= 2)
     {
-        k4a_correspondence_t correspondence;
-        if (K4A_FAILED(TRACE_CALL(transformation_compute_correspondence(
-                idx, context->depth_image.data_uint16[idx], context, &correspondence))))
+        int neighbor_x = x + sign * step_x;
+        int neighbor_y = y + sign * step_y;
+        if (neighbor_x < 0 || neighbor_y < 0 || neighbor_x >= map->depth_width || neighbor_y >= map->depth_height)
         {
-            return K4A_RESULT_FAILED;
+            continue;
         }
 
-        if (correspondence.valid && transformation_point_inside_image(context->color_image.descriptor->width_pixels,
-                                                                      context->color_image.descriptor->height_pixels,
-                                                                      &correspondence.point2d))
+        const k4a_correspondence_t *neighbor = &map->correspondences[neighbor_y * map->depth_width + neighbor_x];
+        if (neighbor->valid)
         {
-            uint8_t b = transformation_bilinear_interpolation(context->color_image.data_uint8,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
+            gradient->xy.x = (float)sign * (neighbor->point2d.xy.x - center->point2d.xy.x);
+            gradient->xy.y = (float)sign * (neighbor->point2d.xy.y - center->point2d.xy.y);
+            return true;
+        }
+    }
+    return false;
+}
 
-            uint8_t g = transformation_bilinear_interpolation(context->color_image.data_uint8 + 1,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
+static void transformation_inverse_map_lookup(const k4a_transformation_inverse_map_t *map,
+                                              const float source_point2d[2],
+                                              float target_point2d[2],
+                                              int *valid)
+{
+    target_point2d[0] = 0.f;
+    target_point2d[1] = 0.f;
+    *valid = 0;
 
-            uint8_t r = transformation_bilinear_interpolation(context->color_image.data_uint8 + 2,
-                                                              context->color_image.descriptor->stride_bytes,
-                                                              &correspondence.point2d);
+    int cell_x, cell_y;
+    if (!transformation_inverse_map_get_cell(map, source_point2d, &cell_x, &cell_y))
+    {
+        return;
+    }
 
-            uint8_t alpha = transformation_bilinear_interpolation(context->color_image.data_uint8 + 3,
-                                                                  context->color_image.descriptor->stride_bytes,
-                                                                  &correspondence.point2d);
+    // The depth pixels of the surrounding cells cover the cells that no depth pixel fell into
+    int best = -1;
+    float best_distance = FLT_MAX;
+    for (int y = transformation_max2(cell_y - 1, 0); y <= transformation_min2(cell_y + 1, map->height - 1); y++)
+    {
+        for (int x = transformation_max2(cell_x - 1, 0); x <= transformation_min2(cell_x + 1, map->width - 1); x++)
+        {
+            int index = map->cells[y * map->width + x];
+            if (index >= 0)
+            {
+                float distance = transformation_inverse_map_distance(&map->correspondences[index], source_point2d);
+                if (distance < best_distance)
+                {
+                    best = index;
+                    best_distance = distance;
+                }
+            }
+        }
+    }
+    if (best < 0)
+    {
+        return;
+    }
 
-            // bgra = (0,0,0,0) is used to indicate that the bgra pixel is invalid. A valid bgra pixel with values
-            // (0,0,0,0) is mapped to (1,0,0,0) to express that it is valid and very close to black.
-            if (b == 0 && g == 0 && r == 0 && alpha == 0)
+    // Walk to the depth pixel whose correspondence is nearest to the color pixel
+    int best_x = best % map->depth_width;
+    int best_y = best / map->depth_width;
+    for (int step = 0; step < TRANSFORMATION_COLOR_TO_DEPTH_MAX_STEPS; step++)
+    {
+        int center_x = best_x;
+        int center_y = best_y;
+        int last_y = transformation_min2(center_y + 1, map->depth_height - 1);
+        int last_x = transformation_min2(center_x + 1, map->depth_width - 1);
+        for (int y = transformation_max2(center_y - 1, 0); y <= last_y; y++)
+        {
+            for (int x = transformation_max2(center_x - 1, 0); x <= last_x; x++)
             {
-                b++;
+                const k4a_correspondence_t *correspondence = &map->correspondences[y * map->depth_width + x];
+                if (correspondence->valid)
+                {
+                    float distance = transformation_inverse_map_distance(correspondence, source_point2d);
+                    if (distance < best_distance)
+                    {
+                        best_x = x;
+                        best_y = y;
+                        best_distance = distance;
+                    }
+                }
             }
+        }
+        if (best_x == center_x && best_y == center_y)
+        {
+            break;
+        }
+    }
+
+    if (best_distance > TRANSFORMATION_COLOR_TO_DEPTH_MAX_ERROR * TRANSFORMATION_COLOR_TO_DEPTH_MAX_ERROR)
+    {
+        return;
+    }
 
-            context->transformed_image.data_uint8[4 * idx + 0] = b;
-            context->transformed_image.data_uint8[4 * idx + 1] = g;
-            context->transformed_image.data_uint8[4 * idx + 2] = r;
-            context->transformed_image.data_uint8[4 * idx + 3] = alpha;
+    // Refine to a sub pixel position by inverting the local change of the correspondences
+    float offset_x = 0.f;
+    float offset_y = 0.f;
+    k4a_float2_t gradient_x, gradient_y;
+    if (transformation_inverse_map_gradient(map, best_x, best_y, 1, 0, &gradient_x) &&
+        transformation_inverse_map_gradient(map, best_x, best_y, 0, 1, &gradient_y))
+    {
+        float determinant = gradient_x.xy.x * gradient_y.xy.y - gradient_y.xy.x * gradient_x.xy.y;
+        if (fabsf(determinant) > 1e-6f)
+        {
+            const k4a_correspondence_t *correspondence = &map->correspondences[best_y * map->depth_width + best_x];
+            float error_x = source_point2d[0] - correspondence->point2d.xy.x;
+            float error_y = source_point2d[1] - correspondence->point2d.xy.y;
+            offset_x = (gradient_y.xy.y * error_x - gradient_y.xy.x * error_y) / determinant;
+            offset_y = (gradient_x.xy.x * error_y - gradient_x.xy.y * error_x) / determinant;
+            offset_x = transformation_min2f(transformation_max2f(offset_x, -1.f), 1.f);
+            offset_y = transformation_min2f(transformation_max2f(offset_y, -1.f), 1.f);
         }
     }
-    return K4A_RESULT_SUCCEEDED;
+
+    target_point2d[0] = (float)best_x + offset_x;
+    target_point2d[1] = (float)best_y + offset_y;
+    *valid = 1;
 }
 
-k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_parameters(
+k4a_result_t transformation_color_2d_to_depth_2d_batch_internal(
     const k4a_calibration_t *calibration,
     const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
     const uint8_t *depth_image_data,
     const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-    const uint8_t *color_image_data,
-    const k4a_transformation_image_descriptor_t *color_image_descriptor,
-    uint8_t *transformed_color_image_data,
-    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+    const float *source_points2d,
+    size_t point_count,
+    float *target_points2d,
+    int *valid,
+    uint32_t thread_count,
+    const k4a_transformation_ray_tables_t *ray_tables_depth_camera)
 {
-    if (transformed_color_image_descriptor == 0 || calibration == 0)
+    if (calibration == 0 || xy_tables_depth_camera == 0 || depth_image_data == 0 || depth_image_descriptor == 0)
     {
-        if (calibration == 0)
-        {
-            LOG_ERROR("Calibration is null.", 0);
-        }
-        return K4A_BUFFER_RESULT_FAILED;
+        LOG_ERROR("Calibration, depth camera xy table or depth image is null.", 0);
+        return K4A_RESULT_FAILED;
     }
 
-    k4a_transformation_image_descriptor_t expected_transformed_color_image_descriptor =
-        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
-                                             calibration->depth_camera_calibration.resolution_height,
-                                             calibration->depth_camera_calibration.resolution_width * 4 *
-                                                 (int)sizeof(uint8_t),
-                                             K4A_IMAGE_FORMAT_COLOR_BGRA32);
-
-    if (transformed_color_image_data == 0 ||
-        transformation_compare_image_descriptors(transformed_color_image_descriptor,
-                                                 &expected_transformed_color_image_descriptor) == false)
+    if (point_count > 0 && (source_points2d == 0 || target_points2d == 0 || valid == 0))
     {
-        if (transformed_color_image_data == 0)
-        {
-            LOG_ERROR("Transformed color image data is null.", 0);
-        }
-        else
-        {
-            LOG_ERROR("Unexpected transformed color image descriptor, see details above.", 0);
-        }
-        return K4A_BUFFER_RESULT_TOO_SMALL;
+        LOG_ERROR("Point arrays are null.", 0);
+        return K4A_RESULT_FAILED;
     }
 
-    if (xy_tables_depth_camera == 0 || depth_image_data == 0 || depth_image_descriptor == 0 || color_image_data == 0 ||
-        color_image_descriptor == 0 || transformed_color_image_data == 0)
-    {
-        if (xy_tables_depth_camera == 0)
+    k4a_transformation_image_descriptor_t expected_depth_image_descriptor =
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * (int)sizeof(uint16_t),
+                                             K4A_IMAGE_FORMAT_DEPTH16);
+    if (transformation_compare_image_descriptors(depth_image_descriptor, &expected_depth_image_descriptor) == false)
+    {
+        LOG_ERROR("Unexpected depth image descriptor, see details above.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (point_count == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    k4a_transformation_rgbz_context_t context;
+    memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
+    context.calibration = calibration;
+    context.xy_tables = xy_tables_depth_camera;
+    context.ray_tables = ray_tables_depth_camera;
+    context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
+    context.thread_count = MIN(thread_count, TRANSFORMATION_MAX_THREAD_COUNT);
+    if (K4A_FAILED(TRACE_CALL(transformation_init_correspondence_params(&context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_inverse_map_t map;
+    map.depth_width = depth_image_descriptor->width_pixels;
+    map.depth_height = depth_image_descriptor->height_pixels;
+    map.cell_size = transformation_inverse_map_cell_size(calibration);
+    map.color_width = (float)calibration->color_camera_calibration.resolution_width;
+    map.color_height = (float)calibration->color_camera_calibration.resolution_height;
+    map.width = (calibration->color_camera_calibration.resolution_width + map.cell_size - 1) / map.cell_size;
+    map.height = (calibration->color_camera_calibration.resolution_height + map.cell_size - 1) / map.cell_size;
+
+    size_t depth_pixel_count = (size_t)map.depth_width * (size_t)map.depth_height;
+    k4a_correspondence_t *correspondences = (k4a_correspondence_t *)malloc(depth_pixel_count *
+                                                                         sizeof(k4a_correspondence_t));
+    float *row_min_y = (float *)malloc((size_t)map.depth_height * sizeof(float));
+    float *row_max_y = (float *)malloc((size_t)map.depth_height * sizeof(float));
+    map.cells = (int *)malloc((size_t)map.width * (size_t)map.height * sizeof(int));
+    map.correspondences = correspondences;
+
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(correspondences != NULL && row_min_y != NULL && row_max_y != NULL &&
+                                               map.cells != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // The correspondences are computed as for the depth to color transformation, once per depth image instead of
+        // once per epipolar search step of every color pixel
+        k4a_transformation_band_t bands[TRANSFORMATION_MAX_THREAD_COUNT];
+        int band_count = transformation_max2(transformation_min2((int)context.thread_count, map.depth_height), 1);
+        for (int i = 0; i < band_count; i++)
+        {
+            bands[i].context = &context;
+            bands[i].correspondences = correspondences;
+            bands[i].row_min_y = row_min_y;
+            bands[i].row_max_y = row_max_y;
+        }
+        result = TRACE_CALL(transformation_run_bands(
+            bands, band_count, map.depth_height, transformation_depth_to_color_correspondence_band));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        transformation_build_inverse_map(&map);
+        for (size_t i = 0; i < point_count; i++)
+        {
+            transformation_inverse_map_lookup(&map, source_points2d + 2 * i, target_points2d + 2 * i, valid + i);
+        }
+    }
+
+    free(correspondences);
+    free(row_min_y);
+    free(row_max_y);
+    free(map.cells);
+    return result;
+}
+
+static inline int transformation_point_inside_image(int width, int height, k4a_float2_t *point2d)
+{
+    int point_floor[2];
+    point_floor[0] = (int)(floorf(point2d->xy.x));
+    point_floor[1] = (int)(floorf(point2d->xy.y));
+    if (point_floor[0] < 0 || point_floor[1] < 0 || point_floor[0] + 1 >= width || point_floor[1] + 1 >= height)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+static inline uint8_t
+transformation_bilinear_interpolation(const uint8_t *image, int stride, const k4a_float2_t *point2d)
+{
+    int point_floor[2];
+    point_floor[0] = (int)(floorf(point2d->xy.x));
+    point_floor[1] = (int)(floorf(point2d->xy.y));
+
+    float fractional[2];
+    fractional[0] = point2d->xy.x - point_floor[0];
+    fractional[1] = point2d->xy.y - point_floor[1];
+
+    float vals[4];
+    int idx = point_floor[1] * stride + 4 * point_floor[0];
+    vals[0] = (float)image[idx];
+    vals[1] = (float)image[idx + 4];
+    idx += stride;
+    vals[2] = (float)image[idx];
+    vals[3] = (float)image[idx + 4];
+
+    float interpol_x[2];
+    interpol_x[0] = (1.f - fractional[0]) * vals[0] + fractional[0] * vals[1];
+    interpol_x[1] = (1.f - fractional[0]) * vals[2] + fractional[0] * vals[3];
+
+    float interpol_y = (1.f - fractional[1]) * interpol_x[0] + fractional[1] * interpol_x[1];
+    return (uint8_t)(interpol_y + 0.5f);
+}
+
+// This is the same function as transformation_bilinear_interpolation_bgra without the SSE
+// instructions. This code is kept here for readability.
+static inline void transformation_bilinear_interpolation_bgra_scalar(const uint8_t *image,
+                                                                     int stride,
+                                                                     const k4a_float2_t *point2d,
+                                                                     uint8_t *bgra)
+{
+    for (int channel = 0; channel < 4; channel++)
+    {
+        bgra[channel] = transformation_bilinear_interpolation(image + channel, stride, point2d);
+    }
+}
+
+#if defined(K4A_USING_NEON)
+// Interpolates all four channels of a BGRA pixel at once, one channel per lane. The arithmetic is the same as the
+// scalar path, so the result is identical.
+static inline void transformation_bilinear_interpolation_bgra_neon(const uint8_t *image,
+                                                                   int stride,
+                                                                   const k4a_float2_t *point2d,
+                                                                   uint8_t *bgra)
+{
+    int point_floor[2];
+    point_floor[0] = (int)(floorf(point2d->xy.x));
+    point_floor[1] = (int)(floorf(point2d->xy.y));
+
+    float32x4_t fractional_x = vdupq_n_f32(point2d->xy.x - point_floor[0]);
+    float32x4_t fractional_y = vdupq_n_f32(point2d->xy.y - point_floor[1]);
+    float32x4_t one = vdupq_n_f32(1.f);
+
+    // Left and right neighbors of the top and bottom row
+    const uint8_t *top = image + point_floor[1] * stride + 4 * point_floor[0];
+    uint16x8_t top_pixels = vmovl_u8(vld1_u8(top));
+    uint16x8_t bottom_pixels = vmovl_u8(vld1_u8(top + stride));
+    float32x4_t top_left = vcvtq_f32_u32(vmovl_u16(vget_low_u16(top_pixels)));
+    float32x4_t top_right = vcvtq_f32_u32(vmovl_u16(vget_high_u16(top_pixels)));
+    float32x4_t bottom_left = vcvtq_f32_u32(vmovl_u16(vget_low_u16(bottom_pixels)));
+    float32x4_t bottom_right = vcvtq_f32_u32(vmovl_u16(vget_high_u16(bottom_pixels)));
+
+    // Separate multiplies and adds, a fused multiply add would round differently than the other paths
+    float32x4_t weight_left = vsubq_f32(one, fractional_x);
+    float32x4_t interpol_top = vaddq_f32(vmulq_f32(weight_left, top_left), vmulq_f32(fractional_x, top_right));
+    float32x4_t interpol_bottom = vaddq_f32(vmulq_f32(weight_left, bottom_left),
+                                            vmulq_f32(fractional_x, bottom_right));
+    float32x4_t interpol = vaddq_f32(vmulq_f32(vsubq_f32(one, fractional_y), interpol_top),
+                                     vmulq_f32(fractional_y, interpol_bottom));
+
+    uint32x4_t rounded = vcvtq_u32_f32(vaddq_f32(interpol, vdupq_n_f32(0.5f)));
+    uint16x4_t narrow = vmovn_u32(rounded);
+    uint8x8_t packed = vmovn_u16(vcombine_u16(narrow, narrow));
+    uint32_t result = vget_lane_u32(vreinterpret_u32_u8(packed), 0);
+    memcpy(bgra, &result, 4);
+}
+
+#elif defined(K4A_USING_SSE)
+// Interpolates all four channels of a BGRA pixel at once, one channel per lane. The arithmetic is the same as the
+// scalar path, so the result is identical.
+static inline void transformation_bilinear_interpolation_bgra_sse41(const uint8_t *image,
+                                                                    int stride,
+                                                                    const k4a_float2_t *point2d,
+                                                                    uint8_t *bgra)
+{
+    int point_floor[2];
+    point_floor[0] = (int)(floorf(point2d->xy.x));
+    point_floor[1] = (int)(floorf(point2d->xy.y));
+
+    __m128 fractional_x = _mm_set1_ps(point2d->xy.x - point_floor[0]);
+    __m128 fractional_y = _mm_set1_ps(point2d->xy.y - point_floor[1]);
+    __m128 one = _mm_set1_ps(1.f);
+
+    // Left and right neighbors of the top and bottom row
+    const uint8_t *top = image + point_floor[1] * stride + 4 * point_floor[0];
+    __m128i top_pixels = _mm_loadl_epi64((const __m128i *)(const void *)top);
+    __m128i bottom_pixels = _mm_loadl_epi64((const __m128i *)(const void *)(top + stride));
+    __m128 top_left = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(top_pixels));
+    __m128 top_right = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(top_pixels, 4)));
+    __m128 bottom_left = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bottom_pixels));
+    __m128 bottom_right = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bottom_pixels, 4)));
+
+    __m128 weight_left = _mm_sub_ps(one, fractional_x);
+    __m128 interpol_top = _mm_add_ps(_mm_mul_ps(weight_left, top_left), _mm_mul_ps(fractional_x, top_right));
+    __m128 interpol_bottom = _mm_add_ps(_mm_mul_ps(weight_left, bottom_left), _mm_mul_ps(fractional_x, bottom_right));
+    __m128 interpol = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, fractional_y), interpol_top),
+                                 _mm_mul_ps(fractional_y, interpol_bottom));
+
+    __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(interpol, _mm_set1_ps(0.5f)));
+    rounded = _mm_packus_epi32(rounded, rounded);
+    rounded = _mm_packus_epi16(rounded, rounded);
+    int result = _mm_cvtsi128_si32(rounded);
+    memcpy(bgra, &result, 4);
+}
+#endif
+
+static inline void transformation_bilinear_interpolation_bgra(const uint8_t *image,
+                                                              int stride,
+                                                              const k4a_float2_t *point2d,
+                                                              simd_level_t level,
+                                                              uint8_t *bgra)
+{
+#if defined(K4A_USING_SSE)
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        transformation_bilinear_interpolation_bgra_sse41(image, stride, point2d, bgra);
+        return;
+    }
+#elif defined(K4A_USING_NEON)
+    if (level == SIMD_LEVEL_NEON)
+    {
+        transformation_bilinear_interpolation_bgra_neon(image, stride, point2d, bgra);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    transformation_bilinear_interpolation_bgra_scalar(image, stride, point2d, bgra);
+}
+
+// Picks the BGRA color of the color pixel closest to point2d
+static inline void
+transformation_nearest_neighbor_bgra(const uint8_t *image, int stride, const k4a_float2_t *point2d, uint8_t *bgra)
+{
+    // point2d is inside the image including its right and bottom neighbors, so rounding stays inside as well
+    int x = (int)(floorf(point2d->xy.x + 0.5f));
+    int y = (int)(floorf(point2d->xy.y + 0.5f));
+    memcpy(bgra, image + y * stride + 4 * x, 4);
+}
+
+static inline uint8_t transformation_clamp_uint8(int value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Converts one pixel of an NV12 or YUY2 image to BGRA with the BT.601 limited range coefficients, the same conversion
+// the color camera pipeline and playback use
+static void transformation_yuv_pixel_to_bgra(const k4a_transformation_input_image_t *image, int x, int y, uint8_t *bgra)
+{
+    const k4a_transformation_image_descriptor_t *descriptor = image->descriptor;
+    int luma, u, v;
+    if (descriptor->format == K4A_IMAGE_FORMAT_COLOR_NV12)
+    {
+        // Full resolution luma plane followed by a half resolution plane of interleaved U and V
+        const uint8_t *chroma = image->data_uint8 + descriptor->stride_bytes * descriptor->height_pixels +
+                                descriptor->stride_bytes * (y / 2) + 2 * (x / 2);
+        luma = image->data_uint8[descriptor->stride_bytes * y + x];
+        u = chroma[0];
+        v = chroma[1];
+    }
+    else
+    {
+        // Y0 U Y1 V, each pair of pixels shares its chroma
+        const uint8_t *pair = image->data_uint8 + descriptor->stride_bytes * y + 4 * (x / 2);
+        luma = pair[2 * (x % 2)];
+        u = pair[1];
+        v = pair[3];
+    }
+
+    int c = 298 * (luma - 16) + 128;
+    int d = u - 128;
+    int e = v - 128;
+    bgra[0] = transformation_clamp_uint8((c + 516 * d) >> 8);
+    bgra[1] = transformation_clamp_uint8((c - 100 * d - 208 * e) >> 8);
+    bgra[2] = transformation_clamp_uint8((c + 409 * e) >> 8);
+    bgra[3] = 255;
+}
+
+// Samples a YUV color image, converting only the pixels the sample reads instead of the whole image
+static void transformation_sample_yuv_bgra(const k4a_transformation_input_image_t *image,
+                                           const k4a_float2_t *point2d,
+                                           bool use_linear_interpolation,
+                                           simd_level_t level,
+                                           uint8_t *bgra)
+{
+    if (use_linear_interpolation)
+    {
+        int x = (int)(floorf(point2d->xy.x));
+        int y = (int)(floorf(point2d->xy.y));
+
+        // The four neighbors are converted into a 2x2 BGRA block that is interpolated like a BGRA image
+        uint8_t neighbors[16];
+        transformation_yuv_pixel_to_bgra(image, x, y, neighbors);
+        transformation_yuv_pixel_to_bgra(image, x + 1, y, neighbors + 4);
+        transformation_yuv_pixel_to_bgra(image, x, y + 1, neighbors + 8);
+        transformation_yuv_pixel_to_bgra(image, x + 1, y + 1, neighbors + 12);
+
+        k4a_float2_t fractional;
+        fractional.xy.x = point2d->xy.x - (float)x;
+        fractional.xy.y = point2d->xy.y - (float)y;
+        transformation_bilinear_interpolation_bgra(neighbors, 8, &fractional, level, bgra);
+    }
+    else
+    {
+        transformation_yuv_pixel_to_bgra(image,
+                                         (int)(floorf(point2d->xy.x + 0.5f)),
+                                         (int)(floorf(point2d->xy.y + 0.5f)),
+                                         bgra);
+    }
+}
+
+// Samples the BGRA color of one depth pixel from the color image
+static void transformation_sample_bgra(const k4a_transformation_rgbz_context_t *context,
+                                       k4a_correspondence_t *correspondence,
+                                       bool use_linear_interpolation,
+                                       uint8_t *bgra)
+{
+    k4a_float2_t point2d = correspondence->point2d;
+    if (context->color_scale > 1)
+    {
+        // Pixel i of the downscaled color image covers color camera pixels i * scale to i * scale + scale - 1
+        float scale = (float)context->color_scale;
+        point2d.xy.x = (point2d.xy.x - (scale - 1.f) / 2.f) / scale;
+        point2d.xy.y = (point2d.xy.y - (scale - 1.f) / 2.f) / scale;
+    }
+
+    const k4a_transformation_image_descriptor_t *color_descriptor = context->color_image.descriptor;
+    if (!correspondence->valid ||
+        !transformation_point_inside_image(color_descriptor->width_pixels, color_descriptor->height_pixels, &point2d))
+    {
+        memset(bgra, 0, 4);
+        return;
+    }
+
+    if (color_descriptor->format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        transformation_sample_yuv_bgra(
+            &context->color_image, &point2d, use_linear_interpolation, context->simd_level, bgra);
+    }
+    else if (use_linear_interpolation)
+    {
+        transformation_bilinear_interpolation_bgra(context->color_image.data_uint8,
+                                                   color_descriptor->stride_bytes,
+                                                   &point2d,
+                                                   context->simd_level,
+                                                   bgra);
+    }
+    else
+    {
+        transformation_nearest_neighbor_bgra(context->color_image.data_uint8,
+                                             color_descriptor->stride_bytes,
+                                             &point2d,
+                                             bgra);
+    }
+
+    // bgra = (0,0,0,0) is used to indicate that the bgra pixel is invalid. A valid bgra pixel with values (0,0,0,0) is
+    // mapped to (1,0,0,0) to express that it is valid and very close to black.
+    if (bgra[0] == 0 && bgra[1] == 0 && bgra[2] == 0 && bgra[3] == 0)
+    {
+        bgra[0]++;
+    }
+}
+
+static k4a_result_t transformation_color_to_depth(k4a_transformation_rgbz_context_t *context)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_init_correspondence_params(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
+    bool use_linear_interpolation = context->interpolation_type == K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR;
+    k4a_correspondence_t *correspondences = (k4a_correspondence_t *)malloc((size_t)width *
+                                                                         sizeof(k4a_correspondence_t));
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(correspondences != NULL)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // Correspondences are computed a row at a time so that the vectorized projection is used
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    for (int y = 0; y < height && K4A_SUCCEEDED(result); y++)
+    {
+        int row_index = y * width;
+        result = TRACE_CALL(transformation_compute_correspondences(row_index, width, context, correspondences));
+        if (K4A_SUCCEEDED(result))
+        {
+            uint8_t *bgra_row = context->transformed_image.data_uint8 + 4 * (size_t)row_index;
+            for (int x = 0; x < width; x++)
+            {
+                transformation_sample_bgra(context, &correspondences[x], use_linear_interpolation, bgra_row + 4 * x);
+            }
+        }
+    }
+
+    free(correspondences);
+    return result;
+}
+
+int transformation_get_color_image_scale(const k4a_calibration_camera_t *color_camera_calibration,
+                                         const k4a_transformation_image_descriptor_t *color_image_descriptor)
+{
+    int width = color_camera_calibration->resolution_width;
+    int height = color_camera_calibration->resolution_height;
+    const k4a_transformation_image_descriptor_t *descriptor = color_image_descriptor;
+
+    switch (descriptor->format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+    {
+        // YUV images are sampled in place and only at the full resolution
+        int stride_bytes = descriptor->format == K4A_IMAGE_FORMAT_COLOR_NV12 ? width : width * 2;
+        if (descriptor->width_pixels == width && descriptor->height_pixels == height &&
+            descriptor->stride_bytes == stride_bytes)
+        {
+            return 1;
+        }
+        return 0;
+    }
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        for (int scale = 1; scale <= TRANSFORMATION_MAX_COLOR_SCALE; scale *= 2)
+        {
+            // Rounded up like a turbojpeg scaled decode
+            int scaled_width = (width + scale - 1) / scale;
+            int scaled_height = (height + scale - 1) / scale;
+            if (descriptor->width_pixels == scaled_width && descriptor->height_pixels == scaled_height &&
+                descriptor->stride_bytes == scaled_width * 4)
+            {
+                return scale;
+            }
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_parameters(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *transformed_color_image_data,
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+{
+    if (transformed_color_image_descriptor == 0 || calibration == 0 || xy_tables_depth_camera == 0)
+    {
+        if (calibration == 0)
+        {
+            LOG_ERROR("Calibration is null.", 0);
+        }
+        if (xy_tables_depth_camera == 0)
         {
             LOG_ERROR("Depth camera xy table is null.", 0);
         }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    // The xy tables cover the full depth image or only its region of interest
+    k4a_transformation_image_descriptor_t expected_transformed_color_image_descriptor =
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * 4 * (int)sizeof(uint8_t),
+                                             K4A_IMAGE_FORMAT_COLOR_BGRA32);
+
+    if (transformed_color_image_data == 0 ||
+        transformation_compare_image_descriptors(transformed_color_image_descriptor,
+                                                 &expected_transformed_color_image_descriptor) == false)
+    {
+        if (transformed_color_image_data == 0)
+        {
+            LOG_ERROR("Transformed color image data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected transformed color image descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    if (depth_image_data == 0 || depth_image_descriptor == 0 || color_image_data == 0 || color_image_descriptor == 0 ||
+        transformed_color_image_data == 0)
+    {
         if (depth_image_data == 0)
         {
             LOG_ERROR("Depth image data is null.", 0);
@@ -1011,10 +2496,9 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_paramete
     }
 
     k4a_transformation_image_descriptor_t expected_depth_image_descriptor =
-        transformation_init_image_descriptor(calibration->depth_camera_calibration.resolution_width,
-                                             calibration->depth_camera_calibration.resolution_height,
-                                             calibration->depth_camera_calibration.resolution_width *
-                                                 (int)sizeof(uint16_t),
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * (int)sizeof(uint16_t),
                                              K4A_IMAGE_FORMAT_DEPTH16);
 
     if (transformation_compare_image_descriptors(depth_image_descriptor, &expected_depth_image_descriptor) == false)
@@ -1023,16 +2507,17 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_validate_paramete
         return K4A_BUFFER_RESULT_FAILED;
     }
 
-    k4a_transformation_image_descriptor_t expected_color_image_descriptor =
-        transformation_init_image_descriptor(calibration->color_camera_calibration.resolution_width,
-                                             calibration->color_camera_calibration.resolution_height,
-                                             calibration->color_camera_calibration.resolution_width * 4 *
-                                                 (int)sizeof(uint8_t),
-                                             K4A_IMAGE_FORMAT_COLOR_BGRA32);
-
-    if (transformation_compare_image_descriptors(color_image_descriptor, &expected_color_image_descriptor) == false)
+    if (transformation_get_color_image_scale(&calibration->color_camera_calibration, color_image_descriptor) == 0)
     {
-        LOG_ERROR("Unexpected color image descriptor, see details above.", 0);
+        LOG_ERROR("Unexpected color image descriptor. "
+                  "width_pixels: %d, height_pixels: %d, stride_bytes: %d, format: %d. "
+                  "Expected BGRA32, NV12 or YUY2 at %dx%d without padding, or BGRA32 downscaled by 2, 4 or 8.",
+                  color_image_descriptor->width_pixels,
+                  color_image_descriptor->height_pixels,
+                  color_image_descriptor->stride_bytes,
+                  color_image_descriptor->format,
+                  calibration->color_camera_calibration.resolution_width,
+                  calibration->color_camera_calibration.resolution_height);
         return K4A_BUFFER_RESULT_FAILED;
     }
 
@@ -1047,7 +2532,8 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     const uint8_t *color_image_data,
     const k4a_transformation_image_descriptor_t *color_image_descriptor,
     uint8_t *transformed_color_image_data,
-    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type)
 {
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
         TRACE_BUFFER_CALL(
@@ -1072,10 +2558,14 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
 
     context.color_image = transformation_init_input_image(color_image_descriptor, color_image_data);
+    context.color_scale = transformation_get_color_image_scale(&calibration->color_camera_calibration,
+                                                               color_image_descriptor);
 
     context.transformed_image = transformation_init_output_image(transformed_color_image_descriptor,
                                                                  transformed_color_image_data);
 
+    context.interpolation_type = interpolation_type;
+
     if (K4A_FAILED(TRACE_CALL(transformation_color_to_depth(&context))))
     {
         return K4A_BUFFER_RESULT_FAILED;
@@ -1083,19 +2573,19 @@ k4a_buffer_result_t transformation_color_image_to_depth_camera_internal(
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
 
-#if !defined(K4A_USING_SSE) && !defined(K4A_USING_NEON)
+// Number of pixels the vectorized point cloud kernels process per iteration
+#define TRANSFORMATION_POINT_CLOUD_GROUP_SIZE (8)
+
 // This is the same function as transformation_depth_to_xyz without the SSE
 // instructions. This code is kept here for readability.
-static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_tables,
-                                        const void *depth_image_data,
-                                        void *xyz_image_data)
+static void transformation_depth_to_xyz_scalar(k4a_transformation_xy_tables_t *xy_tables,
+                                               const void *depth_image_data,
+                                               void *xyz_image_data)
 {
     const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
     int16_t *xyz_data_int16 = (int16_t *)xyz_image_data;
     int16_t x, y, z;
 
-    set_special_instruction_optimization("None");
-
     for (int i = 0; i < xy_tables->width * xy_tables->height; i++)
     {
         float x_tab = xy_tables->x_table[i];
@@ -1119,7 +2609,7 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
     }
 }
 
-#elif defined(K4A_USING_NEON)
+#if defined(K4A_USING_NEON)
 // convert from float to int using NEON is round to zero
 // make separate function to do floor
 static inline int32x4_t neon_floor(float32x4_t v)
@@ -1129,9 +2619,9 @@ static inline int32x4_t neon_floor(float32x4_t v)
     return vaddq_s32(v0, a0);
 }
 
-static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_tables,
-                                        const void *depth_image_data,
-                                        void *xyz_image_data)
+static void transformation_depth_to_xyz_neon(k4a_transformation_xy_tables_t *xy_tables,
+                                             const void *depth_image_data,
+                                             void *xyz_image_data)
 {
     float *x_tab = (float *)xy_tables->x_table;
     float *y_tab = (float *)xy_tables->y_table;
@@ -1139,8 +2629,6 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
     int16_t *xyz_data_int16 = (int16_t *)xyz_image_data;
     float32x4_t half = vdupq_n_f32(0.5f);
 
-    set_special_instruction_optimization("NEON");
-
     for (int i = 0; i < xy_tables->width * xy_tables->height / 8; i++)
     {
         // 8 elements in 1 loop
@@ -1180,26 +2668,10 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
     }
 }
 
-#else /* defined(K4A_USING_SSE) */
-
-static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_tables,
-                                        const void *depth_image_data,
-                                        void *xyz_image_data)
+#elif defined(K4A_USING_SSE)
+// Interleaves the x, y and z values of 8 points into x0, y0, z0, x1, .. z7
+static inline void transformation_store_xyz_8(__m128i *xyz, __m128i x, __m128i y, __m128i z)
 {
-    const __m128i *depth_image_data_m128i = (const __m128i *)depth_image_data;
-#if defined(__clang__) || defined(__GNUC__)
-    void *x_table = __builtin_assume_aligned(xy_tables->x_table, 16);
-    void *y_table = __builtin_assume_aligned(xy_tables->y_table, 16);
-#else
-    void *x_table = (void *)xy_tables->x_table;
-    void *y_table = (void *)xy_tables->y_table;
-#endif
-    __m128 *x_table_m128 = (__m128 *)x_table;
-    __m128 *y_table_m128 = (__m128 *)y_table;
-    __m128i *xyz_data_m128i = (__m128i *)xyz_image_data;
-
-    set_special_instruction_optimization("SSE");
-
     const int16_t pos0 = 0x0100;
     const int16_t pos1 = 0x0302;
     const int16_t pos2 = 0x0504;
@@ -1210,20 +2682,43 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
     const int16_t pos7 = 0x0F0E;
 
     // x0, x3, x6, x1, x4, x7, x2, x5
-    __m128i x_shuffle = _mm_setr_epi16(pos0, pos3, pos6, pos1, pos4, pos7, pos2, pos5);
+    x = _mm_shuffle_epi8(x, _mm_setr_epi16(pos0, pos3, pos6, pos1, pos4, pos7, pos2, pos5));
     // y5, y0, y3, y6, y1, y4, y7, y2
-    __m128i y_shuffle = _mm_setr_epi16(pos5, pos0, pos3, pos6, pos1, pos4, pos7, pos2);
+    y = _mm_shuffle_epi8(y, _mm_setr_epi16(pos5, pos0, pos3, pos6, pos1, pos4, pos7, pos2));
     // z2, z5, z0, z3, z6, z1, z4, z7
-    __m128i z_shuffle = _mm_setr_epi16(pos2, pos5, pos0, pos3, pos6, pos1, pos4, pos7);
+    z = _mm_shuffle_epi8(z, _mm_setr_epi16(pos2, pos5, pos0, pos3, pos6, pos1, pos4, pos7));
+
+    // x0, y0, z0, x1, y1, z1, x2, y2
+    _mm_storeu_si128(xyz, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x92), z, 0x24));
+    // z2, x3, y3, z3, x4, y4, z4, x5
+    _mm_storeu_si128(xyz + 1, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x24), z, 0x49));
+    // y5, z5, x6, y6, z6, x7, y7, z7
+    _mm_storeu_si128(xyz + 2, _mm_blend_epi16(_mm_blend_epi16(x, y, 0x49), z, 0x92));
+}
 
+static void transformation_depth_to_xyz_sse41(k4a_transformation_xy_tables_t *xy_tables,
+                                              const void *depth_image_data,
+                                              void *xyz_image_data)
+{
+    // Rows of a region of interest do not start on a 16 byte boundary, so every access is unaligned
+    const __m128i *depth_image_data_m128i = (const __m128i *)depth_image_data;
+    const float *x_table = xy_tables->x_table;
+    const float *y_table = xy_tables->y_table;
+    __m128i *xyz_data_m128i = (__m128i *)xyz_image_data;
+
+    const int16_t pos0 = 0x0100;
+    const int16_t pos2 = 0x0504;
+    const int16_t pos4 = 0x0908;
+    const int16_t pos6 = 0x0D0C;
     __m128i valid_shuffle = _mm_setr_epi16(pos0, pos2, pos4, pos6, pos0, pos2, pos4, pos6);
 
     for (int i = 0; i < xy_tables->width * xy_tables->height / 8; i++)
     {
-        __m128i z = *depth_image_data_m128i++;
+        __m128i z = _mm_loadu_si128(depth_image_data_m128i++);
 
-        __m128 x_tab_lo = *x_table_m128++;
-        __m128 x_tab_hi = *x_table_m128++;
+        __m128 x_tab_lo = _mm_loadu_ps(x_table);
+        __m128 x_tab_hi = _mm_loadu_ps(x_table + 4);
+        x_table += 8;
         __m128 valid_lo = _mm_cmpeq_ps(x_tab_lo, x_tab_lo);
         __m128 valid_hi = _mm_cmpeq_ps(x_tab_hi, x_tab_hi);
         __m128i valid_shuffle_lo = _mm_shuffle_epi8(*((__m128i *)&valid_lo), valid_shuffle);
@@ -1238,39 +2733,375 @@ static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_table
         __m128i x_hi = _mm_cvtps_epi32(_mm_mul_ps(depth_hi, x_tab_hi));
         __m128i x = _mm_packs_epi32(x_lo, x_hi);
         x = _mm_blendv_epi8(_mm_setzero_si128(), x, valid);
-        x = _mm_shuffle_epi8(x, x_shuffle);
 
-        __m128i y_lo = _mm_cvtps_epi32(_mm_mul_ps(depth_lo, *y_table_m128++));
-        __m128i y_hi = _mm_cvtps_epi32(_mm_mul_ps(depth_hi, *y_table_m128++));
+        __m128i y_lo = _mm_cvtps_epi32(_mm_mul_ps(depth_lo, _mm_loadu_ps(y_table)));
+        __m128i y_hi = _mm_cvtps_epi32(_mm_mul_ps(depth_hi, _mm_loadu_ps(y_table + 4)));
+        y_table += 8;
         __m128i y = _mm_packs_epi32(y_lo, y_hi);
-        y = _mm_shuffle_epi8(y, y_shuffle);
 
-        z = _mm_shuffle_epi8(z, z_shuffle);
+        transformation_store_xyz_8(xyz_data_m128i, x, y, z);
+        xyz_data_m128i += 3;
+    }
+}
+
+#if defined(K4A_USING_AVX)
+// transformation_depth_to_xyz_sse41() over 16 pixels per iteration, the last group of 8 pixels runs through the SSE
+// kernel
+SIMD_TARGET_AVX2 static void transformation_depth_to_xyz_avx2(k4a_transformation_xy_tables_t *xy_tables,
+                                                              const void *depth_image_data,
+                                                              void *xyz_image_data)
+{
+    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
+    __m128i *xyz_data_m128i = (__m128i *)xyz_image_data;
+    int count = xy_tables->width * xy_tables->height / 8 * 8;
 
-        // x0, y0, z0, x1, y1, z1, x2, y2
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x92), z, 0x24);
-        // z2, x3, y3, z3, x4, y4, z4, x5
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x24), z, 0x49);
-        // y5, z5, x6, y6, z6, x7, y7, z7
-        *xyz_data_m128i++ = _mm_blend_epi16(_mm_blend_epi16(x, y, 0x49), z, 0x92);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256 x_tab_lo = _mm256_loadu_ps(xy_tables->x_table + i);
+        __m256 x_tab_hi = _mm256_loadu_ps(xy_tables->x_table + i + 8);
+        __m256i valid_lo = _mm256_castps_si256(_mm256_cmp_ps(x_tab_lo, x_tab_lo, _CMP_EQ_OQ));
+        __m256i valid_hi = _mm256_castps_si256(_mm256_cmp_ps(x_tab_hi, x_tab_hi, _CMP_EQ_OQ));
+        // The packs work on each 128 bit lane, the permute puts the 16 pixels back in order
+        __m256i valid = _mm256_permute4x64_epi64(_mm256_packs_epi32(valid_lo, valid_hi), 0xD8);
+        __m256i z = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(const void *)(depth_image_data_uint16 + i)),
+                                     valid);
+
+        __m256 depth_lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(z)));
+        __m256 depth_hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(z, 1)));
+
+        __m256i x = _mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(depth_lo, x_tab_lo)),
+                                       _mm256_cvtps_epi32(_mm256_mul_ps(depth_hi, x_tab_hi)));
+        x = _mm256_and_si256(_mm256_permute4x64_epi64(x, 0xD8), valid);
+
+        __m256 y_tab_lo = _mm256_loadu_ps(xy_tables->y_table + i);
+        __m256 y_tab_hi = _mm256_loadu_ps(xy_tables->y_table + i + 8);
+        __m256i y = _mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(depth_lo, y_tab_lo)),
+                                       _mm256_cvtps_epi32(_mm256_mul_ps(depth_hi, y_tab_hi)));
+        y = _mm256_permute4x64_epi64(y, 0xD8);
+
+        transformation_store_xyz_8(xyz_data_m128i,
+                                   _mm256_castsi256_si128(x),
+                                   _mm256_castsi256_si128(y),
+                                   _mm256_castsi256_si128(z));
+        transformation_store_xyz_8(xyz_data_m128i + 3,
+                                   _mm256_extracti128_si256(x, 1),
+                                   _mm256_extracti128_si256(y, 1),
+                                   _mm256_extracti128_si256(z, 1));
+        xyz_data_m128i += 6;
+    }
+
+    if (i < count)
+    {
+        k4a_transformation_xy_tables_t tail_tables = *xy_tables;
+        tail_tables.x_table = xy_tables->x_table + i;
+        tail_tables.y_table = xy_tables->y_table + i;
+        tail_tables.width = count - i;
+        tail_tables.height = 1;
+        transformation_depth_to_xyz_sse41(&tail_tables, depth_image_data_uint16 + i, xyz_data_m128i);
     }
 }
 #endif
+#endif
 
-k4a_buffer_result_t
-transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_t *xy_tables,
-                                                   const uint8_t *depth_image_data,
-                                                   const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-                                                   uint8_t *xyz_image_data,
-                                                   k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+// Writes int16 millimeter points of groups of TRANSFORMATION_POINT_CLOUD_GROUP_SIZE pixels with the kernel of level
+static void transformation_depth_to_xyz(k4a_transformation_xy_tables_t *xy_tables,
+                                        const void *depth_image_data,
+                                        void *xyz_image_data,
+                                        simd_level_t level)
+{
+#if defined(K4A_USING_SSE)
+#if defined(K4A_USING_AVX)
+    if (level >= SIMD_LEVEL_AVX2)
+    {
+        transformation_depth_to_xyz_avx2(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#endif
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        transformation_depth_to_xyz_sse41(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#elif defined(K4A_USING_NEON)
+    if (level == SIMD_LEVEL_NEON)
+    {
+        transformation_depth_to_xyz_neon(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    transformation_depth_to_xyz_scalar(xy_tables, depth_image_data, xyz_image_data);
+}
+
+// This is the same function as transformation_depth_to_xyz_float without the SSE
+// instructions. This code is kept here for readability.
+static void transformation_depth_to_xyz_float_scalar(k4a_transformation_xy_tables_t *xy_tables,
+                                                     const void *depth_image_data,
+                                                     void *xyz_image_data)
 {
+    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
+    float *xyz_data_float = (float *)xyz_image_data;
+
+    for (int i = 0; i < xy_tables->width * xy_tables->height; i++)
+    {
+        float x_tab = xy_tables->x_table[i];
+        float x = 0.f, y = 0.f, z = 0.f;
+
+        if (!isnan(x_tab))
+        {
+            z = (float)depth_image_data_uint16[i] * 0.001f;
+            x = x_tab * z;
+            y = xy_tables->y_table[i] * z;
+        }
+
+        xyz_data_float[3 * i + 0] = x;
+        xyz_data_float[3 * i + 1] = y;
+        xyz_data_float[3 * i + 2] = z;
+    }
+}
+
+#if defined(K4A_USING_NEON)
+
+static void transformation_depth_to_xyz_float_neon(k4a_transformation_xy_tables_t *xy_tables,
+                                                   const void *depth_image_data,
+                                                   void *xyz_image_data)
+{
+    const float *x_tab = (const float *)xy_tables->x_table;
+    const float *y_tab = (const float *)xy_tables->y_table;
+    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
+    float *xyz_data_float = (float *)xyz_image_data;
+    float32x4_t millimeters_to_meters = vdupq_n_f32(0.001f);
+
+    for (int i = 0; i < xy_tables->width * xy_tables->height / 4; i++)
+    {
+        // 4 elements in 1 loop
+        int offset = i * 4;
+        float32x4_t t_x = vld1q_f32(x_tab + offset);
+        // equivalent to isnan
+        uint32x4_t valid = vceqq_f32(t_x, t_x);
+        float32x4_t v_z = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vld1_u16(depth_image_data_uint16 + offset))),
+                                    millimeters_to_meters);
+        float32x4x3_t store;
+        store.val[0] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(t_x, v_z)), valid));
+        store.val[1] = vreinterpretq_f32_u32(
+            vandq_u32(vreinterpretq_u32_f32(vmulq_f32(vld1q_f32(y_tab + offset), v_z)), valid));
+        store.val[2] = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v_z), valid));
+        // x0 y0 z0 x1 y1 z1 .. x3 y3 z3
+        vst3q_f32(xyz_data_float + offset * 3, store);
+    }
+}
+
+#elif defined(K4A_USING_SSE)
+
+// Interleaves the x, y and z values of 4 points into x0, y0, z0, x1, .. z3
+static inline void transformation_store_xyz_float_4(float *xyz, __m128 x, __m128 y, __m128 z)
+{
+    // x0, y0, x1, y1 and x2, y2, x3, y3
+    __m128 xy_lo = _mm_unpacklo_ps(x, y);
+    __m128 xy_hi = _mm_unpackhi_ps(x, y);
+    // z0, z0, x1, x1
+    __m128 zx = _mm_shuffle_ps(z, xy_lo, _MM_SHUFFLE(2, 2, 0, 0));
+    // y1, y1, z1, z1
+    __m128 yz = _mm_shuffle_ps(xy_lo, z, _MM_SHUFFLE(1, 1, 3, 3));
+    // z2, z2, x3, x3
+    __m128 zx_hi = _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(2, 2, 2, 2));
+    // y3, y3, z3, z3
+    __m128 yz_hi = _mm_shuffle_ps(xy_hi, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+    // x0, y0, z0, x1
+    _mm_storeu_ps(xyz, _mm_shuffle_ps(xy_lo, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+    // y1, z1, x2, y2
+    _mm_storeu_ps(xyz + 4, _mm_shuffle_ps(yz, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+    // z2, x3, y3, z3
+    _mm_storeu_ps(xyz + 8, _mm_shuffle_ps(zx_hi, yz_hi, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+static void transformation_depth_to_xyz_float_sse41(k4a_transformation_xy_tables_t *xy_tables,
+                                                    const void *depth_image_data,
+                                                    void *xyz_image_data)
+{
+    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
+    float *xyz_data_float = (float *)xyz_image_data;
+    __m128 millimeters_to_meters = _mm_set1_ps(0.001f);
+
+    for (int i = 0; i < xy_tables->width * xy_tables->height / 4; i++)
+    {
+        int offset = i * 4;
+        __m128 x_tab = _mm_loadu_ps(xy_tables->x_table + offset);
+        __m128 valid = _mm_cmpeq_ps(x_tab, x_tab);
+        __m128i depth = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(depth_image_data_uint16 + offset)));
+        __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(depth), millimeters_to_meters);
+        __m128 x = _mm_and_ps(_mm_mul_ps(x_tab, z), valid);
+        __m128 y = _mm_and_ps(_mm_mul_ps(_mm_loadu_ps(xy_tables->y_table + offset), z), valid);
+        z = _mm_and_ps(z, valid);
+        transformation_store_xyz_float_4(xyz_data_float + offset * 3, x, y, z);
+    }
+}
+
+#if defined(K4A_USING_AVX)
+SIMD_TARGET_AVX2 static void transformation_depth_to_xyz_float_avx2(k4a_transformation_xy_tables_t *xy_tables,
+                                                                    const void *depth_image_data,
+                                                                    void *xyz_image_data)
+{
+    const uint16_t *depth_image_data_uint16 = (const uint16_t *)depth_image_data;
+    float *xyz_data_float = (float *)xyz_image_data;
+    __m256 millimeters_to_meters = _mm256_set1_ps(0.001f);
+
+    // The point cloud kernels get groups of TRANSFORMATION_POINT_CLOUD_GROUP_SIZE pixels, 8 at a time covers them
+    for (int offset = 0; offset + 8 <= xy_tables->width * xy_tables->height; offset += 8)
+    {
+        __m256 x_tab = _mm256_loadu_ps(xy_tables->x_table + offset);
+        __m256 valid = _mm256_cmp_ps(x_tab, x_tab, _CMP_EQ_OQ);
+        __m256i depth = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)(const void *)(depth_image_data_uint16 + offset)));
+        __m256 z = _mm256_mul_ps(_mm256_cvtepi32_ps(depth), millimeters_to_meters);
+        __m256 x = _mm256_and_ps(_mm256_mul_ps(x_tab, z), valid);
+        __m256 y = _mm256_and_ps(_mm256_mul_ps(_mm256_loadu_ps(xy_tables->y_table + offset), z), valid);
+        z = _mm256_and_ps(z, valid);
+        transformation_store_xyz_float_4(xyz_data_float + offset * 3,
+                                         _mm256_castps256_ps128(x),
+                                         _mm256_castps256_ps128(y),
+                                         _mm256_castps256_ps128(z));
+        transformation_store_xyz_float_4(xyz_data_float + offset * 3 + 12,
+                                         _mm256_extractf128_ps(x, 1),
+                                         _mm256_extractf128_ps(y, 1),
+                                         _mm256_extractf128_ps(z, 1));
+    }
+}
+#endif
+#endif
+
+// Writes float meter points of groups of TRANSFORMATION_POINT_CLOUD_GROUP_SIZE pixels with the kernel of level
+static void transformation_depth_to_xyz_float(k4a_transformation_xy_tables_t *xy_tables,
+                                              const void *depth_image_data,
+                                              void *xyz_image_data,
+                                              simd_level_t level)
+{
+#if defined(K4A_USING_SSE)
+#if defined(K4A_USING_AVX)
+    if (level >= SIMD_LEVEL_AVX2)
+    {
+        transformation_depth_to_xyz_float_avx2(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#endif
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        transformation_depth_to_xyz_float_sse41(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#elif defined(K4A_USING_NEON)
+    if (level == SIMD_LEVEL_NEON)
+    {
+        transformation_depth_to_xyz_float_neon(xy_tables, depth_image_data, xyz_image_data);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    transformation_depth_to_xyz_float_scalar(xy_tables, depth_image_data, xyz_image_data);
+}
+
+static int transformation_point_cloud_point_size(k4a_transformation_point_cloud_format_t point_cloud_format)
+{
+    switch (point_cloud_format)
+    {
+    case K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS:
+        return 3 * (int)sizeof(int16_t);
+    case K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS:
+        return 3 * (int)sizeof(float);
+    default:
+        return 0;
+    }
+}
+
+static void transformation_depth_to_point_cloud_kernel(k4a_transformation_xy_tables_t *xy_tables,
+                                                       const uint8_t *depth_image_data,
+                                                       k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                       uint8_t *xyz_image_data)
+{
+    simd_level_t level = simd_get_level();
+    if (point_cloud_format == K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS)
+    {
+        transformation_depth_to_xyz_float(xy_tables, (const void *)depth_image_data, (void *)xyz_image_data, level);
+    }
+    else
+    {
+        transformation_depth_to_xyz(xy_tables, (const void *)depth_image_data, (void *)xyz_image_data, level);
+    }
+}
+
+// Writes one organized point per pixel of depth_image_data. Points of pixels without a valid xy table entry are
+// (0,0,0), so are points with zero depth.
+static void transformation_depth_to_point_cloud(k4a_transformation_xy_tables_t *xy_tables,
+                                                const uint8_t *depth_image_data,
+                                                k4a_transformation_point_cloud_format_t point_cloud_format,
+                                                uint8_t *xyz_image_data)
+{
+    // The vectorized kernels process groups of TRANSFORMATION_POINT_CLOUD_GROUP_SIZE pixels
+    int count = xy_tables->width * xy_tables->height;
+    int tail = count % TRANSFORMATION_POINT_CLOUD_GROUP_SIZE;
+    size_t point_size = (size_t)transformation_point_cloud_point_size(point_cloud_format);
+
+    k4a_transformation_xy_tables_t head_tables = *xy_tables;
+    head_tables.width = count - tail;
+    head_tables.height = 1;
+    transformation_depth_to_point_cloud_kernel(&head_tables, depth_image_data, point_cloud_format, xyz_image_data);
+
+    if (tail == 0)
+    {
+        return;
+    }
+
+    // The last pixels, which regions of interest may leave, run through the same kernel from a padded group so that
+    // they round exactly like the others.
+    float x_table[TRANSFORMATION_POINT_CLOUD_GROUP_SIZE];
+    float y_table[TRANSFORMATION_POINT_CLOUD_GROUP_SIZE];
+    uint16_t depth[TRANSFORMATION_POINT_CLOUD_GROUP_SIZE];
+    float xyz[3 * TRANSFORMATION_POINT_CLOUD_GROUP_SIZE];
+
+    for (int i = 0; i < TRANSFORMATION_POINT_CLOUD_GROUP_SIZE; i++)
+    {
+        x_table[i] = i < tail ? xy_tables->x_table[count - tail + i] : NAN;
+        y_table[i] = i < tail ? xy_tables->y_table[count - tail + i] : NAN;
+    }
+    memset(depth, 0, TRANSFORMATION_POINT_CLOUD_GROUP_SIZE * sizeof(uint16_t));
+    memcpy(depth, depth_image_data + (size_t)(count - tail) * sizeof(uint16_t), (size_t)tail * sizeof(uint16_t));
+
+    k4a_transformation_xy_tables_t tail_tables;
+    tail_tables.x_table = x_table;
+    tail_tables.y_table = y_table;
+    tail_tables.width = TRANSFORMATION_POINT_CLOUD_GROUP_SIZE;
+    tail_tables.height = 1;
+    transformation_depth_to_point_cloud_kernel(
+        &tail_tables, (const uint8_t *)depth, point_cloud_format, (uint8_t *)xyz);
+    memcpy(xyz_image_data + (size_t)(count - tail) * point_size, xyz, (size_t)tail * point_size);
+}
+
+static k4a_buffer_result_t
+transformation_validate_point_cloud_parameters(k4a_transformation_xy_tables_t *xy_tables,
+                                               const uint8_t *depth_image_data,
+                                               const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                               k4a_transformation_point_cloud_format_t point_cloud_format,
+                                               uint8_t *xyz_image_data,
+                                               k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    int point_size = transformation_point_cloud_point_size(point_cloud_format);
+    if (point_size == 0)
+    {
+        LOG_ERROR("Unexpected point cloud format %d.", point_cloud_format);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
     if (xyz_image_descriptor == 0)
     {
         return K4A_BUFFER_RESULT_FAILED;
     }
 
     k4a_transformation_image_descriptor_t expected_xyz_image_descriptor = transformation_init_image_descriptor(
-        xy_tables->width, xy_tables->height, xy_tables->width * 3 * (int)sizeof(int16_t), xyz_image_descriptor->format);
+        xy_tables->width, xy_tables->height, xy_tables->width * point_size, xyz_image_descriptor->format);
 
     if (xyz_image_data == 0 ||
         transformation_compare_image_descriptors(xyz_image_descriptor, &expected_xyz_image_descriptor) == false)
@@ -1304,7 +3135,901 @@ transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_
         return K4A_BUFFER_RESULT_FAILED;
     }
 
-    transformation_depth_to_xyz(xy_tables, (const void *)depth_image_data, (void *)xyz_image_data);
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+k4a_buffer_result_t
+transformation_depth_image_to_point_cloud_internal(k4a_transformation_xy_tables_t *xy_tables,
+                                                   const uint8_t *depth_image_data,
+                                                   const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                   uint8_t *xyz_image_data,
+                                                   k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    return transformation_depth_image_to_point_cloud_with_format_internal(
+        xy_tables,
+        depth_image_data,
+        depth_image_descriptor,
+        K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS,
+        xyz_image_data,
+        xyz_image_descriptor);
+}
+
+k4a_buffer_result_t transformation_depth_image_to_point_cloud_with_format_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(transformation_validate_point_cloud_parameters(
+        xy_tables, depth_image_data, depth_image_descriptor, point_cloud_format, xyz_image_data, xyz_image_descriptor));
+    if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    transformation_depth_to_point_cloud(xy_tables, depth_image_data, point_cloud_format, xyz_image_data);
+
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+static bool transformation_point_is_valid(const uint8_t *point,
+                                          k4a_transformation_point_cloud_format_t point_cloud_format)
+{
+    if (point_cloud_format == K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS)
+    {
+        float z;
+        memcpy(&z, point + 2 * sizeof(float), sizeof(float));
+        return z != 0.f;
+    }
+
+    int16_t z;
+    memcpy(&z, point + 2 * sizeof(int16_t), sizeof(int16_t));
+    return z != 0;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_compact_point_cloud_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *index_image_data,
+    k4a_transformation_image_descriptor_t *index_image_descriptor,
+    size_t *point_count)
+{
+    if (point_count == 0)
+    {
+        LOG_ERROR("Point count is null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(transformation_validate_point_cloud_parameters(
+        xy_tables, depth_image_data, depth_image_descriptor, point_cloud_format, xyz_image_data, xyz_image_descriptor));
+    if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    if (index_image_data != 0 || index_image_descriptor != 0)
+    {
+        if (index_image_descriptor == 0)
+        {
+            return K4A_BUFFER_RESULT_FAILED;
+        }
+
+        k4a_transformation_image_descriptor_t expected_index_image_descriptor =
+            transformation_init_image_descriptor(xy_tables->width,
+                                                 xy_tables->height,
+                                                 xy_tables->width * (int)sizeof(uint32_t),
+                                                 index_image_descriptor->format);
 
+        if (index_image_data == 0 ||
+            transformation_compare_image_descriptors(index_image_descriptor, &expected_index_image_descriptor) == false)
+        {
+            if (index_image_data == 0)
+            {
+                LOG_ERROR("Index image data is null.", 0);
+            }
+            else
+            {
+                LOG_ERROR("Unexpected index image descriptor, see details above.", 0);
+            }
+            return K4A_BUFFER_RESULT_TOO_SMALL;
+        }
+    }
+
+    // The organized points of one row are computed by the vectorized kernels into a scratch row and only the valid
+    // ones are copied to the output, so that the compact point cloud needs a single pass over the depth image.
+    int width = xy_tables->width;
+    size_t point_size = (size_t)transformation_point_cloud_point_size(point_cloud_format);
+    size_t xyz_row_size = ((size_t)width * point_size + 15) & ~(size_t)15;
+#ifdef _MSC_VER
+    uint8_t *xyz_row = (uint8_t *)_aligned_malloc(xyz_row_size, 16);
+#else
+    uint8_t *xyz_row = (uint8_t *)aligned_alloc(16, xyz_row_size);
+#endif
+    if (xyz_row == NULL)
+    {
+        LOG_ERROR("Failed to allocate a point cloud row.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    size_t count = 0;
+    for (int y = 0; y < xy_tables->height; y++)
+    {
+        int row_index = y * width;
+        k4a_transformation_xy_tables_t xy_tables_row;
+        xy_tables_row.x_table = xy_tables->x_table + row_index;
+        xy_tables_row.y_table = xy_tables->y_table + row_index;
+        xy_tables_row.width = width;
+        xy_tables_row.height = 1;
+        transformation_depth_to_point_cloud(&xy_tables_row,
+                                            depth_image_data + (size_t)row_index * sizeof(uint16_t),
+                                            point_cloud_format,
+                                            xyz_row);
+
+        const uint8_t *point = xyz_row;
+        for (int x = 0; x < width; x++, point += point_size)
+        {
+            if (transformation_point_is_valid(point, point_cloud_format))
+            {
+                memcpy(xyz_image_data + count * point_size, point, point_size);
+                if (index_image_data != 0)
+                {
+                    uint32_t index = (uint32_t)(row_index + x);
+                    memcpy(index_image_data + count * sizeof(uint32_t), &index, sizeof(uint32_t));
+                }
+                count++;
+            }
+        }
+    }
+
+#ifdef _MSC_VER
+    _aligned_free(xyz_row);
+#else
+    free(xyz_row);
+#endif
+
+    *point_count = count;
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+// Normals of an organized point cloud are the cross product of the central differences of the points below and above,
+// and right and left, of a pixel. They have unit length and point towards the camera. A pixel without a point, with a
+// neighbor without a point, or on the border of the image has a (0,0,0) normal.
+
+// Computes the point of one pixel with the same operations as the float point cloud kernels, returns whether the
+// pixel has a point
+static inline bool transformation_pixel_to_point(const k4a_transformation_xy_tables_t *xy_tables,
+                                                 const uint16_t *depth_image_data,
+                                                 int index,
+                                                 float point[3])
+{
+    float x_tab = xy_tables->x_table[index];
+    if (isnan(x_tab))
+    {
+        point[0] = 0.f;
+        point[1] = 0.f;
+        point[2] = 0.f;
+        return false;
+    }
+
+    float z = (float)depth_image_data[index] * 0.001f;
+    point[0] = x_tab * z;
+    point[1] = xy_tables->y_table[index] * z;
+    point[2] = z;
+    return z != 0.f;
+}
+
+static void transformation_pixel_to_point_and_normal(const k4a_transformation_xy_tables_t *xy_tables,
+                                                     const uint16_t *depth_image_data,
+                                                     int x,
+                                                     int y,
+                                                     float point[3],
+                                                     float normal[3])
+{
+    int width = xy_tables->width;
+    int index = y * width + x;
+    float left[3], right[3], top[3], bottom[3];
+    normal[0] = 0.f;
+    normal[1] = 0.f;
+    normal[2] = 0.f;
+
+    bool valid = transformation_pixel_to_point(xy_tables, depth_image_data, index, point);
+    if (!valid || x == 0 || y == 0 || x == width - 1 || y == xy_tables->height - 1 ||
+        !transformation_pixel_to_point(xy_tables, depth_image_data, index - 1, left) ||
+        !transformation_pixel_to_point(xy_tables, depth_image_data, index + 1, right) ||
+        !transformation_pixel_to_point(xy_tables, depth_image_data, index - width, top) ||
+        !transformation_pixel_to_point(xy_tables, depth_image_data, index + width, bottom))
+    {
+        return;
+    }
+
+    float dx[3] = { right[0] - left[0], right[1] - left[1], right[2] - left[2] };
+    float dy[3] = { bottom[0] - top[0], bottom[1] - top[1], bottom[2] - top[2] };
+    float n[3] = { dy[1] * dx[2] - dy[2] * dx[1], dy[2] * dx[0] - dy[0] * dx[2], dy[0] * dx[1] - dy[1] * dx[0] };
+    float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0.f)
+    {
+        normal[0] = n[0] / length;
+        normal[1] = n[1] / length;
+        normal[2] = n[2] / length;
+    }
+}
+
+// The kernels below compute the points and normals of 4 pixels inside the border of the image with the same
+// operations, in the same order, as transformation_pixel_to_point_and_normal() does.
+#if defined(K4A_USING_SSE)
+// Loads the points of 4 pixels, returns which have a point and sets table_valid to which have a valid xy table entry
+static inline __m128 transformation_pixels_to_points_4(const k4a_transformation_xy_tables_t *xy_tables,
+                                                       const uint16_t *depth_image_data,
+                                                       int index,
+                                                       __m128 *x,
+                                                       __m128 *y,
+                                                       __m128 *z,
+                                                       __m128 *table_valid)
+{
+    __m128 x_tab = _mm_loadu_ps(xy_tables->x_table + index);
+    __m128i depth = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(const void *)(depth_image_data + index)));
+    *z = _mm_mul_ps(_mm_cvtepi32_ps(depth), _mm_set1_ps(0.001f));
+    *x = _mm_mul_ps(x_tab, *z);
+    *y = _mm_mul_ps(_mm_loadu_ps(xy_tables->y_table + index), *z);
+    *table_valid = _mm_cmpeq_ps(x_tab, x_tab);
+    return _mm_and_ps(*table_valid, _mm_cmpneq_ps(*z, _mm_setzero_ps()));
+}
+
+static void transformation_pixels_to_points_and_normals_4(const k4a_transformation_xy_tables_t *xy_tables,
+                                                          const uint16_t *depth_image_data,
+                                                          int index,
+                                                          float *points,
+                                                          float *normals)
+{
+    int width = xy_tables->width;
+    __m128 x, y, z, table_valid, left_x, left_y, left_z, right_x, right_y, right_z;
+    __m128 top_x, top_y, top_z, bottom_x, bottom_y, bottom_z, neighbor_table_valid;
+
+    __m128 valid = transformation_pixels_to_points_4(xy_tables, depth_image_data, index, &x, &y, &z, &table_valid);
+    transformation_store_xyz_float_4(points,
+                                     _mm_and_ps(x, table_valid),
+                                     _mm_and_ps(y, table_valid),
+                                     _mm_and_ps(z, table_valid));
+
+    valid = _mm_and_ps(valid,
+                       transformation_pixels_to_points_4(
+                           xy_tables, depth_image_data, index - 1, &left_x, &left_y, &left_z, &neighbor_table_valid));
+    valid = _mm_and_ps(valid,
+                       transformation_pixels_to_points_4(xy_tables,
+                                                         depth_image_data,
+                                                         index + 1,
+                                                         &right_x,
+                                                         &right_y,
+                                                         &right_z,
+                                                         &neighbor_table_valid));
+    valid = _mm_and_ps(valid,
+                       transformation_pixels_to_points_4(
+                           xy_tables, depth_image_data, index - width, &top_x, &top_y, &top_z, &neighbor_table_valid));
+    valid = _mm_and_ps(valid,
+                       transformation_pixels_to_points_4(xy_tables,
+                                                         depth_image_data,
+                                                         index + width,
+                                                         &bottom_x,
+                                                         &bottom_y,
+                                                         &bottom_z,
+                                                         &neighbor_table_valid));
+
+    __m128 dx_x = _mm_sub_ps(right_x, left_x);
+    __m128 dx_y = _mm_sub_ps(right_y, left_y);
+    __m128 dx_z = _mm_sub_ps(right_z, left_z);
+    __m128 dy_x = _mm_sub_ps(bottom_x, top_x);
+    __m128 dy_y = _mm_sub_ps(bottom_y, top_y);
+    __m128 dy_z = _mm_sub_ps(bottom_z, top_z);
+    __m128 n_x = _mm_sub_ps(_mm_mul_ps(dy_y, dx_z), _mm_mul_ps(dy_z, dx_y));
+    __m128 n_y = _mm_sub_ps(_mm_mul_ps(dy_z, dx_x), _mm_mul_ps(dy_x, dx_z));
+    __m128 n_z = _mm_sub_ps(_mm_mul_ps(dy_x, dx_y), _mm_mul_ps(dy_y, dx_x));
+    __m128 length = _mm_sqrt_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(n_x, n_x), _mm_mul_ps(n_y, n_y)), _mm_mul_ps(n_z, n_z)));
+    valid = _mm_and_ps(valid, _mm_cmpgt_ps(length, _mm_setzero_ps()));
+
+    transformation_store_xyz_float_4(normals,
+                                     _mm_and_ps(_mm_div_ps(n_x, length), valid),
+                                     _mm_and_ps(_mm_div_ps(n_y, length), valid),
+                                     _mm_and_ps(_mm_div_ps(n_z, length), valid));
+}
+#elif defined(K4A_USING_NEON)
+// Loads the points of 4 pixels, returns which have a point and sets table_valid to which have a valid xy table entry
+static inline uint32x4_t transformation_pixels_to_points_4(const k4a_transformation_xy_tables_t *xy_tables,
+                                                           const uint16_t *depth_image_data,
+                                                           int index,
+                                                           float32x4_t *x,
+                                                           float32x4_t *y,
+                                                           float32x4_t *z,
+                                                           uint32x4_t *table_valid)
+{
+    float32x4_t x_tab = vld1q_f32(xy_tables->x_table + index);
+    *z = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vld1_u16(depth_image_data + index))), vdupq_n_f32(0.001f));
+    *x = vmulq_f32(x_tab, *z);
+    *y = vmulq_f32(vld1q_f32(xy_tables->y_table + index), *z);
+    *table_valid = vceqq_f32(x_tab, x_tab);
+    return vandq_u32(*table_valid, vmvnq_u32(vceqq_f32(*z, vdupq_n_f32(0.f))));
+}
+
+static inline float32x4_t transformation_mask_f32(float32x4_t value, uint32x4_t mask)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(value), mask));
+}
+
+static void transformation_pixels_to_points_and_normals_4(const k4a_transformation_xy_tables_t *xy_tables,
+                                                          const uint16_t *depth_image_data,
+                                                          int index,
+                                                          float *points,
+                                                          float *normals)
+{
+    int width = xy_tables->width;
+    float32x4_t x, y, z, left_x, left_y, left_z, right_x, right_y, right_z;
+    float32x4_t top_x, top_y, top_z, bottom_x, bottom_y, bottom_z;
+    uint32x4_t table_valid, neighbor_table_valid;
+
+    uint32x4_t valid = transformation_pixels_to_points_4(xy_tables, depth_image_data, index, &x, &y, &z, &table_valid);
+    float32x4x3_t store;
+    store.val[0] = transformation_mask_f32(x, table_valid);
+    store.val[1] = transformation_mask_f32(y, table_valid);
+    store.val[2] = transformation_mask_f32(z, table_valid);
+    vst3q_f32(points, store);
+
+    valid = vandq_u32(valid,
+                      transformation_pixels_to_points_4(
+                          xy_tables, depth_image_data, index - 1, &left_x, &left_y, &left_z, &neighbor_table_valid));
+    valid = vandq_u32(valid,
+                      transformation_pixels_to_points_4(
+                          xy_tables, depth_image_data, index + 1, &right_x, &right_y, &right_z, &neighbor_table_valid));
+    valid = vandq_u32(valid,
+                      transformation_pixels_to_points_4(
+                          xy_tables, depth_image_data, index - width, &top_x, &top_y, &top_z, &neighbor_table_valid));
+    valid = vandq_u32(valid,
+                      transformation_pixels_to_points_4(xy_tables,
+                                                        depth_image_data,
+                                                        index + width,
+                                                        &bottom_x,
+                                                        &bottom_y,
+                                                        &bottom_z,
+                                                        &neighbor_table_valid));
+
+    float32x4_t dx_x = vsubq_f32(right_x, left_x);
+    float32x4_t dx_y = vsubq_f32(right_y, left_y);
+    float32x4_t dx_z = vsubq_f32(right_z, left_z);
+    float32x4_t dy_x = vsubq_f32(bottom_x, top_x);
+    float32x4_t dy_y = vsubq_f32(bottom_y, top_y);
+    float32x4_t dy_z = vsubq_f32(bottom_z, top_z);
+    float32x4_t n_x = vsubq_f32(vmulq_f32(dy_y, dx_z), vmulq_f32(dy_z, dx_y));
+    float32x4_t n_y = vsubq_f32(vmulq_f32(dy_z, dx_x), vmulq_f32(dy_x, dx_z));
+    float32x4_t n_z = vsubq_f32(vmulq_f32(dy_x, dx_y), vmulq_f32(dy_y, dx_x));
+    float32x4_t length = vsqrtq_f32(
+        vaddq_f32(vaddq_f32(vmulq_f32(n_x, n_x), vmulq_f32(n_y, n_y)), vmulq_f32(n_z, n_z)));
+    valid = vandq_u32(valid, vcgtq_f32(length, vdupq_n_f32(0.f)));
+
+    store.val[0] = transformation_mask_f32(vdivq_f32(n_x, length), valid);
+    store.val[1] = transformation_mask_f32(vdivq_f32(n_y, length), valid);
+    store.val[2] = transformation_mask_f32(vdivq_f32(n_z, length), valid);
+    vst3q_f32(normals, store);
+}
+#endif
+
+// Writes the float points and the normals of row y. The point and the normal of a pixel come out of the same kernel,
+// so the depth image is read once for both.
+static void transformation_depth_to_xyz_normals_row(const k4a_transformation_xy_tables_t *xy_tables,
+                                                    const uint16_t *depth_image_data,
+                                                    int y,
+                                                    float *xyz_row,
+                                                    float *normal_row)
+{
+    int width = xy_tables->width;
+    int x = 0;
+#if defined(K4A_USING_SSE) || defined(K4A_USING_NEON)
+    if (y > 0 && y < xy_tables->height - 1 && simd_get_level() != SIMD_LEVEL_NONE)
+    {
+        transformation_pixel_to_point_and_normal(xy_tables, depth_image_data, 0, y, xyz_row, normal_row);
+        for (x = 1; x + 4 <= width - 1; x += 4)
+        {
+            transformation_pixels_to_points_and_normals_4(
+                xy_tables, depth_image_data, y * width + x, xyz_row + 3 * x, normal_row + 3 * x);
+        }
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        transformation_pixel_to_point_and_normal(
+            xy_tables, depth_image_data, x, y, xyz_row + 3 * x, normal_row + 3 * x);
+    }
+}
+
+static k4a_buffer_result_t
+transformation_validate_normal_image(const k4a_transformation_xy_tables_t *xy_tables,
+                                     const uint8_t *normal_image_data,
+                                     const k4a_transformation_image_descriptor_t *normal_image_descriptor)
+{
+    if (normal_image_descriptor == 0)
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_normal_image_descriptor =
+        transformation_init_image_descriptor(xy_tables->width,
+                                             xy_tables->height,
+                                             xy_tables->width * 3 * (int)sizeof(float),
+                                             normal_image_descriptor->format);
+
+    if (normal_image_data == 0 ||
+        transformation_compare_image_descriptors(normal_image_descriptor, &expected_normal_image_descriptor) == false)
+    {
+        if (normal_image_data == 0)
+        {
+            LOG_ERROR("Normal image data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected normal image descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_point_cloud_with_normals_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor)
+{
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+        transformation_validate_point_cloud_parameters(xy_tables,
+                                                       depth_image_data,
+                                                       depth_image_descriptor,
+                                                       K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                                                       xyz_image_data,
+                                                       xyz_image_descriptor));
+    if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    result = TRACE_BUFFER_CALL(
+        transformation_validate_normal_image(xy_tables, normal_image_data, normal_image_descriptor));
+    if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    size_t row_floats = 3 * (size_t)xy_tables->width;
+    for (int y = 0; y < xy_tables->height; y++)
+    {
+        transformation_depth_to_xyz_normals_row(xy_tables,
+                                                (const uint16_t *)(const void *)depth_image_data,
+                                                y,
+                                                (float *)(void *)xyz_image_data + (size_t)y * row_floats,
+                                                (float *)(void *)normal_image_data + (size_t)y * row_floats);
+    }
+
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+// Bits of each voxel coordinate in a voxel key
+#define TRANSFORMATION_VOXEL_COORDINATE_BITS (21)
+#define TRANSFORMATION_VOXEL_EMPTY_KEY (UINT64_MAX)
+#define TRANSFORMATION_VOXEL_INITIAL_SLOT_BITS (12)
+
+// Open addressing hash grid of the voxels of a voxel point cloud. The voxels are numbered in the order their first
+// point is added, and the sums of the points and normals of voxel i are accumulated in point i of the output images.
+typedef struct _k4a_transformation_voxel_grid_t
+{
+    uint64_t *keys;     // key of every slot, TRANSFORMATION_VOXEL_EMPTY_KEY for free slots
+    uint32_t *indices;  // voxel of every slot
+    int slot_bits;      // there are 2^slot_bits slots
+    uint32_t *counts;   // number of points of every voxel
+    size_t voxel_count; // number of voxels
+} k4a_transformation_voxel_grid_t;
+
+static inline size_t transformation_voxel_slot(uint64_t key, int slot_bits)
+{
+    // Fibonacci hashing spreads neighboring voxels over the table
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - slot_bits));
+}
+
+static bool transformation_voxel_grid_resize(k4a_transformation_voxel_grid_t *grid, int slot_bits)
+{
+    size_t slot_count = (size_t)1 << slot_bits;
+    uint64_t *keys = (uint64_t *)malloc(slot_count * sizeof(uint64_t));
+    uint32_t *indices = (uint32_t *)malloc(slot_count * sizeof(uint32_t));
+    if (keys == NULL || indices == NULL)
+    {
+        free(keys);
+        free(indices);
+        return false;
+    }
+    memset(keys, 0xFF, slot_count * sizeof(uint64_t));
+
+    if (grid->keys != NULL)
+    {
+        size_t old_slot_count = (size_t)1 << grid->slot_bits;
+        for (size_t i = 0; i < old_slot_count; i++)
+        {
+            if (grid->keys[i] != TRANSFORMATION_VOXEL_EMPTY_KEY)
+            {
+                size_t slot = transformation_voxel_slot(grid->keys[i], slot_bits);
+                while (keys[slot] != TRANSFORMATION_VOXEL_EMPTY_KEY)
+                {
+                    slot = (slot + 1) & (slot_count - 1);
+                }
+                keys[slot] = grid->keys[i];
+                indices[slot] = grid->indices[i];
+            }
+        }
+    }
+
+    free(grid->keys);
+    free(grid->indices);
+    grid->keys = keys;
+    grid->indices = indices;
+    grid->slot_bits = slot_bits;
+    return true;
+}
+
+static inline uint64_t transformation_voxel_key(const float point[3], float inverse_voxel_size)
+{
+    // Points outside of the grid are added to the voxels on its faces
+    const float offset = (float)(1 << (TRANSFORMATION_VOXEL_COORDINATE_BITS - 1));
+    uint64_t key = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        float coordinate = floorf(point[i] * inverse_voxel_size) + offset;
+        coordinate = coordinate < 0.f ? 0.f : (coordinate > 2.f * offset - 1.f ? 2.f * offset - 1.f : coordinate);
+        key = (key << TRANSFORMATION_VOXEL_COORDINATE_BITS) | (uint64_t)coordinate;
+    }
+    return key;
+}
+
+// Returns the voxel of key, which is added to the grid if it has no point yet, or UINT32_MAX if growing the grid failed
+static uint32_t transformation_voxel_grid_find(k4a_transformation_voxel_grid_t *grid, uint64_t key)
+{
+    size_t slot_mask = ((size_t)1 << grid->slot_bits) - 1;
+    size_t slot = transformation_voxel_slot(key, grid->slot_bits);
+    while (grid->keys[slot] != key && grid->keys[slot] != TRANSFORMATION_VOXEL_EMPTY_KEY)
+    {
+        slot = (slot + 1) & slot_mask;
+    }
+    if (grid->keys[slot] == key)
+    {
+        return grid->indices[slot];
+    }
+
+    // Keep the table at most half full so that probe sequences stay short
+    if ((grid->voxel_count + 1) * 2 > slot_mask + 1)
+    {
+        if (!transformation_voxel_grid_resize(grid, grid->slot_bits + 1))
+        {
+            return UINT32_MAX;
+        }
+        return transformation_voxel_grid_find(grid, key);
+    }
+
+    uint32_t index = (uint32_t)grid->voxel_count++;
+    grid->keys[slot] = key;
+    grid->indices[slot] = index;
+    grid->counts[index] = 0;
+    return index;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_voxel_point_cloud_internal(
+    k4a_transformation_xy_tables_t *xy_tables,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    float voxel_size,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor,
+    size_t *point_count)
+{
+    if (point_count == 0)
+    {
+        LOG_ERROR("Point count is null.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    if (!(voxel_size > 0.f))
+    {
+        LOG_ERROR("Expect the voxel size to be larger than 0, actual value is %lf.", (double)voxel_size);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+        transformation_validate_point_cloud_parameters(xy_tables,
+                                                       depth_image_data,
+                                                       depth_image_descriptor,
+                                                       K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                                                       xyz_image_data,
+                                                       xyz_image_descriptor));
+    if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    // The normal image is optional
+    bool with_normals = normal_image_data != 0 || normal_image_descriptor != 0;
+    if (with_normals)
+    {
+        result = TRACE_BUFFER_CALL(
+            transformation_validate_normal_image(xy_tables, normal_image_data, normal_image_descriptor));
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            return result;
+        }
+    }
+
+    // The points, and normals, of a row are computed into scratch rows and added to the grid before the next row, so
+    // neither the organized point cloud nor the normals are written out
+    int width = xy_tables->width;
+    const uint16_t *depth = (const uint16_t *)(const void *)depth_image_data;
+    float *xyz_row = (float *)malloc(3 * (size_t)width * sizeof(float));
+    float *normal_row = with_normals ? (float *)malloc(3 * (size_t)width * sizeof(float)) : NULL;
+    k4a_transformation_voxel_grid_t grid;
+    memset(&grid, 0, sizeof(grid));
+    grid.counts = (uint32_t *)malloc((size_t)width * (size_t)xy_tables->height * sizeof(uint32_t));
+    bool succeeded = xyz_row != NULL && (normal_row != NULL || !with_normals) && grid.counts != NULL &&
+                     transformation_voxel_grid_resize(&grid, TRANSFORMATION_VOXEL_INITIAL_SLOT_BITS);
+    if (!succeeded)
+    {
+        LOG_ERROR("Failed to allocate the voxel grid.", 0);
+    }
+
+    float *xyz_sums = (float *)(void *)xyz_image_data;
+    float *normal_sums = (float *)(void *)normal_image_data;
+    float inverse_voxel_size = 1.f / voxel_size;
+    for (int y = 0; y < xy_tables->height && succeeded; y++)
+    {
+        int row_index = y * width;
+        if (with_normals)
+        {
+            transformation_depth_to_xyz_normals_row(xy_tables, depth, y, xyz_row, normal_row);
+        }
+        else
+        {
+            k4a_transformation_xy_tables_t xy_tables_row;
+            xy_tables_row.x_table = xy_tables->x_table + row_index;
+            xy_tables_row.y_table = xy_tables->y_table + row_index;
+            xy_tables_row.width = width;
+            xy_tables_row.height = 1;
+            transformation_depth_to_point_cloud(&xy_tables_row,
+                                                (const uint8_t *)(depth + row_index),
+                                                K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                                                (uint8_t *)xyz_row);
+        }
+
+        for (int x = 0; x < width; x++)
+        {
+            const float *point = xyz_row + 3 * x;
+            if (point[2] == 0.f)
+            {
+                continue;
+            }
+
+            uint32_t index = transformation_voxel_grid_find(&grid, transformation_voxel_key(point, inverse_voxel_size));
+            if (index == UINT32_MAX)
+            {
+                LOG_ERROR("Failed to grow the voxel grid.", 0);
+                succeeded = false;
+                break;
+            }
+
+            float *xyz_sum = xyz_sums + 3 * (size_t)index;
+            float *normal_sum = with_normals ? normal_sums + 3 * (size_t)index : NULL;
+            for (int i = 0; i < 3; i++)
+            {
+                xyz_sum[i] = grid.counts[index] == 0 ? point[i] : xyz_sum[i] + point[i];
+                if (with_normals)
+                {
+                    float normal = normal_row[3 * x + i];
+                    normal_sum[i] = grid.counts[index] == 0 ? normal : normal_sum[i] + normal;
+                }
+            }
+            grid.counts[index]++;
+        }
+    }
+
+    // Every voxel becomes the centroid of its points, with the normalized sum of their normals
+    for (size_t i = 0; i < grid.voxel_count && succeeded; i++)
+    {
+        float *xyz_sum = xyz_sums + 3 * i;
+        float count = (float)grid.counts[i];
+        xyz_sum[0] /= count;
+        xyz_sum[1] /= count;
+        xyz_sum[2] /= count;
+        if (with_normals)
+        {
+            float *normal_sum = normal_sums + 3 * i;
+            float length = sqrtf(normal_sum[0] * normal_sum[0] + normal_sum[1] * normal_sum[1] +
+                                 normal_sum[2] * normal_sum[2]);
+            for (int c = 0; c < 3; c++)
+            {
+                normal_sum[c] = length > 0.f ? normal_sum[c] / length : 0.f;
+            }
+        }
+    }
+
+    free(xyz_row);
+    free(normal_row);
+    free(grid.keys);
+    free(grid.indices);
+    free(grid.counts);
+
+    if (!succeeded)
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+    *point_count = grid.voxel_count;
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+// Produces the point cloud and the color of every depth pixel one row at a time, so that neither the point cloud nor
+// the color image in depth geometry is written out as an intermediate image.
+static k4a_result_t transformation_depth_to_colored_xyz(k4a_transformation_rgbz_context_t *context,
+                                                        uint8_t *colored_xyz_image_data)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_init_correspondence_params(context))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    int width = context->depth_image.descriptor->width_pixels;
+    int height = context->depth_image.descriptor->height_pixels;
+    k4a_correspondence_t *correspondences = (k4a_correspondence_t *)malloc((size_t)width *
+                                                                         sizeof(k4a_correspondence_t));
+    size_t xyz_row_size = (3 * (size_t)width * sizeof(int16_t) + 15) & ~(size_t)15;
+#ifdef _MSC_VER
+    int16_t *xyz_row = (int16_t *)_aligned_malloc(xyz_row_size, 16);
+#else
+    int16_t *xyz_row = (int16_t *)aligned_alloc(16, xyz_row_size);
+#endif
+
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(correspondences != NULL && xyz_row != NULL);
+    for (int y = 0; y < height && K4A_SUCCEEDED(result); y++)
+    {
+        int row_index = y * width;
+        result = TRACE_CALL(transformation_compute_correspondences(row_index, width, context, correspondences));
+        if (K4A_FAILED(result))
+        {
+            break;
+        }
+
+        k4a_transformation_xy_tables_t xy_tables_row;
+        xy_tables_row.x_table = context->xy_tables->x_table + row_index;
+        xy_tables_row.y_table = context->xy_tables->y_table + row_index;
+        xy_tables_row.width = width;
+        xy_tables_row.height = 1;
+        transformation_depth_to_point_cloud(&xy_tables_row,
+                                            (const uint8_t *)(context->depth_image.data_uint16 + row_index),
+                                            K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS,
+                                            (uint8_t *)xyz_row);
+
+        uint8_t *point = colored_xyz_image_data + (size_t)row_index * TRANSFORMATION_COLORED_POINT_SIZE;
+        for (int x = 0; x < width; x++, point += TRANSFORMATION_COLORED_POINT_SIZE)
+        {
+            memcpy(point, xyz_row + 3 * x, 3 * sizeof(int16_t));
+            transformation_sample_bgra(context, &correspondences[x], true, point + 3 * sizeof(int16_t));
+        }
+    }
+
+    free(correspondences);
+#ifdef _MSC_VER
+    _aligned_free(xyz_row);
+#else
+    free(xyz_row);
+#endif
+    return result;
+}
+
+k4a_buffer_result_t transformation_depth_image_to_colored_point_cloud_internal(
+    const k4a_calibration_t *calibration,
+    const k4a_transformation_xy_tables_t *xy_tables_depth_camera,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *colored_xyz_image_data,
+    k4a_transformation_image_descriptor_t *colored_xyz_image_descriptor)
+{
+    if (colored_xyz_image_descriptor == 0 || calibration == 0 || xy_tables_depth_camera == 0)
+    {
+        if (calibration == 0)
+        {
+            LOG_ERROR("Calibration is null.", 0);
+        }
+        if (xy_tables_depth_camera == 0)
+        {
+            LOG_ERROR("Depth camera xy table is null.", 0);
+        }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_colored_xyz_image_descriptor =
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * TRANSFORMATION_COLORED_POINT_SIZE,
+                                             colored_xyz_image_descriptor->format);
+
+    if (colored_xyz_image_data == 0 ||
+        transformation_compare_image_descriptors(colored_xyz_image_descriptor,
+                                                 &expected_colored_xyz_image_descriptor) == false)
+    {
+        if (colored_xyz_image_data == 0)
+        {
+            LOG_ERROR("Colored XYZ image data is null.", 0);
+        }
+        else
+        {
+            LOG_ERROR("Unexpected colored XYZ image descriptor, see details above.", 0);
+        }
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    if (depth_image_data == 0 || depth_image_descriptor == 0 || color_image_data == 0 || color_image_descriptor == 0)
+    {
+        if (depth_image_data == 0)
+        {
+            LOG_ERROR("Depth image data is null.", 0);
+        }
+        if (color_image_data == 0)
+        {
+            LOG_ERROR("Color image data is null.", 0);
+        }
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_depth_image_descriptor =
+        transformation_init_image_descriptor(xy_tables_depth_camera->width,
+                                             xy_tables_depth_camera->height,
+                                             xy_tables_depth_camera->width * (int)sizeof(uint16_t),
+                                             K4A_IMAGE_FORMAT_DEPTH16);
+
+    if (transformation_compare_image_descriptors(depth_image_descriptor, &expected_depth_image_descriptor) == false)
+    {
+        LOG_ERROR("Unexpected depth image descriptor, see details above.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_image_descriptor_t expected_color_image_descriptor =
+        transformation_init_image_descriptor(calibration->color_camera_calibration.resolution_width,
+                                             calibration->color_camera_calibration.resolution_height,
+                                             calibration->color_camera_calibration.resolution_width * 4 *
+                                                 (int)sizeof(uint8_t),
+                                             K4A_IMAGE_FORMAT_COLOR_BGRA32);
+
+    if (transformation_compare_image_descriptors(color_image_descriptor, &expected_color_image_descriptor) == false)
+    {
+        LOG_ERROR("Unexpected color image descriptor, see details above.", 0);
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    k4a_transformation_rgbz_context_t context;
+    memset(&context, 0, sizeof(k4a_transformation_rgbz_context_t));
+
+    context.xy_tables = xy_tables_depth_camera;
+    context.calibration = calibration;
+
+    context.depth_image = transformation_init_input_image(depth_image_descriptor, depth_image_data);
+
+    context.color_image = transformation_init_input_image(color_image_descriptor, color_image_data);
+
+    if (K4A_FAILED(TRACE_CALL(transformation_depth_to_colored_xyz(&context, colored_xyz_image_data))))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
     return K4A_BUFFER_RESULT_SUCCEEDED;
 }
@@ -8,12 +8,23 @@
 #include <k4ainternal/logging.h>
 #include <k4ainternal/deloader.h>
 #include <k4ainternal/tewrapper.h>
+#include <k4ainternal/threadpool.h>
 #include <k4ainternal/image.h>
+#include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/threadapi.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/lock.h>
+#include <turbojpeg.h>
 
 // System dependencies
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
+#include <stdio.h>
+#include <limits.h>
+
+// Number of points that batched transformations stage on the stack at a time
+#define TRANSFORMATION_BATCH_CHUNK_SIZE (64)
 
 k4a_result_t transformation_get_mode_specific_calibration(const k4a_calibration_camera_t *depth_camera_calibration,
                                                           const k4a_calibration_camera_t *color_camera_calibration,
@@ -276,6 +287,133 @@ k4a_result_t transformation_3d_to_2d(const k4a_calibration_t *calibration,
     }
 }
 
+k4a_result_t transformation_2d_to_3d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points2d,
+                                           const float *source_depths,
+                                           size_t point_count,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points3d,
+                                           int *valid)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))) ||
+        K4A_FAILED(TRACE_CALL(transformation_possible(calibration, target_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_camera_t *camera_calibration = NULL;
+    if (source_camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        camera_calibration = &calibration->depth_camera_calibration;
+    }
+    else if (source_camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        camera_calibration = &calibration->color_camera_calibration;
+    }
+    else
+    {
+        LOG_ERROR("Unexpected source camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  source_camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return K4A_RESULT_FAILED; // unproject only supported for depth and color cameras
+    }
+
+    if (K4A_FAILED(TRACE_CALL(transformation_unproject_batch(
+            camera_calibration, source_points2d, source_depths, point_count, target_points3d, valid))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (source_camera == target_camera)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    const k4a_calibration_extrinsics_t *source_to_target = &calibration->extrinsics[source_camera][target_camera];
+    for (size_t i = 0; i < point_count; i++)
+    {
+        float *target_point3d = target_points3d + 3 * i;
+        if (K4A_FAILED(TRACE_CALL(
+                transformation_apply_extrinsic_transformation(source_to_target, target_point3d, target_point3d))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_3d_to_2d_batch(const k4a_calibration_t *calibration,
+                                           const float *source_points3d,
+                                           size_t point_count,
+                                           const k4a_calibration_type_t source_camera,
+                                           const k4a_calibration_type_t target_camera,
+                                           float *target_points2d,
+                                           int *valid)
+{
+    if (K4A_FAILED(TRACE_CALL(transformation_possible(calibration, source_camera))) ||
+        K4A_FAILED(TRACE_CALL(transformation_possible(calibration, target_camera))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_camera_t *camera_calibration = NULL;
+    if (target_camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        camera_calibration = &calibration->depth_camera_calibration;
+    }
+    else if (target_camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        camera_calibration = &calibration->color_camera_calibration;
+    }
+    else
+    {
+        LOG_ERROR("Unexpected target camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  target_camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return K4A_RESULT_FAILED; // project only supported for depth and color cameras
+    }
+
+    if (source_camera == target_camera)
+    {
+        return TRACE_CALL(
+            transformation_project_batch(camera_calibration, source_points3d, point_count, target_points2d, valid));
+    }
+
+    const k4a_calibration_extrinsics_t *source_to_target = &calibration->extrinsics[source_camera][target_camera];
+    float target_points3d[3 * TRANSFORMATION_BATCH_CHUNK_SIZE];
+    for (size_t first = 0; first < point_count; first += TRANSFORMATION_BATCH_CHUNK_SIZE)
+    {
+        size_t chunk_size = point_count - first;
+        if (chunk_size > TRANSFORMATION_BATCH_CHUNK_SIZE)
+        {
+            chunk_size = TRANSFORMATION_BATCH_CHUNK_SIZE;
+        }
+
+        for (size_t i = 0; i < chunk_size; i++)
+        {
+            if (K4A_FAILED(TRACE_CALL(transformation_apply_extrinsic_transformation(
+                    source_to_target, source_points3d + 3 * (first + i), target_points3d + 3 * i))))
+            {
+                return K4A_RESULT_FAILED;
+            }
+        }
+
+        if (K4A_FAILED(TRACE_CALL(transformation_project_batch(
+                camera_calibration, target_points3d, chunk_size, target_points2d + 2 * first, valid + first))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t transformation_2d_to_2d(const k4a_calibration_t *calibration,
                                      const float source_point2d[2],
                                      const float source_depth,
@@ -508,32 +646,52 @@ static k4a_buffer_result_t transformation_init_xy_tables(const k4a_calibration_t
         xy_tables->x_table = data;
         xy_tables->y_table = data + table_size;
 
-        float point2d[2], point3d[3];
-        int valid = 1;
+        // Unproject the pixels in chunks through the batch path, which undistorts several pixels at a time
+        float points2d[2 * TRANSFORMATION_BATCH_CHUNK_SIZE];
+        float depths[TRANSFORMATION_BATCH_CHUNK_SIZE];
+        float points3d[3 * TRANSFORMATION_BATCH_CHUNK_SIZE];
+        int valid[TRANSFORMATION_BATCH_CHUNK_SIZE];
+        for (int i = 0; i < TRANSFORMATION_BATCH_CHUNK_SIZE; i++)
+        {
+            depths[i] = 1.f;
+        }
 
         for (int y = 0, idx = 0; y < height; y++)
         {
-            point2d[1] = (float)y;
-            for (int x = 0; x < width; x++, idx++)
+            for (int first_x = 0; first_x < width; first_x += TRANSFORMATION_BATCH_CHUNK_SIZE)
             {
-                point2d[0] = (float)x;
-                if (K4A_FAILED(TRACE_CALL(
-                        transformation_2d_to_3d(calibration, point2d, 1.f, camera, camera, point3d, &valid))))
+                int chunk_size = width - first_x;
+                if (chunk_size > TRANSFORMATION_BATCH_CHUNK_SIZE)
                 {
-                    return K4A_BUFFER_RESULT_FAILED;
+                    chunk_size = TRANSFORMATION_BATCH_CHUNK_SIZE;
                 }
 
-                if (valid == 0)
+                for (int i = 0; i < chunk_size; i++)
                 {
-                    // x table value of NAN marks invalid
-                    xy_tables->x_table[idx] = NAN;
-                    // set y table value to 0 to speed up SSE implementation
-                    xy_tables->y_table[idx] = 0.f;
+                    points2d[2 * i + 0] = (float)(first_x + i);
+                    points2d[2 * i + 1] = (float)y;
+                }
+
+                if (K4A_FAILED(TRACE_CALL(transformation_2d_to_3d_batch(
+                        calibration, points2d, depths, (size_t)chunk_size, camera, camera, points3d, valid))))
+                {
+                    return K4A_BUFFER_RESULT_FAILED;
                 }
-                else
+
+                for (int i = 0; i < chunk_size; i++, idx++)
                 {
-                    xy_tables->x_table[idx] = point3d[0];
-                    xy_tables->y_table[idx] = point3d[1];
+                    if (valid[i] == 0)
+                    {
+                        // x table value of NAN marks invalid
+                        xy_tables->x_table[idx] = NAN;
+                        // set y table value to 0 to speed up SSE implementation
+                        xy_tables->y_table[idx] = 0.f;
+                    }
+                    else
+                    {
+                        xy_tables->x_table[idx] = points3d[3 * i + 0];
+                        xy_tables->y_table[idx] = points3d[3 * i + 1];
+                    }
                 }
             }
         }
@@ -542,6 +700,130 @@ static k4a_buffer_result_t transformation_init_xy_tables(const k4a_calibration_t
     }
 }
 
+// The xy tables only depend on the intrinsics and resolution of a camera, so they can be stored on disk and reused by
+// later processes. The cache is enabled by pointing K4A_TRANSFORMATION_CACHE_DIR at an existing directory.
+#define TRANSFORMATION_XY_TABLES_CACHE_MAGIC (0x59584b34) // "4KXY"
+#define TRANSFORMATION_XY_TABLES_CACHE_VERSION (1)        // bump when the file layout or the unprojection changes
+#define TRANSFORMATION_XY_TABLES_CACHE_MAX_PATH (1024)
+
+typedef struct _k4a_transformation_xy_tables_cache_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t calibration_hash; // identifies both the device and the mode specific intrinsics
+    int32_t width;
+    int32_t height;
+    uint64_t data_hash; // detects truncated or corrupted tables
+} k4a_transformation_xy_tables_cache_header_t;
+
+// 64-bit FNV-1a applied to 32-bit words rather than bytes, which keeps hashing the tables cheap compared to loading
+// them. Both the calibration and the tables are made of 32-bit fields.
+static uint64_t transformation_hash(const void *data, size_t size)
+{
+    const uint32_t *words = (const uint32_t *)data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++)
+    {
+        hash ^= words[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool transformation_get_xy_tables_cache_path(const k4a_calibration_t *calibration,
+                                                    k4a_calibration_type_t camera,
+                                                    char *path,
+                                                    size_t path_size,
+                                                    k4a_transformation_xy_tables_cache_header_t *header)
+{
+    const char *cache_dir = environment_get_variable("K4A_TRANSFORMATION_CACHE_DIR");
+    if (cache_dir == NULL || cache_dir[0] == '\0')
+    {
+        return false;
+    }
+
+    const k4a_calibration_camera_t *camera_calibration = camera == K4A_CALIBRATION_TYPE_DEPTH ?
+                                                             &calibration->depth_camera_calibration :
+                                                             &calibration->color_camera_calibration;
+    header->magic = TRANSFORMATION_XY_TABLES_CACHE_MAGIC;
+    header->version = TRANSFORMATION_XY_TABLES_CACHE_VERSION;
+    header->calibration_hash = transformation_hash(camera_calibration, sizeof(k4a_calibration_camera_t));
+    header->width = camera_calibration->resolution_width;
+    header->height = camera_calibration->resolution_height;
+    header->data_hash = 0;
+
+    int length = snprintf(path,
+                          path_size,
+                          "%s/k4a_xy_tables_%s_%dx%d_%016" PRIx64 ".bin",
+                          cache_dir,
+                          camera == K4A_CALIBRATION_TYPE_DEPTH ? "depth" : "color",
+                          header->width,
+                          header->height,
+                          header->calibration_hash);
+    if (length < 0 || (size_t)length >= path_size)
+    {
+        LOG_WARNING("K4A_TRANSFORMATION_CACHE_DIR is too long, xy tables will not be cached.", 0);
+        return false;
+    }
+    return true;
+}
+
+static bool transformation_load_xy_tables(const char *path,
+                                          const k4a_transformation_xy_tables_cache_header_t *expected_header,
+                                          float *data,
+                                          size_t data_size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    k4a_transformation_xy_tables_cache_header_t header;
+    bool loaded = fread(&header, sizeof(header), 1, file) == 1 && header.magic == expected_header->magic &&
+                  header.version == expected_header->version &&
+                  header.calibration_hash == expected_header->calibration_hash &&
+                  header.width == expected_header->width && header.height == expected_header->height &&
+                  fread(data, sizeof(float), data_size, file) == data_size && fgetc(file) == EOF &&
+                  header.data_hash == transformation_hash(data, data_size * sizeof(float));
+    fclose(file);
+
+    if (!loaded)
+    {
+        LOG_WARNING("Ignoring xy tables cache file %s that does not match the calibration.", path);
+    }
+    return loaded;
+}
+
+static void transformation_store_xy_tables(const char *path,
+                                           k4a_transformation_xy_tables_cache_header_t *header,
+                                           const float *data,
+                                           size_t data_size)
+{
+    header->data_hash = transformation_hash(data, data_size * sizeof(float));
+
+    // Write to a temporary file first so that other processes either see a complete file or no file at all
+    char temp_path[TRANSFORMATION_XY_TABLES_CACHE_MAX_PATH + 4];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL)
+    {
+        LOG_WARNING("Failed to create xy tables cache file %s.", temp_path);
+        return;
+    }
+
+    bool written = fwrite(header, sizeof(*header), 1, file) == 1 &&
+                   fwrite(data, sizeof(float), data_size, file) == data_size;
+    written = fclose(file) == 0 && written;
+
+    if (!written || rename(temp_path, path) != 0)
+    {
+        LOG_WARNING("Failed to write xy tables cache file %s.", path);
+        remove(temp_path);
+    }
+}
+
 static k4a_result_t transformation_allocate_xy_tables(const k4a_calibration_t *calibration,
                                                       k4a_calibration_type_t camera,
                                                       float **buffer,
@@ -561,14 +843,97 @@ static k4a_result_t transformation_allocate_xy_tables(const k4a_calibration_t *c
     *buffer = aligned_alloc(16, xy_tables_data_size * sizeof(float));
 #endif
 
+    char cache_path[TRANSFORMATION_XY_TABLES_CACHE_MAX_PATH];
+    k4a_transformation_xy_tables_cache_header_t cache_header;
+    bool use_cache = transformation_get_xy_tables_cache_path(
+        calibration, camera, cache_path, sizeof(cache_path), &cache_header);
+    if (use_cache && transformation_load_xy_tables(cache_path, &cache_header, *buffer, xy_tables_data_size))
+    {
+        size_t table_size = xy_tables_data_size / 2;
+        xy_tables->width = cache_header.width;
+        xy_tables->height = cache_header.height;
+        xy_tables->x_table = *buffer;
+        xy_tables->y_table = *buffer + table_size;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     if (K4A_BUFFER_RESULT_SUCCEEDED !=
         TRACE_BUFFER_CALL(transformation_init_xy_tables(calibration, camera, *buffer, &xy_tables_data_size, xy_tables)))
     {
         return K4A_RESULT_FAILED;
     }
+
+    if (use_cache)
+    {
+        transformation_store_xy_tables(cache_path, &cache_header, *buffer, xy_tables_data_size);
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static void transformation_free_tables(float *buffer)
+{
+#ifdef _MSC_VER
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+// Rotates each depth camera ray of the xy tables into the color camera once, so that a depth pixel transforms into
+// the color camera as depth * ray + translation.
+static k4a_result_t transformation_allocate_ray_tables(const k4a_calibration_t *calibration,
+                                                       const k4a_transformation_xy_tables_t *xy_tables,
+                                                       float **buffer,
+                                                       k4a_transformation_ray_tables_t *ray_tables)
+{
+    size_t table_size = (size_t)(xy_tables->width * xy_tables->height);
+#ifdef _MSC_VER
+    *buffer = _aligned_malloc(3 * table_size * sizeof(float), 16);
+#else
+    *buffer = aligned_alloc(16, 3 * table_size * sizeof(float));
+#endif
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(*buffer != NULL)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    ray_tables->x_table = *buffer;
+    ray_tables->y_table = *buffer + table_size;
+    ray_tables->z_table = *buffer + 2 * table_size;
+    ray_tables->width = xy_tables->width;
+    ray_tables->height = xy_tables->height;
+
+    const float *R = calibration->extrinsics[K4A_CALIBRATION_TYPE_DEPTH][K4A_CALIBRATION_TYPE_COLOR].rotation;
+    for (size_t i = 0; i < table_size; i++)
+    {
+        float x = xy_tables->x_table[i];
+        float y = xy_tables->y_table[i];
+        if (isnan(x))
+        {
+            ray_tables->x_table[i] = NAN;
+            ray_tables->y_table[i] = 0.f;
+            ray_tables->z_table[i] = 0.f;
+        }
+        else
+        {
+            ray_tables->x_table[i] = R[0] * x + R[1] * y + R[2];
+            ray_tables->y_table[i] = R[3] * x + R[4] * y + R[5];
+            ray_tables->z_table[i] = R[6] * x + R[7] * y + R[8];
+        }
+    }
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Jobs of one k4a_transformation_submit() call, queued for the worker thread of the transformation handle
+typedef struct _k4a_transformation_submission_t
+{
+    struct _k4a_transformation_submission_t *next;
+    k4a_transformation_job_t *jobs; // Allocated together with the submission
+    size_t job_count;
+    k4a_transformation_completion_cb_t *callback;
+    void *callback_context;
+} k4a_transformation_submission_t;
+
 typedef struct _k4a_transformation_context_t
 {
     k4a_calibration_t calibration;
@@ -578,325 +943,2157 @@ typedef struct _k4a_transformation_context_t
     float *memory_color_camera_xy_tables;
     bool enable_gpu_optimization;
     bool enable_depth_color_transform;
+    uint32_t thread_count;
+    bool threadpool_acquired; // Held while thread_count is above 1
+    k4a_transformation_ray_tables_t depth_to_color_ray_tables;
+    float *memory_depth_to_color_ray_tables;
+    k4a_transformation_roi_t roi;                   // decimation is 0 when no region of interest is set
+    k4a_transformation_xy_tables_t roi_xy_tables;   // depth camera xy tables of the pixels of the region
+    float *memory_roi_xy_tables;
+    k4a_transformation_ray_tables_t roi_ray_tables; // depth to color ray tables of the pixels of the region
+    float *memory_roi_ray_tables;
     tewrapper_t tewrapper;
+
+    // Transformations run concurrently on any number of threads, changes to the tables and the region of interest
+    // wait for the running transformations to complete and hold new ones back until they are done
+    LOCK_HANDLE config_lock;
+    COND_HANDLE config_condition; // Signaled when the last running transformation or a change completed
+    size_t active_call_count;
+    bool config_update_pending;
+
+    LOCK_HANDLE queue_lock;
+    COND_HANDLE queue_condition; // Signaled when a submission is queued or the worker thread has to stop
+    COND_HANDLE idle_condition;  // Signaled when the last pending submission completed
+    THREAD_HANDLE queue_thread;  // Started by the first submission
+    k4a_transformation_submission_t *queue_head;
+    k4a_transformation_submission_t *queue_tail;
+    size_t pending_submission_count; // Queued submissions and the one the worker thread is running
+    bool queue_thread_stop;
 } k4a_transformation_context_t;
 
+// Depth camera tables and images that a CPU transformation runs on. Without a region of interest these are the full
+// resolution tables and the images of the caller, with one they are the tables of the region and copies of the pixels
+// of the region.
+typedef struct _k4a_transformation_depth_input_t
+{
+    k4a_transformation_xy_tables_t *xy_tables;
+    const k4a_transformation_ray_tables_t *ray_tables;
+    const uint8_t *depth_image_data;
+    k4a_transformation_image_descriptor_t *depth_image_descriptor;
+    size_t custom_image_count;
+    const uint8_t *custom_image_data[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    k4a_transformation_image_descriptor_t custom_image_descriptors[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES];
+    uint8_t *roi_images;
+    k4a_transformation_image_descriptor_t roi_depth_image_descriptor;
+} k4a_transformation_depth_input_t;
+
 K4A_DECLARE_CONTEXT(k4a_transformation_t, k4a_transformation_context_t);
 
-k4a_transformation_t transformation_create(const k4a_calibration_t *calibration, bool gpu_optimization)
+static bool transformation_roi_enabled(const k4a_transformation_context_t *transformation_context)
 {
-    k4a_transformation_t transformation_handle = NULL;
-    k4a_transformation_context_t *transformation_context = k4a_transformation_t_create(&transformation_handle);
-
-    memcpy(&transformation_context->calibration, calibration, sizeof(k4a_calibration_t));
+    return transformation_context->roi.decimation != 0;
+}
 
-    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
-                                                                K4A_CALIBRATION_TYPE_DEPTH,
-                                                                &transformation_context->memory_depth_camera_xy_tables,
-                                                                &transformation_context->depth_camera_xy_tables))))
+static void transformation_free_roi_tables(k4a_transformation_context_t *transformation_context)
+{
+    if (transformation_context->memory_roi_xy_tables != 0)
     {
-        transformation_destroy(transformation_handle);
-        return 0;
+        transformation_free_tables(transformation_context->memory_roi_xy_tables);
+        transformation_context->memory_roi_xy_tables = 0;
+    }
+    if (transformation_context->memory_roi_ray_tables != 0)
+    {
+        transformation_free_tables(transformation_context->memory_roi_ray_tables);
+        transformation_context->memory_roi_ray_tables = 0;
     }
+}
 
-    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
-                                                                K4A_CALIBRATION_TYPE_COLOR,
-                                                                &transformation_context->memory_color_camera_xy_tables,
-                                                                &transformation_context->color_camera_xy_tables))))
+// Picks the depth camera xy table entries of the pixels of the region of interest, so that the transformations run on
+// the region exactly like they do on the full image. The ray tables of the region follow from its xy tables.
+static k4a_result_t transformation_update_roi_tables(k4a_transformation_context_t *transformation_context)
+{
+    transformation_free_roi_tables(transformation_context);
+    if (!transformation_roi_enabled(transformation_context))
     {
-        transformation_destroy(transformation_handle);
-        return 0;
+        return K4A_RESULT_SUCCEEDED;
     }
 
-    transformation_context->enable_gpu_optimization = gpu_optimization;
-    transformation_context->enable_depth_color_transform = transformation_context->calibration.color_resolution !=
-                                                               K4A_COLOR_RESOLUTION_OFF &&
-                                                           transformation_context->calibration.depth_mode !=
-                                                               K4A_DEPTH_MODE_OFF;
-    if (transformation_context->enable_gpu_optimization && transformation_context->enable_depth_color_transform)
+    const k4a_transformation_roi_t *roi = &transformation_context->roi;
+    const k4a_transformation_xy_tables_t *xy_tables = &transformation_context->depth_camera_xy_tables;
+    int width = (roi->width + roi->decimation - 1) / roi->decimation;
+    int height = (roi->height + roi->decimation - 1) / roi->decimation;
+    size_t table_size = (size_t)width * (size_t)height;
+    size_t buffer_size = (2 * table_size * sizeof(float) + 15) & ~(size_t)15;
+
+#ifdef _MSC_VER
+    float *buffer = (float *)_aligned_malloc(buffer_size, 16);
+#else
+    float *buffer = (float *)aligned_alloc(16, buffer_size);
+#endif
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(buffer != NULL)))
     {
-        // Set up transform engine expected calibration struct
-        k4a_transform_engine_calibration_t transform_engine_calibration;
-        memcpy(&transform_engine_calibration.depth_camera_calibration,
-               &transformation_context->calibration.depth_camera_calibration,
-               sizeof(k4a_calibration_camera_t));
-        memcpy(&transform_engine_calibration.color_camera_calibration,
-               &transformation_context->calibration.color_camera_calibration,
-               sizeof(k4a_calibration_camera_t));
-        memcpy(&transform_engine_calibration.depth_camera_to_color_camera_extrinsics,
-               &transformation_context->calibration.extrinsics[K4A_CALIBRATION_TYPE_DEPTH][K4A_CALIBRATION_TYPE_COLOR],
-               sizeof(k4a_calibration_extrinsics_t));
-        memcpy(&transform_engine_calibration.color_camera_to_depth_camera_extrinsics,
-               &transformation_context->calibration.extrinsics[K4A_CALIBRATION_TYPE_COLOR][K4A_CALIBRATION_TYPE_DEPTH],
-               sizeof(k4a_calibration_extrinsics_t));
-        memcpy(&transform_engine_calibration.depth_camera_xy_tables,
-               &transformation_context->depth_camera_xy_tables,
-               sizeof(k4a_transformation_xy_tables_t));
+        return K4A_RESULT_FAILED;
+    }
 
-        transformation_context->tewrapper = tewrapper_create(&transform_engine_calibration);
-        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->tewrapper != NULL)))
+    k4a_transformation_xy_tables_t *roi_xy_tables = &transformation_context->roi_xy_tables;
+    transformation_context->memory_roi_xy_tables = buffer;
+    roi_xy_tables->x_table = buffer;
+    roi_xy_tables->y_table = buffer + table_size;
+    roi_xy_tables->width = width;
+    roi_xy_tables->height = height;
+
+    for (int y = 0; y < height; y++)
+    {
+        int source_index = (roi->y + y * roi->decimation) * xy_tables->width + roi->x;
+        for (int x = 0; x < width; x++, source_index += roi->decimation)
         {
-            transformation_destroy(transformation_handle);
-            return 0;
+            roi_xy_tables->x_table[y * width + x] = xy_tables->x_table[source_index];
+            roi_xy_tables->y_table[y * width + x] = xy_tables->y_table[source_index];
         }
     }
 
-    return transformation_handle;
+    if (transformation_context->memory_depth_to_color_ray_tables != 0)
+    {
+        float *ray_buffer = 0;
+        if (K4A_FAILED(TRACE_CALL(transformation_allocate_ray_tables(&transformation_context->calibration,
+                                                                     roi_xy_tables,
+                                                                     &ray_buffer,
+                                                                     &transformation_context->roi_ray_tables))))
+        {
+            transformation_free_roi_tables(transformation_context);
+            return K4A_RESULT_FAILED;
+        }
+        transformation_context->memory_roi_ray_tables = ray_buffer;
+    }
+    return K4A_RESULT_SUCCEEDED;
 }
 
-void transformation_destroy(k4a_transformation_t transformation_handle)
+// Copies the pixels of the region of interest out of a full resolution depth camera image
+static void transformation_gather_roi_image(const k4a_transformation_context_t *transformation_context,
+                                            const uint8_t *image_data,
+                                            const k4a_transformation_image_descriptor_t *image_descriptor,
+                                            int bytes_per_pixel,
+                                            uint8_t *roi_image_data)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_transformation_t, transformation_handle);
-    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+    const k4a_transformation_roi_t *roi = &transformation_context->roi;
+    int width = transformation_context->roi_xy_tables.width;
+    int height = transformation_context->roi_xy_tables.height;
+    size_t step = (size_t)(roi->decimation * bytes_per_pixel);
 
-    if (transformation_context->memory_depth_camera_xy_tables != 0)
+    for (int y = 0; y < height; y++)
     {
-#ifdef _MSC_VER
-        _aligned_free(transformation_context->memory_depth_camera_xy_tables);
-#else
-        free(transformation_context->memory_depth_camera_xy_tables);
-#endif
+        size_t row = (size_t)(roi->y + y * roi->decimation);
+        const uint8_t *source = image_data + row * (size_t)image_descriptor->stride_bytes +
+                                (size_t)(roi->x * bytes_per_pixel);
+        uint8_t *target = roi_image_data + (size_t)(y * width * bytes_per_pixel);
+        for (int x = 0; x < width; x++, source += step, target += bytes_per_pixel)
+        {
+            memcpy(target, source, (size_t)bytes_per_pixel);
+        }
     }
-    if (transformation_context->memory_color_camera_xy_tables != 0)
+}
+
+static bool transformation_validate_roi_source_image(const k4a_transformation_context_t *transformation_context,
+                                                     const k4a_transformation_image_descriptor_t *image_descriptor,
+                                                     int bytes_per_pixel)
+{
+    const k4a_transformation_xy_tables_t *xy_tables = &transformation_context->depth_camera_xy_tables;
+    if (image_descriptor->width_pixels != xy_tables->width || image_descriptor->height_pixels != xy_tables->height ||
+        image_descriptor->stride_bytes < xy_tables->width * bytes_per_pixel)
     {
-#ifdef _MSC_VER
+        LOG_ERROR("Expect a %dx%d image with a region of interest, got %dx%d with stride %d.",
+                  xy_tables->width,
+                  xy_tables->height,
+                  image_descriptor->width_pixels,
+                  image_descriptor->height_pixels,
+                  image_descriptor->stride_bytes);
+        return false;
+    }
+    return true;
+}
+
+static void transformation_free_depth_input(k4a_transformation_depth_input_t *input)
+{
+    free(input->roi_images);
+    input->roi_images = NULL;
+}
+
+// Prepares the depth camera input of a CPU transformation, see k4a_transformation_depth_input_t. The custom images
+// are copied to the input as they are when their data is NULL.
+static k4a_result_t
+transformation_init_depth_input(k4a_transformation_context_t *transformation_context,
+                                const uint8_t *depth_image_data,
+                                const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                size_t custom_image_count,
+                                const uint8_t *const *custom_image_data,
+                                const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+                                k4a_transformation_depth_input_t *input)
+{
+    memset(input, 0, sizeof(k4a_transformation_depth_input_t));
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(custom_image_count <= K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    input->depth_image_data = depth_image_data;
+    input->depth_image_descriptor = (k4a_transformation_image_descriptor_t *)depth_image_descriptor;
+    input->custom_image_count = custom_image_count;
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        input->custom_image_data[i] = custom_image_data[i];
+        input->custom_image_descriptors[i] = custom_image_descriptors[i];
+    }
+
+    if (!transformation_roi_enabled(transformation_context))
+    {
+        input->xy_tables = &transformation_context->depth_camera_xy_tables;
+        if (transformation_context->memory_depth_to_color_ray_tables != 0)
+        {
+            input->ray_tables = &transformation_context->depth_to_color_ray_tables;
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    input->xy_tables = &transformation_context->roi_xy_tables;
+    if (transformation_context->memory_roi_ray_tables != 0)
+    {
+        input->ray_tables = &transformation_context->roi_ray_tables;
+    }
+
+    // Null images and descriptors are left to the validation of the transformation itself
+    bool gather_depth = depth_image_data != NULL && depth_image_descriptor != NULL;
+    if (gather_depth && !transformation_validate_roi_source_image(transformation_context, depth_image_descriptor, 2))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    int custom_bytes_per_pixel[K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES] = { 0 };
+    int custom_bytes_per_region_pixel = 0;
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        if (custom_image_data[i] != NULL)
+        {
+            custom_bytes_per_pixel[i] = custom_image_descriptors[i].format == K4A_IMAGE_FORMAT_CUSTOM16 ? 2 : 1;
+            if (!transformation_validate_roi_source_image(
+                    transformation_context, &custom_image_descriptors[i], custom_bytes_per_pixel[i]))
+            {
+                return K4A_RESULT_FAILED;
+            }
+            custom_bytes_per_region_pixel += custom_bytes_per_pixel[i];
+        }
+    }
+
+    int width = transformation_context->roi_xy_tables.width;
+    int height = transformation_context->roi_xy_tables.height;
+    size_t depth_size = gather_depth ? (size_t)(width * height) * sizeof(uint16_t) : 0;
+    size_t custom_size = (size_t)(width * height * custom_bytes_per_region_pixel);
+    if (depth_size + custom_size == 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    input->roi_images = (uint8_t *)malloc(depth_size + custom_size);
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(input->roi_images != NULL)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    if (gather_depth)
+    {
+        transformation_gather_roi_image(
+            transformation_context, depth_image_data, depth_image_descriptor, 2, input->roi_images);
+        input->roi_depth_image_descriptor = *depth_image_descriptor;
+        input->roi_depth_image_descriptor.width_pixels = width;
+        input->roi_depth_image_descriptor.height_pixels = height;
+        input->roi_depth_image_descriptor.stride_bytes = width * (int)sizeof(uint16_t);
+        input->depth_image_data = input->roi_images;
+        input->depth_image_descriptor = &input->roi_depth_image_descriptor;
+    }
+
+    uint8_t *roi_custom_image = input->roi_images + depth_size;
+    for (size_t i = 0; i < custom_image_count; i++)
+    {
+        if (custom_image_data[i] == NULL)
+        {
+            continue;
+        }
+        transformation_gather_roi_image(transformation_context,
+                                        custom_image_data[i],
+                                        &custom_image_descriptors[i],
+                                        custom_bytes_per_pixel[i],
+                                        roi_custom_image);
+        input->custom_image_descriptors[i].width_pixels = width;
+        input->custom_image_descriptors[i].height_pixels = height;
+        input->custom_image_descriptors[i].stride_bytes = width * custom_bytes_per_pixel[i];
+        input->custom_image_data[i] = roi_custom_image;
+        roi_custom_image += (size_t)(width * height * custom_bytes_per_pixel[i]);
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Marks the start of a transformation that reads the tables and the region of interest of the context. Calls from
+// several threads run concurrently, a pending change is completed first.
+static void transformation_begin_call(k4a_transformation_context_t *transformation_context)
+{
+    Lock(transformation_context->config_lock);
+    while (transformation_context->config_update_pending)
+    {
+        (void)Condition_Wait(transformation_context->config_condition, transformation_context->config_lock, 0);
+    }
+    transformation_context->active_call_count++;
+    Unlock(transformation_context->config_lock);
+}
+
+static void transformation_end_call(k4a_transformation_context_t *transformation_context)
+{
+    Lock(transformation_context->config_lock);
+    if (--transformation_context->active_call_count == 0)
+    {
+        Condition_Post(transformation_context->config_condition);
+    }
+    Unlock(transformation_context->config_lock);
+}
+
+// Gives the caller exclusive access to the tables and the region of interest of the context once the running
+// transformations completed.
+static void transformation_begin_update(k4a_transformation_context_t *transformation_context)
+{
+    Lock(transformation_context->config_lock);
+    while (transformation_context->config_update_pending)
+    {
+        (void)Condition_Wait(transformation_context->config_condition, transformation_context->config_lock, 0);
+    }
+    transformation_context->config_update_pending = true;
+    while (transformation_context->active_call_count > 0)
+    {
+        (void)Condition_Wait(transformation_context->config_condition, transformation_context->config_lock, 0);
+    }
+    Unlock(transformation_context->config_lock);
+}
+
+static void transformation_end_update(k4a_transformation_context_t *transformation_context)
+{
+    Lock(transformation_context->config_lock);
+    transformation_context->config_update_pending = false;
+    Condition_Post(transformation_context->config_condition);
+    Unlock(transformation_context->config_lock);
+}
+
+k4a_transformation_t transformation_create(const k4a_calibration_t *calibration, bool gpu_optimization)
+{
+    k4a_transformation_t transformation_handle = NULL;
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_create(&transformation_handle);
+
+    memcpy(&transformation_context->calibration, calibration, sizeof(k4a_calibration_t));
+    transformation_context->thread_count = 1;
+
+    transformation_context->config_lock = Lock_Init();
+    transformation_context->config_condition = Condition_Init();
+    transformation_context->queue_lock = Lock_Init();
+    transformation_context->queue_condition = Condition_Init();
+    transformation_context->idle_condition = Condition_Init();
+    if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->config_lock != NULL &&
+                                        transformation_context->config_condition != NULL &&
+                                        transformation_context->queue_lock != NULL &&
+                                        transformation_context->queue_condition != NULL &&
+                                        transformation_context->idle_condition != NULL)))
+    {
+        transformation_destroy(transformation_handle);
+        return 0;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
+                                                                K4A_CALIBRATION_TYPE_DEPTH,
+                                                                &transformation_context->memory_depth_camera_xy_tables,
+                                                                &transformation_context->depth_camera_xy_tables))))
+    {
+        transformation_destroy(transformation_handle);
+        return 0;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(transformation_allocate_xy_tables(&transformation_context->calibration,
+                                                                K4A_CALIBRATION_TYPE_COLOR,
+                                                                &transformation_context->memory_color_camera_xy_tables,
+                                                                &transformation_context->color_camera_xy_tables))))
+    {
+        transformation_destroy(transformation_handle);
+        return 0;
+    }
+
+    transformation_context->enable_gpu_optimization = gpu_optimization;
+    transformation_context->enable_depth_color_transform = transformation_context->calibration.color_resolution !=
+                                                               K4A_COLOR_RESOLUTION_OFF &&
+                                                           transformation_context->calibration.depth_mode !=
+                                                               K4A_DEPTH_MODE_OFF;
+    if (transformation_context->enable_gpu_optimization && transformation_context->enable_depth_color_transform)
+    {
+        // Set up transform engine expected calibration struct
+        k4a_transform_engine_calibration_t transform_engine_calibration;
+        memcpy(&transform_engine_calibration.depth_camera_calibration,
+               &transformation_context->calibration.depth_camera_calibration,
+               sizeof(k4a_calibration_camera_t));
+        memcpy(&transform_engine_calibration.color_camera_calibration,
+               &transformation_context->calibration.color_camera_calibration,
+               sizeof(k4a_calibration_camera_t));
+        memcpy(&transform_engine_calibration.depth_camera_to_color_camera_extrinsics,
+               &transformation_context->calibration.extrinsics[K4A_CALIBRATION_TYPE_DEPTH][K4A_CALIBRATION_TYPE_COLOR],
+               sizeof(k4a_calibration_extrinsics_t));
+        memcpy(&transform_engine_calibration.color_camera_to_depth_camera_extrinsics,
+               &transformation_context->calibration.extrinsics[K4A_CALIBRATION_TYPE_COLOR][K4A_CALIBRATION_TYPE_DEPTH],
+               sizeof(k4a_calibration_extrinsics_t));
+        memcpy(&transform_engine_calibration.depth_camera_xy_tables,
+               &transformation_context->depth_camera_xy_tables,
+               sizeof(k4a_transformation_xy_tables_t));
+
+        transformation_context->tewrapper = tewrapper_create(&transform_engine_calibration);
+        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(transformation_context->tewrapper != NULL)))
+        {
+            transformation_destroy(transformation_handle);
+            return 0;
+        }
+    }
+
+    return transformation_handle;
+}
+
+void transformation_destroy(k4a_transformation_t transformation_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (transformation_context->queue_thread)
+    {
+        // Complete the submitted jobs before stopping the worker thread
+        (void)transformation_wait_idle(transformation_handle, K4A_WAIT_INFINITE);
+
+        Lock(transformation_context->queue_lock);
+        transformation_context->queue_thread_stop = true;
+        Condition_Post(transformation_context->queue_condition);
+        Unlock(transformation_context->queue_lock);
+
+        int thread_result;
+        THREADAPI_RESULT tresult = ThreadAPI_Join(transformation_context->queue_thread, &thread_result);
+        (void)K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK); // Trace the issue, but we don't return a failure
+    }
+    if (transformation_context->queue_condition)
+    {
+        Condition_Deinit(transformation_context->queue_condition);
+    }
+    if (transformation_context->idle_condition)
+    {
+        Condition_Deinit(transformation_context->idle_condition);
+    }
+    if (transformation_context->queue_lock)
+    {
+        Lock_Deinit(transformation_context->queue_lock);
+    }
+    if (transformation_context->config_condition)
+    {
+        Condition_Deinit(transformation_context->config_condition);
+    }
+    if (transformation_context->config_lock)
+    {
+        Lock_Deinit(transformation_context->config_lock);
+    }
+
+    if (transformation_context->memory_depth_camera_xy_tables != 0)
+    {
+#ifdef _MSC_VER
+        _aligned_free(transformation_context->memory_depth_camera_xy_tables);
+#else
+        free(transformation_context->memory_depth_camera_xy_tables);
+#endif
+    }
+    if (transformation_context->memory_color_camera_xy_tables != 0)
+    {
+#ifdef _MSC_VER
         _aligned_free(transformation_context->memory_color_camera_xy_tables);
 #else
         free(transformation_context->memory_color_camera_xy_tables);
 #endif
     }
-    if (transformation_context->tewrapper)
+    if (transformation_context->memory_depth_to_color_ray_tables != 0)
+    {
+        transformation_free_tables(transformation_context->memory_depth_to_color_ray_tables);
+    }
+    transformation_free_roi_tables(transformation_context);
+    if (transformation_context->tewrapper)
+    {
+        tewrapper_destroy(transformation_context->tewrapper);
+    }
+    if (transformation_context->threadpool_acquired)
+    {
+        threadpool_release();
+    }
+    k4a_transformation_t_destroy(transformation_handle);
+}
+
+static k4a_result_t transformation_set_thread_count_locked(k4a_transformation_context_t *transformation_context,
+                                                           uint32_t thread_count)
+{
+    // Only the CPU implementation of the depth to color transformation is split across threads, which run on the
+    // worker threads shared by every transformation in the process
+    if (thread_count > 1 && !transformation_context->threadpool_acquired)
+    {
+        if (K4A_FAILED(TRACE_CALL(threadpool_acquire())))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        transformation_context->threadpool_acquired = true;
+    }
+    else if (thread_count == 1 && transformation_context->threadpool_acquired)
+    {
+        threadpool_release();
+        transformation_context->threadpool_acquired = false;
+    }
+
+    transformation_context->thread_count = thread_count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_set_thread_count(k4a_transformation_t transformation_handle, uint32_t thread_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count == 0 || thread_count > TRANSFORMATION_MAX_THREAD_COUNT);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_update(transformation_context);
+    k4a_result_t result = transformation_set_thread_count_locked(transformation_context, thread_count);
+    transformation_end_update(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_enable_depth_to_color_ray_tables_locked(
+    k4a_transformation_context_t *transformation_context,
+    bool enable)
+{
+    if (!enable)
+    {
+        if (transformation_context->memory_depth_to_color_ray_tables != 0)
+        {
+            transformation_free_tables(transformation_context->memory_depth_to_color_ray_tables);
+            transformation_context->memory_depth_to_color_ray_tables = 0;
+        }
+        return TRACE_CALL(transformation_update_roi_tables(transformation_context));
+    }
+
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to precompute depth to color ray tables.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (transformation_context->memory_depth_to_color_ray_tables != 0)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    // Only the CPU implementation of the depth to color transformation uses the ray tables
+    float *buffer = 0;
+    if (K4A_FAILED(TRACE_CALL(transformation_allocate_ray_tables(&transformation_context->calibration,
+                                                                 &transformation_context->depth_camera_xy_tables,
+                                                                 &buffer,
+                                                                 &transformation_context->depth_to_color_ray_tables))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+    transformation_context->memory_depth_to_color_ray_tables = buffer;
+    return TRACE_CALL(transformation_update_roi_tables(transformation_context));
+}
+
+k4a_result_t transformation_enable_depth_to_color_ray_tables(k4a_transformation_t transformation_handle, bool enable)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_update(transformation_context);
+    k4a_result_t result = transformation_enable_depth_to_color_ray_tables_locked(transformation_context, enable);
+    transformation_end_update(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_set_region_of_interest_locked(k4a_transformation_context_t *transformation_context,
+                                                                 const k4a_transformation_roi_t *roi)
+{
+    if (roi == NULL)
+    {
+        memset(&transformation_context->roi, 0, sizeof(k4a_transformation_roi_t));
+        return TRACE_CALL(transformation_update_roi_tables(transformation_context));
+    }
+
+    const k4a_transformation_xy_tables_t *xy_tables = &transformation_context->depth_camera_xy_tables;
+    if (roi->x < 0 || roi->y < 0 || roi->width <= 0 || roi->height <= 0 || roi->decimation <= 0 ||
+        roi->width > xy_tables->width - roi->x || roi->height > xy_tables->height - roi->y)
+    {
+        LOG_ERROR("Unexpected region of interest (%d, %d) %dx%d with decimation %d for a %dx%d depth image.",
+                  roi->x,
+                  roi->y,
+                  roi->width,
+                  roi->height,
+                  roi->decimation,
+                  xy_tables->width,
+                  xy_tables->height);
+        return K4A_RESULT_FAILED;
+    }
+
+    transformation_context->roi = *roi;
+    if (K4A_FAILED(TRACE_CALL(transformation_update_roi_tables(transformation_context))))
+    {
+        memset(&transformation_context->roi, 0, sizeof(k4a_transformation_roi_t));
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_set_region_of_interest(k4a_transformation_t transformation_handle,
+                                                   const k4a_transformation_roi_t *roi)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_update(transformation_context);
+    k4a_result_t result = transformation_set_region_of_interest_locked(transformation_context, roi);
+    transformation_end_update(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_get_xy_table(k4a_transformation_t transformation_handle,
+                                         const k4a_calibration_type_t camera,
+                                         uint8_t *xy_table_data,
+                                         const k4a_transformation_image_descriptor_t *xy_table_descriptor)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, xy_table_data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, xy_table_descriptor == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    const k4a_transformation_xy_tables_t *xy_tables = NULL;
+    switch (camera)
+    {
+    case K4A_CALIBRATION_TYPE_DEPTH:
+        xy_tables = &transformation_context->depth_camera_xy_tables;
+        break;
+    case K4A_CALIBRATION_TYPE_COLOR:
+        xy_tables = &transformation_context->color_camera_xy_tables;
+        break;
+    default:
+        LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
+                  camera,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_CALIBRATION_TYPE_COLOR);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (xy_tables->width <= 0 || xy_tables->height <= 0)
+    {
+        LOG_ERROR("The calibration of camera %d has no resolution, the camera is not in use.", camera);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (xy_table_descriptor->format != K4A_IMAGE_FORMAT_CUSTOM ||
+        xy_table_descriptor->width_pixels != xy_tables->width ||
+        xy_table_descriptor->height_pixels != xy_tables->height ||
+        xy_table_descriptor->stride_bytes < xy_tables->width * (int)sizeof(k4a_float2_t))
+    {
+        LOG_ERROR("Unexpected xy table image format %d, width %d, height %d, stride %d. Expected format %d, width %d, "
+                  "height %d and a stride of at least %d.",
+                  xy_table_descriptor->format,
+                  xy_table_descriptor->width_pixels,
+                  xy_table_descriptor->height_pixels,
+                  xy_table_descriptor->stride_bytes,
+                  K4A_IMAGE_FORMAT_CUSTOM,
+                  xy_tables->width,
+                  xy_tables->height,
+                  xy_tables->width * (int)sizeof(k4a_float2_t));
+        return K4A_RESULT_FAILED;
+    }
+
+    // The tables are stored as separate X and Y planes with NAN in the X table for invalid pixels; callers get
+    // interleaved pairs that can be uploaded as a two channel texture, with both values NAN for invalid pixels.
+    for (int y = 0, idx = 0; y < xy_tables->height; y++)
+    {
+        uint8_t *row_data = xy_table_data + (size_t)y * (size_t)xy_table_descriptor->stride_bytes;
+        k4a_float2_t *row = (k4a_float2_t *)(void *)row_data;
+        for (int x = 0; x < xy_tables->width; x++, idx++)
+        {
+            float x_value = xy_tables->x_table[idx];
+            row[x].xy.x = x_value;
+            row[x].xy.y = isnan(x_value) ? x_value : xy_tables->y_table[idx];
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t
+transformation_color_2d_to_depth_2d_batch(k4a_transformation_t transformation_handle,
+                                          const uint8_t *depth_image_data,
+                                          const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                          const float *source_points2d,
+                                          size_t point_count,
+                                          float *target_points2d,
+                                          int *valid)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to transform color pixels to depth camera.",
+                  0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The full depth image is always used, a region of interest only applies to image transformations
+    transformation_begin_call(transformation_context);
+    const k4a_transformation_ray_tables_t *ray_tables = NULL;
+    if (transformation_context->memory_depth_to_color_ray_tables != 0)
+    {
+        ray_tables = &transformation_context->depth_to_color_ray_tables;
+    }
+    k4a_result_t result = TRACE_CALL(
+        transformation_color_2d_to_depth_2d_batch_internal(&transformation_context->calibration,
+                                                           &transformation_context->depth_camera_xy_tables,
+                                                           depth_image_data,
+                                                           depth_image_descriptor,
+                                                           source_points2d,
+                                                           point_count,
+                                                           target_points2d,
+                                                           valid,
+                                                           transformation_context->thread_count,
+                                                           ray_tables));
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_depth_image_to_color_camera_custom_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptor,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    uint32_t invalid_custom_value)
+{
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to transform depth image to color camera.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The transform engine only processes full images at the color camera resolution, a region of interest or a
+    // downscaled output always runs on the CPU
+    if (transformation_context->enable_gpu_optimization && !transformation_roi_enabled(transformation_context) &&
+        transformation_get_depth_to_color_scale(&transformation_context->calibration.color_camera_calibration,
+                                                transformed_depth_image_descriptor) == 1)
+    {
+        if (K4A_BUFFER_RESULT_SUCCEEDED !=
+            TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_validate_parameters(
+                &transformation_context->calibration,
+                &transformation_context->depth_camera_xy_tables,
+                depth_image_data,
+                depth_image_descriptor,
+                custom_image_data,
+                custom_image_descriptor,
+                transformed_depth_image_data,
+                transformed_depth_image_descriptor,
+                transformed_custom_image_data,
+                transformed_custom_image_descriptor)))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        size_t depth_image_size = (size_t)(depth_image_descriptor->stride_bytes *
+                                           depth_image_descriptor->height_pixels);
+        size_t custom_image_size = (size_t)(custom_image_descriptor->stride_bytes *
+                                            custom_image_descriptor->height_pixels);
+        size_t transformed_depth_image_size = (size_t)(transformed_depth_image_descriptor->stride_bytes *
+                                                       transformed_depth_image_descriptor->height_pixels);
+        size_t transformed_custom_image_size = (size_t)(transformed_custom_image_descriptor->stride_bytes *
+                                                        transformed_custom_image_descriptor->height_pixels);
+
+        k4a_transform_engine_type_t transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR;
+        if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM8)
+        {
+            transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM8_TO_COLOR;
+        }
+        else if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM16)
+        {
+            transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM16_TO_COLOR;
+        }
+
+        k4a_transform_engine_interpolation_t interpolation;
+        switch (interpolation_type)
+        {
+        case K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST:
+            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_NEAREST;
+            break;
+
+        case K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR:
+            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
+            break;
+
+        default:
+            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
+            break;
+        }
+
+        if (K4A_FAILED(TRACE_CALL(tewrapper_process_frame(transformation_context->tewrapper,
+                                                          transform_type,
+                                                          depth_image_data,
+                                                          depth_image_size,
+                                                          custom_image_data,
+                                                          custom_image_size,
+                                                          transformed_depth_image_data,
+                                                          transformed_depth_image_size,
+                                                          transformed_custom_image_data,
+                                                          transformed_custom_image_size,
+                                                          interpolation,
+                                                          invalid_custom_value))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+    else
+    {
+        // A null custom image descriptor is left to the validation of the transformation
+        size_t custom_image_count = custom_image_descriptor != NULL ? 1 : 0;
+        k4a_transformation_depth_input_t input;
+        if (K4A_FAILED(TRACE_CALL(transformation_init_depth_input(transformation_context,
+                                                                  depth_image_data,
+                                                                  depth_image_descriptor,
+                                                                  custom_image_count,
+                                                                  &custom_image_data,
+                                                                  custom_image_descriptor,
+                                                                  &input))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        k4a_buffer_result_t result = TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_internal(
+            &transformation_context->calibration,
+            input.xy_tables,
+            input.depth_image_data,
+            input.depth_image_descriptor,
+            input.custom_image_data[0],
+            custom_image_count > 0 ? &input.custom_image_descriptors[0] : NULL,
+            transformed_depth_image_data,
+            transformed_depth_image_descriptor,
+            transformed_custom_image_data,
+            transformed_custom_image_descriptor,
+            interpolation_type,
+            invalid_custom_value,
+            transformation_context->thread_count,
+            input.ray_tables));
+        transformation_free_depth_input(&input);
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_depth_image_to_color_camera_custom(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptor,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    uint32_t invalid_custom_value)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_color_camera_custom_locked(transformation_context,
+                                                                                   depth_image_data,
+                                                                                   depth_image_descriptor,
+                                                                                   custom_image_data,
+                                                                                   custom_image_descriptor,
+                                                                                   transformed_depth_image_data,
+                                                                                   transformed_depth_image_descriptor,
+                                                                                   transformed_custom_image_data,
+                                                                                   transformed_custom_image_descriptor,
+                                                                                   interpolation_type,
+                                                                                   invalid_custom_value);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_depth_image_to_color_camera_custom_images_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    const uint32_t *invalid_custom_values)
+{
+    // The transform engine maps at most one custom image per pass, a single custom image takes its path
+    if (transformation_context->enable_gpu_optimization && !transformation_roi_enabled(transformation_context) &&
+        custom_image_count <= 1)
+    {
+        k4a_transformation_image_descriptor_t dummy_descriptor = { 0 };
+        bool has_custom_image = custom_image_count == 1 && custom_image_data != NULL &&
+                                custom_image_descriptors != NULL && transformed_custom_image_data != NULL &&
+                                transformed_custom_image_descriptors != NULL && invalid_custom_values != NULL;
+        if (K4A_FAILED(K4A_RESULT_FROM_BOOL(custom_image_count == 0 || has_custom_image)))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        return TRACE_CALL(transformation_depth_image_to_color_camera_custom_locked(
+            transformation_context,
+            depth_image_data,
+            depth_image_descriptor,
+            has_custom_image ? custom_image_data[0] : NULL,
+            has_custom_image ? custom_image_descriptors : &dummy_descriptor,
+            transformed_depth_image_data,
+            transformed_depth_image_descriptor,
+            has_custom_image ? transformed_custom_image_data[0] : NULL,
+            has_custom_image ? transformed_custom_image_descriptors : &dummy_descriptor,
+            interpolation_type,
+            has_custom_image ? invalid_custom_values[0] : 0));
+    }
+
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to transform depth image to color camera.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (K4A_BUFFER_RESULT_SUCCEEDED !=
+        TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_custom_images_validate_parameters(
+            &transformation_context->calibration,
+            &transformation_context->depth_camera_xy_tables,
+            depth_image_data,
+            depth_image_descriptor,
+            custom_image_count,
+            custom_image_data,
+            custom_image_descriptors,
+            transformed_depth_image_data,
+            transformed_depth_image_descriptor,
+            transformed_custom_image_data,
+            transformed_custom_image_descriptors,
+            invalid_custom_values)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_depth_input(transformation_context,
+                                                              depth_image_data,
+                                                              depth_image_descriptor,
+                                                              custom_image_count,
+                                                              custom_image_data,
+                                                              custom_image_descriptors,
+                                                              &input))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // All custom images are interpolated in the same rasterization pass over the depth mesh
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_custom_images_internal(
+        &transformation_context->calibration,
+        input.xy_tables,
+        input.depth_image_data,
+        input.depth_image_descriptor,
+        input.custom_image_count,
+        input.custom_image_data,
+        input.custom_image_descriptors,
+        transformed_depth_image_data,
+        transformed_depth_image_descriptor,
+        transformed_custom_image_data,
+        transformed_custom_image_descriptors,
+        interpolation_type,
+        invalid_custom_values,
+        transformation_context->thread_count,
+        input.ray_tables));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+k4a_result_t transformation_depth_image_to_color_camera_custom_images(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    size_t custom_image_count,
+    const uint8_t *const *custom_image_data,
+    const k4a_transformation_image_descriptor_t *custom_image_descriptors,
+    uint8_t *transformed_depth_image_data,
+    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
+    uint8_t *const *transformed_custom_image_data,
+    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptors,
+    k4a_transformation_interpolation_type_t interpolation_type,
+    const uint32_t *invalid_custom_values)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_color_camera_custom_images_locked(
+        transformation_context,
+        depth_image_data,
+        depth_image_descriptor,
+        custom_image_count,
+        custom_image_data,
+        custom_image_descriptors,
+        transformed_depth_image_data,
+        transformed_depth_image_descriptor,
+        transformed_custom_image_data,
+        transformed_custom_image_descriptors,
+        interpolation_type,
+        invalid_custom_values);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t
+transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
+                                           const uint8_t *depth_image_data,
+                                           const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                           const uint8_t *color_image_data,
+                                           const k4a_transformation_image_descriptor_t *color_image_descriptor,
+                                           uint8_t *transformed_color_image_data,
+                                           k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+{
+    return TRACE_CALL(
+        transformation_color_image_to_depth_camera_with_interpolation(transformation_handle,
+                                                                      depth_image_data,
+                                                                      depth_image_descriptor,
+                                                                      color_image_data,
+                                                                      color_image_descriptor,
+                                                                      transformed_color_image_data,
+                                                                      transformed_color_image_descriptor,
+                                                                      K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR));
+}
+
+static k4a_result_t transformation_color_image_to_depth_camera_with_interpolation_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *transformed_color_image_data,
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type)
+{
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to transform color image to depth camera.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (interpolation_type != K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST &&
+        interpolation_type != K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR)
+    {
+        LOG_ERROR("Unexpected interpolation type %d.", interpolation_type);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The transform engine only processes full images, always samples color bilinearly and reads full resolution
+    // BGRA only. A region of interest, nearest neighbor sampling or other color images run on the CPU.
+    if (transformation_context->enable_gpu_optimization && !transformation_roi_enabled(transformation_context) &&
+        interpolation_type == K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR && color_image_descriptor != NULL &&
+        color_image_descriptor->format == K4A_IMAGE_FORMAT_COLOR_BGRA32 &&
+        transformation_get_color_image_scale(&transformation_context->calibration.color_camera_calibration,
+                                             color_image_descriptor) == 1)
+    {
+        if (K4A_BUFFER_RESULT_SUCCEEDED !=
+            TRACE_BUFFER_CALL(transformation_color_image_to_depth_camera_validate_parameters(
+                &transformation_context->calibration,
+                &transformation_context->depth_camera_xy_tables,
+                depth_image_data,
+                depth_image_descriptor,
+                color_image_data,
+                color_image_descriptor,
+                transformed_color_image_data,
+                transformed_color_image_descriptor)))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        size_t depth_image_size = (size_t)(depth_image_descriptor->stride_bytes *
+                                           depth_image_descriptor->height_pixels);
+        size_t color_image_size = (size_t)(color_image_descriptor->stride_bytes *
+                                           color_image_descriptor->height_pixels);
+        size_t transformed_color_image_size = (size_t)(transformed_color_image_descriptor->stride_bytes *
+                                                       transformed_color_image_descriptor->height_pixels);
+
+        if (K4A_FAILED(TRACE_CALL(tewrapper_process_frame(transformation_context->tewrapper,
+                                                          K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH,
+                                                          depth_image_data,
+                                                          depth_image_size,
+                                                          color_image_data,
+                                                          color_image_size,
+                                                          transformed_color_image_data,
+                                                          transformed_color_image_size,
+                                                          NULL,
+                                                          (size_t)0,
+                                                          K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR,
+                                                          (uint16_t)0))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+    else
+    {
+        k4a_transformation_depth_input_t input;
+        if (K4A_FAILED(TRACE_CALL(transformation_init_depth_input(
+                transformation_context, depth_image_data, depth_image_descriptor, 0, NULL, NULL, &input))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+            transformation_color_image_to_depth_camera_internal(&transformation_context->calibration,
+                                                                input.xy_tables,
+                                                                input.depth_image_data,
+                                                                input.depth_image_descriptor,
+                                                                color_image_data,
+                                                                color_image_descriptor,
+                                                                transformed_color_image_data,
+                                                                transformed_color_image_descriptor,
+                                                                interpolation_type));
+        transformation_free_depth_input(&input);
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            return K4A_RESULT_FAILED;
+        }
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_color_image_to_depth_camera_with_interpolation(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *transformed_color_image_data,
+    k4a_transformation_image_descriptor_t *transformed_color_image_descriptor,
+    k4a_transformation_interpolation_type_t interpolation_type)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_color_image_to_depth_camera_with_interpolation_locked(
+        transformation_context,
+        depth_image_data,
+        depth_image_descriptor,
+        color_image_data,
+        color_image_descriptor,
+        transformed_color_image_data,
+        transformed_color_image_descriptor,
+        interpolation_type);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_decode_color_image(k4a_transformation_t transformation_handle,
+                                               const uint8_t *jpeg_data,
+                                               size_t jpeg_size,
+                                               uint8_t **bgra_image_data,
+                                               k4a_transformation_image_descriptor_t *bgra_image_descriptor)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, jpeg_data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, jpeg_size == 0 || jpeg_size > ULONG_MAX);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, bgra_image_data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, bgra_image_descriptor == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to transform color image to depth camera.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_t *calibration = &transformation_context->calibration;
+    int color_width = calibration->color_camera_calibration.resolution_width;
+    int color_height = calibration->color_camera_calibration.resolution_height;
+    int depth_width = calibration->depth_camera_calibration.resolution_width;
+    int depth_height = calibration->depth_camera_calibration.resolution_height;
+
+    // Only one color sample is taken per depth pixel, so the image is decoded at the smallest scale that still has
+    // at least the resolution of the depth camera. Sizes are rounded up like turbojpeg does.
+    int scale = 1;
+    while (scale < TRANSFORMATION_MAX_COLOR_SCALE && (color_width + 2 * scale - 1) / (2 * scale) >= depth_width &&
+           (color_height + 2 * scale - 1) / (2 * scale) >= depth_height)
+    {
+        scale *= 2;
+    }
+    int width = (color_width + scale - 1) / scale;
+    int height = (color_height + scale - 1) / scale;
+
+    tjhandle decoder = tjInitDecompress();
+    if (decoder == NULL)
+    {
+        LOG_ERROR("Failed to initialize the jpeg decompressor.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    int jpeg_width = 0;
+    int jpeg_height = 0;
+    int jpeg_subsampling = 0;
+    int jpeg_colorspace = 0;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(tjDecompressHeader3(decoder,
+                                                                   jpeg_data,
+                                                                   (unsigned long)jpeg_size,
+                                                                   &jpeg_width,
+                                                                   &jpeg_height,
+                                                                   &jpeg_subsampling,
+                                                                   &jpeg_colorspace) == 0);
+    if (K4A_SUCCEEDED(result) && (jpeg_width != color_width || jpeg_height != color_height))
+    {
+        LOG_ERROR("Color image of %dx%d does not match the color camera resolution of %dx%d.",
+                  jpeg_width,
+                  jpeg_height,
+                  color_width,
+                  color_height);
+        result = K4A_RESULT_FAILED;
+    }
+
+    uint8_t *data = NULL;
+    if (K4A_SUCCEEDED(result))
+    {
+        data = (uint8_t *)malloc((size_t)width * 4 * (size_t)height);
+        result = K4A_RESULT_FROM_BOOL(data != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result) && tjDecompress2(decoder,
+                                               jpeg_data,
+                                               (unsigned long)jpeg_size,
+                                               data,
+                                               width,
+                                               width * 4,
+                                               height,
+                                               TJPF_BGRA,
+                                               TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+    {
+        LOG_ERROR("Failed to decompress jpeg image to BGRA format.", 0);
+        result = K4A_RESULT_FAILED;
+    }
+    (void)tjDestroy(decoder);
+
+    if (K4A_FAILED(result))
+    {
+        free(data);
+        return K4A_RESULT_FAILED;
+    }
+
+    *bgra_image_data = data;
+    bgra_image_descriptor->width_pixels = width;
+    bgra_image_descriptor->height_pixels = height;
+    bgra_image_descriptor->stride_bytes = width * 4;
+    bgra_image_descriptor->format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t transformation_depth_image_to_colored_point_cloud_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *colored_xyz_image_data,
+    k4a_transformation_image_descriptor_t *colored_xyz_image_descriptor)
+{
+    if (!transformation_context->enable_depth_color_transform)
+    {
+        LOG_ERROR("Expect both depth camera and color camera are running to compute a colored point cloud.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_depth_input(
+            transformation_context, depth_image_data, depth_image_descriptor, 0, NULL, NULL, &input))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // The transform engine has no fused mode, so this always runs on the CPU
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+        transformation_depth_image_to_colored_point_cloud_internal(&transformation_context->calibration,
+                                                                   input.xy_tables,
+                                                                   input.depth_image_data,
+                                                                   input.depth_image_descriptor,
+                                                                   color_image_data,
+                                                                   color_image_descriptor,
+                                                                   colored_xyz_image_data,
+                                                                   colored_xyz_image_descriptor));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+static bool transformation_validate_gpu_input_image(const k4a_transformation_image_descriptor_t *descriptor,
+                                                    const k4a_calibration_camera_t *camera_calibration,
+                                                    k4a_image_format_t format,
+                                                    int bytes_per_pixel)
+{
+    // The transform engine reads the rows packed, as the host memory path passes them
+    if (descriptor == NULL || descriptor->format != format ||
+        descriptor->width_pixels != camera_calibration->resolution_width ||
+        descriptor->height_pixels != camera_calibration->resolution_height ||
+        descriptor->stride_bytes != descriptor->width_pixels * bytes_per_pixel)
+    {
+        LOG_ERROR("Expect a packed %dx%d image of format %d for the GPU transformation.",
+                  camera_calibration->resolution_width,
+                  camera_calibration->resolution_height,
+                  format);
+        return false;
+    }
+    return true;
+}
+
+static k4a_result_t transformation_get_gpu_export_type(k4a_gpu_interop_type_t type,
+                                                       k4a_transform_engine_gpu_export_t *export_type)
+{
+    if (!deloader_get_gpu_export_type(type, export_type))
+    {
+        LOG_ERROR("Unexpected GPU interop type %d.", type);
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t
+transformation_export_gpu_locked(k4a_transformation_context_t *transformation_context,
+                                 k4a_transform_engine_type_t transform_type,
+                                 const uint8_t *depth_image_data,
+                                 const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                 const k4a_gpu_resource_t *depth_resource,
+                                 const uint8_t *color_image_data,
+                                 const k4a_transformation_image_descriptor_t *color_image_descriptor,
+                                 k4a_gpu_interop_type_t type,
+                                 k4a_gpu_resource_t *resource)
+{
+    if (!transformation_context->enable_depth_color_transform || transformation_context->tewrapper == NULL)
+    {
+        LOG_ERROR("Expect a transformation created with GPU optimization for both depth camera and color camera to "
+                  "export GPU resources.",
+                  0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (transformation_roi_enabled(transformation_context))
+    {
+        LOG_ERROR("The transform engine only processes full images, clear the region of interest to export GPU "
+                  "resources.",
+                  0);
+        return K4A_RESULT_FAILED;
+    }
+
+    const k4a_calibration_t *calibration = &transformation_context->calibration;
+    k4a_transform_engine_gpu_export_t depth_export_type = K4A_TRANSFORM_ENGINE_GPU_EXPORT_OPENGL_TEXTURE;
+    k4a_transform_engine_gpu_output_t depth_input = { 0 };
+    if (depth_resource != NULL)
+    {
+        // A depth engine resource holds the IR image after the depth image, the transform engine reads the first
+        k4a_transformation_image_descriptor_t depth_resource_descriptor = { depth_resource->width_pixels,
+                                                                            depth_resource->height_pixels,
+                                                                            depth_resource->stride_bytes,
+                                                                            depth_resource->format };
+        if (!transformation_validate_gpu_input_image(&depth_resource_descriptor,
+                                                     &calibration->depth_camera_calibration,
+                                                     K4A_IMAGE_FORMAT_DEPTH16,
+                                                     (int)sizeof(uint16_t)) ||
+            K4A_FAILED(TRACE_CALL(transformation_get_gpu_export_type(depth_resource->type, &depth_export_type))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        depth_input.handle = depth_resource->handle;
+        depth_input.size = depth_resource->size;
+        depth_input.fence = depth_resource->fence;
+    }
+    else if (depth_image_data == NULL ||
+             !transformation_validate_gpu_input_image(depth_image_descriptor,
+                                                      &calibration->depth_camera_calibration,
+                                                      K4A_IMAGE_FORMAT_DEPTH16,
+                                                      (int)sizeof(uint16_t)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    size_t color_image_size = 0;
+    k4a_image_format_t format = K4A_IMAGE_FORMAT_DEPTH16;
+    const k4a_calibration_camera_t *output_camera = &calibration->color_camera_calibration;
+    int output_bytes_per_pixel = (int)sizeof(uint16_t);
+    if (transform_type == K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH)
+    {
+        if (color_image_data == NULL ||
+            !transformation_validate_gpu_input_image(color_image_descriptor,
+                                                     &calibration->color_camera_calibration,
+                                                     K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                                     4 * (int)sizeof(uint8_t)))
+        {
+            return K4A_RESULT_FAILED;
+        }
+        color_image_size = (size_t)(color_image_descriptor->stride_bytes * color_image_descriptor->height_pixels);
+        format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+        output_camera = &calibration->depth_camera_calibration;
+        output_bytes_per_pixel = 4 * (int)sizeof(uint8_t);
+    }
+
+    k4a_transform_engine_gpu_export_t export_type;
+    if (K4A_FAILED(TRACE_CALL(transformation_get_gpu_export_type(type, &export_type))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transform_engine_gpu_output_t output = { 0 };
+    k4a_result_t result;
+    if (depth_resource != NULL)
+    {
+        result = TRACE_CALL(tewrapper_process_frame_gpu_input(transformation_context->tewrapper,
+                                                              transform_type,
+                                                              depth_export_type,
+                                                              &depth_input,
+                                                              color_image_data,
+                                                              color_image_size,
+                                                              export_type,
+                                                              &output));
+    }
+    else
+    {
+        size_t depth_image_size = (size_t)(depth_image_descriptor->stride_bytes *
+                                           depth_image_descriptor->height_pixels);
+        result = TRACE_CALL(tewrapper_process_frame_gpu(transformation_context->tewrapper,
+                                                        transform_type,
+                                                        depth_image_data,
+                                                        depth_image_size,
+                                                        color_image_data,
+                                                        color_image_size,
+                                                        export_type,
+                                                        &output));
+    }
+    if (K4A_FAILED(result))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    resource->type = type;
+    resource->format = format;
+    resource->width_pixels = output_camera->resolution_width;
+    resource->height_pixels = output_camera->resolution_height;
+    resource->stride_bytes = output_camera->resolution_width * output_bytes_per_pixel;
+    resource->size = output.size;
+    resource->handle = output.handle;
+    resource->fence = output.fence;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t transformation_depth_image_to_color_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_depth_resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, transformed_depth_resource == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_export_gpu_locked(transformation_context,
+                                                           K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR,
+                                                           depth_image_data,
+                                                           depth_image_descriptor,
+                                                           NULL,
+                                                           NULL,
+                                                           NULL,
+                                                           type,
+                                                           transformed_depth_resource);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_color_image_to_depth_camera_gpu(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    k4a_gpu_interop_type_t type,
+    k4a_gpu_resource_t *transformed_color_resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, transformed_color_resource == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_export_gpu_locked(transformation_context,
+                                                           K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH,
+                                                           depth_image_data,
+                                                           depth_image_descriptor,
+                                                           NULL,
+                                                           color_image_data,
+                                                           color_image_descriptor,
+                                                           type,
+                                                           transformed_color_resource);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_depth_resource_to_color_camera_gpu(k4a_transformation_t transformation_handle,
+                                                              const k4a_gpu_resource_t *depth_resource,
+                                                              k4a_gpu_interop_type_t type,
+                                                              k4a_gpu_resource_t *transformed_depth_resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, depth_resource == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, transformed_depth_resource == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_export_gpu_locked(transformation_context,
+                                                           K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR,
+                                                           NULL,
+                                                           NULL,
+                                                           depth_resource,
+                                                           NULL,
+                                                           NULL,
+                                                           type,
+                                                           transformed_depth_resource);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_release_gpu_resource(k4a_transformation_t transformation_handle,
+                                                 const k4a_gpu_resource_t *resource)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, resource == NULL);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, transformation_context->tewrapper == NULL);
+
+    k4a_transform_engine_gpu_export_t export_type;
+    if (K4A_FAILED(TRACE_CALL(transformation_get_gpu_export_type(resource->type, &export_type))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_transform_engine_gpu_output_t output = { 0 };
+    output.handle = resource->handle;
+    output.size = resource->size;
+    output.fence = resource->fence;
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = TRACE_CALL(
+        tewrapper_release_gpu_output(transformation_context->tewrapper, export_type, &output));
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+k4a_result_t transformation_depth_image_to_colored_point_cloud(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const uint8_t *color_image_data,
+    const k4a_transformation_image_descriptor_t *color_image_descriptor,
+    uint8_t *colored_xyz_image_data,
+    k4a_transformation_image_descriptor_t *colored_xyz_image_descriptor)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_colored_point_cloud_locked(transformation_context,
+                                                                                   depth_image_data,
+                                                                                   depth_image_descriptor,
+                                                                                   color_image_data,
+                                                                                   color_image_descriptor,
+                                                                                   colored_xyz_image_data,
+                                                                                   colored_xyz_image_descriptor);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+// Prepares the input of a point cloud transformation. Only depth images in the depth camera geometry are limited to
+// the region of interest.
+static k4a_result_t
+transformation_init_point_cloud_input(k4a_transformation_context_t *transformation_context,
+                                      const k4a_calibration_type_t camera,
+                                      const uint8_t *depth_image_data,
+                                      const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                      k4a_transformation_depth_input_t *input)
+{
+    if (camera == K4A_CALIBRATION_TYPE_DEPTH)
+    {
+        return TRACE_CALL(transformation_init_depth_input(
+            transformation_context, depth_image_data, depth_image_descriptor, 0, NULL, NULL, input));
+    }
+    else if (camera == K4A_CALIBRATION_TYPE_COLOR)
+    {
+        memset(input, 0, sizeof(k4a_transformation_depth_input_t));
+        input->xy_tables = &transformation_context->color_camera_xy_tables;
+        input->depth_image_data = depth_image_data;
+        input->depth_image_descriptor = (k4a_transformation_image_descriptor_t *)depth_image_descriptor;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
+              "K4A_CALIBRATION_TYPE_COLOR (%d).",
+              camera,
+              K4A_CALIBRATION_TYPE_DEPTH,
+              K4A_CALIBRATION_TYPE_COLOR);
+    return K4A_RESULT_FAILED;
+}
+
+k4a_result_t
+transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
+                                          const uint8_t *depth_image_data,
+                                          const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                          const k4a_calibration_type_t camera,
+                                          uint8_t *xyz_image_data,
+                                          k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    return transformation_depth_image_to_point_cloud_with_format(
+        transformation_handle,
+        depth_image_data,
+        depth_image_descriptor,
+        camera,
+        K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS,
+        xyz_image_data,
+        xyz_image_descriptor);
+}
+
+static k4a_result_t transformation_depth_image_to_point_cloud_with_format_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_point_cloud_input(
+            transformation_context, camera, depth_image_data, depth_image_descriptor, &input))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_buffer_result_t result = TRACE_BUFFER_CALL(
+        transformation_depth_image_to_point_cloud_with_format_internal(input.xy_tables,
+                                                                       input.depth_image_data,
+                                                                       input.depth_image_descriptor,
+                                                                       point_cloud_format,
+                                                                       xyz_image_data,
+                                                                       xyz_image_descriptor));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+k4a_result_t transformation_depth_image_to_point_cloud_with_format(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_point_cloud_with_format_locked(transformation_context,
+                                                                                       depth_image_data,
+                                                                                       depth_image_descriptor,
+                                                                                       camera,
+                                                                                       point_cloud_format,
+                                                                                       xyz_image_data,
+                                                                                       xyz_image_descriptor);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_depth_image_to_compact_point_cloud_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *index_image_data,
+    k4a_transformation_image_descriptor_t *index_image_descriptor,
+    size_t *point_count)
+{
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_point_cloud_input(
+            transformation_context, camera, depth_image_data, depth_image_descriptor, &input))))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_buffer_result_t result =
+        TRACE_BUFFER_CALL(transformation_depth_image_to_compact_point_cloud_internal(input.xy_tables,
+                                                                                    input.depth_image_data,
+                                                                                    input.depth_image_descriptor,
+                                                                                    point_cloud_format,
+                                                                                    xyz_image_data,
+                                                                                    xyz_image_descriptor,
+                                                                                    index_image_data,
+                                                                                    index_image_descriptor,
+                                                                                    point_count));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+k4a_result_t transformation_depth_image_to_compact_point_cloud(
+    k4a_transformation_t transformation_handle,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    k4a_transformation_point_cloud_format_t point_cloud_format,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *index_image_data,
+    k4a_transformation_image_descriptor_t *index_image_descriptor,
+    size_t *point_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_compact_point_cloud_locked(transformation_context,
+                                                                                   depth_image_data,
+                                                                                   depth_image_descriptor,
+                                                                                   camera,
+                                                                                   point_cloud_format,
+                                                                                   xyz_image_data,
+                                                                                   xyz_image_descriptor,
+                                                                                   index_image_data,
+                                                                                   index_image_descriptor,
+                                                                                   point_count);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_depth_image_to_point_cloud_with_normals_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor)
+{
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_point_cloud_input(
+            transformation_context, camera, depth_image_data, depth_image_descriptor, &input))))
     {
-        tewrapper_destroy(transformation_context->tewrapper);
+        return K4A_RESULT_FAILED;
     }
-    k4a_transformation_t_destroy(transformation_handle);
+
+    k4a_buffer_result_t result =
+        TRACE_BUFFER_CALL(transformation_depth_image_to_point_cloud_with_normals_internal(input.xy_tables,
+                                                                                         input.depth_image_data,
+                                                                                         input.depth_image_descriptor,
+                                                                                         xyz_image_data,
+                                                                                         xyz_image_descriptor,
+                                                                                         normal_image_data,
+                                                                                         normal_image_descriptor));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
 }
 
-k4a_result_t transformation_depth_image_to_color_camera_custom(
+k4a_result_t transformation_depth_image_to_point_cloud_with_normals(
     k4a_transformation_t transformation_handle,
     const uint8_t *depth_image_data,
     const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-    const uint8_t *custom_image_data,
-    const k4a_transformation_image_descriptor_t *custom_image_descriptor,
-    uint8_t *transformed_depth_image_data,
-    k4a_transformation_image_descriptor_t *transformed_depth_image_descriptor,
-    uint8_t *transformed_custom_image_data,
-    k4a_transformation_image_descriptor_t *transformed_custom_image_descriptor,
-    k4a_transformation_interpolation_type_t interpolation_type,
-    uint32_t invalid_custom_value)
+    const k4a_calibration_type_t camera,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
     k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
 
-    if (!transformation_context->enable_depth_color_transform)
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_point_cloud_with_normals_locked(transformation_context,
+                                                                                        depth_image_data,
+                                                                                        depth_image_descriptor,
+                                                                                        camera,
+                                                                                        xyz_image_data,
+                                                                                        xyz_image_descriptor,
+                                                                                        normal_image_data,
+                                                                                        normal_image_descriptor);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static k4a_result_t transformation_depth_image_to_voxel_point_cloud_locked(
+    k4a_transformation_context_t *transformation_context,
+    const uint8_t *depth_image_data,
+    const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+    const k4a_calibration_type_t camera,
+    float voxel_size,
+    uint8_t *xyz_image_data,
+    k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+    uint8_t *normal_image_data,
+    k4a_transformation_image_descriptor_t *normal_image_descriptor,
+    size_t *point_count)
+{
+    k4a_transformation_depth_input_t input;
+    if (K4A_FAILED(TRACE_CALL(transformation_init_point_cloud_input(
+            transformation_context, camera, depth_image_data, depth_image_descriptor, &input))))
     {
-        LOG_ERROR("Expect both depth camera and color camera are running to transform depth image to color camera.", 0);
         return K4A_RESULT_FAILED;
     }
 
-    if (transformation_context->enable_gpu_optimization)
+    k4a_buffer_result_t result =
+        TRACE_BUFFER_CALL(transformation_depth_image_to_voxel_point_cloud_internal(input.xy_tables,
+                                                                                  input.depth_image_data,
+                                                                                  input.depth_image_descriptor,
+                                                                                  voxel_size,
+                                                                                  xyz_image_data,
+                                                                                  xyz_image_descriptor,
+                                                                                  normal_image_data,
+                                                                                  normal_image_descriptor,
+                                                                                  point_count));
+    transformation_free_depth_input(&input);
+    return result == K4A_BUFFER_RESULT_SUCCEEDED ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+k4a_result_t
+transformation_depth_image_to_voxel_point_cloud(k4a_transformation_t transformation_handle,
+                                                const uint8_t *depth_image_data,
+                                                const k4a_transformation_image_descriptor_t *depth_image_descriptor,
+                                                const k4a_calibration_type_t camera,
+                                                float voxel_size,
+                                                uint8_t *xyz_image_data,
+                                                k4a_transformation_image_descriptor_t *xyz_image_descriptor,
+                                                uint8_t *normal_image_data,
+                                                k4a_transformation_image_descriptor_t *normal_image_descriptor,
+                                                size_t *point_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    transformation_begin_call(transformation_context);
+    k4a_result_t result = transformation_depth_image_to_voxel_point_cloud_locked(transformation_context,
+                                                                                 depth_image_data,
+                                                                                 depth_image_descriptor,
+                                                                                 camera,
+                                                                                 voxel_size,
+                                                                                 xyz_image_data,
+                                                                                 xyz_image_descriptor,
+                                                                                 normal_image_data,
+                                                                                 normal_image_descriptor,
+                                                                                 point_count);
+    transformation_end_call(transformation_context);
+    return result;
+}
+
+static uint8_t *transformation_get_job_image(k4a_image_t image, k4a_transformation_image_descriptor_t *descriptor)
+{
+    memset(descriptor, 0, sizeof(k4a_transformation_image_descriptor_t));
+    if (image == NULL)
     {
-        if (K4A_BUFFER_RESULT_SUCCEEDED !=
-            TRACE_BUFFER_CALL(transformation_depth_image_to_color_camera_validate_parameters(
-                &transformation_context->calibration,
-                &transformation_context->depth_camera_xy_tables,
-                depth_image_data,
-                depth_image_descriptor,
-                custom_image_data,
-                custom_image_descriptor,
-                transformed_depth_image_data,
-                transformed_depth_image_descriptor,
-                transformed_custom_image_data,
-                transformed_custom_image_descriptor)))
+        return NULL;
+    }
+
+    descriptor->width_pixels = image_get_width_pixels(image);
+    descriptor->height_pixels = image_get_height_pixels(image);
+    descriptor->stride_bytes = image_get_stride_bytes(image);
+    descriptor->format = image_get_format(image);
+    return image_get_buffer(image);
+}
+
+static bool transformation_job_has_images(const k4a_transformation_job_t *job)
+{
+    switch (job->type)
+    {
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR:
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD:
+        return job->depth_image != NULL && job->transformed_image != NULL;
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR:
+        return job->depth_image != NULL && job->source_image != NULL && job->transformed_image != NULL &&
+               job->transformed_source_image != NULL;
+    case K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH:
+        return job->depth_image != NULL && job->source_image != NULL && job->transformed_image != NULL;
+    default:
+        LOG_ERROR("Unknown transformation job type: %d.", job->type);
+        return false;
+    }
+}
+
+// The worker thread holds references to the images of the queued jobs, so the caller may release its own
+static void transformation_reference_job_images(const k4a_transformation_job_t *job, bool reference)
+{
+    k4a_image_t images[] = {
+        job->depth_image, job->source_image, job->transformed_image, job->transformed_source_image
+    };
+    for (size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++)
+    {
+        if (images[i] != NULL)
         {
-            return K4A_RESULT_FAILED;
+            if (reference)
+            {
+                image_inc_ref(images[i]);
+            }
+            else
+            {
+                image_dec_ref(images[i]);
+            }
         }
+    }
+}
 
-        size_t depth_image_size = (size_t)(depth_image_descriptor->stride_bytes *
-                                           depth_image_descriptor->height_pixels);
-        size_t custom_image_size = (size_t)(custom_image_descriptor->stride_bytes *
-                                            custom_image_descriptor->height_pixels);
-        size_t transformed_depth_image_size = (size_t)(transformed_depth_image_descriptor->stride_bytes *
-                                                       transformed_depth_image_descriptor->height_pixels);
-        size_t transformed_custom_image_size = (size_t)(transformed_custom_image_descriptor->stride_bytes *
-                                                        transformed_custom_image_descriptor->height_pixels);
+static k4a_result_t transformation_run_job(k4a_transformation_t transformation_handle,
+                                           const k4a_transformation_job_t *job)
+{
+    bool custom = job->type == K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR;
+    k4a_image_t source_image = custom || job->type == K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH ? job->source_image :
+                                                                                                    NULL;
+    k4a_image_t transformed_source_image = custom ? job->transformed_source_image : NULL;
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor;
+    k4a_transformation_image_descriptor_t source_image_descriptor;
+    k4a_transformation_image_descriptor_t transformed_image_descriptor;
+    k4a_transformation_image_descriptor_t transformed_source_image_descriptor;
+    uint8_t *depth_image_data = transformation_get_job_image(job->depth_image, &depth_image_descriptor);
+    uint8_t *source_image_data = transformation_get_job_image(source_image, &source_image_descriptor);
+    uint8_t *transformed_image_data = transformation_get_job_image(job->transformed_image,
+                                                                   &transformed_image_descriptor);
+    uint8_t *transformed_source_image_data = transformation_get_job_image(transformed_source_image,
+                                                                          &transformed_source_image_descriptor);
+
+    switch (job->type)
+    {
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR:
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_CUSTOM_TO_COLOR:
+        return TRACE_CALL(transformation_depth_image_to_color_camera_custom(
+            transformation_handle,
+            depth_image_data,
+            &depth_image_descriptor,
+            source_image_data,
+            &source_image_descriptor,
+            transformed_image_data,
+            &transformed_image_descriptor,
+            transformed_source_image_data,
+            &transformed_source_image_descriptor,
+            custom ? job->interpolation_type : K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+            custom ? job->invalid_custom_value : 0));
+    case K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH:
+        return TRACE_CALL(transformation_color_image_to_depth_camera_with_interpolation(transformation_handle,
+                                                                                        depth_image_data,
+                                                                                        &depth_image_descriptor,
+                                                                                        source_image_data,
+                                                                                        &source_image_descriptor,
+                                                                                        transformed_image_data,
+                                                                                        &transformed_image_descriptor,
+                                                                                        job->interpolation_type));
+    case K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD:
+        return TRACE_CALL(transformation_depth_image_to_point_cloud_with_format(transformation_handle,
+                                                                                depth_image_data,
+                                                                                &depth_image_descriptor,
+                                                                                job->camera,
+                                                                                job->point_cloud_format,
+                                                                                transformed_image_data,
+                                                                                &transformed_image_descriptor));
+    default:
+        return K4A_RESULT_FAILED;
+    }
+}
 
-        k4a_transform_engine_type_t transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_TO_COLOR;
-        if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM8)
+static void transformation_free_submission(k4a_transformation_submission_t *submission)
+{
+    for (size_t i = 0; i < submission->job_count; i++)
+    {
+        transformation_reference_job_images(&submission->jobs[i], false);
+    }
+    free(submission);
+}
+
+static int transformation_queue_thread(void *param)
+{
+    k4a_transformation_t transformation_handle = (k4a_transformation_t)param;
+    k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
+
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_WORKER);
+
+    Lock(transformation_context->queue_lock);
+    while (!transformation_context->queue_thread_stop)
+    {
+        k4a_transformation_submission_t *submission = transformation_context->queue_head;
+        if (submission == NULL)
         {
-            transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM8_TO_COLOR;
+            int infinite_timeout = 0;
+            (void)Condition_Wait(transformation_context->queue_condition,
+                                 transformation_context->queue_lock,
+                                 infinite_timeout);
+            continue;
         }
-        else if (custom_image_descriptor->format == K4A_IMAGE_FORMAT_CUSTOM16)
+
+        transformation_context->queue_head = submission->next;
+        if (transformation_context->queue_head == NULL)
         {
-            transform_type = K4A_TRANSFORM_ENGINE_TYPE_DEPTH_CUSTOM16_TO_COLOR;
+            transformation_context->queue_tail = NULL;
         }
+        Unlock(transformation_context->queue_lock);
 
-        k4a_transform_engine_interpolation_t interpolation;
-        switch (interpolation_type)
+        // Jobs of a submission run back to back, each of them even when an earlier one failed
+        k4a_result_t result = K4A_RESULT_SUCCEEDED;
+        for (size_t i = 0; i < submission->job_count; i++)
         {
-        case K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST:
-            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_NEAREST;
-            break;
-
-        case K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR:
-            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
-            break;
-
-        default:
-            interpolation = K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR;
-            break;
+            if (K4A_FAILED(TRACE_CALL(transformation_run_job(transformation_handle, &submission->jobs[i]))))
+            {
+                result = K4A_RESULT_FAILED;
+            }
         }
 
-        if (K4A_FAILED(TRACE_CALL(tewrapper_process_frame(transformation_context->tewrapper,
-                                                          transform_type,
-                                                          depth_image_data,
-                                                          depth_image_size,
-                                                          custom_image_data,
-                                                          custom_image_size,
-                                                          transformed_depth_image_data,
-                                                          transformed_depth_image_size,
-                                                          transformed_custom_image_data,
-                                                          transformed_custom_image_size,
-                                                          interpolation,
-                                                          invalid_custom_value))))
+        if (submission->callback)
         {
-            return K4A_RESULT_FAILED;
+            submission->callback(result, submission->callback_context);
         }
-    }
-    else
-    {
-        if (K4A_BUFFER_RESULT_SUCCEEDED !=
-            TRACE_BUFFER_CALL(
-                transformation_depth_image_to_color_camera_internal(&transformation_context->calibration,
-                                                                    &transformation_context->depth_camera_xy_tables,
-                                                                    depth_image_data,
-                                                                    depth_image_descriptor,
-                                                                    custom_image_data,
-                                                                    custom_image_descriptor,
-                                                                    transformed_depth_image_data,
-                                                                    transformed_depth_image_descriptor,
-                                                                    transformed_custom_image_data,
-                                                                    transformed_custom_image_descriptor,
-                                                                    interpolation_type,
-                                                                    invalid_custom_value)))
+        transformation_free_submission(submission);
+
+        Lock(transformation_context->queue_lock);
+        transformation_context->pending_submission_count--;
+        if (transformation_context->pending_submission_count == 0)
         {
-            return K4A_RESULT_FAILED;
+            Condition_Post(transformation_context->idle_condition);
         }
     }
-    return K4A_RESULT_SUCCEEDED;
+    Unlock(transformation_context->queue_lock);
+
+    return 0;
 }
 
-k4a_result_t
-transformation_color_image_to_depth_camera(k4a_transformation_t transformation_handle,
-                                           const uint8_t *depth_image_data,
-                                           const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-                                           const uint8_t *color_image_data,
-                                           const k4a_transformation_image_descriptor_t *color_image_descriptor,
-                                           uint8_t *transformed_color_image_data,
-                                           k4a_transformation_image_descriptor_t *transformed_color_image_descriptor)
+k4a_result_t transformation_submit(k4a_transformation_t transformation_handle,
+                                   const k4a_transformation_job_t *jobs,
+                                   size_t job_count,
+                                   k4a_transformation_completion_cb_t *callback,
+                                   void *callback_context)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, jobs == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, job_count == 0);
     k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
 
-    if (!transformation_context->enable_depth_color_transform)
-    {
-        LOG_ERROR("Expect both depth camera and color camera are running to transform color image to depth camera.", 0);
-        return K4A_RESULT_FAILED;
-    }
-
-    if (transformation_context->enable_gpu_optimization)
+    for (size_t i = 0; i < job_count; i++)
     {
-        if (K4A_BUFFER_RESULT_SUCCEEDED !=
-            TRACE_BUFFER_CALL(transformation_color_image_to_depth_camera_validate_parameters(
-                &transformation_context->calibration,
-                &transformation_context->depth_camera_xy_tables,
-                depth_image_data,
-                depth_image_descriptor,
-                color_image_data,
-                color_image_descriptor,
-                transformed_color_image_data,
-                transformed_color_image_descriptor)))
+        if (!transformation_job_has_images(&jobs[i]))
         {
+            LOG_ERROR("Transformation job %d is missing an image its type requires.", (int)i);
             return K4A_RESULT_FAILED;
         }
+    }
 
-        size_t depth_image_size = (size_t)(depth_image_descriptor->stride_bytes *
-                                           depth_image_descriptor->height_pixels);
-        size_t color_image_size = (size_t)(color_image_descriptor->stride_bytes *
-                                           color_image_descriptor->height_pixels);
-        size_t transformed_color_image_size = (size_t)(transformed_color_image_descriptor->stride_bytes *
-                                                       transformed_color_image_descriptor->height_pixels);
+    k4a_transformation_submission_t *submission = (k4a_transformation_submission_t *)malloc(
+        sizeof(k4a_transformation_submission_t) + job_count * sizeof(k4a_transformation_job_t));
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(submission != NULL);
+    if (K4A_FAILED(result))
+    {
+        return result;
+    }
 
-        if (K4A_FAILED(TRACE_CALL(tewrapper_process_frame(transformation_context->tewrapper,
-                                                          K4A_TRANSFORM_ENGINE_TYPE_COLOR_TO_DEPTH,
-                                                          depth_image_data,
-                                                          depth_image_size,
-                                                          color_image_data,
-                                                          color_image_size,
-                                                          transformed_color_image_data,
-                                                          transformed_color_image_size,
-                                                          NULL,
-                                                          (size_t)0,
-                                                          K4A_TRANSFORM_ENGINE_INTERPOLATION_LINEAR,
-                                                          (uint16_t)0))))
+    submission->next = NULL;
+    submission->jobs = (k4a_transformation_job_t *)(void *)(submission + 1);
+    submission->job_count = job_count;
+    submission->callback = callback;
+    submission->callback_context = callback_context;
+    memcpy(submission->jobs, jobs, job_count * sizeof(k4a_transformation_job_t));
+    for (size_t i = 0; i < job_count; i++)
+    {
+        transformation_reference_job_images(&submission->jobs[i], true);
+    }
+
+    Lock(transformation_context->queue_lock);
+    if (transformation_context->queue_thread == NULL)
+    {
+        THREADAPI_RESULT tresult = ThreadAPI_Create(&transformation_context->queue_thread,
+                                                    transformation_queue_thread,
+                                                    transformation_handle);
+        result = K4A_RESULT_FROM_BOOL(tresult == THREADAPI_OK);
+        if (K4A_FAILED(result))
         {
-            return K4A_RESULT_FAILED;
+            transformation_context->queue_thread = NULL;
         }
     }
-    else
+
+    if (K4A_SUCCEEDED(result))
     {
-        if (K4A_BUFFER_RESULT_SUCCEEDED !=
-            TRACE_BUFFER_CALL(
-                transformation_color_image_to_depth_camera_internal(&transformation_context->calibration,
-                                                                    &transformation_context->depth_camera_xy_tables,
-                                                                    depth_image_data,
-                                                                    depth_image_descriptor,
-                                                                    color_image_data,
-                                                                    color_image_descriptor,
-                                                                    transformed_color_image_data,
-                                                                    transformed_color_image_descriptor)))
+        if (transformation_context->queue_tail == NULL)
         {
-            return K4A_RESULT_FAILED;
+            transformation_context->queue_head = submission;
+        }
+        else
+        {
+            transformation_context->queue_tail->next = submission;
         }
+        transformation_context->queue_tail = submission;
+        transformation_context->pending_submission_count++;
+        Condition_Post(transformation_context->queue_condition);
     }
-    return K4A_RESULT_SUCCEEDED;
+    Unlock(transformation_context->queue_lock);
+
+    if (K4A_FAILED(result))
+    {
+        transformation_free_submission(submission);
+    }
+    return result;
 }
 
-k4a_result_t
-transformation_depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
-                                          const uint8_t *depth_image_data,
-                                          const k4a_transformation_image_descriptor_t *depth_image_descriptor,
-                                          const k4a_calibration_type_t camera,
-                                          uint8_t *xyz_image_data,
-                                          k4a_transformation_image_descriptor_t *xyz_image_descriptor)
+k4a_wait_result_t transformation_wait_idle(k4a_transformation_t transformation_handle, int32_t timeout_in_ms)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_transformation_t, transformation_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_transformation_t, transformation_handle);
     k4a_transformation_context_t *transformation_context = k4a_transformation_t_get_context(transformation_handle);
 
-    k4a_transformation_xy_tables_t *xy_tables;
-    if (camera == K4A_CALIBRATION_TYPE_DEPTH)
-    {
-        xy_tables = &transformation_context->depth_camera_xy_tables;
-    }
-    else if (camera == K4A_CALIBRATION_TYPE_COLOR)
-    {
-        xy_tables = &transformation_context->color_camera_xy_tables;
-    }
-    else
+    k4a_wait_result_t wait_result = K4A_WAIT_RESULT_SUCCEEDED;
+    Lock(transformation_context->queue_lock);
+    while (transformation_context->pending_submission_count > 0 && wait_result == K4A_WAIT_RESULT_SUCCEEDED)
     {
-        LOG_ERROR("Unexpected camera calibration type %d, should either be K4A_CALIBRATION_TYPE_DEPTH (%d) or "
-                  "K4A_CALIBRATION_TYPE_COLOR (%d).",
-                  camera,
-                  K4A_CALIBRATION_TYPE_DEPTH,
-                  K4A_CALIBRATION_TYPE_COLOR);
-        return K4A_RESULT_FAILED;
+        if (timeout_in_ms == 0)
+        {
+            wait_result = K4A_WAIT_RESULT_TIMEOUT;
+            break;
+        }
+
+        // Anything less than 0 is a wait forever condition, which Condition_Wait expresses with 0
+        COND_RESULT cond_result = Condition_Wait(transformation_context->idle_condition,
+                                                 transformation_context->queue_lock,
+                                                 timeout_in_ms < 0 ? 0 : timeout_in_ms);
+        if (cond_result == COND_TIMEOUT)
+        {
+            wait_result = K4A_WAIT_RESULT_TIMEOUT;
+        }
+        else if (cond_result != COND_OK)
+        {
+            K4A_RESULT_FROM_BOOL(cond_result != COND_ERROR);
+            wait_result = K4A_WAIT_RESULT_FAILED;
+        }
     }
 
-    if (K4A_BUFFER_RESULT_SUCCEEDED !=
-        TRACE_BUFFER_CALL(transformation_depth_image_to_point_cloud_internal(
-            xy_tables, depth_image_data, depth_image_descriptor, xyz_image_data, xyz_image_descriptor)))
+    if (transformation_context->pending_submission_count == 0)
     {
-        return K4A_RESULT_FAILED;
+        // Condition_Post may only wake one thread, pass the wake up on to the other waiting threads
+        Condition_Post(transformation_context->idle_condition);
     }
-    return K4A_RESULT_SUCCEEDED;
+    Unlock(transformation_context->queue_lock);
+
+    return wait_result;
 }
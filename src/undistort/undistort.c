@@ -0,0 +1,637 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library remaps camera images to an undistorted pinhole camera
+#include <k4ainternal/undistort.h>
+
+// Dependent libraries
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+#include <k4ainternal/simd.h>
+#include <k4ainternal/threadpool.h>
+
+// System dependencies
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bilinear weights are fixed point with this many fractional bits, so that a 16 bit pixel times both weights fits
+// 32 bits
+#define UNDISTORT_WEIGHT_BITS (8)
+#define UNDISTORT_WEIGHT_ONE (1 << UNDISTORT_WEIGHT_BITS)
+
+// x of a map entry of a target pixel without a source pixel
+#define UNDISTORT_INVALID_ENTRY (INT16_MIN)
+
+// Number of pixels the 16 bit bilinear kernel interpolates at once
+#define UNDISTORT_GROUP_SIZE (4)
+
+// Source pixel of one target pixel. The top left neighbor is (x, y) and the bottom right neighbor is (x + 1, y + 1),
+// both inside the source image. The weights of the right and bottom neighbors are in [0, UNDISTORT_WEIGHT_ONE].
+typedef struct _undistort_map_entry_t
+{
+    int16_t x;
+    int16_t y;
+    uint16_t weight_x;
+    uint16_t weight_y;
+} undistort_map_entry_t;
+
+struct _undistort_context_t;
+
+// Rows [first_row, last_row) of the target image that one thread remaps
+typedef struct _undistort_band_t
+{
+    struct _undistort_context_t *context;
+    int first_row;
+    int last_row;
+} undistort_band_t;
+
+typedef struct _undistort_context_t
+{
+    int source_width;
+    int source_height;
+    int target_width;
+    int target_height;
+    undistort_map_entry_t *entries;
+
+    // Arguments of the remap in progress
+    const uint8_t *source_data;
+    const k4a_transformation_image_descriptor_t *source_descriptor;
+    uint8_t *destination_data;
+    const k4a_transformation_image_descriptor_t *destination_descriptor;
+    bool nearest;
+
+    simd_level_t simd_level; // Instruction set of the interpolation, see simd_get_level()
+    uint32_t band_count;
+    bool threadpool_acquired; // Held while band_count is above 1
+    undistort_band_t bands[UNDISTORT_MAX_THREAD_COUNT];
+} undistort_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_undistortion_map_t, undistort_context_t);
+
+// Fills the map entries of one target row from the projections of its rays
+static void undistort_fill_entries(undistort_context_t *context,
+                                   const float *points2d,
+                                   const int *valid,
+                                   undistort_map_entry_t *entries)
+{
+    // Projections within half a weight step of the border are rounded onto it, so that the rounding error of the
+    // projection does not drop the first and last pixels of a map without distortion
+    const float tolerance = 0.5f / UNDISTORT_WEIGHT_ONE;
+    float max_x = (float)(context->source_width - 1);
+    float max_y = (float)(context->source_height - 1);
+    for (int x = 0; x < context->target_width; x++)
+    {
+        float source_x = points2d[2 * x];
+        float source_y = points2d[2 * x + 1];
+        if (!valid[x] || !(source_x >= -tolerance && source_x <= max_x + tolerance && source_y >= -tolerance &&
+                           source_y <= max_y + tolerance))
+        {
+            entries[x].x = UNDISTORT_INVALID_ENTRY;
+            entries[x].y = 0;
+            entries[x].weight_x = 0;
+            entries[x].weight_y = 0;
+            continue;
+        }
+
+        // The last row and column are reached with a full weight on their neighbor to the top or left, so that the
+        // bottom right neighbor stays inside the image
+        source_x = source_x < 0.f ? 0.f : (source_x > max_x ? max_x : source_x);
+        source_y = source_y < 0.f ? 0.f : (source_y > max_y ? max_y : source_y);
+        int floor_x = (int)floorf(source_x);
+        int floor_y = (int)floorf(source_y);
+        floor_x = floor_x > context->source_width - 2 ? context->source_width - 2 : floor_x;
+        floor_y = floor_y > context->source_height - 2 ? context->source_height - 2 : floor_y;
+        entries[x].x = (int16_t)floor_x;
+        entries[x].y = (int16_t)floor_y;
+        entries[x].weight_x = (uint16_t)((source_x - (float)floor_x) * UNDISTORT_WEIGHT_ONE + 0.5f);
+        entries[x].weight_y = (uint16_t)((source_y - (float)floor_y) * UNDISTORT_WEIGHT_ONE + 0.5f);
+    }
+}
+
+// Interpolates four values at once from their top left, top right, bottom left and bottom right neighbors. The
+// arithmetic is exact in 32 bits for 16 bit values, so every path gives the same result.
+#if defined(K4A_USING_SSE)
+static inline void undistort_interpolate_4_sse41(const uint32_t *top_left,
+                                                 const uint32_t *top_right,
+                                                 const uint32_t *bottom_left,
+                                                 const uint32_t *bottom_right,
+                                                 const uint32_t *weight_x,
+                                                 const uint32_t *weight_y,
+                                                 uint32_t *output)
+{
+    __m128i one = _mm_set1_epi32(UNDISTORT_WEIGHT_ONE);
+    __m128i wx = _mm_loadu_si128((const __m128i *)(const void *)weight_x);
+    __m128i wy = _mm_loadu_si128((const __m128i *)(const void *)weight_y);
+    __m128i wx_left = _mm_sub_epi32(one, wx);
+    __m128i top = _mm_add_epi32(_mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(const void *)top_left), wx_left),
+                                _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(const void *)top_right), wx));
+    __m128i bottom = _mm_add_epi32(_mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(const void *)bottom_left),
+                                                   wx_left),
+                                   _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(const void *)bottom_right), wx));
+    __m128i sum = _mm_add_epi32(_mm_mullo_epi32(top, _mm_sub_epi32(one, wy)), _mm_mullo_epi32(bottom, wy));
+    sum = _mm_add_epi32(sum, _mm_set1_epi32(1 << (2 * UNDISTORT_WEIGHT_BITS - 1)));
+    _mm_storeu_si128((__m128i *)(void *)output, _mm_srli_epi32(sum, 2 * UNDISTORT_WEIGHT_BITS));
+}
+#elif defined(K4A_USING_NEON)
+static inline void undistort_interpolate_4_neon(const uint32_t *top_left,
+                                                const uint32_t *top_right,
+                                                const uint32_t *bottom_left,
+                                                const uint32_t *bottom_right,
+                                                const uint32_t *weight_x,
+                                                const uint32_t *weight_y,
+                                                uint32_t *output)
+{
+    uint32x4_t one = vdupq_n_u32(UNDISTORT_WEIGHT_ONE);
+    uint32x4_t wx = vld1q_u32(weight_x);
+    uint32x4_t wy = vld1q_u32(weight_y);
+    uint32x4_t wx_left = vsubq_u32(one, wx);
+    uint32x4_t top = vmlaq_u32(vmulq_u32(vld1q_u32(top_left), wx_left), vld1q_u32(top_right), wx);
+    uint32x4_t bottom = vmlaq_u32(vmulq_u32(vld1q_u32(bottom_left), wx_left), vld1q_u32(bottom_right), wx);
+    uint32x4_t sum = vmlaq_u32(vmulq_u32(top, vsubq_u32(one, wy)), bottom, wy);
+    sum = vaddq_u32(sum, vdupq_n_u32(1 << (2 * UNDISTORT_WEIGHT_BITS - 1)));
+    vst1q_u32(output, vshrq_n_u32(sum, 2 * UNDISTORT_WEIGHT_BITS));
+}
+#endif
+
+static inline void undistort_interpolate_4_scalar(const uint32_t *top_left,
+                                                  const uint32_t *top_right,
+                                                  const uint32_t *bottom_left,
+                                                  const uint32_t *bottom_right,
+                                                  const uint32_t *weight_x,
+                                                  const uint32_t *weight_y,
+                                                  uint32_t *output)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        uint32_t wx_left = UNDISTORT_WEIGHT_ONE - weight_x[i];
+        uint32_t top = top_left[i] * wx_left + top_right[i] * weight_x[i];
+        uint32_t bottom = bottom_left[i] * wx_left + bottom_right[i] * weight_x[i];
+        uint32_t sum = top * (UNDISTORT_WEIGHT_ONE - weight_y[i]) + bottom * weight_y[i];
+        output[i] = (sum + (1u << (2 * UNDISTORT_WEIGHT_BITS - 1))) >> (2 * UNDISTORT_WEIGHT_BITS);
+    }
+}
+
+static inline void undistort_interpolate_4(const uint32_t *top_left,
+                                           const uint32_t *top_right,
+                                           const uint32_t *bottom_left,
+                                           const uint32_t *bottom_right,
+                                           const uint32_t *weight_x,
+                                           const uint32_t *weight_y,
+                                           simd_level_t level,
+                                           uint32_t *output)
+{
+#if defined(K4A_USING_SSE)
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        undistort_interpolate_4_sse41(top_left, top_right, bottom_left, bottom_right, weight_x, weight_y, output);
+        return;
+    }
+#elif defined(K4A_USING_NEON)
+    if (level == SIMD_LEVEL_NEON)
+    {
+        undistort_interpolate_4_neon(top_left, top_right, bottom_left, bottom_right, weight_x, weight_y, output);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    undistort_interpolate_4_scalar(top_left, top_right, bottom_left, bottom_right, weight_x, weight_y, output);
+}
+
+static void undistort_remap_row_16_nearest(const undistort_map_entry_t *entries,
+                                           int width,
+                                           const uint8_t *source,
+                                           int source_stride,
+                                           uint16_t *output)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const undistort_map_entry_t *entry = &entries[x];
+        if (entry->x == UNDISTORT_INVALID_ENTRY)
+        {
+            output[x] = 0;
+            continue;
+        }
+        int source_x = entry->x + (entry->weight_x >= UNDISTORT_WEIGHT_ONE / 2);
+        int source_y = entry->y + (entry->weight_y >= UNDISTORT_WEIGHT_ONE / 2);
+        const uint16_t *row = (const uint16_t *)(const void *)(source + (size_t)source_y * (size_t)source_stride);
+        output[x] = row[source_x];
+    }
+}
+
+static void undistort_remap_row_16_bilinear(const undistort_map_entry_t *entries,
+                                            int width,
+                                            const uint8_t *source,
+                                            int source_stride,
+                                            bool is_depth,
+                                            simd_level_t level,
+                                            uint16_t *output)
+{
+    for (int x = 0; x < width; x += UNDISTORT_GROUP_SIZE)
+    {
+        // The neighbors are gathered for a group of pixels and interpolated together. Pixels past the end of the row
+        // and without a source pixel interpolate zeros.
+        uint32_t neighbors[4][UNDISTORT_GROUP_SIZE] = { { 0 } };
+        uint32_t weight_x[UNDISTORT_GROUP_SIZE] = { 0 };
+        uint32_t weight_y[UNDISTORT_GROUP_SIZE] = { 0 };
+        bool invalid[UNDISTORT_GROUP_SIZE] = { false };
+        int count = width - x < UNDISTORT_GROUP_SIZE ? width - x : UNDISTORT_GROUP_SIZE;
+        for (int i = 0; i < count; i++)
+        {
+            const undistort_map_entry_t *entry = &entries[x + i];
+            if (entry->x == UNDISTORT_INVALID_ENTRY)
+            {
+                invalid[i] = true;
+                continue;
+            }
+            const uint16_t *top = (const uint16_t *)(const void *)(source +
+                                                                  (size_t)entry->y * (size_t)source_stride) +
+                                  entry->x;
+            const uint16_t *bottom = (const uint16_t *)(const void *)((const uint8_t *)top + source_stride);
+            neighbors[0][i] = top[0];
+            neighbors[1][i] = top[1];
+            neighbors[2][i] = bottom[0];
+            neighbors[3][i] = bottom[1];
+            weight_x[i] = entry->weight_x;
+            weight_y[i] = entry->weight_y;
+
+            // Depth is not blended with pixels without depth. Neighbors without weight are ignored, so that a map
+            // without distortion keeps depth next to a hole.
+            if (is_depth)
+            {
+                bool left = entry->weight_x < UNDISTORT_WEIGHT_ONE;
+                bool right = entry->weight_x > 0;
+                bool upper = entry->weight_y < UNDISTORT_WEIGHT_ONE;
+                bool lower = entry->weight_y > 0;
+                invalid[i] = (upper && ((left && top[0] == 0) || (right && top[1] == 0))) ||
+                             (lower && ((left && bottom[0] == 0) || (right && bottom[1] == 0)));
+            }
+        }
+
+        uint32_t interpolated[UNDISTORT_GROUP_SIZE];
+        undistort_interpolate_4(neighbors[0],
+                                neighbors[1],
+                                neighbors[2],
+                                neighbors[3],
+                                weight_x,
+                                weight_y,
+                                level,
+                                interpolated);
+        for (int i = 0; i < count; i++)
+        {
+            output[x + i] = invalid[i] ? 0 : (uint16_t)interpolated[i];
+        }
+    }
+}
+
+static void undistort_remap_row_bgra_nearest(const undistort_map_entry_t *entries,
+                                             int width,
+                                             const uint8_t *source,
+                                             int source_stride,
+                                             uint8_t *output)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const undistort_map_entry_t *entry = &entries[x];
+        if (entry->x == UNDISTORT_INVALID_ENTRY)
+        {
+            memset(output + 4 * x, 0, 4);
+            continue;
+        }
+        int source_x = entry->x + (entry->weight_x >= UNDISTORT_WEIGHT_ONE / 2);
+        int source_y = entry->y + (entry->weight_y >= UNDISTORT_WEIGHT_ONE / 2);
+        memcpy(output + 4 * x, source + (size_t)source_y * (size_t)source_stride + 4 * source_x, 4);
+    }
+}
+
+#if defined(K4A_USING_SSE)
+static inline void undistort_bilinear_bgra_sse41(const uint8_t *top,
+                                                 const uint8_t *bottom,
+                                                 const undistort_map_entry_t *entry,
+                                                 uint8_t *output)
+{
+    __m128i one = _mm_set1_epi32(UNDISTORT_WEIGHT_ONE);
+    __m128i wx = _mm_set1_epi32(entry->weight_x);
+    __m128i wy = _mm_set1_epi32(entry->weight_y);
+    __m128i wx_left = _mm_sub_epi32(one, wx);
+
+    // Left and right neighbors of the top and bottom row
+    __m128i top_pixels = _mm_loadl_epi64((const __m128i *)(const void *)top);
+    __m128i bottom_pixels = _mm_loadl_epi64((const __m128i *)(const void *)bottom);
+    __m128i top_row = _mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu8_epi32(top_pixels), wx_left),
+                                    _mm_mullo_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(top_pixels, 4)), wx));
+    __m128i bottom_row = _mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu8_epi32(bottom_pixels), wx_left),
+                                       _mm_mullo_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(bottom_pixels, 4)), wx));
+    __m128i sum = _mm_add_epi32(_mm_mullo_epi32(top_row, _mm_sub_epi32(one, wy)), _mm_mullo_epi32(bottom_row, wy));
+    sum = _mm_add_epi32(sum, _mm_set1_epi32(1 << (2 * UNDISTORT_WEIGHT_BITS - 1)));
+    __m128i result = _mm_srli_epi32(sum, 2 * UNDISTORT_WEIGHT_BITS);
+    result = _mm_packus_epi32(result, result);
+    result = _mm_packus_epi16(result, result);
+    int packed = _mm_cvtsi128_si32(result);
+    memcpy(output, &packed, 4);
+}
+#endif
+
+// Interpolates the four channels of one BGRA pixel at once
+static inline void undistort_bilinear_bgra(const uint8_t *top,
+                                           const uint8_t *bottom,
+                                           const undistort_map_entry_t *entry,
+                                           simd_level_t level,
+                                           uint8_t *output)
+{
+#if defined(K4A_USING_SSE)
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        undistort_bilinear_bgra_sse41(top, bottom, entry, output);
+        return;
+    }
+#endif
+
+    uint32_t neighbors[4][4];
+    uint32_t weight_x[4];
+    uint32_t weight_y[4];
+    for (int c = 0; c < 4; c++)
+    {
+        neighbors[0][c] = top[c];
+        neighbors[1][c] = top[4 + c];
+        neighbors[2][c] = bottom[c];
+        neighbors[3][c] = bottom[4 + c];
+        weight_x[c] = entry->weight_x;
+        weight_y[c] = entry->weight_y;
+    }
+
+    uint32_t interpolated[4];
+    undistort_interpolate_4(
+        neighbors[0], neighbors[1], neighbors[2], neighbors[3], weight_x, weight_y, level, interpolated);
+    for (int c = 0; c < 4; c++)
+    {
+        output[c] = (uint8_t)interpolated[c];
+    }
+}
+
+static void undistort_remap_row_bgra_bilinear(const undistort_map_entry_t *entries,
+                                              int width,
+                                              const uint8_t *source,
+                                              int source_stride,
+                                              simd_level_t level,
+                                              uint8_t *output)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const undistort_map_entry_t *entry = &entries[x];
+        if (entry->x == UNDISTORT_INVALID_ENTRY)
+        {
+            memset(output + 4 * x, 0, 4);
+            continue;
+        }
+        const uint8_t *top = source + (size_t)entry->y * (size_t)source_stride + 4 * entry->x;
+        undistort_bilinear_bgra(top, top + source_stride, entry, level, output + 4 * x);
+    }
+}
+
+static int undistort_band_worker(void *param)
+{
+    undistort_band_t *band = (undistort_band_t *)param;
+    undistort_context_t *context = band->context;
+    const k4a_transformation_image_descriptor_t *source_descriptor = context->source_descriptor;
+    const k4a_transformation_image_descriptor_t *destination_descriptor = context->destination_descriptor;
+    int width = context->target_width;
+
+    for (int y = band->first_row; y < band->last_row; y++)
+    {
+        const undistort_map_entry_t *entries = context->entries + (size_t)y * (size_t)width;
+        uint8_t *output = context->destination_data + (size_t)y * (size_t)destination_descriptor->stride_bytes;
+        if (source_descriptor->format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+        {
+            if (context->nearest)
+            {
+                undistort_remap_row_bgra_nearest(
+                    entries, width, context->source_data, source_descriptor->stride_bytes, output);
+            }
+            else
+            {
+                undistort_remap_row_bgra_bilinear(entries,
+                                                  width,
+                                                  context->source_data,
+                                                  source_descriptor->stride_bytes,
+                                                  context->simd_level,
+                                                  output);
+            }
+        }
+        else if (context->nearest)
+        {
+            undistort_remap_row_16_nearest(
+                entries, width, context->source_data, source_descriptor->stride_bytes, (uint16_t *)(void *)output);
+        }
+        else
+        {
+            undistort_remap_row_16_bilinear(entries,
+                                            width,
+                                            context->source_data,
+                                            source_descriptor->stride_bytes,
+                                            source_descriptor->format == K4A_IMAGE_FORMAT_DEPTH16,
+                                            context->simd_level,
+                                            (uint16_t *)(void *)output);
+        }
+    }
+    return 0;
+}
+
+k4a_result_t undistort_map_create(const k4a_calibration_camera_t *camera_calibration,
+                                  const k4a_pinhole_t *target,
+                                  const float *rotation,
+                                  uint32_t thread_count,
+                                  k4a_undistortion_map_t *map_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, camera_calibration == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, map_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, thread_count > UNDISTORT_MAX_THREAD_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        camera_calibration->resolution_width < 2 || camera_calibration->resolution_height < 2 ||
+                            camera_calibration->resolution_width > INT16_MAX ||
+                            camera_calibration->resolution_height > INT16_MAX);
+
+    // Without a target the image keeps the focal length and principal point of the camera
+    k4a_pinhole_t pinhole;
+    if (target != NULL)
+    {
+        pinhole = *target;
+    }
+    else
+    {
+        const k4a_calibration_intrinsic_parameters_t *parameters = &camera_calibration->intrinsics.parameters;
+        pinhole.cx = parameters->param.cx;
+        pinhole.cy = parameters->param.cy;
+        pinhole.fx = parameters->param.fx;
+        pinhole.fy = parameters->param.fy;
+        pinhole.width = camera_calibration->resolution_width;
+        pinhole.height = camera_calibration->resolution_height;
+    }
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, pinhole.width <= 0 || pinhole.height <= 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !(pinhole.fx > 0.f && pinhole.fy > 0.f));
+
+    undistort_context_t *context = k4a_undistortion_map_t_create(map_handle);
+    if (context == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    context->source_width = camera_calibration->resolution_width;
+    context->source_height = camera_calibration->resolution_height;
+    context->target_width = pinhole.width;
+    context->target_height = pinhole.height;
+    context->simd_level = simd_get_level();
+
+    size_t width = (size_t)pinhole.width;
+    context->entries = (undistort_map_entry_t *)malloc(width * (size_t)pinhole.height *
+                                                       sizeof(undistort_map_entry_t));
+    float *points3d = (float *)malloc(width * 3 * sizeof(float));
+    float *points2d = (float *)malloc(width * 2 * sizeof(float));
+    int *valid = (int *)malloc(width * sizeof(int));
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context->entries != NULL && points3d != NULL && points2d != NULL &&
+                                               valid != NULL);
+
+    // The rays of a row of target pixels are projected into the camera together
+    for (int y = 0; y < pinhole.height && K4A_SUCCEEDED(result); y++)
+    {
+        float ray_y = ((float)y - pinhole.cy) / pinhole.fy;
+        for (size_t x = 0; x < width; x++)
+        {
+            float ray[3] = { ((float)x - pinhole.cx) / pinhole.fx, ray_y, 1.f };
+            float *point3d = points3d + 3 * x;
+            if (rotation != NULL)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    point3d[i] = rotation[3 * i] * ray[0] + rotation[3 * i + 1] * ray[1] + rotation[3 * i + 2] * ray[2];
+                }
+            }
+            else
+            {
+                memcpy(point3d, ray, sizeof(ray));
+            }
+        }
+
+        result = TRACE_CALL(transformation_project_batch(camera_calibration, points3d, width, points2d, valid));
+        if (K4A_SUCCEEDED(result))
+        {
+            undistort_fill_entries(context, points2d, valid, context->entries + (size_t)y * width);
+        }
+    }
+    free(points3d);
+    free(points2d);
+    free(valid);
+
+    context->band_count = thread_count > 1 ? thread_count : 1;
+    if (context->band_count > (uint32_t)pinhole.height)
+    {
+        context->band_count = (uint32_t)pinhole.height;
+    }
+    if (K4A_SUCCEEDED(result) && context->band_count > 1)
+    {
+        result = TRACE_CALL(threadpool_acquire());
+        context->threadpool_acquired = K4A_SUCCEEDED(result);
+    }
+
+    for (uint32_t i = 0; i < context->band_count; i++)
+    {
+        context->bands[i].context = context;
+        context->bands[i].first_row = (int)((uint32_t)pinhole.height * i / context->band_count);
+        context->bands[i].last_row = (int)((uint32_t)pinhole.height * (i + 1) / context->band_count);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        undistort_map_destroy(*map_handle);
+        *map_handle = NULL;
+    }
+    return result;
+}
+
+void undistort_map_destroy(k4a_undistortion_map_t map_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_undistortion_map_t, map_handle);
+    undistort_context_t *context = k4a_undistortion_map_t_get_context(map_handle);
+
+    if (context->threadpool_acquired)
+    {
+        threadpool_release();
+    }
+    free(context->entries);
+    k4a_undistortion_map_t_destroy(map_handle);
+}
+
+k4a_result_t undistort_map_remap(k4a_undistortion_map_t map_handle,
+                                 const uint8_t *source_data,
+                                 const k4a_transformation_image_descriptor_t *source_descriptor,
+                                 uint8_t *destination_data,
+                                 const k4a_transformation_image_descriptor_t *destination_descriptor,
+                                 k4a_transformation_interpolation_type_t interpolation_type)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_undistortion_map_t, map_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source_data == NULL || source_descriptor == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, destination_data == NULL || destination_descriptor == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        interpolation_type != K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST &&
+                            interpolation_type != K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR);
+    undistort_context_t *context = k4a_undistortion_map_t_get_context(map_handle);
+
+    int bytes_per_pixel = 0;
+    switch (source_descriptor->format)
+    {
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+        bytes_per_pixel = (int)sizeof(uint16_t);
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        bytes_per_pixel = 4 * (int)sizeof(uint8_t);
+        break;
+    default:
+        LOG_ERROR("Unsupported image format %d, expected DEPTH16, IR16 or BGRA32.", source_descriptor->format);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (source_descriptor->width_pixels != context->source_width ||
+        source_descriptor->height_pixels != context->source_height ||
+        source_descriptor->stride_bytes < context->source_width * bytes_per_pixel)
+    {
+        LOG_ERROR("Source image of %dx%d does not match the camera resolution of %dx%d.",
+                  source_descriptor->width_pixels,
+                  source_descriptor->height_pixels,
+                  context->source_width,
+                  context->source_height);
+        return K4A_RESULT_FAILED;
+    }
+    if (destination_descriptor->format != source_descriptor->format ||
+        destination_descriptor->width_pixels != context->target_width ||
+        destination_descriptor->height_pixels != context->target_height ||
+        destination_descriptor->stride_bytes < context->target_width * bytes_per_pixel)
+    {
+        LOG_ERROR("Destination image of %dx%d and format %d does not match the target resolution of %dx%d and the "
+                  "source format %d.",
+                  destination_descriptor->width_pixels,
+                  destination_descriptor->height_pixels,
+                  destination_descriptor->format,
+                  context->target_width,
+                  context->target_height,
+                  source_descriptor->format);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->source_data = source_data;
+    context->source_descriptor = source_descriptor;
+    context->destination_data = destination_data;
+    context->destination_descriptor = destination_descriptor;
+    context->nearest = interpolation_type == K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST;
+
+    if (context->band_count == 1)
+    {
+        (void)undistort_band_worker(&context->bands[0]);
+    }
+    else
+    {
+        threadpool_run_tasks(undistort_band_worker, context->bands, sizeof(undistort_band_t), context->band_count);
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
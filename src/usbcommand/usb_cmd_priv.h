@@ -16,6 +16,7 @@
 
 // Dependent libraries
 #include <k4ainternal/allocator.h>
+#include <azure_c_shared_utility/condition.h>
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/threadapi.h>
 
@@ -40,6 +41,21 @@ extern "C" {
 #define USB_CMD_MAX_XFR_POOL 10000000 // Memory pool size for outstanding transfers (based on empirical testing)
 #endif
 #define USB_CMD_PORT_DEPTH 8
+#define USB_CMD_MAX_CACHED_DEVICES 32 // Upper limit to the number of device locations with a known container ID
+#define USB_CMD_XFR_POOL_SPARE_COUNT 4 // Extra pooled buffers for images still held downstream of the USB thread
+#define USB_CMD_XFR_POOL_MAX_COUNT (USB_CMD_MAX_XFR_COUNT + USB_CMD_XFR_POOL_SPARE_COUNT)
+#define USB_CMD_XFR_BUFFER_ALIGNMENT 4096 // Page alignment for pooled transfer buffers
+
+// Adaptive transfer count, enabled with K4A_LIBUSB_ADAPTIVE
+#define USB_CMD_ADAPTIVE_INITIAL_XFR_COUNT 4      // Transfers submitted when the stream starts
+#define USB_CMD_ADAPTIVE_MIN_XFR_COUNT 2          // Never fewer, so one can be resubmitted while the other fills
+#define USB_CMD_ADAPTIVE_SPARE_XFR_COUNT 2        // Transfers kept beyond those covering the longest service gap
+#define USB_CMD_ADAPTIVE_SHRINK_WINDOWS 5         // Consecutive windows with spare transfers before shrinking
+#define USB_CMD_STATS_WINDOW_USEC 1000000         // Period of the receive rate and of adaptive decisions
+
+// In place stream recovery, disabled with K4A_LIBUSB_RECOVERY=0
+#define USB_CMD_RECOVERY_MAX_ATTEMPTS 3 // Recoveries without a completed transfer before the error is reported
+#define USB_CMD_RECOVERY_DRAIN_TRIES 3  // Event timeouts to wait for the cancelled transfers of the endpoint
 
 #define USB_CMD_EVENT_WAIT_TIME 1
 #define USB_MAX_TX_DATA 128
@@ -61,12 +77,94 @@ extern "C" {
 #define USB_CMD_IMU_STREAM_ENDPOINT 0x82
 
 //************************ Typedefs *****************************
+typedef struct _usb_command_header_t
+{
+    uint32_t packet_type;
+    uint32_t packet_transaction_id;
+    uint32_t payload_size;
+    uint32_t command;
+    uint32_t reserved; // Must be zero
+} usb_command_header_t;
+
+typedef struct _usb_command_packet_t
+{
+    usb_command_header_t header;
+    uint8_t data[USB_MAX_TX_DATA];
+} usb_command_packet_t;
+
+/////////////////////////////////////////////////////
+// This is the response structure going to the host.
+/////////////////////////////////////////////////////
+
+typedef struct _usb_command_response_t
+{
+    uint32_t packet_type;
+    uint32_t packet_transaction_id;
+    uint32_t status;
+    uint32_t reserved; // Will be zero
+} usb_command_response_t;
+
+// Keeps the device handle open while transfer buffers mapped from it with libusb_dev_mem_alloc are in use. The usbcmd
+// instance holds one reference and every pool of mapped buffers holds one; usb_cmd_destroy hands the handle over and
+// the last reference closes it, so images still held by the application never outlive the mapping's device.
+typedef struct _usb_dev_mem_owner_t
+{
+    volatile long ref_count;
+    libusb_device_handle *libusb;
+    libusb_context *libusb_context;
+    bool owns_handle; // Set by usb_cmd_destroy, the last reference closes the handle and exits the context
+} usb_dev_mem_owner_t;
+
+// Fixed set of page aligned, pre-faulted buffers that streaming transfers are recycled through. The pool is
+// reference counted: the stream thread holds one reference and every buffer lent out as a k4a_image_t holds one, so
+// the pool outlives the stream when an image is still in use after streaming stops.
+//
+// In zero copy mode each transfer is permanently bound to one buffer of the pool. The completed transfer's memory is
+// handed to the stream callback as the image and the transfer is only resubmitted once that image is released.
+typedef struct _usb_xfr_buffer_pool_t
+{
+    LOCK_HANDLE lock;
+    volatile long ref_count;
+
+    bool zero_copy;
+    bool stream_active; // Zero copy mode only; cleared under lock when the stream thread stops resubmitting
+    uint32_t generation; // Bumped under lock when the stream is recovered, older transfers are not resubmitted
+    usb_dev_mem_owner_t *dev_mem_owner; // Set if the buffers are mapped from the device with libusb_dev_mem_alloc
+
+    size_t buffer_size;
+    uint32_t buffer_count;
+    uint32_t free_count;
+    uint8_t *buffers[USB_CMD_XFR_POOL_MAX_COUNT];   // Every buffer owned by the pool
+    uint8_t *free_list[USB_CMD_XFR_POOL_MAX_COUNT]; // Buffers not currently lent out as an image
+} usb_xfr_buffer_pool_t;
+
+// Physical location of a device on the USB bus, stable for as long as the device stays plugged into the same port
+typedef struct _usb_cmd_device_location_t
+{
+    uint16_t pid;
+    uint8_t bus;
+    uint8_t port_count;
+    uint8_t port_path[USB_CMD_PORT_DEPTH];
+} usb_cmd_device_location_t;
+
+// Container ID last read from the device at a location. Finding a device by container ID otherwise requires opening
+// every attached device to read its BOS descriptor.
+typedef struct _usb_cmd_cached_device_t
+{
+    usb_cmd_device_location_t location;
+    guid_t container_id;
+} usb_cmd_cached_device_t;
+
 typedef struct _usb_async_transfer_data_t
 {
     struct _usbcmd_context_t *usbcmd;
     struct libusb_transfer *bulk_transfer;
     k4a_image_t image;
     uint32_t list_index;
+    usb_xfr_buffer_pool_t *pool; // Zero copy mode only; pool owning the buffer bound to this transfer
+    bool held;                   // Zero copy mode only; the buffer is lent out as an image and is not submitted
+    uint32_t generation;         // Zero copy mode only; pool generation the transfer was allocated in
+    uint64_t submit_usec;        // When the transfer was last submitted, for the latency histogram
 } usb_async_transfer_data_t;
 
 typedef struct _usbcmd_context_t
@@ -88,14 +186,48 @@ typedef struct _usbcmd_context_t
 
     unsigned char serial_number[MAX_SERIAL_NUMBER_LENGTH];
     guid_t container_id;
+    int numa_node; // NUMA node of the USB controller, -1 when unknown
 
     usb_cmd_stream_cb_t *callback;
     void *stream_context;
     bool stream_going;
     usb_async_transfer_data_t *transfer_list[USB_CMD_MAX_XFR_COUNT];
     size_t stream_size;
+    usb_xfr_buffer_pool_t *buffer_pool;
+    usb_dev_mem_owner_t *dev_mem_owner; // Created by the first stream that maps its buffers from the device
     LOCK_HANDLE lock;
     THREAD_HANDLE stream_handle;
+
+    // Set under lock while the transfers of a command batch are in flight on the command endpoints. Synchronous
+    // commands and other batches wait on batch_done_condition until the batch completes.
+    bool batch_in_flight;
+    COND_HANDLE batch_done_condition;
+
+    // Stream telemetry. Written from libusb callbacks and image release, read by usb_cmd_get_stream_stats().
+    LOCK_HANDLE stats_lock;
+    k4a_usb_stream_stats_t stats;
+
+    // Measurement window and adaptive transfer count. Only accessed from the stream thread, which runs the libusb
+    // callbacks of copy mode.
+    bool adaptive;
+    uint32_t xfr_count;   // Transfers allocated in transfer_list
+    uint32_t xfr_target;  // Transfers to keep allocated and submitted
+    uint32_t xfr_limit;   // Upper bound from the memory budget, lowered when a submission fails
+    uint64_t window_start_usec;
+    uint64_t window_bytes;
+    uint64_t window_completions;
+    uint64_t window_max_gap_usec; // Longest time between two consecutive completions
+    uint64_t window_timeouts;        // stats.timed_out_transfers when the window started
+    uint64_t window_submit_failures; // stats.resubmit_failures when the window started
+    uint64_t last_completion_usec;
+    uint32_t spare_windows; // Consecutive windows that needed fewer transfers than xfr_target
+
+    // In place recovery after a transfer error. Only accessed from the stream thread.
+    bool recovery;              // Reset the endpoint and resubmit the transfers instead of ending the stream
+    bool recover_pending;       // A transfer failed, the stream thread recovers once the callbacks return
+    bool recovering;            // Transfers completing now are released instead of resubmitted
+    bool refill_pending;        // Some slots below xfr_target could not be given a transfer again
+    uint32_t recovery_attempts; // Recoveries since the last completed transfer
 } usbcmd_context_t;
 
 K4A_DECLARE_CONTEXT(usbcmd_t, usbcmd_context_t);
@@ -104,6 +236,16 @@ K4A_DECLARE_CONTEXT(usbcmd_t, usbcmd_context_t);
 
 //******************* Function Prototypes ***********************
 void LIBUSB_CALL usb_cmd_libusb_cb(struct libusb_transfer *bulk_transfer);
+void LIBUSB_CALL usb_cmd_libusb_zero_copy_cb(struct libusb_transfer *bulk_transfer);
+void usb_dev_mem_owner_dec_ref(usb_dev_mem_owner_t *owner);
+k4a_result_t usb_cmd_wait_for_batch(usbcmd_context_t *usbcmd);
+k4a_result_t usb_cmd_count_devices(libusb_context *libusb_ctx, uint32_t *p_device_count);
+bool usb_cmd_hotplug_get_device_count(uint32_t *p_device_count);
+k4a_result_t usb_cmd_check_response(uint32_t cmd,
+                                    const usb_command_response_t *response_packet,
+                                    int rx_size,
+                                    uint32_t transaction_id,
+                                    uint32_t *cmd_status);
 
 #ifdef __cplusplus
 }
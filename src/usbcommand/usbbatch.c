@@ -0,0 +1,504 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+//************************ Includes *****************************
+// This library
+#include <k4ainternal/usbcommand.h>
+#include "usb_cmd_priv.h"
+
+// System dependencies
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+//**************Symbolic Constant Macros (defines)  *************
+
+//************************ Typedefs *****************************
+// Transfers of one command, submitted in this order. Transfers on the same endpoint complete in submission order, so
+// the command and data sent to the device and the data and status read back stay paired without a round trip.
+typedef enum
+{
+    USB_CMD_BATCH_STAGE_COMMAND = 0,
+    USB_CMD_BATCH_STAGE_DATA_OUT,
+    USB_CMD_BATCH_STAGE_DATA_IN,
+    USB_CMD_BATCH_STAGE_STATUS,
+
+    USB_CMD_BATCH_STAGE_COUNT
+} usb_cmd_batch_stage_t;
+
+typedef struct _usb_cmd_batch_entry_t
+{
+    usb_command_packet_t packet;
+    size_t cmd_data_size;
+    uint8_t *p_rx_data;
+    uint8_t *p_tx_data;
+    size_t payload_size;
+    size_t *transfer_count;
+    uint32_t *cmd_status; // NULL if a nonzero status fails the batch
+    usb_command_response_t response;
+
+    struct libusb_transfer *transfers[USB_CMD_BATCH_STAGE_COUNT]; // NULL for stages the command doesn't have
+    bool in_flight[USB_CMD_BATCH_STAGE_COUNT];
+} usb_cmd_batch_entry_t;
+
+typedef struct _usb_cmd_batch_context_t
+{
+    usbcmd_context_t *usbcmd;
+
+    uint32_t command_count;
+    usb_cmd_batch_entry_t commands[USB_CMD_BATCH_MAX_COMMANDS];
+    bool submitted; // Set from usb_cmd_batch_submit until usb_cmd_batch_wait, the device is reserved for the batch
+
+    // Written from the libusb callbacks, which may run on the stream thread of the device
+    LOCK_HANDLE lock;
+    uint32_t pending_count; // Transfers submitted and not yet completed
+    bool all_submitted;     // No more transfers will be submitted, the last completion completes the batch
+    bool failed;            // A transfer did not complete, the remaining ones are cancelled
+    int completed;          // Passed to libusb_handle_events_completed
+} usb_cmd_batch_context_t;
+
+K4A_DECLARE_CONTEXT(usb_cmd_batch_t, usb_cmd_batch_context_t);
+
+//************ Declarations (Statics and globals) ***************
+
+//******************* Function Prototypes ***********************
+
+//*********************** Functions *****************************
+
+k4a_result_t usb_cmd_batch_create(usbcmd_t usbcmd_handle, usb_cmd_batch_t *batch_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usbcmd_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, batch_handle == NULL);
+
+    usb_cmd_batch_context_t *batch;
+    k4a_result_t result = K4A_RESULT_FROM_BOOL((batch = usb_cmd_batch_t_create(batch_handle)) != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        batch->usbcmd = usbcmd_t_get_context(usbcmd_handle);
+        result = K4A_RESULT_FROM_BOOL((batch->lock = Lock_Init()) != NULL);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        usb_cmd_batch_destroy(*batch_handle);
+        *batch_handle = NULL;
+    }
+
+    return result;
+}
+
+void usb_cmd_batch_destroy(usb_cmd_batch_t batch_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, usb_cmd_batch_t, batch_handle);
+    usb_cmd_batch_context_t *batch = usb_cmd_batch_t_get_context(batch_handle);
+
+    if (batch->submitted)
+    {
+        // Transfers still in flight point into the batch
+        (void)usb_cmd_batch_wait(batch_handle);
+    }
+
+    if (batch->lock)
+    {
+        Lock_Deinit(batch->lock);
+        batch->lock = NULL;
+    }
+
+    usb_cmd_batch_t_destroy(batch_handle);
+}
+
+static k4a_result_t usb_cmd_batch_add(usb_cmd_batch_t batch_handle,
+                                      uint32_t cmd,
+                                      uint8_t *p_cmd_data,
+                                      size_t cmd_data_size,
+                                      uint8_t *p_rx_data,
+                                      size_t rx_data_size,
+                                      uint8_t *p_tx_data,
+                                      size_t tx_data_size,
+                                      size_t *transfer_count,
+                                      uint32_t *cmd_status)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usb_cmd_batch_t, batch_handle);
+    usb_cmd_batch_context_t *batch = usb_cmd_batch_t_get_context(batch_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, batch->submitted);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, batch->command_count >= USB_CMD_BATCH_MAX_COMMANDS);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cmd_data_size > USB_MAX_TX_DATA);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cmd_data_size > 0 && p_cmd_data == NULL);
+
+    size_t payload_size = (rx_data_size == 0 ? tx_data_size : rx_data_size);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, payload_size > INT32_MAX);
+
+    usb_cmd_batch_entry_t *entry = &batch->commands[batch->command_count++];
+    memset(entry, 0, sizeof(*entry));
+
+    entry->packet.header.command = cmd;
+    entry->packet.header.packet_type = USB_CMD_PACKET_TYPE;
+    entry->packet.header.payload_size = (uint32_t)payload_size;
+    entry->packet.header.reserved = 0;
+    if (cmd_data_size > 0)
+    {
+        memcpy(entry->packet.data, p_cmd_data, cmd_data_size);
+    }
+    entry->cmd_data_size = cmd_data_size;
+    entry->p_rx_data = p_rx_data;
+    entry->p_tx_data = p_tx_data;
+    entry->payload_size = payload_size;
+    entry->transfer_count = transfer_count;
+    entry->cmd_status = cmd_status;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t usb_cmd_batch_add_read(usb_cmd_batch_t batch_handle,
+                                    uint32_t cmd,
+                                    uint8_t *p_cmd_data,
+                                    size_t cmd_data_size,
+                                    uint8_t *p_data,
+                                    size_t data_size,
+                                    size_t *bytes_read,
+                                    uint32_t *cmd_status)
+{
+    return TRACE_CALL(usb_cmd_batch_add(
+        batch_handle, cmd, p_cmd_data, cmd_data_size, p_data, data_size, NULL, 0, bytes_read, cmd_status));
+}
+
+k4a_result_t usb_cmd_batch_add_write(usb_cmd_batch_t batch_handle,
+                                     uint32_t cmd,
+                                     uint8_t *p_cmd_data,
+                                     size_t cmd_data_size,
+                                     uint8_t *p_data,
+                                     size_t data_size,
+                                     uint32_t *cmd_status)
+{
+    return TRACE_CALL(
+        usb_cmd_batch_add(batch_handle, cmd, p_cmd_data, cmd_data_size, NULL, 0, p_data, data_size, NULL, cmd_status));
+}
+
+// Cancels every transfer of the batch still in flight. Called with batch->lock held.
+static void usb_cmd_batch_cancel(usb_cmd_batch_context_t *batch)
+{
+    for (uint32_t i = 0; i < batch->command_count; i++)
+    {
+        for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT; stage++)
+        {
+            if (batch->commands[i].in_flight[stage])
+            {
+                (void)libusb_cancel_transfer(batch->commands[i].transfers[stage]);
+            }
+        }
+    }
+}
+
+static void LIBUSB_CALL usb_cmd_batch_libusb_cb(struct libusb_transfer *transfer)
+{
+    usb_cmd_batch_context_t *batch = (usb_cmd_batch_context_t *)transfer->user_data;
+
+    Lock(batch->lock);
+    for (uint32_t i = 0; i < batch->command_count; i++)
+    {
+        for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT; stage++)
+        {
+            if (batch->commands[i].transfers[stage] == transfer)
+            {
+                batch->commands[i].in_flight[stage] = false;
+            }
+        }
+    }
+
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED && !batch->failed)
+    {
+        // The transfers queued behind this one would be paired with the wrong command
+        batch->failed = true;
+        usb_cmd_batch_cancel(batch);
+    }
+
+    batch->pending_count--;
+    if (batch->pending_count == 0 && batch->all_submitted)
+    {
+        batch->completed = 1;
+    }
+    Unlock(batch->lock);
+}
+
+// Fills and submits one transfer of a command, the batch counts it as pending until its callback runs
+static k4a_result_t usb_cmd_batch_submit_transfer(usb_cmd_batch_context_t *batch,
+                                                  usb_cmd_batch_entry_t *entry,
+                                                  usb_cmd_batch_stage_t stage,
+                                                  uint8_t endpoint,
+                                                  uint8_t *buffer,
+                                                  int length,
+                                                  unsigned int timeout)
+{
+    usbcmd_context_t *usbcmd = batch->usbcmd;
+    struct libusb_transfer *transfer = entry->transfers[stage];
+    int err;
+
+    libusb_fill_bulk_transfer(
+        transfer, usbcmd->libusb, endpoint, buffer, length, usb_cmd_batch_libusb_cb, batch, timeout);
+
+    Lock(batch->lock);
+    batch->pending_count++;
+    entry->in_flight[stage] = true;
+    if ((err = libusb_submit_transfer(transfer)) != LIBUSB_SUCCESS)
+    {
+        batch->pending_count--;
+        entry->in_flight[stage] = false;
+        LOG_ERROR("Error calling libusb_submit_transfer for command %08X, result:%s",
+                  entry->packet.header.command,
+                  libusb_error_name(err));
+    }
+    Unlock(batch->lock);
+
+    return K4A_RESULT_FROM_BOOL(err == LIBUSB_SUCCESS);
+}
+
+k4a_result_t usb_cmd_batch_submit(usb_cmd_batch_t batch_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usb_cmd_batch_t, batch_handle);
+    usb_cmd_batch_context_t *batch = usb_cmd_batch_t_get_context(batch_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, batch->submitted);
+
+    usbcmd_context_t *usbcmd = batch->usbcmd;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    batch->pending_count = 0;
+    batch->all_submitted = false;
+    batch->failed = false;
+    batch->completed = 0;
+
+    // Allocate every transfer up front, so a failure leaves nothing in flight
+    for (uint32_t i = 0; i < batch->command_count && K4A_SUCCEEDED(result); i++)
+    {
+        usb_cmd_batch_entry_t *entry = &batch->commands[i];
+        bool has_stage[USB_CMD_BATCH_STAGE_COUNT] = { true, entry->p_tx_data != NULL, entry->p_rx_data != NULL, true };
+        for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT && K4A_SUCCEEDED(result); stage++)
+        {
+            if (has_stage[stage])
+            {
+                result = K4A_RESULT_FROM_BOOL((entry->transfers[stage] = libusb_alloc_transfer(0)) != NULL);
+            }
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        Lock(usbcmd->lock);
+        result = TRACE_CALL(usb_cmd_wait_for_batch(usbcmd));
+        if (K4A_SUCCEEDED(result))
+        {
+            usbcmd->batch_in_flight = true;
+            batch->submitted = true;
+        }
+
+        for (uint32_t i = 0; i < batch->command_count && K4A_SUCCEEDED(result); i++)
+        {
+            usb_cmd_batch_entry_t *entry = &batch->commands[i];
+            int payload_size = (int)entry->payload_size;
+
+            // Timeouts start at submission, commands later in the batch also wait for the ones ahead of them
+            unsigned int timeout = USB_CMD_MAX_WAIT_TIME * (i + 1);
+
+            entry->packet.header.packet_transaction_id = usbcmd->transaction_id++;
+            LOG_TRACE("XFR: Batched Cmd=%08x, CmdLength=%zu, PayloadSize=%zu",
+                      entry->packet.header.command,
+                      entry->cmd_data_size,
+                      entry->payload_size);
+
+            result = usb_cmd_batch_submit_transfer(batch,
+                                                   entry,
+                                                   USB_CMD_BATCH_STAGE_COMMAND,
+                                                   usbcmd->cmd_tx_endpoint,
+                                                   (uint8_t *)&entry->packet,
+                                                   (int)(sizeof(usb_command_header_t) + entry->cmd_data_size),
+                                                   timeout);
+
+            if (K4A_SUCCEEDED(result) && entry->p_tx_data != NULL)
+            {
+                result = usb_cmd_batch_submit_transfer(batch,
+                                                       entry,
+                                                       USB_CMD_BATCH_STAGE_DATA_OUT,
+                                                       usbcmd->cmd_tx_endpoint,
+                                                       entry->p_tx_data,
+                                                       payload_size,
+                                                       timeout);
+            }
+
+            if (K4A_SUCCEEDED(result) && entry->p_rx_data != NULL)
+            {
+                result = usb_cmd_batch_submit_transfer(batch,
+                                                       entry,
+                                                       USB_CMD_BATCH_STAGE_DATA_IN,
+                                                       usbcmd->cmd_rx_endpoint,
+                                                       entry->p_rx_data,
+                                                       payload_size,
+                                                       timeout);
+            }
+
+            if (K4A_SUCCEEDED(result))
+            {
+                result = usb_cmd_batch_submit_transfer(batch,
+                                                       entry,
+                                                       USB_CMD_BATCH_STAGE_STATUS,
+                                                       usbcmd->cmd_rx_endpoint,
+                                                       (uint8_t *)&entry->response,
+                                                       (int)sizeof(entry->response),
+                                                       timeout);
+            }
+        }
+        Unlock(usbcmd->lock);
+    }
+
+    Lock(batch->lock);
+    if (K4A_FAILED(result))
+    {
+        batch->failed = true;
+        usb_cmd_batch_cancel(batch);
+    }
+    batch->all_submitted = true;
+    if (batch->pending_count == 0)
+    {
+        batch->completed = 1;
+    }
+    Unlock(batch->lock);
+
+    if (K4A_FAILED(result) && batch->submitted)
+    {
+        // Drain whatever was submitted and release the device
+        (void)usb_cmd_batch_wait(batch_handle);
+    }
+    else if (K4A_FAILED(result))
+    {
+        for (uint32_t i = 0; i < batch->command_count; i++)
+        {
+            for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT; stage++)
+            {
+                libusb_free_transfer(batch->commands[i].transfers[stage]);
+                batch->commands[i].transfers[stage] = NULL;
+            }
+        }
+        batch->command_count = 0;
+    }
+
+    return result;
+}
+
+// Checks the transfers of a completed command, in the same way usb_cmd_io checks each stage
+static k4a_result_t usb_cmd_batch_entry_result(usb_cmd_batch_entry_t *entry)
+{
+    static const char *stage_names[USB_CMD_BATCH_STAGE_COUNT] = { "initial tx", "tx", "rx", "status" };
+    uint32_t cmd = entry->packet.header.command;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    uint32_t status = 0;
+
+    for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT && K4A_SUCCEEDED(result); stage++)
+    {
+        struct libusb_transfer *transfer = entry->transfers[stage];
+        if (transfer != NULL && transfer->status != LIBUSB_TRANSFER_COMPLETED)
+        {
+            // Transfers cancelled after an earlier failure were already reported
+            if (transfer->status != LIBUSB_TRANSFER_CANCELLED)
+            {
+                LOG_ERROR("Command(%08X) %s transfer ended in failure, transfer status:%d",
+                          cmd,
+                          stage_names[stage],
+                          transfer->status);
+            }
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (entry->transfer_count != NULL)
+    {
+        struct libusb_transfer *transfer = entry->transfers[USB_CMD_BATCH_STAGE_DATA_IN];
+        *entry->transfer_count = (K4A_SUCCEEDED(result) && transfer != NULL) ? (size_t)transfer->actual_length : 0;
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = usb_cmd_check_response(cmd,
+                                        &entry->response,
+                                        entry->transfers[USB_CMD_BATCH_STAGE_STATUS]->actual_length,
+                                        entry->packet.header.packet_transaction_id,
+                                        &status);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        if (entry->cmd_status != NULL)
+        {
+            *entry->cmd_status = status;
+        }
+        else if (status != 0)
+        {
+            LOG_ERROR("Batched command(%08X) ended in failure, Command status 0x%08x", cmd, status);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    return result;
+}
+
+k4a_result_t usb_cmd_batch_wait(usb_cmd_batch_t batch_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usb_cmd_batch_t, batch_handle);
+    usb_cmd_batch_context_t *batch = usb_cmd_batch_t_get_context(batch_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !batch->submitted);
+
+    usbcmd_context_t *usbcmd = batch->usbcmd;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    // Every transfer has a timeout, so the batch always completes. When the stream thread of the device is handling
+    // events this waits for it to run the callbacks.
+    while (!batch->completed)
+    {
+        int err = libusb_handle_events_completed(usbcmd->libusb_context, &batch->completed);
+        if (err < 0 && err != LIBUSB_ERROR_INTERRUPTED)
+        {
+            LOG_ERROR("Error calling libusb_handle_events_completed, result:%s", libusb_error_name(err));
+            Lock(batch->lock);
+            if (!batch->failed)
+            {
+                batch->failed = true;
+                usb_cmd_batch_cancel(batch);
+            }
+            Unlock(batch->lock);
+        }
+    }
+
+    for (uint32_t i = 0; i < batch->command_count; i++)
+    {
+        usb_cmd_batch_entry_t *entry = &batch->commands[i];
+        if (K4A_FAILED(usb_cmd_batch_entry_result(entry)))
+        {
+            result = K4A_RESULT_FAILED;
+        }
+
+        for (int stage = 0; stage < USB_CMD_BATCH_STAGE_COUNT; stage++)
+        {
+            libusb_free_transfer(entry->transfers[stage]);
+            entry->transfers[stage] = NULL;
+        }
+    }
+    batch->command_count = 0;
+    batch->submitted = false;
+
+    Lock(usbcmd->lock);
+    usbcmd->batch_in_flight = false;
+    Condition_Post(usbcmd->batch_done_condition);
+    Unlock(usbcmd->lock);
+
+    return result;
+}
+
+k4a_result_t usb_cmd_batch_execute(usb_cmd_batch_t batch_handle)
+{
+    k4a_result_t result = TRACE_CALL(usb_cmd_batch_submit(batch_handle));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(usb_cmd_batch_wait(batch_handle));
+    }
+
+    return result;
+}
@@ -6,6 +6,10 @@
 // This library
 #include "usb_cmd_priv.h"
 
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/rwlock.h>
+
 // System dependencies
 #include <stdlib.h>
 #include <string.h>
@@ -39,33 +43,6 @@ TraceLibUsbError(int err, const char *szCall, const char *szFile, int line, cons
 //**************Symbolic Constant Macros (defines)  *************
 
 //************************ Typedefs *****************************
-typedef struct _usb_command_header_t
-{
-    uint32_t packet_type;
-    uint32_t packet_transaction_id;
-    uint32_t payload_size;
-    uint32_t command;
-    uint32_t reserved; // Must be zero
-} usb_command_header_t;
-
-typedef struct _usb_command_packet_t
-{
-    usb_command_header_t header;
-    uint8_t data[USB_MAX_TX_DATA];
-} usb_command_packet_t;
-
-/////////////////////////////////////////////////////
-// This is the response structure going to the host.
-/////////////////////////////////////////////////////
-
-typedef struct _usb_command_response_t
-{
-    uint32_t packet_type;
-    uint32_t packet_transaction_id;
-    uint32_t status;
-    uint32_t reserved; // Will be zero
-} usb_command_response_t;
-
 typedef struct _descriptor_choice_t
 {
     uint16_t pid;
@@ -76,12 +53,126 @@ typedef struct _descriptor_choice_t
     usbcmd_context_t **handle_list;
 } descriptor_choice_t;
 
+// Container IDs of the devices opened so far, shared by every usbcmd instance in the process
+typedef struct _usb_cmd_global_t
+{
+    k4a_rwlock_t lock;
+    uint32_t cached_device_count;
+    uint32_t next_replaced_device;
+    usb_cmd_cached_device_t cached_devices[USB_CMD_MAX_CACHED_DEVICES];
+} usb_cmd_global_t;
+
 //************ Declarations (Statics and globals) ***************
 
+static void usb_cmd_global_init(usb_cmd_global_t *global);
+
+// Creates a function called usb_cmd_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(usb_cmd_global_t, usb_cmd_global_init);
+
 //******************* Function Prototypes ***********************
 
 //*********************** Functions *****************************
 
+static void usb_cmd_global_init(usb_cmd_global_t *global)
+{
+    // All other members are initialized to zero
+    rwlock_init(&global->lock);
+}
+
+static bool get_device_location(libusb_device *device, uint16_t pid, usb_cmd_device_location_t *location)
+{
+    memset(location, 0, sizeof(*location));
+    location->pid = pid;
+    location->bus = libusb_get_bus_number(device);
+
+    int port_count = libusb_get_port_numbers(device, location->port_path, (int)sizeof(location->port_path));
+    if (port_count < 0)
+    {
+        // Deeper than USB_CMD_PORT_DEPTH, the device is not cached
+        return false;
+    }
+    location->port_count = (uint8_t)port_count;
+    return true;
+}
+
+// Returns the NUMA node of the USB controller a device is connected to, -1 when unknown
+static int get_device_numa_node(libusb_device *device)
+{
+    int numa_node = -1;
+#ifdef __linux__
+    // The root hub of each bus is a child of its host controller, which reports the node it is attached to
+    char path[64];
+    snprintf(path,
+             sizeof(path),
+             "/sys/bus/usb/devices/usb%u/../numa_node",
+             (unsigned int)libusb_get_bus_number(device));
+    FILE *file = fopen(path, "r");
+    if (file != NULL)
+    {
+        if (fscanf(file, "%d", &numa_node) != 1)
+        {
+            numa_node = -1;
+        }
+        fclose(file);
+    }
+#else
+    (void)device;
+#endif
+    return numa_node;
+}
+
+static bool get_cached_container_id(const usb_cmd_device_location_t *location, guid_t *container_id)
+{
+    usb_cmd_global_t *global = usb_cmd_global_t_get();
+    bool found = false;
+
+    rwlock_acquire_read(&global->lock);
+    for (uint32_t i = 0; i < global->cached_device_count && found == false; i++)
+    {
+        if (memcmp(&global->cached_devices[i].location, location, sizeof(*location)) == 0)
+        {
+            *container_id = global->cached_devices[i].container_id;
+            found = true;
+        }
+    }
+    rwlock_release_read(&global->lock);
+
+    return found;
+}
+
+static void set_cached_container_id(const usb_cmd_device_location_t *location, const guid_t *container_id)
+{
+    usb_cmd_global_t *global = usb_cmd_global_t_get();
+    uint32_t i;
+
+    rwlock_acquire_write(&global->lock);
+    for (i = 0; i < global->cached_device_count; i++)
+    {
+        if (memcmp(&global->cached_devices[i].location, location, sizeof(*location)) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i == global->cached_device_count)
+    {
+        if (global->cached_device_count < USB_CMD_MAX_CACHED_DEVICES)
+        {
+            global->cached_device_count++;
+        }
+        else
+        {
+            // Cache is full, replace the entries in the order they were added
+            i = global->next_replaced_device;
+            global->next_replaced_device = (global->next_replaced_device + 1) % USB_CMD_MAX_CACHED_DEVICES;
+        }
+    }
+
+    global->cached_devices[i].location = *location;
+    global->cached_devices[i].container_id = *container_id;
+    rwlock_release_write(&global->lock);
+}
+
 #define UUID_STR_LENGTH sizeof("{00000000-0000-0000-0000-000000000000}")
 static void uuid_to_string(const guid_t *guid, char *string, size_t string_size)
 {
@@ -238,6 +329,8 @@ static k4a_result_t find_libusb_device(uint32_t device_index,
     bool found = false;
     int open_attempts = 0;
     int access_denied = 0;
+    bool skipped_cached = false;
+    usb_cmd_device_location_t location;
 
     // Initialize library
     result = K4A_RESULT_FROM_LIBUSB(libusb_init(&usbcmd->libusb_context));
@@ -263,75 +356,101 @@ static k4a_result_t find_libusb_device(uint32_t device_index,
 
     if (K4A_SUCCEEDED(result))
     {
-        // Traverse list looking for sensor matches
-        uint8_t list_index = 0;
-        for (int loop = 0; loop < count && found == false; loop++)
+        // The first pass does not open devices whose cached container ID is not the one we are looking for. A second
+        // pass opening every device is only needed if one of those skipped devices was replaced since it was cached.
+        for (int pass = 0; pass < 2 && found == false && (pass == 0 || skipped_cached); pass++)
         {
-            found = false;
-            result = K4A_RESULT_FROM_LIBUSB(libusb_get_device_descriptor(dev_list[loop], desc));
-
-            if (K4A_SUCCEEDED(result))
+            // Traverse list looking for sensor matches
+            uint8_t list_index = 0;
+            for (int loop = 0; loop < count && found == false; loop++)
             {
-                // Check if this is our device and correlates to the index number based on discovery order
-                if ((desc->idVendor != K4A_MSFT_VID) || (desc->idProduct != usbcmd->pid) ||
-                    ((device_index != list_index++) && container_id == NULL))
+                found = false;
+                result = K4A_RESULT_FROM_LIBUSB(libusb_get_device_descriptor(dev_list[loop], desc));
+
+                if (K4A_SUCCEEDED(result))
                 {
-                    continue;
+                    // Check if this is our device and correlates to the index number based on discovery order
+                    if ((desc->idVendor != K4A_MSFT_VID) || (desc->idProduct != usbcmd->pid) ||
+                        ((device_index != list_index++) && container_id == NULL))
+                    {
+                        continue;
+                    }
                 }
-            }
 
-            usbcmd->libusb = NULL;
-            if (K4A_SUCCEEDED(result))
-            {
-                open_attempts++;
-                int result_libusb;
+                bool location_known = get_device_location(dev_list[loop], usbcmd->pid, &location);
+                if (K4A_SUCCEEDED(result) && container_id != NULL && pass == 0 && location_known)
                 {
-                    // LIBUSB (on Windows) will generate ERROR messages when open is called and the device has already
-                    // been opened, which we need to do to get the serial number.
-                    libusb_logging_disable(usbcmd->libusb_context);
-                    result_libusb = libusb_open(dev_list[loop], &usbcmd->libusb);
-                    libusb_logging_restore(usbcmd->libusb_context, usbcmd->libusb_verbosity);
+                    guid_t cached_container_id;
+                    if (get_cached_container_id(&location, &cached_container_id) &&
+                        memcmp(container_id, &cached_container_id, sizeof(*container_id)) != 0)
+                    {
+                        skipped_cached = true;
+                        continue;
+                    }
                 }
-                if (LIBUSB_ERROR_ACCESS == result_libusb)
+
+                usbcmd->libusb = NULL;
+                if (K4A_SUCCEEDED(result))
                 {
-                    access_denied++;
+                    open_attempts++;
+                    int result_libusb;
+                    {
+                        // LIBUSB (on Windows) will generate ERROR messages when open is called and the device has
+                        // already been opened, which we need to do to get the serial number.
+                        libusb_logging_disable(usbcmd->libusb_context);
+                        result_libusb = libusb_open(dev_list[loop], &usbcmd->libusb);
+                        libusb_logging_restore(usbcmd->libusb_context, usbcmd->libusb_verbosity);
+                    }
+                    if (LIBUSB_ERROR_ACCESS == result_libusb)
+                    {
+                        access_denied++;
+                    }
+                    if (result_libusb < LIBUSB_SUCCESS)
+                    {
+                        continue; // Device is already open
+                    }
                 }
-                if (result_libusb < LIBUSB_SUCCESS)
+
+                if (K4A_SUCCEEDED(result))
                 {
-                    continue; // Device is already open
+                    result = populate_container_id(usbcmd);
                 }
-            }
 
-            if (K4A_SUCCEEDED(result))
-            {
-                result = populate_container_id(usbcmd);
-            }
+                if (K4A_SUCCEEDED(result) && location_known)
+                {
+                    set_cached_container_id(&location, &usbcmd->container_id);
+                }
 
-            if (K4A_SUCCEEDED(result))
-            {
-                if (container_id == NULL)
+                if (K4A_SUCCEEDED(result))
                 {
-                    // We opened the USB handle based on index
-                    found = true;
+                    if (container_id == NULL)
+                    {
+                        // We opened the USB handle based on index
+                        found = true;
+                    }
+                    else if (memcmp(container_id, &usbcmd->container_id, sizeof(*container_id)) == 0)
+                    {
+                        // We have a container ID match
+                        found = true;
+                    }
+                    else
+                    {
+                        char container_id_string[UUID_STR_LENGTH];
+                        uuid_to_string(&usbcmd->container_id, container_id_string, sizeof(container_id_string));
+                        LOG_INFO("Found non matching Container ID: %s ", container_id_string);
+                    }
                 }
-                else if (memcmp(container_id, &usbcmd->container_id, sizeof(*container_id)) == 0)
+
+                if (found)
                 {
-                    // We have a container ID match
-                    found = true;
+                    usbcmd->numa_node = get_device_numa_node(dev_list[loop]);
                 }
-                else
+                if (!found)
                 {
-                    char container_id_string[UUID_STR_LENGTH];
-                    uuid_to_string(&usbcmd->container_id, container_id_string, sizeof(container_id_string));
-                    LOG_INFO("Found non matching Container ID: %s ", container_id_string);
+                    libusb_close(usbcmd->libusb);
+                    usbcmd->libusb = NULL;
                 }
             }
-
-            if (!found)
-            {
-                libusb_close(usbcmd->libusb);
-                usbcmd->libusb = NULL;
-            }
         }
     }
 
@@ -396,9 +515,20 @@ k4a_result_t usb_cmd_create(usb_command_device_type_t device_type,
     if (K4A_SUCCEEDED(result))
     {
         usbcmd->stream_going = false;
+        usbcmd->numa_node = -1;
         result = K4A_RESULT_FROM_BOOL((usbcmd->lock = Lock_Init()) != NULL);
     }
 
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL((usbcmd->stats_lock = Lock_Init()) != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = K4A_RESULT_FROM_BOOL((usbcmd->batch_done_condition = Condition_Init()) != NULL);
+    }
+
     if (K4A_SUCCEEDED(result))
     {
         if (device_type == USB_DEVICE_DEPTH_PROCESSOR)
@@ -486,6 +616,10 @@ void usb_cmd_destroy(usbcmd_t usbcmd_handle)
     {
         // Wait for any outstanding commands to process
         Lock(usbcmd->lock);
+        if (usbcmd->batch_done_condition)
+        {
+            (void)usb_cmd_wait_for_batch(usbcmd);
+        }
         Unlock(usbcmd->lock);
     }
 
@@ -495,6 +629,16 @@ void usb_cmd_destroy(usbcmd_t usbcmd_handle)
         (void)K4A_RESULT_FROM_LIBUSB(libusb_release_interface(usbcmd->libusb, usbcmd->interface));
     }
 
+    if (usbcmd->dev_mem_owner)
+    {
+        // Transfer buffers mapped from the device may still be held as images, the last of them closes the device
+        usbcmd->dev_mem_owner->owns_handle = true;
+        usb_dev_mem_owner_dec_ref(usbcmd->dev_mem_owner);
+        usbcmd->dev_mem_owner = NULL;
+        usbcmd->libusb = NULL;
+        usbcmd->libusb_context = NULL;
+    }
+
     if (usbcmd->libusb)
     {
         // close the device
@@ -516,6 +660,18 @@ void usb_cmd_destroy(usbcmd_t usbcmd_handle)
         usbcmd->lock = 0;
     }
 
+    if (usbcmd->stats_lock)
+    {
+        Lock_Deinit(usbcmd->stats_lock);
+        usbcmd->stats_lock = 0;
+    }
+
+    if (usbcmd->batch_done_condition)
+    {
+        Condition_Deinit(usbcmd->batch_done_condition);
+        usbcmd->batch_done_condition = NULL;
+    }
+
     // Destroy the allocator
     usbcmd_t_destroy(usbcmd_handle);
 }
@@ -557,6 +713,93 @@ k4a_buffer_result_t usb_cmd_get_serial_number(usbcmd_t usbcmd_handle, char *seri
     return result_b;
 }
 
+/**
+ *  Waits until no command batch is in flight on the command endpoints. Must be called with usbcmd->lock held, which
+ *  is released while waiting.
+ *
+ *  @param usbcmd
+ *   Context of the device
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   The command endpoints are free
+ *   K4A_RESULT_FAILED      Waiting failed
+ *
+ */
+k4a_result_t usb_cmd_wait_for_batch(usbcmd_context_t *usbcmd)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    bool waited = false;
+    while (usbcmd->batch_in_flight && K4A_SUCCEEDED(result))
+    {
+        int infinite_timeout = 0;
+        COND_RESULT cond_result = Condition_Wait(usbcmd->batch_done_condition, usbcmd->lock, infinite_timeout);
+        result = K4A_RESULT_FROM_BOOL(cond_result == COND_OK);
+        waited = true;
+    }
+
+    if (waited)
+    {
+        // The completed batch wakes a single waiter, pass the wake up on to the next one
+        Condition_Post(usbcmd->batch_done_condition);
+    }
+    return result;
+}
+
+/**
+ *  Checks the response packet that ends a command sequence.
+ *
+ *  @param cmd
+ *   Command the response belongs to, for logging
+ *
+ *  @param response_packet
+ *   Response read from the device
+ *
+ *  @param rx_size
+ *   Number of bytes of the response that were read
+ *
+ *  @param transaction_id
+ *   Transaction ID the command was sent with
+ *
+ *  @param cmd_status
+ *   Pointer to hold the returned status of the command operation
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   The response matches the command, cmd_status is set
+ *   K4A_RESULT_FAILED      The response is malformed or belongs to another command
+ *
+ */
+k4a_result_t usb_cmd_check_response(uint32_t cmd,
+                                    const usb_command_response_t *response_packet,
+                                    int rx_size,
+                                    uint32_t transaction_id,
+                                    uint32_t *cmd_status)
+{
+    // Check for errors in response packet. The packet status is checked by the caller in the
+    // success cases, so it shouldn't be checked here.
+    if ((rx_size != sizeof(*response_packet)) || (response_packet->packet_transaction_id != transaction_id) ||
+        (response_packet->packet_type != USB_CMD_PACKET_TYPE_RESPONSE))
+    {
+        LOG_ERROR("Command(%08X) sequence ended in failure, "
+                  "TransactionId %08X == %08X "
+                  "Response size 0x%08X == 0x%08X "
+                  "Packet status 0x%08x == 0x%08x "
+                  "Packet type 0x%08x == 0x%08x",
+                  cmd,
+                  response_packet->packet_transaction_id,
+                  transaction_id,
+                  rx_size,
+                  sizeof(*response_packet),
+                  response_packet->status,
+                  0,
+                  response_packet->packet_type,
+                  USB_CMD_PACKET_TYPE_RESPONSE);
+        return K4A_RESULT_FAILED;
+    }
+
+    *cmd_status = response_packet->status;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 /**
  *  Function to handle a command transaction with a sensor module
  *
@@ -654,6 +897,11 @@ static k4a_result_t usb_cmd_io(usbcmd_t usbcmd_handle,
         }
 
         Lock(usbcmd->lock);
+        if (K4A_FAILED(TRACE_CALL(usb_cmd_wait_for_batch(usbcmd))))
+        {
+            goto exit;
+        }
+
         // format up request and send command
         usb_cmd_pkt.header.command = cmd;
         usb_cmd_pkt.header.packet_type = USB_CMD_PACKET_TYPE;
@@ -711,32 +959,11 @@ static k4a_result_t usb_cmd_io(usbcmd_t usbcmd_handle,
                                             &rx_size,
                                             USB_CMD_MAX_WAIT_TIME)) == LIBUSB_SUCCESS)
             {
-                // Check for errors in response packet. The packet status is checked by the caller in the
-                // success cases, so it shouldn't be checked here.
-                if ((rx_size != sizeof(response_packet)) ||
-                    (response_packet.packet_transaction_id != usb_cmd_pkt.header.packet_transaction_id) ||
-                    (response_packet.packet_type != USB_CMD_PACKET_TYPE_RESPONSE))
-                {
-                    LOG_ERROR("Command(%08X) sequence ended in failure, "
-                              "TransactionId %08X == %08X "
-                              "Response size 0x%08X == 0x%08X "
-                              "Packet status 0x%08x == 0x%08x "
-                              "Packet type 0x%08x == 0x%08x",
-                              cmd,
-                              response_packet.packet_transaction_id,
-                              usb_cmd_pkt.header.packet_transaction_id,
-                              rx_size,
-                              sizeof(response_packet),
-                              response_packet.status,
-                              0,
-                              response_packet.packet_type,
-                              USB_CMD_PACKET_TYPE_RESPONSE);
-                }
-                else
-                {
-                    *cmd_status = response_packet.status;
-                    result = K4A_RESULT_SUCCEEDED;
-                }
+                result = usb_cmd_check_response(cmd,
+                                                &response_packet,
+                                                rx_size,
+                                                usb_cmd_pkt.header.packet_transaction_id,
+                                                cmd_status);
             }
             else
             {
@@ -986,45 +1213,18 @@ k4a_result_t usb_cmd_stream_register_cb(usbcmd_t usbcmd_handle, usb_cmd_stream_c
     return result;
 }
 
-/**
- *  Function to get the number of sensor modules attached
- *
- *  @param p_device_count
- *   Pointer to where the device count will be placed
- *
- *  @return
- *   K4A_RESULT_SUCCEEDED   Operation successful
- *   K4A_RESULT_FAILED      Operation failed
- *
- */
-k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count)
+// Counts the devices attached to a libusb context. The color or depth function of a device may be in a bad state, so
+// both are counted and the larger count is the number of devices.
+k4a_result_t usb_cmd_count_devices(libusb_context *libusb_ctx, uint32_t *p_device_count)
 {
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
     struct libusb_device_descriptor desc;
-    libusb_context *libusb_ctx;
     libusb_device **dev_list; // pointer to pointer of device, used to retrieve a list of devices
     ssize_t count;            // holding number of devices in list
-    int err;
     uint32_t color_device_count = 0;
     uint32_t depth_device_count = 0;
 
-    if (p_device_count == NULL)
-    {
-        LOG_ERROR("Error p_device_count is NULL", 0);
-        return K4A_RESULT_FAILED;
-    }
-
     *p_device_count = 0;
-    // initialize library
-    if ((err = libusb_init(&libusb_ctx)) < 0)
-    {
-        LOG_ERROR("Error calling libusb_init, result:%s", libusb_error_name(err));
-        return K4A_RESULT_FAILED;
-    }
-
-    // We disable all LIBUSB logging for this function, which only used this local context. LIBUSB (on Windows)
-    // generates errors when a device is detached moments before this is called.
-    libusb_logging_disable(libusb_ctx);
 
     count = libusb_get_device_list(libusb_ctx, &dev_list); // get the list of devices
     if (count > INT32_MAX)
@@ -1063,12 +1263,57 @@ k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count)
     // free the list, unref the devices in it
     libusb_free_device_list(dev_list, (int)count);
 
+    *p_device_count = color_device_count > depth_device_count ? color_device_count : depth_device_count;
+
+    return result;
+}
+
+/**
+ *  Function to get the number of sensor modules attached
+ *
+ *  @param p_device_count
+ *   Pointer to where the device count will be placed
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count)
+{
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    libusb_context *libusb_ctx;
+    int err;
+
+    if (p_device_count == NULL)
+    {
+        LOG_ERROR("Error p_device_count is NULL", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // While a hotplug callback is registered, the count is kept up to date by the hotplug monitor
+    if (usb_cmd_hotplug_get_device_count(p_device_count))
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    *p_device_count = 0;
+    // initialize library
+    if ((err = libusb_init(&libusb_ctx)) < 0)
+    {
+        LOG_ERROR("Error calling libusb_init, result:%s", libusb_error_name(err));
+        return K4A_RESULT_FAILED;
+    }
+
+    // We disable all LIBUSB logging for this function, which only used this local context. LIBUSB (on Windows)
+    // generates errors when a device is detached moments before this is called.
+    libusb_logging_disable(libusb_ctx);
+
+    result = usb_cmd_count_devices(libusb_ctx, p_device_count);
+
     // close the instance
     libusb_exit(libusb_ctx);
 
-    // Color or Depth end point my be in a bad state so we cound both and return the larger count
-    *p_device_count = color_device_count > depth_device_count ? color_device_count : depth_device_count;
-
     return result;
 }
 
@@ -0,0 +1,310 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+//************************ Includes *****************************
+
+// This library
+#include "usb_cmd_priv.h"
+
+// Dependent libraries
+#include <k4ainternal/global.h>
+#include <k4ainternal/rwlock.h>
+
+// System dependencies
+#include <stdbool.h>
+
+//**************Symbolic Constant Macros (defines)  *************
+#define USB_CMD_HOTPLUG_EVENT_WAIT_MS 100 // How long the monitor thread waits for events before checking for a stop
+#define USB_CMD_HOTPLUG_POLL_MS 500       // Enumeration period when libusb has no hotplug support
+
+//************************ Typedefs *****************************
+
+// Device count kept up to date by a monitor thread while a hotplug callback is registered
+typedef struct _usb_cmd_hotplug_global_t
+{
+    LOCK_HANDLE register_lock; // Serializes usb_cmd_set_hotplug_callback()
+
+    k4a_rwlock_t lock; // Locks access to monitoring and device_count
+    bool monitoring;   // device_count is kept up to date
+    uint32_t device_count;
+
+    // Only changed while the monitor thread is stopped
+    k4a_device_hotplug_cb_t *callback;
+    void *callback_context;
+    libusb_context *libusb_context;
+    libusb_hotplug_callback_handle hotplug_handle;
+    bool hotplug_registered; // False if libusb has no hotplug support, the devices are enumerated periodically
+    THREAD_HANDLE thread;
+
+    volatile bool stop;
+    bool arrived; // Set by the libusb hotplug callback, which runs on the monitor thread
+    bool left;
+} usb_cmd_hotplug_global_t;
+
+//************ Declarations (Statics and globals) ***************
+
+static void usb_cmd_hotplug_global_init(usb_cmd_hotplug_global_t *global);
+
+// Creates a function called usb_cmd_hotplug_global_t_get() which returns the initialized singleton global
+K4A_DECLARE_GLOBAL(usb_cmd_hotplug_global_t, usb_cmd_hotplug_global_init);
+
+//*********************** Functions *****************************
+
+static void usb_cmd_hotplug_global_init(usb_cmd_hotplug_global_t *global)
+{
+    // All other members are initialized to zero
+    global->register_lock = Lock_Init();
+    rwlock_init(&global->lock);
+}
+
+static int LIBUSB_CALL usb_cmd_hotplug_libusb_cb(libusb_context *context,
+                                                 libusb_device *device,
+                                                 libusb_hotplug_event event,
+                                                 void *user_data)
+{
+    (void)context;
+    usb_cmd_hotplug_global_t *global = (usb_cmd_hotplug_global_t *)user_data;
+    struct libusb_device_descriptor desc;
+
+    // The callback is registered for the Microsoft vendor ID, which other devices share
+    if (libusb_get_device_descriptor(device, &desc) == LIBUSB_SUCCESS &&
+        (desc.idProduct == K4A_RGB_PID || desc.idProduct == K4A_DEPTH_PID))
+    {
+        if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED)
+        {
+            global->arrived = true;
+        }
+        else
+        {
+            global->left = true;
+        }
+    }
+
+    // Stay registered
+    return 0;
+}
+
+// Enumerates the devices again and notifies the callback of the changes seen since the last enumeration
+static void usb_cmd_hotplug_update(usb_cmd_hotplug_global_t *global)
+{
+    uint32_t device_count = 0;
+    if (K4A_FAILED(TRACE_CALL(usb_cmd_count_devices(global->libusb_context, &device_count))))
+    {
+        return;
+    }
+
+    rwlock_acquire_write(&global->lock);
+    uint32_t previous_count = global->device_count;
+    global->device_count = device_count;
+    rwlock_release_write(&global->lock);
+
+    // A device that is unplugged and plugged back in between two enumerations reports both events with the same count
+    bool arrived = global->arrived || device_count > previous_count;
+    bool left = global->left || device_count < previous_count;
+    global->arrived = false;
+    global->left = false;
+
+    if (left)
+    {
+        global->callback(global->callback_context, K4A_DEVICE_HOTPLUG_REMOVED, device_count);
+    }
+    if (arrived)
+    {
+        global->callback(global->callback_context, K4A_DEVICE_HOTPLUG_ARRIVED, device_count);
+    }
+}
+
+static int usb_cmd_hotplug_thread(void *var)
+{
+    usb_cmd_hotplug_global_t *global = (usb_cmd_hotplug_global_t *)var;
+    uint32_t poll_wait_ms = 0;
+
+    while (!global->stop)
+    {
+        bool update = false;
+        if (global->hotplug_registered)
+        {
+            struct timeval timeout = { 0, USB_CMD_HOTPLUG_EVENT_WAIT_MS * 1000 };
+            int err = libusb_handle_events_timeout_completed(global->libusb_context, &timeout, NULL);
+            if (err < 0 && err != LIBUSB_ERROR_INTERRUPTED)
+            {
+                LOG_ERROR("Error calling libusb_handle_events_timeout_completed, result:%s", libusb_error_name(err));
+                ThreadAPI_Sleep(USB_CMD_HOTPLUG_EVENT_WAIT_MS);
+            }
+            update = global->arrived || global->left;
+        }
+        else
+        {
+            ThreadAPI_Sleep(USB_CMD_HOTPLUG_EVENT_WAIT_MS);
+            poll_wait_ms += USB_CMD_HOTPLUG_EVENT_WAIT_MS;
+            update = poll_wait_ms >= USB_CMD_HOTPLUG_POLL_MS;
+        }
+
+        if (update && !global->stop)
+        {
+            poll_wait_ms = 0;
+            usb_cmd_hotplug_update(global);
+        }
+    }
+
+    return 0;
+}
+
+static void usb_cmd_hotplug_stop(usb_cmd_hotplug_global_t *global)
+{
+    if (global->thread == NULL)
+    {
+        return;
+    }
+
+    // Device count queries enumerate the devices again from here on
+    rwlock_acquire_write(&global->lock);
+    global->monitoring = false;
+    rwlock_release_write(&global->lock);
+
+    global->stop = true;
+    ThreadAPI_Join(global->thread, NULL);
+    global->thread = NULL;
+
+    if (global->hotplug_registered)
+    {
+        libusb_hotplug_deregister_callback(global->libusb_context, global->hotplug_handle);
+        global->hotplug_registered = false;
+    }
+    libusb_exit(global->libusb_context);
+    global->libusb_context = NULL;
+    global->callback = NULL;
+    global->callback_context = NULL;
+}
+
+static k4a_result_t usb_cmd_hotplug_start(usb_cmd_hotplug_global_t *global,
+                                          k4a_device_hotplug_cb_t *hotplug_cb,
+                                          void *context)
+{
+    int err = libusb_init(&global->libusb_context);
+    if (err < 0)
+    {
+        LOG_ERROR("Error calling libusb_init, result:%s", libusb_error_name(err));
+        global->libusb_context = NULL;
+        return K4A_RESULT_FAILED;
+    }
+
+    // LIBUSB (on Windows) generates errors when a device is detached while the devices are enumerated.
+    libusb_set_option(global->libusb_context, LIBUSB_OPTION_LOG_LEVEL, LIBUSB_LOG_LEVEL_NONE);
+
+    global->callback = hotplug_cb;
+    global->callback_context = context;
+    global->stop = false;
+    global->arrived = false;
+    global->left = false;
+    global->hotplug_registered = false;
+
+    if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+    {
+        err = libusb_hotplug_register_callback(global->libusb_context,
+                                               LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                               0,
+                                               K4A_MSFT_VID,
+                                               LIBUSB_HOTPLUG_MATCH_ANY,
+                                               LIBUSB_HOTPLUG_MATCH_ANY,
+                                               usb_cmd_hotplug_libusb_cb,
+                                               global,
+                                               &global->hotplug_handle);
+        if (err == LIBUSB_SUCCESS)
+        {
+            global->hotplug_registered = true;
+        }
+        else
+        {
+            LOG_WARNING("Failed to register for hotplug events, devices are enumerated every %dms: %s",
+                        USB_CMD_HOTPLUG_POLL_MS,
+                        libusb_error_name(err));
+        }
+    }
+
+    // Enumerated after registering for events, so a device attached in between is not missed
+    uint32_t device_count = 0;
+    k4a_result_t result = TRACE_CALL(usb_cmd_count_devices(global->libusb_context, &device_count));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        rwlock_acquire_write(&global->lock);
+        global->device_count = device_count;
+        global->monitoring = true;
+        rwlock_release_write(&global->lock);
+
+        if (ThreadAPI_Create(&global->thread, usb_cmd_hotplug_thread, global) != THREADAPI_OK)
+        {
+            LOG_ERROR("Failed to create the hotplug monitor thread", 0);
+            global->thread = NULL;
+            result = K4A_RESULT_FAILED;
+
+            rwlock_acquire_write(&global->lock);
+            global->monitoring = false;
+            rwlock_release_write(&global->lock);
+        }
+    }
+
+    if (K4A_FAILED(result))
+    {
+        if (global->hotplug_registered)
+        {
+            libusb_hotplug_deregister_callback(global->libusb_context, global->hotplug_handle);
+            global->hotplug_registered = false;
+        }
+        libusb_exit(global->libusb_context);
+        global->libusb_context = NULL;
+        global->callback = NULL;
+        global->callback_context = NULL;
+    }
+
+    return result;
+}
+
+/**
+ *  Function to register a callback notified when devices are attached or detached
+ *
+ *  @param hotplug_cb
+ *   Callback to notify, NULL to stop monitoring the devices
+ *
+ *  @param context
+ *   Data that will be handed back with the callback
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+k4a_result_t usb_cmd_set_hotplug_callback(k4a_device_hotplug_cb_t *hotplug_cb, void *context)
+{
+    usb_cmd_hotplug_global_t *global = usb_cmd_hotplug_global_t_get();
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    Lock(global->register_lock);
+
+    // The previous callback is not called again once this returns
+    usb_cmd_hotplug_stop(global);
+    if (hotplug_cb != NULL)
+    {
+        result = TRACE_CALL(usb_cmd_hotplug_start(global, hotplug_cb, context));
+    }
+
+    Unlock(global->register_lock);
+    return result;
+}
+
+// Returns the device count kept by the hotplug monitor, false if no hotplug callback is registered
+bool usb_cmd_hotplug_get_device_count(uint32_t *p_device_count)
+{
+    usb_cmd_hotplug_global_t *global = usb_cmd_hotplug_global_t_get();
+
+    rwlock_acquire_read(&global->lock);
+    bool monitoring = global->monitoring;
+    if (monitoring)
+    {
+        *p_device_count = global->device_count;
+    }
+    rwlock_release_read(&global->lock);
+
+    return monitoring;
+}
@@ -1,146 +1,1135 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#ifndef _MSC_VER
+#define _ISOC11_SOURCE          /* for aligned_alloc() */
+#define _POSIX_C_SOURCE 199309L /* for clock_gettime() */
+#endif
+
 //************************ Includes *****************************
 // This library
 #include <k4ainternal/usbcommand.h>
 #include "usb_cmd_priv.h"
 
+// Dependent libraries
+#include <k4ainternal/threadpool.h>
+
 // System dependencies
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <azure_c_shared_utility/envvariable.h>
+#include <azure_c_shared_utility/refcount.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 //**************Symbolic Constant Macros (defines)  *************
 #define USB_CMD_LIBUSB_EVENT_TIMEOUT 1
 
 //************************ Typedefs *****************************
 
-//************ Declarations (Statics and globals) ***************
+//************ Declarations (Statics and globals) ***************
+
+//******************* Function Prototypes ***********************
+
+//*********************** Functions *****************************
+static uint64_t usb_cmd_get_time_usec(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER qpc = { 0 }, freq = { 0 };
+    if (!QueryPerformanceCounter(&qpc) || !QueryPerformanceFrequency(&freq))
+    {
+        return 0;
+    }
+    return (uint64_t)(qpc.QuadPart / freq.QuadPart * 1000000 + qpc.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+#else
+    struct timespec ts_time;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts_time) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)ts_time.tv_sec * 1000000 + (uint64_t)ts_time.tv_nsec / 1000;
+#endif
+}
+
+/**
+ *  Submits a transfer and counts it as in flight
+ *
+ *  @param transfer
+ *   The filled in transfer to submit
+ *
+ *  @param resubmit
+ *   true if the transfer completed before, a failure is counted as a resubmit failure
+ *
+ *  @return
+ *   The result of libusb_submit_transfer
+ *
+ */
+static int usb_cmd_submit_xfr(usb_async_transfer_data_t *transfer, bool resubmit)
+{
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+
+    // Counted before submitting, the transfer may complete on the stream thread before libusb_submit_transfer returns
+    Lock(usbcmd->stats_lock);
+    usbcmd->stats.transfers_in_flight++;
+    Unlock(usbcmd->stats_lock);
+
+    transfer->submit_usec = usb_cmd_get_time_usec();
+    int err = libusb_submit_transfer(transfer->bulk_transfer);
+    if (err != LIBUSB_SUCCESS)
+    {
+        Lock(usbcmd->stats_lock);
+        usbcmd->stats.transfers_in_flight--;
+        if (resubmit)
+        {
+            usbcmd->stats.resubmit_failures++;
+        }
+        Unlock(usbcmd->stats_lock);
+    }
+    return err;
+}
+
+/**
+ *  Records the completion of a transfer in the stream telemetry. Called from the libusb callbacks, which run on the
+ *  stream thread.
+ *
+ *  @param transfer
+ *   The transfer that completed
+ *
+ */
+static void usb_cmd_xfr_completed(usb_async_transfer_data_t *transfer)
+{
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+    struct libusb_transfer *bulk_transfer = transfer->bulk_transfer;
+    uint64_t now = usb_cmd_get_time_usec();
+
+    uint32_t bucket = 0;
+    for (uint64_t latency_ms = (now - transfer->submit_usec) / 1000;
+         latency_ms > 0 && bucket < K4A_USB_LATENCY_HISTOGRAM_BUCKETS - 1;
+         latency_ms >>= 1)
+    {
+        bucket++;
+    }
+
+    Lock(usbcmd->stats_lock);
+    usbcmd->stats.transfers_in_flight--;
+    switch (bulk_transfer->status)
+    {
+    case LIBUSB_TRANSFER_COMPLETED:
+        usbcmd->stats.completed_transfers++;
+        usbcmd->stats.bytes_transferred += (uint64_t)bulk_transfer->actual_length;
+        usbcmd->stats.latency_histogram[bucket]++;
+        break;
+    case LIBUSB_TRANSFER_TIMED_OUT:
+        usbcmd->stats.timed_out_transfers++;
+        break;
+    case LIBUSB_TRANSFER_OVERFLOW:
+        usbcmd->stats.overflow_transfers++;
+        break;
+    case LIBUSB_TRANSFER_CANCELLED:
+        break;
+    default:
+        usbcmd->stats.failed_transfers++;
+        break;
+    }
+    Unlock(usbcmd->stats_lock);
+
+    if (bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED)
+    {
+        usbcmd->recovery_attempts = 0;
+        if (usbcmd->last_completion_usec != 0 && now - usbcmd->last_completion_usec > usbcmd->window_max_gap_usec)
+        {
+            usbcmd->window_max_gap_usec = now - usbcmd->last_completion_usec;
+        }
+        usbcmd->last_completion_usec = now;
+        usbcmd->window_completions++;
+        usbcmd->window_bytes += (uint64_t)bulk_transfer->actual_length;
+    }
+}
+
+static uint8_t *usb_cmd_alloc_aligned_buffer(size_t size)
+{
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t aligned_size = (size + USB_CMD_XFR_BUFFER_ALIGNMENT - 1) / USB_CMD_XFR_BUFFER_ALIGNMENT *
+                          USB_CMD_XFR_BUFFER_ALIGNMENT;
+    uint8_t *buffer;
+#ifdef _MSC_VER
+    buffer = (uint8_t *)_aligned_malloc(aligned_size, USB_CMD_XFR_BUFFER_ALIGNMENT);
+#else
+    buffer = (uint8_t *)aligned_alloc(USB_CMD_XFR_BUFFER_ALIGNMENT, aligned_size);
+#endif
+    if (buffer != NULL)
+    {
+        // Touch every page now so the first transfer into this buffer does not take page faults
+        memset(buffer, 0, aligned_size);
+    }
+    return buffer;
+}
+
+static void usb_cmd_free_aligned_buffer(uint8_t *buffer)
+{
+#ifdef _MSC_VER
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+void usb_dev_mem_owner_dec_ref(usb_dev_mem_owner_t *owner)
+{
+    if (DEC_REF_VAR(owner->ref_count) == 0)
+    {
+        if (owner->owns_handle)
+        {
+            libusb_close(owner->libusb);
+            libusb_exit(owner->libusb_context);
+        }
+        free(owner);
+    }
+}
+
+/**
+ *  Maps buffers of the pool from the device with libusb_dev_mem_alloc, so that the kernel receives into them directly
+ *  instead of copying out of its own transfer buffer. Either every buffer is mapped or none is.
+ *
+ *  @param pool
+ *   The pool, with no buffers allocated yet
+ *
+ *  @param buffer_count
+ *   Number of buffers to map
+ *
+ *  @param owner
+ *   Owner of the device handle to map the buffers from
+ *
+ *  @return
+ *   true if the buffers were mapped, false if the platform or the kernel does not support it
+ *
+ */
+static bool usb_xfr_pool_map_dev_mem(usb_xfr_buffer_pool_t *pool, uint32_t buffer_count, usb_dev_mem_owner_t *owner)
+{
+#if LIBUSB_API_VERSION >= 0x01000105
+    for (uint32_t i = 0; i < buffer_count; i++)
+    {
+        uint8_t *buffer = libusb_dev_mem_alloc(owner->libusb, pool->buffer_size);
+        if (buffer == NULL)
+        {
+            for (uint32_t j = 0; j < i; j++)
+            {
+                (void)libusb_dev_mem_free(owner->libusb, pool->buffers[j], pool->buffer_size);
+            }
+            return false;
+        }
+        pool->buffers[i] = buffer;
+    }
+
+    for (uint32_t i = 0; i < buffer_count; i++)
+    {
+        pool->free_list[i] = pool->buffers[i];
+    }
+    pool->buffer_count = buffer_count;
+    pool->free_count = buffer_count;
+
+    INC_REF_VAR(owner->ref_count);
+    pool->dev_mem_owner = owner;
+    return true;
+#else
+    (void)pool;
+    (void)buffer_count;
+    (void)owner;
+    return false;
+#endif
+}
+
+static void usb_xfr_pool_dec_ref(usb_xfr_buffer_pool_t *pool)
+{
+    if (DEC_REF_VAR(pool->ref_count) == 0)
+    {
+        assert(pool->zero_copy || pool->free_count == pool->buffer_count);
+        for (uint32_t i = 0; i < pool->buffer_count; i++)
+        {
+#if LIBUSB_API_VERSION >= 0x01000105
+            if (pool->dev_mem_owner != NULL)
+            {
+                (void)libusb_dev_mem_free(pool->dev_mem_owner->libusb, pool->buffers[i], pool->buffer_size);
+                continue;
+            }
+#endif
+            usb_cmd_free_aligned_buffer(pool->buffers[i]);
+        }
+        if (pool->dev_mem_owner != NULL)
+        {
+            usb_dev_mem_owner_dec_ref(pool->dev_mem_owner);
+        }
+        if (pool->lock)
+        {
+            Lock_Deinit(pool->lock);
+        }
+        free(pool);
+    }
+}
+
+/**
+ *  Creates a pool of transfer buffers
+ *
+ *  @param buffer_size
+ *   Size of each buffer in the pool
+ *
+ *  @param buffer_count
+ *   Number of buffers to allocate, must not exceed USB_CMD_XFR_POOL_MAX_COUNT
+ *
+ *  @param zero_copy
+ *   true if each buffer will be bound to one transfer and lent out directly as the stream image
+ *
+ *  @param dev_mem_owner
+ *   Optional owner of the device handle to map the buffers from. Falls back to regular buffers if they can't be
+ *   mapped.
+ *
+ *  @param pool_out
+ *   Location to store the new pool. The caller owns the one reference on the pool.
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+static k4a_result_t usb_xfr_pool_create(size_t buffer_size,
+                                        uint32_t buffer_count,
+                                        bool zero_copy,
+                                        usb_dev_mem_owner_t *dev_mem_owner,
+                                        usb_xfr_buffer_pool_t **pool_out)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_size == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, buffer_count == 0 || buffer_count > USB_CMD_XFR_POOL_MAX_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, pool_out == NULL);
+
+    usb_xfr_buffer_pool_t *pool = (usb_xfr_buffer_pool_t *)calloc(1, sizeof(usb_xfr_buffer_pool_t));
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(pool != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        pool->ref_count = 1;
+        pool->buffer_size = buffer_size;
+        pool->zero_copy = zero_copy;
+        pool->stream_active = true;
+        pool->lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(pool->lock != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result) && dev_mem_owner != NULL &&
+        !usb_xfr_pool_map_dev_mem(pool, buffer_count, dev_mem_owner))
+    {
+        LOG_INFO("libusb_dev_mem_alloc is not available, streaming into regular buffers", 0);
+    }
+
+    for (uint32_t i = pool->buffer_count; K4A_SUCCEEDED(result) && i < buffer_count; i++)
+    {
+        uint8_t *buffer = usb_cmd_alloc_aligned_buffer(buffer_size);
+        result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            pool->buffers[pool->buffer_count++] = buffer;
+            pool->free_list[pool->free_count++] = buffer;
+        }
+    }
+
+    if (K4A_FAILED(result) && pool != NULL)
+    {
+        usb_xfr_pool_dec_ref(pool);
+        pool = NULL;
+    }
+
+    *pool_out = pool;
+    return result;
+}
+
+/**
+ *  Image destroy callback, returns a buffer lent out by usb_cmd_create_stream_image to its pool
+ */
+static void usb_xfr_pool_return_buffer(void *buffer, void *context)
+{
+    usb_xfr_buffer_pool_t *pool = (usb_xfr_buffer_pool_t *)context;
+
+    Lock(pool->lock);
+    assert(pool->free_count < pool->buffer_count);
+    pool->free_list[pool->free_count++] = (uint8_t *)buffer;
+    Unlock(pool->lock);
+
+    usb_xfr_pool_dec_ref(pool);
+}
+
+/**
+ *  Creates the image a streaming transfer is received into. The buffer comes from the stream's pool when one is
+ *  available, otherwise it falls back to the SDK allocator so the stream keeps running when consumers hold on to
+ *  more images than the pool has spares for.
+ *
+ *  @param usbcmd
+ *   Context of the stream the image is for
+ *
+ *  @param image
+ *   Location to store the new image
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+static k4a_result_t usb_cmd_create_stream_image(usbcmd_context_t *usbcmd, k4a_image_t *image)
+{
+    usb_xfr_buffer_pool_t *pool = usbcmd->buffer_pool;
+    uint8_t *buffer = NULL;
+
+    if (pool != NULL)
+    {
+        Lock(pool->lock);
+        if (pool->free_count > 0)
+        {
+            buffer = pool->free_list[--pool->free_count];
+        }
+        Unlock(pool->lock);
+    }
+
+    if (buffer == NULL)
+    {
+        return TRACE_CALL(image_create_empty_internal(usbcmd->source, usbcmd->stream_size, image));
+    }
+
+    INC_REF_VAR(pool->ref_count);
+    k4a_result_t result = TRACE_CALL(
+        image_create_empty_from_buffer(buffer, usbcmd->stream_size, usb_xfr_pool_return_buffer, pool, image));
+    if (K4A_FAILED(result))
+    {
+        usb_xfr_pool_return_buffer(buffer, pool);
+    }
+    return result;
+}
+
+/**
+ *  Utility function for releasing the transfer resources
+ *
+ *  @param bulk_transfer
+ *   Pointer to the resources allocated for doing the usb transfer
+ *
+ */
+static void usb_cmd_release_xfr(struct libusb_transfer *bulk_transfer)
+{
+    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+
+    if (usbcmd->transfer_list[transfer->list_index] == transfer)
+    {
+        usbcmd->transfer_list[transfer->list_index] = NULL;
+        usbcmd->xfr_count--;
+    }
+    if (transfer->image)
+    {
+        image_dec_ref(transfer->image);
+        transfer->image = NULL;
+    }
+    if (transfer->pool != NULL)
+    {
+        // The bound buffer goes back to the pool, a recovered stream binds it to a new transfer
+        Lock(transfer->pool->lock);
+        transfer->pool->free_list[transfer->pool->free_count++] = bulk_transfer->buffer;
+        Unlock(transfer->pool->lock);
+    }
+
+    // free the allocated resources
+    libusb_free_transfer(bulk_transfer);
+    free(transfer);
+}
+
+/**
+ *  Reports a failed or stopped transfer to the stream callback, or schedules a recovery of the endpoint, and releases
+ *  the transfer
+ *
+ *  @param bulk_transfer
+ *   Pointer to the resources allocated for doing the usb transfer
+ *
+ */
+static void usb_cmd_xfr_failed(struct libusb_transfer *bulk_transfer)
+{
+    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+
+    // Transfers that end while the endpoint is being recovered are dropped silently
+    if (usbcmd->stream_going && !usbcmd->recovering && usbcmd->recovery &&
+        usbcmd->recovery_attempts < USB_CMD_RECOVERY_MAX_ATTEMPTS &&
+        (bulk_transfer->status == LIBUSB_TRANSFER_ERROR || bulk_transfer->status == LIBUSB_TRANSFER_STALL))
+    {
+        // The stream thread resets the endpoint once the libusb callbacks return, the consumers keep running
+        LOG_WARNING("LibUSB transfer status of %08X on the %s stream, restarting the endpoint",
+                    bulk_transfer->status,
+                    usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu");
+        usbcmd->recover_pending = true;
+    }
+    else if (usbcmd->stream_going && !usbcmd->recovering && (bulk_transfer->status != LIBUSB_TRANSFER_CANCELLED) &&
+             (bulk_transfer->status != LIBUSB_TRANSFER_OVERFLOW))
+    {
+        // Note: The overflow happens when the thread tries to submit the next transfer and the kernel doesn't
+        // have the space for it. This is where the adaptive detection mechanism takes place. The adaptive
+        // method submits until it gets an error from the submit call. The error produces the libusb_transfer_
+        // overflow error which shows up in the callback. It's ignored since it is expected behavior during
+        // the submission process and there are other trace messages that record the event.
+        LOG_ERROR("Error LIBUSB transfer failed, result:%s", libusb_error_name((int)bulk_transfer->status));
+
+        // check if the error state can be propagated
+        if (usbcmd->callback != NULL)
+        {
+            if (transfer->image != NULL)
+            {
+                image_set_size(transfer->image, (size_t)0);
+            }
+            usbcmd->callback(K4A_RESULT_FAILED, transfer->image, usbcmd->stream_context);
+        }
+    }
+    // release resource for phy related changes or transfer stopped
+    usb_cmd_release_xfr(bulk_transfer);
+}
+
+/**
+ *  Function for handling the callback from the libusb library as a result of a transfer request
+ *
+ *  @param bulk_transfer
+ *   Pointer to the resources allocated for doing the usb transfer
+ *
+ */
+void LIBUSB_CALL usb_cmd_libusb_cb(struct libusb_transfer *bulk_transfer)
+{
+    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+    k4a_result_t result = K4A_RESULT_FAILED;
+
+    logger_trace(LOGGER_TRACE_USB_TRANSFER,
+                 (uint64_t)usbcmd->interface,
+                 (uint64_t)bulk_transfer->status,
+                 (uint64_t)bulk_transfer->actual_length);
+    usb_cmd_xfr_completed(transfer);
+
+    result = image_apply_system_timestamp(transfer->image);
+    if (K4A_SUCCEEDED(result))
+    {
+        if (((bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED) ||
+             bulk_transfer->status == LIBUSB_TRANSFER_TIMED_OUT) &&
+            (usbcmd->stream_going) && !usbcmd->recovering)
+        {
+            // if callback provided, callback with associated information
+            if ((bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED) && (usbcmd->callback != NULL))
+            {
+                image_set_size(transfer->image, (size_t)bulk_transfer->actual_length);
+                usbcmd->callback(K4A_RESULT_SUCCEEDED, transfer->image, usbcmd->stream_context);
+            }
+            else
+            {
+                LOG_WARNING("USB timeout on streaming endpoint for %s",
+                            usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu");
+            }
+
+            // We guarantee the capture is valid during the callback if someone wants it to survive longer then they
+            // need to add a ref
+            image_dec_ref(transfer->image);
+            transfer->image = NULL;
+
+            if (usbcmd->adaptive && usbcmd->xfr_count > usbcmd->xfr_target)
+            {
+                // The adaptive target dropped, retire this transfer instead of resubmitting it
+                usb_cmd_release_xfr(bulk_transfer);
+                return;
+            }
+
+            // get the next buffer and re-use transfer
+            result = TRACE_CALL(usb_cmd_create_stream_image(usbcmd, &transfer->image));
+            if (K4A_SUCCEEDED(result))
+            {
+                int err = LIBUSB_ERROR_OTHER;
+                libusb_fill_bulk_transfer(bulk_transfer,
+                                          usbcmd->libusb,
+                                          usbcmd->stream_endpoint,
+                                          image_get_buffer(transfer->image),
+                                          (int)usbcmd->stream_size,
+                                          usb_cmd_libusb_cb,
+                                          transfer,
+                                          USB_CMD_MAX_WAIT_TIME);
+                if ((err = usb_cmd_submit_xfr(transfer, true)) != LIBUSB_SUCCESS)
+                {
+                    result = K4A_RESULT_FAILED;
+                    LOG_ERROR("Error calling libusb_submit_transfer for tx, result:%s", libusb_error_name(err));
+                    image_dec_ref(transfer->image);
+                    transfer->image = NULL;
+                }
+            }
+        }
+        else
+        {
+            if ((bulk_transfer->status != LIBUSB_TRANSFER_CANCELLED) &&
+                (bulk_transfer->status != LIBUSB_TRANSFER_COMPLETED))
+            {
+                LOG_ERROR("LibUSB transfer status of %08X unexpected", bulk_transfer->status);
+            }
+            // Shutdown condition or an error happened.
+            result = K4A_RESULT_FAILED;
+        }
+    }
+    if (K4A_FAILED(result))
+    {
+        usb_cmd_xfr_failed(bulk_transfer);
+    }
+}
+
+/**
+ *  Image destroy callback for zero copy mode. Called when the last reference to the image wrapping a transfer's
+ *  buffer is released; resubmits the transfer if the stream is still running, otherwise frees it.
+ *
+ *  @param buffer
+ *   The transfer buffer, owned by the stream's buffer pool
+ *
+ *  @param context
+ *   The usb_async_transfer_data_t the buffer is bound to
+ *
+ */
+static void usb_cmd_zero_copy_release(void *buffer, void *context)
+{
+    (void)buffer;
+    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)context;
+    usb_xfr_buffer_pool_t *pool = transfer->pool;
+    bool free_transfer = true;
+
+    // usbcmd is only valid while stream_active is set; the stream thread clears it before the stream is torn down.
+    // A transfer from before a stream recovery no longer has a slot in the transfer list.
+    Lock(pool->lock);
+    transfer->held = false;
+    if (pool->stream_active && transfer->generation == pool->generation)
+    {
+        int err = usb_cmd_submit_xfr(transfer, true);
+        if (err == LIBUSB_SUCCESS)
+        {
+            free_transfer = false;
+        }
+        else
+        {
+            LOG_ERROR("Error calling libusb_submit_transfer for tx, result:%s", libusb_error_name(err));
+            transfer->usbcmd->transfer_list[transfer->list_index] = NULL;
+        }
+    }
+    if (free_transfer)
+    {
+        // The buffer stays with the pool, only the transfer is destroyed
+        pool->free_list[pool->free_count++] = transfer->bulk_transfer->buffer;
+    }
+    Unlock(pool->lock);
+
+    if (free_transfer)
+    {
+        libusb_free_transfer(transfer->bulk_transfer);
+        free(transfer);
+    }
+
+    usb_xfr_pool_dec_ref(pool);
+}
+
+/**
+ *  Function for handling the callback from the libusb library as a result of a transfer request in zero copy mode
+ *
+ *  @param bulk_transfer
+ *   Pointer to the resources allocated for doing the usb transfer
+ *
+ */
+void LIBUSB_CALL usb_cmd_libusb_zero_copy_cb(struct libusb_transfer *bulk_transfer)
+{
+    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
+    usbcmd_context_t *usbcmd = transfer->usbcmd;
+    usb_xfr_buffer_pool_t *pool = transfer->pool;
+    k4a_result_t result = K4A_RESULT_FAILED;
+
+    logger_trace(LOGGER_TRACE_USB_TRANSFER,
+                 (uint64_t)usbcmd->interface,
+                 (uint64_t)bulk_transfer->status,
+                 (uint64_t)bulk_transfer->actual_length);
+    usb_cmd_xfr_completed(transfer);
+
+    if (!usbcmd->stream_going || usbcmd->recovering ||
+        (bulk_transfer->status != LIBUSB_TRANSFER_COMPLETED && bulk_transfer->status != LIBUSB_TRANSFER_TIMED_OUT))
+    {
+        if ((bulk_transfer->status != LIBUSB_TRANSFER_CANCELLED) &&
+            (bulk_transfer->status != LIBUSB_TRANSFER_COMPLETED))
+        {
+            LOG_ERROR("LibUSB transfer status of %08X unexpected", bulk_transfer->status);
+        }
+        // Shutdown condition or an error happened.
+        usb_cmd_xfr_failed(bulk_transfer);
+        return;
+    }
+
+    if (bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED && bulk_transfer->actual_length > 0 &&
+        usbcmd->callback != NULL)
+    {
+        k4a_image_t image = NULL;
+
+        // The image keeps a reference on the pool and owns the transfer until it is released
+        Lock(pool->lock);
+        transfer->held = true;
+        Unlock(pool->lock);
+        INC_REF_VAR(pool->ref_count);
+
+        result = TRACE_CALL(image_create_empty_from_buffer(bulk_transfer->buffer,
+                                                           (size_t)bulk_transfer->actual_length,
+                                                           usb_cmd_zero_copy_release,
+                                                           transfer,
+                                                           &image));
+        if (K4A_SUCCEEDED(result))
+        {
+            result = image_apply_system_timestamp(image);
+            if (K4A_SUCCEEDED(result))
+            {
+                usbcmd->callback(K4A_RESULT_SUCCEEDED, image, usbcmd->stream_context);
+            }
+
+            // Resubmits the transfer unless the callback kept a reference to the image
+            image_dec_ref(image);
+        }
+        else
+        {
+            Lock(pool->lock);
+            transfer->held = false;
+            Unlock(pool->lock);
+            usb_xfr_pool_dec_ref(pool);
+            usb_cmd_xfr_failed(bulk_transfer);
+        }
+        return;
+    }
+
+    LOG_WARNING("USB timeout on streaming endpoint for %s",
+                usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu");
+
+    int err = usb_cmd_submit_xfr(transfer, true);
+    if (err != LIBUSB_SUCCESS)
+    {
+        LOG_ERROR("Error calling libusb_submit_transfer for tx, result:%s", libusb_error_name(err));
+        usb_cmd_xfr_failed(bulk_transfer);
+    }
+}
+
+/**
+ *  Allocates a transfer with its buffer into a free slot of the transfer list. The transfer is filled in but not
+ *  submitted.
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ *  @param list_index
+ *   Free slot of the transfer list to use
+ *
+ *  @param zero_copy
+ *   true to bind a buffer of the pool to the transfer, false to receive into a new stream image
+ *
+ *  @param transfer_out
+ *   Location to store the transfer
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed, nothing is left allocated
+ *
+ */
+static k4a_result_t usb_cmd_alloc_xfr(usbcmd_context_t *usbcmd,
+                                      uint32_t list_index,
+                                      bool zero_copy,
+                                      usb_async_transfer_data_t **transfer_out)
+{
+    usb_async_transfer_data_t *transfer = calloc(1, sizeof(usb_async_transfer_data_t));
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(transfer != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        transfer->usbcmd = usbcmd;
+        transfer->list_index = list_index;
+        transfer->bulk_transfer = libusb_alloc_transfer(0);
+        result = K4A_RESULT_FROM_BOOL(transfer->bulk_transfer != NULL);
+    }
+
+    uint8_t *buffer = NULL;
+    if (K4A_SUCCEEDED(result) && zero_copy)
+    {
+        // The buffer stays bound to this transfer for the life of the stream
+        usb_xfr_buffer_pool_t *pool = usbcmd->buffer_pool;
+        Lock(pool->lock);
+        if (pool->free_count > 0)
+        {
+            buffer = pool->free_list[--pool->free_count];
+        }
+        transfer->generation = pool->generation;
+        Unlock(pool->lock);
+        transfer->pool = pool;
+        result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+    }
+    else if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(usb_cmd_create_stream_image(usbcmd, &transfer->image));
+        if (K4A_SUCCEEDED(result))
+        {
+            buffer = image_get_buffer(transfer->image);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        libusb_fill_bulk_transfer(transfer->bulk_transfer,
+                                  usbcmd->libusb,
+                                  usbcmd->stream_endpoint,
+                                  buffer,
+                                  (int)usbcmd->stream_size,
+                                  zero_copy ? usb_cmd_libusb_zero_copy_cb : usb_cmd_libusb_cb,
+                                  transfer,
+                                  USB_CMD_MAX_WAIT_TIME);
+        usbcmd->transfer_list[list_index] = transfer;
+        usbcmd->xfr_count++;
+        *transfer_out = transfer;
+    }
+    else if (transfer != NULL)
+    {
+        if (transfer->image)
+        {
+            image_dec_ref(transfer->image);
+        }
+        if (transfer->bulk_transfer)
+        {
+            libusb_free_transfer(transfer->bulk_transfer);
+        }
+        free(transfer);
+    }
+
+    return result;
+}
+
+/**
+ *  Adds copy mode transfers until the adaptive target is reached. A transfer that can not be submitted lowers the
+ *  limit to the transfers that are running, the host is short on memory for transfers.
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ */
+static void usb_cmd_grow_xfrs(usbcmd_context_t *usbcmd)
+{
+    for (uint32_t i = 0; i < USB_CMD_MAX_XFR_COUNT && usbcmd->xfr_count < usbcmd->xfr_target; i++)
+    {
+        if (usbcmd->transfer_list[i] != NULL)
+        {
+            continue;
+        }
+
+        usb_async_transfer_data_t *transfer = NULL;
+        k4a_result_t result = TRACE_CALL(usb_cmd_alloc_xfr(usbcmd, i, false, &transfer));
+        if (K4A_SUCCEEDED(result))
+        {
+            int err = usb_cmd_submit_xfr(transfer, false);
+            if (err != LIBUSB_SUCCESS)
+            {
+                LOG_WARNING("Could not add a libusb transfer, error:%s", libusb_error_name(err));
+                usb_cmd_release_xfr(transfer->bulk_transfer);
+                result = K4A_RESULT_FAILED;
+            }
+        }
 
-//******************* Function Prototypes ***********************
+        if (K4A_FAILED(result))
+        {
+            usbcmd->xfr_limit = MAX(usbcmd->xfr_count, USB_CMD_ADAPTIVE_MIN_XFR_COUNT);
+            usbcmd->xfr_target = usbcmd->xfr_limit;
+            break;
+        }
+    }
+}
 
-//*********************** Functions *****************************
 /**
- *  Utility function for releasing the transfer resources
+ *  Picks the number of transfers to keep in flight from the last measurement window.
  *
- *  @param bulk_transfer
- *   Pointer to the resources allocated for doing the usb transfer
+ *  The stream can absorb a stall of the stream thread as long as transfers are queued for the frames the device
+ *  sends meanwhile, so the target covers the longest time between two completions plus a couple of spares. Transfers
+ *  that time out waited longer than USB_CMD_MAX_WAIT_TIME behind the others and resubmit failures mean the host is
+ *  short on memory for transfers, both shrink the target right away. Spare transfers are only released after several
+ *  quiet windows to not oscillate.
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ *  @param window_usec
+ *   Duration of the window
+ *
+ *  @param timeouts
+ *   Transfers that timed out during the window
+ *
+ *  @param submit_failures
+ *   Transfers that could not be resubmitted during the window
  *
  */
-static void usb_cmd_release_xfr(struct libusb_transfer *bulk_transfer)
+static void usb_cmd_adapt_xfr_target(usbcmd_context_t *usbcmd,
+                                     uint64_t window_usec,
+                                     uint64_t timeouts,
+                                     uint64_t submit_failures)
 {
-    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
-    usbcmd_context_t *usbcmd = transfer->usbcmd;
+    uint32_t target = usbcmd->xfr_target;
 
-    if (usbcmd->transfer_list[transfer->list_index] == transfer)
+    if (submit_failures > 0)
     {
-        usbcmd->transfer_list[transfer->list_index] = NULL;
+        usbcmd->xfr_limit = MAX(usbcmd->xfr_count, USB_CMD_ADAPTIVE_MIN_XFR_COUNT);
+        target = MIN(target, usbcmd->xfr_limit);
+        usbcmd->spare_windows = 0;
     }
-    if (transfer->image)
+    else if (timeouts > 0)
     {
-        image_dec_ref(transfer->image);
-        transfer->image = NULL;
+        target = MAX(target - 1, USB_CMD_ADAPTIVE_MIN_XFR_COUNT);
+        usbcmd->spare_windows = 0;
     }
+    else if (usbcmd->window_completions >= 2)
+    {
+        uint64_t interval_usec = window_usec / usbcmd->window_completions;
+        uint64_t needed = (usbcmd->window_max_gap_usec + interval_usec - 1) / interval_usec +
+                          USB_CMD_ADAPTIVE_SPARE_XFR_COUNT;
 
-    // free the allocated resources
-    libusb_free_transfer(bulk_transfer);
-    free(transfer);
+        if (needed > target && target < usbcmd->xfr_limit)
+        {
+            target++;
+            usbcmd->spare_windows = 0;
+        }
+        else if (needed < target && ++usbcmd->spare_windows >= USB_CMD_ADAPTIVE_SHRINK_WINDOWS)
+        {
+            target = MAX(target - 1, USB_CMD_ADAPTIVE_MIN_XFR_COUNT);
+            usbcmd->spare_windows = 0;
+        }
+        else if (needed >= target)
+        {
+            usbcmd->spare_windows = 0;
+        }
+    }
+
+    if (target != usbcmd->xfr_target)
+    {
+        LOG_INFO("Adjusting %s stream from %u to %u libusb transfers",
+                 usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu",
+                 usbcmd->xfr_target,
+                 target);
+        usbcmd->xfr_target = target;
+    }
 }
 
 /**
- *  Function for handling the callback from the libusb library as a result of a transfer request
+ *  Gives a transfer to the empty slots below the transfer target again, after a stream recovery dropped them. In zero
+ *  copy mode a slot stays empty until the image holding its old buffer is released, a later call fills it.
  *
- *  @param bulk_transfer
- *   Pointer to the resources allocated for doing the usb transfer
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ *  @return
+ *   Number of transfers in flight
  *
  */
-void LIBUSB_CALL usb_cmd_libusb_cb(struct libusb_transfer *bulk_transfer)
+static uint32_t usb_cmd_refill_xfrs(usbcmd_context_t *usbcmd)
 {
-    usb_async_transfer_data_t *transfer = (usb_async_transfer_data_t *)(bulk_transfer->user_data);
-    usbcmd_context_t *usbcmd = transfer->usbcmd;
-    k4a_result_t result = K4A_RESULT_FAILED;
+    bool zero_copy = usbcmd->buffer_pool != NULL && usbcmd->buffer_pool->zero_copy;
+    uint32_t running = 0;
 
-    result = image_apply_system_timestamp(transfer->image);
-    if (K4A_SUCCEEDED(result))
+    usbcmd->refill_pending = false;
+    for (uint32_t i = 0; i < usbcmd->xfr_target; i++)
     {
-        if (((bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED) ||
-             bulk_transfer->status == LIBUSB_TRANSFER_TIMED_OUT) &&
-            (usbcmd->stream_going))
+        if (usbcmd->transfer_list[i] != NULL)
         {
-            // if callback provided, callback with associated information
-            if ((bulk_transfer->status == LIBUSB_TRANSFER_COMPLETED) && (usbcmd->callback != NULL))
-            {
-                image_set_size(transfer->image, (size_t)bulk_transfer->actual_length);
-                usbcmd->callback(K4A_RESULT_SUCCEEDED, transfer->image, usbcmd->stream_context);
-            }
-            else
+            running++;
+            continue;
+        }
+
+        if (zero_copy)
+        {
+            Lock(usbcmd->buffer_pool->lock);
+            bool buffer_free = usbcmd->buffer_pool->free_count > 0;
+            Unlock(usbcmd->buffer_pool->lock);
+            if (!buffer_free)
             {
-                LOG_WARNING("USB timeout on streaming endpoint for %s",
-                            usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu");
+                usbcmd->refill_pending = true;
+                continue;
             }
+        }
 
-            // We guarantee the capture is valid during the callback if someone wants it to survive longer then they
-            // need to add a ref
-            image_dec_ref(transfer->image);
-            transfer->image = NULL;
-
-            // allocate next buffer and re-use transfer
-            result = TRACE_CALL(image_create_empty_internal(usbcmd->source, usbcmd->stream_size, &transfer->image));
-            if (K4A_SUCCEEDED(result))
+        usb_async_transfer_data_t *transfer = NULL;
+        k4a_result_t result = usb_cmd_alloc_xfr(usbcmd, i, zero_copy, &transfer);
+        if (K4A_SUCCEEDED(result))
+        {
+            int err = usb_cmd_submit_xfr(transfer, false);
+            if (err != LIBUSB_SUCCESS)
             {
-                int err = LIBUSB_ERROR_OTHER;
-                libusb_fill_bulk_transfer(bulk_transfer,
-                                          usbcmd->libusb,
-                                          usbcmd->stream_endpoint,
-                                          image_get_buffer(transfer->image),
-                                          (int)usbcmd->stream_size,
-                                          usb_cmd_libusb_cb,
-                                          transfer,
-                                          USB_CMD_MAX_WAIT_TIME);
-                if ((err = libusb_submit_transfer(bulk_transfer)) != LIBUSB_SUCCESS)
-                {
-                    result = K4A_RESULT_FAILED;
-                    LOG_ERROR("Error calling libusb_submit_transfer for tx, result:%s", libusb_error_name(err));
-                    image_dec_ref(transfer->image);
-                    transfer->image = NULL;
-                }
+                LOG_WARNING("Could not resubmit a libusb transfer, error:%s", libusb_error_name(err));
+                usb_cmd_release_xfr(transfer->bulk_transfer);
+                result = K4A_RESULT_FAILED;
             }
         }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            running++;
+        }
         else
         {
-            if ((bulk_transfer->status != LIBUSB_TRANSFER_CANCELLED) &&
-                (bulk_transfer->status != LIBUSB_TRANSFER_COMPLETED))
+            usbcmd->refill_pending = true;
+        }
+    }
+    return running;
+}
+
+/**
+ *  Closes the measurement window once it is long enough: publishes the receive rate and, in adaptive mode, tunes the
+ *  number of transfers in flight. Runs on the stream thread between calls into libusb.
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ */
+static void usb_cmd_end_window(usbcmd_context_t *usbcmd)
+{
+    uint64_t now = usb_cmd_get_time_usec();
+    uint64_t window_usec = now - usbcmd->window_start_usec;
+    if (window_usec < USB_CMD_STATS_WINDOW_USEC)
+    {
+        return;
+    }
+
+    Lock(usbcmd->stats_lock);
+    usbcmd->stats.bytes_per_second = usbcmd->window_bytes * 1000000 / window_usec;
+    uint64_t timeouts = usbcmd->stats.timed_out_transfers - usbcmd->window_timeouts;
+    uint64_t submit_failures = usbcmd->stats.resubmit_failures - usbcmd->window_submit_failures;
+    usbcmd->window_timeouts = usbcmd->stats.timed_out_transfers;
+    usbcmd->window_submit_failures = usbcmd->stats.resubmit_failures;
+    Unlock(usbcmd->stats_lock);
+
+    if (usbcmd->refill_pending)
+    {
+        (void)usb_cmd_refill_xfrs(usbcmd);
+    }
+
+    if (usbcmd->adaptive)
+    {
+        usb_cmd_adapt_xfr_target(usbcmd, window_usec, timeouts, submit_failures);
+        usb_cmd_grow_xfrs(usbcmd);
+
+        Lock(usbcmd->stats_lock);
+        usbcmd->stats.transfer_target = usbcmd->xfr_target;
+        Unlock(usbcmd->stats_lock);
+    }
+
+    usbcmd->window_start_usec = now;
+    usbcmd->window_bytes = 0;
+    usbcmd->window_completions = 0;
+    usbcmd->window_max_gap_usec = 0;
+}
+
+/**
+ *  Restarts the stream endpoint in place after a transfer error. The transfers still in flight are cancelled, the
+ *  halt on the endpoint is cleared and the transfers are submitted again, while the consumers of the stream keep
+ *  running and only miss the data lost during the reset. Runs on the stream thread between calls into libusb.
+ *
+ *  @param usbcmd
+ *   Context of the stream
+ *
+ */
+static void usb_cmd_recover_stream(usbcmd_context_t *usbcmd)
+{
+    usb_xfr_buffer_pool_t *pool = usbcmd->buffer_pool;
+    const char *stream_name = usbcmd->interface == USB_CMD_DEPTH_INTERFACE ? "depth" : "imu";
+    struct timeval tv = { USB_CMD_LIBUSB_EVENT_TIMEOUT, 0 };
+    int err = LIBUSB_SUCCESS;
+
+    usbcmd->recover_pending = false;
+    usbcmd->recovering = true;
+    usbcmd->recovery_attempts++;
+
+    if (pool != NULL && pool->zero_copy)
+    {
+        // Transfers whose buffer is lent out as an image are freed when the image is released instead of being
+        // resubmitted, their slots are given new transfers
+        Lock(pool->lock);
+        pool->generation++;
+        for (uint32_t i = 0; i < USB_CMD_MAX_XFR_COUNT; i++)
+        {
+            if (usbcmd->transfer_list[i] != NULL && usbcmd->transfer_list[i]->held)
             {
-                LOG_ERROR("LibUSB transfer status of %08X unexpected", bulk_transfer->status);
+                usbcmd->transfer_list[i] = NULL;
+                usbcmd->xfr_count--;
             }
-            // Shutdown condition or an error happened.
-            result = K4A_RESULT_FAILED;
         }
+        Unlock(pool->lock);
     }
-    if (K4A_FAILED(result))
+
+    // Cancelled transfers release themselves from their callback; the endpoint must be idle before its halt is cleared
+    for (uint32_t i = 0; i < USB_CMD_MAX_XFR_COUNT; i++)
     {
-        if (usbcmd->stream_going && (bulk_transfer->status != LIBUSB_TRANSFER_CANCELLED) &&
-            (bulk_transfer->status != LIBUSB_TRANSFER_OVERFLOW))
+        if (usbcmd->transfer_list[i] != NULL)
         {
-            // Note: The overflow happens when the thread tries to submit the next transfer and the kernel doesn't
-            // have the space for it. This is where the adaptive detection mechanism takes place. The adaptive
-            // method submits until it gets an error from the submit call. The error produces the libusb_transfer_
-            // overflow error which shows up in the callback. It's ignored since it is expected behavior during
-            // the submission process and there are other trace messages that record the event.
-            LOG_ERROR("Error LIBUSB transfer failed, result:%s", libusb_error_name((int)bulk_transfer->status));
+            libusb_cancel_transfer(usbcmd->transfer_list[i]->bulk_transfer);
+        }
+    }
 
-            // check if the error state can be propagated
-            if (usbcmd->callback != NULL)
-            {
-                image_set_size(transfer->image, (size_t)0);
-                usbcmd->callback(K4A_RESULT_FAILED, transfer->image, usbcmd->stream_context);
-            }
+    bool idle = false;
+    for (uint32_t tries = 0; usbcmd->stream_going && tries <= USB_CMD_RECOVERY_DRAIN_TRIES; tries++)
+    {
+        idle = true;
+        for (uint32_t i = 0; i < USB_CMD_MAX_XFR_COUNT; i++)
+        {
+            idle = idle && usbcmd->transfer_list[i] == NULL;
+        }
+        if (idle || tries == USB_CMD_RECOVERY_DRAIN_TRIES)
+        {
+            break;
+        }
+
+        if ((err = libusb_handle_events_timeout_completed(usbcmd->libusb_context, &tv, NULL)) < 0)
+        {
+            LOG_ERROR("Error calling libusb_handle_events_timeout failed, result:%s", libusb_error_name(err));
+            idle = false;
+            break;
+        }
+    }
+
+    if (idle)
+    {
+        err = libusb_clear_halt(usbcmd->libusb, usbcmd->stream_endpoint);
+        if (err != LIBUSB_SUCCESS)
+        {
+            LOG_WARNING("Error calling libusb_clear_halt for the %s stream, result:%s",
+                        stream_name,
+                        libusb_error_name(err));
+        }
+    }
+    usbcmd->recovering = false;
+
+    if (!usbcmd->stream_going)
+    {
+        // The stream is stopping, the stream thread releases what is left
+        return;
+    }
+
+    uint32_t running = 0;
+    if (idle && err != LIBUSB_ERROR_NO_DEVICE)
+    {
+        running = usb_cmd_refill_xfrs(usbcmd);
+    }
+
+    // In zero copy mode the application may still hold every buffer, the slots are filled as the images are released
+    if (running > 0 || (idle && err != LIBUSB_ERROR_NO_DEVICE && pool != NULL && pool->zero_copy))
+    {
+        LOG_INFO("Restarted the %s stream after a transfer error, %u transfers in flight", stream_name, running);
+        Lock(usbcmd->stats_lock);
+        usbcmd->stats.stream_recoveries++;
+        Unlock(usbcmd->stats_lock);
+    }
+    else
+    {
+        LOG_ERROR("Could not restart the %s stream after a transfer error", stream_name);
+        usbcmd->recovery_attempts = USB_CMD_RECOVERY_MAX_ATTEMPTS;
+        usbcmd->refill_pending = false;
+        if (usbcmd->callback != NULL)
+        {
+            usbcmd->callback(K4A_RESULT_FAILED, NULL, usbcmd->stream_context);
         }
-        // release resource for phy related changes or transfer stopped
-        usb_cmd_release_xfr(bulk_transfer);
     }
 }
 
@@ -165,6 +1154,17 @@ static int usb_cmd_lib_usb_thread(void *var)
     struct timeval tv = { 0 };
     size_t xfer_pool = usbcmd->stream_size;
     size_t max_xfr_pool = USB_CMD_MAX_XFR_POOL;
+    bool zero_copy = false;
+
+    threadpool_apply_thread_role(K4A_THREAD_ROLE_USB);
+    allocator_set_thread_numa_node(usbcmd->numa_node);
+
+    // A memory budget limits the pool to its share, in whole transfers
+    if (usbcmd->stream_endpoint == USB_CMD_DEPTH_STREAM_ENDPOINT && allocator_get_memory_budget() != 0)
+    {
+        uint32_t budget_count = allocator_budget_count(MEMORY_BUDGET_USB_TRANSFERS, usbcmd->stream_size, 1, UINT32_MAX);
+        max_xfr_pool = MIN(max_xfr_pool, (size_t)budget_count * usbcmd->stream_size);
+    }
 
     // override the xfr pool if the environment variable is defined
     const char *env_max_pool = environment_get_variable("K4A_MAX_LIBUSB_POOL");
@@ -173,6 +1173,43 @@ static int usb_cmd_lib_usb_thread(void *var)
         max_xfr_pool = (size_t)strtol(env_max_pool, NULL, 10);
     }
 
+    // Lend the transfer buffers out directly as stream images if the environment variable is defined
+    const char *env_zero_copy = environment_get_variable("K4A_LIBUSB_ZERO_COPY");
+    if (env_zero_copy != NULL && env_zero_copy[0] != '\0' && env_zero_copy[0] != '0')
+    {
+        zero_copy = true;
+    }
+
+    // Tune the number of transfers in flight at run time if the environment variable is defined. Zero copy mode binds
+    // the buffers of the pool to the transfers and keeps a fixed count.
+    const char *env_adaptive = environment_get_variable("K4A_LIBUSB_ADAPTIVE");
+    usbcmd->adaptive = env_adaptive != NULL && env_adaptive[0] != '\0' && env_adaptive[0] != '0';
+
+    // Restart the endpoint in place after a transfer error instead of ending the stream, unless the environment
+    // variable is set to 0
+    const char *env_recovery = environment_get_variable("K4A_LIBUSB_RECOVERY");
+    usbcmd->recovery = env_recovery == NULL || env_recovery[0] != '0';
+
+    // Map the depth transfer buffers from the device so usbfs receives frames into them directly instead of copying
+    // each frame out of a kernel buffer, unless the environment variable is set to 0
+    bool dev_mem = usbcmd->stream_endpoint == USB_CMD_DEPTH_STREAM_ENDPOINT;
+    const char *env_dev_mem = environment_get_variable("K4A_LIBUSB_DEV_MEM");
+    if (env_dev_mem != NULL && env_dev_mem[0] == '0')
+    {
+        dev_mem = false;
+    }
+
+    if (dev_mem && usbcmd->dev_mem_owner == NULL)
+    {
+        usbcmd->dev_mem_owner = (usb_dev_mem_owner_t *)calloc(1, sizeof(usb_dev_mem_owner_t));
+        if (usbcmd->dev_mem_owner != NULL)
+        {
+            usbcmd->dev_mem_owner->ref_count = 1;
+            usbcmd->dev_mem_owner->libusb = usbcmd->libusb;
+            usbcmd->dev_mem_owner->libusb_context = usbcmd->libusb_context;
+        }
+    }
+
     tv.tv_sec = USB_CMD_LIBUSB_EVENT_TIMEOUT;
 
     if (usbcmd->stream_size > INT32_MAX)
@@ -181,47 +1218,68 @@ static int usb_cmd_lib_usb_thread(void *var)
     }
     else
     {
-        // set up the transfers.  Limit the overall amount of resources to a predefined amount
-        for (uint32_t i = 0; (i < USB_CMD_MAX_XFR_COUNT) && (xfer_pool < max_xfr_pool); i++)
+        // Size the buffer pool from the same budget used to limit the number of outstanding transfers, plus some
+        // spares for images that are still held downstream when their transfer is resubmitted. Zero copy mode binds
+        // one buffer to each transfer and needs no spares.
+        uint32_t xfr_limit = 0;
+        for (size_t pool_size = usbcmd->stream_size; (xfr_limit < USB_CMD_MAX_XFR_COUNT) && (pool_size < max_xfr_pool);
+             pool_size += usbcmd->stream_size)
         {
-            usb_async_transfer_data_t *transfer;
-            transfer = calloc(sizeof(usb_async_transfer_data_t), sizeof(int));
-            result = K4A_RESULT_FROM_BOOL(transfer != NULL);
+            xfr_limit++;
+        }
 
-            if (K4A_SUCCEEDED(result))
-            {
-                xfer_pool += usbcmd->stream_size;
-                transfer->usbcmd = usbcmd;
-                transfer->list_index = i;
-                usbcmd->transfer_list[i] = transfer;
-                transfer->bulk_transfer = libusb_alloc_transfer(0);
-                result = K4A_RESULT_FROM_BOOL(transfer->bulk_transfer != NULL);
-            }
+        if (K4A_FAILED(TRACE_CALL(usb_xfr_pool_create(usbcmd->stream_size,
+                                                      MAX(xfr_limit, 1) +
+                                                          (zero_copy ? 0 : USB_CMD_XFR_POOL_SPARE_COUNT),
+                                                      zero_copy,
+                                                      dev_mem ? usbcmd->dev_mem_owner : NULL,
+                                                      &usbcmd->buffer_pool))))
+        {
+            // Not fatal, every transfer will allocate its buffer from the SDK allocator instead
+            LOG_WARNING("Could not allocate a pool of %zu byte transfer buffers", usbcmd->stream_size);
+            zero_copy = false;
+        }
 
-            if (K4A_SUCCEEDED(result))
-            {
-                result = TRACE_CALL(image_create_empty_internal(usbcmd->source, usbcmd->stream_size, &transfer->image));
-            }
+        usbcmd->adaptive = usbcmd->adaptive && !zero_copy;
+        usbcmd->xfr_count = 0;
+        usbcmd->xfr_limit = MAX(xfr_limit, 1);
+        usbcmd->xfr_target = usbcmd->adaptive ? MIN(usbcmd->xfr_limit, USB_CMD_ADAPTIVE_INITIAL_XFR_COUNT) :
+                                                usbcmd->xfr_limit;
+        usbcmd->window_start_usec = usb_cmd_get_time_usec();
+        usbcmd->window_bytes = 0;
+        usbcmd->window_completions = 0;
+        usbcmd->window_max_gap_usec = 0;
+        usbcmd->window_timeouts = 0;
+        usbcmd->window_submit_failures = 0;
+        usbcmd->last_completion_usec = 0;
+        usbcmd->spare_windows = 0;
+        usbcmd->recover_pending = false;
+        usbcmd->recovering = false;
+        usbcmd->refill_pending = false;
+        usbcmd->recovery_attempts = 0;
 
-            if (K4A_SUCCEEDED(result))
-            {
+        Lock(usbcmd->stats_lock);
+        memset(&usbcmd->stats, 0, sizeof(usbcmd->stats));
+        usbcmd->stats.transfer_size = (uint32_t)usbcmd->stream_size;
+        Unlock(usbcmd->stats_lock);
 
-                libusb_fill_bulk_transfer(transfer->bulk_transfer,
-                                          usbcmd->libusb,
-                                          usbcmd->stream_endpoint,
-                                          image_get_buffer(transfer->image),
-                                          (int)usbcmd->stream_size,
-                                          usb_cmd_libusb_cb,
-                                          transfer,
-                                          USB_CMD_MAX_WAIT_TIME);
+        // set up the transfers.  Limit the overall amount of resources to a predefined amount
+        for (uint32_t i = 0; (i < usbcmd->xfr_target) && (xfer_pool < max_xfr_pool); i++)
+        {
+            usb_async_transfer_data_t *transfer = NULL;
+            result = TRACE_CALL(usb_cmd_alloc_xfr(usbcmd, i, zero_copy, &transfer));
 
-                if ((err = libusb_submit_transfer(transfer->bulk_transfer)) != LIBUSB_SUCCESS)
+            if (K4A_SUCCEEDED(result))
+            {
+                xfer_pool += usbcmd->stream_size;
+                if ((err = usb_cmd_submit_xfr(transfer, false)) != LIBUSB_SUCCESS)
                 {
                     if (i == 0)
                     {
                         // Could not even submit one.  This is an error
                         LOG_ERROR("No libusb transfers could not be submitted, error:%s", libusb_error_name(err));
                         result = K4A_RESULT_FAILED;
+                        usb_cmd_release_xfr(transfer->bulk_transfer);
                     }
                     else
                     {
@@ -230,30 +1288,24 @@ static int usb_cmd_lib_usb_thread(void *var)
                         // pool needs to be adjusted
                         LOG_WARNING(
                             "Less than optimal %d libusb transfers submitted. Please evaluate available resources",
-                            i + 1);
+                            i);
+                        usb_cmd_release_xfr(transfer->bulk_transfer);
+                        usbcmd->xfr_limit = MAX(i, USB_CMD_ADAPTIVE_MIN_XFR_COUNT);
+                        usbcmd->xfr_target = i;
+                        break; // exit loop
                     }
                 }
             }
 
             if (K4A_FAILED(result))
             {
-                if (transfer)
-                {
-                    if (transfer->image)
-                    {
-                        image_dec_ref(transfer->image);
-                    }
-                    if (transfer->bulk_transfer)
-                    {
-                        libusb_free_transfer(transfer->bulk_transfer);
-                    }
-                    free(transfer);
-                }
-
-                usbcmd->transfer_list[i] = NULL;
                 break; // exit loop
             }
         }
+
+        Lock(usbcmd->stats_lock);
+        usbcmd->stats.transfer_target = usbcmd->xfr_target;
+        Unlock(usbcmd->stats_lock);
     }
 
     // loop servicing libusb
@@ -267,7 +1319,32 @@ static int usb_cmd_lib_usb_thread(void *var)
                 LOG_ERROR("Error calling libusb_handle_events_timeout failed, result:%s", libusb_error_name(err));
                 result = K4A_RESULT_FAILED;
             }
+            else
+            {
+                if (usbcmd->recover_pending)
+                {
+                    usb_cmd_recover_stream(usbcmd);
+                }
+                usb_cmd_end_window(usbcmd);
+            }
+        }
+    }
+
+    if (zero_copy)
+    {
+        // Stop resubmitting from image release. Transfers whose buffer is still held as an image are no longer
+        // tracked here; they are freed when the image is released.
+        usb_xfr_buffer_pool_t *pool = usbcmd->buffer_pool;
+        Lock(pool->lock);
+        pool->stream_active = false;
+        for (uint32_t i = 0; i < USB_CMD_MAX_XFR_COUNT; i++)
+        {
+            if (usbcmd->transfer_list[i] != NULL && usbcmd->transfer_list[i]->held)
+            {
+                usbcmd->transfer_list[i] = NULL;
+            }
         }
+        Unlock(pool->lock);
     }
 
     // cancel everything just in case of errors
@@ -286,6 +1363,13 @@ static int usb_cmd_lib_usb_thread(void *var)
         }
     }
 
+    // Images still held by consumers keep their own reference on the pool
+    if (usbcmd->buffer_pool != NULL)
+    {
+        usb_xfr_pool_dec_ref(usbcmd->buffer_pool);
+        usbcmd->buffer_pool = NULL;
+    }
+
     ThreadAPI_Exit((int)result);
     return 0;
 }
@@ -391,3 +1475,38 @@ k4a_result_t usb_cmd_stream_stop(usbcmd_t usbcmd_handle)
 
     return result;
 }
+
+/**
+ *  Function to read the telemetry of the streaming endpoint
+ *
+ *  @param usbcmd_handle
+ *   Handle of the stream
+ *
+ *  @param stats
+ *   Location to write the statistics. Counters are reset when the stream starts.
+ *
+ *  @return
+ *   K4A_RESULT_SUCCEEDED   Operation successful
+ *   K4A_RESULT_FAILED      Operation failed
+ *
+ */
+int usb_cmd_get_numa_node(usbcmd_t usbcmd_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(-1, usbcmd_t, usbcmd_handle);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+
+    return usbcmd->numa_node;
+}
+
+k4a_result_t usb_cmd_get_stream_stats(usbcmd_t usbcmd_handle, k4a_usb_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usbcmd_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+
+    Lock(usbcmd->stats_lock);
+    *stats = usbcmd->stats;
+    Unlock(usbcmd->stats_lock);
+
+    return K4A_RESULT_SUCCEEDED;
+}
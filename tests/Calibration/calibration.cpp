@@ -4,6 +4,20 @@
 #include <utcommon.h>
 #include <ut_calibration_data.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#define MKDIR(path) "if not exist " + path + " mkdir " + path
+#define RMDIR(path) "rmdir /S /Q " + path
+#define SETENV(env, value) _putenv_s(env, value)
+#else
+#define MKDIR(path) "mkdir -p " + path
+#define RMDIR(path) "rm -rf " + path
+#define SETENV(env, value) setenv(env, value, 1)
+#endif
+
 // Module being tested
 #include <k4ainternal/calibration.h>
 #include <k4ainternal/depth_mcu.h>
@@ -14,6 +28,9 @@ using namespace testing;
 #define GTEST_LOG_INFO std::cout << "[     INFO ] "
 #define FAKE_MCU ((depthmcu_t)0xface000)
 
+// Number of times the calibration was read from the fake device
+static int g_extrinsic_calibration_reads = 0;
+
 // Define the symbols needed from the usb_cmd module.
 // Only functions required to link the depth module are needed
 k4a_result_t
@@ -21,6 +38,7 @@ depthmcu_get_extrinsic_calibration(depthmcu_t depthmcu_handle, char *json, size_
 {
     (void)depthmcu_handle;
 
+    g_extrinsic_calibration_reads++;
     if (json_size < sizeof(g_test_json))
     {
         return K4A_RESULT_FAILED;
@@ -347,6 +365,96 @@ TEST(calibration_ut, validate_raw_data_api)
     free(json);
 }
 
+static std::string read_file(const std::string &path)
+{
+    std::string contents;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file != NULL)
+    {
+        int c;
+        while ((c = fgetc(file)) != EOF)
+        {
+            contents.push_back((char)c);
+        }
+        fclose(file);
+    }
+    return contents;
+}
+
+static void write_file(const std::string &path, const std::string &contents)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, (FILE *)NULL);
+    ASSERT_EQ(fwrite(contents.data(), 1, contents.size(), file), contents.size());
+    fclose(file);
+}
+
+TEST(calibration_ut, calibration_cache)
+{
+    calibration_t calibration;
+    k4a_calibration_camera_t depth;
+    k4a_calibration_camera_t depth_expected;
+    depthmcu_firmware_versions_t version = {};
+    version.depth_major = 1;
+    version.depth_minor = 6;
+    version.depth_build = 79;
+
+    const std::string device_json(g_test_json, sizeof(g_test_json));
+    const std::string cache_dir = "calibration_cache_test_temp";
+    const std::string cache_path = cache_dir + "/k4a_calibration_000123456789_0.0.0_1.6.79_0.0.0_0.0.json";
+    ASSERT_EQ(system((MKDIR(cache_dir)).c_str()), 0);
+    ASSERT_EQ(SETENV("K4A_CALIBRATION_CACHE_DIR", cache_dir.c_str()), 0);
+
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", &version, NULL), K4A_RESULT_FAILED);
+
+    // Without a serial number or version the cache is not used
+    g_extrinsic_calibration_reads = 0;
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, NULL, &version, &calibration), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(calibration_get_camera(calibration, K4A_CALIBRATION_TYPE_DEPTH, &depth_expected), K4A_RESULT_SUCCEEDED);
+    calibration_destroy(calibration);
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", NULL, &calibration), K4A_RESULT_SUCCEEDED);
+    calibration_destroy(calibration);
+    ASSERT_EQ(g_extrinsic_calibration_reads, 2);
+    ASSERT_EQ(read_file(cache_path), "");
+
+    // A cache miss reads the device and stores the calibration
+    g_extrinsic_calibration_reads = 0;
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", &version, &calibration), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(g_extrinsic_calibration_reads, 1);
+    calibration_destroy(calibration);
+    ASSERT_EQ(read_file(cache_path), device_json);
+
+    // A cache hit is validated against the device in the background
+    g_extrinsic_calibration_reads = 0;
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", &version, &calibration), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(calibration_get_camera(calibration, K4A_CALIBRATION_TYPE_DEPTH, &depth), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(memcmp(&depth, &depth_expected, sizeof(depth)), 0);
+    calibration_destroy(calibration);
+    ASSERT_EQ(g_extrinsic_calibration_reads, 1);
+    ASSERT_EQ(read_file(cache_path), device_json);
+
+    // A valid calibration that does not match the device is refreshed
+    std::string stale_json(g_test_json);
+    stale_json.insert(1, " ");
+    write_file(cache_path, stale_json);
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", &version, &calibration), K4A_RESULT_SUCCEEDED);
+    calibration_destroy(calibration);
+    ASSERT_EQ(read_file(cache_path), device_json);
+
+    // A corrupted cache file is read from the device instead
+    write_file(cache_path, "not a calibration");
+    g_extrinsic_calibration_reads = 0;
+    ASSERT_EQ(calibration_create_cached(FAKE_MCU, "000123456789", &version, &calibration), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(g_extrinsic_calibration_reads, 1);
+    ASSERT_EQ(calibration_get_camera(calibration, K4A_CALIBRATION_TYPE_DEPTH, &depth), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(memcmp(&depth, &depth_expected, sizeof(depth)), 0);
+    calibration_destroy(calibration);
+    ASSERT_EQ(read_file(cache_path), device_json);
+
+    ASSERT_EQ(SETENV("K4A_CALIBRATION_CACHE_DIR", ""), 0);
+    ASSERT_EQ(system((RMDIR(cache_dir)).c_str()), 0);
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_common_main(argc, argv);
@@ -7,6 +7,7 @@
 
 #include <k4ainternal/capturesync.h>
 #include <k4ainternal/capture.h>
+#include <k4ainternal/common.h>
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/threadapi.h>
 #include <azure_c_shared_utility/condition.h>
@@ -829,3 +830,392 @@ TEST(capturesync_ut, test_d_DropIndividualSamplesToCaller_v2)
     capturesync_validate_synchronization(copy, DEPTH_FIRST, true);
     free(copy);
 }
+
+typedef struct _capture_callback_test_t
+{
+    int succeeded_count;
+    int failed_count;
+    bool last_capture_synchronized;
+} capture_callback_test_t;
+
+static void capture_callback_test_cb(k4a_result_t result, k4a_capture_t capture, void *context)
+{
+    capture_callback_test_t *test = (capture_callback_test_t *)context;
+
+    if (K4A_FAILED(result))
+    {
+        EXPECT_EQ(capture, (k4a_capture_t)NULL);
+        test->failed_count++;
+        return;
+    }
+
+    k4a_image_t color = capture_get_color_image(capture);
+    k4a_image_t depth = capture_get_depth_image(capture);
+    test->last_capture_synchronized = color != NULL && depth != NULL;
+    if (color)
+    {
+        image_dec_ref(color);
+    }
+    if (depth)
+    {
+        image_dec_ref(depth);
+    }
+    test->succeeded_count++;
+}
+
+TEST(capturesync_ut, capture_callback)
+{
+    k4a_capture_t capture;
+    capturesync_t sync;
+    capture_callback_test_t test = { 0, 0, false };
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_set_capture_callback(NULL, capture_callback_test_cb, &test), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_set_capture_callback(sync, capture_callback_test_cb, &test), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+
+    // The synchronized capture goes to the callback and not the queue
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(1, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.succeeded_count, 0);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(1, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.succeeded_count, 1);
+    ASSERT_TRUE(test.last_capture_synchronized);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_TIMEOUT);
+
+    // Clearing the callback returns to queueing captures
+    ASSERT_EQ(capturesync_set_capture_callback(sync, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(2, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(2, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.succeeded_count, 1);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    capture_dec_ref(capture);
+
+    // A streaming error is reported through the callback
+    ASSERT_EQ(capturesync_set_capture_callback(sync, capture_callback_test_cb, &test), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_FAILED, sync, DEPTH_CAPTURE, FPS_30_US(3, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.failed_count, 1);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
+
+typedef struct _depth_callback_test_t
+{
+    int depth_count;
+    int failed_count;
+    uint64_t last_depth_ts;
+    bool last_capture_has_color;
+} depth_callback_test_t;
+
+static void depth_callback_test_cb(k4a_result_t result, k4a_capture_t capture, void *context)
+{
+    depth_callback_test_t *test = (depth_callback_test_t *)context;
+
+    if (K4A_FAILED(result))
+    {
+        EXPECT_EQ(capture, (k4a_capture_t)NULL);
+        test->failed_count++;
+        return;
+    }
+
+    k4a_image_t color = capture_get_color_image(capture);
+    k4a_image_t depth = capture_get_depth_image(capture);
+    test->last_capture_has_color = color != NULL;
+    if (color)
+    {
+        image_dec_ref(color);
+    }
+    if (depth)
+    {
+        test->last_depth_ts = image_get_device_timestamp_usec(depth);
+        image_dec_ref(depth);
+    }
+    test->depth_count++;
+}
+
+TEST(capturesync_ut, depth_capture_callback)
+{
+    k4a_capture_t capture;
+    capturesync_t sync;
+    depth_callback_test_t test = { 0, 0, 0, false };
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_set_depth_capture_callback(NULL, depth_callback_test_cb, &test), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_set_depth_capture_callback(sync, depth_callback_test_cb, &test), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+
+    // Depth is delivered before any color has arrived
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(1, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.depth_count, 1);
+    ASSERT_EQ(test.last_depth_ts, (uint64_t)(FPS_30_US(1, 5)));
+    ASSERT_FALSE(test.last_capture_has_color);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_TIMEOUT);
+
+    // The matching color follows in a synchronized capture with the same depth image, the depth callback isn't called
+    // again and doesn't see color
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(1, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.depth_count, 1);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    k4a_image_t color = capture_get_color_image(capture);
+    k4a_image_t depth = capture_get_depth_image(capture);
+    ASSERT_NE(color, (k4a_image_t)NULL);
+    ASSERT_NE(depth, (k4a_image_t)NULL);
+    ASSERT_EQ(image_get_device_timestamp_usec(depth), (uint64_t)(FPS_30_US(1, 5)));
+    image_dec_ref(color);
+    image_dec_ref(depth);
+    capture_dec_ref(capture);
+
+    // Clearing the callback stops early depth delivery
+    ASSERT_EQ(capturesync_set_depth_capture_callback(sync, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(2, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.depth_count, 1);
+
+    // A streaming error is reported through the callback
+    ASSERT_EQ(capturesync_set_depth_capture_callback(sync, depth_callback_test_cb, &test), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_FAILED, sync, DEPTH_CAPTURE, FPS_30_US(3, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.failed_count, 1);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
+
+TEST(capturesync_ut, capture_stats)
+{
+    k4a_capture_t capture;
+    capturesync_t sync;
+    k4a_capture_stats_t stats;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_get_stats(NULL, &stats), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_get_stats(sync, NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+
+    // Depth from before the timestamp reset is dropped
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(20, 0)),
+              K4A_RESULT_SUCCEEDED);
+
+    // A matched pair
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(1, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(1, 5)),
+              K4A_RESULT_SUCCEEDED);
+
+    // Color without depth, followed by a matched pair
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(2, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(4, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(4, 5)),
+              K4A_RESULT_SUCCEEDED);
+
+    // Color waiting for its depth
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(5, 0)),
+              K4A_RESULT_SUCCEEDED);
+
+    ASSERT_EQ(capturesync_get_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.synchronized_captures, 2u);
+    ASSERT_EQ(stats.depth_dropped_timestamp_reset, 1u);
+    ASSERT_EQ(stats.color_unmatched, 1u);
+    ASSERT_EQ(stats.depth_unmatched, 0u);
+    ASSERT_EQ(stats.color_queue_overflow, 0u);
+    ASSERT_EQ(stats.depth_queue_overflow, 0u);
+    ASSERT_EQ(stats.output_queue_overflow, 0u);
+    ASSERT_EQ(stats.average_skew_usec, (int64_t)(FPS_30_US(1, 5)) - (int64_t)(FPS_30_US(1, 0)));
+    ASSERT_EQ(stats.color_queue_count, 1u);
+    ASSERT_EQ(stats.depth_queue_count, 0u);
+    ASSERT_EQ(stats.output_queue_count, 3u);
+
+    // Reading captures drains the output queue
+    while (capturesync_get_capture(sync, &capture, 0) == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        capture_dec_ref(capture);
+    }
+    ASSERT_EQ(capturesync_get_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.output_queue_count, 0u);
+
+    // Restarting resets the counters
+    capturesync_stop(sync);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_get_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.synchronized_captures, 0u);
+    ASSERT_EQ(stats.color_unmatched, 0u);
+    ASSERT_EQ(stats.average_skew_usec, 0);
+    ASSERT_EQ(stats.color_queue_count, 0u);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
+
+TEST(capturesync_ut, capture_queue_policy)
+{
+    k4a_capture_t capture;
+    capturesync_t sync;
+    k4a_capture_stats_t stats;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_set_queue_policy(NULL, 1, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_set_queue_policy(sync, 1, (k4a_queue_policy_t)10), K4A_RESULT_FAILED);
+
+    // Latest capture only
+    ASSERT_EQ(capturesync_set_queue_policy(sync, 1, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_set_queue_policy(sync, 2, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_FAILED);
+
+    for (int i = 1; i <= 3; i++)
+    {
+        ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(i, 0)),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(i, 5)),
+                  K4A_RESULT_SUCCEEDED);
+    }
+
+    ASSERT_EQ(capturesync_get_stats(sync, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.synchronized_captures, 3u);
+    ASSERT_EQ(stats.output_queue_overflow, 2u);
+    ASSERT_EQ(stats.output_queue_count, 1u);
+
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    k4a_image_t color = capture_get_color_image(capture);
+    ASSERT_NE(color, (k4a_image_t)NULL);
+    ASSERT_EQ(image_get_device_timestamp_usec(color), (uint64_t)(FPS_30_US(3, 0)));
+    image_dec_ref(color);
+    capture_dec_ref(capture);
+    capturesync_stop(sync);
+
+    // Keep the first captures instead
+    ASSERT_EQ(capturesync_set_queue_policy(sync, 1, K4A_QUEUE_POLICY_DROP_NEWEST), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+    for (int i = 1; i <= 3; i++)
+    {
+        ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(i, 0)),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(i, 5)),
+                  K4A_RESULT_SUCCEEDED);
+    }
+
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    color = capture_get_color_image(capture);
+    ASSERT_NE(color, (k4a_image_t)NULL);
+    ASSERT_EQ(image_get_device_timestamp_usec(color), (uint64_t)(FPS_30_US(1, 0)));
+    image_dec_ref(color);
+    capture_dec_ref(capture);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_TIMEOUT);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
+
+typedef struct _imu_samples_callback_test_t
+{
+    int count;
+    uint64_t start_usec;
+    uint64_t end_usec;
+} imu_samples_callback_test_t;
+
+static void imu_samples_callback_test_cb(k4a_capture_t capture, uint64_t start_usec, uint64_t end_usec, void *context)
+{
+    imu_samples_callback_test_t *test = (imu_samples_callback_test_t *)context;
+    test->count++;
+    test->start_usec = start_usec;
+    test->end_usec = end_usec;
+
+    // The capture takes ownership of the samples
+    k4a_imu_sample_t *samples = (k4a_imu_sample_t *)malloc(2 * sizeof(k4a_imu_sample_t));
+    ASSERT_NE(samples, (k4a_imu_sample_t *)NULL);
+    memset(samples, 0, 2 * sizeof(k4a_imu_sample_t));
+    samples[0].acc_timestamp_usec = start_usec;
+    samples[1].acc_timestamp_usec = end_usec;
+    capture_set_imu_samples(capture, samples, 2);
+}
+
+TEST(capturesync_ut, imu_samples_callback)
+{
+    k4a_capture_t capture;
+    capturesync_t sync;
+    imu_samples_callback_test_t test = { 0, 0, 0 };
+    k4a_imu_sample_t samples[2];
+    size_t sample_count = 0;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(capturesync_create(&sync), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_set_imu_samples_callback(NULL, imu_samples_callback_test_cb, &test), K4A_RESULT_FAILED);
+    ASSERT_EQ(capturesync_set_imu_samples_callback(sync, imu_samples_callback_test_cb, &test), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_start(sync, &config), K4A_RESULT_SUCCEEDED);
+
+    // The images of the test don't report an exposure, so each one spans half a frame period on each side
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(1, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.count, 0);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(1, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.count, 1);
+    ASSERT_EQ(test.start_usec, (uint64_t)(FPS_30_US(1, 0)) - HZ_TO_PERIOD_US(30) / 2);
+    ASSERT_EQ(test.end_usec, (uint64_t)(FPS_30_US(1, 5)) + HZ_TO_PERIOD_US(30) / 2);
+
+    // The samples attached by the callback are read from the published capture
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_get_imu_samples(capture, NULL, &sample_count), K4A_BUFFER_RESULT_TOO_SMALL);
+    ASSERT_EQ(sample_count, 2u);
+    sample_count = 1;
+    ASSERT_EQ(capture_get_imu_samples(capture, samples, &sample_count), K4A_BUFFER_RESULT_TOO_SMALL);
+    sample_count = COUNTOF(samples);
+    ASSERT_EQ(capture_get_imu_samples(capture, samples, &sample_count), K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, 2u);
+    ASSERT_EQ(samples[0].acc_timestamp_usec, test.start_usec);
+    ASSERT_EQ(samples[1].acc_timestamp_usec, test.end_usec);
+    capture_dec_ref(capture);
+
+    // Clearing the callback publishes captures without samples
+    ASSERT_EQ(capturesync_set_imu_samples_callback(sync, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, COLOR_CAPTURE, FPS_30_US(2, 0)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(capturesync_push_single_capture(K4A_RESULT_SUCCEEDED, sync, DEPTH_CAPTURE, FPS_30_US(2, 5)),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.count, 1);
+    ASSERT_EQ(capturesync_get_capture(sync, &capture, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    sample_count = 0;
+    ASSERT_EQ(capture_get_imu_samples(capture, NULL, &sample_count), K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, 0u);
+    capture_dec_ref(capture);
+
+    capturesync_stop(sync);
+    capturesync_destroy(sync);
+}
@@ -10,6 +10,7 @@
 #include <k4ainternal/depth_mcu.h>
 #include <k4ainternal/calibration.h>
 #include <k4ainternal/dewrapper.h>
+#include <k4ainternal/depthfilter.h>
 
 using namespace testing;
 
@@ -103,6 +104,12 @@ bool depthmcu_wait_is_ready(depthmcu_t depthmcu_handle)
 {
     return g_MockDepthMcu->depthmcu_wait_is_ready(depthmcu_handle);
 }
+
+int depthmcu_get_numa_node(depthmcu_t depthmcu_handle)
+{
+    (void)depthmcu_handle;
+    return -1;
+}
 }
 
 // k4a_result_t depthmcu_get_serialnum(depthmcu_t depthmcu_handle, char* serial_number, size_t*
@@ -198,6 +205,72 @@ void dewrapper_destroy(dewrapper_t dewrapper_handle)
 {
     (void)dewrapper_handle;
 }
+void dewrapper_set_numa_node(dewrapper_t dewrapper_handle, int numa_node)
+{
+    (void)dewrapper_handle;
+    (void)numa_node;
+}
+void dewrapper_set_depth_engine_gpu(dewrapper_t dewrapper_handle, int32_t gpu_index)
+{
+    (void)dewrapper_handle;
+    (void)gpu_index;
+}
+void dewrapper_set_depth_engine_shared(dewrapper_t dewrapper_handle, bool shared)
+{
+    (void)dewrapper_handle;
+    (void)shared;
+}
+void dewrapper_set_keep_depth_engine(dewrapper_t dewrapper_handle, bool keep)
+{
+    (void)dewrapper_handle;
+    (void)keep;
+}
+void dewrapper_set_depth_filter(dewrapper_t dewrapper_handle, const k4a_depth_filter_configuration_t *config)
+{
+    (void)dewrapper_handle;
+    (void)config;
+}
+void dewrapper_set_depth_gpu_export(dewrapper_t dewrapper_handle, const k4a_depth_gpu_export_configuration_t *config)
+{
+    (void)dewrapper_handle;
+    (void)config;
+}
+void dewrapper_set_depth_only(dewrapper_t dewrapper_handle, bool depth_only)
+{
+    (void)dewrapper_handle;
+    (void)depth_only;
+}
+void dewrapper_set_frame_decimation(dewrapper_t dewrapper_handle, uint32_t decimation)
+{
+    (void)dewrapper_handle;
+    (void)decimation;
+}
+void dewrapper_set_ir8_output(dewrapper_t dewrapper_handle, const k4a_ir8_configuration_t *config)
+{
+    (void)dewrapper_handle;
+    (void)config;
+}
+void dewrapper_set_overload_policy(dewrapper_t dewrapper_handle,
+                                   const k4a_depth_engine_overload_configuration_t *config)
+{
+    (void)dewrapper_handle;
+    (void)config;
+}
+void dewrapper_get_stats(dewrapper_t dewrapper_handle, dewrapper_stats_t *stats)
+{
+    (void)dewrapper_handle;
+    *stats = {};
+}
+k4a_result_t depthfilter_validate_configuration(const k4a_depth_filter_configuration_t *config)
+{
+    (void)config;
+    return K4A_RESULT_SUCCEEDED;
+}
+k4a_result_t depthfilter_validate_ir8_configuration(const k4a_ir8_configuration_t *config)
+{
+    (void)config;
+    return K4A_RESULT_SUCCEEDED;
+}
 k4a_result_t dewrapper_start(dewrapper_t dewrapper_handle,
                              const k4a_device_configuration_t *config,
                              uint8_t *calibration_memory,
@@ -213,6 +286,12 @@ void dewrapper_stop(dewrapper_t dewrapper_handle)
 {
     (void)dewrapper_handle;
 }
+k4a_result_t dewrapper_restart(dewrapper_t dewrapper_handle, const k4a_device_configuration_t *config)
+{
+    (void)dewrapper_handle;
+    (void)config;
+    return K4A_RESULT_SUCCEEDED;
+}
 void dewrapper_post_capture(k4a_result_t cb_result, k4a_capture_t capture_raw, void *context)
 {
     (void)cb_result;
@@ -314,6 +393,123 @@ TEST_F(depth_ut, serialnum)
     depth_destroy(depth_handle);
 }
 
+TEST_F(depth_ut, depth_engine_gpu)
+{
+    // Create the depth instance
+    depth_t depth_handle = NULL;
+
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_MCU, &calibration_handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_create(FAKE_MCU, calibration_handle, NULL, NULL, &depth_handle));
+    ASSERT_NE(depth_handle, (depth_t)NULL);
+
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_set_depth_engine_gpu(NULL, K4A_DEPTH_ENGINE_GPU_AUTO));
+
+    // The GPU is only used when the depth engine starts, so any value is accepted while stopped
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_gpu(depth_handle, K4A_DEPTH_ENGINE_GPU_AUTO));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_gpu(depth_handle, 1));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_gpu(depth_handle, K4A_DEPTH_ENGINE_GPU_DEFAULT));
+
+    calibration_destroy(calibration_handle);
+    depth_destroy(depth_handle);
+}
+
+TEST_F(depth_ut, depth_engine_settings)
+{
+    // Create the depth instance
+    depth_t depth_handle = NULL;
+
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_MCU, &calibration_handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_create(FAKE_MCU, calibration_handle, NULL, NULL, &depth_handle));
+    ASSERT_NE(depth_handle, (depth_t)NULL);
+
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_set_depth_engine_shared(NULL, true));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_shared(depth_handle, true));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_shared(depth_handle, false));
+
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_set_depth_engine_keep_alive(NULL, true));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_keep_alive(depth_handle, true));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_keep_alive(depth_handle, false));
+
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_set_frame_decimation(NULL, 3));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_frame_decimation(depth_handle, 3));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_frame_decimation(depth_handle, 0));
+
+    k4a_depth_engine_overload_configuration_t overload_config = { 3, NULL, NULL };
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_set_depth_engine_overload_policy(NULL, &overload_config));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_overload_policy(depth_handle, &overload_config));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_set_depth_engine_overload_policy(depth_handle, NULL));
+
+    calibration_destroy(calibration_handle);
+    depth_destroy(depth_handle);
+}
+
+TEST_F(depth_ut, reconfigure)
+{
+    // Create the depth instance
+    depth_t depth_handle = NULL;
+
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_MCU, &calibration_handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_create(FAKE_MCU, calibration_handle, NULL, NULL, &depth_handle));
+    ASSERT_NE(depth_handle, (depth_t)NULL);
+
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_reconfigure(NULL, &config));
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_reconfigure(depth_handle, NULL));
+
+    // The sensor must be streaming
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_reconfigure(depth_handle, &config));
+
+    EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_set_capture_mode(FAKE_MCU, K4A_DEPTH_MODE_NFOV_UNBINNED))
+        .WillOnce(Return(K4A_RESULT_SUCCEEDED));
+    EXPECT_CALL(m_MockDepthMcu, depthmcu_get_cal(FAKE_MCU, _, _, _))
+        .WillOnce(Invoke([](Unused, Unused, size_t cal_size, size_t *bytes_read) {
+            *bytes_read = cal_size;
+            return K4A_RESULT_SUCCEEDED;
+        }));
+    EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_set_fps(FAKE_MCU, K4A_FRAMES_PER_SECOND_30))
+        .WillOnce(Return(K4A_RESULT_SUCCEEDED));
+    EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_start_streaming(FAKE_MCU, _, _)).WillOnce(Return(K4A_RESULT_SUCCEEDED));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_start(depth_handle, &config));
+    Mock::VerifyAndClearExpectations(&m_MockDepthMcu);
+
+    // Only the stream restarts, in the new mode and at the new rate, without reading the calibration again
+    config.depth_mode = K4A_DEPTH_MODE_WFOV_2X2BINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_15;
+    {
+        InSequence sequence;
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_stop_streaming(FAKE_MCU, false));
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_set_capture_mode(FAKE_MCU, K4A_DEPTH_MODE_WFOV_2X2BINNED))
+            .WillOnce(Return(K4A_RESULT_SUCCEEDED));
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_set_fps(FAKE_MCU, K4A_FRAMES_PER_SECOND_15))
+            .WillOnce(Return(K4A_RESULT_SUCCEEDED));
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_start_streaming(FAKE_MCU, _, _))
+            .WillOnce(Return(K4A_RESULT_SUCCEEDED));
+    }
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depth_reconfigure(depth_handle, &config));
+    Mock::VerifyAndClearExpectations(&m_MockDepthMcu);
+
+    // A failed reconfiguration stops the sensor
+    {
+        InSequence sequence;
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_stop_streaming(FAKE_MCU, false));
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_set_capture_mode(FAKE_MCU, K4A_DEPTH_MODE_WFOV_2X2BINNED))
+            .WillOnce(Return(K4A_RESULT_FAILED));
+        EXPECT_CALL(m_MockDepthMcu, depthmcu_depth_stop_streaming(FAKE_MCU, false));
+    }
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_reconfigure(depth_handle, &config));
+    ASSERT_EQ(K4A_RESULT_FAILED, depth_reconfigure(depth_handle, &config));
+    Mock::VerifyAndClearExpectations(&m_MockDepthMcu);
+
+    calibration_destroy(calibration_handle);
+    depth_destroy(depth_handle);
+}
+
 // Function prototype for the Depth module API we want to test.
 extern "C" bool is_fw_version_compatable(const char *fw_type, k4a_version_t *fw_version, k4a_version_t *fw_min_version);
 
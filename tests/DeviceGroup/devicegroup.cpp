@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <gtest/gtest.h>
+
+#include <k4ainternal/devicegroup.h>
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/image.h>
+
+#define FPS_30_IN_US (1000000 / 30)
+
+// Timestamp of a capture number plus a percentage of the frame period
+#define FPS_30_US(captureNum, percent) ((FPS_30_IN_US * (captureNum)) + ((percent)*FPS_30_IN_US / 100))
+
+#define SUBORDINATE_DELAY_USEC (160)
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+static void push_capture(devicegroup_t group, uint32_t device_index, bool color, uint64_t timestamp)
+{
+    k4a_capture_t capture = NULL;
+    k4a_image_t image = NULL;
+
+    ASSERT_EQ(capture_create(&capture), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create_empty_internal(color ? ALLOCATION_SOURCE_COLOR : ALLOCATION_SOURCE_DEPTH, 10, &image),
+              K4A_RESULT_SUCCEEDED);
+    image_set_device_timestamp_usec(image, timestamp);
+    if (color)
+    {
+        capture_set_color_image(capture, image);
+    }
+    else
+    {
+        capture_set_depth_image(capture, image);
+        capture_set_ir_image(capture, image);
+    }
+    image_dec_ref(image);
+
+    devicegroup_add_capture(group, device_index, K4A_RESULT_SUCCEEDED, capture);
+    capture_dec_ref(capture);
+}
+
+static uint64_t get_color_timestamp(k4a_capture_t capture)
+{
+    k4a_image_t image = capture_get_color_image(capture);
+    EXPECT_NE(image, (k4a_image_t)NULL);
+    uint64_t ts = image_get_device_timestamp_usec(image);
+    image_dec_ref(image);
+    return ts;
+}
+
+static void release_captures(k4a_capture_t *captures, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        capture_dec_ref(captures[i]);
+    }
+}
+
+static void init_configs(k4a_device_configuration_t *configs, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        configs[i] = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+        configs[i].color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+        configs[i].color_resolution = K4A_COLOR_RESOLUTION_1080P;
+        configs[i].depth_mode = K4A_DEPTH_MODE_NFOV_2X2BINNED;
+        configs[i].camera_fps = K4A_FRAMES_PER_SECOND_30;
+        configs[i].wired_sync_mode = i == 0 ? K4A_WIRED_SYNC_MODE_MASTER : K4A_WIRED_SYNC_MODE_SUBORDINATE;
+        configs[i].subordinate_delay_off_master_usec = i == 0 ? 0 : SUBORDINATE_DELAY_USEC;
+    }
+}
+
+TEST(devicegroup_ut, create)
+{
+    devicegroup_t group = NULL;
+    ASSERT_EQ(devicegroup_create(0, &group), K4A_RESULT_FAILED);
+    ASSERT_EQ(devicegroup_create(DEVICEGROUP_MAX_DEVICES + 1, &group), K4A_RESULT_FAILED);
+    ASSERT_EQ(devicegroup_create(2, NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(devicegroup_create(DEVICEGROUP_MAX_DEVICES, &group), K4A_RESULT_SUCCEEDED);
+
+    k4a_capture_t captures[DEVICEGROUP_MAX_DEVICES];
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 0), K4A_WAIT_RESULT_FAILED);
+
+    // All devices must run at the same frame rate
+    k4a_device_configuration_t configs[DEVICEGROUP_MAX_DEVICES];
+    init_configs(configs, DEVICEGROUP_MAX_DEVICES);
+    configs[3].camera_fps = K4A_FRAMES_PER_SECOND_15;
+    ASSERT_EQ(devicegroup_start(group, configs), K4A_RESULT_FAILED);
+
+    devicegroup_destroy(group);
+}
+
+TEST(devicegroup_ut, match)
+{
+    const uint32_t device_count = 3;
+    devicegroup_t group = NULL;
+    k4a_device_configuration_t configs[device_count];
+    k4a_capture_t captures[device_count];
+    uint64_t skew_usec = 0;
+
+    init_configs(configs, device_count);
+    ASSERT_EQ(devicegroup_create(device_count, &group), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(devicegroup_start(group, configs), K4A_RESULT_SUCCEEDED);
+
+    // A set is only complete when every device has a capture
+    push_capture(group, 0, true, FPS_30_US(1, 0));
+    push_capture(group, 1, true, FPS_30_US(1, 0) + SUBORDINATE_DELAY_USEC);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, &skew_usec, 0), K4A_WAIT_RESULT_TIMEOUT);
+    push_capture(group, 2, true, FPS_30_US(1, 1) + SUBORDINATE_DELAY_USEC);
+
+    ASSERT_EQ(devicegroup_get_capture(group, captures, &skew_usec, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(get_color_timestamp(captures[0]), (uint64_t)FPS_30_US(1, 0));
+    ASSERT_EQ(get_color_timestamp(captures[1]), (uint64_t)(FPS_30_US(1, 0) + SUBORDINATE_DELAY_USEC));
+    ASSERT_EQ(get_color_timestamp(captures[2]), (uint64_t)(FPS_30_US(1, 1) + SUBORDINATE_DELAY_USEC));
+    ASSERT_EQ(skew_usec, (uint64_t)(FPS_30_US(1, 1) - FPS_30_US(1, 0)));
+    release_captures(captures, device_count);
+
+    // Device 1 misses frame 2, the frame 2 captures of the other devices are dropped once frame 3 arrives
+    push_capture(group, 0, true, FPS_30_US(2, 0));
+    push_capture(group, 2, true, FPS_30_US(2, 0) + SUBORDINATE_DELAY_USEC);
+    push_capture(group, 1, true, FPS_30_US(3, 0) + SUBORDINATE_DELAY_USEC);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 0), K4A_WAIT_RESULT_TIMEOUT);
+    push_capture(group, 0, true, FPS_30_US(3, 0));
+    push_capture(group, 2, true, FPS_30_US(3, 0) + SUBORDINATE_DELAY_USEC);
+
+    ASSERT_EQ(devicegroup_get_capture(group, captures, &skew_usec, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(get_color_timestamp(captures[0]), (uint64_t)FPS_30_US(3, 0));
+    ASSERT_EQ(skew_usec, 0u);
+    release_captures(captures, device_count);
+    ASSERT_EQ(devicegroup_get_dropped_count(group), 2u);
+
+    // A device with only depth lines up through depth_delay_off_color_usec
+    devicegroup_stop(group);
+    configs[2].color_resolution = K4A_COLOR_RESOLUTION_OFF;
+    configs[2].depth_delay_off_color_usec = 500;
+    ASSERT_EQ(devicegroup_start(group, configs), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(devicegroup_get_dropped_count(group), 0u);
+    push_capture(group, 0, true, FPS_30_US(4, 0));
+    push_capture(group, 1, true, FPS_30_US(4, 0) + SUBORDINATE_DELAY_USEC);
+    push_capture(group, 2, false, FPS_30_US(4, 0) + SUBORDINATE_DELAY_USEC + 500);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, &skew_usec, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(skew_usec, 0u);
+    release_captures(captures, device_count);
+
+    // A stream error fails the readers once the matched sets are read
+    push_capture(group, 0, true, FPS_30_US(5, 0));
+    push_capture(group, 1, true, FPS_30_US(5, 0) + SUBORDINATE_DELAY_USEC);
+    push_capture(group, 2, false, FPS_30_US(5, 0) + SUBORDINATE_DELAY_USEC + 500);
+    devicegroup_add_capture(group, 1, K4A_RESULT_FAILED, NULL);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    release_captures(captures, device_count);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 100), K4A_WAIT_RESULT_FAILED);
+
+    devicegroup_stop(group);
+    devicegroup_destroy(group);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(devicegroup_ut, stop_releases_captures)
+{
+    const uint32_t device_count = 2;
+    devicegroup_t group = NULL;
+    k4a_device_configuration_t configs[device_count];
+    k4a_capture_t captures[device_count];
+
+    init_configs(configs, device_count);
+    ASSERT_EQ(devicegroup_create(device_count, &group), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(devicegroup_start(group, configs), K4A_RESULT_SUCCEEDED);
+
+    // One matched set and one pending capture are still held
+    push_capture(group, 0, true, FPS_30_US(1, 0));
+    push_capture(group, 1, true, FPS_30_US(1, 0) + SUBORDINATE_DELAY_USEC);
+    push_capture(group, 0, true, FPS_30_US(2, 0));
+
+    devicegroup_stop(group);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 0), K4A_WAIT_RESULT_FAILED);
+
+    // Captures are not accepted while stopped
+    push_capture(group, 0, true, FPS_30_US(3, 0));
+    push_capture(group, 1, true, FPS_30_US(3, 0) + SUBORDINATE_DELAY_USEC);
+    ASSERT_EQ(devicegroup_get_capture(group, captures, NULL, 0), K4A_WAIT_RESULT_FAILED);
+
+    devicegroup_destroy(group);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
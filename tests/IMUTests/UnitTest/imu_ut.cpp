@@ -10,6 +10,7 @@
 #include <k4ainternal/color_mcu.h>
 #include <k4ainternal/depth_mcu.h>
 #include <k4ainternal/calibration.h>
+#include <k4ainternal/math.h>
 
 using namespace testing;
 
@@ -350,6 +351,237 @@ TEST_F(imu_ut, get_sample)
     calibration_destroy(calibration_handle);
 }
 
+// Delivers a packet of sample_count samples with the gyro and accelerometer timestamps first_pts, first_pts + 9, ...
+// and readings that vary per sample
+static void imu_packet_deliver(uint32_t sample_count, uint64_t first_pts, int16_t temperature_value = 0)
+{
+    size_t imu_alloc_size = sizeof(imu_payload_metadata_t) + sizeof(xyz_vector_t) * 2 * sample_count;
+    k4a_capture_t cb_capture = capture_manufacture(imu_alloc_size);
+    ASSERT_NE(cb_capture, (k4a_capture_t)NULL);
+    k4a_image_t image = capture_get_imu_image(cb_capture);
+    uint8_t *buffer = image_get_buffer(image);
+    memset(buffer, 0, imu_alloc_size);
+
+    imu_payload_metadata_t *p_imu_packet = (imu_payload_metadata_t *)buffer;
+    p_imu_packet->temperature.value = temperature_value;
+    p_imu_packet->gyro.sensitivity = 1000;
+    p_imu_packet->gyro.sample_count = sample_count;
+    p_imu_packet->accel.sensitivity = 1000;
+    p_imu_packet->accel.sample_count = sample_count;
+    xyz_vector_t *p_samples = (xyz_vector_t *)(buffer + sizeof(imu_payload_metadata_t));
+    for (uint32_t i = 0; i < sample_count; i++)
+    {
+        xyz_vector_t *gyro = &p_samples[i];
+        xyz_vector_t *accel = &p_samples[sample_count + i];
+        gyro->pts = accel->pts = first_pts + 9 * i;
+        gyro->rx = (int16_t)(100 + i);
+        gyro->ry = (int16_t)(-200 + 3 * i);
+        gyro->rz = (int16_t)(300 - 7 * i);
+        accel->rx = (int16_t)(-1000 + 11 * i);
+        accel->ry = (int16_t)(500 - 13 * i);
+        accel->rz = (int16_t)(9000 + 17 * i);
+    }
+
+    g_MockColorMcu->frame_ready_cb(K4A_RESULT_SUCCEEDED, image, g_MockColorMcu->cb_context);
+    image_dec_ref(image);
+    capture_dec_ref(cb_capture);
+}
+
+TEST_F(imu_ut, get_samples)
+{
+    // Create the  instance
+    imu_t imu_handle = NULL;
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_DEPTH_MCU, &calibration_handle));
+    k4a_imu_sample_t imu_samples[2000];
+    size_t sample_count = 0;
+    TICK_COUNTER_HANDLE tick;
+
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, FAKE_COLOR_MCU, calibration_handle, &imu_handle));
+    ASSERT_NE(imu_handle, (imu_t)NULL);
+
+    // Fail if not started
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, imu_samples, 10, &sample_count, 10));
+
+    // Start the imu
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+
+    // validate input checking
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(NULL, imu_samples, 10, &sample_count, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, NULL, 10, &sample_count, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, imu_samples, 0, &sample_count, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, imu_samples, 10, NULL, 0));
+
+    // Nothing buffered yet
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imu_get_samples(imu_handle, imu_samples, 10, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)0);
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imu_get_samples(imu_handle, imu_samples, 10, &sample_count, 10));
+
+    // The backlog is read oldest first, across calls and packets
+    imu_packet_deliver(3, 9);
+    imu_packet_deliver(2, 36);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, imu_samples, 4, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)4);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_EQ(imu_samples[i].gyro_timestamp_usec, 100 * (i + 1));
+        ASSERT_EQ(imu_samples[i].acc_timestamp_usec, 100 * (i + 1));
+    }
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED,
+              imu_get_samples(imu_handle, imu_samples, 10, &sample_count, K4A_WAIT_INFINITE));
+    ASSERT_EQ(sample_count, (size_t)1);
+    ASSERT_EQ(imu_samples[0].gyro_timestamp_usec, (uint64_t)500);
+
+    // A full ring drops the oldest samples
+    imu_packet_deliver(2000, 9);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, imu_samples, 2000, &sample_count, 0));
+    ASSERT_GT(sample_count, (size_t)0);
+    ASSERT_LT(sample_count, (size_t)2000);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_EQ(imu_samples[i].gyro_timestamp_usec, 100 * (2000 - sample_count + i + 1));
+    }
+
+    // Single sample reads share the stream
+    imu_packet_deliver(2, 9);
+    k4a_imu_sample_t imu_sample;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_sample(imu_handle, &imu_sample, 0));
+    ASSERT_EQ(imu_sample.gyro_timestamp_usec, (uint64_t)100);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, imu_samples, 10, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)1);
+    ASSERT_EQ(imu_samples[0].gyro_timestamp_usec, (uint64_t)200);
+
+    // Stopping drops the buffered samples and fails reads
+    imu_packet_deliver(2, 9);
+    imu_stop(imu_handle);
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imu_get_samples(imu_handle, imu_samples, 10, &sample_count, 0));
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+    // Destroy the instance
+    imu_destroy(imu_handle);
+    tickcounter_destroy(tick);
+    calibration_destroy(calibration_handle);
+}
+
+// Scalar reference for the temperature compensated calibration of one reading, the second order term is only used by
+// the accelerometer
+static void imu_expected_reading(const k4a_calibration_imu_t *calibration,
+                                 bool second_order,
+                                 float temperature,
+                                 const float raw[3],
+                                 float out[3])
+{
+    const int coefficients = CALIBRATION_INERTIALSENSOR_TEMPERATURE_MODEL_COEFFICIENTS;
+    float bias[3];
+    float mixing_matrix[3 * 3];
+    for (int row = 0; row < 3; row++)
+    {
+        bias[row] = math_eval_poly_3(temperature, &calibration->bias_temperature_model[row * coefficients]);
+        for (int col = 0; col < 3; col++)
+        {
+            mixing_matrix[3 * row + col] =
+                math_eval_poly_3(temperature,
+                                 &calibration->mixing_matrix_temperature_model[(3 * row + col) * coefficients]);
+        }
+    }
+    if (second_order)
+    {
+        math_quadratic_transform_3(mixing_matrix, calibration->second_order_scaling, raw, bias, out);
+    }
+    else
+    {
+        math_affine_transform_3(mixing_matrix, raw, bias, out);
+    }
+}
+
+TEST_F(imu_ut, get_samples_calibration)
+{
+    // Create the  instance
+    imu_t imu_handle = NULL;
+    calibration_t calibration_handle;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(FAKE_DEPTH_MCU, &calibration_handle));
+    k4a_imu_sample_t imu_samples[12];
+    k4a_imu_sample_t imu_sample;
+    size_t sample_count = 0;
+    TICK_COUNTER_HANDLE tick;
+
+    ASSERT_NE((TICK_COUNTER_HANDLE)0, (tick = tickcounter_create()));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, FAKE_COLOR_MCU, calibration_handle, &imu_handle));
+    ASSERT_NE(imu_handle, (imu_t)NULL);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu_handle, 0));
+
+    // Packets at different temperatures, so the calibration is refreshed partway through a batched read
+    const int16_t temperatures[] = { 10 * 256, 10 * 256, 20 * 256 };
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int16_t temperature : temperatures)
+        {
+            imu_packet_deliver(4, 9, temperature);
+        }
+    }
+
+    // The first pass is read in one call and the second pass one sample at a time
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_samples(imu_handle, imu_samples, 12, &sample_count, 0));
+    ASSERT_EQ(sample_count, (size_t)12);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imu_get_sample(imu_handle, &imu_sample, 0));
+        ASSERT_EQ(imu_sample.temperature, imu_samples[i].temperature);
+        ASSERT_EQ(imu_sample.gyro_timestamp_usec, imu_samples[i].gyro_timestamp_usec);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            ASSERT_FLOAT_EQ(imu_sample.gyro_sample.v[axis], imu_samples[i].gyro_sample.v[axis]);
+            ASSERT_FLOAT_EQ(imu_sample.acc_sample.v[axis], imu_samples[i].acc_sample.v[axis]);
+        }
+    }
+    ASSERT_EQ(imu_samples[0].temperature, imu_samples[4].temperature);
+    ASSERT_NE(imu_samples[0].temperature, imu_samples[8].temperature);
+
+    // Compare with the scalar math, using the conversion of the raw readings done by the IMU module
+    k4a_calibration_imu_t gyro_calibration;
+    k4a_calibration_imu_t accel_calibration;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              calibration_get_imu(calibration_handle, K4A_CALIBRATION_TYPE_GYRO, &gyro_calibration));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              calibration_get_imu(calibration_handle, K4A_CALIBRATION_TYPE_ACCEL, &accel_calibration));
+    for (int i = 0; i < 4; i++)
+    {
+        const float gyro_raw[3] = { (float)(100 + i), (float)(-200 + 3 * i), (float)(300 - 7 * i) };
+        const float accel_raw[3] = { (float)(-1000 + 11 * i), (float)(500 - 13 * i), (float)(9000 + 17 * i) };
+        float gyro[3], accel[3], expected_gyro[3], expected_accel[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            gyro[axis] = gyro_raw[axis] * 1000 * (3.141592f / 180.0f) / 1000000;
+            accel[axis] = accel_raw[axis] * 1000 * 9.81f / 1000000;
+        }
+        for (size_t sample = (size_t)i; sample < sample_count; sample += 4)
+        {
+            imu_expected_reading(&gyro_calibration, false, imu_samples[sample].temperature, gyro, expected_gyro);
+            imu_expected_reading(&accel_calibration, true, imu_samples[sample].temperature, accel, expected_accel);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                ASSERT_NEAR(expected_gyro[axis],
+                            imu_samples[sample].gyro_sample.v[axis],
+                            1e-5f * fabsf(expected_gyro[axis]) + 1e-7f);
+                ASSERT_NEAR(expected_accel[axis],
+                            imu_samples[sample].acc_sample.v[axis],
+                            1e-5f * fabsf(expected_accel[axis]) + 1e-7f);
+            }
+        }
+    }
+
+    imu_stop(imu_handle);
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+    // Destroy the instance
+    imu_destroy(imu_handle);
+    tickcounter_destroy(tick);
+    calibration_destroy(calibration_handle);
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_common_main(argc, argv);
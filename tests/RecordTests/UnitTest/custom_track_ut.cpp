@@ -6,6 +6,8 @@
 #include <k4ainternal/matroska_common.h>
 
 #include <cstdio>
+#include <cstring>
+#include <vector>
 #include <k4arecord/record.h>
 #include <k4arecord/playback.h>
 
@@ -281,6 +283,100 @@ TEST_F(custom_track_ut, read_custom_track_data)
     k4a_playback_close(handle);
 }
 
+TEST_F(custom_track_ut, read_custom_track_data_blocks)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_custom_track.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint64_t start_timestamp_usec = (uint64_t)config.start_timestamp_offset_usec;
+    uint64_t end_timestamp_usec = start_timestamp_usec + test_timestamp_delta_usec * test_frame_count;
+
+    std::vector<k4a_playback_data_block_info_t> blocks(test_frame_count);
+    std::vector<uint8_t> buffer(1024 * 1024);
+    size_t block_count = 0;
+
+    // Read the whole low frequency track in a single call.
+    k4a_buffer_result_t buffer_result = k4a_playback_get_data_blocks(handle,
+                                                                     "CUSTOM_TRACK",
+                                                                     start_timestamp_usec,
+                                                                     end_timestamp_usec,
+                                                                     blocks.data(),
+                                                                     blocks.size(),
+                                                                     buffer.data(),
+                                                                     buffer.size(),
+                                                                     &block_count);
+    ASSERT_EQ(buffer_result, K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(block_count, test_frame_count);
+    for (size_t i = 0; i < block_count; i++)
+    {
+        uint64_t expected_timestamp_usec = start_timestamp_usec + test_timestamp_delta_usec * i;
+        ASSERT_EQ(blocks[i].device_timestamp_usec, expected_timestamp_usec);
+        ASSERT_TRUE(validate_custom_track_block(buffer.data() + blocks[i].buffer_offset,
+                                                blocks[i].buffer_size,
+                                                expected_timestamp_usec));
+    }
+
+    // Read the high frequency track a few blocks at a time and compare against the cursor API.
+    size_t total_blocks = 0;
+    uint64_t next_timestamp_usec = start_timestamp_usec;
+    do
+    {
+        buffer_result = k4a_playback_get_data_blocks(handle,
+                                                     "CUSTOM_TRACK_HIGH_FREQ",
+                                                     next_timestamp_usec,
+                                                     end_timestamp_usec,
+                                                     blocks.data(),
+                                                     3,
+                                                     buffer.data(),
+                                                     buffer.size(),
+                                                     &block_count);
+        ASSERT_NE(buffer_result, K4A_BUFFER_RESULT_FAILED);
+        ASSERT_LE(block_count, 3u);
+
+        for (size_t i = 0; i < block_count; i++)
+        {
+            k4a_playback_data_block_t data_block = NULL;
+            k4a_stream_result_t stream_result = k4a_playback_get_next_data_block(handle,
+                                                                                 "CUSTOM_TRACK_HIGH_FREQ",
+                                                                                 &data_block);
+            ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_EQ(blocks[i].device_timestamp_usec, k4a_playback_data_block_get_device_timestamp_usec(data_block));
+            ASSERT_EQ(blocks[i].buffer_size, k4a_playback_data_block_get_buffer_size(data_block));
+            ASSERT_EQ(memcmp(buffer.data() + blocks[i].buffer_offset,
+                             k4a_playback_data_block_get_buffer(data_block),
+                             blocks[i].buffer_size),
+                      0);
+            k4a_playback_data_block_release(data_block);
+        }
+
+        if (block_count > 0)
+        {
+            next_timestamp_usec = blocks[block_count - 1].device_timestamp_usec + 1;
+        }
+        total_blocks += block_count;
+    } while (buffer_result == K4A_BUFFER_RESULT_TOO_SMALL);
+    ASSERT_EQ(total_blocks, test_frame_count * 10);
+
+    // Built-in tracks can't be read as data blocks.
+    buffer_result = k4a_playback_get_data_blocks(handle,
+                                                 "DEPTH",
+                                                 start_timestamp_usec,
+                                                 end_timestamp_usec,
+                                                 blocks.data(),
+                                                 blocks.size(),
+                                                 buffer.data(),
+                                                 buffer.size(),
+                                                 &block_count);
+    ASSERT_EQ(buffer_result, K4A_BUFFER_RESULT_FAILED);
+
+    k4a_playback_close(handle);
+}
+
 TEST_F(custom_track_ut, seek_custom_track_frame)
 {
     k4a_playback_t handle = NULL;
@@ -423,6 +519,69 @@ TEST_F(custom_track_ut, seek_custom_track_high_frequency)
     k4a_playback_close(handle);
 }
 
+TEST_F(custom_track_ut, owned_and_batch_writes_match)
+{
+    // record_test_custom_track_owned.mkv holds the same data, written with the owned and batched custom track writes
+    k4a_playback_t handle = NULL;
+    k4a_playback_t owned_handle = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_custom_track.mkv", &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_open("record_test_custom_track_owned.mkv", &owned_handle), K4A_RESULT_SUCCEEDED);
+
+    // The IR track is written with k4a_record_write_custom_track_data_owned()
+    k4a_capture_t capture = NULL;
+    k4a_capture_t owned_capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_get_next_capture(owned_handle, &owned_capture), K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t ir_image = k4a_capture_get_ir_image(capture);
+        k4a_image_t owned_ir_image = k4a_capture_get_ir_image(owned_capture);
+        ASSERT_NE(ir_image, (k4a_image_t)NULL);
+        ASSERT_NE(owned_ir_image, (k4a_image_t)NULL);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(ir_image), k4a_image_get_device_timestamp_usec(owned_ir_image));
+        ASSERT_EQ(k4a_image_get_size(ir_image), k4a_image_get_size(owned_ir_image));
+        ASSERT_EQ(memcmp(k4a_image_get_buffer(ir_image),
+                         k4a_image_get_buffer(owned_ir_image),
+                         k4a_image_get_size(ir_image)),
+                  0);
+        k4a_image_release(ir_image);
+        k4a_image_release(owned_ir_image);
+
+        k4a_capture_release(capture);
+        k4a_capture_release(owned_capture);
+    }
+    ASSERT_EQ(k4a_playback_get_next_capture(owned_handle, &owned_capture), K4A_STREAM_RESULT_EOF);
+
+    // The high frequency track is written with k4a_record_write_custom_track_data_batch()
+    size_t block_count = 0;
+    k4a_playback_data_block_t data_block = NULL;
+    k4a_playback_data_block_t owned_data_block = NULL;
+    while (k4a_playback_get_next_data_block(handle, "CUSTOM_TRACK_HIGH_FREQ", &data_block) ==
+           K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_EQ(k4a_playback_get_next_data_block(owned_handle, "CUSTOM_TRACK_HIGH_FREQ", &owned_data_block),
+                  K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_data_block_get_device_timestamp_usec(data_block),
+                  k4a_playback_data_block_get_device_timestamp_usec(owned_data_block));
+        ASSERT_EQ(k4a_playback_data_block_get_buffer_size(data_block),
+                  k4a_playback_data_block_get_buffer_size(owned_data_block));
+        ASSERT_EQ(memcmp(k4a_playback_data_block_get_buffer(data_block),
+                         k4a_playback_data_block_get_buffer(owned_data_block),
+                         k4a_playback_data_block_get_buffer_size(data_block)),
+                  0);
+        k4a_playback_data_block_release(data_block);
+        k4a_playback_data_block_release(owned_data_block);
+        block_count++;
+    }
+    ASSERT_EQ(block_count, test_frame_count * 10);
+    ASSERT_EQ(k4a_playback_get_next_data_block(owned_handle, "CUSTOM_TRACK_HIGH_FREQ", &owned_data_block),
+              K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+    k4a_playback_close(owned_handle);
+}
+
 int main(int argc, char **argv)
 {
     k4a_unittest_init();
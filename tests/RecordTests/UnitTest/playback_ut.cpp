@@ -7,8 +7,13 @@
 #include <k4ainternal/matroska_common.h>
 
 #include "test_helpers.h"
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 #include <chrono>
 
 // Module being tested
@@ -66,6 +71,77 @@ TEST_F(playback_ut, read_playback_tags)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, open_lazy_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_playback_t lazy_handle = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_full.mkv", &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_open_lazy("record_test_full.mkv", &lazy_handle), K4A_RESULT_SUCCEEDED);
+
+    // The configuration, tracks and tags are read by the open
+    k4a_record_configuration_t config, lazy_config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(handle, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_record_configuration(lazy_handle, &lazy_config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(lazy_config.color_format, config.color_format);
+    ASSERT_EQ(lazy_config.color_resolution, config.color_resolution);
+    ASSERT_EQ(lazy_config.depth_mode, config.depth_mode);
+    ASSERT_EQ(lazy_config.camera_fps, config.camera_fps);
+    ASSERT_EQ(lazy_config.start_timestamp_offset_usec, config.start_timestamp_offset_usec);
+    ASSERT_EQ(k4a_playback_get_track_count(lazy_handle), k4a_playback_get_track_count(handle));
+
+    char tag_value[256];
+    size_t tag_value_size = sizeof(tag_value);
+    ASSERT_EQ(k4a_playback_get_tag(lazy_handle, "K4A_DEPTH_MODE", tag_value, &tag_value_size),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_STREQ(tag_value, "NFOV_UNBINNED");
+
+    // The attachments and clusters are loaded on first use
+    size_t calibration_size = 0;
+    size_t lazy_calibration_size = 0;
+    ASSERT_EQ(k4a_playback_get_raw_calibration(lazy_handle, NULL, &lazy_calibration_size),
+              k4a_playback_get_raw_calibration(handle, NULL, &calibration_size));
+    ASSERT_EQ(lazy_calibration_size, calibration_size);
+    ASSERT_EQ(k4a_playback_get_recording_length_usec(lazy_handle), k4a_playback_get_recording_length_usec(handle));
+
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(lazy_handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    k4a_playback_close(lazy_handle);
+
+    // Seeking can be the first use of the clusters
+    ASSERT_EQ(k4a_playback_open_lazy("record_test_full.mkv", &lazy_handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_seek_timestamp(lazy_handle, (int64_t)(50 * timestamp_delta), K4A_PLAYBACK_SEEK_BEGIN),
+              K4A_RESULT_SUCCEEDED);
+    uint64_t seek_timestamps[3] = { 50 * timestamp_delta, 50 * timestamp_delta + 1000, 50 * timestamp_delta + 1000 };
+    ASSERT_EQ(k4a_playback_get_next_capture(lazy_handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      seek_timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_close(lazy_handle);
+
+    // A recording can be opened and closed without reading any data
+    ASSERT_EQ(k4a_playback_open_lazy("record_test_full.mkv", &lazy_handle), K4A_RESULT_SUCCEEDED);
+    k4a_playback_close(lazy_handle);
+    k4a_playback_close(handle);
+}
+
 TEST_F(playback_ut, open_large_file)
 {
     k4a_playback_t handle = NULL;
@@ -789,6 +865,59 @@ TEST_F(playback_ut, open_imu_playback_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, playback_imu_samples)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint64_t recording_length = k4a_playback_get_recording_length_usec(handle);
+    std::vector<k4a_imu_sample_t> samples(recording_length / 1000 + 1);
+    size_t sample_count = 0;
+
+    // Read every sample at once
+    k4a_buffer_result_t buffer_result =
+        k4a_playback_get_imu_samples(handle, 0, UINT64_MAX, samples.data(), samples.size(), &sample_count);
+    ASSERT_EQ(buffer_result, K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, (size_t)((recording_length - 1150) / 1000 + 1));
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_TRUE(validate_imu_sample(samples[i], 1150 + 1000 * i));
+    }
+
+    // Read a range in small batches, starting and ending in the middle of blocks
+    uint64_t imu_timestamp = 10150;
+    uint64_t start_timestamp = 10100;
+    do
+    {
+        buffer_result = k4a_playback_get_imu_samples(handle, start_timestamp, 200000, samples.data(), 7, &sample_count);
+        ASSERT_NE(buffer_result, K4A_BUFFER_RESULT_FAILED);
+        for (size_t i = 0; i < sample_count; i++)
+        {
+            ASSERT_TRUE(validate_imu_sample(samples[i], imu_timestamp));
+            imu_timestamp += 1000;
+        }
+        if (sample_count > 0)
+        {
+            start_timestamp = samples[sample_count - 1].acc_timestamp_usec + 1;
+        }
+    } while (buffer_result == K4A_BUFFER_RESULT_TOO_SMALL);
+    ASSERT_EQ(imu_timestamp, (uint64_t)200150);
+
+    // The playback position is not changed
+    k4a_imu_sample_t imu_sample = { 0 };
+    k4a_stream_result_t stream_result = k4a_playback_get_next_imu_sample(handle, &imu_sample);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, 1150));
+
+    // An empty range
+    buffer_result = k4a_playback_get_imu_samples(handle, 5000, 5000, samples.data(), samples.size(), &sample_count);
+    ASSERT_EQ(buffer_result, K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, (size_t)0);
+
+    k4a_playback_close(handle);
+}
+
 TEST_F(playback_ut, open_start_offset_file)
 {
     k4a_playback_t handle = NULL;
@@ -917,6 +1046,48 @@ TEST_F(playback_ut, open_start_offset_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, imu_batch_matches_single_samples)
+{
+    // record_test_imu_batch.mkv holds the same data as record_test_offset.mkv, with the IMU samples written by
+    // k4a_record_write_imu_samples() instead of one k4a_record_write_imu_sample() call per sample
+    k4a_playback_t handle = NULL;
+    k4a_playback_t batch_handle = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_offset.mkv", &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_open("record_test_imu_batch.mkv", &batch_handle), K4A_RESULT_SUCCEEDED);
+
+    size_t sample_count = 0;
+    k4a_imu_sample_t imu_sample = { 0 };
+    k4a_imu_sample_t batch_imu_sample = { 0 };
+    while (k4a_playback_get_next_imu_sample(handle, &imu_sample) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_EQ(k4a_playback_get_next_imu_sample(batch_handle, &batch_imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(imu_sample.acc_timestamp_usec, batch_imu_sample.acc_timestamp_usec);
+        ASSERT_EQ(imu_sample.gyro_timestamp_usec, batch_imu_sample.gyro_timestamp_usec);
+        ASSERT_EQ(imu_sample.temperature, batch_imu_sample.temperature);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_EQ(imu_sample.acc_sample.v[i], batch_imu_sample.acc_sample.v[i]);
+            ASSERT_EQ(imu_sample.gyro_sample.v[i], batch_imu_sample.gyro_sample.v[i]);
+        }
+        sample_count++;
+    }
+    ASSERT_GT(sample_count, (size_t)0);
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(batch_handle, &batch_imu_sample), K4A_STREAM_RESULT_EOF);
+
+    // Seeking lands on the same samples
+    uint64_t seek_timestamp = 1001150 + 1000 * (sample_count / 2) + 100;
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, (int64_t)seek_timestamp, K4A_PLAYBACK_SEEK_DEVICE_TIME),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_seek_timestamp(batch_handle, (int64_t)seek_timestamp, K4A_PLAYBACK_SEEK_DEVICE_TIME),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_previous_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_previous_imu_sample(batch_handle, &batch_imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(imu_sample.acc_timestamp_usec, batch_imu_sample.acc_timestamp_usec);
+
+    k4a_playback_close(handle);
+    k4a_playback_close(batch_handle);
+}
+
 TEST_F(playback_ut, open_color_only_file)
 {
     k4a_playback_t handle = NULL;
@@ -1022,6 +1193,1517 @@ TEST_F(playback_ut, open_bgra_color_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, open_zero_copy_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_zero_copy.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_TRUE(config.depth_track_enabled);
+    ASSERT_TRUE(config.ir_track_enabled);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, open_rvl_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_rvl.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_TRUE(config.depth_track_enabled);
+    ASSERT_TRUE(config.ir_track_enabled);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, open_color_encoder_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_color_encoder.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_EQ(config.color_format, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(config.color_resolution, K4A_COLOR_RESOLUTION_720P);
+
+    size_t data_size = 0;
+    std::vector<char> codec_id;
+    ASSERT_EQ(k4a_playback_track_get_codec_id(handle, "COLOR", nullptr, &data_size), K4A_BUFFER_RESULT_TOO_SMALL);
+    codec_id.resize(data_size);
+    ASSERT_EQ(k4a_playback_track_get_codec_id(handle, "COLOR", codec_id.data(), &data_size),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_STREQ(codec_id.data(), "V_K4A/TEST_XOR");
+
+    std::vector<uint8_t> codec_context(4);
+    data_size = codec_context.size();
+    ASSERT_EQ(k4a_playback_track_get_codec_context(handle, "COLOR", codec_context.data(), &data_size),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(codec_context, std::vector<uint8_t>({ 1, 2, 3, 4 }));
+
+    // The test codec decodes the NV12 frames it was given
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_NV12);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint32_t width = 0, height = 0;
+    ASSERT_TRUE(k4a_convert_resolution_to_width_height(config.color_resolution, &width, &height));
+    test_color_codec codec = {};
+    codec.format = K4A_IMAGE_FORMAT_COLOR_NV12;
+    codec.width = width;
+    codec.height = height;
+    codec.stride = width;
+    result = k4a_playback_set_color_decoder(handle, test_color_decode, &codec);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          K4A_IMAGE_FORMAT_COLOR_NV12,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+    }
+
+    // Playing forward decodes every frame once
+    ASSERT_EQ(codec.frame_count, test_frame_count);
+
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    // Frames after a seek are decoded from the previous key frame, with key frames every 10 frames
+    timestamps[0] = 15 * timestamp_delta;
+    result = k4a_playback_seek_timestamp(handle, (int64_t)timestamps[0], K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    codec.frame_count = 0;
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      K4A_IMAGE_FORMAT_COLOR_NV12,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+    ASSERT_EQ(codec.frame_count, 6u);
+
+    stream_result = k4a_playback_get_previous_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    timestamps[0] -= timestamp_delta;
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      K4A_IMAGE_FORMAT_COLOR_NV12,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, open_color_jpeg_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_color_jpeg.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // The NV12 images were compressed to a regular MJPG track
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_EQ(config.color_format, K4A_IMAGE_FORMAT_COLOR_MJPG);
+    ASSERT_EQ(config.color_resolution, K4A_COLOR_RESOLUTION_720P);
+
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamp = 0;
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < 10; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(color_image), timestamp);
+        ASSERT_EQ(k4a_image_get_width_pixels(color_image), 1280);
+        ASSERT_EQ(k4a_image_get_height_pixels(color_image), 720);
+
+        // Mid gray stays close to mid gray through JPEG compression
+        const uint8_t *buffer = k4a_image_get_buffer(color_image);
+        size_t buffer_size = k4a_image_get_size(color_image);
+        for (size_t j = 0; j < buffer_size; j += 4)
+        {
+            ASSERT_NEAR(buffer[j], 128, 4);
+            ASSERT_NEAR(buffer[j + 1], 128, 4);
+            ASSERT_NEAR(buffer[j + 2], 128, 4);
+        }
+
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+        timestamp += timestamp_delta;
+    }
+
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_decode_color_image)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_color_jpeg.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.color_format, K4A_IMAGE_FORMAT_COLOR_MJPG);
+
+    k4a_image_t bgra_image = NULL;
+    result = k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32, 1280, 720, 1280 * 4, &bgra_image);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    k4a_image_t half_image = NULL;
+    result = k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32, 640, 360, 640 * 4, &half_image);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    k4a_image_t wrong_size_image = NULL;
+    result = k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32, 1280, 360, 1280 * 4, &wrong_size_image);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Every frame is decoded into the same application image
+    uint64_t timestamp = 0;
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < 10; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_format(color_image), K4A_IMAGE_FORMAT_COLOR_MJPG);
+
+        ASSERT_EQ(k4a_playback_decode_color_image(handle, color_image, bgra_image), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(bgra_image), timestamp);
+        ASSERT_EQ(k4a_playback_decode_color_image(handle, color_image, half_image), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(half_image), timestamp);
+
+        // Mid gray stays close to mid gray through JPEG compression
+        for (k4a_image_t image : { bgra_image, half_image })
+        {
+            const uint8_t *buffer = k4a_image_get_buffer(image);
+            size_t buffer_size = k4a_image_get_size(image);
+            for (size_t j = 0; j < buffer_size; j += 4)
+            {
+                ASSERT_NEAR(buffer[j], 128, 4);
+                ASSERT_NEAR(buffer[j + 1], 128, 4);
+                ASSERT_NEAR(buffer[j + 2], 128, 4);
+            }
+        }
+
+        // Only the sizes of the color scales are supported, and only BGRA targets
+        ASSERT_EQ(k4a_playback_decode_color_image(handle, color_image, wrong_size_image), K4A_RESULT_FAILED);
+        ASSERT_EQ(k4a_playback_decode_color_image(handle, bgra_image, bgra_image), K4A_RESULT_FAILED);
+        ASSERT_EQ(k4a_playback_decode_color_image(handle, color_image, color_image), K4A_RESULT_FAILED);
+
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+        timestamp += timestamp_delta;
+    }
+
+    // Converted images reuse the buffers of released images
+    result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    for (size_t i = 0; i < 10; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_size(color_image), k4a_image_get_size(bgra_image));
+        ASSERT_EQ(memcmp(k4a_image_get_buffer(color_image),
+                         k4a_image_get_buffer(bgra_image),
+                         k4a_image_get_size(bgra_image)),
+                  0);
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+    }
+
+    // Images can outlive the playback handle that decoded them
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+    result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+    k4a_capture_release(capture);
+
+    k4a_image_release(bgra_image);
+    k4a_image_release(half_image);
+    k4a_image_release(wrong_size_image);
+}
+
+TEST_F(playback_ut, open_unbuffered_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_unbuffered.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_TRUE(config.depth_track_enabled);
+    ASSERT_TRUE(config.ir_track_enabled);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, open_segmented_files)
+{
+    const char *segment_files[] = { "record_test_segmented.mkv",
+                                    "record_test_segmented_001.mkv",
+                                    "record_test_segmented_002.mkv",
+                                    "record_test_segmented_003.mkv" };
+
+    // The recording continues from one file to the next without losing any captures
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    size_t capture_count = 0;
+    for (const char *segment_file : segment_files)
+    {
+        k4a_playback_t handle = NULL;
+        k4a_result_t result = k4a_playback_open(segment_file, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_configuration_t config;
+        result = k4a_playback_get_record_configuration(handle, &config);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(config.start_timestamp_offset_usec, timestamps[0]);
+
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        while (stream_result == K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+            capture_count++;
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+            stream_result = k4a_playback_get_next_capture(handle, &capture);
+        }
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+        k4a_playback_close(handle);
+    }
+    ASSERT_EQ(capture_count, test_frame_count);
+
+    // The file prepared for the next segment is deleted when the recording ends
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_segmented_004.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_FAILED);
+}
+
+TEST_F(playback_ut, playback_color_scale)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_color_only.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // MJPG recordings can be decoded to any scale
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, K4A_COLOR_SCALE_HALF), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, K4A_COLOR_SCALE_EIGHTH), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, (k4a_color_scale_t)(K4A_COLOR_SCALE_EIGHTH + 1)),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, (k4a_color_scale_t)-1), K4A_RESULT_FAILED);
+
+    // Without a color conversion the MJPG images are not decoded, so they keep their resolution
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_close(handle);
+
+    // Scaling is done by the MJPG decoder, other recordings can only use the full resolution
+    result = k4a_playback_open("record_test_bgra_color.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, K4A_COLOR_SCALE_FULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, K4A_COLOR_SCALE_QUARTER), K4A_RESULT_FAILED);
+    k4a_playback_close(handle);
+
+    result = k4a_playback_open("record_test_depth_only.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_scale(handle, K4A_COLOR_SCALE_FULL), K4A_RESULT_FAILED);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_color_read_ahead)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    ASSERT_EQ(k4a_playback_set_color_read_ahead(handle, 4), K4A_RESULT_SUCCEEDED);
+
+    // Images converted ahead of time are returned with the right capture
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = K4A_STREAM_RESULT_FAILED;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+    // Images are read ahead in reverse when playing backward, changing direction discards the images read ahead
+    for (size_t i = 0; i < 20; i++)
+    {
+        timestamps[0] -= timestamp_delta;
+        timestamps[1] -= timestamp_delta;
+        timestamps[2] -= timestamp_delta;
+
+        stream_result = k4a_playback_get_previous_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+    for (size_t i = 0; i < 2; i++)
+    {
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+
+    result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    timestamps[0] = 0;
+    timestamps[1] = 1000;
+    timestamps[2] = 1000;
+    for (size_t i = 0; i < 10; i++)
+    {
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    // Closing the playback with images still being converted releases them
+    k4a_playback_close(handle);
+
+    result = k4a_playback_open("record_test_depth_only.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_read_ahead(handle, 4), K4A_RESULT_FAILED);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_cluster_cache)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    ASSERT_EQ(k4a_playback_set_cache_size(handle, 1024 * 1024 * 1024), K4A_RESULT_SUCCEEDED);
+
+    // Scrub back and forth with different read ahead depths, the cached clusters return the same captures
+    const uint32_t read_ahead_counts[] = { 0, 4, 1 };
+    const size_t seek_frames[] = { 50, 10, 90, 0, 49 };
+    for (uint32_t read_ahead_count : read_ahead_counts)
+    {
+        ASSERT_EQ(k4a_playback_set_cluster_read_ahead(handle, read_ahead_count), K4A_RESULT_SUCCEEDED);
+
+        for (size_t frame : seek_frames)
+        {
+            uint64_t timestamps[3] = { frame * timestamp_delta,
+                                       frame * timestamp_delta + 1000,
+                                       frame * timestamp_delta + 1000 };
+            result = k4a_playback_seek_timestamp(handle, (int64_t)timestamps[0], K4A_PLAYBACK_SEEK_BEGIN);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            for (size_t i = frame; i < frame + 5 && i < test_frame_count; i++)
+            {
+                k4a_capture_t capture = NULL;
+                k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+                ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+                ASSERT_TRUE(validate_test_capture(capture,
+                                                  timestamps,
+                                                  config.color_format,
+                                                  config.color_resolution,
+                                                  config.depth_mode));
+                k4a_capture_release(capture);
+
+                timestamps[0] += timestamp_delta;
+                timestamps[1] += timestamp_delta;
+                timestamps[2] += timestamp_delta;
+            }
+        }
+    }
+
+    // Shrinking the cache evicts the clusters that no longer fit
+    ASSERT_EQ(k4a_playback_set_cache_size(handle, 0), K4A_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_sidecar_index)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t recording_length = k4a_playback_get_recording_length_usec(handle);
+    ASSERT_EQ(k4a_playback_write_index(handle), K4A_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+
+    std::ifstream index_file("record_test_full.mkv.k4aidx", std::ios::binary);
+    ASSERT_TRUE(index_file.good());
+    index_file.close();
+
+    // The index gives the same recording length and seek results as the recording's own Cue entries
+    result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_recording_length_usec(handle), recording_length);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    const size_t seek_frames[] = { 50, 0, 99, 25 };
+    for (size_t frame : seek_frames)
+    {
+        uint64_t timestamps[3] = { frame * timestamp_delta,
+                                   frame * timestamp_delta + 1000,
+                                   frame * timestamp_delta + 1000 };
+        result = k4a_playback_seek_timestamp(handle, (int64_t)timestamps[0], K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+    k4a_playback_close(handle);
+
+    // An index that doesn't match the recording is ignored
+    std::ofstream stale_index("record_test_full.mkv.k4aidx", std::ios::binary | std::ios::trunc);
+    stale_index << "not an index";
+    stale_index.close();
+
+    result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_recording_length_usec(handle), recording_length);
+    k4a_playback_close(handle);
+
+    ASSERT_EQ(std::remove("record_test_full.mkv.k4aidx"), 0);
+}
+
+TEST_F(playback_ut, playback_live_index)
+{
+    // Closing the recording completed its live index
+    k4arecord::cluster_index_header_t header = {};
+    std::vector<k4arecord::cluster_index_entry_t> entries;
+    {
+        std::ifstream index_file("record_test_live_index.mkv.k4aidx", std::ios::binary);
+        ASSERT_TRUE(index_file.good());
+        index_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        ASSERT_TRUE(index_file.good());
+        ASSERT_GT(header.recording_size, 0u);
+        ASSERT_GT(header.entry_count, 1u);
+
+        entries.resize((size_t)header.entry_count);
+        index_file.read(reinterpret_cast<char *>(entries.data()),
+                        (std::streamsize)(entries.size() * sizeof(k4arecord::cluster_index_entry_t)));
+        ASSERT_TRUE(index_file.good());
+    }
+
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_live_index.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t recording_length = k4a_playback_get_recording_length_usec(handle);
+    k4a_playback_close(handle);
+
+    // Rewrite the index as if the recording was interrupted: the last clusters are missing and the index ends with a
+    // cluster that never reached the disk and a partial entry.
+    {
+        header.recording_size = 0;
+        header.entry_count = 0;
+        k4arecord::cluster_index_entry_t unwritten = entries.back();
+        unwritten.file_offset += unwritten.cluster_size;
+        unwritten.timestamp_ns += 1000000;
+        entries.resize(entries.size() / 2);
+        entries.push_back(unwritten);
+
+        std::ofstream index_file("record_test_live_index.mkv.k4aidx", std::ios::binary | std::ios::trunc);
+        index_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        index_file.write(reinterpret_cast<const char *>(entries.data()),
+                         (std::streamsize)(entries.size() * sizeof(k4arecord::cluster_index_entry_t)));
+        index_file.write(reinterpret_cast<const char *>(&unwritten), sizeof(unwritten) / 2);
+        ASSERT_TRUE(index_file.good());
+    }
+
+    // The rest of the recording is read from the file
+    result = k4a_playback_open("record_test_live_index.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_recording_length_usec(handle), recording_length);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    const size_t seek_frames[] = { 10, 90, 0, 99, 50 };
+    for (size_t frame : seek_frames)
+    {
+        uint64_t timestamps[3] = { frame * timestamp_delta, frame * timestamp_delta, frame * timestamp_delta };
+        result = k4a_playback_seek_timestamp(handle, (int64_t)timestamps[0], K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_mapped_io)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_mapped_io(handle, true), K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // Read the whole recording through the mapping, the first capture is kept to check it outlives the playback handle
+    k4a_capture_t first_capture = NULL;
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        if (first_capture == NULL)
+        {
+            first_capture = capture;
+        }
+        else
+        {
+            k4a_capture_release(capture);
+        }
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    // Switching back to regular file IO keeps the playback position and cluster cache
+    ASSERT_EQ(k4a_playback_set_mapped_io(handle, false), K4A_RESULT_SUCCEEDED);
+    result = k4a_playback_seek_timestamp(handle, (int64_t)(50 * timestamp_delta), K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t seek_timestamps[3] = { 50 * timestamp_delta, 50 * timestamp_delta + 1000, 50 * timestamp_delta + 1000 };
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      seek_timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_close(handle);
+
+    uint64_t first_timestamps[3] = { 0, 1000, 1000 };
+    ASSERT_TRUE(validate_test_capture(first_capture,
+                                      first_timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(first_capture);
+}
+
+TEST_F(playback_ut, playback_raw_blocks)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // The captures are read with a cursor, raw blocks of the built-in tracks use the playback position
+    k4a_playback_cursor_t cursor = NULL;
+    ASSERT_EQ(k4a_playback_cursor_create(handle, &cursor), K4A_RESULT_SUCCEEDED);
+
+    for (bool mapped_io : { false, true })
+    {
+        ASSERT_EQ(k4a_playback_set_mapped_io(handle, mapped_io), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_cursor_seek_timestamp(cursor, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = NULL;
+            ASSERT_EQ(k4a_playback_cursor_get_next_capture(cursor, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+            k4a_image_t color_image = k4a_capture_get_color_image(capture);
+            ASSERT_NE(color_image, nullptr);
+
+            // The color block is the image as recorded, without creating an image
+            k4a_playback_data_block_t block = NULL;
+            ASSERT_EQ(k4a_playback_get_next_raw_block(handle, K4A_TRACK_NAME_COLOR, &block),
+                      K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_EQ(k4a_playback_data_block_get_device_timestamp_usec(block), timestamps[0]);
+            ASSERT_EQ(k4a_playback_data_block_get_buffer_size(block), k4a_image_get_size(color_image));
+            ASSERT_EQ(memcmp(k4a_playback_data_block_get_buffer(block),
+                             k4a_image_get_buffer(color_image),
+                             k4a_image_get_size(color_image)),
+                      0);
+            k4a_playback_data_block_release(block);
+            k4a_image_release(color_image);
+
+            ASSERT_EQ(k4a_playback_get_next_raw_block(handle, K4A_TRACK_NAME_DEPTH, &block),
+                      K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_EQ(k4a_playback_data_block_get_device_timestamp_usec(block), timestamps[1]);
+            ASSERT_GT(k4a_playback_data_block_get_buffer_size(block), 0u);
+            k4a_playback_data_block_release(block);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        k4a_playback_data_block_t block = NULL;
+        ASSERT_EQ(k4a_playback_get_next_raw_block(handle, K4A_TRACK_NAME_COLOR, &block), K4A_STREAM_RESULT_EOF);
+        ASSERT_EQ(k4a_playback_get_previous_raw_block(handle, K4A_TRACK_NAME_COLOR, &block),
+                  K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_playback_data_block_get_device_timestamp_usec(block), timestamps[0] - timestamp_delta);
+        k4a_playback_data_block_release(block);
+    }
+
+    // The IMU track is read one sample per block
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    k4a_playback_data_block_t block = NULL;
+    ASSERT_EQ(k4a_playback_get_next_raw_block(handle, K4A_TRACK_NAME_IMU, &block), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_GT(k4a_playback_data_block_get_buffer_size(block), 0u);
+    k4a_playback_data_block_release(block);
+
+    ASSERT_EQ(k4a_playback_get_next_raw_block(handle, "UNKNOWN_TRACK", &block), K4A_STREAM_RESULT_FAILED);
+
+    k4a_playback_cursor_destroy(cursor);
+    k4a_playback_close(handle);
+}
+
+// Reads a recording for k4a_playback_open_custom_io(), the callback is called from several threads at once.
+struct custom_io_file_t
+{
+    std::ifstream file;
+    std::mutex lock;
+    uint64_t bytes_read = 0;
+    bool fail = false;
+};
+
+static k4a_result_t custom_io_read(uint64_t offset, void *buffer, size_t size, void *context)
+{
+    custom_io_file_t *io = static_cast<custom_io_file_t *>(context);
+    std::lock_guard<std::mutex> lock(io->lock);
+    if (io->fail)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    io->file.seekg((std::streamoff)offset);
+    io->file.read(static_cast<char *>(buffer), (std::streamsize)size);
+    io->bytes_read += (uint64_t)io->file.gcount();
+    return io->file.gcount() == (std::streamsize)size ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+TEST_F(playback_ut, playback_custom_io)
+{
+    custom_io_file_t io;
+    io.file.open("record_test_full.mkv", std::ios::binary | std::ios::ate);
+    ASSERT_TRUE(io.file.good());
+    uint64_t size = (uint64_t)io.file.tellg();
+
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open_custom_io("record_test_full.mkv", size, NULL, &io, &handle), K4A_RESULT_FAILED);
+    k4a_result_t result = k4a_playback_open_custom_io("record_test_full.mkv", size, custom_io_read, &io, &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // The recording is read through the callback only
+    ASSERT_EQ(k4a_playback_set_mapped_io(handle, true), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_write_index(handle), K4A_RESULT_FAILED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    result = k4a_playback_seek_timestamp(handle, (int64_t)(50 * timestamp_delta), K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t seek_timestamps[3] = { 50 * timestamp_delta, 50 * timestamp_delta + 1000, 50 * timestamp_delta + 1000 };
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      seek_timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_close(handle);
+
+    ASSERT_GT(io.bytes_read, 0u);
+
+    // A failed read fails the playback instead of returning bad data
+    io.fail = true;
+    result = k4a_playback_open_custom_io("record_test_full.mkv", size, custom_io_read, &io, &handle);
+    ASSERT_EQ(result, K4A_RESULT_FAILED);
+}
+
+TEST_F(playback_ut, playback_cursors)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // Each cursor reads a quarter of the recording on its own thread
+    const size_t cursor_count = 4;
+    const size_t frames_per_cursor = test_frame_count / cursor_count;
+    k4a_playback_cursor_t cursors[cursor_count] = {};
+    for (size_t i = 0; i < cursor_count; i++)
+    {
+        ASSERT_EQ(k4a_playback_cursor_create(handle, &cursors[i]), K4A_RESULT_SUCCEEDED);
+    }
+
+    bool cursor_results[cursor_count] = {};
+    std::thread threads[cursor_count];
+    for (size_t i = 0; i < cursor_count; i++)
+    {
+        threads[i] = std::thread([&, i] {
+            size_t frame = i * frames_per_cursor;
+            uint64_t timestamps[3] = { frame * timestamp_delta,
+                                       frame * timestamp_delta + 1000,
+                                       frame * timestamp_delta + 1000 };
+            if (k4a_playback_cursor_seek_timestamp(cursors[i], (int64_t)timestamps[0], K4A_PLAYBACK_SEEK_BEGIN) !=
+                K4A_RESULT_SUCCEEDED)
+            {
+                return;
+            }
+
+            for (size_t j = 0; j < frames_per_cursor; j++)
+            {
+                k4a_capture_t capture = NULL;
+                if (k4a_playback_cursor_get_next_capture(cursors[i], &capture) != K4A_STREAM_RESULT_SUCCEEDED)
+                {
+                    return;
+                }
+                bool valid = validate_test_capture(capture,
+                                                   timestamps,
+                                                   config.color_format,
+                                                   config.color_resolution,
+                                                   config.depth_mode);
+                k4a_capture_release(capture);
+                if (!valid)
+                {
+                    return;
+                }
+
+                timestamps[0] += timestamp_delta;
+                timestamps[1] += timestamp_delta;
+                timestamps[2] += timestamp_delta;
+            }
+            cursor_results[i] = true;
+        });
+    }
+    for (size_t i = 0; i < cursor_count; i++)
+    {
+        threads[i].join();
+        ASSERT_TRUE(cursor_results[i]) << "Cursor " << i << " failed";
+    }
+
+    // Reading the cursors didn't move the playback handle, which still starts at the first capture
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+
+    // After a seek, the cursor reads the IMU track from the same position as the playback handle
+    k4a_imu_sample_t cursor_sample = { 0 };
+    k4a_imu_sample_t playback_sample = { 0 };
+    ASSERT_EQ(k4a_playback_cursor_get_next_imu_sample(cursors[0], &cursor_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_cursor_seek_timestamp(cursors[0], 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_cursor_get_next_imu_sample(cursors[0], &cursor_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &playback_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(cursor_sample.acc_timestamp_usec, playback_sample.acc_timestamp_usec);
+
+    // Custom track functions don't accept the built-in tracks
+    k4a_playback_data_block_t data_block = NULL;
+    ASSERT_EQ(k4a_playback_cursor_get_next_data_block(cursors[0], K4A_TRACK_NAME_DEPTH, &data_block),
+              K4A_STREAM_RESULT_FAILED);
+
+    for (size_t i = 0; i < cursor_count; i++)
+    {
+        k4a_playback_cursor_destroy(cursors[i]);
+    }
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_seek_frame)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    ASSERT_EQ(k4a_playback_get_frame_count(handle), test_frame_count);
+
+    // Next capture returns the frame that was seeked to, previous capture returns the one before it
+    uint64_t timestamps[3] = { 50 * timestamp_delta, 50 * timestamp_delta + 1000, 50 * timestamp_delta + 1000 };
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_seek_frame(handle, 50), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        timestamps[i] -= timestamp_delta;
+    }
+    ASSERT_EQ(k4a_playback_seek_frame(handle, 50), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_previous_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+
+    // Seeking to the frame count seeks to the end of the recording
+    ASSERT_EQ(k4a_playback_seek_frame(handle, test_frame_count), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+    ASSERT_EQ(k4a_playback_seek_frame(handle, test_frame_count + 1), K4A_RESULT_FAILED);
+
+    // Seeking to the offset of a frame reads the same capture as seeking to the frame
+    uint64_t offset_usec = 0;
+    ASSERT_EQ(k4a_playback_get_frame_offset(handle, 50, &offset_usec), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, (int64_t)offset_usec, K4A_PLAYBACK_SEEK_BEGIN),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    for (size_t i = 0; i < 3; i++)
+    {
+        timestamps[i] += timestamp_delta;
+    }
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+    ASSERT_EQ(k4a_playback_get_frame_offset(handle, test_frame_count, &offset_usec), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_get_frame_offset(handle, 0, NULL), K4A_RESULT_FAILED);
+
+    // Cursors seek by frame independently of the playback handle
+    k4a_playback_cursor_t cursor = NULL;
+    ASSERT_EQ(k4a_playback_cursor_create(handle, &cursor), K4A_RESULT_SUCCEEDED);
+    timestamps[0] = 0;
+    timestamps[1] = timestamps[2] = 1000;
+    ASSERT_EQ(k4a_playback_cursor_seek_frame(cursor, 0), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_cursor_get_next_capture(cursor, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_cursor_destroy(cursor);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_enabled_tracks)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Only the depth track is read
+    const char *depth_only[] = { K4A_TRACK_NAME_DEPTH };
+    ASSERT_EQ(k4a_playback_set_enabled_tracks(handle, depth_only, 1), K4A_RESULT_SUCCEEDED);
+    size_t capture_count = 0;
+    k4a_capture_t capture = NULL;
+    while (k4a_playback_get_next_capture(handle, &capture) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        k4a_image_t depth = k4a_capture_get_depth_image(capture);
+        ASSERT_NE(depth, nullptr);
+        ASSERT_EQ(k4a_capture_get_color_image(capture), nullptr);
+        ASSERT_EQ(k4a_capture_get_ir_image(capture), nullptr);
+        uint64_t expected_timestamp = (uint64_t)capture_count * test_timestamp_delta_usec + 1000;
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(depth) * 1000 / MATROSKA_TIMESCALE_NS,
+                  expected_timestamp * 1000 / MATROSKA_TIMESCALE_NS);
+        k4a_image_release(depth);
+        k4a_capture_release(capture);
+        capture_count++;
+    }
+    ASSERT_EQ(capture_count, test_frame_count);
+    ASSERT_EQ(k4a_playback_get_frame_count(handle), test_frame_count);
+
+    // Tracks that aren't image tracks can't be selected, and the previous selection is kept
+    const char *invalid[] = { K4A_TRACK_NAME_DEPTH, K4A_TRACK_NAME_IMU };
+    ASSERT_EQ(k4a_playback_set_enabled_tracks(handle, invalid, 2), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_enabled_tracks(handle, NULL, 1), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    // Enabling every track again moves back to the start of the recording
+    k4a_record_configuration_t config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(handle, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_enabled_tracks(handle, NULL, 0), K4A_RESULT_SUCCEEDED);
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+
+    k4a_playback_close(handle);
+}
+
+struct range_test_context_t
+{
+    k4a_record_configuration_t config;
+    uint64_t timestamp_delta;
+    uint64_t timestamps[3];
+    size_t capture_count;
+    bool valid;
+    std::mutex lock;
+    std::set<uint64_t> color_timestamps;
+};
+
+static k4a_result_t range_test_in_order_cb(k4a_capture_t capture, void *context)
+{
+    range_test_context_t *test = (range_test_context_t *)context;
+    if (!validate_test_capture(capture,
+                               test->timestamps,
+                               test->config.color_format,
+                               test->config.color_resolution,
+                               test->config.depth_mode))
+    {
+        test->valid = false;
+        return K4A_RESULT_FAILED;
+    }
+    test->capture_count++;
+    for (size_t i = 0; i < 3; i++)
+    {
+        test->timestamps[i] += test->timestamp_delta;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t range_test_any_order_cb(k4a_capture_t capture, void *context)
+{
+    range_test_context_t *test = (range_test_context_t *)context;
+    k4a_image_t color = k4a_capture_get_color_image(capture);
+    if (color == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    uint64_t timestamp = k4a_image_get_device_timestamp_usec(color);
+    k4a_image_release(color);
+
+    std::lock_guard<std::mutex> lock(test->lock);
+    test->capture_count++;
+    test->color_timestamps.insert(timestamp);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static k4a_result_t range_test_stop_cb(k4a_capture_t capture, void *context)
+{
+    (void)capture;
+    range_test_context_t *test = (range_test_context_t *)context;
+    std::lock_guard<std::mutex> lock(test->lock);
+    return ++test->capture_count < 5 ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+}
+
+TEST_F(playback_ut, playback_process_range)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    range_test_context_t test = {};
+    result = k4a_playback_get_record_configuration(handle, &test.config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    test.timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(test.config.camera_fps));
+    uint64_t recording_end = k4a_playback_get_recording_length_usec(handle) + 1;
+
+    // Read the whole recording in order
+    test.timestamps[0] = 0;
+    test.timestamps[1] = test.timestamps[2] = 1000;
+    test.valid = true;
+    ASSERT_EQ(k4a_playback_process_range(handle, 0, recording_end, 4, true, &range_test_in_order_cb, &test),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(test.valid);
+    ASSERT_EQ(test.capture_count, test_frame_count);
+
+    // A range in the middle of the recording includes its start and excludes its end
+    test.timestamps[0] = 10 * test.timestamp_delta;
+    test.timestamps[1] = test.timestamps[2] = 10 * test.timestamp_delta + 1000;
+    test.capture_count = 0;
+    ASSERT_EQ(k4a_playback_process_range(handle,
+                                         10 * test.timestamp_delta,
+                                         20 * test.timestamp_delta,
+                                         2,
+                                         true,
+                                         &range_test_in_order_cb,
+                                         &test),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(test.valid);
+    ASSERT_EQ(test.capture_count, 10u);
+
+    // Without ordering, every capture is still passed to the callback exactly once
+    test.capture_count = 0;
+    ASSERT_EQ(k4a_playback_process_range(handle, 0, recording_end, 4, false, &range_test_any_order_cb, &test),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(test.capture_count, test_frame_count);
+    ASSERT_EQ(test.color_timestamps.size(), test_frame_count);
+
+    // A failing callback stops processing
+    for (bool in_order : { true, false })
+    {
+        test.capture_count = 0;
+        ASSERT_EQ(k4a_playback_process_range(handle, 0, recording_end, 4, in_order, &range_test_stop_cb, &test),
+                  K4A_RESULT_FAILED);
+        ASSERT_LT(test.capture_count, test_frame_count);
+    }
+
+    ASSERT_EQ(k4a_playback_process_range(handle, 0, recording_end, 0, true, &range_test_stop_cb, &test),
+              K4A_RESULT_FAILED);
+
+    // The read position of the playback handle is not changed
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      test.config.color_format,
+                                      test.config.color_resolution,
+                                      test.config.depth_mode));
+    k4a_capture_release(capture);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_write_range)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    uint64_t recording_length = k4a_playback_get_recording_length_usec(handle);
+
+    ASSERT_EQ(k4a_playback_write_range(handle, "record_test_range.mkv", 30 * timestamp_delta, 60 * timestamp_delta),
+              K4A_RESULT_SUCCEEDED);
+
+    // The recording can't be replaced by a range of itself, and a range after its end fails without writing a file
+    ASSERT_EQ(k4a_playback_write_range(handle, "record_test_full.mkv", 0, timestamp_delta), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_write_range(handle,
+                                       "record_test_range_end.mkv",
+                                       recording_length + 1,
+                                       recording_length + 2),
+              K4A_RESULT_FAILED);
+    ASSERT_FALSE(std::ifstream("record_test_range_end.mkv").good());
+    k4a_playback_close(handle);
+
+    result = k4a_playback_open("record_test_range.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // The new recording starts at the cluster containing the start of the range
+    k4a_record_configuration_t range_config;
+    result = k4a_playback_get_record_configuration(handle, &range_config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(range_config.color_format, config.color_format);
+    ASSERT_TRUE(range_config.imu_track_enabled);
+    ASSERT_GT(range_config.start_timestamp_offset_usec, (uint32_t)0);
+    ASSERT_LE(range_config.start_timestamp_offset_usec, 30 * timestamp_delta);
+    ASSERT_LT(k4a_playback_get_recording_length_usec(handle), 33 * timestamp_delta);
+
+    k4a_calibration_t calibration;
+    ASSERT_EQ(k4a_playback_get_calibration(handle, &calibration), K4A_RESULT_SUCCEEDED);
+
+    // Every capture of the range keeps its device timestamps, captures cut at the ends may be missing images
+    size_t first_frame = SIZE_MAX;
+    size_t last_frame = 0;
+    k4a_capture_t capture = NULL;
+    while (k4a_playback_get_next_capture(handle, &capture) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        k4a_image_t images[3] = { k4a_capture_get_color_image(capture),
+                                  k4a_capture_get_depth_image(capture),
+                                  k4a_capture_get_ir_image(capture) };
+        if (images[0] != NULL && images[1] != NULL && images[2] != NULL)
+        {
+            size_t frame = (size_t)(k4a_image_get_device_timestamp_usec(images[0]) / timestamp_delta);
+            uint64_t timestamps[3] = { frame * timestamp_delta,
+                                       frame * timestamp_delta + 1000,
+                                       frame * timestamp_delta + 1000 };
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            if (first_frame != SIZE_MAX)
+            {
+                ASSERT_EQ(frame, last_frame + 1);
+            }
+            else
+            {
+                first_frame = frame;
+            }
+            last_frame = frame;
+        }
+        for (k4a_image_t image : images)
+        {
+            if (image != NULL)
+            {
+                k4a_image_release(image);
+            }
+        }
+        k4a_capture_release(capture);
+    }
+    ASSERT_LE(first_frame, 31u);
+    ASSERT_GE(last_frame, 59u);
+    ASSERT_LE(last_frame, 60u);
+
+    // IMU samples are copied with the captures
+    k4a_imu_sample_t imu_sample = { 0 };
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_GE(imu_sample.acc_timestamp_usec, (uint64_t)range_config.start_timestamp_offset_usec);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, imu_sample.acc_timestamp_usec));
+
+    k4a_playback_close(handle);
+    ASSERT_EQ(std::remove("record_test_range.mkv"), 0);
+}
+
+TEST_F(playback_ut, playback_group)
+{
+    const char *paths[] = { "record_test_group_master.mkv", "record_test_group_sub.mkv" };
+    k4a_playback_group_t group = NULL;
+    ASSERT_EQ(k4a_playback_group_open(paths, 2, &group), K4A_RESULT_SUCCEEDED);
+    ASSERT_NE(k4a_playback_group_get_playback(group, 1), (k4a_playback_t)NULL);
+    ASSERT_EQ(k4a_playback_group_get_playback(group, 2), (k4a_playback_t)NULL);
+
+    k4a_record_configuration_t config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(k4a_playback_group_get_playback(group, 1), &config),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.wired_sync_mode, K4A_WIRED_SYNC_MODE_SUBORDINATE);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    uint64_t delay = config.subordinate_delay_off_master_usec;
+
+    // Each subordinate capture is matched with the master capture that triggered it
+    k4a_capture_t captures[2] = { NULL, NULL };
+    uint64_t sync_timestamp = 0;
+    ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 1, &sync_timestamp), K4A_STREAM_RESULT_FAILED);
+    for (uint64_t i = 0; i < 30; i++)
+    {
+        ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 2, &sync_timestamp),
+                  K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(sync_timestamp, i * timestamp_delta);
+
+        uint64_t timestamps[3] = { i * timestamp_delta, i * timestamp_delta, i * timestamp_delta };
+        ASSERT_TRUE(validate_test_capture(captures[0],
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(captures[0]);
+
+        // The subordinate dropped frame 10
+        if (i == 10)
+        {
+            ASSERT_EQ(captures[1], (k4a_capture_t)NULL);
+        }
+        else
+        {
+            timestamps[0] = timestamps[1] = timestamps[2] = i * timestamp_delta + delay;
+            ASSERT_TRUE(validate_test_capture(captures[1],
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(captures[1]);
+        }
+    }
+    ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 2, &sync_timestamp), K4A_STREAM_RESULT_EOF);
+
+    // Seeking moves every recording to the same time
+    ASSERT_EQ(k4a_playback_group_seek_timestamp(group, 20 * timestamp_delta), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 2, &sync_timestamp), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(sync_timestamp, 20 * timestamp_delta);
+    ASSERT_NE(captures[0], (k4a_capture_t)NULL);
+    ASSERT_NE(captures[1], (k4a_capture_t)NULL);
+    k4a_capture_release(captures[0]);
+    k4a_capture_release(captures[1]);
+    k4a_playback_group_close(group);
+
+    // A rig has only one master
+    const char *two_masters[] = { "record_test_group_master.mkv", "record_test_group_master.mkv" };
+    ASSERT_EQ(k4a_playback_group_open(two_masters, 2, &group), K4A_RESULT_FAILED);
+    ASSERT_EQ(group, (k4a_playback_group_t)NULL);
+
+    const char *missing[] = { "record_test_group_master.mkv", "record_test_missing.mkv" };
+    ASSERT_EQ(k4a_playback_group_open(missing, 2, &group), K4A_RESULT_FAILED);
+}
+
+TEST_F(playback_ut, playback_group_single_file)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_group_single.mkv", &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_device_count(handle), 2u);
+    k4a_playback_close(handle);
+
+    // Device 0 is the plain recording, devices past the last one fail to open
+    ASSERT_EQ(k4a_playback_open_device("record_test_group_single.mkv", 2, &handle), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_open("record_test_group_master.mkv", &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_device_count(handle), 1u);
+    k4a_playback_close(handle);
+
+    k4a_playback_group_t group = NULL;
+    ASSERT_EQ(k4a_playback_group_open_devices("record_test_group_single.mkv", &group), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_group_get_playback(group, 2), (k4a_playback_t)NULL);
+
+    k4a_record_configuration_t config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(k4a_playback_group_get_playback(group, 0), &config),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.wired_sync_mode, K4A_WIRED_SYNC_MODE_MASTER);
+    ASSERT_EQ(k4a_playback_get_record_configuration(k4a_playback_group_get_playback(group, 1), &config),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.wired_sync_mode, K4A_WIRED_SYNC_MODE_SUBORDINATE);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+    uint64_t delay = config.subordinate_delay_off_master_usec;
+
+    // The devices of one file are matched the same way as separate recordings
+    k4a_capture_t captures[2] = { NULL, NULL };
+    uint64_t sync_timestamp = 0;
+    for (uint64_t i = 0; i < 30; i++)
+    {
+        ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 2, &sync_timestamp),
+                  K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(sync_timestamp, i * timestamp_delta);
+
+        uint64_t timestamps[3] = { i * timestamp_delta, i * timestamp_delta, i * timestamp_delta };
+        ASSERT_TRUE(validate_test_capture(captures[0],
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(captures[0]);
+
+        if (i == 10)
+        {
+            ASSERT_EQ(captures[1], (k4a_capture_t)NULL);
+        }
+        else
+        {
+            timestamps[0] = timestamps[1] = timestamps[2] = i * timestamp_delta + delay;
+            ASSERT_TRUE(validate_test_capture(captures[1],
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(captures[1]);
+        }
+    }
+    ASSERT_EQ(k4a_playback_group_get_next_captures(group, captures, 2, &sync_timestamp), K4A_STREAM_RESULT_EOF);
+    k4a_playback_group_close(group);
+}
+
 int main(int argc, char **argv)
 {
     k4a_unittest_init();
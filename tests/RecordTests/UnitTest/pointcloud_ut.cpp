@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Module being tested
+#include <k4arecord/pointcloud.h>
+#include <k4a/k4a.h>
+
+using namespace testing;
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 288
+
+class pointcloud_ut : public ::testing::Test
+{
+protected:
+    k4a_image_t int16_image = NULL;
+    k4a_image_t float_image = NULL;
+    k4a_image_t color_image = NULL;
+    size_t valid_point_count = 0;
+
+    void SetUp() override
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
+                                   TEST_WIDTH,
+                                   TEST_HEIGHT,
+                                   TEST_WIDTH * 3 * (int)sizeof(int16_t),
+                                   &int16_image));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
+                                   TEST_WIDTH,
+                                   TEST_HEIGHT,
+                                   TEST_WIDTH * 3 * (int)sizeof(float),
+                                   &float_image));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                   TEST_WIDTH,
+                                   TEST_HEIGHT,
+                                   TEST_WIDTH * 4,
+                                   &color_image));
+
+        // Every 5th pixel has no depth and must be skipped
+        int16_t *int16_points = reinterpret_cast<int16_t *>(k4a_image_get_buffer(int16_image));
+        float *float_points = reinterpret_cast<float *>(k4a_image_get_buffer(float_image));
+        uint8_t *colors = k4a_image_get_buffer(color_image);
+        for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+        {
+            bool valid = i % 5 != 0;
+            valid_point_count += valid ? 1 : 0;
+            for (int c = 0; c < 3; c++)
+            {
+                int16_points[3 * i + c] = (int16_t)(valid ? 1 + (i + c) % 4000 : 0);
+                float_points[3 * i + c] = valid ? 0.001f * (float)(1 + (i + c) % 4000) : 0.0f;
+            }
+            for (int c = 0; c < 4; c++)
+            {
+                colors[4 * i + c] = (uint8_t)(i * 3 + c);
+            }
+        }
+    }
+
+    void TearDown() override
+    {
+        k4a_image_release(int16_image);
+        k4a_image_release(float_image);
+        k4a_image_release(color_image);
+    }
+};
+
+static std::string read_file(const char *path)
+{
+    std::string contents;
+    FILE *file = fopen(path, "rb");
+    EXPECT_NE(file, nullptr);
+    if (file != NULL)
+    {
+        char buffer[4096];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            contents.append(buffer, size);
+        }
+        fclose(file);
+    }
+    return contents;
+}
+
+// Checks the points following the header of a file against the valid points of the images
+static void validate_points(const std::string &contents,
+                            size_t header_size,
+                            k4a_image_t xyz_image,
+                            k4a_image_t color_image,
+                            k4a_point_cloud_file_format_t format,
+                            size_t point_count)
+{
+    size_t xyz_size = (size_t)k4a_image_get_stride_bytes(xyz_image) / TEST_WIDTH;
+    size_t color_size = color_image == NULL ? 0 : (format == K4A_POINT_CLOUD_FILE_FORMAT_PLY ? 3 : 4);
+    ASSERT_EQ(header_size + point_count * (xyz_size + color_size), contents.size());
+
+    const uint8_t *xyz = k4a_image_get_buffer(xyz_image);
+    const uint8_t *colors = color_image == NULL ? NULL : k4a_image_get_buffer(color_image);
+    const uint8_t *point = reinterpret_cast<const uint8_t *>(contents.data()) + header_size;
+    for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    {
+        if (i % 5 == 0)
+        {
+            continue;
+        }
+        ASSERT_EQ(0, memcmp(point, xyz + i * xyz_size, xyz_size));
+        if (colors != NULL)
+        {
+            const uint8_t *bgra = colors + 4 * i;
+            if (format == K4A_POINT_CLOUD_FILE_FORMAT_PLY)
+            {
+                ASSERT_EQ(bgra[2], point[xyz_size + 0]);
+                ASSERT_EQ(bgra[1], point[xyz_size + 1]);
+                ASSERT_EQ(bgra[0], point[xyz_size + 2]);
+            }
+            else
+            {
+                ASSERT_EQ(0, memcmp(point + xyz_size, bgra, 3));
+                ASSERT_EQ(0, point[xyz_size + 3]);
+            }
+        }
+        point += xyz_size + color_size;
+    }
+}
+
+static void validate_ply(const char *path, k4a_image_t xyz_image, k4a_image_t color_image, size_t point_count)
+{
+    std::string contents = read_file(path);
+    bool float_points = k4a_image_get_stride_bytes(xyz_image) == TEST_WIDTH * 3 * (int)sizeof(float);
+    const char *type = float_points ? "float" : "short";
+    std::string expected = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(point_count) +
+                           "\nproperty " + type + " x\nproperty " + type + " y\nproperty " + type + " z\n";
+    if (color_image != NULL)
+    {
+        expected += "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    }
+    expected += "end_header\n";
+    ASSERT_EQ(expected, contents.substr(0, expected.size()));
+
+    validate_points(contents, expected.size(), xyz_image, color_image, K4A_POINT_CLOUD_FILE_FORMAT_PLY, point_count);
+}
+
+static void validate_pcd(const char *path, k4a_image_t xyz_image, k4a_image_t color_image, size_t point_count)
+{
+    std::string contents = read_file(path);
+    bool float_points = k4a_image_get_stride_bytes(xyz_image) == TEST_WIDTH * 3 * (int)sizeof(float);
+    bool has_color = color_image != NULL;
+    std::string count = std::to_string(point_count);
+    std::string expected = "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\n";
+    expected += has_color ? "FIELDS x y z rgb\n" : "FIELDS x y z\n";
+    expected += std::string(float_points ? "SIZE 4 4 4" : "SIZE 2 2 2") + (has_color ? " 4\n" : "\n");
+    expected += std::string(float_points ? "TYPE F F F" : "TYPE I I I") + (has_color ? " U\n" : "\n");
+    expected += has_color ? "COUNT 1 1 1 1\n" : "COUNT 1 1 1\n";
+    expected += "WIDTH " + count + "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS " + count + "\nDATA binary\n";
+    ASSERT_EQ(expected, contents.substr(0, expected.size()));
+
+    validate_points(contents, expected.size(), xyz_image, color_image, K4A_POINT_CLOUD_FILE_FORMAT_PCD, point_count);
+}
+
+TEST_F(pointcloud_ut, write_ply)
+{
+    k4a_point_cloud_writer_t writer = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_create(K4A_POINT_CLOUD_FILE_FORMAT_PLY, false, &writer));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_write(writer, "pointcloud_ut_0.ply", int16_image, NULL));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_point_cloud_writer_write(writer, "pointcloud_ut_1.ply", float_image, color_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_flush(writer));
+    k4a_point_cloud_writer_close(writer);
+
+    validate_ply("pointcloud_ut_0.ply", int16_image, NULL, valid_point_count);
+    validate_ply("pointcloud_ut_1.ply", float_image, color_image, valid_point_count);
+    remove("pointcloud_ut_0.ply");
+    remove("pointcloud_ut_1.ply");
+}
+
+TEST_F(pointcloud_ut, write_pcd)
+{
+    k4a_point_cloud_writer_t writer = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_create(K4A_POINT_CLOUD_FILE_FORMAT_PCD, false, &writer));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_write(writer, "pointcloud_ut_0.pcd", float_image, NULL));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_point_cloud_writer_write(writer, "pointcloud_ut_1.pcd", int16_image, color_image));
+    k4a_point_cloud_writer_close(writer);
+
+    validate_pcd("pointcloud_ut_0.pcd", float_image, NULL, valid_point_count);
+    validate_pcd("pointcloud_ut_1.pcd", int16_image, color_image, valid_point_count);
+    remove("pointcloud_ut_0.pcd");
+    remove("pointcloud_ut_1.pcd");
+}
+
+TEST_F(pointcloud_ut, write_background)
+{
+    k4a_point_cloud_writer_t writer = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_create(K4A_POINT_CLOUD_FILE_FORMAT_PLY, true, &writer));
+
+    // More point clouds than the queue holds, so some writes wait for the writer thread
+    const int file_count = 8;
+    for (int i = 0; i < file_count; i++)
+    {
+        std::string path = "pointcloud_ut_" + std::to_string(i) + ".ply";
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_write(writer, path.c_str(), float_image, color_image));
+    }
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_flush(writer));
+
+    for (int i = 0; i < file_count; i++)
+    {
+        std::string path = "pointcloud_ut_" + std::to_string(i) + ".ply";
+        validate_ply(path.c_str(), float_image, color_image, valid_point_count);
+        remove(path.c_str());
+    }
+
+    // A failed background write is reported by the next flush only
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_point_cloud_writer_write(writer, "pointcloud_ut_missing/0.ply", float_image, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_flush(writer));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_flush(writer));
+
+    k4a_point_cloud_writer_close(writer);
+}
+
+TEST_F(pointcloud_ut, invalid_arguments)
+{
+    k4a_point_cloud_writer_t writer = NULL;
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_create(K4A_POINT_CLOUD_FILE_FORMAT_PLY, false, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_create((k4a_point_cloud_file_format_t)-1, false, &writer));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_point_cloud_writer_create(K4A_POINT_CLOUD_FILE_FORMAT_PLY, false, &writer));
+
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_write(NULL, "pointcloud_ut.ply", float_image, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_write(writer, NULL, float_image, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_write(writer, "pointcloud_ut.ply", NULL, NULL));
+
+    // The color image is not a point cloud, and the point cloud is not a BGRA32 image
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_write(writer, "pointcloud_ut.ply", color_image, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_write(writer, "pointcloud_ut.ply", float_image, int16_image));
+
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_point_cloud_writer_flush(NULL));
+    k4a_point_cloud_writer_close(writer);
+}
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
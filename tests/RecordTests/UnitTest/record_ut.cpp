@@ -3,10 +3,16 @@
 
 #include <utcommon.h>
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <future>
+
+#include "test_helpers.h"
 
 // Module being tested
 #include <k4ainternal/matroska_write.h>
 #include <k4arecord/record.h>
+#include <k4arecord/playback.h>
 #include <k4a/k4a.h>
 
 #include <ebml/MemIOCallback.h>
@@ -132,6 +138,288 @@ TEST_F(record_ut, new_cluster_out_of_order)
     ASSERT_EQ(context->pending_clusters.size(), 3u);
 }
 
+TEST_F(record_ut, rvl_round_trip)
+{
+    // Runs of zeros, small deltas, and the largest possible jumps between pixels
+    std::vector<uint16_t> pixels = { 0, 0, 0, 1000, 1001, 999, 0, 65535, 1, 65535, 0, 0, 7, 8, 0 };
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+        pixels.push_back(i % 7 == 0 ? 0 : (uint16_t)(500 + i));
+    }
+
+    std::vector<uint8_t> encoded(rvl_max_encoded_size(pixels.size()));
+    size_t encoded_size = rvl_encode(pixels.data(), pixels.size(), encoded.data(), encoded.size());
+    ASSERT_GT(encoded_size, 0u);
+    ASSERT_LT(encoded_size, pixels.size() * sizeof(uint16_t));
+    ASSERT_EQ(rvl_get_pixel_count(encoded.data(), encoded_size), pixels.size());
+
+    std::vector<uint16_t> decoded(pixels.size());
+    ASSERT_EQ(rvl_decode(encoded.data(), encoded_size, decoded.data(), decoded.size()), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(decoded, pixels);
+
+    // Truncated data and a wrong pixel count are rejected
+    ASSERT_EQ(rvl_decode(encoded.data(), encoded_size / 2, decoded.data(), decoded.size()), K4A_RESULT_FAILED);
+    ASSERT_EQ(rvl_decode(encoded.data(), encoded_size, decoded.data(), decoded.size() - 1), K4A_RESULT_FAILED);
+
+    // The worst case, alternating zero and maximum delta pixels, fits in the encoded buffer
+    std::vector<uint16_t> worst_case;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        worst_case.push_back(i % 2 == 0 ? 0 : (i % 4 == 1 ? 65535 : 1));
+    }
+    encoded.resize(rvl_max_encoded_size(worst_case.size()));
+    encoded_size = rvl_encode(worst_case.data(), worst_case.size(), encoded.data(), encoded.size());
+    ASSERT_GT(encoded_size, 0u);
+    decoded.resize(worst_case.size());
+    ASSERT_EQ(rvl_decode(encoded.data(), encoded_size, decoded.data(), decoded.size()), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(decoded, worst_case);
+}
+
+static void write_queue_test(k4a_record_write_queue_policy_t policy,
+                             size_t limit,
+                             size_t capture_count,
+                             k4a_result_t expected_result,
+                             uint64_t expected_dropped_count)
+{
+    k4a_device_configuration_t record_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    record_config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    record_config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create("record_test_write_queue.mkv", NULL, record_config, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_set_write_queue_limit(handle, limit, policy), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < capture_count; i++)
+    {
+        k4a_capture_t capture = create_test_capture(timestamps,
+                                                    record_config.color_format,
+                                                    record_config.color_resolution,
+                                                    record_config.depth_mode);
+        ASSERT_EQ(k4a_record_write_capture(handle, capture), expected_result);
+        k4a_capture_release(capture);
+
+        for (uint64_t &timestamp : timestamps)
+        {
+            timestamp += test_timestamp_delta_usec;
+        }
+    }
+
+    uint64_t dropped_count = 0;
+    ASSERT_EQ(k4a_record_get_dropped_image_count(handle, &dropped_count), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(dropped_count, expected_dropped_count);
+
+    ASSERT_EQ(k4a_record_flush(handle), K4A_RESULT_SUCCEEDED);
+    k4a_record_close(handle);
+    ASSERT_EQ(std::remove("record_test_write_queue.mkv"), 0);
+}
+
+TEST_F(record_ut, write_queue_limit)
+{
+    // Test captures have a color, depth and IR image of 8096 bytes each
+    const size_t image_size = 8096;
+
+    // The first capture never fits in a 1 byte queue, so the whole capture is dropped or rejected
+    write_queue_test(K4A_RECORD_WRITE_QUEUE_DROP_CAPTURE, 1, 1, K4A_RESULT_SUCCEEDED, 3);
+    write_queue_test(K4A_RECORD_WRITE_QUEUE_FAIL, 1, 1, K4A_RESULT_FAILED, 0);
+
+    // Only the depth and IR images of the first capture fit, none of the second capture fits
+    write_queue_test(K4A_RECORD_WRITE_QUEUE_DROP_COLOR, image_size * 2, 2, K4A_RESULT_SUCCEEDED, 4);
+
+    // A blocked capture is written once the writer thread catches up, so nothing is dropped
+    write_queue_test(K4A_RECORD_WRITE_QUEUE_BLOCK, 1, 10, K4A_RESULT_SUCCEEDED, 0);
+}
+
+TEST_F(record_ut, custom_track_data_owned)
+{
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create("record_test_custom_owned.mkv", NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_add_custom_subtitle_track(handle, "CUSTOM", "S_K4A/CUSTOM", NULL, 0, NULL),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    auto release_cb = [](void *buffer, void *context) {
+        delete[] static_cast<uint8_t *>(buffer);
+        (*static_cast<int *>(context))++;
+    };
+    int release_count = 0;
+
+    // The buffer is released once it has been written to disk
+    uint8_t *buffer = new uint8_t[16];
+    ASSERT_EQ(k4a_record_write_custom_track_data_owned(handle, "CUSTOM", 1000, buffer, 16, release_cb, &release_count),
+              K4A_RESULT_SUCCEEDED);
+
+    // The buffer is also released when it can't be written
+    buffer = new uint8_t[16];
+    ASSERT_EQ(k4a_record_write_custom_track_data_owned(handle, "MISSING", 1000, buffer, 16, release_cb, &release_count),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(release_count, 1);
+
+    // A batch writes every valid block, and fails if any block can't be written
+    uint8_t block_data[4] = { 1, 2, 3, 4 };
+    k4a_record_custom_track_block_t blocks[] = { { 2000, block_data, sizeof(block_data) },
+                                                 { 2001, NULL, 0 },
+                                                 { 2002, block_data, sizeof(block_data) } };
+    ASSERT_EQ(k4a_record_write_custom_track_data_batch(handle, "CUSTOM", blocks, 1), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_custom_track_data_batch(handle, "CUSTOM", blocks, arraysize(blocks)), K4A_RESULT_FAILED);
+
+    ASSERT_EQ(k4a_record_flush(handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(release_count, 2);
+
+    k4a_record_close(handle);
+    ASSERT_EQ(std::remove("record_test_custom_owned.mkv"), 0);
+}
+
+TEST_F(record_ut, custom_track_image_view)
+{
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create("record_test_custom_image.mkv", NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_add_custom_subtitle_track(handle, "CUSTOM", "S_K4A/CUSTOM", NULL, 0, NULL),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    k4a_image_t image = NULL;
+    ASSERT_EQ(k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM8, 8, 4, 8, &image), K4A_RESULT_SUCCEEDED);
+    uint8_t *pixels = k4a_image_get_buffer(image);
+    for (int i = 0; i < 8 * 4; i++)
+    {
+        pixels[i] = (uint8_t)i;
+    }
+
+    // The view shares the rows of the image, and only its own pixels are written
+    k4a_image_t view = NULL;
+    ASSERT_EQ(k4a_image_create_view(image, 2, 1, 3, 2, &view), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_image_get_buffer(view), pixels + 8 + 2);
+    ASSERT_EQ(k4a_image_get_stride_bytes(view), 8);
+    k4a_image_set_device_timestamp_usec(view, 1000);
+
+    ASSERT_EQ(k4a_record_write_custom_track_image(handle, "CUSTOM", view), K4A_RESULT_SUCCEEDED);
+
+    // Packed images are written whole
+    k4a_image_set_device_timestamp_usec(image, 2000);
+    ASSERT_EQ(k4a_record_write_custom_track_image(handle, "CUSTOM", image), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_custom_track_image(handle, "MISSING", view), K4A_RESULT_FAILED);
+    k4a_image_release(view);
+    k4a_image_release(image);
+    k4a_record_close(handle);
+
+    k4a_playback_t playback = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_custom_image.mkv", &playback), K4A_RESULT_SUCCEEDED);
+    k4a_playback_data_block_t block = NULL;
+    ASSERT_EQ(k4a_playback_get_next_data_block(playback, "CUSTOM", &block), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_data_block_get_device_timestamp_usec(block), 1000u);
+    ASSERT_EQ(k4a_playback_data_block_get_buffer_size(block), 6u);
+    const uint8_t expected[] = { 10, 11, 12, 18, 19, 20 };
+    ASSERT_EQ(memcmp(k4a_playback_data_block_get_buffer(block), expected, sizeof(expected)), 0);
+    k4a_playback_data_block_release(block);
+
+    ASSERT_EQ(k4a_playback_get_next_data_block(playback, "CUSTOM", &block), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_data_block_get_buffer_size(block), 32u);
+    k4a_playback_data_block_release(block);
+
+    k4a_playback_close(playback);
+    ASSERT_EQ(std::remove("record_test_custom_image.mkv"), 0);
+}
+
+TEST_F(record_ut, capture_history)
+{
+    k4a_device_configuration_t record_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    record_config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    record_config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    // Test captures have a color, depth and IR image of 8096 bytes each
+    const size_t capture_size = 8096 * 3;
+
+    k4a_capture_history_t history = NULL;
+    ASSERT_EQ(k4a_capture_history_create(1000000, capture_size * 100, &history), K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamps[3] = { 1000, 1000, 1000 };
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_capture_t capture = create_test_capture(timestamps,
+                                                    record_config.color_format,
+                                                    record_config.color_resolution,
+                                                    record_config.depth_mode);
+        ASSERT_EQ(k4a_capture_history_add_capture(history, capture), K4A_RESULT_SUCCEEDED);
+        k4a_capture_release(capture);
+
+        for (uint64_t &timestamp : timestamps)
+        {
+            timestamp += test_timestamp_delta_usec;
+        }
+    }
+
+    // Only the last second of captures is kept
+    ASSERT_EQ(k4a_capture_history_get_capture_count(history), (size_t)31);
+
+    // Captures are looked up by the closest timestamp
+    uint64_t expected_timestamps[3] = { 1000 + test_timestamp_delta_usec * 90,
+                                        1000 + test_timestamp_delta_usec * 90,
+                                        1000 + test_timestamp_delta_usec * 90 };
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_capture_history_get_capture(history, expected_timestamps[0] + 100, &capture), K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      expected_timestamps,
+                                      record_config.color_format,
+                                      record_config.color_resolution,
+                                      record_config.depth_mode));
+    k4a_capture_release(capture);
+    ASSERT_EQ(k4a_capture_history_get_capture(history, expected_timestamps[0] - 100, &capture), K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      expected_timestamps,
+                                      record_config.color_format,
+                                      record_config.color_resolution,
+                                      record_config.depth_mode));
+    k4a_capture_release(capture);
+
+    // Write the last half second to a recording in the background
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create("record_test_history.mkv", NULL, record_config, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    std::promise<k4a_result_t> dump_result;
+    auto dump_cb = [](k4a_result_t result, void *context) {
+        static_cast<std::promise<k4a_result_t> *>(context)->set_value(result);
+    };
+    ASSERT_EQ(k4a_capture_history_dump(history, handle, 500000, dump_cb, &dump_result), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(dump_result.get_future().get(), K4A_RESULT_SUCCEEDED);
+    k4a_record_close(handle);
+    k4a_capture_history_destroy(history);
+
+    k4a_playback_t playback = NULL;
+    ASSERT_EQ(k4a_playback_open("record_test_history.mkv", &playback), K4A_RESULT_SUCCEEDED);
+    size_t capture_count = 0;
+    while (k4a_playback_get_next_capture(playback, &capture) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        k4a_capture_release(capture);
+        capture_count++;
+    }
+    ASSERT_EQ(capture_count, (size_t)16);
+    k4a_playback_close(playback);
+    ASSERT_EQ(std::remove("record_test_history.mkv"), 0);
+
+    // The memory limit evicts the oldest captures
+    ASSERT_EQ(k4a_capture_history_create(UINT64_MAX, capture_size * 5, &history), K4A_RESULT_SUCCEEDED);
+    for (size_t i = 0; i < 10; i++)
+    {
+        capture = create_test_capture(timestamps,
+                                      record_config.color_format,
+                                      record_config.color_resolution,
+                                      record_config.depth_mode);
+        ASSERT_EQ(k4a_capture_history_add_capture(history, capture), K4A_RESULT_SUCCEEDED);
+        k4a_capture_release(capture);
+    }
+    ASSERT_EQ(k4a_capture_history_get_capture_count(history), (size_t)5);
+    k4a_capture_history_destroy(history);
+}
+
 // This test's goal is to fill up the write queue by saturating disk write.
 // It should trigger the write speed warning message in the logs.
 // Since this test is unlikely to complete, and needs to be manually run, it is disabled.
@@ -0,0 +1,534 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <k4a/k4a.h>
+#include <k4a/k4aversion.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/matroska_common.h>
+
+#include "test_helpers.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// Module being tested
+#include <k4arecord/playback.h>
+#include <k4arecord/record.h>
+
+// Benchmarks recording and playback on a recording generated by the test, so the numbers can be compared across SDK
+// versions and machines. The recording has full size NV12 color, depth and IR images and is written with
+// k4a_record_write_capture(), which is the write benchmark. Playback is then measured for sequential reads, seeks and
+// color conversion with several read ahead settings.
+//
+// Results are printed and written as JSON. The cluster length is fixed when the SDK is built, see
+// K4A_RECORD_CLUSTER_LENGTH_MS, so it is reported with the results.
+
+using namespace testing;
+
+static uint64_t g_recording_size_mb = 2048;
+static std::string g_recording_path = "recording_perf.mkv";
+static std::string g_json_path = "recording_perf_results.json";
+static bool g_keep_recording = false;
+static int g_seek_count = 200;
+static int g_conversion_count = 300;
+
+static bool g_recording_written = false;
+static uint64_t g_recording_bytes = 0;
+
+struct benchmark_result
+{
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> values;
+
+    void add(const std::string &key, double value)
+    {
+        char text[64];
+        snprintf(text, sizeof(text), "%.3f", value);
+        values.emplace_back(key, text);
+    }
+
+    void add(const std::string &key, bool value)
+    {
+        values.emplace_back(key, value ? "true" : "false");
+    }
+
+    void add(const std::string &key, uint64_t value)
+    {
+        values.emplace_back(key, std::to_string(value));
+    }
+};
+
+static std::vector<benchmark_result> g_results;
+
+static const k4a_device_configuration_t &get_record_config()
+{
+    static k4a_device_configuration_t config = []() {
+        k4a_device_configuration_t c = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+        c.color_format = K4A_IMAGE_FORMAT_COLOR_NV12;
+        c.color_resolution = K4A_COLOR_RESOLUTION_720P;
+        c.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+        c.camera_fps = K4A_FRAMES_PER_SECOND_30;
+        return c;
+    }();
+    return config;
+}
+
+static double get_seconds(std::chrono::high_resolution_clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+static double get_mb_per_second(uint64_t bytes, double seconds)
+{
+    return seconds > 0 ? (double)bytes / (1024 * 1024) / seconds : 0;
+}
+
+static double get_percentile_ms(const std::vector<double> &sorted_ms, double percentile)
+{
+    size_t index = (size_t)(percentile * (double)(sorted_ms.size() - 1) + 0.5);
+    return sorted_ms[std::min(index, sorted_ms.size() - 1)];
+}
+
+// Creates an image filled from template_data so every capture writes a full size image without generating new data
+static k4a_image_t create_full_image(k4a_image_format_t format,
+                                     int width,
+                                     int height,
+                                     int stride,
+                                     const std::vector<uint8_t> &template_data,
+                                     uint64_t timestamp_usec)
+{
+    k4a_image_t image = NULL;
+    if (K4A_RESULT_SUCCEEDED != k4a_image_create(format, width, height, stride, &image))
+    {
+        return NULL;
+    }
+
+    size_t size = std::min(k4a_image_get_size(image), template_data.size());
+    memcpy(k4a_image_get_buffer(image), template_data.data(), size);
+    k4a_image_set_device_timestamp_usec(image, timestamp_usec);
+    return image;
+}
+
+static uint64_t get_capture_bytes(k4a_capture_t capture)
+{
+    uint64_t bytes = 0;
+    k4a_image_t images[] = { k4a_capture_get_color_image(capture),
+                             k4a_capture_get_depth_image(capture),
+                             k4a_capture_get_ir_image(capture) };
+    for (k4a_image_t image : images)
+    {
+        if (image)
+        {
+            bytes += k4a_image_get_size(image);
+            k4a_image_release(image);
+        }
+    }
+    return bytes;
+}
+
+class recording_write_perf : public ::testing::Test
+{
+};
+
+TEST_F(recording_write_perf, write_capture_and_flush)
+{
+    const k4a_device_configuration_t &config = get_record_config();
+    uint32_t color_width = 0, color_height = 0, depth_width = 0, depth_height = 0;
+    ASSERT_TRUE(k4a_convert_resolution_to_width_height(config.color_resolution, &color_width, &color_height));
+    ASSERT_TRUE(k4a_convert_depth_mode_to_width_height(config.depth_mode, &depth_width, &depth_height));
+
+    // Pseudo random data, so images don't compress or deduplicate in the file system
+    std::vector<uint8_t> template_data((size_t)color_width * color_height * 3 / 2);
+    std::mt19937 random(1);
+    for (uint8_t &value : template_data)
+    {
+        value = (uint8_t)random();
+    }
+
+    const uint64_t capture_bytes = (uint64_t)color_width * color_height * 3 / 2 +
+                                   (uint64_t)depth_width * depth_height * 2 * 2;
+    const uint64_t capture_count = std::max((uint64_t)1, g_recording_size_mb * 1024 * 1024 / capture_bytes);
+
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_record_create(g_recording_path.c_str(), NULL, config, &handle));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_record_write_header(handle));
+
+    std::chrono::high_resolution_clock::duration write_time(0);
+    for (uint64_t i = 0; i < capture_count; i++)
+    {
+        uint64_t timestamp_usec = i * test_timestamp_delta_usec;
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_capture_create(&capture));
+        k4a_image_t images[] = {
+            create_full_image(K4A_IMAGE_FORMAT_COLOR_NV12,
+                              (int)color_width,
+                              (int)color_height,
+                              (int)color_width,
+                              template_data,
+                              timestamp_usec),
+            create_full_image(K4A_IMAGE_FORMAT_DEPTH16,
+                              (int)depth_width,
+                              (int)depth_height,
+                              (int)depth_width * 2,
+                              template_data,
+                              timestamp_usec),
+            create_full_image(K4A_IMAGE_FORMAT_IR16,
+                              (int)depth_width,
+                              (int)depth_height,
+                              (int)depth_width * 2,
+                              template_data,
+                              timestamp_usec),
+        };
+        ASSERT_TRUE(images[0] != NULL && images[1] != NULL && images[2] != NULL);
+        k4a_capture_set_color_image(capture, images[0]);
+        k4a_capture_set_depth_image(capture, images[1]);
+        k4a_capture_set_ir_image(capture, images[2]);
+        for (k4a_image_t image : images)
+        {
+            k4a_image_release(image);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        k4a_result_t result = k4a_record_write_capture(handle, capture);
+        write_time += std::chrono::high_resolution_clock::now() - start;
+
+        k4a_capture_release(capture);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, result);
+    }
+
+    auto flush_start = std::chrono::high_resolution_clock::now();
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_record_flush(handle));
+    auto flush_time = std::chrono::high_resolution_clock::now() - flush_start;
+    k4a_record_close(handle);
+
+    g_recording_written = true;
+    g_recording_bytes = capture_count * capture_bytes;
+
+    double write_seconds = get_seconds(write_time);
+    double total_seconds = get_seconds(write_time + flush_time);
+
+    benchmark_result result;
+    result.name = "write";
+    result.add("captures", capture_count);
+    result.add("image_bytes", g_recording_bytes);
+    result.add("write_capture_mb_per_second", get_mb_per_second(g_recording_bytes, write_seconds));
+    result.add("flush_ms", get_seconds(flush_time) * 1000);
+    result.add("mb_per_second", get_mb_per_second(g_recording_bytes, total_seconds));
+    g_results.push_back(result);
+
+    std::cout << "    Wrote " << capture_count << " captures, " << (g_recording_bytes / (1024 * 1024)) << " MB"
+              << std::endl;
+    std::cout << "    k4a_record_write_capture: " << get_mb_per_second(g_recording_bytes, write_seconds) << " MB/s"
+              << std::endl;
+    std::cout << "    k4a_record_flush: " << get_seconds(flush_time) * 1000 << " ms" << std::endl;
+    std::cout << "    Write and flush: " << get_mb_per_second(g_recording_bytes, total_seconds) << " MB/s"
+              << std::endl;
+}
+
+struct read_parameters
+{
+    int test_number;
+    uint32_t cluster_read_ahead;
+    uint32_t color_read_ahead;
+    bool mapped_io;
+
+    friend std::ostream &operator<<(std::ostream &os, const read_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class recording_read_perf : public ::testing::Test, public ::testing::WithParamInterface<read_parameters>
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(g_recording_written) << "The write benchmark must run first to generate the recording";
+
+        auto as = GetParam();
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_open(g_recording_path.c_str(), &m_handle));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_cluster_read_ahead(m_handle, as.cluster_read_ahead));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_mapped_io(m_handle, as.mapped_io));
+    }
+
+    void TearDown() override
+    {
+        if (m_handle)
+        {
+            k4a_playback_close(m_handle);
+        }
+    }
+
+    benchmark_result create_result(const char *name)
+    {
+        auto as = GetParam();
+        benchmark_result result;
+        result.name = name;
+        result.add("cluster_read_ahead", (uint64_t)as.cluster_read_ahead);
+        result.add("color_read_ahead", (uint64_t)as.color_read_ahead);
+        result.add("mapped_io", as.mapped_io);
+        return result;
+    }
+
+    k4a_playback_t m_handle = NULL;
+};
+
+TEST_P(recording_read_perf, sequential_read)
+{
+    uint64_t bytes = 0;
+    uint64_t captures = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    while (true)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t result = k4a_playback_get_next_capture(m_handle, &capture);
+        ASSERT_NE(K4A_STREAM_RESULT_FAILED, result);
+        if (result == K4A_STREAM_RESULT_EOF)
+        {
+            break;
+        }
+        bytes += get_capture_bytes(capture);
+        captures++;
+        k4a_capture_release(capture);
+    }
+    double seconds = get_seconds(std::chrono::high_resolution_clock::now() - start);
+
+    benchmark_result result = create_result("sequential_read");
+    result.add("captures", captures);
+    result.add("mb_per_second", get_mb_per_second(bytes, seconds));
+    g_results.push_back(result);
+
+    std::cout << "    Sequential read: " << get_mb_per_second(bytes, seconds) << " MB/s" << std::endl;
+}
+
+TEST_P(recording_read_perf, seek_latency)
+{
+    uint64_t length_usec = k4a_playback_get_recording_length_usec(m_handle);
+    ASSERT_GT(length_usec, 0u);
+
+    // The same seek positions for every run
+    std::mt19937_64 random(1);
+    std::vector<double> latencies_ms;
+    for (int i = 0; i < g_seek_count; i++)
+    {
+        int64_t offset_usec = (int64_t)(random() % length_usec);
+        k4a_capture_t capture = NULL;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_seek_timestamp(m_handle, offset_usec, K4A_PLAYBACK_SEEK_BEGIN));
+        k4a_stream_result_t result = k4a_playback_get_next_capture(m_handle, &capture);
+        latencies_ms.push_back(get_seconds(std::chrono::high_resolution_clock::now() - start) * 1000);
+
+        ASSERT_NE(K4A_STREAM_RESULT_FAILED, result);
+        if (capture)
+        {
+            k4a_capture_release(capture);
+        }
+    }
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+
+    benchmark_result result = create_result("seek");
+    result.add("seeks", (uint64_t)latencies_ms.size());
+    result.add("p50_ms", get_percentile_ms(latencies_ms, 0.50));
+    result.add("p90_ms", get_percentile_ms(latencies_ms, 0.90));
+    result.add("p99_ms", get_percentile_ms(latencies_ms, 0.99));
+    result.add("max_ms", latencies_ms.back());
+    g_results.push_back(result);
+
+    std::cout << "    Seek and read: P50 " << get_percentile_ms(latencies_ms, 0.50) << " ms, P90 "
+              << get_percentile_ms(latencies_ms, 0.90) << " ms, P99 " << get_percentile_ms(latencies_ms, 0.99)
+              << " ms, max " << latencies_ms.back() << " ms" << std::endl;
+}
+
+TEST_P(recording_read_perf, color_conversion)
+{
+    auto as = GetParam();
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_color_conversion(m_handle, K4A_IMAGE_FORMAT_COLOR_BGRA32));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_color_read_ahead(m_handle, as.color_read_ahead));
+
+    uint64_t captures = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    while (captures < (uint64_t)g_conversion_count)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t result = k4a_playback_get_next_capture(m_handle, &capture);
+        ASSERT_NE(K4A_STREAM_RESULT_FAILED, result);
+        if (result == K4A_STREAM_RESULT_EOF)
+        {
+            break;
+        }
+
+        // Read the pixels so conversions deferred to the first access are counted
+        k4a_image_t image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(image, nullptr);
+        ASSERT_NE(k4a_image_get_buffer(image), nullptr);
+        k4a_image_release(image);
+        k4a_capture_release(capture);
+        captures++;
+    }
+    double seconds = get_seconds(std::chrono::high_resolution_clock::now() - start);
+
+    benchmark_result result = create_result("color_conversion");
+    result.add("captures", captures);
+    result.add("fps", seconds > 0 ? (double)captures / seconds : 0);
+    g_results.push_back(result);
+
+    std::cout << "    NV12 to BGRA32: " << (seconds > 0 ? (double)captures / seconds : 0) << " fps" << std::endl;
+}
+
+// clang-format off
+static struct read_parameters tests[] = {
+    { 0, 0, 0, false },
+    { 1, 2, 0, false },
+    { 2, 8, 0, false },
+    { 3, 2, 0, true },
+    { 4, 8, 0, true },
+    { 5, 2, 4, false },
+    { 6, 2, 4, true },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(RECORDING_TESTS, recording_read_perf, ValuesIn(tests));
+
+static void write_json(FILE *file, const std::string &text)
+{
+    fputc('"', file);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            fputc('\\', file);
+        }
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+static bool write_results(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        printf("Error: failed to open %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"sdk_version\": ");
+    write_json(file, K4A_VERSION_STR);
+    fprintf(file,
+            ",\n  \"max_cluster_length_ms\": %.3f,\n  \"recording_image_bytes\": %llu,\n  \"results\": [",
+            (double)MAX_CLUSTER_LENGTH_NS / 1000000,
+            (unsigned long long)g_recording_bytes);
+    for (size_t i = 0; i < g_results.size(); i++)
+    {
+        fprintf(file, "%s\n    { \"benchmark\": ", i == 0 ? "" : ",");
+        write_json(file, g_results[i].name);
+        for (const auto &value : g_results[i].values)
+        {
+            fprintf(file, ", ");
+            write_json(file, value.first);
+            fprintf(file, ": %s", value.second.c_str());
+        }
+        fprintf(file, " }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        std::transform(argument.begin(), argument.end(), argument.begin(), ::tolower);
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (argument == "--size_mb" || argument == "--path" || argument == "--json" || argument == "--seeks" ||
+            argument == "--conversions")
+        {
+            if (value == NULL)
+            {
+                printf("Error: %s parameter missing\n", argument.c_str());
+                error = true;
+                continue;
+            }
+            i++;
+        }
+
+        if (argument == "--size_mb")
+        {
+            g_recording_size_mb = strtoull(value, NULL, 10);
+        }
+        else if (argument == "--path")
+        {
+            g_recording_path = value;
+        }
+        else if (argument == "--json")
+        {
+            g_json_path = value;
+        }
+        else if (argument == "--seeks")
+        {
+            g_seek_count = (int)strtol(value, NULL, 10);
+        }
+        else if (argument == "--conversions")
+        {
+            g_conversion_count = (int)strtol(value, NULL, 10);
+        }
+        else if (argument == "--keep")
+        {
+            g_keep_recording = true;
+        }
+        else if (argument == "-h" || argument == "/h" || argument == "-?" || argument == "/?")
+        {
+            error = true;
+        }
+    }
+
+    if (g_recording_size_mb == 0 || g_seek_count <= 0 || g_conversion_count <= 0)
+    {
+        printf("Error: sizes and counts must be positive\n");
+        error = true;
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --size_mb <megabytes>\n");
+        printf("      Size of the image data in the generated recording; default is 2048\n");
+        printf("  --path <path>\n");
+        printf("      Where the recording is generated; default is recording_perf.mkv\n");
+        printf("  --json <path>\n");
+        printf("      Where the results are written; default is recording_perf_results.json\n");
+        printf("  --seeks <count>\n");
+        printf("      The number of seeks timed by each seek benchmark; default is 200\n");
+        printf("  --conversions <count>\n");
+        printf("      The number of color images converted by each conversion benchmark; default is 300\n");
+        printf("  --keep\n");
+        printf("      Keep the generated recording\n");
+
+        return 1; // Indicates an error or warning
+    }
+
+    int results = RUN_ALL_TESTS();
+
+    if (!write_results(g_json_path.c_str()))
+    {
+        results = 1;
+    }
+    if (g_recording_written && !g_keep_recording)
+    {
+        std::remove(g_recording_path.c_str());
+    }
+
+    k4a_unittest_deinit();
+    return results;
+}
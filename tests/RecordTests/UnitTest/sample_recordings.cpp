@@ -4,6 +4,8 @@
 #include "test_helpers.h"
 
 #include <cstdio>
+#include <cstring>
+#include <vector>
 #include <k4arecord/record.h>
 #include <k4ainternal/common.h>
 #include <k4ainternal/matroska_write.h>
@@ -29,12 +31,19 @@ void SampleRecordings::SetUp()
     record_config_sub.wired_sync_mode = K4A_WIRED_SYNC_MODE_SUBORDINATE;
     record_config_sub.subordinate_delay_off_master_usec = 10000; // 10ms
 
+    k4a_device_configuration_t record_config_master = record_config_full;
+    record_config_master.wired_sync_mode = K4A_WIRED_SYNC_MODE_MASTER;
+
     k4a_device_configuration_t record_config_color_only = record_config_full;
     record_config_color_only.depth_mode = K4A_DEPTH_MODE_OFF;
 
     k4a_device_configuration_t record_config_depth_only = record_config_full;
     record_config_depth_only.color_resolution = K4A_COLOR_RESOLUTION_OFF;
 
+    k4a_device_configuration_t record_config_nv12_color = record_config_color_only;
+    record_config_nv12_color.color_format = K4A_IMAGE_FORMAT_COLOR_NV12;
+    record_config_nv12_color.color_resolution = K4A_COLOR_RESOLUTION_720P;
+
     k4a_device_configuration_t record_config_bgra_color = record_config_full;
     record_config_bgra_color.color_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
     record_config_bgra_color.depth_mode = K4A_DEPTH_MODE_OFF;
@@ -267,6 +276,56 @@ void SampleRecordings::SetUp()
 
         k4a_record_close(handle);
     }
+    { // Create the same recording as record_test_offset.mkv, with the IMU samples of each frame written as a batch
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_imu_batch.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_add_imu_track(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 1000000, 1000000, 1000000 };
+        uint64_t imu_timestamp = 1001150;
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_delay.camera_fps));
+        k4a_capture_t capture = NULL;
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            capture = create_test_capture(timestamps,
+                                          record_config_delay.color_format,
+                                          record_config_delay.color_resolution,
+                                          record_config_delay.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+
+            std::vector<k4a_imu_sample_t> imu_samples;
+            while (imu_timestamp < timestamps[0])
+            {
+                imu_samples.push_back(create_test_imu_sample(imu_timestamp));
+
+                // Write IMU samples at ~1000 samples per second (this is an arbitrary rate for testing)
+                imu_timestamp += 1000; // 1ms
+            }
+            result = k4a_record_write_imu_samples(handle, imu_samples.data(), imu_samples.size());
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        }
+
+        // A batch needs at least one sample
+        result = k4a_record_write_imu_samples(handle, NULL, 0);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
     { // Create a recording file with only the color camera enabled
         k4a_record_t handle = NULL;
         k4a_result_t result = k4a_record_create("record_test_color_only.mkv", NULL, record_config_color_only, &handle);
@@ -331,6 +390,359 @@ void SampleRecordings::SetUp()
         result = k4a_record_flush(handle);
         ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
 
+        k4a_record_close(handle);
+    }
+    { // Create a recording file that references the color images instead of copying them
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_zero_copy.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_zero_copy(handle, true);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_full.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            // The capture is released right away, the recording holds the color image until it is written
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
+    { // Create a recording file with RVL compressed depth and IR tracks
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_rvl.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_depth_codec(handle, K4A_RECORD_DEPTH_CODEC_RVL);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The codec can't be changed once the header is written
+        result = k4a_record_set_depth_codec(handle, K4A_RECORD_DEPTH_CODEC_RAW);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_full.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
+    { // Create a recording file written with unbuffered IO
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_unbuffered.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_unbuffered_io(handle, true);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The file can't be created again once the header is written
+        result = k4a_record_set_unbuffered_io(handle, false);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_full.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
+    { // Create a recording split into files of 1 second each
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_segmented.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_segment_limits(handle, 1000000, 0);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The limits can't be changed once the header is written
+        result = k4a_record_set_segment_limits(handle, 0, 0);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_full.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        k4a_record_close(handle);
+    }
+    { // Create a recording that writes its index while recording
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_live_index.mkv", NULL, record_config_full, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_live_index(handle, true);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The index can't be enabled once the header is written
+        result = k4a_record_set_live_index(handle, false);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_full.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_full.color_format,
+                                                        record_config_full.color_resolution,
+                                                        record_config_full.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        k4a_record_close(handle);
+    }
+    { // Create a recording with a color track compressed by a video encoder
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_color_encoder.mkv",
+                                                NULL,
+                                                record_config_nv12_color,
+                                                &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        test_color_codec codec = {};
+        codec.key_frame_interval = 10;
+        const uint8_t codec_context[] = { 1, 2, 3, 4 };
+        result = k4a_record_set_color_encoder(handle,
+                                              "V_K4A/TEST_XOR",
+                                              codec_context,
+                                              sizeof(codec_context),
+                                              test_color_encode,
+                                              &codec);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The encoder can't be changed once the header is written
+        result = k4a_record_set_color_encoder(handle, "V_K4A/TEST_XOR", NULL, 0, test_color_encode, &codec);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_nv12_color.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_nv12_color.color_format,
+                                                        record_config_nv12_color.color_resolution,
+                                                        record_config_nv12_color.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+        ASSERT_EQ(codec.frame_count, test_frame_count);
+    }
+    { // Create a recording with NV12 color images compressed to MJPG
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_color_jpeg.mkv", NULL, record_config_nv12_color, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        // The codec can't be changed once the header is written
+        result = k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_RAW);
+        ASSERT_EQ(result, K4A_RESULT_FAILED);
+
+        // JPEG compression needs full size images, filled with mid gray here
+        uint32_t width = 0, height = 0;
+        ASSERT_TRUE(k4a_convert_resolution_to_width_height(record_config_nv12_color.color_resolution, &width, &height));
+        uint64_t timestamp = 0;
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_nv12_color.camera_fps));
+        for (size_t i = 0; i < 10; i++)
+        {
+            k4a_image_t color_image = NULL;
+            result = k4a_image_create(K4A_IMAGE_FORMAT_COLOR_NV12, (int)width, (int)height, (int)width, &color_image);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            memset(k4a_image_get_buffer(color_image), 128, k4a_image_get_size(color_image));
+            k4a_image_set_device_timestamp_usec(color_image, timestamp);
+
+            k4a_capture_t capture = NULL;
+            result = k4a_capture_create(&capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_set_color_image(capture, color_image);
+            k4a_image_release(color_image);
+
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamp += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
+    { // Create the recordings of a synchronized master and subordinate, the subordinate drops frame 10
+        const char *paths[] = { "record_test_group_master.mkv", "record_test_group_sub.mkv" };
+        k4a_device_configuration_t configs[] = { record_config_master, record_config_sub };
+        for (size_t device = 0; device < 2; device++)
+        {
+            k4a_record_t handle = NULL;
+            k4a_result_t result = k4a_record_create(paths[device], NULL, configs[device], &handle);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            result = k4a_record_write_header(handle);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            uint64_t delay = configs[device].subordinate_delay_off_master_usec;
+            uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(configs[device].camera_fps));
+            for (uint64_t i = 0; i < 30; i++)
+            {
+                if (device == 1 && i == 10)
+                {
+                    continue;
+                }
+
+                uint64_t timestamps[3] = { i * timestamp_delta + delay,
+                                           i * timestamp_delta + delay,
+                                           i * timestamp_delta + delay };
+                k4a_capture_t capture = create_test_capture(timestamps,
+                                                            configs[device].color_format,
+                                                            configs[device].color_resolution,
+                                                            configs[device].depth_mode);
+                result = k4a_record_write_capture(handle, capture);
+                ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+                k4a_capture_release(capture);
+            }
+
+            result = k4a_record_flush(handle);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+            k4a_record_close(handle);
+        }
+    }
+    { // Create a single recording holding the same master and subordinate, the subordinate drops frame 10
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_group_single.mkv", NULL, record_config_master, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint32_t device_index = 0;
+        result = k4a_record_add_device(handle, NULL, record_config_sub, &device_index);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(device_index, 1u);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_device_configuration_t configs[] = { record_config_master, record_config_sub };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_master.camera_fps));
+        for (uint64_t i = 0; i < 30; i++)
+        {
+            for (uint32_t device = 0; device < 2; device++)
+            {
+                if (device == 1 && i == 10)
+                {
+                    continue;
+                }
+
+                uint64_t delay = configs[device].subordinate_delay_off_master_usec;
+                uint64_t timestamps[3] = { i * timestamp_delta + delay,
+                                           i * timestamp_delta + delay,
+                                           i * timestamp_delta + delay };
+                k4a_capture_t capture = create_test_capture(timestamps,
+                                                            configs[device].color_format,
+                                                            configs[device].color_resolution,
+                                                            configs[device].depth_mode);
+                result = k4a_record_write_device_capture(handle, device, capture);
+                ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+                k4a_capture_release(capture);
+            }
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
         k4a_record_close(handle);
     }
 }
@@ -343,17 +755,34 @@ void SampleRecordings::TearDown()
     ASSERT_EQ(std::remove("record_test_skips.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_sub.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_offset.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_imu_batch.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_color_only.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_depth_only.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_bgra_color.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_zero_copy.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_rvl.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_unbuffered.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_segmented.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_segmented_001.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_segmented_002.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_segmented_003.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_live_index.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_live_index.mkv.k4aidx"), 0);
+    ASSERT_EQ(std::remove("record_test_color_encoder.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_color_jpeg.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_group_master.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_group_sub.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_group_single.mkv"), 0);
 }
 
-void CustomTrackRecordings::SetUp()
+// Uses the custom track recording API to create a recording with Depth and IR tracks. With owned_and_batch_writes, the
+// IR track is written with k4a_record_write_custom_track_data_owned() and the high frequency track with
+// k4a_record_write_custom_track_data_batch() instead of k4a_record_write_custom_track_data(), which must produce the
+// same recording.
+static void create_custom_track_recording(const char *path, bool owned_and_batch_writes)
 {
-    // Use custom track recording API to create a recording with Depth and IR tracks
     k4a_record_t handle = NULL;
-    k4a_result_t result =
-        k4a_record_create("record_test_custom_track.mkv", NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle);
+    k4a_result_t result = k4a_record_create(path, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle);
     ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
 
     k4arecord::BITMAPINFOHEADER depth_codec_header;
@@ -441,12 +870,28 @@ void CustomTrackRecordings::SetUp()
                                                     static_cast<uint32_t>(k4a_image_get_size(depth_image)));
         ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
 
-        result = k4a_record_write_custom_track_data(handle,
-                                                    "IR",
-                                                    k4a_image_get_device_timestamp_usec(ir_image),
-                                                    k4a_image_get_buffer(ir_image),
-                                                    static_cast<uint32_t>(k4a_image_get_size(ir_image)));
-        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        if (owned_and_batch_writes)
+        {
+            // The IR track is written without a copy, the recording releases the image once it has been written.
+            result = k4a_record_write_custom_track_data_owned(
+                handle,
+                "IR",
+                k4a_image_get_device_timestamp_usec(ir_image),
+                k4a_image_get_buffer(ir_image),
+                k4a_image_get_size(ir_image),
+                [](void *, void *context) { k4a_image_release(static_cast<k4a_image_t>(context)); },
+                ir_image);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        }
+        else
+        {
+            result = k4a_record_write_custom_track_data(handle,
+                                                        "IR",
+                                                        k4a_image_get_device_timestamp_usec(ir_image),
+                                                        k4a_image_get_buffer(ir_image),
+                                                        static_cast<uint32_t>(k4a_image_get_size(ir_image)));
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        }
 
         // Write data to the custom subtitle tracks
         std::vector<uint8_t> custom_track_block = create_test_custom_track_block(timestamp_usec);
@@ -458,20 +903,42 @@ void CustomTrackRecordings::SetUp()
         ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
 
         // Write the high frequency track at 10x the rate of the regular track.
-        for (uint64_t j = 0; j < 10; j++)
+        if (owned_and_batch_writes)
         {
-            uint64_t timestamp_usec_high_freq = timestamp_usec + j * test_timestamp_delta_usec / 10;
-            custom_track_block = create_test_custom_track_block(timestamp_usec_high_freq);
-            result = k4a_record_write_custom_track_data(handle,
-                                                        "CUSTOM_TRACK_HIGH_FREQ",
-                                                        timestamp_usec_high_freq,
-                                                        custom_track_block.data(),
-                                                        custom_track_block.size());
+            std::vector<std::vector<uint8_t>> high_freq_data(10);
+            std::vector<k4a_record_custom_track_block_t> high_freq_blocks(10);
+            for (uint64_t j = 0; j < 10; j++)
+            {
+                uint64_t timestamp_usec_high_freq = timestamp_usec + j * test_timestamp_delta_usec / 10;
+                high_freq_data[j] = create_test_custom_track_block(timestamp_usec_high_freq);
+                high_freq_blocks[j] = { timestamp_usec_high_freq, high_freq_data[j].data(), high_freq_data[j].size() };
+            }
+            result = k4a_record_write_custom_track_data_batch(handle,
+                                                              "CUSTOM_TRACK_HIGH_FREQ",
+                                                              high_freq_blocks.data(),
+                                                              high_freq_blocks.size());
             ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
         }
+        else
+        {
+            for (uint64_t j = 0; j < 10; j++)
+            {
+                uint64_t timestamp_usec_high_freq = timestamp_usec + j * test_timestamp_delta_usec / 10;
+                custom_track_block = create_test_custom_track_block(timestamp_usec_high_freq);
+                result = k4a_record_write_custom_track_data(handle,
+                                                            "CUSTOM_TRACK_HIGH_FREQ",
+                                                            timestamp_usec_high_freq,
+                                                            custom_track_block.data(),
+                                                            custom_track_block.size());
+                ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            }
+        }
 
         k4a_image_release(depth_image);
-        k4a_image_release(ir_image);
+        if (!owned_and_batch_writes)
+        {
+            k4a_image_release(ir_image);
+        }
 
         timestamp_usec += test_timestamp_delta_usec;
     }
@@ -482,7 +949,14 @@ void CustomTrackRecordings::SetUp()
     k4a_record_close(handle);
 }
 
+void CustomTrackRecordings::SetUp()
+{
+    create_custom_track_recording("record_test_custom_track.mkv", false);
+    create_custom_track_recording("record_test_custom_track_owned.mkv", true);
+}
+
 void CustomTrackRecordings::TearDown()
 {
     ASSERT_EQ(std::remove("record_test_custom_track.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_custom_track_owned.mkv"), 0);
 }
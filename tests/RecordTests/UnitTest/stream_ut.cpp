@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <vector>
+
+#include "test_helpers.h"
+
+// Module being tested
+#include <k4arecord/stream.h>
+#include <k4a/k4a.h>
+
+using namespace testing;
+
+class stream_ut : public ::testing::Test
+{
+protected:
+    k4a_stream_server_t server = NULL;
+    k4a_stream_client_t client = NULL;
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+
+    void SetUp() override
+    {
+        config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+        config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+        config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+        config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_stream_server_create(0, NULL, config, &server));
+        uint16_t port = k4a_stream_server_get_port(server);
+        ASSERT_NE(0, port);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_stream_client_open("127.0.0.1", port, &client));
+    }
+
+    void TearDown() override
+    {
+        k4a_stream_client_close(client);
+        k4a_stream_server_close(server);
+    }
+
+    // k4a_stream_client_open() returns once the server has accepted the client, so a written capture is sent to it.
+    k4a_capture_t write_and_receive(k4a_capture_t capture)
+    {
+        k4a_capture_t received = NULL;
+        EXPECT_EQ(K4A_RESULT_SUCCEEDED, k4a_stream_server_write_capture(server, capture));
+        EXPECT_EQ(K4A_WAIT_RESULT_SUCCEEDED, k4a_stream_client_get_capture(client, &received, 5000));
+        return received;
+    }
+};
+
+// Creates a packed depth image with every pixel set, so the whole image goes through the depth codec
+static k4a_image_t create_depth_image(uint64_t timestamp_us, int width, int height)
+{
+    k4a_image_t image = NULL;
+    EXPECT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, width, height, width * (int)sizeof(uint16_t), &image));
+    uint16_t *pixels = reinterpret_cast<uint16_t *>(k4a_image_get_buffer(image));
+    for (int i = 0; i < width * height; i++)
+    {
+        pixels[i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+    k4a_image_set_device_timestamp_usec(image, timestamp_us);
+    k4a_image_set_system_timestamp_nsec(image, timestamp_us * 1000 + 17);
+    return image;
+}
+
+static void validate_depth_image(k4a_image_t expected, k4a_image_t actual)
+{
+    ASSERT_NE(actual, nullptr);
+    ASSERT_EQ(k4a_image_get_format(expected), k4a_image_get_format(actual));
+    ASSERT_EQ(k4a_image_get_width_pixels(expected), k4a_image_get_width_pixels(actual));
+    ASSERT_EQ(k4a_image_get_height_pixels(expected), k4a_image_get_height_pixels(actual));
+    ASSERT_EQ(k4a_image_get_stride_bytes(expected), k4a_image_get_stride_bytes(actual));
+    ASSERT_EQ(k4a_image_get_device_timestamp_usec(expected), k4a_image_get_device_timestamp_usec(actual));
+    ASSERT_EQ(k4a_image_get_system_timestamp_nsec(expected), k4a_image_get_system_timestamp_nsec(actual));
+    ASSERT_EQ(k4a_image_get_size(expected), k4a_image_get_size(actual));
+    ASSERT_EQ(0, memcmp(k4a_image_get_buffer(expected), k4a_image_get_buffer(actual), k4a_image_get_size(expected)));
+}
+
+TEST_F(stream_ut, device_configuration)
+{
+    k4a_device_configuration_t client_config;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_stream_client_get_device_configuration(client, &client_config));
+    ASSERT_EQ(config.color_format, client_config.color_format);
+    ASSERT_EQ(config.color_resolution, client_config.color_resolution);
+    ASSERT_EQ(config.depth_mode, client_config.depth_mode);
+    ASSERT_EQ(config.camera_fps, client_config.camera_fps);
+
+    // The server was created without a device
+    k4a_calibration_t calibration;
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_stream_client_get_calibration(client, &calibration));
+}
+
+TEST_F(stream_ut, stream_mjpeg_passthrough)
+{
+    uint64_t timestamps[3] = { 1000, 1000, 1000 };
+    k4a_capture_t capture = create_test_capture(timestamps,
+                                                K4A_IMAGE_FORMAT_COLOR_MJPG,
+                                                K4A_COLOR_RESOLUTION_1080P,
+                                                K4A_DEPTH_MODE_OFF);
+
+    k4a_capture_t received = write_and_receive(capture);
+    ASSERT_NE(received, nullptr);
+    ASSERT_TRUE(validate_test_capture(received,
+                                      timestamps,
+                                      K4A_IMAGE_FORMAT_COLOR_MJPG,
+                                      K4A_COLOR_RESOLUTION_1080P,
+                                      K4A_DEPTH_MODE_OFF));
+
+    k4a_capture_release(received);
+    k4a_capture_release(capture);
+}
+
+TEST_F(stream_ut, stream_depth_codecs)
+{
+    for (k4a_record_depth_codec_t codec : { K4A_RECORD_DEPTH_CODEC_RVL, K4A_RECORD_DEPTH_CODEC_RAW })
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_stream_server_set_depth_codec(server, codec));
+
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_capture_create(&capture));
+        k4a_image_t depth_image = create_depth_image(2000 + (uint64_t)codec, 640, 576);
+        k4a_capture_set_depth_image(capture, depth_image);
+
+        k4a_capture_t received = write_and_receive(capture);
+        ASSERT_NE(received, nullptr);
+        k4a_image_t received_image = k4a_capture_get_depth_image(received);
+        validate_depth_image(depth_image, received_image);
+
+        k4a_image_release(received_image);
+        k4a_capture_release(received);
+        k4a_image_release(depth_image);
+        k4a_capture_release(capture);
+    }
+}
+
+TEST_F(stream_ut, invalid_arguments)
+{
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_stream_server_set_queue_limit(server, 0));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_stream_server_set_depth_codec(server, (k4a_record_depth_codec_t)-1));
+    ASSERT_EQ(K4A_RESULT_FAILED, k4a_stream_server_write_capture(server, NULL));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, k4a_stream_client_get_capture(client, NULL, 0));
+
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, k4a_stream_client_get_capture(client, &capture, 0));
+}
+
+TEST_F(stream_ut, server_closed)
+{
+    k4a_stream_server_close(server);
+    server = NULL;
+
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, k4a_stream_client_get_capture(client, &capture, K4A_WAIT_INFINITE));
+}
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
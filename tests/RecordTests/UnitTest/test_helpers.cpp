@@ -6,6 +6,7 @@
 #include <k4ainternal/common.h>
 #include <k4ainternal/logging.h>
 #include <k4ainternal/matroska_common.h>
+#include <cstring>
 
 #define EXIT_IF_FALSE(x)                                                                                               \
     {                                                                                                                  \
@@ -252,6 +253,107 @@ bool validate_test_image(k4a_image_t image,
     return false;
 }
 
+// Each encoded frame starts with this header, followed by the frame data.
+struct test_color_frame_header
+{
+    uint8_t key_frame;
+    uint64_t previous_timestamp_us; // The frame a delta frame was encoded against
+};
+
+k4a_result_t test_color_encode(k4a_image_t color_image,
+                               const uint8_t **encoded_data,
+                               size_t *encoded_size,
+                               bool *key_frame,
+                               void *context)
+{
+    test_color_codec *codec = static_cast<test_color_codec *>(context);
+    const uint8_t *buffer = k4a_image_get_buffer(color_image);
+    size_t buffer_size = k4a_image_get_size(color_image);
+
+    test_color_frame_header header = {};
+    header.key_frame = codec->frame_count % codec->key_frame_interval == 0 ? 1 : 0;
+    header.previous_timestamp_us = codec->previous_timestamp_us;
+    if (!header.key_frame && codec->previous_frame.size() != buffer_size)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    codec->encoded_frame.resize(sizeof(header) + buffer_size);
+    memcpy(codec->encoded_frame.data(), &header, sizeof(header));
+    for (size_t i = 0; i < buffer_size; i++)
+    {
+        codec->encoded_frame[sizeof(header) + i] = header.key_frame ? buffer[i] : buffer[i] ^ codec->previous_frame[i];
+    }
+
+    codec->previous_frame.assign(buffer, buffer + buffer_size);
+    codec->previous_timestamp_us = k4a_image_get_device_timestamp_usec(color_image);
+    codec->frame_count++;
+
+    *encoded_data = codec->encoded_frame.data();
+    *encoded_size = codec->encoded_frame.size();
+    *key_frame = header.key_frame != 0;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t test_color_decode(const uint8_t *encoded_data,
+                               size_t encoded_size,
+                               uint64_t device_timestamp_usec,
+                               k4a_image_format_t target_format,
+                               k4a_image_t *color_image,
+                               void *context)
+{
+    test_color_codec *codec = static_cast<test_color_codec *>(context);
+    test_color_frame_header header;
+    if (encoded_size < sizeof(header) || target_format != codec->format)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    memcpy(&header, encoded_data, sizeof(header));
+    const uint8_t *data = encoded_data + sizeof(header);
+    size_t data_size = encoded_size - sizeof(header);
+
+    if (header.key_frame)
+    {
+        codec->previous_frame.assign(data, data + data_size);
+    }
+    else
+    {
+        // Delta frames can only be decoded right after the frame they were encoded against.
+        if (codec->previous_timestamp_us != header.previous_timestamp_us || codec->previous_frame.size() != data_size)
+        {
+            LOG_ERROR("PlaybackTest, frame %llu decoded out of order", device_timestamp_usec);
+            return K4A_RESULT_FAILED;
+        }
+        for (size_t i = 0; i < data_size; i++)
+        {
+            codec->previous_frame[i] ^= data[i];
+        }
+    }
+    codec->previous_timestamp_us = device_timestamp_usec;
+    codec->frame_count++;
+
+    if (color_image != NULL)
+    {
+        uint8_t *buffer = new uint8_t[data_size];
+        memcpy(buffer, codec->previous_frame.data(), data_size);
+        k4a_result_t result = k4a_image_create_from_buffer(target_format,
+                                                           (int)codec->width,
+                                                           (int)codec->height,
+                                                           (int)codec->stride,
+                                                           buffer,
+                                                           data_size,
+                                                           [](void *_buffer, void *) { delete[](uint8_t *) _buffer; },
+                                                           NULL,
+                                                           color_image);
+        if (K4A_FAILED(result))
+        {
+            delete[] buffer;
+            return result;
+        }
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us)
 {
     k4a_imu_sample_t sample = {};
@@ -6,8 +6,10 @@
 
 #include <utcommon.h>
 #include <k4a/k4a.h>
+#include <k4arecord/types.h>
 #include <chrono>
 #include <iostream>
+#include <vector>
 
 static const char *const format_names[] = { "K4A_IMAGE_FORMAT_COLOR_MJPG", "K4A_IMAGE_FORMAT_COLOR_NV12",
                                             "K4A_IMAGE_FORMAT_COLOR_YUY2", "K4A_IMAGE_FORMAT_COLOR_BGRA32",
@@ -65,6 +67,34 @@ struct custom_track_test_data
 std::vector<uint8_t> create_test_custom_track_block(uint64_t timestamp_us);
 bool validate_custom_track_block(const uint8_t *block, size_t block_size, uint64_t timestamp_us);
 
+// A test video codec for k4a_record_set_color_encoder() and k4a_playback_set_color_decoder(). Key frames are stored
+// as is, and the frames in between as the XOR with the frame before them, so they can only be decoded after it.
+struct test_color_codec
+{
+    k4a_image_format_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    size_t key_frame_interval;
+
+    size_t frame_count;             // The number of frames encoded or decoded
+    uint64_t previous_timestamp_us; // The timestamp of previous_frame
+    std::vector<uint8_t> previous_frame;
+    std::vector<uint8_t> encoded_frame;
+};
+
+k4a_result_t test_color_encode(k4a_image_t color_image,
+                               const uint8_t **encoded_data,
+                               size_t *encoded_size,
+                               bool *key_frame,
+                               void *context);
+k4a_result_t test_color_decode(const uint8_t *encoded_data,
+                               size_t encoded_size,
+                               uint64_t device_timestamp_usec,
+                               k4a_image_format_t target_format,
+                               k4a_image_t *color_image,
+                               void *context);
+
 class SampleRecordings : public ::testing::Environment
 {
 public:
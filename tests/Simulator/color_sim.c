@@ -0,0 +1,298 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Simulated implementation of color.h. Frames are allocated and wrapped in captures the way the UVC camera reader
+// does, paced by sim_stream. Color controls report the default of every control and accept any value.
+
+// This library
+#include <k4ainternal/color.h>
+#include "simulator.h"
+#include "sim_stream.h"
+
+// Dependent libraries
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+
+// System dependencies
+#include <string.h>
+
+typedef struct _color_context_t
+{
+    TICK_COUNTER_HANDLE tick;
+    color_cb_streaming_capture_t *capture_ready_cb;
+    void *capture_ready_cb_context;
+
+    tickcounter_ms_t sensor_start_time_tick;
+    k4a_image_format_t format;
+    int width_pixels;
+    int height_pixels;
+    int stride_bytes;
+    size_t frame_size;
+    sim_stream_t stream;
+} color_context_t;
+
+K4A_DECLARE_CONTEXT(color_t, color_context_t);
+
+static simulator_stream_config_t g_color_stream_config;
+
+void simulator_set_color_stream_config(const simulator_stream_config_t *config)
+{
+    if (config)
+    {
+        g_color_stream_config = *config;
+    }
+    else
+    {
+        memset(&g_color_stream_config, 0, sizeof(g_color_stream_config));
+    }
+}
+
+k4a_result_t color_create(TICK_COUNTER_HANDLE tick_handle,
+                          const guid_t *container_id,
+                          const char *serial_number,
+                          color_cb_streaming_capture_t capture_ready_cb,
+                          void *capture_ready_cb_context,
+                          color_t *color_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, tick_handle == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_ready_cb == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, color_handle == NULL);
+    (void)container_id;
+    (void)serial_number;
+
+    color_context_t *color = color_t_create(color_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(color != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        color->tick = tick_handle;
+        color->capture_ready_cb = capture_ready_cb;
+        color->capture_ready_cb_context = capture_ready_cb_context;
+    }
+
+    return result;
+}
+
+void color_destroy(color_t color_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, color_t, color_handle);
+
+    color_stop(color_handle);
+    color_t_destroy(color_handle);
+}
+
+k4a_result_t color_set_scale(color_t color_handle, k4a_color_scale_t scale)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+
+    // Frames are delivered at the resolution of the camera mode, there is no decoder to scale them
+    return K4A_RESULT_FROM_BOOL(scale == K4A_COLOR_SCALE_FULL);
+}
+
+static void color_free_allocation(void *buffer, void *context)
+{
+    (void)context;
+    allocator_free(buffer);
+}
+
+static void color_sim_frame_ready(uint64_t frame_index, uint64_t device_timestamp_usec, void *context)
+{
+    color_context_t *color = (color_context_t *)context;
+    k4a_capture_t capture = NULL;
+    k4a_image_t image = NULL;
+
+    uint8_t *buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, color->frame_size);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(buffer != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        const uint8_t *frame = sim_stream_get_frame(&color->stream.config, frame_index);
+        if (frame)
+        {
+            memcpy(buffer, frame, color->frame_size);
+        }
+        else
+        {
+            memset(buffer, 0, color->frame_size);
+        }
+
+        result = TRACE_CALL(image_create_from_buffer(color->format,
+                                                     color->width_pixels,
+                                                     color->height_pixels,
+                                                     color->stride_bytes,
+                                                     buffer,
+                                                     color->frame_size,
+                                                     color_free_allocation,
+                                                     NULL,
+                                                     &image));
+        if (K4A_FAILED(result))
+        {
+            allocator_free(buffer);
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        image_set_device_timestamp_usec(image, device_timestamp_usec);
+        result = TRACE_CALL(image_apply_system_timestamp(image));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(capture_create(&capture));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        capture_set_color_image(capture, image);
+    }
+
+    color->capture_ready_cb(result, capture, color->capture_ready_cb_context);
+
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+    if (capture)
+    {
+        capture_dec_ref(capture);
+    }
+}
+
+k4a_result_t color_start(color_t color_handle, const k4a_device_configuration_t *config)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+    color_context_t *color = color_t_get_context(color_handle);
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!k4a_convert_resolution_to_width_height(config->color_resolution, &width, &height))
+    {
+        LOG_ERROR("Invalid color resolution %d", config->color_resolution);
+        return K4A_RESULT_FAILED;
+    }
+
+    color->format = config->color_format;
+    color->width_pixels = (int)width;
+    color->height_pixels = (int)height;
+    switch (config->color_format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        // MJPEG frames vary in size, a quarter of the YUY2 size is a generous estimate of a compressed frame
+        color->stride_bytes = 0;
+        color->frame_size = (size_t)width * height / 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        color->stride_bytes = (int)width;
+        color->frame_size = (size_t)width * height * 3 / 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        color->stride_bytes = (int)width * 2;
+        color->frame_size = (size_t)width * height * 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        color->stride_bytes = (int)width * 4;
+        color->frame_size = (size_t)width * height * 4;
+        break;
+    default:
+        LOG_ERROR("Invalid color format %d", config->color_format);
+        return K4A_RESULT_FAILED;
+    }
+
+    simulator_stream_config_t stream_config = g_color_stream_config;
+    if (stream_config.fps == 0)
+    {
+        stream_config.fps = k4a_convert_fps_to_uint(config->camera_fps);
+    }
+    if (stream_config.frame_size != 0)
+    {
+        color->frame_size = stream_config.frame_size;
+    }
+    else
+    {
+        stream_config.frame_size = color->frame_size;
+    }
+
+    if (tickcounter_get_current_ms(color->tick, &color->sensor_start_time_tick) != 0)
+    {
+        LOG_ERROR("Failed to read the start time of the color camera", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(sim_stream_start(&color->stream, &stream_config, color_sim_frame_ready, color));
+    if (K4A_FAILED(result))
+    {
+        color->sensor_start_time_tick = 0;
+    }
+
+    return result;
+}
+
+void color_stop(color_t color_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, color_t, color_handle);
+    color_context_t *color = color_t_get_context(color_handle);
+
+    sim_stream_stop(&color->stream);
+    color->sensor_start_time_tick = 0;
+}
+
+tickcounter_ms_t color_get_sensor_start_time_tick(const color_t color_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(0, color_t, color_handle);
+    color_context_t *color = color_t_get_context(color_handle);
+    return color->sensor_start_time_tick;
+}
+
+k4a_result_t color_get_control_capabilities(const color_t color_handle,
+                                            const k4a_color_control_command_t command,
+                                            bool *supports_auto,
+                                            int32_t *min_value,
+                                            int32_t *max_value,
+                                            int32_t *step_value,
+                                            int32_t *default_value,
+                                            k4a_color_control_mode_t *default_mode)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, supports_auto == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, min_value == NULL || max_value == NULL || step_value == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, default_value == NULL || default_mode == NULL);
+    (void)command;
+
+    *supports_auto = false;
+    *min_value = 0;
+    *max_value = 0;
+    *step_value = 1;
+    *default_value = 0;
+    *default_mode = K4A_COLOR_CONTROL_MODE_MANUAL;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t color_get_control(const color_t color_handle,
+                               const k4a_color_control_command_t command,
+                               k4a_color_control_mode_t *mode,
+                               int32_t *value)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, mode == NULL || value == NULL);
+    (void)command;
+
+    *mode = K4A_COLOR_CONTROL_MODE_MANUAL;
+    *value = 0;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t color_set_control(const color_t color_handle,
+                               const k4a_color_control_command_t command,
+                               const k4a_color_control_mode_t mode,
+                               int32_t value)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, color_t, color_handle);
+    (void)command;
+    (void)mode;
+    (void)value;
+    return K4A_RESULT_SUCCEEDED;
+}
@@ -0,0 +1,417 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <ut_calibration_data.h>
+
+#ifdef K4A_IMU_PERF_SIMULATOR
+#include "simulator.h"
+#endif
+
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/calibration.h>
+#include <k4ainternal/color_mcu.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/depth_mcu.h>
+#include <k4ainternal/imu.h>
+#include <azure_c_shared_utility/threadapi.h>
+#include <azure_c_shared_utility/tickcounter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Measures the IMU path from the color MCU's USB stream through imu_capture_ready(), which unpacks each packet into
+// the sample ring, to the reads of the application. Samples are read one at a time with imu_get_sample() or in
+// batches with imu_get_samples(), by a consumer that can stall periodically. Results are printed and appended to
+// imu_perf_results.csv.
+//
+// imu_perf_sim runs on the simulated USB backend, which sends packets of samples at the sample rate of the device,
+// imu_perf runs on a device.
+//
+// The device and host clocks are not related, so the latency of each sample is its host receipt time minus its device
+// timestamp, less the smallest such difference of the run. It is the delay of each sample over the fastest one, which
+// for the last sample of a packet read right away is close to the transfer time alone.
+
+static int g_seconds = 5;
+
+using ::testing::ValuesIn;
+
+enum imu_read_mode
+{
+    IMU_READ_SAMPLE,  // imu_get_sample(), one sample per call
+    IMU_READ_SAMPLES, // imu_get_samples(), up to batch_size samples per call
+};
+
+struct imu_parameters
+{
+    int test_number;
+    imu_read_mode read_mode;
+    uint32_t batch_size;
+    uint32_t queue_depth; // Samples buffered by the IMU, 0 for the default
+    k4a_queue_policy_t queue_policy;
+    uint32_t stall_ms;          // The consumer stops reading for this long
+    uint32_t stall_interval_ms; // every this often
+    uint32_t jitter_usec;       // Simulated packet jitter
+
+    friend std::ostream &operator<<(std::ostream &os, const imu_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class imu_perf : public ::testing::Test, public ::testing::WithParamInterface<imu_parameters>
+{
+public:
+    virtual void SetUp()
+    {
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("imu_perf_results.csv", "a")));
+        allocator_initialize();
+    }
+
+    virtual void TearDown()
+    {
+#ifdef K4A_IMU_PERF_SIMULATOR
+        simulator_set_usb_stream_config(USB_DEVICE_COLOR_IMU_PROCESSOR, NULL);
+        simulator_set_calibration(NULL, 0);
+#endif
+        allocator_deinitialize();
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    FILE *m_file_handle;
+};
+
+static uint64_t get_host_time_usec()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static uint64_t get_thread_cpu_usec()
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        return 0;
+    }
+    ULARGE_INTEGER kernel = { { kernel_time.dwLowDateTime, kernel_time.dwHighDateTime } };
+    ULARGE_INTEGER user = { { user_time.dwLowDateTime, user_time.dwHighDateTime } };
+    return (kernel.QuadPart + user.QuadPart) / 10;
+#else
+    struct timespec ts_time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_time) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)ts_time.tv_sec * 1000000 + (uint64_t)ts_time.tv_nsec / 1000;
+#endif
+}
+
+static const char *get_policy_name(k4a_queue_policy_t policy)
+{
+    switch (policy)
+    {
+    case K4A_QUEUE_POLICY_DROP_OLDEST:
+        return "drop_oldest";
+    case K4A_QUEUE_POLICY_DROP_NEWEST:
+        return "drop_newest";
+    case K4A_QUEUE_POLICY_BLOCK:
+        return "block";
+    }
+    return "unknown";
+}
+
+// Counts the samples missing from a sequence of accelerometer timestamps, from the gaps longer than the usual period
+static uint64_t count_missing_samples(const std::vector<uint64_t> &timestamps_usec)
+{
+    std::vector<uint64_t> periods;
+    for (size_t i = 1; i < timestamps_usec.size(); i++)
+    {
+        if (timestamps_usec[i] > timestamps_usec[i - 1])
+        {
+            periods.push_back(timestamps_usec[i] - timestamps_usec[i - 1]);
+        }
+    }
+    if (periods.empty())
+    {
+        return 0;
+    }
+
+    std::vector<uint64_t> sorted_periods = periods;
+    std::nth_element(sorted_periods.begin(), sorted_periods.begin() + sorted_periods.size() / 2, sorted_periods.end());
+    uint64_t period = std::max<uint64_t>(sorted_periods[sorted_periods.size() / 2], 1);
+
+    uint64_t missing = 0;
+    for (uint64_t gap : periods)
+    {
+        if (gap * 2 > period * 3)
+        {
+            missing += (gap + period / 2) / period - 1;
+        }
+    }
+    return missing;
+}
+
+TEST_P(imu_perf, testTest)
+{
+    auto as = GetParam();
+
+#ifdef K4A_IMU_PERF_SIMULATOR
+    simulator_set_calibration(g_test_json, sizeof(g_test_json));
+    simulator_stream_config_t stream_config = {};
+    stream_config.jitter_usec = as.jitter_usec;
+    stream_config.seed = 3;
+    simulator_set_usb_stream_config(USB_DEVICE_COLOR_IMU_PROCESSOR, &stream_config);
+#endif
+
+    TICK_COUNTER_HANDLE tick = tickcounter_create();
+    ASSERT_NE((TICK_COUNTER_HANDLE)NULL, tick);
+
+    depthmcu_t depthmcu = NULL;
+    colormcu_t colormcu = NULL;
+    calibration_t calibration = NULL;
+    imu_t imu = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_create(0, &depthmcu));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, colormcu_create_by_index(0, &colormcu));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, calibration_create(depthmcu, &calibration));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_create(tick, colormcu, calibration, &imu));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_set_queue_policy(imu, as.queue_depth, as.queue_policy));
+
+    std::vector<k4a_imu_sample_t> samples(as.read_mode == IMU_READ_SAMPLE ? 1 : as.batch_size);
+    std::vector<uint64_t> timestamps_usec;
+    std::vector<int64_t> receipt_offsets_usec;
+    timestamps_usec.reserve((size_t)g_seconds * K4A_IMU_SAMPLE_RATE * 2);
+    receipt_offsets_usec.reserve(timestamps_usec.capacity());
+    uint64_t reads = 0;
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, imu_start(imu, 0));
+
+    const uint64_t start_usec = get_host_time_usec();
+    const uint64_t end_usec = start_usec + (uint64_t)g_seconds * 1000000;
+    uint64_t next_stall_usec = start_usec + (uint64_t)as.stall_interval_ms * 1000;
+    const uint64_t start_cpu_usec = get_thread_cpu_usec();
+
+    for (uint64_t now_usec = start_usec; now_usec < end_usec; now_usec = get_host_time_usec())
+    {
+        size_t sample_count = 0;
+        k4a_wait_result_t result;
+        if (as.read_mode == IMU_READ_SAMPLE)
+        {
+            result = imu_get_sample(imu, samples.data(), 100);
+            sample_count = 1;
+        }
+        else
+        {
+            result = imu_get_samples(imu, samples.data(), samples.size(), &sample_count, 100);
+        }
+        uint64_t receipt_usec = get_host_time_usec();
+
+        ASSERT_NE(K4A_WAIT_RESULT_FAILED, result);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            reads++;
+            for (size_t i = 0; i < sample_count; i++)
+            {
+                timestamps_usec.push_back(samples[i].acc_timestamp_usec);
+                receipt_offsets_usec.push_back((int64_t)receipt_usec - (int64_t)samples[i].acc_timestamp_usec);
+            }
+        }
+
+        if (as.stall_ms != 0 && receipt_usec >= next_stall_usec)
+        {
+            // An application that falls behind, so the queue policy decides which samples are dropped
+            ThreadAPI_Sleep(as.stall_ms);
+            next_stall_usec = get_host_time_usec() + (uint64_t)as.stall_interval_ms * 1000;
+        }
+    }
+
+    const uint64_t consumer_cpu_usec = get_thread_cpu_usec() - start_cpu_usec;
+    const double seconds = (double)(get_host_time_usec() - start_usec) / 1000000;
+
+    k4a_usb_stream_stats_t usb_stats = {};
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, colormcu_imu_get_usb_stream_stats(colormcu, &usb_stats));
+    imu_stop(imu);
+
+#ifdef K4A_IMU_PERF_SIMULATOR
+    const uint64_t producer_cpu_usec = simulator_get_callback_cpu_usec(USB_DEVICE_COLOR_IMU_PROCESSOR);
+#else
+    // The USB thread of the device isn't ours to measure
+    const uint64_t producer_cpu_usec = 0;
+#endif
+
+    imu_destroy(imu);
+    calibration_destroy(calibration);
+    colormcu_destroy(colormcu);
+    depthmcu_destroy(depthmcu);
+    tickcounter_destroy(tick);
+
+    const uint64_t received = timestamps_usec.size();
+    ASSERT_GT(received, 0u);
+
+    const uint64_t missing = count_missing_samples(timestamps_usec);
+    const double drop_percent = 100.0 * (double)missing / (double)(received + missing);
+
+    const int64_t min_offset_usec = *std::min_element(receipt_offsets_usec.begin(), receipt_offsets_usec.end());
+    std::vector<uint64_t> latencies_usec;
+    latencies_usec.reserve(receipt_offsets_usec.size());
+    uint64_t total_latency_usec = 0;
+    for (int64_t offset : receipt_offsets_usec)
+    {
+        latencies_usec.push_back((uint64_t)(offset - min_offset_usec));
+        total_latency_usec += latencies_usec.back();
+    }
+    std::sort(latencies_usec.begin(), latencies_usec.end());
+    const double average_latency_ms = (double)total_latency_usec / (double)received / 1000;
+    const double p99_latency_ms = (double)latencies_usec[latencies_usec.size() * 99 / 100] / 1000;
+    const double max_latency_ms = (double)latencies_usec.back() / 1000;
+
+    const double samples_per_second = (double)received / seconds;
+    const double consumer_cpu_usec_per_1000 = (double)consumer_cpu_usec * 1000 / (double)received;
+    const double producer_cpu_usec_per_1000 = (double)producer_cpu_usec * 1000 / (double)(received + missing);
+
+    printf("%s batch %u, queue depth %u %s, %u ms stall every %u ms, %u usec jitter\n",
+           as.read_mode == IMU_READ_SAMPLE ? "imu_get_sample" : "imu_get_samples",
+           as.read_mode == IMU_READ_SAMPLE ? 1 : as.batch_size,
+           as.queue_depth,
+           get_policy_name(as.queue_policy),
+           as.stall_ms,
+           as.stall_interval_ms,
+           as.jitter_usec);
+    printf("    %.1f samples/s in %llu reads from %llu USB packets, %llu missing (%.2f%%)\n",
+           samples_per_second,
+           (unsigned long long)reads,
+           (unsigned long long)usb_stats.completed_transfers,
+           (unsigned long long)missing,
+           drop_percent);
+    printf("    latency over the fastest sample %.3f ms average %.3f ms p99 %.3f ms max\n",
+           average_latency_ms,
+           p99_latency_ms,
+           max_latency_ms);
+    printf("    CPU per 1000 samples %.1f usec reading, %.1f usec unpacking\n",
+           consumer_cpu_usec_per_1000,
+           producer_cpu_usec_per_1000);
+
+    if (m_file_handle)
+    {
+        // Write the header when the file is new
+        if (ftell(m_file_handle) == 0)
+        {
+            fprintf(m_file_handle,
+                    "test, read, batch, queue_depth, policy, stall_ms, stall_interval_ms, jitter_usec, samples, "
+                    "samples_per_second, reads, missing, drop_percent, average_latency_ms, p99_latency_ms, "
+                    "max_latency_ms, read_cpu_usec_per_1000, unpack_cpu_usec_per_1000\n");
+        }
+        fprintf(m_file_handle,
+                "%d, %s, %u, %u, %s, %u, %u, %u, %llu, %.1f, %llu, %llu, %.3f, %.3f, %.3f, %.3f, %.1f, %.1f\n",
+                as.test_number,
+                as.read_mode == IMU_READ_SAMPLE ? "sample" : "samples",
+                as.read_mode == IMU_READ_SAMPLE ? 1 : as.batch_size,
+                as.queue_depth,
+                get_policy_name(as.queue_policy),
+                as.stall_ms,
+                as.stall_interval_ms,
+                as.jitter_usec,
+                (unsigned long long)received,
+                samples_per_second,
+                (unsigned long long)reads,
+                (unsigned long long)missing,
+                drop_percent,
+                average_latency_ms,
+                p99_latency_ms,
+                max_latency_ms,
+                consumer_cpu_usec_per_1000,
+                producer_cpu_usec_per_1000);
+    }
+}
+
+// clang-format off
+static struct imu_parameters tests[] = {
+    // Per sample reads against batched reads of the sample ring
+    { 0, IMU_READ_SAMPLE, 1, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0, 0 },
+    { 1, IMU_READ_SAMPLES, 8, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0, 0 },
+    { 2, IMU_READ_SAMPLES, 64, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0, 0 },
+    { 3, IMU_READ_SAMPLE, 1, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0, 500 },
+    { 4, IMU_READ_SAMPLES, 64, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0, 500 },
+    // Consumers that stall for less than the default buffer of 0.5 s, and for longer
+    { 5, IMU_READ_SAMPLE, 1, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 200, 1000, 0 },
+    { 6, IMU_READ_SAMPLES, 64, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 200, 1000, 0 },
+    { 7, IMU_READ_SAMPLE, 1, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 800, 1000, 0 },
+    { 8, IMU_READ_SAMPLES, 64, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 800, 1000, 0 },
+    { 9, IMU_READ_SAMPLES, 64, 0, K4A_QUEUE_POLICY_DROP_NEWEST, 800, 1000, 0 },
+    // A deeper buffer rides out the long stalls
+    { 10, IMU_READ_SAMPLES, 64, 2000, K4A_QUEUE_POLICY_DROP_OLDEST, 800, 1000, 0 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(IMU_TESTS, imu_perf, ValuesIn(tests));
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+        if (strcmp(argument, "--seconds") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_seconds = (int)strtol(argv[i + 1], NULL, 10);
+                printf("g_seconds = %d\n", g_seconds);
+                i++;
+            }
+            else
+            {
+                printf("Error: seconds parameter missing\n");
+                error = true;
+            }
+        }
+
+        if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+            (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (g_seconds <= 0)
+    {
+        printf("Error: seconds must be positive\n");
+        error = true;
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --seconds <count>\n");
+        printf("      How long each test reads samples; default is 5\n");
+
+        return 1; // Indicates an error or warning
+    }
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
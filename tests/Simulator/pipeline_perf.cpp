@@ -0,0 +1,456 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include "simulator.h"
+#include "depthcommands.h"
+
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/capturesync.h>
+#include <k4ainternal/color.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/depth_mcu.h>
+#include <azure_c_shared_utility/threadapi.h>
+#include <azure_c_shared_utility/tickcounter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Measures the capture pipeline end to end without a device. The simulated USB backend and color reader deliver
+// frames at a configurable rate and jitter through the depth MCU and the color reader interface into capture sync,
+// and the test reads the synchronized captures like an application would. Results are printed and appended to
+// pipeline_perf_results.csv.
+//
+// The depth engine is proprietary and needs a GPU, so the raw depth frames are turned into depth and IR images by a
+// stand-in that only allocates and copies them, the way the depth engine output would be.
+
+static int g_capture_count = 150;
+static std::vector<uint8_t> g_raw_depth_frames;
+
+using ::testing::ValuesIn;
+
+struct pipeline_parameters
+{
+    int test_number;
+    k4a_fps_t fps;
+    uint32_t jitter_usec;
+    k4a_queue_policy_t queue_policy;
+    uint32_t pooled_buffers;
+    uint32_t consumer_delay_ms;
+
+    friend std::ostream &operator<<(std::ostream &os, const pipeline_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class pipeline_perf : public ::testing::Test, public ::testing::WithParamInterface<pipeline_parameters>
+{
+public:
+    virtual void SetUp()
+    {
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("pipeline_perf_results.csv", "a")));
+        allocator_initialize();
+    }
+
+    virtual void TearDown()
+    {
+        simulator_set_usb_stream_config(USB_DEVICE_DEPTH_PROCESSOR, NULL);
+        simulator_set_color_stream_config(NULL);
+        (void)allocator_set_pooling(0);
+        allocator_deinitialize();
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    FILE *m_file_handle;
+};
+
+typedef struct _pipeline_context_t
+{
+    capturesync_t sync;
+    k4a_depth_mode_t depth_mode;
+} pipeline_context_t;
+
+static const char *get_policy_name(k4a_queue_policy_t policy)
+{
+    switch (policy)
+    {
+    case K4A_QUEUE_POLICY_DROP_OLDEST:
+        return "drop_oldest";
+    case K4A_QUEUE_POLICY_DROP_NEWEST:
+        return "drop_newest";
+    case K4A_QUEUE_POLICY_BLOCK:
+        return "block";
+    }
+    return "unknown";
+}
+
+static uint64_t get_system_time_nsec()
+{
+    // image_apply_system_timestamp() uses the same monotonic clock
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Stands in for the depth engine: creates the depth and IR images of the mode from the raw frame
+static k4a_image_t create_depth_engine_image(k4a_image_t raw_image, k4a_depth_mode_t depth_mode)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    k4a_image_t image = NULL;
+    if (!k4a_convert_depth_mode_to_width_height(depth_mode, &width, &height) ||
+        K4A_FAILED(image_create(
+            K4A_IMAGE_FORMAT_DEPTH16, (int)width, (int)height, 0, ALLOCATION_SOURCE_DEPTH, &image)))
+    {
+        return NULL;
+    }
+
+    size_t size = std::min(image_get_size(image), image_get_size(raw_image));
+    memcpy(image_get_buffer(image), image_get_buffer(raw_image), size);
+    image_set_device_timestamp_usec(image, image_get_device_timestamp_usec(raw_image));
+    image_set_system_timestamp_nsec(image, image_get_system_timestamp_nsec(raw_image));
+    return image;
+}
+
+static void depth_frame_ready(k4a_result_t result, k4a_image_t image_raw, void *context)
+{
+    pipeline_context_t *pipeline = (pipeline_context_t *)context;
+    k4a_capture_t capture = NULL;
+    k4a_image_t depth = NULL;
+    k4a_image_t ir = NULL;
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = capture_create(&capture);
+    }
+
+    if (K4A_SUCCEEDED(result) && pipeline->depth_mode != K4A_DEPTH_MODE_PASSIVE_IR)
+    {
+        depth = create_depth_engine_image(image_raw, pipeline->depth_mode);
+        result = K4A_RESULT_FROM_BOOL(depth != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        ir = create_depth_engine_image(image_raw, pipeline->depth_mode);
+        result = K4A_RESULT_FROM_BOOL(ir != NULL);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        if (depth)
+        {
+            capture_set_depth_image(capture, depth);
+        }
+        capture_set_ir_image(capture, ir);
+    }
+
+    capturesync_add_capture(pipeline->sync, result, capture, false);
+
+    if (depth)
+    {
+        image_dec_ref(depth);
+    }
+    if (ir)
+    {
+        image_dec_ref(ir);
+    }
+    if (capture)
+    {
+        capture_dec_ref(capture);
+    }
+}
+
+static void color_capture_ready(k4a_result_t result, k4a_capture_t capture, void *context)
+{
+    pipeline_context_t *pipeline = (pipeline_context_t *)context;
+    capturesync_add_capture(pipeline->sync, result, capture, true);
+}
+
+static uint64_t get_total_allocations(const k4a_allocator_stats_t &stats)
+{
+    return stats.depth.total_allocations + stats.color.total_allocations + stats.usb_depth.total_allocations;
+}
+
+static uint64_t get_peak_bytes(const k4a_allocator_stats_t &stats)
+{
+    return stats.depth.peak_bytes + stats.color.peak_bytes + stats.usb_depth.peak_bytes;
+}
+
+TEST_P(pipeline_perf, testTest)
+{
+    auto as = GetParam();
+
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_720P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    config.camera_fps = as.fps;
+    config.synchronized_images_only = true;
+
+    simulator_stream_config_t stream_config = {};
+    stream_config.jitter_usec = as.jitter_usec;
+    stream_config.seed = 1;
+    if (!g_raw_depth_frames.empty())
+    {
+        // The frame size is the size of the sensor mode
+        stream_config.frames = g_raw_depth_frames.data();
+        stream_config.frame_size = SENSOR_MODE_LONG_THROW_NATIVE_SIZE;
+        stream_config.frame_count = g_raw_depth_frames.size() / stream_config.frame_size;
+    }
+    simulator_set_usb_stream_config(USB_DEVICE_DEPTH_PROCESSOR, &stream_config);
+
+    stream_config = {};
+    stream_config.jitter_usec = as.jitter_usec;
+    stream_config.seed = 2;
+    simulator_set_color_stream_config(&stream_config);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(as.pooled_buffers));
+
+    pipeline_context_t pipeline = {};
+    pipeline.depth_mode = config.depth_mode;
+    TICK_COUNTER_HANDLE tick = tickcounter_create();
+    ASSERT_NE((TICK_COUNTER_HANDLE)NULL, tick);
+
+    depthmcu_t depthmcu = NULL;
+    color_t color = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capturesync_create(&pipeline.sync));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capturesync_set_queue_policy(pipeline.sync, 0, as.queue_policy));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_create(0, &depthmcu));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, color_create(tick, NULL, NULL, color_capture_ready, &pipeline, &color));
+
+    k4a_allocator_stats_t allocator_start = {};
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_get_stats(&allocator_start));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capturesync_start(pipeline.sync, &config));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_depth_set_capture_mode(depthmcu, config.depth_mode));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_depth_set_fps(depthmcu, config.camera_fps));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, color_start(color, &config));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_depth_start_streaming(depthmcu, depth_frame_ready, &pipeline));
+
+    const int32_t timeout_ms = 5 * 1000 / (int32_t)k4a_convert_fps_to_uint(config.camera_fps) + 1000;
+    int captures = 0;
+    uint64_t total_latency_nsec = 0;
+    uint64_t max_latency_nsec = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (captures < g_capture_count)
+    {
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, capturesync_get_capture(pipeline.sync, &capture, timeout_ms));
+        uint64_t now_nsec = get_system_time_nsec();
+
+        // A capture can't be published before its last image arrived
+        uint64_t arrival_nsec = 0;
+        k4a_image_t images[] = { capture_get_color_image(capture), capture_get_ir_image(capture) };
+        for (k4a_image_t image : images)
+        {
+            if (image)
+            {
+                arrival_nsec = std::max(arrival_nsec, image_get_system_timestamp_nsec(image));
+                image_dec_ref(image);
+            }
+        }
+        capture_dec_ref(capture);
+
+        uint64_t latency_nsec = now_nsec > arrival_nsec ? now_nsec - arrival_nsec : 0;
+        total_latency_nsec += latency_nsec;
+        max_latency_nsec = std::max(max_latency_nsec, latency_nsec);
+        captures++;
+
+        if (as.consumer_delay_ms)
+        {
+            // An application that falls behind, so the queue policy decides what is dropped
+            ThreadAPI_Sleep(as.consumer_delay_ms);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    k4a_capture_stats_t sync_stats = {};
+    k4a_usb_stream_stats_t usb_stats = {};
+    k4a_allocator_stats_t allocator_end = {};
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capturesync_get_stats(pipeline.sync, &sync_stats));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, depthmcu_depth_get_usb_stream_stats(depthmcu, &usb_stats));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_get_stats(&allocator_end));
+
+    depthmcu_depth_stop_streaming(depthmcu, false);
+    color_stop(color);
+    capturesync_stop(pipeline.sync);
+
+    color_destroy(color);
+    depthmcu_destroy(depthmcu);
+    capturesync_destroy(pipeline.sync);
+    tickcounter_destroy(tick);
+
+    double captures_per_second = captures / seconds;
+    double average_latency_ms = (double)total_latency_nsec / captures / 1000000;
+    double max_latency_ms = (double)max_latency_nsec / 1000000;
+    uint64_t allocations = get_total_allocations(allocator_end) - get_total_allocations(allocator_start);
+    uint64_t dropped = sync_stats.depth_unmatched + sync_stats.color_unmatched + sync_stats.depth_queue_overflow +
+                       sync_stats.color_queue_overflow + sync_stats.output_queue_overflow;
+
+    printf("%d fps, %u usec jitter, %s policy, %u pooled buffers, %u ms consumer delay\n",
+           k4a_convert_fps_to_uint(as.fps),
+           as.jitter_usec,
+           get_policy_name(as.queue_policy),
+           as.pooled_buffers,
+           as.consumer_delay_ms);
+    printf("    %.1f captures/s, latency %.3f ms average %.3f ms max\n",
+           captures_per_second,
+           average_latency_ms,
+           max_latency_ms);
+    printf("    %llu raw depth frames, %llu captures dropped, %llu output queue overflows, %lld usec average skew\n",
+           (unsigned long long)usb_stats.completed_transfers,
+           (unsigned long long)dropped,
+           (unsigned long long)sync_stats.output_queue_overflow,
+           (long long)sync_stats.average_skew_usec);
+    printf("    %llu allocations, %llu peak bytes\n",
+           (unsigned long long)allocations,
+           (unsigned long long)get_peak_bytes(allocator_end));
+
+    if (m_file_handle)
+    {
+        fprintf(m_file_handle,
+                "%d, %d, %u, %s, %u, %u, %d, %.1f, %.3f, %.3f, %llu, %llu, %llu, %llu, %llu\n",
+                as.test_number,
+                k4a_convert_fps_to_uint(as.fps),
+                as.jitter_usec,
+                get_policy_name(as.queue_policy),
+                as.pooled_buffers,
+                as.consumer_delay_ms,
+                captures,
+                captures_per_second,
+                average_latency_ms,
+                max_latency_ms,
+                (unsigned long long)usb_stats.completed_transfers,
+                (unsigned long long)dropped,
+                (unsigned long long)sync_stats.output_queue_overflow,
+                (unsigned long long)allocations,
+                (unsigned long long)get_peak_bytes(allocator_end));
+    }
+}
+
+// clang-format off
+static struct pipeline_parameters tests[] = {
+    { 0, K4A_FRAMES_PER_SECOND_30, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 0, 0 },
+    { 1, K4A_FRAMES_PER_SECOND_30, 0, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 0 },
+    { 2, K4A_FRAMES_PER_SECOND_30, 2000, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 0 },
+    { 3, K4A_FRAMES_PER_SECOND_30, 8000, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 0 },
+    { 4, K4A_FRAMES_PER_SECOND_30, 2000, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 50 },
+    { 5, K4A_FRAMES_PER_SECOND_30, 2000, K4A_QUEUE_POLICY_DROP_NEWEST, 8, 50 },
+    { 6, K4A_FRAMES_PER_SECOND_30, 2000, K4A_QUEUE_POLICY_BLOCK, 8, 50 },
+    { 7, K4A_FRAMES_PER_SECOND_15, 2000, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 0 },
+    { 8, K4A_FRAMES_PER_SECOND_5, 2000, K4A_QUEUE_POLICY_DROP_OLDEST, 8, 0 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(PIPELINE_TESTS, pipeline_perf, ValuesIn(tests));
+
+static bool load_raw_depth_frames(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Error: failed to open %s\n", path);
+        return false;
+    }
+
+    uint8_t buffer[64 * 1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        g_raw_depth_frames.insert(g_raw_depth_frames.end(), buffer, buffer + read);
+    }
+    fclose(file);
+
+    if (g_raw_depth_frames.empty() || g_raw_depth_frames.size() % SENSOR_MODE_LONG_THROW_NATIVE_SIZE != 0)
+    {
+        printf("Error: %s does not hold whole raw NFOV frames of %d bytes\n", path, SENSOR_MODE_LONG_THROW_NATIVE_SIZE);
+        g_raw_depth_frames.clear();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+        if (strcmp(argument, "--capture_count") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_capture_count = (int)strtol(argv[i + 1], NULL, 10);
+                printf("g_capture_count = %d\n", g_capture_count);
+                i++;
+            }
+            else
+            {
+                printf("Error: capture_count parameter missing\n");
+                error = true;
+            }
+        }
+        else if (strcmp(argument, "--raw_depth") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                printf("raw depth frames = %s\n", argv[i + 1]);
+                error = error || !load_raw_depth_frames(argv[i + 1]);
+                i++;
+            }
+            else
+            {
+                printf("Error: raw_depth parameter missing\n");
+                error = true;
+            }
+        }
+
+        if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+            (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (g_capture_count <= 0)
+    {
+        printf("Error: capture_count must be positive\n");
+        error = true;
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --capture_count <count>\n");
+        printf("      The number of synchronized captures each test reads; default is 150\n");
+        printf("  --raw_depth <path>\n");
+        printf("      Replay the raw NFOV depth frames stored back to back in a file instead of zero filled frames.\n");
+
+        return 1; // Indicates an error or warning
+    }
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
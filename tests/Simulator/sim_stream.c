@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L /* for clock_gettime() */
+#endif
+
+// This library
+#include "sim_stream.h"
+
+// Dependent libraries
+#include <k4ainternal/logging.h>
+
+// System dependencies
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static uint64_t sim_stream_get_time_usec(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER qpc = { 0 }, freq = { 0 };
+    if (!QueryPerformanceCounter(&qpc) || !QueryPerformanceFrequency(&freq))
+    {
+        return 0;
+    }
+    return (uint64_t)(qpc.QuadPart / freq.QuadPart * 1000000 + qpc.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+#else
+    struct timespec ts_time;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts_time) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)ts_time.tv_sec * 1000000 + (uint64_t)ts_time.tv_nsec / 1000;
+#endif
+}
+
+// xorshift32, so the jitter sequence only depends on the seed and not on the C runtime
+static uint32_t sim_stream_next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool sim_stream_is_running(sim_stream_t *stream)
+{
+    Lock(stream->lock);
+    bool running = stream->running;
+    Unlock(stream->lock);
+    return running;
+}
+
+static int sim_stream_thread(void *param)
+{
+    sim_stream_t *stream = (sim_stream_t *)param;
+    const uint64_t period_usec = 1000000 / stream->config.fps;
+    const uint32_t jitter_usec = stream->config.jitter_usec;
+
+    // xorshift never leaves a state of 0
+    uint32_t random_state = stream->config.seed != 0 ? stream->config.seed : 0x9E3779B9;
+
+    const uint64_t start_usec = sim_stream_get_time_usec();
+
+    for (uint64_t frame_index = 0; sim_stream_is_running(stream); frame_index++)
+    {
+        int64_t offset_usec = 0;
+        if (jitter_usec != 0)
+        {
+            offset_usec = (int64_t)(sim_stream_next_random(&random_state) % (2 * (uint64_t)jitter_usec + 1)) -
+                          jitter_usec;
+        }
+
+        // A frame captured late by the sensor is delivered late too, so the device timestamp carries the jitter. The
+        // device clock starts one jitter in so the first frame can be early.
+        const uint64_t device_timestamp_usec = (uint64_t)((int64_t)(jitter_usec + frame_index * period_usec) +
+                                                          offset_usec);
+        const uint64_t due_usec = start_usec + device_timestamp_usec;
+
+        // Sleep for whole milliseconds and spin for the rest, the OS sleep granularity would otherwise be the jitter
+        uint64_t now_usec = sim_stream_get_time_usec();
+        while (now_usec < due_usec)
+        {
+            uint64_t remaining_usec = due_usec - now_usec;
+            ThreadAPI_Sleep(remaining_usec > 2000 ? (unsigned int)(remaining_usec / 1000 - 1) : 0);
+            now_usec = sim_stream_get_time_usec();
+        }
+
+        if (!sim_stream_is_running(stream))
+        {
+            break;
+        }
+
+        stream->callback(frame_index, device_timestamp_usec, stream->callback_context);
+    }
+
+    return 0;
+}
+
+k4a_result_t sim_stream_start(sim_stream_t *stream,
+                              const simulator_stream_config_t *config,
+                              sim_stream_frame_cb_t *callback,
+                              void *callback_context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stream == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config->fps == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, callback == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config->frames != NULL && config->frame_count == 0);
+
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stream->lock != NULL);
+
+    stream->lock = Lock_Init();
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(stream->lock != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        stream->config = *config;
+        stream->callback = callback;
+        stream->callback_context = callback_context;
+        stream->running = true;
+
+        result = K4A_RESULT_FROM_BOOL(ThreadAPI_Create(&stream->thread, sim_stream_thread, stream) == THREADAPI_OK);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        stream->thread = NULL;
+        if (stream->lock)
+        {
+            Lock_Deinit(stream->lock);
+            stream->lock = NULL;
+        }
+    }
+
+    return result;
+}
+
+void sim_stream_stop(sim_stream_t *stream)
+{
+    if (stream == NULL || stream->lock == NULL)
+    {
+        return;
+    }
+
+    Lock(stream->lock);
+    stream->running = false;
+    Unlock(stream->lock);
+
+    if (stream->thread)
+    {
+        int thread_result;
+        (void)ThreadAPI_Join(stream->thread, &thread_result);
+        stream->thread = NULL;
+    }
+
+    Lock_Deinit(stream->lock);
+    stream->lock = NULL;
+}
+
+const uint8_t *sim_stream_get_frame(const simulator_stream_config_t *config, uint64_t frame_index)
+{
+    if (config->frames == NULL)
+    {
+        return NULL;
+    }
+    return config->frames + (size_t)(frame_index % config->frame_count) * config->frame_size;
+}
@@ -0,0 +1,60 @@
+/** \file sim_stream.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Paces the frames of a simulated stream on a thread of its own.
+ */
+
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include "simulator.h"
+#include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/threadapi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Called on the stream thread when a frame is due
+ *
+ * \param frame_index
+ * Index of the frame since the stream started
+ *
+ * \param device_timestamp_usec
+ * When the simulated sensor captured the frame, the jitter included
+ *
+ * \param context
+ * Context passed to sim_stream_start()
+ */
+typedef void(sim_stream_frame_cb_t)(uint64_t frame_index, uint64_t device_timestamp_usec, void *context);
+
+typedef struct _sim_stream_t
+{
+    simulator_stream_config_t config;
+    sim_stream_frame_cb_t *callback;
+    void *callback_context;
+
+    THREAD_HANDLE thread;
+    LOCK_HANDLE lock;
+    bool running;
+} sim_stream_t;
+
+/** Starts delivering frames at config->fps, which must not be 0. stream must be zero initialized or stopped. */
+k4a_result_t sim_stream_start(sim_stream_t *stream,
+                              const simulator_stream_config_t *config,
+                              sim_stream_frame_cb_t *callback,
+                              void *callback_context);
+
+/** Stops the stream and waits for the callback in progress to return. Does nothing if the stream isn't running. */
+void sim_stream_stop(sim_stream_t *stream);
+
+/** Returns the frame at frame_index of a replayed stream, or NULL when the stream delivers zero filled frames */
+const uint8_t *sim_stream_get_frame(const simulator_stream_config_t *config, uint64_t frame_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_STREAM_H */
@@ -0,0 +1,93 @@
+/** \file simulator.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Configuration of the simulated device. The simulator replaces the USB command module (usbcommand.h) and the color
+ * reader (color.h) at link time, so the depth MCU, allocator, capture sync and queue modules run unmodified without
+ * hardware.
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <k4ainternal/usbcommand.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** How a simulated stream delivers its frames */
+typedef struct _simulator_stream_config_t
+{
+    /** Frames per second, 0 for the rate the SDK configured */
+    uint32_t fps;
+
+    /** Each frame is captured and delivered up to this many microseconds early or late, 0 for a steady rate */
+    uint32_t jitter_usec;
+
+    /** Seed of the jitter, runs with the same seed deliver frames with the same offsets */
+    uint32_t seed;
+
+    /** frame_count raw frames of frame_size bytes replayed in a loop, NULL to deliver zero filled frames */
+    const uint8_t *frames;
+
+    /** Size of each frame, 0 for the size the SDK expects for the configured mode */
+    size_t frame_size;
+
+    /** Number of frames in frames */
+    size_t frame_count;
+} simulator_stream_config_t;
+
+/** Sets how a simulated USB streaming endpoint delivers frames
+ *
+ * \param device_type
+ * The USB device the configuration applies to
+ *
+ * \param config
+ * The configuration, copied. NULL restores the default steady stream of zero filled frames. frames must remain valid
+ * until the stream stops.
+ *
+ * \remarks
+ * The configuration applies the next time the stream is started with usb_cmd_stream_start()
+ */
+void simulator_set_usb_stream_config(usb_command_device_type_t device_type, const simulator_stream_config_t *config);
+
+/** Sets the calibration the simulated depth MCU returns
+ *
+ * \param json
+ * The raw calibration JSON, not copied. NULL restores the default of a zero filled calibration, which fails to parse.
+ * json must remain valid until the calibration is read.
+ *
+ * \param json_size
+ * Size of json, including the null terminator
+ */
+void simulator_set_calibration(const char *json, size_t json_size);
+
+/** Returns the thread CPU time spent in the SDK callback of a simulated USB streaming endpoint
+ *
+ * \param device_type
+ * The USB device the time applies to
+ *
+ * \remarks
+ * The time is reset when the stream starts, and should be read once it is stopped. For the IMU this is the time the
+ * SDK spends unpacking the packets into its sample buffer.
+ */
+uint64_t simulator_get_callback_cpu_usec(usb_command_device_type_t device_type);
+
+/** Sets how the simulated color camera delivers frames
+ *
+ * \param config
+ * The configuration, copied. NULL restores the default steady stream of zero filled frames. frames must remain valid
+ * until the stream stops.
+ *
+ * \remarks
+ * The configuration applies the next time the camera is started with color_start()
+ */
+void simulator_set_color_stream_config(const simulator_stream_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMULATOR_H */
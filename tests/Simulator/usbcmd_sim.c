@@ -0,0 +1,478 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Simulated implementation of usbcommand.h. Commands succeed without doing anything, except for the depth mode and
+// frame rate commands that the streaming endpoint follows. Streaming delivers frames from the allocator, the way
+// the USB reader did before zero copy transfers, paced by sim_stream. The IMU endpoint delivers packets of samples
+// timestamped from the simulated device clock.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L /* for clock_gettime() */
+#endif
+
+// This library
+#include <k4ainternal/usbcommand.h>
+#include "simulator.h"
+#include "sim_stream.h"
+
+// Dependent libraries
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/color_mcu.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+
+// System dependencies
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Private headers
+#include "depthcommands.h"
+
+#define SIM_SERIAL_NUMBER "000000000000"
+
+// Rate of the streams the SDK doesn't set a rate for
+#define SIM_DEFAULT_FPS (30)
+
+// The IMU sends packets of samples at the sample rate of the device
+#define SIM_IMU_SAMPLES_PER_PACKET (IMU_MAX_ACC_COUNT_IN_PAYLOAD)
+#define SIM_IMU_PACKETS_PER_SECOND (K4A_IMU_SAMPLE_RATE / SIM_IMU_SAMPLES_PER_PACKET)
+#define SIM_IMU_PACKET_SIZE                                                                                            \
+    (sizeof(imu_payload_metadata_t) + 2 * SIM_IMU_SAMPLES_PER_PACKET * sizeof(xyz_vector_t))
+
+// Raw IMU readings, about 1 g down on the accelerometer and slow rotation on the gyroscope
+#define SIM_IMU_GYRO_SENSITIVITY (4000)
+#define SIM_IMU_ACCEL_SENSITIVITY (2000)
+#define SIM_IMU_ACCEL_Z (-490)
+#define SIM_IMU_GYRO_X (25)
+
+typedef struct _usbcmd_context_t
+{
+    usb_command_device_type_t device_type;
+    guid_t container_id;
+
+    usb_cmd_stream_cb_t *callback;
+    void *callback_context;
+
+    uint32_t fps;     // Set with DEV_CMD_DEPTH_FPS_SET
+    size_t mode_size; // Set with DEV_CMD_DEPTH_MODE_SET
+    size_t frame_size;
+    uint64_t imu_sample_period_usec;
+    sim_stream_t stream;
+
+    LOCK_HANDLE stats_lock;
+    k4a_usb_stream_stats_t stats;
+} usbcmd_context_t;
+
+K4A_DECLARE_CONTEXT(usbcmd_t, usbcmd_context_t);
+
+static simulator_stream_config_t g_stream_config[USB_DEVICE_TYPE_COUNT];
+static const char *g_calibration_json;
+static size_t g_calibration_json_size;
+
+// Only written by the stream thread of each device type
+static volatile uint64_t g_callback_cpu_usec[USB_DEVICE_TYPE_COUNT];
+
+void simulator_set_calibration(const char *json, size_t json_size)
+{
+    g_calibration_json = json;
+    g_calibration_json_size = json != NULL ? json_size : 0;
+}
+
+uint64_t simulator_get_callback_cpu_usec(usb_command_device_type_t device_type)
+{
+    return device_type < USB_DEVICE_TYPE_COUNT ? g_callback_cpu_usec[device_type] : 0;
+}
+
+static uint64_t usb_cmd_sim_get_thread_cpu_usec(void)
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        return 0;
+    }
+    ULARGE_INTEGER kernel = { { kernel_time.dwLowDateTime, kernel_time.dwHighDateTime } };
+    ULARGE_INTEGER user = { { user_time.dwLowDateTime, user_time.dwHighDateTime } };
+    return (kernel.QuadPart + user.QuadPart) / 10;
+#else
+    struct timespec ts_time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_time) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)ts_time.tv_sec * 1000000 + (uint64_t)ts_time.tv_nsec / 1000;
+#endif
+}
+
+void simulator_set_usb_stream_config(usb_command_device_type_t device_type, const simulator_stream_config_t *config)
+{
+    if (device_type >= USB_DEVICE_TYPE_COUNT)
+    {
+        return;
+    }
+
+    if (config)
+    {
+        g_stream_config[device_type] = *config;
+    }
+    else
+    {
+        memset(&g_stream_config[device_type], 0, sizeof(g_stream_config[device_type]));
+    }
+}
+
+k4a_result_t usb_cmd_create(usb_command_device_type_t device_type,
+                            uint32_t device_index,
+                            const guid_t *container_id,
+                            usbcmd_t *usb_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_type >= USB_DEVICE_TYPE_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_index != 0 && container_id == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, usb_handle == NULL);
+
+    usbcmd_context_t *usbcmd = usbcmd_t_create(usb_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(usbcmd != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        usbcmd->device_type = device_type;
+        if (container_id)
+        {
+            usbcmd->container_id = *container_id;
+        }
+        usbcmd->stats_lock = Lock_Init();
+        result = K4A_RESULT_FROM_BOOL(usbcmd->stats_lock != NULL);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        usb_cmd_destroy(*usb_handle);
+        *usb_handle = NULL;
+    }
+
+    return result;
+}
+
+void usb_cmd_destroy(usbcmd_t usb_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, usbcmd_t, usb_handle);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usb_handle);
+
+    sim_stream_stop(&usbcmd->stream);
+
+    if (usbcmd->stats_lock)
+    {
+        Lock_Deinit(usbcmd->stats_lock);
+    }
+
+    usbcmd_t_destroy(usb_handle);
+}
+
+k4a_buffer_result_t usb_cmd_get_serial_number(usbcmd_t usb_handle, char *serial_number, size_t *serial_number_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, usbcmd_t, usb_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, serial_number_size == NULL);
+
+    size_t caller_size = *serial_number_size;
+    *serial_number_size = sizeof(SIM_SERIAL_NUMBER);
+    if (serial_number == NULL || caller_size < sizeof(SIM_SERIAL_NUMBER))
+    {
+        return K4A_BUFFER_RESULT_TOO_SMALL;
+    }
+
+    memcpy(serial_number, SIM_SERIAL_NUMBER, sizeof(SIM_SERIAL_NUMBER));
+    return K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
+k4a_result_t usb_cmd_read(usbcmd_t usb_handle,
+                          uint32_t cmd,
+                          uint8_t *p_cmd_data,
+                          size_t cmd_data_size,
+                          uint8_t *p_data,
+                          size_t data_size,
+                          size_t *bytes_read)
+{
+    uint32_t cmd_status;
+    return usb_cmd_read_with_status(
+        usb_handle, cmd, p_cmd_data, cmd_data_size, p_data, data_size, bytes_read, &cmd_status);
+}
+
+k4a_result_t usb_cmd_read_with_status(usbcmd_t usbcmd_handle,
+                                      uint32_t cmd,
+                                      uint8_t *p_cmd_data,
+                                      size_t cmd_data_size,
+                                      uint8_t *p_data,
+                                      size_t data_size,
+                                      size_t *bytes_read,
+                                      uint32_t *cmd_status)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usbcmd_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, p_data == NULL && data_size != 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cmd_status == NULL);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+    (void)p_cmd_data;
+    (void)cmd_data_size;
+
+    if (usbcmd->device_type == USB_DEVICE_DEPTH_PROCESSOR && cmd == DEV_CMD_DEPTH_READ_CALIBRATION_DATA &&
+        g_calibration_json != NULL)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_size < g_calibration_json_size);
+        memcpy(p_data, g_calibration_json, g_calibration_json_size);
+        if (bytes_read)
+        {
+            *bytes_read = g_calibration_json_size;
+        }
+        *cmd_status = CMD_STATUS_PASS;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    // The simulated device has no versions or serial number to report
+    if (p_data)
+    {
+        memset(p_data, 0, data_size);
+    }
+    if (bytes_read)
+    {
+        *bytes_read = data_size;
+    }
+    *cmd_status = CMD_STATUS_PASS;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t usb_cmd_write(usbcmd_t usb_handle,
+                           uint32_t cmd,
+                           uint8_t *p_cmd_data,
+                           size_t cmd_data_size,
+                           uint8_t *p_data,
+                           size_t data_size)
+{
+    uint32_t cmd_status;
+    return usb_cmd_write_with_status(usb_handle, cmd, p_cmd_data, cmd_data_size, p_data, data_size, &cmd_status);
+}
+
+k4a_result_t usb_cmd_write_with_status(usbcmd_t usb_handle,
+                                       uint32_t cmd,
+                                       uint8_t *p_cmd_data,
+                                       size_t cmd_data_size,
+                                       uint8_t *p_data,
+                                       size_t data_size,
+                                       uint32_t *cmd_status)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usb_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cmd_status == NULL);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usb_handle);
+    (void)p_data;
+    (void)data_size;
+
+    uint32_t value = 0;
+    if (p_cmd_data != NULL && cmd_data_size == sizeof(value))
+    {
+        memcpy(&value, p_cmd_data, sizeof(value));
+    }
+
+    if (cmd == DEV_CMD_DEPTH_MODE_SET)
+    {
+        switch (value)
+        {
+        case SENSOR_MODE_LONG_THROW_NATIVE:
+            usbcmd->mode_size = SENSOR_MODE_LONG_THROW_NATIVE_SIZE;
+            break;
+        case SENSOR_MODE_QUARTER_MEGA_PIXEL:
+            usbcmd->mode_size = SENSOR_MODE_QUARTER_MEGA_PIXEL_SIZE;
+            break;
+        case SENSOR_MODE_MEGA_PIXEL:
+            usbcmd->mode_size = SENSOR_MODE_MEGA_PIXEL_SIZE;
+            break;
+        case SENSOR_MODE_PSEUDO_COMMON:
+            usbcmd->mode_size = SENSOR_MODE_PSEUDO_COMMON_SIZE;
+            break;
+        default:
+            LOG_ERROR("Simulated device doesn't support sensor mode %u", value);
+            return K4A_RESULT_FAILED;
+        }
+    }
+    else if (cmd == DEV_CMD_DEPTH_FPS_SET)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, value == 0);
+        usbcmd->fps = value;
+    }
+
+    *cmd_status = CMD_STATUS_PASS;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t usb_cmd_stream_register_cb(usbcmd_t usbcmd_handle, usb_cmd_stream_cb_t *frame_ready_cb, void *context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usbcmd_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, frame_ready_cb == NULL);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+
+    usbcmd->callback = frame_ready_cb;
+    usbcmd->callback_context = context;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Writes a packet of IMU samples, the last one captured at device_timestamp_usec and the others one sample period apart
+static void usb_cmd_sim_write_imu_packet(usbcmd_context_t *usbcmd, uint8_t *packet, uint64_t device_timestamp_usec)
+{
+    imu_payload_metadata_t *metadata = (imu_payload_metadata_t *)packet;
+    xyz_vector_t *gyro = (xyz_vector_t *)(packet + sizeof(imu_payload_metadata_t));
+    xyz_vector_t *accel = gyro + SIM_IMU_SAMPLES_PER_PACKET;
+
+    memset(packet, 0, SIM_IMU_PACKET_SIZE);
+    metadata->gyro.sensitivity = SIM_IMU_GYRO_SENSITIVITY;
+    metadata->gyro.sample_rate_in_us = (uint32_t)usbcmd->imu_sample_period_usec;
+    metadata->gyro.sample_count = SIM_IMU_SAMPLES_PER_PACKET;
+    metadata->accel.sensitivity = SIM_IMU_ACCEL_SENSITIVITY;
+    metadata->accel.sample_rate_in_us = (uint32_t)usbcmd->imu_sample_period_usec;
+    metadata->accel.sample_count = SIM_IMU_SAMPLES_PER_PACKET;
+
+    for (uint32_t i = 0; i < SIM_IMU_SAMPLES_PER_PACKET; i++)
+    {
+        uint64_t age_usec = (SIM_IMU_SAMPLES_PER_PACKET - 1 - i) * usbcmd->imu_sample_period_usec;
+        uint64_t timestamp_usec = device_timestamp_usec > age_usec ? device_timestamp_usec - age_usec : 0;
+        uint64_t pts = timestamp_usec * 9 / 100; // 90 kHz ticks, see K4A_90K_HZ_TICK_TO_USEC()
+
+        gyro[i].pts = pts;
+        gyro[i].rx = SIM_IMU_GYRO_X;
+        accel[i].pts = pts;
+        accel[i].rz = SIM_IMU_ACCEL_Z;
+    }
+}
+
+static void usb_cmd_sim_frame_ready(uint64_t frame_index, uint64_t device_timestamp_usec, void *context)
+{
+    usbcmd_context_t *usbcmd = (usbcmd_context_t *)context;
+    const allocation_source_t source = usbcmd->device_type == USB_DEVICE_DEPTH_PROCESSOR ?
+                                           ALLOCATION_SOURCE_USB_DEPTH :
+                                           ALLOCATION_SOURCE_USB_IMU;
+    k4a_image_t image = NULL;
+
+    k4a_result_t result = TRACE_CALL(image_create_empty_internal(source, usbcmd->frame_size, &image));
+
+    if (K4A_SUCCEEDED(result))
+    {
+        const uint8_t *frame = sim_stream_get_frame(&usbcmd->stream.config, frame_index);
+        if (frame)
+        {
+            memcpy(image_get_buffer(image), frame, usbcmd->frame_size);
+        }
+        else if (usbcmd->device_type == USB_DEVICE_COLOR_IMU_PROCESSOR)
+        {
+            usb_cmd_sim_write_imu_packet(usbcmd, image_get_buffer(image), device_timestamp_usec);
+        }
+        else
+        {
+            memset(image_get_buffer(image), 0, usbcmd->frame_size);
+        }
+
+        image_set_device_timestamp_usec(image, device_timestamp_usec);
+        result = image_apply_system_timestamp(image);
+    }
+
+    Lock(usbcmd->stats_lock);
+    if (K4A_SUCCEEDED(result))
+    {
+        usbcmd->stats.completed_transfers++;
+        usbcmd->stats.bytes_transferred += usbcmd->frame_size;
+    }
+    else
+    {
+        usbcmd->stats.failed_transfers++;
+    }
+    Unlock(usbcmd->stats_lock);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        uint64_t start_cpu_usec = usb_cmd_sim_get_thread_cpu_usec();
+        usbcmd->callback(K4A_RESULT_SUCCEEDED, image, usbcmd->callback_context);
+        g_callback_cpu_usec[usbcmd->device_type] += usb_cmd_sim_get_thread_cpu_usec() - start_cpu_usec;
+    }
+
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+}
+
+k4a_result_t usb_cmd_stream_start(usbcmd_t usb_handle, size_t payload_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usb_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, payload_size == 0);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usb_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, usbcmd->callback == NULL);
+
+    simulator_stream_config_t config = g_stream_config[usbcmd->device_type];
+    const bool imu = usbcmd->device_type == USB_DEVICE_COLOR_IMU_PROCESSOR;
+    if (config.fps == 0)
+    {
+        config.fps = usbcmd->fps != 0 ? usbcmd->fps : (imu ? SIM_IMU_PACKETS_PER_SECOND : SIM_DEFAULT_FPS);
+    }
+    usbcmd->imu_sample_period_usec = 1000000 / config.fps / SIM_IMU_SAMPLES_PER_PACKET;
+
+    // The depth MCU drops frames that aren't the size of the sensor mode, so that is the size sent by default
+    usbcmd->frame_size = config.frame_size != 0 ? config.frame_size :
+                                                  (usbcmd->mode_size != 0 ? usbcmd->mode_size : payload_size);
+    if (imu && config.frames == NULL && config.frame_size == 0)
+    {
+        usbcmd->frame_size = SIM_IMU_PACKET_SIZE;
+    }
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, usbcmd->frame_size > payload_size);
+    if (config.frames != NULL && config.frame_size == 0)
+    {
+        config.frame_size = usbcmd->frame_size;
+    }
+
+    Lock(usbcmd->stats_lock);
+    memset(&usbcmd->stats, 0, sizeof(usbcmd->stats));
+    usbcmd->stats.transfer_size = (uint32_t)payload_size;
+    Unlock(usbcmd->stats_lock);
+    g_callback_cpu_usec[usbcmd->device_type] = 0;
+
+    return TRACE_CALL(sim_stream_start(&usbcmd->stream, &config, usb_cmd_sim_frame_ready, usbcmd));
+}
+
+k4a_result_t usb_cmd_stream_stop(usbcmd_t usb_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usb_handle);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usb_handle);
+
+    sim_stream_stop(&usbcmd->stream);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t usb_cmd_get_stream_stats(usbcmd_t usb_handle, k4a_usb_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, usbcmd_t, usb_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usb_handle);
+
+    Lock(usbcmd->stats_lock);
+    *stats = usbcmd->stats;
+    Unlock(usbcmd->stats_lock);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+int usb_cmd_get_numa_node(usbcmd_t usb_handle)
+{
+    (void)usb_handle;
+    return -1;
+}
+
+k4a_result_t usb_cmd_get_device_count(uint32_t *p_device_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, p_device_count == NULL);
+    *p_device_count = 1;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+const guid_t *usb_cmd_get_container_id(usbcmd_t usbcmd_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(NULL, usbcmd_t, usbcmd_handle);
+    usbcmd_context_t *usbcmd = usbcmd_t_get_context(usbcmd_handle);
+    return &usbcmd->container_id;
+}
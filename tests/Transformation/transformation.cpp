@@ -4,11 +4,29 @@
 #include <utcommon.h>
 #include <ut_calibration_data.h>
 
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+#define MKDIR(path) "if not exist " + path + " mkdir " + path
+#define RMDIR(path) "rmdir /S /Q " + path
+#define SETENV(env, value) _putenv_s(env, value)
+#else
+#define MKDIR(path) "mkdir -p " + path
+#define RMDIR(path) "rm -rf " + path
+#define SETENV(env, value) setenv(env, value, 1)
+#endif
+
 // Module being tested
 #include <k4a/k4a.h>
 #include <k4ainternal/transformation.h>
 #include <k4ainternal/common.h>
 #include <k4ainternal/image.h>
+#include <k4ainternal/simd.h>
 
 using namespace testing;
 
@@ -84,8 +102,8 @@ protected:
         ASSERT_EQ_FLT(A[2], B[2])                                                                                      \
     }
 
-// Export function from transformation.c to snoop on the compiler setting used.
-extern "C" char *transformation_get_instruction_type();
+// Export function from transformation.c to snoop on the instruction set of the kernels.
+extern "C" const char *transformation_get_instruction_type();
 
 static k4a_transformation_image_descriptor_t image_get_descriptor(const k4a_image_t image)
 {
@@ -349,6 +367,133 @@ TEST_F(transformation_ut, transformation_color_2d_to_depth_2d)
     ASSERT_LT(fabs(point2d[1] - m_depth_point2d_reference[1]), 1);
 }
 
+TEST_F(transformation_ut, transformation_color_2d_to_depth_2d_batch)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_image_t depth_image = NULL;
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                           width,
+                           height,
+                           width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &depth_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_NE(depth_image, (k4a_image_t)NULL);
+
+    uint16_t *depth_image_buffer = (uint16_t *)(void *)image_get_buffer(depth_image);
+    for (int i = 0; i < width * height; i++)
+    {
+        depth_image_buffer[i] = (uint16_t)1000;
+    }
+    const uint8_t *depth_image_data = image_get_buffer(depth_image);
+
+    // Color pixels of depth pixels at 1000mm, the reference point and a color pixel outside of the color image. The
+    // valid flag of transformation_2d_to_2d() doesn't check the bounds of the color image, so the projections that
+    // fall outside of it are skipped.
+    float color_width = (float)m_calibration.color_camera_calibration.resolution_width;
+    float color_height = (float)m_calibration.color_camera_calibration.resolution_height;
+    std::vector<float> depth_points2d;
+    std::vector<float> color_points2d;
+    for (int y = 16; y < height - 16; y += 37)
+    {
+        for (int x = 16; x < width - 16; x += 41)
+        {
+            float depth_point2d[2] = { (float)x + 0.25f, (float)y - 0.25f };
+            float color_point2d[2];
+            int valid = 0;
+            ASSERT_EQ(transformation_2d_to_2d(&m_calibration,
+                                              depth_point2d,
+                                              1000.f,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              K4A_CALIBRATION_TYPE_COLOR,
+                                              color_point2d,
+                                              &valid),
+                      K4A_RESULT_SUCCEEDED);
+            if (valid && color_point2d[0] >= 0.f && color_point2d[0] < color_width && color_point2d[1] >= 0.f &&
+                color_point2d[1] < color_height)
+            {
+                depth_points2d.insert(depth_points2d.end(), depth_point2d, depth_point2d + 2);
+                color_points2d.insert(color_points2d.end(), color_point2d, color_point2d + 2);
+            }
+        }
+    }
+    size_t point_count = color_points2d.size() / 2;
+    ASSERT_GT(point_count, (size_t)10);
+    depth_points2d.insert(depth_points2d.end(), m_depth_point2d_reference, m_depth_point2d_reference + 2);
+    color_points2d.insert(color_points2d.end(), m_color_point2d_reference, m_color_point2d_reference + 2);
+    color_points2d.push_back(-100.f);
+    color_points2d.push_back(10.f);
+    point_count += 2;
+
+    for (uint32_t thread_count : { 1u, 4u })
+    {
+        ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+
+        std::vector<float> points2d(2 * point_count);
+        std::vector<int> valid(point_count);
+        ASSERT_EQ(transformation_color_2d_to_depth_2d_batch(transformation_handle,
+                                                            depth_image_data,
+                                                            &depth_image_descriptor,
+                                                            color_points2d.data(),
+                                                            point_count,
+                                                            points2d.data(),
+                                                            valid.data()),
+                  K4A_RESULT_SUCCEEDED);
+
+        // The lookup is refined below the one pixel steps of the epipolar search
+        for (size_t i = 0; i + 1 < point_count; i++)
+        {
+            ASSERT_EQ(valid[i], 1) << "point " << i;
+            ASSERT_LT(fabs(points2d[2 * i] - depth_points2d[2 * i]), 0.5) << "point " << i;
+            ASSERT_LT(fabs(points2d[2 * i + 1] - depth_points2d[2 * i + 1]), 0.5) << "point " << i;
+        }
+        ASSERT_EQ(valid[point_count - 1], 0);
+
+        // The batch agrees with the single point API, which searches the epipolar line by steps of one pixel
+        for (size_t i = 0; i < point_count; i++)
+        {
+            float point2d[2];
+            int point_valid = 0;
+            ASSERT_EQ(transformation_color_2d_to_depth_2d(
+                          &m_calibration, &color_points2d[2 * i], depth_image, point2d, &point_valid),
+                      K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(valid[i], point_valid) << "point " << i;
+            if (point_valid)
+            {
+                ASSERT_LT(fabs(points2d[2 * i] - point2d[0]), 1) << "point " << i;
+                ASSERT_LT(fabs(points2d[2 * i + 1] - point2d[1]), 1) << "point " << i;
+            }
+        }
+    }
+
+    float point2d[2];
+    int valid = 0;
+    const float *source_points2d = color_points2d.data();
+    ASSERT_EQ(transformation_color_2d_to_depth_2d_batch(
+                  transformation_handle, depth_image_data, &depth_image_descriptor, source_points2d, 0, NULL, NULL),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_color_2d_to_depth_2d_batch(
+                  transformation_handle, depth_image_data, &depth_image_descriptor, NULL, 1, point2d, &valid),
+              K4A_RESULT_FAILED);
+
+    k4a_transformation_image_descriptor_t wrong_descriptor = depth_image_descriptor;
+    wrong_descriptor.width_pixels = width / 2;
+    ASSERT_EQ(transformation_color_2d_to_depth_2d_batch(
+                  transformation_handle, depth_image_data, &wrong_descriptor, source_points2d, 1, point2d, &valid),
+              K4A_RESULT_FAILED);
+
+    image_dec_ref(depth_image);
+    transformation_destroy(transformation_handle);
+}
+
 TEST_F(transformation_ut, transformation_depth_image_to_point_cloud)
 {
     k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
@@ -409,24 +554,16 @@ TEST_F(transformation_ut, transformation_depth_image_to_point_cloud)
     }
 
     {
-        // Are we compiled for the correct instruction type
+        // Are we compiled for the correct instruction type, and do the kernels run at the level picked at runtime
 #if defined(__amd64__) || defined(_M_AMD64) || defined(__i386__) || defined(_M_IX86)
-#define SPECIAL_INSTRUCTION_OPTIMIZATION "SSE\0"
+        ASSERT_GE(simd_get_supported_level(), SIMD_LEVEL_SSE41);
 #elif defined(__aarch64__) || defined(_M_ARM64)
-#define SPECIAL_INSTRUCTION_OPTIMIZATION "NEON"
-#else
-// Omit defining this when not SSE or NEON. Should result in a build break. We are either SSE or Neon.
-//#define SPECIAL_INSTRUCTION_OPTIMIZATION "None"
+        ASSERT_EQ(simd_get_supported_level(), SIMD_LEVEL_NEON);
 #endif
-        char *compile_type = transformation_get_instruction_type();
-        ASSERT_NE(compile_type, (char *)nullptr);
-        ASSERT_NE(compile_type[0], '\0');
+        const char *compile_type = transformation_get_instruction_type();
+        ASSERT_NE(compile_type, nullptr);
         std::cout << "*** K4A Sensor SDK Compile type is: " << compile_type << " ***\n";
-        ASSERT_TRUE(memcmp(compile_type, SPECIAL_INSTRUCTION_OPTIMIZATION, strlen(compile_type)) == 0)
-            << "Expecting " << SPECIAL_INSTRUCTION_OPTIMIZATION << " but compiled for " << compile_type << "\n";
-        ASSERT_TRUE(memcmp(compile_type, SPECIAL_INSTRUCTION_OPTIMIZATION, strlen(compile_type)) == 0)
-            << "Expecting " << SPECIAL_INSTRUCTION_OPTIMIZATION << " but compiled for " << compile_type << "\n";
-        ASSERT_EQ(strlen(compile_type), strlen(SPECIAL_INSTRUCTION_OPTIMIZATION));
+        ASSERT_STREQ(compile_type, simd_get_level_name(simd_get_level()));
     }
 
     image_dec_ref(depth_image);
@@ -700,6 +837,1717 @@ TEST_F(transformation_ut, transformation_all_image_functions_with_failure_cases)
     image_dec_ref(xyz_depth_image);
 }
 
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_multi_thread)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    ASSERT_EQ(transformation_set_thread_count(transformation_handle, 0), K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_set_thread_count(transformation_handle, TRANSFORMATION_MAX_THREAD_COUNT + 1),
+              K4A_RESULT_FAILED);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    k4a_image_t depth_image = NULL;
+    k4a_image_t custom_image = NULL;
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                           width,
+                           height,
+                           width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &depth_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_CUSTOM16,
+                           width,
+                           height,
+                           width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &custom_image),
+              K4A_RESULT_SUCCEEDED);
+    k4a_transformation_image_descriptor_t depth_image_descriptor = image_get_descriptor(depth_image);
+    k4a_transformation_image_descriptor_t custom_image_descriptor = image_get_descriptor(custom_image);
+
+    // A near box in front of a slanted background, with holes, so that quads overlap and occlude each other
+    uint16_t *depth_image_buffer = (uint16_t *)(void *)image_get_buffer(depth_image);
+    uint16_t *custom_image_buffer = (uint16_t *)(void *)image_get_buffer(custom_image);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            bool box = x > width / 4 && x < width / 2 && y > height / 4 && y < height / 2;
+            uint16_t depth = (uint16_t)(box ? 500 + x : 2000 + 2 * y);
+            depth_image_buffer[y * width + x] = (x * 7 + y * 13) % 97 == 0 ? (uint16_t)0 : depth;
+            custom_image_buffer[y * width + x] = (uint16_t)(x * 31 + y * 17);
+        }
+    }
+
+    k4a_image_t transformed_depth_image[2] = { NULL, NULL };
+    k4a_image_t transformed_custom_image[2] = { NULL, NULL };
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                               color_width,
+                               color_height,
+                               color_width * (int)sizeof(uint16_t),
+                               ALLOCATION_SOURCE_USER,
+                               &transformed_depth_image[i]),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_CUSTOM16,
+                               color_width,
+                               color_height,
+                               color_width * (int)sizeof(uint16_t),
+                               ALLOCATION_SOURCE_USER,
+                               &transformed_custom_image[i]),
+                  K4A_RESULT_SUCCEEDED);
+    }
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = image_get_descriptor(
+        transformed_depth_image[0]);
+    k4a_transformation_image_descriptor_t transformed_custom_image_descriptor = image_get_descriptor(
+        transformed_custom_image[0]);
+    size_t transformed_image_size = image_get_size(transformed_depth_image[0]);
+
+    k4a_transformation_interpolation_type_t interpolation_types[] = { K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST,
+                                                                      K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR };
+    uint32_t thread_counts[] = { 2, 3, 4, TRANSFORMATION_MAX_THREAD_COUNT };
+
+    for (k4a_transformation_interpolation_type_t interpolation_type : interpolation_types)
+    {
+        // Reference is the single threaded output
+        ASSERT_EQ(transformation_set_thread_count(transformation_handle, 1), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    image_get_buffer(depth_image),
+                                                                    &depth_image_descriptor,
+                                                                    image_get_buffer(custom_image),
+                                                                    &custom_image_descriptor,
+                                                                    image_get_buffer(transformed_depth_image[0]),
+                                                                    &transformed_depth_image_descriptor,
+                                                                    image_get_buffer(transformed_custom_image[0]),
+                                                                    &transformed_custom_image_descriptor,
+                                                                    interpolation_type,
+                                                                    65535),
+                  K4A_RESULT_SUCCEEDED);
+
+        for (uint32_t thread_count : thread_counts)
+        {
+            memset(image_get_buffer(transformed_depth_image[1]), 0xff, transformed_image_size);
+            memset(image_get_buffer(transformed_custom_image[1]), 0xff, transformed_image_size);
+
+            ASSERT_EQ(transformation_set_thread_count(transformation_handle, thread_count), K4A_RESULT_SUCCEEDED);
+            ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                        image_get_buffer(depth_image),
+                                                                        &depth_image_descriptor,
+                                                                        image_get_buffer(custom_image),
+                                                                        &custom_image_descriptor,
+                                                                        image_get_buffer(transformed_depth_image[1]),
+                                                                        &transformed_depth_image_descriptor,
+                                                                        image_get_buffer(transformed_custom_image[1]),
+                                                                        &transformed_custom_image_descriptor,
+                                                                        interpolation_type,
+                                                                        65535),
+                      K4A_RESULT_SUCCEEDED);
+
+            ASSERT_EQ(memcmp(image_get_buffer(transformed_depth_image[0]),
+                             image_get_buffer(transformed_depth_image[1]),
+                             transformed_image_size),
+                      0)
+                << "Depth differs with " << thread_count << " threads";
+            ASSERT_EQ(memcmp(image_get_buffer(transformed_custom_image[0]),
+                             image_get_buffer(transformed_custom_image[1]),
+                             transformed_image_size),
+                      0)
+                << "Custom differs with " << thread_count << " threads";
+        }
+    }
+
+    image_dec_ref(depth_image);
+    image_dec_ref(custom_image);
+    for (int i = 0; i < 2; i++)
+    {
+        image_dec_ref(transformed_depth_image[i]);
+        image_dec_ref(transformed_custom_image[i]);
+    }
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_scaled)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    // A slanted plane, so depth changes slowly between neighboring color pixels
+    std::vector<uint16_t> depth((size_t)(width * height));
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            depth[(size_t)(y * width + x)] = (uint16_t)(1500 + x + 2 * y);
+        }
+    }
+    k4a_transformation_image_descriptor_t depth_descriptor = { width,
+                                                               height,
+                                                               width * (int)sizeof(uint16_t),
+                                                               K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t dummy_descriptor = { 0 };
+
+    std::vector<uint16_t> full((size_t)(color_width * color_height));
+    k4a_transformation_image_descriptor_t full_descriptor = { color_width,
+                                                              color_height,
+                                                              color_width * (int)sizeof(uint16_t),
+                                                              K4A_IMAGE_FORMAT_DEPTH16 };
+    ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                (const uint8_t *)depth.data(),
+                                                                &depth_descriptor,
+                                                                NULL,
+                                                                &dummy_descriptor,
+                                                                (uint8_t *)full.data(),
+                                                                &full_descriptor,
+                                                                NULL,
+                                                                &dummy_descriptor,
+                                                                K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                0),
+              K4A_RESULT_SUCCEEDED);
+    size_t full_valid_count = 0;
+    for (uint16_t value : full)
+    {
+        full_valid_count += value != 0 ? 1 : 0;
+    }
+
+    for (int scale = 2; scale <= 4; scale *= 2)
+    {
+        int scaled_width = (color_width + scale - 1) / scale;
+        int scaled_height = (color_height + scale - 1) / scale;
+        std::vector<uint16_t> scaled((size_t)(scaled_width * scaled_height));
+        k4a_transformation_image_descriptor_t scaled_descriptor = { scaled_width,
+                                                                    scaled_height,
+                                                                    scaled_width * (int)sizeof(uint16_t),
+                                                                    K4A_IMAGE_FORMAT_DEPTH16 };
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    (const uint8_t *)depth.data(),
+                                                                    &depth_descriptor,
+                                                                    NULL,
+                                                                    &dummy_descriptor,
+                                                                    (uint8_t *)scaled.data(),
+                                                                    &scaled_descriptor,
+                                                                    NULL,
+                                                                    &dummy_descriptor,
+                                                                    K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                    0),
+                  K4A_RESULT_SUCCEEDED);
+
+        // Each scaled pixel renders the center of its block of full resolution pixels
+        size_t valid_count = 0;
+        for (int y = 0; y < scaled_height; y++)
+        {
+            for (int x = 0; x < scaled_width; x++)
+            {
+                uint16_t value = scaled[(size_t)(y * scaled_width + x)];
+                valid_count += value != 0 ? 1 : 0;
+
+                int block_min = 65536;
+                int block_max = 0;
+                for (int by = y * scale; by < std::min(y * scale + scale, color_height); by++)
+                {
+                    for (int bx = x * scale; bx < std::min(x * scale + scale, color_width); bx++)
+                    {
+                        int full_value = full[(size_t)(by * color_width + bx)];
+                        block_min = full_value < block_min ? full_value : block_min;
+                        block_max = full_value > block_max ? full_value : block_max;
+                    }
+                }
+                if (value != 0 && block_min != 0)
+                {
+                    ASSERT_GE(value + 1, block_min) << "Scale " << scale << " at " << x << ", " << y;
+                    ASSERT_LE(value, block_max + 1) << "Scale " << scale << " at " << x << ", " << y;
+                }
+            }
+        }
+        size_t expected_count = full_valid_count / (size_t)(scale * scale);
+        ASSERT_NEAR((double)valid_count, (double)expected_count, 0.05 * (double)expected_count);
+
+        // Only packed power of two downscales are accepted
+        k4a_transformation_image_descriptor_t padded_descriptor = scaled_descriptor;
+        padded_descriptor.stride_bytes += (int)sizeof(uint16_t);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    (const uint8_t *)depth.data(),
+                                                                    &depth_descriptor,
+                                                                    NULL,
+                                                                    &dummy_descriptor,
+                                                                    (uint8_t *)scaled.data(),
+                                                                    &padded_descriptor,
+                                                                    NULL,
+                                                                    &dummy_descriptor,
+                                                                    K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                    0),
+                  K4A_RESULT_FAILED);
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_shared_handle_concurrent_calls)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth_image(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            depth_image[y * width + x] = (x * 5 + y * 11) % 89 == 0 ? (uint16_t)0 : (uint16_t)(800 + x + 2 * y);
+        }
+    }
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width * (int)sizeof(uint16_t),
+                                                                                 K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t dummy_descriptor = { 0, 0, 0, K4A_IMAGE_FORMAT_CUSTOM };
+
+    auto transform = [&](std::vector<uint16_t> &transformed_depth_image) {
+        return transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                 (const uint8_t *)depth_image.data(),
+                                                                 &depth_image_descriptor,
+                                                                 NULL,
+                                                                 &dummy_descriptor,
+                                                                 (uint8_t *)transformed_depth_image.data(),
+                                                                 &transformed_depth_image_descriptor,
+                                                                 NULL,
+                                                                 &dummy_descriptor,
+                                                                 K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST,
+                                                                 0);
+    };
+
+    std::vector<uint16_t> reference(color_width * color_height);
+    ASSERT_EQ(transform(reference), K4A_RESULT_SUCCEEDED);
+
+    // Worker threads share the handle while the thread count, which doesn't change the output, is changed under them
+    const int worker_count = 4;
+    const int iteration_count = 8;
+    std::vector<std::vector<uint16_t>> transformed_depth_images(worker_count,
+                                                                std::vector<uint16_t>(color_width * color_height));
+    std::vector<int> failures(worker_count, 0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < worker_count; i++)
+    {
+        workers.emplace_back([&, i]() {
+            for (int j = 0; j < iteration_count; j++)
+            {
+                std::fill(transformed_depth_images[i].begin(), transformed_depth_images[i].end(), (uint16_t)0xffff);
+                if (K4A_FAILED(transform(transformed_depth_images[i])) || transformed_depth_images[i] != reference)
+                {
+                    failures[i]++;
+                }
+            }
+        });
+    }
+    for (int j = 0; j < iteration_count; j++)
+    {
+        EXPECT_EQ(transformation_set_thread_count(transformation_handle, (uint32_t)(j % 4 + 1)), K4A_RESULT_SUCCEEDED);
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        ASSERT_EQ(failures[i], 0) << "Worker " << i << " got a different result";
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_custom_images)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+    size_t pixel_count = (size_t)(width * height);
+    size_t color_pixel_count = (size_t)(color_width * color_height);
+
+    std::vector<uint16_t> depth_image(pixel_count);
+    std::vector<uint16_t> custom16_image(pixel_count);
+    std::vector<uint8_t> custom8_image(pixel_count);
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        depth_image[i] = (uint16_t)(i % 11 == 0 ? 0 : 1000 + i % 500);
+        custom16_image[i] = (uint16_t)(i * 7);
+        custom8_image[i] = (uint8_t)(i * 3);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t custom_image_descriptors[] = {
+        { width, height, width * (int)sizeof(uint16_t), K4A_IMAGE_FORMAT_CUSTOM16 },
+        { width, height, width * (int)sizeof(uint8_t), K4A_IMAGE_FORMAT_CUSTOM8 }
+    };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width * (int)sizeof(uint16_t),
+                                                                                 K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t transformed_custom_image_descriptors[] = {
+        { color_width, color_height, color_width * (int)sizeof(uint16_t), K4A_IMAGE_FORMAT_CUSTOM16 },
+        { color_width, color_height, color_width * (int)sizeof(uint8_t), K4A_IMAGE_FORMAT_CUSTOM8 }
+    };
+    uint32_t invalid_custom_values[] = { 65535, 7 };
+
+    k4a_transformation_interpolation_type_t interpolation_types[] = { K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST,
+                                                                      K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR };
+    for (k4a_transformation_interpolation_type_t interpolation_type : interpolation_types)
+    {
+        // Reference is one transformation per custom image
+        std::vector<uint16_t> transformed_depth_image(color_pixel_count);
+        std::vector<uint16_t> transformed_custom16_image(color_pixel_count);
+        std::vector<uint8_t> transformed_custom8_image(color_pixel_count);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    (uint8_t *)depth_image.data(),
+                                                                    &depth_image_descriptor,
+                                                                    (uint8_t *)custom16_image.data(),
+                                                                    &custom_image_descriptors[0],
+                                                                    (uint8_t *)transformed_depth_image.data(),
+                                                                    &transformed_depth_image_descriptor,
+                                                                    (uint8_t *)transformed_custom16_image.data(),
+                                                                    &transformed_custom_image_descriptors[0],
+                                                                    interpolation_type,
+                                                                    invalid_custom_values[0]),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    (uint8_t *)depth_image.data(),
+                                                                    &depth_image_descriptor,
+                                                                    custom8_image.data(),
+                                                                    &custom_image_descriptors[1],
+                                                                    (uint8_t *)transformed_depth_image.data(),
+                                                                    &transformed_depth_image_descriptor,
+                                                                    transformed_custom8_image.data(),
+                                                                    &transformed_custom_image_descriptors[1],
+                                                                    interpolation_type,
+                                                                    invalid_custom_values[1]),
+                  K4A_RESULT_SUCCEEDED);
+
+        std::vector<uint16_t> one_pass_depth_image(color_pixel_count);
+        std::vector<uint16_t> one_pass_custom16_image(color_pixel_count);
+        std::vector<uint8_t> one_pass_custom8_image(color_pixel_count);
+        const uint8_t *custom_image_data[] = { (uint8_t *)custom16_image.data(), custom8_image.data() };
+        uint8_t *transformed_custom_image_data[] = { (uint8_t *)one_pass_custom16_image.data(),
+                                                     one_pass_custom8_image.data() };
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom_images(transformation_handle,
+                                                                           (uint8_t *)depth_image.data(),
+                                                                           &depth_image_descriptor,
+                                                                           2,
+                                                                           custom_image_data,
+                                                                           custom_image_descriptors,
+                                                                           (uint8_t *)one_pass_depth_image.data(),
+                                                                           &transformed_depth_image_descriptor,
+                                                                           transformed_custom_image_data,
+                                                                           transformed_custom_image_descriptors,
+                                                                           interpolation_type,
+                                                                           invalid_custom_values),
+                  K4A_RESULT_SUCCEEDED);
+
+        ASSERT_EQ(one_pass_depth_image, transformed_depth_image);
+        ASSERT_EQ(one_pass_custom16_image, transformed_custom16_image);
+        ASSERT_EQ(one_pass_custom8_image, transformed_custom8_image);
+
+        // The transformation is unchanged without custom images
+        std::vector<uint16_t> depth_only_image(color_pixel_count);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom_images(transformation_handle,
+                                                                           (uint8_t *)depth_image.data(),
+                                                                           &depth_image_descriptor,
+                                                                           0,
+                                                                           NULL,
+                                                                           NULL,
+                                                                           (uint8_t *)depth_only_image.data(),
+                                                                           &transformed_depth_image_descriptor,
+                                                                           NULL,
+                                                                           NULL,
+                                                                           interpolation_type,
+                                                                           NULL),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(depth_only_image, transformed_depth_image);
+    }
+
+    ASSERT_EQ(transformation_depth_image_to_color_camera_custom_images(transformation_handle,
+                                                                       (uint8_t *)depth_image.data(),
+                                                                       &depth_image_descriptor,
+                                                                       K4A_TRANSFORMATION_MAX_CUSTOM_IMAGES + 1,
+                                                                       NULL,
+                                                                       NULL,
+                                                                       (uint8_t *)depth_image.data(),
+                                                                       &transformed_depth_image_descriptor,
+                                                                       NULL,
+                                                                       NULL,
+                                                                       K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                       NULL),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_color_camera_ray_tables)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    k4a_image_t depth_image = NULL;
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                           width,
+                           height,
+                           width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &depth_image),
+              K4A_RESULT_SUCCEEDED);
+    k4a_transformation_image_descriptor_t depth_image_descriptor = image_get_descriptor(depth_image);
+
+    uint16_t *depth_image_buffer = (uint16_t *)(void *)image_get_buffer(depth_image);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            depth_image_buffer[y * width + x] = (uint16_t)(1000 + x + y);
+        }
+    }
+
+    k4a_image_t transformed_depth_image[2] = { NULL, NULL };
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                               color_width,
+                               color_height,
+                               color_width * (int)sizeof(uint16_t),
+                               ALLOCATION_SOURCE_USER,
+                               &transformed_depth_image[i]),
+                  K4A_RESULT_SUCCEEDED);
+    }
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = image_get_descriptor(
+        transformed_depth_image[0]);
+    k4a_transformation_image_descriptor_t dummy_descriptor = { 0 };
+
+    for (int i = 0; i < 2; i++)
+    {
+        // Enabling twice keeps the tables that were already computed
+        ASSERT_EQ(transformation_enable_depth_to_color_ray_tables(transformation_handle, i == 1), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(transformation_enable_depth_to_color_ray_tables(transformation_handle, i == 1), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                    image_get_buffer(depth_image),
+                                                                    &depth_image_descriptor,
+                                                                    0,
+                                                                    &dummy_descriptor,
+                                                                    image_get_buffer(transformed_depth_image[i]),
+                                                                    &transformed_depth_image_descriptor,
+                                                                    0,
+                                                                    &dummy_descriptor,
+                                                                    K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                    0),
+                  K4A_RESULT_SUCCEEDED);
+    }
+
+    // The ray tables round differently, which may only change the interpolated depth by a fraction of a millimeter
+    uint16_t *reference = (uint16_t *)(void *)image_get_buffer(transformed_depth_image[0]);
+    uint16_t *result = (uint16_t *)(void *)image_get_buffer(transformed_depth_image[1]);
+    int valid_pixels = 0;
+    int different_pixels = 0;
+    for (int i = 0; i < color_width * color_height; i++)
+    {
+        valid_pixels += reference[i] != 0;
+        different_pixels += abs(reference[i] - result[i]) > 1;
+    }
+    ASSERT_GT(valid_pixels, 0);
+    ASSERT_LT(different_pixels, valid_pixels / 1000);
+
+    image_dec_ref(depth_image);
+    image_dec_ref(transformed_depth_image[0]);
+    image_dec_ref(transformed_depth_image[1]);
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_batch_matches_single_point)
+{
+    const k4a_calibration_type_t cameras[2] = { K4A_CALIBRATION_TYPE_DEPTH, K4A_CALIBRATION_TYPE_COLOR };
+    const size_t point_count = 1027; // not a multiple of the SIMD width so that the scalar tail is covered
+
+    // Sweep pixels, depths and 3D points well beyond the field of view of either camera and behind the camera
+    std::vector<k4a_float2_t> points2d(point_count);
+    std::vector<float> depths(point_count);
+    std::vector<k4a_float3_t> points3d(point_count);
+    for (size_t i = 0; i < point_count; i++)
+    {
+        points2d[i].xy.x = (float)((i * 37) % 4000) - 500.f;
+        points2d[i].xy.y = (float)((i * 53) % 3000) - 500.f;
+        depths[i] = i % 11 == 0 ? 0.f : 300.f + (float)i;
+        points3d[i].xyz.x = (float)((int)(i * 37 % 3001) - 1500);
+        points3d[i].xyz.y = (float)((int)(i * 53 % 2001) - 1000);
+        points3d[i].xyz.z = (float)((int)(i * 71 % 4001) - 500);
+    }
+
+    std::vector<k4a_float3_t> batch_points3d(point_count);
+    std::vector<k4a_float2_t> batch_points2d(point_count);
+    std::vector<int> batch_valid(point_count);
+    for (k4a_calibration_type_t source_camera : cameras)
+    {
+        for (k4a_calibration_type_t target_camera : cameras)
+        {
+            ASSERT_EQ(transformation_2d_to_3d_batch(&m_calibration,
+                                                    points2d[0].v,
+                                                    depths.data(),
+                                                    point_count,
+                                                    source_camera,
+                                                    target_camera,
+                                                    batch_points3d[0].v,
+                                                    batch_valid.data()),
+                      K4A_RESULT_SUCCEEDED);
+            for (size_t i = 0; i < point_count; i++)
+            {
+                float point3d[3];
+                int valid = 0;
+                ASSERT_EQ(transformation_2d_to_3d(&m_calibration,
+                                                  points2d[i].v,
+                                                  depths[i],
+                                                  source_camera,
+                                                  target_camera,
+                                                  point3d,
+                                                  &valid),
+                          K4A_RESULT_SUCCEEDED);
+                ASSERT_EQ(batch_valid[i], valid);
+                if (valid)
+                {
+                    ASSERT_EQ_FLT3(batch_points3d[i].v, point3d);
+                }
+            }
+
+            ASSERT_EQ(transformation_3d_to_2d_batch(&m_calibration,
+                                                    points3d[0].v,
+                                                    point_count,
+                                                    source_camera,
+                                                    target_camera,
+                                                    batch_points2d[0].v,
+                                                    batch_valid.data()),
+                      K4A_RESULT_SUCCEEDED);
+            int valid_count = 0;
+            for (size_t i = 0; i < point_count; i++)
+            {
+                float point2d[2];
+                int valid = 0;
+                ASSERT_EQ(transformation_3d_to_2d(
+                              &m_calibration, points3d[i].v, source_camera, target_camera, point2d, &valid),
+                          K4A_RESULT_SUCCEEDED);
+                ASSERT_EQ(batch_valid[i], valid);
+                if (valid)
+                {
+                    ASSERT_EQ_FLT2(batch_points2d[i].v, point2d);
+                    valid_count++;
+                }
+            }
+            ASSERT_GT(valid_count, 0);
+            ASSERT_LT(valid_count, (int)point_count);
+        }
+    }
+
+    // The camera must be running to transform into it
+    k4a_calibration_t calibration = m_calibration;
+    calibration.color_resolution = K4A_COLOR_RESOLUTION_OFF;
+    ASSERT_EQ(transformation_3d_to_2d_batch(&calibration,
+                                            points3d[0].v,
+                                            point_count,
+                                            K4A_CALIBRATION_TYPE_DEPTH,
+                                            K4A_CALIBRATION_TYPE_COLOR,
+                                            batch_points2d[0].v,
+                                            batch_valid.data()),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_2d_to_3d_batch(&calibration,
+                                            points2d[0].v,
+                                            depths.data(),
+                                            point_count,
+                                            K4A_CALIBRATION_TYPE_DEPTH,
+                                            K4A_CALIBRATION_TYPE_COLOR,
+                                            batch_points3d[0].v,
+                                            batch_valid.data()),
+              K4A_RESULT_FAILED);
+}
+
+static std::vector<int16_t> depth_image_to_point_cloud(k4a_transformation_t transformation_handle,
+                                                       const k4a_calibration_t &calibration)
+{
+    int width = calibration.depth_camera_calibration.resolution_width;
+    int height = calibration.depth_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth_image((size_t)(width * height));
+    for (int i = 0; i < width * height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(500 + i % 3000);
+    }
+    std::vector<int16_t> xyz_image((size_t)(3 * width * height));
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { width,
+                                                                   height,
+                                                                   width * 3 * (int)sizeof(int16_t),
+                                                                   K4A_IMAGE_FORMAT_CUSTOM };
+    EXPECT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (uint8_t *)depth_image.data(),
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        (uint8_t *)xyz_image.data(),
+                                                        &xyz_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    return xyz_image;
+}
+
+TEST_F(transformation_ut, transformation_xy_tables_cache)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+    std::vector<int16_t> reference = depth_image_to_point_cloud(transformation_handle, m_calibration);
+    transformation_destroy(transformation_handle);
+
+    const std::string cache_dir = "transformation_cache_test_temp";
+    ASSERT_EQ(system((MKDIR(cache_dir)).c_str()), 0);
+    ASSERT_EQ(SETENV("K4A_TRANSFORMATION_CACHE_DIR", cache_dir.c_str()), 0);
+
+    // The first handle computes and stores the tables, the second one loads them
+    for (int i = 0; i < 2; i++)
+    {
+        transformation_handle = transformation_create(&m_calibration, false);
+        ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+        ASSERT_EQ(depth_image_to_point_cloud(transformation_handle, m_calibration), reference);
+        transformation_destroy(transformation_handle);
+    }
+
+    // A different mode must not pick up the tables of the first one
+    k4a_calibration_t calibration;
+    ASSERT_EQ(k4a_calibration_get_from_raw(g_test_json,
+                                           sizeof(g_test_json),
+                                           K4A_DEPTH_MODE_NFOV_UNBINNED,
+                                           K4A_COLOR_RESOLUTION_720P,
+                                           &calibration),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(SETENV("K4A_TRANSFORMATION_CACHE_DIR", ""), 0);
+    transformation_handle = transformation_create(&calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+    std::vector<int16_t> mode_reference = depth_image_to_point_cloud(transformation_handle, calibration);
+    transformation_destroy(transformation_handle);
+
+    ASSERT_EQ(SETENV("K4A_TRANSFORMATION_CACHE_DIR", cache_dir.c_str()), 0);
+    transformation_handle = transformation_create(&calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+    ASSERT_EQ(depth_image_to_point_cloud(transformation_handle, calibration), mode_reference);
+    transformation_destroy(transformation_handle);
+
+    ASSERT_EQ(SETENV("K4A_TRANSFORMATION_CACHE_DIR", ""), 0);
+    ASSERT_EQ(system((RMDIR(cache_dir)).c_str()), 0);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_colored_point_cloud)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth_image((size_t)(depth_width * depth_height));
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+    std::vector<uint8_t> color_image((size_t)(4 * color_width * color_height));
+    for (size_t i = 0; i < color_image.size(); i++)
+    {
+        color_image[i] = (uint8_t)(i % 5 == 0 ? 0 : i * 31);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width,
+                                                                     color_height,
+                                                                     color_width * 4 * (int)sizeof(uint8_t),
+                                                                     K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t),
+                                                                                 K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { depth_width,
+                                                                   depth_height,
+                                                                   depth_width * 3 * (int)sizeof(int16_t),
+                                                                   K4A_IMAGE_FORMAT_CUSTOM };
+    k4a_transformation_image_descriptor_t colored_xyz_image_descriptor = { depth_width,
+                                                                           depth_height,
+                                                                           depth_width *
+                                                                               TRANSFORMATION_COLORED_POINT_SIZE,
+                                                                           K4A_IMAGE_FORMAT_CUSTOM };
+
+    // Reference from the two separate transformations
+    std::vector<uint8_t> transformed_color_image((size_t)(4 * depth_width * depth_height));
+    std::vector<int16_t> xyz_image((size_t)(3 * depth_width * depth_height));
+    ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                         (uint8_t *)depth_image.data(),
+                                                         &depth_image_descriptor,
+                                                         color_image.data(),
+                                                         &color_image_descriptor,
+                                                         transformed_color_image.data(),
+                                                         &transformed_color_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (uint8_t *)depth_image.data(),
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        (uint8_t *)xyz_image.data(),
+                                                        &xyz_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    std::vector<uint8_t> colored_xyz_image((size_t)(depth_width * depth_height * TRANSFORMATION_COLORED_POINT_SIZE));
+    ASSERT_EQ(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                (uint8_t *)depth_image.data(),
+                                                                &depth_image_descriptor,
+                                                                color_image.data(),
+                                                                &color_image_descriptor,
+                                                                colored_xyz_image.data(),
+                                                                &colored_xyz_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    int colored_points = 0;
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        const uint8_t *point = colored_xyz_image.data() + i * TRANSFORMATION_COLORED_POINT_SIZE;
+        ASSERT_EQ(memcmp(point, xyz_image.data() + 3 * i, 3 * sizeof(int16_t)), 0);
+        ASSERT_EQ(memcmp(point + 3 * sizeof(int16_t), transformed_color_image.data() + 4 * i, 4), 0);
+        colored_points += point[6] != 0 || point[7] != 0 || point[8] != 0 || point[9] != 0;
+    }
+    ASSERT_GT(colored_points, 0);
+
+    // Output with the stride of a plain point cloud must be rejected
+    ASSERT_EQ(transformation_depth_image_to_colored_point_cloud(transformation_handle,
+                                                                (uint8_t *)depth_image.data(),
+                                                                &depth_image_descriptor,
+                                                                color_image.data(),
+                                                                &color_image_descriptor,
+                                                                colored_xyz_image.data(),
+                                                                &xyz_image_descriptor),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_point_cloud_formats)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth_image((size_t)(width * height));
+    for (int i = 0; i < width * height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t xyz_int16_descriptor = { width,
+                                                                   height,
+                                                                   width * 3 * (int)sizeof(int16_t),
+                                                                   K4A_IMAGE_FORMAT_CUSTOM };
+    k4a_transformation_image_descriptor_t xyz_float_descriptor = { width,
+                                                                   height,
+                                                                   width * 3 * (int)sizeof(float),
+                                                                   K4A_IMAGE_FORMAT_CUSTOM };
+    k4a_transformation_image_descriptor_t index_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint32_t),
+                                                                     K4A_IMAGE_FORMAT_CUSTOM };
+
+    std::vector<int16_t> xyz_int16(3 * (size_t)(width * height));
+    std::vector<float> xyz_float(3 * (size_t)(width * height));
+    ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (uint8_t *)depth_image.data(),
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        (uint8_t *)xyz_int16.data(),
+                                                        &xyz_int16_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)xyz_float.data(),
+                  &xyz_float_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // The float points are the int16 points before rounding, in meters
+    for (size_t i = 0; i < xyz_float.size(); i++)
+    {
+        ASSERT_LE(std::abs(xyz_float[i] * 1000.f - (float)xyz_int16[i]), 0.51f);
+    }
+
+    // The compact point clouds hold exactly the points with non zero depth, in pixel order
+    std::vector<int16_t> compact_int16(xyz_int16.size());
+    std::vector<float> compact_float(xyz_float.size());
+    std::vector<uint32_t> indices((size_t)(width * height));
+    size_t int16_point_count = 0, float_point_count = 0;
+    ASSERT_EQ(transformation_depth_image_to_compact_point_cloud(transformation_handle,
+                                                                (uint8_t *)depth_image.data(),
+                                                                &depth_image_descriptor,
+                                                                K4A_CALIBRATION_TYPE_DEPTH,
+                                                                K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS,
+                                                                (uint8_t *)compact_int16.data(),
+                                                                &xyz_int16_descriptor,
+                                                                (uint8_t *)indices.data(),
+                                                                &index_image_descriptor,
+                                                                &int16_point_count),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_compact_point_cloud(transformation_handle,
+                                                                (uint8_t *)depth_image.data(),
+                                                                &depth_image_descriptor,
+                                                                K4A_CALIBRATION_TYPE_DEPTH,
+                                                                K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                                                                (uint8_t *)compact_float.data(),
+                                                                &xyz_float_descriptor,
+                                                                NULL,
+                                                                NULL,
+                                                                &float_point_count),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(int16_point_count, float_point_count);
+
+    size_t point_count = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+        if (xyz_int16[3 * (size_t)i + 2] == 0)
+        {
+            continue;
+        }
+        ASSERT_LT(point_count, int16_point_count);
+        ASSERT_EQ(indices[point_count], (uint32_t)i);
+        ASSERT_EQ(memcmp(&compact_int16[3 * point_count], &xyz_int16[3 * (size_t)i], 3 * sizeof(int16_t)), 0);
+        ASSERT_EQ(memcmp(&compact_float[3 * point_count], &xyz_float[3 * (size_t)i], 3 * sizeof(float)), 0);
+        point_count++;
+    }
+    ASSERT_EQ(point_count, int16_point_count);
+    ASSERT_GT(point_count, (size_t)0);
+    ASSERT_LT(point_count, (size_t)(width * height));
+
+    // The float format needs the wider stride
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)xyz_float.data(),
+                  &xyz_int16_descriptor),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_depth_image_to_point_cloud_normals_and_voxels)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    // A wall 1 meter in front of the camera, with holes
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth_image((size_t)(width * height));
+    for (int i = 0; i < width * height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 11 == 0 ? 0 : 1000);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t xyz_descriptor = { width,
+                                                             height,
+                                                             width * 3 * (int)sizeof(float),
+                                                             K4A_IMAGE_FORMAT_CUSTOM };
+
+    std::vector<float> expected_xyz(3 * (size_t)(width * height));
+    std::vector<float> xyz(expected_xyz.size());
+    std::vector<float> normals(expected_xyz.size());
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)expected_xyz.data(),
+                  &xyz_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_normals(transformation_handle,
+                                                                     (uint8_t *)depth_image.data(),
+                                                                     &depth_image_descriptor,
+                                                                     K4A_CALIBRATION_TYPE_DEPTH,
+                                                                     (uint8_t *)xyz.data(),
+                                                                     &xyz_descriptor,
+                                                                     (uint8_t *)normals.data(),
+                                                                     &xyz_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // The points are those of the plain point cloud, and the normals of the wall face the camera
+    ASSERT_EQ(memcmp(xyz.data(), expected_xyz.data(), xyz.size() * sizeof(float)), 0);
+    size_t valid_point_count = 0, normal_count = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+        const float *normal = &normals[3 * (size_t)i];
+        valid_point_count += xyz[3 * (size_t)i + 2] != 0.f ? 1 : 0;
+        if (normal[0] == 0.f && normal[1] == 0.f && normal[2] == 0.f)
+        {
+            continue;
+        }
+        ASSERT_NE(depth_image[(size_t)i], 0);
+        ASSERT_NEAR(normal[0], 0.f, 1e-5f);
+        ASSERT_NEAR(normal[1], 0.f, 1e-5f);
+        ASSERT_NEAR(normal[2], -1.f, 1e-5f);
+        normal_count++;
+    }
+    ASSERT_GT(normal_count, (size_t)0);
+    ASSERT_LT(normal_count, valid_point_count);
+
+    // Voxels smaller than the point spacing keep every point unchanged
+    std::vector<float> voxel_xyz(xyz.size());
+    std::vector<float> voxel_normals(xyz.size());
+    size_t voxel_count = 0;
+    ASSERT_EQ(transformation_depth_image_to_voxel_point_cloud(transformation_handle,
+                                                              (uint8_t *)depth_image.data(),
+                                                              &depth_image_descriptor,
+                                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                                              0.0001f,
+                                                              (uint8_t *)voxel_xyz.data(),
+                                                              &xyz_descriptor,
+                                                              NULL,
+                                                              NULL,
+                                                              &voxel_count),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(voxel_count, valid_point_count);
+    size_t point_index = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+        if (xyz[3 * (size_t)i + 2] != 0.f)
+        {
+            ASSERT_EQ(memcmp(&voxel_xyz[3 * point_index], &xyz[3 * (size_t)i], 3 * sizeof(float)), 0);
+            point_index++;
+        }
+    }
+
+    // Voxels of 5 centimeters merge neighboring points into centroids inside the voxel
+    const float voxel_size = 0.05f;
+    ASSERT_EQ(transformation_depth_image_to_voxel_point_cloud(transformation_handle,
+                                                              (uint8_t *)depth_image.data(),
+                                                              &depth_image_descriptor,
+                                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                                              voxel_size,
+                                                              (uint8_t *)voxel_xyz.data(),
+                                                              &xyz_descriptor,
+                                                              (uint8_t *)voxel_normals.data(),
+                                                              &xyz_descriptor,
+                                                              &voxel_count),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_GT(voxel_count, (size_t)0);
+    ASSERT_LT(voxel_count, valid_point_count / 10);
+    for (size_t i = 0; i < voxel_count; i++)
+    {
+        ASSERT_NEAR(voxel_xyz[3 * i + 2], 1.f, 1e-4f);
+        const float *normal = &voxel_normals[3 * i];
+        if (normal[2] != 0.f)
+        {
+            ASSERT_NEAR(normal[2], -1.f, 1e-5f);
+        }
+    }
+
+    ASSERT_EQ(transformation_depth_image_to_voxel_point_cloud(transformation_handle,
+                                                              (uint8_t *)depth_image.data(),
+                                                              &depth_image_descriptor,
+                                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                                              0.f,
+                                                              (uint8_t *)voxel_xyz.data(),
+                                                              &xyz_descriptor,
+                                                              NULL,
+                                                              NULL,
+                                                              &voxel_count),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_region_of_interest)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    std::vector<uint16_t> depth_image((size_t)(width * height));
+    for (int i = 0; i < width * height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { width,
+                                                                     height,
+                                                                     width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t xyz_descriptor = { width,
+                                                             height,
+                                                             width * 3 * (int)sizeof(float),
+                                                             K4A_IMAGE_FORMAT_CUSTOM };
+    std::vector<float> xyz(3 * (size_t)(width * height));
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)xyz.data(),
+                  &xyz_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // An odd offset and a region width that is not a multiple of the SIMD width
+    k4a_transformation_roi_t roi = { 37, 21, 203, 151, 2 };
+    int roi_width = (roi.width + roi.decimation - 1) / roi.decimation;
+    int roi_height = (roi.height + roi.decimation - 1) / roi.decimation;
+    ASSERT_EQ(transformation_set_region_of_interest(transformation_handle, &roi), K4A_RESULT_SUCCEEDED);
+
+    k4a_transformation_image_descriptor_t roi_xyz_descriptor = { roi_width,
+                                                                 roi_height,
+                                                                 roi_width * 3 * (int)sizeof(float),
+                                                                 K4A_IMAGE_FORMAT_CUSTOM };
+    std::vector<float> roi_xyz(3 * (size_t)(roi_width * roi_height));
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)roi_xyz.data(),
+                  &roi_xyz_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // Every region point is the full image point at the same depth pixel
+    for (int y = 0; y < roi_height; y++)
+    {
+        for (int x = 0; x < roi_width; x++)
+        {
+            size_t full_index = (size_t)((roi.y + y * roi.decimation) * width + roi.x + x * roi.decimation);
+            ASSERT_EQ(memcmp(&roi_xyz[3 * (size_t)(y * roi_width + x)], &xyz[3 * full_index], 3 * sizeof(float)), 0);
+        }
+    }
+
+    // With a region of interest the output takes the region size
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)xyz.data(),
+                  &xyz_descriptor),
+              K4A_RESULT_FAILED);
+
+    k4a_transformation_roi_t outside = { width - 10, 0, 20, 10, 1 };
+    ASSERT_EQ(transformation_set_region_of_interest(transformation_handle, &outside), K4A_RESULT_FAILED);
+    k4a_transformation_roi_t no_decimation = { 0, 0, 10, 10, 0 };
+    ASSERT_EQ(transformation_set_region_of_interest(transformation_handle, &no_decimation), K4A_RESULT_FAILED);
+
+    ASSERT_EQ(transformation_set_region_of_interest(transformation_handle, NULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud_with_format(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  K4A_CALIBRATION_TYPE_DEPTH,
+                  K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_FLOAT32_METERS,
+                  (uint8_t *)xyz.data(),
+                  &xyz_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_get_xy_table)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int width = m_calibration.depth_camera_calibration.resolution_width;
+    int height = m_calibration.depth_camera_calibration.resolution_height;
+    k4a_transformation_image_descriptor_t xy_table_descriptor = { width,
+                                                                  height,
+                                                                  width * (int)sizeof(k4a_float2_t),
+                                                                  K4A_IMAGE_FORMAT_CUSTOM };
+    std::vector<k4a_float2_t> xy_table((size_t)(width * height));
+
+    // The region of interest does not change the table
+    k4a_transformation_roi_t roi = { 37, 21, 203, 151, 2 };
+    ASSERT_EQ(transformation_set_region_of_interest(transformation_handle, &roi), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_get_xy_table(transformation_handle,
+                                          K4A_CALIBRATION_TYPE_DEPTH,
+                                          (uint8_t *)xy_table.data(),
+                                          &xy_table_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    // Every entry is the pixel unprojected to a depth of 1, or NAN where the pixel can not be unprojected
+    for (int y = 0; y < height; y += 7)
+    {
+        for (int x = 0; x < width; x += 7)
+        {
+            float point2d[2] = { (float)x, (float)y };
+            float point3d[3] = { 0.f, 0.f, 0.f };
+            int valid = 0;
+            ASSERT_EQ(transformation_2d_to_3d(&m_calibration,
+                                              point2d,
+                                              1.f,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              K4A_CALIBRATION_TYPE_DEPTH,
+                                              point3d,
+                                              &valid),
+                      K4A_RESULT_SUCCEEDED);
+
+            const k4a_float2_t &entry = xy_table[(size_t)(y * width + x)];
+            if (valid)
+            {
+                ASSERT_NEAR(entry.xy.x, point3d[0], 0.0001f);
+                ASSERT_NEAR(entry.xy.y, point3d[1], 0.0001f);
+            }
+            else
+            {
+                ASSERT_TRUE(std::isnan(entry.xy.x));
+                ASSERT_TRUE(std::isnan(entry.xy.y));
+            }
+        }
+    }
+
+    // The table must have the full camera resolution
+    k4a_transformation_image_descriptor_t roi_descriptor = { width / 2,
+                                                             height / 2,
+                                                             width * (int)sizeof(k4a_float2_t),
+                                                             K4A_IMAGE_FORMAT_CUSTOM };
+    ASSERT_EQ(transformation_get_xy_table(transformation_handle,
+                                          K4A_CALIBRATION_TYPE_DEPTH,
+                                          (uint8_t *)xy_table.data(),
+                                          &roi_descriptor),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_get_xy_table(transformation_handle,
+                                          K4A_CALIBRATION_TYPE_GYRO,
+                                          (uint8_t *)xy_table.data(),
+                                          &xy_table_descriptor),
+              K4A_RESULT_FAILED);
+
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+    k4a_transformation_image_descriptor_t color_xy_table_descriptor = { color_width,
+                                                                        color_height,
+                                                                        color_width * (int)sizeof(k4a_float2_t),
+                                                                        K4A_IMAGE_FORMAT_CUSTOM };
+    std::vector<k4a_float2_t> color_xy_table((size_t)(color_width * color_height));
+    ASSERT_EQ(transformation_get_xy_table(transformation_handle,
+                                          K4A_CALIBRATION_TYPE_COLOR,
+                                          (uint8_t *)color_xy_table.data(),
+                                          &color_xy_table_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    transformation_destroy(transformation_handle);
+}
+
+TEST_F(transformation_ut, transformation_color_image_to_depth_camera_nearest)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth_image((size_t)(depth_width * depth_height));
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+
+    // Blue and green are ramps along x and y, red is a checkerboard only nearest neighbor sampling keeps binary
+    std::vector<uint8_t> color_image((size_t)(4 * color_width * color_height));
+    for (int y = 0; y < color_height; y++)
+    {
+        for (int x = 0; x < color_width; x++)
+        {
+            uint8_t *pixel = color_image.data() + 4 * (y * color_width + x);
+            pixel[0] = (uint8_t)(x * 255 / (color_width - 1));
+            pixel[1] = (uint8_t)(y * 255 / (color_height - 1));
+            pixel[2] = (uint8_t)(((x + y) & 1) * 255);
+            pixel[3] = 255;
+        }
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width,
+                                                                     color_height,
+                                                                     color_width * 4 * (int)sizeof(uint8_t),
+                                                                     K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t),
+                                                                                 K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+
+    std::vector<uint8_t> reference_image((size_t)(4 * depth_width * depth_height));
+    std::vector<uint8_t> linear_image((size_t)(4 * depth_width * depth_height));
+    std::vector<uint8_t> nearest_image((size_t)(4 * depth_width * depth_height));
+    ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                         (uint8_t *)depth_image.data(),
+                                                         &depth_image_descriptor,
+                                                         color_image.data(),
+                                                         &color_image_descriptor,
+                                                         reference_image.data(),
+                                                         &transformed_color_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_color_image_to_depth_camera_with_interpolation(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  color_image.data(),
+                  &color_image_descriptor,
+                  linear_image.data(),
+                  &transformed_color_image_descriptor,
+                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_color_image_to_depth_camera_with_interpolation(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  color_image.data(),
+                  &color_image_descriptor,
+                  nearest_image.data(),
+                  &transformed_color_image_descriptor,
+                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(memcmp(reference_image.data(), linear_image.data(), reference_image.size()), 0);
+
+    int valid_pixels = 0;
+    int blended_pixels = 0;
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        const uint8_t *linear = linear_image.data() + 4 * i;
+        const uint8_t *nearest = nearest_image.data() + 4 * i;
+        ASSERT_EQ(linear[3], nearest[3]);
+        if (nearest[3] == 0)
+        {
+            ASSERT_EQ(nearest[0] | nearest[1] | nearest[2], 0);
+            continue;
+        }
+        valid_pixels++;
+        ASSERT_LE(abs(linear[0] - nearest[0]), 1);
+        ASSERT_LE(abs(linear[1] - nearest[1]), 1);
+        ASSERT_TRUE(nearest[2] == 0 || nearest[2] == 255);
+        blended_pixels += linear[2] != 0 && linear[2] != 255;
+    }
+    ASSERT_GT(valid_pixels, 0);
+    ASSERT_GT(blended_pixels, 0);
+
+    ASSERT_EQ(transformation_color_image_to_depth_camera_with_interpolation(
+                  transformation_handle,
+                  (uint8_t *)depth_image.data(),
+                  &depth_image_descriptor,
+                  color_image.data(),
+                  &color_image_descriptor,
+                  nearest_image.data(),
+                  &transformed_color_image_descriptor,
+                  (k4a_transformation_interpolation_type_t)(K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR + 1)),
+              K4A_RESULT_FAILED);
+
+    transformation_destroy(transformation_handle);
+}
+
+static uint8_t yuv_test_clamp(int value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// BT.601 limited range, the conversion the transformation applies to sampled pixels
+static void yuv_test_pixel_to_bgra(int luma, int u, int v, uint8_t *bgra)
+{
+    int c = 298 * (luma - 16) + 128;
+    bgra[0] = yuv_test_clamp((c + 516 * (u - 128)) >> 8);
+    bgra[1] = yuv_test_clamp((c - 100 * (u - 128) - 208 * (v - 128)) >> 8);
+    bgra[2] = yuv_test_clamp((c + 409 * (v - 128)) >> 8);
+    bgra[3] = 255;
+}
+
+TEST_F(transformation_ut, transformation_color_image_to_depth_camera_yuv)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    std::vector<uint16_t> depth_image((size_t)(depth_width * depth_height));
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        depth_image[(size_t)i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+
+    // Luma is a ramp along x, chroma changes along y. The same pixels are stored as NV12, YUY2 and converted to BGRA.
+    std::vector<uint8_t> nv12_image((size_t)(color_width * color_height * 3 / 2));
+    std::vector<uint8_t> yuy2_image((size_t)(2 * color_width * color_height));
+    std::vector<uint8_t> bgra_image((size_t)(4 * color_width * color_height));
+    for (int y = 0; y < color_height; y++)
+    {
+        for (int x = 0; x < color_width; x++)
+        {
+            int luma = 16 + x * 219 / (color_width - 1);
+            int u = 16 + (y / 2) * 224 / (color_height / 2);
+            int v = 240 - (y / 2) * 224 / (color_height / 2);
+            nv12_image[(size_t)(y * color_width + x)] = (uint8_t)luma;
+            nv12_image[(size_t)(color_width * color_height + (y / 2) * color_width + (x / 2) * 2)] = (uint8_t)u;
+            nv12_image[(size_t)(color_width * color_height + (y / 2) * color_width + (x / 2) * 2 + 1)] = (uint8_t)v;
+            uint8_t *pair = yuy2_image.data() + 2 * y * color_width + 4 * (x / 2);
+            pair[2 * (x % 2)] = (uint8_t)luma;
+            pair[1] = (uint8_t)u;
+            pair[3] = (uint8_t)v;
+            yuv_test_pixel_to_bgra(luma, u, v, bgra_image.data() + 4 * (y * color_width + x));
+        }
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t),
+                                                                                 K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t color_image_descriptors[] = {
+        { color_width, color_height, color_width * 4, K4A_IMAGE_FORMAT_COLOR_BGRA32 },
+        { color_width, color_height, color_width, K4A_IMAGE_FORMAT_COLOR_NV12 },
+        { color_width, color_height, color_width * 2, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    };
+    const uint8_t *color_images[] = { bgra_image.data(), nv12_image.data(), yuy2_image.data() };
+
+    // Sampling the YUV images directly gives the same result as converting the whole image to BGRA first
+    for (k4a_transformation_interpolation_type_t interpolation_type :
+         { K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR, K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST })
+    {
+        std::vector<uint8_t> transformed_images[3];
+        for (size_t i = 0; i < 3; i++)
+        {
+            transformed_images[i].resize((size_t)(4 * depth_width * depth_height));
+            ASSERT_EQ(transformation_color_image_to_depth_camera_with_interpolation(transformation_handle,
+                                                                                    (uint8_t *)depth_image.data(),
+                                                                                    &depth_image_descriptor,
+                                                                                    color_images[i],
+                                                                                    &color_image_descriptors[i],
+                                                                                    transformed_images[i].data(),
+                                                                                    &transformed_color_image_descriptor,
+                                                                                    interpolation_type),
+                      K4A_RESULT_SUCCEEDED);
+        }
+        ASSERT_EQ(transformed_images[0], transformed_images[1]);
+        ASSERT_EQ(transformed_images[0], transformed_images[2]);
+    }
+
+    // A BGRA image downscaled by 2, as an MJPEG image decoded at a reduced scale, maps to the same depth pixels
+    std::vector<uint8_t> uniform_image((size_t)(color_width * color_height), 128);
+    k4a_transformation_image_descriptor_t scaled_descriptor = { color_width / 2,
+                                                                color_height / 2,
+                                                                color_width / 2 * 4,
+                                                                K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    std::vector<uint8_t> full_transformed((size_t)(4 * depth_width * depth_height));
+    std::vector<uint8_t> scaled_transformed((size_t)(4 * depth_width * depth_height));
+    ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                         (uint8_t *)depth_image.data(),
+                                                         &depth_image_descriptor,
+                                                         bgra_image.data(),
+                                                         &color_image_descriptors[0],
+                                                         full_transformed.data(),
+                                                         &transformed_color_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                         (uint8_t *)depth_image.data(),
+                                                         &depth_image_descriptor,
+                                                         uniform_image.data(),
+                                                         &scaled_descriptor,
+                                                         scaled_transformed.data(),
+                                                         &transformed_color_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    int valid_pixels = 0;
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        const uint8_t *scaled = scaled_transformed.data() + 4 * i;
+        if (full_transformed[(size_t)(4 * i + 3)] != 0 && scaled[3] != 0)
+        {
+            valid_pixels++;
+            ASSERT_EQ(scaled[0], 128);
+            ASSERT_EQ(scaled[2], 128);
+        }
+    }
+    ASSERT_GT(valid_pixels, 0);
+
+    // Padded YUV images and other downscales are rejected
+    k4a_transformation_image_descriptor_t padded_descriptor = color_image_descriptors[2];
+    padded_descriptor.stride_bytes += 64;
+    scaled_descriptor.width_pixels = color_width / 3;
+    scaled_descriptor.height_pixels = color_height / 3;
+    scaled_descriptor.stride_bytes = scaled_descriptor.width_pixels * 4;
+    for (const k4a_transformation_image_descriptor_t *descriptor : { &padded_descriptor, &scaled_descriptor })
+    {
+        ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                             (uint8_t *)depth_image.data(),
+                                                             &depth_image_descriptor,
+                                                             yuy2_image.data(),
+                                                             descriptor,
+                                                             full_transformed.data(),
+                                                             &transformed_color_image_descriptor),
+                  K4A_RESULT_FAILED);
+    }
+
+    transformation_destroy(transformation_handle);
+}
+
+struct transformation_completion_counter_t
+{
+    int succeeded;
+    int failed;
+};
+
+static void transformation_completion_callback(k4a_result_t result, void *context)
+{
+    transformation_completion_counter_t *counter = (transformation_completion_counter_t *)context;
+    if (K4A_SUCCEEDED(result))
+    {
+        counter->succeeded++;
+    }
+    else
+    {
+        counter->failed++;
+    }
+}
+
+TEST_F(transformation_ut, transformation_submit)
+{
+    k4a_transformation_t transformation_handle = transformation_create(&m_calibration, false);
+    ASSERT_NE(transformation_handle, (k4a_transformation_t)NULL);
+
+    int depth_width = m_calibration.depth_camera_calibration.resolution_width;
+    int depth_height = m_calibration.depth_camera_calibration.resolution_height;
+    int color_width = m_calibration.color_camera_calibration.resolution_width;
+    int color_height = m_calibration.color_camera_calibration.resolution_height;
+
+    k4a_image_t depth_image = NULL;
+    k4a_image_t color_image = NULL;
+    k4a_image_t transformed_depth_image = NULL;
+    k4a_image_t transformed_color_image = NULL;
+    k4a_image_t xyz_image = NULL;
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                           depth_width,
+                           depth_height,
+                           depth_width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &depth_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                           color_width,
+                           color_height,
+                           color_width * 4 * (int)sizeof(uint8_t),
+                           ALLOCATION_SOURCE_USER,
+                           &color_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                           color_width,
+                           color_height,
+                           color_width * (int)sizeof(uint16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &transformed_depth_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                           depth_width,
+                           depth_height,
+                           depth_width * 4 * (int)sizeof(uint8_t),
+                           ALLOCATION_SOURCE_USER,
+                           &transformed_color_image),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(image_create(K4A_IMAGE_FORMAT_CUSTOM,
+                           depth_width,
+                           depth_height,
+                           depth_width * 3 * (int)sizeof(int16_t),
+                           ALLOCATION_SOURCE_USER,
+                           &xyz_image),
+              K4A_RESULT_SUCCEEDED);
+
+    uint16_t *depth_image_buffer = (uint16_t *)(void *)image_get_buffer(depth_image);
+    for (int i = 0; i < depth_width * depth_height; i++)
+    {
+        depth_image_buffer[i] = (uint16_t)(i % 7 == 0 ? 0 : 500 + i % 3000);
+    }
+    uint8_t *color_image_buffer = image_get_buffer(color_image);
+    for (size_t i = 0; i < image_get_size(color_image); i++)
+    {
+        color_image_buffer[i] = (uint8_t)(i * 31);
+    }
+
+    k4a_transformation_image_descriptor_t depth_image_descriptor = { depth_width,
+                                                                     depth_height,
+                                                                     depth_width * (int)sizeof(uint16_t),
+                                                                     K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t color_image_descriptor = { color_width,
+                                                                     color_height,
+                                                                     color_width * 4 * (int)sizeof(uint8_t),
+                                                                     K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t transformed_depth_image_descriptor = { color_width,
+                                                                                 color_height,
+                                                                                 color_width * (int)sizeof(uint16_t),
+                                                                                 K4A_IMAGE_FORMAT_DEPTH16 };
+    k4a_transformation_image_descriptor_t transformed_color_image_descriptor = { depth_width,
+                                                                                 depth_height,
+                                                                                 depth_width * 4 *
+                                                                                     (int)sizeof(uint8_t),
+                                                                                 K4A_IMAGE_FORMAT_COLOR_BGRA32 };
+    k4a_transformation_image_descriptor_t xyz_image_descriptor = { depth_width,
+                                                                   depth_height,
+                                                                   depth_width * 3 * (int)sizeof(int16_t),
+                                                                   K4A_IMAGE_FORMAT_CUSTOM };
+    k4a_transformation_image_descriptor_t dummy_descriptor = { 0, 0, 0, K4A_IMAGE_FORMAT_CUSTOM };
+
+    // Reference from the synchronous functions
+    std::vector<uint8_t> reference_depth_image(image_get_size(transformed_depth_image));
+    std::vector<uint8_t> reference_color_image(image_get_size(transformed_color_image));
+    std::vector<uint8_t> reference_xyz_image(image_get_size(xyz_image));
+    ASSERT_EQ(transformation_depth_image_to_color_camera_custom(transformation_handle,
+                                                                (uint8_t *)depth_image_buffer,
+                                                                &depth_image_descriptor,
+                                                                NULL,
+                                                                &dummy_descriptor,
+                                                                reference_depth_image.data(),
+                                                                &transformed_depth_image_descriptor,
+                                                                NULL,
+                                                                &dummy_descriptor,
+                                                                K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                0),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_color_image_to_depth_camera(transformation_handle,
+                                                         (uint8_t *)depth_image_buffer,
+                                                         &depth_image_descriptor,
+                                                         color_image_buffer,
+                                                         &color_image_descriptor,
+                                                         reference_color_image.data(),
+                                                         &transformed_color_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_depth_image_to_point_cloud(transformation_handle,
+                                                        (uint8_t *)depth_image_buffer,
+                                                        &depth_image_descriptor,
+                                                        K4A_CALIBRATION_TYPE_DEPTH,
+                                                        reference_xyz_image.data(),
+                                                        &xyz_image_descriptor),
+              K4A_RESULT_SUCCEEDED);
+
+    k4a_transformation_job_t jobs[3];
+    memset(jobs, 0, sizeof(jobs));
+    jobs[0].type = K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_COLOR;
+    jobs[0].depth_image = depth_image;
+    jobs[0].transformed_image = transformed_depth_image;
+    jobs[1].type = K4A_TRANSFORMATION_JOB_TYPE_COLOR_TO_DEPTH;
+    jobs[1].depth_image = depth_image;
+    jobs[1].source_image = color_image;
+    jobs[1].transformed_image = transformed_color_image;
+    jobs[1].interpolation_type = K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR;
+    jobs[2].type = K4A_TRANSFORMATION_JOB_TYPE_DEPTH_TO_POINT_CLOUD;
+    jobs[2].depth_image = depth_image;
+    jobs[2].transformed_image = xyz_image;
+    jobs[2].camera = K4A_CALIBRATION_TYPE_DEPTH;
+    jobs[2].point_cloud_format = K4A_TRANSFORMATION_POINT_CLOUD_FORMAT_INT16_MILLIMETERS;
+
+    transformation_completion_counter_t counter = { 0, 0 };
+    ASSERT_EQ(transformation_wait_idle(transformation_handle, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_submit(transformation_handle, jobs, 3, transformation_completion_callback, &counter),
+              K4A_RESULT_SUCCEEDED);
+    // A job with a point cloud image of the wrong size fails without affecting the other submissions
+    k4a_transformation_job_t failing_job = jobs[2];
+    failing_job.transformed_image = transformed_depth_image;
+    ASSERT_EQ(transformation_submit(
+                  transformation_handle, &failing_job, 1, transformation_completion_callback, &counter),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_submit(transformation_handle, jobs, 1, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(transformation_wait_idle(transformation_handle, K4A_WAIT_INFINITE), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(counter.succeeded, 1);
+    ASSERT_EQ(counter.failed, 1);
+
+    ASSERT_EQ(memcmp(image_get_buffer(transformed_depth_image),
+                     reference_depth_image.data(),
+                     reference_depth_image.size()),
+              0);
+    ASSERT_EQ(memcmp(image_get_buffer(transformed_color_image),
+                     reference_color_image.data(),
+                     reference_color_image.size()),
+              0);
+    ASSERT_EQ(memcmp(image_get_buffer(xyz_image), reference_xyz_image.data(), reference_xyz_image.size()), 0);
+
+    // Submissions that are missing images are rejected without calling the callback
+    k4a_transformation_job_t incomplete_job = jobs[1];
+    incomplete_job.source_image = NULL;
+    ASSERT_EQ(transformation_submit(
+                  transformation_handle, &incomplete_job, 1, transformation_completion_callback, &counter),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_submit(transformation_handle, jobs, 0, transformation_completion_callback, &counter),
+              K4A_RESULT_FAILED);
+    ASSERT_EQ(transformation_submit(transformation_handle, NULL, 1, transformation_completion_callback, &counter),
+              K4A_RESULT_FAILED);
+
+    // The worker thread keeps the images of pending jobs alive, and destroying the handle completes them
+    ASSERT_EQ(transformation_submit(transformation_handle, jobs, 3, transformation_completion_callback, &counter),
+              K4A_RESULT_SUCCEEDED);
+    image_dec_ref(depth_image);
+    image_dec_ref(color_image);
+    image_dec_ref(transformed_depth_image);
+    image_dec_ref(transformed_color_image);
+    image_dec_ref(xyz_image);
+    transformation_destroy(transformation_handle);
+    ASSERT_EQ(counter.succeeded, 2);
+    ASSERT_EQ(counter.failed, 1);
+}
+
 int main(int argc, char **argv)
 {
     return k4a_test_common_main(argc, argv);
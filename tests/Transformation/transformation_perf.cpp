@@ -0,0 +1,432 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <ut_calibration_data.h>
+
+#include <k4a/k4a.h>
+#include <k4arecord/playback.h>
+
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Measures the throughput of the transformation functions for every depth mode and color resolution.  The
+// calibration is the one the unit tests use, or the one stored in a recording passed with --recording, so the
+// test runs without a device.  Results are printed and appended to transformation_perf_results.csv.
+
+extern "C" const char *transformation_get_instruction_type();
+
+static int g_iterations = 10;
+static const char *g_recording_path = NULL;
+static std::vector<char> g_raw_calibration;
+
+using ::testing::ValuesIn;
+
+struct transformation_parameters
+{
+    int test_number;
+    k4a_depth_mode_t depth_mode;
+    k4a_color_resolution_t color_resolution;
+
+    friend std::ostream &operator<<(std::ostream &os, const transformation_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class transformation_perf : public ::testing::Test, public ::testing::WithParamInterface<transformation_parameters>
+{
+public:
+    virtual void SetUp()
+    {
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("transformation_perf_results.csv", "a")));
+    }
+
+    virtual void TearDown()
+    {
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    void print_and_log(const char *kernel, size_t output_pixels, double average_ms);
+
+    FILE *m_file_handle;
+};
+
+static const char *get_string_from_depth_mode(k4a_depth_mode_t mode)
+{
+    switch (mode)
+    {
+    case K4A_DEPTH_MODE_NFOV_2X2BINNED:
+        return "K4A_DEPTH_MODE_NFOV_2X2BINNED";
+    case K4A_DEPTH_MODE_NFOV_UNBINNED:
+        return "K4A_DEPTH_MODE_NFOV_UNBINNED";
+    case K4A_DEPTH_MODE_WFOV_2X2BINNED:
+        return "K4A_DEPTH_MODE_WFOV_2X2BINNED";
+    case K4A_DEPTH_MODE_WFOV_UNBINNED:
+        return "K4A_DEPTH_MODE_WFOV_UNBINNED";
+    default:
+        break;
+    }
+    return "Unknown depth mode";
+}
+
+static const char *get_string_from_color_resolution(k4a_color_resolution_t resolution)
+{
+    switch (resolution)
+    {
+    case K4A_COLOR_RESOLUTION_720P:
+        return "K4A_COLOR_RESOLUTION_720P";
+    case K4A_COLOR_RESOLUTION_1080P:
+        return "K4A_COLOR_RESOLUTION_1080P";
+    case K4A_COLOR_RESOLUTION_1440P:
+        return "K4A_COLOR_RESOLUTION_1440P";
+    case K4A_COLOR_RESOLUTION_1536P:
+        return "K4A_COLOR_RESOLUTION_1536P";
+    case K4A_COLOR_RESOLUTION_2160P:
+        return "K4A_COLOR_RESOLUTION_2160P";
+    case K4A_COLOR_RESOLUTION_3072P:
+        return "K4A_COLOR_RESOLUTION_3072P";
+    default:
+        break;
+    }
+    return "Unknown color resolution";
+}
+
+void transformation_perf::print_and_log(const char *kernel, size_t output_pixels, double average_ms)
+{
+    const transformation_parameters &params = GetParam();
+    const char *instruction_type = transformation_get_instruction_type();
+    double mpixels_per_second = average_ms > 0 ? (double)output_pixels / (average_ms * 1000.0) : 0;
+
+    printf("    %-40s %8.3f ms %10.2f Mpixel/s\n", kernel, average_ms, mpixels_per_second);
+
+    if (m_file_handle)
+    {
+        fprintf(m_file_handle,
+                "%s,%s,%s,%s,%zu,%d,%f,%f\n",
+                instruction_type[0] ? instruction_type : "Unknown",
+                get_string_from_depth_mode(params.depth_mode),
+                get_string_from_color_resolution(params.color_resolution),
+                kernel,
+                output_pixels,
+                g_iterations,
+                average_ms,
+                mpixels_per_second);
+    }
+}
+
+// Runs fn once to warm up caches and lookup tables, then g_iterations times, and returns the average in ms
+template<typename F> static double time_kernel(F fn)
+{
+    if (fn() != K4A_RESULT_SUCCEEDED)
+    {
+        return -1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < g_iterations; i++)
+    {
+        if (fn() != K4A_RESULT_SUCCEEDED)
+        {
+            return -1;
+        }
+    }
+    auto duration = std::chrono::high_resolution_clock::now() - start;
+
+    return std::chrono::duration<double, std::milli>(duration).count() / g_iterations;
+}
+
+TEST_P(transformation_perf, testTest)
+{
+    const transformation_parameters &params = GetParam();
+
+    k4a_calibration_t calibration;
+    if (g_raw_calibration.empty())
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_calibration_get_from_raw(g_test_json,
+                                               sizeof(g_test_json),
+                                               params.depth_mode,
+                                               params.color_resolution,
+                                               &calibration));
+    }
+    else
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_calibration_get_from_raw(g_raw_calibration.data(),
+                                               g_raw_calibration.size(),
+                                               params.depth_mode,
+                                               params.color_resolution,
+                                               &calibration));
+    }
+
+    k4a_transformation_t transformation = k4a_transformation_create(&calibration);
+    ASSERT_NE(transformation, (k4a_transformation_t)NULL);
+
+    const int depth_width = calibration.depth_camera_calibration.resolution_width;
+    const int depth_height = calibration.depth_camera_calibration.resolution_height;
+    const int color_width = calibration.color_camera_calibration.resolution_width;
+    const int color_height = calibration.color_camera_calibration.resolution_height;
+    const size_t depth_pixels = (size_t)depth_width * (size_t)depth_height;
+    const size_t color_pixels = (size_t)color_width * (size_t)color_height;
+
+    printf("%s, %s (%dx%d depth, %dx%d color), instruction type %s, %d iterations\n",
+           get_string_from_depth_mode(params.depth_mode),
+           get_string_from_color_resolution(params.color_resolution),
+           depth_width,
+           depth_height,
+           color_width,
+           color_height,
+           transformation_get_instruction_type(),
+           g_iterations);
+
+    k4a_image_t depth_image = NULL;
+    k4a_image_t custom_image = NULL;
+    k4a_image_t color_image = NULL;
+    k4a_image_t transformed_depth_image = NULL;
+    k4a_image_t transformed_custom_image = NULL;
+    k4a_image_t transformed_color_image = NULL;
+    k4a_image_t xyz_image = NULL;
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                               depth_width,
+                               depth_height,
+                               depth_width * (int)sizeof(uint16_t),
+                               &depth_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM16,
+                               depth_width,
+                               depth_height,
+                               depth_width * (int)sizeof(uint16_t),
+                               &custom_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                               color_width,
+                               color_height,
+                               color_width * 4,
+                               &color_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                               color_width,
+                               color_height,
+                               color_width * (int)sizeof(uint16_t),
+                               &transformed_depth_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM16,
+                               color_width,
+                               color_height,
+                               color_width * (int)sizeof(uint16_t),
+                               &transformed_custom_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                               depth_width,
+                               depth_height,
+                               depth_width * 4,
+                               &transformed_color_image));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(K4A_IMAGE_FORMAT_CUSTOM,
+                               depth_width,
+                               depth_height,
+                               depth_width * 3 * (int)sizeof(int16_t),
+                               &xyz_image));
+
+    // A slanted plane 1-3m away with some invalid pixels, so every kernel does real work on most pixels
+    uint16_t *depth_data = (uint16_t *)(void *)k4a_image_get_buffer(depth_image);
+    uint16_t *custom_data = (uint16_t *)(void *)k4a_image_get_buffer(custom_image);
+    for (int y = 0; y < depth_height; y++)
+    {
+        for (int x = 0; x < depth_width; x++)
+        {
+            size_t i = (size_t)(y * depth_width + x);
+            depth_data[i] = (uint16_t)(i % 17 == 0 ? 0 : 1000 + (2000 * (x + y)) / (depth_width + depth_height));
+            custom_data[i] = (uint16_t)(i * 7);
+        }
+    }
+    memset(k4a_image_get_buffer(color_image), 0x80, color_pixels * 4);
+
+    double depth_to_color_ms = time_kernel([&]() {
+        return k4a_transformation_depth_image_to_color_camera(transformation, depth_image, transformed_depth_image);
+    });
+    double depth_to_color_custom_ms = time_kernel([&]() {
+        return k4a_transformation_depth_image_to_color_camera_custom(transformation,
+                                                                     depth_image,
+                                                                     custom_image,
+                                                                     transformed_depth_image,
+                                                                     transformed_custom_image,
+                                                                     K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR,
+                                                                     0);
+    });
+    double color_to_depth_ms = time_kernel([&]() {
+        return k4a_transformation_color_image_to_depth_camera(transformation,
+                                                               depth_image,
+                                                               color_image,
+                                                               transformed_color_image);
+    });
+    double point_cloud_ms = time_kernel([&]() {
+        return k4a_transformation_depth_image_to_point_cloud(transformation,
+                                                             depth_image,
+                                                             K4A_CALIBRATION_TYPE_DEPTH,
+                                                             xyz_image);
+    });
+
+    EXPECT_GE(depth_to_color_ms, 0);
+    EXPECT_GE(depth_to_color_custom_ms, 0);
+    EXPECT_GE(color_to_depth_ms, 0);
+    EXPECT_GE(point_cloud_ms, 0);
+
+    // Throughput is measured in output pixels
+    print_and_log("depth_image_to_color_camera", color_pixels, depth_to_color_ms);
+    print_and_log("depth_image_to_color_camera_custom", color_pixels, depth_to_color_custom_ms);
+    print_and_log("color_image_to_depth_camera", depth_pixels, color_to_depth_ms);
+    print_and_log("depth_image_to_point_cloud", depth_pixels, point_cloud_ms);
+
+    k4a_image_release(depth_image);
+    k4a_image_release(custom_image);
+    k4a_image_release(color_image);
+    k4a_image_release(transformed_depth_image);
+    k4a_image_release(transformed_custom_image);
+    k4a_image_release(transformed_color_image);
+    k4a_image_release(xyz_image);
+    k4a_transformation_destroy(transformation);
+}
+
+static struct transformation_parameters tests[] = {
+    { 0, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_720P },
+    { 1, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1080P },
+    { 2, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1440P },
+    { 3, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1536P },
+    { 4, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_2160P },
+    { 5, K4A_DEPTH_MODE_NFOV_2X2BINNED, K4A_COLOR_RESOLUTION_3072P },
+    { 6, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_720P },
+    { 7, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1080P },
+    { 8, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1440P },
+    { 9, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_1536P },
+    { 10, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_2160P },
+    { 11, K4A_DEPTH_MODE_NFOV_UNBINNED, K4A_COLOR_RESOLUTION_3072P },
+    { 12, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_720P },
+    { 13, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1080P },
+    { 14, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1440P },
+    { 15, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_1536P },
+    { 16, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_2160P },
+    { 17, K4A_DEPTH_MODE_WFOV_2X2BINNED, K4A_COLOR_RESOLUTION_3072P },
+    { 18, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_720P },
+    { 19, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1080P },
+    { 20, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1440P },
+    { 21, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_1536P },
+    { 22, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_2160P },
+    { 23, K4A_DEPTH_MODE_WFOV_UNBINNED, K4A_COLOR_RESOLUTION_3072P },
+};
+
+INSTANTIATE_TEST_CASE_P(TRANSFORMATION_TESTS, transformation_perf, ValuesIn(tests));
+
+static bool load_calibration_from_recording(const char *path)
+{
+    k4a_playback_t playback = NULL;
+    if (K4A_RESULT_SUCCEEDED != k4a_playback_open(path, &playback))
+    {
+        printf("Error: failed to open recording %s\n", path);
+        return false;
+    }
+
+    size_t size = 0;
+    bool succeeded = false;
+    if (K4A_BUFFER_RESULT_TOO_SMALL == k4a_playback_get_raw_calibration(playback, NULL, &size))
+    {
+        g_raw_calibration.resize(size);
+        succeeded = K4A_BUFFER_RESULT_SUCCEEDED ==
+                    k4a_playback_get_raw_calibration(playback, (uint8_t *)g_raw_calibration.data(), &size);
+    }
+
+    if (!succeeded)
+    {
+        printf("Error: recording %s does not contain a calibration\n", path);
+        g_raw_calibration.clear();
+    }
+
+    k4a_playback_close(playback);
+    return succeeded;
+}
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+        if (strcmp(argument, "--iterations") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_iterations = (int)strtol(argv[i + 1], NULL, 10);
+                printf("g_iterations = %d\n", g_iterations);
+                i++;
+            }
+            else
+            {
+                printf("Error: iterations parameter missing\n");
+                error = true;
+            }
+        }
+        else if (strcmp(argument, "--recording") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_recording_path = argv[i + 1];
+                printf("g_recording_path = %s\n", g_recording_path);
+                i++;
+            }
+            else
+            {
+                printf("Error: recording parameter missing\n");
+                error = true;
+            }
+        }
+
+        if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+            (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (g_iterations <= 0)
+    {
+        printf("Error: iterations must be positive\n");
+        error = true;
+    }
+
+    if (!error && g_recording_path != NULL && !load_calibration_from_recording(g_recording_path))
+    {
+        error = true;
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --iterations <count>\n");
+        printf("      The number of times each transformation is timed; default is 10\n");
+        printf("  --recording <path>\n");
+        printf("      Use the calibration stored in a recording instead of the built-in test calibration.\n");
+
+        return 1; // Indicates an error or warning
+    }
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
@@ -107,6 +107,21 @@ TEST(allocator_ut, allocator_api_validation)
         ASSERT_EQ(50.0f, capture_get_temperature_c(capture_c));
     }
 
+    {
+        ASSERT_EQ(0u, capture_get_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_DEPTH_ENGINE));
+        capture_set_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_DEPTH_ENGINE, 1000);
+        capture_set_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_CAPTURE_SYNC, 2000);
+        capture_set_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_NUM, 3000);
+        capture_set_latency_timestamp_nsec(NULL, K4A_LATENCY_STAGE_USER, 4000);
+
+        ASSERT_EQ(0u, capture_get_latency_timestamp_nsec(NULL, K4A_LATENCY_STAGE_DEPTH_ENGINE));
+        ASSERT_EQ(0u, capture_get_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_NUM));
+        ASSERT_EQ(0u, capture_get_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_DEPTH_QUEUE));
+        ASSERT_EQ(1000u, capture_get_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_DEPTH_ENGINE));
+        ASSERT_EQ(2000u, capture_get_latency_timestamp_nsec(capture_d, K4A_LATENCY_STAGE_CAPTURE_SYNC));
+        ASSERT_EQ(0u, capture_get_latency_timestamp_nsec(capture_c, K4A_LATENCY_STAGE_CAPTURE_SYNC));
+    }
+
     {
         k4a_image_t image;
 
@@ -522,6 +537,546 @@ TEST(allocator_ut, image_api_validation)
     ASSERT_EQ(allocator_test_for_leaks(), 0);
 }
 
+static void image_count_free_function(void *buffer, void *context)
+{
+    (void)buffer;
+    (*(int *)context)++;
+}
+
+TEST(allocator_ut, image_create_empty_from_buffer)
+{
+    uint8_t buffer[128];
+    k4a_image_t image = NULL;
+    int free_count = 0;
+
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_empty_from_buffer(NULL, sizeof(buffer), image_count_free_function, &free_count, &image));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_empty_from_buffer(buffer, 0, image_count_free_function, &free_count, &image));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_empty_from_buffer(buffer, sizeof(buffer), image_count_free_function, &free_count, NULL));
+    ASSERT_EQ(0, free_count);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              image_create_empty_from_buffer(buffer, sizeof(buffer), image_count_free_function, &free_count, &image));
+    ASSERT_EQ(buffer, image_get_buffer(image));
+    ASSERT_EQ(sizeof(buffer), image_get_size(image));
+
+    // The buffer is handed back to its owner only when the last reference is released
+    image_inc_ref(image);
+    image_dec_ref(image);
+    ASSERT_EQ(0, free_count);
+    image_dec_ref(image);
+    ASSERT_EQ(1, free_count);
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+typedef struct _deferred_decode_data_t
+{
+    int decode_count;
+    k4a_result_t result;
+} deferred_decode_data_t;
+
+static k4a_result_t image_fill_decode_function(k4a_image_t image,
+                                               const uint8_t *payload,
+                                               size_t payload_size,
+                                               uint8_t *buffer,
+                                               size_t buffer_size,
+                                               void *context)
+{
+    deferred_decode_data_t *data = (deferred_decode_data_t *)context;
+    EXPECT_EQ(buffer_size, image_get_size(image));
+    EXPECT_GT(payload_size, 0u);
+    memset(buffer, payload[0], buffer_size);
+    data->decode_count++;
+    return data->result;
+}
+
+TEST(allocator_ut, image_create_deferred)
+{
+    uint8_t payload[16] = { 0x5a };
+    k4a_image_t image = NULL;
+    int free_count = 0;
+    deferred_decode_data_t data = { 0, K4A_RESULT_SUCCEEDED };
+
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    32,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    NULL,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    image_fill_decode_function,
+                                    &data,
+                                    &image));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    32,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    payload,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    NULL,
+                                    &data,
+                                    &image));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    0,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    payload,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    image_fill_decode_function,
+                                    &data,
+                                    &image));
+    ASSERT_EQ(0, free_count);
+
+    // An image released without its buffer being accessed is never decoded
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    32,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    payload,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    image_fill_decode_function,
+                                    &data,
+                                    &image));
+    ASSERT_EQ((size_t)(4 * 32), image_get_size(image));
+    image_dec_ref(image);
+    ASSERT_EQ(1, free_count);
+    ASSERT_EQ(0, data.decode_count);
+
+    // The first access decodes and frees the payload, later accesses return the same buffer
+    free_count = 0;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    32,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    payload,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    image_fill_decode_function,
+                                    &data,
+                                    &image));
+    uint8_t *buffer = image_get_buffer(image);
+    ASSERT_NE((uint8_t *)NULL, buffer);
+    ASSERT_EQ(1, data.decode_count);
+    ASSERT_EQ(1, free_count);
+    for (size_t i = 0; i < image_get_size(image); i++)
+    {
+        ASSERT_EQ(payload[0], buffer[i]);
+    }
+    ASSERT_EQ(buffer, image_get_buffer(image));
+    ASSERT_EQ(1, data.decode_count);
+    image_dec_ref(image);
+    ASSERT_EQ(1, free_count);
+
+    // A failed decode returns no buffer and is not retried
+    free_count = 0;
+    data.decode_count = 0;
+    data.result = K4A_RESULT_FAILED;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              image_create_deferred(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                    8,
+                                    4,
+                                    32,
+                                    ALLOCATION_SOURCE_COLOR,
+                                    payload,
+                                    sizeof(payload),
+                                    image_count_free_function,
+                                    &free_count,
+                                    image_fill_decode_function,
+                                    &data,
+                                    &image));
+    ASSERT_EQ((uint8_t *)NULL, image_get_buffer(image));
+    ASSERT_EQ((uint8_t *)NULL, image_get_buffer(image));
+    ASSERT_EQ(1, data.decode_count);
+    ASSERT_EQ(1, free_count);
+    image_dec_ref(image);
+    ASSERT_EQ(1, free_count);
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+static int g_pooling_alloc_count = 0;
+static int g_pooling_free_count = 0;
+
+static uint8_t *pooling_count_alloc(int size, void **context)
+{
+    *context = NULL;
+    g_pooling_alloc_count++;
+    return (uint8_t *)malloc((size_t)size);
+}
+
+static void pooling_count_free(void *buffer, void *context)
+{
+    (void)context;
+    g_pooling_free_count++;
+    free(buffer);
+}
+
+TEST(allocator_ut, allocator_pooling)
+{
+    uint8_t *buffer[3];
+
+    g_pooling_alloc_count = 0;
+    g_pooling_free_count = 0;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(pooling_count_alloc, pooling_count_free));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_set_pooling(ALLOCATOR_MAX_POOLED_BUFFERS + 1));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(2));
+
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_NE((uint8_t *)NULL, buffer[i] = allocator_alloc(ALLOCATION_SOURCE_DEPTH, 1024));
+    }
+    ASSERT_EQ(3, g_pooling_alloc_count);
+
+    // Only the high water mark worth of buffers is kept
+    for (int i = 0; i < 3; i++)
+    {
+        allocator_free(buffer[i]);
+    }
+    ASSERT_EQ(1, g_pooling_free_count);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+
+    // Same source and size is served from the pool, most recently freed first
+    ASSERT_EQ(buffer[1], allocator_alloc(ALLOCATION_SOURCE_DEPTH, 1024));
+    ASSERT_EQ(buffer[0], allocator_alloc(ALLOCATION_SOURCE_DEPTH, 1024));
+    ASSERT_EQ(3, g_pooling_alloc_count);
+    allocator_free(buffer[1]);
+
+    // Other sources and sizes go to the heap
+    uint8_t *color_buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, 1024);
+    ASSERT_NE((uint8_t *)NULL, color_buffer);
+    ASSERT_EQ(4, g_pooling_alloc_count);
+    uint8_t *large_buffer = allocator_alloc(ALLOCATION_SOURCE_DEPTH, 2048);
+    ASSERT_NE((uint8_t *)NULL, large_buffer);
+    ASSERT_EQ(5, g_pooling_alloc_count);
+    allocator_free(color_buffer);
+    allocator_free(buffer[0]);
+    ASSERT_EQ(1, g_pooling_free_count);
+
+    // A new size class for a source releases the buffers pooled for the old size
+    allocator_free(large_buffer);
+    ASSERT_EQ(3, g_pooling_free_count);
+
+    // Disabling pooling releases everything that is pooled
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(0));
+    ASSERT_EQ(5, g_pooling_free_count);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(allocator_ut, allocator_pool_reserve)
+{
+    uint8_t *buffer[2];
+
+    g_pooling_alloc_count = 0;
+    g_pooling_free_count = 0;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(pooling_count_alloc, pooling_count_free));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(0));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_pool_reserve(ALLOCATION_SOURCE_COLOR, 1024, 0));
+
+    // The reserved buffers are allocated up front and pooled without a pooling limit
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_pool_reserve(ALLOCATION_SOURCE_COLOR, 1024, 2));
+    ASSERT_EQ(2, g_pooling_alloc_count);
+    ASSERT_EQ(0, g_pooling_free_count);
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_NE((uint8_t *)NULL, buffer[i] = allocator_alloc(ALLOCATION_SOURCE_COLOR, 1024));
+    }
+    ASSERT_EQ(2, g_pooling_alloc_count);
+    for (int i = 0; i < 2; i++)
+    {
+        allocator_free(buffer[i]);
+    }
+    ASSERT_EQ(0, g_pooling_free_count);
+
+    // The reserved pool keeps its size class
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_pool_reserve(ALLOCATION_SOURCE_COLOR, 2048, 1));
+    uint8_t *large_buffer = allocator_alloc(ALLOCATION_SOURCE_COLOR, 2048);
+    ASSERT_NE((uint8_t *)NULL, large_buffer);
+    ASSERT_EQ(3, g_pooling_alloc_count);
+    allocator_free(large_buffer);
+    ASSERT_EQ(1, g_pooling_free_count);
+    ASSERT_EQ(buffer[1], allocator_alloc(ALLOCATION_SOURCE_COLOR, 1024));
+    allocator_free(buffer[1]);
+
+    // Releasing the reservation releases the pooled buffers
+    allocator_pool_unreserve(ALLOCATION_SOURCE_COLOR, 2);
+    ASSERT_EQ(3, g_pooling_free_count);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(allocator_ut, capture_recycle)
+{
+    g_pooling_alloc_count = 0;
+    g_pooling_free_count = 0;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(pooling_count_alloc, pooling_count_free));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(0));
+
+    // A recycled capture keeps the buffer of its image without pooling
+    k4a_capture_t capture = capture_manufacture(1024, true);
+    ASSERT_NE(capture, (k4a_capture_t)NULL);
+    k4a_image_t image = capture_get_depth_image(capture);
+    uint8_t *buffer = image_get_buffer(image);
+    image_dec_ref(image);
+    capture_recycle(capture);
+    ASSERT_EQ(1, g_pooling_alloc_count);
+    ASSERT_EQ(0, g_pooling_free_count);
+
+    // The next capture of the same size takes it, and releasing it without recycling frees it
+    capture = capture_manufacture(1024, true);
+    ASSERT_NE(capture, (k4a_capture_t)NULL);
+    image = capture_get_depth_image(capture);
+    ASSERT_EQ(buffer, image_get_buffer(image));
+    image_dec_ref(image);
+    ASSERT_EQ(1, g_pooling_alloc_count);
+    capture_dec_ref(capture);
+    ASSERT_EQ(1, g_pooling_free_count);
+
+    // Only the last reference recycles
+    capture = capture_manufacture(1024, true);
+    ASSERT_NE(capture, (k4a_capture_t)NULL);
+    ASSERT_EQ(2, g_pooling_alloc_count);
+    capture_inc_ref(capture);
+    capture_recycle(capture);
+    capture_dec_ref(capture);
+    ASSERT_EQ(2, g_pooling_free_count);
+
+    // Recycling is limited per source
+    k4a_capture_t captures[ALLOCATOR_RECYCLED_BUFFERS + 1];
+    for (int i = 0; i < ALLOCATOR_RECYCLED_BUFFERS + 1; i++)
+    {
+        ASSERT_NE(captures[i] = capture_manufacture(1024, true), (k4a_capture_t)NULL);
+    }
+    for (int i = 0; i < ALLOCATOR_RECYCLED_BUFFERS + 1; i++)
+    {
+        capture_recycle(captures[i]);
+    }
+    ASSERT_EQ(3, g_pooling_free_count);
+
+    // Setting the allocator releases the recycled buffers
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_EQ(g_pooling_alloc_count, g_pooling_free_count);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(allocator_ut, allocator_budget_count)
+{
+    // Without a budget the default count is used
+    ASSERT_EQ(0u, allocator_get_memory_budget());
+    ASSERT_EQ(10u, allocator_budget_count(MEMORY_BUDGET_CAPTURES, 1024, 1, 10));
+
+    // Each share is a part of the budget, limited by the minimum and default counts
+    allocator_set_memory_budget(8 * 1024);
+    ASSERT_EQ((size_t)(8 * 1024), allocator_get_memory_budget());
+    ASSERT_EQ(4u, allocator_budget_count(MEMORY_BUDGET_CAPTURES, 1024, 1, 10));
+    ASSERT_EQ(4u, allocator_budget_count(MEMORY_BUDGET_RECORDING, 1024, 1, 10));
+    ASSERT_EQ(2u, allocator_budget_count(MEMORY_BUDGET_USB_TRANSFERS, 1024, 1, 10));
+    ASSERT_EQ(2u, allocator_budget_count(MEMORY_BUDGET_PLAYBACK_CACHE, 1024, 1, 10));
+    ASSERT_EQ(3u, allocator_budget_count(MEMORY_BUDGET_CAPTURES, 1024, 1, 3));
+    ASSERT_EQ(5u, allocator_budget_count(MEMORY_BUDGET_CAPTURES, 1024, 5, 10));
+    ASSERT_EQ(1u, allocator_budget_count(MEMORY_BUDGET_CAPTURES, 1024 * 1024, 1, 10));
+
+    allocator_set_memory_budget(0);
+}
+
+// Allocator that returns buffers one byte off any useful alignment
+static uint8_t *misaligned_alloc(int size, void **context)
+{
+    uint8_t *buffer = (uint8_t *)malloc((size_t)size + 1);
+    *context = buffer;
+    return buffer == NULL ? NULL : buffer + 1;
+}
+
+static void misaligned_free(void *buffer, void *context)
+{
+    ASSERT_EQ((uint8_t *)context + 1, (uint8_t *)buffer);
+    free(context);
+}
+
+TEST(allocator_ut, allocator_alignment)
+{
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(misaligned_alloc, misaligned_free));
+
+    for (size_t size = 1; size < 200; size += 13)
+    {
+        uint8_t *buffer = allocator_alloc(ALLOCATION_SOURCE_DEPTH, size);
+        ASSERT_NE((uint8_t *)NULL, buffer);
+        ASSERT_EQ(0u, (uintptr_t)buffer % ALLOCATOR_ALIGNMENT);
+
+        // The size is padded to the alignment
+        memset(buffer, 0xEE, ALLOCATOR_ALIGN_UP(size));
+        allocator_free(buffer);
+    }
+
+    // Default strides are only padded when requested
+    k4a_image_t image;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create(K4A_IMAGE_FORMAT_DEPTH16, 10, 4, 0, ALLOCATION_SOURCE_USER, &image));
+    ASSERT_EQ(0u, (uintptr_t)image_get_buffer(image) % ALLOCATOR_ALIGNMENT);
+    ASSERT_EQ(20, image_get_stride_bytes(image));
+    image_dec_ref(image);
+
+    image_set_row_padding(true);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create(K4A_IMAGE_FORMAT_DEPTH16, 10, 4, 0, ALLOCATION_SOURCE_USER, &image));
+    ASSERT_EQ(ALLOCATOR_ALIGNMENT, image_get_stride_bytes(image));
+    ASSERT_EQ((size_t)(4 * ALLOCATOR_ALIGNMENT), image_get_size(image));
+    image_dec_ref(image);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create(K4A_IMAGE_FORMAT_DEPTH16, 10, 4, 24, ALLOCATION_SOURCE_USER, &image));
+    ASSERT_EQ(24, image_get_stride_bytes(image));
+    image_dec_ref(image);
+    image_set_row_padding(false);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator(NULL, NULL));
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+// Records the requests of allocator_set_allocator_ex() and returns buffers offset by misalignment from the alignment
+typedef struct
+{
+    k4a_allocation_info_t last_info;
+    size_t misalignment;
+    int allocations;
+} allocation_recorder_t;
+
+static uint8_t *recording_alloc(const k4a_allocation_info_t *info, void *user_context, void **context)
+{
+    allocation_recorder_t *recorder = (allocation_recorder_t *)user_context;
+    recorder->last_info = *info;
+    recorder->allocations++;
+
+    uint8_t *full_buffer = (uint8_t *)malloc(info->size + 2 * info->alignment);
+    *context = full_buffer;
+    if (full_buffer == NULL)
+    {
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)full_buffer + info->alignment - 1) & ~(uintptr_t)(info->alignment - 1);
+    return (uint8_t *)aligned + recorder->misalignment;
+}
+
+static void recording_free(void *buffer, void *context)
+{
+    (void)buffer;
+    free(context);
+}
+
+TEST(allocator_ut, allocator_ex)
+{
+    allocation_recorder_t recorder = {};
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_set_allocator_ex(recording_alloc, NULL, &recorder));
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_set_allocator_ex(NULL, recording_free, &recorder));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator_ex(recording_alloc, recording_free, &recorder));
+
+    // Images pass their format, other buffers pass K4A_IMAGE_FORMAT_CUSTOM
+    k4a_image_t image;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32, 16, 4, 0, ALLOCATION_SOURCE_USER, &image));
+    ASSERT_EQ(1, recorder.allocations);
+    ASSERT_EQ(K4A_ALLOCATION_SOURCE_USER, recorder.last_info.source);
+    ASSERT_EQ(K4A_IMAGE_FORMAT_COLOR_BGRA32, recorder.last_info.format);
+    ASSERT_EQ((size_t)ALLOCATOR_ALIGNMENT, recorder.last_info.alignment);
+    ASSERT_LE((size_t)(16 * 4 * 4), recorder.last_info.size);
+    ASSERT_EQ(0u, (uintptr_t)image_get_buffer(image) % ALLOCATOR_ALIGNMENT);
+    image_dec_ref(image);
+
+    uint8_t *buffer = allocator_alloc(ALLOCATION_SOURCE_DEPTH, 100);
+    ASSERT_NE((uint8_t *)NULL, buffer);
+    ASSERT_EQ(K4A_ALLOCATION_SOURCE_DEPTH, recorder.last_info.source);
+    ASSERT_EQ(K4A_IMAGE_FORMAT_CUSTOM, recorder.last_info.format);
+    ASSERT_EQ(0u, (uintptr_t)buffer % ALLOCATOR_ALIGNMENT);
+    memset(buffer, 0xEE, ALLOCATOR_ALIGN_UP(100));
+    allocator_free(buffer);
+
+    // A buffer that ignores the requested alignment is freed and the allocation fails
+    recorder.misalignment = 8;
+    ASSERT_EQ((uint8_t *)NULL, allocator_alloc_image(ALLOCATION_SOURCE_COLOR, K4A_IMAGE_FORMAT_COLOR_NV12, 4096));
+    ASSERT_EQ(K4A_IMAGE_FORMAT_COLOR_NV12, recorder.last_info.format);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_allocator_ex(NULL, NULL, NULL));
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(allocator_ut, allocator_huge_pages)
+{
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_huge_pages(true));
+    allocator_set_thread_numa_node(0);
+
+    // Frame sized buffers are mapped, small ones come from the heap. Both must be usable whether or not the system has
+    // huge pages available.
+    const size_t frame_size = 3 * 1024 * 1024 + 17;
+    uint8_t *frame = allocator_alloc(ALLOCATION_SOURCE_DEPTH, frame_size);
+    uint8_t *small = allocator_alloc(ALLOCATION_SOURCE_DEPTH, 1024);
+    ASSERT_NE((uint8_t *)NULL, frame);
+    ASSERT_NE((uint8_t *)NULL, small);
+    memset(frame, 0xAB, frame_size);
+    memset(small, 0xCD, 1024);
+    ASSERT_EQ(0xAB, frame[frame_size - 1]);
+
+    // Buffers keep the free function of the allocator they came from
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_huge_pages(false));
+    allocator_free(frame);
+    allocator_free(small);
+
+    allocator_set_thread_numa_node(-1);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(allocator_ut, allocator_stats)
+{
+    k4a_allocator_stats_t before;
+    k4a_allocator_stats_t stats;
+
+    ASSERT_EQ(K4A_RESULT_FAILED, allocator_get_stats(NULL));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_get_stats(&before));
+
+    uint8_t *buffer1 = allocator_alloc(ALLOCATION_SOURCE_COLOR, 1000);
+    uint8_t *buffer2 = allocator_alloc(ALLOCATION_SOURCE_COLOR, 500);
+    ASSERT_NE((uint8_t *)NULL, buffer1);
+    ASSERT_NE((uint8_t *)NULL, buffer2);
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_get_stats(&stats));
+    ASSERT_EQ(before.color.live_count + 2, stats.color.live_count);
+    ASSERT_EQ(before.color.live_bytes + 1500, stats.color.live_bytes);
+    ASSERT_GE(stats.color.peak_bytes, stats.color.live_bytes);
+    ASSERT_EQ(before.color.total_allocations + 2, stats.color.total_allocations);
+    ASSERT_EQ(before.depth.total_allocations, stats.depth.total_allocations);
+
+    allocator_free(buffer1);
+    allocator_free(buffer2);
+
+    // Peak and cumulative counts persist after the buffers are freed
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_get_stats(&stats));
+    ASSERT_EQ(before.color.live_count, stats.color.live_count);
+    ASSERT_EQ(before.color.live_bytes, stats.color.live_bytes);
+    ASSERT_GE(stats.color.peak_bytes, before.color.live_bytes + 1500);
+    ASSERT_EQ(before.color.total_allocations + 2, stats.color.total_allocations);
+
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
 //
 // This test is sensitive to workload and should be a manual test.
 //
@@ -0,0 +1,356 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <gtest/gtest.h>
+
+#include <k4ainternal/broker.h>
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/image.h>
+
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+#define BUFFER_COUNT (8)
+#define BUFFER_SIZE (1024 * 1024)
+#define DEPTH_WIDTH (640)
+#define DEPTH_HEIGHT (576)
+
+class broker_ut : public ::testing::Test
+{
+protected:
+    std::string name;
+    broker_t broker = NULL;
+
+    void SetUp() override
+    {
+        // Tests running in parallel each get their own shared memory
+        name = "broker_ut_" + std::to_string(getpid());
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_create(name.c_str(), BUFFER_COUNT, BUFFER_SIZE, &broker));
+    }
+
+    void TearDown() override
+    {
+        if (broker)
+        {
+            broker_destroy(broker);
+        }
+        ASSERT_EQ(allocator_test_for_leaks(), 0);
+    }
+};
+
+// Creates a capture with a depth image filled from the timestamp, allocated like the depth reader does
+static k4a_capture_t create_depth_capture(uint64_t timestamp_usec)
+{
+    k4a_capture_t capture = NULL;
+    k4a_image_t image = NULL;
+    if (K4A_FAILED(capture_create(&capture)))
+    {
+        return NULL;
+    }
+    if (K4A_FAILED(image_create(K4A_IMAGE_FORMAT_DEPTH16,
+                                DEPTH_WIDTH,
+                                DEPTH_HEIGHT,
+                                DEPTH_WIDTH * (int)sizeof(uint16_t),
+                                ALLOCATION_SOURCE_DEPTH,
+                                &image)))
+    {
+        capture_dec_ref(capture);
+        return NULL;
+    }
+
+    uint16_t *pixels = (uint16_t *)image_get_buffer(image);
+    for (int i = 0; i < DEPTH_WIDTH * DEPTH_HEIGHT; i++)
+    {
+        pixels[i] = (uint16_t)(timestamp_usec + (uint64_t)i);
+    }
+    image_set_device_timestamp_usec(image, timestamp_usec);
+    capture_set_depth_image(capture, image);
+    capture_set_temperature_c(capture, 30.5f);
+    image_dec_ref(image);
+    return capture;
+}
+
+static bool validate_depth_capture(k4a_capture_t capture, uint64_t timestamp_usec)
+{
+    k4a_image_t image = capture_get_depth_image(capture);
+    bool valid = image != NULL && image_get_device_timestamp_usec(image) == timestamp_usec &&
+                 image_get_width_pixels(image) == DEPTH_WIDTH && image_get_height_pixels(image) == DEPTH_HEIGHT &&
+                 capture_get_temperature_c(capture) == 30.5f;
+    if (valid)
+    {
+        uint16_t *pixels = (uint16_t *)image_get_buffer(image);
+        for (int i = 0; i < DEPTH_WIDTH * DEPTH_HEIGHT && valid; i++)
+        {
+            valid = pixels[i] == (uint16_t)(timestamp_usec + (uint64_t)i);
+        }
+    }
+    if (image)
+    {
+        image_dec_ref(image);
+    }
+    return valid;
+}
+
+TEST_F(broker_ut, invalid_arguments)
+{
+    broker_t second = NULL;
+    broker_client_t client = NULL;
+
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_create(NULL, BUFFER_COUNT, BUFFER_SIZE, &second));
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_create("bad/name", BUFFER_COUNT, BUFFER_SIZE, &second));
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_create("other", 0, BUFFER_SIZE, &second));
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_create("other", BUFFER_COUNT, 1024, &second));
+
+    // Only one broker can own the allocator
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_create("other", BUFFER_COUNT, BUFFER_SIZE, &second));
+
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_attach("broker_ut_missing", &client));
+    ASSERT_EQ(K4A_RESULT_FAILED, broker_publish_capture(broker, NULL));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_attach(name.c_str(), &client));
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, broker_client_get_capture(client, &capture, 0));
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, broker_client_get_capture(client, NULL, 0));
+
+    // No calibration has been shared yet
+    char raw[BROKER_MAX_CALIBRATION_BYTES + 1];
+    size_t raw_size;
+    k4a_depth_mode_t depth_mode;
+    k4a_color_resolution_t color_resolution;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              broker_client_get_calibration(client, raw, &raw_size, &depth_mode, &color_resolution));
+    broker_detach(client);
+}
+
+TEST_F(broker_ut, calibration)
+{
+    const char calibration[] = "{\"CalibrationInformation\":{}}";
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              broker_set_calibration(broker,
+                                     (const uint8_t *)calibration,
+                                     strlen(calibration),
+                                     K4A_DEPTH_MODE_NFOV_UNBINNED,
+                                     K4A_COLOR_RESOLUTION_720P));
+
+    broker_client_t client = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_attach(name.c_str(), &client));
+
+    char raw[BROKER_MAX_CALIBRATION_BYTES + 1];
+    size_t raw_size;
+    k4a_depth_mode_t depth_mode;
+    k4a_color_resolution_t color_resolution;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              broker_client_get_calibration(client, raw, &raw_size, &depth_mode, &color_resolution));
+    ASSERT_EQ(sizeof(calibration), raw_size);
+    ASSERT_STREQ(calibration, raw);
+    ASSERT_EQ(K4A_DEPTH_MODE_NFOV_UNBINNED, depth_mode);
+    ASSERT_EQ(K4A_COLOR_RESOLUTION_720P, color_resolution);
+    broker_detach(client);
+}
+
+TEST_F(broker_ut, zero_copy)
+{
+    broker_client_t client = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_attach(name.c_str(), &client));
+
+    // The depth image is allocated straight from shared memory
+    k4a_capture_t capture = create_depth_capture(1000);
+    ASSERT_NE(capture, nullptr);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT - 1, broker_get_free_buffer_count(broker));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+    capture_dec_ref(capture);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT - 1, broker_get_free_buffer_count(broker));
+
+    k4a_capture_t received = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, broker_client_get_capture(client, &received, 1000));
+    ASSERT_TRUE(validate_depth_capture(received, 1000));
+
+    // The buffer is free once the attached process releases it too, even after detaching
+    broker_detach(client);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT - 1, broker_get_free_buffer_count(broker));
+    capture_dec_ref(received);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT, broker_get_free_buffer_count(broker));
+}
+
+TEST_F(broker_ut, drop_oldest)
+{
+    broker_client_t client = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_attach(name.c_str(), &client));
+
+    // Publishing more captures than the queue holds keeps the newest ones and frees the buffers of the others
+    const int published = BROKER_CLIENT_QUEUE_LENGTH + 2;
+    for (int i = 0; i < published; i++)
+    {
+        k4a_capture_t capture = create_depth_capture(1000 * (uint64_t)(i + 1));
+        ASSERT_NE(capture, nullptr);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+        capture_dec_ref(capture);
+    }
+    ASSERT_EQ((uint32_t)(BUFFER_COUNT - BROKER_CLIENT_QUEUE_LENGTH), broker_get_free_buffer_count(broker));
+
+    for (int i = published - BROKER_CLIENT_QUEUE_LENGTH; i < published; i++)
+    {
+        k4a_capture_t received = NULL;
+        ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, broker_client_get_capture(client, &received, 0));
+        ASSERT_TRUE(validate_depth_capture(received, 1000 * (uint64_t)(i + 1)));
+        capture_dec_ref(received);
+    }
+
+    k4a_capture_t received = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, broker_client_get_capture(client, &received, 0));
+    ASSERT_EQ((uint32_t)BUFFER_COUNT, broker_get_free_buffer_count(broker));
+    broker_detach(client);
+}
+
+TEST_F(broker_ut, copy_heap_images)
+{
+    broker_client_t client = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_attach(name.c_str(), &client));
+
+    // Small images come from the heap and are copied to a shared buffer when published
+    k4a_capture_t capture = NULL;
+    k4a_image_t image = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, capture_create(&capture));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create(K4A_IMAGE_FORMAT_IR16, 64, 64, 128, ALLOCATION_SOURCE_DEPTH, &image));
+    memset(image_get_buffer(image), 0x5A, image_get_size(image));
+    capture_set_ir_image(capture, image);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT, broker_get_free_buffer_count(broker));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+    ASSERT_EQ((uint32_t)BUFFER_COUNT - 1, broker_get_free_buffer_count(broker));
+
+    k4a_capture_t received = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, broker_client_get_capture(client, &received, 0));
+    k4a_image_t received_image = capture_get_ir_image(received);
+    ASSERT_NE(received_image, nullptr);
+    ASSERT_NE(image_get_buffer(image), image_get_buffer(received_image));
+    ASSERT_EQ(image_get_size(image), image_get_size(received_image));
+    ASSERT_EQ(0, memcmp(image_get_buffer(image), image_get_buffer(received_image), image_get_size(image)));
+
+    image_dec_ref(received_image);
+    capture_dec_ref(received);
+    image_dec_ref(image);
+    capture_dec_ref(capture);
+    broker_detach(client);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT, broker_get_free_buffer_count(broker));
+}
+
+// Forks a process that attaches to the broker, returns once it has attached
+static pid_t fork_attached(const std::string &name, broker_client_t *client)
+{
+    int attached[2];
+    if (pipe(attached) != 0)
+    {
+        return -1;
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(attached[0]);
+        char status = K4A_SUCCEEDED(broker_attach(name.c_str(), client)) ? 0 : 1;
+        if (write(attached[1], &status, 1) != 1 || status != 0)
+        {
+            _exit(1);
+        }
+        close(attached[1]);
+        return 0;
+    }
+
+    close(attached[1]);
+    char status = 1;
+    if (child > 0 && (read(attached[0], &status, 1) != 1 || status != 0))
+    {
+        waitpid(child, NULL, 0);
+        child = -1;
+    }
+    close(attached[0]);
+    return child;
+}
+
+TEST_F(broker_ut, other_process)
+{
+    broker_client_t client = NULL;
+    pid_t child = fork_attached(name, &client);
+    ASSERT_NE(-1, child);
+    if (child == 0)
+    {
+        // Receive two captures in another process, then wait for the broker to be destroyed
+        int status = 0;
+        for (uint64_t timestamp = 1000; timestamp <= 2000 && status == 0; timestamp += 1000)
+        {
+            k4a_capture_t received = NULL;
+            status = broker_client_get_capture(client, &received, 10000) == K4A_WAIT_RESULT_SUCCEEDED ? 0 : 2;
+            if (status == 0)
+            {
+                status = validate_depth_capture(received, timestamp) ? 0 : 3;
+                capture_dec_ref(received);
+            }
+        }
+        k4a_capture_t received = NULL;
+        if (status == 0 && broker_client_get_capture(client, &received, 10000) != K4A_WAIT_RESULT_FAILED)
+        {
+            status = 4;
+        }
+        broker_detach(client);
+        _exit(status);
+    }
+
+    for (uint64_t timestamp = 1000; timestamp <= 2000; timestamp += 1000)
+    {
+        k4a_capture_t capture = create_depth_capture(timestamp);
+        ASSERT_NE(capture, nullptr);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+        capture_dec_ref(capture);
+    }
+
+    // Captures queued before the broker is destroyed are still received
+    broker_destroy(broker);
+    broker = NULL;
+
+    int status = -1;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_F(broker_ut, reclaim_exited_process)
+{
+    broker_client_t client = NULL;
+    pid_t child = fork_attached(name, &client);
+    ASSERT_NE(-1, child);
+    if (child == 0)
+    {
+        // Hold a received capture and exit without releasing it or detaching
+        k4a_capture_t received = NULL;
+        _exit(broker_client_get_capture(client, &received, 10000) == K4A_WAIT_RESULT_SUCCEEDED ? 0 : 2);
+    }
+
+    k4a_capture_t capture = create_depth_capture(1000);
+    ASSERT_NE(capture, nullptr);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+    capture_dec_ref(capture);
+
+    int status = -1;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+    ASSERT_EQ((uint32_t)BUFFER_COUNT - 1, broker_get_free_buffer_count(broker));
+
+    // The next capture published finds the process gone and frees its buffers
+    capture = create_depth_capture(2000);
+    ASSERT_NE(capture, nullptr);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, broker_publish_capture(broker, capture));
+    capture_dec_ref(capture);
+    ASSERT_EQ((uint32_t)BUFFER_COUNT, broker_get_free_buffer_count(broker));
+}
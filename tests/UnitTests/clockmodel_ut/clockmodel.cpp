@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/clockmodel.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// Device clock 50 ppm fast of the system clock, started 5 seconds after the system clock
+static uint64_t true_system_nsec(uint64_t device_usec)
+{
+    return 5000000000ull + device_usec * 1000 + device_usec / 20;
+}
+
+// Transfer latency of 200 us to 5 ms
+static uint64_t arrival_nsec(uint64_t device_usec)
+{
+    return true_system_nsec(device_usec) + 200000 + (uint64_t)(rand() % 4800) * 1000;
+}
+
+TEST(clockmodel_ut, invalid_args)
+{
+    uint64_t system_nsec = 0;
+    ASSERT_EQ(clockmodel_create(NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(NULL, 1000, &system_nsec), K4A_RESULT_FAILED);
+
+    clockmodel_t clockmodel = NULL;
+    ASSERT_EQ(clockmodel_create(&clockmodel), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, 1000, NULL), K4A_RESULT_FAILED);
+    clockmodel_destroy(clockmodel);
+}
+
+TEST(clockmodel_ut, needs_observations)
+{
+    clockmodel_t clockmodel = NULL;
+    ASSERT_EQ(clockmodel_create(&clockmodel), K4A_RESULT_SUCCEEDED);
+
+    uint64_t system_nsec = 0;
+    for (uint64_t i = 1; i < CLOCKMODEL_MIN_OBSERVATIONS; i++)
+    {
+        clockmodel_add_observation(clockmodel, i * 33333, arrival_nsec(i * 33333));
+        ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, i * 33333, &system_nsec), K4A_RESULT_FAILED);
+    }
+
+    // Observations without a timestamp are ignored
+    clockmodel_add_observation(clockmodel, 0, arrival_nsec(0));
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, 0, &system_nsec), K4A_RESULT_FAILED);
+
+    clockmodel_add_observation(clockmodel, 300000, arrival_nsec(300000));
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, 300000, &system_nsec), K4A_RESULT_SUCCEEDED);
+
+    clockmodel_reset(clockmodel);
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, 300000, &system_nsec), K4A_RESULT_FAILED);
+    clockmodel_destroy(clockmodel);
+}
+
+TEST(clockmodel_ut, drift_and_jitter)
+{
+    clockmodel_t clockmodel = NULL;
+    ASSERT_EQ(clockmodel_create(&clockmodel), K4A_RESULT_SUCCEEDED);
+    srand(1);
+
+    // 60 seconds of depth and color at 30 fps
+    for (uint64_t frame = 1; frame < 1800; frame++)
+    {
+        uint64_t device_usec = frame * 33333;
+        clockmodel_add_observation(clockmodel, device_usec, arrival_nsec(device_usec));
+        clockmodel_add_observation(clockmodel, device_usec + 160, arrival_nsec(device_usec + 160));
+    }
+
+    // Mapped times follow the earliest arrivals, not the average latency
+    const uint64_t device_times_usec[] = { 45000000, 59000000, 59990000, 61000000 };
+    for (uint64_t device_usec : device_times_usec)
+    {
+        uint64_t system_nsec = 0;
+        ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, device_usec, &system_nsec), K4A_RESULT_SUCCEEDED);
+        int64_t error_nsec = (int64_t)(system_nsec - true_system_nsec(device_usec)) - 200000;
+        ASSERT_LT(std::abs(error_nsec), 200000) << "Device time " << device_usec;
+    }
+    clockmodel_destroy(clockmodel);
+}
+
+TEST(clockmodel_ut, clock_restart)
+{
+    clockmodel_t clockmodel = NULL;
+    ASSERT_EQ(clockmodel_create(&clockmodel), K4A_RESULT_SUCCEEDED);
+    srand(2);
+
+    for (uint64_t frame = 1; frame < 300; frame++)
+    {
+        clockmodel_add_observation(clockmodel, frame * 33333, arrival_nsec(frame * 33333));
+    }
+
+    // The device clock restarts at 0, 20 seconds later on the system clock
+    uint64_t restart_nsec = true_system_nsec(300 * 33333) + 10000000000ull;
+    uint64_t system_nsec = 0;
+    for (uint64_t frame = 1; frame < 300; frame++)
+    {
+        uint64_t device_usec = frame * 33333;
+        clockmodel_add_observation(clockmodel, device_usec, restart_nsec + device_usec * 1000 + 500000);
+    }
+    ASSERT_EQ(clockmodel_get_system_timestamp_nsec(clockmodel, 150 * 33333, &system_nsec), K4A_RESULT_SUCCEEDED);
+    int64_t error_nsec = (int64_t)(system_nsec - (restart_nsec + 150 * 33333 * 1000ull + 500000));
+    ASSERT_LT(std::abs(error_nsec), 100000);
+    clockmodel_destroy(clockmodel);
+}
@@ -0,0 +1,323 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/depthfilter.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// Widths with and without a remainder for the vectorized kernels
+#define TEST_WIDTH (37)
+#define TEST_HEIGHT (13)
+
+static uint16_t reference_pixel(const std::vector<uint16_t> &image, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= TEST_WIDTH || y >= TEST_HEIGHT)
+    {
+        return 0;
+    }
+    return image[(size_t)(y * TEST_WIDTH + x)];
+}
+
+static std::vector<uint16_t> reference_edge(const std::vector<uint16_t> &image, uint16_t threshold)
+{
+    const int dx[4] = { -1, 1, 0, 0 };
+    const int dy[4] = { 0, 0, -1, 1 };
+    std::vector<uint16_t> output(image.size());
+    for (int y = 0; y < TEST_HEIGHT; y++)
+    {
+        for (int x = 0; x < TEST_WIDTH; x++)
+        {
+            int depth = reference_pixel(image, x, y);
+            bool edge = false;
+            for (int i = 0; i < 4; i++)
+            {
+                int neighbor = reference_pixel(image, x + dx[i], y + dy[i]);
+                edge = edge || (neighbor != 0 && std::abs(depth - neighbor) > threshold);
+            }
+            output[(size_t)(y * TEST_WIDTH + x)] = edge ? (uint16_t)0 : (uint16_t)depth;
+        }
+    }
+    return output;
+}
+
+static std::vector<uint16_t> reference_hole_fill(const std::vector<uint16_t> &image)
+{
+    std::vector<uint16_t> output(image);
+    for (int y = 0; y < TEST_HEIGHT; y++)
+    {
+        for (int x = 0; x < TEST_WIDTH; x++)
+        {
+            if (reference_pixel(image, x, y) == 0)
+            {
+                output[(size_t)(y * TEST_WIDTH + x)] = std::max(std::max(reference_pixel(image, x - 1, y),
+                                                                         reference_pixel(image, x + 1, y)),
+                                                                std::max(reference_pixel(image, x, y - 1),
+                                                                         reference_pixel(image, x, y + 1)));
+            }
+        }
+    }
+    return output;
+}
+
+static std::vector<uint16_t> make_test_image(unsigned int seed)
+{
+    std::vector<uint16_t> image((size_t)(TEST_WIDTH * TEST_HEIGHT));
+    srand(seed);
+    for (size_t i = 0; i < image.size(); i++)
+    {
+        // Holes, and pixels in front of a slanted background
+        int r = rand() % 100;
+        int depth = 1000 + (int)(i % TEST_WIDTH) * 3 + (r < 15 ? 500 : 0) + rand() % 30;
+        image[i] = r < 10 ? (uint16_t)0 : (uint16_t)depth;
+    }
+    return image;
+}
+
+static std::vector<uint16_t> run_filter(const k4a_depth_filter_configuration_t &config,
+                                        const std::vector<std::vector<uint16_t>> &images)
+{
+    depthfilter_t depthfilter = NULL;
+    EXPECT_EQ(depthfilter_create(&config, TEST_WIDTH, TEST_HEIGHT, &depthfilter), K4A_RESULT_SUCCEEDED);
+    std::vector<uint16_t> image;
+    for (const std::vector<uint16_t> &input : images)
+    {
+        image = input;
+        depthfilter_process(depthfilter, image.data());
+    }
+    depthfilter_destroy(depthfilter);
+    return image;
+}
+
+TEST(depthfilter_ut, validate_configuration)
+{
+    k4a_depth_filter_configuration_t config = {};
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_SUCCEEDED);
+    ASSERT_FALSE(depthfilter_is_enabled(&config));
+    ASSERT_EQ(depthfilter_validate_configuration(NULL), K4A_RESULT_FAILED);
+
+    config.temporal_alpha = 1.0f;
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_FAILED);
+    config.temporal_alpha = -0.5f;
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_FAILED);
+    config.temporal_alpha = NAN;
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_FAILED);
+    config.temporal_alpha = 0.5f;
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(depthfilter_is_enabled(&config));
+
+    config.thread_count = DEPTHFILTER_MAX_THREAD_COUNT + 1;
+    ASSERT_EQ(depthfilter_validate_configuration(&config), K4A_RESULT_FAILED);
+
+    depthfilter_t depthfilter = NULL;
+    ASSERT_EQ(depthfilter_create(&config, TEST_WIDTH, TEST_HEIGHT, &depthfilter), K4A_RESULT_FAILED);
+    ASSERT_EQ(depthfilter, (depthfilter_t)NULL);
+}
+
+TEST(depthfilter_ut, edge_removal)
+{
+    k4a_depth_filter_configuration_t config = {};
+    config.edge_threshold_mm = 50;
+
+    std::vector<uint16_t> image = make_test_image(1);
+    ASSERT_EQ(run_filter(config, { image }), reference_edge(image, config.edge_threshold_mm));
+}
+
+TEST(depthfilter_ut, hole_fill)
+{
+    k4a_depth_filter_configuration_t config = {};
+    config.hole_fill_passes = 2;
+
+    std::vector<uint16_t> image = make_test_image(2);
+    ASSERT_EQ(run_filter(config, { image }), reference_hole_fill(reference_hole_fill(image)));
+}
+
+TEST(depthfilter_ut, temporal_smoothing)
+{
+    k4a_depth_filter_configuration_t config = {};
+    config.temporal_alpha = 0.25f;
+    config.temporal_threshold_mm = 100;
+
+    std::vector<uint16_t> first(TEST_WIDTH * TEST_HEIGHT, 1000);
+    std::vector<uint16_t> second(TEST_WIDTH * TEST_HEIGHT, 1040);
+    second[0] = 0;    // Invalid pixels stay invalid
+    second[1] = 1500; // Changes above the threshold are not smoothed
+    std::vector<uint16_t> output = run_filter(config, { first, second });
+
+    ASSERT_EQ(output[0], 0);
+    ASSERT_EQ(output[1], 1500);
+    for (size_t i = 2; i < output.size(); i++)
+    {
+        ASSERT_EQ(output[i], 1010) << "Pixel " << i;
+    }
+}
+
+TEST(depthfilter_ut, thread_count)
+{
+    k4a_depth_filter_configuration_t config = {};
+    config.edge_threshold_mm = 40;
+    config.temporal_alpha = 0.5f;
+    config.temporal_threshold_mm = 60;
+    config.hole_fill_passes = 3;
+
+    std::vector<std::vector<uint16_t>> images = { make_test_image(3), make_test_image(4), make_test_image(5) };
+    std::vector<uint16_t> reference = run_filter(config, images);
+
+    // Splitting the image across the worker threads doesn't change the result
+    const uint32_t thread_counts[] = { 2, 3, DEPTHFILTER_MAX_THREAD_COUNT };
+    for (uint32_t thread_count : thread_counts)
+    {
+        config.thread_count = thread_count;
+        ASSERT_EQ(run_filter(config, images), reference) << thread_count << " threads";
+    }
+}
+
+TEST(depthfilter_ut, statistics)
+{
+    // Widths that leave no remainder, only a remainder and both for the vectorized kernels
+    const int widths[] = { 1, 7, 16, TEST_WIDTH, 640 };
+    for (int width : widths)
+    {
+        std::vector<uint16_t> image((size_t)(width * TEST_HEIGHT));
+        srand((unsigned int)width);
+        for (uint16_t &depth : image)
+        {
+            int r = rand() % 10;
+            depth = r < 2 ? (uint16_t)0 : (r < 3 ? (uint16_t)(rand() % 65536) : (uint16_t)(rand() % 9000));
+        }
+
+        k4a_depth_statistics_t reference = {};
+        uint64_t total = 0;
+        for (uint16_t depth : image)
+        {
+            if (depth != 0)
+            {
+                reference.min_mm = reference.valid_pixel_count == 0 ? depth : std::min(reference.min_mm, depth);
+                reference.max_mm = std::max(reference.max_mm, depth);
+                reference.valid_pixel_count++;
+                total += depth;
+                int bin = depth / K4A_DEPTH_STATISTICS_BIN_WIDTH_MM;
+                reference.histogram[std::min(bin, K4A_DEPTH_STATISTICS_HISTOGRAM_BINS - 1)]++;
+            }
+        }
+
+        k4a_depth_statistics_t statistics;
+        depthfilter_compute_statistics(image.data(), width, TEST_HEIGHT, &statistics);
+        ASSERT_EQ(statistics.valid_pixel_count, reference.valid_pixel_count) << "Width " << width;
+        ASSERT_EQ(statistics.min_mm, reference.min_mm) << "Width " << width;
+        ASSERT_EQ(statistics.max_mm, reference.max_mm) << "Width " << width;
+        ASSERT_FLOAT_EQ(statistics.mean_mm, (float)((double)total / reference.valid_pixel_count)) << "Width " << width;
+        for (int i = 0; i < K4A_DEPTH_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            ASSERT_EQ(statistics.histogram[i], reference.histogram[i]) << "Width " << width << " bin " << i;
+        }
+    }
+
+    // An image without valid pixels has all statistics at 0
+    std::vector<uint16_t> invalid((size_t)(TEST_WIDTH * TEST_HEIGHT), 0);
+    k4a_depth_statistics_t statistics;
+    depthfilter_compute_statistics(invalid.data(), TEST_WIDTH, TEST_HEIGHT, &statistics);
+    ASSERT_EQ(statistics.valid_pixel_count, 0u);
+    ASSERT_EQ(statistics.min_mm, 0);
+    ASSERT_EQ(statistics.max_mm, 0);
+    ASSERT_EQ(statistics.mean_mm, 0.0f);
+}
+
+TEST(depthfilter_ut, validate_ir8_configuration)
+{
+    k4a_ir8_configuration_t config = {};
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(NULL), K4A_RESULT_FAILED);
+
+    config.shift = DEPTHFILTER_IR8_MAX_SHIFT + 1;
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_FAILED);
+
+    config.tone_mapping = K4A_IR_TONE_MAPPING_PERCENTILE;
+    config.low_percentile = 1.0f;
+    config.high_percentile = 99.0f;
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_SUCCEEDED);
+    config.high_percentile = 1.0f;
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_FAILED);
+    config.high_percentile = 101.0f;
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_FAILED);
+    config.high_percentile = 99.0f;
+    config.low_percentile = NAN;
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_FAILED);
+
+    config.tone_mapping = (k4a_ir_tone_mapping_t)(K4A_IR_TONE_MAPPING_PERCENTILE + 1);
+    ASSERT_EQ(depthfilter_validate_ir8_configuration(&config), K4A_RESULT_FAILED);
+}
+
+TEST(depthfilter_ut, ir_tone_mapping_shift)
+{
+    // Widths that leave no remainder, only a remainder and both for the vectorized kernels
+    const int widths[] = { 1, 7, 16, TEST_WIDTH, 640 };
+    const uint32_t shifts[] = { 0, 3, DEPTHFILTER_IR8_MAX_SHIFT };
+    for (int width : widths)
+    {
+        std::vector<uint16_t> image((size_t)(width * TEST_HEIGHT));
+        srand((unsigned int)width);
+        for (uint16_t &ir : image)
+        {
+            ir = (uint16_t)(rand() % 4 == 0 ? rand() % 65536 : rand() % 2000);
+        }
+
+        for (uint32_t shift : shifts)
+        {
+            k4a_ir8_configuration_t config = {};
+            config.shift = shift;
+            std::vector<uint8_t> ir8(image.size());
+            depthfilter_tone_map_ir(&config, image.data(), width, TEST_HEIGHT, ir8.data());
+            for (size_t i = 0; i < image.size(); i++)
+            {
+                ASSERT_EQ(ir8[i], (uint8_t)std::min(image[i] >> shift, 255))
+                    << "Width " << width << " shift " << shift << " pixel " << i;
+            }
+        }
+    }
+}
+
+TEST(depthfilter_ut, ir_tone_mapping_percentile)
+{
+    const int width = 640;
+    std::vector<uint16_t> image((size_t)(width * TEST_HEIGHT));
+    srand(1);
+    for (uint16_t &ir : image)
+    {
+        ir = (uint16_t)(100 + rand() % 4000);
+    }
+
+    k4a_ir8_configuration_t config = {};
+    config.tone_mapping = K4A_IR_TONE_MAPPING_PERCENTILE;
+    config.low_percentile = 10.0f;
+    config.high_percentile = 90.0f;
+    std::vector<uint8_t> ir8(image.size());
+    depthfilter_tone_map_ir(&config, image.data(), width, TEST_HEIGHT, ir8.data());
+
+    // The mapping doesn't decrease with the IR value and clamps about a tenth of the pixels at each end
+    std::vector<size_t> order(image.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&image](size_t a, size_t b) { return image[a] < image[b]; });
+    for (size_t i = 1; i < order.size(); i++)
+    {
+        ASSERT_LE(ir8[order[i - 1]], ir8[order[i]]) << "IR " << image[order[i - 1]] << " and " << image[order[i]];
+    }
+
+    size_t black = (size_t)std::count(ir8.begin(), ir8.end(), (uint8_t)0);
+    size_t white = (size_t)std::count(ir8.begin(), ir8.end(), (uint8_t)255);
+    ASSERT_NEAR((double)black / (double)image.size(), 0.1, 0.03);
+    ASSERT_NEAR((double)white / (double)image.size(), 0.1, 0.03);
+}
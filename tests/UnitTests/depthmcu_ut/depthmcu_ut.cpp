@@ -69,6 +69,24 @@ public:
     MOCK_CONST_METHOD2(usb_cmd_stream_start, k4a_result_t(usbcmd_t p_command_handle, size_t payload_size));
 
     MOCK_CONST_METHOD1(usb_cmd_stream_stop, k4a_result_t(usbcmd_t p_command_handle));
+
+    MOCK_CONST_METHOD2(usb_cmd_get_stream_stats,
+                       k4a_result_t(usbcmd_t p_command_handle, k4a_usb_stream_stats_t *stats));
+
+    MOCK_CONST_METHOD2(usb_cmd_batch_create, k4a_result_t(usbcmd_t p_command_handle, usb_cmd_batch_t *batch_handle));
+
+    MOCK_CONST_METHOD1(usb_cmd_batch_destroy, void(usb_cmd_batch_t batch_handle));
+
+    MOCK_CONST_METHOD7(usb_cmd_batch_add_write,
+                       k4a_result_t(usb_cmd_batch_t batch_handle,
+                                    uint32_t cmd,
+                                    uint8_t *p_cmd_data,
+                                    size_t cmd_data_size,
+                                    uint8_t *p_data,
+                                    size_t data_size,
+                                    uint32_t *cmd_status));
+
+    MOCK_CONST_METHOD1(usb_cmd_batch_execute, k4a_result_t(usb_cmd_batch_t batch_handle));
 };
 
 extern "C" {
@@ -156,6 +174,44 @@ k4a_result_t usb_cmd_stream_stop(usbcmd_t p_command_handle)
 {
     return g_MockUsbCmd->usb_cmd_stream_stop(p_command_handle);
 }
+
+k4a_result_t usb_cmd_get_stream_stats(usbcmd_t p_command_handle, k4a_usb_stream_stats_t *stats)
+{
+    return g_MockUsbCmd->usb_cmd_get_stream_stats(p_command_handle, stats);
+}
+
+k4a_result_t usb_cmd_batch_create(usbcmd_t p_command_handle, usb_cmd_batch_t *batch_handle)
+{
+    return g_MockUsbCmd->usb_cmd_batch_create(p_command_handle, batch_handle);
+}
+
+void usb_cmd_batch_destroy(usb_cmd_batch_t batch_handle)
+{
+    g_MockUsbCmd->usb_cmd_batch_destroy(batch_handle);
+}
+
+k4a_result_t usb_cmd_batch_add_write(usb_cmd_batch_t batch_handle,
+                                     uint32_t cmd,
+                                     uint8_t *p_cmd_data,
+                                     size_t cmd_data_size,
+                                     uint8_t *p_data,
+                                     size_t data_size,
+                                     uint32_t *cmd_status)
+{
+    return g_MockUsbCmd
+        ->usb_cmd_batch_add_write(batch_handle, cmd, p_cmd_data, cmd_data_size, p_data, data_size, cmd_status);
+}
+
+k4a_result_t usb_cmd_batch_execute(usb_cmd_batch_t batch_handle)
+{
+    return g_MockUsbCmd->usb_cmd_batch_execute(batch_handle);
+}
+
+int usb_cmd_get_numa_node(usbcmd_t p_command_handle)
+{
+    (void)p_command_handle;
+    return -1;
+}
 }
 
 // Set an expectation on the mock object for a serial number USB request which will succeed
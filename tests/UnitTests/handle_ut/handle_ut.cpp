@@ -43,6 +43,28 @@ K4A_DECLARE_CONTEXT(foo_t, context_t);
 K4A_DECLARE_HANDLE(bar_t);
 K4A_DECLARE_CONTEXT(bar_t, context2_t);
 
+// A pool keeping a single freed handle
+static void *g_pooled_handle = NULL;
+static void *pool_alloc(size_t size)
+{
+    void *handle = g_pooled_handle;
+    g_pooled_handle = NULL;
+    if (handle)
+    {
+        memset(handle, 0, size);
+        return handle;
+    }
+    return calloc(1, size);
+}
+static void pool_free(void *handle)
+{
+    free(g_pooled_handle);
+    g_pooled_handle = handle;
+}
+
+K4A_DECLARE_HANDLE(baz_t);
+K4A_DECLARE_POOLED_CONTEXT(baz_t, context_t, pool_alloc, pool_free);
+
 TEST(handle_ut, create_free)
 {
     foo_t foo = NULL;
@@ -116,6 +138,31 @@ TEST(handle_ut_deathtest, use_after_free)
     EXPECT_EQ(NULL, foo_t_get_context(foo));
 }
 
+TEST(handle_ut, pooled_create_free)
+{
+    baz_t baz = NULL;
+    context_t *context = baz_t_create(&baz);
+    ASSERT_NE((context_t *)NULL, context);
+    context->my = 1;
+
+    // The destroyed handle stays in the pool and must not validate
+    baz_t_destroy(baz);
+    EXPECT_EQ((void *)baz, g_pooled_handle);
+    EXPECT_EQ(NULL, baz_t_get_context(baz));
+
+    // The next handle reuses the memory, zeroed
+    baz_t baz2 = NULL;
+    context = baz_t_create(&baz2);
+    ASSERT_NE((context_t *)NULL, context);
+    EXPECT_EQ(baz, baz2);
+    EXPECT_EQ(0, context->my);
+    EXPECT_EQ(context, baz_t_get_context(baz2));
+
+    baz_t_destroy(baz2);
+    free(g_pooled_handle);
+    g_pooled_handle = NULL;
+}
+
 TEST(handle_ut, K4A_DECLARE_CONTEXT_in_shared_header)
 {
     dual_defined_t dual = NULL;
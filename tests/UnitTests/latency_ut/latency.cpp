@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/latency.h>
+#include <gtest/gtest.h>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+TEST(latency_ut, invalid_args)
+{
+    k4a_latency_stats_t stats;
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_NUM, &stats), K4A_RESULT_FAILED);
+    ASSERT_EQ(latency_get_stats((k4a_latency_stage_t)-1, &stats), K4A_RESULT_FAILED);
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_TOTAL, NULL), K4A_RESULT_FAILED);
+}
+
+TEST(latency_ut, record)
+{
+    k4a_latency_stats_t stats;
+    latency_reset_stats();
+
+    uint64_t now_nsec = latency_get_time_nsec();
+    ASSERT_NE(now_nsec, 0u);
+    ASSERT_GE(latency_get_time_nsec(), now_nsec);
+
+    // 10 us, 100 us and 5 ms
+    latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, now_nsec, now_nsec + 10000);
+    latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, now_nsec, now_nsec + 100000);
+    latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, now_nsec, now_nsec + 5000000);
+
+    // Samples without a start time or ending before they start are ignored
+    latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, 0, now_nsec);
+    latency_record(K4A_LATENCY_STAGE_DEPTH_ENGINE, now_nsec, now_nsec - 1);
+
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_DEPTH_ENGINE, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.count, 3u);
+    ASSERT_EQ(stats.min_usec, 10u);
+    ASSERT_EQ(stats.max_usec, 5000u);
+    ASSERT_EQ(stats.total_usec, 5110u);
+    ASSERT_EQ(stats.histogram[0], 1u); // Under 64 us
+    ASSERT_EQ(stats.histogram[1], 1u); // 64 us up to 128 us
+    ASSERT_EQ(stats.histogram[7], 1u); // 4096 us up to 8192 us
+
+    // Other stages are not affected
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_USER, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.count, 0u);
+
+    // Latencies past the histogram land in the last bucket
+    latency_record(K4A_LATENCY_STAGE_USER, now_nsec, now_nsec + 10000000000ULL);
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_USER, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.histogram[K4A_LATENCY_HISTOGRAM_BUCKETS - 1], 1u);
+
+    latency_reset_stats();
+    ASSERT_EQ(latency_get_stats(K4A_LATENCY_STAGE_DEPTH_ENGINE, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.count, 0u);
+    ASSERT_EQ(stats.max_usec, 0u);
+}
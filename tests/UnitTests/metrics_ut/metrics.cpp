@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/metrics.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <string.h>
+#include <thread>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+TEST(metrics_ut, list)
+{
+    k4a_metric_t metrics[2];
+    metrics_list_t list = { metrics, 2, 0 };
+
+    metrics_add_counter(&list, "test_total", "A counter", "stream", "depth", 3);
+    metrics_add_gauge(&list, "test_gauge", "A gauge", NULL, NULL, 1.5);
+
+    // Metrics past the capacity are counted but not written
+    metrics_add_gauge(&list, "test_dropped", "A gauge", NULL, NULL, 2);
+    ASSERT_EQ(list.count, 3u);
+
+    ASSERT_EQ(metrics[0].type, K4A_METRIC_TYPE_COUNTER);
+    ASSERT_EQ(strcmp(metrics[0].name, "test_total"), 0);
+    ASSERT_EQ(strcmp(metrics[0].label_name, "stream"), 0);
+    ASSERT_EQ(strcmp(metrics[0].label_value, "depth"), 0);
+    ASSERT_EQ(metrics[0].value, 3);
+
+    ASSERT_EQ(metrics[1].type, K4A_METRIC_TYPE_GAUGE);
+    ASSERT_EQ(metrics[1].label_name, nullptr);
+    ASSERT_EQ(metrics[1].value, 1.5);
+
+    // A NULL array only counts the metrics
+    metrics_list_t count_only = { NULL, 0, 0 };
+    metrics_add_latency_stats(&count_only);
+    ASSERT_EQ(count_only.count, (size_t)K4A_LATENCY_STAGE_NUM);
+}
+
+TEST(metrics_ut, histogram)
+{
+    k4a_metric_t metric;
+    metrics_list_t list = { &metric, 1, 0 };
+    uint64_t counts[4] = { 1, 0, 2, 5 };
+
+    metrics_add_exponential_histogram(&list, "test_seconds", "A histogram", NULL, NULL, counts, 4, 0.001, 0.5);
+    ASSERT_EQ(list.count, 1u);
+    ASSERT_EQ(metric.type, K4A_METRIC_TYPE_HISTOGRAM);
+    ASSERT_EQ(metric.bucket_count, 4u);
+    ASSERT_EQ(metric.count, 8u);
+    ASSERT_EQ(metric.value, 0.5);
+    ASSERT_DOUBLE_EQ(metric.bucket_upper_bounds[0], 0.001);
+    ASSERT_DOUBLE_EQ(metric.bucket_upper_bounds[1], 0.002);
+    ASSERT_DOUBLE_EQ(metric.bucket_upper_bounds[2], 0.004);
+    ASSERT_TRUE(std::isinf(metric.bucket_upper_bounds[3]));
+    ASSERT_EQ(metric.bucket_counts[3], 5u);
+}
+
+static void count_runs(void *context)
+{
+    (*(std::atomic<int> *)context)++;
+}
+
+TEST(metrics_ut, sink)
+{
+    std::atomic<int> runs(0);
+    metrics_sink_t sink = NULL;
+
+    ASSERT_EQ(metrics_sink_create(0, count_runs, &runs, &sink), K4A_RESULT_FAILED);
+    ASSERT_EQ(metrics_sink_create(10, NULL, &runs, &sink), K4A_RESULT_FAILED);
+    ASSERT_EQ(metrics_sink_create(10, count_runs, &runs, NULL), K4A_RESULT_FAILED);
+
+    ASSERT_EQ(metrics_sink_create(10, count_runs, &runs, &sink), K4A_RESULT_SUCCEEDED);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    metrics_sink_destroy(sink);
+
+    int runs_at_destroy = runs;
+    ASSERT_GT(runs_at_destroy, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(runs, runs_at_destroy);
+}
@@ -7,12 +7,15 @@
 #include <k4ainternal/image.h>
 #include <k4ainternal/queue.h>
 #include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
 #include <gtest/gtest.h>
 
 #include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/tickcounter.h>
 #include <azure_c_shared_utility/threadapi.h>
 
+#include <vector>
+
 int main(int argc, char **argv)
 {
     return k4a_test_common_main(argc, argv);
@@ -415,6 +418,144 @@ TEST(queue_ut, test_queue_push_w_dropped)
     ASSERT_EQ(allocator_test_for_leaks(), 0);
 }
 
+TEST(queue_ut, queue_get_count)
+{
+    queue_t queue;
+    k4a_capture_t capture[3];
+    k4a_capture_t capture_read;
+
+    ASSERT_EQ(queue_get_count(NULL), 0u);
+    ASSERT_EQ(queue_create(2, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+    ASSERT_EQ(queue_get_count(queue), 0u);
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture[i] = capture_manufacture(10);
+        ASSERT_NE(capture[i], (k4a_capture_t)NULL);
+        queue_push(queue, capture[i]);
+    }
+
+    // The queue holds 2, the oldest was dropped
+    ASSERT_EQ(queue_get_count(queue), 2u);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    capture_dec_ref(capture_read);
+    ASSERT_EQ(queue_get_count(queue), 1u);
+
+    queue_disable(queue);
+    ASSERT_EQ(queue_get_count(queue), 0u);
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture_dec_ref(capture[i]);
+    }
+    queue_destroy(queue);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+typedef struct _queue_blocked_push_data_t
+{
+    queue_t queue;
+    k4a_capture_t capture;
+} queue_blocked_push_data_t;
+
+static int thread_blocked_push(void *param)
+{
+    queue_blocked_push_data_t *data = (queue_blocked_push_data_t *)param;
+    queue_push(data->queue, data->capture);
+    return 0;
+}
+
+TEST(queue_ut, queue_configure)
+{
+    queue_t queue;
+    k4a_capture_t capture[3];
+    k4a_capture_t capture_read;
+    k4a_capture_t capture_dropped = NULL;
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture[i] = capture_manufacture(10);
+        ASSERT_NE(capture[i], (k4a_capture_t)NULL);
+    }
+
+    ASSERT_EQ(queue_create(QUEUE_DEFAULT_SIZE, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+
+    // Only a disabled queue can be reconfigured, repeating the current configuration is allowed
+    queue_enable(queue);
+    ASSERT_EQ(queue_configure(queue, 1, K4A_QUEUE_POLICY_DROP_NEWEST), K4A_RESULT_FAILED);
+    ASSERT_EQ(queue_configure(queue, QUEUE_DEFAULT_SIZE, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_SUCCEEDED);
+    queue_disable(queue);
+    ASSERT_EQ(queue_configure(NULL, 1, K4A_QUEUE_POLICY_DROP_NEWEST), K4A_RESULT_FAILED);
+    ASSERT_EQ(queue_configure(queue, 0, K4A_QUEUE_POLICY_DROP_NEWEST), K4A_RESULT_FAILED);
+    ASSERT_EQ(queue_configure(queue, 1, (k4a_queue_policy_t)10), K4A_RESULT_FAILED);
+
+    // Drop newest keeps the queued capture and returns the new one
+    ASSERT_EQ(queue_configure(queue, 1, K4A_QUEUE_POLICY_DROP_NEWEST), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+    queue_push_w_dropped(queue, capture[0], &capture_dropped);
+    ASSERT_EQ(capture_dropped, (k4a_capture_t)NULL);
+    queue_push_w_dropped(queue, capture[1], &capture_dropped);
+    ASSERT_EQ(capture_dropped, capture[1]);
+    capture_dec_ref(capture_dropped);
+    queue_push(queue, capture[2]);
+    ASSERT_EQ(queue_get_count(queue), 1u);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture[0]);
+    capture_dec_ref(capture_read);
+    queue_disable(queue);
+
+    // Block waits for a pop to make room
+    ASSERT_EQ(queue_configure(queue, 1, K4A_QUEUE_POLICY_BLOCK), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+    queue_push(queue, capture[0]);
+
+    queue_blocked_push_data_t data = { queue, capture[1] };
+    THREAD_HANDLE thread;
+    int thread_result;
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&thread, thread_blocked_push, &data));
+    ThreadAPI_Sleep(100);
+    ASSERT_EQ(queue_get_count(queue), 1u);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture[0]);
+    capture_dec_ref(capture_read);
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(thread, &thread_result));
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture[1]);
+    capture_dec_ref(capture_read);
+
+    // Disabling the queue releases a blocked push
+    queue_push(queue, capture[0]);
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&thread, thread_blocked_push, &data));
+    ThreadAPI_Sleep(100);
+    queue_disable(queue);
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(thread, &thread_result));
+    ASSERT_EQ(queue_get_count(queue), 0u);
+
+    // Growing the queue
+    ASSERT_EQ(queue_configure(queue, 3, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+    for (int i = 0; i < 3; i++)
+    {
+        queue_push(queue, capture[i]);
+    }
+    ASSERT_EQ(queue_get_count(queue), 3u);
+    queue_disable(queue);
+
+    // Lock-free queues can't be configured
+    queue_t queue_spsc;
+    ASSERT_EQ(queue_create_spsc(2, "queue_test", &queue_spsc), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_configure(queue_spsc, 1, K4A_QUEUE_POLICY_DROP_OLDEST), K4A_RESULT_FAILED);
+    queue_destroy(queue_spsc);
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture_dec_ref(capture[i]);
+    }
+    queue_destroy(queue);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
 TEST(queue_ut, queue_multiple_queues)
 {
     queue_t queue1, queue2, queue3;
@@ -740,6 +881,142 @@ TEST(queue_ut, queue_threaded)
     Lock_Deinit(lock);
 }
 
+TEST(queue_ut, queue_spsc)
+{
+    queue_t queue;
+    k4a_capture_t capture[3];
+    k4a_capture_t capture_read;
+    k4a_capture_t capture_dropped = NULL;
+
+    ASSERT_EQ(queue_create_spsc(2, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture[i] = capture_manufacture(10);
+        ASSERT_NE(capture[i], (k4a_capture_t)NULL);
+    }
+
+    // The oldest capture is dropped when the queue is full
+    queue_push_w_dropped(queue, capture[0], &capture_dropped);
+    ASSERT_EQ(capture_dropped, (k4a_capture_t)NULL);
+    queue_push_w_dropped(queue, capture[1], &capture_dropped);
+    ASSERT_EQ(capture_dropped, (k4a_capture_t)NULL);
+    queue_push_w_dropped(queue, capture[2], &capture_dropped);
+    ASSERT_EQ(capture_dropped, capture[0]);
+    capture_dec_ref(capture_dropped);
+    ASSERT_EQ(queue_get_count(queue), 2u);
+
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture[1]);
+    capture_dec_ref(capture_read);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture[2]);
+    capture_dec_ref(capture_read);
+
+    ASSERT_EQ(queue_get_count(queue), 0u);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_TIMEOUT);
+    ASSERT_EQ(queue_pop(queue, 100, &capture_read), K4A_WAIT_RESULT_TIMEOUT);
+
+    // Disabling drops what is left in the queue
+    queue_push(queue, capture[0]);
+    queue_disable(queue);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_FAILED);
+    ASSERT_EQ(capture_read, (k4a_capture_t)NULL);
+
+    for (int i = 0; i < 3; i++)
+    {
+        capture_dec_ref(capture[i]);
+    }
+    queue_destroy(queue);
+
+    // A blocking pop is woken by the producer
+    ASSERT_EQ(queue_create_spsc(TEST_QUEUE_DEPTH, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+
+    empty_queue_read_write_data_t data;
+    THREAD_HANDLE t1, t2;
+    int write_result, read_result;
+    data.queue = queue;
+    data.capture = capture_manufacture(10);
+    data.lock = Lock_Init();
+    data.pop_api_timeout = K4A_WAIT_INFINITE;
+    data.push_api_delay = 100;
+    ASSERT_NE(data.capture, (k4a_capture_t)NULL);
+    ASSERT_NE(data.lock, (LOCK_HANDLE)NULL);
+
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&t1, thread_pop_empty_queue_writer, &data));
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&t2, thread_pop_empty_queue_reader, &data));
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(t1, &write_result));
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(t2, &read_result));
+    ASSERT_EQ((k4a_wait_result_t)read_result, K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ((k4a_wait_result_t)write_result, K4A_WAIT_RESULT_SUCCEEDED);
+
+    capture_dec_ref(data.capture);
+    Lock_Deinit(data.lock);
+    queue_destroy(queue);
+
+    // Verify all our allocations were released
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(queue_ut, queue_spsc_threaded)
+{
+    queue_t queue;
+    LOCK_HANDLE lock;
+    threaded_queue_data_t writer, reader;
+    THREAD_HANDLE t1, r1;
+
+    ASSERT_EQ(queue_create_spsc(TEST_QUEUE_DEPTH, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+    ASSERT_NE((lock = Lock_Init()), (LOCK_HANDLE)NULL);
+
+    writer.queue = queue;
+    writer.pattern_start = 1;
+    writer.pattern_offset = 3;
+    writer.done_event = 0;
+    writer.error = 0;
+    writer.lock = lock;
+
+    reader.queue = queue;
+    reader.pattern_offset = 3;
+    reader.done_event = 0;
+    reader.error = 0;
+    reader.dropped = 0;
+    reader.lock = lock;
+
+    // prevent the threads from running
+    Lock(lock);
+
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&t1, thread_write_queue, &writer));
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&r1, thread_read_queue, &reader));
+
+    Unlock(lock);
+
+    // Wait for the thread to terminate
+    int result1, result2;
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(t1, &result1));
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(r1, &result2));
+
+    ASSERT_EQ(result1, TEST_RETURN_VALUE);
+    ASSERT_EQ(result2, TEST_RETURN_VALUE);
+
+    ASSERT_EQ(writer.error, (uint32_t)0);
+    ASSERT_EQ(reader.error, (uint32_t)0);
+
+    if (reader.dropped != 0)
+    {
+        GTEST_LOG_WARNING << "WARNING: queue dropped " << reader.dropped << " samples \n";
+    }
+
+    queue_destroy(queue);
+
+    // Verify all our allocations were released
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+
+    Lock_Deinit(lock);
+}
+
 TEST(queue_ut, queue_enable_disable)
 {
 
@@ -873,3 +1150,164 @@ TEST(queue_ut, queue_stop)
     queue_destroy(queue);
     ASSERT_EQ(allocator_test_for_leaks(), 0);
 }
+
+TEST(queue_ut, queue_waiter)
+{
+    queue_t queue;
+    queue_t queue_spsc;
+    queue_waiter_t waiter;
+    k4a_capture_t capture_read;
+
+    ASSERT_EQ(queue_create(TEST_QUEUE_DEPTH, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_create_spsc(TEST_QUEUE_DEPTH, "queue_test_spsc", &queue_spsc), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_waiter_create(&waiter), K4A_RESULT_SUCCEEDED);
+
+    // A disabled queue is ready, popping it fails without waiting
+    ASSERT_TRUE(queue_is_ready(queue));
+    ASSERT_TRUE(queue_is_ready(queue_spsc));
+    queue_enable(queue);
+    queue_enable(queue_spsc);
+    ASSERT_FALSE(queue_is_ready(queue));
+    ASSERT_FALSE(queue_is_ready(queue_spsc));
+
+    ASSERT_EQ(queue_add_waiter(queue, waiter), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_add_waiter(queue_spsc, waiter), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_waiter_wait(waiter, 0), K4A_WAIT_RESULT_TIMEOUT);
+    ASSERT_EQ(queue_waiter_wait(waiter, 10), K4A_WAIT_RESULT_TIMEOUT);
+
+    // A push from another thread wakes the waiter
+    empty_queue_read_write_data_t data;
+    THREAD_HANDLE t1;
+    int write_result;
+    data.queue = queue_spsc;
+    data.capture = capture_manufacture(10);
+    data.lock = Lock_Init();
+    data.pop_api_timeout = 0;
+    data.push_api_delay = 100;
+    ASSERT_NE(data.capture, (k4a_capture_t)NULL);
+    ASSERT_NE(data.lock, (LOCK_HANDLE)NULL);
+
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Create(&t1, thread_pop_empty_queue_writer, &data));
+    ASSERT_EQ(queue_waiter_wait(waiter, K4A_WAIT_INFINITE), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(THREADAPI_OK, ThreadAPI_Join(t1, &write_result));
+    ASSERT_TRUE(queue_is_ready(queue_spsc));
+    ASSERT_FALSE(queue_is_ready(queue));
+
+    ASSERT_EQ(queue_pop(queue_spsc, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    capture_dec_ref(capture_read);
+    ASSERT_FALSE(queue_is_ready(queue_spsc));
+    ASSERT_EQ(queue_waiter_wait(waiter, 0), K4A_WAIT_RESULT_TIMEOUT);
+
+    // A notification is kept until the next wait
+    queue_push(queue, data.capture);
+    ASSERT_TRUE(queue_is_ready(queue));
+    ASSERT_EQ(queue_waiter_wait(waiter, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    capture_dec_ref(capture_read);
+
+    // Disabling notifies, the queue is ready again
+    queue_disable(queue_spsc);
+    ASSERT_EQ(queue_waiter_wait(waiter, 0), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_TRUE(queue_is_ready(queue_spsc));
+
+    // A detached waiter is not notified
+    queue_remove_waiter(queue, waiter);
+    queue_push(queue, data.capture);
+    ASSERT_EQ(queue_waiter_wait(waiter, 0), K4A_WAIT_RESULT_TIMEOUT);
+
+    // The number of waiters per queue is limited
+    queue_waiter_t waiters[QUEUE_MAX_WAITERS];
+    for (int i = 0; i < QUEUE_MAX_WAITERS; i++)
+    {
+        ASSERT_EQ(queue_waiter_create(&waiters[i]), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(queue_add_waiter(queue, waiters[i]), K4A_RESULT_SUCCEEDED);
+    }
+    ASSERT_EQ(queue_add_waiter(queue, waiter), K4A_RESULT_FAILED);
+    for (int i = 0; i < QUEUE_MAX_WAITERS; i++)
+    {
+        queue_remove_waiter(queue, waiters[i]);
+        queue_waiter_destroy(waiters[i]);
+    }
+
+    queue_remove_waiter(queue_spsc, waiter);
+    queue_waiter_destroy(waiter);
+    capture_dec_ref(data.capture);
+    Lock_Deinit(data.lock);
+    queue_destroy(queue);
+    queue_destroy(queue_spsc);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
+
+TEST(queue_ut, queue_trace)
+{
+    queue_t queue;
+    k4a_capture_t capture1 = capture_manufacture(10);
+    k4a_capture_t capture2 = capture_manufacture(10);
+    k4a_capture_t capture_read;
+    const char *path = "queue_ut_trace.bin";
+
+    ASSERT_NE(capture1, (k4a_capture_t)NULL);
+    ASSERT_NE(capture2, (k4a_capture_t)NULL);
+    ASSERT_EQ(queue_create(1, "queue_test", &queue), K4A_RESULT_SUCCEEDED);
+    queue_enable(queue);
+
+    // The second push drops the first capture
+    queue_push(queue, capture1);
+    queue_push(queue, capture2);
+    ASSERT_EQ(queue_pop(queue, 0, &capture_read), K4A_WAIT_RESULT_SUCCEEDED);
+    ASSERT_EQ(capture_read, capture2);
+    capture_dec_ref(capture_read);
+
+    ASSERT_EQ(logger_trace_dump(NULL, 0), K4A_RESULT_FAILED);
+    ASSERT_EQ(logger_trace_dump(path, 10 * 1000000), K4A_RESULT_SUCCEEDED);
+
+    FILE *file = fopen(path, "rb");
+    ASSERT_NE(file, (FILE *)NULL);
+    logger_trace_file_header_t header;
+    ASSERT_EQ(fread(&header, sizeof(header), 1, file), 1u);
+    ASSERT_EQ(memcmp(header.magic, LOGGER_TRACE_FILE_MAGIC, sizeof(header.magic)), 0);
+    ASSERT_EQ(header.version, (uint32_t)LOGGER_TRACE_FILE_VERSION);
+    ASSERT_EQ(header.event_name_count, (uint32_t)LOGGER_TRACE_EVENT_COUNT);
+
+    // Event names follow the header, null terminated
+    for (uint32_t names = 0; names < header.event_name_count;)
+    {
+        int c = fgetc(file);
+        ASSERT_NE(c, EOF);
+        names += c == '\0' ? 1 : 0;
+    }
+
+    std::vector<logger_trace_record_t> records(header.record_count);
+    ASSERT_EQ(fread(records.data(), sizeof(logger_trace_record_t), records.size(), file), records.size());
+    ASSERT_EQ(fgetc(file), EOF);
+    fclose(file);
+    remove(path);
+
+    // The events of this test are recorded one after the other, on the same queue
+    const logger_trace_record_t expected[] = {
+        { 0, LOGGER_TRACE_QUEUE_PUSH, 0, { 0, (uintptr_t)capture1, 0 } },
+        { 0, LOGGER_TRACE_QUEUE_PUSH, 0, { 0, (uintptr_t)capture2, 0 } },
+        { 0, LOGGER_TRACE_QUEUE_DROP, 0, { 0, (uintptr_t)capture1, K4A_QUEUE_POLICY_DROP_OLDEST } },
+        { 0, LOGGER_TRACE_QUEUE_POP, 0, { 0, (uintptr_t)capture2, K4A_WAIT_RESULT_SUCCEEDED } },
+    };
+    size_t found = 0;
+    for (size_t first = 0; found != COUNTOF(expected) && first + COUNTOF(expected) <= records.size(); first++)
+    {
+        for (found = 0; found < COUNTOF(expected); found++)
+        {
+            const logger_trace_record_t &record = records[first + found];
+            const logger_trace_record_t &next = expected[found];
+            if (record.time_nsec == 0 || record.event != next.event || record.args[0] != records[first].args[0] ||
+                record.args[1] != next.args[1] || record.args[2] != next.args[2])
+            {
+                break;
+            }
+        }
+    }
+    ASSERT_EQ(found, COUNTOF(expected));
+
+    capture_dec_ref(capture1);
+    capture_dec_ref(capture2);
+    queue_destroy(queue);
+    ASSERT_EQ(allocator_test_for_leaks(), 0);
+}
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/simd.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+TEST(simd_ut, parse_level)
+{
+    simd_level_t level = SIMD_LEVEL_NONE;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("avx2", &level));
+    ASSERT_EQ(SIMD_LEVEL_AVX2, level);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("AVX512", &level));
+    ASSERT_EQ(SIMD_LEVEL_AVX512, level);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("SSE4.1", &level));
+    ASSERT_EQ(SIMD_LEVEL_SSE41, level);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("sse", &level));
+    ASSERT_EQ(SIMD_LEVEL_SSE41, level);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("Neon", &level));
+    ASSERT_EQ(SIMD_LEVEL_NEON, level);
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level("none", &level));
+    ASSERT_EQ(SIMD_LEVEL_NONE, level);
+
+    // Unknown names and prefixes of names leave the level unchanged
+    level = SIMD_LEVEL_AVX2;
+    ASSERT_EQ(K4A_RESULT_FAILED, simd_parse_level("avx", &level));
+    ASSERT_EQ(K4A_RESULT_FAILED, simd_parse_level("avx2x", &level));
+    ASSERT_EQ(K4A_RESULT_FAILED, simd_parse_level("", &level));
+    ASSERT_EQ(SIMD_LEVEL_AVX2, level);
+    ASSERT_EQ(K4A_RESULT_FAILED, simd_parse_level(NULL, &level));
+    ASSERT_EQ(K4A_RESULT_FAILED, simd_parse_level("avx2", NULL));
+}
+
+TEST(simd_ut, level_names)
+{
+    for (int level = SIMD_LEVEL_NONE; level <= SIMD_LEVEL_AVX512; level++)
+    {
+        // Every name parses back to its level
+        simd_level_t parsed;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, simd_parse_level(simd_get_level_name((simd_level_t)level), &parsed));
+        ASSERT_EQ(level, parsed);
+    }
+    ASSERT_STREQ("SSE", simd_get_level_name(SIMD_LEVEL_SSE41));
+}
+
+TEST(simd_ut, detected_level)
+{
+    simd_level_t supported = simd_get_supported_level();
+    simd_level_t level = simd_get_level();
+
+#if defined(K4A_USING_SSE)
+    // SSE4.1 is the baseline the library is compiled for
+    ASSERT_GE(supported, SIMD_LEVEL_SSE41);
+    ASSERT_NE(SIMD_LEVEL_NEON, level);
+#elif defined(K4A_USING_NEON)
+    ASSERT_EQ(SIMD_LEVEL_NEON, supported);
+#else
+    ASSERT_EQ(SIMD_LEVEL_NONE, supported);
+#endif
+
+    // K4A_SIMD_LEVEL can only lower the level
+    ASSERT_LE(level, supported);
+    ASSERT_EQ(level, simd_get_level());
+}
@@ -0,0 +1,212 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/tensor.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// Widths with and without a remainder for the vectorized kernels
+#define TEST_WIDTH (37)
+#define TEST_HEIGHT (13)
+
+static k4a_tensor_configuration_t make_config(k4a_image_format_t format, int width, int height)
+{
+    k4a_tensor_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    config.format = format;
+    config.image_width = width;
+    config.image_height = height;
+    config.tensor_width = width;
+    config.tensor_height = height;
+    config.data_type = K4A_TENSOR_DATA_TYPE_FLOAT32;
+    config.scale = 1.f;
+    config.std[0] = config.std[1] = config.std[2] = 1.f;
+    return config;
+}
+
+static k4a_transformation_image_descriptor_t make_descriptor(k4a_image_format_t format, int width, int height)
+{
+    k4a_transformation_image_descriptor_t descriptor;
+    descriptor.width_pixels = width;
+    descriptor.height_pixels = height;
+    descriptor.stride_bytes = width * (format == K4A_IMAGE_FORMAT_COLOR_BGRA32 ? 4 : 2);
+    descriptor.format = format;
+    return descriptor;
+}
+
+TEST(tensor_ut, bgra_normalized)
+{
+    std::vector<uint8_t> image((size_t)(TEST_WIDTH * TEST_HEIGHT * 4));
+    srand(1);
+    for (size_t i = 0; i < image.size(); i++)
+    {
+        image[i] = (uint8_t)(rand() % 256);
+    }
+
+    const float mean[3] = { 0.485f, 0.456f, 0.406f };
+    const float std_dev[3] = { 0.229f, 0.224f, 0.225f };
+    k4a_tensor_configuration_t config = make_config(K4A_IMAGE_FORMAT_COLOR_BGRA32, TEST_WIDTH, TEST_HEIGHT);
+    config.rgb = true;
+    config.scale = 1.f / 255.f;
+    memcpy(config.mean, mean, sizeof(mean));
+    memcpy(config.std, std_dev, sizeof(std_dev));
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(config.format, TEST_WIDTH, TEST_HEIGHT);
+
+    // Every thread count writes the same tensor
+    for (uint32_t thread_count : { 0u, 4u })
+    {
+        k4a_tensor_converter_t converter = NULL;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, thread_count, &converter));
+        ASSERT_EQ(3 * TEST_WIDTH * TEST_HEIGHT * sizeof(float), tensor_converter_get_size(converter));
+
+        std::vector<float> tensor((size_t)(3 * TEST_WIDTH * TEST_HEIGHT));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  tensor_converter_convert(
+                      converter, image.data(), &descriptor, tensor.data(), tensor.size() * sizeof(float)));
+        for (int c = 0; c < 3; c++)
+        {
+            for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+            {
+                // R, G, B planes from B, G, R pixels
+                float value = image[(size_t)(4 * i + 2 - c)] / 255.f;
+                ASSERT_NEAR((value - mean[c]) / std_dev[c], tensor[(size_t)(c * TEST_WIDTH * TEST_HEIGHT + i)], 1e-5f)
+                    << "channel " << c << " pixel " << i;
+            }
+        }
+        tensor_converter_destroy(converter);
+    }
+}
+
+TEST(tensor_ut, float16_rounding)
+{
+    const uint16_t image[8] = { 0, 1, 3, 2048, 2049, 2051, 65535, 1000 };
+    const uint16_t expected[8] = { 0x0000, 0x3c00, 0x4200, 0x6800, 0x6800, 0x6802, 0x7c00, 0x63d0 };
+
+    k4a_tensor_configuration_t config = make_config(K4A_IMAGE_FORMAT_DEPTH16, 8, 1);
+    config.data_type = K4A_TENSOR_DATA_TYPE_FLOAT16;
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(config.format, 8, 1);
+
+    k4a_tensor_converter_t converter = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, 0, &converter));
+    ASSERT_EQ(sizeof(expected), tensor_converter_get_size(converter));
+
+    uint16_t tensor[8];
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              tensor_converter_convert(converter, (const uint8_t *)image, &descriptor, tensor, sizeof(tensor)));
+    for (int i = 0; i < 8; i++)
+    {
+        ASSERT_EQ(expected[i], tensor[i]) << "value " << image[i];
+    }
+    tensor_converter_destroy(converter);
+}
+
+TEST(tensor_ut, resize)
+{
+    uint16_t image[8 * 4];
+    for (int i = 0; i < 8 * 4; i++)
+    {
+        image[i] = (uint16_t)(10 * i);
+    }
+
+    // Depth is downscaled with the pixel nearest to the center of each tensor pixel
+    k4a_tensor_configuration_t config = make_config(K4A_IMAGE_FORMAT_DEPTH16, 8, 4);
+    config.tensor_width = 4;
+    config.tensor_height = 2;
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(config.format, 8, 4);
+    const float nearest[8] = { 90, 110, 130, 150, 250, 270, 290, 310 };
+
+    k4a_tensor_converter_t converter = NULL;
+    float tensor[8];
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, 2, &converter));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              tensor_converter_convert(converter, (const uint8_t *)image, &descriptor, tensor, sizeof(tensor)));
+    for (int i = 0; i < 8; i++)
+    {
+        ASSERT_FLOAT_EQ(nearest[i], tensor[i]);
+    }
+    tensor_converter_destroy(converter);
+
+    // IR is downscaled bilinearly, each tensor pixel is centered between four image pixels
+    config.format = descriptor.format = K4A_IMAGE_FORMAT_IR16;
+    const float bilinear[8] = { 45, 65, 85, 105, 205, 225, 245, 265 };
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, 2, &converter));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              tensor_converter_convert(converter, (const uint8_t *)image, &descriptor, tensor, sizeof(tensor)));
+    for (int i = 0; i < 8; i++)
+    {
+        ASSERT_FLOAT_EQ(bilinear[i], tensor[i]);
+    }
+    tensor_converter_destroy(converter);
+
+    // Upscaling clamps to the border pixels
+    const uint16_t small[4] = { 0, 100, 200, 300 };
+    const float upscaled[16] = { 0, 25, 75, 100, 50, 75, 125, 150, 150, 175, 225, 250, 200, 225, 275, 300 };
+    config = make_config(K4A_IMAGE_FORMAT_IR16, 2, 2);
+    config.tensor_width = 4;
+    config.tensor_height = 4;
+    descriptor = make_descriptor(config.format, 2, 2);
+    float large[16];
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, 0, &converter));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              tensor_converter_convert(converter, (const uint8_t *)small, &descriptor, large, sizeof(large)));
+    for (int i = 0; i < 16; i++)
+    {
+        ASSERT_FLOAT_EQ(upscaled[i], large[i]);
+    }
+    tensor_converter_destroy(converter);
+}
+
+TEST(tensor_ut, invalid_arguments)
+{
+    k4a_tensor_configuration_t config = make_config(K4A_IMAGE_FORMAT_DEPTH16, TEST_WIDTH, TEST_HEIGHT);
+    k4a_tensor_converter_t converter = NULL;
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(NULL, 0, &converter));
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(&config, 0, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(&config, TENSOR_MAX_THREAD_COUNT + 1, &converter));
+
+    k4a_tensor_configuration_t wrong = config;
+    wrong.format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(&wrong, 0, &converter));
+    wrong = config;
+    wrong.std[0] = 0.f;
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(&wrong, 0, &converter));
+    wrong = config;
+    wrong.tensor_width = 0;
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_create(&wrong, 0, &converter));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, tensor_converter_create(&config, 0, &converter));
+    std::vector<uint16_t> image((size_t)(TEST_WIDTH * TEST_HEIGHT));
+    std::vector<float> tensor(image.size());
+    size_t tensor_size = tensor.size() * sizeof(float);
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(config.format, TEST_WIDTH, TEST_HEIGHT);
+    const uint8_t *image_data = (const uint8_t *)image.data();
+
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_convert(converter, NULL, &descriptor, tensor.data(), tensor_size));
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_convert(converter, image_data, NULL, tensor.data(), tensor_size));
+    ASSERT_EQ(K4A_RESULT_FAILED, tensor_converter_convert(converter, image_data, &descriptor, NULL, tensor_size));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              tensor_converter_convert(converter, image_data, &descriptor, tensor.data(), tensor_size - 1));
+
+    k4a_transformation_image_descriptor_t wrong_descriptor = descriptor;
+    wrong_descriptor.format = K4A_IMAGE_FORMAT_IR16;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              tensor_converter_convert(converter, image_data, &wrong_descriptor, tensor.data(), tensor_size));
+    wrong_descriptor = descriptor;
+    wrong_descriptor.width_pixels = TEST_WIDTH - 1;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              tensor_converter_convert(converter, image_data, &wrong_descriptor, tensor.data(), tensor_size));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              tensor_converter_convert(converter, image_data, &descriptor, tensor.data(), tensor_size));
+    tensor_converter_destroy(converter);
+}
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/threadpool.h>
+#include <gtest/gtest.h>
+
+#include <azure_c_shared_utility/threadapi.h>
+
+#include <atomic>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+#define TEST_TASK_COUNT (32)
+#define TEST_SUBMITTER_COUNT (4)
+
+typedef struct
+{
+    uint32_t index;
+    uint32_t result;
+    std::atomic<uint32_t> *run_count;
+} test_task_t;
+
+static int test_task_function(void *param)
+{
+    test_task_t *task = (test_task_t *)param;
+    task->result = task->index * task->index;
+    (*task->run_count)++;
+    return 0;
+}
+
+static void run_test_tasks()
+{
+    std::atomic<uint32_t> run_count(0);
+    test_task_t tasks[TEST_TASK_COUNT];
+    for (uint32_t i = 0; i < TEST_TASK_COUNT; i++)
+    {
+        tasks[i].index = i;
+        tasks[i].result = 0;
+        tasks[i].run_count = &run_count;
+    }
+
+    threadpool_run_tasks(test_task_function, tasks, sizeof(test_task_t), TEST_TASK_COUNT);
+
+    // Every task ran exactly once before threadpool_run_tasks() returned
+    ASSERT_EQ(run_count.load(), (uint32_t)TEST_TASK_COUNT);
+    for (uint32_t i = 0; i < TEST_TASK_COUNT; i++)
+    {
+        ASSERT_EQ(tasks[i].result, i * i);
+    }
+}
+
+static int run_test_tasks_thread(void *param)
+{
+    (void)param;
+    for (int i = 0; i < 100; i++)
+    {
+        run_test_tasks();
+    }
+    return 0;
+}
+
+TEST(threadpool_ut, run_tasks_without_workers)
+{
+    // Tasks run on the calling thread when the pool was never started
+    run_test_tasks();
+}
+
+TEST(threadpool_ut, run_tasks)
+{
+    ASSERT_EQ(threadpool_set_worker_count(THREADPOOL_MAX_WORKERS + 1), K4A_RESULT_FAILED);
+
+    for (uint32_t worker_count = 1; worker_count <= 4; worker_count++)
+    {
+        ASSERT_EQ(threadpool_set_worker_count(worker_count), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(threadpool_acquire(), K4A_RESULT_SUCCEEDED);
+        run_test_tasks();
+
+        // A second reference keeps the workers running after the first is released
+        ASSERT_EQ(threadpool_acquire(), K4A_RESULT_SUCCEEDED);
+        threadpool_release();
+        run_test_tasks();
+        threadpool_release();
+    }
+
+    ASSERT_EQ(threadpool_set_worker_count(0), K4A_RESULT_SUCCEEDED);
+}
+
+TEST(threadpool_ut, concurrent_submitters)
+{
+    ASSERT_EQ(threadpool_set_worker_count(2), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(threadpool_acquire(), K4A_RESULT_SUCCEEDED);
+
+    THREAD_HANDLE threads[TEST_SUBMITTER_COUNT];
+    for (int i = 0; i < TEST_SUBMITTER_COUNT; i++)
+    {
+        ASSERT_EQ(ThreadAPI_Create(&threads[i], run_test_tasks_thread, NULL), THREADAPI_OK);
+    }
+    for (int i = 0; i < TEST_SUBMITTER_COUNT; i++)
+    {
+        int thread_result;
+        ASSERT_EQ(ThreadAPI_Join(threads[i], &thread_result), THREADAPI_OK);
+    }
+
+    threadpool_release();
+    ASSERT_EQ(threadpool_set_worker_count(0), K4A_RESULT_SUCCEEDED);
+}
+
+TEST(threadpool_ut, affinity)
+{
+    ASSERT_EQ(threadpool_set_affinity(K4A_THREAD_ROLE_NUM, 1), K4A_RESULT_FAILED);
+    ASSERT_EQ(threadpool_set_affinity((k4a_thread_role_t)-1, 1), K4A_RESULT_FAILED);
+
+    // CPU 0 always exists, pinning to it must not affect running tasks
+    ASSERT_EQ(threadpool_set_affinity(K4A_THREAD_ROLE_WORKER, 1), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(threadpool_acquire(), K4A_RESULT_SUCCEEDED);
+    run_test_tasks();
+    threadpool_release();
+
+    ASSERT_EQ(threadpool_set_affinity(K4A_THREAD_ROLE_WORKER, 0), K4A_RESULT_SUCCEEDED);
+}
+
+TEST(threadpool_ut, priority)
+{
+    ASSERT_EQ(threadpool_set_priority(K4A_THREAD_ROLE_NUM, K4A_THREAD_PRIORITY_HIGH), K4A_RESULT_FAILED);
+    ASSERT_EQ(threadpool_set_priority(K4A_THREAD_ROLE_WORKER, (k4a_thread_priority_t)-1), K4A_RESULT_FAILED);
+    ASSERT_EQ(threadpool_set_priority(K4A_THREAD_ROLE_WORKER,
+                                      (k4a_thread_priority_t)(K4A_THREAD_PRIORITY_REALTIME + 1)),
+              K4A_RESULT_FAILED);
+
+    // Without the privilege to raise priorities the workers log a warning and still run the tasks
+    ASSERT_EQ(threadpool_set_priority(K4A_THREAD_ROLE_WORKER, K4A_THREAD_PRIORITY_REALTIME), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(threadpool_acquire(), K4A_RESULT_SUCCEEDED);
+    run_test_tasks();
+    threadpool_release();
+
+    ASSERT_EQ(threadpool_set_priority(K4A_THREAD_ROLE_WORKER, K4A_THREAD_PRIORITY_DEFAULT), K4A_RESULT_SUCCEEDED);
+}
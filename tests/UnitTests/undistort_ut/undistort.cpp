@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/undistort.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// Widths with and without a remainder for the vectorized kernels
+#define TEST_WIDTH (37)
+#define TEST_HEIGHT (13)
+
+// A camera without distortion, so that the map of its own intrinsics is the identity
+static k4a_calibration_camera_t make_test_camera()
+{
+    k4a_calibration_camera_t camera;
+    memset(&camera, 0, sizeof(camera));
+    camera.intrinsics.type = K4A_CALIBRATION_LENS_DISTORTION_MODEL_BROWN_CONRADY;
+    camera.intrinsics.parameter_count = 14;
+    camera.intrinsics.parameters.param.cx = 18.f;
+    camera.intrinsics.parameters.param.cy = 6.f;
+    camera.intrinsics.parameters.param.fx = 30.f;
+    camera.intrinsics.parameters.param.fy = 30.f;
+    camera.resolution_width = TEST_WIDTH;
+    camera.resolution_height = TEST_HEIGHT;
+    camera.metric_radius = 10.f;
+    return camera;
+}
+
+static k4a_transformation_image_descriptor_t make_descriptor(k4a_image_format_t format, int bytes_per_pixel)
+{
+    k4a_transformation_image_descriptor_t descriptor;
+    descriptor.width_pixels = TEST_WIDTH;
+    descriptor.height_pixels = TEST_HEIGHT;
+    descriptor.stride_bytes = TEST_WIDTH * bytes_per_pixel;
+    descriptor.format = format;
+    return descriptor;
+}
+
+static std::vector<uint16_t> make_test_image(unsigned int seed)
+{
+    std::vector<uint16_t> image((size_t)(TEST_WIDTH * TEST_HEIGHT));
+    srand(seed);
+    for (size_t i = 0; i < image.size(); i++)
+    {
+        image[i] = (uint16_t)(500 + rand() % 4000);
+    }
+    return image;
+}
+
+TEST(undistort_ut, identity)
+{
+    k4a_calibration_camera_t camera = make_test_camera();
+    std::vector<uint16_t> input = make_test_image(5);
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(K4A_IMAGE_FORMAT_IR16, 2);
+
+    for (uint32_t thread_count = 0; thread_count <= 4; thread_count += 4)
+    {
+        k4a_undistortion_map_t map = NULL;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, undistort_map_create(&camera, NULL, NULL, thread_count, &map));
+
+        const k4a_transformation_interpolation_type_t types[] = { K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST,
+                                                                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR };
+        for (k4a_transformation_interpolation_type_t type : types)
+        {
+            std::vector<uint16_t> output(input.size(), 1);
+            ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                      undistort_map_remap(map,
+                                          (const uint8_t *)input.data(),
+                                          &descriptor,
+                                          (uint8_t *)output.data(),
+                                          &descriptor,
+                                          type));
+            ASSERT_EQ(input, output);
+        }
+        undistort_map_destroy(map);
+    }
+}
+
+TEST(undistort_ut, bilinear)
+{
+    // A target shifted by half a pixel samples halfway between two columns of the camera
+    k4a_calibration_camera_t camera = make_test_camera();
+    k4a_pinhole_t target = { 18.f + 0.5f, 6.f, 30.f, 30.f, TEST_WIDTH, TEST_HEIGHT };
+    std::vector<uint16_t> input = make_test_image(7);
+    input[(size_t)(4 * TEST_WIDTH + 10)] = 0;
+
+    k4a_undistortion_map_t map = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, undistort_map_create(&camera, &target, NULL, 0, &map));
+
+    const k4a_image_format_t formats[] = { K4A_IMAGE_FORMAT_IR16, K4A_IMAGE_FORMAT_DEPTH16 };
+    for (k4a_image_format_t format : formats)
+    {
+        k4a_transformation_image_descriptor_t descriptor = make_descriptor(format, 2);
+        std::vector<uint16_t> output(input.size(), 1);
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  undistort_map_remap(map,
+                                      (const uint8_t *)input.data(),
+                                      &descriptor,
+                                      (uint8_t *)output.data(),
+                                      &descriptor,
+                                      K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR));
+
+        for (int y = 0; y < TEST_HEIGHT; y++)
+        {
+            // The first column projects left of the camera image
+            ASSERT_EQ(0, output[(size_t)(y * TEST_WIDTH)]);
+            for (int x = 1; x < TEST_WIDTH; x++)
+            {
+                uint16_t left = input[(size_t)(y * TEST_WIDTH + x - 1)];
+                uint16_t right = input[(size_t)(y * TEST_WIDTH + x)];
+                int expected = (left + right + 1) / 2;
+                if (format == K4A_IMAGE_FORMAT_DEPTH16 && (left == 0 || right == 0))
+                {
+                    expected = 0;
+                }
+                ASSERT_NEAR(expected, output[(size_t)(y * TEST_WIDTH + x)], 1) << "x " << x << " y " << y;
+            }
+        }
+    }
+    undistort_map_destroy(map);
+}
+
+TEST(undistort_ut, bgra)
+{
+    k4a_calibration_camera_t camera = make_test_camera();
+    std::vector<uint8_t> input((size_t)(TEST_WIDTH * TEST_HEIGHT * 4));
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        input[i] = (uint8_t)(i * 7);
+    }
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(K4A_IMAGE_FORMAT_COLOR_BGRA32, 4);
+
+    k4a_undistortion_map_t map = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, undistort_map_create(&camera, NULL, NULL, 2, &map));
+    std::vector<uint8_t> output(input.size());
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              undistort_map_remap(map,
+                                  input.data(),
+                                  &descriptor,
+                                  output.data(),
+                                  &descriptor,
+                                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_LINEAR));
+    ASSERT_EQ(input, output);
+    undistort_map_destroy(map);
+}
+
+TEST(undistort_ut, invalid_arguments)
+{
+    k4a_calibration_camera_t camera = make_test_camera();
+    k4a_undistortion_map_t map = NULL;
+    ASSERT_EQ(K4A_RESULT_FAILED, undistort_map_create(NULL, NULL, NULL, 0, &map));
+    ASSERT_EQ(K4A_RESULT_FAILED, undistort_map_create(&camera, NULL, NULL, 0, NULL));
+    ASSERT_EQ(K4A_RESULT_FAILED, undistort_map_create(&camera, NULL, NULL, UNDISTORT_MAX_THREAD_COUNT + 1, &map));
+    k4a_pinhole_t target = { 0.f, 0.f, 0.f, 30.f, TEST_WIDTH, TEST_HEIGHT };
+    ASSERT_EQ(K4A_RESULT_FAILED, undistort_map_create(&camera, &target, NULL, 0, &map));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, undistort_map_create(&camera, NULL, NULL, 0, &map));
+    std::vector<uint16_t> image((size_t)(TEST_WIDTH * TEST_HEIGHT));
+    k4a_transformation_image_descriptor_t descriptor = make_descriptor(K4A_IMAGE_FORMAT_DEPTH16, 2);
+
+    // Formats and resolutions that do not match the map
+    k4a_transformation_image_descriptor_t wrong = descriptor;
+    wrong.format = K4A_IMAGE_FORMAT_CUSTOM16;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              undistort_map_remap(map,
+                                  (const uint8_t *)image.data(),
+                                  &wrong,
+                                  (uint8_t *)image.data(),
+                                  &wrong,
+                                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST));
+    wrong = descriptor;
+    wrong.width_pixels = TEST_WIDTH - 1;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              undistort_map_remap(map,
+                                  (const uint8_t *)image.data(),
+                                  &descriptor,
+                                  (uint8_t *)image.data(),
+                                  &wrong,
+                                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST));
+    wrong = descriptor;
+    wrong.format = K4A_IMAGE_FORMAT_IR16;
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              undistort_map_remap(map,
+                                  (const uint8_t *)image.data(),
+                                  &descriptor,
+                                  (uint8_t *)image.data(),
+                                  &wrong,
+                                  K4A_TRANSFORMATION_INTERPOLATION_TYPE_NEAREST));
+    undistort_map_destroy(map);
+}
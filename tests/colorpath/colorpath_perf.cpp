@@ -0,0 +1,843 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4a/k4a.h>
+#include <k4arecord/playback.h>
+#include <k4arecord/record.h>
+#include <k4ainternal/cdloader.h>
+#include <k4ainternal/common.h>
+
+#include <turbojpeg.h>
+#include <libyuv.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// Benchmarks of the color path, run without a device on frames generated at every color resolution:
+// - MJPEG decoding as done by the color readers and playback, BGRA32 at full and scaled sizes, with one decoder or a
+//   pool of decoders on several threads, in software with turbojpeg or with the hardware decoder plugin. The Y, U and V
+//   plane decode of the viewer's MJPG converter is measured the same way.
+// - The libyuv conversions of playback, NV12 and YUY2 to BGRA32 and BGRA32 to NV12 and YUY2.
+// - Playback of recordings written by the benchmark, through k4a_playback_get_next_capture() with a color conversion,
+//   color scale and color read ahead, which covers convert_block_to_image() along with reading the file.
+// Results are printed and appended to colorpath_perf_results.csv.
+
+static uint32_t g_iterations = 60;
+
+using ::testing::ValuesIn;
+
+typedef std::chrono::high_resolution_clock clock_type;
+
+// Runs body(thread_index) on thread_count threads released at the same time, returns the seconds until all returned
+template<typename F> static double run_threads(int thread_count, F body)
+{
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back([&go, &body, i]() {
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            body(i);
+        });
+    }
+
+    auto start = clock_type::now();
+    go.store(true);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+static const char *resolution_name(k4a_color_resolution_t resolution)
+{
+    switch (resolution)
+    {
+    case K4A_COLOR_RESOLUTION_720P:
+        return "720P";
+    case K4A_COLOR_RESOLUTION_1080P:
+        return "1080P";
+    case K4A_COLOR_RESOLUTION_1440P:
+        return "1440P";
+    case K4A_COLOR_RESOLUTION_1536P:
+        return "1536P";
+    case K4A_COLOR_RESOLUTION_2160P:
+        return "2160P";
+    case K4A_COLOR_RESOLUTION_3072P:
+        return "3072P";
+    default:
+        return "unknown";
+    }
+}
+
+static const char *format_name(k4a_image_format_t format)
+{
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        return "MJPG";
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        return "NV12";
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        return "YUY2";
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        return "BGRA32";
+    default:
+        return "unknown";
+    }
+}
+
+// Size of a frame decoded at a color scale, rounded up the same way as turbojpeg and k4a_playback_set_color_scale()
+static int scaled_size(int size, k4a_color_scale_t scale)
+{
+    tjscalingfactor scaling_factor = { 1, 1 << scale };
+    return TJSCALED(size, scaling_factor);
+}
+
+//
+// Sample frames
+//
+
+// One frame of a color resolution in each format the camera produces, generated from the same BGRA32 picture
+struct color_sample
+{
+    int width;
+    int height;
+    std::vector<uint8_t> bgra;
+    std::vector<uint8_t> mjpeg;
+    std::vector<uint8_t> nv12;
+    std::vector<uint8_t> yuy2;
+};
+
+// Builds a picture with smooth gradients, edges and some noise, so the JPEG compresses to a size close to a camera
+// frame instead of the trivially small size of a flat image. Encoded with 4:2:2 chroma subsampling like the camera.
+static std::unique_ptr<color_sample> create_color_sample(k4a_color_resolution_t resolution)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!k4a_convert_resolution_to_width_height(resolution, &width, &height))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<color_sample> sample(new color_sample());
+    sample->width = (int)width;
+    sample->height = (int)height;
+    sample->bgra.resize((size_t)width * height * 4);
+
+    uint32_t noise = 0x12345678;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint8_t *row = sample->bgra.data() + (size_t)y * width * 4;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            noise = noise * 1664525 + 1013904223;
+            uint8_t grain = (uint8_t)(noise >> 28);
+            bool checker = ((x / 64) + (y / 64)) % 2 == 0;
+            row[x * 4 + 0] = (uint8_t)(x * 255 / width + grain);
+            row[x * 4 + 1] = (uint8_t)(y * 255 / height + grain);
+            row[x * 4 + 2] = (uint8_t)((checker ? 192 : 64) + grain);
+            row[x * 4 + 3] = 0xFF;
+        }
+    }
+
+    tjhandle compressor = tjInitCompress();
+    if (compressor == NULL)
+    {
+        return nullptr;
+    }
+
+    unsigned char *jpeg = NULL;
+    unsigned long jpeg_size = 0;
+    int compress_status = tjCompress2(compressor,
+                                      sample->bgra.data(),
+                                      (int)width,
+                                      0, // pitch
+                                      (int)height,
+                                      TJPF_BGRA,
+                                      &jpeg,
+                                      &jpeg_size,
+                                      TJSAMP_422,
+                                      90, // quality
+                                      TJFLAG_FASTDCT);
+    if (compress_status == 0)
+    {
+        sample->mjpeg.assign(jpeg, jpeg + jpeg_size);
+    }
+    tjFree(jpeg);
+    (void)tjDestroy(compressor);
+    if (compress_status != 0)
+    {
+        return nullptr;
+    }
+
+    // The endianness of libyuv's ARGB is opposite our BGRA format. They are the same byte order.
+    size_t y_plane_size = (size_t)width * height;
+    sample->nv12.resize(y_plane_size + (y_plane_size + 1) / 2);
+    sample->yuy2.resize((size_t)width * height * 2);
+    if (libyuv::ARGBToNV12(sample->bgra.data(),
+                           (int)width * 4,
+                           sample->nv12.data(),
+                           (int)width,
+                           sample->nv12.data() + y_plane_size,
+                           (int)width,
+                           (int)width,
+                           (int)height) != 0 ||
+        libyuv::ARGBToYUY2(sample->bgra.data(),
+                           (int)width * 4,
+                           sample->yuy2.data(),
+                           (int)width * 2,
+                           (int)width,
+                           (int)height) != 0)
+    {
+        return nullptr;
+    }
+
+    return sample;
+}
+
+// Returns the sample of a resolution, created on first use and kept for the other benchmarks
+static const color_sample *get_color_sample(k4a_color_resolution_t resolution)
+{
+    static std::map<k4a_color_resolution_t, std::unique_ptr<color_sample>> samples;
+    auto found = samples.find(resolution);
+    if (found == samples.end())
+    {
+        found = samples.emplace(resolution, create_color_sample(resolution)).first;
+    }
+    return found->second.get();
+}
+
+class colorpath_perf_base : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("colorpath_perf_results.csv", "a")));
+    }
+
+    virtual void TearDown()
+    {
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    void report(const char *benchmark, const char *settings, uint64_t frames, double seconds)
+    {
+        double ms_per_frame = frames ? seconds * 1000 / (double)frames : 0;
+        double frames_per_second = seconds > 0 ? (double)frames / seconds : 0;
+        printf("    %-16s %-52s %8.1f fps %9.3f ms/frame\n", benchmark, settings, frames_per_second, ms_per_frame);
+
+        if (m_file_handle)
+        {
+            // Write the header when the file is new
+            if (ftell(m_file_handle) == 0)
+            {
+                fprintf(m_file_handle, "benchmark,settings,frames,seconds,frames_per_second,ms_per_frame\n");
+            }
+            fprintf(m_file_handle,
+                    "%s,%s,%llu,%f,%f,%f\n",
+                    benchmark,
+                    settings,
+                    (unsigned long long)frames,
+                    seconds,
+                    frames_per_second,
+                    ms_per_frame);
+        }
+    }
+
+    FILE *m_file_handle;
+};
+
+//
+// MJPEG decode
+//
+
+enum mjpeg_backend
+{
+    MJPEG_SOFTWARE,   // turbojpeg to BGRA32, like the color readers and playback
+    MJPEG_HARDWARE,   // the color decoder plugin to BGRA32, frames it doesn't support are decoded in software
+    MJPEG_YUV_PLANES, // turbojpeg to Y, U and V planes, like the MJPG converter of the viewer
+};
+
+struct mjpeg_parameters
+{
+    int test_number;
+    k4a_color_resolution_t resolution;
+    k4a_color_scale_t scale;
+    int decoders; // 1 decodes every frame with one decoder, more is a pool of decoders each used by its own thread
+    mjpeg_backend backend;
+
+    friend std::ostream &operator<<(std::ostream &os, const mjpeg_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class mjpeg_perf : public colorpath_perf_base, public ::testing::WithParamInterface<mjpeg_parameters>
+{
+};
+
+TEST_P(mjpeg_perf, decode)
+{
+    auto as = GetParam();
+    const color_sample *sample = get_color_sample(as.resolution);
+    ASSERT_NE(sample, nullptr);
+
+    if (as.backend == MJPEG_HARDWARE && !cdloader_is_loaded())
+    {
+        printf("    Skipped, set K4A_COLOR_HARDWARE_DECODE=1 with the color decoder plugin installed to run it\n");
+        return;
+    }
+
+    int width = scaled_size(sample->width, as.scale);
+    int height = scaled_size(sample->height, as.scale);
+
+    // Each decoder has its own turbojpeg instance and output buffer, like the frame workers of the color readers
+    struct decoder
+    {
+        tjhandle turbojpeg = NULL;
+        k4a_decoder_context_t *hardware = NULL;
+        std::vector<uint8_t> output;
+    };
+    std::vector<decoder> decoders((size_t)as.decoders);
+    for (auto &d : decoders)
+    {
+        d.turbojpeg = tjInitDecompress();
+        ASSERT_NE(d.turbojpeg, nullptr);
+        // The Y, U and V planes take at most 3 bytes per pixel, 4:4:4 with one byte of padding per row
+        d.output.resize((size_t)width * height * 4);
+        if (as.backend == MJPEG_HARDWARE)
+        {
+            ASSERT_EQ(K4A_DECODER_RESULT_SUCCEEDED,
+                      cdloader_decoder_create(&d.hardware, (uint32_t)width, (uint32_t)height));
+        }
+    }
+
+    std::atomic<uint32_t> next_frame(0);
+    std::atomic<uint64_t> software_fallbacks(0);
+    std::atomic<bool> failed(false);
+
+    double seconds = run_threads(as.decoders, [&](int index) {
+        decoder &d = decoders[(size_t)index];
+        while (next_frame++ < g_iterations && !failed)
+        {
+            int status = 0;
+            if (as.backend == MJPEG_YUV_PLANES)
+            {
+                status = tjDecompressToYUV2(d.turbojpeg,
+                                            sample->mjpeg.data(),
+                                            (unsigned long)sample->mjpeg.size(),
+                                            d.output.data(),
+                                            width,
+                                            1, // pad
+                                            height,
+                                            TJFLAG_FASTDCT);
+            }
+            else
+            {
+                if (d.hardware != NULL)
+                {
+                    k4a_decoder_result_code_t result = cdloader_decode_mjpeg(d.hardware,
+                                                                             sample->mjpeg.data(),
+                                                                             sample->mjpeg.size(),
+                                                                             d.output.data(),
+                                                                             (uint32_t)width * 4,
+                                                                             d.output.size());
+                    if (result == K4A_DECODER_RESULT_SUCCEEDED)
+                    {
+                        continue;
+                    }
+                    if (result != K4A_DECODER_RESULT_UNSUPPORTED)
+                    {
+                        failed = true;
+                        break;
+                    }
+                    software_fallbacks++;
+                }
+
+                status = tjDecompress2(d.turbojpeg,
+                                       sample->mjpeg.data(),
+                                       (unsigned long)sample->mjpeg.size(),
+                                       d.output.data(),
+                                       width,
+                                       0, // pitch
+                                       height,
+                                       TJPF_BGRA,
+                                       TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE);
+            }
+
+            if (status != 0)
+            {
+                failed = true;
+            }
+        }
+    });
+
+    for (auto &d : decoders)
+    {
+        if (d.hardware != NULL)
+        {
+            cdloader_decoder_destroy(&d.hardware);
+        }
+        (void)tjDestroy(d.turbojpeg);
+    }
+    ASSERT_FALSE(failed.load());
+
+    static const char *backend_names[] = { "software", "hardware", "yuv_planes" };
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%s %s %dx%d decoders %d jpeg %zu fallbacks %llu",
+             resolution_name(as.resolution),
+             backend_names[as.backend],
+             width,
+             height,
+             as.decoders,
+             sample->mjpeg.size(),
+             (unsigned long long)software_fallbacks.load());
+    report("mjpeg_decode", settings, g_iterations, seconds);
+}
+
+// clang-format off
+static struct mjpeg_parameters mjpeg_tests[] = {
+    // Full and scaled software decode with one decoder at every resolution
+    { 0, K4A_COLOR_RESOLUTION_720P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 1, K4A_COLOR_RESOLUTION_720P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 2, K4A_COLOR_RESOLUTION_720P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 3, K4A_COLOR_RESOLUTION_720P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    { 4, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 5, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 6, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 7, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    { 8, K4A_COLOR_RESOLUTION_1440P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 9, K4A_COLOR_RESOLUTION_1440P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 10, K4A_COLOR_RESOLUTION_1440P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 11, K4A_COLOR_RESOLUTION_1440P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    { 12, K4A_COLOR_RESOLUTION_1536P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 13, K4A_COLOR_RESOLUTION_1536P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 14, K4A_COLOR_RESOLUTION_1536P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 15, K4A_COLOR_RESOLUTION_1536P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    { 16, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 17, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 18, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 19, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    { 20, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_FULL, 1, MJPEG_SOFTWARE },
+    { 21, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_HALF, 1, MJPEG_SOFTWARE },
+    { 22, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_QUARTER, 1, MJPEG_SOFTWARE },
+    { 23, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_EIGHTH, 1, MJPEG_SOFTWARE },
+    // Pools of decoders, the default of 2 frame workers of the color reader and a larger pool
+    { 24, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_FULL, 2, MJPEG_SOFTWARE },
+    { 25, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_FULL, 4, MJPEG_SOFTWARE },
+    { 26, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 2, MJPEG_SOFTWARE },
+    { 27, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 4, MJPEG_SOFTWARE },
+    { 28, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_FULL, 2, MJPEG_SOFTWARE },
+    { 29, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_FULL, 4, MJPEG_SOFTWARE },
+    // Hardware decoder plugin, only run when it is loaded
+    { 30, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_FULL, 1, MJPEG_HARDWARE },
+    { 31, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 1, MJPEG_HARDWARE },
+    { 32, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_HALF, 1, MJPEG_HARDWARE },
+    { 33, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 2, MJPEG_HARDWARE },
+    { 34, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_FULL, 1, MJPEG_HARDWARE },
+    // The viewer decodes to planes and converts to RGB on the GPU
+    { 35, K4A_COLOR_RESOLUTION_720P, K4A_COLOR_SCALE_FULL, 1, MJPEG_YUV_PLANES },
+    { 36, K4A_COLOR_RESOLUTION_1080P, K4A_COLOR_SCALE_FULL, 1, MJPEG_YUV_PLANES },
+    { 37, K4A_COLOR_RESOLUTION_2160P, K4A_COLOR_SCALE_FULL, 1, MJPEG_YUV_PLANES },
+    { 38, K4A_COLOR_RESOLUTION_3072P, K4A_COLOR_SCALE_FULL, 1, MJPEG_YUV_PLANES },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(MJPEG_TESTS, mjpeg_perf, ValuesIn(mjpeg_tests));
+
+//
+// libyuv conversions
+//
+
+struct convert_parameters
+{
+    int test_number;
+    k4a_color_resolution_t resolution;
+    k4a_image_format_t source_format;
+    k4a_image_format_t target_format;
+
+    friend std::ostream &operator<<(std::ostream &os, const convert_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class convert_perf : public colorpath_perf_base, public ::testing::WithParamInterface<convert_parameters>
+{
+};
+
+TEST_P(convert_perf, convert)
+{
+    auto as = GetParam();
+    const color_sample *sample = get_color_sample(as.resolution);
+    ASSERT_NE(sample, nullptr);
+
+    int width = sample->width;
+    int height = sample->height;
+    size_t y_plane_size = (size_t)width * height;
+    std::vector<uint8_t> output(y_plane_size * 4);
+
+    // The same calls as decode_color_to_bgra() and convert_block_to_image() in playback
+    auto start = clock_type::now();
+    for (uint32_t i = 0; i < g_iterations; i++)
+    {
+        int status = -1;
+        if (as.source_format == K4A_IMAGE_FORMAT_COLOR_NV12)
+        {
+            status = libyuv::NV12ToARGB(sample->nv12.data(),
+                                        width,
+                                        sample->nv12.data() + y_plane_size,
+                                        width,
+                                        output.data(),
+                                        width * 4,
+                                        width,
+                                        height);
+        }
+        else if (as.source_format == K4A_IMAGE_FORMAT_COLOR_YUY2)
+        {
+            status = libyuv::YUY2ToARGB(sample->yuy2.data(), width * 2, output.data(), width * 4, width, height);
+        }
+        else if (as.target_format == K4A_IMAGE_FORMAT_COLOR_NV12)
+        {
+            status = libyuv::ARGBToNV12(sample->bgra.data(),
+                                        width * 4,
+                                        output.data(),
+                                        width,
+                                        output.data() + y_plane_size,
+                                        width,
+                                        width,
+                                        height);
+        }
+        else if (as.target_format == K4A_IMAGE_FORMAT_COLOR_YUY2)
+        {
+            status = libyuv::ARGBToYUY2(sample->bgra.data(), width * 4, output.data(), width * 2, width, height);
+        }
+        ASSERT_EQ(status, 0);
+    }
+    double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%s %s to %s",
+             resolution_name(as.resolution),
+             format_name(as.source_format),
+             format_name(as.target_format));
+    report("libyuv_convert", settings, g_iterations, seconds);
+}
+
+// clang-format off
+static struct convert_parameters convert_tests[] = {
+    // The camera only streams NV12 and YUY2 at 720P
+    { 0, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_NV12, K4A_IMAGE_FORMAT_COLOR_BGRA32 },
+    { 1, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_YUY2, K4A_IMAGE_FORMAT_COLOR_BGRA32 },
+    // Playback converts decoded MJPG frames of every resolution to NV12 and YUY2
+    { 2, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 3, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    { 4, K4A_COLOR_RESOLUTION_1080P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 5, K4A_COLOR_RESOLUTION_1080P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    { 6, K4A_COLOR_RESOLUTION_1440P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 7, K4A_COLOR_RESOLUTION_1440P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    { 8, K4A_COLOR_RESOLUTION_1536P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 9, K4A_COLOR_RESOLUTION_1536P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    { 10, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 11, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+    { 12, K4A_COLOR_RESOLUTION_3072P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_NV12 },
+    { 13, K4A_COLOR_RESOLUTION_3072P, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_IMAGE_FORMAT_COLOR_YUY2 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(CONVERT_TESTS, convert_perf, ValuesIn(convert_tests));
+
+//
+// Playback
+//
+
+struct playback_parameters
+{
+    int test_number;
+    k4a_color_resolution_t resolution;
+    k4a_image_format_t recorded_format;
+    k4a_image_format_t target_format;
+    k4a_color_scale_t scale;
+    uint32_t read_ahead; // captures converted ahead on background threads, 0 converts on the reading thread
+
+    friend std::ostream &operator<<(std::ostream &os, const playback_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class playback_perf : public colorpath_perf_base, public ::testing::WithParamInterface<playback_parameters>
+{
+};
+
+// Writes a recording with only a color track, holding g_iterations copies of the sample frame in the given format
+static bool write_color_recording(const char *path, const color_sample *sample, k4a_device_configuration_t config)
+{
+    const std::vector<uint8_t> *frame = NULL;
+    int stride = 0;
+    switch (config.color_format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        frame = &sample->mjpeg;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        frame = &sample->nv12;
+        stride = sample->width;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+        frame = &sample->yuy2;
+        stride = sample->width * 2;
+        break;
+    default:
+        return false;
+    }
+
+    k4a_record_t recording = NULL;
+    if (K4A_FAILED(k4a_record_create(path, NULL, config, &recording)))
+    {
+        return false;
+    }
+
+    bool succeeded = K4A_SUCCEEDED(k4a_record_write_header(recording));
+    uint64_t frame_period_usec = 1000000 / (uint64_t)k4a_convert_fps_to_uint(config.camera_fps);
+    for (uint32_t i = 0; succeeded && i < g_iterations; i++)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_image_t image = NULL;
+        // The images point at the sample frame, which outlives the recording, instead of copying it
+        succeeded = K4A_SUCCEEDED(k4a_capture_create(&capture)) &&
+                    K4A_SUCCEEDED(k4a_image_create_from_buffer(config.color_format,
+                                                               sample->width,
+                                                               sample->height,
+                                                               stride,
+                                                               const_cast<uint8_t *>(frame->data()),
+                                                               frame->size(),
+                                                               NULL,
+                                                               NULL,
+                                                               &image));
+        if (succeeded)
+        {
+            k4a_image_set_device_timestamp_usec(image, i * frame_period_usec);
+            k4a_capture_set_color_image(capture, image);
+            succeeded = K4A_SUCCEEDED(k4a_record_write_capture(recording, capture));
+        }
+        if (image)
+        {
+            k4a_image_release(image);
+        }
+        if (capture)
+        {
+            k4a_capture_release(capture);
+        }
+    }
+
+    succeeded = succeeded && K4A_SUCCEEDED(k4a_record_flush(recording));
+    k4a_record_close(recording);
+    return succeeded;
+}
+
+TEST_P(playback_perf, get_next_capture)
+{
+    auto as = GetParam();
+    const color_sample *sample = get_color_sample(as.resolution);
+    ASSERT_NE(sample, nullptr);
+
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    config.color_format = as.recorded_format;
+    config.color_resolution = as.resolution;
+    config.camera_fps = as.resolution == K4A_COLOR_RESOLUTION_3072P ? K4A_FRAMES_PER_SECOND_15 :
+                                                                      K4A_FRAMES_PER_SECOND_30;
+
+    char path[64];
+    snprintf(path,
+             sizeof(path),
+             "colorpath_perf_%s_%s.mkv",
+             resolution_name(as.resolution),
+             format_name(as.recorded_format));
+    ASSERT_TRUE(write_color_recording(path, sample, config));
+
+    k4a_playback_t playback = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_open(path, &playback));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_color_conversion(playback, as.target_format));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_color_scale(playback, as.scale));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_playback_set_color_read_ahead(playback, as.read_ahead));
+
+    uint64_t frames = 0;
+    bool failed = false;
+    int width = 0;
+    int height = 0;
+    auto start = clock_type::now();
+    while (true)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t result = k4a_playback_get_next_capture(playback, &capture);
+        if (result != K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            failed = result == K4A_STREAM_RESULT_FAILED;
+            break;
+        }
+
+        k4a_image_t image = k4a_capture_get_color_image(capture);
+        if (image == NULL || k4a_image_get_format(image) != as.target_format || k4a_image_get_buffer(image) == NULL)
+        {
+            failed = true;
+        }
+        else
+        {
+            width = k4a_image_get_width_pixels(image);
+            height = k4a_image_get_height_pixels(image);
+            frames++;
+        }
+
+        if (image)
+        {
+            k4a_image_release(image);
+        }
+        k4a_capture_release(capture);
+        if (failed)
+        {
+            break;
+        }
+    }
+    double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    k4a_playback_close(playback);
+    ASSERT_EQ(std::remove(path), 0);
+    ASSERT_FALSE(failed);
+    ASSERT_EQ(frames, (uint64_t)g_iterations);
+
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%s %s to %s %dx%d read ahead %u",
+             resolution_name(as.resolution),
+             format_name(as.recorded_format),
+             format_name(as.target_format),
+             width,
+             height,
+             as.read_ahead);
+    report("playback", settings, frames, seconds);
+}
+
+// clang-format off
+static struct playback_parameters playback_tests[] = {
+    // MJPG to BGRA32 at every resolution, full and scaled
+    { 0, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 1, K4A_COLOR_RESOLUTION_1080P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 2, K4A_COLOR_RESOLUTION_1440P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 3, K4A_COLOR_RESOLUTION_1536P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 4, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 5, K4A_COLOR_RESOLUTION_3072P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 6, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_HALF, 0 },
+    { 7, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_QUARTER, 0 },
+    { 8, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_EIGHTH, 0 },
+    // Decoding on the read ahead threads, with their pool of turbojpeg decompressors
+    { 9, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 2 },
+    { 10, K4A_COLOR_RESOLUTION_2160P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 8 },
+    { 11, K4A_COLOR_RESOLUTION_3072P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 8 },
+    // MJPG through BGRA32 to NV12 and YUY2
+    { 12, K4A_COLOR_RESOLUTION_1080P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_NV12,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 13, K4A_COLOR_RESOLUTION_1080P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_YUY2,
+      K4A_COLOR_SCALE_FULL, 0 },
+    // NV12 and YUY2 recordings to BGRA32, and read as they are stored
+    { 14, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_NV12, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 15, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_YUY2, K4A_IMAGE_FORMAT_COLOR_BGRA32,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 16, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_NV12, K4A_IMAGE_FORMAT_COLOR_NV12,
+      K4A_COLOR_SCALE_FULL, 0 },
+    { 17, K4A_COLOR_RESOLUTION_720P, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_IMAGE_FORMAT_COLOR_MJPG,
+      K4A_COLOR_SCALE_FULL, 0 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(PLAYBACK_TESTS, playback_perf, ValuesIn(playback_tests));
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+
+        if (strcmp(argument, "--iterations") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_iterations = (uint32_t)strtoul(argv[++i], NULL, 10);
+                if (g_iterations == 0)
+                {
+                    printf("Error: iterations must be greater than 0\n");
+                    error = true;
+                }
+            }
+            else
+            {
+                printf("Error: iterations parameter missing\n");
+                error = true;
+            }
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+                 (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --iterations <count>\n");
+        printf("      Number of frames decoded or converted per benchmark; default is 60\n");
+
+        return 1; // Indicates an error or warning
+    }
+
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
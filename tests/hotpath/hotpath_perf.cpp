@@ -0,0 +1,548 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4ainternal/allocator.h>
+#include <k4ainternal/capture.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/image.h>
+#include <k4ainternal/queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks of the calls every capture goes through: queue_push and queue_pop, allocator_alloc and
+// allocator_free, capture_create and capture_dec_ref, and the image accessors. Each benchmark runs on several threads
+// at the producer and consumer ratios and buffer sizes of the SDK, so the contention on the shared locks and pools is
+// measured along with the cost of the calls. Results are printed and appended to hotpath_perf_results.csv.
+
+static uint32_t g_iterations = 100000;
+
+using ::testing::ValuesIn;
+
+typedef std::chrono::high_resolution_clock clock_type;
+
+// Runs body(thread_index) on thread_count threads released at the same time, returns the seconds until all returned
+template<typename F> static double run_threads(int thread_count, F body)
+{
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back([&go, &body, i]() {
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            body(i);
+        });
+    }
+
+    auto start = clock_type::now();
+    go.store(true);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+class hotpath_perf_base : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("hotpath_perf_results.csv", "a")));
+        allocator_initialize();
+    }
+
+    virtual void TearDown()
+    {
+        (void)allocator_set_pooling(0);
+        allocator_deinitialize();
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    void report(const char *benchmark, const char *settings, uint64_t operations, double seconds)
+    {
+        double ns_per_op = operations ? seconds * 1e9 / (double)operations : 0;
+        double ops_per_second = seconds > 0 ? (double)operations / seconds : 0;
+        printf("    %-16s %-48s %12.0f ops/s %10.1f ns/op\n", benchmark, settings, ops_per_second, ns_per_op);
+
+        if (m_file_handle)
+        {
+            // Write the header when the file is new
+            if (ftell(m_file_handle) == 0)
+            {
+                fprintf(m_file_handle, "benchmark,settings,operations,seconds,ops_per_second,ns_per_op\n");
+            }
+            fprintf(m_file_handle,
+                    "%s,%s,%llu,%f,%f,%f\n",
+                    benchmark,
+                    settings,
+                    (unsigned long long)operations,
+                    seconds,
+                    ops_per_second,
+                    ns_per_op);
+        }
+    }
+
+    FILE *m_file_handle;
+};
+
+static k4a_capture_t create_capture_with_image(size_t image_size)
+{
+    k4a_capture_t capture = NULL;
+    k4a_image_t image = NULL;
+    k4a_result_t result = TRACE_CALL(capture_create(&capture));
+    if (K4A_SUCCEEDED(result) && image_size != 0)
+    {
+        result = TRACE_CALL(image_create_empty_internal(ALLOCATION_SOURCE_USB_DEPTH, image_size, &image));
+        if (K4A_SUCCEEDED(result))
+        {
+            capture_set_depth_image(capture, image);
+            image_dec_ref(image);
+        }
+    }
+
+    if (K4A_FAILED(result) && capture)
+    {
+        capture_dec_ref(capture);
+        capture = NULL;
+    }
+    return capture;
+}
+
+//
+// queue_push / queue_pop
+//
+
+struct queue_parameters
+{
+    int test_number;
+    int producers;
+    int consumers;
+    uint32_t depth;
+    bool spsc;
+    size_t image_size; // 0 pushes the same capture, otherwise each push creates a capture with an image this size
+
+    friend std::ostream &operator<<(std::ostream &os, const queue_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class queue_perf : public hotpath_perf_base, public ::testing::WithParamInterface<queue_parameters>
+{
+};
+
+TEST_P(queue_perf, push_pop)
+{
+    auto as = GetParam();
+    queue_t queue = NULL;
+    if (as.spsc)
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, queue_create_spsc(as.depth, "queue_perf", &queue));
+    }
+    else
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, queue_create(as.depth, "queue_perf", &queue));
+    }
+    queue_enable(queue);
+
+    k4a_capture_t shared_capture = as.image_size == 0 ? create_capture_with_image(0) : NULL;
+    std::atomic<int> producers_running(as.producers);
+    std::atomic<uint64_t> popped(0);
+    std::atomic<bool> failed(false);
+
+    double seconds = run_threads(as.producers + as.consumers, [&](int index) {
+        if (index < as.producers)
+        {
+            for (uint32_t i = 0; i < g_iterations; i++)
+            {
+                k4a_capture_t capture = shared_capture ? shared_capture : create_capture_with_image(as.image_size);
+                if (capture == NULL)
+                {
+                    failed = true;
+                    break;
+                }
+                queue_push(queue, capture);
+                if (capture != shared_capture)
+                {
+                    capture_dec_ref(capture);
+                }
+            }
+            producers_running--;
+            return;
+        }
+
+        uint64_t count = 0;
+        while (true)
+        {
+            k4a_capture_t capture = NULL;
+            // Check for running producers before popping, so the pop that times out has seen every push
+            bool producing = producers_running.load() > 0;
+            k4a_wait_result_t result = queue_pop(queue, producing ? 10 : 0, &capture);
+            if (result == K4A_WAIT_RESULT_SUCCEEDED)
+            {
+                capture_dec_ref(capture);
+                count++;
+            }
+            else if (result == K4A_WAIT_RESULT_FAILED || !producing)
+            {
+                break;
+            }
+        }
+        popped += count;
+    });
+
+    queue_destroy(queue);
+    if (shared_capture)
+    {
+        capture_dec_ref(shared_capture);
+    }
+    ASSERT_FALSE(failed.load());
+
+    uint64_t pushed = (uint64_t)as.producers * g_iterations;
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%s %d:%d depth %u image %zu dropped %llu",
+             as.spsc ? "spsc" : "locked",
+             as.producers,
+             as.consumers,
+             as.depth,
+             as.image_size,
+             (unsigned long long)(pushed - popped.load()));
+    report("queue_push_pop", settings, pushed, seconds);
+}
+
+// clang-format off
+static struct queue_parameters queue_tests[] = {
+    // One producer and one consumer, like a device queue and the application thread reading it
+    { 0, 1, 1, 2, false, 0 },
+    { 1, 1, 1, 2, true, 0 },
+    { 2, 1, 1, 10, false, 0 },
+    { 3, 1, 1, 10, true, 0 },
+    // Captures with the image of an NFOV unbinned raw depth frame, freed by the consumer
+    { 4, 1, 1, 2, false, 1024 * 1024 },
+    { 5, 1, 1, 2, true, 1024 * 1024 },
+    // Several streams into one queue, and several application threads reading one queue
+    { 6, 2, 1, 10, false, 0 },
+    { 7, 1, 2, 10, false, 0 },
+    { 8, 4, 4, 10, false, 0 },
+    { 9, 4, 4, 10, false, 1024 * 1024 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(QUEUE_TESTS, queue_perf, ValuesIn(queue_tests));
+
+//
+// allocator_alloc / allocator_free
+//
+
+struct allocator_parameters
+{
+    int test_number;
+    int threads;
+    size_t size;
+    uint32_t in_flight; // buffers each thread holds before freeing them, like frames waiting in queues
+    uint32_t pooled_buffers;
+
+    friend std::ostream &operator<<(std::ostream &os, const allocator_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class allocator_perf : public hotpath_perf_base, public ::testing::WithParamInterface<allocator_parameters>
+{
+};
+
+TEST_P(allocator_perf, alloc_free)
+{
+    auto as = GetParam();
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, allocator_set_pooling(as.pooled_buffers));
+    std::atomic<bool> failed(false);
+
+    double seconds = run_threads(as.threads, [&](int index) {
+        (void)index;
+        std::vector<uint8_t *> buffers(as.in_flight);
+        for (uint32_t i = 0; i < g_iterations; i += as.in_flight)
+        {
+            for (auto &buffer : buffers)
+            {
+                buffer = allocator_alloc(ALLOCATION_SOURCE_USB_DEPTH, as.size);
+                if (buffer == NULL)
+                {
+                    failed = true;
+                }
+                else
+                {
+                    // Touch the buffer like a reader would, so fresh pages are faulted in
+                    buffer[0] = 1;
+                }
+            }
+            for (auto &buffer : buffers)
+            {
+                if (buffer)
+                {
+                    allocator_free(buffer);
+                }
+            }
+        }
+    });
+    ASSERT_FALSE(failed.load());
+
+    uint64_t iterations = (g_iterations + as.in_flight - 1) / as.in_flight * as.in_flight;
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%d threads size %zu in flight %u pooled %u",
+             as.threads,
+             as.size,
+             as.in_flight,
+             as.pooled_buffers);
+    report("allocator", settings, iterations * (uint64_t)as.threads, seconds);
+}
+
+// clang-format off
+static struct allocator_parameters allocator_tests[] = {
+    // IMU packets
+    { 0, 1, 512, 4, 0 },
+    { 1, 4, 512, 4, 0 },
+    // Raw depth frames, with and without pooling
+    { 2, 1, 1024 * 1024, 2, 0 },
+    { 3, 1, 1024 * 1024, 2, 8 },
+    { 4, 4, 1024 * 1024, 2, 0 },
+    { 5, 4, 1024 * 1024, 2, 8 },
+    // 720p NV12 color frames
+    { 6, 2, 1280 * 720 * 3 / 2, 4, 0 },
+    { 7, 2, 1280 * 720 * 3 / 2, 4, 8 },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(ALLOCATOR_TESTS, allocator_perf, ValuesIn(allocator_tests));
+
+//
+// capture_create / capture_dec_ref
+//
+
+struct capture_parameters
+{
+    int test_number;
+    int threads;
+    bool images; // attach a depth, IR and color image to every capture
+
+    friend std::ostream &operator<<(std::ostream &os, const capture_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class capture_perf : public hotpath_perf_base, public ::testing::WithParamInterface<capture_parameters>
+{
+};
+
+TEST_P(capture_perf, create_release)
+{
+    auto as = GetParam();
+    k4a_image_t images[3] = {};
+    if (as.images)
+    {
+        for (auto &image : images)
+        {
+            ASSERT_EQ(K4A_RESULT_SUCCEEDED, image_create_empty_internal(ALLOCATION_SOURCE_USER, 64, &image));
+        }
+    }
+    std::atomic<bool> failed(false);
+
+    double seconds = run_threads(as.threads, [&](int index) {
+        (void)index;
+        for (uint32_t i = 0; i < g_iterations; i++)
+        {
+            k4a_capture_t capture = NULL;
+            if (K4A_FAILED(capture_create(&capture)))
+            {
+                failed = true;
+                break;
+            }
+            if (as.images)
+            {
+                capture_set_depth_image(capture, images[0]);
+                capture_set_ir_image(capture, images[1]);
+                capture_set_color_image(capture, images[2]);
+            }
+            capture_dec_ref(capture);
+        }
+    });
+
+    for (auto image : images)
+    {
+        if (image)
+        {
+            image_dec_ref(image);
+        }
+    }
+    ASSERT_FALSE(failed.load());
+
+    char settings[128];
+    snprintf(settings, sizeof(settings), "%d threads%s", as.threads, as.images ? " 3 images" : "");
+    report("capture", settings, (uint64_t)g_iterations * (uint64_t)as.threads, seconds);
+}
+
+// clang-format off
+static struct capture_parameters capture_tests[] = {
+    { 0, 1, false },
+    { 1, 4, false },
+    { 2, 1, true },
+    { 3, 4, true },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(CAPTURE_TESTS, capture_perf, ValuesIn(capture_tests));
+
+//
+// Image accessors
+//
+
+struct image_parameters
+{
+    int test_number;
+    int threads;
+    bool shared; // all threads read the same image, like several consumers of one capture
+
+    friend std::ostream &operator<<(std::ostream &os, const image_parameters &obj)
+    {
+        return os << "test index: " << (int)obj.test_number;
+    }
+};
+
+class image_perf : public hotpath_perf_base, public ::testing::WithParamInterface<image_parameters>
+{
+};
+
+// The accessors read by an application processing a frame
+static const int IMAGE_ACCESSOR_CALLS = 8;
+
+TEST_P(image_perf, accessors)
+{
+    auto as = GetParam();
+    std::vector<k4a_image_t> images((size_t)(as.shared ? 1 : as.threads));
+    for (auto &image : images)
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  image_create(K4A_IMAGE_FORMAT_DEPTH16, 640, 576, 0, ALLOCATION_SOURCE_USER, &image));
+    }
+    std::atomic<uint64_t> checksum(0);
+
+    double seconds = run_threads(as.threads, [&](int index) {
+        k4a_image_t image = images[as.shared ? 0 : (size_t)index];
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < g_iterations; i++)
+        {
+            sum += (uint64_t)(uintptr_t)image_get_buffer(image);
+            sum += image_get_size(image);
+            sum += (uint64_t)image_get_format(image);
+            sum += (uint64_t)image_get_width_pixels(image);
+            sum += (uint64_t)image_get_height_pixels(image);
+            sum += (uint64_t)image_get_stride_bytes(image);
+            sum += image_get_device_timestamp_usec(image);
+            sum += image_get_system_timestamp_nsec(image);
+        }
+        // Keeps the calls from being optimized away
+        checksum += sum;
+    });
+
+    for (auto image : images)
+    {
+        image_dec_ref(image);
+    }
+
+    char settings[128];
+    snprintf(settings,
+             sizeof(settings),
+             "%d threads %s checksum %llu",
+             as.threads,
+             as.shared ? "shared" : "private",
+             (unsigned long long)(checksum.load() & 0xff));
+    report("image_accessors",
+           settings,
+           (uint64_t)g_iterations * (uint64_t)as.threads * IMAGE_ACCESSOR_CALLS,
+           seconds);
+}
+
+// clang-format off
+static struct image_parameters image_tests[] = {
+    { 0, 1, false },
+    { 1, 4, false },
+    { 2, 4, true },
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(IMAGE_TESTS, image_perf, ValuesIn(image_tests));
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+
+        if (strcmp(argument, "--iterations") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_iterations = (uint32_t)strtoul(argv[++i], NULL, 10);
+                if (g_iterations == 0)
+                {
+                    printf("Error: iterations must be greater than 0\n");
+                    error = true;
+                }
+            }
+            else
+            {
+                printf("Error: iterations parameter missing\n");
+                error = true;
+            }
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+                 (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --iterations <count>\n");
+        printf("      Number of operations each thread runs per benchmark; default is 100000\n");
+
+        return 1; // Indicates an error or warning
+    }
+
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
@@ -18,8 +18,10 @@
 #include <k4a/k4a.h>
 #include <azure_c_shared_utility/threadapi.h>
 #include <azure_c_shared_utility/envvariable.h>
+#include <algorithm>
 #include <deque>
 #include <mutex>
+#include <vector>
 
 #ifndef _WIN32
 #include <time.h>
@@ -39,6 +41,7 @@ static uint32_t g_subordinate_delay_off_master_usec = 0;
 static bool g_manual_exposure = true;
 static uint32_t g_exposure_setting = 31000; // will round up to nearest value
 static bool g_power_line_50_hz = false;
+static const char *g_json_path = "latency_perf_results.json";
 
 using ::testing::ValuesIn;
 
@@ -83,6 +86,7 @@ public:
         ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_open(g_device_index, &m_device)) << "Couldn't open device\n";
         ASSERT_NE(m_device, nullptr);
         EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("latency_testResults.csv", "a")));
+        EXPECT_NE((FILE *)NULL, (m_json_handle = fopen(g_json_path, "a")));
     }
 
     virtual void TearDown()
@@ -96,9 +100,14 @@ public:
         {
             fclose(m_file_handle);
         }
+        if (m_json_handle)
+        {
+            fclose(m_json_handle);
+        }
     }
 
     void print_and_log(const char *message, const char *mode, int64_t ave, int64_t min, int64_t max);
+    void print_and_log_percentiles(const char *name, const char *mode, std::vector<uint64_t> *latency_usec);
     void process_image(k4a_capture_t capture,
                        uint64_t current_system_ts,
                        bool process_color,
@@ -110,6 +119,7 @@ public:
 
     k4a_device_t m_device = nullptr;
     FILE *m_file_handle;
+    FILE *m_json_handle;
 };
 
 static const char *get_string_from_color_format(k4a_image_format_t format)
@@ -420,6 +430,49 @@ void latency_perf::print_and_log(const char *message, const char *mode, int64_t
     }
 }
 
+// Nearest rank percentile of sorted values
+static uint64_t get_percentile(const std::vector<uint64_t> &sorted, double percentile)
+{
+    size_t rank = (size_t)(percentile / 100 * (double)sorted.size() + 0.999999);
+    return sorted[rank == 0 ? 0 : std::min(rank, sorted.size()) - 1];
+}
+
+// Prints the percentiles of a latency and writes them as a member of the JSON object of the test
+void latency_perf::print_and_log_percentiles(const char *name, const char *mode, std::vector<uint64_t> *latency_usec)
+{
+    if (latency_usec->empty())
+    {
+        return;
+    }
+
+    std::sort(latency_usec->begin(), latency_usec->end());
+    uint64_t p50 = get_percentile(*latency_usec, 50);
+    uint64_t p99 = get_percentile(*latency_usec, 99);
+    uint64_t p999 = get_percentile(*latency_usec, 99.9);
+    uint64_t max = latency_usec->back();
+
+    printf("    %30s %30s: P50=%" PRIu64 " P99=%" PRIu64 " P99.9=%" PRIu64 " max=%" PRIu64 " (us)\n",
+           name,
+           mode,
+           p50,
+           p99,
+           p999,
+           max);
+
+    if (m_json_handle)
+    {
+        fprintf(m_json_handle,
+                ", \"%s\": { \"count\": %zu, \"p50_usec\": %" PRIu64 ", \"p99_usec\": %" PRIu64
+                ", \"p99_9_usec\": %" PRIu64 ", \"max_usec\": %" PRIu64 " }",
+                name,
+                latency_usec->size(),
+                p50,
+                p99,
+                p999,
+                max);
+    }
+}
+
 void latency_perf::process_image(k4a_capture_t capture,
                                  uint64_t current_system_ts,
                                  bool process_color,
@@ -512,6 +565,7 @@ TEST_P(latency_perf, testTest)
     uint64_t color_system_ts_last = 0, color_system_ts_from_pts_last = 0;
     uint64_t ir_system_ts_last = 0, ir_system_ts_from_pts_last = 0;
     int32_t read_exposure = 0;
+    std::vector<uint64_t> stage_latency_usec[K4A_LATENCY_STAGE_NUM];
 
     printf("Capturing %d frames for test: %s\n", g_capture_count, as.test_name);
 
@@ -695,6 +749,29 @@ TEST_P(latency_perf, testTest)
                       &ir_system_ts_last,
                       &ir_system_ts_from_pts_last);
 
+        // Time spent in each SDK stage, which starts when the previous one ended and with the USB transfer of the
+        // raw depth frame for the first stage and the total
+        k4a_image_t ir_image = k4a_capture_get_ir_image(capture);
+        if (ir_image)
+        {
+            uint64_t usb_done_nsec = k4a_image_get_system_timestamp_nsec(ir_image);
+            uint64_t stage_start_nsec = usb_done_nsec;
+            for (int stage = 0; stage < K4A_LATENCY_STAGE_NUM; stage++)
+            {
+                if (stage == K4A_LATENCY_STAGE_TOTAL)
+                {
+                    stage_start_nsec = usb_done_nsec;
+                }
+                uint64_t stage_end_nsec = k4a_capture_get_latency_timestamp_nsec(capture, (k4a_latency_stage_t)stage);
+                if (stage_start_nsec != 0 && stage_end_nsec >= stage_start_nsec)
+                {
+                    stage_latency_usec[stage].push_back((stage_end_nsec - stage_start_nsec) / 1000);
+                }
+                stage_start_nsec = stage_end_nsec;
+            }
+            k4a_image_release(ir_image);
+        }
+
         printf("|\n"); // End of line
     }                  // End capture loop
 
@@ -833,6 +910,55 @@ TEST_P(latency_perf, testTest)
                       STS_TO_MS(max));
     }
 
+    {
+        // One JSON object per line, so results of many runs can be appended to the same file
+        if (m_json_handle)
+        {
+            fprintf(m_json_handle,
+                    "{ \"test\": \"%s\", \"fps\": %d, \"color_format\": \"%s\", \"color_resolution\": %d, "
+                    "\"depth_mode\": \"%s\", \"captures\": %d",
+                    as.test_name,
+                    k4a_convert_fps_to_uint(as.fps),
+                    get_string_from_color_format(as.color_format),
+                    (int)as.color_resolution,
+                    get_string_from_depth_mode(as.depth_mode),
+                    g_capture_count);
+        }
+
+        // Where the depth capture latency is spent inside the SDK
+        const char *stage_names[K4A_LATENCY_STAGE_NUM] = {
+            "usb_to_depth_engine", "depth_engine", "capture_sync", "user_pop", "usb_to_user"
+        };
+        for (int stage = 0; stage < K4A_LATENCY_STAGE_NUM; stage++)
+        {
+            print_and_log_percentiles(stage_names[stage],
+                                      get_string_from_depth_mode(config.depth_mode),
+                                      &stage_latency_usec[stage]);
+        }
+
+        // Exposure to delivery, the latency seen by the application
+        std::vector<uint64_t> latency_usec[2];
+        for (uint64_t latency_nsec : color_system_latency)
+        {
+            latency_usec[0].push_back(latency_nsec / 1000);
+        }
+        for (uint64_t latency_nsec : ir_system_latency)
+        {
+            latency_usec[1].push_back(latency_nsec / 1000);
+        }
+        print_and_log_percentiles("color_system_latency",
+                                  get_string_from_color_format(config.color_format),
+                                  &latency_usec[0]);
+        print_and_log_percentiles("ir_system_latency",
+                                  get_string_from_depth_mode(config.depth_mode),
+                                  &latency_usec[1]);
+
+        if (m_json_handle)
+        {
+            fprintf(m_json_handle, " }\n");
+        }
+    }
+
     printf("\n");
     if (m_file_handle != 0)
     {
@@ -1011,6 +1137,20 @@ int main(int argc, char **argv)
                 error = true;
             }
         }
+        else if (strcmp(argument, "--json") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                g_json_path = argv[i + 1];
+                printf("g_json_path = %s\n", g_json_path);
+                i++;
+            }
+            else
+            {
+                printf("Error: json parameter missing\n");
+                error = true;
+            }
+        }
         else if (strcmp(argument, "--auto") == 0)
         {
             g_manual_exposure = false;
@@ -1060,6 +1200,9 @@ int main(int argc, char **argv)
         printf("      that is passed in.\n");
         printf("  --auto\n");
         printf("      By default the test uses manual exposure. This will test with auto exposure.\n");
+        printf("  --json <path>\n");
+        printf("      File the per stage latency percentiles of each test are appended to, one JSON object per\n");
+        printf("      line; default is latency_perf_results.json\n");
         printf("  --60hz\n");
         printf("      <default> Sets the power line compensation frequency to 60Hz\n");
         printf("  --50hz\n");
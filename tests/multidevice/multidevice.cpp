@@ -235,6 +235,38 @@ TEST_F(multidevice_ft, open_close_two)
     m_device2 = NULL;
 }
 
+static void hotplug_callback(void *context, k4a_device_hotplug_event_t event, uint32_t device_count)
+{
+    (void)event;
+    (void)device_count;
+    (*(int *)context)++;
+}
+
+TEST_F(multidevice_ft, hotplug_cached_count)
+{
+    uint32_t device_count = k4a_device_get_installed_count();
+    ASSERT_LE((uint32_t)2, device_count);
+
+    // The cached count matches the enumerated one, and opening devices is not reported as a device change
+    int notification_count = 0;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_set_device_hotplug_callback(hotplug_callback, &notification_count));
+    ASSERT_EQ(device_count, k4a_device_get_installed_count());
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_open(0, &m_device1));
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_open(1, &m_device2));
+    k4a_device_close(m_device1);
+    m_device1 = NULL;
+    k4a_device_close(m_device2);
+    m_device2 = NULL;
+    ThreadAPI_Sleep(1000);
+    ASSERT_EQ(device_count, k4a_device_get_installed_count());
+
+    // Once cleared, the callback is not called and the devices are enumerated again
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_set_device_hotplug_callback(NULL, NULL));
+    ASSERT_EQ(0, notification_count);
+    ASSERT_EQ(device_count, k4a_device_get_installed_count());
+}
+
 TEST_F(multidevice_ft, stream_two_1_then_2)
 {
     k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
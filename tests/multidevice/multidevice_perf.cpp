@@ -0,0 +1,458 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <k4a/k4a.h>
+#include <k4ainternal/common.h>
+#include <utcommon.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// Measures how streaming scales with the number of devices. Every mode combination is streamed from 1, 2, 4, ... and
+// finally all of the devices at once, and the test reports the aggregate frame rate, the frames each device dropped,
+// the CPU time and depth engine time per device and the bandwidth received over USB. Results are printed and appended
+// to multidevice_perf_results.csv, to size capture rigs and to check that the shared SDK threads keep up as devices are
+// added.
+//
+// The SDK does not report which USB controller a device is on, so bandwidth is reported per device and in total. Run
+// with the devices of one controller connected to measure that controller.
+
+static uint32_t g_max_device_count = 0; // 0 uses every installed device
+static int g_duration_sec = 10;
+static int g_warmup_sec = 2;
+static bool g_wired_sync = false;
+
+using ::testing::ValuesIn;
+
+struct multidevice_parameters
+{
+    int test_number;
+    const char *test_name;
+    k4a_fps_t fps;
+    k4a_image_format_t color_format;
+    k4a_color_resolution_t color_resolution;
+    k4a_depth_mode_t depth_mode;
+
+    friend std::ostream &operator<<(std::ostream &os, const multidevice_parameters &obj)
+    {
+        return os << "test index: (" << obj.test_name << ") " << (int)obj.test_number;
+    }
+};
+
+// What one device delivered during the measurement
+struct device_counters
+{
+    std::atomic<bool> measuring;
+    std::atomic<bool> exit;
+    uint64_t captures;
+    uint64_t color_images;
+    uint64_t depth_images;
+    uint64_t color_bytes;
+    uint64_t depth_engine_usec;
+    uint64_t depth_engine_count;
+    bool failed;
+};
+
+static uint64_t get_process_cpu_usec()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 10; // 100ns units
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           (uint64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+static void read_captures(k4a_device_t device, device_counters *counters)
+{
+    while (!counters->exit.load())
+    {
+        k4a_capture_t capture = NULL;
+        k4a_wait_result_t result = k4a_device_get_capture(device, &capture, 100);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            counters->failed = true;
+            return;
+        }
+        if (result != K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        if (counters->measuring.load())
+        {
+            counters->captures++;
+
+            k4a_image_t image = k4a_capture_get_color_image(capture);
+            if (image)
+            {
+                counters->color_images++;
+                counters->color_bytes += k4a_image_get_size(image);
+                k4a_image_release(image);
+            }
+
+            image = k4a_capture_get_depth_image(capture);
+            if (image == NULL)
+            {
+                // Passive IR only has an IR image
+                image = k4a_capture_get_ir_image(capture);
+            }
+            if (image)
+            {
+                counters->depth_images++;
+                k4a_image_release(image);
+            }
+
+            uint64_t engine_start = k4a_capture_get_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_DEPTH_QUEUE);
+            uint64_t engine_end = k4a_capture_get_latency_timestamp_nsec(capture, K4A_LATENCY_STAGE_DEPTH_ENGINE);
+            if (engine_start != 0 && engine_end >= engine_start)
+            {
+                counters->depth_engine_usec += (engine_end - engine_start) / 1000;
+                counters->depth_engine_count++;
+            }
+        }
+        k4a_capture_release(capture);
+    }
+}
+
+class multidevice_perf : public ::testing::Test, public ::testing::WithParamInterface<multidevice_parameters>
+{
+public:
+    virtual void SetUp()
+    {
+        uint32_t installed = k4a_device_get_installed_count();
+        ASSERT_GT(installed, 0u) << "No devices connected\n";
+        uint32_t device_count = g_max_device_count == 0 ? installed : std::min(g_max_device_count, installed);
+
+        for (uint32_t i = 0; i < device_count; i++)
+        {
+            k4a_device_t device = NULL;
+            ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_open(i, &device)) << "Couldn't open device " << i << "\n";
+            m_devices.push_back(device);
+        }
+        EXPECT_NE((FILE *)NULL, (m_file_handle = fopen("multidevice_perf_results.csv", "a")));
+    }
+
+    virtual void TearDown()
+    {
+        for (k4a_device_t device : m_devices)
+        {
+            k4a_device_close(device);
+        }
+        m_devices.clear();
+        if (m_file_handle)
+        {
+            fclose(m_file_handle);
+        }
+    }
+
+    void stream(const multidevice_parameters &as, size_t device_count);
+
+    std::vector<k4a_device_t> m_devices;
+    FILE *m_file_handle;
+};
+
+void multidevice_perf::stream(const multidevice_parameters &as, size_t device_count)
+{
+    std::vector<device_counters> counters(device_count);
+    std::vector<k4a_usb_stream_stats_t> usb_start(device_count);
+    std::vector<k4a_usb_stream_stats_t> usb_end(device_count);
+    std::vector<k4a_capture_stats_t> capture_stats(device_count);
+    std::vector<std::thread> readers;
+
+    // Subordinates must be started before the master
+    std::vector<size_t> start_order;
+    for (size_t i = 0; i < device_count; i++)
+    {
+        bool sync_in = false, sync_out = false;
+        bool subordinate = g_wired_sync &&
+                           K4A_SUCCEEDED(k4a_device_get_sync_jack(m_devices[i], &sync_in, &sync_out)) && sync_in;
+        if (subordinate)
+        {
+            start_order.insert(start_order.begin(), i);
+        }
+        else
+        {
+            start_order.push_back(i);
+        }
+    }
+
+    for (size_t i : start_order)
+    {
+        k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+        config.color_format = as.color_format;
+        config.color_resolution = as.color_resolution;
+        config.depth_mode = as.depth_mode;
+        config.camera_fps = as.fps;
+        if (g_wired_sync)
+        {
+            bool sync_in = false, sync_out = false;
+            (void)k4a_device_get_sync_jack(m_devices[i], &sync_in, &sync_out);
+            config.wired_sync_mode = sync_in ? K4A_WIRED_SYNC_MODE_SUBORDINATE : K4A_WIRED_SYNC_MODE_MASTER;
+        }
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_start_cameras(m_devices[i], &config));
+    }
+
+    for (size_t i = 0; i < device_count; i++)
+    {
+        counters[i].measuring = false;
+        counters[i].exit = false;
+        readers.emplace_back(read_captures, m_devices[i], &counters[i]);
+    }
+
+    // Leave the start of the streams out of the measurement
+    std::this_thread::sleep_for(std::chrono::seconds(g_warmup_sec));
+
+    for (size_t i = 0; i < device_count; i++)
+    {
+        EXPECT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_device_get_usb_stream_stats(m_devices[i], K4A_USB_STREAM_DEPTH, &usb_start[i]));
+        counters[i].measuring = true;
+    }
+    uint64_t cpu_start_usec = get_process_cpu_usec();
+    auto start = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(g_duration_sec));
+
+    for (size_t i = 0; i < device_count; i++)
+    {
+        counters[i].measuring = false;
+        EXPECT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_device_get_usb_stream_stats(m_devices[i], K4A_USB_STREAM_DEPTH, &usb_end[i]));
+        EXPECT_EQ(K4A_RESULT_SUCCEEDED, k4a_device_get_capture_stats(m_devices[i], &capture_stats[i]));
+    }
+    uint64_t cpu_usec = get_process_cpu_usec() - cpu_start_usec;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < device_count; i++)
+    {
+        counters[i].exit = true;
+    }
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+    // Stop the master first, so the subordinates don't wait for its sync pulses
+    for (auto i = start_order.rbegin(); i != start_order.rend(); ++i)
+    {
+        k4a_device_stop_cameras(m_devices[*i]);
+    }
+
+    uint32_t fps = k4a_convert_fps_to_uint(as.fps);
+    uint64_t expected_frames = (uint64_t)(fps * seconds);
+    uint64_t total_captures = 0;
+    uint64_t total_dropped = 0;
+    double total_mb_per_second = 0;
+
+    printf("  %zu device(s), %s\n", device_count, as.test_name);
+    printf("    device  captures/s  dropped  depth engine (ms)  USB depth (MB/s)  color (MB/s)  app overflow\n");
+    for (size_t i = 0; i < device_count; i++)
+    {
+        const device_counters &c = counters[i];
+        EXPECT_FALSE(c.failed) << "Device " << i << " failed to return captures\n";
+
+        // A stream that is enabled should deliver fps images per second, the rest were dropped along the way
+        uint64_t dropped = 0;
+        if (as.color_resolution != K4A_COLOR_RESOLUTION_OFF && c.color_images < expected_frames)
+        {
+            dropped += expected_frames - c.color_images;
+        }
+        if (as.depth_mode != K4A_DEPTH_MODE_OFF && c.depth_images < expected_frames)
+        {
+            dropped += expected_frames - c.depth_images;
+        }
+
+        double depth_mb_per_second = (double)(usb_end[i].bytes_transferred - usb_start[i].bytes_transferred) /
+                                     (1024 * 1024) / seconds;
+        double color_mb_per_second = (double)c.color_bytes / (1024 * 1024) / seconds;
+        double engine_ms = c.depth_engine_count ? (double)c.depth_engine_usec / (double)c.depth_engine_count / 1000 :
+                                                  0;
+
+        printf("    %6zu  %10.2f  %7llu  %17.2f  %16.2f  %12.2f  %12llu\n",
+               i,
+               (double)c.captures / seconds,
+               (unsigned long long)dropped,
+               engine_ms,
+               depth_mb_per_second,
+               color_mb_per_second,
+               (unsigned long long)capture_stats[i].output_queue_overflow);
+
+        total_captures += c.captures;
+        total_dropped += dropped;
+        total_mb_per_second += depth_mb_per_second + color_mb_per_second;
+
+        if (m_file_handle)
+        {
+            fprintf(m_file_handle,
+                    "%s,%zu,%zu,%f,%llu,%f,%f,%f,%llu\n",
+                    as.test_name,
+                    device_count,
+                    i,
+                    (double)c.captures / seconds,
+                    (unsigned long long)dropped,
+                    engine_ms,
+                    depth_mb_per_second,
+                    color_mb_per_second,
+                    (unsigned long long)capture_stats[i].output_queue_overflow);
+        }
+    }
+
+    // CPU time of the whole process, shared out over the devices
+    double cpu_percent_per_device = (double)cpu_usec / 10000 / seconds / (double)device_count;
+    printf("    total   %10.2f  %7llu  CPU %.1f%% per device  USB and color %.2f MB/s\n",
+           (double)total_captures / seconds,
+           (unsigned long long)total_dropped,
+           cpu_percent_per_device,
+           total_mb_per_second);
+    if (m_file_handle)
+    {
+        fprintf(m_file_handle,
+                "%s,%zu,total,%f,%llu,cpu_percent_per_device,%f,%f\n",
+                as.test_name,
+                device_count,
+                (double)total_captures / seconds,
+                (unsigned long long)total_dropped,
+                cpu_percent_per_device,
+                total_mb_per_second);
+    }
+}
+
+TEST_P(multidevice_perf, scaling)
+{
+    auto as = GetParam();
+
+    // 1, 2, 4, ... devices and then all of them
+    size_t count = 1;
+    while (true)
+    {
+        stream(as, count);
+        if (HasFatalFailure() || count == m_devices.size())
+        {
+            return;
+        }
+        count = std::min(count * 2, m_devices.size());
+    }
+}
+
+// clang-format off
+static struct multidevice_parameters tests[] = {
+    // Every depth mode with the least demanding color mode
+    {  0, "FPS_30_MJPEG_0720P_NFOV_2X2BINNED",  K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_NFOV_2X2BINNED},
+    {  1, "FPS_30_MJPEG_0720P_NFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_NFOV_UNBINNED},
+    {  2, "FPS_30_MJPEG_0720P_WFOV_2X2BINNED",  K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_WFOV_2X2BINNED},
+    {  3, "FPS_15_MJPEG_0720P_WFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_15, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_WFOV_UNBINNED},
+    {  4, "FPS_30_MJPEG_0720P_PASSIVE_IR",      K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_PASSIVE_IR},
+
+    // Every color format at the resolution that needs the most bandwidth, with a common depth mode
+    {  5, "FPS_30_MJPEG_2160P_NFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG,   K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_NFOV_UNBINNED},
+    {  6, "FPS_30_BGRA32_2160P_NFOV_UNBINNED",  K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_NFOV_UNBINNED},
+    {  7, "FPS_30_NV12__0720P_NFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_NV12,   K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_NFOV_UNBINNED},
+    {  8, "FPS_30_YUY2__0720P_NFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_YUY2,   K4A_COLOR_RESOLUTION_720P,  K4A_DEPTH_MODE_NFOV_UNBINNED},
+    {  9, "FPS_15_MJPEG_3072P_NFOV_UNBINNED",   K4A_FRAMES_PER_SECOND_15, K4A_IMAGE_FORMAT_COLOR_MJPG,   K4A_COLOR_RESOLUTION_3072P, K4A_DEPTH_MODE_NFOV_UNBINNED},
+
+    // Single streams
+    { 10, "FPS_30_OFF___NFOV_UNBINNED",         K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG,   K4A_COLOR_RESOLUTION_OFF,   K4A_DEPTH_MODE_NFOV_UNBINNED},
+    { 11, "FPS_30_MJPEG_2160P_OFF",             K4A_FRAMES_PER_SECOND_30, K4A_IMAGE_FORMAT_COLOR_MJPG,   K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_OFF},
+};
+// clang-format on
+
+INSTANTIATE_TEST_CASE_P(MULTIDEVICE_TESTS, multidevice_perf, ValuesIn(tests));
+
+int main(int argc, char **argv)
+{
+    bool error = false;
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char *argument = argv[i];
+        for (int j = 0; argument[j]; j++)
+        {
+            argument[j] = (char)tolower(argument[j]);
+        }
+
+        if (strcmp(argument, "--device_count") == 0 || strcmp(argument, "--duration") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                int value = (int)strtol(argv[++i], NULL, 10);
+                if (value <= 0)
+                {
+                    printf("Error: %s must be greater than 0\n", argument);
+                    error = true;
+                }
+                else if (strcmp(argument, "--device_count") == 0)
+                {
+                    g_max_device_count = (uint32_t)value;
+                }
+                else
+                {
+                    g_duration_sec = value;
+                }
+            }
+            else
+            {
+                printf("Error: %s parameter missing\n", argument);
+                error = true;
+            }
+        }
+        else if (strcmp(argument, "--wired_sync") == 0)
+        {
+            g_wired_sync = true;
+        }
+        else if ((strcmp(argument, "-h") == 0) || (strcmp(argument, "/h") == 0) || (strcmp(argument, "-?") == 0) ||
+                 (strcmp(argument, "/?") == 0))
+        {
+            error = true;
+        }
+    }
+
+    if (error)
+    {
+        printf("\n\nOptional Custom Test Settings:\n");
+        printf("  --device_count <count>\n");
+        printf("      The most devices to stream at once; default is every connected device\n");
+        printf("  --duration <seconds>\n");
+        printf("      How long each measurement streams; default is 10\n");
+        printf("  --wired_sync\n");
+        printf("      Devices with a cable in their sync in jack run as subordinates, the others as master\n");
+
+        return 1; // Indicates an error or warning
+    }
+
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
@@ -7,6 +7,17 @@
 
 using namespace k4afastcapture;
 
+// Number of requested captures that can be buffered while the writers catch up.
+#define WRITE_JOB_COUNT 4
+
+// Number of threads storing requested captures to disk.
+#define WRITER_THREAD_COUNT 2
+
+// Initial capacity of the job buffers. The depth/IR frame is at most 1024x1024 16-bit pixels, the MJPEG frame is
+// compressed and well under the size of a raw 3072P frame.
+#define DEPTH_BUFFER_RESERVE (1024 * 1024 * sizeof(uint16_t))
+#define COLOR_BUFFER_RESERVE (4096 * 3072)
+
 #ifdef _WIN32
 void VERIFY_HR(HRESULT hr)
 {
@@ -28,7 +39,8 @@ K4AFastCapture::K4AFastCapture() :
     m_streaming(true),
     m_device(NULL),
     m_capture(NULL),
-    m_deviceConfig(K4A_DEVICE_CONFIG_INIT_DISABLE_ALL)
+    m_deviceConfig(K4A_DEVICE_CONFIG_INIT_DISABLE_ALL),
+    m_writersExit(false)
 {
 
 #ifdef _WIN32
@@ -57,6 +69,7 @@ K4AFastCapture::K4AFastCapture() :
 
 K4AFastCapture::~K4AFastCapture()
 {
+    StopWriters();
 
     if (m_device != NULL)
     {
@@ -173,13 +186,26 @@ bool K4AFastCapture::Configure(const char *fileDirectory, int32_t exposureValue,
 #endif
     try
     {
-        m_pcmImg.resize(m_pcmOutputHeight * m_pcmOutputWidth);
+        for (int i = 0; i < WRITE_JOB_COUNT; i++)
+        {
+            std::unique_ptr<WriteJob> job(new WriteJob());
+            job->depthData.reserve(DEPTH_BUFFER_RESERVE);
+            job->colorData.reserve(COLOR_BUFFER_RESERVE);
+#ifdef _WIN32
+            job->pcmImg.resize(m_pcmOutputHeight * m_pcmOutputWidth);
+#endif
+            job->depthIsPcm = false;
+            m_freeWriteJobs.push_back(job.get());
+            m_writeJobs.push_back(std::move(job));
+        }
     }
     catch (std::bad_alloc const &)
     {
         std::cout << "Memory allocation failed. " << std::endl;
         throw std::exception();
     }
+
+    StartWriters();
     return true;
 }
 
@@ -187,7 +213,6 @@ void K4AFastCapture::Run(int streamingLength)
 {
     std::string colorFileName;
     std::string depthFileName;
-    k4a_image_t ir_image = NULL;
     k4a_image_t depth_image = NULL;
     k4a_image_t color_image = NULL;
 
@@ -240,28 +265,29 @@ void K4AFastCapture::Run(int streamingLength)
         if (0 == result)
 #endif
         {
+            // Copy the frames into a job and hand it to the writer threads. The capture done signal is sent by the
+            // writer once the frames are on disk.
+            WriteJob *job = AcquireWriteJob();
+
+            job->depthFileName = depthFileName;
+            job->colorFileName = colorFileName;
+            job->depthIsPcm = false;
+
             if (m_deviceConfig.depth_mode == K4A_DEPTH_MODE_PASSIVE_IR)
             {
                 // for the passive IR mode, there is no depth image. Only IR image is available in the capture.
-                ir_image = k4a_capture_get_ir_image(m_capture);
-                assert(ir_image != NULL); // Because m_deviceConfig.synchronized_images_only == true
+                depth_image = k4a_capture_get_ir_image(m_capture);
+                assert(depth_image != NULL); // Because m_deviceConfig.synchronized_images_only == true
 
-                // Do work with the frames
-                // write captures to disk
 #ifdef _WIN32
-                depthFileName += ".png";
                 // On Windows, write the IR image to .png file.
                 // SavePcmToImage function encodes the pcm frame into lossless PNG format, which depends on Windows
                 // Imaging Component and it's only available on Windows.
-                SavePcmToImage(depthFileName.c_str(),
-                               m_pcmOutputHeight,
-                               m_pcmOutputWidth,
-                               k4a_image_get_buffer(ir_image),
-                               k4a_image_get_size(ir_image));
+                job->depthFileName += ".png";
+                job->depthIsPcm = true;
 #else
                 // For other platforms, write IR image to .bin file.
-                depthFileName += ".bin";
-                WriteToFile(depthFileName.c_str(), k4a_image_get_buffer(ir_image), k4a_image_get_size(ir_image));
+                job->depthFileName += ".bin";
 #endif
             }
             else
@@ -270,32 +296,29 @@ void K4AFastCapture::Run(int streamingLength)
                 assert(depth_image != NULL); // Because m_deviceConfig.synchronized_images_only == true
 
                 // write depth frame to .bin
-                depthFileName += ".bin";
-                WriteToFile(depthFileName.c_str(), k4a_image_get_buffer(depth_image), k4a_image_get_size(depth_image));
+                job->depthFileName += ".bin";
             }
 
             color_image = k4a_capture_get_color_image(m_capture);
             assert(color_image != NULL); // Because m_deviceConfig.synchronized_images_only == true
 
-            WriteToFile(colorFileName.c_str(), k4a_image_get_buffer(color_image), k4a_image_get_size(color_image));
-
-            m_frameRequestedNum++;
-
-#ifdef _WIN32
-            SetEvent(m_captureDoneEvent.Get());
-            ResetEvent(m_captureRequestedEvent.Get());
-#else
-            sem_post(m_captureDoneSem);
-#endif
-
             if (depth_image)
             {
+                uint8_t *buffer = k4a_image_get_buffer(depth_image);
+                job->depthData.assign(buffer, buffer + k4a_image_get_size(depth_image));
                 k4a_image_release(depth_image);
+                depth_image = NULL;
             }
             if (color_image)
             {
+                uint8_t *buffer = k4a_image_get_buffer(color_image);
+                job->colorData.assign(buffer, buffer + k4a_image_get_size(color_image));
                 k4a_image_release(color_image);
+                color_image = NULL;
             }
+
+            QueueWriteJob(job);
+            m_frameRequestedNum++;
         }
         // release frame
         k4a_capture_release(m_capture);
@@ -313,6 +336,9 @@ void K4AFastCapture::Run(int streamingLength)
         }
     }
     std::cout << "[Streaming Service] Exiting as requested..." << std::endl;
+
+    // Store the captures that are still queued before returning.
+    StopWriters();
     return;
 }
 
@@ -321,12 +347,113 @@ void K4AFastCapture::Stop()
     m_streaming = false;
 }
 
+void K4AFastCapture::StartWriters()
+{
+    m_writersExit = false;
+    for (int i = 0; i < WRITER_THREAD_COUNT; i++)
+    {
+        m_writers.emplace_back(&K4AFastCapture::WriterThread, this);
+    }
+}
+
+void K4AFastCapture::StopWriters()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_writersExit = true;
+    }
+    m_writeQueued.notify_all();
+
+    for (std::thread &writer : m_writers)
+    {
+        writer.join();
+    }
+    m_writers.clear();
+}
+
+K4AFastCapture::WriteJob *K4AFastCapture::AcquireWriteJob()
+{
+    // Only blocks when every job is still queued, the trigger app waits for each capture before requesting the next
+    // one so this does not happen in practice.
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    m_writeJobFreed.wait(lock, [this] { return !m_freeWriteJobs.empty(); });
+
+    WriteJob *job = m_freeWriteJobs.back();
+    m_freeWriteJobs.pop_back();
+    return job;
+}
+
+void K4AFastCapture::QueueWriteJob(WriteJob *job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_pendingWriteJobs.push_back(job);
+    }
+    m_writeQueued.notify_one();
+}
+
+void K4AFastCapture::WriterThread()
+{
+    for (;;)
+    {
+        WriteJob *job = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_writeMutex);
+            m_writeQueued.wait(lock, [this] { return m_writersExit || !m_pendingWriteJobs.empty(); });
+
+            // Drain the queue before exiting so that every signaled capture reaches the disk.
+            if (m_pendingWriteJobs.empty())
+            {
+                return;
+            }
+            job = m_pendingWriteJobs.front();
+            m_pendingWriteJobs.pop_front();
+        }
+
+#ifdef _WIN32
+        if (job->depthIsPcm)
+        {
+            SavePcmToImage(job->depthFileName.c_str(),
+                           m_pcmOutputHeight,
+                           m_pcmOutputWidth,
+                           job->depthData.data(),
+                           job->depthData.size(),
+                           job->pcmImg);
+        }
+        else
+#endif
+        {
+            WriteToFile(job->depthFileName.c_str(), job->depthData.data(), job->depthData.size());
+        }
+        WriteToFile(job->colorFileName.c_str(), job->colorData.data(), job->colorData.size());
+
+        SignalCaptureDone();
+
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            m_freeWriteJobs.push_back(job);
+        }
+        m_writeJobFreed.notify_one();
+    }
+}
+
+void K4AFastCapture::SignalCaptureDone()
+{
+#ifdef _WIN32
+    SetEvent(m_captureDoneEvent.Get());
+    ResetEvent(m_captureRequestedEvent.Get());
+#else
+    sem_post(m_captureDoneSem);
+#endif
+}
+
 #ifdef _WIN32
 void K4AFastCapture::SavePcmToImage(const char *fileName,
                                     unsigned int height,
                                     unsigned int width,
                                     uint8_t *data,
-                                    size_t dataSize)
+                                    size_t dataSize,
+                                    std::vector<char> &pcmImg)
 {
     assert(height > 0);
     assert(width > 0);
@@ -368,10 +495,10 @@ void K4AFastCapture::SavePcmToImage(const char *fileName,
         {
             pcm[i] = 0;
         }
-        m_pcmImg[i] = static_cast<char>(min(pcm[i] >> m_pcmShiftValue, 0xFF));
+        pcmImg[i] = static_cast<char>(min(pcm[i] >> m_pcmShiftValue, 0xFF));
     }
 
-    VERIFY_HR(frame->WritePixels(height, width * sizeof(char), height * width * sizeof(char), (BYTE *)m_pcmImg.data()));
+    VERIFY_HR(frame->WritePixels(height, width * sizeof(char), height * width * sizeof(char), (BYTE *)pcmImg.data()));
     VERIFY_HR(frame->Commit());
     VERIFY_HR(encoder->Commit());
     CoUninitialize();
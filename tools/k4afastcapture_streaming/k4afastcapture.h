@@ -5,6 +5,11 @@
 #define K4AFASTCAPTURE_H
 
 #include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <k4a/k4a.h>
 #include <math.h>
 #include <string.h>
@@ -35,11 +40,35 @@ public:
     void Stop();
 
 private:
+    // A requested capture copied out of the SDK buffers, waiting to be written by a writer thread. The buffers keep
+    // their capacity when the job is returned to the free list, so they are only allocated once.
+    struct WriteJob
+    {
+        std::string depthFileName;
+        std::string colorFileName;
+        std::vector<uint8_t> depthData;
+        std::vector<uint8_t> colorData;
+        std::vector<char> pcmImg;
+        bool depthIsPcm;
+    };
+
+    void StartWriters();
+    void StopWriters();
+    void WriterThread();
+    WriteJob *AcquireWriteJob();
+    void QueueWriteJob(WriteJob *job);
+    void SignalCaptureDone();
+
     long WriteToFile(const char *fileName, void *buffer, size_t bufferSize);
 
     // SavePcmToImage function encodes the pcm frame into lossless PNG format, which depends on Windows Imaging
     // Component. It's only available on Windows.
-    void SavePcmToImage(const char *fileName, unsigned int width, unsigned int height, uint8_t *data, size_t dataSize);
+    void SavePcmToImage(const char *fileName,
+                        unsigned int width,
+                        unsigned int height,
+                        uint8_t *data,
+                        size_t dataSize,
+                        std::vector<char> &pcmImg);
 
     std::string m_colorFileDirectory;
     std::string m_depthFileDirectory;
@@ -54,7 +83,17 @@ private:
     k4a_device_t m_device;
     k4a_capture_t m_capture;
     k4a_device_configuration_t m_deviceConfig;
-    std::vector<char> m_pcmImg;
+
+    // Write-behind queue: the streaming thread copies a requested capture into a free job and the writer threads
+    // store it, so the streaming loop never waits on the disk.
+    std::vector<std::unique_ptr<WriteJob>> m_writeJobs;
+    std::vector<WriteJob *> m_freeWriteJobs;
+    std::deque<WriteJob *> m_pendingWriteJobs;
+    std::vector<std::thread> m_writers;
+    std::mutex m_writeMutex;
+    std::condition_variable m_writeQueued;
+    std::condition_variable m_writeJobFreed;
+    bool m_writersExit;
 
 #ifdef _WIN32
     Microsoft::WRL::Wrappers::Event m_captureRequestedEvent;
@@ -17,6 +17,9 @@
 #include <chrono>
 #include <csignal>
 #include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace std::chrono;
 
@@ -112,6 +115,9 @@ static int string_compare(const char *s1, const char *s2)
 int main(int argc, char **argv)
 {
     int device_index = 0;
+    bool device_index_set = false;
+    std::vector<uint8_t> device_indices;
+    bool wired_sync_mode_set = false;
     int recording_length = -1;
     k4a_image_format_t recording_color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
     k4a_color_resolution_t recording_color_resolution = K4A_COLOR_RESOLUTION_1080P;
@@ -119,6 +125,9 @@ int main(int argc, char **argv)
     k4a_fps_t recording_rate = K4A_FRAMES_PER_SECOND_30;
     bool recording_rate_set = false;
     bool recording_imu_enabled = true;
+    bool recording_index_enabled = false;
+    k4a_record_depth_codec_t recording_depth_codec = K4A_RECORD_DEPTH_CODEC_RAW;
+    k4a_record_color_codec_t recording_color_codec = K4A_RECORD_COLOR_CODEC_RAW;
     k4a_wired_sync_mode_t wired_sync_mode = K4A_WIRED_SYNC_MODE_STANDALONE;
     int32_t depth_delay_off_color_usec = 0;
     uint32_t subordinate_delay_off_master_usec = 0;
@@ -140,6 +149,40 @@ int main(int argc, char **argv)
                                   device_index = std::stoi(args[0]);
                                   if (device_index < 0 || device_index > 255)
                                       throw std::runtime_error("Device index must 0-255");
+                                  device_index_set = true;
+                              });
+    cmd_parser.RegisterOption("--devices",
+                              "Record from several devices in one process, each to its own file named after the\n"
+                              "device serial number. Comma separated device indexes, or ALL. The sync mode of each\n"
+                              "device is taken from its sync jacks and subordinates are started before the master.",
+                              1,
+                              [&](const std::vector<char *> &args) {
+                                  device_indices.clear();
+                                  if (string_compare(args[0], "all") == 0)
+                                  {
+                                      uint32_t device_count = k4a_device_get_installed_count();
+                                      for (uint32_t i = 0; i < device_count && i < 256; i++)
+                                      {
+                                          device_indices.push_back((uint8_t)i);
+                                      }
+                                  }
+                                  else
+                                  {
+                                      std::istringstream split(args[0]);
+                                      std::string index;
+                                      while (std::getline(split, index, ','))
+                                      {
+                                          int value = std::stoi(index);
+                                          if (value < 0 || value > 255)
+                                              throw std::runtime_error("Device index must 0-255");
+                                          if (std::find(device_indices.begin(), device_indices.end(), value) !=
+                                              device_indices.end())
+                                              throw std::runtime_error("Device index listed twice");
+                                          device_indices.push_back((uint8_t)value);
+                                      }
+                                  }
+                                  if (device_indices.empty())
+                                      throw std::runtime_error("No devices to record from");
                               });
     cmd_parser.RegisterOption("-l|--record-length",
                               "Limit the recording to N seconds (default: infinite)",
@@ -245,6 +288,46 @@ int main(int argc, char **argv)
                               [&](const std::vector<char *> &args) {
                                   depth_delay_off_color_usec = std::stoi(args[0]);
                               });
+    cmd_parser.RegisterOption("--depth-codec",
+                              "Set the codec of the depth and IR tracks (default: RAW), Available options:\n"
+                              "RAW, RVL (lossless compression)",
+                              1,
+                              [&](const std::vector<char *> &args) {
+                                  if (string_compare(args[0], "raw") == 0)
+                                  {
+                                      recording_depth_codec = K4A_RECORD_DEPTH_CODEC_RAW;
+                                  }
+                                  else if (string_compare(args[0], "rvl") == 0)
+                                  {
+                                      recording_depth_codec = K4A_RECORD_DEPTH_CODEC_RVL;
+                                  }
+                                  else
+                                  {
+                                      std::ostringstream str;
+                                      str << "Unknown depth codec specified: " << args[0];
+                                      throw std::runtime_error(str.str());
+                                  }
+                              });
+    cmd_parser.RegisterOption("--color-codec",
+                              "Set the codec of the color track (default: RAW), Available options:\n"
+                              "RAW, MJPG (compresses NV12 and YUY2 color modes)",
+                              1,
+                              [&](const std::vector<char *> &args) {
+                                  if (string_compare(args[0], "raw") == 0)
+                                  {
+                                      recording_color_codec = K4A_RECORD_COLOR_CODEC_RAW;
+                                  }
+                                  else if (string_compare(args[0], "mjpg") == 0)
+                                  {
+                                      recording_color_codec = K4A_RECORD_COLOR_CODEC_MJPG;
+                                  }
+                                  else
+                                  {
+                                      std::ostringstream str;
+                                      str << "Unknown color codec specified: " << args[0];
+                                      throw std::runtime_error(str.str());
+                                  }
+                              });
     cmd_parser.RegisterOption("-r|--rate",
                               "Set the camera frame rate in Frames per Second\n"
                               "Default is the maximum rate supported by the camera modes.\n"
@@ -290,10 +373,30 @@ int main(int argc, char **argv)
                                       throw std::runtime_error(str.str());
                                   }
                               });
+    cmd_parser.RegisterOption("--index",
+                              "Write a sidecar index next to the recording for faster playback (ON, OFF, default: OFF)",
+                              1,
+                              [&](const std::vector<char *> &args) {
+                                  if (string_compare(args[0], "on") == 0)
+                                  {
+                                      recording_index_enabled = true;
+                                  }
+                                  else if (string_compare(args[0], "off") == 0)
+                                  {
+                                      recording_index_enabled = false;
+                                  }
+                                  else
+                                  {
+                                      std::ostringstream str;
+                                      str << "Unknown index mode specified: " << args[0];
+                                      throw std::runtime_error(str.str());
+                                  }
+                              });
     cmd_parser.RegisterOption("--external-sync",
                               "Set the external sync mode (Master, Subordinate, Standalone default: Standalone)",
                               1,
                               [&](const std::vector<char *> &args) {
+                                  wired_sync_mode_set = true;
                                   if (string_compare(args[0], "master") == 0)
                                   {
                                       wired_sync_mode = K4A_WIRED_SYNC_MODE_MASTER;
@@ -393,7 +496,13 @@ int main(int argc, char **argv)
             return 1;
         }
     }
-    if (subordinate_delay_off_master_usec > 0 && wired_sync_mode != K4A_WIRED_SYNC_MODE_SUBORDINATE)
+    if (!device_indices.empty() && (device_index_set || wired_sync_mode_set))
+    {
+        std::cerr << "--devices can't be combined with --device or --external-sync." << std::endl;
+        return 1;
+    }
+    if (subordinate_delay_off_master_usec > 0 && wired_sync_mode != K4A_WIRED_SYNC_MODE_SUBORDINATE &&
+        device_indices.empty())
     {
         std::cerr << "--sync-delay is only valid if --external-sync is set to Subordinate." << std::endl;
         return 1;
@@ -427,11 +536,28 @@ int main(int argc, char **argv)
     device_config.depth_delay_off_color_usec = depth_delay_off_color_usec;
     device_config.subordinate_delay_off_master_usec = subordinate_delay_off_master_usec;
 
+    if (!device_indices.empty())
+    {
+        return do_multi_recording(device_indices,
+                                  recording_filename,
+                                  recording_length,
+                                  &device_config,
+                                  recording_imu_enabled,
+                                  recording_index_enabled,
+                                  recording_depth_codec,
+                                  recording_color_codec,
+                                  absoluteExposureValue,
+                                  gain);
+    }
+
     return do_recording((uint8_t)device_index,
                         recording_filename,
                         recording_length,
                         &device_config,
                         recording_imu_enabled,
+                        recording_index_enabled,
+                        recording_depth_codec,
+                        recording_color_codec,
                         absoluteExposureValue,
                         gain);
 }
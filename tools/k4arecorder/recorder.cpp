@@ -7,9 +7,17 @@
 #include <atomic>
 #include <iostream>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <k4a/k4a.h>
 #include <k4arecord/record.h>
+#include <k4arecord/playback.h>
 
 using namespace std::chrono;
 
@@ -48,26 +56,14 @@ inline static uint32_t k4a_convert_fps_to_uint(k4a_fps_t fps)
 
 std::atomic_bool exiting(false);
 
-int do_recording(uint8_t device_index,
-                 char *recording_filename,
-                 int recording_length,
-                 k4a_device_configuration_t *device_config,
-                 bool record_imu,
-                 int32_t absoluteExposureValue,
-                 int32_t gain)
+// Opens a device and prints its serial number and firmware versions
+static int open_device(uint8_t device_index, k4a_device_t *device_out, std::string *serial_number)
 {
-    seconds recording_length_seconds(recording_length);
-    const uint32_t installed_devices = k4a_device_get_installed_count();
-    if (device_index >= installed_devices)
-    {
-        std::cerr << "Device not found." << std::endl;
-        return 1;
-    }
-
     k4a_device_t device;
     if (K4A_FAILED(k4a_device_open(device_index, &device)))
     {
         std::cerr << "Runtime error: k4a_device_open() failed " << std::endl;
+        return 1;
     }
 
     char serial_number_buffer[256];
@@ -87,15 +83,13 @@ int do_recording(uint8_t device_index,
               << "; A: " << version_info.audio.major << "." << version_info.audio.minor << "."
               << version_info.audio.iteration << std::endl;
 
-    uint32_t camera_fps = k4a_convert_fps_to_uint(device_config->camera_fps);
-
-    if (camera_fps <= 0 || (device_config->color_resolution == K4A_COLOR_RESOLUTION_OFF &&
-                            device_config->depth_mode == K4A_DEPTH_MODE_OFF))
-    {
-        std::cerr << "Either the color or depth modes must be enabled to record." << std::endl;
-        return 1;
-    }
+    *device_out = device;
+    *serial_number = serial_number_buffer;
+    return 0;
+}
 
+static void set_color_controls(k4a_device_t device, int32_t absoluteExposureValue, int32_t gain)
+{
     if (absoluteExposureValue != defaultExposureAuto)
     {
         if (K4A_FAILED(k4a_device_set_color_control(device,
@@ -125,27 +119,317 @@ int do_recording(uint8_t device_index,
             std::cerr << "Runtime error: k4a_device_set_color_control() for manual gain failed " << std::endl;
         }
     }
+}
 
-    CHECK(k4a_device_start_cameras(device, device_config), device);
-    if (record_imu)
+// Creates a recording file and writes its header
+static k4a_result_t create_recording(const char *recording_filename,
+                                     k4a_device_t device,
+                                     const k4a_device_configuration_t *device_config,
+                                     bool record_imu,
+                                     k4a_record_depth_codec_t depth_codec,
+                                     k4a_record_color_codec_t color_codec,
+                                     k4a_record_t *recording_out)
+{
+    k4a_record_t recording;
+    if (K4A_FAILED(k4a_record_create(recording_filename, device, *device_config, &recording)))
     {
-        CHECK(k4a_device_start_imu(device), device);
+        std::cerr << "Unable to create recording file: " << recording_filename << std::endl;
+        return K4A_RESULT_FAILED;
     }
 
-    std::cout << "Device started" << std::endl;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    if (depth_codec != K4A_RECORD_DEPTH_CODEC_RAW)
+    {
+        result = k4a_record_set_depth_codec(recording, depth_codec);
+    }
+    if (K4A_SUCCEEDED(result) && color_codec != K4A_RECORD_COLOR_CODEC_RAW)
+    {
+        result = k4a_record_set_color_codec(recording, color_codec);
+    }
+    if (K4A_SUCCEEDED(result) && record_imu)
+    {
+        result = k4a_record_add_imu_track(recording);
+    }
+    if (K4A_SUCCEEDED(result))
+    {
+        result = k4a_record_write_header(recording);
+    }
 
-    k4a_record_t recording;
-    if (K4A_FAILED(k4a_record_create(recording_filename, device, *device_config, &recording)))
+    if (K4A_FAILED(result))
+    {
+        k4a_record_close(recording);
+        return result;
+    }
+    *recording_out = recording;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static void write_recording_index(const char *recording_filename)
+{
+    k4a_playback_t playback = NULL;
+    if (K4A_FAILED(k4a_playback_open(recording_filename, &playback)) || K4A_FAILED(k4a_playback_write_index(playback)))
+    {
+        // The recording itself is still valid without an index.
+        std::cerr << "Failed to write the recording index: " << recording_filename << std::endl;
+    }
+    if (playback != NULL)
+    {
+        k4a_playback_close(playback);
+    }
+}
+
+// Fixed size single producer, single consumer queue. The reader threads push and the recording thread pops without
+// taking a lock, so neither waits for the other.
+template<typename T, size_t capacity> class handoff_ring_t
+{
+public:
+    bool try_push(const T &item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == capacity)
+        {
+            return false;
+        }
+        m_items[tail % capacity] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T *item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        *item = m_items[head % capacity];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T m_items[capacity];
+    std::atomic<size_t> m_head{ 0 };
+    std::atomic<size_t> m_tail{ 0 };
+};
+
+// Captures read ahead of the recording thread, about half a second at 30 fps
+static const size_t capture_handoff_size = 16;
+
+// IMU samples read ahead of the recording thread, about two seconds at the 1.6 kHz sample rate
+static const size_t imu_handoff_size = 4096;
+
+// State shared by the reader threads and the recording thread of a single device recording
+struct recording_state_t
+{
+    k4a_device_t device = NULL;
+    int32_t timeout_ms = 0;
+    std::atomic_bool stop{ false };
+    std::atomic_bool read_failed{ false };
+
+    handoff_ring_t<k4a_capture_t, capture_handoff_size> captures;
+    handoff_ring_t<k4a_imu_sample_t, imu_handoff_size> imu_samples;
+
+    // Written by the reader threads
+    std::atomic<uint64_t> captures_dropped{ 0 };
+    std::atomic<uint64_t> imu_samples_dropped{ 0 };
+
+    // Written by the recording thread
+    uint64_t captures_written = 0;
+    uint64_t imu_samples_written = 0;
+    std::vector<k4a_imu_sample_t> imu_batch; // The IMU samples written with the next k4a_record_write_imu_samples()
+    steady_clock::duration write_time_total = steady_clock::duration::zero();
+    steady_clock::duration write_time_max = steady_clock::duration::zero();
+};
+
+static void read_captures(recording_state_t *state)
+{
+    while (!state->stop)
+    {
+        k4a_capture_t capture;
+        k4a_wait_result_t result = k4a_device_get_capture(state->device, &capture, state->timeout_ms);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            if (!state->captures.try_push(capture))
+            {
+                // The recording thread is behind, keep the captures it already has
+                k4a_capture_release(capture);
+                state->captures_dropped++;
+            }
+        }
+        else if (result != K4A_WAIT_RESULT_TIMEOUT)
+        {
+            std::cerr << "Runtime error: k4a_device_get_capture() returned " << result << std::endl;
+            state->read_failed = true;
+            break;
+        }
+    }
+}
+
+static void read_imu_samples(recording_state_t *state)
+{
+    while (!state->stop)
+    {
+        k4a_imu_sample_t sample;
+        k4a_wait_result_t result = k4a_device_get_imu_sample(state->device, &sample, state->timeout_ms);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            if (!state->imu_samples.try_push(sample))
+            {
+                state->imu_samples_dropped++;
+            }
+        }
+        else if (result != K4A_WAIT_RESULT_TIMEOUT)
+        {
+            std::cerr << "Runtime error: k4a_imu_get_sample() returned " << result << std::endl;
+            state->read_failed = true;
+            break;
+        }
+    }
+}
+
+// Writes one pending capture and the IMU samples read so far. Returns false if there was nothing to write.
+static bool write_pending_data(recording_state_t *state, k4a_record_t recording, bool *write_failed)
+{
+    bool wrote = false;
+
+    k4a_capture_t capture;
+    if (state->captures.try_pop(&capture))
+    {
+        steady_clock::time_point write_start = steady_clock::now();
+        k4a_result_t result = k4a_record_write_capture(recording, capture);
+        steady_clock::duration write_time = steady_clock::now() - write_start;
+        k4a_capture_release(capture);
+        if (K4A_FAILED(result))
+        {
+            std::cerr << "Runtime error: k4a_record_write_capture() returned " << result << std::endl;
+            *write_failed = true;
+            return true;
+        }
+
+        state->captures_written++;
+        state->write_time_total += write_time;
+        state->write_time_max = std::max(state->write_time_max, write_time);
+        wrote = true;
+    }
+
+    // The samples read so far are written together, instead of one call per sample at the IMU rate.
+    k4a_imu_sample_t sample;
+    state->imu_batch.clear();
+    while (state->imu_samples.try_pop(&sample))
+    {
+        state->imu_batch.push_back(sample);
+    }
+    if (!state->imu_batch.empty())
+    {
+        k4a_result_t result = k4a_record_write_imu_samples(recording,
+                                                           state->imu_batch.data(),
+                                                           state->imu_batch.size());
+        if (K4A_FAILED(result))
+        {
+            std::cerr << "Runtime error: k4a_record_write_imu_samples() returned " << result << std::endl;
+            *write_failed = true;
+            return true;
+        }
+        state->imu_samples_written += state->imu_batch.size();
+        wrote = true;
+    }
+
+    return wrote;
+}
+
+static void release_pending_data(recording_state_t *state)
+{
+    k4a_capture_t capture;
+    while (state->captures.try_pop(&capture))
+    {
+        k4a_capture_release(capture);
+    }
+}
+
+static void print_recording_report(recording_state_t *state,
+                                   k4a_record_t recording,
+                                   const k4a_capture_stats_t *capture_stats)
+{
+    std::cout << "Captures written: " << state->captures_written << ", IMU samples written: "
+              << state->imu_samples_written << std::endl;
+
+    if (state->captures_written > 0)
+    {
+        double average_ms = duration<double, std::milli>(state->write_time_total).count() /
+                            (double)state->captures_written;
+        double max_ms = duration<double, std::milli>(state->write_time_max).count();
+        std::cout << "Capture write time: average " << average_ms << " ms, max " << max_ms << " ms" << std::endl;
+    }
+
+    uint64_t recording_dropped = 0;
+    (void)k4a_record_get_dropped_image_count(recording, &recording_dropped);
+
+    std::cout << "Dropped by the recorder: " << state->captures_dropped << " captures, " << state->imu_samples_dropped
+              << " IMU samples; by the write queue: " << recording_dropped << " images";
+    if (capture_stats != NULL)
+    {
+        std::cout << "; by the SDK: " << capture_stats->output_queue_overflow << " captures not read in time, "
+                  << capture_stats->depth_queue_overflow + capture_stats->color_queue_overflow
+                  << " images on sync queue overflow";
+    }
+    std::cout << std::endl;
+}
+
+int do_recording(uint8_t device_index,
+                 char *recording_filename,
+                 int recording_length,
+                 k4a_device_configuration_t *device_config,
+                 bool record_imu,
+                 bool write_index,
+                 k4a_record_depth_codec_t depth_codec,
+                 k4a_record_color_codec_t color_codec,
+                 int32_t absoluteExposureValue,
+                 int32_t gain)
+{
+    seconds recording_length_seconds(recording_length);
+    const uint32_t installed_devices = k4a_device_get_installed_count();
+    if (device_index >= installed_devices)
+    {
+        std::cerr << "Device not found." << std::endl;
+        return 1;
+    }
+
+    k4a_device_t device;
+    std::string serial_number;
+    if (open_device(device_index, &device, &serial_number) != 0)
     {
-        std::cerr << "Unable to create recording file: " << recording_filename << std::endl;
         return 1;
     }
 
+    uint32_t camera_fps = k4a_convert_fps_to_uint(device_config->camera_fps);
+
+    if (camera_fps <= 0 || (device_config->color_resolution == K4A_COLOR_RESOLUTION_OFF &&
+                            device_config->depth_mode == K4A_DEPTH_MODE_OFF))
+    {
+        std::cerr << "Either the color or depth modes must be enabled to record." << std::endl;
+        return 1;
+    }
+
+    set_color_controls(device, absoluteExposureValue, gain);
+
+    CHECK(k4a_device_start_cameras(device, device_config), device);
     if (record_imu)
     {
-        CHECK(k4a_record_add_imu_track(recording), device);
+        CHECK(k4a_device_start_imu(device), device);
     }
-    CHECK(k4a_record_write_header(recording), device);
+
+    std::cout << "Device started" << std::endl;
+
+    k4a_record_t recording;
+    CHECK(create_recording(recording_filename,
+                           device,
+                           device_config,
+                           record_imu,
+                           depth_codec,
+                           color_codec,
+                           &recording),
+          device);
 
     // Wait for the first capture before starting recording.
     k4a_capture_t capture;
@@ -190,69 +474,504 @@ int do_recording(uint8_t device_index,
         std::cout << "Press Ctrl-C to stop recording." << std::endl;
     }
 
+    // Kept off the stack, the IMU hand-off alone is a few hundred kilobytes
+    std::unique_ptr<recording_state_t> state(new recording_state_t());
+    state->device = device;
+    state->timeout_ms = 1000 / (int32_t)camera_fps;
+    std::thread capture_reader(read_captures, state.get());
+    std::thread imu_reader;
+    if (record_imu)
+    {
+        imu_reader = std::thread(read_imu_samples, state.get());
+    }
+
+    // This thread only writes, so a slow write delays the file but not the reading of captures and IMU samples
     steady_clock::time_point recording_start = steady_clock::now();
-    int32_t timeout_ms = 1000 / camera_fps;
-    do
+    bool write_failed = false;
+    while (!exiting && !write_failed && !state->read_failed &&
+           (recording_length < 0 || (steady_clock::now() - recording_start < recording_length_seconds)))
     {
-        result = k4a_device_get_capture(device, &capture, timeout_ms);
-        if (result == K4A_WAIT_RESULT_TIMEOUT)
+        if (!write_pending_data(state.get(), recording, &write_failed))
         {
-            continue;
+            std::this_thread::sleep_for(milliseconds(1));
         }
-        else if (result != K4A_WAIT_RESULT_SUCCEEDED)
+    }
+
+    if (!exiting)
+    {
+        exiting = true;
+        std::cout << "Stopping recording..." << std::endl;
+    }
+
+    state->stop = true;
+    capture_reader.join();
+    if (imu_reader.joinable())
+    {
+        imu_reader.join();
+    }
+
+    // Write what was read before the readers stopped
+    while (!write_failed && write_pending_data(state.get(), recording, &write_failed))
+    {
+    }
+    release_pending_data(state.get());
+
+    k4a_capture_stats_t capture_stats = {};
+    bool capture_stats_valid = K4A_SUCCEEDED(k4a_device_get_capture_stats(device, &capture_stats));
+
+    if (record_imu)
+    {
+        k4a_device_stop_imu(device);
+    }
+    k4a_device_stop_cameras(device);
+
+    print_recording_report(state.get(), recording, capture_stats_valid ? &capture_stats : NULL);
+
+    if (write_failed || state->read_failed)
+    {
+        k4a_record_close(recording);
+        k4a_device_close(device);
+        return 1;
+    }
+
+    std::cout << "Saving recording..." << std::endl;
+    CHECK(k4a_record_flush(recording), device);
+    k4a_record_close(recording);
+
+    if (write_index)
+    {
+        std::cout << "Writing recording index..." << std::endl;
+        write_recording_index(recording_filename);
+    }
+
+    std::cout << "Done" << std::endl;
+
+    k4a_device_close(device);
+
+    return 0;
+}
+
+// Most captures a device may have waiting for the writer. When the disk falls behind, the oldest capture of the device
+// is dropped so the capture thread keeps up with the camera.
+static const size_t max_pending_captures = 8;
+
+// A capture or IMU sample read from a device, waiting to be written
+struct pending_write_t
+{
+    k4a_capture_t capture; // NULL for an IMU sample
+    k4a_imu_sample_t imu_sample;
+};
+
+// State of one device of a multi-device recording. The pending writes are guarded by the scheduler lock.
+struct device_recording_t
+{
+    uint8_t device_index;
+    k4a_device_t device = NULL;
+    k4a_device_configuration_t config;
+    std::string filename;
+    k4a_record_t recording = NULL;
+    std::thread capture_thread;
+
+    std::deque<pending_write_t> pending;
+    size_t pending_captures = 0;
+    uint64_t dropped_captures = 0;
+    bool capture_done = false;
+
+    // Set by the capture thread or the writer, read by both
+    std::atomic_bool failed{ false };
+};
+
+// Hands the captures of every device to a single writer, one device at a time, so the recordings grow at the same pace
+// and their clusters reach the disk interleaved instead of in bursts per device.
+struct write_scheduler_t
+{
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<std::unique_ptr<device_recording_t>> devices;
+};
+
+// Inserts the serial number of the device before the extension, output.mkv becomes output-000123456789.mkv
+static std::string device_recording_filename(const char *recording_filename, const std::string &serial_number)
+{
+    std::string filename(recording_filename);
+    size_t extension = filename.find_last_of('.');
+    size_t separator = filename.find_last_of("/\\");
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+    {
+        extension = filename.size();
+    }
+    return filename.substr(0, extension) + "-" + serial_number + filename.substr(extension);
+}
+
+static void queue_write(write_scheduler_t *scheduler, device_recording_t *device, const pending_write_t &write)
+{
+    std::lock_guard<std::mutex> lock(scheduler->lock);
+    if (write.capture != NULL)
+    {
+        if (device->pending_captures == max_pending_captures)
         {
-            std::cerr << "Runtime error: k4a_device_get_capture() returned " << result << std::endl;
+            // Drop the oldest capture, IMU samples are small and always kept
+            for (auto it = device->pending.begin(); it != device->pending.end(); ++it)
+            {
+                if (it->capture != NULL)
+                {
+                    k4a_capture_release(it->capture);
+                    device->pending.erase(it);
+                    device->pending_captures--;
+                    device->dropped_captures++;
+                    break;
+                }
+            }
+        }
+        device->pending_captures++;
+    }
+    device->pending.push_back(write);
+    scheduler->ready.notify_one();
+}
+
+static void capture_thread(write_scheduler_t *scheduler,
+                           device_recording_t *device,
+                           bool record_imu,
+                           int recording_length)
+{
+    k4a_wait_result_t result = K4A_WAIT_RESULT_TIMEOUT;
+
+    // Wait for the first capture in a loop so Ctrl-C will still exit. Subordinates wait for the master to start.
+    seconds timeout_sec_for_first_capture(device->config.wired_sync_mode == K4A_WIRED_SYNC_MODE_SUBORDINATE ? 360 : 60);
+    steady_clock::time_point first_capture_start = steady_clock::now();
+    while (!exiting && (steady_clock::now() - first_capture_start) < timeout_sec_for_first_capture)
+    {
+        k4a_capture_t capture;
+        result = k4a_device_get_capture(device->device, &capture, 100);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            k4a_capture_release(capture);
             break;
         }
-        CHECK(k4a_record_write_capture(recording, capture), device);
-        k4a_capture_release(capture);
+        else if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            break;
+        }
+    }
 
-        if (record_imu)
+    if (result != K4A_WAIT_RESULT_SUCCEEDED && !exiting)
+    {
+        std::cerr << "Device " << (int)device->device_index << ": "
+                  << (result == K4A_WAIT_RESULT_TIMEOUT ? "timed out waiting for first capture."
+                                                        : "k4a_device_get_capture() failed.")
+                  << std::endl;
+        device->failed = true;
+        exiting = true;
+    }
+
+    seconds recording_length_seconds(recording_length);
+    steady_clock::time_point recording_start = steady_clock::now();
+    int32_t timeout_ms = 1000 / (int32_t)k4a_convert_fps_to_uint(device->config.camera_fps);
+    while (!exiting && (recording_length < 0 || (steady_clock::now() - recording_start < recording_length_seconds)))
+    {
+        pending_write_t write = {};
+        result = k4a_device_get_capture(device->device, &write.capture, timeout_ms);
+        if (result == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            queue_write(scheduler, device, write);
+        }
+        else if (result == K4A_WAIT_RESULT_FAILED)
         {
-            do
+            std::cerr << "Device " << (int)device->device_index
+                      << ": runtime error: k4a_device_get_capture() returned " << result << std::endl;
+            device->failed = true;
+            break;
+        }
+
+        while (record_imu)
+        {
+            pending_write_t imu_write = {};
+            if (k4a_device_get_imu_sample(device->device, &imu_write.imu_sample, 0) != K4A_WAIT_RESULT_SUCCEEDED)
+            {
+                break;
+            }
+            queue_write(scheduler, device, imu_write);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(scheduler->lock);
+    device->capture_done = true;
+    scheduler->ready.notify_one();
+}
+
+// Writes the pending captures and IMU samples until every capture thread is done and nothing is left to write. Each
+// round writes at most one capture per device, along with the IMU samples read before it.
+static void write_pending(write_scheduler_t *scheduler)
+{
+    std::unique_lock<std::mutex> lock(scheduler->lock);
+    for (;;)
+    {
+        bool idle = true;
+        bool done = true;
+        for (auto &device : scheduler->devices)
+        {
+            idle = idle && device->pending.empty();
+            done = done && device->capture_done && device->pending.empty();
+        }
+        if (done)
+        {
+            return;
+        }
+        if (idle)
+        {
+            scheduler->ready.wait(lock);
+            continue;
+        }
+
+        for (auto &device : scheduler->devices)
+        {
+            while (!device->pending.empty())
             {
-                k4a_imu_sample_t sample;
-                result = k4a_device_get_imu_sample(device, &sample, 0);
-                if (result == K4A_WAIT_RESULT_TIMEOUT)
+                pending_write_t write = device->pending.front();
+                device->pending.pop_front();
+                if (write.capture != NULL)
                 {
-                    break;
+                    device->pending_captures--;
+                }
+
+                lock.unlock();
+                k4a_result_t result;
+                if (write.capture != NULL)
+                {
+                    result = device->failed ? K4A_RESULT_FAILED : k4a_record_write_capture(device->recording,
+                                                                                             write.capture);
+                    k4a_capture_release(write.capture);
                 }
-                else if (result != K4A_WAIT_RESULT_SUCCEEDED)
+                else
                 {
-                    std::cerr << "Runtime error: k4a_imu_get_sample() returned " << result << std::endl;
-                    break;
+                    result = device->failed ? K4A_RESULT_FAILED :
+                                              k4a_record_write_imu_sample(device->recording, write.imu_sample);
                 }
-                k4a_result_t write_result = k4a_record_write_imu_sample(recording, sample);
-                if (K4A_FAILED(write_result))
+                if (K4A_FAILED(result) && !device->failed)
+                {
+                    std::cerr << "Device " << (int)device->device_index << ": runtime error writing "
+                              << device->filename << std::endl;
+                    device->failed = true;
+                    exiting = true;
+                }
+                lock.lock();
+
+                if (write.capture != NULL)
                 {
-                    std::cerr << "Runtime error: k4a_record_write_imu_sample() returned " << write_result << std::endl;
                     break;
                 }
-            } while (!exiting && result != K4A_WAIT_RESULT_FAILED &&
-                     (recording_length < 0 || (steady_clock::now() - recording_start < recording_length_seconds)));
+            }
         }
-    } while (!exiting && result != K4A_WAIT_RESULT_FAILED &&
-             (recording_length < 0 || (steady_clock::now() - recording_start < recording_length_seconds)));
+    }
+}
 
-    if (!exiting)
+int do_multi_recording(const std::vector<uint8_t> &device_indices,
+                       char *recording_filename,
+                       int recording_length,
+                       k4a_device_configuration_t *device_config,
+                       bool record_imu,
+                       bool write_index,
+                       k4a_record_depth_codec_t depth_codec,
+                       k4a_record_color_codec_t color_codec,
+                       int32_t absoluteExposureValue,
+                       int32_t gain)
+{
+    const uint32_t installed_devices = k4a_device_get_installed_count();
+    uint32_t camera_fps = k4a_convert_fps_to_uint(device_config->camera_fps);
+    if (camera_fps <= 0 || (device_config->color_resolution == K4A_COLOR_RESOLUTION_OFF &&
+                            device_config->depth_mode == K4A_DEPTH_MODE_OFF))
     {
-        exiting = true;
-        std::cout << "Stopping recording..." << std::endl;
+        std::cerr << "Either the color or depth modes must be enabled to record." << std::endl;
+        return 1;
     }
 
-    if (record_imu)
+    write_scheduler_t scheduler;
+    int result = 0;
+    size_t master_count = 0;
+    for (uint8_t device_index : device_indices)
     {
-        k4a_device_stop_imu(device);
+        if (device_index >= installed_devices)
+        {
+            std::cerr << "Device " << (int)device_index << " not found." << std::endl;
+            result = 1;
+            break;
+        }
+
+        std::unique_ptr<device_recording_t> device(new device_recording_t());
+        device->device_index = device_index;
+        std::string serial_number;
+        if (open_device(device_index, &device->device, &serial_number) != 0)
+        {
+            result = 1;
+            break;
+        }
+
+        // The sync cables decide the role of each device, as in a daisy chain only the master has no sync in
+        device->config = *device_config;
+        bool sync_in = false;
+        bool sync_out = false;
+        if (K4A_FAILED(k4a_device_get_sync_jack(device->device, &sync_in, &sync_out)))
+        {
+            std::cerr << "Runtime error: k4a_device_get_sync_jack() failed" << std::endl;
+        }
+        if (sync_in)
+        {
+            device->config.wired_sync_mode = K4A_WIRED_SYNC_MODE_SUBORDINATE;
+        }
+        else if (sync_out)
+        {
+            device->config.wired_sync_mode = K4A_WIRED_SYNC_MODE_MASTER;
+            device->config.subordinate_delay_off_master_usec = 0;
+            master_count++;
+        }
+        else
+        {
+            device->config.wired_sync_mode = K4A_WIRED_SYNC_MODE_STANDALONE;
+            device->config.subordinate_delay_off_master_usec = 0;
+        }
+
+        set_color_controls(device->device, absoluteExposureValue, gain);
+
+        device->filename = device_recording_filename(recording_filename, serial_number);
+        scheduler.devices.push_back(std::move(device));
     }
-    k4a_device_stop_cameras(device);
 
-    std::cout << "Saving recording..." << std::endl;
-    CHECK(k4a_record_flush(recording), device);
-    k4a_record_close(recording);
+    if (result == 0 && master_count > 1)
+    {
+        std::cerr << "More than one device has only its sync out jack connected, expected a single master."
+                  << std::endl;
+        result = 1;
+    }
 
-    std::cout << "Done" << std::endl;
+    // Subordinates must be running before the master sends its first sync pulse, so start them first
+    std::vector<device_recording_t *> start_order;
+    for (auto &device : scheduler.devices)
+    {
+        if (device->config.wired_sync_mode != K4A_WIRED_SYNC_MODE_MASTER)
+        {
+            start_order.push_back(device.get());
+        }
+    }
+    for (auto &device : scheduler.devices)
+    {
+        if (device->config.wired_sync_mode == K4A_WIRED_SYNC_MODE_MASTER)
+        {
+            start_order.push_back(device.get());
+        }
+    }
 
-    k4a_device_close(device);
+    std::vector<device_recording_t *> started;
+    for (size_t i = 0; i < start_order.size() && result == 0; i++)
+    {
+        device_recording_t *device = start_order[i];
+        if (K4A_FAILED(create_recording(device->filename.c_str(),
+                                        device->device,
+                                        &device->config,
+                                        record_imu,
+                                        depth_codec,
+                                        color_codec,
+                                        &device->recording)))
+        {
+            result = 1;
+            break;
+        }
+        if (K4A_FAILED(k4a_device_start_cameras(device->device, &device->config)))
+        {
+            std::cerr << "Runtime error: k4a_device_start_cameras() failed for device " << (int)device->device_index
+                      << std::endl;
+            result = 1;
+            break;
+        }
+        started.push_back(device);
+        if (record_imu && K4A_FAILED(k4a_device_start_imu(device->device)))
+        {
+            std::cerr << "Runtime error: k4a_device_start_imu() failed for device " << (int)device->device_index
+                      << std::endl;
+            result = 1;
+            break;
+        }
 
-    return 0;
+        const char *role = device->config.wired_sync_mode == K4A_WIRED_SYNC_MODE_MASTER ?
+                               "master" :
+                               (device->config.wired_sync_mode == K4A_WIRED_SYNC_MODE_SUBORDINATE ? "subordinate" :
+                                                                                                    "standalone");
+        std::cout << "Device " << (int)device->device_index << " started as " << role << ", recording to "
+                  << device->filename << std::endl;
+    }
+
+    if (result == 0)
+    {
+        std::cout << "Started recording" << std::endl;
+        if (recording_length <= 0)
+        {
+            std::cout << "Press Ctrl-C to stop recording." << std::endl;
+        }
+
+        for (auto &device : scheduler.devices)
+        {
+            device->capture_thread = std::thread(capture_thread,
+                                                 &scheduler,
+                                                 device.get(),
+                                                 record_imu,
+                                                 recording_length);
+        }
+
+        write_pending(&scheduler);
+
+        for (auto &device : scheduler.devices)
+        {
+            device->capture_thread.join();
+            if (device->failed)
+            {
+                result = 1;
+            }
+        }
+
+        if (!exiting)
+        {
+            exiting = true;
+            std::cout << "Stopping recording..." << std::endl;
+        }
+    }
+
+    // Stop the master first so the subordinates don't lose the sync signal while still recording
+    for (auto it = started.rbegin(); it != started.rend(); ++it)
+    {
+        if (record_imu)
+        {
+            k4a_device_stop_imu((*it)->device);
+        }
+        k4a_device_stop_cameras((*it)->device);
+    }
+
+    for (auto &device : scheduler.devices)
+    {
+        if (device->recording != NULL)
+        {
+            std::cout << "Saving recording " << device->filename << "..." << std::endl;
+            if (K4A_FAILED(k4a_record_flush(device->recording)))
+            {
+                std::cerr << "Runtime error: k4a_record_flush() failed for " << device->filename << std::endl;
+                result = 1;
+            }
+            k4a_record_close(device->recording);
+
+            if (device->dropped_captures > 0)
+            {
+                std::cerr << "Device " << (int)device->device_index << ": dropped " << device->dropped_captures
+                          << " captures because the disk did not keep up." << std::endl;
+            }
+
+            if (write_index)
+            {
+                std::cout << "Writing recording index..." << std::endl;
+                write_recording_index(device->filename.c_str());
+            }
+        }
+        k4a_device_close(device->device);
+    }
+
+    std::cout << "Done" << std::endl;
+
+    return result;
 }
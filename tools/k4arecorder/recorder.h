@@ -5,7 +5,9 @@
 #define RECORDER_H
 
 #include <atomic>
+#include <vector>
 #include <k4a/k4a.h>
+#include <k4arecord/types.h>
 
 extern std::atomic_bool exiting;
 
@@ -17,7 +19,23 @@ int do_recording(uint8_t device_index,
                  int recording_length,
                  k4a_device_configuration_t *device_config,
                  bool record_imu,
+                 bool write_index,
+                 k4a_record_depth_codec_t depth_codec,
+                 k4a_record_color_codec_t color_codec,
                  int32_t absoluteExposureValue,
                  int32_t gain);
 
+// Records from several devices at once, each to its own file named after the device serial number. Sync roles are
+// taken from the sync jacks of each device.
+int do_multi_recording(const std::vector<uint8_t> &device_indices,
+                       char *recording_filename,
+                       int recording_length,
+                       k4a_device_configuration_t *device_config,
+                       bool record_imu,
+                       bool write_index,
+                       k4a_record_depth_codec_t depth_codec,
+                       k4a_record_color_codec_t color_codec,
+                       int32_t absoluteExposureValue,
+                       int32_t gain);
+
 #endif /* RECORDER_H */
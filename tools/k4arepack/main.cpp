@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4arecord/playback.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static void print_usage()
+{
+    std::cout << "k4arepack [options] input.mkv output.mkv" << std::endl;
+    std::cout << std::endl;
+    std::cout << " Options:" << std::endl;
+    std::cout << "  -h, --help   Prints this help" << std::endl;
+    std::cout << "  -s, --start  Start of the range to copy in seconds (default: 0)" << std::endl;
+    std::cout << "  -e, --end    End of the range to copy in seconds (default: end of the recording)" << std::endl;
+}
+
+// Parses a number of seconds into microseconds, returns false if the value is not a positive number.
+static bool parse_seconds(const char *value, uint64_t *timestamp_usec)
+{
+    char *end = NULL;
+    double seconds = strtod(value, &end);
+    if (end == value || *end != '\0' || !(seconds >= 0) || seconds > 1e12)
+    {
+        return false;
+    }
+    *timestamp_usec = (uint64_t)(seconds * 1000000);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t start_usec = 0;
+    uint64_t end_usec = UINT64_MAX;
+    const char *paths[2] = { NULL, NULL };
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            print_usage();
+            return 0;
+        }
+        else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--start") == 0 || strcmp(argv[i], "-e") == 0 ||
+                 strcmp(argv[i], "--end") == 0)
+        {
+            bool start = strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--start") == 0;
+            if (i + 1 >= argc || !parse_seconds(argv[i + 1], start ? &start_usec : &end_usec))
+            {
+                std::cerr << argv[i] << " requires a number of seconds." << std::endl;
+                return 1;
+            }
+            i++;
+        }
+        else if (path_count < 2)
+        {
+            paths[path_count++] = argv[i];
+        }
+        else
+        {
+            std::cerr << "Unexpected argument: " << argv[i] << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (path_count != 2)
+    {
+        print_usage();
+        return 1;
+    }
+    if (start_usec > end_usec)
+    {
+        std::cerr << "The start of the range is after its end." << std::endl;
+        return 1;
+    }
+
+    k4a_playback_t playback = NULL;
+    if (K4A_FAILED(k4a_playback_open(paths[0], &playback)))
+    {
+        std::cerr << "Failed to open recording: " << paths[0] << std::endl;
+        return 1;
+    }
+
+    uint64_t recording_length = k4a_playback_get_recording_length_usec(playback);
+    if (end_usec > recording_length)
+    {
+        end_usec = recording_length;
+    }
+
+    k4a_result_t result = k4a_playback_write_range(playback, paths[1], start_usec, end_usec);
+    k4a_playback_close(playback);
+    if (K4A_FAILED(result))
+    {
+        std::cerr << "Failed to write recording: " << paths[1] << std::endl;
+        return 1;
+    }
+
+    // The copy starts and ends at cluster boundaries, the new recording shows the range that was actually copied.
+    if (K4A_SUCCEEDED(k4a_playback_open(paths[1], &playback)))
+    {
+        k4a_record_configuration_t config;
+        if (K4A_SUCCEEDED(k4a_playback_get_record_configuration(playback, &config)))
+        {
+            std::cout << "Wrote " << k4a_playback_get_recording_length_usec(playback) / 1000000.0 << " seconds to "
+                      << paths[1] << ", starting at device time " << config.start_timestamp_offset_usec / 1000000.0
+                      << " seconds." << std::endl;
+        }
+        k4a_playback_close(playback);
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Associated header
+//
+#include "gpudepthimagecolorizer.h"
+
+// System headers
+//
+#include <algorithm>
+
+// Library headers
+//
+
+// Project headers
+//
+
+using namespace k4aviewer;
+
+namespace
+{
+
+constexpr char const ComputeShader[] =
+    R"(
+#version 430
+
+layout(location=0, rgba8) writeonly uniform image2D destTex;
+
+layout(location=1, r16ui) readonly uniform uimage2D depthImage;
+
+layout(location=2) uniform uvec2 valueRange;
+layout(location=3) uniform int colorization;
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Same as ImGui::ColorConvertHSVtoRGB with saturation and value set to 1
+//
+vec3 HueToRgb(float hue)
+{
+    float h = mod(hue, 1.0f) * 6.0f;
+    int i = int(h);
+    float f = h - float(i);
+
+    switch (i)
+    {
+    case 0:
+        return vec3(1.0f, f, 0.0f);
+    case 1:
+        return vec3(1.0f - f, 1.0f, 0.0f);
+    case 2:
+        return vec3(0.0f, 1.0f, f);
+    case 3:
+        return vec3(0.0f, 1.0f - f, 1.0f);
+    case 4:
+        return vec3(f, 0.0f, 1.0f);
+    default:
+        return vec3(1.0f, 0.0f, 1.0f - f);
+    }
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(destTex))))
+    {
+        return;
+    }
+
+    uint value = imageLoad(depthImage, pixel).r;
+    float minValue = float(valueRange.x);
+    float maxValue = float(valueRange.y);
+
+    vec3 color = vec3(0.0f, 0.0f, 0.0f);
+    if (colorization == 0)
+    {
+        // Blue to red.  Zero means the pixel is invalid rather than close, so it stays black.
+        //
+        if (value != 0u)
+        {
+            float hue = (clamp(float(value), minValue, maxValue) - minValue) / (maxValue - minValue);
+
+            // Stop at blue before the hue wraps around through purple, and put blue at the near end.
+            //
+            const float range = 2.0f / 3.0f;
+            color = HueToRgb(range - hue * range);
+        }
+    }
+    else
+    {
+        // Greyscale
+        //
+        float level = (clamp(float(value), minValue, maxValue) - minValue) / (maxValue - minValue);
+        color = vec3(level, level, level);
+    }
+
+    imageStore(destTex, pixel, vec4(color, 1.0f));
+}
+)";
+
+constexpr GLuint WorkGroupSize = 8;
+
+// Texture formats
+//
+constexpr GLenum destTexInternalFormat = GL_RGBA8;
+
+constexpr GLenum depthImageInternalFormat = GL_R16UI;
+constexpr GLenum depthImageDataFormat = GL_RED_INTEGER;
+constexpr GLenum depthImageDataType = GL_UNSIGNED_SHORT;
+
+} // namespace
+
+GpuDepthImageColorizer::GpuDepthImageColorizer()
+{
+    OpenGL::Shader shader(GL_COMPUTE_SHADER, ComputeShader);
+
+    m_shaderProgram.AttachShader(std::move(shader));
+    m_shaderProgram.Link();
+
+    m_destTexId = glGetUniformLocation(m_shaderProgram.Id(), "destTex");
+    m_depthImageId = glGetUniformLocation(m_shaderProgram.Id(), "depthImage");
+    m_valueRangeId = glGetUniformLocation(m_shaderProgram.Id(), "valueRange");
+    m_colorizationId = glGetUniformLocation(m_shaderProgram.Id(), "colorization");
+}
+
+void GpuDepthImageColorizer::InitializeDepthImageTexture(const int width, const int height)
+{
+    // Pre-allocate a texture for the depth images so we don't have to
+    // reallocate on every frame
+    //
+    m_depthImageTexture.Init();
+
+    const GLsizeiptr depthImageSizeBytes = static_cast<GLsizeiptr>(width * height) * sizeof(DepthPixel);
+    m_depthImagePixelBuffer.Initialize(GL_PIXEL_UNPACK_BUFFER, depthImageSizeBytes);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
+
+    glTexStorage2D(GL_TEXTURE_2D, 1, depthImageInternalFormat, width, height);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    m_depthImageDimensions = ImageDimensions(width, height);
+}
+
+GLenum GpuDepthImageColorizer::Colorize(const k4a::image &image,
+                                        const std::pair<DepthPixel, DepthPixel> valueRange,
+                                        const DepthColorization colorization,
+                                        K4AViewerImage *texture)
+{
+    const int width = image.get_width_pixels();
+    const int height = image.get_height_pixels();
+    if (!m_depthImageTexture || m_depthImageDimensions.Width != width || m_depthImageDimensions.Height != height)
+    {
+        InitializeDepthImageTexture(width, height);
+    }
+
+    // Upload data to our uniform texture
+    //
+    const GLuint numBytes = static_cast<GLuint>(width * height) * sizeof(DepthPixel);
+
+    GLubyte *textureMappedBuffer = m_depthImagePixelBuffer.BeginWrite();
+    glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
+
+    if (!textureMappedBuffer)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return glGetError();
+    }
+
+    const GLubyte *depthSrc = reinterpret_cast<const GLubyte *>(image.get_buffer());
+    std::copy(depthSrc, depthSrc + numBytes, textureMappedBuffer);
+    const GLenum writeStatus = m_depthImagePixelBuffer.EndWrite();
+    if (writeStatus != GL_NO_ERROR)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return writeStatus;
+    }
+
+    glTexSubImage2D(GL_TEXTURE_2D,                                                                // target
+                    0,                                                                            // level
+                    0,                                                                            // xoffset
+                    0,                                                                            // yoffset
+                    width,                                                                        // width
+                    height,                                                                       // height
+                    depthImageDataFormat,                                                         // format
+                    depthImageDataType,                                                           // type
+                    reinterpret_cast<const GLvoid *>(m_depthImagePixelBuffer.GetWriteOffset())); // data
+    m_depthImagePixelBuffer.Fence();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glUseProgram(m_shaderProgram.Id());
+
+    // Bind textures that we're going to pass to the shader
+    //
+    const GLuint destTexture = static_cast<GLuint>(*texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, destTexture);
+    glBindImageTexture(0, destTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, destTexInternalFormat);
+    glUniform1i(m_destTexId, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
+    glBindImageTexture(1, m_depthImageTexture.Id(), 0, GL_FALSE, 0, GL_READ_ONLY, depthImageInternalFormat);
+    glUniform1i(m_depthImageId, 1);
+
+    glUniform2ui(m_valueRangeId, valueRange.first, valueRange.second);
+    glUniform1i(m_colorizationId, colorization == DepthColorization::BlueToRed ? 0 : 1);
+
+    // Colorize the image
+    //
+    glDispatchCompute((static_cast<GLuint>(width) + WorkGroupSize - 1) / WorkGroupSize,
+                      (static_cast<GLuint>(height) + WorkGroupSize - 1) / WorkGroupSize,
+                      1);
+
+    // Wait for the colorization to finish before the UI samples the texture we just wrote
+    //
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    GLenum status = glGetError();
+    return status;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef GPUDEPTHIMAGECOLORIZER_H
+#define GPUDEPTHIMAGECOLORIZER_H
+
+// System headers
+//
+#include <utility>
+
+// Library headers
+//
+#include <k4a/k4a.hpp>
+#include "k4aimgui_all.h"
+
+// Project headers
+//
+#include "k4apixel.h"
+#include "k4astreamingbuffer.h"
+#include "k4aviewerimage.h"
+#include "openglhelpers.h"
+
+namespace k4aviewer
+{
+
+// Ways to turn depth pixels into colors.  These match the functions in K4ADepthPixelColorizer.
+//
+enum class DepthColorization
+{
+    // Blue for the near end of the value range, red for the far end, black for invalid pixels
+    //
+    BlueToRed,
+
+    // Black for the low end of the value range, white for the high end
+    //
+    Greyscale
+};
+
+class GpuDepthImageColorizer
+{
+public:
+    GpuDepthImageColorizer();
+    ~GpuDepthImageColorizer() = default;
+
+    // Uploads a DEPTH16 or IR16 image as-is and colorizes it into texture with a compute shader, so
+    // the CPU only has to copy the 16-bit pixels.  Values are clamped to valueRange before being mapped
+    // to colors.
+    //
+    // texture must have an internal format of GL_RGBA8 and the same dimensions as image.  Must be
+    // called on the thread that owns the OpenGL context.
+    //
+    GLenum Colorize(const k4a::image &image,
+                    std::pair<DepthPixel, DepthPixel> valueRange,
+                    DepthColorization colorization,
+                    K4AViewerImage *texture);
+
+    GpuDepthImageColorizer(GpuDepthImageColorizer &) = delete;
+    GpuDepthImageColorizer(GpuDepthImageColorizer &&) = delete;
+    GpuDepthImageColorizer &operator=(GpuDepthImageColorizer &) = delete;
+    GpuDepthImageColorizer &operator=(GpuDepthImageColorizer &&) = delete;
+
+private:
+    void InitializeDepthImageTexture(int width, int height);
+
+    OpenGL::Program m_shaderProgram;
+    GLint m_destTexId;
+    GLint m_depthImageId;
+    GLint m_valueRangeId;
+    GLint m_colorizationId;
+
+    OpenGL::Texture m_depthImageTexture;
+    K4AStreamingBuffer m_depthImagePixelBuffer;
+    ImageDimensions m_depthImageDimensions = { 0, 0 };
+};
+} // namespace k4aviewer
+#endif
@@ -42,13 +42,13 @@ void main()
     float alpha = 1.0f;
     vec3 vertexPosition = vec3(vertexValue * xyValue.x, vertexValue * xyValue.y, vertexValue);
 
-    // Invalid pixels have their XY table values set to 0.
-    // Set the rest of their values to 0 so clients can pick them out.
+    // Invalid pixels have their XY table values set to NaN.
+    // Set their values to 0 so clients can pick them out.
     //
-    if (xyValue.x == 0.0f && xyValue.y == 0.0f)
+    if (isnan(xyValue.x) || isnan(xyValue.y))
     {
         alpha = 0.0f;
-        vertexValue = 0.0f;
+        vertexPosition = vec3(0.0f, 0.0f, 0.0f);
     }
 
     // Vertex positions are in millimeters, but everything else is in meters, so we need to convert
@@ -118,13 +118,10 @@ GLenum GpuDepthToPointCloudConverter::Convert(const k4a::image &depth, OpenGL::T
 
     // Upload data to our uniform texture
     //
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_depthImagePixelBuffer.Id());
-    glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
-
     const GLuint numBytes = static_cast<GLuint>(width * height) * sizeof(uint16_t);
 
-    GLubyte *textureMappedBuffer = reinterpret_cast<GLubyte *>(
-        glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    GLubyte *textureMappedBuffer = m_depthImagePixelBuffer.BeginWrite();
+    glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
 
     if (!textureMappedBuffer)
     {
@@ -133,20 +130,22 @@ GLenum GpuDepthToPointCloudConverter::Convert(const k4a::image &depth, OpenGL::T
 
     const GLubyte *depthSrc = reinterpret_cast<const GLubyte *>(depth.get_buffer());
     std::copy(depthSrc, depthSrc + numBytes, textureMappedBuffer);
-    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+    const GLenum writeStatus = m_depthImagePixelBuffer.EndWrite();
+    if (writeStatus != GL_NO_ERROR)
     {
-        return glGetError();
+        return writeStatus;
     }
 
-    glTexSubImage2D(GL_TEXTURE_2D,        // target
-                    0,                    // level
-                    0,                    // xoffset
-                    0,                    // yoffset
-                    width,                // width
-                    height,               // height
-                    depthImageDataFormat, // format
-                    depthImageDataType,   // type
-                    nullptr);             // data
+    glTexSubImage2D(GL_TEXTURE_2D,                                                                // target
+                    0,                                                                            // level
+                    0,                                                                            // xoffset
+                    0,                                                                            // yoffset
+                    width,                                                                        // width
+                    height,                                                                       // height
+                    depthImageDataFormat,                                                         // format
+                    depthImageDataType,                                                           // type
+                    reinterpret_cast<const GLvoid *>(m_depthImagePixelBuffer.GetWriteOffset())); // data
+    m_depthImagePixelBuffer.Fence();
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     glUseProgram(m_shaderProgram.Id());
@@ -207,11 +206,9 @@ GLenum GpuDepthToPointCloudConverter::SetActiveXyTable(const k4a::image &xyTable
     // reallocate on every frame
     //
     m_depthImageTexture.Init();
-    m_depthImagePixelBuffer.Init();
 
-    const GLuint depthImageSizeBytes = static_cast<GLuint>(width * height) * sizeof(uint16_t);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_depthImagePixelBuffer.Id());
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, depthImageSizeBytes, nullptr, GL_STREAM_DRAW);
+    const GLsizeiptr depthImageSizeBytes = static_cast<GLsizeiptr>(width * height) * sizeof(uint16_t);
+    m_depthImagePixelBuffer.Initialize(GL_PIXEL_UNPACK_BUFFER, depthImageSizeBytes);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     glBindTexture(GL_TEXTURE_2D, m_depthImageTexture.Id());
@@ -224,49 +221,3 @@ GLenum GpuDepthToPointCloudConverter::SetActiveXyTable(const k4a::image &xyTable
     GLenum status = glGetError();
     return status;
 }
-
-k4a::image GpuDepthToPointCloudConverter::GenerateXyTable(const k4a::calibration &calibration,
-                                                          k4a_calibration_type_t calibrationType)
-{
-    const k4a_calibration_camera_t &cameraCalibration = calibrationType == K4A_CALIBRATION_TYPE_COLOR ?
-                                                            calibration.color_camera_calibration :
-                                                            calibration.depth_camera_calibration;
-
-    k4a::image xyTable = k4a::image::create(K4A_IMAGE_FORMAT_CUSTOM,
-                                            cameraCalibration.resolution_width,
-                                            cameraCalibration.resolution_height,
-                                            cameraCalibration.resolution_width *
-                                                static_cast<int>(sizeof(k4a_float2_t)));
-
-    k4a_float2_t *tableData = reinterpret_cast<k4a_float2_t *>(xyTable.get_buffer());
-
-    int width = cameraCalibration.resolution_width;
-    int height = cameraCalibration.resolution_height;
-
-    k4a_float2_t p;
-    k4a_float3_t ray;
-
-    for (int y = 0, idx = 0; y < height; y++)
-    {
-        p.xy.y = static_cast<float>(y);
-        for (int x = 0; x < width; x++, idx++)
-        {
-            p.xy.x = static_cast<float>(x);
-
-            if (calibration.convert_2d_to_3d(p, 1.f, calibrationType, calibrationType, &ray))
-            {
-                tableData[idx].xy.x = ray.xyz.x;
-                tableData[idx].xy.y = ray.xyz.y;
-            }
-            else
-            {
-                // The pixel is invalid.
-                //
-                tableData[idx].xy.x = 0.0f;
-                tableData[idx].xy.y = 0.0f;
-            }
-        }
-    }
-
-    return xyTable;
-}
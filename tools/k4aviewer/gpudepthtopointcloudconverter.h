@@ -14,6 +14,7 @@
 
 // Project headers
 //
+#include "k4astreamingbuffer.h"
 #include "openglhelpers.h"
 
 namespace k4aviewer
@@ -25,20 +26,14 @@ public:
     GpuDepthToPointCloudConverter();
     ~GpuDepthToPointCloudConverter() = default;
 
-    // Creates a k4a::image containing the XY tables from calibration based on calibrationType.
-    // The table is a 2D array of k4a_float2_t's with the same resolution as the camera of calibrationType
-    // specified in calibration.
+    // Set the XY table that will be used by future calls to Convert().  Get an XY table by calling
+    // k4a::transformation::get_xy_table(), which returns the tables the SDK already computed for the
+    // transformation functions instead of unprojecting every pixel again.
     //
-    // You can use this table to convert a depth image into a point cloud, e.g. by using the Convert method.
     // Conversion is done by multiplying the depth pixel value by the XY table values - i.e. the result
     // pixel will be (xyTable[p].x * depthImage[p], xyTable[p].y * depthImage[p], depthImage[p]), where
     // p is the index of a given pixel.
     //
-    static k4a::image GenerateXyTable(const k4a::calibration &calibration, k4a_calibration_type_t calibrationType);
-
-    // Set the XY table that will be used by future calls to Convert().  Get an XY table by calling
-    // GenerateXyTable().
-    //
     GLenum SetActiveXyTable(const k4a::image &xyTable);
 
     // Takes depth data and turns it into a texture containing the XYZ coordinates of the depth map
@@ -79,7 +74,7 @@ private:
     OpenGL::Texture m_depthImageTexture;
     OpenGL::Texture m_xyTableTexture;
 
-    OpenGL::Buffer m_depthImagePixelBuffer;
+    K4AStreamingBuffer m_depthImagePixelBuffer;
 };
 } // namespace k4aviewer
 #endif
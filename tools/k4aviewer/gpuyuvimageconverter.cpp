@@ -0,0 +1,294 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Associated header
+//
+#include "gpuyuvimageconverter.h"
+
+// System headers
+//
+#include <algorithm>
+
+// Library headers
+//
+
+// Project headers
+//
+#include "k4aviewerutil.h"
+
+using namespace k4aviewer;
+
+namespace
+{
+
+constexpr char const ComputeShader[] =
+    R"(
+#version 430
+
+layout(location=0, rgba8) writeonly uniform image2D destTex;
+
+layout(location=1, r8) readonly uniform image2D yPlane;
+layout(location=2, rg8) readonly uniform image2D uvPlane;
+layout(location=3, r8) readonly uniform image2D uPlane;
+layout(location=4, r8) readonly uniform image2D vPlane;
+layout(location=5, rgba8) readonly uniform image2D packedImage;
+
+layout(location=6) uniform int yuvFormat;
+layout(location=7) uniform int fullRange;
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, imageSize(destTex))))
+    {
+        return;
+    }
+
+    float y;
+    float u;
+    float v;
+    if (yuvFormat == 0)
+    {
+        // NV12: full resolution Y plane, interleaved UV plane at half resolution in both directions
+        //
+        y = imageLoad(yPlane, pixel).r;
+        vec2 uv = imageLoad(uvPlane, pixel / 2).rg;
+        u = uv.r;
+        v = uv.g;
+    }
+    else if (yuvFormat == 1)
+    {
+        // YUY2: each RGBA texel holds Y0 U Y1 V for two horizontally adjacent pixels
+        //
+        vec4 yuyv = imageLoad(packedImage, ivec2(pixel.x / 2, pixel.y));
+        y = (pixel.x % 2 == 0) ? yuyv.r : yuyv.b;
+        u = yuyv.g;
+        v = yuyv.a;
+    }
+    else
+    {
+        // Planar: the chroma planes may be subsampled in either direction
+        //
+        y = imageLoad(yPlane, pixel).r;
+        ivec2 chromaPixel = pixel * imageSize(uPlane) / imageSize(yPlane);
+        u = imageLoad(uPlane, chromaPixel).r;
+        v = imageLoad(vPlane, chromaPixel).r;
+    }
+
+    u -= 0.5f;
+    v -= 0.5f;
+
+    vec3 rgb;
+    if (fullRange != 0)
+    {
+        rgb = vec3(y + 1.402f * v, y - 0.344136f * u - 0.714136f * v, y + 1.772f * u);
+    }
+    else
+    {
+        y = 1.164f * (y - 16.0f / 255.0f);
+        rgb = vec3(y + 1.596f * v, y - 0.392f * u - 0.813f * v, y + 2.017f * u);
+    }
+
+    imageStore(destTex, pixel, vec4(clamp(rgb, 0.0f, 1.0f), 1.0f));
+}
+)";
+
+constexpr GLuint WorkGroupSize = 8;
+
+// Image units used by the shader
+//
+constexpr GLuint YPlaneUnit = 1;
+constexpr GLuint UVPlaneUnit = 2;
+constexpr GLuint UPlaneUnit = 3;
+constexpr GLuint VPlaneUnit = 4;
+constexpr GLuint PackedImageUnit = 5;
+
+// Texture formats
+//
+constexpr GLenum destTexInternalFormat = GL_RGBA8;
+
+} // namespace
+
+GpuYuvImageConverter::GpuYuvImageConverter()
+{
+    OpenGL::Shader shader(GL_COMPUTE_SHADER, ComputeShader);
+
+    m_shaderProgram.AttachShader(std::move(shader));
+    m_shaderProgram.Link();
+
+    m_destTexId = glGetUniformLocation(m_shaderProgram.Id(), "destTex");
+    m_yuvFormatId = glGetUniformLocation(m_shaderProgram.Id(), "yuvFormat");
+    m_fullRangeId = glGetUniformLocation(m_shaderProgram.Id(), "fullRange");
+
+    glUseProgram(m_shaderProgram.Id());
+    glUniform1i(glGetUniformLocation(m_shaderProgram.Id(), "yPlane"), static_cast<GLint>(YPlaneUnit));
+    glUniform1i(glGetUniformLocation(m_shaderProgram.Id(), "uvPlane"), static_cast<GLint>(UVPlaneUnit));
+    glUniform1i(glGetUniformLocation(m_shaderProgram.Id(), "uPlane"), static_cast<GLint>(UPlaneUnit));
+    glUniform1i(glGetUniformLocation(m_shaderProgram.Id(), "vPlane"), static_cast<GLint>(VPlaneUnit));
+    glUniform1i(glGetUniformLocation(m_shaderProgram.Id(), "packedImage"), static_cast<GLint>(PackedImageUnit));
+    glUseProgram(0);
+}
+
+GLenum GpuYuvImageConverter::ConvertNV12(const k4a::image &image, K4AViewerImage *texture)
+{
+    const int width = image.get_width_pixels();
+    const int height = image.get_height_pixels();
+
+    const PlaneLayout planes[] = {
+        { YPlaneUnit, ImageDimensions(width, height), GL_R8, GL_RED, 1 },
+        { UVPlaneUnit, ImageDimensions(width / 2, height / 2), GL_RG8, GL_RG, 2 },
+    };
+
+    return Convert(YuvFormat::NV12, image.get_buffer(), planes, 2, false, texture);
+}
+
+GLenum GpuYuvImageConverter::ConvertYUY2(const k4a::image &image, K4AViewerImage *texture)
+{
+    const int width = image.get_width_pixels();
+    const int height = image.get_height_pixels();
+
+    const PlaneLayout planes[] = {
+        { PackedImageUnit, ImageDimensions(width / 2, height), GL_RGBA8, GL_RGBA, 4 },
+    };
+
+    return Convert(YuvFormat::YUY2, image.get_buffer(), planes, 1, false, texture);
+}
+
+GLenum GpuYuvImageConverter::ConvertPlanar(const uint8_t *data,
+                                           const ImageDimensions lumaDimensions,
+                                           const ImageDimensions chromaDimensions,
+                                           K4AViewerImage *texture)
+{
+    const PlaneLayout planes[] = {
+        { YPlaneUnit, lumaDimensions, GL_R8, GL_RED, 1 },
+        { UPlaneUnit, chromaDimensions, GL_R8, GL_RED, 1 },
+        { VPlaneUnit, chromaDimensions, GL_R8, GL_RED, 1 },
+    };
+
+    return Convert(YuvFormat::Planar, data, planes, 3, true, texture);
+}
+
+GLenum GpuYuvImageConverter::Convert(const YuvFormat format,
+                                     const uint8_t *data,
+                                     const PlaneLayout *planes,
+                                     const size_t planeCount,
+                                     const bool fullRange,
+                                     K4AViewerImage *texture)
+{
+    GLuint totalBytes = 0;
+    for (size_t i = 0; i < planeCount; i++)
+    {
+        const PlaneLayout &plane = planes[i];
+        totalBytes += static_cast<GLuint>(plane.Dimensions.Width * plane.Dimensions.Height) * plane.BytesPerTexel;
+
+        // (Re)create the plane textures if the image layout changed so we don't have to reallocate on every frame
+        //
+        PlaneTexture &planeTexture = m_planeTextures[i];
+        if (!planeTexture.Texture || planeTexture.Dimensions.Width != plane.Dimensions.Width ||
+            planeTexture.Dimensions.Height != plane.Dimensions.Height ||
+            planeTexture.InternalFormat != plane.InternalFormat)
+        {
+            planeTexture.Texture.Init();
+            glBindTexture(GL_TEXTURE_2D, planeTexture.Texture.Id());
+            glTexStorage2D(GL_TEXTURE_2D, 1, plane.InternalFormat, plane.Dimensions.Width, plane.Dimensions.Height);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            planeTexture.Dimensions = plane.Dimensions;
+            planeTexture.InternalFormat = plane.InternalFormat;
+        }
+    }
+
+    CleanupGuard bufferCleanupGuard([]() { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); });
+
+    if (!m_pixelBuffer.IsInitialized() || m_pixelBuffer.GetSectionSize() < static_cast<GLsizeiptr>(totalBytes))
+    {
+        const GLenum initStatus = m_pixelBuffer.Initialize(GL_PIXEL_UNPACK_BUFFER, totalBytes);
+        if (initStatus != GL_NO_ERROR)
+        {
+            return initStatus;
+        }
+    }
+
+    // Upload all the planes with a single copy, then split them into their textures on the GPU
+    //
+    GLubyte *mappedBuffer = m_pixelBuffer.BeginWrite();
+    if (!mappedBuffer)
+    {
+        return glGetError();
+    }
+
+    std::copy(data, data + totalBytes, mappedBuffer);
+    const GLenum writeStatus = m_pixelBuffer.EndWrite();
+    if (writeStatus != GL_NO_ERROR)
+    {
+        return writeStatus;
+    }
+
+    // Chroma planes of odd widths aren't 4-byte aligned
+    //
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    size_t offset = static_cast<size_t>(m_pixelBuffer.GetWriteOffset());
+    for (size_t i = 0; i < planeCount; i++)
+    {
+        const PlaneLayout &plane = planes[i];
+
+        glBindTexture(GL_TEXTURE_2D, m_planeTextures[i].Texture.Id());
+        glTexSubImage2D(GL_TEXTURE_2D,                             // target
+                        0,                                         // level
+                        0,                                         // xoffset
+                        0,                                         // yoffset
+                        plane.Dimensions.Width,                    // width
+                        plane.Dimensions.Height,                   // height
+                        plane.DataFormat,                          // format
+                        GL_UNSIGNED_BYTE,                          // type
+                        reinterpret_cast<const GLvoid *>(offset)); // data
+
+        offset += static_cast<size_t>(plane.Dimensions.Width * plane.Dimensions.Height) * plane.BytesPerTexel;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Don't reuse this section of the buffer until the uploads are done
+    //
+    m_pixelBuffer.Fence();
+
+    glUseProgram(m_shaderProgram.Id());
+
+    // Bind textures that we're going to pass to the shader
+    //
+    const GLuint destTexture = static_cast<GLuint>(*texture);
+    glBindImageTexture(0, destTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, destTexInternalFormat);
+    glUniform1i(m_destTexId, 0);
+
+    for (size_t i = 0; i < planeCount; i++)
+    {
+        glBindImageTexture(planes[i].ImageUnit,
+                           m_planeTextures[i].Texture.Id(),
+                           0,
+                           GL_FALSE,
+                           0,
+                           GL_READ_ONLY,
+                           planes[i].InternalFormat);
+    }
+
+    glUniform1i(m_yuvFormatId, static_cast<GLint>(format));
+    glUniform1i(m_fullRangeId, fullRange ? 1 : 0);
+
+    // Convert the image
+    //
+    const ImageDimensions dimensions = texture->GetDimensions();
+    glDispatchCompute((static_cast<GLuint>(dimensions.Width) + WorkGroupSize - 1) / WorkGroupSize,
+                      (static_cast<GLuint>(dimensions.Height) + WorkGroupSize - 1) / WorkGroupSize,
+                      1);
+
+    // Wait for the conversion to finish before the UI samples the texture we just wrote
+    //
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    GLenum status = glGetError();
+    return status;
+}
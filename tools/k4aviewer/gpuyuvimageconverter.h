@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef GPUYUVIMAGECONVERTER_H
+#define GPUYUVIMAGECONVERTER_H
+
+// System headers
+//
+#include <array>
+
+// Library headers
+//
+#include <k4a/k4a.hpp>
+#include "k4aimgui_all.h"
+
+// Project headers
+//
+#include "k4astreamingbuffer.h"
+#include "k4aviewerimage.h"
+#include "openglhelpers.h"
+
+namespace k4aviewer
+{
+
+class GpuYuvImageConverter
+{
+public:
+    GpuYuvImageConverter();
+    ~GpuYuvImageConverter() = default;
+
+    // Uploads the planes of an NV12 image as-is and converts them to RGBA in texture with a compute shader.
+    // Uses the BT.601 limited range coefficients, same as libyuv::NV12ToARGB.
+    //
+    // texture must have an internal format of GL_RGBA8 and the same dimensions as image.  Must be
+    // called on the thread that owns the OpenGL context.
+    //
+    GLenum ConvertNV12(const k4a::image &image, K4AViewerImage *texture);
+
+    // Same as ConvertNV12, but for YUY2 images.
+    //
+    GLenum ConvertYUY2(const k4a::image &image, K4AViewerImage *texture);
+
+    // Converts separate, unpadded Y, U and V planes back to back in data, as written by tjDecompressToYUV2()
+    // with a pad of 1.  The chroma planes are chromaDimensions in size.  Uses the full range coefficients
+    // that JPEG images are encoded with.
+    //
+    GLenum ConvertPlanar(const uint8_t *data,
+                         ImageDimensions lumaDimensions,
+                         ImageDimensions chromaDimensions,
+                         K4AViewerImage *texture);
+
+    GpuYuvImageConverter(GpuYuvImageConverter &) = delete;
+    GpuYuvImageConverter(GpuYuvImageConverter &&) = delete;
+    GpuYuvImageConverter &operator=(GpuYuvImageConverter &) = delete;
+    GpuYuvImageConverter &operator=(GpuYuvImageConverter &&) = delete;
+
+private:
+    // How the pixels of the source image are laid out.  Must match the yuvFormat values in the shader.
+    //
+    enum class YuvFormat
+    {
+        NV12 = 0,
+        YUY2 = 1,
+        Planar = 2
+    };
+
+    // A plane of the source image and the shader image unit it is read from
+    //
+    struct PlaneLayout
+    {
+        GLuint ImageUnit;
+        ImageDimensions Dimensions;
+        GLenum InternalFormat;
+        GLenum DataFormat;
+        GLuint BytesPerTexel;
+    };
+
+    struct PlaneTexture
+    {
+        OpenGL::Texture Texture;
+        ImageDimensions Dimensions = { 0, 0 };
+        GLenum InternalFormat = GL_NONE;
+    };
+
+    static constexpr size_t MaxPlanes = 3;
+
+    GLenum Convert(YuvFormat format,
+                   const uint8_t *data,
+                   const PlaneLayout *planes,
+                   size_t planeCount,
+                   bool fullRange,
+                   K4AViewerImage *texture);
+
+    OpenGL::Program m_shaderProgram;
+    GLint m_destTexId;
+    GLint m_yuvFormatId;
+    GLint m_fullRangeId;
+
+    std::array<PlaneTexture, MaxPlanes> m_planeTextures;
+    K4AStreamingBuffer m_pixelBuffer;
+};
+} // namespace k4aviewer
+#endif
@@ -40,11 +40,38 @@ public:
     //
     virtual ImageDimensions GetImageDimensions() const = 0;
 
-    // Converts srcImage into a BGRA32-formatted image and stores the result in bgraImage.
-    // bgraImage must already be allocated and must be an image with the same dimensions that
-    // GetImageDimensions() returns.
+    // Converts srcImage and stores the result in convertedImage, which must already be allocated by
+    // CreateConversionImage().  Unless the converter overrides UpdateTexture(), the result is a
+    // BGRA32-formatted image.
     //
-    virtual ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) = 0;
+    // Converters that finish the conversion on the GPU in UpdateTexture() may only validate srcImage here.
+    // Called on a worker thread.
+    //
+    virtual ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *convertedImage) = 0;
+
+    // Creates an image for ConvertImage() to write to.  The default is a BGRA32 image with the
+    // dimensions that GetImageDimensions() returns.  Converters that do not write to it return an
+    // empty image.
+    //
+    virtual k4a::image CreateConversionImage() const
+    {
+        const ImageDimensions dimensions = GetImageDimensions();
+        return k4a::image::create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
+                                  dimensions.Width,
+                                  dimensions.Height,
+                                  dimensions.Width * static_cast<int>(sizeof(BgraPixel)));
+    }
+
+    // Updates texture from the result of a call to ConvertImage().  srcImage and convertedImage are the
+    // arguments that ConvertImage() was called with.  The default uploads convertedImage as BGRA32.
+    //
+    // Must be called on the thread that owns the OpenGL context.
+    //
+    virtual GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &convertedImage, K4AViewerImage *texture)
+    {
+        (void)srcImage;
+        return texture->UpdateTexture(convertedImage.get_buffer());
+    }
 
     virtual ~IK4AImageConverter() = default;
 
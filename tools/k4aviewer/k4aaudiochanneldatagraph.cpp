@@ -7,6 +7,7 @@
 
 // System headers
 //
+#include <algorithm>
 #include <cmath>
 
 // Library headers
@@ -33,42 +34,93 @@ ImVec2 operator-(const ImVec2 &lhs, const ImVec2 &rhs)
 
 K4AAudioChannelDataGraph::K4AAudioChannelDataGraph(const char *name) : m_name(name) {}
 
-void K4AAudioChannelDataGraph::AddSample(const float sample)
+void K4AAudioChannelDataGraph::AddSamples(const float *samples, size_t sampleCount)
 {
-    // We're computing the root-mean-square for visualization
-    //
-    if (sample > 0)
-    {
-        m_positiveDataAccumulator.AddSample(sample);
-    }
-    else if (sample < 0)
+    while (sampleCount > 0)
     {
-        m_negativeDataAccumulator.AddSample(sample);
-    }
-    else
-    {
-        m_positiveDataAccumulator.AddSample(sample);
-        m_negativeDataAccumulator.AddSample(sample);
-    }
-
-    const size_t totalSamples = m_positiveDataAccumulator.GetSampleCount() + m_negativeDataAccumulator.GetSampleCount();
-    if (totalSamples >= AudioSamplesPerGraphSample)
-    {
-        // Update graph data
+        // Each graph point covers AudioSamplesPerGraphSample samples, so only take the block up to the next point
         //
-        m_graphData[m_nextGraphPointIndex] = DataPoint(m_positiveDataAccumulator.GetAbsMax(),
-                                                       m_positiveDataAccumulator.GetRms(),
-                                                       -m_negativeDataAccumulator.GetRms(),
-                                                       -m_negativeDataAccumulator.GetAbsMax());
+        const size_t blockSize = std::min(sampleCount, AudioSamplesPerGraphSample - m_pendingSampleCount);
 
-        // Advance graph point
+        // We're computing the root-mean-square of the positive and negative halves for visualization.
+        // The block is split across independent lanes with no branches so the compiler can vectorize the loop;
+        // zero samples count towards both halves.
         //
-        m_nextGraphPointIndex = (m_nextGraphPointIndex + 1) % AudioChannelGraphSampleCount;
+        constexpr size_t LaneCount = 8;
+        std::array<float, LaneCount> positiveSumOfSquares = {};
+        std::array<float, LaneCount> negativeSumOfSquares = {};
+        std::array<float, LaneCount> positiveAbsMax = {};
+        std::array<float, LaneCount> negativeAbsMax = {};
+        std::array<uint32_t, LaneCount> positiveCount = {};
+        std::array<uint32_t, LaneCount> negativeCount = {};
+
+        size_t i = 0;
+        for (; i + LaneCount <= blockSize; i += LaneCount)
+        {
+            for (size_t lane = 0; lane < LaneCount; lane++)
+            {
+                const float sample = samples[i + lane];
+                const float positive = std::max(sample, 0.f);
+                const float negative = std::max(-sample, 0.f);
+                positiveSumOfSquares[lane] += positive * positive;
+                negativeSumOfSquares[lane] += negative * negative;
+                positiveAbsMax[lane] = std::max(positiveAbsMax[lane], positive);
+                negativeAbsMax[lane] = std::max(negativeAbsMax[lane], negative);
+                positiveCount[lane] += sample >= 0 ? 1u : 0u;
+                negativeCount[lane] += sample <= 0 ? 1u : 0u;
+            }
+        }
+        for (size_t lane = 0; i < blockSize; i++, lane++)
+        {
+            const float sample = samples[i];
+            const float positive = std::max(sample, 0.f);
+            const float negative = std::max(-sample, 0.f);
+            positiveSumOfSquares[lane] += positive * positive;
+            negativeSumOfSquares[lane] += negative * negative;
+            positiveAbsMax[lane] = std::max(positiveAbsMax[lane], positive);
+            negativeAbsMax[lane] = std::max(negativeAbsMax[lane], negative);
+            positiveCount[lane] += sample >= 0 ? 1u : 0u;
+            negativeCount[lane] += sample <= 0 ? 1u : 0u;
+        }
 
-        // Reset accumulators
-        //
-        m_positiveDataAccumulator.Reset();
-        m_negativeDataAccumulator.Reset();
+        float positiveSum = 0, negativeSum = 0, positiveMax = 0, negativeMax = 0;
+        size_t positiveTotal = 0, negativeTotal = 0;
+        for (size_t lane = 0; lane < LaneCount; lane++)
+        {
+            positiveSum += positiveSumOfSquares[lane];
+            negativeSum += negativeSumOfSquares[lane];
+            positiveMax = std::max(positiveMax, positiveAbsMax[lane]);
+            negativeMax = std::max(negativeMax, negativeAbsMax[lane]);
+            positiveTotal += positiveCount[lane];
+            negativeTotal += negativeCount[lane];
+        }
+
+        m_positiveDataAccumulator.AddBlock(positiveTotal, positiveSum, positiveMax);
+        m_negativeDataAccumulator.AddBlock(negativeTotal, negativeSum, negativeMax);
+
+        samples += blockSize;
+        sampleCount -= blockSize;
+        m_pendingSampleCount += blockSize;
+
+        if (m_pendingSampleCount >= AudioSamplesPerGraphSample)
+        {
+            // Update graph data
+            //
+            m_graphData[m_nextGraphPointIndex] = DataPoint(m_positiveDataAccumulator.GetAbsMax(),
+                                                           m_positiveDataAccumulator.GetRms(),
+                                                           -m_negativeDataAccumulator.GetRms(),
+                                                           -m_negativeDataAccumulator.GetAbsMax());
+
+            // Advance graph point
+            //
+            m_nextGraphPointIndex = (m_nextGraphPointIndex + 1) % AudioChannelGraphSampleCount;
+
+            // Reset accumulators
+            //
+            m_positiveDataAccumulator.Reset();
+            m_negativeDataAccumulator.Reset();
+            m_pendingSampleCount = 0;
+        }
     }
 }
 
@@ -171,11 +223,13 @@ void K4AAudioChannelDataGraph::Show(ImVec2 graphSize, const float scale)
                              ImVec2(0.5f, 0.0f));
 }
 
-void K4AAudioChannelDataGraph::SignedAudioDataAccumulator::AddSample(const float sample)
+void K4AAudioChannelDataGraph::SignedAudioDataAccumulator::AddBlock(const size_t sampleCount,
+                                                                     const float sumOfSquares,
+                                                                     const float absMax)
 {
-    m_sampleCount++;
-    m_rmsAccumulator += sample * sample;
-    m_absMax = std::max(std::fabs(sample), m_absMax);
+    m_sampleCount += sampleCount;
+    m_rmsAccumulator += sumOfSquares;
+    m_absMax = std::max(absMax, m_absMax);
 }
 
 void K4AAudioChannelDataGraph::SignedAudioDataAccumulator::Reset()
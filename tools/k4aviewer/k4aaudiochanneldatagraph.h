@@ -23,7 +23,9 @@ class K4AAudioChannelDataGraph
 public:
     explicit K4AAudioChannelDataGraph(const char *name);
 
-    void AddSample(float sample);
+    // Adds a block of consecutive samples of this channel
+    //
+    void AddSamples(const float *samples, size_t sampleCount);
     void Show(ImVec2 graphSize, float scale);
 
 private:
@@ -32,7 +34,9 @@ private:
     class SignedAudioDataAccumulator
     {
     public:
-        void AddSample(float sample);
+        // Adds the statistics of a block of samples, all of which have the accumulator's sign
+        //
+        void AddBlock(size_t sampleCount, float sumOfSquares, float absMax);
         void Reset();
         float GetAbsMax() const;
 
@@ -74,6 +78,7 @@ private:
     //
     static constexpr size_t AudioSamplesPerGraphSample = K4AMicrophoneSampleRate / 60;
     size_t m_nextGraphPointIndex = 0;
+    size_t m_pendingSampleCount = 0;
     SignedAudioDataAccumulator m_positiveDataAccumulator;
     SignedAudioDataAccumulator m_negativeDataAccumulator;
     std::string m_name = "Unknown channel";
@@ -15,8 +15,6 @@
 
 // Project headers
 //
-#include "k4aviewererrormanager.h"
-
 #include "k4adevicecorrelator.h"
 
 using namespace k4aviewer;
@@ -7,6 +7,8 @@
 
 // System headers
 //
+#include <algorithm>
+#include <array>
 #include <sstream>
 
 // Library headers
@@ -109,11 +111,20 @@ void K4AAudioWindow::ProcessNewData()
     }
 
     m_listener->ProcessFrames([this](K4AMicrophoneFrame *frame, const size_t frameCount) {
-        for (size_t frameId = 0; frameId < frameCount; frameId++)
+        // De-interleave the frames a chunk at a time so each channel graph gets a contiguous block of samples
+        //
+        constexpr size_t ChunkFrameCount = 256;
+        std::array<float, ChunkFrameCount> channelSamples;
+        for (size_t chunkStart = 0; chunkStart < frameCount; chunkStart += ChunkFrameCount)
         {
+            const size_t chunkSize = std::min(ChunkFrameCount, frameCount - chunkStart);
             for (size_t channelId = 0; channelId < K4AMicrophoneFrame::ChannelCount; channelId++)
             {
-                m_channelData[channelId].AddSample(frame[frameId].Channel[channelId]);
+                for (size_t frameId = 0; frameId < chunkSize; frameId++)
+                {
+                    channelSamples[frameId] = frame[chunkStart + frameId].Channel[channelId];
+                }
+                m_channelData[channelId].AddSamples(channelSamples.data(), chunkSize);
             }
         }
 
@@ -8,11 +8,11 @@
 // System headers
 //
 #include <algorithm>
+#include <atomic>
 #include <string>
 
 // Library headers
 //
-#include "libyuv.h"
 
 // Clang parses doxygen-style comments in your source and checks for doxygen syntax errors.
 // Unfortunately, some of our external dependencies have doxygen syntax errors in them, so
@@ -32,6 +32,7 @@
 
 // Project headers
 //
+#include "gpuyuvimageconverter.h"
 #include "k4astaticimageproperties.h"
 #include "k4aviewererrormanager.h"
 #include "perfcounter.h"
@@ -52,12 +53,9 @@ protected:
     explicit K4AColorImageConverterBase(k4a_color_resolution_t colorResolution) :
         m_dimensions(GetColorDimensions(colorResolution))
     {
-        m_expectedBufferSize = sizeof(BgraPixel) * static_cast<size_t>(m_dimensions.Width * m_dimensions.Height);
     }
 
-    bool ImagesAreCorrectlySized(const k4a::image &srcImage,
-                                 const k4a::image &dstImage,
-                                 const size_t *srcImageExpectedSize)
+    bool ImageIsCorrectlySized(const k4a::image &srcImage, const size_t *srcImageExpectedSize)
     {
         if (srcImageExpectedSize)
         {
@@ -67,12 +65,12 @@ protected:
             }
         }
 
-        if (srcImage.get_width_pixels() != dstImage.get_width_pixels())
+        if (srcImage.get_width_pixels() != m_dimensions.Width)
         {
             return false;
         }
 
-        if (srcImage.get_height_pixels() != dstImage.get_height_pixels())
+        if (srcImage.get_height_pixels() != m_dimensions.Height)
         {
             return false;
         }
@@ -80,42 +78,61 @@ protected:
         return true;
     }
 
-    size_t m_expectedBufferSize;
+    // The GPU converter owns OpenGL objects, so it has to be created on the thread that owns the context
+    //
+    GpuYuvImageConverter &GetGpuConverter()
+    {
+        if (!m_gpuConverter)
+        {
+            m_gpuConverter.reset(new GpuYuvImageConverter());
+        }
+        return *m_gpuConverter;
+    }
+
     ImageDimensions m_dimensions;
+
+private:
+    std::unique_ptr<GpuYuvImageConverter> m_gpuConverter;
 };
 
+// Converters for formats that the GPU converts as-is.  ConvertImage() only checks the image and
+// UpdateTexture() uploads the source image.
+//
 class K4AYUY2ImageConverter : public K4AColorImageConverterBase<K4A_IMAGE_FORMAT_COLOR_YUY2>
 {
 public:
-    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) override
+    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *convertedImage) override
     {
+        (void)convertedImage;
+
         // YUY2 is a 4:2:2 format, so there are 4 bytes per 'chunk' of data, and each 'chunk' represents 2 pixels.
         //
         const int stride = m_dimensions.Width * 4 / 2;
         const size_t expectedBufferSize = static_cast<size_t>(stride * m_dimensions.Height);
 
-        if (!ImagesAreCorrectlySized(srcImage, *bgraImage, &expectedBufferSize))
+        if (!ImageIsCorrectlySized(srcImage, &expectedBufferSize))
         {
             return ImageConversionResult::InvalidBufferSizeError;
         }
 
+        return ImageConversionResult::Success;
+    }
+
+    k4a::image CreateConversionImage() const override
+    {
+        return k4a::image();
+    }
+
+    GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &convertedImage, K4AViewerImage *texture) override
+    {
+        (void)convertedImage;
+
         static PerfCounter decode("YUY2 decode");
         PerfSample decodeSample(&decode);
-        int result = libyuv::YUY2ToARGB(srcImage.get_buffer(),                                    // src_yuy2,
-                                        stride,                                                   // src_stride_yuy2,
-                                        bgraImage->get_buffer(),                                  // dst_argb,
-                                        m_dimensions.Width * static_cast<int>(sizeof(BgraPixel)), // dst_stride_argb,
-                                        m_dimensions.Width,                                       // width,
-                                        m_dimensions.Height                                       // height
-        );
+        const GLenum result = GetGpuConverter().ConvertYUY2(srcImage, texture);
         decodeSample.End();
 
-        if (result != 0)
-        {
-            return ImageConversionResult::InvalidImageDataError;
-        }
-
-        return ImageConversionResult::Success;
+        return result;
     }
 
     K4AYUY2ImageConverter(k4a_color_resolution_t resolution) : K4AColorImageConverterBase(resolution) {}
@@ -124,45 +141,40 @@ public:
 class K4ANV12ImageConverter : public K4AColorImageConverterBase<K4A_IMAGE_FORMAT_COLOR_NV12>
 {
 public:
-    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) override
+    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *convertedImage) override
     {
+        (void)convertedImage;
+
         const int luminanceStride = m_dimensions.Width;
         const int hueSatStride = m_dimensions.Width;
-        const uint8_t *hueSatStart = srcImage.get_buffer() + luminanceStride * m_dimensions.Height;
 
         // NV12 is a 4:2:0 format, so there are half as many hue/sat pixels as luminance pixels
         //
         const auto expectedBufferSize = static_cast<size_t>(m_dimensions.Height * (luminanceStride + hueSatStride / 2));
 
-        if (!ImagesAreCorrectlySized(srcImage, *bgraImage, &expectedBufferSize))
+        if (!ImageIsCorrectlySized(srcImage, &expectedBufferSize))
         {
             return ImageConversionResult::InvalidBufferSizeError;
         }
 
-        // libyuv refers to pixel order in system-endian order but OpenGL refers to
-        // pixel order in big-endian order, which is why we create the OpenGL texture
-        // as "RGBA" but then use the "ABGR" libyuv function here.
-        //
+        return ImageConversionResult::Success;
+    }
+
+    k4a::image CreateConversionImage() const override
+    {
+        return k4a::image();
+    }
+
+    GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &convertedImage, K4AViewerImage *texture) override
+    {
+        (void)convertedImage;
+
         static PerfCounter decode("NV12 decode");
         PerfSample decodeSample(&decode);
-        int result = libyuv::NV12ToARGB(srcImage.get_buffer(),                                    // src_y
-                                        luminanceStride,                                          // src_stride_y
-                                        hueSatStart,                                              // src_vu
-                                        hueSatStride,                                             // src_stride_vu
-                                        bgraImage->get_buffer(),                                  // dst_argb
-                                        m_dimensions.Width * static_cast<int>(sizeof(BgraPixel)), // dst_stride_argb
-                                        m_dimensions.Width,                                       // width
-                                        m_dimensions.Height                                       // height
-        );
-
-        if (result != 0)
-        {
-            return ImageConversionResult::InvalidImageDataError;
-        }
-
+        const GLenum result = GetGpuConverter().ConvertNV12(srcImage, texture);
         decodeSample.End();
 
-        return ImageConversionResult::Success;
+        return result;
     }
 
     K4ANV12ImageConverter(k4a_color_resolution_t resolution) : K4AColorImageConverterBase(resolution) {}
@@ -171,30 +183,47 @@ public:
 class K4ABGRA32ImageConverter : public K4AColorImageConverterBase<K4A_IMAGE_FORMAT_COLOR_BGRA32>
 {
 public:
-    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) override
+    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *convertedImage) override
     {
+        (void)convertedImage;
+
         const size_t expectedBufferSize = static_cast<size_t>(m_dimensions.Height * m_dimensions.Width) *
                                           sizeof(BgraPixel);
-        if (!ImagesAreCorrectlySized(srcImage, *bgraImage, &expectedBufferSize))
+        if (!ImageIsCorrectlySized(srcImage, &expectedBufferSize))
         {
             return ImageConversionResult::InvalidBufferSizeError;
         }
 
-        std::copy(srcImage.get_buffer(), srcImage.get_buffer() + srcImage.get_size(), bgraImage->get_buffer());
         return ImageConversionResult::Success;
     }
 
+    k4a::image CreateConversionImage() const override
+    {
+        return k4a::image();
+    }
+
+    // The source image is already in the texture's format, so upload it directly rather than copying it first
+    //
+    GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &convertedImage, K4AViewerImage *texture) override
+    {
+        (void)convertedImage;
+        return texture->UpdateTexture(srcImage.get_buffer());
+    }
+
     K4ABGRA32ImageConverter(k4a_color_resolution_t resolution) : K4AColorImageConverterBase(resolution) {}
 };
 
+// MJPG images are decoded on the CPU, but only as far as their Y, U and V planes; the GPU does the conversion to
+// RGB, which saves the color conversion pass and uploads half as much data for 4:2:2 images.
+//
 class K4AMJPGImageConverter : public K4AColorImageConverterBase<K4A_IMAGE_FORMAT_COLOR_MJPG>
 {
 public:
-    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) override
+    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *yuvImage) override
     {
         // MJPG images are not of a consistent size, so we can't compute an expected size
         //
-        if (!ImagesAreCorrectlySized(srcImage, *bgraImage, nullptr))
+        if (!ImageIsCorrectlySized(srcImage, nullptr))
         {
             return ImageConversionResult::InvalidBufferSizeError;
         }
@@ -202,24 +231,81 @@ public:
         static PerfCounter mjpgDecode("MJPG decode");
         PerfSample decodeSample(&mjpgDecode);
 
-        const int decompressStatus = tjDecompress2(m_decompressor,
-                                                   srcImage.get_buffer(),
-                                                   static_cast<unsigned long>(srcImage.get_size()),
-                                                   bgraImage->get_buffer(),
-                                                   m_dimensions.Width,
-                                                   0, // pitch
-                                                   m_dimensions.Height,
-                                                   TJPF_BGRA,
-                                                   TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE);
+        int width = 0;
+        int height = 0;
+        int subsampling = 0;
+        int colorspace = 0;
+        if (tjDecompressHeader3(m_decompressor,
+                                srcImage.get_buffer(),
+                                static_cast<unsigned long>(srcImage.get_size()),
+                                &width,
+                                &height,
+                                &subsampling,
+                                &colorspace) != 0)
+        {
+            return ImageConversionResult::InvalidImageDataError;
+        }
+
+        if (width != m_dimensions.Width || height != m_dimensions.Height)
+        {
+            return ImageConversionResult::InvalidBufferSizeError;
+        }
+
+        // The color camera never produces greyscale images, and the shader expects chroma planes
+        //
+        if (subsampling == TJSAMP_GRAY)
+        {
+            return ImageConversionResult::InvalidImageDataError;
+        }
+
+        const int decompressStatus = tjDecompressToYUV2(m_decompressor,
+                                                        srcImage.get_buffer(),
+                                                        static_cast<unsigned long>(srcImage.get_size()),
+                                                        yuvImage->get_buffer(),
+                                                        m_dimensions.Width,
+                                                        1, // pad
+                                                        m_dimensions.Height,
+                                                        TJFLAG_FASTDCT);
 
         if (decompressStatus != 0)
         {
             return ImageConversionResult::InvalidImageDataError;
         }
 
+        m_subsampling = subsampling;
+
         return ImageConversionResult::Success;
     }
 
+    // Large enough for the Y, U and V planes of a 4:4:4 image, the largest the decoder can produce
+    //
+    k4a::image CreateConversionImage() const override
+    {
+        return k4a::image::create(K4A_IMAGE_FORMAT_CUSTOM8,
+                                  m_dimensions.Width,
+                                  m_dimensions.Height * 3,
+                                  m_dimensions.Width);
+    }
+
+    GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &yuvImage, K4AViewerImage *texture) override
+    {
+        (void)srcImage;
+
+        const int subsampling = m_subsampling;
+        const ImageDimensions chromaDimensions(tjPlaneWidth(1, m_dimensions.Width, subsampling),
+                                               tjPlaneHeight(1, m_dimensions.Height, subsampling));
+
+        static PerfCounter mjpgConvert("MJPG convert");
+        PerfSample convertSample(&mjpgConvert);
+        const GLenum result = GetGpuConverter().ConvertPlanar(yuvImage.get_buffer(),
+                                                              m_dimensions,
+                                                              chromaDimensions,
+                                                              texture);
+        convertSample.End();
+
+        return result;
+    }
+
     K4AMJPGImageConverter(k4a_color_resolution_t resolution) :
         K4AColorImageConverterBase(resolution),
         m_decompressor(tjInitDecompress())
@@ -233,6 +319,11 @@ public:
 
 private:
     tjhandle m_decompressor;
+
+    // Chroma subsampling of the most recently decoded image.  Written by the worker thread, read by UpdateTexture().
+    // The camera doesn't change it mid-stream.
+    //
+    std::atomic<int> m_subsampling{ TJSAMP_422 };
 };
 
 template<>
@@ -7,10 +7,11 @@
 // System headers
 //
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <thread>
 
 // Library headers
 //
@@ -22,7 +23,9 @@
 #include "ik4aimageconverter.h"
 #include "k4aimageextractor.h"
 #include "k4aframeratetracker.h"
+#include "k4alatestvalueslot.h"
 #include "k4aringbuffer.h"
+#include "k4aworkerpool.h"
 
 namespace k4aviewer
 {
@@ -41,8 +44,9 @@ public:
             return ImageConversionResult::NoDataError;
         }
 
-        GLenum result = textureToUpdate->UpdateTexture(m_textureBuffers.CurrentItem()->Bgra.get_buffer());
-        *sourceImage = m_textureBuffers.CurrentItem()->Source;
+        ConvertedImagePair *item = m_textureBuffers.CurrentItem();
+        GLenum result = m_imageConverter->UpdateTexture(item->Source, item->Converted, textureToUpdate);
+        *sourceImage = item->Source;
 
         m_textureBuffers.AdvanceRead();
         return GLEnumToImageConversionResult(result);
@@ -75,39 +79,32 @@ public:
 
     void NotifyTermination() override
     {
-        m_workerThreadShouldExit = true;
+        m_conversionShouldExit = true;
         m_failed = true;
     }
 
     void ClearData() override
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
+        m_pendingImage.Clear();
         m_textureBuffers.Clear();
-        m_inputImageBuffer.Clear();
     }
 
     ~K4AConvertingImageSourceImpl() override
     {
-        m_workerThreadShouldExit = true;
-        if (m_workerThread.joinable())
-        {
-            m_workerThread.join();
-        }
+        // Conversion tasks reference this object, so wait for the ones that are still queued on the pool
+        //
+        m_conversionShouldExit = true;
+        std::unique_lock<std::mutex> lock(m_conversionMutex);
+        m_conversionDone.wait(lock, [this]() { return m_scheduledConversions == 0; });
     };
 
     K4AConvertingImageSourceImpl(std::unique_ptr<IK4AImageConverter<ImageFormat>> &&imageConverter) :
         m_imageConverter(std::move(imageConverter))
     {
-        ImageDimensions dimensions = m_imageConverter->GetImageDimensions();
-        m_textureBuffers.Initialize([dimensions](ConvertedImagePair *bufferItem) {
-            bufferItem->Bgra = k4a::image::create(K4A_IMAGE_FORMAT_COLOR_BGRA32,
-                                                  dimensions.Width,
-                                                  dimensions.Height,
-                                                  dimensions.Width * static_cast<int>(sizeof(BgraPixel)));
+        IK4AImageConverter<ImageFormat> *converter = m_imageConverter.get();
+        m_textureBuffers.Initialize([converter](ConvertedImagePair *bufferItem) {
+            bufferItem->Converted = converter->CreateConversionImage();
         });
-
-        m_workerThread = std::thread(&K4AConvertingImageSourceImpl::WorkerThread, this);
     }
 
     K4AConvertingImageSourceImpl(K4AConvertingImageSourceImpl &) = delete;
@@ -125,64 +122,72 @@ protected:
         k4a::image image = K4AImageExtractor::GetImageFromCapture<ImageFormat>(data);
         if (image != nullptr)
         {
-            // Hand the image off to our worker thread.
+            // Hand the image off to the worker pool.  This runs on the polling thread, so it must never wait
+            // on the conversion: if the previous image hasn't been converted yet, it's replaced and dropped.
             //
-            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pendingImage.Put(image);
 
-            if (!m_inputImageBuffer.BeginInsert())
+            // Only one conversion task per source is queued or running at a time, so conversions of the
+            // same source never run in parallel.  The task keeps going until it has seen every notification.
+            //
+            if (m_pendingNotifications.fetch_add(1) == 0)
             {
-                // Worker thread is backed up. drop the image
-                //
-                return;
+                {
+                    std::lock_guard<std::mutex> lock(m_conversionMutex);
+                    ++m_scheduledConversions;
+                }
+                K4AWorkerPool::Instance().Submit([this]() { ConvertPendingImages(); });
             }
-
-            *m_inputImageBuffer.InsertionItem() = std::move(image);
-            m_inputImageBuffer.EndInsert();
         }
     }
 
 private:
-    static void WorkerThread(K4AConvertingImageSourceImpl *fs)
+    void ConvertPendingImages()
     {
-        while (!fs->m_workerThreadShouldExit)
+        size_t notifications = m_pendingNotifications.load();
+        do
         {
-            std::unique_lock<std::mutex> lock(fs->m_mutex);
-            if (!fs->m_inputImageBuffer.Empty())
-            {
-                // Take the image from the image source
-                //
-                k4a::image imageToConvert = std::move(*fs->m_inputImageBuffer.CurrentItem());
-                fs->m_inputImageBuffer.AdvanceRead();
-                lock.unlock();
+            ConvertImage(m_pendingImage.Take());
+        } while (!m_pendingNotifications.compare_exchange_strong(notifications, 0));
 
-                if (!fs->m_textureBuffers.BeginInsert())
-                {
-                    // Our buffer has overflowed.  Drop the image.
-                    //
-                    continue;
-                }
+        std::lock_guard<std::mutex> lock(m_conversionMutex);
+        --m_scheduledConversions;
+        m_conversionDone.notify_all();
+    }
 
-                ImageConversionResult result =
-                    fs->m_imageConverter->ConvertImage(imageToConvert, &fs->m_textureBuffers.InsertionItem()->Bgra);
+    void ConvertImage(k4a::image &&imageToConvert)
+    {
+        if (!imageToConvert || m_conversionShouldExit)
+        {
+            return;
+        }
 
-                if (result != ImageConversionResult::Success)
-                {
-                    // We treat visualization failures as fatal.  Stop the thread.
-                    //
-                    fs->m_failureCode = result;
-                    fs->NotifyTermination();
-                    fs->m_textureBuffers.AbortInsert();
-                    return;
-                }
+        if (!m_textureBuffers.BeginInsert())
+        {
+            // Our buffer has overflowed.  Drop the image.
+            //
+            return;
+        }
 
-                // Save off the source image so the viewer can show things like pixel values
-                //
-                fs->m_textureBuffers.InsertionItem()->Source = std::move(imageToConvert);
+        ImageConversionResult result = m_imageConverter->ConvertImage(imageToConvert,
+                                                                      &m_textureBuffers.InsertionItem()->Converted);
 
-                fs->m_textureBuffers.EndInsert();
-                fs->m_framerateTracker.NotifyFrame();
-            }
+        if (result != ImageConversionResult::Success)
+        {
+            // We treat visualization failures as fatal.  Stop converting.
+            //
+            m_failureCode = result;
+            NotifyTermination();
+            m_textureBuffers.AbortInsert();
+            return;
         }
+
+        // Save off the source image so the viewer can show things like pixel values
+        //
+        m_textureBuffers.InsertionItem()->Source = std::move(imageToConvert);
+
+        m_textureBuffers.EndInsert();
+        m_framerateTracker.NotifyFrame();
     }
 
     ImageConversionResult m_failureCode = ImageConversionResult::Success;
@@ -195,18 +200,20 @@ private:
     struct ConvertedImagePair
     {
         k4a::image Source;
-        k4a::image Bgra;
+        k4a::image Converted;
     };
 
     K4ARingBuffer<ConvertedImagePair, BufferSize> m_textureBuffers;
-    K4ARingBuffer<k4a::image, BufferSize> m_inputImageBuffer;
+    K4ALatestValueSlot<k4a::image> m_pendingImage;
 
     K4AFramerateTracker m_framerateTracker;
 
-    std::mutex m_mutex;
+    std::atomic<size_t> m_pendingNotifications{ 0 };
+    std::atomic<bool> m_conversionShouldExit{ false };
 
-    std::thread m_workerThread;
-    bool m_workerThreadShouldExit = false;
+    size_t m_scheduledConversions = 0;
+    std::mutex m_conversionMutex;
+    std::condition_variable m_conversionDone;
 };
 
 template<k4a_image_format_t ImageFormat>
@@ -10,7 +10,9 @@
 // Library headers
 //
 #include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 // Project headers
 //
@@ -45,26 +47,24 @@ public:
         m_observers.emplace_back(std::move(observer));
     }
 
+    // Called on the polling thread for every capture or sample.  Observers are notified outside the lock,
+    // so registering an observer on the UI thread never holds up the polling thread for longer than it
+    // takes to copy the list; observers are expected to hand the data off without waiting.
+    //
     void NotifyObservers(const T &data)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::shared_ptr<IK4AObserver<T>>> observers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
 
-        m_mostRecentData = data;
-        m_primed = true;
-        for (auto wpObserver = m_observers.begin(); wpObserver != m_observers.end();)
+            m_mostRecentData = data;
+            m_primed = true;
+            observers = LockObservers();
+        }
+
+        for (const auto &spObserver : observers)
         {
-            auto spObserver = wpObserver->lock();
-            if (spObserver)
-            {
-                spObserver->NotifyData(data);
-                ++wpObserver;
-            }
-            else
-            {
-                auto toDelete = wpObserver;
-                ++wpObserver;
-                m_observers.erase(toDelete);
-            }
+            spObserver->NotifyData(data);
         }
     }
 
@@ -107,6 +107,30 @@ public:
     }
 
 private:
+    // Returns the observers that still exist and forgets the others.  Must be called with m_mutex held.
+    //
+    std::vector<std::shared_ptr<IK4AObserver<T>>> LockObservers()
+    {
+        std::vector<std::shared_ptr<IK4AObserver<T>>> observers;
+        observers.reserve(m_observers.size());
+        for (auto wpObserver = m_observers.begin(); wpObserver != m_observers.end();)
+        {
+            auto spObserver = wpObserver->lock();
+            if (spObserver)
+            {
+                observers.emplace_back(std::move(spObserver));
+                ++wpObserver;
+            }
+            else
+            {
+                auto toDelete = wpObserver;
+                ++wpObserver;
+                m_observers.erase(toDelete);
+            }
+        }
+        return observers;
+    }
+
     std::list<std::weak_ptr<IK4AObserver<T>>> m_observers;
 
     bool m_primed = false;
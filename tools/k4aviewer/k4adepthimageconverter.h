@@ -13,14 +13,13 @@
 // Project headers
 //
 #include "k4adepthimageconverterbase.h"
-#include "k4adepthpixelcolorizer.h"
 #include "k4astaticimageproperties.h"
 
 namespace k4aviewer
 {
 
 class K4ADepthImageConverter
-    : public K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_DEPTH16, K4ADepthPixelColorizer::ColorizeBlueToRed>
+    : public K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_DEPTH16, DepthColorization::BlueToRed>
 {
 public:
     explicit K4ADepthImageConverter(k4a_depth_mode_t depthMode) :
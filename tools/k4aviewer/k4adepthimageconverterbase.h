@@ -7,35 +7,38 @@
 // System headers
 //
 #include <memory>
-#include <vector>
+#include <string>
 
 // Library headers
 //
 
 // Project headers
 //
+#include "gpudepthimagecolorizer.h"
 #include "ik4aimageconverter.h"
-#include "k4adepthpixelcolorizer.h"
 #include "k4astaticimageproperties.h"
 #include "k4aviewerutil.h"
 #include "perfcounter.h"
 
 namespace k4aviewer
 {
-template<k4a_image_format_t ImageFormat, DepthPixelVisualizationFunction VisualizationFunction>
+// Converts depth and IR images for display.  The 16-bit pixels are uploaded as-is and colorized on the GPU
+// with GpuDepthImageColorizer, so ConvertImage() only checks the image.
+//
+template<k4a_image_format_t ImageFormat, DepthColorization Colorization>
 class K4ADepthImageConverterBase : public IK4AImageConverter<ImageFormat>
 {
 public:
     explicit K4ADepthImageConverterBase(const k4a_depth_mode_t depthMode,
                                         const std::pair<DepthPixel, DepthPixel> expectedValueRange) :
         m_dimensions(GetDepthDimensions(depthMode)),
-        m_expectedValueRange(expectedValueRange),
-        m_expectedBufferSize(static_cast<size_t>(m_dimensions.Width * m_dimensions.Height) * sizeof(BgraPixel))
+        m_expectedValueRange(expectedValueRange)
     {
     }
 
-    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *bgraImage) override
+    ImageConversionResult ConvertImage(const k4a::image &srcImage, k4a::image *convertedImage) override
     {
+        (void)convertedImage;
         const size_t srcImageSize = static_cast<size_t>(m_dimensions.Width * m_dimensions.Height) * sizeof(DepthPixel);
 
         if (srcImage.get_size() != srcImageSize)
@@ -43,22 +46,38 @@ public:
             return ImageConversionResult::InvalidBufferSizeError;
         }
 
-        if (bgraImage->get_width_pixels() != srcImage.get_width_pixels() ||
-            bgraImage->get_height_pixels() != srcImage.get_height_pixels())
+        if (srcImage.get_width_pixels() != m_dimensions.Width || srcImage.get_height_pixels() != m_dimensions.Height)
         {
             return ImageConversionResult::InvalidBufferSizeError;
         }
 
-        const uint8_t *src = srcImage.get_buffer();
+        return ImageConversionResult::Success;
+    }
+
+    k4a::image CreateConversionImage() const override
+    {
+        // The colorized image only ever exists on the GPU
+        //
+        return k4a::image();
+    }
+
+    GLenum UpdateTexture(const k4a::image &srcImage, const k4a::image &convertedImage, K4AViewerImage *texture) override
+    {
+        (void)convertedImage;
+
+        // The colorizer owns OpenGL objects, so it has to be created on the thread that owns the context
+        //
+        if (!m_colorizer)
+        {
+            m_colorizer.reset(new GpuDepthImageColorizer());
+        }
 
         static PerfCounter render(std::string("Depth sensor<T") + std::to_string(int(ImageFormat)) + "> render");
         PerfSample renderSample(&render);
-        RenderImage(src,
-                    static_cast<size_t>(m_dimensions.Width * m_dimensions.Height) * sizeof(DepthPixel),
-                    bgraImage->get_buffer());
+        const GLenum result = m_colorizer->Colorize(srcImage, m_expectedValueRange, Colorization, texture);
         renderSample.End();
 
-        return ImageConversionResult::Success;
+        return result;
     }
 
     ImageDimensions GetImageDimensions() const override
@@ -74,25 +93,10 @@ public:
     K4ADepthImageConverterBase &operator=(const K4ADepthImageConverterBase &&) = delete;
 
 private:
-    void RenderImage(const uint8_t *src, const size_t srcSize, uint8_t *dst)
-    {
-        const uint8_t *currentSrc = src;
-        const uint8_t *srcEnd = src + srcSize;
-        while (currentSrc < srcEnd)
-        {
-            const DepthPixel pixelValue = *reinterpret_cast<const DepthPixel *>(currentSrc);
-
-            BgraPixel *outputPixel = reinterpret_cast<BgraPixel *>(dst);
-            *outputPixel = VisualizationFunction(pixelValue, m_expectedValueRange.first, m_expectedValueRange.second);
-
-            dst += sizeof(BgraPixel);
-            currentSrc += sizeof(DepthPixel);
-        }
-    }
-
     const ImageDimensions m_dimensions;
     const std::pair<DepthPixel, DepthPixel> m_expectedValueRange;
-    const size_t m_expectedBufferSize;
+
+    std::unique_ptr<GpuDepthImageColorizer> m_colorizer;
 };
 
 } // namespace k4aviewer
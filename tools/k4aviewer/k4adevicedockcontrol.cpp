@@ -23,6 +23,7 @@
 #include "k4aviewererrormanager.h"
 #include "k4aviewerutil.h"
 #include "k4awindowmanager.h"
+#include "perfcounter.h"
 
 using namespace k4aviewer;
 
@@ -285,10 +286,13 @@ K4ADeviceDockControl::K4ADeviceDockControl(k4a::device &&device) : m_device(std:
 
     LoadColorSettingsCache();
     RefreshSyncCableStatus();
+
+    PerfCounterManager::RegisterDevice(m_device.handle(), m_deviceSerialNumber);
 }
 
 K4ADeviceDockControl::~K4ADeviceDockControl()
 {
+    PerfCounterManager::UnregisterDevice(m_device.handle());
     Stop();
 }
 
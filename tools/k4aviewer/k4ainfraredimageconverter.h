@@ -13,18 +13,16 @@
 // Project headers
 //
 #include "k4adepthimageconverterbase.h"
-#include "k4adepthpixelcolorizer.h"
 
 namespace k4aviewer
 {
 class K4AInfraredImageConverter
-    : public K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_IR16, K4ADepthPixelColorizer::ColorizeGreyscale>
+    : public K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_IR16, DepthColorization::Greyscale>
 {
 public:
     explicit K4AInfraredImageConverter(k4a_depth_mode_t depthMode) :
-        K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_IR16, K4ADepthPixelColorizer::ColorizeGreyscale>(depthMode,
-                                                                                                     GetIrLevels(
-                                                                                                         depthMode)){};
+        K4ADepthImageConverterBase<K4A_IMAGE_FORMAT_IR16, DepthColorization::Greyscale>(depthMode,
+                                                                                        GetIrLevels(depthMode)){};
 
     ~K4AInfraredImageConverter() override = default;
 
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef K4ALATESTVALUESLOT_H
+#define K4ALATESTVALUESLOT_H
+
+// System headers
+//
+#include <atomic>
+#include <utility>
+
+// Library headers
+//
+#include <k4a/k4a.hpp>
+
+// Project headers
+//
+
+namespace k4aviewer
+{
+
+inline void AddHandleReference(k4a_image_t handle)
+{
+    k4a_image_reference(handle);
+}
+
+inline void AddHandleReference(k4a_capture_t handle)
+{
+    k4a_capture_reference(handle);
+}
+
+// Holds the most recent k4a::image or k4a::capture handed over from one thread to another.
+//
+// Putting a value replaces the one in the slot, so a consumer that falls behind only ever sees the newest
+// value and the producer never waits for it.  Both sides only do an atomic exchange of the handle.
+//
+template<typename T> class K4ALatestValueSlot
+{
+public:
+    using HandleType = decltype(std::declval<const T &>().handle());
+
+    K4ALatestValueSlot() = default;
+
+    ~K4ALatestValueSlot()
+    {
+        Clear();
+    }
+
+    // Replaces the value in the slot.  A value that was never taken is released.
+    //
+    void Put(const T &value)
+    {
+        HandleType handle = value.handle();
+        if (handle)
+        {
+            AddHandleReference(handle);
+        }
+
+        T dropped(m_handle.exchange(handle));
+    }
+
+    // Empties the slot and returns what was in it, which may be a null value
+    //
+    T Take()
+    {
+        return T(m_handle.exchange(nullptr));
+    }
+
+    void Clear()
+    {
+        T dropped(m_handle.exchange(nullptr));
+    }
+
+    K4ALatestValueSlot(const K4ALatestValueSlot &) = delete;
+    K4ALatestValueSlot(const K4ALatestValueSlot &&) = delete;
+    K4ALatestValueSlot &operator=(const K4ALatestValueSlot &) = delete;
+    K4ALatestValueSlot &operator=(const K4ALatestValueSlot &&) = delete;
+
+private:
+    std::atomic<HandleType> m_handle{ nullptr };
+};
+
+} // namespace k4aviewer
+
+#endif
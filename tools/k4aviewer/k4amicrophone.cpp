@@ -8,6 +8,9 @@
 // System headers
 //
 #include <algorithm>
+#include <climits>
+#include <cstring>
+#include <thread>
 
 // Library headers
 //
@@ -15,11 +18,16 @@
 // Project headers
 //
 #include "k4amicrophonelistener.h"
-#include "k4aviewererrormanager.h"
 
 using namespace k4aviewer;
 
-K4AMicrophone::K4AMicrophone(std::shared_ptr<SoundIoDevice> device) : m_device(std::move(device)) {}
+K4AMicrophone::K4AMicrophone(std::shared_ptr<SoundIoDevice> device) : m_device(std::move(device))
+{
+    for (std::atomic<K4AMicrophoneListener *> &slot : m_listeners)
+    {
+        slot.store(nullptr);
+    }
+}
 
 void K4AMicrophone::SetFailed(const int errorCode)
 {
@@ -84,8 +92,12 @@ void K4AMicrophone::Stop()
     m_started = false;
     m_inStream.reset();
 
-    std::lock_guard<std::mutex> lock(m_listenersMutex);
-    m_listeners.clear();
+    // Destroying the stream stopped the capture callback, so the listeners can be dropped right away
+    //
+    for (std::atomic<K4AMicrophoneListener *> &slot : m_listeners)
+    {
+        slot.store(nullptr);
+    }
 }
 
 std::shared_ptr<K4AMicrophoneListener> K4AMicrophone::CreateListener()
@@ -96,10 +108,11 @@ std::shared_ptr<K4AMicrophoneListener> K4AMicrophone::CreateListener()
     }
 
     constexpr int bufferPaddingRatio = 3;
-    const auto bufferSize = static_cast<size_t>(bufferPaddingRatio * m_inStream->software_latency *
-                                                m_inStream->sample_rate * m_inStream->bytes_per_frame);
+    const auto bufferFrameCount = static_cast<size_t>(bufferPaddingRatio * m_inStream->software_latency *
+                                                      m_inStream->sample_rate);
 
-    auto result = std::shared_ptr<K4AMicrophoneListener>(new K4AMicrophoneListener(shared_from_this(), bufferSize));
+    auto result = std::shared_ptr<K4AMicrophoneListener>(
+        new K4AMicrophoneListener(shared_from_this(), bufferFrameCount));
     if (!result->m_buffer)
     {
         // OOM
@@ -108,12 +121,39 @@ std::shared_ptr<K4AMicrophoneListener> K4AMicrophone::CreateListener()
         return nullptr;
     }
 
-    std::weak_ptr<K4AMicrophoneListener> newListenerWeakPtr = result;
+    for (std::atomic<K4AMicrophoneListener *> &slot : m_listeners)
+    {
+        K4AMicrophoneListener *expected = nullptr;
+        if (slot.compare_exchange_strong(expected, result.get()))
+        {
+            return result;
+        }
+    }
+
+    // Every slot is taken.  The listener was never registered, so destroying it is a no-op for the callback.
+    //
+    return nullptr;
+}
 
-    std::lock_guard<std::mutex> lock(m_listenersMutex);
-    m_listeners.emplace_back(std::move(newListenerWeakPtr));
+void K4AMicrophone::RemoveListener(K4AMicrophoneListener *listener)
+{
+    for (std::atomic<K4AMicrophoneListener *> &slot : m_listeners)
+    {
+        K4AMicrophoneListener *expected = listener;
+        slot.compare_exchange_strong(expected, nullptr);
+    }
 
-    return result;
+    // A callback that started before the slot was cleared may still be writing to the listener.
+    // Callbacks that start after this point can't see it, so we only have to outlast the current one.
+    //
+    const uint32_t sequence = m_callbackSequence.load();
+    if (sequence % 2 == 1)
+    {
+        while (m_callbackSequence.load() == sequence)
+        {
+            std::this_thread::yield();
+        }
+    }
 }
 
 void K4AMicrophone::ReadCallback(SoundIoInStream *inStream, const int frameCountMin, const int frameCountMax)
@@ -125,63 +165,53 @@ void K4AMicrophone::ReadCallback(SoundIoInStream *inStream, const int frameCount
 
     auto instance = reinterpret_cast<K4AMicrophone *>(inStream->userdata);
 
+    // Mark the callback as running for as long as it may touch listeners, on every return path.
+    // This is the only synchronization with the listeners' threads, the callback never takes a lock or allocates.
+    //
+    struct CallbackScope
+    {
+        explicit CallbackScope(std::atomic<uint32_t> *sequence) : Sequence(sequence)
+        {
+            Sequence->fetch_add(1);
+        }
+        ~CallbackScope()
+        {
+            Sequence->fetch_add(1);
+        }
+        std::atomic<uint32_t> *Sequence;
+    } callbackScope(&instance->m_callbackSequence);
+
     int maxFramesToWrite = 0;
 
-    // Grab references to all the listeners and figure out how many frames we're going to read
+    // Grab all the listeners and figure out how many frames we're going to read
     //
     struct ListenerInfo
     {
-        std::shared_ptr<K4AMicrophoneListener> Listener = nullptr;
+        K4AMicrophoneListener *Listener = nullptr;
         int FramesToWrite = 0;
         int FramesWritten = 0;
-        char *WritePtr = nullptr;
+        size_t FramesDropped = 0;
     };
 
-    std::vector<ListenerInfo> listenerInfo;
+    std::array<ListenerInfo, MaxListeners> listenerInfo;
+    size_t listenerCount = 0;
 
-    // We don't need the lock on the listeners for the whole function, so create a scope that just
-    // lasts as long as we need the lock
+    for (std::atomic<K4AMicrophoneListener *> &slot : instance->m_listeners)
     {
-        std::lock_guard<std::mutex> lock(instance->m_listenersMutex);
-        listenerInfo.reserve(instance->m_listeners.size());
-
-        bool expiredReferencesFound = false;
-
-        for (std::weak_ptr<K4AMicrophoneListener> &wpListener : instance->m_listeners)
+        K4AMicrophoneListener *listener = slot.load();
+        if (listener == nullptr)
         {
-            std::shared_ptr<K4AMicrophoneListener> spListener = wpListener.lock();
-            if (spListener)
-            {
-                const int bufferFreeBytes = soundio_ring_buffer_free_count(spListener->m_buffer.get());
-                const int bufferFreeFrames = bufferFreeBytes / instance->m_inStream->bytes_per_frame;
-                const int totalFramesToWrite = std::min(bufferFreeFrames, frameCountMax);
-
-                ListenerInfo newListener;
-                newListener.Listener = std::move(spListener);
-                newListener.FramesToWrite = totalFramesToWrite;
-                newListener.FramesWritten = 0;
-                newListener.WritePtr = soundio_ring_buffer_write_ptr(newListener.Listener->m_buffer.get());
-                listenerInfo.emplace_back(std::move(newListener));
-
-                maxFramesToWrite = std::max(totalFramesToWrite, maxFramesToWrite);
-            }
-            else
-            {
-                expiredReferencesFound = true;
-            }
+            continue;
         }
 
-        // Clean up listeners that have been destroyed
-        //
-        if (expiredReferencesFound)
-        {
-            const auto isExpired = [](const std::weak_ptr<K4AMicrophoneListener> &wp) { return wp.expired(); };
+        const size_t bufferFreeFrames = std::min(listener->m_buffer->FreeCount(), static_cast<size_t>(INT_MAX));
+        const int totalFramesToWrite = std::min(static_cast<int>(bufferFreeFrames), frameCountMax);
 
-            instance->m_listeners.erase(std::remove_if(instance->m_listeners.begin(),
-                                                       instance->m_listeners.end(),
-                                                       isExpired),
-                                        instance->m_listeners.end());
-        }
+        ListenerInfo &newListener = listenerInfo[listenerCount++];
+        newListener.Listener = listener;
+        newListener.FramesToWrite = totalFramesToWrite;
+
+        maxFramesToWrite = std::max(totalFramesToWrite, maxFramesToWrite);
     }
 
     if (frameCountMin > maxFramesToWrite)
@@ -192,10 +222,12 @@ void K4AMicrophone::ReadCallback(SoundIoInStream *inStream, const int frameCount
         return;
     }
 
+    const int channelCount = std::min(instance->m_inStream->layout.channel_count,
+                                      static_cast<int>(K4AMicrophoneFrame::ChannelCount));
+
     // Actually read audio data
     //
     int remainingFramesToWrite = maxFramesToWrite;
-    int maxFramesWritten = 0;
     while (true)
     {
         int readFrameCount = remainingFramesToWrite;
@@ -215,45 +247,37 @@ void K4AMicrophone::ReadCallback(SoundIoInStream *inStream, const int frameCount
 
         // Distribute audio data to each listener
         //
-        for (ListenerInfo &listener : listenerInfo)
+        for (size_t i = 0; i < listenerCount; i++)
         {
+            ListenerInfo &listener = listenerInfo[i];
+            K4ASpscRingBuffer<K4AMicrophoneFrame> &buffer = *listener.Listener->m_buffer;
             const int framesToWriteForListener = std::min(readFrameCount, listener.FramesToWrite);
 
-            if (framesToWriteForListener < readFrameCount)
+            for (int frame = 0; frame < framesToWriteForListener; ++frame)
             {
-                // This listener has run out of space in its buffer and is going to lose data.
-                //
-                listener.Listener->m_overflowed = true;
-            }
+                K4AMicrophoneFrame *target = buffer.WriteItem(static_cast<size_t>(listener.FramesWritten + frame));
+                if (areas == nullptr)
+                {
+                    // There is a hole in the buffer; we need to fill it with silence.
+                    // This can happen if the microphone is muted by the OS.
+                    //
+                    memset(target, 0, sizeof(K4AMicrophoneFrame));
+                    continue;
+                }
 
-            if (areas == nullptr)
-            {
-                // There is a hole in the buffer; we need to fill it with silence.
-                // This can happen if the microphone is muted by the OS.
-                //
-                memset(listener.WritePtr,
-                       0,
-                       static_cast<size_t>(readFrameCount * instance->m_inStream->bytes_per_frame));
-            }
-            else
-            {
-                for (int frame = 0; frame < readFrameCount; ++frame)
+                for (int channel = 0; channel < channelCount; channel++)
                 {
-                    for (int channel = 0; channel < instance->m_inStream->layout.channel_count; channel++)
-                    {
-                        memcpy(listener.WritePtr,
-                               areas[channel].ptr,
-                               static_cast<size_t>(instance->m_inStream->bytes_per_sample));
-                        areas[channel].ptr += areas[channel].step;
-                        listener.WritePtr += instance->m_inStream->bytes_per_sample;
-                    }
+                    memcpy(&target->Channel[channel],
+                           areas[channel].ptr + frame * areas[channel].step,
+                           sizeof(target->Channel[channel]));
                 }
             }
 
+            // This listener has run out of space in its buffer and is losing data.
+            //
+            listener.FramesDropped += static_cast<size_t>(readFrameCount - framesToWriteForListener);
             listener.FramesToWrite -= framesToWriteForListener;
             listener.FramesWritten += framesToWriteForListener;
-
-            maxFramesWritten = std::max(listener.FramesWritten, maxFramesWritten);
         }
 
         err = soundio_instream_end_read(instance->m_inStream.get());
@@ -270,16 +294,16 @@ void K4AMicrophone::ReadCallback(SoundIoInStream *inStream, const int frameCount
         }
     }
 
-    for (ListenerInfo &listener : listenerInfo)
+    for (size_t i = 0; i < listenerCount; i++)
     {
-        const int bytesWritten = listener.FramesWritten * instance->m_inStream->bytes_per_frame;
-        soundio_ring_buffer_advance_write_ptr(listener.Listener->m_buffer.get(), bytesWritten);
+        ListenerInfo &listener = listenerInfo[i];
+        listener.Listener->m_buffer->CommitWrite(static_cast<size_t>(listener.FramesWritten));
 
         // This listener fell behind and lost some data; notify it that this happened
         //
-        if (listener.FramesWritten < maxFramesWritten)
+        if (listener.FramesDropped > 0)
         {
-            listener.Listener->m_overflowed = true;
+            listener.Listener->AddDroppedFrames(listener.FramesDropped);
         }
     }
 }
@@ -6,9 +6,9 @@
 
 // System headers
 //
+#include <array>
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <vector>
 
 // Library headers
 //
@@ -21,6 +21,9 @@ namespace k4aviewer
 {
 class K4AMicrophoneListener;
 
+// Captures audio from the microphone array of an Azure Kinect device and hands it to listeners.
+// This has no dependency on the rest of the viewer and is built as the k4amicrophone library.
+//
 class K4AMicrophone : public std::enable_shared_from_this<K4AMicrophone>
 {
 public:
@@ -47,8 +50,13 @@ public:
         return m_started;
     }
 
+    // Returns nullptr if the microphone isn't started, if memory runs out, or if there are already
+    // MaxListeners listeners.
+    //
     std::shared_ptr<K4AMicrophoneListener> CreateListener();
 
+    static constexpr size_t MaxListeners = 8;
+
     K4AMicrophone(const K4AMicrophone &) = delete;
     K4AMicrophone(const K4AMicrophone &&) = delete;
     K4AMicrophone &operator=(const K4AMicrophone &) = delete;
@@ -58,10 +66,15 @@ public:
 
 private:
     friend class K4AAudioManager;
+    friend class K4AMicrophoneListener;
     explicit K4AMicrophone(std::shared_ptr<SoundIoDevice> device);
 
     void SetFailed(int errorCode);
 
+    // Unregisters a listener and waits until the capture callback no longer uses it
+    //
+    void RemoveListener(K4AMicrophoneListener *listener);
+
     // These are callbacks that we give to libsoundio.
     // inStream->userdata is a void* that will point to a K4AMicrophone instance.
     //
@@ -69,13 +82,19 @@ private:
     static void ErrorCallback(SoundIoInStream *inStream, int errorCode);
     static void OverflowCallback(SoundIoInStream *inStream);
 
-    std::mutex m_listenersMutex;
-    std::vector<std::weak_ptr<K4AMicrophoneListener>> m_listeners;
+    // The capture callback reads these slots without taking a lock.  Listeners own themselves; they fill a slot
+    // when created and empty it when destroyed.
+    //
+    std::array<std::atomic<K4AMicrophoneListener *>, MaxListeners> m_listeners;
+
+    // Incremented when the capture callback starts and when it returns, so it is odd while the callback runs
+    //
+    std::atomic<uint32_t> m_callbackSequence{ 0 };
 
     SoundIoInStreamUniquePtr m_inStream = nullptr;
     std::shared_ptr<SoundIoDevice> m_device = nullptr;
-    bool m_started = false;
-    int m_statusCode = SoundIoErrorNone;
+    std::atomic<bool> m_started{ false };
+    std::atomic<int> m_statusCode{ SoundIoErrorNone };
 };
 } // namespace k4aviewer
 
@@ -7,7 +7,7 @@
 
 // System headers
 //
-#include <regex>
+#include <new>
 
 // Library headers
 //
@@ -30,36 +30,55 @@ size_t K4AMicrophoneListener::ProcessFrames(const std::function<size_t(K4AMicrop
         // we need to recreate the microphone listener.  Clear out everything.
         //
         m_statusCode = m_backingDevice->GetStatusCode();
+        m_backingDevice->RemoveListener(this);
         m_buffer.reset();
         m_backingDevice.reset();
         return 0;
     }
 
-    const auto readableBytes = static_cast<size_t>(soundio_ring_buffer_fill_count(m_buffer.get()));
-    const size_t readableFrames = readableBytes / sizeof(K4AMicrophoneFrame);
-
-    if (readableFrames == 0)
+    // The readable frames are in at most two contiguous runs, one up to the end of the buffer
+    // and one from its start.
+    //
+    size_t readFrames = 0;
+    for (int run = 0; run < 2; ++run)
     {
-        return 0;
-    }
+        size_t readableFrames = 0;
+        K4AMicrophoneFrame *frameReadPoint = m_buffer->ReadItems(&readableFrames);
+        if (readableFrames == 0)
+        {
+            break;
+        }
 
-    char *readPoint = soundio_ring_buffer_read_ptr(m_buffer.get());
-    auto *frameReadPoint = reinterpret_cast<K4AMicrophoneFrame *>(readPoint);
+        const size_t processedFrames = processor(frameReadPoint, readableFrames);
+        m_buffer->CommitRead(processedFrames);
+        readFrames += processedFrames;
 
-    const size_t readFrames = processor(frameReadPoint, readableFrames);
-    const size_t readBytes = readFrames * sizeof(K4AMicrophoneFrame);
-
-    soundio_ring_buffer_advance_read_ptr(m_buffer.get(), static_cast<int>(readBytes));
+        if (processedFrames < readableFrames)
+        {
+            break;
+        }
+    }
 
     return readFrames;
 }
 
-K4AMicrophoneListener::K4AMicrophoneListener(std::shared_ptr<K4AMicrophone> backingDevice, const size_t bufferSize) :
+K4AMicrophoneListener::K4AMicrophoneListener(std::shared_ptr<K4AMicrophone> backingDevice,
+                                             const size_t bufferFrameCount) :
     m_backingDevice(std::move(backingDevice))
 {
-    m_buffer.reset(soundio_ring_buffer_create(nullptr, static_cast<int>(bufferSize)));
-    if (m_buffer)
+    m_buffer.reset(new (std::nothrow) K4ASpscRingBuffer<K4AMicrophoneFrame>(bufferFrameCount));
+    if (m_buffer && !m_buffer->IsValid())
+    {
+        m_buffer.reset();
+    }
+}
+
+K4AMicrophoneListener::~K4AMicrophoneListener()
+{
+    // The capture callback may still be writing to our buffer; this waits for it to let go of us.
+    //
+    if (m_backingDevice)
     {
-        memset(soundio_ring_buffer_write_ptr(m_buffer.get()), 0, bufferSize);
+        m_backingDevice->RemoveListener(this);
     }
 }
@@ -6,6 +6,7 @@
 
 // System headers
 //
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -16,6 +17,7 @@
 // Project headers
 //
 #include "k4amicrophone.h"
+#include "k4aspscringbuffer.h"
 
 namespace k4aviewer
 {
@@ -28,6 +30,10 @@ struct K4AMicrophoneFrame
     float Channel[ChannelCount];
 };
 
+// Receives the frames captured by a K4AMicrophone.  Each listener has its own lock-free ring buffer that the
+// microphone's capture callback writes to and the listener's owner reads from, so a slow reader only loses its own
+// data and never stalls the audio thread.
+//
 class K4AMicrophoneListener
 {
 public:
@@ -35,6 +41,9 @@ public:
     // the number of frames that it processed (i.e. wants removed from the buffer).  It must return a number
     // that is <= the number of frames it received.
     //
+    // When the buffered frames wrap around the end of the ring buffer, processor is called a second time
+    // with the frames at the start of the buffer, provided it consumed all the frames of the first call.
+    //
     size_t ProcessFrames(const std::function<size_t(K4AMicrophoneFrame *, size_t)> &processor);
 
     int GetStatus() const
@@ -42,17 +51,33 @@ public:
         return m_statusCode;
     }
 
+    // True if frames were dropped since the last call to ClearOverflowed()
+    //
     bool Overflowed() const
     {
-        return m_overflowed;
+        return m_droppedFrameCount.load(std::memory_order_relaxed) != m_clearedDroppedFrameCount;
     }
 
     void ClearOverflowed()
     {
-        m_overflowed = false;
+        m_clearedDroppedFrameCount = m_droppedFrameCount.load(std::memory_order_relaxed);
+    }
+
+    // Number of frames dropped because the ring buffer was full, since the listener was created
+    //
+    uint64_t GetDroppedFrameCount() const
+    {
+        return m_droppedFrameCount.load(std::memory_order_relaxed);
+    }
+
+    // Number of capture callbacks that dropped frames, since the listener was created
+    //
+    uint64_t GetOverflowCount() const
+    {
+        return m_overflowCount.load(std::memory_order_relaxed);
     }
 
-    ~K4AMicrophoneListener() = default;
+    ~K4AMicrophoneListener();
 
     K4AMicrophoneListener(const K4AMicrophoneListener &) = delete;
     K4AMicrophoneListener(const K4AMicrophoneListener &&) = delete;
@@ -62,12 +87,23 @@ public:
 private:
     friend class K4AMicrophone;
 
-    K4AMicrophoneListener(std::shared_ptr<K4AMicrophone> backingDevice, size_t bufferSize);
+    K4AMicrophoneListener(std::shared_ptr<K4AMicrophone> backingDevice, size_t bufferFrameCount);
+
+    // Called from the capture callback
+    //
+    void AddDroppedFrames(size_t frameCount)
+    {
+        m_droppedFrameCount.fetch_add(frameCount, std::memory_order_relaxed);
+        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    SoundIoRingBufferUniquePtr m_buffer;
+    std::unique_ptr<K4ASpscRingBuffer<K4AMicrophoneFrame>> m_buffer;
     std::shared_ptr<K4AMicrophone> m_backingDevice;
     int m_statusCode = SoundIoErrorNone;
-    bool m_overflowed = false;
+
+    std::atomic<uint64_t> m_droppedFrameCount{ 0 };
+    std::atomic<uint64_t> m_overflowCount{ 0 };
+    uint64_t m_clearedDroppedFrameCount = 0;
 };
 } // namespace k4aviewer
 
@@ -6,9 +6,8 @@
 
 // System headers
 //
-#include <array>
+#include <atomic>
 #include <memory>
-#include <mutex>
 
 // Library headers
 //
@@ -18,15 +17,21 @@
 //
 #include "ik4aobserver.h"
 #include "k4aimageextractor.h"
+#include "k4alatestvalueslot.h"
 
 namespace k4aviewer
 {
+// Hands the most recent capture from the polling thread to a window.  The polling thread only swaps the
+// capture into a slot, so a slow window never holds it up; captures the window doesn't get to are dropped.
+//
 class K4ANonBufferingCaptureSource : public IK4ACaptureObserver
 {
 public:
+    // Must only be called from the thread of the window that reads the captures
+    //
     inline k4a::capture GetLastCapture()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        Update();
         return m_lastCapture;
     }
 
@@ -35,24 +40,26 @@ public:
         return m_failed;
     }
 
-    bool HasData() const
+    // Must only be called from the thread of the window that reads the captures
+    //
+    bool HasData()
     {
+        Update();
         return m_lastCapture != nullptr;
     }
 
     void NotifyData(const k4a::capture &capture) override
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         if (capture)
         {
-            m_lastCapture = capture;
+            m_pendingCapture.Put(capture);
         }
     }
 
     void ClearData() override
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_lastCapture.reset();
+        m_pendingCapture.Clear();
+        m_clearRequested = true;
     }
 
     void NotifyTermination() override
@@ -69,11 +76,29 @@ public:
     K4ANonBufferingCaptureSource &operator=(K4ANonBufferingCaptureSource &&) = delete;
 
 private:
-    k4a::capture m_lastCapture;
+    // The window keeps showing its last capture until a newer one arrives, so that one is cached on the
+    // window's side rather than left in the slot
+    //
+    void Update()
+    {
+        if (m_clearRequested.exchange(false))
+        {
+            m_lastCapture.reset();
+        }
 
-    bool m_failed = false;
+        k4a::capture newCapture = m_pendingCapture.Take();
+        if (newCapture)
+        {
+            m_lastCapture = std::move(newCapture);
+        }
+    }
+
+    K4ALatestValueSlot<k4a::capture> m_pendingCapture;
+    std::atomic<bool> m_clearRequested{ false };
+
+    k4a::capture m_lastCapture;
 
-    std::mutex m_mutex;
+    std::atomic<bool> m_failed{ false };
 };
 
 } // namespace k4aviewer
@@ -0,0 +1,376 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Associated header
+//
+#include "k4aplaybackprefetcher.h"
+
+// System headers
+//
+#include <iterator>
+
+// Library headers
+//
+
+// Project headers
+//
+
+using namespace k4aviewer;
+
+namespace
+{
+// Enough frames behind the playback position to step back through without waiting, and enough ahead to keep
+// playing through a slow read (e.g. an MJPEG color track being converted to BGRA for the point cloud viewer)
+//
+constexpr int64_t FramesBehind = 15;
+constexpr int64_t FramesAhead = 45;
+
+// Upper bound on the memory held by prefetched captures, so high-resolution recordings converted to BGRA
+// don't keep gigabytes alive.  Captures up to the playback position are always read.
+//
+constexpr size_t MaxCachedBytes = 512 * 1024 * 1024;
+
+size_t GetCaptureSize(const k4a::capture &capture)
+{
+    size_t size = 0;
+    const k4a::image images[] = { capture.get_color_image(), capture.get_depth_image(), capture.get_ir_image() };
+    for (const k4a::image &image : images)
+    {
+        if (image)
+        {
+            size += image.get_size();
+        }
+    }
+    return size;
+}
+} // namespace
+
+K4APlaybackPrefetcher::K4APlaybackPrefetcher(k4a::playback *recording,
+                                             std::chrono::microseconds timePerFrame,
+                                             std::chrono::microseconds startTimestamp) :
+    m_recording(recording),
+    m_framesBehindUsec(timePerFrame.count() * FramesBehind),
+    m_framesAheadUsec(timePerFrame.count() * FramesAhead),
+    m_startTimestamp(startTimestamp.count()),
+    m_position(startTimestamp.count())
+{
+}
+
+K4APlaybackPrefetcher::~K4APlaybackPrefetcher()
+{
+    Stop();
+}
+
+void K4APlaybackPrefetcher::Start()
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shouldExit = false;
+    m_failed = false;
+    m_rangeValid = false;
+
+    try
+    {
+        m_cursor = m_recording->create_cursor();
+    }
+    catch (const k4a::error &)
+    {
+        // Reads throw, which shows the failure to the user
+        //
+        m_failed = true;
+        return;
+    }
+
+    m_thread = std::thread(&K4APlaybackPrefetcher::PrefetchThread, this);
+}
+
+void K4APlaybackPrefetcher::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shouldExit = true;
+    }
+    m_positionChanged.notify_all();
+    m_captureLoaded.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clear();
+    m_rangeValid = false;
+    m_cursor.reset();
+}
+
+void K4APlaybackPrefetcher::SetPosition(std::chrono::microseconds timestamp)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_position = timestamp.count();
+    }
+    m_positionChanged.notify_all();
+}
+
+K4APlaybackPrefetcher::ReadResult K4APlaybackPrefetcher::GetCaptureAt(std::chrono::microseconds timestamp,
+                                                                      k4a::capture *capture)
+{
+    return Read(timestamp, Direction::AtOrAfter, capture);
+}
+
+K4APlaybackPrefetcher::ReadResult K4APlaybackPrefetcher::GetNextCapture(std::chrono::microseconds timestamp,
+                                                                        k4a::capture *capture)
+{
+    return Read(timestamp, Direction::After, capture);
+}
+
+K4APlaybackPrefetcher::ReadResult K4APlaybackPrefetcher::GetPreviousCapture(std::chrono::microseconds timestamp,
+                                                                            k4a::capture *capture)
+{
+    return Read(timestamp, Direction::Before, capture);
+}
+
+K4APlaybackPrefetcher::ReadResult
+K4APlaybackPrefetcher::Read(std::chrono::microseconds timestamp, Direction direction, k4a::capture *capture)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_position != timestamp.count())
+    {
+        m_position = timestamp.count();
+        m_positionChanged.notify_all();
+    }
+
+    LookupResult result = LookupResult::NotLoaded;
+    m_captureLoaded.wait(lock, [&]() {
+        if (m_failed || m_shouldExit)
+        {
+            return true;
+        }
+        result = Lookup(timestamp.count(), direction, capture);
+        return result != LookupResult::NotLoaded;
+    });
+
+    if (m_failed)
+    {
+        throw k4a::error("Failed to read recording!");
+    }
+    if (m_shouldExit)
+    {
+        return ReadResult::Stopped;
+    }
+
+    return result == LookupResult::Found ? ReadResult::Succeeded : ReadResult::EndOfRecording;
+}
+
+K4APlaybackPrefetcher::LookupResult
+K4APlaybackPrefetcher::Lookup(int64_t timestamp, Direction direction, k4a::capture *capture) const
+{
+    // We can only tell what's around a timestamp if we've read the recording from before it
+    //
+    if (!m_rangeValid || (timestamp < m_rangeStart && !m_reachedBegin))
+    {
+        return LookupResult::NotLoaded;
+    }
+
+    if (direction == Direction::Before)
+    {
+        auto it = m_captures.lower_bound(timestamp);
+        if (it == m_captures.end() && !m_reachedEnd)
+        {
+            // There may be captures between the last one we've read and timestamp
+            //
+            return LookupResult::NotLoaded;
+        }
+        if (it == m_captures.begin())
+        {
+            return m_reachedBegin ? LookupResult::EndOfRecording : LookupResult::NotLoaded;
+        }
+
+        *capture = std::prev(it)->second;
+        return LookupResult::Found;
+    }
+
+    auto it = direction == Direction::After ? m_captures.upper_bound(timestamp) : m_captures.lower_bound(timestamp);
+    if (it == m_captures.end())
+    {
+        return m_reachedEnd ? LookupResult::EndOfRecording : LookupResult::NotLoaded;
+    }
+
+    *capture = it->second;
+    return LookupResult::Found;
+}
+
+bool K4APlaybackPrefetcher::IsWithinReach(int64_t timestamp) const
+{
+    if (!m_rangeValid)
+    {
+        return false;
+    }
+
+    // Captures before the range would need a seek, and so would captures far enough past the last one we read
+    // that reading up to them takes longer than seeking
+    //
+    if (timestamp < m_rangeStart && !m_reachedBegin)
+    {
+        return false;
+    }
+
+    const int64_t lastTimestamp = m_captures.empty() ? m_rangeStart : m_captures.rbegin()->first;
+    return m_reachedEnd || timestamp - lastTimestamp <= m_framesAheadUsec;
+}
+
+void K4APlaybackPrefetcher::Evict()
+{
+    // Drop captures that fell too far behind the playback position, then the oldest of the rest if we're over
+    // the memory budget.  Captures from the playback position on are kept so reads can be answered.
+    //
+    const int64_t keepFrom = m_position - m_framesBehindUsec;
+    while (!m_captures.empty())
+    {
+        auto oldest = m_captures.begin();
+        if (oldest->first >= keepFrom && (m_cachedBytes <= MaxCachedBytes || oldest->first >= m_position))
+        {
+            break;
+        }
+
+        m_cachedBytes -= GetCaptureSize(oldest->second);
+        m_rangeStart = oldest->first + 1;
+        m_reachedBegin = false;
+        m_captures.erase(oldest);
+    }
+}
+
+void K4APlaybackPrefetcher::Clear()
+{
+    m_captures.clear();
+    m_cachedBytes = 0;
+}
+
+void K4APlaybackPrefetcher::PrefetchThread(K4APlaybackPrefetcher *prefetcher)
+{
+    std::unique_lock<std::mutex> lock(prefetcher->m_mutex);
+    try
+    {
+        while (!prefetcher->m_shouldExit)
+        {
+            const int64_t position = prefetcher->m_position;
+
+            if (!prefetcher->IsWithinReach(position))
+            {
+                // Start a new range a bit behind the position so the user can step back from it
+                //
+                prefetcher->Clear();
+                const int64_t rangeStart = position - prefetcher->m_framesBehindUsec;
+
+                lock.unlock();
+                prefetcher->m_cursor.seek_timestamp(std::chrono::microseconds(rangeStart),
+                                                    K4A_PLAYBACK_SEEK_DEVICE_TIME);
+                lock.lock();
+
+                prefetcher->m_rangeValid = true;
+                prefetcher->m_rangeStart = rangeStart;
+                prefetcher->m_reachedBegin = rangeStart <= prefetcher->m_startTimestamp;
+                prefetcher->m_reachedEnd = false;
+                continue;
+            }
+
+            prefetcher->Evict();
+
+            const bool needsPosition = prefetcher->m_captures.empty() ||
+                                       prefetcher->m_captures.rbegin()->first <= position;
+            const bool wantsReadAhead = !prefetcher->m_captures.empty() &&
+                                        prefetcher->m_captures.rbegin()->first <
+                                            position + prefetcher->m_framesAheadUsec &&
+                                        prefetcher->m_cachedBytes < MaxCachedBytes;
+
+            if (prefetcher->m_reachedEnd || (!needsPosition && !wantsReadAhead))
+            {
+                prefetcher->m_positionChanged.wait(lock, [prefetcher, position]() {
+                    return prefetcher->m_shouldExit || prefetcher->m_position != position;
+                });
+                continue;
+            }
+
+            lock.unlock();
+            k4a::capture capture;
+            const bool readSucceeded = prefetcher->m_cursor.get_next_capture(&capture);
+            if (readSucceeded)
+            {
+                // Show the timing data embedded in the recording as the timestamp so synchronized recordings
+                // show comparable timestamps.  This is done before the capture is shared with other threads.
+                //
+                k4a::image images[] = { capture.get_color_image(), capture.get_depth_image(), capture.get_ir_image() };
+                for (k4a::image &image : images)
+                {
+                    if (image)
+                    {
+                        image.set_timestamp(image.get_device_timestamp());
+                    }
+                }
+            }
+            lock.lock();
+
+            if (readSucceeded)
+            {
+                const int64_t timestamp = GetCaptureTimestamp(capture).count();
+                if (prefetcher->m_captures.empty() || timestamp > prefetcher->m_captures.rbegin()->first)
+                {
+                    prefetcher->m_cachedBytes += GetCaptureSize(capture);
+                    prefetcher->m_captures.emplace(timestamp, std::move(capture));
+                }
+            }
+            else
+            {
+                prefetcher->m_reachedEnd = true;
+            }
+
+            prefetcher->m_captureLoaded.notify_all();
+        }
+    }
+    catch (const k4a::error &)
+    {
+        if (!lock.owns_lock())
+        {
+            lock.lock();
+        }
+        prefetcher->m_failed = true;
+        prefetcher->m_captureLoaded.notify_all();
+    }
+}
+
+std::chrono::microseconds K4APlaybackPrefetcher::GetCaptureTimestamp(const k4a::capture &capture)
+{
+    // Captures don't actually have timestamps, images do, so we have to look at all the images
+    // associated with the capture.  We only need an approximate timestamp for seeking, so we just
+    // return the first one we get back (we don't have to care if a capture has multiple images but
+    // the timestamps are slightly off).
+    //
+    // We check the IR capture instead of the depth capture because if the depth camera is started
+    // in passive IR mode, it only has an IR image (i.e. no depth image), but there is no mode
+    // where a capture will have a depth image but not an IR image.
+    //
+    const auto irImage = capture.get_ir_image();
+    if (irImage != nullptr)
+    {
+        return irImage.get_device_timestamp();
+    }
+
+    const auto depthImage = capture.get_depth_image();
+    if (depthImage != nullptr)
+    {
+        return depthImage.get_device_timestamp();
+    }
+
+    const auto colorImage = capture.get_color_image();
+    if (colorImage != nullptr)
+    {
+        return colorImage.get_device_timestamp();
+    }
+
+    return std::chrono::microseconds::zero();
+}
@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef K4APLAYBACKPREFETCHER_H
+#define K4APLAYBACKPREFETCHER_H
+
+// System headers
+//
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Library headers
+//
+#include <k4arecord/playback.hpp>
+
+// Project headers
+//
+
+namespace k4aviewer
+{
+
+// Keeps a window of captures around the playback position in memory, read ahead of time through a cursor
+// of the recording on a background thread, so playing, stepping and scrubbing the timeline don't have to
+// wait for the recording to be read.
+//
+// Timestamps are device timestamps as returned by GetCaptureTimestamp().
+//
+class K4APlaybackPrefetcher
+{
+public:
+    enum class ReadResult
+    {
+        Succeeded,
+        EndOfRecording,
+        Stopped
+    };
+
+    // recording must outlive the prefetcher.  startTimestamp is the device timestamp of the start of the
+    // recording, i.e. its start_timestamp_offset_usec.
+    //
+    K4APlaybackPrefetcher(k4a::playback *recording,
+                          std::chrono::microseconds timePerFrame,
+                          std::chrono::microseconds startTimestamp);
+    ~K4APlaybackPrefetcher();
+
+    // Starts and stops the background thread.  Settings of the recording that apply to its cursors, like
+    // the color conversion, must only be changed while the prefetcher is stopped.  Stopping drops every
+    // prefetched capture and makes pending reads return ReadResult::Stopped.
+    //
+    void Start();
+    void Stop();
+
+    // Moves the window of prefetched captures, e.g. while the user drags the timeline.  Reads move it too.
+    //
+    void SetPosition(std::chrono::microseconds timestamp);
+
+    // Read the first capture at or after timestamp, the first capture after it and the last capture before
+    // it.  They return right away if the capture is prefetched and otherwise wait for the background
+    // thread to read it.  Throws k4a::error if the recording couldn't be read.
+    //
+    ReadResult GetCaptureAt(std::chrono::microseconds timestamp, k4a::capture *capture);
+    ReadResult GetNextCapture(std::chrono::microseconds timestamp, k4a::capture *capture);
+    ReadResult GetPreviousCapture(std::chrono::microseconds timestamp, k4a::capture *capture);
+
+    // Captures don't actually have timestamps, images do, so this returns the timestamp of one of the images
+    //
+    static std::chrono::microseconds GetCaptureTimestamp(const k4a::capture &capture);
+
+    K4APlaybackPrefetcher(const K4APlaybackPrefetcher &) = delete;
+    K4APlaybackPrefetcher(const K4APlaybackPrefetcher &&) = delete;
+    K4APlaybackPrefetcher &operator=(const K4APlaybackPrefetcher &) = delete;
+    K4APlaybackPrefetcher &operator=(const K4APlaybackPrefetcher &&) = delete;
+
+private:
+    enum class LookupResult
+    {
+        Found,
+        EndOfRecording,
+        NotLoaded
+    };
+
+    enum class Direction
+    {
+        AtOrAfter,
+        After,
+        Before
+    };
+
+    ReadResult Read(std::chrono::microseconds timestamp, Direction direction, k4a::capture *capture);
+
+    // Must be called with m_mutex held
+    //
+    LookupResult Lookup(int64_t timestamp, Direction direction, k4a::capture *capture) const;
+    bool IsWithinReach(int64_t timestamp) const;
+    void Evict();
+    void Clear();
+
+    static void PrefetchThread(K4APlaybackPrefetcher *prefetcher);
+
+    k4a::playback *m_recording;
+    const int64_t m_framesBehindUsec;
+    const int64_t m_framesAheadUsec;
+    const int64_t m_startTimestamp;
+
+    k4a::playback_cursor m_cursor;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::condition_variable m_positionChanged;
+    std::condition_variable m_captureLoaded;
+
+    bool m_shouldExit = true;
+    bool m_failed = false;
+    int64_t m_position = 0;
+
+    // Every capture of the recording from m_rangeStart up to the last entry, read in order through m_cursor.
+    // m_reachedBegin means there are no captures before m_rangeStart and m_reachedEnd that there are none
+    // after the last entry.
+    //
+    std::map<int64_t, k4a::capture> m_captures;
+    size_t m_cachedBytes = 0;
+    bool m_rangeValid = false;
+    int64_t m_rangeStart = 0;
+    bool m_reachedBegin = false;
+    bool m_reachedEnd = false;
+};
+
+} // namespace k4aviewer
+
+#endif
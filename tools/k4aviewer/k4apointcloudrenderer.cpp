@@ -58,18 +58,19 @@ GLenum PointCloudRenderer::UpdatePointClouds(const k4a::image &color, const Open
 
     // Vertex Colors
     //
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexColorBufferObject.Id());
-
     const int colorImageSizeBytes = static_cast<int>(color.get_size());
 
-    if (m_vertexArraySizeBytes != colorImageSizeBytes)
+    if (m_vertexArraySizeBytes != colorImageSizeBytes || !m_vertexColorBuffer.IsInitialized())
     {
         m_vertexArraySizeBytes = colorImageSizeBytes;
-        glBufferData(GL_ARRAY_BUFFER, m_vertexArraySizeBytes, nullptr, GL_STREAM_DRAW);
+        const GLenum initStatus = m_vertexColorBuffer.Initialize(GL_ARRAY_BUFFER, m_vertexArraySizeBytes);
+        if (initStatus != GL_NO_ERROR)
+        {
+            return initStatus;
+        }
     }
 
-    GLubyte *vertexMappedBuffer = reinterpret_cast<GLubyte *>(
-        glMapBufferRange(GL_ARRAY_BUFFER, 0, colorImageSizeBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    GLubyte *vertexMappedBuffer = m_vertexColorBuffer.BeginWrite();
 
     if (!vertexMappedBuffer)
     {
@@ -78,13 +79,21 @@ GLenum PointCloudRenderer::UpdatePointClouds(const k4a::image &color, const Open
 
     const GLubyte *colorSrc = reinterpret_cast<const GLubyte *>(color.get_buffer());
     std::copy(colorSrc, colorSrc + colorImageSizeBytes, vertexMappedBuffer);
-    if (!glUnmapBuffer(GL_ARRAY_BUFFER))
+    const GLenum writeStatus = m_vertexColorBuffer.EndWrite();
+    if (writeStatus != GL_NO_ERROR)
     {
-        return glGetError();
+        return writeStatus;
     }
 
+    // Point the vertex array at the section we just wrote; Render() fences it after each draw
+    //
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, GL_BGRA, GL_UNSIGNED_BYTE, GL_TRUE, 0, 0);
+    glVertexAttribPointer(0,
+                          GL_BGRA,
+                          GL_UNSIGNED_BYTE,
+                          GL_TRUE,
+                          0,
+                          reinterpret_cast<const GLvoid *>(m_vertexColorBuffer.GetWriteOffset()));
 
     glUseProgram(m_shaderProgram.Id());
 
@@ -131,6 +140,13 @@ GLenum PointCloudRenderer::Render()
     glBindVertexArray(m_vertexArrayObject.Id());
     glDrawArrays(GL_POINTS, 0, m_vertexArraySizeBytes / static_cast<GLsizei>(sizeof(BgraPixel)));
 
+    // The colors may be drawn again next frame, so the section is only released once the latest draw is done
+    //
+    if (m_vertexColorBuffer.IsInitialized())
+    {
+        m_vertexColorBuffer.Fence();
+    }
+
     glBindVertexArray(0);
 
     return glGetError();
@@ -15,6 +15,7 @@
 
 // Project headers
 //
+#include "k4astreamingbuffer.h"
 #include "openglhelpers.h"
 
 namespace k4aviewer
@@ -60,7 +61,7 @@ private:
     GLint m_pointCloudTextureIndex;
 
     OpenGL::VertexArray m_vertexArrayObject = OpenGL::VertexArray(true);
-    OpenGL::Buffer m_vertexColorBufferObject = OpenGL::Buffer(true);
+    K4AStreamingBuffer m_vertexColorBuffer;
 };
 } // namespace k4aviewer
 #endif
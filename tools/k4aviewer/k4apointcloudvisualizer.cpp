@@ -190,10 +190,10 @@ K4APointCloudVisualizer::K4APointCloudVisualizer(const bool enableColorPointClou
 
     if (enableColorPointCloud)
     {
-        m_colorXyTable = m_pointCloudConverter.GenerateXyTable(m_calibrationData, K4A_CALIBRATION_TYPE_COLOR);
+        m_colorXyTable = m_transformation.get_xy_table(K4A_CALIBRATION_TYPE_COLOR);
     }
 
-    m_depthXyTable = m_pointCloudConverter.GenerateXyTable(m_calibrationData, K4A_CALIBRATION_TYPE_DEPTH);
+    m_depthXyTable = m_transformation.get_xy_table(K4A_CALIBRATION_TYPE_DEPTH);
 
     SetColorizationStrategy(m_colorizationStrategy);
 }
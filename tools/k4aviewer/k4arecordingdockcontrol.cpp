@@ -7,6 +7,7 @@
 
 // System headers
 //
+#include <algorithm>
 #include <memory>
 #include <ratio>
 #include <sstream>
@@ -28,6 +29,11 @@ namespace
 {
 static constexpr std::chrono::microseconds InvalidSeekTime = std::chrono::microseconds(-1);
 
+// Clusters of the recording kept in memory, so seeking back and forth near the playback position doesn't
+// read the file again
+//
+constexpr uint64_t PlaybackCacheSizeBytes = 256 * 1024 * 1024;
+
 std::string SafeGetTag(const k4a::playback &recording, const char *tagName)
 {
     std::string result;
@@ -92,9 +98,6 @@ K4ARecordingDockControl::K4ARecordingDockControl(std::string &&path, k4a::playba
     {
         colorFormatSS << m_recordConfiguration.color_format;
         colorResolutionSS << m_recordConfiguration.color_resolution;
-
-        recording.set_color_conversion(K4A_IMAGE_FORMAT_COLOR_BGRA32);
-        m_recordConfiguration.color_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
     }
     else
     {
@@ -123,7 +126,25 @@ K4ARecordingDockControl::K4ARecordingDockControl(std::string &&path, k4a::playba
     m_colorFirmwareVersion = SafeGetTag(recording, "K4A_COLOR_FIRMWARE_VERSION");
     m_depthFirmwareVersion = SafeGetTag(recording, "K4A_DEPTH_FIRMWARE_VERSION");
 
+    m_playbackThreadState.StartTimestamp = std::chrono::microseconds(m_startTimestampOffsetUsec);
+    m_playbackThreadState.CurrentCaptureTimestamp = m_playbackThreadState.StartTimestamp;
+
+    try
+    {
+        recording.set_cache_size(PlaybackCacheSizeBytes);
+    }
+    catch (const k4a::error &e)
+    {
+        // Playback still works, just with more disk reads
+        //
+        K4AViewerErrorManager::Instance().SetErrorStatus(e.what());
+    }
+
     m_playbackThreadState.Recording = std::move(recording);
+    m_playbackThreadState.Prefetcher = std14::make_unique<K4APlaybackPrefetcher>(&m_playbackThreadState.Recording,
+                                                                                 m_playbackThreadState.TimePerFrame,
+                                                                                 m_playbackThreadState.StartTimestamp);
+
     PlaybackThreadState *pThreadState = &m_playbackThreadState;
     m_playbackThread = std14::make_unique<K4APollingThread>(
         [pThreadState](bool) { return PlaybackThreadFn(pThreadState); });
@@ -131,6 +152,14 @@ K4ARecordingDockControl::K4ARecordingDockControl(std::string &&path, k4a::playba
     SetViewType(K4AWindowSet::ViewType::Normal);
 }
 
+K4ARecordingDockControl::~K4ARecordingDockControl()
+{
+    // Stop the prefetcher first so the playback thread isn't left waiting on a capture when we join it
+    //
+    m_playbackThreadState.Prefetcher->Stop();
+    m_playbackThread.reset();
+}
+
 K4ADockControlStatus K4ARecordingDockControl::Show()
 {
     ImGui::TextUnformatted(m_filenameLabel.c_str());
@@ -180,6 +209,8 @@ K4ADockControlStatus K4ARecordingDockControl::Show()
     }
     ImGui::SameLine();
 
+    // The slider shows the time since the start of the recording
+    //
     const uint64_t seekMin = 0;
     const uint64_t seekMax = m_recordingLengthUsec;
 
@@ -187,14 +218,23 @@ K4ADockControlStatus K4ARecordingDockControl::Show()
     bool paused;
     {
         std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
-        currentTimestampUs = static_cast<uint64_t>(m_playbackThreadState.CurrentCaptureTimestamp.count());
+        const std::chrono::microseconds sinceStart = m_playbackThreadState.CurrentCaptureTimestamp -
+                                                     m_playbackThreadState.StartTimestamp;
+        currentTimestampUs = static_cast<uint64_t>(std::max(sinceStart.count(), int64_t(0)));
         paused = m_playbackThreadState.Paused;
     }
 
     if (ImGui::SliderScalar("##seek", ImGuiDataType_U64, &currentTimestampUs, &seekMin, &seekMax, ""))
     {
+        const std::chrono::microseconds seekTimestamp = m_playbackThreadState.StartTimestamp +
+                                                        std::chrono::microseconds(currentTimestampUs);
+
+        // Start prefetching around the new position right away rather than when the playback thread gets to it
+        //
+        m_playbackThreadState.Prefetcher->SetPosition(seekTimestamp);
+
         std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
-        m_playbackThreadState.SeekTimestamp = std::chrono::microseconds(currentTimestampUs);
+        m_playbackThreadState.SeekTimestamp = seekTimestamp;
         m_playbackThreadState.Paused = true;
     }
     ImGui::SameLine();
@@ -209,8 +249,7 @@ K4ADockControlStatus K4ARecordingDockControl::Show()
     if (ImGui::Button("<<"))
     {
         std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
-        m_playbackThreadState.SeekTimestamp = std::chrono::microseconds(0);
-        m_playbackThreadState.Step = StepDirection::Forward;
+        m_playbackThreadState.SeekTimestamp = m_playbackThreadState.StartTimestamp;
         m_playbackThreadState.Paused = true;
     }
     ImGui::SameLine();
@@ -223,8 +262,8 @@ K4ADockControlStatus K4ARecordingDockControl::Show()
     if (ImGui::Button(">>"))
     {
         std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
-        m_playbackThreadState.SeekTimestamp = std::chrono::microseconds(m_recordingLengthUsec + 1);
-        m_playbackThreadState.Step = StepDirection::Forward;
+        m_playbackThreadState.SeekTimestamp = m_playbackThreadState.StartTimestamp +
+                                              std::chrono::microseconds(m_recordingLengthUsec + 1);
         m_playbackThreadState.Paused = true;
     }
 
@@ -241,27 +280,38 @@ bool K4ARecordingDockControl::PlaybackThreadFn(PlaybackThreadState *state)
     {
         std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
 
+        // Work out what to show next, then read it without holding the lock so the UI doesn't wait for the
+        // recording to be read
+        //
+        enum class ReadMode
+        {
+            At,
+            Next,
+            Previous
+        };
+
         std::unique_lock<std::mutex> lock(state->Mutex);
 
+        const uint32_t viewGeneration = state->ViewGeneration;
         bool forceRefreshImuData = false;
+        ReadMode readMode = ReadMode::Next;
+        std::chrono::microseconds readFrom = state->CurrentCaptureTimestamp;
         if (state->SeekTimestamp != InvalidSeekTime)
         {
             // We need to read back a few seconds from before the time we seeked to.
             //
             forceRefreshImuData = true;
 
-            state->Recording.seek_timestamp(state->SeekTimestamp, K4A_PLAYBACK_SEEK_BEGIN);
+            readMode = ReadMode::At;
+            readFrom = state->SeekTimestamp;
             state->SeekTimestamp = InvalidSeekTime;
-
-            // Force-read the next frame
-            //
-            state->Step = StepDirection::Forward;
+            state->Step = StepDirection::None;
+            state->RecordingAtEnd = false;
         }
-
-        bool backward = false;
-        if (state->Step != StepDirection::None)
+        else if (state->Step != StepDirection::None)
         {
-            backward = state->Step == StepDirection::Backward;
+            const bool backward = state->Step == StepDirection::Backward;
+            readMode = backward ? ReadMode::Previous : ReadMode::Next;
             state->Step = StepDirection::None;
 
             // Stepping backwards is closer to a seek - we can't just add
@@ -280,40 +330,77 @@ bool K4ARecordingDockControl::PlaybackThreadFn(PlaybackThreadState *state)
         {
             return true;
         }
-        else if (!state->Paused && state->RecordingAtEnd)
+        else if (state->RecordingAtEnd)
         {
             // Someone hit 'play' after the recording ended, so we need
             // to restart from the beginning
             //
-            state->Recording.seek_timestamp(std::chrono::microseconds(0), K4A_PLAYBACK_SEEK_BEGIN);
+            readMode = ReadMode::At;
+            readFrom = state->StartTimestamp;
             state->RecordingAtEnd = false;
             forceRefreshImuData = true;
         }
+        lock.unlock();
 
         k4a::capture nextCapture;
-        const bool seekSuccessful = backward ? state->Recording.get_previous_capture(&nextCapture) :
-                                               state->Recording.get_next_capture(&nextCapture);
-        if (!seekSuccessful)
+        K4APlaybackPrefetcher::ReadResult result;
+        switch (readMode)
         {
-            // We're at the end of the file.
-            //
-            state->RecordingAtEnd = true;
-            state->Paused = true;
+        case ReadMode::At:
+            result = state->Prefetcher->GetCaptureAt(readFrom, &nextCapture);
+            break;
+        case ReadMode::Previous:
+            result = state->Prefetcher->GetPreviousCapture(readFrom, &nextCapture);
+            break;
+        case ReadMode::Next:
+        default:
+            result = state->Prefetcher->GetNextCapture(readFrom, &nextCapture);
+            break;
+        }
 
+        const bool atEnd = result == K4APlaybackPrefetcher::ReadResult::EndOfRecording;
+        if (atEnd && readMode == ReadMode::At)
+        {
             // Attempt to show the last capture in the file.
             // We need to do this rather than just leaving the last-posted capture to handle
             // cases where we did a seek to EOF.
             //
-            const bool backseekSuccessful = state->Recording.get_previous_capture(&nextCapture);
-            if (!backseekSuccessful)
-            {
-                // Couldn't read back the last capture, so continue showing the last one
-                //
-                return true;
-            }
+            result = state->Prefetcher->GetPreviousCapture(readFrom, &nextCapture);
+        }
+
+        if (result == K4APlaybackPrefetcher::ReadResult::Stopped)
+        {
+            // The view is being changed; try again once the prefetcher restarts
+            //
+            std::this_thread::sleep_for(state->TimePerFrame);
+            return true;
+        }
+
+        lock.lock();
+
+        if (state->ViewGeneration != viewGeneration)
+        {
+            // The view changed while we were reading, so the capture may have the wrong color format
+            //
+            return true;
+        }
+
+        if (atEnd)
+        {
+            // We're at the end of the file (or stepped back past the start of it)
+            //
+            state->RecordingAtEnd = readMode != ReadMode::Previous;
+            state->Paused = true;
+        }
+
+        if (result != K4APlaybackPrefetcher::ReadResult::Succeeded)
+        {
+            // Couldn't read a capture to show, so continue showing the last one
+            //
+            return true;
         }
 
-        state->CurrentCaptureTimestamp = GetCaptureTimestamp(nextCapture);
+        state->CurrentCaptureTimestamp = K4APlaybackPrefetcher::GetCaptureTimestamp(nextCapture);
 
         // Read IMU data up to the next timestamp, if applicable
         //
@@ -328,6 +415,11 @@ bool K4ARecordingDockControl::PlaybackThreadFn(PlaybackThreadState *state)
                 {
                     state->ImuDataSource.ClearData();
 
+                    // Captures are read through the prefetcher, so the recording itself is only used for IMU
+                    // data and has to be moved to the capture we're showing
+                    //
+                    state->Recording.seek_timestamp(state->CurrentCaptureTimestamp, K4A_PLAYBACK_SEEK_DEVICE_TIME);
+
                     k4a_imu_sample_t sample;
 
                     // Seek to the first IMU sample that was before the camera frame we're trying to show
@@ -377,21 +469,9 @@ bool K4ARecordingDockControl::PlaybackThreadFn(PlaybackThreadState *state)
             }
         }
 
-        // Update the timestamps on the images using the timing data embedded in the recording
-        // so we show comparable timestamps when playing back synchronized recordings
+        // Handing captures to the windows doesn't block, so we can do it under the lock, which keeps captures
+        // read before a view change from reaching the new windows
         //
-        k4a::image images[] = { nextCapture.get_color_image(),
-                                nextCapture.get_depth_image(),
-                                nextCapture.get_ir_image() };
-
-        for (k4a::image &image : images)
-        {
-            if (image)
-            {
-                image.set_timestamp(image.get_device_timestamp());
-            }
-        }
-
         state->CaptureDataSource.NotifyObservers(nextCapture);
         lock.unlock();
 
@@ -415,43 +495,41 @@ bool K4ARecordingDockControl::PlaybackThreadFn(PlaybackThreadState *state)
     }
 }
 
-std::chrono::microseconds K4ARecordingDockControl::GetCaptureTimestamp(const k4a::capture &capture)
+void K4ARecordingDockControl::SetViewType(K4AWindowSet::ViewType viewType)
 {
-    // Captures don't actually have timestamps, images do, so we have to look at all the images
-    // associated with the capture.  We only need an approximate timestamp for seeking, so we just
-    // return the first one we get back (we don't have to care if a capture has multiple images but
-    // the timestamps are slightly off).
-    //
-    // We check the IR capture instead of the depth capture because if the depth camera is started
-    // in passive IR mode, it only has an IR image (i.e. no depth image), but there is no mode
-    // where a capture will have a depth image but not an IR image.
+    K4AWindowManager::Instance().ClearWindows();
+
+    // The color conversion can't change while the prefetcher reads the recording, and captures it already
+    // read have the old format
     //
-    const auto irImage = capture.get_ir_image();
-    if (irImage != nullptr)
-    {
-        return irImage.get_device_timestamp();
-    }
+    m_playbackThreadState.Prefetcher->Stop();
 
-    const auto depthImage = capture.get_depth_image();
-    if (depthImage != nullptr)
-    {
-        return depthImage.get_device_timestamp();
-    }
+    std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
 
-    const auto colorImage = capture.get_color_image();
-    if (colorImage != nullptr)
+    // The normal view converts color images from the recorded format on the GPU; the point cloud viewer
+    // needs BGRA, which we have the recording convert as it reads
+    //
+    if (m_recordingHasColor)
     {
-        return colorImage.get_device_timestamp();
+        const k4a_image_format_t colorFormat = viewType == K4AWindowSet::ViewType::PointCloudViewer ?
+                                                   K4A_IMAGE_FORMAT_COLOR_BGRA32 :
+                                                   m_recordConfiguration.color_format;
+        try
+        {
+            m_playbackThreadState.Recording.set_color_conversion(colorFormat);
+        }
+        catch (const k4a::error &e)
+        {
+            K4AViewerErrorManager::Instance().SetErrorStatus(e.what());
+        }
     }
 
-    return std::chrono::microseconds::zero();
-}
+    m_playbackThreadState.Prefetcher->Start();
+    ++m_playbackThreadState.ViewGeneration;
 
-void K4ARecordingDockControl::SetViewType(K4AWindowSet::ViewType viewType)
-{
-    K4AWindowManager::Instance().ClearWindows();
-
-    std::lock_guard<std::mutex> lock(m_playbackThreadState.Mutex);
+    // Show the current capture again with the new settings
+    //
+    m_playbackThreadState.SeekTimestamp = m_playbackThreadState.CurrentCaptureTimestamp;
 
     K4ADataSource<k4a_imu_sample_t> *imuDataSource = nullptr;
     switch (viewType)
@@ -18,6 +18,7 @@
 #include "ik4adockcontrol.h"
 #include "k4adatasource.h"
 #include "k4aimugraphdatagenerator.h"
+#include "k4aplaybackprefetcher.h"
 #include "k4apollingthread.h"
 #include "k4awindowset.h"
 
@@ -28,6 +29,7 @@ class K4ARecordingDockControl : public IK4ADockControl
 {
 public:
     explicit K4ARecordingDockControl(std::string &&path, k4a::playback &&recording);
+    ~K4ARecordingDockControl() override;
 
     K4ADockControlStatus Show() override;
 
@@ -48,16 +50,26 @@ private:
         bool Paused = false;
         bool RecordingAtEnd = false;
         StepDirection Step = StepDirection::None;
+        uint32_t ViewGeneration = 0;
+
+        // Device timestamps
+        //
         std::chrono::microseconds SeekTimestamp;
         std::chrono::microseconds CurrentCaptureTimestamp;
 
         // Constant state (expected to be set once, accessible without synchronization)
         //
         std::chrono::microseconds TimePerFrame;
+        std::chrono::microseconds StartTimestamp;
 
         // Recording state
         //
         k4a::playback Recording;
+
+        // Reads captures from Recording ahead of time; accessible without synchronization
+        //
+        std::unique_ptr<K4APlaybackPrefetcher> Prefetcher;
+
         K4ADataSource<k4a::capture> CaptureDataSource;
         K4ADataSource<k4a_imu_sample_t> ImuDataSource;
 
@@ -66,8 +78,6 @@ private:
 
     static bool PlaybackThreadFn(PlaybackThreadState *state);
 
-    static std::chrono::microseconds GetCaptureTimestamp(const k4a::capture &capture);
-
     void SetViewType(K4AWindowSet::ViewType viewType);
 
     // Labels / static UI state
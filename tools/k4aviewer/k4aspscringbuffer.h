@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef K4ASPSCRINGBUFFER_H
+#define K4ASPSCRINGBUFFER_H
+
+// System headers
+//
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Library headers
+//
+
+// Project headers
+//
+
+namespace k4aviewer
+{
+
+// Lock-free ring buffer with exactly one producer thread and one consumer thread.
+// Each side owns one index and only reads the other, so neither side can be blocked
+// by the other, which makes it safe to write to from a realtime callback.
+//
+template<typename T> class K4ASpscRingBuffer
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "Ring buffer elements are copied as raw memory");
+
+    // Allocates room for at least minCapacity elements.  Check IsValid() for allocation failure.
+    //
+    explicit K4ASpscRingBuffer(size_t minCapacity)
+    {
+        size_t capacity = 1;
+        while (capacity < minCapacity)
+        {
+            capacity <<= 1;
+        }
+
+        m_buffer.reset(new (std::nothrow) T[capacity]());
+        m_mask = m_buffer ? capacity - 1 : 0;
+    }
+
+    bool IsValid() const
+    {
+        return m_buffer != nullptr;
+    }
+
+    size_t Capacity() const
+    {
+        return m_buffer ? m_mask + 1 : 0;
+    }
+
+    // Producer functions
+    //
+
+    // Returns the number of elements that can be written before the consumer catches up.
+    //
+    size_t FreeCount() const
+    {
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        return Capacity() - (writeIndex - m_readIndex.load(std::memory_order_acquire));
+    }
+
+    // Returns the element offset elements past the write position.  offset must be less than FreeCount().
+    //
+    T *WriteItem(size_t offset)
+    {
+        return &m_buffer[(m_writeIndex.load(std::memory_order_relaxed) + offset) & m_mask];
+    }
+
+    // Makes the next count elements written with WriteItem() visible to the consumer.
+    //
+    void CommitWrite(size_t count)
+    {
+        m_writeIndex.store(m_writeIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer functions
+    //
+
+    size_t FillCount() const
+    {
+        return m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_relaxed);
+    }
+
+    // Returns the elements at the read position that are contiguous in memory, and sets count to their number.
+    // Once those are consumed, the rest of the readable elements (if any) start at the beginning of the buffer.
+    //
+    T *ReadItems(size_t *count)
+    {
+        const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        const size_t untilWrap = Capacity() - (readIndex & m_mask);
+        const size_t fillCount = FillCount();
+
+        *count = fillCount < untilWrap ? fillCount : untilWrap;
+        return &m_buffer[readIndex & m_mask];
+    }
+
+    // Releases the next count read elements to the producer.
+    //
+    void CommitRead(size_t count)
+    {
+        m_readIndex.store(m_readIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<T[]> m_buffer;
+    size_t m_mask = 0;
+
+    // The indices only ever grow and are masked on use, so a full buffer and an empty one are told apart.
+    // They live on separate cache lines so the producer and consumer don't contend for one.
+    //
+    alignas(64) std::atomic<size_t> m_writeIndex{ 0 };
+    alignas(64) std::atomic<size_t> m_readIndex{ 0 };
+};
+} // namespace k4aviewer
+
+#endif
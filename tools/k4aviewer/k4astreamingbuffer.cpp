@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Associated header
+//
+#include "k4astreamingbuffer.h"
+
+// System headers
+//
+
+// Library headers
+//
+
+// Project headers
+//
+
+using namespace k4aviewer;
+
+namespace
+{
+// How long to wait for the GPU on each try before checking again
+//
+constexpr GLuint64 FenceWaitTimeoutNs = 1000000000;
+} // namespace
+
+K4AStreamingBuffer::~K4AStreamingBuffer()
+{
+    DeleteFences();
+}
+
+void K4AStreamingBuffer::DeleteFences()
+{
+    for (GLsync &fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+GLenum K4AStreamingBuffer::Initialize(const GLenum target, const GLsizeiptr sectionSize)
+{
+    DeleteFences();
+
+    m_target = target;
+    m_sectionSize = sectionSize;
+    m_currentSection = SectionCount - 1;
+    m_persistentMapping = nullptr;
+
+    // Re-initializing deletes the old buffer, which also unmaps it
+    //
+    m_buffer.Init();
+    glBindBuffer(m_target, m_buffer.Id());
+
+    const GLsizeiptr totalSize = m_sectionSize * static_cast<GLsizeiptr>(SectionCount);
+    if (gl3wIsSupported(4, 4))
+    {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(m_target, totalSize, nullptr, flags);
+        m_persistentMapping = reinterpret_cast<uint8_t *>(glMapBufferRange(m_target, 0, totalSize, flags));
+        if (!m_persistentMapping)
+        {
+            return glGetError();
+        }
+    }
+    else
+    {
+        glBufferData(m_target, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    return glGetError();
+}
+
+uint8_t *K4AStreamingBuffer::BeginWrite()
+{
+    m_currentSection = (m_currentSection + 1) % SectionCount;
+
+    // With three sections this only blocks if the GPU is more than two frames behind
+    //
+    GLsync &fence = m_fences[m_currentSection];
+    if (fence)
+    {
+        GLenum waitResult;
+        do
+        {
+            waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceWaitTimeoutNs);
+        } while (waitResult == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        if (waitResult == GL_WAIT_FAILED)
+        {
+            return nullptr;
+        }
+    }
+
+    glBindBuffer(m_target, m_buffer.Id());
+
+    if (m_persistentMapping)
+    {
+        return m_persistentMapping + GetWriteOffset();
+    }
+
+    // The fence already guarantees the GPU is done with this section, so the driver doesn't need to synchronize
+    //
+    return reinterpret_cast<uint8_t *>(
+        glMapBufferRange(m_target,
+                         GetWriteOffset(),
+                         m_sectionSize,
+                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+}
+
+GLenum K4AStreamingBuffer::EndWrite()
+{
+    // Persistent mappings are coherent, so the writes are already visible to the GPU
+    //
+    if (!m_persistentMapping && !glUnmapBuffer(m_target))
+    {
+        return glGetError();
+    }
+
+    return GL_NO_ERROR;
+}
+
+void K4AStreamingBuffer::Fence()
+{
+    GLsync &fence = m_fences[m_currentSection];
+    if (fence)
+    {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
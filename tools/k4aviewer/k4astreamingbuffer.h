@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef K4ASTREAMINGBUFFER_H
+#define K4ASTREAMINGBUFFER_H
+
+// System headers
+//
+#include <array>
+
+// Library headers
+//
+#include "k4aimgui_all.h"
+
+// Project headers
+//
+#include "openglhelpers.h"
+
+namespace k4aviewer
+{
+
+// A buffer object for data that is streamed to the GPU every frame.
+//
+// The buffer is split into a ring of sections and each write goes to the next section, guarded by a fence,
+// so writing a frame never waits for the GPU to finish reading the previous one and the driver never has
+// to orphan the buffer.  Where the context supports it (OpenGL 4.4), the buffer is mapped once with
+// GL_MAP_PERSISTENT_BIT and stays mapped; otherwise each section is mapped unsynchronized while it is written.
+//
+// All methods must be called on the thread that owns the OpenGL context.
+//
+class K4AStreamingBuffer
+{
+public:
+    static constexpr size_t SectionCount = 3;
+
+    K4AStreamingBuffer() = default;
+    ~K4AStreamingBuffer();
+
+    // (Re)allocates the buffer with SectionCount sections of sectionSize bytes each.  target is the binding
+    // point that the data is read from, e.g. GL_PIXEL_UNPACK_BUFFER.  Leaves the buffer bound to target.
+    //
+    GLenum Initialize(GLenum target, GLsizeiptr sectionSize);
+
+    bool IsInitialized() const
+    {
+        return static_cast<bool>(m_buffer);
+    }
+
+    GLsizeiptr GetSectionSize() const
+    {
+        return m_sectionSize;
+    }
+
+    // Waits until the GPU is done with the next section, binds the buffer to its target and returns a
+    // pointer to the section.  Returns nullptr if the section couldn't be mapped.
+    //
+    uint8_t *BeginWrite();
+
+    // Finishes the write started by BeginWrite().  The buffer stays bound; pass GetWriteOffset() to the
+    // OpenGL calls that read the data, then call Fence().
+    //
+    GLenum EndWrite();
+
+    // The offset in the buffer of the section most recently returned by BeginWrite()
+    //
+    GLintptr GetWriteOffset() const
+    {
+        return static_cast<GLintptr>(m_currentSection) * m_sectionSize;
+    }
+
+    // Marks the point in the command stream after which the GPU is done reading the current section.
+    // May be called again after later reads of the same section (e.g. vertex data drawn every frame).
+    //
+    void Fence();
+
+    K4AStreamingBuffer(const K4AStreamingBuffer &) = delete;
+    K4AStreamingBuffer(const K4AStreamingBuffer &&) = delete;
+    K4AStreamingBuffer &operator=(const K4AStreamingBuffer &) = delete;
+    K4AStreamingBuffer &operator=(const K4AStreamingBuffer &&) = delete;
+
+private:
+    void DeleteFences();
+
+    GLenum m_target = GL_NONE;
+    GLsizeiptr m_sectionSize = 0;
+    size_t m_currentSection = SectionCount - 1;
+
+    OpenGL::Buffer m_buffer;
+    uint8_t *m_persistentMapping = nullptr;
+    std::array<GLsync, SectionCount> m_fences = {};
+};
+} // namespace k4aviewer
+
+#endif
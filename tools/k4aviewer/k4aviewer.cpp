@@ -210,6 +210,9 @@ void K4AViewer::Run()
 
         // Finalize/render frame
         //
+        static PerfCounter render("Frame render");
+        PerfSample renderSample(&render);
+
         ImGui::Render();
         int displayW;
         int displayH;
@@ -220,6 +223,7 @@ void K4AViewer::Run()
         glClearColor(ClearColor.x, ClearColor.y, ClearColor.z, ClearColor.w);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        renderSample.End();
 
         glfwSwapBuffers(m_window);
     }
@@ -239,6 +243,7 @@ void K4AViewer::ShowMainMenuBar()
                 ShowViewerOptionMenuItem("Show framerate", ViewerOption::ShowFrameRateInfo);
             }
 
+            ImGui::MenuItem("Show performance counters", nullptr, &m_showPerfCounters);
             ShowViewerOptionMenuItem("Show developer options", ViewerOption::ShowDeveloperOptions);
 
             ImGui::Separator();
@@ -264,7 +269,6 @@ void K4AViewer::ShowMainMenuBar()
                 ImGui::MenuItem("Show demo window", nullptr, &m_showDemoWindow);
                 ImGui::MenuItem("Show style editor", nullptr, &m_showStyleEditor);
                 ImGui::MenuItem("Show metrics window", nullptr, &m_showMetricsWindow);
-                ImGui::MenuItem("Show perf counters", nullptr, &m_showPerfCounters);
 
                 ImGui::EndMenu();
             }
@@ -14,6 +14,7 @@
 // Project headers
 //
 #include "k4aviewerutil.h"
+#include "perfcounter.h"
 
 using namespace k4aviewer;
 
@@ -48,23 +49,18 @@ K4AViewerImage::K4AViewerImage(const ImageDimensions dimensions, const GLenum fo
 {
     m_textureBufferSize = static_cast<GLuint>(dimensions.Width * dimensions.Height) *
                           GetFormatPixelElementCount(format);
-
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_textureBuffer.Id());
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, m_textureBufferSize, nullptr, GL_STREAM_DRAW);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 GLenum K4AViewerImage::UpdateTexture(const uint8_t *data)
 {
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_textureBuffer.Id());
+    static PerfCounter upload("Texture upload");
+    PerfSample uploadSample(&upload);
+
     glBindTexture(GL_TEXTURE_2D, m_texture.Id());
 
     CleanupGuard bufferCleanupGuard([]() { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); });
 
-    uint8_t *buffer = reinterpret_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
-                                                                   0,
-                                                                   m_textureBufferSize,
-                                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    uint8_t *buffer = m_textureBuffer.BeginWrite();
 
     if (!buffer)
     {
@@ -80,20 +76,25 @@ GLenum K4AViewerImage::UpdateTexture(const uint8_t *data)
         std::fill(buffer, buffer + m_textureBufferSize, static_cast<uint8_t>(0));
     }
 
-    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+    const GLenum writeStatus = m_textureBuffer.EndWrite();
+    if (writeStatus != GL_NO_ERROR)
     {
-        return glGetError();
+        return writeStatus;
     }
 
-    glTexSubImage2D(GL_TEXTURE_2D,       // target
-                    0,                   // level
-                    0,                   // xoffset
-                    0,                   // yoffset
-                    m_dimensions.Width,  // width
-                    m_dimensions.Height, // height
-                    m_format,            // format
-                    GL_UNSIGNED_BYTE,    // type
-                    nullptr);            // data
+    glTexSubImage2D(GL_TEXTURE_2D,                                                        // target
+                    0,                                                                    // level
+                    0,                                                                    // xoffset
+                    0,                                                                    // yoffset
+                    m_dimensions.Width,                                                   // width
+                    m_dimensions.Height,                                                  // height
+                    m_format,                                                             // format
+                    GL_UNSIGNED_BYTE,                                                     // type
+                    reinterpret_cast<const GLvoid *>(m_textureBuffer.GetWriteOffset())); // data
+
+    // Don't reuse this section of the buffer until the upload is done
+    //
+    m_textureBuffer.Fence();
 
     return glGetError();
 }
@@ -118,7 +119,15 @@ GLenum K4AViewerImage::Create(std::shared_ptr<K4AViewerImage> *out,
                    static_cast<GLsizei>(dimensions.Width),
                    static_cast<GLsizei>(dimensions.Height));
 
-    GLenum status = newTexture->UpdateTexture(data);
+    GLenum status = newTexture->m_textureBuffer.Initialize(GL_PIXEL_UNPACK_BUFFER, newTexture->m_textureBufferSize);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (status != GL_NO_ERROR)
+    {
+        out->reset();
+        return status;
+    }
+
+    status = newTexture->UpdateTexture(data);
 
     if (status == GL_NO_ERROR)
     {
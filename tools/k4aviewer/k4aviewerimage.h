@@ -16,6 +16,7 @@
 // Project headers
 //
 #include "k4apixel.h"
+#include "k4astreamingbuffer.h"
 #include "openglhelpers.h"
 
 namespace k4aviewer
@@ -66,7 +67,7 @@ private:
     GLenum m_format;
 
     OpenGL::Texture m_texture = OpenGL::Texture(true);
-    OpenGL::Buffer m_textureBuffer = OpenGL::Buffer(true);
+    K4AStreamingBuffer m_textureBuffer;
 
     GLuint m_textureBufferSize;
 };
@@ -0,0 +1,90 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Associated header
+//
+#include "k4aworkerpool.h"
+
+// System headers
+//
+#include <algorithm>
+
+// Library headers
+//
+
+// Project headers
+//
+
+using namespace k4aviewer;
+
+namespace
+{
+// Enough for the color, depth and IR windows of one device to convert in parallel without taking over
+// the machine when several devices are open
+//
+constexpr unsigned int MinWorkerThreads = 2;
+constexpr unsigned int MaxWorkerThreads = 4;
+} // namespace
+
+K4AWorkerPool &K4AWorkerPool::Instance()
+{
+    static K4AWorkerPool instance;
+    return instance;
+}
+
+K4AWorkerPool::K4AWorkerPool()
+{
+    const unsigned int threadCount = std::max(MinWorkerThreads,
+                                              std::min(MaxWorkerThreads, std::thread::hardware_concurrency() / 2));
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&K4AWorkerPool::WorkerThread, this);
+    }
+}
+
+K4AWorkerPool::~K4AWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shouldExit = true;
+    }
+    m_taskAvailable.notify_all();
+
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void K4AWorkerPool::Submit(std::function<void()> &&task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_taskAvailable.notify_one();
+}
+
+void K4AWorkerPool::WorkerThread(K4AWorkerPool *pool)
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(pool->m_mutex);
+            pool->m_taskAvailable.wait(lock, [pool]() { return pool->m_shouldExit || !pool->m_tasks.empty(); });
+
+            // Finish the queued tasks before exiting; their owners may be waiting for them
+            //
+            if (pool->m_tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(pool->m_tasks.front());
+            pool->m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef K4AWORKERPOOL_H
+#define K4AWORKERPOOL_H
+
+// System headers
+//
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Library headers
+//
+
+// Project headers
+//
+
+namespace k4aviewer
+{
+
+// A small pool of threads shared by every image source in the viewer, so converting images doesn't
+// need a thread per window.
+//
+// Tasks must not block on the UI thread; the UI thread may wait for tasks to finish.
+//
+class K4AWorkerPool
+{
+public:
+    static K4AWorkerPool &Instance();
+
+    void Submit(std::function<void()> &&task);
+
+    ~K4AWorkerPool();
+
+    K4AWorkerPool(const K4AWorkerPool &) = delete;
+    K4AWorkerPool(const K4AWorkerPool &&) = delete;
+    K4AWorkerPool &operator=(const K4AWorkerPool &) = delete;
+    K4AWorkerPool &operator=(const K4AWorkerPool &&) = delete;
+
+private:
+    K4AWorkerPool();
+
+    static void WorkerThread(K4AWorkerPool *pool);
+
+    std::vector<std::thread> m_threads;
+
+    std::deque<std::function<void()>> m_tasks;
+    bool m_shouldExit = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+};
+
+} // namespace k4aviewer
+
+#endif
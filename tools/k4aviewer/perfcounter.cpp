@@ -7,6 +7,10 @@
 
 // System headers
 //
+#include <cfloat>
+#include <ctime>
+#include <fstream>
+#include <sstream>
 
 // Library headers
 //
@@ -16,44 +20,350 @@
 
 using namespace k4aviewer;
 
+namespace
+{
+struct LatencyStageInfo
+{
+    k4a_latency_stage_t Stage;
+    const char *Name;
+};
+
+constexpr LatencyStageInfo LatencyStages[] = {
+    { K4A_LATENCY_STAGE_DEPTH_QUEUE, "USB to depth engine" },
+    { K4A_LATENCY_STAGE_DEPTH_ENGINE, "Depth engine" },
+    { K4A_LATENCY_STAGE_CAPTURE_SYNC, "Capture sync" },
+    { K4A_LATENCY_STAGE_USER, "Waiting for viewer" },
+    { K4A_LATENCY_STAGE_TOTAL, "Total" },
+};
+
+struct UsbStreamInfo
+{
+    k4a_usb_stream_t Stream;
+    const char *Name;
+};
+
+constexpr UsbStreamInfo UsbStreams[] = {
+    { K4A_USB_STREAM_DEPTH, "USB depth" },
+    { K4A_USB_STREAM_IMU, "USB IMU" },
+};
+
+constexpr double UsecPerMs = 1000.0;
+
+// Labels of the buckets of PerfCounter::HistogramData and k4a_latency_stats_t, e.g. "<0.064ms"
+//
+std::string GetHistogramBucketLabel(size_t bucket)
+{
+    std::stringstream labelBuilder;
+    const double upperLimitMs = static_cast<double>(64ull << bucket) / UsecPerMs;
+    if (bucket == PerfCounter::HistogramBuckets - 1)
+    {
+        labelBuilder << ">=" << static_cast<double>(64ull << (bucket - 1)) / UsecPerMs << "ms";
+    }
+    else
+    {
+        labelBuilder << "<" << upperLimitMs << "ms";
+    }
+    return labelBuilder.str();
+}
+
+// Plots a histogram with the buckets of PerfCounter::HistogramData; the tooltip of the plot shows the bucket labels
+//
+void ShowHistogram(const char *id, const uint64_t *histogram)
+{
+    std::array<float, PerfCounter::HistogramBuckets> buckets;
+    size_t lastUsedBucket = 0;
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        buckets[i] = static_cast<float>(histogram[i]);
+        if (histogram[i] != 0)
+        {
+            lastUsedBucket = i;
+        }
+    }
+
+    constexpr float plotHeight = 40.0f;
+    ImGui::PlotHistogram(id,
+                         buckets.data(),
+                         static_cast<int>(buckets.size()),
+                         0,
+                         nullptr,
+                         0.0f,
+                         FLT_MAX,
+                         ImVec2(0.0f, plotHeight));
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Buckets from %s to %s",
+                          GetHistogramBucketLabel(0).c_str(),
+                          GetHistogramBucketLabel(lastUsedBucket).c_str());
+    }
+}
+
+void WriteCsvHistogram(std::ostream &csv, const uint64_t *histogram)
+{
+    for (size_t i = 0; i < PerfCounter::HistogramBuckets; ++i)
+    {
+        csv << "," << histogram[i];
+    }
+}
+} // namespace
+
 void PerfCounterManager::RegisterPerfCounter(const char *name, PerfCounter *perfCounter)
 {
     std::lock_guard<std::mutex> lockGuard(Instance().m_mutex);
     Instance().m_perfCounters[std::string(name)] = perfCounter;
 }
 
-void PerfCounterManager::ShowPerfWindow(bool *windowOpen)
+void PerfCounterManager::RegisterDevice(k4a_device_t device, const std::string &serialNumber)
+{
+    std::lock_guard<std::mutex> lockGuard(Instance().m_mutex);
+    Instance().m_device = device;
+    Instance().m_deviceSerialNumber = serialNumber;
+}
+
+void PerfCounterManager::UnregisterDevice(k4a_device_t device)
 {
     std::lock_guard<std::mutex> lockGuard(Instance().m_mutex);
+    if (Instance().m_device == device)
+    {
+        Instance().m_device = nullptr;
+        Instance().m_deviceSerialNumber.clear();
+    }
+}
 
-    if (ImGui::Begin("Performance Counters (in ms)", windowOpen, ImGuiWindowFlags_AlwaysAutoResize))
+void PerfCounterManager::ShowPerfWindow(bool *windowOpen)
+{
+    PerfCounterManager &instance = Instance();
+    std::lock_guard<std::mutex> lockGuard(instance.m_mutex);
+
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    if (ImGui::Begin("Performance Counters (in ms)",
+                     windowOpen,
+                     ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing))
     {
-        for (auto &counter : Instance().m_perfCounters)
+        if (ImGui::CollapsingHeader("SDK depth pipeline", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            instance.ShowSdkLatencies();
+        }
+
+        if (ImGui::CollapsingHeader("Dropped frames", ImGuiTreeNodeFlags_DefaultOpen))
         {
-            ImGui::Text("%s", counter.first.c_str());
-            ImGui::Text("avg: %f", double(counter.second->GetAverage()));
-            ImGui::Text("max: %f", double(counter.second->GetMax()));
+            instance.ShowDeviceCounters();
+        }
 
-            const PerfCounter::SampleData &data = counter.second->GetSampleData();
-            ImGui::PlotLines("",
-                             &data[0],
-                             static_cast<int>(data.size()),
-                             static_cast<int>(counter.second->GetCurrentSampleId()),
-                             "");
-            ImGui::Separator();
+        if (ImGui::CollapsingHeader("Viewer", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            instance.ShowViewerCounters();
         }
 
+        ImGui::Separator();
         if (ImGui::Button("Reset perf counters"))
         {
-            for (auto &counter : Instance().m_perfCounters)
-            {
-                counter.second->Reset();
-            }
+            instance.ResetCounters();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Export to CSV"))
+        {
+            const std::string fileName = instance.ExportCsv();
+            instance.m_exportStatus = fileName.empty() ? "Failed to write CSV file!" : "Wrote " + fileName;
+        }
+
+        if (!instance.m_exportStatus.empty())
+        {
+            ImGui::Text("%s", instance.m_exportStatus.c_str());
         }
     }
     ImGui::End();
 }
 
+void PerfCounterManager::ShowViewerCounters()
+{
+    for (auto &counter : m_perfCounters)
+    {
+        ImGui::PushID(counter.first.c_str());
+
+        ImGui::Text("%s", counter.first.c_str());
+        ImGui::Text("avg: %f", double(counter.second->GetAverage()));
+        ImGui::Text("max: %f", double(counter.second->GetMax()));
+
+        const PerfCounter::SampleData &data = counter.second->GetSampleData();
+        ImGui::PlotLines("",
+                         &data[0],
+                         static_cast<int>(data.size()),
+                         static_cast<int>(counter.second->GetCurrentSampleId()),
+                         "");
+        ShowHistogram("##histogram", counter.second->GetHistogram().data());
+        ImGui::Separator();
+
+        ImGui::PopID();
+    }
+}
+
+void PerfCounterManager::ShowSdkLatencies()
+{
+    for (const LatencyStageInfo &stageInfo : LatencyStages)
+    {
+        k4a_latency_stats_t stats;
+        if (k4a_get_latency_stats(stageInfo.Stage, &stats) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        ImGui::PushID(stageInfo.Name);
+
+        ImGui::Text("%s", stageInfo.Name);
+        if (stats.count == 0)
+        {
+            ImGui::Text("No captures yet");
+        }
+        else
+        {
+            ImGui::Text("avg: %f min: %f max: %f (%llu captures)",
+                        double(stats.total_usec) / double(stats.count) / UsecPerMs,
+                        double(stats.min_usec) / UsecPerMs,
+                        double(stats.max_usec) / UsecPerMs,
+                        static_cast<unsigned long long>(stats.count));
+            ShowHistogram("##histogram", stats.histogram);
+        }
+        ImGui::Separator();
+
+        ImGui::PopID();
+    }
+}
+
+void PerfCounterManager::ShowDeviceCounters()
+{
+    if (!m_device)
+    {
+        ImGui::Text("No device open");
+        return;
+    }
+
+    ImGui::Text("Device S/N: %s", m_deviceSerialNumber.c_str());
+
+    k4a_capture_stats_t captureStats;
+    if (k4a_device_get_capture_stats(m_device, &captureStats) == K4A_RESULT_SUCCEEDED)
+    {
+        ImGui::Text("Synchronized captures: %llu", static_cast<unsigned long long>(captureStats.synchronized_captures));
+        ImGui::Text("Unmatched depth / color: %llu / %llu",
+                    static_cast<unsigned long long>(captureStats.depth_unmatched),
+                    static_cast<unsigned long long>(captureStats.color_unmatched));
+        ImGui::Text("Sync queue overflows depth / color: %llu / %llu",
+                    static_cast<unsigned long long>(captureStats.depth_queue_overflow),
+                    static_cast<unsigned long long>(captureStats.color_queue_overflow));
+        ImGui::Text("Not read in time: %llu", static_cast<unsigned long long>(captureStats.output_queue_overflow));
+        ImGui::Text("Dropped at timestamp reset: %llu",
+                    static_cast<unsigned long long>(captureStats.depth_dropped_timestamp_reset));
+    }
+
+    for (const UsbStreamInfo &streamInfo : UsbStreams)
+    {
+        k4a_usb_stream_stats_t usbStats;
+        if (k4a_device_get_usb_stream_stats(m_device, streamInfo.Stream, &usbStats) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        ImGui::Text("%s: %llu timed out, %llu overflowed, %llu failed, %llu not resubmitted, %llu recoveries",
+                    streamInfo.Name,
+                    static_cast<unsigned long long>(usbStats.timed_out_transfers),
+                    static_cast<unsigned long long>(usbStats.overflow_transfers),
+                    static_cast<unsigned long long>(usbStats.failed_transfers),
+                    static_cast<unsigned long long>(usbStats.resubmit_failures),
+                    static_cast<unsigned long long>(usbStats.stream_recoveries));
+    }
+}
+
+void PerfCounterManager::ResetCounters()
+{
+    for (auto &counter : m_perfCounters)
+    {
+        counter.second->Reset();
+    }
+
+    k4a_reset_latency_stats();
+}
+
+std::string PerfCounterManager::ExportCsv()
+{
+    const std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    if (std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::localtime(&now)) == 0)
+    {
+        return std::string();
+    }
+
+    const std::string fileName = std::string("k4aviewer-perf-") + timestamp + ".csv";
+    std::ofstream csv(fileName.c_str());
+    if (!csv)
+    {
+        return std::string();
+    }
+
+    // Latency rows have a count, the timings in ms and a histogram; counter rows only have a value
+    //
+    csv << "category,name,count,avg_ms,min_ms,max_ms";
+    for (size_t i = 0; i < PerfCounter::HistogramBuckets; ++i)
+    {
+        csv << "," << GetHistogramBucketLabel(i);
+    }
+    csv << "\n";
+
+    for (const LatencyStageInfo &stageInfo : LatencyStages)
+    {
+        k4a_latency_stats_t stats;
+        if (k4a_get_latency_stats(stageInfo.Stage, &stats) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        const double averageMs = stats.count == 0 ? 0.0 : double(stats.total_usec) / double(stats.count) / UsecPerMs;
+        csv << "sdk," << stageInfo.Name << "," << stats.count << "," << averageMs << ","
+            << double(stats.min_usec) / UsecPerMs << "," << double(stats.max_usec) / UsecPerMs;
+        WriteCsvHistogram(csv, stats.histogram);
+        csv << "\n";
+    }
+
+    for (auto &counter : m_perfCounters)
+    {
+        csv << "viewer," << counter.first << "," << counter.second->GetCount() << "," << counter.second->GetMean()
+            << "," << counter.second->GetMin() << "," << counter.second->GetMax();
+        WriteCsvHistogram(csv, counter.second->GetHistogram().data());
+        csv << "\n";
+    }
+
+    k4a_capture_stats_t captureStats;
+    if (m_device && k4a_device_get_capture_stats(m_device, &captureStats) == K4A_RESULT_SUCCEEDED)
+    {
+        csv << "capture,synchronized_captures," << captureStats.synchronized_captures << "\n";
+        csv << "capture,depth_unmatched," << captureStats.depth_unmatched << "\n";
+        csv << "capture,color_unmatched," << captureStats.color_unmatched << "\n";
+        csv << "capture,depth_queue_overflow," << captureStats.depth_queue_overflow << "\n";
+        csv << "capture,color_queue_overflow," << captureStats.color_queue_overflow << "\n";
+        csv << "capture,output_queue_overflow," << captureStats.output_queue_overflow << "\n";
+        csv << "capture,depth_dropped_timestamp_reset," << captureStats.depth_dropped_timestamp_reset << "\n";
+    }
+
+    for (const UsbStreamInfo &streamInfo : UsbStreams)
+    {
+        k4a_usb_stream_stats_t usbStats;
+        if (!m_device ||
+            k4a_device_get_usb_stream_stats(m_device, streamInfo.Stream, &usbStats) != K4A_RESULT_SUCCEEDED)
+        {
+            continue;
+        }
+
+        csv << "usb," << streamInfo.Name << " timed_out_transfers," << usbStats.timed_out_transfers << "\n";
+        csv << "usb," << streamInfo.Name << " overflow_transfers," << usbStats.overflow_transfers << "\n";
+        csv << "usb," << streamInfo.Name << " failed_transfers," << usbStats.failed_transfers << "\n";
+        csv << "usb," << streamInfo.Name << " resubmit_failures," << usbStats.resubmit_failures << "\n";
+        csv << "usb," << streamInfo.Name << " stream_recoveries," << usbStats.stream_recoveries << "\n";
+    }
+
+    csv.close();
+    return csv ? fileName : std::string();
+}
+
 PerfCounterManager &PerfCounterManager::Instance()
 {
     static PerfCounterManager instance;
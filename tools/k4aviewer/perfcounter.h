@@ -13,9 +13,11 @@
 #include <mutex>
 #include <numeric>
 #include <ratio>
+#include <string>
 
 // Library headers
 //
+#include <k4a/k4a.h>
 #include "k4aimgui_all.h"
 
 // Project headers
@@ -28,6 +30,10 @@ namespace k4aviewer
 //
 // Perf counters must last forever once declared (usually by being declared static).
 //
+// The perf window shows the viewer's counters next to the latency statistics of the SDK's depth pipeline
+// (k4a_get_latency_stats) and the drop counters of the open device, so a slow rig can be diagnosed without
+// attaching a profiler.  Everything it shows can be exported to a CSV file.
+//
 class PerfCounter;
 class PerfCounterManager
 {
@@ -35,10 +41,31 @@ public:
     static void RegisterPerfCounter(const char *name, PerfCounter *perfCounter);
     static void ShowPerfWindow(bool *windowOpen);
 
+    // Sets the device whose capture and USB statistics are shown in the perf window.  The device must
+    // stay open until it is unregistered.  Must be called on the UI thread.
+    //
+    static void RegisterDevice(k4a_device_t device, const std::string &serialNumber);
+    static void UnregisterDevice(k4a_device_t device);
+
 private:
     static PerfCounterManager &Instance();
+
+    void ShowViewerCounters();
+    void ShowSdkLatencies();
+    void ShowDeviceCounters();
+    void ResetCounters();
+
+    // Writes every counter to a CSV file in the working directory and returns its name, or an empty
+    // string if the file couldn't be written.
+    //
+    std::string ExportCsv();
+
     std::map<std::string, PerfCounter *> m_perfCounters;
     std::mutex m_mutex;
+
+    k4a_device_t m_device = nullptr;
+    std::string m_deviceSerialNumber;
+    std::string m_exportStatus;
 };
 
 // A wrapper for taking a single perf measurement.  Timing starts when the sample is created.
@@ -70,6 +97,13 @@ class PerfCounter
 public:
     using SampleData = std::array<float, 100>;
 
+    // Same buckets as k4a_latency_stats_t, so viewer and SDK stages can be compared side by side:
+    // bucket 0 counts samples under 64 us, bucket N counts samples from 2^(N+5) us up to 2^(N+6) us
+    // and the last bucket counts every slower sample.
+    //
+    static constexpr size_t HistogramBuckets = K4A_LATENCY_HISTOGRAM_BUCKETS;
+    using HistogramData = std::array<uint64_t, HistogramBuckets>;
+
     PerfCounter(const char *name)
     {
         PerfCounterManager::RegisterPerfCounter(name, this);
@@ -82,6 +116,28 @@ public:
         return m_max;
     }
 
+    inline float GetMin() const
+    {
+        return m_count == 0 ? 0.0f : m_min;
+    }
+
+    inline uint64_t GetCount() const
+    {
+        return m_count;
+    }
+
+    // Mean of every sample since the last reset, unlike GetAverage(), which only covers the plotted samples
+    //
+    inline float GetMean() const
+    {
+        return m_count == 0 ? 0.0f : static_cast<float>(m_totalMs / m_count);
+    }
+
+    inline const HistogramData &GetHistogram() const
+    {
+        return m_histogram;
+    }
+
     inline float GetAverage() const
     {
         return static_cast<float>(std::accumulate(m_samples.begin(), m_samples.end(), 0.0) / m_samples.size());
@@ -105,6 +161,16 @@ public:
         const float durationMs = durationNs * 1.0f * std::milli::den / std::milli::num * std::nano::num /
                                  std::nano::den;
         m_max = std::max(m_max, durationMs);
+        m_min = m_count == 0 ? durationMs : std::min(m_min, durationMs);
+        m_totalMs += durationMs;
+        ++m_count;
+
+        size_t bucket = 0;
+        for (long long limitUs = 64; bucket < HistogramBuckets - 1 && durationNs >= limitUs * 1000; limitUs *= 2)
+        {
+            ++bucket;
+        }
+        ++m_histogram[bucket];
 
         m_currentSample = (m_currentSample + 1) % m_samples.size();
         m_samples[m_currentSample] = durationMs;
@@ -113,13 +179,21 @@ public:
     inline void Reset()
     {
         m_max = 0;
+        m_min = 0;
+        m_totalMs = 0;
+        m_count = 0;
         std::fill(m_samples.begin(), m_samples.end(), 0.0f);
+        std::fill(m_histogram.begin(), m_histogram.end(), 0);
     }
 
 private:
     float m_max = 0;
+    float m_min = 0;
+    double m_totalMs = 0;
+    uint64_t m_count = 0;
     size_t m_currentSample = 0;
     SampleData m_samples;
+    HistogramData m_histogram = {};
 };
 
 inline void PerfSample::End()
@@ -14,7 +14,6 @@
 
 // Project headers
 //
-#include "k4aviewererrormanager.h"
 #include "k4asoundio_util.h"
 
 using namespace k4aviewer;
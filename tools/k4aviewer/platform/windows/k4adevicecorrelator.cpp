@@ -33,7 +33,6 @@
 
 // Project headers
 //
-#include "k4aviewererrormanager.h"
 #include "k4aviewerutil.h"
 
 #define RETURN_IF_FAILED(hr)                                                                                           \
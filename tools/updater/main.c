@@ -8,6 +8,7 @@
 #include <k4ainternal/firmware.h>
 #include <k4ainternal/logging.h>
 
+#include <azure_c_shared_utility/lock.h>
 #include <azure_c_shared_utility/tickcounter.h>
 #include <azure_c_shared_utility/threadapi.h>
 #include <stdio.h>
@@ -40,6 +41,11 @@
 
 char K4A_ENV_VAR_LOG_TO_A_FILE[] = K4A_ENABLE_LOG_TO_A_FILE;
 
+// Devices are updated on a thread each. Opening a device enumerates every attached device, so only one thread opens a
+// device at a time, and multi-line reports are printed under a lock so the reports of different devices don't mix.
+static LOCK_HANDLE g_open_lock = NULL;
+static LOCK_HANDLE g_print_lock = NULL;
+
 typedef enum
 {
     K4A_FIRMWARE_COMMAND_UNKNOWN = 0,
@@ -69,6 +75,15 @@ typedef struct _updater_command_info_t
     k4a_hardware_version_t updated_version;
 } updater_command_info_t;
 
+// Update of a single device, run on its own thread
+typedef struct _device_update_t
+{
+    updater_command_info_t command_info; // Holds the one device being updated
+    firmware_package_info_t *firmware_info;
+    THREAD_HANDLE thread;
+    k4a_result_t result;
+} device_update_t;
+
 static void print_supprted_commands()
 {
     printf("* Usage Info *\n");
@@ -86,6 +101,7 @@ static void print_supprted_commands()
     printf("        Arguments: <Firmware Package Path and FileName>\n");
     printf("\n");
     printf("    If no Serial Number is provided, the tool will just connect to the first device.\n");
+    printf("    An update without a Serial Number updates all connected devices at the same time.\n");
     printf("\n");
     printf("Examples:\n");
     printf("    %s -List\n", EXECUTABLE_NAME);
@@ -585,13 +601,52 @@ static bool compare_version_list(k4a_version_t device_version, uint8_t count, k4
     return false;
 }
 
-static k4a_result_t wait_update_operation_complete(firmware_t firmware_handle, firmware_status_summary_t *finalStatus)
+// Prints the stage of the component being updated when it changes
+static void print_update_progress(const char *serial_number,
+                                  const firmware_status_summary_t *status,
+                                  const char **last_progress)
+{
+    const char *component = NULL;
+    const char *progress = NULL;
+    if (status->audio.overall == FIRMWARE_OPERATION_INPROGRESS)
+    {
+        component = "Audio";
+        progress = component_status_to_string(status->audio, false);
+    }
+    else if (status->depth_config.overall == FIRMWARE_OPERATION_INPROGRESS)
+    {
+        component = "Depth config";
+        progress = component_status_to_string(status->depth_config, false);
+    }
+    else if (status->depth.overall == FIRMWARE_OPERATION_INPROGRESS)
+    {
+        component = "Depth";
+        progress = component_status_to_string(status->depth, false);
+    }
+    else if (status->rgb.overall == FIRMWARE_OPERATION_INPROGRESS)
+    {
+        component = "RGB";
+        progress = component_status_to_string(status->rgb, false);
+    }
+
+    // The status strings are constants, so the stage changed if the string did
+    if (progress != NULL && progress != *last_progress)
+    {
+        printf("S/N %s: %s %s\n", serial_number, component, progress);
+        *last_progress = progress;
+    }
+}
+
+static k4a_result_t wait_update_operation_complete(firmware_t firmware_handle,
+                                                   const char *serial_number,
+                                                   firmware_status_summary_t *finalStatus)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, finalStatus == NULL);
     LOG_INFO("Waiting for the update operation to complete...", 0);
 
     bool allComplete = false;
     k4a_result_t result = K4A_RESULT_FAILED;
+    const char *last_progress = NULL;
 
     tickcounter_ms_t start_time_ms, now;
 
@@ -617,6 +672,7 @@ static k4a_result_t wait_update_operation_complete(firmware_t firmware_handle, f
                            (finalStatus->depth_config.overall > FIRMWARE_OPERATION_INPROGRESS) &&
                            (finalStatus->depth.overall > FIRMWARE_OPERATION_INPROGRESS) &&
                            (finalStatus->rgb.overall > FIRMWARE_OPERATION_INPROGRESS));
+            print_update_progress(serial_number, finalStatus, &last_progress);
         }
         else
         {
@@ -669,9 +725,11 @@ static k4a_result_t ensure_firmware_open(updater_command_info_t *command_info,
         // Wait until the device is available...
         do
         {
+            Lock(g_open_lock);
             result = firmware_create(command_info->device_serial_number[device_index],
                                      resetting_device,
                                      &command_info->firmware_handle);
+            Unlock(g_open_lock);
             if (!K4A_SUCCEEDED(result))
             {
                 LOG_INFO("Failed to connect to the Azure Kinect device", 0);
@@ -790,168 +848,228 @@ static k4a_result_t command_load_and_inspect_firmware(char *firmware_path, firmw
     return result;
 }
 
-static k4a_result_t command_update_device(updater_command_info_t *command_info)
+static k4a_result_t update_device(updater_command_info_t *command_info, firmware_package_info_t *firmware_info)
 {
     firmware_status_summary_t finalFwCommandStatus;
-    k4a_result_t finalCmdStatus = K4A_RESULT_SUCCEEDED;
+    const char *serial_number = command_info->device_serial_number[0];
 
-    // Load and parse the firmware file information...
-    firmware_package_info_t firmware_info;
-    k4a_result_t result = command_load_and_inspect_firmware(command_info->firmware_path, &firmware_info);
+    k4a_result_t result = ensure_firmware_open(command_info, FW_OPEN_FULL_FEATURE, 0);
     if (!K4A_SUCCEEDED(result))
     {
+        printf("ERROR: Failed to open device S/N: %s\n", serial_number);
         return result;
     }
 
-    for (uint32_t device_index = 0; device_index < command_info->device_count; device_index++)
+    // Query the current device information...
+    Lock(g_print_lock);
+    result = command_query_device(command_info);
+    Unlock(g_print_lock);
+    if (!K4A_SUCCEEDED(result))
     {
-        result = ensure_firmware_open(command_info, FW_OPEN_FULL_FEATURE, device_index);
-        if (!K4A_SUCCEEDED(result))
-        {
-            return result;
-        }
+        return result;
+    }
 
-        // Make a copy of the command so that only 1 device is updated at a time.
-        updater_command_info_t sub_command_info = { 0 };
-        sub_command_info.device_count = 1;
-        sub_command_info.device_serial_number[0] = command_info->device_serial_number[device_index];
-        sub_command_info.firmware_handle = command_info->firmware_handle;
-        sub_command_info.firmware_serial_number = command_info->firmware_serial_number;
+    bool audio_current_version_same = compare_version(command_info->current_version.audio, firmware_info->audio);
+    bool depth_config_current_version_same = compare_version_list(command_info->current_version.depth_sensor,
+                                                                  firmware_info->depth_config_number_versions,
+                                                                  firmware_info->depth_config_versions);
+    bool depth_current_version_same = compare_version(command_info->current_version.depth, firmware_info->depth);
+    bool rgb_current_version_same = compare_version(command_info->current_version.rgb, firmware_info->rgb);
 
-        // Passed the ownership of the handle to sub_command_info
-        command_info->firmware_handle = NULL;
-        command_info->firmware_serial_number = NULL;
+    // Write the loaded firmware to the device. The whole package is sent in a single transfer.
+    printf("S/N %s: Sending the firmware to the device.\n", serial_number);
+    result = firmware_download(command_info->firmware_handle, firmware_info->buffer, firmware_info->size);
+    if (!K4A_SUCCEEDED(result))
+    {
+        printf("ERROR: Downloading the firmware to S/N %s failed! %d\n", serial_number, result);
+        return result;
+    }
 
-        // Query the current device information...
-        result = command_query_device(&sub_command_info);
-        if (!K4A_SUCCEEDED(result))
-        {
-            return result;
-        }
+    // Wait until the update operation is complete and query the device to get status...
+    bool update_failed = K4A_FAILED(
+        wait_update_operation_complete(command_info->firmware_handle, serial_number, &finalFwCommandStatus));
 
-        bool audio_current_version_same = compare_version(sub_command_info.current_version.audio, firmware_info.audio);
-        bool depth_config_current_version_same = compare_version_list(sub_command_info.current_version.depth_sensor,
-                                                                      firmware_info.depth_config_number_versions,
-                                                                      firmware_info.depth_config_versions);
-        bool depth_current_version_same = compare_version(sub_command_info.current_version.depth, firmware_info.depth);
-        bool rgb_current_version_same = compare_version(sub_command_info.current_version.rgb, firmware_info.rgb);
+    // Always reset the device.
+    result = command_reset_device(command_info);
+    if (K4A_FAILED(result))
+    {
+        printf("ERROR: S/N %s failed to reset after an update. Please manually power cycle the device.\n",
+               serial_number);
+    }
 
-        printf("Please wait, updating device firmware. Don't unplug the device. This operation can take a few "
-               "minutes...\n");
+    bool allSuccess =
+        ((calculate_overall_component_status(finalFwCommandStatus.audio) == FIRMWARE_OPERATION_SUCCEEDED) &&
+         (calculate_overall_component_status(finalFwCommandStatus.depth_config) == FIRMWARE_OPERATION_SUCCEEDED) &&
+         (calculate_overall_component_status(finalFwCommandStatus.depth) == FIRMWARE_OPERATION_SUCCEEDED) &&
+         (calculate_overall_component_status(finalFwCommandStatus.rgb) == FIRMWARE_OPERATION_SUCCEEDED));
 
-        // Write the loaded firmware to the device...
-        result = firmware_download(sub_command_info.firmware_handle, firmware_info.buffer, firmware_info.size);
-        if (!K4A_SUCCEEDED(result))
-        {
-            printf("ERROR: Downloading the firmware failed! %d\n", result);
-            return result;
-        }
+    if (update_failed || !allSuccess)
+    {
+        Lock(g_print_lock);
+        printf("\nERROR: The update process of S/N %s failed. One or more stages failed.\n", serial_number);
+        printf("  Audio's last known state:        %s\n",
+               component_status_to_string(finalFwCommandStatus.audio, audio_current_version_same));
+        printf("  Depth config's last known state: %s\n",
+               component_status_to_string(finalFwCommandStatus.depth_config, depth_config_current_version_same));
+        printf("  Depth's last known state:        %s\n",
+               component_status_to_string(finalFwCommandStatus.depth, depth_current_version_same));
+        printf("  RGB's last known state:          %s\n",
+               component_status_to_string(finalFwCommandStatus.rgb, rgb_current_version_same));
+        printf("\n");
+        Unlock(g_print_lock);
 
-        // Wait until the update operation is complete and query the device to get status...
-        bool update_failed = K4A_FAILED(
-            wait_update_operation_complete(sub_command_info.firmware_handle, &finalFwCommandStatus));
+        return K4A_RESULT_FAILED;
+    }
 
-        // Always reset the device.
-        result = command_reset_device(&sub_command_info);
-        if (K4A_FAILED(result))
+    // Pull the updated version number:
+    result = firmware_get_device_version(command_info->firmware_handle, &command_info->updated_version);
+    Lock(g_print_lock);
+    if (K4A_SUCCEEDED(result))
+    {
+        bool audio_updated_version_same = compare_version(command_info->updated_version.audio, firmware_info->audio);
+        bool depth_config_updated_version_same = compare_version_list(command_info->updated_version.depth_sensor,
+                                                                      firmware_info->depth_config_number_versions,
+                                                                      firmware_info->depth_config_versions);
+        bool depth_updated_version_same = compare_version(command_info->updated_version.depth, firmware_info->depth);
+        bool rgb_updated_version_same = compare_version(command_info->updated_version.rgb, firmware_info->rgb);
+
+        if (audio_current_version_same && audio_updated_version_same && depth_config_current_version_same &&
+            depth_config_updated_version_same && depth_current_version_same && depth_updated_version_same &&
+            rgb_current_version_same && rgb_updated_version_same)
         {
-            printf("ERROR: The device failed to reset after an update. Please manually power cycle the device.\n");
+            printf("SUCCESS: The firmware of S/N %s was already up-to-date.\n", serial_number);
+        }
+        else if (audio_updated_version_same && depth_config_updated_version_same && depth_updated_version_same &&
+                 rgb_updated_version_same)
+        {
+            printf("SUCCESS: The firmware of S/N %s has been successfully updated.\n", serial_number);
+        }
+        else
+        {
+            printf("The firmware of S/N %s has been updated to the following firmware Versions:\n", serial_number);
+            printf("  RGB camera firmware:    %d.%d.%d => %d.%d.%d\n",
+                   command_info->current_version.rgb.major,
+                   command_info->current_version.rgb.minor,
+                   command_info->current_version.rgb.iteration,
+                   command_info->updated_version.rgb.major,
+                   command_info->updated_version.rgb.minor,
+                   command_info->updated_version.rgb.iteration);
+            printf("  Depth camera firmware:  %d.%d.%d => %d.%d.%d\n",
+                   command_info->current_version.depth.major,
+                   command_info->current_version.depth.minor,
+                   command_info->current_version.depth.iteration,
+                   command_info->updated_version.depth.major,
+                   command_info->updated_version.depth.minor,
+                   command_info->updated_version.depth.iteration);
+            printf("  Depth config file:      %d.%d => %d.%d\n",
+                   command_info->current_version.depth_sensor.major,
+                   command_info->current_version.depth_sensor.minor,
+                   command_info->updated_version.depth_sensor.major,
+                   command_info->updated_version.depth_sensor.minor);
+            printf("  Audio firmware:         %d.%d.%d => %d.%d.%d\n",
+                   command_info->current_version.audio.major,
+                   command_info->current_version.audio.minor,
+                   command_info->current_version.audio.iteration,
+                   command_info->updated_version.audio.major,
+                   command_info->updated_version.audio.minor,
+                   command_info->updated_version.audio.iteration);
         }
+    }
+    else
+    {
+        printf("ERROR: Failed to get updated versions of S/N %s\n\n", serial_number);
+    }
+    printf("\n\n");
+    Unlock(g_print_lock);
 
-        bool allSuccess =
-            ((calculate_overall_component_status(finalFwCommandStatus.audio) == FIRMWARE_OPERATION_SUCCEEDED) &&
-             (calculate_overall_component_status(finalFwCommandStatus.depth_config) == FIRMWARE_OPERATION_SUCCEEDED) &&
-             (calculate_overall_component_status(finalFwCommandStatus.depth) == FIRMWARE_OPERATION_SUCCEEDED) &&
-             (calculate_overall_component_status(finalFwCommandStatus.rgb) == FIRMWARE_OPERATION_SUCCEEDED));
+    return result;
+}
 
-        if (update_failed || !allSuccess)
-        {
-            printf("\nERROR: The update process failed. One or more stages failed.\n");
-            printf("  Audio's last known state:        %s\n",
-                   component_status_to_string(finalFwCommandStatus.audio, audio_current_version_same));
-            printf("  Depth config's last known state: %s\n",
-                   component_status_to_string(finalFwCommandStatus.depth_config, depth_config_current_version_same));
-            printf("  Depth's last known state:        %s\n",
-                   component_status_to_string(finalFwCommandStatus.depth, depth_current_version_same));
-            printf("  RGB's last known state:          %s\n",
-                   component_status_to_string(finalFwCommandStatus.rgb, rgb_current_version_same));
+static int update_device_thread(void *param)
+{
+    device_update_t *update = (device_update_t *)param;
 
-            return K4A_RESULT_FAILED;
+    update->result = update_device(&update->command_info, update->firmware_info);
+    close_all_handles(&update->command_info, NULL);
+    return 0;
+}
+
+static k4a_result_t command_update_device(updater_command_info_t *command_info)
+{
+    k4a_result_t finalCmdStatus = K4A_RESULT_SUCCEEDED;
+
+    // Load and parse the firmware file information...
+    firmware_package_info_t firmware_info;
+    k4a_result_t result = command_load_and_inspect_firmware(command_info->firmware_path, &firmware_info);
+    if (!K4A_SUCCEEDED(result))
+    {
+        return result;
+    }
+
+    device_update_t *updates = (device_update_t *)calloc(command_info->device_count, sizeof(device_update_t));
+    if (updates == NULL)
+    {
+        printf("ERROR: Failed to allocate memory for %d device updates.\n", command_info->device_count);
+        close_all_handles(command_info, &firmware_info);
+        return K4A_RESULT_FAILED;
+    }
+
+    // Each device is opened by the thread updating it
+    close_all_handles(command_info, NULL);
+
+    printf("Please wait, updating device firmware. Don't unplug the device. This operation can take a few "
+           "minutes...\n");
+
+    // An update mostly waits for the device to write its flash and reboot, so all devices are updated at the same
+    // time. Each update only uses its own device and handle.
+    for (uint32_t device_index = 0; device_index < command_info->device_count; device_index++)
+    {
+        device_update_t *update = &updates[device_index];
+        update->command_info.device_count = 1;
+        update->command_info.device_serial_number[0] = command_info->device_serial_number[device_index];
+        update->firmware_info = &firmware_info;
+        update->result = K4A_RESULT_FAILED;
+
+        if (ThreadAPI_Create(&update->thread, update_device_thread, update) != THREADAPI_OK)
+        {
+            // The device is updated on this thread once the others are started
+            LOG_WARNING("Failed to create a thread to update S/N %s", update->command_info.device_serial_number[0]);
+            update->thread = NULL;
         }
+    }
 
-        // Pull the updated version number:
-        result = firmware_get_device_version(sub_command_info.firmware_handle, &sub_command_info.updated_version);
-        if (K4A_SUCCEEDED(result))
+    for (uint32_t device_index = 0; device_index < command_info->device_count; device_index++)
+    {
+        device_update_t *update = &updates[device_index];
+        if (update->thread != NULL)
         {
-            bool audio_updated_version_same = compare_version(sub_command_info.updated_version.audio,
-                                                              firmware_info.audio);
-            bool depth_config_updated_version_same = compare_version_list(sub_command_info.updated_version.depth_sensor,
-                                                                          firmware_info.depth_config_number_versions,
-                                                                          firmware_info.depth_config_versions);
-            bool depth_updated_version_same = compare_version(sub_command_info.updated_version.depth,
-                                                              firmware_info.depth);
-            bool rgb_updated_version_same = compare_version(sub_command_info.updated_version.rgb, firmware_info.rgb);
-
-            if (audio_current_version_same && audio_updated_version_same && depth_config_current_version_same &&
-                depth_config_updated_version_same && depth_current_version_same && depth_updated_version_same &&
-                rgb_current_version_same && rgb_updated_version_same)
-            {
-                printf("SUCCESS: The firmware was already up-to-date.\n");
-            }
-            else if (audio_updated_version_same && depth_config_updated_version_same && depth_updated_version_same &&
-                     rgb_updated_version_same)
-            {
-                printf("SUCCESS: The firmware has been successfully updated.\n");
-            }
-            else
-            {
-                printf("The firmware has been updated to the following firmware Versions:\n");
-                printf("  RGB camera firmware:    %d.%d.%d => %d.%d.%d\n",
-                       sub_command_info.current_version.rgb.major,
-                       sub_command_info.current_version.rgb.minor,
-                       sub_command_info.current_version.rgb.iteration,
-                       sub_command_info.updated_version.rgb.major,
-                       sub_command_info.updated_version.rgb.minor,
-                       sub_command_info.updated_version.rgb.iteration);
-                printf("  Depth camera firmware:  %d.%d.%d => %d.%d.%d\n",
-                       sub_command_info.current_version.depth.major,
-                       sub_command_info.current_version.depth.minor,
-                       sub_command_info.current_version.depth.iteration,
-                       sub_command_info.updated_version.depth.major,
-                       sub_command_info.updated_version.depth.minor,
-                       sub_command_info.updated_version.depth.iteration);
-                printf("  Depth config file:      %d.%d => %d.%d\n",
-                       sub_command_info.current_version.depth_sensor.major,
-                       sub_command_info.current_version.depth_sensor.minor,
-                       sub_command_info.updated_version.depth_sensor.major,
-                       sub_command_info.updated_version.depth_sensor.minor);
-                printf("  Audio firmware:         %d.%d.%d => %d.%d.%d\n",
-                       sub_command_info.current_version.audio.major,
-                       sub_command_info.current_version.audio.minor,
-                       sub_command_info.current_version.audio.iteration,
-                       sub_command_info.updated_version.audio.major,
-                       sub_command_info.updated_version.audio.minor,
-                       sub_command_info.updated_version.audio.iteration);
-            }
+            ThreadAPI_Join(update->thread, NULL);
         }
         else
         {
-            printf("ERROR: Failed to get updated versions\n\n");
+            (void)update_device_thread(update);
         }
 
-        // Ensure the final handle state is copied back.
-        command_info->firmware_handle = sub_command_info.firmware_handle;
-        command_info->firmware_serial_number = sub_command_info.firmware_serial_number;
-
-        printf("\n\n");
-
-        if (K4A_FAILED(result))
+        if (K4A_FAILED(update->result))
         {
             // keep track of overal status
             finalCmdStatus = K4A_RESULT_FAILED;
         }
     }
 
+    if (command_info->device_count > 1)
+    {
+        printf("Update results:\n");
+        for (uint32_t device_index = 0; device_index < command_info->device_count; device_index++)
+        {
+            printf("  S/N %s: %s\n",
+                   updates[device_index].command_info.device_serial_number[0],
+                   K4A_SUCCEEDED(updates[device_index].result) ? "SUCCEEDED" : "FAILED");
+        }
+        printf("\n");
+    }
+
+    free(updates);
     close_all_handles(command_info, &firmware_info);
 
     return finalCmdStatus;
@@ -1026,9 +1144,11 @@ int main(int argc, char **argv)
         return exit_code;
     }
 
-    result = K4A_RESULT_SUCCEEDED;
+    g_open_lock = Lock_Init();
+    g_print_lock = Lock_Init();
+    result = K4A_RESULT_FROM_BOOL(g_open_lock != NULL && g_print_lock != NULL);
 
-    switch (command_info.requested_command)
+    switch (K4A_SUCCEEDED(result) ? command_info.requested_command : K4A_FIRMWARE_COMMAND_UNKNOWN)
     {
     case K4A_FIRMWARE_COMMAND_USAGE:
         break;
@@ -1068,6 +1188,15 @@ int main(int argc, char **argv)
         }
     }
 
+    if (g_open_lock != NULL)
+    {
+        Lock_Deinit(g_open_lock);
+    }
+    if (g_print_lock != NULL)
+    {
+        Lock_Deinit(g_print_lock);
+    }
+
     if (!K4A_SUCCEEDED(result))
     {
         return EXIT_FAILED;